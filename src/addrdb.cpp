@@ -118,7 +118,13 @@ void DeserializeFileDB(const fs::path& path, Data& data, int version)
     if (filein.IsNull()) {
         throw DbNotFoundError{};
     }
-    DeserializeDB(filein, data);
+    // Read the whole file at once and deserialize from memory, rather than
+    // reading from the file for every field.
+    CDataStream stream(SER_DISK, version);
+    stream.resize(fs::file_size(path));
+    filein.read(MakeWritableByteSpan(stream));
+    filein.fclose();
+    DeserializeDB(stream, data);
 }
 } // namespace
 
@@ -9,6 +9,7 @@
 #include <hash.h>
 #include <logging.h>
 #include <logging/timer.h>
+#include <memusage.h>
 #include <netaddress.h>
 #include <protocol.h>
 #include <random.h>
@@ -21,6 +22,7 @@
 
 #include <cmath>
 #include <optional>
+#include <tuple>
 
 /** Over how many buckets entries with tried addresses from a single group (/16 for IPv4) are spread */
 static constexpr uint32_t ADDRMAN_TRIED_BUCKETS_PER_GROUP{8};
@@ -127,6 +129,9 @@ AddrManImpl::~AddrManImpl()
     nKey.SetNull();
 }
 
+// Bucket positions are serialized as a single byte.
+static_assert(ADDRMAN_BUCKET_SIZE <= 256);
+
 template <typename Stream>
 void AddrManImpl::Serialize(Stream& s_) const
 {
@@ -150,17 +155,22 @@ void AddrManImpl::Serialize(Stream& s_) const
      * * nTried
      * * number of "new" buckets XOR 2**30
      * * all new addresses (total count: nNew)
-     * * all tried addresses (total count: nTried)
+     * * all tried addresses (total count: nTried), each followed by its tried bucket
+     *   and its position in that bucket
      * * for each new bucket:
      *   * number of elements
-     *   * for each element: index in the serialized "all new addresses"
+     *   * for each element: index in the serialized "all new addresses", and its
+     *     position in the bucket
      * * asmap checksum
      *
+     * The bucket positions let Unserialize() restore the tables without hashing every
+     * entry again, as long as the bucketing didn't change (see RevalidateBuckets()).
+     *
      * 2**30 is xorred with the number of buckets to make addrman deserializer v0 detect it
      * as incompatible. This is necessary because it did not check the version number on
      * deserialization.
      *
-     * vvNew, vvTried, mapInfo, mapAddr and vRandom are never encoded explicitly;
+     * vvNew, vvTried, m_entries, mapAddr, vRandom and m_network_ids are never encoded explicitly;
      * they are instead reconstructed from the other information.
      *
      * This format is more complex, but significantly smaller (at most 1.5 MiB), and supports
@@ -178,7 +188,7 @@ void AddrManImpl::Serialize(Stream& s_) const
 
     // Increment `lowest_compatible` iff a newly introduced format is incompatible with
     // the previous one.
-    static constexpr uint8_t lowest_compatible = Format::V4_MULTIPORT;
+    static constexpr uint8_t lowest_compatible = Format::V5_BUCKET_POSITIONS;
     s << static_cast<uint8_t>(INCOMPATIBILITY_BASE + lowest_compatible);
 
     s << nKey;
@@ -189,9 +199,10 @@ void AddrManImpl::Serialize(Stream& s_) const
     s << nUBuckets;
     std::unordered_map<int, int> mapUnkIds;
     int nIds = 0;
-    for (const auto& entry : mapInfo) {
-        mapUnkIds[entry.first] = nIds;
-        const AddrInfo& info = entry.second;
+    for (int n = 0; n < int(m_entries.size()); n++) {
+        if (!m_entries[n]) continue;
+        mapUnkIds[n] = nIds;
+        const AddrInfo& info = *m_entries[n];
         if (info.nRefCount) {
             assert(nIds != nNew); // this means nNew was wrong, oh ow
             s << info;
@@ -199,12 +210,13 @@ void AddrManImpl::Serialize(Stream& s_) const
         }
     }
     nIds = 0;
-    for (const auto& entry : mapInfo) {
-        const AddrInfo& info = entry.second;
-        if (info.fInTried) {
-            assert(nIds != nTried); // this means nTried was wrong, oh ow
-            s << info;
-            nIds++;
+    for (int bucket = 0; bucket < ADDRMAN_TRIED_BUCKET_COUNT; bucket++) {
+        for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            if (vvTried[bucket][i] != -1) {
+                assert(nIds != nTried); // this means nTried was wrong, oh ow
+                s << GetEntry(vvTried[bucket][i]) << bucket << static_cast<uint8_t>(i);
+                nIds++;
+            }
         }
     }
     for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
@@ -217,7 +229,7 @@ void AddrManImpl::Serialize(Stream& s_) const
         for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
             if (vvNew[bucket][i] != -1) {
                 int nIndex = mapUnkIds[vvNew[bucket][i]];
-                s << nIndex;
+                s << nIndex << static_cast<uint8_t>(i);
             }
         }
     }
@@ -285,50 +297,48 @@ void AddrManImpl::Unserialize(Stream& s_)
     }
 
     // Deserialize entries from the new table.
+    m_entries.reserve(nNew + nTried);
     for (int n = 0; n < nNew; n++) {
-        AddrInfo& info = mapInfo[n];
+        AddrInfo info;
         s >> info;
-        mapAddr[info] = n;
-        info.nRandomPos = vRandom.size();
-        vRandom.push_back(n);
+        m_entries.emplace_back();
+        Insert(n, std::move(info));
     }
-    nIdCount = nNew;
 
-    // Deserialize entries from the tried table.
-    int nLost = 0;
+    // Deserialize entries from the tried table, along with their stored
+    // position (or -1 if the format has none), to place them once it is known
+    // whether the bucketing changed.
+    std::vector<std::tuple<AddrInfo, int, int>> tried_entries;
+    tried_entries.reserve(nTried);
     for (int n = 0; n < nTried; n++) {
-        AddrInfo info;
+        auto& [info, bucket, position] = tried_entries.emplace_back(AddrInfo{}, -1, -1);
         s >> info;
-        int nKBucket = info.GetTriedBucket(nKey, m_netgroupman);
-        int nKBucketPos = info.GetBucketPosition(nKey, false, nKBucket);
-        if (info.IsValid()
-                && vvTried[nKBucket][nKBucketPos] == -1) {
-            info.nRandomPos = vRandom.size();
-            info.fInTried = true;
-            vRandom.push_back(nIdCount);
-            mapInfo[nIdCount] = info;
-            mapAddr[info] = nIdCount;
-            vvTried[nKBucket][nKBucketPos] = nIdCount;
-            nIdCount++;
-        } else {
-            nLost++;
+        if (format >= Format::V5_BUCKET_POSITIONS) {
+            uint8_t pos;
+            s >> bucket >> pos;
+            position = pos;
         }
     }
-    nTried -= nLost;
 
     // Store positions in the new table buckets to apply later (if possible).
     // An entry may appear in up to ADDRMAN_NEW_BUCKETS_PER_ADDRESS buckets,
-    // so we store all bucket-entry_index pairs to iterate through later.
-    std::vector<std::pair<int, int>> bucket_entries;
+    // so we store all bucket-entry_index-position triples to iterate through later.
+    std::vector<std::tuple<int, int, int>> bucket_entries;
 
     for (int bucket = 0; bucket < nUBuckets; ++bucket) {
         int num_entries{0};
         s >> num_entries;
         for (int n = 0; n < num_entries; ++n) {
             int entry_index{0};
+            int position{-1};
             s >> entry_index;
+            if (format >= Format::V5_BUCKET_POSITIONS) {
+                uint8_t pos;
+                s >> pos;
+                position = pos;
+            }
             if (entry_index >= 0 && entry_index < nNew) {
-                bucket_entries.emplace_back(bucket, entry_index);
+                bucket_entries.emplace_back(bucket, entry_index, position);
             }
         }
     }
@@ -348,10 +358,35 @@ void AddrManImpl::Unserialize(Stream& s_)
         LogPrint(BCLog::ADDRMAN, "Bucketing method was updated, re-bucketing addrman entries from disk\n");
     }
 
-    for (auto bucket_entry : bucket_entries) {
-        int bucket{bucket_entry.first};
-        const int entry_index{bucket_entry.second};
-        AddrInfo& info = mapInfo[entry_index];
+    // Stored positions are only used with unchanged bucketing. They are not
+    // hashed again here, but checked later by RevalidateBuckets().
+    const auto use_stored = [&](int bucket, int bucket_count, int position) {
+        return restore_bucketing && bucket >= 0 && bucket < bucket_count && position >= 0 && position < ADDRMAN_BUCKET_SIZE;
+    };
+
+    int nLost = 0;
+    for (auto& [info, bucket, position] : tried_entries) {
+        if (use_stored(bucket, ADDRMAN_TRIED_BUCKET_COUNT, position)) {
+            m_unverified_positions = true;
+        } else {
+            bucket = info.GetTriedBucket(nKey, m_netgroupman);
+            position = info.GetBucketPosition(nKey, false, bucket);
+        }
+        if (info.IsValid()
+                && vvTried[bucket][position] == -1) {
+            const int nId = m_entries.size();
+            info.fInTried = true;
+            m_entries.emplace_back();
+            Insert(nId, std::move(info));
+            vvTried[bucket][position] = nId;
+        } else {
+            nLost++;
+        }
+    }
+    nTried -= nLost;
+
+    for (auto [bucket, entry_index, position] : bucket_entries) {
+        AddrInfo& info = GetEntry(entry_index);
 
         // Don't store the entry in the new bucket if it's not a valid address for our addrman
         if (!info.IsValid()) continue;
@@ -361,8 +396,10 @@ void AddrManImpl::Unserialize(Stream& s_)
         // this bucket_entry.
         if (info.nRefCount >= ADDRMAN_NEW_BUCKETS_PER_ADDRESS) continue;
 
-        int bucket_position = info.GetBucketPosition(nKey, true, bucket);
+        const bool stored{use_stored(bucket, ADDRMAN_NEW_BUCKET_COUNT, position)};
+        int bucket_position = stored ? position : info.GetBucketPosition(nKey, true, bucket);
         if (restore_bucketing && vvNew[bucket][bucket_position] == -1) {
+            m_unverified_positions |= stored;
             // Bucketing has not changed, using existing bucket positions for the new table
             vvNew[bucket][bucket_position] = entry_index;
             ++info.nRefCount;
@@ -380,13 +417,10 @@ void AddrManImpl::Unserialize(Stream& s_)
 
     // Prune new entries with refcount 0 (as a result of collisions or invalid address).
     int nLostUnk = 0;
-    for (auto it = mapInfo.cbegin(); it != mapInfo.cend(); ) {
-        if (it->second.fInTried == false && it->second.nRefCount == 0) {
-            const auto itCopy = it++;
-            Delete(itCopy->first);
+    for (int n = 0; n < int(m_entries.size()); n++) {
+        if (m_entries[n] && m_entries[n]->fInTried == false && m_entries[n]->nRefCount == 0) {
+            Delete(n);
             ++nLostUnk;
-        } else {
-            ++it;
         }
     }
     if (nLost + nLostUnk > 0) {
@@ -410,24 +444,57 @@ AddrInfo* AddrManImpl::Find(const CService& addr, int* pnId)
         return nullptr;
     if (pnId)
         *pnId = (*it).second;
-    const auto it2 = mapInfo.find((*it).second);
-    if (it2 != mapInfo.end())
-        return &(*it2).second;
-    return nullptr;
+    return FindEntry((*it).second);
+}
+
+AddrInfo* AddrManImpl::FindEntry(int nId)
+{
+    AssertLockHeld(cs);
+
+    if (nId < 0 || nId >= int(m_entries.size()) || !m_entries[nId]) return nullptr;
+    return &*m_entries[nId];
+}
+
+const AddrInfo* AddrManImpl::FindEntry(int nId) const
+{
+    AssertLockHeld(cs);
+
+    if (nId < 0 || nId >= int(m_entries.size()) || !m_entries[nId]) return nullptr;
+    return &*m_entries[nId];
 }
 
 AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource, int* pnId)
 {
     AssertLockHeld(cs);
 
-    int nId = nIdCount++;
-    mapInfo[nId] = AddrInfo(addr, addrSource);
-    mapAddr[addr] = nId;
-    mapInfo[nId].nRandomPos = vRandom.size();
-    vRandom.push_back(nId);
+    // Reuse the slot of a deleted entry if there is one, so m_entries stays dense.
+    int nId;
+    if (m_free_ids.empty()) {
+        nId = m_entries.size();
+        m_entries.emplace_back();
+    } else {
+        nId = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+    AddrInfo& info = Insert(nId, AddrInfo(addr, addrSource));
     if (pnId)
         *pnId = nId;
-    return &mapInfo[nId];
+    return &info;
+}
+
+AddrInfo& AddrManImpl::Insert(int nId, AddrInfo&& info)
+{
+    AssertLockHeld(cs);
+
+    assert(!m_entries.at(nId));
+    AddrInfo& entry = m_entries[nId].emplace(std::move(info));
+    mapAddr[entry] = nId;
+    entry.nRandomPos = vRandom.size();
+    vRandom.push_back(nId);
+    std::vector<int>& network_ids = m_network_ids[entry.GetNetClass()];
+    entry.m_network_pos = network_ids.size();
+    network_ids.push_back(nId);
+    return entry;
 }
 
 void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
@@ -442,31 +509,51 @@ void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
     int nId1 = vRandom[nRndPos1];
     int nId2 = vRandom[nRndPos2];
 
-    const auto it_1{mapInfo.find(nId1)};
-    const auto it_2{mapInfo.find(nId2)};
-    assert(it_1 != mapInfo.end());
-    assert(it_2 != mapInfo.end());
-
-    it_1->second.nRandomPos = nRndPos2;
-    it_2->second.nRandomPos = nRndPos1;
+    GetEntry(nId1).nRandomPos = nRndPos2;
+    GetEntry(nId2).nRandomPos = nRndPos1;
 
     vRandom[nRndPos1] = nId2;
     vRandom[nRndPos2] = nId1;
 }
 
+void AddrManImpl::SwapNetwork(Network net, unsigned int nNetworkPos1, unsigned int nNetworkPos2) const
+{
+    AssertLockHeld(cs);
+
+    if (nNetworkPos1 == nNetworkPos2)
+        return;
+
+    std::vector<int>& network_ids = m_network_ids[net];
+    assert(nNetworkPos1 < network_ids.size() && nNetworkPos2 < network_ids.size());
+
+    int nId1 = network_ids[nNetworkPos1];
+    int nId2 = network_ids[nNetworkPos2];
+
+    GetEntry(nId1).m_network_pos = nNetworkPos2;
+    GetEntry(nId2).m_network_pos = nNetworkPos1;
+
+    network_ids[nNetworkPos1] = nId2;
+    network_ids[nNetworkPos2] = nId1;
+}
+
 void AddrManImpl::Delete(int nId)
 {
     AssertLockHeld(cs);
 
-    assert(mapInfo.count(nId) != 0);
-    AddrInfo& info = mapInfo[nId];
+    AddrInfo& info = GetEntry(nId);
     assert(!info.fInTried);
     assert(info.nRefCount == 0);
 
     SwapRandom(info.nRandomPos, vRandom.size() - 1);
     vRandom.pop_back();
+    const Network net{info.GetNetClass()};
+    SwapNetwork(net, info.m_network_pos, m_network_ids[net].size() - 1);
+    m_network_ids[net].pop_back();
     mapAddr.erase(info);
-    mapInfo.erase(nId);
+    m_entries[nId].reset();
+    m_free_ids.push_back(nId);
+    // The nId will be reused for another address, so it must not linger as a collision.
+    m_tried_collisions.erase(nId);
     nNew--;
 }
 
@@ -477,7 +564,7 @@ void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
     // if there is an entry in the specified bucket, delete it.
     if (vvNew[nUBucket][nUBucketPos] != -1) {
         int nIdDelete = vvNew[nUBucket][nUBucketPos];
-        AddrInfo& infoDelete = mapInfo[nIdDelete];
+        AddrInfo& infoDelete = GetEntry(nIdDelete);
         assert(infoDelete.nRefCount > 0);
         infoDelete.nRefCount--;
         vvNew[nUBucket][nUBucketPos] = -1;
@@ -515,8 +602,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
     if (vvTried[nKBucket][nKBucketPos] != -1) {
         // find an item to evict
         int nIdEvict = vvTried[nKBucket][nKBucketPos];
-        assert(mapInfo.count(nIdEvict) == 1);
-        AddrInfo& infoOld = mapInfo[nIdEvict];
+        AddrInfo& infoOld = GetEntry(nIdEvict);
 
         // Remove the to-be-evicted item from the tried set.
         infoOld.fInTried = false;
@@ -599,7 +685,7 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
     bool fInsert = vvNew[nUBucket][nUBucketPos] == -1;
     if (vvNew[nUBucket][nUBucketPos] != nId) {
         if (!fInsert) {
-            AddrInfo& infoExisting = mapInfo[vvNew[nUBucket][nUBucketPos]];
+            AddrInfo& infoExisting = GetEntry(vvNew[nUBucket][nUBucketPos]);
             if (infoExisting.IsTerrible() || (infoExisting.nRefCount > 1 && pinfo->nRefCount == 0)) {
                 // Overwrite the existing new table entry.
                 fInsert = true;
@@ -659,9 +745,9 @@ bool AddrManImpl::Good_(const CService& addr, bool test_before_evict, NodeSecond
             m_tried_collisions.insert(nId);
         }
         // Output the entry we'd be colliding with, for debugging purposes
-        auto colliding_entry = mapInfo.find(vvTried[tried_bucket][tried_bucket_pos]);
+        const AddrInfo* colliding_entry = FindEntry(vvTried[tried_bucket][tried_bucket_pos]);
         LogPrint(BCLog::ADDRMAN, "Collision with %s while attempting to move %s to tried table. Collisions=%d\n",
-                 colliding_entry != mapInfo.end() ? colliding_entry->second.ToString() : "",
+                 colliding_entry ? colliding_entry->ToString() : "",
                  addr.ToString(),
                  m_tried_collisions.size());
         return false;
@@ -733,9 +819,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
             if (i == ADDRMAN_BUCKET_SIZE) continue;
             // Find the entry to return.
             int nId = vvTried[nKBucket][(nKBucketPos + i) % ADDRMAN_BUCKET_SIZE];
-            const auto it_found{mapInfo.find(nId)};
-            assert(it_found != mapInfo.end());
-            const AddrInfo& info{it_found->second};
+            const AddrInfo& info{GetEntry(nId)};
             // With probability GetChance() * fChanceFactor, return the entry.
             if (insecure_rand.randbits(30) < fChanceFactor * info.GetChance() * (1 << 30)) {
                 LogPrint(BCLog::ADDRMAN, "Selected %s from tried\n", info.ToString());
@@ -761,9 +845,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
             if (i == ADDRMAN_BUCKET_SIZE) continue;
             // Find the entry to return.
             int nId = vvNew[nUBucket][(nUBucketPos + i) % ADDRMAN_BUCKET_SIZE];
-            const auto it_found{mapInfo.find(nId)};
-            assert(it_found != mapInfo.end());
-            const AddrInfo& info{it_found->second};
+            const AddrInfo& info{GetEntry(nId)};
             // With probability GetChance() * fChanceFactor, return the entry.
             if (insecure_rand.randbits(30) < fChanceFactor * info.GetChance() * (1 << 30)) {
                 LogPrint(BCLog::ADDRMAN, "Selected %s from new\n", info.ToString());
@@ -787,22 +869,22 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
         nNodes = std::min(nNodes, max_addresses);
     }
 
-    // gather a list of random nodes, skipping those of low quality
+    // gather a list of random nodes, skipping those of low quality. If a
+    // network was given, only its own nIds are shuffled and visited.
     const auto now{Now<NodeSeconds>()};
+    const std::vector<int>& ids{network ? m_network_ids[*network] : vRandom};
     std::vector<CAddress> addresses;
-    for (unsigned int n = 0; n < vRandom.size(); n++) {
+    for (unsigned int n = 0; n < ids.size(); n++) {
         if (addresses.size() >= nNodes)
             break;
 
-        int nRndPos = insecure_rand.randrange(vRandom.size() - n) + n;
-        SwapRandom(n, nRndPos);
-        const auto it{mapInfo.find(vRandom[n])};
-        assert(it != mapInfo.end());
-
-        const AddrInfo& ai{it->second};
-
-        // Filter by network (optional)
-        if (network != std::nullopt && ai.GetNetClass() != network) continue;
+        int nRndPos = insecure_rand.randrange(ids.size() - n) + n;
+        if (network) {
+            SwapNetwork(*network, n, nRndPos);
+        } else {
+            SwapRandom(n, nRndPos);
+        }
+        const AddrInfo& ai{GetEntry(ids[n])};
 
         // Filter for quality
         if (ai.IsTerrible(now)) continue;
@@ -832,6 +914,47 @@ void AddrManImpl::Connected_(const CService& addr, NodeSeconds time)
     }
 }
 
+void AddrManImpl::RevalidateBuckets_()
+{
+    AssertLockHeld(cs);
+
+    if (!m_unverified_positions) return;
+    m_unverified_positions = false;
+
+    int nLostTried = 0;
+    for (int bucket = 0; bucket < ADDRMAN_TRIED_BUCKET_COUNT; bucket++) {
+        for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            const int nId = vvTried[bucket][i];
+            if (nId == -1) continue;
+            AddrInfo& info = GetEntry(nId);
+            const int tried_bucket = info.GetTriedBucket(nKey, m_netgroupman);
+            if (tried_bucket == bucket && info.GetBucketPosition(nKey, false, tried_bucket) == i) continue;
+            // Not where it belongs: take it out of the tried table and delete it.
+            vvTried[bucket][i] = -1;
+            info.fInTried = false;
+            nTried--;
+            nNew++; // Delete() expects a new entry.
+            Delete(nId);
+            nLostTried++;
+        }
+    }
+
+    int nLostNew = 0;
+    for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
+        for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            const int nId = vvNew[bucket][i];
+            if (nId == -1) continue;
+            if (GetEntry(nId).GetBucketPosition(nKey, true, bucket) == i) continue;
+            ClearNew(bucket, i);
+            nLostNew++;
+        }
+    }
+
+    if (nLostTried + nLostNew > 0) {
+        LogPrintf("addrman dropped %i new and %i tried entries from peers.dat that were not in their bucket position\n", nLostNew, nLostTried);
+    }
+}
+
 void AddrManImpl::SetServices_(const CService& addr, ServiceFlags nServices)
 {
     AssertLockHeld(cs);
@@ -857,11 +980,11 @@ void AddrManImpl::ResolveCollisions_()
 
         bool erase_collision = false;
 
-        // If id_new not found in mapInfo remove it from m_tried_collisions
-        if (mapInfo.count(id_new) != 1) {
+        // If id_new not found in m_entries remove it from m_tried_collisions
+        if (!FindEntry(id_new)) {
             erase_collision = true;
         } else {
-            AddrInfo& info_new = mapInfo[id_new];
+            AddrInfo& info_new = GetEntry(id_new);
 
             // Which tried bucket to move the entry to.
             int tried_bucket = info_new.GetTriedBucket(nKey, m_netgroupman);
@@ -872,7 +995,7 @@ void AddrManImpl::ResolveCollisions_()
 
                 // Get the to-be-evicted address that is being tested
                 int id_old = vvTried[tried_bucket][tried_bucket_pos];
-                AddrInfo& info_old = mapInfo[id_old];
+                AddrInfo& info_old = GetEntry(id_old);
 
                 const auto current_time{Now<NodeSeconds>()};
 
@@ -923,19 +1046,19 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision_()
     std::advance(it, insecure_rand.randrange(m_tried_collisions.size()));
     int id_new = *it;
 
-    // If id_new not found in mapInfo remove it from m_tried_collisions
-    if (mapInfo.count(id_new) != 1) {
+    // If id_new not found in m_entries remove it from m_tried_collisions
+    if (!FindEntry(id_new)) {
         m_tried_collisions.erase(it);
         return {};
     }
 
-    const AddrInfo& newInfo = mapInfo[id_new];
+    const AddrInfo& newInfo = GetEntry(id_new);
 
     // which tried bucket to move the entry to
     int tried_bucket = newInfo.GetTriedBucket(nKey, m_netgroupman);
     int tried_bucket_pos = newInfo.GetBucketPosition(nKey, false, tried_bucket);
 
-    const AddrInfo& info_old = mapInfo[vvTried[tried_bucket][tried_bucket_pos]];
+    const AddrInfo& info_old = GetEntry(vvTried[tried_bucket][tried_bucket_pos]);
     return {info_old, info_old.m_last_try};
 }
 
@@ -990,9 +1113,13 @@ int AddrManImpl::CheckAddrman() const
     if (vRandom.size() != (size_t)(nTried + nNew))
         return -7;
 
-    for (const auto& entry : mapInfo) {
-        int n = entry.first;
-        const AddrInfo& info = entry.second;
+    size_t free_slots{0};
+    for (int n = 0; n < int(m_entries.size()); n++) {
+        if (!m_entries[n]) {
+            ++free_slots;
+            continue;
+        }
+        const AddrInfo& info = *m_entries[n];
         if (info.fInTried) {
             if (!TicksSinceEpoch<std::chrono::seconds>(info.m_last_success)) {
                 return -1;
@@ -1013,6 +1140,9 @@ int AddrManImpl::CheckAddrman() const
         }
         if (info.nRandomPos < 0 || (size_t)info.nRandomPos >= vRandom.size() || vRandom[info.nRandomPos] != n)
             return -14;
+        const std::vector<int>& network_ids = m_network_ids[info.GetNetClass()];
+        if (info.m_network_pos < 0 || (size_t)info.m_network_pos >= network_ids.size() || network_ids[info.m_network_pos] != n)
+            return -20;
         if (info.m_last_try < NodeSeconds{0s}) {
             return -6;
         }
@@ -1021,21 +1151,33 @@ int AddrManImpl::CheckAddrman() const
         }
     }
 
+    if (free_slots != m_free_ids.size())
+        return -21;
+    size_t network_ids_size{0};
+    for (const auto& network_ids : m_network_ids) {
+        network_ids_size += network_ids.size();
+    }
+    if (network_ids_size != vRandom.size())
+        return -22;
+
     if (setTried.size() != (size_t)nTried)
         return -9;
     if (mapNew.size() != (size_t)nNew)
         return -10;
 
+    // Positions restored from peers.dat are checked by RevalidateBuckets() instead.
+    const bool check_positions{!m_unverified_positions};
+
     for (int n = 0; n < ADDRMAN_TRIED_BUCKET_COUNT; n++) {
         for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
             if (vvTried[n][i] != -1) {
                 if (!setTried.count(vvTried[n][i]))
                     return -11;
-                const auto it{mapInfo.find(vvTried[n][i])};
-                if (it == mapInfo.end() || it->second.GetTriedBucket(nKey, m_netgroupman) != n) {
+                const AddrInfo* info{FindEntry(vvTried[n][i])};
+                if (!info || (check_positions && info->GetTriedBucket(nKey, m_netgroupman) != n)) {
                     return -17;
                 }
-                if (it->second.GetBucketPosition(nKey, false, n) != i) {
+                if (check_positions && info->GetBucketPosition(nKey, false, n) != i) {
                     return -18;
                 }
                 setTried.erase(vvTried[n][i]);
@@ -1048,8 +1190,8 @@ int AddrManImpl::CheckAddrman() const
             if (vvNew[n][i] != -1) {
                 if (!mapNew.count(vvNew[n][i]))
                     return -12;
-                const auto it{mapInfo.find(vvNew[n][i])};
-                if (it == mapInfo.end() || it->second.GetBucketPosition(nKey, true, n) != i) {
+                const AddrInfo* info{FindEntry(vvNew[n][i])};
+                if (!info || (check_positions && info->GetBucketPosition(nKey, true, n) != i)) {
                     return -19;
                 }
                 if (--mapNew[vvNew[n][i]] == 0)
@@ -1074,6 +1216,19 @@ size_t AddrManImpl::size() const
     return vRandom.size();
 }
 
+size_t AddrManImpl::DynamicMemoryUsage() const
+{
+    LOCK(cs);
+    // The buckets are part of the object, which AddrMan allocates
+    size_t usage{memusage::MallocUsage(sizeof(AddrManImpl))};
+    usage += memusage::DynamicUsage(m_entries) + memusage::DynamicUsage(m_free_ids);
+    usage += memusage::DynamicUsage(mapAddr) + memusage::DynamicUsage(vRandom);
+    for (const auto& ids : m_network_ids) {
+        usage += memusage::DynamicUsage(ids);
+    }
+    return usage + memusage::DynamicUsage(m_tried_collisions);
+}
+
 bool AddrManImpl::Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
 {
     LOCK(cs);
@@ -1108,6 +1263,13 @@ void AddrManImpl::ResolveCollisions()
     Check();
 }
 
+void AddrManImpl::RevalidateBuckets()
+{
+    LOCK(cs);
+    RevalidateBuckets_();
+    Check();
+}
+
 std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision()
 {
     LOCK(cs);
@@ -1191,6 +1353,11 @@ size_t AddrMan::size() const
     return m_impl->size();
 }
 
+size_t AddrMan::DynamicMemoryUsage() const
+{
+    return m_impl->DynamicMemoryUsage();
+}
+
 bool AddrMan::Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
 {
     return m_impl->Add(vAddr, source, time_penalty);
@@ -1211,6 +1378,11 @@ void AddrMan::ResolveCollisions()
     m_impl->ResolveCollisions();
 }
 
+void AddrMan::RevalidateBuckets()
+{
+    m_impl->RevalidateBuckets();
+}
+
 std::pair<CAddress, NodeSeconds> AddrMan::SelectTriedCollision()
 {
     return m_impl->SelectTriedCollision();
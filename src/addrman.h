@@ -102,6 +102,9 @@ public:
     //! Return the number of (unique) addresses in all tables.
     size_t size() const;
 
+    //! Return the memory used by the tables.
+    size_t DynamicMemoryUsage() const;
+
     /**
      * Attempt to add one or more addresses to addrman's new table.
      *
@@ -128,6 +131,14 @@ public:
     //! See if any to-be-evicted tried table entries have been tested and if so resolve the collisions.
     void ResolveCollisions();
 
+    /**
+     * Check the bucket positions that were restored from peers.dat without
+     * recomputing them, and drop any entry that is not where it belongs.
+     * Deserialization leaves this to be called later, e.g. from the
+     * scheduler, so that loading a full address table doesn't wait on it.
+     */
+    void RevalidateBuckets();
+
     /**
      * Randomly select an address in the tried table that another address is
      * attempting to evict.
@@ -13,8 +13,10 @@
 #include <sync.h>
 #include <timedata.h>
 #include <uint256.h>
+#include <util/check.h>
 #include <util/time.h>
 
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <set>
@@ -63,6 +65,9 @@ public:
     //! position in vRandom
     mutable int nRandomPos{-1};
 
+    //! position in the list of its network in m_network_ids
+    mutable int m_network_pos{-1};
+
     SERIALIZE_METHODS(AddrInfo, obj)
     {
         READWRITEAS(CAddress, obj);
@@ -114,6 +119,8 @@ public:
 
     size_t size() const EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
     bool Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
         EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
@@ -125,6 +132,8 @@ public:
 
     void ResolveCollisions() EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
+    void RevalidateBuckets() EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
     std::pair<CAddress, NodeSeconds> SelectTriedCollision() EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
     std::pair<CAddress, NodeSeconds> Select(bool newOnly) const
@@ -161,6 +170,7 @@ private:
         V2_ASMAP = 2,         //!< for files including asmap version
         V3_BIP155 = 3,        //!< same as V2_ASMAP plus addresses are in BIP155 format
         V4_MULTIPORT = 4,     //!< adds support for multiple ports per IP
+        V5_BUCKET_POSITIONS = 5, //!< stores the bucket positions of new and tried entries
     };
 
     //! The maximum format this software knows it can unserialize. Also, we always serialize
@@ -168,7 +178,7 @@ private:
     //! The format (first byte in the serialized stream) can be higher than this and
     //! still this software may be able to unserialize the file - if the second byte
     //! (see `lowest_compatible` in `Unserialize()`) is less or equal to this.
-    static constexpr Format FILE_FORMAT = Format::V4_MULTIPORT;
+    static constexpr Format FILE_FORMAT = Format::V5_BUCKET_POSITIONS;
 
     //! The initial value of a field that is incremented every time an incompatible format
     //! change is made (such that old software versions would not be able to parse and
@@ -177,11 +187,12 @@ private:
     //! @note Don't increment this. Increment `lowest_compatible` in `Serialize()` instead.
     static constexpr uint8_t INCOMPATIBILITY_BASE = 32;
 
-    //! last used nId
-    int nIdCount GUARDED_BY(cs){0};
+    //! table with information about all nIds, indexed by nId. The slot of a
+    //! deleted entry stays empty until Create() reuses its nId.
+    std::vector<std::optional<AddrInfo>> m_entries GUARDED_BY(cs);
 
-    //! table with information about all nIds
-    std::unordered_map<int, AddrInfo> mapInfo GUARDED_BY(cs);
+    //! nIds of the empty slots in m_entries
+    std::vector<int> m_free_ids GUARDED_BY(cs);
 
     //! find an nId based on its network address and port.
     std::unordered_map<CService, int, CServiceHash> mapAddr GUARDED_BY(cs);
@@ -191,6 +202,11 @@ private:
     //! changes to it (even in const methods) are also unobservable.
     mutable std::vector<int> vRandom GUARDED_BY(cs);
 
+    //! randomly-ordered vectors of the nIds of every network (by GetNetClass()),
+    //! so that GetAddr can sample a single network without visiting the others.
+    //! Mutable for the same reason as vRandom.
+    mutable std::array<std::vector<int>, NET_MAX> m_network_ids GUARDED_BY(cs);
+
     // number of "tried" entries
     int nTried GUARDED_BY(cs){0};
 
@@ -209,6 +225,10 @@ private:
     //! Holds addrs inserted into tried table that collide with existing entries. Test-before-evict discipline used to resolve these collisions.
     std::set<int> m_tried_collisions;
 
+    //! Whether bucket positions were taken from peers.dat without recomputing them, and RevalidateBuckets()
+    //! hasn't checked them yet. CheckAddrman() skips its bucket position checks until then.
+    bool m_unverified_positions GUARDED_BY(cs){false};
+
     /** Perform consistency checks every m_consistency_check_ratio operations (if non-zero). */
     const int32_t m_consistency_check_ratio;
 
@@ -218,12 +238,26 @@ private:
     //! Find an entry.
     AddrInfo* Find(const CService& addr, int* pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
-    //! Create a new entry and add it to the internal data structures mapInfo, mapAddr and vRandom.
+    //! Get the entry with a given nId, or nullptr if it is not in use.
+    AddrInfo* FindEntry(int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    const AddrInfo* FindEntry(int nId) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Get the entry with a given nId, which must be in use.
+    AddrInfo& GetEntry(int nId) EXCLUSIVE_LOCKS_REQUIRED(cs) { return *Assert(FindEntry(nId)); }
+    const AddrInfo& GetEntry(int nId) const EXCLUSIVE_LOCKS_REQUIRED(cs) { return *Assert(FindEntry(nId)); }
+
+    //! Create a new entry and add it to the internal data structures m_entries, mapAddr, vRandom and m_network_ids.
     AddrInfo* Create(const CAddress& addr, const CNetAddr& addrSource, int* pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Store info in the empty slot nId of m_entries, and add it to mapAddr, vRandom and m_network_ids.
+    AddrInfo& Insert(int nId, AddrInfo&& info) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     //! Swap two elements in vRandom.
     void SwapRandom(unsigned int nRandomPos1, unsigned int nRandomPos2) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Swap two elements in the m_network_ids vector of a network.
+    void SwapNetwork(Network net, unsigned int nNetworkPos1, unsigned int nNetworkPos2) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     //! Delete an entry. It must not be in tried, and have refcount 0.
     void Delete(int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -253,6 +287,8 @@ private:
 
     void ResolveCollisions_() EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    void RevalidateBuckets_() EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     std::pair<CAddress, NodeSeconds> SelectTriedCollision_() EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     std::optional<AddressPosition> FindAddressEntry_(const CAddress& addr) EXCLUSIVE_LOCKS_REQUIRED(cs);
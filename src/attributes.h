@@ -16,4 +16,17 @@
 #  define LIFETIMEBOUND
 #endif
 
+/** Lets the members following a member with this attribute use its tail padding. */
+#if defined(_MSC_VER)
+#  define NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#elif defined(__has_cpp_attribute)
+#  if __has_cpp_attribute(no_unique_address)
+#    define NO_UNIQUE_ADDRESS [[no_unique_address]]
+#  else
+#    define NO_UNIQUE_ADDRESS
+#  endif
+#else
+#  define NO_UNIQUE_ADDRESS
+#endif
+
 #endif // BITCOIN_ATTRIBUTES_H
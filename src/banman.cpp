@@ -12,6 +12,9 @@
 #include <util/time.h>
 #include <util/translation.h>
 
+#include <algorithm>
+#include <limits>
+
 
 BanMan::BanMan(fs::path ban_file, CClientUIInterface* client_interface, int64_t default_ban_time)
     : m_client_interface(client_interface), m_ban_db(std::move(ban_file)), m_default_ban_time(default_ban_time)
@@ -33,6 +36,11 @@ void BanMan::LoadBanlist()
 
     const auto start{SteadyClock::now()};
     if (m_ban_db.Read(m_banned)) {
+        m_banned_prefixes.clear();
+        for (const auto& [sub_net, _] : m_banned) {
+            IndexBannedSubnet(sub_net);
+        }
+        m_banned_next_expiry = 0; // scan for invalid entries as well
         SweepBanned(); // sweep out unused entries
 
         LogPrint(BCLog::NET, "Loaded %d banned node addresses/subnets  %dms\n", m_banned.size(),
@@ -40,6 +48,7 @@ void BanMan::LoadBanlist()
     } else {
         LogPrintf("Recreating the banlist database\n");
         m_banned = {};
+        m_banned_prefixes.clear();
         m_is_dirty = true;
     }
 }
@@ -72,6 +81,7 @@ void BanMan::ClearBanned()
     {
         LOCK(m_cs_banned);
         m_banned.clear();
+        m_banned_prefixes.clear();
         m_is_dirty = true;
     }
     DumpBanlist(); //store banlist to disk
@@ -86,13 +96,20 @@ bool BanMan::IsDiscouraged(const CNetAddr& net_addr)
 
 bool BanMan::IsBanned(const CNetAddr& net_addr)
 {
+    if (!net_addr.IsValid()) return false;
     auto current_time = GetTime();
     LOCK(m_cs_banned);
-    for (const auto& it : m_banned) {
-        CSubNet sub_net = it.first;
-        CBanEntry ban_entry = it.second;
-
-        if (current_time < ban_entry.nBanUntil && sub_net.Match(net_addr)) {
+    const auto is_banned = [&](const CSubNet& sub_net) EXCLUSIVE_LOCKS_REQUIRED(m_cs_banned) {
+        banmap_t::const_iterator i = m_banned.find(sub_net);
+        return i != m_banned.end() && current_time < i->second.nBanUntil;
+    };
+    // Subnets of other networks only match their single address
+    if (!net_addr.IsIPv4() && !net_addr.IsIPv6()) return is_banned(CSubNet{net_addr});
+
+    const uint8_t max_prefix{uint8_t(net_addr.IsIPv4() ? ADDR_IPV4_SIZE * 8 : ADDR_IPV6_SIZE * 8)};
+    for (const auto& [prefix, _] : m_banned_prefixes) {
+        if (prefix > max_prefix) break;
+        if (is_banned(CSubNet{net_addr, prefix})) {
             return true;
         }
     }
@@ -139,8 +156,10 @@ void BanMan::Ban(const CSubNet& sub_net, int64_t ban_time_offset, bool since_uni
 
     {
         LOCK(m_cs_banned);
+        if (!m_banned.count(sub_net)) IndexBannedSubnet(sub_net);
         if (m_banned[sub_net].nBanUntil < ban_entry.nBanUntil) {
             m_banned[sub_net] = ban_entry;
+            m_banned_next_expiry = std::min(m_banned_next_expiry, ban_entry.nBanUntil);
             m_is_dirty = true;
         } else
             return;
@@ -162,6 +181,7 @@ bool BanMan::Unban(const CSubNet& sub_net)
     {
         LOCK(m_cs_banned);
         if (m_banned.erase(sub_net) == 0) return false;
+        UnindexBannedSubnet(sub_net);
         m_is_dirty = true;
     }
     if (m_client_interface) m_client_interface->BannedListChanged();
@@ -182,6 +202,8 @@ void BanMan::SweepBanned()
     AssertLockHeld(m_cs_banned);
 
     int64_t now = GetTime();
+    if (now <= m_banned_next_expiry) return;
+    m_banned_next_expiry = std::numeric_limits<int64_t>::max();
     bool notify_ui = false;
     banmap_t::iterator it = m_banned.begin();
     while (it != m_banned.end()) {
@@ -189,10 +211,12 @@ void BanMan::SweepBanned()
         CBanEntry ban_entry = (*it).second;
         if (!sub_net.IsValid() || now > ban_entry.nBanUntil) {
             m_banned.erase(it++);
+            UnindexBannedSubnet(sub_net);
             m_is_dirty = true;
             notify_ui = true;
             LogPrint(BCLog::NET, "Removed banned node address/subnet: %s\n", sub_net.ToString());
         } else {
+            m_banned_next_expiry = std::min(m_banned_next_expiry, ban_entry.nBanUntil);
             ++it;
         }
     }
@@ -203,6 +227,20 @@ void BanMan::SweepBanned()
     }
 }
 
+void BanMan::IndexBannedSubnet(const CSubNet& sub_net)
+{
+    AssertLockHeld(m_cs_banned);
+    ++m_banned_prefixes[sub_net.GetPrefixLength()];
+}
+
+void BanMan::UnindexBannedSubnet(const CSubNet& sub_net)
+{
+    AssertLockHeld(m_cs_banned);
+    auto it = m_banned_prefixes.find(sub_net.GetPrefixLength());
+    assert(it != m_banned_prefixes.end());
+    if (--it->second == 0) m_banned_prefixes.erase(it);
+}
+
 bool BanMan::BannedSetIsDirty()
 {
     LOCK(m_cs_banned);
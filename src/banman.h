@@ -13,6 +13,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <map>
 #include <memory>
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
@@ -86,9 +87,18 @@ private:
     void SetBannedSetDirty(bool dirty = true);
     //!clean unused entries (if bantime has expired)
     void SweepBanned() EXCLUSIVE_LOCKS_REQUIRED(m_cs_banned);
+    //!add or remove a subnet of m_banned from the prefixes IsBanned() looks up
+    void IndexBannedSubnet(const CSubNet& sub_net) EXCLUSIVE_LOCKS_REQUIRED(m_cs_banned);
+    void UnindexBannedSubnet(const CSubNet& sub_net) EXCLUSIVE_LOCKS_REQUIRED(m_cs_banned);
 
     RecursiveMutex m_cs_banned;
     banmap_t m_banned GUARDED_BY(m_cs_banned);
+    //! Number of subnets in m_banned per prefix length. An IPv4 or IPv6 address is banned if its
+    //! own subnet of one of these lengths is, so it is looked up once per length instead of being
+    //! matched against every ban.
+    std::map<uint8_t, size_t> m_banned_prefixes GUARDED_BY(m_cs_banned);
+    //! A time no later than the earliest expiry in m_banned, so SweepBanned() only scans when a ban may have expired
+    int64_t m_banned_next_expiry GUARDED_BY(m_cs_banned){0};
     bool m_is_dirty GUARDED_BY(m_cs_banned){false};
     CClientUIInterface* m_client_interface = nullptr;
     CBanDB m_ban_db;
@@ -93,33 +93,50 @@ std::string EncodeBase58(Span<const unsigned char> input)
         input = input.subspan(1);
         zeroes++;
     }
-    // Allocate enough space in big-endian base58 representation.
-    int size = input.size() * 138 / 100 + 1; // log(256) / log(58), rounded up.
-    std::vector<unsigned char> b58(size);
-    // Process the bytes.
+    // Allocate enough space in big-endian base58 representation, in limbs of
+    // 5 base58 digits. A limb fits in 30 bits, so up to 4 input bytes at a time
+    // can be multiplied in with 64-bit arithmetic.
+    static constexpr int LIMB_DIGITS = 5;
+    static constexpr uint64_t LIMB_BASE = 58ULL * 58 * 58 * 58 * 58;
+    int size = (input.size() * 138 / 100 + 1) / LIMB_DIGITS + 1; // log(256) / log(58), rounded up.
+    std::vector<uint32_t> b58(size);
+    // Process the bytes, the first (input.size() % 4) of them and then 4 at a time.
+    size_t chunk = input.size() % 4 ? input.size() % 4 : 4;
     while (input.size() > 0) {
-        int carry = input[0];
+        uint64_t carry = 0;
+        for (size_t j = 0; j < chunk; ++j) carry = (carry << 8) | input[j];
+        const int shift = 8 * chunk;
         int i = 0;
-        // Apply "b58 = b58 * 256 + ch".
-        for (std::vector<unsigned char>::reverse_iterator it = b58.rbegin(); (carry != 0 || i < length) && (it != b58.rend()); it++, i++) {
-            carry += 256 * (*it);
-            *it = carry % 58;
-            carry /= 58;
+        // Apply "b58 = b58 * 256^chunk + bytes".
+        for (std::vector<uint32_t>::reverse_iterator it = b58.rbegin(); (carry != 0 || i < length) && (it != b58.rend()); it++, i++) {
+            carry += uint64_t{*it} << shift;
+            *it = carry % LIMB_BASE;
+            carry /= LIMB_BASE;
         }
 
         assert(carry == 0);
         length = i;
-        input = input.subspan(1);
+        input = input.subspan(chunk);
+        chunk = 4;
+    }
+    // Expand the limbs into base58 digits.
+    std::vector<unsigned char> digits(length * LIMB_DIGITS);
+    for (int i = 0; i < length; ++i) {
+        uint32_t limb = b58[size - length + i];
+        for (int j = LIMB_DIGITS - 1; j >= 0; --j) {
+            digits[i * LIMB_DIGITS + j] = limb % 58;
+            limb /= 58;
+        }
     }
     // Skip leading zeroes in base58 result.
-    std::vector<unsigned char>::iterator it = b58.begin() + (size - length);
-    while (it != b58.end() && *it == 0)
+    std::vector<unsigned char>::iterator it = digits.begin();
+    while (it != digits.end() && *it == 0)
         it++;
     // Translate the result into a string.
     std::string str;
-    str.reserve(zeroes + (b58.end() - it));
+    str.reserve(zeroes + (digits.end() - it));
     str.assign(zeroes, '1');
-    while (it != b58.end())
+    while (it != digits.end())
         str += pszBase58[*(it++)];
     return str;
 }
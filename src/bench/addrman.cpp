@@ -4,11 +4,17 @@
 
 #include <addrman.h>
 #include <bench/bench.h>
+#include <bench/data.h>
+#include <crypto/common.h>
 #include <netgroup.h>
 #include <random.h>
+#include <util/asmap.h>
 #include <util/check.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <optional>
 #include <vector>
 
@@ -57,6 +63,33 @@ static void CreateAddresses()
     }
 }
 
+static std::vector<bool> BenchAsmap()
+{
+    // Maps 250.0.0.0/8 and 101.1.0.0/16 to 101.8.0.0/16 to ASNs, see addrman_tests
+    std::vector<bool> asmap;
+    for (uint8_t byte : benchmark::data::asmap) {
+        for (int bit = 0; bit < 8; ++bit) {
+            asmap.push_back((byte >> bit) & 1);
+        }
+    }
+    assert(SanityCheckASMap(asmap, 128));
+    return asmap;
+}
+
+/** IPv4 addresses, half of them in the ranges of the asmap, as the 128 bits looked up for them */
+static std::vector<std::array<uint8_t, ADDR_IPV6_SIZE>> AsmapLookups()
+{
+    FastRandomContext rng(uint256(std::vector<unsigned char>(32, 123)));
+    std::vector<std::array<uint8_t, ADDR_IPV6_SIZE>> ips(1024);
+    for (size_t i = 0; i < ips.size(); ++i) {
+        std::copy(IPV4_IN_IPV6_PREFIX.begin(), IPV4_IN_IPV6_PREFIX.end(), ips[i].begin());
+        uint32_t ipv4 = rng.rand32();
+        if (i % 2) ipv4 = (i % 4 == 1) ? (250U << 24) | (ipv4 & 0xFFFFFF) : (101U << 24) | ((1 + i % 8) << 16) | (ipv4 & 0xFFFF);
+        WriteBE32(ips[i].data() + IPV4_IN_IPV6_PREFIX.size(), ipv4);
+    }
+    return ips;
+}
+
 static void AddAddressesToAddrMan(AddrMan& addrman)
 {
     for (size_t source_i = 0; source_i < NUM_SOURCES; ++source_i) {
@@ -107,6 +140,19 @@ static void AddrManGetAddr(benchmark::Bench& bench)
     });
 }
 
+static void AddrManGetAddrByNetwork(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+
+    // Responses to getaddr requests are built per network of the requesting peer.
+    bench.run([&] {
+        const auto& addresses = addrman.GetAddr(/*max_addresses=*/2500, /*max_pct=*/23, /*network=*/NET_IPV6);
+        assert(addresses.size() > 0);
+    });
+}
+
 static void AddrManAddThenGood(benchmark::Bench& bench)
 {
     auto markSomeAsGood = [](AddrMan& addrman) {
@@ -133,7 +179,49 @@ static void AddrManAddThenGood(benchmark::Bench& bench)
     });
 }
 
+static void AsmapInterpret(benchmark::Bench& bench)
+{
+    const std::vector<bool> asmap{BenchAsmap()};
+    std::vector<std::vector<bool>> ips;
+    for (const auto& ip : AsmapLookups()) {
+        std::vector<bool>& bits{ips.emplace_back(128)};
+        for (size_t i = 0; i < bits.size(); ++i) {
+            bits[i] = (ip[i / 8] >> (7 - i % 8)) & 1;
+        }
+    }
+    size_t i{0};
+    bench.run([&] {
+        ankerl::nanobench::doNotOptimizeAway(Interpret(asmap, ips[i++ % ips.size()]));
+    });
+}
+
+static void AsmapInterpretCompiled(benchmark::Bench& bench)
+{
+    const std::vector<AsmapRange> ranges{CompileAsmap(BenchAsmap())};
+    const auto ips{AsmapLookups()};
+    size_t i{0};
+    bench.run([&] {
+        const auto& ip{ips[i++ % ips.size()]};
+        ankerl::nanobench::doNotOptimizeAway(InterpretCompiled(ranges, ReadBE64(ip.data()), ReadBE64(ip.data() + 8)));
+    });
+}
+
+static void AddrManAddAsmap(benchmark::Bench& bench)
+{
+    const NetGroupManager netgroupman{BenchAsmap()};
+    CreateAddresses();
+
+    bench.run([&] {
+        AddrMan addrman{netgroupman, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+        AddAddressesToAddrMan(addrman);
+    });
+}
+
 BENCHMARK(AddrManAdd);
+BENCHMARK(AddrManAddAsmap);
 BENCHMARK(AddrManSelect);
 BENCHMARK(AddrManGetAddr);
+BENCHMARK(AddrManGetAddrByNetwork);
 BENCHMARK(AddrManAddThenGood);
+BENCHMARK(AsmapInterpret);
+BENCHMARK(AsmapInterpretCompiled);
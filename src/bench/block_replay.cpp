@@ -0,0 +1,277 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <coins.h>
+#include <consensus/amount.h>
+#include <consensus/conversion.h>
+#include <consensus/validation.h>
+#include <kernel/validation_cache_sizes.h>
+#include <kernel/validation_stats.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <script/standard.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using kernel::LatencyHistogram;
+using kernel::ValidationStage;
+using node::NodeContext;
+
+namespace {
+constexpr size_t NUM_REPLAY_BLOCKS{10};
+//! Transactions of each kind in every block of the corpus
+constexpr size_t NUM_CASH_TRANSFERS{100};
+constexpr size_t NUM_BOND_TRANSFERS{100};
+constexpr size_t NUM_CONVERSIONS_PER_TYPE{50};
+//! Outputs of each split transaction, which keeps them below the standard weight
+constexpr size_t SPLIT_OUTPUTS{500};
+
+constexpr CAmount OUTPUT_AMOUNT{COIN / 1000};
+constexpr CAmount TRANSFER_FEE{5000};
+
+/** The stages ConnectBlock records, in the order it runs them */
+constexpr std::array<ValidationStage, 4> CONNECT_BLOCK_STAGES{
+    ValidationStage::INPUTS_FETCH,
+    ValidationStage::CONVERSION_EVAL,
+    ValidationStage::SCRIPT_CHECKS,
+    ValidationStage::UNDO_WRITE,
+};
+
+void Submit(const NodeContext& node, const CMutableTransaction& tx)
+{
+    LOCK(::cs_main);
+    const MempoolAcceptResult res = node.chainman->ProcessTransaction(MakeTransactionRef(tx));
+    assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+}
+
+CAmounts GetTipSupply(const NodeContext& node)
+{
+    LOCK(::cs_main);
+    return node.chainman->ActiveChain().Tip()->GetTotalSupply();
+}
+
+CTxIn SpendOpTrue(const COutPoint& prevout)
+{
+    CTxIn in{prevout};
+    in.scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+    return in;
+}
+
+/** Pay value - fee to count outputs of amount each and the rest to change, which is the last output */
+CMutableTransaction MakeSplit(const COutPoint& prevout, CAmountType amountType, CAmount value, size_t count, CAmount amount)
+{
+    CMutableTransaction tx;
+    tx.vin.push_back(SpendOpTrue(prevout));
+    for (size_t i = 0; i < count; ++i) {
+        tx.vout.emplace_back(amountType, amount, P2WSH_OP_TRUE);
+    }
+    tx.vout.emplace_back(amountType, value - TRANSFER_FEE - amount * count, P2WSH_OP_TRUE);
+    return tx;
+}
+
+/** Spend two outputs of OUTPUT_AMOUNT, paying a random amount and change */
+CMutableTransaction MakeTransfer(const COutPoint& first, const COutPoint& second, CAmountType amountType, FastRandomContext& rng)
+{
+    const CAmount payment = 1 + rng.randrange(2 * OUTPUT_AMOUNT - TRANSFER_FEE - 1);
+    CMutableTransaction tx;
+    tx.vin.push_back(SpendOpTrue(first));
+    tx.vin.push_back(SpendOpTrue(second));
+    tx.vout.emplace_back(amountType, payment, GetScriptForDestination(WitnessV0KeyHash{uint160{rng.randbytes(20)}}));
+    tx.vout.emplace_back(amountType, 2 * OUTPUT_AMOUNT - TRANSFER_FEE - payment, P2WSH_OP_TRUE);
+    return tx;
+}
+
+/**
+ * Convert an output of OUTPUT_AMOUNT to the other amount type, asking for 95%
+ * of the output at the given supply and paying the remainder to a fresh
+ * address, so that the miner adds it to the coinbase.
+ */
+CMutableTransaction MakeConversion(const COutPoint& prevout, CAmountType inputType, const CAmounts& totalSupply, FastRandomContext& rng)
+{
+    const CAmountType outputType = inputType == CASH ? BOND : CASH;
+    const CAmount fee = inputType == CASH ? 2000 : 500;
+    const CScript remainder_script = GetScriptForDestination(WitnessV0KeyHash{uint160{rng.randbytes(20)}});
+    CMutableTransaction tx;
+    tx.vin.push_back(SpendOpTrue(prevout));
+    tx.vout.emplace_back(inputType, fee, GetConversionScript(outputType, remainder_script, /*nDeadline=*/0));
+    tx.vout.emplace_back(outputType, CalculateOutputAmount(totalSupply, OUTPUT_AMOUNT - fee, inputType) * 95 / 100, P2WSH_OP_TRUE);
+    return tx;
+}
+
+/** Split the given outputs into SPLIT_OUTPUTS outputs of OUTPUT_AMOUNT each, and mine the splits */
+std::vector<COutPoint> SplitOutputs(const NodeContext& node, const std::vector<std::pair<COutPoint, CAmount>>& sources, CAmountType amountType)
+{
+    std::vector<COutPoint> outputs;
+    for (const auto& [prevout, value] : sources) {
+        const CMutableTransaction split = MakeSplit(prevout, amountType, value, SPLIT_OUTPUTS, OUTPUT_AMOUNT);
+        Submit(node, split);
+        for (uint32_t i = 0; i < SPLIT_OUTPUTS; ++i) {
+            outputs.emplace_back(split.GetHash(), i);
+        }
+    }
+    MineBlock(node, P2WSH_OP_TRUE);
+    return outputs;
+}
+
+/**
+ * A corpus of PeerFed blocks on a regtest chain, each holding cash and bond
+ * transfers and conversions in both directions whose remainders the coinbase
+ * pays out. The blocks are connected as they are mined, so their undo data is
+ * on disk, and the coins they spend are restored from it into a cache on top
+ * of the coins tip.
+ */
+class BlockCorpus
+{
+public:
+    BlockCorpus()
+        : m_setup{MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::REGTEST)}
+    {
+        const NodeContext& node = m_setup->m_node;
+        const size_t outputs_per_type = NUM_REPLAY_BLOCKS * (2 * NUM_CASH_TRANSFERS + NUM_CONVERSIONS_PER_TYPE);
+        static_assert(NUM_CASH_TRANSFERS == NUM_BOND_TRANSFERS);
+        const size_t num_splits = (outputs_per_type + SPLIT_OUTPUTS - 1) / SPLIT_OUTPUTS;
+
+        // The genesis supply is all bonds, so every block reward is paid in bonds
+        std::vector<COutPoint> coinbase_bonds;
+        for (size_t i = 0; i < COINBASE_MATURITY + 1 + num_splits; ++i) {
+            coinbase_bonds.emplace_back(MineBlock(node, P2WSH_OP_TRUE).prevout.hash, BOND);
+        }
+        const CAmount coinbase_bond_value = 50 * COIN;
+
+        // Convert half of a block reward into cash to create a cash supply,
+        // paying it to an output for every cash split
+        CMutableTransaction seed;
+        {
+            const CAmount seed_input = coinbase_bond_value / 2;
+            const CAmount fee = 10000;
+            seed.vin.push_back(SpendOpTrue(coinbase_bonds[0]));
+            seed.vout.emplace_back(BOND, fee, GetConversionScript(CASH, CScript(), /*nDeadline=*/0));
+            seed.vout.emplace_back(BOND, coinbase_bond_value - seed_input - fee, P2WSH_OP_TRUE);
+            const CAmount cash = CalculateOutputAmount(GetTipSupply(node), seed_input, BOND) * 99 / 100;
+            for (size_t i = 0; i < num_splits; ++i) {
+                seed.vout.emplace_back(CASH, cash / num_splits, P2WSH_OP_TRUE);
+            }
+            Submit(node, seed);
+            MineBlock(node, P2WSH_OP_TRUE);
+        }
+
+        std::vector<std::pair<COutPoint, CAmount>> cash_sources;
+        std::vector<std::pair<COutPoint, CAmount>> bond_sources;
+        for (size_t i = 0; i < num_splits; ++i) {
+            cash_sources.emplace_back(COutPoint{seed.GetHash(), uint32_t(2 + i)}, seed.vout[2 + i].nValue);
+            bond_sources.emplace_back(coinbase_bonds[1 + i], coinbase_bond_value);
+        }
+        const std::vector<COutPoint> cash_outputs = SplitOutputs(node, cash_sources, CASH);
+        const std::vector<COutPoint> bond_outputs = SplitOutputs(node, bond_sources, BOND);
+
+        FastRandomContext rng(true);
+        size_t next_output{0};
+        for (size_t b = 0; b < NUM_REPLAY_BLOCKS; ++b) {
+            for (size_t i = 0; i < NUM_CASH_TRANSFERS; ++i, next_output += 2) {
+                Submit(node, MakeTransfer(cash_outputs[next_output], cash_outputs[next_output + 1], CASH, rng));
+                Submit(node, MakeTransfer(bond_outputs[next_output], bond_outputs[next_output + 1], BOND, rng));
+            }
+            const CAmounts totalSupply = GetTipSupply(node);
+            for (size_t i = 0; i < NUM_CONVERSIONS_PER_TYPE; ++i, ++next_output) {
+                Submit(node, MakeConversion(cash_outputs[next_output], CASH, totalSupply, rng));
+                Submit(node, MakeConversion(bond_outputs[next_output], BOND, totalSupply, rng));
+            }
+            MineBlock(node, P2WSH_OP_TRUE);
+        }
+
+        LOCK(::cs_main);
+        Chainstate& chainstate = node.chainman->ActiveChainstate();
+        m_index.resize(NUM_REPLAY_BLOCKS);
+        m_blocks.resize(NUM_REPLAY_BLOCKS);
+        CBlockIndex* pindex = chainstate.m_chain.Tip();
+        for (size_t b = NUM_REPLAY_BLOCKS; b-- > 0; pindex = pindex->pprev) {
+            m_index[b] = pindex;
+            const bool read{node::ReadBlockFromDisk(m_blocks[b], pindex, node.chainman->GetConsensus())};
+            assert(read);
+        }
+        m_coins = std::make_unique<CCoinsViewCache>(&chainstate.CoinsTip());
+        for (size_t b = NUM_REPLAY_BLOCKS; b-- > 0;) {
+            const DisconnectResult res = chainstate.DisconnectBlock(m_blocks[b], m_index[b], *m_coins);
+            assert(res == DISCONNECT_OK);
+        }
+        m_coins->SetBestBlock(m_index[0]->pprev->GetBlockHash());
+
+        // The mempool checks stored the transactions in the script execution
+        // cache, re-salt it so that the replay checks every script like a
+        // node that sees the blocks for the first time
+        kernel::ValidationCacheSizes cache_sizes{};
+        const bool cache{InitScriptExecutionCache(cache_sizes.script_execution_cache_bytes)};
+        assert(cache);
+    }
+
+    /** Connect every block of the corpus to a view on the restored coins */
+    void Replay() EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        Chainstate& chainstate = m_setup->m_node.chainman->ActiveChainstate();
+        CCoinsViewCache view{m_coins.get()};
+        for (size_t b = 0; b < NUM_REPLAY_BLOCKS; ++b) {
+            // CheckBlock caches its result in the block, so connect a copy
+            const CBlock block{m_blocks[b]};
+            BlockValidationState state;
+            const bool connected{chainstate.ConnectBlock(block, state, m_index[b], view)};
+            assert(connected);
+        }
+    }
+
+private:
+    const std::unique_ptr<const TestingSetup> m_setup;
+    std::vector<CBlockIndex*> m_index;
+    std::vector<CBlock> m_blocks;
+    std::unique_ptr<CCoinsViewCache> m_coins;
+};
+} // namespace
+
+/**
+ * Replay a corpus of representative blocks through ConnectBlock, against coins
+ * restored from their undo data, and print the time spent per block in the
+ * stages ConnectBlock records. The undo data is already on disk, so writing it
+ * is skipped.
+ */
+static void ConnectBlockReplay(benchmark::Bench& bench)
+{
+    BlockCorpus corpus;
+
+    std::array<LatencyHistogram::Snapshot, CONNECT_BLOCK_STAGES.size()> before;
+    for (size_t i = 0; i < CONNECT_BLOCK_STAGES.size(); ++i) {
+        before[i] = kernel::GetValidationStageHistogram(CONNECT_BLOCK_STAGES[i]).GetSnapshot();
+    }
+    uint64_t blocks{0};
+    std::chrono::microseconds connect_time{0};
+    bench.batch(NUM_REPLAY_BLOCKS).unit("block").run([&] {
+        LOCK(::cs_main);
+        const auto start{SteadyClock::now()};
+        corpus.Replay();
+        connect_time += std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - start);
+        blocks += NUM_REPLAY_BLOCKS;
+    });
+
+    std::cout << strprintf("ConnectBlockReplay: %.3f ms per block\n", connect_time.count() / 1000.0 / blocks);
+    for (size_t i = 0; i < CONNECT_BLOCK_STAGES.size(); ++i) {
+        const LatencyHistogram::Snapshot after{kernel::GetValidationStageHistogram(CONNECT_BLOCK_STAGES[i]).GetSnapshot()};
+        const uint64_t stage_us = after.total_us - before[i].total_us;
+        std::cout << strprintf("  %-16s %.3f ms per block (%.1f%%)\n", kernel::ValidationStageName(CONNECT_BLOCK_STAGES[i]) + ":",
+                               stage_us / 1000.0 / blocks, connect_time.count() ? 100.0 * stage_us / connect_time.count() : 0.0);
+    }
+}
+
+BENCHMARK(ConnectBlockReplay);
@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
 
@@ -51,4 +52,53 @@ static void CCoinsCaching(benchmark::Bench& bench)
     ECC_Stop();
 }
 
+// Lookups in a cache that holds many more coins than fit in the CPU caches, as the
+// chainstate's coins cache does during IBD. Half of the lookups miss.
+static void CCoinsCachingLookup(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    CCoinsView coins_dummy;
+    CCoinsViewCache coins(&coins_dummy);
+
+    constexpr uint32_t NUM_COINS{200000};
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(NUM_COINS);
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.out.scriptPubKey.assign(uint32_t{22}, 1);
+    for (uint32_t i = 0; i < NUM_COINS; ++i) {
+        outpoints.emplace_back(rng.rand256(), i);
+        coins.AddCoin(outpoints.back(), Coin{coin}, /*possible_overwrite=*/false);
+    }
+
+    bench.run([&] {
+        const COutPoint& hit{outpoints[rng.randrange(NUM_COINS)]};
+        const COutPoint miss{hit.hash, NUM_COINS + hit.n};
+        bool found{coins.HaveCoin(hit) && !coins.HaveCoin(miss)};
+        assert(found);
+    });
+}
+
+// Adding coins to an empty cache and flushing them, as ConnectBlock does with
+// the view it connects a block in.
+static void CCoinsCachingAddFlush(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    CCoinsView coins_dummy;
+    CCoinsViewCache coins(&coins_dummy);
+
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.out.scriptPubKey.assign(uint32_t{22}, 1);
+    bench.batch(5000).unit("coin").run([&] {
+        for (uint32_t i = 0; i < 5000; ++i) {
+            coins.AddCoin(COutPoint{rng.rand256(), i}, Coin{coin}, /*possible_overwrite=*/false);
+        }
+        // The dummy view can't be written to, but the cache is emptied regardless
+        coins.Flush();
+    });
+}
+
 BENCHMARK(CCoinsCaching);
+BENCHMARK(CCoinsCachingLookup);
+BENCHMARK(CCoinsCachingAddFlush);
@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 #include <checkqueue.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
@@ -70,4 +71,59 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     queue.StopWorkerThreads();
     ECC_Stop();
 }
+
+// This Benchmark measures how the CheckQueue scales with the number of threads
+// (including the master), with checks that each hash a little data.
+static void CCheckQueueScaling(benchmark::Bench& bench, int threads)
+{
+    struct HashJob {
+        unsigned char data[64] = {};
+        bool operator()()
+        {
+            unsigned char hash[CSHA256::OUTPUT_SIZE];
+            CSHA256().Write(data, sizeof(data)).Finalize(hash);
+            return hash[0] != 0 || hash[1] != 0;
+        }
+        void swap(HashJob& x) noexcept
+        {
+            std::swap(data, x.data);
+        };
+    };
+    CCheckQueue<HashJob> queue {QUEUE_BATCH_SIZE};
+    queue.StartWorkerThreads(threads - 1);
+
+    std::vector<std::vector<HashJob>> vBatches(BATCHES);
+    for (size_t i = 0; i < BATCHES; ++i) {
+        vBatches[i].resize(BATCH_SIZE);
+        for (size_t x = 0; x < BATCH_SIZE; ++x) {
+            vBatches[i][x].data[0] = i;
+            vBatches[i][x].data[1] = x;
+        }
+    }
+
+    bench.minEpochIterations(10).batch(BATCH_SIZE * BATCHES).unit("job").run([&] {
+        CCheckQueueControl<HashJob> control(&queue);
+        for (auto vChecks : vBatches) {
+            control.Add(vChecks);
+        }
+        control.Wait();
+    });
+    queue.StopWorkerThreads();
+}
+
+static void CCheckQueueScaling1Thread(benchmark::Bench& bench) { CCheckQueueScaling(bench, 1); }
+static void CCheckQueueScaling2Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 2); }
+static void CCheckQueueScaling4Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 4); }
+static void CCheckQueueScaling8Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 8); }
+static void CCheckQueueScaling16Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 16); }
+static void CCheckQueueScaling32Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 32); }
+static void CCheckQueueScaling64Threads(benchmark::Bench& bench) { CCheckQueueScaling(bench, 64); }
+
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+BENCHMARK(CCheckQueueScaling1Thread);
+BENCHMARK(CCheckQueueScaling2Threads);
+BENCHMARK(CCheckQueueScaling4Threads);
+BENCHMARK(CCheckQueueScaling8Threads);
+BENCHMARK(CCheckQueueScaling16Threads);
+BENCHMARK(CCheckQueueScaling32Threads);
+BENCHMARK(CCheckQueueScaling64Threads);
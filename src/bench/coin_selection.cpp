@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <interfaces/chain.h>
 #include <node/context.h>
+#include <wallet/coincontrol.h>
 #include <wallet/coinselection.h>
 #include <wallet/spend.h>
 #include <wallet/wallet.h>
@@ -13,6 +14,7 @@
 
 using node::NodeContext;
 using wallet::AttemptSelection;
+using wallet::CCoinControl;
 using wallet::CHANGE_LOWER;
 using wallet::COutput;
 using wallet::CWallet;
@@ -21,6 +23,7 @@ using wallet::CoinEligibilityFilter;
 using wallet::CoinSelectionParams;
 using wallet::CreateDummyWalletDatabase;
 using wallet::OutputGroup;
+using wallet::SelectCoins;
 using wallet::SelectCoinsBnB;
 using wallet::TxStateInactive;
 
@@ -83,6 +86,48 @@ static void CoinSelection(benchmark::Bench& bench)
     });
 }
 
+// Selection from unconfirmed change, which only succeeds after SelectCoins has
+// relaxed its eligibility filter a few times. Every attempt groups all of the
+// coins again, so this measures the cost of the fallback passes.
+static void CoinSelectionUnconfirmed(benchmark::Bench& bench)
+{
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node);
+    CWallet wallet(chain.get(), "", gArgs, CreateDummyWalletDatabase());
+    LOCK(wallet.cs_wallet);
+
+    wallet::CoinsResult available_coins;
+    for (int i = 0; i < 1000; ++i) {
+        CMutableTransaction tx;
+        tx.nLockTime = i;
+        tx.vout.emplace_back(BOND, 10 * COIN, CScript());
+        const CTxOut& txout = tx.vout.at(0);
+        COutput coin(COutPoint(tx.GetHash(), 0), txout, /*depth=*/0, CalculateMaximumSignedInputSize(txout, &wallet, /*coin_control=*/nullptr), /*spendable=*/true, /*solvable=*/true, /*safe=*/true, /*time=*/0, /*from_me=*/true, /*fees=*/0);
+        coin.ancestors = 1;
+        coin.descendants = 1;
+        available_coins.coins[OutputType::BECH32].push_back(coin);
+    }
+
+    FastRandomContext rand{};
+    const CoinSelectionParams coin_selection_params{
+        rand,
+        /*change_output_size=*/ 34,
+        /*change_spend_size=*/ 148,
+        /*min_change_target=*/ CHANGE_LOWER,
+        /*effective_feerate=*/ CFeeRate(0),
+        /*long_term_feerate=*/ CFeeRate(0),
+        /*discard_feerate=*/ CFeeRate(0),
+        /*tx_noinputs_size=*/ 0,
+        /*avoid_partial=*/ false,
+    };
+    const CCoinControl coin_control;
+    bench.run([&] {
+        auto result = SelectCoins(wallet, available_coins, 25 * COIN, coin_control, coin_selection_params);
+        assert(result);
+        assert(result->GetSelectedValue() >= 25 * COIN);
+    });
+}
+
 // Copied from src/wallet/test/coinselector_tests.cpp
 static void add_coin(const CAmount& nValue, int nInput, std::vector<OutputGroup>& set)
 {
@@ -122,4 +167,5 @@ static void BnBExhaustion(benchmark::Bench& bench)
 }
 
 BENCHMARK(CoinSelection);
+BENCHMARK(CoinSelectionUnconfirmed);
 BENCHMARK(BnBExhaustion);
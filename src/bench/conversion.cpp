@@ -0,0 +1,340 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <consensus/amount.h>
+#include <consensus/conversion.h>
+#include <consensus/tx_verify.h>
+#include <consensus/validation.h>
+#include <node/miner.h>
+#include <random.h>
+#include <script/standard.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <timedata.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <cassert>
+#include <vector>
+
+using node::NodeContext;
+
+namespace {
+struct Conversion {
+    CAmounts inputs{0};
+    CAmounts minOutputs{0};
+    CAmountType remainderType;
+};
+
+/** Generate conversions that are valid against the given supply */
+std::vector<Conversion> MakeConversions(const CAmounts& totalSupply, size_t count)
+{
+    FastRandomContext rng(true);
+    std::vector<Conversion> conversions(count);
+    for (auto& conversion : conversions) {
+        const CAmountType inputType = rng.randbool() ? CASH : BOND;
+        conversion.inputs[inputType] = 1 + rng.randrange(totalSupply[inputType] / 1000);
+        conversion.minOutputs[!inputType] = CalculateOutputAmount(totalSupply, conversion.inputs[inputType], inputType) * 99 / 100;
+        conversion.remainderType = rng.randbool() ? CASH : BOND;
+    }
+    return conversions;
+}
+
+/** The boost multiprecision implementation of Consensus::IsValidConversion, for comparison */
+bool IsValidConversionBoost(CAmounts& totalSupply, const CAmounts inputs, const CAmounts minOutputs, const CAmountType remainderType, CAmount& remainder)
+{
+    using namespace boost::multiprecision;
+    int128_t invariant_sq_in = pow((int128_t)totalSupply[CASH], 2) + pow((int128_t)totalSupply[BOND], 2);
+    int128_t invariant_sq_min_out = pow((int128_t)(totalSupply[CASH] + minOutputs[CASH] - inputs[CASH]), 2) + pow((int128_t)(totalSupply[BOND] + minOutputs[BOND] - inputs[BOND]), 2);
+    if (invariant_sq_min_out > invariant_sq_in) {
+        return false;
+    }
+    remainder = (sqrt(invariant_sq_in - pow((int128_t)(totalSupply[!remainderType] + minOutputs[!remainderType] - inputs[!remainderType]), 2)) - (int128_t)(totalSupply[remainderType] + minOutputs[remainderType] - inputs[remainderType])).convert_to<CAmount>();
+    totalSupply[CASH] += (minOutputs[CASH] - inputs[CASH]);
+    totalSupply[BOND] += (minOutputs[BOND] - inputs[BOND]);
+    totalSupply[remainderType] += remainder;
+    return true;
+}
+
+template <typename F>
+void RunConversions(benchmark::Bench& bench, F is_valid_conversion)
+{
+    const CAmounts totalSupply{1000000 * COIN, 400000 * COIN};
+    const std::vector<Conversion> conversions = MakeConversions(totalSupply, 1000);
+    bench.batch(conversions.size()).unit("conversion").run([&] {
+        for (const auto& conversion : conversions) {
+            CAmounts supply = totalSupply;
+            CAmount remainder;
+            const bool valid = is_valid_conversion(supply, conversion.inputs, conversion.minOutputs, conversion.remainderType, remainder);
+            assert(valid);
+        }
+    });
+}
+
+/** Spend an OP_TRUE output, paying value - fee to count outputs of amount each and the rest to change */
+CMutableTransaction MakeSplit(const COutPoint& prevout, CAmountType amountType, CAmount value, size_t count, CAmount amount)
+{
+    const CAmount fee = COIN / 1000;
+    CMutableTransaction tx;
+    tx.vin.emplace_back(prevout);
+    tx.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+    for (size_t i = 0; i < count; ++i) {
+        tx.vout.emplace_back(amountType, amount, P2WSH_OP_TRUE);
+    }
+    tx.vout.emplace_back(amountType, value - fee - amount * count, P2WSH_OP_TRUE);
+    return tx;
+}
+
+/**
+ * Spend an OP_TRUE output in a conversion to the other amount type, paying the
+ * fee in the input type and the remainder to its own address. The minimum
+ * output is min_output_percent of the output at the given supply, which leaves
+ * the slack for the conversion to stay valid as the supply moves within a block.
+ */
+CMutableTransaction MakeConversion(const COutPoint& prevout, CAmountType inputType, CAmount value, const CAmounts& totalSupply, int min_output_percent, FastRandomContext& rng, uint32_t deadline = 0)
+{
+    const CAmountType outputType = inputType == CASH ? BOND : CASH;
+    const CAmount fee = inputType == CASH ? 2000 : 500;
+    const CScript remainder_script = GetScriptForDestination(WitnessV0KeyHash{uint160{rng.randbytes(20)}});
+    CMutableTransaction tx;
+    tx.vin.emplace_back(prevout);
+    tx.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+    tx.vout.emplace_back(inputType, fee, GetConversionScript(outputType, remainder_script, deadline));
+    tx.vout.emplace_back(outputType, CalculateOutputAmount(totalSupply, value - fee, inputType) * min_output_percent / 100, P2WSH_OP_TRUE);
+    return tx;
+}
+
+void Submit(const NodeContext& node, const CMutableTransaction& tx)
+{
+    LOCK(::cs_main);
+    const MempoolAcceptResult res = node.chainman->ProcessTransaction(MakeTransactionRef(tx));
+    assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+}
+
+CAmounts GetTipSupply(const NodeContext& node)
+{
+    LOCK(::cs_main);
+    return node.chainman->ActiveChain().Tip()->GetTotalSupply();
+}
+
+/** Spend the converted output of a conversion, paying a higher fee than the conversion in the output type */
+CMutableTransaction MakeConversionChild(const CMutableTransaction& conversion)
+{
+    const CTxOut& output = conversion.vout[1];
+    const CAmount fee = output.amountType == CASH ? 6000 : 1500;
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint{conversion.GetHash(), 1});
+    tx.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+    tx.vout.emplace_back(output.amountType, output.nValue - fee, P2WSH_OP_TRUE);
+    return tx;
+}
+
+constexpr size_t NUM_CONVERSIONS{2000};
+constexpr size_t NUM_BOND_FEE_TXS{500};
+
+struct ConversionMempoolOptions {
+    //! Percentage of the output at the tip supply that the conversions require
+    int min_output_percent{95};
+    //! If not 0, every this many conversions one has a deadline a few blocks after the tip
+    size_t deadline_every{0};
+    //! If not 0, every this many pairs of conversions both have a child bumping their fee
+    size_t child_every{0};
+};
+
+/**
+ * Regtest chain whose mempool holds NUM_CONVERSIONS conversions, alternating
+ * cash to bonds and bonds to cash, and NUM_BOND_FEE_TXS transfers paying their
+ * fee in bonds. With the default min_output_percent every conversion fits in
+ * one block in any order, while with 99 (the slack the mempool requires) the
+ * conversions of one type are only valid if enough of the other type are
+ * executed before them.
+ */
+std::unique_ptr<const TestingSetup> MakeConversionMempool(const ConversionMempoolOptions& options = {}, const std::vector<const char*>& extra_args = {})
+{
+    auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::REGTEST, extra_args);
+    const NodeContext& node = testing_setup->m_node;
+
+    // The genesis supply is all bonds, so every block reward is paid in bonds
+    std::vector<COutPoint> coinbase_bonds;
+    for (int i = 0; i < COINBASE_MATURITY + 2; ++i) {
+        coinbase_bonds.emplace_back(MineBlock(node, P2WSH_OP_TRUE).prevout.hash, BOND);
+    }
+    const CAmount coinbase_bond_value = 50 * COIN;
+
+    // Convert half of a block reward into cash to create a cash supply
+    CMutableTransaction seed;
+    {
+        const CAmount seed_input = coinbase_bond_value / 2;
+        const CAmount fee = 10000;
+        seed.vin.emplace_back(coinbase_bonds[0]);
+        seed.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        seed.vout.emplace_back(BOND, fee, GetConversionScript(CASH, CScript(), /*nDeadline=*/0));
+        seed.vout.emplace_back(BOND, coinbase_bond_value - seed_input - fee, P2WSH_OP_TRUE);
+        seed.vout.emplace_back(CASH, CalculateOutputAmount(GetTipSupply(node), seed_input, BOND) * 99 / 100, P2WSH_OP_TRUE);
+        Submit(node, seed);
+        MineBlock(node, P2WSH_OP_TRUE);
+    }
+
+    // Split the converted cash and another block reward into small outputs
+    const size_t num_bond_outputs = NUM_CONVERSIONS / 2 + NUM_BOND_FEE_TXS;
+    const CAmount cash_amount = COIN / 100;
+    const CAmount bond_amount = COIN / 1000;
+    const CMutableTransaction cash_split = MakeSplit({seed.GetHash(), 2}, CASH, seed.vout[2].nValue, NUM_CONVERSIONS / 2, cash_amount);
+    const CMutableTransaction bond_split = MakeSplit(coinbase_bonds[1], BOND, coinbase_bond_value, num_bond_outputs, bond_amount);
+    Submit(node, cash_split);
+    Submit(node, bond_split);
+    MineBlock(node, P2WSH_OP_TRUE);
+
+    FastRandomContext rng(true);
+    const CAmounts totalSupply = GetTipSupply(node);
+    const uint32_t deadline = WITH_LOCK(::cs_main, return node.chainman->ActiveChain().Height()) + 10;
+    for (size_t i = 0; i < NUM_CONVERSIONS; ++i) {
+        const CAmountType inputType = i % 2 ? BOND : CASH;
+        const COutPoint prevout{inputType == CASH ? cash_split.GetHash() : bond_split.GetHash(), uint32_t(i / 2)};
+        const bool has_deadline = options.deadline_every && i % options.deadline_every == 0;
+        const CMutableTransaction conversion = MakeConversion(prevout, inputType, inputType == CASH ? cash_amount : bond_amount, totalSupply,
+                                                              options.min_output_percent, rng, has_deadline ? deadline : 0);
+        Submit(node, conversion);
+        if (options.child_every && (i / 2) % options.child_every == 0) {
+            Submit(node, MakeConversionChild(conversion));
+        }
+    }
+    for (size_t i = NUM_CONVERSIONS / 2; i < num_bond_outputs; ++i) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint{bond_split.GetHash(), uint32_t(i)});
+        tx.vin.back().scriptWitness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+        tx.vout.emplace_back(BOND, bond_amount - 500, P2WSH_OP_TRUE);
+        Submit(node, tx);
+    }
+    return testing_setup;
+}
+} // namespace
+
+static void IsValidConversion(benchmark::Bench& bench)
+{
+    RunConversions(bench, Consensus::IsValidConversion);
+}
+
+static void IsValidConversionBoostReference(benchmark::Bench& bench)
+{
+    RunConversions(bench, IsValidConversionBoost);
+}
+
+static void CheckValidConversionAtTip(benchmark::Bench& bench, int check_last_N_blocks)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestChain100Setup>();
+    LOCK(::cs_main);
+    const CBlockIndex* tip = testing_setup->m_node.chainman->ActiveChain().Tip();
+
+    // Ask for twice the output available at the tip, so that every block in
+    // the window is checked before the conversion is found to be invalid
+    CTxConversionInfo info;
+    info.remainderType = CASH;
+    info.inputs[BOND] = COIN;
+    info.minOutputs[CASH] = 2 * CalculateOutputAmount(tip->GetTotalSupply(), COIN, BOND);
+
+    bench.run([&] {
+        const bool valid = CheckValidConversionAtTip(tip, info, check_last_N_blocks, DEFAULT_MEMPOOL_CONVERSION_BUFFER);
+        assert(!valid);
+    });
+}
+
+static void CheckValidConversionAtTip3(benchmark::Bench& bench) { CheckValidConversionAtTip(bench, 3); }
+static void CheckValidConversionAtTip6(benchmark::Bench& bench) { CheckValidConversionAtTip(bench, 6); }
+static void CheckValidConversionAtTip24(benchmark::Bench& bench) { CheckValidConversionAtTip(bench, 24); }
+static void CheckValidConversionAtTip100(benchmark::Bench& bench) { CheckValidConversionAtTip(bench, 100); }
+
+static void AssembleBlockConversions(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeConversionMempool();
+    bench.run([&] {
+        PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE);
+    });
+}
+
+/**
+ * Assemble blocks from conversions that can not all be executed in one block,
+ * with the given time to sequence them after feerate order. The batch is the
+ * number of conversions in the block, so the results compare how many
+ * conversions each block includes.
+ */
+static void AssembleBlockSequencedConversions(benchmark::Bench& bench, const char* conversion_time)
+{
+    const auto testing_setup = MakeConversionMempool({.min_output_percent = 99}, {conversion_time});
+    const std::shared_ptr<CBlock> block = PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE);
+    size_t num_conversions{0};
+    for (const CTransactionRef& tx : block->vtx) {
+        if (tx->IsConversion()) ++num_conversions;
+    }
+    assert(num_conversions > 0);
+    bench.batch(num_conversions).unit("included conversion").run([&] {
+        PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE);
+    });
+}
+
+static void AssembleBlockConversionsFeerateOrder(benchmark::Bench& bench) { AssembleBlockSequencedConversions(bench, "-blockconversiontime=0"); }
+static void AssembleBlockConversionsSequenced(benchmark::Bench& bench) { AssembleBlockSequencedConversions(bench, "-blockconversiontime=50"); }
+
+static void ConnectBlockConversions(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeConversionMempool();
+    const NodeContext& node = testing_setup->m_node;
+    const std::shared_ptr<CBlock> block = PrepareBlock(node, P2WSH_OP_TRUE);
+    // The coinbase is followed by every mempool transaction
+    assert(block->vtx.size() == 1 + NUM_CONVERSIONS + NUM_BOND_FEE_TXS);
+
+    LOCK(::cs_main);
+    Chainstate& chainstate = node.chainman->ActiveChainstate();
+    CBlockIndex* tip = chainstate.m_chain.Tip();
+    bench.unit("block").run([&] {
+        BlockValidationState state;
+        const bool valid = TestBlockValidity(state, node.chainman->GetParams(), chainstate, *block, tip, GetAdjustedTime, /*fCheckPOW=*/false, /*fCheckMerkleRoot=*/false);
+        assert(valid);
+    });
+}
+
+/**
+ * Connect and disconnect a block over a mempool of conversions in both
+ * directions, some with deadlines and some with children paying for them, and
+ * transfers paying their fees in bonds. The block only holds part of the
+ * mempool, so this covers assembling it, moving the supply and with it the
+ * normalized fees of the rest in removeForBlock(), and the reorg path returning
+ * its transactions and limiting the mempool size again.
+ */
+static void ConversionMempoolStress(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeConversionMempool({.deadline_every = 3, .child_every = 4}, {"-blockmaxweight=1000000"});
+    const NodeContext& node = testing_setup->m_node;
+    Chainstate& chainstate = node.chainman->ActiveChainstate();
+    const size_t mempool_size = WITH_LOCK(node.mempool->cs, return node.mempool->size());
+    assert(mempool_size > NUM_CONVERSIONS + NUM_BOND_FEE_TXS);
+
+    bench.unit("block").run([&] {
+        MineBlock(node, P2WSH_OP_TRUE);
+        CBlockIndex* tip = WITH_LOCK(::cs_main, return chainstate.m_chain.Tip());
+        BlockValidationState state;
+        const bool invalidated = chainstate.InvalidateBlock(state, tip);
+        assert(invalidated);
+        // The same block is connected again by the next run
+        LOCK(::cs_main);
+        chainstate.ResetBlockFailureFlags(tip);
+    });
+}
+
+BENCHMARK(IsValidConversion);
+BENCHMARK(IsValidConversionBoostReference);
+BENCHMARK(CheckValidConversionAtTip3);
+BENCHMARK(CheckValidConversionAtTip6);
+BENCHMARK(CheckValidConversionAtTip24);
+BENCHMARK(CheckValidConversionAtTip100);
+BENCHMARK(AssembleBlockConversions);
+BENCHMARK(AssembleBlockConversionsFeerateOrder);
+BENCHMARK(AssembleBlockConversionsSequenced);
+BENCHMARK(ConnectBlockConversions);
+BENCHMARK(ConversionMempoolStress);
@@ -4,6 +4,8 @@
 
 
 #include <bench/bench.h>
+#include <crypto/blake3.h>
+#include <crypto/blake3_header.h>
 #include <crypto/muhash.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
@@ -12,6 +14,7 @@
 #include <crypto/sha512.h>
 #include <crypto/siphash.h>
 #include <hash.h>
+#include <primitives/block.h>
 #include <random.h>
 #include <uint256.h>
 
@@ -54,6 +57,72 @@ static void SHA3_256_1M(benchmark::Bench& bench)
     });
 }
 
+static void BLAKE3_1M(benchmark::Bench& bench)
+{
+    uint8_t hash[BLAKE3_OUT_LEN];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    bench.batch(in.size()).unit("byte").run([&] {
+        blake3_hasher hasher;
+        blake3_hasher_init(&hasher);
+        blake3_hasher_update(&hasher, in.data(), in.size());
+        blake3_hasher_finalize(&hasher, hash, BLAKE3_OUT_LEN);
+    });
+}
+
+static CBlockHeader BenchHeader()
+{
+    CBlockHeader header;
+    header.nVersion = 0x20000000;
+    header.hashPrevBlock = GetRandHash();
+    header.hashMerkleRoot = GetRandHash();
+    header.nTime = 1700000000;
+    header.nBits = 0x1d00ffff;
+    return header;
+}
+
+/** Proof of work check of one header, as done for every header received */
+static void BLAKE3HeaderHash(benchmark::Bench& bench)
+{
+    CBlockHeader header{BenchHeader()};
+    bench.unit("header").run([&] {
+        ++header.nNonce;
+        ankerl::nanobench::doNotOptimizeAway(header.GetHash());
+    });
+}
+
+/** Hashing a headers message worth of headers at once */
+static void BLAKE3HeaderHashMany(benchmark::Bench& bench)
+{
+    static constexpr size_t HEADERS{2000};
+    std::vector<unsigned char> headers(HEADERS * CBlockHeader::SERIALIZED_SIZE);
+    CBlockHeader header{BenchHeader()};
+    for (size_t i = 0; i < HEADERS; ++i) {
+        header.nNonce = i;
+        header.SerializeToBuffer(headers.data() + i * CBlockHeader::SERIALIZED_SIZE);
+    }
+    std::vector<unsigned char> hashes(HEADERS * CBlake3HeaderHasher::OUTPUT_SIZE);
+    bench.batch(HEADERS).unit("header").run([&] {
+        CBlake3HeaderHasher::HashMany(headers.data(), HEADERS, hashes.data());
+    });
+}
+
+/** Nonce scanning as the miner's ScanHash does it, from a cached midstate */
+static void BLAKE3ScanHash(benchmark::Bench& bench)
+{
+    static constexpr uint32_t NONCES{4096};
+    unsigned char header[CBlockHeader::SERIALIZED_SIZE];
+    BenchHeader().SerializeToBuffer(header);
+    const CBlake3HeaderHasher hasher(header);
+    uint256 hash;
+    uint32_t nonce{0};
+    bench.batch(NONCES).unit("nonce").run([&] {
+        for (uint32_t i = 0; i < NONCES; ++i) {
+            hasher.Finalize(++nonce, hash.begin());
+        }
+        ankerl::nanobench::doNotOptimizeAway(hash);
+    });
+}
+
 static void SHA256_32b(benchmark::Bench& bench)
 {
     std::vector<uint8_t> in(32,0);
@@ -150,11 +219,29 @@ static void MuHashPrecompute(benchmark::Bench& bench)
     });
 }
 
+static void MuHashFinalize(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    MuHash3072 acc{rng.randbytes(32)};
+    acc /= MuHash3072{rng.randbytes(32)};
+
+    bench.run([&] {
+        // Finalize() inverts the denominator, which dominates its cost
+        uint256 out;
+        acc.Finalize(out);
+        acc /= MuHash3072{out};
+    });
+}
+
 BENCHMARK(RIPEMD160);
 BENCHMARK(SHA1);
 BENCHMARK(SHA256);
 BENCHMARK(SHA512);
 BENCHMARK(SHA3_256_1M);
+BENCHMARK(BLAKE3_1M);
+BENCHMARK(BLAKE3HeaderHash);
+BENCHMARK(BLAKE3HeaderHashMany);
+BENCHMARK(BLAKE3ScanHash);
 
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
@@ -166,3 +253,4 @@ BENCHMARK(MuHash);
 BENCHMARK(MuHashMul);
 BENCHMARK(MuHashDiv);
 BENCHMARK(MuHashPrecompute);
+BENCHMARK(MuHashFinalize);
@@ -7,6 +7,9 @@
 namespace benchmark {
 namespace data {
 
+#include <bench/data/asmap.raw.h>
+const std::vector<uint8_t> asmap{std::begin(asmap_raw), std::end(asmap_raw)};
+
 #include <bench/data/block413567.raw.h>
 const std::vector<uint8_t> block413567{std::begin(block413567_raw), std::end(block413567_raw)};
 
@@ -6,9 +6,11 @@
 #include <key.h>
 #include <script/descriptor.h>
 #include <script/standard.h>
+#include <test/util/setup_common.h>
 
 #include <string>
 #include <utility>
+#include <vector>
 
 static void ExpandDescriptor(benchmark::Bench& bench)
 {
@@ -27,4 +29,35 @@ static void ExpandDescriptor(benchmark::Bench& bench)
     });
 }
 
+static void ExpandXpubRange(benchmark::Bench& bench, bool parallel)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const auto desc_str = "wpkh(xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4koxb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL/1/*)";
+    const std::pair<int, int> range = {0, 1000};
+    FlatSigningProvider provider;
+    std::string error;
+    auto desc = Parse(desc_str, provider, error);
+    assert(desc);
+
+    bench.run([&] {
+        FlatSigningProvider out;
+        if (parallel) {
+            std::vector<std::vector<CScript>> scripts;
+            bool success = ExpandRange(*desc, range.first, range.second, provider, scripts, out);
+            assert(success);
+        } else {
+            for (int i = range.first; i <= range.second; ++i) {
+                std::vector<CScript> scripts;
+                bool success = desc->Expand(i, provider, scripts, out);
+                assert(success);
+            }
+        }
+    });
+}
+
+static void ExpandXpubRangeSequential(benchmark::Bench& bench) { ExpandXpubRange(bench, /*parallel=*/false); }
+static void ExpandXpubRangeParallel(benchmark::Bench& bench) { ExpandXpubRange(bench, /*parallel=*/true); }
+
 BENCHMARK(ExpandDescriptor);
+BENCHMARK(ExpandXpubRangeSequential);
+BENCHMARK(ExpandXpubRangeParallel);
@@ -4,6 +4,12 @@
 
 #include <bench/bench.h>
 #include <blockfilter.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <util/system.h>
+
+#include <cassert>
+#include <vector>
 
 static const GCSFilter::ElementSet GenerateGCSTestElements()
 {
@@ -23,6 +29,45 @@ static const GCSFilter::ElementSet GenerateGCSTestElements()
     return elements;
 }
 
+static void GenerateGCSTestBlocks(std::vector<CBlock>& blocks, std::vector<CBlockUndo>& block_undos)
+{
+    // A window of blocks with 1,000 distinct output scripts each, roughly a
+    // full block worth of filter elements
+    for (int n = 0; n < 64; ++n) {
+        CMutableTransaction tx;
+        for (int i = 0; i < 1000; ++i) {
+            tx.vout.emplace_back(CASH, 1, CScript() << OP_0 << std::vector<unsigned char>{static_cast<unsigned char>(n), static_cast<unsigned char>(i), static_cast<unsigned char>(i >> 8)});
+        }
+        CBlock block;
+        block.nNonce = n;
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+        blocks.push_back(std::move(block));
+        block_undos.emplace_back();
+    }
+}
+
+static void GCSFilterConstructBlocks(benchmark::Bench& bench, int n_threads)
+{
+    std::vector<CBlock> blocks;
+    std::vector<CBlockUndo> block_undos;
+    GenerateGCSTestBlocks(blocks, block_undos);
+
+    bench.batch(blocks.size()).unit("block").run([&] {
+        const auto filters{ConstructBlockFilters(BlockFilterType::BASIC, blocks, block_undos, n_threads)};
+        assert(filters.size() == blocks.size());
+    });
+}
+
+static void GCSFilterConstructBlocksSingleThread(benchmark::Bench& bench)
+{
+    GCSFilterConstructBlocks(bench, 1);
+}
+
+static void GCSFilterConstructBlocksAllCores(benchmark::Bench& bench)
+{
+    GCSFilterConstructBlocks(bench, GetNumCores());
+}
+
 static void GCSBlockFilterGetHash(benchmark::Bench& bench)
 {
     auto elements = GenerateGCSTestElements();
@@ -83,6 +128,8 @@ static void GCSFilterMatch(benchmark::Bench& bench)
 }
 BENCHMARK(GCSBlockFilterGetHash);
 BENCHMARK(GCSFilterConstruct);
+BENCHMARK(GCSFilterConstructBlocksSingleThread);
+BENCHMARK(GCSFilterConstructBlocksAllCores);
 BENCHMARK(GCSFilterDecode);
 BENCHMARK(GCSFilterDecodeSkipCheck);
 BENCHMARK(GCSFilterMatch);
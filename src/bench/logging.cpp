@@ -33,6 +33,14 @@ static void LoggingNoCategory(benchmark::Bench& bench)
 {
     Logging(bench, {"-logthreadnames=0", "-debug=0"}, [] { LogPrint(BCLog::NET, "%s\n", "test"); });
 }
+static void LoggingAsyncYoCategory(benchmark::Bench& bench)
+{
+    Logging(bench, {"-logthreadnames=0", "-debug=net", "-logasync"}, [] { LogPrint(BCLog::NET, "%s\n", "test"); });
+}
+static void LoggingAsyncYoThreadNames(benchmark::Bench& bench)
+{
+    Logging(bench, {"-logthreadnames=1", "-logasync"}, [] { LogPrintf("%s\n", "test"); });
+}
 static void LoggingNoFile(benchmark::Bench& bench)
 {
     Logging(bench, {"-nodebuglogfile", "-debug=1"}, [] {
@@ -45,4 +53,6 @@ BENCHMARK(LoggingYoThreadNames);
 BENCHMARK(LoggingNoThreadNames);
 BENCHMARK(LoggingYoCategory);
 BENCHMARK(LoggingNoCategory);
+BENCHMARK(LoggingAsyncYoCategory);
+BENCHMARK(LoggingAsyncYoThreadNames);
 BENCHMARK(LoggingNoFile);
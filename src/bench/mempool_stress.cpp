@@ -116,5 +116,46 @@ static void MempoolCheck(benchmark::Bench& bench)
     });
 }
 
+static void MempoolUpdateNormalizedFees(benchmark::Bench& bench, size_t num_entries)
+{
+    FastRandomContext det_rand{true};
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
+    CTxMemPool& pool = *testing_setup.get()->m_node.mempool;
+    LOCK2(cs_main, pool.cs);
+
+    // Every tenth transaction pays its fee in bonds and has a child paying in cash
+    CTransactionRef parent;
+    for (size_t i = 0; i < num_entries; ++i) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = i % 10 == 1 ? COutPoint(parent->GetHash(), 0) : COutPoint(det_rand.rand256(), 0);
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        tx.vout[0].nValue = 10 * COIN;
+        CTransactionRef ref = MakeTransactionRef(tx);
+
+        CAmounts nFees = {0};
+        nFees[i % 10 == 0 ? BOND : CASH] = 1000;
+        pool.addUnchecked(CTxMemPoolEntry(ref, nFees, /*normalized_fee=*/1000, /*time=*/0, /*entry_height=*/1, /*spends_coinbase=*/false, /*sigops_cost=*/4, LockPoints{}));
+        if (i % 10 == 0) parent = ref;
+    }
+
+    const auto filter_none = [](CTxMemPool::txiter) { return false; };
+    const CAmounts supplies[2] = {{1000 * COIN, 500 * COIN}, {1000 * COIN, 501 * COIN}};
+    unsigned int height = 1;
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        // A block without mempool transactions that changes the conversion rate
+        pool.removeForBlock({}, height, supplies[height % 2], filter_none);
+        ++height;
+    });
+}
+
+static void MempoolUpdateNormalizedFees10k(benchmark::Bench& bench) { MempoolUpdateNormalizedFees(bench, 10000); }
+static void MempoolUpdateNormalizedFees100k(benchmark::Bench& bench) { MempoolUpdateNormalizedFees(bench, 100000); }
+static void MempoolUpdateNormalizedFees300k(benchmark::Bench& bench) { MempoolUpdateNormalizedFees(bench, 300000); }
+
 BENCHMARK(ComplexMemPool);
 BENCHMARK(MempoolCheck);
+BENCHMARK(MempoolUpdateNormalizedFees10k);
+BENCHMARK(MempoolUpdateNormalizedFees100k);
+BENCHMARK(MempoolUpdateNormalizedFees300k);
@@ -0,0 +1,57 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <net.h>
+#include <protocol.h>
+#include <test/util/setup_common.h>
+#include <version.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+/* Message sizes of an inv of one transaction, a typical transaction and a full block */
+static constexpr size_t MESSAGE_SIZE_INV = 37;
+static constexpr size_t MESSAGE_SIZE_TX = 250;
+static constexpr size_t MESSAGE_SIZE_BLOCK = 1000 * 1000;
+
+/** Serialize a message and read it back, the per-message work of both sides of a connection. */
+static void P2PTransport(benchmark::Bench& bench, const TransportSerializer& serializer, TransportDeserializer& deserializer, size_t message_size)
+{
+    std::vector<unsigned char> header;
+    bench.batch(message_size).unit("byte").run([&] {
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::TX;
+        msg.data.assign(message_size, 0x42);
+        serializer.prepareForTransport(msg, header);
+        for (Span<const uint8_t> bytes : {Span<const uint8_t>{header}, Span<const uint8_t>{msg.data}}) {
+            while (!bytes.empty()) {
+                const int ret{deserializer.Read(bytes)};
+                assert(ret > 0);
+            }
+        }
+        assert(deserializer.Complete());
+        bool reject_message;
+        CNetMessage received{deserializer.GetMessage(std::chrono::microseconds{0}, reject_message)};
+        assert(!reject_message && received.m_message_size == message_size);
+    });
+}
+
+static void P2PTransportV1(benchmark::Bench& bench, size_t message_size)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    V1TransportSerializer serializer;
+    V1TransportDeserializer deserializer{Params(), /*node_id=*/0, SER_NETWORK, INIT_PROTO_VERSION};
+    P2PTransport(bench, serializer, deserializer, message_size);
+}
+
+static void P2PTransportV1Inv(benchmark::Bench& bench) { P2PTransportV1(bench, MESSAGE_SIZE_INV); }
+static void P2PTransportV1Tx(benchmark::Bench& bench) { P2PTransportV1(bench, MESSAGE_SIZE_TX); }
+static void P2PTransportV1Block(benchmark::Bench& bench) { P2PTransportV1(bench, MESSAGE_SIZE_BLOCK); }
+
+BENCHMARK(P2PTransportV1Inv);
+BENCHMARK(P2PTransportV1Tx);
+BENCHMARK(P2PTransportV1Block);
@@ -24,6 +24,19 @@ static void RollingBloom(benchmark::Bench& bench)
     });
 }
 
+static void RollingBloomGrowing(benchmark::Bench& bench)
+{
+    // Like the per-peer inventory filters, which start small and grow when needed
+    bench.run([&] {
+        CRollingBloomFilter filter(50000, 0.000001, 1000);
+        std::vector<unsigned char> data(32);
+        for (uint32_t count = 0; count < 20000; ++count) {
+            WriteLE32(data.data(), count);
+            filter.insert(data);
+        }
+    });
+}
+
 static void RollingBloomReset(benchmark::Bench& bench)
 {
     CRollingBloomFilter filter(120000, 0.000001);
@@ -33,4 +46,5 @@ static void RollingBloomReset(benchmark::Bench& bench)
 }
 
 BENCHMARK(RollingBloom);
+BENCHMARK(RollingBloomGrowing);
 BENCHMARK(RollingBloomReset);
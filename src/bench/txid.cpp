@@ -0,0 +1,57 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <consensus/amount.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+
+#include <vector>
+
+/** Number of transactions in a full block of typical one or two input transactions */
+static constexpr size_t NUM_TXS = 2500;
+
+static std::vector<CMutableTransaction> CreateTransactions()
+{
+    FastRandomContext rng(true);
+    std::vector<CMutableTransaction> txs(NUM_TXS);
+    for (size_t i = 0; i < txs.size(); ++i) {
+        for (size_t j = 0; j < 1 + i % 2; ++j) {
+            txs[i].vin.emplace_back(rng.rand256(), rng.rand32());
+            // Two thirds spend a segwit output: a signature and a public key
+            if (i % 3) {
+                txs[i].vin.back().scriptWitness.stack = {rng.randbytes(72), rng.randbytes(33)};
+            } else {
+                txs[i].vin.back().scriptSig = CScript() << rng.randbytes(72) << rng.randbytes(33);
+            }
+        }
+        txs[i].vout.emplace_back(CASH, rng.randrange(COIN), CScript() << OP_0 << rng.randbytes(20));
+        txs[i].vout.emplace_back(CASH, rng.randrange(COIN), CScript() << OP_0 << rng.randbytes(20));
+    }
+    return txs;
+}
+
+static void TxidPerTransaction(benchmark::Bench& bench)
+{
+    const std::vector<CMutableTransaction> txs{CreateTransactions()};
+    bench.batch(txs.size()).unit("tx").run([&] {
+        std::vector<CTransactionRef> refs;
+        refs.reserve(txs.size());
+        for (CMutableTransaction tx : txs) refs.push_back(MakeTransactionRef(std::move(tx)));
+        ankerl::nanobench::doNotOptimizeAway(refs);
+    });
+}
+
+static void TxidBatch(benchmark::Bench& bench)
+{
+    const std::vector<CMutableTransaction> txs{CreateTransactions()};
+    bench.batch(txs.size()).unit("tx").run([&] {
+        std::vector<CMutableTransaction> copy{txs};
+        ankerl::nanobench::doNotOptimizeAway(MakeTransactionRefs(std::move(copy)));
+    });
+}
+
+BENCHMARK(TxidPerTransaction);
+BENCHMARK(TxidBatch);
@@ -14,9 +14,11 @@
 
 #include <array>
 
-// Microbenchmark for verification of a basic P2WPKH script. Can be easily
-// modified to measure performance of other types of scripts.
-static void VerifyScriptBench(benchmark::Bench& bench)
+// Microbenchmark for verification of a basic P2WPKH or P2PKH spend. The
+// standard templates are verified without the interpreter loop; the same
+// scripts in a non-template form (P2WSH, or with a leading OP_NOP) measure the
+// general path for comparison.
+static void VerifyScriptBench(benchmark::Bench& bench, bool witness, bool use_template)
 {
     const ECCVerifyHandle verify_handle;
     ECC_Start();
@@ -37,16 +39,27 @@ static void VerifyScriptBench(benchmark::Bench& bench)
     CHash160().Write(pubkey).Finalize(pubkeyHash);
 
     // Script.
-    CScript scriptPubKey = CScript() << witnessversion << ToByteVector(pubkeyHash);
-    CScript scriptSig;
     CScript witScriptPubkey = CScript() << OP_DUP << OP_HASH160 << ToByteVector(pubkeyHash) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript scriptPubKey;
+    if (witness) {
+        scriptPubKey = use_template ? CScript() << witnessversion << ToByteVector(pubkeyHash) : GetScriptForDestination(WitnessV0ScriptHash(witScriptPubkey));
+    } else {
+        scriptPubKey = use_template ? witScriptPubkey : CScript() << OP_NOP << OP_DUP << OP_HASH160 << ToByteVector(pubkeyHash) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
     const CMutableTransaction& txCredit = BuildCreditingTransaction(scriptPubKey, 1);
-    CMutableTransaction txSpend = BuildSpendingTransaction(scriptSig, CScriptWitness(), CTransaction(txCredit));
-    CScriptWitness& witness = txSpend.vin[0].scriptWitness;
-    witness.stack.emplace_back();
-    key.Sign(SignatureHash(witScriptPubkey, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].amountType, txCredit.vout[0].nValue, SigVersion::WITNESS_V0), witness.stack.back());
-    witness.stack.back().push_back(static_cast<unsigned char>(SIGHASH_ALL));
-    witness.stack.push_back(ToByteVector(pubkey));
+    CMutableTransaction txSpend = BuildSpendingTransaction(CScript(), CScriptWitness(), CTransaction(txCredit));
+    std::vector<unsigned char> sig;
+    if (witness) {
+        key.Sign(SignatureHash(witScriptPubkey, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].amountType, txCredit.vout[0].nValue, SigVersion::WITNESS_V0), sig);
+        sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        CScriptWitness& scriptWitness = txSpend.vin[0].scriptWitness;
+        scriptWitness.stack = {sig, ToByteVector(pubkey)};
+        if (!use_template) scriptWitness.stack.emplace_back(witScriptPubkey.begin(), witScriptPubkey.end());
+    } else {
+        key.Sign(SignatureHash(scriptPubKey, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].amountType, txCredit.vout[0].nValue, SigVersion::BASE), sig);
+        sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        txSpend.vin[0].scriptSig = CScript() << sig << ToByteVector(pubkey);
+    }
 
     // Benchmark.
     bench.run([&] {
@@ -76,6 +89,11 @@ static void VerifyScriptBench(benchmark::Bench& bench)
     ECC_Stop();
 }
 
+static void VerifyScriptP2WPKH(benchmark::Bench& bench) { VerifyScriptBench(bench, /*witness=*/true, /*use_template=*/true); }
+static void VerifyScriptP2WSHPKH(benchmark::Bench& bench) { VerifyScriptBench(bench, /*witness=*/true, /*use_template=*/false); }
+static void VerifyScriptP2PKH(benchmark::Bench& bench) { VerifyScriptBench(bench, /*witness=*/false, /*use_template=*/true); }
+static void VerifyScriptP2PKHNonTemplate(benchmark::Bench& bench) { VerifyScriptBench(bench, /*witness=*/false, /*use_template=*/false); }
+
 static void VerifyNestedIfScript(benchmark::Bench& bench)
 {
     std::vector<std::vector<unsigned char>> stack;
@@ -97,5 +115,8 @@ static void VerifyNestedIfScript(benchmark::Bench& bench)
     });
 }
 
-BENCHMARK(VerifyScriptBench);
+BENCHMARK(VerifyScriptP2WPKH);
+BENCHMARK(VerifyScriptP2WSHPKH);
+BENCHMARK(VerifyScriptP2PKH);
+BENCHMARK(VerifyScriptP2PKHNonTemplate);
 BENCHMARK(VerifyNestedIfScript);
@@ -0,0 +1,29 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <streams.h>
+
+#include <cstddef>
+#include <vector>
+
+static void Xor(benchmark::Bench& bench, size_t size)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    // CDBWrapper obfuscates values with a random 8 byte key
+    const std::vector<unsigned char> key{rng.randbytes(8)};
+    CDataStream data{rng.randbytes(size), SER_DISK, 0};
+    bench.batch(size).unit("byte").run([&] {
+        data.Xor(key);
+        ankerl::nanobench::doNotOptimizeAway(data);
+    });
+}
+
+// The size of a typical serialized coin, as read from the chainstate on a cache miss
+static void XorCoin(benchmark::Bench& bench) { Xor(bench, 40); }
+static void XorOneMB(benchmark::Bench& bench) { Xor(bench, 1 << 20); }
+
+BENCHMARK(XorCoin);
+BENCHMARK(XorOneMB);
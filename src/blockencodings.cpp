@@ -16,12 +16,19 @@
 
 #include <unordered_map>
 
-CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block) :
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, size_t omitted_remainders) :
         nonce(GetRand<uint64_t>()),
         shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
     FillShortTxIDSelector();
     //TODO: Use our mempool prior to block acceptance to predictively fill more than just the coinbase
-    prefilledtxn[0] = {0, block.vtx[0]};
+    if (omitted_remainders > 0 && omitted_remainders <= block.vtx[0]->vout.size()) {
+        CMutableTransaction coinbase(*block.vtx[0]);
+        coinbase.vout.resize(coinbase.vout.size() - omitted_remainders);
+        prefilledtxn[0] = {0, MakeTransactionRef(std::move(coinbase))};
+        omitted_remainder_outputs = omitted_remainders;
+    } else {
+        prefilledtxn[0] = {0, block.vtx[0]};
+    }
     for (size_t i = 1; i < block.vtx.size(); i++) {
         const CTransaction& tx = *block.vtx[i];
         shorttxids[i - 1] = GetShortID(tx.GetWitnessHash());
@@ -73,6 +80,7 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
         txn_available[lastprefilledindex] = cmpctblock.prefilledtxn[i].tx;
     }
     prefilled_count = cmpctblock.prefilledtxn.size();
+    omitted_remainder_outputs = cmpctblock.omitted_remainder_outputs;
 
     // Calculate map of txids -> positions and check mempool to see what we have (or don't)
     // Because well-formed cmpctblock messages will have a (relatively) uniform distribution
@@ -173,7 +181,7 @@ bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const {
     return txn_available[index] != nullptr;
 }
 
-ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing) {
+ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing, const RemainderOutputsPredictor& predict_remainders) {
     assert(!header.IsNull());
     uint256 hash = header.GetHash();
     block = header;
@@ -196,6 +204,18 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
     if (vtx_missing.size() != tx_missing_offset)
         return READ_STATUS_INVALID;
 
+    if (omitted_remainder_outputs > 0) {
+        // Restore the remainder outputs stripped from the coinbase. A failed
+        // or mismatched prediction is not the peer's fault, since our view of
+        // the parent may differ, so fall back to requesting the full block.
+        if (!predict_remainders) return READ_STATUS_FAILED;
+        const std::optional<std::vector<CTxOut>> remainders = predict_remainders(block);
+        if (!remainders || remainders->size() != omitted_remainder_outputs) return READ_STATUS_FAILED;
+        CMutableTransaction coinbase(*block.vtx[0]);
+        coinbase.vout.insert(coinbase.vout.end(), remainders->begin(), remainders->end());
+        block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    }
+
     BlockValidationState state;
     if (!CheckBlock(block, state, Params().GetConsensus())) {
         // TODO: We really want to just check merkle tree manually here,
@@ -7,6 +7,8 @@
 
 #include <primitives/block.h>
 
+#include <functional>
+#include <optional>
 
 class CTxMemPool;
 
@@ -101,10 +103,18 @@ public:
 
     CBlockHeader header;
 
+    /**
+     * Number of conversion remainder outputs stripped from the end of the
+     * prefilled coinbase. These are deterministic given the block's parent
+     * and are predicted by the receiver. Not part of the base serialization;
+     * peers that negotiated remainder prediction append it to the message.
+     */
+    uint64_t omitted_remainder_outputs{0};
+
     // Dummy for deserialization
     CBlockHeaderAndShortTxIDs() {}
 
-    CBlockHeaderAndShortTxIDs(const CBlock& block);
+    CBlockHeaderAndShortTxIDs(const CBlock& block, size_t omitted_remainders = 0);
 
     uint64_t GetShortID(const uint256& txhash) const;
 
@@ -122,10 +132,14 @@ public:
     }
 };
 
+/** Predicts the conversion remainder outputs paid by the coinbase of a block */
+using RemainderOutputsPredictor = std::function<std::optional<std::vector<CTxOut>>(const CBlock&)>;
+
 class PartiallyDownloadedBlock {
 protected:
     std::vector<CTransactionRef> txn_available;
     size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
+    uint64_t omitted_remainder_outputs = 0;
     const CTxMemPool* pool;
 public:
     CBlockHeader header;
@@ -134,7 +148,9 @@ public:
     // extra_txn is a list of extra transactions to look at, in <witness hash, reference> form
     ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
     bool IsTxAvailable(size_t index) const;
-    ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing);
+    // If the coinbase had its remainder outputs stripped, predict_remainders is
+    // called on the otherwise complete block to restore them
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing, const RemainderOutputsPredictor& predict_remainders = {});
 };
 
 #endif // BITCOIN_BLOCKENCODINGS_H
@@ -2,8 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <algorithm>
+#include <cassert>
 #include <mutex>
 #include <set>
+#include <stdexcept>
 
 #include <blockfilter.h>
 #include <crypto/siphash.h>
@@ -13,6 +16,7 @@
 #include <streams.h>
 #include <util/golombrice.h>
 #include <util/string.h>
+#include <util/threadpool.h>
 
 /// SerType used to serialize parameters in GCS filter encoding.
 static constexpr int GCS_SER_TYPE = SER_NETWORK;
@@ -265,3 +269,24 @@ uint256 BlockFilter::ComputeHeader(const uint256& prev_header) const
         .Finalize(result);
     return result;
 }
+
+std::vector<BlockFilter> ConstructBlockFilters(BlockFilterType filter_type, Span<const CBlock> blocks,
+                                               Span<const CBlockUndo> block_undos, int n_threads)
+{
+    assert(blocks.size() == block_undos.size());
+    // Check the type up front, rather than once per block
+    if (BlockFilterTypeName(filter_type).empty()) {
+        throw std::invalid_argument("unknown filter_type");
+    }
+
+    // Each filter hashes and sorts the elements of its own block, so the
+    // blocks are split into contiguous ranges, one per thread
+    std::vector<BlockFilter> filters(blocks.size());
+    const size_t n_ranges{std::min<size_t>(std::max(n_threads, 1), blocks.size())};
+    util::ParallelFor("blockfilters", util::TaskPriority::LOW, n_ranges, n_ranges, [&](size_t range) {
+        for (size_t i = range * blocks.size() / n_ranges; i < (range + 1) * blocks.size() / n_ranges; ++i) {
+            filters[i] = BlockFilter(filter_type, blocks[i], block_undos[i]);
+        }
+    });
+    return filters;
+}
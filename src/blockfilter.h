@@ -14,6 +14,7 @@
 #include <attributes.h>
 #include <primitives/block.h>
 #include <serialize.h>
+#include <span.h>
 #include <uint256.h>
 #include <undo.h>
 #include <util/bytevectorhash.h>
@@ -169,4 +170,14 @@ public:
     }
 };
 
+/**
+ * Construct the filters of a batch of blocks, splitting the batch between up
+ * to n_threads tasks of the shared thread pool. block_undos holds the undo
+ * data of each block.
+ *
+ * @return  the filters, in the order of the blocks
+ */
+std::vector<BlockFilter> ConstructBlockFilters(BlockFilterType filter_type, Span<const CBlock> blocks,
+                                               Span<const CBlockUndo> block_undos, int n_threads);
+
 #endif // BITCOIN_BLOCKFILTER_H
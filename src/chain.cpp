@@ -25,8 +25,10 @@ void CChain::SetTip(CBlockIndex& block)
 {
     CBlockIndex* pindex = &block;
     vChain.resize(pindex->nHeight + 1);
+    vScaleFactor.resize(pindex->nHeight + 1);
     while (pindex && vChain[pindex->nHeight] != pindex) {
         vChain[pindex->nHeight] = pindex;
+        vScaleFactor[pindex->nHeight] = pindex->scaleFactor;
         pindex = pindex->pprev;
     }
 }
@@ -131,25 +133,34 @@ void CBlockIndex::BuildSkip()
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
 }
 
+CAmountScaleFactor GetNextScaleFactor(CAmountScaleFactor prevScaleFactor, const CAmounts& prevTotalSupply, const Consensus::Params& consensus_params)
+{
+    uint128_t interest = (uint128_t)prevScaleFactor;
+    interest *= (uint128_t)prevTotalSupply[CASH];
+    interest /= (uint128_t)prevTotalSupply[BOND];
+    interest /= (uint128_t)consensus_params.TargetBlocksPerYear();
+    CAmountScaleFactor scaleFactor = prevScaleFactor + interest.convert_to<CAmountScaleFactor>();
+    if (scaleFactor < BASE_FACTOR) {
+        // Handle potential overflow by resetting the scale factor
+        scaleFactor = BASE_FACTOR;
+    }
+    return scaleFactor;
+}
+
 void CBlockIndex::BuildScaleFactor(const Consensus::Params& consensus_params)
 {
     if (pprev) {
-        CAmounts prevTotalSupply = pprev->GetTotalSupply();
-        uint128_t interest = (uint128_t)pprev->scaleFactor;
-        interest *= (uint128_t)prevTotalSupply[CASH];
-        interest /= (uint128_t)prevTotalSupply[BOND];
-        interest /= (uint128_t)consensus_params.TargetBlocksPerYear();
-        scaleFactor = pprev->scaleFactor + interest.convert_to<CAmountScaleFactor>();
-        if (scaleFactor < BASE_FACTOR) {
-            // Handle potential overflow by resetting the scale factor
-            scaleFactor = BASE_FACTOR;
-        }
+        scaleFactor = GetNextScaleFactor(pprev->scaleFactor, pprev->GetTotalSupply(), consensus_params);
+    } else {
+        scaleFactor = BASE_FACTOR;
     }
 }
 
-int64_t CBlockIndex::GetInterestRate() const
+int64_t CBlockIndex::ComputeInterestRate() const
 {
     CAmounts totalSupply = GetTotalSupply();
+    // Without bonds there is no interest rate, and nothing to compute it from
+    if (totalSupply[BOND] <= 0) return 0;
     uint128_t interest = (uint128_t)totalSupply[CASH];
     interest *= 100000; // 100 basis points plus 1 decimal place
     interest /= (uint128_t)totalSupply[BOND];
@@ -160,6 +171,19 @@ int64_t CBlockIndex::GetInterestRate() const
     return interest.convert_to<int64_t>();
 }
 
+CAmounts CBlockIndex::ComputeScaledTotalSupply() const
+{
+    CAmounts totalSupply = GetTotalSupply();
+    ScaleAmounts(totalSupply, scaleFactor);
+    return totalSupply;
+}
+
+void CBlockIndex::BuildSupplyViews()
+{
+    nInterestRate = ComputeInterestRate();
+    scaledSupply = ComputeScaledTotalSupply();
+}
+
 arith_uint256 GetBlockProof(const CBlockIndex& block)
 {
     arith_uint256 bnTarget;
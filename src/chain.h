@@ -141,6 +141,9 @@ enum BlockStatus : uint32_t {
      * on a background chainstate. See `doc/design/assumeutxo.md`.
      */
     BLOCK_ASSUMED_VALID      =   256,
+
+    //! (disk only) the block index entry is followed by its scale factor. Never set in memory.
+    BLOCK_HAVE_SCALE_FACTOR  =   512,
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -151,8 +154,8 @@ enum BlockStatus : uint32_t {
 class CBlockIndex
 {
 public:
-    //! pointer to the hash of the block, if any. Memory is owned by this CBlockIndex
-    const uint256* phashBlock{nullptr};
+    // The fields used to walk the tree and to compare chain tips come first, so
+    // that they share the first cache line of each entry.
 
     //! pointer to the index of the predecessor of this block
     CBlockIndex* pprev{nullptr};
@@ -163,21 +166,39 @@ public:
     //! height of the entry in the chain. The genesis block has height 0
     int nHeight{0};
 
-    //! scale factor at the entry in the chain. The genesis block has scale factor of BASE_FACTOR
-    CAmountScaleFactor scaleFactor{BASE_FACTOR};
+    //! Verification status of this block. See enum BlockStatus
+    //!
+    //! Note: this value is modified to show BLOCK_OPT_WITNESS during UTXO snapshot
+    //! load to avoid the block index being spuriously rewound.
+    //! @sa NeedsRedownload
+    //! @sa ActivateSnapshot
+    uint32_t nStatus GUARDED_BY(::cs_main){0};
 
-    //! Which # file this block is stored in (blk?????.dat)
-    int nFile GUARDED_BY(::cs_main){0};
+    //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
+    int32_t nSequenceId{0};
 
-    //! Byte offset within blk?????.dat where this block's data is stored
-    unsigned int nDataPos GUARDED_BY(::cs_main){0};
+    //! (memory only) Maximum nTime in the chain up to and including this block.
+    unsigned int nTimeMax{0};
 
-    //! Byte offset within rev?????.dat where this block's undo data is stored
-    unsigned int nUndoPos GUARDED_BY(::cs_main){0};
+    //! (memory only) Median time past of this block, set by BuildMedianTimePast() when the
+    //! entry is added to the block index, or 0 if not computed
+    uint32_t nTimeMedian{0};
 
     //! (memory only) Total amount of work (expected number of hashes) in the chain up to and including this block
     arith_uint256 nChainWork{};
 
+    //! pointer to the hash of the block, if any. Memory is owned by this CBlockIndex
+    const uint256* phashBlock{nullptr};
+
+    //! scale factor at the entry in the chain. The genesis block has scale factor of BASE_FACTOR
+    //! (stored in the block index database since it compounds over the whole chain)
+    CAmountScaleFactor scaleFactor{BASE_FACTOR};
+
+    //! (memory only) Interest rate (in basis points) and total supply scaled by scaleFactor, set
+    //! by BuildSupplyViews() when the entry is added to the block index, or -1 if not computed
+    int64_t nInterestRate{-1};
+    CAmounts scaledSupply{0};
+
     //! Number of transactions in this block.
     //! Note: in a potential headers-first mode, this number cannot be relied upon
     //! Note: this value is faked during UTXO snapshot load to ensure that
@@ -195,13 +216,21 @@ public:
     //! @sa ActivateSnapshot
     unsigned int nChainTx{0};
 
-    //! Verification status of this block. See enum BlockStatus
-    //!
-    //! Note: this value is modified to show BLOCK_OPT_WITNESS during UTXO snapshot
-    //! load to avoid the block index being spuriously rewound.
-    //! @sa NeedsRedownload
-    //! @sa ActivateSnapshot
-    uint32_t nStatus GUARDED_BY(::cs_main){0};
+    //! (memory only) first of the entries whose pprev is this entry, linked through pnextSibling,
+    //! so that the descendants of an entry can be walked without scanning the whole block index
+    CBlockIndex* pfirstChild{nullptr};
+
+    //! (memory only) next entry with the same pprev as this one
+    CBlockIndex* pnextSibling{nullptr};
+
+    //! Which # file this block is stored in (blk?????.dat)
+    int nFile GUARDED_BY(::cs_main){0};
+
+    //! Byte offset within blk?????.dat where this block's data is stored
+    unsigned int nDataPos GUARDED_BY(::cs_main){0};
+
+    //! Byte offset within rev?????.dat where this block's undo data is stored
+    unsigned int nUndoPos GUARDED_BY(::cs_main){0};
 
     //! block header
     int32_t nVersion{0};
@@ -212,12 +241,6 @@ public:
     CAmount cashSupply{0};
     CAmount bondSupply{0};
 
-    //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
-    int32_t nSequenceId{0};
-
-    //! (memory only) Maximum nTime in the chain up to and including this block.
-    unsigned int nTimeMax{0};
-
     CBlockIndex()
     {
     }
@@ -303,6 +326,12 @@ public:
     static constexpr int nMedianTimeSpan = 11;
 
     int64_t GetMedianTimePast() const
+    {
+        if (nTimeMedian != 0) return nTimeMedian;
+        return ComputeMedianTimePast();
+    }
+
+    int64_t ComputeMedianTimePast() const
     {
         int64_t pmedian[nMedianTimeSpan];
         int64_t* pbegin = &pmedian[nMedianTimeSpan];
@@ -369,11 +398,41 @@ public:
     //! Build the skiplist pointer for this entry.
     void BuildSkip();
 
+    //! Cache the median time past of this entry. Must be called again if the time of
+    //! this entry or one of its nMedianTimeSpan - 1 ancestors changes.
+    void BuildMedianTimePast() { nTimeMedian = ComputeMedianTimePast(); }
+
+    //! Add this entry to the children of pprev. Must be called once per entry with a pprev.
+    void LinkToParent()
+    {
+        assert(pprev);
+        pnextSibling = pprev->pfirstChild;
+        pprev->pfirstChild = this;
+    }
+
     //! Build the scale factor for this entry.
     void BuildScaleFactor(const Consensus::Params& consensus_params);
 
     //! Return the current interest rate (in basis points)
-    int64_t GetInterestRate() const;
+    int64_t GetInterestRate() const
+    {
+        if (nInterestRate >= 0) return nInterestRate;
+        return ComputeInterestRate();
+    }
+
+    int64_t ComputeInterestRate() const;
+
+    //! Return the total supply scaled by the scale factor of this entry
+    CAmounts GetScaledTotalSupply() const
+    {
+        if (nInterestRate >= 0) return scaledSupply;
+        return ComputeScaledTotalSupply();
+    }
+
+    CAmounts ComputeScaledTotalSupply() const;
+
+    //! Compute the interest rate and scaled supply once its scale factor is known, for the readers above.
+    void BuildSupplyViews();
 
     //! Efficiently find an ancestor of this block.
     CBlockIndex* GetAncestor(int height);
@@ -385,6 +444,8 @@ arith_uint256 GetBlockProof(const CBlockIndex& block);
 int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& from, const CBlockIndex& tip, const Consensus::Params&);
 /** Find the forking point between two chain tips. */
 const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex* pb);
+/** Return the scale factor of a block given the scale factor and total supply of its parent, e.g. to extend a known scale factor along a chain of headers. */
+CAmountScaleFactor GetNextScaleFactor(CAmountScaleFactor prevScaleFactor, const CAmounts& prevTotalSupply, const Consensus::Params& consensus_params);
 
 
 /** Used to marshal pointers into hashes for db storage. */
@@ -410,7 +471,9 @@ public:
         if (!(s.GetType() & SER_GETHASH)) READWRITE(VARINT_MODE(_nVersion, VarIntMode::NONNEGATIVE_SIGNED));
 
         READWRITE(VARINT_MODE(obj.nHeight, VarIntMode::NONNEGATIVE_SIGNED));
-        READWRITE(VARINT(obj.nStatus));
+        uint32_t _nStatus = obj.nStatus | BLOCK_HAVE_SCALE_FACTOR;
+        READWRITE(VARINT(_nStatus));
+        SER_READ(obj, obj.nStatus = _nStatus & ~BLOCK_HAVE_SCALE_FACTOR);
         READWRITE(VARINT(obj.nTx));
         if (obj.nStatus & (BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO)) READWRITE(VARINT_MODE(obj.nFile, VarIntMode::NONNEGATIVE_SIGNED));
         if (obj.nStatus & BLOCK_HAVE_DATA) READWRITE(VARINT(obj.nDataPos));
@@ -425,6 +488,14 @@ public:
         READWRITE(obj.nNonce);
         READWRITE(obj.cashSupply);
         READWRITE(obj.bondSupply);
+
+        // Entries written before the scale factor was persisted read it as zero,
+        // which BlockManager::LoadBlockIndex() treats as not yet computed.
+        if (_nStatus & BLOCK_HAVE_SCALE_FACTOR) {
+            READWRITE(VARINT(obj.scaleFactor));
+        } else {
+            SER_READ(obj, obj.scaleFactor = 0);
+        }
     }
 
     uint256 ConstructBlockHash() const
@@ -450,6 +521,8 @@ class CChain
 {
 private:
     std::vector<CBlockIndex*> vChain;
+    //! Scale factor of each block in vChain, stored contiguously by height
+    std::vector<CAmountScaleFactor> vScaleFactor;
 
 public:
     CChain() = default;
@@ -497,6 +570,14 @@ public:
         return int(vChain.size()) - 1;
     }
 
+    /** Returns the scale factor at a particular height in this chain, or BASE_FACTOR if no such height exists. */
+    CAmountScaleFactor GetScaleFactor(int nHeight) const
+    {
+        if (nHeight < 0 || nHeight >= (int)vScaleFactor.size())
+            return BASE_FACTOR;
+        return vScaleFactor[nHeight];
+    }
+
     /** Set/initialize a chain with a given tip. */
     void SetTip(CBlockIndex& block);
 
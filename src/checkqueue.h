@@ -6,11 +6,15 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <sync.h>
-#include <tinyformat.h>
 #include <util/syscall_sandbox.h>
-#include <util/threadnames.h>
+#include <util/threadpool.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <vector>
 
 template <typename T>
@@ -22,110 +26,176 @@ class CCheckQueueControl;
   * operator(), returning a bool.
   *
   * One thread (the master) is assumed to push batches of verifications
-  * onto the queue, where they are processed by N-1 worker threads. When
-  * the master is done adding work, it temporarily joins the worker pool
-  * as an N'th worker, until all jobs are done.
+  * onto the queue, where they are processed by N-1 workers. When the
+  * master is done adding work, it temporarily joins the workers as an
+  * N'th worker, until all jobs are done.
+  *
+  * Workers are tasks on a util::ThreadPool, which the master starts when
+  * it adds verifications, and which end once they run out of them, so that
+  * the threads of the pool are free for other tasks in between blocks.
+  *
+  * Each worker, including the master, has its own queue of verifications,
+  * which the master fills in turns. A worker takes verifications from its
+  * own queue, and steals them from the queues of the others once its own
+  * is empty, so that the workers don't contend on a single lock.
   */
 template <typename T>
 class CCheckQueue
 {
+public:
+    //! Statistics of the verifications done between two waits of the master.
+    struct Stats {
+        //! Number of verifications added.
+        unsigned int checks{0};
+        //! Number of verifications run by another worker than the one they were queued for.
+        unsigned int stolen{0};
+    };
+
 private:
-    //! Mutex to protect the inner state
+    /**
+     * Verifications waiting for a worker. Its owner takes them from the
+     * back, while other workers steal them from the front.
+     */
+    struct WorkerQueue {
+        Mutex m_mutex;
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+        //! Whether the task of the worker is queued or running on the pool
+        std::atomic<bool> m_active{false};
+    };
+
+    //! Mutex to protect the waiting of the master
     Mutex m_mutex;
 
-    //! Worker threads block on this when out of work
-    std::condition_variable m_worker_cv;
-
-    //! Master thread blocks on this when out of work
+    //! Master thread blocks on this when out of work, and when waiting for the workers to stop
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! The queues of the master (first) and of the worker threads.
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
+    //! The queue the master adds the next verifications to.
+    size_t m_next_queue{0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
+    //! Pool the workers run on, and the thread pool created for them by StartWorkerThreads().
+    std::optional<util::TaskPool> m_pool;
+    std::unique_ptr<util::ThreadPool> m_own_thread_pool;
 
-    //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    //! Number of worker tasks that are queued or running on the pool.
+    int m_running_workers GUARDED_BY(m_mutex){0};
+
+    /**
+     * Number of verifications that were added but that no worker has taken
+     * yet. It is increased with m_mutex held, before the verifications are
+     * queued, so that idle workers don't miss them.
+     */
+    std::atomic<unsigned int> m_queued{0};
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<unsigned int> m_todo{0};
+
+    //! The temporary evaluation result.
+    std::atomic<bool> m_all_ok{true};
+
+    //! Number of verifications added since the master last waited.
+    unsigned int m_added{0};
+
+    //! Number of verifications stolen since the master last waited.
+    std::atomic<unsigned int> m_stolen{0};
+
+    //! Statistics of the verifications done before the master last finished waiting.
+    Stats m_last_stats;
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
 
-    std::vector<std::thread> m_worker_threads;
-    bool m_request_stop GUARDED_BY(m_mutex){false};
+    /**
+     * Move a batch of verifications to vChecks, from the queue of the worker
+     * if it has any, else from the queue of another worker. Half of a queue
+     * is taken at most, so that the rest can be stolen by idle workers.
+     */
+    void TakeChecks(size_t index, std::vector<T>& vChecks)
+    {
+        for (size_t i = 0; i < m_queues.size() && vChecks.empty(); ++i) {
+            const bool steal{i > 0};
+            WorkerQueue& queue{*m_queues[(index + i) % m_queues.size()]};
+            LOCK(queue.m_mutex);
+            if (queue.m_checks.empty()) continue;
+            const unsigned int nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.m_checks.size() / 2));
+            vChecks.resize(nNow);
+            for (T& check : vChecks) {
+                // Swap jobs from the queue to the local batch vector instead of copying.
+                if (steal) {
+                    check.swap(queue.m_checks.front());
+                    queue.m_checks.pop_front();
+                } else {
+                    check.swap(queue.m_checks.back());
+                    queue.m_checks.pop_back();
+                }
+            }
+            m_queued -= nNow;
+            if (steal) m_stolen += nNow;
+        }
+    }
+
+    /** Start the task of a worker on the pool, unless it is already active */
+    void StartWorker(size_t index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (m_queues[index]->m_active.exchange(true)) return;
+        WITH_LOCK(m_mutex, ++m_running_workers);
+        m_pool->Post([this, index] { Loop(index, false /* worker */); });
+    }
 
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    bool Loop(size_t index, bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
-                WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
+            TakeChecks(index, vChecks);
+            if (vChecks.empty()) {
+                if (fMaster) {
+                    WAIT_LOCK(m_mutex, lock);
+                    // Only the master adds work, so wait for the other workers to finish theirs.
+                    while (m_queued == 0 && m_todo != 0) {
+                        m_master_cv.wait(lock);
+                    }
+                    if (m_todo == 0) {
+                        m_last_stats = {m_added, m_stolen.exchange(0)};
+                        m_added = 0;
+                        // reset the status for new work later, and return the current status
+                        return m_all_ok.exchange(true);
+                    }
                 } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
+                    // Free the thread for other tasks, unless verifications were added meanwhile
+                    // and no new task was started for them.
+                    WorkerQueue& queue{*m_queues[index]};
+                    queue.m_active = false;
+                    if (m_queued == 0 || queue.m_active.exchange(true)) {
+                        LOCK(m_mutex);
+                        --m_running_workers;
+                        m_master_cv.notify_all();
+                        return false;
                     }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
-                if (m_request_stop) {
-                    return false;
                 }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the m_mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
+
+            // Check whether we need to do work at all
+            bool fOk = m_all_ok;
+            const unsigned int nNow = vChecks.size();
             // execute work
             for (T& check : vChecks)
                 if (fOk)
                     fOk = check();
             vChecks.clear();
+            if (!fOk) m_all_ok = false;
+            if (m_todo.fetch_sub(nNow) == nNow && !fMaster) {
+                // We processed the last element; inform the master it can exit and return the result
+                WITH_LOCK(m_mutex, m_master_cv.notify_one());
+            }
         } while (true);
     }
 
@@ -137,31 +207,38 @@ public:
     explicit CCheckQueue(unsigned int nBatchSizeIn)
         : nBatchSize(nBatchSizeIn)
     {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
     }
 
-    //! Create a pool of new worker threads.
-    void StartWorkerThreads(const int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    //! Run up to workers_num workers as tasks of pool.
+    void StartWorkers(util::TaskPool pool, const int workers_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        {
-            LOCK(m_mutex);
-            nIdle = 0;
-            nTotal = 0;
-            fAllOk = true;
-        }
-        assert(m_worker_threads.empty());
-        for (int n = 0; n < threads_num; ++n) {
-            m_worker_threads.emplace_back([this, n]() {
-                util::ThreadRename(strprintf("scriptch.%i", n));
-                SetSyscallSandboxPolicy(SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK);
-                Loop(false /* worker thread */);
-            });
+        m_all_ok = true;
+        assert(!m_pool);
+        m_pool.emplace(std::move(pool));
+        for (int n = 0; n < workers_num; ++n) {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
         }
+        m_next_queue = 0;
+    }
+
+    //! Run the workers on a pool of new threads, one for each.
+    void StartWorkerThreads(const int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        assert(!m_own_thread_pool);
+        if (threads_num <= 0) return;
+        util::ThreadPool::Options options;
+        options.name = "scriptch";
+        options.threads = threads_num;
+        options.syscall_sandbox_policy = SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK;
+        m_own_thread_pool = std::make_unique<util::ThreadPool>(std::move(options));
+        StartWorkers(util::TaskPool{*m_own_thread_pool, "scriptcheck", util::TaskPriority::HIGH}, threads_num);
     }
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(0, true /* master thread */);
     }
 
     //! Add a batch of checks to the queue
@@ -173,35 +250,53 @@ public:
 
         {
             LOCK(m_mutex);
-            for (T& check : vChecks) {
-                queue.emplace_back();
-                check.swap(queue.back());
+            m_queued += vChecks.size();
+            m_todo += vChecks.size();
+        }
+        m_added += vChecks.size();
+
+        // Spread large batches over several queues, so that each worker starts with work of its own.
+        const size_t chunk = std::max<size_t>(1, std::min<size_t>(nBatchSize, vChecks.size() / m_queues.size()));
+        for (size_t pos = 0; pos < vChecks.size(); pos += chunk) {
+            WorkerQueue& queue{*m_queues[m_next_queue]};
+            m_next_queue = (m_next_queue + 1) % m_queues.size();
+            LOCK(queue.m_mutex);
+            for (size_t i = pos; i < std::min(pos + chunk, vChecks.size()); ++i) {
+                queue.m_checks.emplace_back();
+                vChecks[i].swap(queue.m_checks.back());
             }
-            nTodo += vChecks.size();
         }
 
-        if (vChecks.size() == 1) {
-            m_worker_cv.notify_one();
-        } else {
-            m_worker_cv.notify_all();
+        // Make sure there is an active worker for each verification, as far as there are workers
+        for (size_t index = 1; index < m_queues.size() && index <= vChecks.size(); ++index) {
+            StartWorker(index);
         }
     }
 
-    //! Stop all of the worker threads.
+    //! Return the statistics of the verifications done before the master last finished waiting.
+    Stats GetLastStats() const
+    {
+        return m_last_stats;
+    }
+
+    //! Wait for the tasks of the workers to end, and stop the threads started for them.
     void StopWorkerThreads() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        WITH_LOCK(m_mutex, m_request_stop = true);
-        m_worker_cv.notify_all();
-        for (std::thread& t : m_worker_threads) {
-            t.join();
+        {
+            WAIT_LOCK(m_mutex, lock);
+            while (m_running_workers > 0) {
+                m_master_cv.wait(lock);
+            }
         }
-        m_worker_threads.clear();
-        WITH_LOCK(m_mutex, m_request_stop = false);
+        m_pool.reset();
+        m_own_thread_pool.reset();
+        m_queues.resize(1);
+        m_next_queue = 0;
     }
 
     ~CCheckQueue()
     {
-        assert(m_worker_threads.empty());
+        assert(!m_pool);
     }
 
 };
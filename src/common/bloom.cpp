@@ -5,6 +5,7 @@
 #include <common/bloom.h>
 
 #include <hash.h>
+#include <memusage.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <script/script.h>
@@ -159,12 +160,25 @@ bool CBloomFilter::IsRelevantAndUpdate(const CTransaction& tx)
     return false;
 }
 
-CRollingBloomFilter::CRollingBloomFilter(const unsigned int nElements, const double fpRate)
+/** How much larger a rolling bloom filter started below its full size grows each time it fills up */
+static constexpr unsigned int ROLLING_BLOOM_GROWTH_FACTOR{4};
+
+CRollingBloomFilter::CRollingBloomFilter(const unsigned int nElements, const double fpRate, const unsigned int initial_elements)
 {
-    double logFpRate = log(fpRate);
+    m_log_fp_rate = log(fpRate);
     /* The optimal number of hash functions is log(fpRate) / log(0.5), but
      * restrict it to the range 1-50. */
-    nHashFuncs = std::max(1, std::min((int)round(logFpRate / log(0.5)), 50));
+    nHashFuncs = std::max(1, std::min((int)round(m_log_fp_rate / log(0.5)), 50));
+    m_max_elements = nElements;
+    m_initial_elements = initial_elements == 0 ? nElements : std::min(initial_elements, nElements);
+    Resize(m_initial_elements);
+    reset();
+}
+
+void CRollingBloomFilter::Resize(unsigned int nElements)
+{
+    const double logFpRate = m_log_fp_rate;
+    m_elements = nElements;
     /* In this rolling bloom filter, we'll store between 2 and 3 generations of nElements / 2 entries. */
     nEntriesPerGeneration = (nElements + 1) / 2;
     uint32_t nMaxElements = nEntriesPerGeneration * 3;
@@ -183,7 +197,7 @@ CRollingBloomFilter::CRollingBloomFilter(const unsigned int nElements, const dou
      * These bits are stored in separate integers: position P corresponds to bit
      * (P & 63) of the integers data[(P >> 6) * 2] and data[(P >> 6) * 2 + 1]. */
     data.resize(((nFilterBits + 63) / 64) << 1);
-    reset();
+    data.shrink_to_fit();
 }
 
 /* Similar to CBloomFilter::Hash */
@@ -194,7 +208,14 @@ static inline uint32_t RollingBloomHash(unsigned int nHashNum, uint32_t nTweak,
 
 void CRollingBloomFilter::insert(Span<const unsigned char> vKey)
 {
-    if (nEntriesThisGeneration == nEntriesPerGeneration) {
+    if (nEntriesThisGeneration == nEntriesPerGeneration && nGeneration == 3 && m_elements < m_max_elements) {
+        /* The next generation would wipe the oldest entries. Grow instead, keeping the
+         * current filter around until the entries it holds would have been forgotten. */
+        m_retired.push_back({std::move(data), m_inserted});
+        Resize(std::min<uint64_t>(uint64_t{m_elements} * ROLLING_BLOOM_GROWTH_FACTOR, m_max_elements));
+        nEntriesThisGeneration = 0;
+        nGeneration = 1;
+    } else if (nEntriesThisGeneration == nEntriesPerGeneration) {
         nEntriesThisGeneration = 0;
         nGeneration++;
         if (nGeneration == 4) {
@@ -211,6 +232,10 @@ void CRollingBloomFilter::insert(Span<const unsigned char> vKey)
         }
     }
     nEntriesThisGeneration++;
+    ++m_inserted;
+    while (!m_retired.empty() && m_inserted - m_retired.front().inserted > m_max_elements) {
+        m_retired.erase(m_retired.begin());
+    }
 
     for (int n = 0; n < nHashFuncs; n++) {
         uint32_t h = RollingBloomHash(n, nTweak, vKey);
@@ -223,24 +248,49 @@ void CRollingBloomFilter::insert(Span<const unsigned char> vKey)
     }
 }
 
-bool CRollingBloomFilter::contains(Span<const unsigned char> vKey) const
+bool CRollingBloomFilter::Contains(const std::vector<uint64_t>& filter, Span<const unsigned char> vKey) const
 {
     for (int n = 0; n < nHashFuncs; n++) {
         uint32_t h = RollingBloomHash(n, nTweak, vKey);
         int bit = h & 0x3F;
-        uint32_t pos = FastRange32(h, data.size());
-        /* If the relevant bit is not set in either data[pos & ~1] or data[pos | 1], the filter does not contain vKey */
-        if (!(((data[pos & ~1U] | data[pos | 1]) >> bit) & 1)) {
+        uint32_t pos = FastRange32(h, filter.size());
+        /* If the relevant bit is not set in either filter[pos & ~1] or filter[pos | 1], the filter does not contain vKey */
+        if (!(((filter[pos & ~1U] | filter[pos | 1]) >> bit) & 1)) {
             return false;
         }
     }
     return true;
 }
 
+bool CRollingBloomFilter::contains(Span<const unsigned char> vKey) const
+{
+    if (Contains(data, vKey)) return true;
+    for (const RetiredFilter& retired : m_retired) {
+        if (Contains(retired.data, vKey)) return true;
+    }
+    return false;
+}
+
 void CRollingBloomFilter::reset()
 {
     nTweak = GetRand<unsigned int>();
     nEntriesThisGeneration = 0;
     nGeneration = 1;
-    std::fill(data.begin(), data.end(), 0);
+    m_inserted = 0;
+    m_retired.clear();
+    m_retired.shrink_to_fit();
+    if (m_elements != m_initial_elements) {
+        Resize(m_initial_elements);
+    } else {
+        std::fill(data.begin(), data.end(), 0);
+    }
+}
+
+size_t CRollingBloomFilter::DynamicMemoryUsage() const
+{
+    size_t usage{memusage::DynamicUsage(data) + memusage::DynamicUsage(m_retired)};
+    for (const RetiredFilter& retired : m_retired) {
+        usage += memusage::DynamicUsage(retired.data);
+    }
+    return usage;
 }
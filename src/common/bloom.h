@@ -104,24 +104,53 @@ public:
  * Then we get a more accurate estimate for filter bytes:
  *
  *     3/(log(256)*log(2)) * log(1/fpRate) * nElements
+ *
+ * Filters that usually see far fewer than nElements items, like the ones kept
+ * for each peer, can be given a smaller initial_elements to start sized for.
+ * Instead of forgetting its oldest items, such a filter then grows until it is
+ * sized for nElements. Each smaller filter it grew out of is kept, and checked
+ * by contains(), until nElements newer items were inserted, so the guarantee
+ * above holds throughout.
  */
 class CRollingBloomFilter
 {
 public:
-    CRollingBloomFilter(const unsigned int nElements, const double nFPRate);
+    CRollingBloomFilter(const unsigned int nElements, const double nFPRate, const unsigned int initial_elements = 0);
 
     void insert(Span<const unsigned char> vKey);
     bool contains(Span<const unsigned char> vKey) const;
 
+    /** Forget all items, and shrink back to the initial size */
     void reset();
 
+    size_t DynamicMemoryUsage() const;
+
 private:
+    /** A filter the rolling filter grew out of */
+    struct RetiredFilter {
+        std::vector<uint64_t> data;
+        //! Number of items inserted before this filter was retired
+        uint64_t inserted;
+    };
+
+    /** Size data for nElements items and clear it */
+    void Resize(unsigned int nElements);
+    bool Contains(const std::vector<uint64_t>& filter, Span<const unsigned char> vKey) const;
+
     int nEntriesPerGeneration;
     int nEntriesThisGeneration;
     int nGeneration;
     std::vector<uint64_t> data;
     unsigned int nTweak;
     int nHashFuncs;
+    double m_log_fp_rate;
+    //! Number of items the filter is currently sized for, the initial size, and the size it grows to
+    unsigned int m_elements;
+    unsigned int m_initial_elements;
+    unsigned int m_max_elements;
+    //! Number of items inserted since the last reset
+    uint64_t m_inserted{0};
+    std::vector<RetiredFilter> m_retired;
 };
 
 #endif // BITCOIN_COMMON_BLOOM_H
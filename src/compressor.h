@@ -8,6 +8,7 @@
 
 #include <prevector.h>
 #include <primitives/transaction.h>
+#include <script/interpreter.h>
 #include <script/script.h>
 #include <serialize.h>
 #include <span.h>
@@ -95,6 +96,70 @@ struct ScriptCompression
     }
 };
 
+/** Compact serializer for scripts, used by UTXO snapshots and v2 undo data.
+ *
+ *  Besides the special scripts of ScriptCompression, P2WPKH, P2WSH and P2TR
+ *  scripts are encoded as their type followed by just the witness program.
+ *  Other scripts are encoded as in ScriptCompression, but overly long ones
+ *  are an error.
+ */
+struct TemplateScriptCompression
+{
+    static constexpr uint64_t SCRIPT_P2WPKH{ScriptCompression::nSpecialScripts};
+    static constexpr uint64_t SCRIPT_P2WSH{ScriptCompression::nSpecialScripts + 1};
+    static constexpr uint64_t SCRIPT_P2TR{ScriptCompression::nSpecialScripts + 2};
+    //! Other scripts are stored as their size plus this, followed by the script.
+    static constexpr uint64_t SCRIPT_RAW{ScriptCompression::nSpecialScripts + 3};
+
+    template<typename Stream>
+    void Ser(Stream& s, const CScript& script) {
+        CompressedScript compr;
+        if (CompressScript(script, compr)) {
+            s << Span{compr};
+            return;
+        }
+        int version;
+        std::vector<unsigned char> program;
+        if (script.IsWitnessProgram(version, program)) {
+            if (version == 0 && program.size() == WITNESS_V0_KEYHASH_SIZE) {
+                s << VARINT(SCRIPT_P2WPKH) << Span{program};
+                return;
+            } else if (version == 0 && program.size() == WITNESS_V0_SCRIPTHASH_SIZE) {
+                s << VARINT(SCRIPT_P2WSH) << Span{program};
+                return;
+            } else if (version == 1 && program.size() == WITNESS_V1_TAPROOT_SIZE) {
+                s << VARINT(SCRIPT_P2TR) << Span{program};
+                return;
+            }
+        }
+        s << VARINT(script.size() + SCRIPT_RAW) << Span{script};
+    }
+
+    template<typename Stream>
+    void Unser(Stream& s, CScript& script) {
+        uint64_t type;
+        s >> VARINT(type);
+        if (type < ScriptCompression::nSpecialScripts) {
+            CompressedScript vch(GetSpecialScriptSize(type), 0x00);
+            s >> Span{vch};
+            if (!DecompressScript(script, type, vch)) {
+                throw std::ios_base::failure("invalid compressed script");
+            }
+        } else if (type == SCRIPT_P2WPKH || type == SCRIPT_P2WSH || type == SCRIPT_P2TR) {
+            std::vector<unsigned char> program(type == SCRIPT_P2WPKH ? WITNESS_V0_KEYHASH_SIZE : WITNESS_V0_SCRIPTHASH_SIZE);
+            s >> Span{program};
+            script = CScript() << (type == SCRIPT_P2TR ? OP_1 : OP_0) << program;
+        } else {
+            const uint64_t size{type - SCRIPT_RAW};
+            if (size > MAX_SCRIPT_SIZE) {
+                throw std::ios_base::failure("script too large");
+            }
+            script.resize(size);
+            s >> Span{script};
+        }
+    }
+};
+
 struct AmountCompression
 {
     template<typename Stream, typename I> void Ser(Stream& s, I val)
@@ -4,18 +4,110 @@
 
 #include <consensus/amount.h>
 
-#include <boost/multiprecision/cpp_int.hpp>
+#include <cassert>
+#include <limits>
 
-using namespace boost::multiprecision;
+namespace {
+/**
+ * Compute floor(a * b / d) for unsigned 64-bit operands without losing the
+ * intermediate product. Sets inexact if the division leaves a remainder.
+ * @return false if the quotient does not fit in 64 bits.
+ */
+bool MulDivU64(uint64_t a, uint64_t b, uint64_t d, uint64_t& quotient, bool& inexact)
+{
+#ifdef __SIZEOF_INT128__
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    const unsigned __int128 q = product / d;
+    inexact = (product % d) != 0;
+    quotient = static_cast<uint64_t>(q);
+    return (q >> 64) == 0;
+#else
+    // Multiply piece-wise on 32-bit halves to get the 128-bit product (hi, lo).
+    const uint64_t a_hi = a >> 32, a_lo = a & 0xFFFFFFFF;
+    const uint64_t b_hi = b >> 32, b_lo = b & 0xFFFFFFFF;
+    const uint64_t ll = a_lo * b_lo;
+    const uint64_t lh = a_lo * b_hi;
+    const uint64_t hl = a_hi * b_lo;
+    const uint64_t hh = a_hi * b_hi;
+    const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+    const uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    const uint64_t lo = (mid << 32) | (ll & 0xFFFFFFFF);
+
+    // The quotient fits in 64 bits if and only if hi < d.
+    if (hi >= d) {
+        inexact = false;
+        quotient = std::numeric_limits<uint64_t>::max();
+        return false;
+    }
+
+    // Restoring long division of (hi, lo) by d, one bit at a time.
+    uint64_t rem = hi;
+    uint64_t q = 0;
+    for (int i = 63; i >= 0; --i) {
+        const bool carry = rem >> 63;
+        rem = (rem << 1) | ((lo >> i) & 1);
+        q <<= 1;
+        if (carry || rem >= d) {
+            rem -= d;
+            q |= 1;
+        }
+    }
+    inexact = rem != 0;
+    quotient = q;
+    return true;
+#endif
+}
+
+/** Convert a sign and magnitude to a CAmount, saturating at the bounds of the type. */
+CAmount SaturatedAmount(bool negative, uint64_t magnitude, bool fits)
+{
+    constexpr uint64_t max_positive = std::numeric_limits<CAmount>::max();
+    if (negative) {
+        if (!fits || magnitude > max_positive) return std::numeric_limits<CAmount>::min();
+        return -static_cast<CAmount>(magnitude);
+    }
+    if (!fits || magnitude > max_positive) return std::numeric_limits<CAmount>::max();
+    return static_cast<CAmount>(magnitude);
+}
+
+/** Absolute value of a CAmount, well-defined for the most negative value. */
+uint64_t AbsAmount(const CAmount& nValue)
+{
+    return nValue < 0 ? uint64_t{0} - static_cast<uint64_t>(nValue) : static_cast<uint64_t>(nValue);
+}
+} // namespace
 
 CAmount ScaleAmount(const CAmount& nValue, const CAmountScaleFactor& scaleFactor) {
-    return ((int256_t)nValue * (int256_t)scaleFactor / ((int256_t)BASE_FACTOR)).convert_to<CAmount>();
+    // nValue * scaleFactor / BASE_FACTOR, rounded toward zero
+    uint64_t magnitude;
+    bool inexact;
+    const bool fits = MulDivU64(AbsAmount(nValue), scaleFactor, BASE_FACTOR, magnitude, inexact);
+    return SaturatedAmount(nValue < 0, magnitude, fits);
+}
+
+void ScaleAmounts(Span<CAmount> amounts, const CAmountScaleFactor& scaleFactor) {
+    // The genesis scale factor is the identity
+    if (scaleFactor == BASE_FACTOR) return;
+    for (CAmount& nValue : amounts) {
+        uint64_t magnitude;
+        bool inexact;
+        const bool fits = MulDivU64(AbsAmount(nValue), scaleFactor, BASE_FACTOR, magnitude, inexact);
+        nValue = SaturatedAmount(nValue < 0, magnitude, fits);
+    }
 }
 
 CAmount DescaleAmount(const CAmount& scaledValue, const CAmountScaleFactor& scaleFactor) {
-    CAmount baseAmount = ((int256_t)scaledValue * (int256_t)BASE_FACTOR / ((int256_t)scaleFactor)).convert_to<CAmount>();
-    while (ScaleAmount(baseAmount, scaleFactor) < scaledValue) {
-        baseAmount++;
+    assert(scaleFactor > 0);
+    // ceil(scaledValue * BASE_FACTOR / scaleFactor). For positive values, this is the
+    // smallest base amount that scales to at least scaledValue.
+    uint64_t magnitude;
+    bool inexact;
+    const bool fits = MulDivU64(AbsAmount(scaledValue), BASE_FACTOR, scaleFactor, magnitude, inexact);
+    const bool negative = scaledValue < 0;
+    if (fits && inexact && !negative) {
+        // Round positive values up. Negative values are already rounded up by truncation.
+        if (magnitude == std::numeric_limits<uint64_t>::max()) return std::numeric_limits<CAmount>::max();
+        ++magnitude;
     }
-    return baseAmount;
+    return SaturatedAmount(negative, magnitude, fits);
 }
@@ -6,6 +6,8 @@
 #ifndef BITCOIN_CONSENSUS_AMOUNT_H
 #define BITCOIN_CONSENSUS_AMOUNT_H
 
+#include <span.h>
+
 #include <cstdint>
 #include <array>
 
@@ -40,8 +42,20 @@ static constexpr CAmountScaleFactor BASE_FACTOR = 10000000000;
 static constexpr CAmount MAX_MONEY = 21000000 * COIN;
 inline bool MoneyRange(const CAmount& nValue) { return (nValue >= 0 && nValue <= MAX_MONEY); }
 
+/**
+ * Apply a scale factor to an amount, rounding toward zero. Results outside the
+ * range of CAmount saturate.
+ */
 CAmount ScaleAmount(const CAmount& nValue, const CAmountScaleFactor& scaleFactor);
 
+/** Apply a scale factor to each amount in place. Equivalent to calling ScaleAmount() on each. */
+void ScaleAmounts(Span<CAmount> amounts, const CAmountScaleFactor& scaleFactor);
+
+/**
+ * Remove a scale factor from an amount, rounding up so that positive results
+ * scale back to at least scaledValue. Results outside the range of CAmount
+ * saturate. scaleFactor must be non-zero.
+ */
 CAmount DescaleAmount(const CAmount& scaledValue, const CAmountScaleFactor& scaleFactor);
 
 #endif // BITCOIN_CONSENSUS_AMOUNT_H
@@ -2,10 +2,15 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <consensus/conversion.h>
+
 #include <consensus/amount.h>
+#include <consensus/invariant.h>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
+#include <limits>
+
 using namespace boost::multiprecision;
 
 CAmount CalculateOutputAmount(const CAmounts& totalSupply, const CAmount& inputAmount, const CAmountType& inputType)
@@ -15,22 +20,26 @@ CAmount CalculateOutputAmount(const CAmounts& totalSupply, const CAmount& inputA
         return 0;
 
     // Calculate sum-of-squares invariant and determine new output
-    int128_t invariant_sq_in = pow((int128_t)totalSupply[CASH], 2) + pow((int128_t)totalSupply[BOND], 2); // K^2
-    int128_t new_input_sq = pow((int128_t)totalSupply[inputType] - (int128_t)inputAmount, 2); // (A - ΔA)^2
-    CAmount new_output = sqrt(invariant_sq_in - new_input_sq).convert_to<CAmount>(); // B' = sqrt(K^2 - (A - ΔA)^2)
+    CAmountSquare invariant_sq_in = GetInvariantSquare(totalSupply); // K^2
+    CAmountSquare new_input_sq = SquareAmount((CWideAmount)totalSupply[inputType] - (CWideAmount)inputAmount); // (A - ΔA)^2
+    if (new_input_sq > invariant_sq_in)
+        // Negative input amount exceeds maximum available with current total supply
+        return 0;
+
+    CAmount new_output = SaturatedAmount(ISqrt(invariant_sq_in - new_input_sq)); // B' = sqrt(K^2 - (A - ΔA)^2)
     return new_output - totalSupply[!inputType]; // ΔB = B' - B
 }
 
 CAmount CalculateInputAmount(const CAmounts& totalSupply, const CAmount& outputAmount, const CAmountType& outputType)
 {
     // Calculate sum-of-squares invariant
-    int128_t invariant_sq_in = pow((int128_t)totalSupply[CASH], 2) + pow((int128_t)totalSupply[BOND], 2); // K^2
-    int128_t new_output_sq = pow((int128_t)totalSupply[outputType] + (int128_t)outputAmount, 2); // (B + ΔB)^2
+    CAmountSquare invariant_sq_in = GetInvariantSquare(totalSupply); // K^2
+    CAmountSquare new_output_sq = SquareAmount((CWideAmount)totalSupply[outputType] + (CWideAmount)outputAmount); // (B + ΔB)^2
     if (new_output_sq > invariant_sq_in)
         // New output amount exceeds maximum available with current total supply
         return 0;
 
-    CAmount new_input = sqrt(invariant_sq_in - new_output_sq).convert_to<CAmount>(); // A' = sqrt(K^2 - (B + ΔB)^2)
+    CAmount new_input = SaturatedAmount(ISqrt(invariant_sq_in - new_output_sq)); // A' = sqrt(K^2 - (B + ΔB)^2)
     return totalSupply[!outputType] - new_input; // ΔA = A - A'
 }
 
@@ -48,3 +57,85 @@ CAmount GetConvertedAmount(const CAmounts& totalSupply, const CAmount& amount, c
         return convertedAmount;
     }
 }
+
+namespace {
+/** Compute the 128-bit product a * b as (hi, lo). */
+void Mul64(uint64_t a, uint64_t b, uint64_t& hi, uint64_t& lo)
+{
+#ifdef __SIZEOF_INT128__
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    hi = static_cast<uint64_t>(product >> 64);
+    lo = static_cast<uint64_t>(product);
+#else
+    const uint64_t a_hi = a >> 32, a_lo = a & 0xFFFFFFFF;
+    const uint64_t b_hi = b >> 32, b_lo = b & 0xFFFFFFFF;
+    const uint64_t ll = a_lo * b_lo;
+    const uint64_t lh = a_lo * b_hi;
+    const uint64_t hl = a_hi * b_lo;
+    const uint64_t hh = a_hi * b_hi;
+    const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    lo = (mid << 32) | (ll & 0xFFFFFFFF);
+#endif
+}
+} // namespace
+
+ConversionRate::ConversionRate(const CAmounts& totalSupply) : m_total_supply{totalSupply}
+{
+    m_use_ratio = totalSupply[CASH] > 0 && totalSupply[BOND] > 0;
+    if (!m_use_ratio) return;
+    for (const CAmountType type : {CASH, BOND}) {
+        Ratio& ratio = m_ratios[type];
+        const uint64_t numerator = totalSupply[type];
+        ratio.denominator = totalSupply[!type];
+        ratio.quotient = numerator / ratio.denominator;
+        ratio.remainder = numerator % ratio.denominator;
+        // fraction = floor(remainder * 2^64 / denominator) by long division,
+        // which fits as remainder < denominator.
+        uint64_t rem = ratio.remainder;
+        for (int i = 0; i < 64; ++i) {
+            const bool carry = rem >> 63;
+            rem <<= 1;
+            ratio.fraction <<= 1;
+            if (carry || rem >= ratio.denominator) {
+                rem -= ratio.denominator;
+                ratio.fraction |= 1;
+            }
+        }
+    }
+}
+
+CAmount ConversionRate::Convert(const CAmount& amount, const CAmountType& amountType, bool roundedUp) const
+{
+    if (!m_use_ratio) return GetConvertedAmount(m_total_supply, amount, amountType, roundedUp);
+
+    // |amount| * numerator / denominator, rounded toward zero like the int256_t
+    // division in GetConvertedAmount().
+    const Ratio& ratio = m_ratios[amountType];
+    const uint64_t magnitude = amount < 0 ? uint64_t{0} - static_cast<uint64_t>(amount) : static_cast<uint64_t>(amount);
+
+    // The fixed-point fraction estimates floor(magnitude * remainder / denominator)
+    // as at most one too low, as magnitude < 2^64.
+    uint64_t frac_part, unused;
+    Mul64(magnitude, ratio.fraction, frac_part, unused);
+    uint64_t exact_hi, exact_lo, next_hi, next_lo;
+    Mul64(magnitude, ratio.remainder, exact_hi, exact_lo);
+    Mul64(frac_part + 1, ratio.denominator, next_hi, next_lo);
+    if (next_hi < exact_hi || (next_hi == exact_hi && next_lo <= exact_lo)) ++frac_part;
+
+    uint64_t result_hi, result_lo;
+    Mul64(magnitude, ratio.quotient, result_hi, result_lo);
+    result_lo += frac_part;
+    if (result_lo < frac_part) ++result_hi;
+
+    // Saturate like int256_t::convert_to<CAmount>()
+    CAmount converted;
+    constexpr uint64_t max_positive = std::numeric_limits<CAmount>::max();
+    if (amount < 0) {
+        converted = result_hi != 0 || result_lo > max_positive ? std::numeric_limits<CAmount>::min() : -static_cast<CAmount>(result_lo);
+    } else {
+        converted = result_hi != 0 || result_lo > max_positive ? std::numeric_limits<CAmount>::max() : static_cast<CAmount>(result_lo);
+    }
+    if (roundedUp && converted < std::numeric_limits<CAmount>::max()) converted += 1;
+    return converted;
+}
@@ -2,8 +2,14 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#ifndef BITCOIN_CONSENSUS_CONVERSION_H
+#define BITCOIN_CONSENSUS_CONVERSION_H
+
 #include <consensus/amount.h>
 
+#include <array>
+#include <cstdint>
+
 /**
  * Calculate output amount if conversion transaction is executed immediately after given block.
  * Not consensus critical.
@@ -21,3 +27,37 @@ CAmount CalculateInputAmount(const CAmounts& totalSupply, const CAmount& outputA
  * Not consensus critical.
  */
 CAmount GetConvertedAmount(const CAmounts& totalSupply, const CAmount& amount, const CAmountType& amountType, const bool& roundedUp = false);
+
+/**
+ * The marginal conversion rate of a total supply, precomputed as a fixed-point
+ * ratio so that many amounts can be converted with GetConvertedAmount()'s exact
+ * rounding using 64-bit multiplications instead of a 256-bit division each.
+ * Not consensus critical.
+ */
+class ConversionRate
+{
+public:
+    ConversionRate() : ConversionRate(CAmounts{0, 0}) {}
+    explicit ConversionRate(const CAmounts& totalSupply);
+
+    /** Equivalent to GetConvertedAmount(GetTotalSupply(), amount, amountType, roundedUp). */
+    CAmount Convert(const CAmount& amount, const CAmountType& amountType, bool roundedUp = false) const;
+
+    const CAmounts& GetTotalSupply() const { return m_total_supply; }
+
+private:
+    /** totalSupply[type] / totalSupply[!type] as quotient + fraction / 2^64, rounded down */
+    struct Ratio {
+        uint64_t quotient{0};
+        uint64_t remainder{0};
+        uint64_t denominator{0};
+        uint64_t fraction{0};
+    };
+
+    CAmounts m_total_supply;
+    //! Whether both supplies are positive, so that the ratios are used
+    bool m_use_ratio{false};
+    std::array<Ratio, 2> m_ratios;
+};
+
+#endif // BITCOIN_CONSENSUS_CONVERSION_H
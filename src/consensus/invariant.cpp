@@ -0,0 +1,54 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/invariant.h>
+
+#include <cmath>
+#include <limits>
+
+CAmountSquare SquareAmount(const CWideAmount& amount)
+{
+#ifdef __SIZEOF_INT128__
+    const uint64_t magnitude = static_cast<uint64_t>(amount < 0 ? -amount : amount);
+    return static_cast<CAmountSquare>(magnitude) * magnitude;
+#else
+    const CAmountSquare magnitude = (amount < 0 ? -amount : amount).convert_to<CAmountSquare>();
+    return magnitude * magnitude;
+#endif
+}
+
+uint64_t ISqrt(const CAmountSquare& n)
+{
+#ifdef __SIZEOF_INT128__
+    if (n == 0) return 0;
+
+    // Seed with the double precision square root, which is within a small
+    // relative error of the exact result.
+    const double seed = std::sqrt(static_cast<double>(n));
+    CAmountSquare x = seed >= 18446744073709551615.0 ? std::numeric_limits<uint64_t>::max() : static_cast<uint64_t>(seed);
+    if (x == 0) x = 1;
+
+    // One Newton step squares the relative error, leaving x within one of the result.
+    x = (x + n / x) >> 1;
+    if (x > std::numeric_limits<uint64_t>::max()) x = std::numeric_limits<uint64_t>::max();
+
+    // Correct to floor(sqrt(n)).
+    while (x * x > n) --x;
+    while (x < std::numeric_limits<uint64_t>::max() && (x + 1) * (x + 1) <= n) ++x;
+    return static_cast<uint64_t>(x);
+#else
+    return sqrt(n).convert_to<uint64_t>();
+#endif
+}
+
+CAmount SaturatedAmount(const CWideAmount& amount)
+{
+    if (amount > std::numeric_limits<CAmount>::max()) return std::numeric_limits<CAmount>::max();
+    if (amount < std::numeric_limits<CAmount>::min()) return std::numeric_limits<CAmount>::min();
+#ifdef __SIZEOF_INT128__
+    return static_cast<CAmount>(amount);
+#else
+    return amount.convert_to<CAmount>();
+#endif
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CONSENSUS_INVARIANT_H
+#define BITCOIN_CONSENSUS_INVARIANT_H
+
+#include <consensus/amount.h>
+
+#include <cstdint>
+
+#ifdef __SIZEOF_INT128__
+/** Signed integer wide enough to hold the sum or difference of two amounts */
+typedef __int128 CWideAmount;
+/** Unsigned integer wide enough to hold the sum-of-squares invariant K^2 of two amounts */
+typedef unsigned __int128 CAmountSquare;
+#else
+#include <boost/multiprecision/cpp_int.hpp>
+typedef boost::multiprecision::int128_t CWideAmount;
+typedef boost::multiprecision::uint128_t CAmountSquare;
+#endif
+
+/** Square of a wide amount. The magnitude must be less than 2^64. */
+CAmountSquare SquareAmount(const CWideAmount& amount);
+
+/** Sum-of-squares invariant K^2 = cash^2 + bond^2 of a total supply. */
+inline CAmountSquare GetInvariantSquare(const CAmounts& totalSupply)
+{
+    return SquareAmount(totalSupply[CASH]) + SquareAmount(totalSupply[BOND]);
+}
+
+/** Sum-of-squares invariant of a total supply after removing inputs and adding outputs. */
+inline CAmountSquare GetInvariantSquare(const CAmounts& totalSupply, const CAmounts& inputs, const CAmounts& outputs)
+{
+    return SquareAmount(totalSupply[CASH] + outputs[CASH] - inputs[CASH]) + SquareAmount(totalSupply[BOND] + outputs[BOND] - inputs[BOND]);
+}
+
+/** Integer square root, rounded down. Consensus critical. */
+uint64_t ISqrt(const CAmountSquare& n);
+
+/** Convert a wide amount to a CAmount, saturating at the bounds of the type. */
+CAmount SaturatedAmount(const CWideAmount& amount);
+
+#endif // BITCOIN_CONSENSUS_INVARIANT_H
@@ -5,9 +5,15 @@
 #include <consensus/tx_check.h>
 
 #include <consensus/amount.h>
+#include <hash.h>
 #include <primitives/transaction.h>
 #include <consensus/validation.h>
 
+#include <map>
+#include <optional>
+#include <tuple>
+#include <vector>
+
 bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
 {
     // Basic checks that don't depend on any context
@@ -16,7 +22,7 @@ bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
     if (tx.vout.empty())
         return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-txns-vout-empty");
     // Size limits (this doesn't take the witness into account, as that hasn't been checked for malleability)
-    if (::GetSerializeSize(tx, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT)
+    if (tx.GetStrippedSize() * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT)
         return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-txns-oversize");
 
     // Check for negative or overflow output values (see CVE-2010-5139)
@@ -69,47 +75,116 @@ bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
     return true;
 }
 
-bool CheckTransactionContainsOutputs(const CTransaction& tx, std::vector<CTxOut> outputs, std::string& addressWithIncorrectAmount)
+namespace {
+/** Expected and actual amounts paid to an (amountType, scriptPubKey) pair */
+struct OutputAmounts
 {
-    // Create mapping of output string to # of occurrences of output in transaction
-    std::map<std::string, CAmount> addressToActualCashAmount;
-    std::map<std::string, CAmount> addressToActualBondAmount;
-    for (const auto& txout : tx.vout)
+    const CTxOut* output{nullptr};
+    CAmount expected{0};
+    CAmount actual{0};
+};
+
+/**
+ * Open-addressed hash table of output amounts keyed on (amountType, scriptPubKey).
+ * Keys point into the expected outputs, so no script is copied or encoded.
+ *
+ * The hash is unsalted, so scripts can be crafted to collide. Probing is therefore capped at
+ * MAX_PROBES slots, and outputs that do not fit within it are left to OutputAmountsMap.
+ */
+class OutputAmountsTable
+{
+    std::vector<OutputAmounts> m_slots;
+    size_t m_mask;
+
+    static unsigned int Hash(const CTxOut& txout)
+    {
+        return MurmurHash3(txout.amountType, txout.scriptPubKey);
+    }
+
+public:
+    static constexpr size_t MAX_PROBES{32};
+
+    explicit OutputAmountsTable(size_t count)
     {
-        if (txout.amountType == CASH) {
-            addressToActualCashAmount[HexStr(txout.scriptPubKey)] += txout.nValue;
-        } else if (txout.amountType == BOND) {
-            addressToActualBondAmount[HexStr(txout.scriptPubKey)] += txout.nValue;
+        size_t size = 1;
+        while (size < 2 * count) size <<= 1;
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    /**
+     * Find the slot for txout, or the empty slot where it would be inserted. Returns nullptr if
+     * neither is within MAX_PROBES slots, in which case txout is not in the table.
+     */
+    OutputAmounts* Find(const CTxOut& txout)
+    {
+        size_t i = Hash(txout) & m_mask;
+        for (size_t probes = 0; probes < MAX_PROBES; ++probes, i = (i + 1) & m_mask) {
+            OutputAmounts& slot = m_slots[i];
+            if (!slot.output) return &slot;
+            if (slot.output->amountType == txout.amountType && slot.output->scriptPubKey == txout.scriptPubKey) return &slot;
         }
+        return nullptr;
     }
+};
 
-    // Create mapping of output string to # of occurrences in outputs list
-    std::map<std::string, CAmount> addressToExpectedCashAmount;
-    std::map<std::string, CAmount> addressToExpectedBondAmount;
+/** Ordered map of output amounts keyed on (amountType, scriptPubKey), used when keys collide in OutputAmountsTable */
+class OutputAmountsMap
+{
+    struct KeyLess {
+        bool operator()(const CTxOut* a, const CTxOut* b) const
+        {
+            return std::tie(a->amountType, a->scriptPubKey) < std::tie(b->amountType, b->scriptPubKey);
+        }
+    };
+    std::map<const CTxOut*, OutputAmounts, KeyLess> m_amounts;
+
+public:
+    OutputAmounts* Find(const CTxOut& txout) { return &m_amounts[&txout]; }
+};
+
+/**
+ * Check that tx pays every (amountType, scriptPubKey) pair in outputs the sum of its amounts.
+ * Returns std::nullopt if an expected output does not fit in table.
+ */
+template <typename Table>
+std::optional<bool> CheckOutputAmounts(Table& table, const CTransaction& tx, const std::vector<CTxOut>& outputs, std::string& addressWithIncorrectAmount)
+{
+    // Sum the amount expected by every (amountType, scriptPubKey) pair in outputs
     for (const auto& output : outputs)
     {
-        if (output.amountType == CASH) {
-            addressToExpectedCashAmount[HexStr(output.scriptPubKey)] += output.nValue;
-        } else if (output.amountType == BOND) {
-            addressToExpectedBondAmount[HexStr(output.scriptPubKey)] += output.nValue;
-        }
+        OutputAmounts* slot = table.Find(output);
+        if (!slot) return std::nullopt;
+        if (!slot->output) slot->output = &output;
+        slot->expected += output.nValue;
     }
 
-    // Check that every scriptPubKey receives correct cash amount
-    for (const auto& [hexStr, cashAmount] : addressToExpectedCashAmount)
+    // Sum the amount paid by the transaction to each expected pair
+    for (const auto& txout : tx.vout)
     {
-        if (addressToExpectedCashAmount[hexStr] != addressToActualCashAmount[hexStr]) {
-            addressWithIncorrectAmount = hexStr;
-            return false;
-        }
+        OutputAmounts* slot = table.Find(txout);
+        if (slot && slot->output) slot->actual += txout.nValue;
     }
-    // Check that every scriptPubKey receives correct cash amount
-    for (const auto& [hexStr, bondAmount] : addressToExpectedBondAmount)
+
+    // Check that every scriptPubKey receives the correct amount
+    for (const auto& output : outputs)
     {
-        if (addressToExpectedBondAmount[hexStr] != addressToActualBondAmount[hexStr]) {
-            addressWithIncorrectAmount = hexStr;
+        const OutputAmounts* slot = table.Find(output);
+        if (slot->expected != slot->actual) {
+            addressWithIncorrectAmount = HexStr(output.scriptPubKey);
             return false;
         }
     }
     return true;
 }
+} // namespace
+
+bool CheckTransactionContainsOutputs(const CTransaction& tx, const std::vector<CTxOut>& outputs, std::string& addressWithIncorrectAmount)
+{
+    if (outputs.empty()) return true;
+
+    OutputAmountsTable table(outputs.size());
+    if (const auto result{CheckOutputAmounts(table, tx, outputs, addressWithIncorrectAmount)}) return *result;
+    OutputAmountsMap map;
+    return *CheckOutputAmounts(map, tx, outputs, addressWithIncorrectAmount);
+}
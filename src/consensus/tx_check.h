@@ -8,6 +8,7 @@
 #include <util/strencodings.h>
 
 #include <string>
+#include <vector>
 
 /**
  * Context-independent transaction checking code that can be called outside the
@@ -22,6 +23,10 @@ class CTxOut;
 
 bool CheckTransaction(const CTransaction& tx, TxValidationState& state);
 
-bool CheckTransactionContainsOutputs(const CTransaction& tx, std::vector<CTxOut> outputs, std::string& addressWithIncorrectAmount);
+/**
+ * Check that tx pays exactly the summed amount of each (amountType, scriptPubKey) pair in outputs.
+ * On failure, addressWithIncorrectAmount is set to the hex of the first mismatching scriptPubKey.
+ */
+bool CheckTransactionContainsOutputs(const CTransaction& tx, const std::vector<CTxOut>& outputs, std::string& addressWithIncorrectAmount);
 
 #endif // BITCOIN_CONSENSUS_TX_CHECK_H
@@ -8,15 +8,13 @@
 #include <coins.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
+#include <consensus/invariant.h>
 #include <consensus/validation.h>
 #include <primitives/transaction.h>
 #include <script/interpreter.h>
 #include <script/script.h>
 #include <util/check.h>
 #include <util/moneystr.h>
-#include <boost/multiprecision/cpp_int.hpp>
-
-using namespace boost::multiprecision;
 
 bool IsFinalTx(const CTransaction &tx, int nBlockHeight, int64_t nBlockTime)
 {
@@ -256,8 +254,8 @@ bool Consensus::CheckTxInputs(const CTransaction& tx, TxValidationState& state,
 bool Consensus::IsValidConversion(CAmounts& totalSupply, const CAmounts inputs, const CAmounts minOutputs, const CAmountType remainderType, CAmount& remainder)
 {
     // Calculate sum-of-squares invariants in and out and check that this is a valid conversion
-    int128_t invariant_sq_in = pow((int128_t)totalSupply[CASH], 2) + pow((int128_t)totalSupply[BOND], 2); // K^2
-    int128_t invariant_sq_min_out = pow((int128_t)(totalSupply[CASH] + minOutputs[CASH] - inputs[CASH]), 2) + pow((int128_t)(totalSupply[BOND] + minOutputs[BOND] - inputs[BOND]), 2);
+    CAmountSquare invariant_sq_in = GetInvariantSquare(totalSupply); // K^2
+    CAmountSquare invariant_sq_min_out = GetInvariantSquare(totalSupply, inputs, minOutputs);
     if (invariant_sq_min_out > invariant_sq_in) {
         // Invariant out cannot be greater than invariant in
         return false;
@@ -268,7 +266,7 @@ bool Consensus::IsValidConversion(CAmounts& totalSupply, const CAmounts inputs,
     // (A + ΔA + ΔA')^2              = K^2 - (B + ΔB)^2
     //  A + ΔA + ΔA'                 = sqrt(K^2 - (B + ΔB)^2)
     //           ΔA'                 = sqrt(K^2 - (B + ΔB)^2) - (A + ΔA)
-    remainder = (sqrt(invariant_sq_in - pow((int128_t)(totalSupply[!remainderType] + minOutputs[!remainderType] - inputs[!remainderType]), 2)) - (int128_t)(totalSupply[remainderType] + minOutputs[remainderType] - inputs[remainderType])).convert_to<CAmount>();
+    remainder = SaturatedAmount((CWideAmount)ISqrt(invariant_sq_in - SquareAmount(totalSupply[!remainderType] + minOutputs[!remainderType] - inputs[!remainderType])) - (CWideAmount)(totalSupply[remainderType] + minOutputs[remainderType] - inputs[remainderType]));
 
     // Update cash and bond supply in block header
     totalSupply[CASH] += (minOutputs[CASH] - inputs[CASH]);
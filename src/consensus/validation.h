@@ -56,6 +56,11 @@ enum class TxValidationResult {
      */
     TX_CONFLICT,
     TX_MEMPOOL_POLICY,        //!< violated mempool's fee/size/descendant/RBF/etc limits
+    /**
+     * The transaction's feerate is below the mempool or relay minimum, but it may be
+     * accepted in a package with a child that pays for it.
+     */
+    TX_RECONSIDERABLE,
     TX_NO_MEMPOOL,            //!< this node does not have a mempool so can't validate the transaction
 };
 
@@ -148,22 +153,44 @@ class BlockValidationState : public ValidationState<BlockValidationResult> {};
 // using only serialization with and without witness data. As witness_size
 // is equal to total_size - stripped_size, this formula is identical to:
 // weight = (stripped_size * 3) + total_size.
+// Transactions record both sizes when they are created, so none of these
+// serialize a transaction again.
 // If conversion, transaction weight includes weight of remainder output that appears in coinbase transaction (unless remainder sent to miner)
+static inline int64_t GetRemainderOutputWeight(const std::optional<CTxConversionInfo>& conversionInfo)
+{
+    if (!conversionInfo || !IsValidDestination(conversionInfo->destination)) return 0;
+    // Outputs carry no witness data, so the remainder output's weight is its serialized size times the scale factor
+    const CScript remainderScript = GetScriptForDestination(conversionInfo->destination);
+    return (::GetSerializeSize(CAmountType{}, PROTOCOL_VERSION) + ::GetSerializeSize(CAmount{}, PROTOCOL_VERSION) + ::GetSerializeSize(remainderScript, PROTOCOL_VERSION)) * WITNESS_SCALE_FACTOR;
+}
+// Use this overload when the conversion info has already been parsed from the transaction
+static inline int64_t GetTransactionWeight(const CTransaction& tx, const std::optional<CTxConversionInfo>& conversionInfo)
+{
+    return tx.GetWeight() + GetRemainderOutputWeight(conversionInfo);
+}
 static inline int64_t GetTransactionWeight(const CTransaction& tx)
 {
-    int64_t remainderOutputWeight = 0;
-    std::optional<CTxConversionInfo> conversionInfo = GetConversionInfo(tx);
-    if (conversionInfo && IsValidDestination(conversionInfo.value().destination)) {
-        // Add the weight of the remainder output unless remainder is sent to the miner
-        CScript remainderScript = GetScriptForDestination(conversionInfo.value().destination);
-        CTxOut dummyRemainderOut(0, 0, remainderScript);
-        remainderOutputWeight += ::GetSerializeSize(dummyRemainderOut, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) * (WITNESS_SCALE_FACTOR - 1) + ::GetSerializeSize(dummyRemainderOut, PROTOCOL_VERSION);
-    }
-    return remainderOutputWeight + ::GetSerializeSize(tx, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) * (WITNESS_SCALE_FACTOR - 1) + ::GetSerializeSize(tx, PROTOCOL_VERSION);
+    // Only transactions starting with a conversion output need it parsed
+    if (tx.vout.empty() || !tx.vout[0].scriptPubKey.IsConversionScript()) return tx.GetWeight();
+    return GetTransactionWeight(tx, GetConversionInfo(tx));
+}
+static inline int64_t GetBlockStrippedSize(const CBlock& block)
+{
+    int64_t size = CBlockHeader::SERIALIZED_SIZE + GetSizeOfCompactSize(block.vtx.size());
+    for (const auto& tx : block.vtx) size += tx->GetStrippedSize();
+    return size;
+}
+static inline int64_t GetBlockTotalSize(const CBlock& block)
+{
+    int64_t size = CBlockHeader::SERIALIZED_SIZE + GetSizeOfCompactSize(block.vtx.size());
+    for (const auto& tx : block.vtx) size += tx->GetTotalSize();
+    return size;
 }
 static inline int64_t GetBlockWeight(const CBlock& block)
 {
-    return ::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) * (WITNESS_SCALE_FACTOR - 1) + ::GetSerializeSize(block, PROTOCOL_VERSION);
+    int64_t weight = (CBlockHeader::SERIALIZED_SIZE + GetSizeOfCompactSize(block.vtx.size())) * WITNESS_SCALE_FACTOR;
+    for (const auto& tx : block.vtx) weight += tx->GetWeight();
+    return weight;
 }
 static inline int64_t GetTransactionInputWeight(const CTxIn& txin)
 {
@@ -243,6 +243,62 @@ void blake3_hash_many(const uint8_t *const *inputs, size_t num_inputs,
                             out);
 }
 
+// Names of the implementations blake3_compress_in_place() and
+// blake3_hash_many() dispatch to, for reporting.
+const char *blake3_compress_impl_name(void) {
+#if defined(IS_X86)
+  const enum cpu_feature features = get_cpu_features();
+  MAYBE_UNUSED(features);
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+  if (features & AVX512VL) {
+    return "avx512";
+  }
+#endif
+#if defined(__SSE4_1__)
+  if (features & SSE41) {
+    return "sse4.1";
+  }
+#endif
+#if defined(__SSE2__)
+  if (features & SSE2) {
+    return "sse2";
+  }
+#endif
+#endif
+  return "portable";
+}
+
+const char *blake3_hash_many_impl_name(void) {
+#if defined(IS_X86)
+  const enum cpu_feature features = get_cpu_features();
+  MAYBE_UNUSED(features);
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+  if ((features & (AVX512F|AVX512VL)) == (AVX512F|AVX512VL)) {
+    return "avx512";
+  }
+#endif
+#if defined(__AVX2__)
+  if (features & AVX2) {
+    return "avx2";
+  }
+#endif
+#if defined(__SSE4_1__)
+  if (features & SSE41) {
+    return "sse4.1";
+  }
+#endif
+#if defined(__SSE2__)
+  if (features & SSE2) {
+    return "sse2";
+  }
+#endif
+#endif
+#ifdef __ARM_NEON
+  return "neon";
+#endif
+  return "portable";
+}
+
 // The dynamically detected SIMD degree of the current platform.
 size_t blake3_simd_degree(void) {
 #if defined(IS_X86)
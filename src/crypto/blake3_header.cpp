@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/blake3_header.h>
+
+#include <crypto/common.h>
+
+extern "C" {
+#include <crypto/blake3_impl.h>
+}
+
+#include <string.h>
+
+static_assert(CBlake3HeaderHasher::HEADER_SIZE > BLAKE3_BLOCK_LEN && CBlake3HeaderHasher::HEADER_SIZE <= 2 * BLAKE3_BLOCK_LEN,
+              "header must span exactly two BLAKE3 blocks");
+static_assert(CBlake3HeaderHasher::NONCE_OFFSET >= BLAKE3_BLOCK_LEN, "nonce must be in the final block");
+
+CBlake3HeaderHasher::CBlake3HeaderHasher(const unsigned char* header)
+{
+    memcpy(m_midstate, IV, sizeof(m_midstate));
+    blake3_compress_in_place(m_midstate, header, BLAKE3_BLOCK_LEN, /*counter=*/0, CHUNK_START);
+    memset(m_tail, 0, sizeof(m_tail));
+    memcpy(m_tail, header + BLAKE3_BLOCK_LEN, HEADER_SIZE - BLAKE3_BLOCK_LEN);
+}
+
+void CBlake3HeaderHasher::Finalize(uint32_t nNonce, unsigned char* hash) const
+{
+    unsigned char block[BLAKE3_BLOCK_LEN];
+    memcpy(block, m_tail, sizeof(block));
+    WriteLE32(block + NONCE_OFFSET - BLAKE3_BLOCK_LEN, nNonce);
+
+    uint32_t cv[8];
+    memcpy(cv, m_midstate, sizeof(cv));
+    blake3_compress_in_place(cv, block, HEADER_SIZE - BLAKE3_BLOCK_LEN, /*counter=*/0, CHUNK_END | ROOT);
+    store_cv_words(hash, cv);
+}
+
+void CBlake3HeaderHasher::Hash(const unsigned char* header, unsigned char* hash)
+{
+    CBlake3HeaderHasher(header).Finalize(ReadLE32(header + NONCE_OFFSET), hash);
+}
+
+void CBlake3HeaderHasher::HashMany(const unsigned char* headers, size_t count, unsigned char* hashes)
+{
+    static constexpr size_t BATCH_SIZE{64};
+    const uint8_t* inputs[BATCH_SIZE];
+    uint8_t midstates[BATCH_SIZE * BLAKE3_OUT_LEN];
+
+    while (count > 0) {
+        const size_t batch{count < BATCH_SIZE ? count : BATCH_SIZE};
+        for (size_t i = 0; i < batch; ++i) {
+            inputs[i] = headers + i * HEADER_SIZE;
+        }
+        // Chaining values after the first block of every header
+        blake3_hash_many(inputs, batch, /*blocks=*/1, IV, /*counter=*/0, /*increment_counter=*/false,
+                         /*flags=*/0, /*flags_start=*/CHUNK_START, /*flags_end=*/0, midstates);
+
+        for (size_t i = 0; i < batch; ++i) {
+            unsigned char block[BLAKE3_BLOCK_LEN];
+            memset(block, 0, sizeof(block));
+            memcpy(block, inputs[i] + BLAKE3_BLOCK_LEN, HEADER_SIZE - BLAKE3_BLOCK_LEN);
+
+            uint32_t cv[8];
+            load_key_words(midstates + i * BLAKE3_OUT_LEN, cv);
+            blake3_compress_in_place(cv, block, HEADER_SIZE - BLAKE3_BLOCK_LEN, /*counter=*/0, CHUNK_END | ROOT);
+            store_cv_words(hashes + i * OUTPUT_SIZE, cv);
+        }
+
+        headers += batch * HEADER_SIZE;
+        hashes += batch * OUTPUT_SIZE;
+        count -= batch;
+    }
+}
+
+std::string Blake3AutoDetect()
+{
+    return std::string(blake3_compress_impl_name()) + ", batches " + blake3_hash_many_impl_name() + " (" + std::to_string(blake3_simd_degree()) + "-way)";
+}
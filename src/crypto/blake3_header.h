@@ -0,0 +1,50 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_BLAKE3_HEADER_H
+#define BITCOIN_CRYPTO_BLAKE3_HEADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * BLAKE3 hasher for serialized 96-byte block headers.
+ *
+ * A header fits in one BLAKE3 chunk of two blocks. The nonce lives in the last
+ * 4 bytes, so the chaining value after the first 64-byte block (the midstate)
+ * is computed once and every nonce only costs a single compression.
+ */
+class CBlake3HeaderHasher
+{
+public:
+    static constexpr size_t HEADER_SIZE = 96;
+    static constexpr size_t NONCE_OFFSET = 92;
+    static constexpr size_t OUTPUT_SIZE = 32;
+
+    /** Cache the midstate of a serialized header. The nonce bytes are ignored. */
+    explicit CBlake3HeaderHasher(const unsigned char* header);
+    /** Compute the hash of the header with its nonce replaced by nNonce. */
+    void Finalize(uint32_t nNonce, unsigned char* hash) const;
+
+    /** Compute the BLAKE3 hash of a single serialized header. */
+    static void Hash(const unsigned char* header, unsigned char* hash);
+
+    /**
+     * Compute the BLAKE3 hashes of count consecutive serialized headers into
+     * count consecutive outputs. The first blocks of all headers are compressed
+     * together using the widest SIMD implementation available.
+     */
+    static void HashMany(const unsigned char* headers, size_t count, unsigned char* hashes);
+
+private:
+    uint32_t m_midstate[8];
+    /** Bytes 64..96 of the header followed by zero padding to a full block */
+    unsigned char m_tail[64];
+};
+
+/** Describe the BLAKE3 implementations selected for this CPU, for single blocks and for batches. */
+std::string Blake3AutoDetect();
+
+#endif // BITCOIN_CRYPTO_BLAKE3_HEADER_H
@@ -182,6 +182,10 @@ void blake3_hash_many(const uint8_t *const *inputs, size_t num_inputs,
 
 size_t blake3_simd_degree(void);
 
+const char *blake3_compress_impl_name(void);
+
+const char *blake3_hash_many_impl_name(void);
+
 
 // Declarations for implementation-specific functions.
 void blake3_compress_in_place_portable(uint32_t cv[8],
@@ -8,8 +8,42 @@
 #include <crypto/common.h>
 #include <crypto/chacha20.h>
 
+#include <compat/cpuid.h>
+
 #include <string.h>
 
+#if defined(ENABLE_AVX2) && defined(HAVE_GETCPUID) && !defined(BUILD_BITCOIN_INTERNAL)
+#define USE_CHACHA20_AVX2
+namespace chacha20_avx2
+{
+/** Crypt 8 blocks (512 bytes) starting at the block counter in input, or output the keystream if in is nullptr. */
+void Crypt_8way(const uint32_t* input, const unsigned char* in, unsigned char* out);
+}
+
+namespace {
+bool DetectAVX2()
+{
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_sse4 = (ecx >> 19) & 1;
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (!have_sse4 || !have_xsave || !have_avx) return false;
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    if ((a & 6) != 6) return false;
+    GetCPUID(7, 0, eax, ebx, ecx, edx);
+    return (ebx >> 5) & 1;
+}
+
+bool HaveAVX2()
+{
+    static const bool have_avx2{DetectAVX2()};
+    return have_avx2;
+}
+} // namespace
+#endif
+
 constexpr static inline uint32_t rotl32(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
 
 #define QUARTERROUND(a,b,c,d) \
@@ -73,6 +107,23 @@ void ChaCha20::Seek(uint64_t pos)
     input[13] = pos >> 32;
 }
 
+void ChaCha20::Crypt8Way(const unsigned char*& m, unsigned char*& c, size_t& bytes)
+{
+#ifdef USE_CHACHA20_AVX2
+    if (bytes < 512 || !HaveAVX2()) return;
+    uint64_t counter = (uint64_t)input[13] << 32 | input[12];
+    while (bytes >= 512) {
+        chacha20_avx2::Crypt_8way(input, m, c);
+        counter += 8;
+        input[12] = counter;
+        input[13] = counter >> 32;
+        if (m) m += 512;
+        c += 512;
+        bytes -= 512;
+    }
+#endif
+}
+
 void ChaCha20::Keystream(unsigned char* c, size_t bytes)
 {
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
@@ -81,6 +132,8 @@ void ChaCha20::Keystream(unsigned char* c, size_t bytes)
     unsigned char tmp[64];
     unsigned int i;
 
+    const unsigned char* m = nullptr;
+    Crypt8Way(m, c, bytes);
     if (!bytes) return;
 
     j0 = input[0];
@@ -192,6 +245,7 @@ void ChaCha20::Crypt(const unsigned char* m, unsigned char* c, size_t bytes)
     unsigned char tmp[64];
     unsigned int i;
 
+    Crypt8Way(m, c, bytes);
     if (!bytes) return;
 
     j0 = input[0];
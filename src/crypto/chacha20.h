@@ -15,6 +15,9 @@ class ChaCha20
 private:
     uint32_t input[16];
 
+    /** Process whole multiples of 8 blocks with a vectorized kernel if the CPU supports one, advancing the pointers and the block counter. */
+    void Crypt8Way(const unsigned char*& m, unsigned char*& c, size_t& bytes);
+
 public:
     ChaCha20();
     ChaCha20(const unsigned char* key, size_t keylen);
@@ -0,0 +1,94 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline K(uint32_t x) { return _mm256_set1_epi32(x); }
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline RotL(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+// Rotations by whole bytes are a single shuffle.
+__m256i inline RotL16(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2)); }
+__m256i inline RotL8(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3, 14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3)); }
+
+void inline __attribute__((always_inline)) QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = RotL16(Xor(d, a));
+    c = Add(c, d); b = RotL(Xor(b, c), 12);
+    a = Add(a, b); d = RotL8(Xor(d, a));
+    c = Add(c, d); b = RotL(Xor(b, c), 7);
+}
+
+/** Transpose words 0-7 of the 8 blocks in x[0..7] and write them at out + 64 * block. */
+void inline Write8(unsigned char* out, const unsigned char* in, const __m256i* x)
+{
+    const __m256i t0 = _mm256_unpacklo_epi32(x[0], x[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(x[0], x[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(x[2], x[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(x[4], x[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(x[4], x[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(x[6], x[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(x[6], x[7]);
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    const __m256i blocks[8] = {
+        _mm256_permute2x128_si256(u0, u4, 0x20), _mm256_permute2x128_si256(u1, u5, 0x20),
+        _mm256_permute2x128_si256(u2, u6, 0x20), _mm256_permute2x128_si256(u3, u7, 0x20),
+        _mm256_permute2x128_si256(u0, u4, 0x31), _mm256_permute2x128_si256(u1, u5, 0x31),
+        _mm256_permute2x128_si256(u2, u6, 0x31), _mm256_permute2x128_si256(u3, u7, 0x31),
+    };
+    for (int i = 0; i < 8; ++i) {
+        __m256i v = blocks[i];
+        if (in) v = Xor(v, _mm256_loadu_si256((const __m256i*)(in + 64 * i)));
+        _mm256_storeu_si256((__m256i*)(out + 64 * i), v);
+    }
+}
+
+}
+
+void Crypt_8way(const uint32_t* input, const unsigned char* in, unsigned char* out)
+{
+    const uint64_t counter = (uint64_t)input[13] << 32 | input[12];
+    __m256i j[16];
+    for (int i = 0; i < 16; ++i) j[i] = K(input[i]);
+    j[12] = _mm256_set_epi32((uint32_t)(counter + 7), (uint32_t)(counter + 6), (uint32_t)(counter + 5), (uint32_t)(counter + 4),
+                             (uint32_t)(counter + 3), (uint32_t)(counter + 2), (uint32_t)(counter + 1), (uint32_t)counter);
+    j[13] = _mm256_set_epi32((counter + 7) >> 32, (counter + 6) >> 32, (counter + 5) >> 32, (counter + 4) >> 32,
+                             (counter + 3) >> 32, (counter + 2) >> 32, (counter + 1) >> 32, counter >> 32);
+
+    __m256i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+    for (int i = 0; i < 10; ++i) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+    Write8(out, in, x);
+    Write8(out + 32, in ? in + 32 : nullptr, x + 8);
+}
+
+}
+
+#endif
@@ -19,7 +19,6 @@ class Num3072
 private:
     void FullReduce();
     bool IsOverflow() const;
-    Num3072 GetInverse() const;
 
 public:
     static constexpr size_t BYTE_SIZE = 384;
@@ -45,6 +44,11 @@ public:
     // Hard coded values in MuHash3072 constructor and Finalize
     static_assert(sizeof(limb_t) == 4 || sizeof(limb_t) == 8, "bad size for limb_t");
 
+    /** Modular inverse, with safegcd where __int128 is available and exponentiation otherwise */
+    Num3072 GetInverse() const;
+    /** Modular inverse by exponentiation to the modulus minus 2, the fallback of GetInverse() */
+    Num3072 GetInverseByExponentiation() const;
+
     void Multiply(const Num3072& a);
     void Divide(const Num3072& a);
     void SetToOne();
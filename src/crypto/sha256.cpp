@@ -37,6 +37,7 @@ void Transform_4way(unsigned char* out, const unsigned char* in);
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
+void Transform_8way_multi(uint32_t* s, const unsigned char* const* blocks);
 }
 
 namespace sha256d64_x86_shani
@@ -436,6 +437,8 @@ void TransformD64(unsigned char* out, const unsigned char* in)
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
 typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+/** Transform 8 independent states (word i of lane j at s[8 * i + j]) by one block each. */
+typedef void (*TransformMultiType)(uint32_t* s, const unsigned char* const* blocks);
 
 template<TransformType tr>
 void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
@@ -481,6 +484,7 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformMultiType TransformMulti_8way = nullptr;
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -564,6 +568,23 @@ bool SelfTest() {
         if (!std::equal(out, out + 256, result_d64)) return false;
     }
 
+    // Test TransformMulti_8way, if available, continuing lane i from the
+    // state after i input blocks.
+    if (TransformMulti_8way) {
+        uint32_t state[64];
+        const unsigned char* blocks[8];
+        for (size_t lane = 0; lane < 8; ++lane) {
+            for (size_t word = 0; word < 8; ++word) state[8 * word + lane] = result[lane][word];
+            blocks[lane] = data + 1 + 64 * lane;
+        }
+        TransformMulti_8way(state, blocks);
+        for (size_t lane = 0; lane < 8; ++lane) {
+            for (size_t word = 0; word < 8; ++word) {
+                if (state[8 * word + lane] != result[lane + 1][word]) return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -630,7 +651,8 @@ std::string SHA256AutoDetect()
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
-        ret += ",avx2(8way)";
+        TransformMulti_8way = sha256d64_avx2::Transform_8way_multi;
+        ret += ",avx2(8way,8way multi)";
     }
 #endif
 #endif // defined(USE_ASM) && defined(HAVE_GETCPUID)
@@ -761,3 +783,149 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+namespace {
+/** A message being double-SHA256'd by SHA256DMulti, as the blocks it has left. */
+struct MultiLane {
+    size_t index;
+    const unsigned char* data;
+    size_t data_blocks;
+    //! The last partial block of data with the padding, or the second hash's block
+    unsigned char tail[128];
+    size_t tail_pos;
+    size_t tail_blocks;
+    bool second;
+
+    void Start(size_t index_in, const unsigned char* data_in, size_t len)
+    {
+        index = index_in;
+        data = data_in;
+        data_blocks = len / 64;
+        const size_t rest = len % 64;
+        const size_t tail_size = rest < 56 ? 64 : 128;
+        memcpy(tail, data + 64 * data_blocks, rest);
+        tail[rest] = 0x80;
+        memset(tail + rest + 1, 0, tail_size - rest - 9);
+        WriteBE64(tail + tail_size - 8, uint64_t{len} << 3);
+        tail_pos = 0;
+        tail_blocks = tail_size / 64;
+        second = false;
+    }
+
+    const unsigned char* NextBlock()
+    {
+        if (data_blocks) {
+            --data_blocks;
+            data += 64;
+            return data - 64;
+        }
+        --tail_blocks;
+        tail_pos += 64;
+        return tail + tail_pos - 64;
+    }
+
+    bool Done() const { return data_blocks == 0 && tail_blocks == 0; }
+
+    /** Continue with the second hash, of the first one's result s. */
+    void StartSecond(const uint32_t* s)
+    {
+        for (int i = 0; i < 8; ++i) WriteBE32(tail + 4 * i, s[i]);
+        tail[32] = 0x80;
+        memset(tail + 33, 0, 31);
+        tail[62] = 1; // 256 bits
+        data_blocks = 0;
+        tail_pos = 0;
+        tail_blocks = 1;
+        second = true;
+    }
+
+    /** Hash the remaining blocks one lane at a time, from state s. */
+    void Finish(uint32_t* s, unsigned char* output)
+    {
+        if (data_blocks) Transform(s, data, data_blocks);
+        if (tail_blocks) Transform(s, tail + tail_pos, tail_blocks);
+        if (!second) {
+            StartSecond(s);
+            sha256::Initialize(s);
+            Transform(s, tail, 1);
+        }
+        for (int i = 0; i < 8; ++i) WriteBE32(output + 32 * index + 4 * i, s[i]);
+    }
+};
+
+void GetLaneState(const uint32_t* state, size_t lane, uint32_t* s)
+{
+    for (size_t i = 0; i < 8; ++i) s[i] = state[8 * i + lane];
+}
+
+void SetLaneState(uint32_t* state, size_t lane, const uint32_t* s)
+{
+    for (size_t i = 0; i < 8; ++i) state[8 * i + lane] = s[i];
+}
+} // namespace
+
+void SHA256DMulti(unsigned char* output, const unsigned char* const* inputs, const size_t* lengths, size_t count)
+{
+    size_t next = 0;
+    if (TransformMulti_8way && count > 2) {
+        static const unsigned char idle_block[64] = {0};
+        uint32_t init[8];
+        sha256::Initialize(init);
+
+        // Each lane takes the next message as soon as its previous one is
+        // done, so messages of different lengths keep all lanes busy.
+        MultiLane lanes[8];
+        bool active[8];
+        uint32_t state[64];
+        size_t num_active = 0;
+        for (size_t lane = 0; lane < 8; ++lane) {
+            active[lane] = next < count;
+            if (!active[lane]) continue;
+            lanes[lane].Start(next, inputs[next], lengths[next]);
+            SetLaneState(state, lane, init);
+            ++next;
+            ++num_active;
+        }
+        // Once there are no more messages to start and only a few lanes are
+        // left, those are faster to finish one at a time.
+        while (num_active > 2 || next < count) {
+            const unsigned char* blocks[8];
+            for (size_t lane = 0; lane < 8; ++lane) {
+                blocks[lane] = active[lane] ? lanes[lane].NextBlock() : idle_block;
+            }
+            TransformMulti_8way(state, blocks);
+            for (size_t lane = 0; lane < 8; ++lane) {
+                if (!active[lane] || !lanes[lane].Done()) continue;
+                uint32_t s[8];
+                GetLaneState(state, lane, s);
+                if (!lanes[lane].second) {
+                    lanes[lane].StartSecond(s);
+                    SetLaneState(state, lane, init);
+                    continue;
+                }
+                for (int i = 0; i < 8; ++i) WriteBE32(output + 32 * lanes[lane].index + 4 * i, s[i]);
+                if (next < count) {
+                    lanes[lane].Start(next, inputs[next], lengths[next]);
+                    SetLaneState(state, lane, init);
+                    ++next;
+                } else {
+                    active[lane] = false;
+                    --num_active;
+                }
+            }
+        }
+        for (size_t lane = 0; lane < 8; ++lane) {
+            if (!active[lane]) continue;
+            uint32_t s[8];
+            GetLaneState(state, lane, s);
+            lanes[lane].Finish(s, output);
+        }
+    }
+    for (; next < count; ++next) {
+        MultiLane lane;
+        lane.Start(next, inputs[next], lengths[next]);
+        uint32_t s[8];
+        sha256::Initialize(s);
+        lane.Finish(s, output);
+    }
+}
@@ -70,6 +70,67 @@ void inline Write8(unsigned char* out, int offset, __m256i v) {
     WriteLE32(out + 224 + offset, _mm256_extract_epi32(v, 0));
 }
 
+/** Read 4 bytes at offset from each of the 8 blocks, lane i from blocks[i]. */
+__m256i inline ReadLanes(const unsigned char* const* blocks, int offset) {
+    __m256i ret = _mm256_set_epi32(
+        ReadLE32(blocks[7] + offset),
+        ReadLE32(blocks[6] + offset),
+        ReadLE32(blocks[5] + offset),
+        ReadLE32(blocks[4] + offset),
+        ReadLE32(blocks[3] + offset),
+        ReadLE32(blocks[2] + offset),
+        ReadLE32(blocks[1] + offset),
+        ReadLE32(blocks[0] + offset)
+    );
+    return _mm256_shuffle_epi8(ret, _mm256_set_epi32(0x0C0D0E0FUL, 0x08090A0BUL, 0x04050607UL, 0x00010203UL, 0x0C0D0E0FUL, 0x08090A0BUL, 0x04050607UL, 0x00010203UL));
+}
+
+const uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul, 0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul,
+    0xd807aa98ul, 0x12835b01ul, 0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul, 0xc19bf174ul,
+    0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul, 0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul,
+    0x983e5152ul, 0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul, 0x06ca6351ul, 0x14292967ul,
+    0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul, 0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+    0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul, 0xd6990624ul, 0xf40e3585ul, 0x106aa070ul,
+    0x19a4c116ul, 0x1e376c08ul, 0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful, 0x682e6ff3ul,
+    0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul, 0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul,
+};
+
+}
+
+void Transform_8way_multi(uint32_t* s, const unsigned char* const* blocks)
+{
+    __m256i st[8];
+    for (int i = 0; i < 8; ++i) st[i] = _mm256_loadu_si256((const __m256i*)(s + 8 * i));
+    __m256i a = st[0], b = st[1], c = st[2], d = st[3], e = st[4], f = st[5], g = st[6], h = st[7];
+
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i) w[i] = ReadLanes(blocks, 4 * i);
+
+    for (int r = 0; r < 64; r += 8) {
+        if (r >= 16) {
+            for (int j = r; j < r + 8; ++j) {
+                Inc(w[j & 15], sigma1(w[(j + 14) & 15]), w[(j + 9) & 15], sigma0(w[(j + 1) & 15]));
+            }
+        }
+        Round(a, b, c, d, e, f, g, h, Add(K(ROUND_CONSTANTS[r + 0]), w[(r + 0) & 15]));
+        Round(h, a, b, c, d, e, f, g, Add(K(ROUND_CONSTANTS[r + 1]), w[(r + 1) & 15]));
+        Round(g, h, a, b, c, d, e, f, Add(K(ROUND_CONSTANTS[r + 2]), w[(r + 2) & 15]));
+        Round(f, g, h, a, b, c, d, e, Add(K(ROUND_CONSTANTS[r + 3]), w[(r + 3) & 15]));
+        Round(e, f, g, h, a, b, c, d, Add(K(ROUND_CONSTANTS[r + 4]), w[(r + 4) & 15]));
+        Round(d, e, f, g, h, a, b, c, Add(K(ROUND_CONSTANTS[r + 5]), w[(r + 5) & 15]));
+        Round(c, d, e, f, g, h, a, b, Add(K(ROUND_CONSTANTS[r + 6]), w[(r + 6) & 15]));
+        Round(b, c, d, e, f, g, h, a, Add(K(ROUND_CONSTANTS[r + 7]), w[(r + 7) & 15]));
+    }
+
+    _mm256_storeu_si256((__m256i*)(s + 0), Add(st[0], a));
+    _mm256_storeu_si256((__m256i*)(s + 8), Add(st[1], b));
+    _mm256_storeu_si256((__m256i*)(s + 16), Add(st[2], c));
+    _mm256_storeu_si256((__m256i*)(s + 24), Add(st[3], d));
+    _mm256_storeu_si256((__m256i*)(s + 32), Add(st[4], e));
+    _mm256_storeu_si256((__m256i*)(s + 40), Add(st[5], f));
+    _mm256_storeu_si256((__m256i*)(s + 48), Add(st[6], g));
+    _mm256_storeu_si256((__m256i*)(s + 56), Add(st[7], h));
 }
 
 void Transform_8way(unsigned char* out, const unsigned char* in)
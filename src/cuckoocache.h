@@ -5,6 +5,7 @@
 #ifndef BITCOIN_CUCKOOCACHE_H
 #define BITCOIN_CUCKOOCACHE_H
 
+#include <memusage.h>
 #include <util/fastrange.h>
 
 #include <algorithm> // std::find
@@ -14,7 +15,9 @@
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
@@ -27,6 +30,9 @@
  *
  * 2. @ref cache is a cache which is performant in memory usage and lookup speed. It
  * is lockfree for erase operations. Elements are lazily erased on the next insert.
+ *
+ * 3. @ref sharded_cache splits a @ref cache into shards with their own locks, for
+ * concurrent use by many threads.
  */
 namespace CuckooCache
 {
@@ -350,6 +356,13 @@ public:
         return size;
     }
 
+    /** Memory used by the table and the collection and epoch flags */
+    size_t DynamicMemoryUsage() const
+    {
+        return memusage::DynamicUsage(table) + memusage::MallocUsage((size + 7) / 8) +
+               memusage::MallocUsage((epoch_flags.capacity() + 7) / 8);
+    }
+
     /** setup_bytes is a convenience function which accounts for internal memory
      * usage when deciding how many elements to store. It isn't perfect because
      * it doesn't account for any overhead (struct size, MallocUsage, collection
@@ -396,8 +409,9 @@ public:
      * @post one of the following: All previously inserted elements and e are
      * now in the table, one previously inserted element is evicted from the
      * table, the entry attempted to be inserted is evicted.
+     * @returns true if an element was evicted, false otherwise
      */
-    inline void insert(Element e)
+    inline bool insert(Element e)
     {
         epoch_check();
         uint32_t last_loc = invalid();
@@ -409,7 +423,7 @@ public:
             if (table[loc] == e) {
                 please_keep(loc);
                 epoch_flags[loc] = last_epoch;
-                return;
+                return false;
             }
         for (uint8_t depth = 0; depth < depth_limit; ++depth) {
             // First try to insert to an empty slot, if one exists
@@ -419,7 +433,7 @@ public:
                 table[loc] = std::move(e);
                 please_keep(loc);
                 epoch_flags[loc] = last_epoch;
-                return;
+                return false;
             }
             /** Swap with the element at the location that was
             * not the last one looked at. Example:
@@ -445,6 +459,7 @@ public:
             // Recompute the locs -- unfortunately happens one too many times!
             locs = compute_hashes(e);
         }
+        return true;
     }
 
     /** contains iterates through the hash locations for a given element
@@ -486,6 +501,114 @@ public:
         return false;
     }
 };
+
+/** Number of lookups that found or missed an element, and of elements evicted
+ * by inserts that found no free slot, since a cache was set up.
+ */
+struct stats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+};
+
+/** sharded_cache splits a @ref cache into a fixed number of shards, each behind
+ * its own lock. Lookups take a shared lock and inserts an exclusive one, so
+ * threads only contend when they insert into the same shard.
+ *
+ * An element is assigned to a shard by the low bits of its first hash. A
+ * @ref cache picks locations from the high bits of the hashes, so all the
+ * locations within a shard remain in use.
+ *
+ * @tparam Element should be a movable and copyable type
+ * @tparam Hash should be a function/callable which takes a template parameter
+ * hash_select and an Element and extracts a hash from it.
+ * @tparam Shards the number of shards
+ */
+template <typename Element, typename Hash, size_t Shards = 16>
+class sharded_cache
+{
+private:
+    struct alignas(64) shard {
+        std::shared_mutex mutex;
+        cache<Element, Hash> table;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+
+    std::array<shard, Shards> shards;
+
+    /** hash_function is a const instance of the hash function. */
+    const Hash hash_function{};
+
+    shard& get_shard(const Element& e)
+    {
+        return shards[hash_function.template operator()<0>(e) % Shards];
+    }
+
+public:
+    /** Set up every shard with an equal part of the given number of bytes.
+     * Not thread safe.
+     *
+     * @returns the total number of elements storable and their approximate
+     * size in bytes, or std::nullopt if the size requested is too large.
+     */
+    std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t bytes)
+    {
+        uint64_t num_elems{0};
+        size_t approx_size_bytes{0};
+        for (shard& s : shards) {
+            const auto setup_results{s.table.setup_bytes(bytes / Shards)};
+            if (!setup_results) return std::nullopt;
+            num_elems += setup_results->first;
+            approx_size_bytes += setup_results->second;
+            s.hits = s.misses = s.evictions = 0;
+        }
+        if (std::numeric_limits<uint32_t>::max() < num_elems) return std::nullopt;
+        return std::make_pair(static_cast<uint32_t>(num_elems), approx_size_bytes);
+    }
+
+    /** Insert an element, see @ref cache::insert. */
+    void insert(Element e)
+    {
+        shard& s{get_shard(e)};
+        std::unique_lock<std::shared_mutex> lock(s.mutex);
+        if (s.table.insert(std::move(e))) ++s.evictions;
+    }
+
+    /** Look an element up, see @ref cache::contains. */
+    bool contains(const Element& e, const bool erase)
+    {
+        shard& s{get_shard(e)};
+        std::shared_lock<std::shared_mutex> lock(s.mutex);
+        const bool found{s.table.contains(e, erase)};
+        ++(found ? s.hits : s.misses);
+        return found;
+    }
+
+    /** Sum the memory used by all the shards. */
+    size_t DynamicMemoryUsage()
+    {
+        size_t usage{0};
+        for (shard& s : shards) {
+            std::shared_lock<std::shared_mutex> lock(s.mutex);
+            usage += s.table.DynamicMemoryUsage();
+        }
+        return usage;
+    }
+
+    /** Sum the statistics of all the shards. */
+    stats get_stats() const
+    {
+        stats total;
+        for (const shard& s : shards) {
+            total.hits += s.hits;
+            total.misses += s.misses;
+            total.evictions += s.evictions;
+        }
+        return total;
+    }
+};
 } // namespace CuckooCache
 
 #endif // BITCOIN_CUCKOOCACHE_H
@@ -110,12 +110,14 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBTuning& tuning)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    const size_t block_cache_size{static_cast<size_t>(uint64_t{nCacheSize} * tuning.block_cache_percent / 100)};
+    options.block_cache = leveldb::NewLRUCache(block_cache_size);
+    options.write_buffer_size = tuning.write_buffer_size ? tuning.write_buffer_size : (nCacheSize - block_cache_size) / 2; // up to two write buffers may be held in memory simultaneously
+    // Tables written with another filter, or none, remain readable; they just aren't filtered.
+    options.filter_policy = tuning.bloom_bits > 0 ? leveldb::NewBloomFilterPolicy(tuning.bloom_bits) : nullptr;
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -127,15 +129,16 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
-    : m_name{fs::PathToString(path.stem())}
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const DBTuning& tuning)
+    : m_name{fs::PathToString(path.stem())}, m_cache_size{nCacheSize}, m_tuning{tuning}
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, tuning);
+    m_tuning.write_buffer_size = options.write_buffer_size;
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -225,6 +228,13 @@ size_t CDBWrapper::DynamicMemoryUsage() const
     return parsed.value();
 }
 
+std::optional<std::string> CDBWrapper::GetProperty(const std::string& property) const
+{
+    std::string value;
+    if (!pdb->GetProperty(property, &value)) return std::nullopt;
+    return value;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -15,6 +15,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <optional>
 #include <leveldb/db.h>
 #include <leveldb/iterator.h>
 #include <leveldb/options.h>
@@ -39,6 +40,17 @@ public:
 
 class CDBWrapper;
 
+/** LevelDB settings that can be tuned per database */
+struct DBTuning {
+    //! Share of the cache size used for the block cache, in percent. The rest is split
+    //! between the two write buffers that may be held in memory at once.
+    int block_cache_percent{50};
+    //! Bits per key of the bloom filter, or 0 for no filter
+    int bloom_bits{10};
+    //! Size of a write buffer in bytes, or 0 to derive it from the cache size
+    size_t write_buffer_size{0};
+};
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private {
@@ -208,6 +220,10 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! the cache size and tuning the database was opened with
+    size_t m_cache_size;
+    DBTuning m_tuning;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
@@ -227,8 +243,10 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] tuning      How nCacheSize is split between the block cache and the write
+     *                        buffers, and the bloom filter to use.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const DBTuning& tuning = {});
     ~CDBWrapper();
 
     CDBWrapper(const CDBWrapper&) = delete;
@@ -300,6 +318,14 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    //! Get the value of a LevelDB property such as "leveldb.stats", if it is known.
+    std::optional<std::string> GetProperty(const std::string& property) const;
+
+    size_t CacheSize() const { return m_cache_size; }
+
+    //! The tuning in use, with the write buffer size filled in.
+    const DBTuning& Tuning() const { return m_tuning; }
+
     CDBIterator *NewIterator()
     {
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
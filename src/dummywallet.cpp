@@ -51,6 +51,7 @@ void DummyWalletInit::AddWalletOptions(ArgsManager& argsman) const
         "-privdb",
         "-walletrejectlongchains",
         "-walletcrosschain",
+        "-sqlitewal",
         "-unsafesqlitesync",
     });
 }
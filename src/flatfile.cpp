@@ -3,13 +3,250 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
 #include <stdexcept>
 
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <logging.h>
 #include <tinyformat.h>
+#include <util/compression.h>
 #include <util/system.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+/**
+ * A compressed flat file is a sequence of chunks, each holding up to
+ * FLATFILE_COMPRESSED_CHUNK_SIZE bytes of the original file as an LZ4 block,
+ * or as is where compressing them would not make them smaller. The chunks
+ * are followed by a table of their stored sizes, as 32 bit integers with the
+ * top bit set for chunks stored as is, and by the trailer:
+ *
+ * - 64 bit size of the original file
+ * - 32 bit chunk size
+ * - 32 bit number of chunks
+ * - 4 byte magic
+ *
+ * Any position of the original file can be read by decompressing only the
+ * chunk holding it, so positions within compressed files stay valid.
+ */
+constexpr uint32_t RAW_CHUNK_FLAG{0x80000000};
+constexpr uint32_t MAX_COMPRESSED_CHUNK_SIZE{1 << 24};
+constexpr std::array<unsigned char, 4> COMPRESSED_FILE_MAGIC{'F', 'F', 'Z', 1};
+constexpr size_t COMPRESSED_TRAILER_SIZE{8 + 4 + 4 + COMPRESSED_FILE_MAGIC.size()};
+
+struct CompressedFileIndex
+{
+    uint64_t size{0};
+    uint32_t chunk_size{0};
+    //! Offsets of the chunks, followed by the offset of the table
+    std::vector<uint64_t> offsets;
+    std::vector<bool> raw;
+
+    size_t Chunks() const { return raw.size(); }
+    size_t ChunkLength(size_t chunk) const { return std::min<uint64_t>(chunk_size, size - uint64_t{chunk} * chunk_size); }
+};
+
+bool ReadCompressedIndex(FILE* file, CompressedFileIndex& index)
+{
+    std::array<unsigned char, COMPRESSED_TRAILER_SIZE> trailer;
+    if (fseek(file, -long{COMPRESSED_TRAILER_SIZE}, SEEK_END) || fread(trailer.data(), 1, trailer.size(), file) != trailer.size()) {
+        return false;
+    }
+    if (!std::equal(COMPRESSED_FILE_MAGIC.begin(), COMPRESSED_FILE_MAGIC.end(), trailer.end() - COMPRESSED_FILE_MAGIC.size())) {
+        return false;
+    }
+    index.size = ReadLE64(trailer.data());
+    index.chunk_size = ReadLE32(trailer.data() + 8);
+    const uint32_t chunks{ReadLE32(trailer.data() + 12)};
+    if (index.chunk_size == 0 || index.chunk_size > MAX_COMPRESSED_CHUNK_SIZE ||
+        chunks != (index.size + index.chunk_size - 1) / index.chunk_size) {
+        return false;
+    }
+
+    const long file_size{ftell(file)};
+    if (file_size < 0 || uint64_t(file_size) < COMPRESSED_TRAILER_SIZE + uint64_t{chunks} * 4) return false;
+    const uint64_t table_pos{file_size - COMPRESSED_TRAILER_SIZE - uint64_t{chunks} * 4};
+    std::vector<unsigned char> table(size_t{chunks} * 4);
+    if (fseek(file, table_pos, SEEK_SET) || fread(table.data(), 1, table.size(), file) != table.size()) {
+        return false;
+    }
+    index.offsets.assign(1, 0);
+    index.raw.clear();
+    for (uint32_t chunk = 0; chunk < chunks; ++chunk) {
+        const uint32_t stored{ReadLE32(table.data() + 4 * chunk)};
+        index.raw.push_back(stored & RAW_CHUNK_FLAG);
+        index.offsets.push_back(index.offsets.back() + (stored & ~RAW_CHUNK_FLAG));
+    }
+    return index.offsets.back() == table_pos;
+}
+
+bool ReadCompressedChunk(FILE* file, const CompressedFileIndex& index, size_t chunk, std::vector<std::byte>& data)
+{
+    const size_t stored_size = index.offsets[chunk + 1] - index.offsets[chunk];
+    const size_t length{index.ChunkLength(chunk)};
+    if (index.raw[chunk] && stored_size != length) return false;
+    std::vector<std::byte> stored(stored_size);
+    if (fseek(file, index.offsets[chunk], SEEK_SET) || fread(stored.data(), 1, stored.size(), file) != stored.size()) {
+        return false;
+    }
+    if (index.raw[chunk]) {
+        data = std::move(stored);
+        return true;
+    }
+    data.resize(length);
+    return LZ4Decompress(stored, data);
+}
+
+/**
+ * Cache of the most recently read chunks of compressed files, so that reading
+ * the records of a chunk one after another decompresses it only once.
+ */
+class DecompressedChunkCache
+{
+private:
+    using Key = std::pair<std::string, size_t>;
+
+    Mutex m_mutex;
+    //! Chunks in order of last access, most recent first
+    std::vector<std::pair<Key, std::shared_ptr<const std::vector<std::byte>>>> m_chunks GUARDED_BY(m_mutex);
+    size_t m_size GUARDED_BY(m_mutex){0};
+
+public:
+    std::shared_ptr<const std::vector<std::byte>> Get(const std::string& path, size_t chunk) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        auto it = std::find_if(m_chunks.begin(), m_chunks.end(), [&](const auto& entry) { return entry.first == Key{path, chunk}; });
+        if (it == m_chunks.end()) return nullptr;
+        std::rotate(m_chunks.begin(), it, it + 1);
+        return m_chunks.front().second;
+    }
+
+    void Add(const std::string& path, size_t chunk, std::shared_ptr<const std::vector<std::byte>> data) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        m_size += data->size();
+        m_chunks.emplace(m_chunks.begin(), Key{path, chunk}, std::move(data));
+        while (m_size > FLATFILE_DECOMPRESSED_CACHE_SIZE && m_chunks.size() > 1) {
+            m_size -= m_chunks.back().second->size();
+            m_chunks.pop_back();
+        }
+    }
+
+    void Invalidate(const std::string& path) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        m_chunks.erase(std::remove_if(m_chunks.begin(), m_chunks.end(), [&](const auto& entry) {
+            if (entry.first.first != path) return false;
+            m_size -= entry.second->size();
+            return true;
+        }), m_chunks.end());
+    }
+};
+
+DecompressedChunkCache g_decompressed_chunks;
+//! Serializes decompressing files back to their original form
+Mutex g_decompress_mutex;
+
+#ifdef HAVE_FOPENCOOKIE
+struct CompressedFileReader
+{
+    FILE* file;
+    std::string path;
+    CompressedFileIndex index;
+    uint64_t pos{0};
+};
+
+ssize_t ReadCompressedFile(void* cookie, char* buf, size_t size)
+{
+    auto& reader{*static_cast<CompressedFileReader*>(cookie)};
+    size_t read{0};
+    while (read < size && reader.pos < reader.index.size) {
+        const size_t chunk = reader.pos / reader.index.chunk_size;
+        auto data{g_decompressed_chunks.Get(reader.path, chunk)};
+        if (!data) {
+            auto decompressed{std::make_shared<std::vector<std::byte>>()};
+            if (!ReadCompressedChunk(reader.file, reader.index, chunk, *decompressed)) {
+                errno = EIO;
+                return -1;
+            }
+            g_decompressed_chunks.Add(reader.path, chunk, decompressed);
+            data = std::move(decompressed);
+        }
+        const size_t offset = reader.pos - uint64_t{chunk} * reader.index.chunk_size;
+        const size_t length{std::min(size - read, data->size() - offset)};
+        std::memcpy(buf + read, data->data() + offset, length);
+        read += length;
+        reader.pos += length;
+    }
+    return read;
+}
+
+int SeekCompressedFile(void* cookie, off64_t* offset, int whence)
+{
+    auto& reader{*static_cast<CompressedFileReader*>(cookie)};
+    int64_t base;
+    switch (whence) {
+    case SEEK_SET: base = 0; break;
+    case SEEK_CUR: base = reader.pos; break;
+    case SEEK_END: base = reader.index.size; break;
+    default: errno = EINVAL; return -1;
+    }
+    if (*offset < -base) {
+        errno = EINVAL;
+        return -1;
+    }
+    reader.pos = base + *offset;
+    *offset = reader.pos;
+    return 0;
+}
+
+int CloseCompressedFile(void* cookie)
+{
+    auto* reader{static_cast<CompressedFileReader*>(cookie)};
+    const int ret{fclose(reader->file)};
+    delete reader;
+    return ret;
+}
+#endif // HAVE_FOPENCOOKIE
+
+/** Open a compressed file to read its original contents, if supported by the platform. */
+FILE* OpenCompressedFile(const fs::path& path)
+{
+#ifdef HAVE_FOPENCOOKIE
+    FILE* file{fsbridge::fopen(path, "rb")};
+    if (!file) return nullptr;
+    auto reader{std::make_unique<CompressedFileReader>()};
+    reader->file = file;
+    reader->path = fs::PathToString(path);
+    if (!ReadCompressedIndex(file, reader->index)) {
+        LogPrintf("Invalid compressed file %s\n", fs::PathToString(path));
+        fclose(file);
+        return nullptr;
+    }
+    const cookie_io_functions_t functions{ReadCompressedFile, nullptr, SeekCompressedFile, CloseCompressedFile};
+    FILE* stream{fopencookie(reader.get(), "rb", functions)};
+    if (!stream) {
+        fclose(file);
+        return nullptr;
+    }
+    reader.release();
+    return stream;
+#else
+    return nullptr;
+#endif
+}
+} // namespace
+
 FlatFileSeq::FlatFileSeq(fs::path dir, const char* prefix, size_t chunk_size) :
     m_dir(std::move(dir)),
     m_prefix(prefix),
@@ -30,6 +267,16 @@ fs::path FlatFileSeq::FileName(const FlatFilePos& pos) const
     return m_dir / fs::u8path(strprintf("%s%05u.dat", m_prefix, pos.nFile));
 }
 
+fs::path FlatFileSeq::CompressedFileName(const FlatFilePos& pos) const
+{
+    return m_dir / fs::u8path(strprintf("%s%05u.cdat", m_prefix, pos.nFile));
+}
+
+bool FlatFileSeq::IsCompressed(const FlatFilePos& pos) const
+{
+    return fs::exists(CompressedFileName(pos));
+}
+
 FILE* FlatFileSeq::Open(const FlatFilePos& pos, bool read_only)
 {
     if (pos.IsNull()) {
@@ -38,6 +285,17 @@ FILE* FlatFileSeq::Open(const FlatFilePos& pos, bool read_only)
     fs::path path = FileName(pos);
     fs::create_directories(path.parent_path());
     FILE* file = fsbridge::fopen(path, read_only ? "rb": "rb+");
+    if (!file && IsCompressed(pos)) {
+        // Read compressed files in place where possible, and decompress them otherwise
+        if (read_only) file = OpenCompressedFile(CompressedFileName(pos));
+        if (!file) {
+            if (!Decompress(pos)) {
+                LogPrintf("Unable to decompress file %s\n", fs::PathToString(CompressedFileName(pos)));
+                return nullptr;
+            }
+            file = fsbridge::fopen(path, read_only ? "rb": "rb+");
+        }
+    }
     if (!file && !read_only)
         file = fsbridge::fopen(path, "wb+");
     if (!file) {
@@ -80,6 +338,10 @@ size_t FlatFileSeq::Allocate(const FlatFilePos& pos, size_t add_size, bool& out_
 
 bool FlatFileSeq::Flush(const FlatFilePos& pos, bool finalize)
 {
+    // Compressed files have been committed and truncated before being compressed
+    if (!fs::exists(FileName(pos)) && IsCompressed(pos)) {
+        return true;
+    }
     FILE* file = Open(FlatFilePos(pos.nFile, 0)); // Avoid fseek to nPos
     if (!file) {
         return error("%s: failed to open file %d", __func__, pos.nFile);
@@ -97,3 +359,173 @@ bool FlatFileSeq::Flush(const FlatFilePos& pos, bool finalize)
     fclose(file);
     return true;
 }
+
+bool FlatFileSeq::WriteCompressed(const FlatFilePos& pos, uint64_t size, uint64_t& compressed_size)
+{
+    const fs::path path{FileName(pos)};
+    const fs::path tmp_path{m_dir / fs::u8path(strprintf("%s%05u.cdat.tmp", m_prefix, pos.nFile))};
+    FILE* in{fsbridge::fopen(path, "rb")};
+    if (!in) {
+        return error("%s: failed to open file %s", __func__, fs::PathToString(path));
+    }
+    FILE* out{fsbridge::fopen(tmp_path, "wb")};
+    if (!out) {
+        fclose(in);
+        return error("%s: failed to open file %s", __func__, fs::PathToString(tmp_path));
+    }
+
+    std::vector<std::byte> chunk(FLATFILE_COMPRESSED_CHUNK_SIZE);
+    std::vector<unsigned char> table;
+    unsigned char buf[8];
+    bool ok{true};
+    compressed_size = 0;
+    for (uint64_t remaining{size}; ok && remaining > 0;) {
+        const size_t length = std::min<uint64_t>(remaining, chunk.size());
+        if (fread(chunk.data(), 1, length, in) != length) {
+            ok = false;
+            break;
+        }
+        const Span<const std::byte> original{Span{chunk}.first(length)};
+        const std::vector<std::byte> compressed{LZ4Compress(original)};
+        const bool raw{compressed.size() >= length};
+        const Span<const std::byte> stored{raw ? original : Span<const std::byte>{compressed}};
+        ok = fwrite(stored.data(), 1, stored.size(), out) == stored.size();
+        WriteLE32(buf, stored.size() | (raw ? RAW_CHUNK_FLAG : 0));
+        table.insert(table.end(), buf, buf + 4);
+        compressed_size += stored.size();
+        remaining -= length;
+    }
+    fclose(in);
+
+    WriteLE64(buf, size);
+    table.insert(table.end(), buf, buf + 8);
+    WriteLE32(buf, FLATFILE_COMPRESSED_CHUNK_SIZE);
+    table.insert(table.end(), buf, buf + 4);
+    WriteLE32(buf, (size + FLATFILE_COMPRESSED_CHUNK_SIZE - 1) / FLATFILE_COMPRESSED_CHUNK_SIZE);
+    table.insert(table.end(), buf, buf + 4);
+    table.insert(table.end(), COMPRESSED_FILE_MAGIC.begin(), COMPRESSED_FILE_MAGIC.end());
+    ok = ok && fwrite(table.data(), 1, table.size(), out) == table.size() && FileCommit(out);
+    fclose(out);
+    if (!ok) {
+        fs::remove(tmp_path);
+        return error("%s: failed to compress file %s", __func__, fs::PathToString(path));
+    }
+    compressed_size += table.size();
+    return true;
+}
+
+bool FlatFileSeq::CommitCompressed(const FlatFilePos& pos, bool commit)
+{
+    const fs::path tmp_path{m_dir / fs::u8path(strprintf("%s%05u.cdat.tmp", m_prefix, pos.nFile))};
+    if (!commit) {
+        fs::remove(tmp_path);
+        return true;
+    }
+    const fs::path compressed_path{CompressedFileName(pos)};
+    g_decompressed_chunks.Invalidate(fs::PathToString(compressed_path));
+    if (!RenameOver(tmp_path, compressed_path)) {
+        fs::remove(tmp_path);
+        return error("%s: failed to rename %s", __func__, fs::PathToString(tmp_path));
+    }
+    // Readers still holding the original file open keep reading it
+    fs::remove(FileName(pos));
+    DirectoryCommit(m_dir);
+    return true;
+}
+
+bool FlatFileSeq::Decompress(const FlatFilePos& pos)
+{
+    LOCK(g_decompress_mutex);
+    const fs::path path{FileName(pos)};
+    if (fs::exists(path)) return true; // Decompressed concurrently
+    const fs::path compressed_path{CompressedFileName(pos)};
+    const fs::path tmp_path{m_dir / fs::u8path(strprintf("%s%05u.dat.tmp", m_prefix, pos.nFile))};
+    FILE* in{fsbridge::fopen(compressed_path, "rb")};
+    if (!in) return false;
+    FILE* out{fsbridge::fopen(tmp_path, "wb")};
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+
+    CompressedFileIndex index;
+    bool ok{ReadCompressedIndex(in, index)};
+    std::vector<std::byte> chunk;
+    for (size_t i = 0; ok && i < index.Chunks(); ++i) {
+        ok = ReadCompressedChunk(in, index, i, chunk) && fwrite(chunk.data(), 1, chunk.size(), out) == chunk.size();
+    }
+    fclose(in);
+    ok = ok && FileCommit(out);
+    fclose(out);
+    if (!ok || !RenameOver(tmp_path, path)) {
+        fs::remove(tmp_path);
+        return false;
+    }
+    fs::remove(compressed_path);
+    g_decompressed_chunks.Invalidate(fs::PathToString(compressed_path));
+    DirectoryCommit(m_dir);
+    return true;
+}
+
+void FlatFileSeq::Remove(const FlatFilePos& pos)
+{
+    fs::remove(FileName(pos));
+    fs::remove(CompressedFileName(pos));
+    g_decompressed_chunks.Invalidate(fs::PathToString(CompressedFileName(pos)));
+}
+
+FlatFileMapping::FlatFileMapping(const fs::path& path)
+{
+#ifndef WIN32
+    const int fd = open(fs::PathToString(path).c_str(), O_RDONLY);
+    if (fd == -1) {
+        // A missing file may be compressed, and is read without a mapping
+        if (errno != ENOENT) LogPrintf("Unable to open file %s\n", fs::PathToString(path));
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const unsigned char*>(data);
+            m_size = st.st_size;
+        } else {
+            LogPrintf("Unable to map file %s\n", fs::PathToString(path));
+        }
+    }
+    // The mapping keeps the file referenced
+    close(fd);
+#endif
+}
+
+FlatFileMapping::~FlatFileMapping()
+{
+#ifndef WIN32
+    if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+}
+
+std::shared_ptr<const FlatFileMapping> FlatFileMappingCache::Get(const fs::path& path, size_t min_size)
+{
+    LOCK(m_mutex);
+    auto it = std::find_if(m_mappings.begin(), m_mappings.end(), [&](const auto& entry) { return entry.first == path; });
+    if (it != m_mappings.end() && it->second->Data().size() >= min_size) {
+        std::rotate(m_mappings.begin(), it, it + 1);
+        return m_mappings.front().second;
+    }
+    if (it != m_mappings.end()) m_mappings.erase(it);
+
+    auto mapping = std::make_shared<const FlatFileMapping>(path);
+    if (mapping->IsNull() || mapping->Data().size() < min_size) {
+        return nullptr;
+    }
+    m_mappings.emplace(m_mappings.begin(), path, mapping);
+    if (m_mappings.size() > m_max_mappings) m_mappings.pop_back();
+    return mapping;
+}
+
+void FlatFileMappingCache::Invalidate(const fs::path& path)
+{
+    LOCK(m_mutex);
+    m_mappings.erase(std::remove_if(m_mappings.begin(), m_mappings.end(), [&](const auto& entry) { return entry.first == path; }), m_mappings.end());
+}
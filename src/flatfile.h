@@ -6,10 +6,14 @@
 #ifndef BITCOIN_FLATFILE_H
 #define BITCOIN_FLATFILE_H
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <fs.h>
 #include <serialize.h>
+#include <span.h>
+#include <sync.h>
 
 struct FlatFilePos
 {
@@ -39,6 +43,11 @@ struct FlatFilePos
     std::string ToString() const;
 };
 
+/** Bytes of a flat file that are compressed together, and decompressed to read any of them */
+static constexpr uint32_t FLATFILE_COMPRESSED_CHUNK_SIZE{256 * 1024};
+/** Bytes of decompressed chunks cached for reading compressed flat files */
+static constexpr size_t FLATFILE_DECOMPRESSED_CACHE_SIZE{32 << 20};
+
 /**
  * FlatFileSeq represents a sequence of numbered files storing raw data. This class facilitates
  * access to and efficient management of these files.
@@ -63,9 +72,36 @@ public:
     /** Get the name of the file at the given position. */
     fs::path FileName(const FlatFilePos& pos) const;
 
-    /** Open a handle to the file at the given position. */
+    /** Get the name of the compressed file at the given position. */
+    fs::path CompressedFileName(const FlatFilePos& pos) const;
+
+    /** Whether the file at the given position is stored compressed. */
+    bool IsCompressed(const FlatFilePos& pos) const;
+
+    /**
+     * Open a handle to the file at the given position. A compressed file is read through a
+     * decompressing handle where supported, and is decompressed again to be written to.
+     */
     FILE* Open(const FlatFilePos& pos, bool read_only = false);
 
+    /**
+     * Write a compressed copy of the first size bytes of the file at the given position. The
+     * copy only replaces the file once passed to CommitCompressed().
+     *
+     * @param[out] compressed_size The size of the compressed copy.
+     * @return true on success, false on failure.
+     */
+    bool WriteCompressed(const FlatFilePos& pos, uint64_t size, uint64_t& compressed_size);
+
+    /**
+     * Replace the file at the given position with the compressed copy written by
+     * WriteCompressed(), or discard the copy if commit is false.
+     */
+    bool CommitCompressed(const FlatFilePos& pos, bool commit);
+
+    /** Remove the file at the given position, whether it is compressed or not. */
+    void Remove(const FlatFilePos& pos);
+
     /**
      * Allocate additional space in a file after the given starting position. The amount allocated
      * will be the minimum multiple of the sequence chunk size greater than add_size.
@@ -85,6 +121,62 @@ public:
      * @return true on success, false on failure.
      */
     bool Flush(const FlatFilePos& pos, bool finalize = false);
+
+private:
+    /** Replace the compressed file at the given position with its decompressed contents. */
+    bool Decompress(const FlatFilePos& pos);
+};
+
+/**
+ * A read-only memory mapping of a whole file, which lets records be
+ * deserialized straight from the page cache without a read per access.
+ * Mapping is only supported on POSIX systems.
+ */
+class FlatFileMapping
+{
+private:
+    const unsigned char* m_data{nullptr};
+    size_t m_size{0};
+
+public:
+    /** Map the file at the given path. The mapping is null if it failed or the file is empty. */
+    explicit FlatFileMapping(const fs::path& path);
+    ~FlatFileMapping();
+
+    FlatFileMapping(const FlatFileMapping&) = delete;
+    FlatFileMapping& operator=(const FlatFileMapping&) = delete;
+
+    bool IsNull() const { return m_data == nullptr; }
+    Span<const unsigned char> Data() const { return {m_data, m_size}; }
+};
+
+/**
+ * Cache of the mappings of the most recently accessed flat files. A mapping
+ * stays valid for as long as it is referenced, even after being evicted or
+ * invalidated, so readers never observe it being unmapped.
+ */
+class FlatFileMappingCache
+{
+private:
+    const size_t m_max_mappings;
+
+    Mutex m_mutex;
+    //! Mappings in order of last access, most recent first
+    std::vector<std::pair<fs::path, std::shared_ptr<const FlatFileMapping>>> m_mappings GUARDED_BY(m_mutex);
+
+public:
+    explicit FlatFileMappingCache(size_t max_mappings) : m_max_mappings(max_mappings) {}
+
+    /**
+     * Get the mapping of a file, mapping it again if the cached mapping is
+     * shorter than min_size because the file has grown since.
+     *
+     * @return the mapping, or nullptr if the file could not be mapped.
+     */
+    std::shared_ptr<const FlatFileMapping> Get(const fs::path& path, size_t min_size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Drop the mapping of a file, before it is truncated or removed. */
+    void Invalidate(const fs::path& path) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
 };
 
 #endif // BITCOIN_FLATFILE_H
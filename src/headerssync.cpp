@@ -18,9 +18,10 @@ constexpr size_t HEADER_COMMITMENT_PERIOD{584};
 //! received and validated against commitments.
 constexpr size_t REDOWNLOAD_BUFFER_SIZE{13959}; // 13959/584 = ~23.9 commitments
 
-// Our memory analysis assumes 48 bytes for a CompressedHeader (so we should
-// re-calculate parameters if we compress further)
-static_assert(sizeof(CompressedHeader) == 48);
+// Our memory analysis assumes 64 bytes for a CompressedHeader (48 bytes for
+// the Bitcoin fields plus the two supply amounts), so we should re-calculate
+// parameters if we compress further.
+static_assert(sizeof(CompressedHeader) == 64);
 
 HeadersSyncState::HeadersSyncState(NodeId id, const Consensus::Params& consensus_params,
         const CBlockIndex* chain_start, const arith_uint256& minimum_required_work) :
@@ -100,9 +101,12 @@ HeadersSyncState::ProcessingResult HeadersSyncState::ProcessNextHeaders(const
         // receive, and add headers to our redownload buffer. When the buffer
         // gets big enough (meaning that we've checked enough commitments),
         // we'll return a batch of headers to the caller for processing.
+        // Every redownloaded header needs its hash (to check continuity of
+        // the next one), so hash the whole message in one batch.
         ret.success = true;
-        for (const auto& hdr : received_headers) {
-            if (!ValidateAndStoreRedownloadedHeader(hdr)) {
+        const std::vector<uint256> hashes{GetBlockHeaderHashes(received_headers)};
+        for (size_t i = 0; i < received_headers.size(); ++i) {
+            if (!ValidateAndStoreRedownloadedHeader(received_headers[i], hashes[i])) {
                 // Something went wrong -- the peer gave us an unexpected chain.
                 // We could consider looking at the reason for failure and
                 // punishing the peer, but for now just give up on sync.
@@ -212,7 +216,7 @@ bool HeadersSyncState::ValidateAndProcessSingleHeader(const CBlockHeader& curren
     return true;
 }
 
-bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& header)
+bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& header, const uint256& hash)
 {
     Assume(m_download_state == State::REDOWNLOAD);
     if (m_download_state != State::REDOWNLOAD) return false;
@@ -260,7 +264,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
             // we've run out of commitments.
             return false;
         }
-        bool commitment = m_hasher(header.GetHash()) & 1;
+        bool commitment = m_hasher(hash) & 1;
         bool expected_commitment = m_header_commitments.front();
         m_header_commitments.pop_front();
         if (commitment != expected_commitment) {
@@ -272,7 +276,7 @@ bool HeadersSyncState::ValidateAndStoreRedownloadedHeader(const CBlockHeader& he
     // Store this header for later processing.
     m_redownloaded_headers.push_back(header);
     m_redownload_buffer_last_height = next_height;
-    m_redownload_buffer_last_hash = header.GetHash();
+    m_redownload_buffer_last_hash = hash;
 
     return true;
 }
@@ -315,3 +319,9 @@ CBlockLocator HeadersSyncState::NextHeadersRequestLocator() const
 
     return CBlockLocator{std::move(locator)};
 }
+
+size_t HeadersSyncState::DynamicMemoryUsage() const
+{
+    // Both are deques, which allocate their elements in large blocks, so only the elements are counted
+    return m_header_commitments.size() / 8 + m_redownloaded_headers.size() * sizeof(CompressedHeader);
+}
@@ -25,6 +25,8 @@ struct CompressedHeader {
     uint32_t nTime{0};
     uint32_t nBits{0};
     uint32_t nNonce{0};
+    CAmount cashSupply{0};
+    CAmount bondSupply{0};
 
     CompressedHeader()
     {
@@ -37,6 +39,8 @@ struct CompressedHeader {
         hashMerkleRoot = header.hashMerkleRoot;
         nTime = header.nTime;
         nBits = header.nBits;
+        cashSupply = header.cashSupply;
+        bondSupply = header.bondSupply;
         nNonce = header.nNonce;
     }
 
@@ -47,6 +51,8 @@ struct CompressedHeader {
         ret.hashMerkleRoot = hashMerkleRoot;
         ret.nTime = nTime;
         ret.nBits = nBits;
+        ret.cashSupply = cashSupply;
+        ret.bondSupply = bondSupply;
         ret.nNonce = nNonce;
         return ret;
     };
@@ -175,6 +181,9 @@ public:
      */
     CBlockLocator NextHeadersRequestLocator() const;
 
+    /** Approximate memory used by the stored commitments and redownloaded headers */
+    size_t DynamicMemoryUsage() const;
+
 private:
     /** Clear out all download state that might be in progress (freeing any used
      * memory), and mark this object as no longer usable.
@@ -194,8 +203,8 @@ private:
     bool ValidateAndProcessSingleHeader(const CBlockHeader& current);
 
     /** In REDOWNLOAD, check a header's commitment (if applicable) and add to
-     * buffer for later processing */
-    bool ValidateAndStoreRedownloadedHeader(const CBlockHeader& header);
+     * buffer for later processing. hash must be header.GetHash(). */
+    bool ValidateAndStoreRedownloadedHeader(const CBlockHeader& header, const uint256& hash);
 
     /** Return a set of headers that satisfy our proof-of-work threshold */
     std::vector<CBlockHeader> PopHeadersReadyForAcceptance();
@@ -201,7 +201,7 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            strReply = JSONRPCReply(std::move(result), NullUniValue, jreq.id);
 
         // array of requests
         } else if (valRequest.isArray()) {
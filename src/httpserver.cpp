@@ -19,14 +19,20 @@
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
 #include <util/threadnames.h>
+#include <util/threadpool.h>
+#include <util/time.h>
 #include <util/translation.h>
 
+#include <algorithm>
 #include <deque>
+#include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <string_view>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -35,6 +41,7 @@
 #include <event2/bufferevent.h>
 #include <event2/http.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -43,6 +50,9 @@
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
+/** How far into a request body the JSON-RPC method is looked for when choosing a work queue */
+static const size_t MAX_METHOD_PEEK_SIZE = 4096;
+
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
 {
@@ -63,60 +73,104 @@ private:
     HTTPRequestHandler func;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Simple work queue for distributing work over the workers of a thread pool.
+ * Work items are simply callable objects. Up to a given number of runner tasks
+ * take items from the queue, and end once it is empty. Reaching the maximum
+ * depth doesn't reject items: the owner is expected to stop producing them
+ * until it is told that the queue dropped below it again.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
     Mutex cs;
+    //! Signalled when a runner ends
     std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
+    std::deque<std::pair<std::unique_ptr<WorkItem>, SteadyClock::time_point>> queue GUARDED_BY(cs);
     bool running GUARDED_BY(cs){true};
     const size_t maxDepth;
+    //! Called by a runner when the queue drops below maxDepth
+    const std::function<void()> m_below_max_depth;
+    std::chrono::microseconds lastWait GUARDED_BY(cs){0};
+    std::optional<util::TaskPool> m_pool GUARDED_BY(cs);
+    int m_max_runners GUARDED_BY(cs){0};
+    int m_runners GUARDED_BY(cs){0};
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : maxDepth(_maxDepth)
+    WorkQueue(size_t _maxDepth, std::function<void()> below_max_depth)
+        : maxDepth(_maxDepth), m_below_max_depth(std::move(below_max_depth))
     {
     }
-    /** Precondition: worker threads have all stopped (they have been joined).
+    /** Precondition: the runners have all ended (WaitForRunners).
      */
     ~WorkQueue() = default;
+    /** Run the work items as tasks of pool, at most max_runners at a time */
+    void Start(util::TaskPool pool, int max_runners) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        m_pool.emplace(std::move(pool));
+        m_max_runners = max_runners;
+    }
     /** Enqueue a work item */
     bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
-        LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
-            return false;
+        {
+            LOCK(cs);
+            if (!running) {
+                return false;
+            }
+            queue.emplace_back(std::unique_ptr<WorkItem>(item), SteadyClock::now());
+            if (!m_pool || m_runners >= m_max_runners) return true;
+            ++m_runners;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
+        m_pool->Post([this] { Run(); });
         return true;
     }
-    /** Thread function */
+    /** Runner task, which runs work items until the queue is empty */
     void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
         while (true) {
             std::unique_ptr<WorkItem> i;
+            bool below_max_depth;
             {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running && queue.empty())
+                LOCK(cs);
+                if (queue.empty()) {
+                    --m_runners;
+                    cond.notify_all();
                     break;
-                i = std::move(queue.front());
+                }
+                i = std::move(queue.front().first);
+                lastWait = std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - queue.front().second);
                 queue.pop_front();
+                below_max_depth = queue.size() + 1 == maxDepth;
             }
+            if (below_max_depth) m_below_max_depth();
             (*i)();
         }
     }
-    /** Interrupt and exit loops */
+    /** Stop accepting work items */
     void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
         LOCK(cs);
         running = false;
-        cond.notify_all();
+    }
+    /** Wait until the runners have run all queued work items */
+    void WaitForRunners() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        WAIT_LOCK(cs, lock);
+        while (m_runners > 0)
+            cond.wait(lock);
+    }
+    size_t Depth() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        return queue.size();
+    }
+    size_t MaxDepth() const { return maxDepth; }
+    std::chrono::microseconds LastWait() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        return lastWait;
     }
 };
 
@@ -141,11 +195,22 @@ static struct evhttp* eventHTTP = nullptr;
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
 static std::unique_ptr<WorkQueue<HTTPClosure>> g_work_queue{nullptr};
+//! Work queue for priority JSON-RPC methods, if enabled
+static std::unique_ptr<WorkQueue<HTTPClosure>> g_priority_work_queue{nullptr};
+//! Maximum number of workers of each work queue
+static int g_http_threads{0};
+static int g_http_priority_threads{0};
 //! Handlers for (sub)paths
 static GlobalMutex g_httppathhandlers_mutex;
 static std::vector<HTTPPathHandler> pathHandlers GUARDED_BY(g_httppathhandlers_mutex);
 //! Bound listening sockets
 static std::vector<evhttp_bound_socket *> boundSockets;
+//! Maximum number of requests served over a connection before it is closed, 0 for no limit
+static uint64_t g_max_requests_per_connection{0};
+//! Open connections, with the number of requests received over each, and their accounting
+static GlobalMutex g_http_connections_mutex;
+static std::map<const evhttp_connection*, uint64_t> g_http_connections GUARDED_BY(g_http_connections_mutex);
+static HTTPConnectionInfo g_http_connection_info GUARDED_BY(g_http_connections_mutex){};
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
@@ -207,6 +272,103 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m)
     }
 }
 
+bool IsHTTPPriorityMethod(const std::string& method)
+{
+    // Calls that miners depend on to produce and relay blocks
+    static const std::set<std::string> PRIORITY_METHODS{"getblocktemplate", "submitblock", "submitheader"};
+    return PRIORITY_METHODS.count(method) > 0;
+}
+
+/** Return the method of a JSON-RPC request body, without consuming or parsing the
+ * body, or an empty string if it is not found near the start of the body. Used only to
+ * pick a work queue; the request is parsed and authenticated as usual by its handler. */
+static std::string PeekJSONRPCMethod(evhttp_request* req)
+{
+    evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf) return {};
+    static const std::string key{"\"method\""};
+    evbuffer_ptr end;
+    if (evbuffer_ptr_set(buf, &end, std::min(evbuffer_get_length(buf), MAX_METHOD_PEEK_SIZE), EVBUFFER_PTR_SET) != 0) return {};
+    evbuffer_ptr pos = evbuffer_search_range(buf, key.data(), key.size(), nullptr, &end);
+    if (pos.pos < 0 || evbuffer_ptr_set(buf, &pos, key.size(), EVBUFFER_PTR_ADD) != 0) return {};
+
+    char peek[64];
+    const ev_ssize_t len = evbuffer_copyout_from(buf, &pos, peek, sizeof(peek));
+    if (len <= 0) return {};
+    const std::string_view value{peek, size_t(len)};
+    const size_t start = value.find_first_not_of(" \t\r\n:");
+    if (start == std::string_view::npos || value[start] != '"') return {};
+    const size_t stop = value.find('"', start + 1);
+    if (stop == std::string_view::npos) return {};
+    return std::string{value.substr(start + 1, stop - start - 1)};
+}
+
+/** Connection close callback, set on every connection a request arrives on */
+static void http_connection_close_cb(struct evhttp_connection* conn, void*)
+{
+    LOCK(g_http_connections_mutex);
+    g_http_connections.erase(conn);
+}
+
+/** Account for a request, and return whether its connection should be closed after the reply */
+static bool TrackHTTPRequest(evhttp_request* req)
+{
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    if (!conn) return false;
+    LOCK(g_http_connections_mutex);
+    const auto [it, inserted] = g_http_connections.try_emplace(conn, 0);
+    if (inserted) {
+        evhttp_connection_set_closecb(conn, http_connection_close_cb, nullptr);
+        ++g_http_connection_info.accepted;
+    } else {
+        ++g_http_connection_info.reused;
+    }
+    ++g_http_connection_info.requests;
+    if (g_max_requests_per_connection > 0 && ++it->second == g_max_requests_per_connection) {
+        ++g_http_connection_info.request_limit_closes;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Stop accepting new connections while a work queue is full, leaving them in
+ * the listen backlog of the kernel instead of rejecting their requests. Each
+ * connection has at most one request queued, as libevent reads the next
+ * request on a connection only once the previous one was replied to, so the
+ * connections already open can't overfill the queues by much.
+ * Only called from the event loop thread.
+ */
+static void PauseAccepting()
+{
+    {
+        LOCK(g_http_connections_mutex);
+        if (!g_http_connection_info.accepting) return;
+        g_http_connection_info.accepting = false;
+        ++g_http_connection_info.accept_pauses;
+    }
+    LogPrint(BCLog::HTTP, "Work queue depth reached, no longer accepting connections\n");
+    for (evhttp_bound_socket* socket : boundSockets) {
+        evconnlistener_disable(evhttp_bound_socket_get_listener(socket));
+    }
+}
+
+/** Accept new connections again once all work queues are below their depth. Only called from the event loop thread. */
+static void ResumeAccepting()
+{
+    if (g_work_queue->Depth() >= g_work_queue->MaxDepth()) return;
+    if (g_priority_work_queue && g_priority_work_queue->Depth() >= g_priority_work_queue->MaxDepth()) return;
+    {
+        LOCK(g_http_connections_mutex);
+        if (g_http_connection_info.accepting) return;
+        g_http_connection_info.accepting = true;
+    }
+    LogPrint(BCLog::HTTP, "Accepting connections again\n");
+    for (evhttp_bound_socket* socket : boundSockets) {
+        evconnlistener_enable(evhttp_bound_socket_get_listener(socket));
+    }
+}
+
 /** HTTP request callback */
 static void http_request_cb(struct evhttp_request* req, void* arg)
 {
@@ -221,6 +383,9 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
         }
     }
     std::unique_ptr<HTTPRequest> hreq(new HTTPRequest(req));
+    if (TrackHTTPRequest(req)) {
+        hreq->WriteHeader("Connection", "close");
+    }
 
     // Early address-based allow check
     if (!ClientAllowed(hreq->GetPeer())) {
@@ -261,13 +426,17 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        // Priority methods get their own workers, so that they do not wait behind slow calls
+        const bool priority{g_priority_work_queue && hreq->GetRequestMethod() == HTTPRequest::POST &&
+                            IsHTTPPriorityMethod(PeekJSONRPCMethod(req))};
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
+        WorkQueue<HTTPClosure>& queue{*(priority ? g_priority_work_queue : g_work_queue)};
+        if (queue.Enqueue(item.get())) {
             item.release(); /* if true, queue took ownership */
+            if (queue.Depth() >= queue.MaxDepth()) PauseAccepting();
         } else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
-            item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
+            item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Request rejected while shutting down");
         }
     } else {
         hreq->WriteReply(HTTP_NOT_FOUND);
@@ -335,14 +504,6 @@ static bool HTTPBindAddresses(struct evhttp* http)
     return !boundSockets.empty();
 }
 
-/** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
-{
-    util::ThreadRename(strprintf("httpworker.%i", worker_num));
-    SetSyscallSandboxPolicy(SyscallSandboxPolicy::NET_HTTP_SERVER_WORKER);
-    queue->Run();
-}
-
 /** libevent event log callback */
 static void libevent_log_cb(int severity, const char *msg)
 {
@@ -394,6 +555,7 @@ bool InitHTTPServer()
     evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
     evhttp_set_max_body_size(http, MAX_SIZE);
     evhttp_set_gencb(http, http_request_cb, nullptr);
+    g_max_requests_per_connection = std::max<int64_t>(gArgs.GetIntArg("-rpcmaxrequestsperconnection", DEFAULT_HTTP_MAX_REQUESTS_PER_CONNECTION), 0);
 
     if (!HTTPBindAddresses(http)) {
         LogPrintf("Unable to bind any endpoint for RPC server\n");
@@ -404,7 +566,14 @@ bool InitHTTPServer()
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
     LogPrintfCategory(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
 
-    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    // Runners tell the event loop to resume accepting connections
+    const auto below_max_depth{[] { (new HTTPEvent(eventBase, true, ResumeAccepting))->trigger(nullptr); }};
+    g_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth, below_max_depth);
+    g_http_threads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    g_http_priority_threads = std::max((long)gArgs.GetIntArg("-rpcprioritythreads", DEFAULT_HTTP_PRIORITY_THREADS), 0L);
+    if (g_http_priority_threads > 0) {
+        g_priority_work_queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth, below_max_depth);
+    }
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -420,18 +589,16 @@ void UpdateHTTPServerLogging(bool enable) {
 }
 
 static std::thread g_thread_http;
-static std::vector<std::thread> g_thread_http_workers;
 
-void StartHTTPServer()
+void StartHTTPServer(util::ThreadPool& thread_pool)
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintfCategory(BCLog::HTTP, "starting %d worker threads\n", rpcThreads);
-    g_thread_http = std::thread(ThreadHTTP, eventBase);
-
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, g_work_queue.get(), i);
+    LogPrintfCategory(BCLog::HTTP, "running up to %d workers and %d priority workers\n", g_http_threads, g_http_priority_threads);
+    g_work_queue->Start(util::TaskPool{thread_pool, "httpworker", util::TaskPriority::NORMAL}, g_http_threads);
+    if (g_priority_work_queue) {
+        g_priority_work_queue->Start(util::TaskPool{thread_pool, "httpprio", util::TaskPriority::HIGH}, g_http_priority_threads);
     }
+    g_thread_http = std::thread(ThreadHTTP, eventBase);
 }
 
 void InterruptHTTPServer()
@@ -444,17 +611,18 @@ void InterruptHTTPServer()
     if (g_work_queue) {
         g_work_queue->Interrupt();
     }
+    if (g_priority_work_queue) {
+        g_priority_work_queue->Interrupt();
+    }
 }
 
 void StopHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
     if (g_work_queue) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
-        for (auto& thread : g_thread_http_workers) {
-            thread.join();
-        }
-        g_thread_http_workers.clear();
+        LogPrint(BCLog::HTTP, "Waiting for HTTP workers to finish\n");
+        g_work_queue->WaitForRunners();
+        if (g_priority_work_queue) g_priority_work_queue->WaitForRunners();
     }
     // Unlisten sockets, these are what make the event loop running, which means
     // that after this and all connections are closed the event loop will quit.
@@ -475,9 +643,30 @@ void StopHTTPServer()
         eventBase = nullptr;
     }
     g_work_queue.reset();
+    g_priority_work_queue.reset();
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo()
+{
+    std::vector<HTTPWorkQueueInfo> ret;
+    if (g_work_queue) {
+        ret.push_back({"default", g_http_threads, g_work_queue->Depth(), g_work_queue->MaxDepth(), g_work_queue->LastWait()});
+    }
+    if (g_priority_work_queue) {
+        ret.push_back({"priority", g_http_priority_threads, g_priority_work_queue->Depth(), g_priority_work_queue->MaxDepth(), g_priority_work_queue->LastWait()});
+    }
+    return ret;
+}
+
+HTTPConnectionInfo GetHTTPConnectionInfo()
+{
+    LOCK(g_http_connections_mutex);
+    HTTPConnectionInfo info{g_http_connection_info};
+    info.open = g_http_connections.size();
+    return info;
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -566,7 +755,7 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
-void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
+void HTTPRequest::WriteReply(int nStatus, Span<const std::byte> reply)
 {
     assert(!replySent && req);
     if (ShutdownRequested()) {
@@ -575,7 +764,7 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    evbuffer_add(evb, reply.data(), reply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
@@ -5,13 +5,23 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <string>
+#include <vector>
+
+#include <span.h>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
+static const int DEFAULT_HTTP_PRIORITY_THREADS=1;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+static const int DEFAULT_HTTP_MAX_REQUESTS_PER_CONNECTION=1000;
+
+namespace util {
+class ThreadPool;
+} // namespace util
 
 struct evhttp_request;
 struct event_base;
@@ -22,11 +32,11 @@ class HTTPRequest;
  * Call this before RegisterHTTPHandler or EventBase().
  */
 bool InitHTTPServer();
-/** Start HTTP server.
+/** Start HTTP server, running the requests on the workers of thread_pool.
  * This is separate from InitHTTPServer to give users race-condition-free time
  * to register their handlers between InitHTTPServer and StartHTTPServer.
  */
-void StartHTTPServer();
+void StartHTTPServer(util::ThreadPool& thread_pool);
 /** Interrupt HTTP server threads */
 void InterruptHTTPServer();
 /** Stop HTTP server */
@@ -35,6 +45,38 @@ void StopHTTPServer();
 /** Change logging level for libevent. */
 void UpdateHTTPServerLogging(bool enable);
 
+/** JSON-RPC methods served from their own work queue, so that they do not wait behind other calls */
+bool IsHTTPPriorityMethod(const std::string& method);
+
+/** State of an HTTP work queue */
+struct HTTPWorkQueueInfo {
+    std::string name;
+    int threads;
+    size_t depth;
+    size_t max_depth;
+    //! Time the most recently started request spent in the queue
+    std::chrono::microseconds last_wait;
+};
+/** Return the state of the HTTP work queues */
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo();
+
+/** Accounting of the connections to the HTTP server */
+struct HTTPConnectionInfo {
+    size_t open{0};
+    //! Number of connections that requests arrived on, and of the requests
+    uint64_t accepted{0};
+    uint64_t requests{0};
+    //! Number of requests that arrived on a connection kept alive after an earlier one
+    uint64_t reused{0};
+    //! Number of connections closed for reaching -rpcmaxrequestsperconnection
+    uint64_t request_limit_closes{0};
+    //! Whether new connections are accepted, rather than held back because a work queue is full
+    bool accepting{true};
+    uint64_t accept_pauses{0};
+};
+/** Return the accounting of the HTTP connections */
+HTTPConnectionInfo GetHTTPConnectionInfo();
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
 /** Register handler for prefix.
@@ -123,7 +165,8 @@ public:
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
-    void WriteReply(int nStatus, const std::string& strReply = "");
+    void WriteReply(int nStatus, const std::string& strReply = "") { WriteReply(nStatus, MakeByteSpan(strReply)); }
+    void WriteReply(int nStatus, Span<const std::byte> reply);
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -180,6 +180,19 @@ bool Session::Accept(Connection& conn)
     return false;
 }
 
+bool Session::Create()
+{
+    try {
+        LOCK(m_mutex);
+        CreateIfNotCreatedAlready();
+        return true;
+    } catch (const std::runtime_error& e) {
+        Log("Error creating session: %s", e.what());
+        CheckControlSock();
+    }
+    return false;
+}
+
 bool Session::Connect(const CService& to, Connection& conn, bool& proxy_error)
 {
     // Refuse connecting to arbitrary ports. We don't specify any destination port to the SAM proxy
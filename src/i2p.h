@@ -107,6 +107,13 @@ public:
      */
     bool Accept(Connection& conn);
 
+    /**
+     * Create the session with the SAM proxy now rather than when first used, so that a
+     * later `Listen()` or `Connect()` does not have to wait for it.
+     * @return true on success
+     */
+    bool Create() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
     /**
      * Connect to an I2P peer.
      * @param[in] to Peer to connect to.
@@ -4,6 +4,7 @@
 
 #include <chainparams.h>
 #include <index/base.h>
+#include <index/blockreader.h>
 #include <interfaces/chain.h>
 #include <kernel/chain.h>
 #include <node/blockstorage.h>
@@ -14,6 +15,7 @@
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
 #include <util/thread.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <validation.h> // For g_chainman
 #include <warnings.h>
@@ -21,8 +23,6 @@
 #include <string>
 #include <utility>
 
-using node::ReadBlockFromDisk;
-
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr auto SYNC_LOG_INTERVAL{30s};
@@ -148,10 +148,10 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain&
 
 void BaseIndex::ThreadSync()
 {
-    SetSyscallSandboxPolicy(SyscallSandboxPolicy::TX_INDEX);
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
-        auto& consensus_params = Params().GetConsensus();
+        // Blocks are read once for all the indexes syncing at the same time
+        IndexBlockReader block_reader{*m_chainstate};
 
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
@@ -197,14 +197,14 @@ void BaseIndex::ThreadSync()
                 Commit();
             }
 
-            CBlock block;
             interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            const std::shared_ptr<const CBlock> block{block_reader.Read(*pindex)};
+            if (!block) {
                 FatalError("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             } else {
-                block_info.data = &block;
+                block_info.data = block.get();
             }
             if (!CustomAppend(block_info)) {
                 FatalError("%s: Failed to write block %s to index database",
@@ -393,7 +393,15 @@ bool BaseIndex::Start()
         return false;
     }
 
-    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] { ThreadSync(); });
+    if (util::ThreadPool* thread_pool{m_chain->context()->thread_pool.get()}) {
+        // Long running, so it may only occupy some of the workers
+        m_sync_task = util::TaskPool{*thread_pool, GetName(), util::TaskPriority::LOW}.Submit([this] { ThreadSync(); });
+    } else {
+        m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] {
+            SetSyscallSandboxPolicy(SyscallSandboxPolicy::TX_INDEX);
+            ThreadSync();
+        });
+    }
     return true;
 }
 
@@ -401,6 +409,9 @@ void BaseIndex::Stop()
 {
     UnregisterValidationInterface(this);
 
+    if (m_sync_task.valid()) {
+        m_sync_task.wait();
+    }
     if (m_thread_sync.joinable()) {
         m_thread_sync.join();
     }
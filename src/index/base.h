@@ -10,7 +10,9 @@
 #include <threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <future>
 #include <string>
+#include <thread>
 
 class CBlock;
 class CBlockIndex;
@@ -66,6 +68,8 @@ private:
     /// The last block in the chain that the index is in sync with.
     std::atomic<const CBlockIndex*> m_best_block_index{nullptr};
 
+    //! The sync runs as a task of the node's thread pool if it has one, else on its own thread
+    std::future<void> m_sync_task;
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
@@ -73,10 +77,10 @@ private:
     bool Init();
 
     /// Sync the index with the block index starting from the current best block.
-    /// Intended to be run in its own thread, m_thread_sync, and can be
-    /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
-    /// flag is set and the BlockConnected ValidationInterface callback takes
-    /// over and the sync thread exits.
+    /// Intended to be run as a task, m_sync_task, or in its own thread,
+    /// m_thread_sync, and can be interrupted with m_interrupt. Once the index
+    /// gets in sync, the m_synced flag is set and the BlockConnected
+    /// ValidationInterface callback takes over and the sync ends.
     void ThreadSync();
 
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
@@ -119,6 +123,9 @@ protected:
 
     virtual DB& GetDB() const = 0;
 
+    /// Whether the initial sync is done and new blocks are appended as they are connected.
+    bool IsSynced() const { return m_synced; }
+
     /// Get the name of the index for display in logs.
     const std::string& GetName() const LIFETIMEBOUND { return m_name; }
 
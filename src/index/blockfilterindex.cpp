@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <cstring>
 #include <map>
 
 #include <dbwrapper.h>
@@ -27,6 +28,10 @@ using node::UndoReadFromDisk;
  * Keys for the height index have the type [DB_BLOCK_HEIGHT, uint32 (BE)]. The height is represented
  * as big-endian so that sequential reads of filters by height are fast.
  * Keys for the hash index have the type [DB_BLOCK_HASH, uint256].
+ *
+ * The block hash, filter hash and header of the blocks of the height index are also stored in the
+ * headers.dat flat file, as fixed size records at the offset of their height. It is flushed before
+ * the database, and is rebuilt from the height index if its record of the best block differs.
  */
 constexpr uint8_t DB_BLOCK_HASH{'s'};
 constexpr uint8_t DB_BLOCK_HEIGHT{'t'};
@@ -41,6 +46,12 @@ constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000; // 1 MiB
  *  is big enough for a 2,000,000 length block chain, which
  *  we should be enough until ~2047. */
 constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
+/** Size of a record of the headers file: the block hash, the filter hash and the filter header */
+constexpr size_t FILTER_HEADERS_RECORD_SIZE{3 * sizeof(uint256)};
+/** The pre-allocation chunk size for the headers file */
+constexpr unsigned int FILTER_HEADERS_CHUNK_SIZE = 0x100000; // 1 MiB
+/** Number of heights the headers file is rebuilt for at a time */
+constexpr int FILTER_HEADERS_REBUILD_BATCH_SIZE{10000};
 
 namespace {
 
@@ -91,6 +102,22 @@ struct DBHashKey {
     }
 };
 
+/** Append the record of a block to the contents of the headers file */
+void AppendHeadersRecord(std::vector<unsigned char>& records, const uint256& block_hash, const DBVal& value)
+{
+    records.insert(records.end(), block_hash.begin(), block_hash.end());
+    records.insert(records.end(), value.hash.begin(), value.hash.end());
+    records.insert(records.end(), value.header.begin(), value.header.end());
+}
+
+/** Get the hash at the given offset of a record of the headers file */
+uint256 ReadHeadersRecordHash(Span<const unsigned char> record, size_t offset)
+{
+    uint256 hash;
+    std::memcpy(hash.begin(), record.data() + offset, hash.size());
+    return hash;
+}
+
 }; // namespace
 
 static std::map<BlockFilterType, BlockFilterIndex> g_filter_indexes;
@@ -107,11 +134,13 @@ BlockFilterIndex::BlockFilterIndex(std::unique_ptr<interfaces::Chain> chain, Blo
     fs::create_directories(path);
 
     m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+    m_headers_path = path / "headers.dat";
     m_filter_fileseq = std::make_unique<FlatFileSeq>(std::move(path), "fltr", FLTR_FILE_CHUNK_SIZE);
 }
 
 bool BlockFilterIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
 {
+    LOCK(m_cs_pending_filters);
     if (!m_db->Read(DB_FILTER_POS, m_next_filter_pos)) {
         // Check that the cause of the read failure is that the key does not exist. Any other errors
         // indicate database corruption or a disk failure, and starting the index would cause
@@ -125,11 +154,127 @@ bool BlockFilterIndex::CustomInit(const std::optional<interfaces::BlockKey>& blo
         m_next_filter_pos.nFile = 0;
         m_next_filter_pos.nPos = 0;
     }
+    InitHeadersFile(block);
     return true;
 }
 
+void BlockFilterIndex::InitHeadersFile(const std::optional<interfaces::BlockKey>& block)
+{
+    LOCK(m_cs_headers_file);
+    m_headers_count = 0;
+    if (!block) return;
+
+    // The records of all heights are valid if the one of the best block is, as the file is
+    // flushed before the best block is committed to the database
+    std::pair<uint256, DBVal> best;
+    if (!m_db->Read(DBHeightKey(block->height), best)) return;
+    {
+        AutoFile file{fsbridge::fopen(m_headers_path, "rb")};
+        if (!file.IsNull() && fseek(file.Get(), block->height * FILTER_HEADERS_RECORD_SIZE, SEEK_SET) == 0) {
+            try {
+                uint256 block_hash, filter_hash, header;
+                file >> block_hash >> filter_hash >> header;
+                if (block_hash == block->hash && filter_hash == best.second.hash && header == best.second.header) {
+                    m_headers_count = block->height + 1;
+                    return;
+                }
+            } catch (const std::ios_base::failure&) {
+                // The file is shorter, and is rebuilt below
+            }
+        }
+    }
+
+    // Failing to rebuild it is not fatal, as lookups fall back to the database
+    LogPrintf("%s: Rebuilding the headers file of %s up to height %d\n", __func__, GetName(), block->height);
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBHeightKey key(0);
+    db_it->Seek(key);
+    std::vector<unsigned char> records;
+    for (int height = 0; height <= block->height; ++height) {
+        std::pair<uint256, DBVal> value;
+        if (!db_it->Valid() || !db_it->GetKey(key) || key.height != height || !db_it->GetValue(value)) {
+            LogPrintf("%s: Unable to read %s at height %d, the headers file is not used\n", __func__, GetName(), height);
+            return;
+        }
+        AppendHeadersRecord(records, value.first, value.second);
+        if (height == block->height || records.size() == FILTER_HEADERS_REBUILD_BATCH_SIZE * FILTER_HEADERS_RECORD_SIZE) {
+            if (!WriteHeaders(m_headers_count, records)) return;
+            records.clear();
+        }
+        db_it->Next();
+    }
+}
+
+bool BlockFilterIndex::WriteHeaders(int start_height, Span<const unsigned char> records)
+{
+    // The records must follow the ones of the indexed chain
+    if (start_height > m_headers_count) return false;
+
+    FILE* headers_file{fsbridge::fopen(m_headers_path, "rb+")};
+    if (!headers_file) headers_file = fsbridge::fopen(m_headers_path, "wb+");
+    AutoFile file{headers_file};
+    if (file.IsNull()) {
+        return error("%s: Failed to open headers file of %s", __func__, GetName());
+    }
+
+    // Pre-allocate the file in chunks, so that it is mapped again only once it grows by a chunk
+    const size_t start_pos{static_cast<size_t>(start_height) * FILTER_HEADERS_RECORD_SIZE};
+    const size_t end_pos{start_pos + records.size()};
+    if (fseek(file.Get(), 0, SEEK_END) != 0) {
+        return error("%s: Failed to seek in headers file of %s", __func__, GetName());
+    }
+    const long file_size{ftell(file.Get())};
+    if (file_size < 0) {
+        return error("%s: Failed to get size of headers file of %s", __func__, GetName());
+    }
+    if (end_pos > static_cast<size_t>(file_size)) {
+        const size_t alloc_size{(end_pos - static_cast<size_t>(file_size) + FILTER_HEADERS_CHUNK_SIZE - 1) / FILTER_HEADERS_CHUNK_SIZE * FILTER_HEADERS_CHUNK_SIZE};
+        AllocateFileRange(file.Get(), file_size, alloc_size);
+    }
+
+    try {
+        if (fseek(file.Get(), start_pos, SEEK_SET) != 0) {
+            return error("%s: Failed to seek in headers file of %s", __func__, GetName());
+        }
+        file.write(AsBytes(records));
+    } catch (const std::ios_base::failure& e) {
+        return error("%s: Failed to write headers file of %s: %s", __func__, GetName(), e.what());
+    }
+    if (fflush(file.Get()) != 0) {
+        return error("%s: Failed to write headers file of %s", __func__, GetName());
+    }
+    m_headers_count = start_height + records.size() / FILTER_HEADERS_RECORD_SIZE;
+    return true;
+}
+
+std::shared_ptr<const FlatFileMapping> BlockFilterIndex::MapHeaders(int start_height, const CBlockIndex* stop_index,
+                                                                    Span<const unsigned char>& records) const
+{
+    if (start_height < 0 || start_height > stop_index->nHeight || stop_index->nHeight >= m_headers_count) {
+        return nullptr;
+    }
+    const size_t start_pos{static_cast<size_t>(start_height) * FILTER_HEADERS_RECORD_SIZE};
+    const size_t end_pos{static_cast<size_t>(stop_index->nHeight + 1) * FILTER_HEADERS_RECORD_SIZE};
+    auto mapping{m_headers_mapping.Get(m_headers_path, end_pos)};
+    if (!mapping) return nullptr;
+
+    // The records form a chain, so they belong to the chain of stop_index if the last one does
+    const Span<const unsigned char> data{mapping->Data()};
+    if (ReadHeadersRecordHash(data.subspan(end_pos - FILTER_HEADERS_RECORD_SIZE), 0) != stop_index->GetBlockHash()) {
+        return nullptr;
+    }
+    records = data.subspan(start_pos, end_pos - start_pos);
+    return mapping;
+}
+
 bool BlockFilterIndex::CustomCommit(CDBBatch& batch)
 {
+    LOCK(m_cs_pending_filters);
+    // The best block is committed along with this, so its filter must be written
+    if (!WritePendingFilters()) {
+        return error("%s: Failed to write pending %s filters", __func__, GetName());
+    }
+
     const FlatFilePos& pos = m_next_filter_pos;
 
     // Flush current filter file to disk.
@@ -141,6 +286,17 @@ bool BlockFilterIndex::CustomCommit(CDBBatch& batch)
         return error("%s: Failed to commit filter file %d", __func__, pos.nFile);
     }
 
+    // Records of the best block must be on disk before it is committed
+    {
+        LOCK(m_cs_headers_file);
+        if (m_headers_count > 0) {
+            AutoFile headers_file{fsbridge::fopen(m_headers_path, "rb+")};
+            if (headers_file.IsNull() || !FileCommit(headers_file.Get())) {
+                return error("%s: Failed to commit headers file of %s", __func__, GetName());
+            }
+        }
+    }
+
     batch.Write(DB_FILTER_POS, pos);
     return true;
 }
@@ -217,8 +373,8 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
 
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
+    LOCK(m_cs_pending_filters);
     CBlockUndo block_undo;
-    uint256 prev_header;
 
     if (block.height > 0) {
         // pindex variable gives indexing code access to node internals. It
@@ -228,36 +384,92 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
             return false;
         }
 
-        std::pair<uint256, DBVal> read_out;
-        if (!m_db->Read(DBHeightKey(block.height - 1), read_out)) {
-            return false;
-        }
-
         uint256 expected_block_hash = *Assert(block.prev_hash);
-        if (read_out.first != expected_block_hash) {
-            return error("%s: previous block header belongs to unexpected block %s; expected %s",
-                         __func__, read_out.first.ToString(), expected_block_hash.ToString());
+        if (!m_pending_blocks.empty()) {
+            const uint256 pending_block_hash{m_pending_blocks.back().GetHash()};
+            if (pending_block_hash != expected_block_hash) {
+                return error("%s: previous pending block %s is unexpected; expected %s",
+                             __func__, pending_block_hash.ToString(), expected_block_hash.ToString());
+            }
+        } else {
+            std::pair<uint256, DBVal> read_out;
+            if (!m_db->Read(DBHeightKey(block.height - 1), read_out)) {
+                return false;
+            }
+
+            if (read_out.first != expected_block_hash) {
+                return error("%s: previous block header belongs to unexpected block %s; expected %s",
+                             __func__, read_out.first.ToString(), expected_block_hash.ToString());
+            }
+
+            m_pending_prev_header = read_out.second.header;
         }
-
-        prev_header = read_out.second.header;
+    } else if (m_pending_blocks.empty()) {
+        m_pending_prev_header.SetNull();
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
+    if (m_pending_blocks.empty()) m_pending_height = block.height;
+    m_pending_blocks.push_back(*Assert(block.data));
+    m_pending_undos.push_back(std::move(block_undo));
+
+    // While syncing, filters are constructed a batch at a time. Once in sync,
+    // the filter of each new block is written right away.
+    if (!IsSynced() && m_pending_blocks.size() < FILTER_CONSTRUCTION_BATCH_SIZE) return true;
+    return WritePendingFilters();
+}
+
+bool BlockFilterIndex::WritePendingFilters()
+{
+    if (m_pending_blocks.empty()) return true;
 
-    size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
-    if (bytes_written == 0) return false;
+    std::vector<BlockFilter> filters{ConstructBlockFilters(m_filter_type, m_pending_blocks, m_pending_undos, GetNumCores())};
 
-    std::pair<uint256, DBVal> value;
-    value.first = block.hash;
-    value.second.hash = filter.GetHash();
-    value.second.header = filter.ComputeHeader(prev_header);
-    value.second.pos = m_next_filter_pos;
+    // Filter headers commit to the previous header, so filters are written in order
+    std::vector<unsigned char> records;
+    records.reserve(filters.size() * FILTER_HEADERS_RECORD_SIZE);
+    uint256 prev_header{m_pending_prev_header};
+    for (size_t i = 0; i < filters.size(); ++i) {
+        const BlockFilter& filter{filters[i]};
+        size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
+        if (bytes_written == 0) return false;
 
-    if (!m_db->Write(DBHeightKey(block.height), value)) {
-        return false;
+        std::pair<uint256, DBVal> value;
+        value.first = filter.GetBlockHash();
+        value.second.hash = filter.GetHash();
+        value.second.header = filter.ComputeHeader(prev_header);
+        value.second.pos = m_next_filter_pos;
+
+        if (!m_db->Write(DBHeightKey(m_pending_height + i), value)) {
+            return false;
+        }
+
+        m_next_filter_pos.nPos += bytes_written;
+        prev_header = value.second.header;
+        AppendHeadersRecord(records, value.first, value.second);
+    }
+
+    {
+        LOCK(m_cs_headers_file);
+        // Lookups fall back to the database for the heights the file misses
+        WriteHeaders(m_pending_height, records);
+    }
+
+    // Once in sync, the filters of new blocks are the ones light clients ask for the most
+    if (IsSynced()) {
+        LOCK(m_cs_recent_filters);
+        for (BlockFilter& filter : filters) {
+            const uint256 block_hash{filter.GetBlockHash()};
+            if (!m_recent_filters.emplace(block_hash, std::move(filter)).second) continue;
+            m_recent_filters_order.push_back(block_hash);
+            if (m_recent_filters_order.size() > RECENT_FILTERS_CACHE_SIZE) {
+                m_recent_filters.erase(m_recent_filters_order.front());
+                m_recent_filters_order.pop_front();
+            }
+        }
     }
 
-    m_next_filter_pos.nPos += bytes_written;
+    m_pending_blocks.clear();
+    m_pending_undos.clear();
     return true;
 }
 
@@ -289,6 +501,10 @@ static bool CopyHeightIndexToHashIndex(CDBIterator& db_it, CDBBatch& batch,
 
 bool BlockFilterIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
 {
+    LOCK(m_cs_pending_filters);
+    // The filters of the disconnected blocks are copied below, so they must be written first
+    if (!WritePendingFilters()) return false;
+
     CDBBatch batch(*m_db);
     std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
 
@@ -299,6 +515,12 @@ bool BlockFilterIndex::CustomRewind(const interfaces::BlockKey& current_tip, con
         return false;
     }
 
+    {
+        // The records of the disconnected blocks get overwritten as new blocks are connected
+        LOCK(m_cs_headers_file);
+        m_headers_count = std::min(m_headers_count, new_tip.height + 1);
+    }
+
     // The latest filter position gets written in Commit by the call to the BaseIndex::Rewind.
     // But since this creates new references to the filter, the position should get updated here
     // atomically as well in case Commit fails.
@@ -383,6 +605,15 @@ static bool LookupRange(CDBWrapper& db, const std::string& index_name, int start
 
 bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const
 {
+    {
+        LOCK(m_cs_recent_filters);
+        auto it{m_recent_filters.find(block_index->GetBlockHash())};
+        if (it != m_recent_filters.end()) {
+            filter_out = it->second;
+            return true;
+        }
+    }
+
     DBVal entry;
     if (!LookupOne(*m_db, block_index, entry)) {
         return false;
@@ -393,6 +624,15 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter&
 
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out)
 {
+    {
+        LOCK(m_cs_headers_file);
+        Span<const unsigned char> record;
+        if (auto mapping{MapHeaders(block_index->nHeight, block_index, record)}) {
+            header_out = ReadHeadersRecordHash(record, 2 * sizeof(uint256));
+            return true;
+        }
+    }
+
     LOCK(m_cs_headers_cache);
 
     bool is_checkpoint{block_index->nHeight % CFCHECKPT_INTERVAL == 0};
@@ -424,6 +664,19 @@ bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint25
 bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* stop_index,
                                          std::vector<BlockFilter>& filters_out) const
 {
+    if (start_height >= 0 && start_height <= stop_index->nHeight) {
+        // Serve the range from the recent filters if it is entirely cached
+        LOCK(m_cs_recent_filters);
+        filters_out.resize(stop_index->nHeight - start_height + 1);
+        const CBlockIndex* block_index{stop_index};
+        for (; block_index && block_index->nHeight >= start_height; block_index = block_index->pprev) {
+            auto it{m_recent_filters.find(block_index->GetBlockHash())};
+            if (it == m_recent_filters.end()) break;
+            filters_out[block_index->nHeight - start_height] = it->second;
+        }
+        if (!block_index || block_index->nHeight < start_height) return true;
+    }
+
     std::vector<DBVal> entries;
     if (!LookupRange(*m_db, m_name, start_height, stop_index, entries)) {
         return false;
@@ -445,6 +698,18 @@ bool BlockFilterIndex::LookupFilterHashRange(int start_height, const CBlockIndex
                                              std::vector<uint256>& hashes_out) const
 
 {
+    {
+        LOCK(m_cs_headers_file);
+        Span<const unsigned char> records;
+        if (auto mapping{MapHeaders(start_height, stop_index, records)}) {
+            hashes_out.resize(records.size() / FILTER_HEADERS_RECORD_SIZE);
+            for (size_t i = 0; i < hashes_out.size(); ++i) {
+                hashes_out[i] = ReadHeadersRecordHash(records.subspan(i * FILTER_HEADERS_RECORD_SIZE), sizeof(uint256));
+            }
+            return true;
+        }
+    }
+
     std::vector<DBVal> entries;
     if (!LookupRange(*m_db, m_name, start_height, stop_index, entries)) {
         return false;
@@ -12,9 +12,17 @@
 #include <index/base.h>
 #include <util/hasher.h>
 
+#include <deque>
+
 /** Interval between compact filter checkpoints. See BIP 157. */
 static constexpr int CFCHECKPT_INTERVAL = 1000;
 
+/** Number of blocks whose filters are constructed together while the index syncs */
+static constexpr size_t FILTER_CONSTRUCTION_BATCH_SIZE = 64;
+
+/** Number of the most recent blocks whose filters are kept in memory to answer getcfilters */
+static constexpr size_t RECENT_FILTERS_CACHE_SIZE = 288;
+
 /**
  * BlockFilterIndex is used to store and retrieve block filters, hashes, and headers for a range of
  * blocks by height. An index is constructed for each supported filter type with its own database
@@ -28,26 +36,66 @@ private:
     BlockFilterType m_filter_type;
     std::unique_ptr<BaseIndex::DB> m_db;
 
-    FlatFilePos m_next_filter_pos;
+    Mutex m_cs_pending_filters;
+    FlatFilePos m_next_filter_pos GUARDED_BY(m_cs_pending_filters);
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
+    /** Blocks appended while syncing whose filters are yet to be constructed and written */
+    std::vector<CBlock> m_pending_blocks GUARDED_BY(m_cs_pending_filters);
+    std::vector<CBlockUndo> m_pending_undos GUARDED_BY(m_cs_pending_filters);
+    /** Height of the first pending block */
+    int m_pending_height GUARDED_BY(m_cs_pending_filters){0};
+    /** Header of the filter preceding the first pending block */
+    uint256 m_pending_prev_header GUARDED_BY(m_cs_pending_filters);
+
     bool ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const;
     size_t WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter);
 
+    /** Construct the filters of the pending blocks in parallel and write them in order */
+    bool WritePendingFilters() EXCLUSIVE_LOCKS_REQUIRED(m_cs_pending_filters, !m_cs_headers_file, !m_cs_recent_filters);
+
     Mutex m_cs_headers_cache;
     /** cache of block hash to filter header, to avoid disk access when responding to getcfcheckpt. */
     std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
 
+    /**
+     * The block hash, filter hash and filter header of every block of the indexed chain are also
+     * stored by height in a flat file, which is read through a memory mapping to answer
+     * getcfheaders and getcfcheckpt without database lookups. Records beyond m_headers_count are
+     * stale or preallocated.
+     */
+    fs::path m_headers_path;
+    mutable FlatFileMappingCache m_headers_mapping{1};
+    mutable Mutex m_cs_headers_file;
+    int m_headers_count GUARDED_BY(m_cs_headers_file){0};
+
+    /** Validate the headers file against the database, rebuilding it if they differ */
+    void InitHeadersFile(const std::optional<interfaces::BlockKey>& block) EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_file);
+    /** Write the records of consecutive blocks to the headers file, starting at the given height */
+    bool WriteHeaders(int start_height, Span<const unsigned char> records) EXCLUSIVE_LOCKS_REQUIRED(m_cs_headers_file);
+    /**
+     * Get the records of the heights from start_height to the height of stop_index from the
+     * headers file, if they belong to the chain of stop_index. The records stay valid while the
+     * returned mapping is held.
+     */
+    std::shared_ptr<const FlatFileMapping> MapHeaders(int start_height, const CBlockIndex* stop_index,
+                                                      Span<const unsigned char>& records) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_headers_file);
+
+    mutable Mutex m_cs_recent_filters;
+    /** Filters of the most recently connected blocks, in the order they were connected */
+    std::unordered_map<uint256, BlockFilter, FilterHeaderHasher> m_recent_filters GUARDED_BY(m_cs_recent_filters);
+    std::deque<uint256> m_recent_filters_order GUARDED_BY(m_cs_recent_filters);
+
     bool AllowPrune() const override { return true; }
 
 protected:
-    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_cs_pending_filters, !m_cs_headers_file);
 
-    bool CustomCommit(CDBBatch& batch) override;
+    bool CustomCommit(CDBBatch& batch) override EXCLUSIVE_LOCKS_REQUIRED(!m_cs_pending_filters, !m_cs_headers_file);
 
-    bool CustomAppend(const interfaces::BlockInfo& block) override;
+    bool CustomAppend(const interfaces::BlockInfo& block) override EXCLUSIVE_LOCKS_REQUIRED(!m_cs_pending_filters, !m_cs_headers_file, !m_cs_recent_filters);
 
-    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override EXCLUSIVE_LOCKS_REQUIRED(!m_cs_pending_filters, !m_cs_headers_file, !m_cs_recent_filters);
 
     BaseIndex::DB& GetDB() const LIFETIMEBOUND override { return *m_db; }
 
@@ -59,18 +107,18 @@ public:
     BlockFilterType GetFilterType() const { return m_filter_type; }
 
     /** Get a single filter by block. */
-    bool LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const;
+    bool LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const EXCLUSIVE_LOCKS_REQUIRED(!m_cs_recent_filters);
 
     /** Get a single filter header by block. */
-    bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_cache);
+    bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_cache, !m_cs_headers_file);
 
     /** Get a range of filters between two heights on a chain. */
     bool LookupFilterRange(int start_height, const CBlockIndex* stop_index,
-                           std::vector<BlockFilter>& filters_out) const;
+                           std::vector<BlockFilter>& filters_out) const EXCLUSIVE_LOCKS_REQUIRED(!m_cs_recent_filters);
 
     /** Get a range of filter hashes between two heights on a chain. */
     bool LookupFilterHashRange(int start_height, const CBlockIndex* stop_index,
-                               std::vector<uint256>& hashes_out) const;
+                               std::vector<uint256>& hashes_out) const EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_file);
 };
 
 /**
@@ -0,0 +1,200 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockreader.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/syscall_sandbox.h>
+#include <util/thread.h>
+#include <validation.h>
+
+#include <condition_variable>
+#include <map>
+#include <thread>
+#include <utility>
+
+using node::ReadBlockFromDisk;
+
+/** Reads blocks for the IndexBlockReaders of a chainstate on a background thread */
+class SharedBlockReader
+{
+private:
+    Chainstate& m_chainstate;
+    const int m_read_ahead;
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    //! Last block requested by each reader
+    std::map<const IndexBlockReader*, const CBlockIndex*> m_requests GUARDED_BY(m_mutex);
+    //! Blocks read from disk, with their height. Null if the block could not be read.
+    std::map<uint256, std::pair<int, std::shared_ptr<const CBlock>>> m_blocks GUARDED_BY(m_mutex);
+    //! Highest block read, from which the active chain is read ahead
+    const CBlockIndex* m_read_tip GUARDED_BY(m_mutex){nullptr};
+    //! Incremented whenever the thread may have new work
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+
+    /** Whether a height is too far ahead of the blocks requested by the other readers */
+    bool IsTooFarAhead(const IndexBlockReader* reader, int height) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Drop the blocks below the lowest block requested */
+    void EvictBlocks() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void ThreadRead();
+
+public:
+    SharedBlockReader(Chainstate& chainstate, int read_ahead);
+    ~SharedBlockReader();
+
+    /** Get the reader shared by the indexes syncing against a chainstate, creating it if needed */
+    static std::shared_ptr<SharedBlockReader> Acquire(Chainstate& chainstate);
+
+    std::shared_ptr<const CBlock> Read(const IndexBlockReader* reader, const CBlockIndex& block_index) LOCKS_EXCLUDED(m_mutex);
+    void RemoveReader(const IndexBlockReader* reader) LOCKS_EXCLUDED(m_mutex);
+};
+
+static GlobalMutex g_shared_block_reader_mutex;
+static std::weak_ptr<SharedBlockReader> g_shared_block_reader GUARDED_BY(g_shared_block_reader_mutex);
+
+SharedBlockReader::SharedBlockReader(Chainstate& chainstate, int read_ahead)
+    : m_chainstate(chainstate), m_read_ahead(read_ahead)
+{
+    m_thread = std::thread(&util::TraceThread, "indexread", [this] { ThreadRead(); });
+}
+
+SharedBlockReader::~SharedBlockReader()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+std::shared_ptr<SharedBlockReader> SharedBlockReader::Acquire(Chainstate& chainstate)
+{
+    LOCK(g_shared_block_reader_mutex);
+    std::shared_ptr<SharedBlockReader> shared{g_shared_block_reader.lock()};
+    if (!shared || &shared->m_chainstate != &chainstate) {
+        shared = std::make_shared<SharedBlockReader>(chainstate, DEFAULT_INDEX_READ_AHEAD_BLOCKS);
+        g_shared_block_reader = shared;
+    }
+    return shared;
+}
+
+bool SharedBlockReader::IsTooFarAhead(const IndexBlockReader* reader, int height) const
+{
+    for (const auto& [other, requested] : m_requests) {
+        if (other != reader && height >= requested->nHeight + m_read_ahead) return true;
+    }
+    return false;
+}
+
+void SharedBlockReader::EvictBlocks()
+{
+    if (m_requests.empty()) {
+        m_blocks.clear();
+        m_read_tip = nullptr;
+        return;
+    }
+    int min_height{m_requests.begin()->second->nHeight};
+    for (const auto& [reader, requested] : m_requests) {
+        min_height = std::min(min_height, requested->nHeight);
+    }
+    for (auto it = m_blocks.begin(); it != m_blocks.end();) {
+        it = it->second.first < min_height ? m_blocks.erase(it) : std::next(it);
+    }
+}
+
+std::shared_ptr<const CBlock> SharedBlockReader::Read(const IndexBlockReader* reader, const CBlockIndex& block_index)
+{
+    const uint256 hash{block_index.GetBlockHash()};
+    WAIT_LOCK(m_mutex, lock);
+    // The slowest reader is never held back, so this can't deadlock
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !IsTooFarAhead(reader, block_index.nHeight); });
+
+    m_requests[reader] = &block_index;
+    EvictBlocks();
+    ++m_generation;
+    m_cv.notify_all();
+
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_blocks.count(hash) > 0; });
+    return m_blocks.at(hash).second;
+}
+
+void SharedBlockReader::RemoveReader(const IndexBlockReader* reader)
+{
+    {
+        LOCK(m_mutex);
+        m_requests.erase(reader);
+        EvictBlocks();
+        ++m_generation;
+    }
+    m_cv.notify_all();
+}
+
+void SharedBlockReader::ThreadRead()
+{
+    SetSyscallSandboxPolicy(SyscallSandboxPolicy::TX_INDEX);
+    const auto& consensus_params{Params().GetConsensus()};
+    while (true) {
+        const CBlockIndex* to_read{nullptr};
+        const CBlockIndex* read_tip{nullptr};
+        uint64_t generation;
+        {
+            LOCK(m_mutex);
+            if (m_stop) return;
+            generation = m_generation;
+
+            // Read the blocks that are waited for first
+            for (const auto& [reader, requested] : m_requests) {
+                if (!m_blocks.count(requested->GetBlockHash())) {
+                    to_read = requested;
+                    break;
+                }
+            }
+            if (!to_read && m_read_tip && !IsTooFarAhead(nullptr, m_read_tip->nHeight + 1)) {
+                read_tip = m_read_tip;
+            }
+        }
+
+        // Otherwise read ahead on the active chain, if the read tip is still on it
+        if (read_tip) {
+            LOCK(cs_main);
+            to_read = m_chainstate.m_chain.Next(read_tip);
+        }
+
+        if (!to_read) {
+            WAIT_LOCK(m_mutex, lock);
+            m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || m_generation != generation; });
+            continue;
+        }
+
+        auto block{std::make_shared<CBlock>()};
+        const bool read{ReadBlockFromDisk(*block, to_read, consensus_params)};
+        {
+            LOCK(m_mutex);
+            m_blocks.try_emplace(to_read->GetBlockHash(), to_read->nHeight, read ? std::move(block) : nullptr);
+            if (!m_read_tip || to_read->nHeight > m_read_tip->nHeight) m_read_tip = to_read;
+            ++m_generation;
+        }
+        m_cv.notify_all();
+    }
+}
+
+IndexBlockReader::IndexBlockReader(Chainstate& chainstate)
+    : m_shared(SharedBlockReader::Acquire(chainstate))
+{}
+
+IndexBlockReader::~IndexBlockReader()
+{
+    m_shared->RemoveReader(this);
+}
+
+std::shared_ptr<const CBlock> IndexBlockReader::Read(const CBlockIndex& block_index)
+{
+    return m_shared->Read(this, block_index);
+}
@@ -0,0 +1,45 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BLOCKREADER_H
+#define BITCOIN_INDEX_BLOCKREADER_H
+
+#include <memory>
+
+class CBlock;
+class CBlockIndex;
+class Chainstate;
+class SharedBlockReader;
+
+/** Maximum number of blocks the indexes that are syncing hold in memory, ahead of the slowest one */
+static constexpr int DEFAULT_INDEX_READ_AHEAD_BLOCKS{16};
+
+/**
+ * Reads blocks from disk for an index that is syncing. The blocks are read
+ * and deserialized once on a thread shared by all the indexes syncing against
+ * the same chainstate, which reads ahead of the slowest index. Each index
+ * consumes the blocks at its own pace, but is held back while it is more than
+ * DEFAULT_INDEX_READ_AHEAD_BLOCKS ahead of the slowest one, so that every
+ * block is read only once.
+ */
+class IndexBlockReader
+{
+private:
+    const std::shared_ptr<SharedBlockReader> m_shared;
+
+public:
+    explicit IndexBlockReader(Chainstate& chainstate);
+    ~IndexBlockReader();
+
+    IndexBlockReader(const IndexBlockReader&) = delete;
+    IndexBlockReader& operator=(const IndexBlockReader&) = delete;
+
+    /// Read a block. Blocks must be read in ascending order of height, except
+    /// after a rewind.
+    ///
+    /// @return  the block, or nullptr if it could not be read from disk
+    std::shared_ptr<const CBlock> Read(const CBlockIndex& block_index);
+};
+
+#endif // BITCOIN_INDEX_BLOCKREADER_H
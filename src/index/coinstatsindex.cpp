@@ -8,6 +8,7 @@
 #include <index/coinstatsindex.h>
 #include <kernel/coinstats.h>
 #include <node/blockstorage.h>
+#include <script/standard.h>
 #include <serialize.h>
 #include <txdb.h>
 #include <undo.h>
@@ -43,22 +44,48 @@ struct DBVal {
     CAmount total_unspendables_scripts;
     CAmount total_unspendables_unclaimed_rewards;
 
-    SERIALIZE_METHODS(DBVal, obj)
+    //! Absent for entries written before conversion stats were recorded
+    std::optional<ConversionStats> conversion_stats;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << muhash;
+        s << transaction_output_count;
+        s << bogo_size;
+        s << total_amount_cash;
+        s << total_amount_bond;
+        s << total_subsidy;
+        s << total_unspendable_amount;
+        s << total_prevout_spent_amount;
+        s << total_new_outputs_ex_coinbase_amount;
+        s << total_coinbase_amount;
+        s << total_unspendables_genesis_block;
+        s << total_unspendables_bip30;
+        s << total_unspendables_scripts;
+        s << total_unspendables_unclaimed_rewards;
+        if (conversion_stats) s << *conversion_stats;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
     {
-        READWRITE(obj.muhash);
-        READWRITE(obj.transaction_output_count);
-        READWRITE(obj.bogo_size);
-        READWRITE(obj.total_amount_cash);
-        READWRITE(obj.total_amount_bond);
-        READWRITE(obj.total_subsidy);
-        READWRITE(obj.total_unspendable_amount);
-        READWRITE(obj.total_prevout_spent_amount);
-        READWRITE(obj.total_new_outputs_ex_coinbase_amount);
-        READWRITE(obj.total_coinbase_amount);
-        READWRITE(obj.total_unspendables_genesis_block);
-        READWRITE(obj.total_unspendables_bip30);
-        READWRITE(obj.total_unspendables_scripts);
-        READWRITE(obj.total_unspendables_unclaimed_rewards);
+        s >> muhash;
+        s >> transaction_output_count;
+        s >> bogo_size;
+        s >> total_amount_cash;
+        s >> total_amount_bond;
+        s >> total_subsidy;
+        s >> total_unspendable_amount;
+        s >> total_prevout_spent_amount;
+        s >> total_new_outputs_ex_coinbase_amount;
+        s >> total_coinbase_amount;
+        s >> total_unspendables_genesis_block;
+        s >> total_unspendables_bip30;
+        s >> total_unspendables_scripts;
+        s >> total_unspendables_unclaimed_rewards;
+        conversion_stats.reset();
+        if (!s.empty()) s >> conversion_stats.emplace();
     }
 };
 
@@ -106,6 +133,37 @@ struct DBHashKey {
 
 std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
 
+void ConversionStats::AddConversion(const CAmounts& inputs, const CAmounts& outputs, CAmountType remainder_type, CAmount remainder, bool has_destination)
+{
+    ++conversion_count;
+    for (const CAmountType type : {CASH, BOND}) {
+        const CAmount created{outputs[type] - inputs[type] + (type == remainder_type ? remainder : 0)};
+        if (created < 0) {
+            amount_in[type] -= created;
+        } else {
+            amount_out[type] += created;
+        }
+    }
+    if (has_destination) {
+        remainder_to_destination[remainder_type] += remainder;
+    } else {
+        remainder_to_miner[remainder_type] += remainder;
+    }
+}
+
+ConversionStats& ConversionStats::operator-=(const ConversionStats& other)
+{
+    conversion_count -= other.conversion_count;
+    for (const CAmountType type : {CASH, BOND}) {
+        amount_in[type] -= other.amount_in[type];
+        amount_out[type] -= other.amount_out[type];
+        remainder_to_destination[type] -= other.remainder_to_destination[type];
+        remainder_to_miner[type] -= other.remainder_to_miner[type];
+        interest_accrued[type] -= other.interest_accrued[type];
+    }
+    return *this;
+}
+
 CoinStatsIndex::CoinStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
     : BaseIndex(std::move(chain), "coinstatsindex")
 {
@@ -146,6 +204,23 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
             }
         }
 
+        // Replay the block's conversions on the parent's supply to recover
+        // their remainders
+        const CAmounts prev_supply{pindex->pprev->GetTotalSupply()};
+        const auto conversions{ReplayBlockConversions(*block.data, block_undo, prev_supply)};
+        if (!conversions) {
+            return error("%s: %s in block %s", __func__, util::ErrorString(conversions).original, block.hash.ToString());
+        }
+        for (const BlockConversion& conversion : *conversions) {
+            m_conversion_stats.AddConversion(conversion.inputs, block.data->vtx[conversion.tx_index]->GetValuesOut(), conversion.info.remainderType,
+                                             conversion.remainder, conversion.remainder > 0 && IsValidDestination(conversion.info.destination));
+        }
+
+        // The scaled value of the parent's supply grows with the scale factor
+        for (const CAmountType type : {CASH, BOND}) {
+            m_conversion_stats.interest_accrued[type] += ScaleAmount(prev_supply[type], pindex->scaleFactor) - ScaleAmount(prev_supply[type], pindex->pprev->scaleFactor);
+        }
+
         // TODO: Deduplicate BIP30 related code
         bool is_bip30_block{(block.height == 91722 && block.hash == uint256S("0x00000000000271a2dc26e7667f8419f2e15416dc6955e5a6c6cdf3f2574dd08e")) ||
                             (block.height == 91812 && block.hash == uint256S("0x00000000000af0aed4792b1acee3d966af36cf5def14935db8de83d6f9306f2f"))};
@@ -234,6 +309,7 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
     value.second.total_unspendables_bip30 = m_total_unspendables_bip30;
     value.second.total_unspendables_scripts = m_total_unspendables_scripts;
     value.second.total_unspendables_unclaimed_rewards = m_total_unspendables_unclaimed_rewards;
+    value.second.conversion_stats = m_conversion_stats;
 
     uint256 out;
     m_muhash.Finalize(out);
@@ -354,6 +430,15 @@ std::optional<CCoinsStats> CoinStatsIndex::LookUpStats(const CBlockIndex& block_
     return stats;
 }
 
+std::optional<ConversionStats> CoinStatsIndex::LookUpConversionStats(const CBlockIndex& block_index) const
+{
+    DBVal entry;
+    if (!LookUpOne(*m_db, {block_index.GetBlockHash(), block_index.nHeight}, entry)) {
+        return std::nullopt;
+    }
+    return entry.conversion_stats;
+}
+
 bool CoinStatsIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
 {
     if (!m_db->Read(DB_MUHASH, m_muhash)) {
@@ -393,6 +478,8 @@ bool CoinStatsIndex::CustomInit(const std::optional<interfaces::BlockKey>& block
         m_total_unspendables_bip30 = entry.total_unspendables_bip30;
         m_total_unspendables_scripts = entry.total_unspendables_scripts;
         m_total_unspendables_unclaimed_rewards = entry.total_unspendables_unclaimed_rewards;
+        // Entries from before conversion stats were recorded start the sums at zero
+        m_conversion_stats = entry.conversion_stats.value_or(ConversionStats{});
     }
 
     return true;
@@ -508,5 +595,8 @@ bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex
     Assert(m_total_unspendables_scripts == read_out.second.total_unspendables_scripts);
     Assert(m_total_unspendables_unclaimed_rewards == read_out.second.total_unspendables_unclaimed_rewards);
 
+    // Conversion stats are prefix sums, so restore them from the parent's entry
+    m_conversion_stats = read_out.second.conversion_stats.value_or(ConversionStats{});
+
     return true;
 }
@@ -5,8 +5,10 @@
 #ifndef BITCOIN_INDEX_COINSTATSINDEX_H
 #define BITCOIN_INDEX_COINSTATSINDEX_H
 
+#include <consensus/amount.h>
 #include <crypto/muhash.h>
 #include <index/base.h>
+#include <serialize.h>
 
 class CBlockIndex;
 class CDBBatch;
@@ -14,6 +16,39 @@ namespace kernel {
 struct CCoinsStats;
 }
 
+/**
+ * Cumulative conversion statistics from the genesis block up to and including
+ * a block. Subtracting the statistics of two blocks gives the statistics of
+ * the range between them.
+ */
+struct ConversionStats {
+    //! Number of conversions
+    uint64_t conversion_count{0};
+    //! Amount converted away, indexed by the currency converted from
+    CAmounts amount_in{{0}};
+    //! Amount received, indexed by the currency converted to
+    CAmounts amount_out{{0}};
+    //! Conversion remainders paid to the remainder destination
+    CAmounts remainder_to_destination{{0}};
+    //! Conversion remainders without a destination, which go to the miner
+    CAmounts remainder_to_miner{{0}};
+    //! Growth of the scaled value of the total supply through the scale factor
+    CAmounts interest_accrued{{0}};
+
+    /** Account for a conversion, given its input and output amounts in each currency and its remainder */
+    void AddConversion(const CAmounts& inputs, const CAmounts& outputs, CAmountType remainder_type, CAmount remainder, bool has_destination);
+
+    ConversionStats& operator-=(const ConversionStats& other);
+
+    SERIALIZE_METHODS(ConversionStats, obj)
+    {
+        READWRITE(obj.conversion_count);
+        for (size_t i = 0; i < 2; ++i) {
+            READWRITE(obj.amount_in[i], obj.amount_out[i], obj.remainder_to_destination[i], obj.remainder_to_miner[i], obj.interest_accrued[i]);
+        }
+    }
+};
+
 /**
  * CoinStatsIndex maintains statistics on the UTXO set.
  */
@@ -35,6 +70,7 @@ private:
     CAmount m_total_unspendables_bip30{0};
     CAmount m_total_unspendables_scripts{0};
     CAmount m_total_unspendables_unclaimed_rewards{0};
+    ConversionStats m_conversion_stats;
 
     bool ReverseBlock(const CBlock& block, const CBlockIndex* pindex);
 
@@ -57,6 +93,10 @@ public:
 
     // Look up stats for a specific block using CBlockIndex
     std::optional<kernel::CCoinsStats> LookUpStats(const CBlockIndex& block_index) const;
+
+    // Look up the cumulative conversion stats for a specific block. Returns
+    // std::nullopt for blocks indexed before conversion stats were recorded.
+    std::optional<ConversionStats> LookUpConversionStats(const CBlockIndex& block_index) const;
 };
 
 /// The global UTXO set hash object.
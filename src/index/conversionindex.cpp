@@ -0,0 +1,197 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/conversionindex.h>
+
+#include <chain.h>
+#include <hash.h>
+#include <node/blockstorage.h>
+#include <script/standard.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+using node::UndoReadFromDisk;
+
+constexpr uint8_t DB_CONVERSION{'c'};
+constexpr uint8_t DB_DESTINATION{'d'};
+
+std::unique_ptr<ConversionIndex> g_conversion_index;
+
+namespace {
+
+/** Key of a conversion under the script its remainder was paid to, ordered by height */
+struct DBDestinationKey {
+    uint256 script_hash;
+    int height;
+    uint256 tx_hash;
+
+    DBDestinationKey() : height(0) {}
+    DBDestinationKey(const uint256& script_hash_in, int height_in, const uint256& tx_hash_in) :
+        script_hash(script_hash_in), height(height_in), tx_hash(tx_hash_in) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_DESTINATION);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        s << tx_hash;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_DESTINATION) {
+            throw std::ios_base::failure("Invalid format for conversionindex DB destination key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        s >> tx_hash;
+    }
+};
+
+uint256 RemainderScriptHash(const CScript& script)
+{
+    return Hash(script);
+}
+
+/**
+ * Find the coinbase output paying a remainder. The miner appends the remainder
+ * outputs in block order, so the expected position is tried first. Consensus
+ * only requires the coinbase to pay the destination the total of its
+ * remainders though, so fall back to the first output paying the script.
+ */
+int32_t FindRemainderOutput(const CTransaction& coinbase, size_t expected_pos, CAmountType remainder_type, CAmount remainder, const CScript& script)
+{
+    if (expected_pos < coinbase.vout.size()) {
+        const CTxOut& txout{coinbase.vout[expected_pos]};
+        if (txout.amountType == remainder_type && txout.nValue == remainder && txout.scriptPubKey == script) {
+            return expected_pos;
+        }
+    }
+    for (size_t i = 0; i < coinbase.vout.size(); ++i) {
+        const CTxOut& txout{coinbase.vout[i]};
+        if (txout.amountType == remainder_type && txout.scriptPubKey == script) return i;
+    }
+    return -1;
+}
+
+} // namespace
+
+/** Access to the conversion index database (indexes/conversionindex/) */
+class ConversionIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the entry of the conversion with the given hash. Returns false if
+    /// the transaction hash is not indexed.
+    bool ReadConversion(const uint256& tx_hash, ConversionIndexEntry& entry) const;
+
+    /// Write a batch of conversion entries to the DB, keyed by transaction
+    /// hash and by remainder script.
+    bool WriteConversions(const std::vector<std::pair<uint256, ConversionIndexEntry>>& v_entries);
+};
+
+ConversionIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "conversionindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool ConversionIndex::DB::ReadConversion(const uint256& tx_hash, ConversionIndexEntry& entry) const
+{
+    return Read(std::make_pair(DB_CONVERSION, tx_hash), entry);
+}
+
+bool ConversionIndex::DB::WriteConversions(const std::vector<std::pair<uint256, ConversionIndexEntry>>& v_entries)
+{
+    CDBBatch batch(*this);
+    for (const auto& [tx_hash, entry] : v_entries) {
+        batch.Write(std::make_pair(DB_CONVERSION, tx_hash), entry);
+        if (!entry.remainder_script.empty()) {
+            batch.Write(DBDestinationKey(RemainderScriptHash(entry.remainder_script), entry.height, tx_hash), entry);
+        }
+    }
+    return WriteBatch(batch);
+}
+
+ConversionIndex::ConversionIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "conversionindex"), m_db(std::make_unique<ConversionIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+ConversionIndex::~ConversionIndex() = default;
+
+bool ConversionIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // The genesis block contains no conversions
+    if (block.height == 0) return true;
+
+    assert(block.data);
+    const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+
+    const auto conversions{ReplayBlockConversions(*block.data, block_undo, pindex->pprev->GetTotalSupply())};
+    if (!conversions) {
+        return error("%s: %s in block %s", __func__, util::ErrorString(conversions).original, block.hash.ToString());
+    }
+    std::vector<std::pair<uint256, ConversionIndexEntry>> v_entries;
+    for (const BlockConversion& conversion : *conversions) {
+        ConversionIndexEntry entry;
+        entry.block_hash = block.hash;
+        entry.height = block.height;
+        entry.remainder_type = conversion.info.remainderType;
+        entry.remainder = conversion.remainder;
+        // Remainders without a destination are added to the miner fees
+        if (entry.remainder > 0 && IsValidDestination(conversion.info.destination)) {
+            entry.remainder_script = GetScriptForDestination(conversion.info.destination);
+        }
+        v_entries.emplace_back(block.data->vtx[conversion.tx_index]->GetHash(), std::move(entry));
+    }
+    if (v_entries.empty()) return true;
+
+    // Locate the remainder outputs, which follow the coinbase's other outputs
+    const CTransaction& coinbase{*block.data->vtx[0]};
+    size_t n_remainder_outputs{0};
+    for (const auto& [tx_hash, entry] : v_entries) {
+        if (!entry.remainder_script.empty()) ++n_remainder_outputs;
+    }
+    size_t expected_pos{coinbase.vout.size() - std::min(n_remainder_outputs, coinbase.vout.size())};
+    for (auto& [tx_hash, entry] : v_entries) {
+        if (entry.remainder_script.empty()) continue;
+        entry.coinbase_vout = FindRemainderOutput(coinbase, expected_pos++, entry.remainder_type, entry.remainder, entry.remainder_script);
+    }
+    return m_db->WriteConversions(v_entries);
+}
+
+BaseIndex::DB& ConversionIndex::GetDB() const { return *m_db; }
+
+bool ConversionIndex::FindConversion(const uint256& tx_hash, ConversionIndexEntry& entry) const
+{
+    return m_db->ReadConversion(tx_hash, entry);
+}
+
+std::vector<std::pair<uint256, ConversionIndexEntry>> ConversionIndex::FindConversionsByDestination(const CScript& remainder_script) const
+{
+    std::vector<std::pair<uint256, ConversionIndexEntry>> result;
+    const uint256 script_hash{RemainderScriptHash(remainder_script)};
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(std::make_pair(DB_DESTINATION, script_hash));
+    for (; db_it->Valid(); db_it->Next()) {
+        DBDestinationKey key;
+        if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+
+        ConversionIndexEntry entry;
+        if (!db_it->GetValue(entry)) {
+            error("%s: unable to read value for conversion %s", __func__, key.tx_hash.ToString());
+            break;
+        }
+        result.emplace_back(key.tx_hash, std::move(entry));
+    }
+    return result;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_CONVERSIONINDEX_H
+#define BITCOIN_INDEX_CONVERSIONINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <utility>
+#include <vector>
+
+/** Where a conversion was confirmed and how its remainder was paid */
+struct ConversionIndexEntry {
+    uint256 block_hash;
+    int height{0};
+    //! Currency of the remainder
+    CAmountType remainder_type{CASH};
+    //! Unscaled remainder created by the conversion
+    CAmount remainder{0};
+    //! Script the remainder was paid to. Empty if the remainder went to the miner.
+    CScript remainder_script;
+    //! Position of the remainder output in the coinbase, or -1 if there is none
+    int32_t coinbase_vout{-1};
+
+    SERIALIZE_METHODS(ConversionIndexEntry, obj)
+    {
+        READWRITE(obj.block_hash, obj.height, obj.remainder_type, obj.remainder, obj.remainder_script, obj.coinbase_vout);
+    }
+};
+
+/**
+ * ConversionIndex is used to look up the conversions included in the
+ * blockchain, either by transaction hash or by the script their remainder was
+ * paid to. The index is written to a LevelDB database. Entries of blocks that
+ * were disconnected are not removed, so callers should check that the block
+ * of an entry is in the active chain.
+ */
+class ConversionIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit ConversionIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~ConversionIndex() override;
+
+    /// Look up a conversion by transaction hash.
+    ///
+    /// @param[in]   tx_hash  The hash of the conversion transaction.
+    /// @param[out]  entry  The block and remainder of the conversion.
+    /// @return  true if the conversion is found, false otherwise
+    bool FindConversion(const uint256& tx_hash, ConversionIndexEntry& entry) const;
+
+    /// Look up the conversions whose remainder was paid to a script, in
+    /// ascending order of height.
+    ///
+    /// @param[in]   remainder_script  The script the remainders were paid to.
+    /// @return  the transaction hash and entry of each conversion
+    std::vector<std::pair<uint256, ConversionIndexEntry>> FindConversionsByDestination(const CScript& remainder_script) const;
+};
+
+/// The global conversion index. May be null.
+extern std::unique_ptr<ConversionIndex> g_conversion_index;
+
+#endif // BITCOIN_INDEX_CONVERSIONINDEX_H
@@ -4,17 +4,79 @@
 
 #include <index/txindex.h>
 
+#include <chain.h>
 #include <index/disktxpos.h>
 #include <node/blockstorage.h>
 #include <util/system.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <map>
+
 using node::OpenBlockFile;
 
 constexpr uint8_t DB_TXINDEX{'t'};
+constexpr uint8_t DB_TXINDEX_COMPACT{'x'};
 
 std::unique_ptr<TxIndex> g_txindex;
 
+namespace {
+
+/** Key of the transactions of a block whose hashes start with the same 8 bytes */
+struct DBCompactKey {
+    uint64_t hash_prefix{0};
+    int height{0};
+
+    DBCompactKey() = default;
+    DBCompactKey(uint64_t hash_prefix_in, int height_in) : hash_prefix(hash_prefix_in), height(height_in) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_TXINDEX_COMPACT);
+        ser_writedata64(s, hash_prefix);
+        ser_writedata32be(s, height);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_TXINDEX_COMPACT) {
+            throw std::ios_base::failure("Invalid format for txindex DB key");
+        }
+        hash_prefix = ser_readdata64(s);
+        height = ser_readdata32be(s);
+    }
+};
+
+/** Prefix of the keys of the transactions whose hashes start with the given 8 bytes */
+struct DBCompactPrefix {
+    uint64_t hash_prefix;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_TXINDEX_COMPACT);
+        ser_writedata64(s, hash_prefix);
+    }
+};
+
+/** Offsets of transactions in their block, from the start of the block header */
+struct DBTxOffsets {
+    std::vector<uint32_t> offsets;
+
+    SERIALIZE_METHODS(DBTxOffsets, obj) { READWRITE(Using<VectorFormatter<VarIntFormatter<VarIntMode::DEFAULT>>>(obj.offsets)); }
+};
+
+/** A transaction to be read, and the lookup it may answer */
+struct TxRead {
+    FlatFilePos pos;
+    size_t index;
+    uint256 block_hash;
+};
+
+} // namespace
 
 /** Access to the txindex database (indexes/txindex/) */
 class TxIndex::DB : public BaseIndex::DB
@@ -22,28 +84,78 @@ class TxIndex::DB : public BaseIndex::DB
 public:
     explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
 
-    /// Read the disk location of the transaction data with the given hash. Returns false if the
-    /// transaction hash is not indexed.
-    bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
+    /// Read the heights of the blocks and the offsets of the transactions
+    /// whose hashes start with the same 8 bytes as the given hash.
+    std::vector<std::pair<int, uint32_t>> ReadTxCandidates(const uint256& txid);
 
-    /// Write a batch of transaction positions to the DB.
-    bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
+    /// Read a transaction indexed in the format keyed by the full hash.
+    /// Returns false if the transaction hash is not indexed so.
+    bool ReadLegacyTx(const uint256& txid, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Write the offsets of the transactions of a block to the DB.
+    bool WriteTxs(int height, const std::map<uint64_t, DBTxOffsets>& offsets);
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
     BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
 {}
 
-bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
+std::vector<std::pair<int, uint32_t>> TxIndex::DB::ReadTxCandidates(const uint256& txid)
+{
+    std::vector<std::pair<int, uint32_t>> candidates;
+    const uint64_t hash_prefix{txid.GetUint64(0)};
+
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+    db_it->Seek(DBCompactPrefix{hash_prefix});
+    for (; db_it->Valid(); db_it->Next()) {
+        DBCompactKey key;
+        if (!db_it->GetKey(key) || key.hash_prefix != hash_prefix) break;
+
+        DBTxOffsets value;
+        if (!db_it->GetValue(value)) {
+            error("%s: unable to read value for transaction %s", __func__, txid.ToString());
+            break;
+        }
+        for (const uint32_t offset : value.offsets) {
+            candidates.emplace_back(key.height, offset);
+        }
+    }
+    return candidates;
+}
+
+bool TxIndex::DB::ReadLegacyTx(const uint256& txid, uint256& block_hash, CTransactionRef& tx) const
 {
-    return Read(std::make_pair(DB_TXINDEX, txid), pos);
+    CDiskTxPos postx;
+    if (!Read(std::make_pair(DB_TXINDEX, txid), postx)) {
+        return false;
+    }
+
+    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return error("%s: OpenBlockFile failed", __func__);
+    }
+    CBlockHeader header;
+    try {
+        file >> header;
+        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
+            return error("%s: fseek(...) failed", __func__);
+        }
+        file >> tx;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    if (tx->GetHash() != txid) {
+        return error("%s: txid mismatch", __func__);
+    }
+    block_hash = header.GetHash();
+    return true;
 }
 
-bool TxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos)
+bool TxIndex::DB::WriteTxs(int height, const std::map<uint64_t, DBTxOffsets>& offsets)
 {
     CDBBatch batch(*this);
-    for (const auto& tuple : v_pos) {
-        batch.Write(std::make_pair(DB_TXINDEX, tuple.first), tuple.second);
+    for (const auto& [hash_prefix, value] : offsets) {
+        batch.Write(DBCompactKey(hash_prefix, height), value);
     }
     return WriteBatch(batch);
 }
@@ -60,42 +172,93 @@ bool TxIndex::CustomAppend(const interfaces::BlockInfo& block)
     if (block.height == 0) return true;
 
     assert(block.data);
-    CDiskTxPos pos({block.file_number, block.data_pos}, GetSizeOfCompactSize(block.data->vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
-    vPos.reserve(block.data->vtx.size());
+    // Transactions of the block whose hashes start alike share a key
+    std::map<uint64_t, DBTxOffsets> offsets;
+    uint32_t offset = ::GetSerializeSize(block.data->GetBlockHeader(), CLIENT_VERSION) + GetSizeOfCompactSize(block.data->vtx.size());
     for (const auto& tx : block.data->vtx) {
-        vPos.emplace_back(tx->GetHash(), pos);
-        pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
+        offsets[tx->GetHash().GetUint64(0)].offsets.push_back(offset);
+        offset += ::GetSerializeSize(*tx, CLIENT_VERSION);
     }
-    return m_db->WriteTxs(vPos);
+    return m_db->WriteTxs(block.height, offsets);
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
-    CDiskTxPos postx;
-    if (!m_db->ReadTxPos(tx_hash, postx)) {
-        return false;
+    auto results{FindTxs({tx_hash})};
+    if (!results[0].second) return false;
+    block_hash = results[0].first;
+    tx = std::move(results[0].second);
+    return true;
+}
+
+std::vector<std::pair<uint256, CTransactionRef>> TxIndex::FindTxs(const std::vector<uint256>& tx_hashes) const
+{
+    std::vector<std::vector<std::pair<int, uint32_t>>> tx_candidates;
+    tx_candidates.reserve(tx_hashes.size());
+    for (const uint256& tx_hash : tx_hashes) {
+        tx_candidates.push_back(m_db->ReadTxCandidates(tx_hash));
     }
 
-    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
+    // Locate the candidates through the blocks of the active chain at their heights
+    std::vector<TxRead> reads;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain{m_chainstate->m_chain};
+        for (size_t i = 0; i < tx_hashes.size(); ++i) {
+            for (const auto& [height, offset] : tx_candidates[i]) {
+                const CBlockIndex* pindex{active_chain[height]};
+                if (!pindex || !(pindex->nStatus & BLOCK_HAVE_DATA)) continue;
+                reads.push_back({FlatFilePos{pindex->nFile, pindex->nDataPos + offset}, i, pindex->GetBlockHash()});
+            }
+        }
     }
-    CBlockHeader header;
-    try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
+
+    // Read each block file once, in the order the transactions are stored
+    std::sort(reads.begin(), reads.end(), [](const TxRead& a, const TxRead& b) {
+        return std::make_pair(a.pos.nFile, a.pos.nPos) < std::make_pair(b.pos.nFile, b.pos.nPos);
+    });
+    std::vector<std::pair<uint256, CTransactionRef>> results(tx_hashes.size());
+    std::unique_ptr<CAutoFile> file;
+    int file_number{-1};
+    for (const TxRead& read : reads) {
+        if (results[read.index].second) continue;
+        if (!file || read.pos.nFile != file_number) {
+            file = std::make_unique<CAutoFile>(OpenBlockFile(read.pos, true), SER_DISK, CLIENT_VERSION);
+            file_number = read.pos.nFile;
+            if (file->IsNull()) {
+                error("%s: OpenBlockFile failed", __func__);
+                file.reset();
+                continue;
+            }
+        } else if (fseek(file->Get(), read.pos.nPos, SEEK_SET)) {
+            error("%s: fseek(...) failed", __func__);
+            file.reset();
+            continue;
+        }
+        CTransactionRef tx;
+        try {
+            *file >> tx;
+        } catch (const std::exception& e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            file.reset();
+            continue;
+        }
+        // Other transactions may share the key
+        if (tx->GetHash() == tx_hashes[read.index]) {
+            results[read.index] = {read.block_hash, std::move(tx)};
         }
-        file >> tx;
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
-    if (tx->GetHash() != tx_hash) {
-        return error("%s: txid mismatch", __func__);
+
+    // Transactions indexed before the compact format are keyed by their full hash
+    for (size_t i = 0; i < tx_hashes.size(); ++i) {
+        if (results[i].second) continue;
+        CTransactionRef tx;
+        uint256 block_hash;
+        if (m_db->ReadLegacyTx(tx_hashes[i], block_hash, tx)) {
+            results[i] = {block_hash, std::move(tx)};
+        }
     }
-    block_hash = header.GetHash();
-    return true;
+    return results;
 }
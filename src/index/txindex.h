@@ -6,11 +6,21 @@
 #define BITCOIN_INDEX_TXINDEX_H
 
 #include <index/base.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <utility>
+#include <vector>
 
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
- * The index is written to a LevelDB database and records the filesystem
- * location of each transaction by transaction hash.
+ * The index is written to a LevelDB database and records the location of each
+ * transaction by transaction hash.
+ *
+ * Transactions are keyed by the first 8 bytes of their hash and the height of
+ * their block, and the value is their offset in the block. Transactions whose
+ * keys collide are told apart by reading them. Indexes written before this
+ * format keep the full hash and disk location, and are still read.
  */
 class TxIndex final : public BaseIndex
 {
@@ -41,6 +51,14 @@ public:
     /// @param[out]  tx  The transaction itself.
     /// @return  true if transaction is found, false otherwise
     bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Look up transactions by hash, reading those in the same block file
+    /// together in the order they are stored.
+    ///
+    /// @param[in]   tx_hashes  The hashes of the transactions to be returned.
+    /// @return  the hash of the block and the transaction for each hash, or
+    ///          a null transaction if it is not found
+    std::vector<std::pair<uint256, CTransactionRef>> FindTxs(const std::vector<uint256>& tx_hashes) const;
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
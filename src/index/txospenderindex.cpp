@@ -0,0 +1,226 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/txospenderindex.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <crypto/siphash.h>
+#include <index/disktxpos.h>
+#include <node/blockstorage.h>
+#include <random.h>
+#include <util/system.h>
+#include <validation.h>
+
+using node::OpenBlockFile;
+using node::ReadBlockFromDisk;
+
+constexpr uint8_t DB_SPENDER{'s'};
+constexpr uint8_t DB_SALT{'z'};
+
+std::unique_ptr<TxoSpenderIndex> g_txospenderindex;
+
+namespace {
+
+/**
+ * Key of the transaction spending an output: the truncated salted hash of the
+ * output, which several outputs may share, and the disk location of the
+ * spending transaction, which tells them apart. The value is the height of
+ * the block of the transaction.
+ */
+struct DBSpenderKey {
+    uint64_t outpoint_hash{0};
+    CDiskTxPos pos;
+
+    DBSpenderKey() = default;
+    DBSpenderKey(uint64_t outpoint_hash_in, const CDiskTxPos& pos_in) : outpoint_hash(outpoint_hash_in), pos(pos_in) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_SPENDER);
+        ser_writedata64(s, outpoint_hash);
+        s << pos;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_SPENDER) {
+            throw std::ios_base::failure("Invalid format for txospenderindex DB key");
+        }
+        outpoint_hash = ser_readdata64(s);
+        s >> pos;
+    }
+};
+
+/** Prefix of the keys of the transactions spending outputs with the given hash */
+struct DBSpenderPrefix {
+    uint64_t outpoint_hash;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_SPENDER);
+        ser_writedata64(s, outpoint_hash);
+    }
+};
+
+using Salt = std::pair<uint64_t, uint64_t>;
+
+uint64_t OutpointHash(const Salt& salt, const COutPoint& outpoint)
+{
+    return SipHashUint256Extra(salt.first, salt.second, outpoint.hash, outpoint.n);
+}
+
+/** Get the keys of the outputs spent by the transactions of a block stored at the given position */
+std::vector<DBSpenderKey> SpenderKeys(const Salt& salt, const CBlock& block, const FlatFilePos& block_pos)
+{
+    std::vector<DBSpenderKey> keys;
+    CDiskTxPos pos(block_pos, GetSizeOfCompactSize(block.vtx.size()));
+    for (const auto& tx : block.vtx) {
+        if (!tx->IsCoinBase()) {
+            for (const CTxIn& txin : tx->vin) {
+                keys.emplace_back(OutpointHash(salt, txin.prevout), pos);
+            }
+        }
+        pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
+    }
+    return keys;
+}
+
+} // namespace
+
+/** Access to the spent output index database (indexes/txospenderindex/) */
+class TxoSpenderIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Write or erase the keys of the outputs spent by the transactions of a block.
+    bool WriteSpenders(const std::vector<DBSpenderKey>& keys, int height);
+    bool EraseSpenders(const std::vector<DBSpenderKey>& keys);
+};
+
+TxoSpenderIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txospenderindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool TxoSpenderIndex::DB::WriteSpenders(const std::vector<DBSpenderKey>& keys, int height)
+{
+    CDBBatch batch(*this);
+    for (const DBSpenderKey& key : keys) {
+        batch.Write(key, height);
+    }
+    return WriteBatch(batch);
+}
+
+bool TxoSpenderIndex::DB::EraseSpenders(const std::vector<DBSpenderKey>& keys)
+{
+    CDBBatch batch(*this);
+    for (const DBSpenderKey& key : keys) {
+        batch.Erase(key);
+    }
+    return WriteBatch(batch);
+}
+
+TxoSpenderIndex::TxoSpenderIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "txospenderindex"), m_db(std::make_unique<TxoSpenderIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+TxoSpenderIndex::~TxoSpenderIndex() = default;
+
+bool TxoSpenderIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
+{
+    if (!m_db->Read(DB_SALT, m_salt)) {
+        if (block) {
+            return error("%s: Cannot read the salt of %s; index may be corrupted", __func__, GetName());
+        }
+        m_salt = {GetRand<uint64_t>(), GetRand<uint64_t>()};
+        if (!m_db->Write(DB_SALT, m_salt)) {
+            return error("%s: Cannot write the salt of %s", __func__, GetName());
+        }
+    }
+    return true;
+}
+
+bool TxoSpenderIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // The genesis block spends no outputs
+    if (block.height == 0) return true;
+
+    assert(block.data);
+    const auto keys{SpenderKeys(m_salt, *block.data, {block.file_number, block.data_pos})};
+    return m_db->WriteSpenders(keys, block.height);
+}
+
+bool TxoSpenderIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    // Remove the spends of the disconnected blocks, so that the outputs they
+    // spent are unspent again
+    LOCK(cs_main);
+    const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+    const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+    const auto& consensus_params{Params().GetConsensus()};
+
+    do {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, iter_tip, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, iter_tip->GetBlockHash().ToString());
+        }
+        const auto keys{SpenderKeys(m_salt, block, iter_tip->GetBlockPos())};
+        if (!m_db->EraseSpenders(keys)) return false;
+
+        iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+    } while (new_tip_index != iter_tip);
+
+    return true;
+}
+
+BaseIndex::DB& TxoSpenderIndex::GetDB() const { return *m_db; }
+
+std::optional<TxoSpender> TxoSpenderIndex::FindSpender(const COutPoint& outpoint) const
+{
+    const uint64_t outpoint_hash{OutpointHash(m_salt, outpoint)};
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(DBSpenderPrefix{outpoint_hash});
+    for (; db_it->Valid(); db_it->Next()) {
+        DBSpenderKey key;
+        if (!db_it->GetKey(key) || key.outpoint_hash != outpoint_hash) break;
+
+        TxoSpender spender;
+        if (!db_it->GetValue(spender.height)) {
+            error("%s: unable to read value for output %s", __func__, outpoint.ToString());
+            break;
+        }
+
+        // Check that the transaction spends the output, as other outputs may share the hash
+        CAutoFile file(OpenBlockFile(key.pos, true), SER_DISK, CLIENT_VERSION);
+        if (file.IsNull()) {
+            error("%s: OpenBlockFile failed", __func__);
+            break;
+        }
+        CBlockHeader header;
+        try {
+            file >> header;
+            if (fseek(file.Get(), key.pos.nTxOffset, SEEK_CUR)) {
+                error("%s: fseek(...) failed", __func__);
+                break;
+            }
+            file >> spender.tx;
+        } catch (const std::exception& e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            break;
+        }
+        for (const CTxIn& txin : spender.tx->vin) {
+            if (txin.prevout == outpoint) {
+                spender.block_hash = header.GetHash();
+                return spender;
+            }
+        }
+    }
+    return std::nullopt;
+}
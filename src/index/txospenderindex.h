@@ -0,0 +1,72 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TXOSPENDERINDEX_H
+#define BITCOIN_INDEX_TXOSPENDERINDEX_H
+
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <optional>
+
+/** A confirmed transaction spending an output */
+struct TxoSpender {
+    CTransactionRef tx;
+    uint256 block_hash;
+    int height{0};
+};
+
+/**
+ * TxoSpenderIndex is used to look up the transaction of the active chain that
+ * spent an output. The index is written to a LevelDB database.
+ *
+ * To keep keys small, outputs are keyed by a truncated salted hash followed
+ * by the disk location of the spending transaction. Lookups read the
+ * transactions of all keys matching the hash from disk, and keep the one that
+ * actually spends the output. This requires the blocks to be kept, so the
+ * index is incompatible with pruning. Entries of disconnected blocks are
+ * removed.
+ */
+class TxoSpenderIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+    //! Salt of the hashes of outputs, generated when the database is created
+    std::pair<uint64_t, uint64_t> m_salt;
+
+    bool AllowPrune() const override { return false; }
+
+protected:
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit TxoSpenderIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~TxoSpenderIndex() override;
+
+    /// Look up the transaction spending an output.
+    ///
+    /// @param[in]   outpoint  The spent output.
+    /// @return  the spending transaction with its block and height, or
+    ///          std::nullopt if the output is unspent in the indexed chain
+    std::optional<TxoSpender> FindSpender(const COutPoint& outpoint) const;
+};
+
+/// The global spent output index. May be null.
+extern std::unique_ptr<TxoSpenderIndex> g_txospenderindex;
+
+#endif // BITCOIN_INDEX_TXOSPENDERINDEX_H
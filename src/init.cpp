@@ -9,6 +9,7 @@
 
 #include <init.h>
 
+#include <kernel/chainstatemanager_opts.h>
 #include <kernel/checks.h>
 #include <kernel/mempool_persist.h>
 #include <kernel/validation_cache_sizes.h>
@@ -26,7 +27,9 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/conversionindex.h>
 #include <index/txindex.h>
+#include <index/txospenderindex.h>
 #include <init/common.h>
 #include <interfaces/chain.h>
 #include <interfaces/init.h>
@@ -45,6 +48,7 @@
 #include <node/mempool_args.h>
 #include <node/mempool_persist_args.h>
 #include <node/miner.h>
+#include <node/txreconciliation.h>
 #include <node/validation_cache_args.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
@@ -76,6 +80,7 @@
 #include <util/system.h>
 #include <util/thread.h>
 #include <util/threadnames.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -87,6 +92,7 @@
 #include <cstdio>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <set>
 #include <string>
 #include <thread>
@@ -112,8 +118,12 @@ using kernel::ValidationCacheSizes;
 using node::ApplyArgsManOptions;
 using node::CacheSizes;
 using node::CalculateCacheSizes;
+using node::DEFAULT_BLOCK_CONVERSION_TIME;
+using node::DEFAULT_BLOCK_COMPRESSION;
+using node::DEFAULT_BLOCK_UNDO_V2;
 using node::DEFAULT_GENERATE;
 using node::DEFAULT_GENERATE_THREADS;
+using node::DEFAULT_MMAP_BLOCKFILES;
 using node::DEFAULT_PERSIST_MEMPOOL;
 using node::DEFAULT_PRINTPRIORITY;
 using node::DEFAULT_STOPAFTERBLOCKIMPORT;
@@ -130,6 +140,15 @@ using node::nPruneTarget;
 
 static const bool DEFAULT_PROXYRANDOMIZE = true;
 static const bool DEFAULT_REST_ENABLE = false;
+/** Number of threads running scheduled tasks and validation interface callbacks */
+static constexpr int DEFAULT_SCHEDULER_THREADS{4};
+static constexpr int MAX_SCHEDULER_THREADS{16};
+/** Number of workers of the thread pool, 0 = one per core */
+static constexpr int DEFAULT_THREAD_POOL_SIZE{0};
+/** Enough workers for a long running RPC call and index sync to leave some for the others */
+static constexpr int MIN_THREAD_POOL_SIZE{4};
+static constexpr int MAX_THREAD_POOL_SIZE{256};
+static constexpr bool DEFAULT_THREAD_POOL_AFFINITY{false};
 
 #ifdef WIN32
 // Win32 LevelDB doesn't use filedescriptors, and the ones used for
@@ -209,6 +228,12 @@ void Interrupt(NodeContext& node)
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
     }
+    if (g_conversion_index) {
+        g_conversion_index->Interrupt();
+    }
+    if (g_txospenderindex) {
+        g_txospenderindex->Interrupt();
+    }
 }
 
 void Shutdown(NodeContext& node)
@@ -246,8 +271,9 @@ void Shutdown(NodeContext& node)
     // After everything has been shut down, but before things get flushed, stop the
     // CScheduler/checkqueue, scheduler and load block thread.
     if (node.scheduler) node.scheduler->stop();
-    if (node.chainman && node.chainman->m_load_block.joinable()) node.chainman->m_load_block.join();
+    if (node.chainman && node.chainman->m_load_block.valid()) node.chainman->m_load_block.wait();
     StopScriptCheckWorkerThreads();
+    StopBlockCheckWorkerThreads();
 
     // After the threads that potentially access these pointers have been stopped,
     // destruct and reset all to nullptr.
@@ -287,9 +313,24 @@ void Shutdown(NodeContext& node)
         g_coin_stats_index->Stop();
         g_coin_stats_index.reset();
     }
+    if (g_conversion_index) {
+        g_conversion_index->Stop();
+        g_conversion_index.reset();
+    }
+    if (g_txospenderindex) {
+        g_txospenderindex->Stop();
+        g_txospenderindex.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
+    // Nothing posts tasks to the thread pool anymore, so its workers can be stopped.
+    if (node.thread_pool) {
+        util::SetSharedThreadPool(nullptr);
+        node.thread_pool->Stop();
+        node.thread_pool.reset();
+    }
+
     // Any future callbacks will be dropped. This should absolutely be safe - if
     // missing a callback results in an unrecoverable situation, unclean shutdown
     // would too. The only reason to do the above flushes is to let the wallet catch
@@ -335,6 +376,7 @@ void Shutdown(NodeContext& node)
     }
 
     LogPrintf("%s: done\n", __func__);
+    LogInstance().StopAsyncWriter();
 }
 
 /**
@@ -413,22 +455,37 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockindexdbblockcachepct=<n>", strprintf("Percentage of the block index database cache used for the LevelDB block cache, the rest is used for write buffers (0 to 100, default: %d)", DBTuning{}.block_cache_percent), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockindexdbbloombits=<n>", strprintf("Bits per key of the LevelDB bloom filter of the block index database, 0 to disable (0 to %d, default: %d)", MAX_DB_BLOOM_BITS, DBTuning{}.bloom_bits), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockindexdbwritebuffer=<n>", strprintf("Size of the LevelDB write buffer of the block index database in MiB, 0 to derive it from the cache size (0 to %d, default: 0)", MAX_DB_WRITE_BUFFER), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockcompression", strprintf("Compress the block and undo files of blocks at least %u deep, one block file every %u seconds. Blocks are read from the compressed files in place, and files are decompressed again when written to. Only supported on Linux (default: %u)", MIN_BLOCKS_TO_KEEP, count_seconds(node::BLOCK_COMPRESSION_INTERVAL), DEFAULT_BLOCK_COMPRESSION), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-mmapblockfiles", strprintf("Read blocks and undo data from memory mapped block files, keeping up to %u files mapped. Not supported on Windows (default: %u)", node::MAX_MAPPED_BLOCKFILES, DEFAULT_MMAP_BLOCKFILES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockundov2", strprintf("Write new undo data in the compact v2 encoding. Disable to keep rev?????.dat files readable by earlier versions; both encodings are always read (default: %u)", DEFAULT_BLOCK_UNDO_V2), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-fastprune", "Use smaller block files and lower minimum prune height for testing purposes", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
 #if HAVE_SYSTEM
     argsman.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
+    argsman.AddArg("-blockreconstructionconversionbytes=<n>", strprintf("Memory in bytes to keep conversions removed from the mempool for no longer being valid in its conversion window for compact block reconstructions, as other miners may still include them (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_CONVERSION_BYTES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Automatic broadcast and rebroadcast of any transactions from inbound peers is disabled, unless the peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-chainstatedbblockcachepct=<n>", strprintf("Percentage of the chainstate database cache used for the LevelDB block cache, the rest is used for write buffers (0 to 100, default: %d)", DBTuning{}.block_cache_percent), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-chainstatedbbloombits=<n>", strprintf("Bits per key of the LevelDB bloom filter of the chainstate database, 0 to disable (0 to %d, default: %d)", MAX_DB_BLOOM_BITS, DBTuning{}.bloom_bits), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-chainstatedbwritebuffer=<n>", strprintf("Size of the LevelDB write buffer of the chainstate database in MiB, 0 to derive it from the cache size (0 to %d, default: 0)", MAX_DB_WRITE_BUFFER), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-coinstatsindex", strprintf("Maintain coinstats index used by the gettxoutsetinfo RPC (default: %u)", DEFAULT_COINSTATSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-conversionindex", strprintf("Maintain a conversion index, used by the getconversion and listconversions RPC calls (default: %u)", DEFAULT_CONVERSIONINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location (only useable from command line, not configuration file) (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbcachehugepages", strprintf("Allocate the coins cache from transparent huge pages, interleaved across NUMA nodes. Only supported on Linux (default: %u)", DEFAULT_DBCACHE_HUGE_PAGES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbcachebackground=<n>", strprintf("Percentage of -dbcache given to the background validation of a snapshot once the snapshot chainstate is synced (1 to 99, default: %d)", kernel::DEFAULT_BACKGROUND_CACHE_PERCENT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbflushbackground", strprintf("Write periodic flushes of the coins cache to disk on a background thread, so that block validation continues meanwhile (default: %u)", DEFAULT_DBFLUSH_BACKGROUND), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-gen", strprintf("Generate coins (default: %u)", DEFAULT_GENERATE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-genproclimit", strprintf("Set the number of threads for coin generation if enabled (-1 = all cores, default: %d)", DEFAULT_GENERATE_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-loadblock=<file>", "Imports blocks from external file on startup", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-maxmemory=<n>", "Limit the memory used by the database caches, the signature caches and the mempool together to <n> MiB. While in initial block download, the in-memory UTXO set cache grows into the part of this budget not used by the others, and shrinks back to its -dbcache share afterwards (default: 0, no limit)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE_MB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolconversionbuffer=<n>", strprintf("Use a <n> bips buffer when checking if conversion is valid for the mempool (default: %d)", DEFAULT_MEMPOOL_CONVERSION_BUFFER), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -439,6 +496,8 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex(), signetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-parbackground=<n>", strprintf("Set the number of script verification workers of the background validation of a snapshot, which run at low priority (0 to %d, 0 = as many as -par, default: %d)",
+        MAX_SCRIPTCHECK_THREADS, DEFAULT_BACKGROUND_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex. "
@@ -446,6 +505,8 @@ void SetupServerArgs(ArgsManager& argsman)
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >=%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk. This will also rebuild active optional indexes.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks. When in pruning mode or if blocks on disk might be corrupted, use full -reindex instead. Deactivate all optional indexes before running this.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-schedulerthreads=<n>", strprintf("Set the number of threads running background tasks and validation notifications, which are delivered to the wallets, indexes and other subscribers concurrently (1 to %d, default: %d)",
+        MAX_SCHEDULER_THREADS, DEFAULT_SCHEDULER_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-settings=<file>", strprintf("Specify path to dynamic settings data file. Can be disabled with -nosettings. File is written at runtime and not meant to be edited by users (use %s instead for custom settings). Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME, BITCOIN_SETTINGS_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-startupnotify=<cmd>", "Execute command on startup.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -455,7 +516,12 @@ void SetupServerArgs(ArgsManager& argsman)
 #else
     hidden_args.emplace_back("-sysperms");
 #endif
+    argsman.AddArg("-threadpoolaffinity", strprintf("Pin each thread pool worker to its own CPU core. Only supported on Linux. (default: %u)", DEFAULT_THREAD_POOL_AFFINITY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-threadpoolcpus=<cpus>", "Pin the thread pool workers, which run script verification and index syncs among others, to these CPUs in turn instead: a comma separated list of CPU numbers, ranges like 0-7, and NUMA nodes like node0. Only supported on Linux.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-threadpoolsize=<n>", strprintf("Set the number of threads shared by script verification, RPC calls, index syncs and block loading (%d to %d, 0 = one per core, default: %d)",
+        MIN_THREAD_POOL_SIZE, MAX_THREAD_POOL_SIZE, DEFAULT_THREAD_POOL_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-txospenderindex", strprintf("Maintain an index of the transactions spending confirmed outputs, used by the gettxspendingprevout rpc call (default: %u)", DEFAULT_TXOSPENDERINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blockfilterindex=<type>",
                  strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
                  " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
@@ -483,6 +549,8 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-onion=<ip:port>", "Use separate SOCKS5 proxy to reach peers via Tor onion services, set -noonion to disable (default: -proxy)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-i2psam=<ip:port>", "I2P SAM proxy to reach I2P peers and accept I2P connections (default: none)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-i2pacceptincoming", "If set and -i2psam is also set then incoming I2P connections are accepted via the SAM proxy. If this is not set but -i2psam is set then only outgoing connections will be made to the I2P network. Ignored if -i2psam is not set. Listening for incoming I2P connections is done through the SAM proxy, not by binding to a local address and port (default: 1)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-i2pacceptstreams=<n>", strprintf("Number of incoming I2P connections that can be accepted at once from the SAM proxy. Needs a SAM proxy supporting version 3.2 or newer to be above 1 (default: %u)", DEFAULT_I2P_ACCEPT_STREAMS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-i2ptransientsessions=<n>", strprintf("Number of transient I2P sessions to create ahead of outgoing I2P connections when not accepting incoming ones (default: %u)", DEFAULT_I2P_TRANSIENT_SESSIONS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onlynet=<net>", "Make automatic outbound connections only to network <net> (" + Join(GetNetworkNames(), ", ") + "). Inbound and manual connections are not affected by this option. It can be specified multiple times to allow multiple networks.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerblockfilters", strprintf("Serve compact block filters to peers per BIP 157 (default: %u)", DEFAULT_PEERBLOCKFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -492,11 +560,13 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-proxy=<ip:port>", "Connect through SOCKS5 proxy, set -noproxy to disable (default: disabled)", ArgsManager::ALLOW_ANY | ArgsManager::DISALLOW_ELISION, OptionsCategory::CONNECTION);
     argsman.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect. This option can be specified multiple times to connect to multiple nodes.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-netcpus=<cpus>", "Run the socket and message handler threads on these CPUs: a comma separated list of CPU numbers, ranges like 0-7, and NUMA nodes like node0. Only supported on Linux.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-networkactive", "Enable all P2P network activity (default: 1). Can be changed by the setnetworkactive RPC command", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-timeout=<n>", strprintf("Specify socket connection timeout in milliseconds. If an initial attempt to connect is unsuccessful after this amount of time, drop it (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peertimeout=<n>", strprintf("Specify a p2p connection timeout delay in seconds. After connecting to a peer, wait this amount of time before considering disconnection based on inactivity (minimum: 1, default: %d)", DEFAULT_PEER_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-torcontrol=<ip>:<port>", strprintf("Tor control port to use if onion listening enabled (default: %s)", DEFAULT_TOR_CONTROL), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-torpassword=<pass>", "Tor control port password (default: empty)", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::CONNECTION);
+    argsman.AddArg("-txreconciliation", strprintf("Enable transaction reconciliations per BIP 330 (default: %d)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
 #ifdef USE_UPNP
 #if USE_UPNP
     argsman.AddArg("-upnp", "Use UPnP to map the listening port (default: 1 when listening and no -proxy)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -527,31 +597,40 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequence=<address>", "Enable publish hash block and tx sequence in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawconversion=<address>", "Enable publish raw conversion and remainder of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubsupply=<address>", "Enable publish supply of connected blocks in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequencehwm=<n>", strprintf("Set publish hash sequence message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawconversionhwm=<n>", strprintf("Set publish raw conversion outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubsupplyhwm=<n>", strprintf("Set publish supply outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
     hidden_args.emplace_back("-zmqpubsequence=<n>");
+    hidden_args.emplace_back("-zmqpubrawconversion=<address>");
+    hidden_args.emplace_back("-zmqpubsupply=<address>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawconversionhwm=<n>");
+    hidden_args.emplace_back("-zmqpubsupplyhwm=<n>");
 #endif
 
     argsman.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checklevel=<n>", strprintf("How thorough the block verification of -checkblocks is: %s (0-4, default: %u)", Join(CHECKLEVEL_DOC, ", "), DEFAULT_CHECKLEVEL), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkblockindex", strprintf("Do a consistency check for the block tree, chainstate, and other validation data structures occasionally. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkaddrman=<n>", strprintf("Run addrman consistency checks every <n> operations. Use 0 to disable. (default: %u)", DEFAULT_ADDRMAN_CONSISTENCY_CHECKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
-    argsman.AddArg("-checkmempool=<n>", strprintf("Run mempool consistency checks every <n> transactions. Use 0 to disable. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-checkmempool=<n>", strprintf("Run mempool consistency checks every <n> transactions, of the transactions changed since the last check and every %u checks of the whole mempool. Use 0 to disable. (default: %u, regtest: %u)", CTxMemPool::FULL_CHECK_INTERVAL, defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkpoints", strprintf("Enable rejection of any forks from the known historical chain until block %s (default: %u)", defaultChainParams->Checkpoints().GetHeight(), DEFAULT_CHECKPOINTS_ENABLED), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-lockstats=<n>", "Record the contention of cs_main, the mempool, wallet and node list locks per acquisition site for the getlockstats RPC, timing the hold of one in <n> acquisitions. Use 0 to disable. (default: 0)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-stopafterblockimport", strprintf("Stop running after importing blocks from disk (default: %u)", DEFAULT_STOPAFTERBLOCKIMPORT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-stopatheight", strprintf("Stop running after reaching the given height in the main chain (default: %u)", DEFAULT_STOPATHEIGHT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-limitancestorcount=<n>", strprintf("Do not accept transactions if number of in-mempool ancestors is <n> or more (default: %u)", DEFAULT_ANCESTOR_LIMIT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -583,6 +662,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-whitelistrelay", strprintf("Add 'relay' permission to whitelisted inbound peers with default permissions. This will accept relayed transactions even when not relaying transactions (default: %d)", DEFAULT_WHITELISTRELAY), ArgsManager::ALLOW_ANY, OptionsCategory::NODE_RELAY);
 
 
+    argsman.AddArg("-blockconversiontime=<n>", strprintf("Set maximum time in milliseconds spent retrying conversions that are not valid in feerate order when creating a block (default: %d)", DEFAULT_BLOCK_CONVERSION_TIME.count()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockmaxweight=<n>", strprintf("Set maximum BIP141 block weight (default: %d)", DEFAULT_BLOCK_MAX_WEIGHT), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kvB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::BLOCK_CREATION);
@@ -594,14 +674,16 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-rpcdoccheck", strprintf("Throw a non-fatal error at runtime if the documentation for an RPC is incorrect (default: %u)", DEFAULT_RPC_DOC_CHECK), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
+    argsman.AddArg("-rpcprioritythreads=<n>", strprintf("Set the number of thread pool workers that may run getblocktemplate, submitblock and submitheader calls at once, so that they do not wait behind other calls; 0 serves them with all other calls (default: %d)", DEFAULT_HTTP_PRIORITY_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u, testnet: %u, signet: %u, regtest: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort(), signetBaseParams->RPCPort(), regtestBaseParams->RPCPort()), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rpcserialversion", strprintf("Sets the serialization of raw transaction or block hex returned in non-verbose mode, non-segwit(0) or segwit(1) (default: %d)", DEFAULT_RPC_SERIALIZE_VERSION), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcmaxrequestsperconnection=<n>", strprintf("Close a kept-alive HTTP connection after serving this many requests over it, 0 for no limit (default: %d)", DEFAULT_HTTP_MAX_REQUESTS_PER_CONNECTION), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
-    argsman.AddArg("-rpcthreads=<n>", strprintf("Set the number of threads to service RPC calls (default: %d)", DEFAULT_HTTP_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcthreads=<n>", strprintf("Set the number of thread pool workers that may service RPC calls at once (default: %d)", DEFAULT_HTTP_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcuser=<user>", "Username for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpcwhitelist=<whitelist>", "Set a whitelist to filter incoming RPC calls for a specific user. The field <whitelist> comes in the format: <USERNAME>:<rpc 1>,<rpc 2>,...,<rpc n>. If multiple whitelists are set for a given user, they are set-intersected. See -rpcwhitelistdefault documentation for information on default whitelist behavior.", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcwhitelistdefault", "Sets default behavior for rpc whitelisting. Unless rpcwhitelistdefault is set to 0, if any -rpcwhitelist is set, the rpc server acts as if all rpc users are subject to empty-unless-otherwise-specified whitelists. If rpcwhitelistdefault is set to 1 and no -rpcwhitelist is set, rpc server acts as if all rpc users are subject to empty whitelists.", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
-    argsman.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls, at which new connections are no longer accepted until it drains (default: %d)", DEFAULT_HTTP_WORKQUEUE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-server", "Accept command line and JSON-RPC commands", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
 
 #if HAVE_DECL_FORK
@@ -658,7 +740,7 @@ static bool AppInitServers(NodeContext& node)
     if (!StartHTTPRPC(&node))
         return false;
     if (args.GetBoolArg("-rest", DEFAULT_REST_ENABLE)) StartREST(&node);
-    StartHTTPServer();
+    StartHTTPServer(*Assert(node.thread_pool));
     return true;
 }
 
@@ -891,6 +973,8 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
     if (args.GetIntArg("-prune", 0)) {
         if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (args.GetBoolArg("-txospenderindex", DEFAULT_TXOSPENDERINDEX))
+            return InitError(_("Prune mode is incompatible with -txospenderindex."));
         if (args.GetBoolArg("-reindex-chainstate", false)) {
             return InitError(_("Prune mode is incompatible with -reindex-chainstate. Use full -reindex instead."));
         }
@@ -940,6 +1024,21 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
 
     fCheckBlockIndex = args.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = args.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    g_coins_cache_huge_pages = args.GetBoolArg("-dbcachehugepages", DEFAULT_DBCACHE_HUGE_PAGES);
+    g_coins_flush_background = args.GetBoolArg("-dbflushbackground", DEFAULT_DBFLUSH_BACKGROUND);
+
+    const int64_t lock_stats_interval{args.GetIntArg("-lockstats", 0)};
+    if (lock_stats_interval < 0 || lock_stats_interval > std::numeric_limits<uint32_t>::max()) {
+        return InitError(Untranslated(strprintf("Invalid -lockstats value: %d", lock_stats_interval)));
+    }
+    RegisterProfiledLock(&cs_main, "cs_main");
+    SetLockProfiling(lock_stats_interval);
+
+    for (const std::string db_name : {"blockindex", "chainstate"}) {
+        DBTuning tuning;
+        bilingual_str error;
+        if (!ReadDBTuning(args, db_name, tuning, error)) return InitError(error);
+    }
 
     hashAssumeValid = uint256S(args.GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
 
@@ -969,6 +1068,14 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
         fPruneMode = true;
     }
 
+    node::g_mmap_block_files = args.GetBoolArg("-mmapblockfiles", DEFAULT_MMAP_BLOCKFILES);
+    node::g_block_undo_v2 = args.GetBoolArg("-blockundov2", DEFAULT_BLOCK_UNDO_V2);
+#ifndef HAVE_FOPENCOOKIE
+    if (args.GetBoolArg("-blockcompression", DEFAULT_BLOCK_COMPRESSION)) {
+        return InitError(_("Compressing block files is not supported on this platform."));
+    }
+#endif
+
     nConnectTimeout = args.GetIntArg("-timeout", DEFAULT_CONNECT_TIMEOUT);
     if (nConnectTimeout <= 0) {
         nConnectTimeout = DEFAULT_CONNECT_TIMEOUT;
@@ -1010,12 +1117,18 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
         if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
             return InitError(_("-reindex-chainstate option is not compatible with -coinstatsindex. Please temporarily disable coinstatsindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
         }
+        if (args.GetBoolArg("-conversionindex", DEFAULT_CONVERSIONINDEX)) {
+            return InitError(_("-reindex-chainstate option is not compatible with -conversionindex. Please temporarily disable conversionindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
+        }
         if (g_enabled_filter_types.count(BlockFilterType::BASIC)) {
             return InitError(_("-reindex-chainstate option is not compatible with -blockfilterindex. Please temporarily disable blockfilterindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
         }
         if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
             return InitError(_("-reindex-chainstate option is not compatible with -txindex. Please temporarily disable txindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
         }
+        if (args.GetBoolArg("-txospenderindex", DEFAULT_TXOSPENDERINDEX)) {
+            return InitError(_("-reindex-chainstate option is not compatible with -txospenderindex. Please temporarily disable txospenderindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
+        }
     }
 
 #if defined(USE_SYSCALL_SANDBOX)
@@ -1139,6 +1252,23 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         return InitError(strprintf(_("Unable to allocate memory for -maxsigcachesize: '%s' MiB"), args.GetIntArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_BYTES >> 20)));
     }
 
+    int thread_pool_size = args.GetIntArg("-threadpoolsize", DEFAULT_THREAD_POOL_SIZE);
+    if (thread_pool_size <= 0) thread_pool_size = GetNumCores();
+    thread_pool_size = std::clamp(thread_pool_size, MIN_THREAD_POOL_SIZE, MAX_THREAD_POOL_SIZE);
+    LogPrintf("Thread pool uses %d threads\n", thread_pool_size);
+    assert(!node.thread_pool);
+    util::ThreadPool::Options thread_pool_options;
+    thread_pool_options.threads = thread_pool_size;
+    thread_pool_options.pin_threads = args.GetBoolArg("-threadpoolaffinity", DEFAULT_THREAD_POOL_AFFINITY);
+    if (args.IsArgSet("-threadpoolcpus")) {
+        const auto cpus{util::ParseCpuSet(args.GetArg("-threadpoolcpus", ""))};
+        if (!cpus) return InitError(strprintf(_("Invalid CPU set for -threadpoolcpus: '%s'"), args.GetArg("-threadpoolcpus", "")));
+        thread_pool_options.cpus = *cpus;
+    }
+    thread_pool_options.syscall_sandbox_policy = SyscallSandboxPolicy::THREAD_POOL;
+    node.thread_pool = std::make_unique<util::ThreadPool>(std::move(thread_pool_options));
+    util::SetSharedThreadPool(node.thread_pool.get());
+
     int script_threads = args.GetIntArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
         // -par=0 means autodetect (number of cores - 1 script threads)
@@ -1149,25 +1279,36 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     // Subtract 1 because the main thread counts towards the par threads
     script_threads = std::max(script_threads - 1, 0);
 
-    // Number of script-checking threads <= MAX_SCRIPTCHECK_THREADS
-    script_threads = std::min(script_threads, MAX_SCRIPTCHECK_THREADS);
+    // Number of script-checking threads <= MAX_SCRIPTCHECK_THREADS, and the thread pool size
+    script_threads = std::min({script_threads, MAX_SCRIPTCHECK_THREADS, thread_pool_size});
 
     LogPrintf("Script verification uses %d additional threads\n", script_threads);
     if (script_threads >= 1) {
         g_parallel_script_checks = true;
-        StartScriptCheckWorkerThreads(script_threads);
+        StartScriptCheckWorkers(*node.thread_pool, script_threads);
+        int background_script_threads = args.GetIntArg("-parbackground", DEFAULT_BACKGROUND_SCRIPTCHECK_THREADS);
+        if (background_script_threads <= 0) background_script_threads = script_threads;
+        background_script_threads = std::min(background_script_threads, MAX_SCRIPTCHECK_THREADS);
+        LogPrintf("Background validation of a snapshot uses up to %d script verification workers\n", background_script_threads);
+        StartBackgroundScriptCheckWorkers(*node.thread_pool, background_script_threads);
+        // As many workers check received blocks before they are accepted
+        StartBlockCheckWorkers(*node.thread_pool, script_threads);
     }
 
     assert(!node.scheduler);
     node.scheduler = std::make_unique<CScheduler>();
 
-    // Start the lightweight task scheduler thread
-    node.scheduler->m_service_thread = std::thread(util::TraceThread, "scheduler", [&] { node.scheduler->serviceQueue(); });
+    // Start the lightweight task scheduler threads
+    const int scheduler_threads = std::clamp<int>(args.GetIntArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS), 1, MAX_SCHEDULER_THREADS);
+    LogPrintf("Scheduler uses %d threads\n", scheduler_threads);
+    for (int n = 0; n < scheduler_threads; ++n) {
+        node.scheduler->m_service_threads.emplace_back(util::TraceThread, n == 0 ? "scheduler" : strprintf("scheduler.%i", n), [&] { node.scheduler->serviceQueue(); });
+    }
 
     // Gather some entropy once per minute.
     node.scheduler->scheduleEvery([]{
         RandAddPeriodic();
-    }, std::chrono::minutes{1});
+    }, std::chrono::minutes{1}, "entropy");
 
     GetMainSignals().RegisterBackgroundSignalScheduler(*node.scheduler);
 
@@ -1251,6 +1392,8 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         if (const auto error{LoadAddrman(*node.netgroupman, args, node.addrman)}) {
             return InitError(*error);
         }
+        // Verify the bucket positions restored from peers.dat in the background.
+        node.scheduler->scheduleFromNow([&addrman = *node.addrman] { addrman.RevalidateBuckets(); }, 0ms);
     }
 
     assert(!node.banman);
@@ -1431,15 +1574,32 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     }
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", cache_sizes.coins * (1.0 / 1024 / 1024), mempool_opts.max_size_bytes * (1.0 / 1024 / 1024));
 
+    // The coins caches and the mempool share what the other caches leave of -maxmemory
+    int64_t memory_budget{0};
+    if (const int64_t max_memory{args.GetIntArg("-maxmemory", 0)}; max_memory > 0) {
+        memory_budget = (max_memory << 20) - cache_sizes.block_tree_db - cache_sizes.tx_index -
+                        cache_sizes.filter_index * int64_t(g_enabled_filter_types.size()) -
+                        int64_t(validation_cache_sizes.signature_cache_bytes + validation_cache_sizes.script_execution_cache_bytes);
+        const int64_t min_budget{cache_sizes.coins_db + cache_sizes.coins + mempool_opts.max_size_bytes};
+        if (memory_budget < min_budget) {
+            const int64_t min_max_memory{(max_memory << 20) - memory_budget + min_budget};
+            return InitError(strprintf(_("-maxmemory must be at least %d MiB, the memory used by -dbcache, -maxmempool and the signature caches"),
+                                       (min_max_memory + (1 << 20) - 1) >> 20));
+        }
+        LogPrintf("* Using up to %.1f MiB for in-memory UTXO set and mempool together during initial block download\n", (memory_budget - cache_sizes.coins_db) * (1.0 / 1024 / 1024));
+    }
+
     for (bool fLoaded = false; !fLoaded && !ShutdownRequested();) {
         node.mempool = std::make_unique<CTxMemPool>(mempool_opts);
 
         const ChainstateManager::Options chainman_opts{
             .chainparams = chainparams,
             .adjusted_time_callback = GetAdjustedTime,
+            .background_cache_percent = std::clamp<int>(args.GetIntArg("-dbcachebackground", kernel::DEFAULT_BACKGROUND_CACHE_PERCENT), 1, 99),
         };
         node.chainman = std::make_unique<ChainstateManager>(chainman_opts);
         ChainstateManager& chainman = *node.chainman;
+        chainman.m_memory_budget = memory_budget;
 
         node::ChainstateLoadOptions options;
         options.mempool = Assert(node.mempool.get());
@@ -1448,6 +1608,7 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         options.prune = node::fPruneMode;
         options.check_blocks = args.GetIntArg("-checkblocks", DEFAULT_CHECKBLOCKS);
         options.check_level = args.GetIntArg("-checklevel", DEFAULT_CHECKLEVEL);
+        options.thread_pool = node.thread_pool.get();
         options.check_interrupt = ShutdownRequested;
         options.coins_error_cb = [] {
             uiInterface.ThreadSafeMessageBox(
@@ -1546,6 +1707,20 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         // }
     }
 
+    if (args.GetBoolArg("-conversionindex", DEFAULT_CONVERSIONINDEX)) {
+        g_conversion_index = std::make_unique<ConversionIndex>(interfaces::MakeChain(node), /* cache size */ 0, false, fReindex);
+        if (!g_conversion_index->Start()) {
+            return false;
+        }
+    }
+
+    if (args.GetBoolArg("-txospenderindex", DEFAULT_TXOSPENDERINDEX)) {
+        g_txospenderindex = std::make_unique<TxoSpenderIndex>(interfaces::MakeChain(node), /* cache size */ 0, false, fReindex);
+        if (!g_txospenderindex->Start()) {
+            return false;
+        }
+    }
+
     // ********************************************************* Step 9: load wallet
     for (const auto& client : node.chain_clients) {
         if (!client->load()) {
@@ -1608,7 +1783,8 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         vImportFiles.push_back(fs::PathFromString(strFile));
     }
 
-    chainman.m_load_block = std::thread(&util::TraceThread, "loadblk", [=, &chainman, &args] {
+    // Not a LOW priority task, as startup waits for it and it must not wait behind the index syncs
+    chainman.m_load_block = util::TaskPool{*node.thread_pool, "loadblk", util::TaskPriority::NORMAL}.Submit([=, &chainman, &args] {
         ThreadImport(chainman, vImportFiles, args, ShouldPersistMempool(args) ? MempoolPath(args) : fs::path{});
     });
 
@@ -1783,6 +1959,14 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     }
 
     connOptions.m_i2p_accept_incoming = args.GetBoolArg("-i2pacceptincoming", true);
+    connOptions.m_i2p_accept_streams = args.GetIntArg("-i2pacceptstreams", DEFAULT_I2P_ACCEPT_STREAMS);
+    connOptions.m_i2p_transient_sessions = args.GetIntArg("-i2ptransientsessions", DEFAULT_I2P_TRANSIENT_SESSIONS);
+
+    if (args.IsArgSet("-netcpus")) {
+        const auto cpus{util::ParseCpuSet(args.GetArg("-netcpus", ""))};
+        if (!cpus) return InitError(strprintf(_("Invalid CPU set for -netcpus: '%s'"), args.GetArg("-netcpus", "")));
+        connOptions.m_thread_cpus = *cpus;
+    }
 
     if (!node.connman->Start(*node.scheduler, connOptions)) {
         return false;
@@ -1814,7 +1998,21 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     BanMan* banman = node.banman.get();
     node.scheduler->scheduleEvery([banman]{
         banman->DumpBanlist();
-    }, DUMP_BANS_INTERVAL);
+    }, DUMP_BANS_INTERVAL, "banlist dump");
+
+    if (args.GetBoolArg("-blockcompression", DEFAULT_BLOCK_COMPRESSION)) {
+        node.scheduler->scheduleEvery([&chainman] {
+            const int tip_height{WITH_LOCK(::cs_main, return chainman.ActiveChain().Height())};
+            chainman.m_blockman.CompressBlockFiles(tip_height - static_cast<int>(MIN_BLOCKS_TO_KEEP), 1);
+        }, node::BLOCK_COMPRESSION_INTERVAL, "block compression");
+    }
+
+    if (chainman.m_memory_budget > 0) {
+        node.scheduler->scheduleEvery([&chainman] {
+            LOCK(::cs_main);
+            chainman.MaybeResizeToMemoryBudget();
+        }, MEMORY_BUDGET_INTERVAL, "memory budget");
+    }
 
     if (node.peerman) node.peerman->StartScheduledTasks(*node.scheduler);
 
@@ -36,6 +36,7 @@ void AddLoggingArgs(ArgsManager& argsman)
 #else
     argsman.AddHiddenArgs({"-logthreadnames"});
 #endif
+    argsman.AddArg("-logasync", strprintf("Format and write the debug output on a background thread instead of the logging thread. Debug messages are dropped if a thread logs faster than they can be written, and messages still queued are lost if the process crashes (default: %u)", DEFAULT_LOGASYNC), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-logsourcelocations", strprintf("Prepend debug output with name of the originating source location (source file, line number and function name) (default: %u)", DEFAULT_LOGSOURCELOCATIONS), ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-printtoconsole", "Send trace/debug info to console (default: 1 when no -daemon. To disable logging to file, set -nodebuglogfile)", ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
@@ -53,6 +54,7 @@ void SetLoggingOptions(const ArgsManager& args)
     LogInstance().m_log_threadnames = args.GetBoolArg("-logthreadnames", DEFAULT_LOGTHREADNAMES);
 #endif
     LogInstance().m_log_sourcelocations = args.GetBoolArg("-logsourcelocations", DEFAULT_LOGSOURCELOCATIONS);
+    LogInstance().m_log_async = args.GetBoolArg("-logasync", DEFAULT_LOGASYNC);
 
     fLogIPs = args.GetBoolArg("-logips", DEFAULT_LOGIPS);
 }
@@ -5,6 +5,7 @@
 #ifndef BITCOIN_INTERFACES_CHAIN_H
 #define BITCOIN_INTERFACES_CHAIN_H
 
+#include <blockfilter.h>
 #include <primitives/transaction.h> // For CTransactionRef
 #include <util/settings.h>          // For util::SettingsValue
 #include <script/standard.h>        // For CReserveDestination
@@ -15,6 +16,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string>
+#include <variant>
 #include <vector>
 
 class ArgsManager;
@@ -45,6 +47,13 @@ struct BlockKey {
     int height = -1;
 };
 
+//! Pending conversion in the mempool, as listed in its conversion order book.
+struct ConversionBookEntry {
+    uint256 txid;
+    CAmount input;  //!< Amount the conversion sells
+    CAmount output; //!< Minimum amount of the other type it requires in return
+};
+
 //! Helper for findBlock to selectively return pieces of block data. If block is
 //! found, data will be returned by setting specified output variables. If block
 //! is not found, output variables will keep their previous values.
@@ -148,6 +157,13 @@ public:
     //! or contents.
     virtual bool findBlock(const uint256& hash, const FoundBlock& block={}) = 0;
 
+    //! Return whether a block filter index of the given type is available.
+    virtual bool hasBlockFilterIndex(BlockFilterType filter_type) = 0;
+
+    //! Return whether any of the elements match the block via its BIP 157
+    //! block filter, or std::nullopt if the filter of the block couldn't be found.
+    virtual std::optional<bool> blockFilterMatchesAny(BlockFilterType filter_type, const uint256& block_hash, const GCSFilter::ElementSet& filter_set) = 0;
+
     //! Find first block in the chain with timestamp >= the given time
     //! and height >= than the given height, return false if there is no block
     //! with a high enough timestamp and height. Optionally return block
@@ -174,7 +190,8 @@ public:
 
     //! Look up unspent output information. Returns coins in the mempool and in
     //! the current chain UTXO set. Iterates through all the keys in the map and
-    //! populates the values.
+    //! populates the values. Coins not cached by the node are read together,
+    //! so callers should look up all the coins they need in one call.
     virtual void findCoins(std::map<COutPoint, Coin>& coins) = 0;
 
     //! Estimate fraction of total transactions verified if blocks up to
@@ -208,6 +225,14 @@ public:
     //! Required at chain start when supply of cash is zero.
     virtual CAmount estimateConvertedAmount(const CAmount& amount, const CAmountType& amountType, const bool& roundedUp = false) = 0;
 
+    //! Get pending conversions that sell inputType, sorted by the rate they
+    //! require (lowest first), stopping after max_entries.
+    virtual std::vector<ConversionBookEntry> getConversionBook(const CAmountType& inputType, size_t max_entries) = 0;
+
+    //! Get the unscaled total supply after the pending conversions in the
+    //! mempool that clear, or the tip supply if there is no mempool.
+    virtual CAmounts getProjectedSupply() = 0;
+
     //! Get last scale factor.
     virtual CAmountScaleFactor getLastScaleFactor() = 0;
 
@@ -217,6 +242,14 @@ public:
     //! Get scale factor for confirmed block height
     virtual std::optional<CAmountScaleFactor> findScaleFactorAtHeight(const int& block_height) = 0;
 
+    //! Block to get the scale factor of: a block hash, or a height in the
+    //! active chain. Heights above the tip give the scale factor of the tip.
+    using ScaleFactorQuery = std::variant<uint256, int>;
+
+    //! Get the scale factors of several blocks at once. Unknown block hashes
+    //! and negative heights give std::nullopt.
+    virtual std::vector<std::optional<CAmountScaleFactor>> findScaleFactors(const std::vector<ScaleFactorQuery>& blocks) = 0;
+
     //! Transaction is added to memory pool, if the transaction fee is below the
     //! amount specified by max_tx_fee, and broadcast to all peers if relay is set to true.
     //! Return false if the transaction could not be added due to the fee or for another reason.
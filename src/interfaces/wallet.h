@@ -101,6 +101,9 @@ public:
     //! Get wallet name.
     virtual std::string getWalletName() = 0;
 
+    //! Get the memory used by the wallet's transactions and address book.
+    virtual size_t getMemoryUsage() = 0;
+
     // Get a new address.
     virtual util::Result<CTxDestination> getNewDestination(const OutputType type, const std::string& label) = 0;
 
@@ -167,6 +170,13 @@ public:
         CAmount& fee,
         CAmountType& feeType) = 0;
 
+    //! Create a batch of conversion transactions sharing one fee estimate and coin scan.
+    virtual util::Result<std::vector<CTransactionRef>> createConversionTransactions(const std::vector<WalletConversionTxDetails>& txs_details,
+        const wallet::CCoinControl& coin_control,
+        bool sign,
+        std::vector<CAmount>& fees,
+        std::vector<CAmountType>& feeTypes) = 0;
+
     //! Commit transaction.
     virtual void commitTransaction(CTransactionRef tx,
         WalletValueMap value_map,
@@ -207,6 +217,9 @@ public:
     //! Get list of all wallet transactions.
     virtual std::set<WalletTx> getWalletTxs() = 0;
 
+    //! Get hashes of all wallet transactions, oldest first.
+    virtual std::vector<uint256> getWalletTxHashes() = 0;
+
     //! Try to get updated status for a particular transaction, if possible without blocking.
     virtual bool tryGetTxStatus(const uint256& txid,
         WalletTxStatus& tx_status,
@@ -0,0 +1,324 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kernel/blockverify.h>
+
+#include <chainparams.h>
+#include <clientversion.h>
+#include <coins.h>
+#include <consensus/consensus.h>
+#include <consensus/tx_check.h>
+#include <consensus/tx_verify.h>
+#include <deploymentstatus.h>
+#include <hash.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/interpreter.h>
+#include <script/script_error.h>
+#include <script/standard.h>
+#include <serialize.h>
+#include <span.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <undo.h>
+#include <util/thread.h>
+#include <validation.h>
+#include <version.h>
+
+#include <algorithm>
+#include <exception>
+#include <set>
+#include <string>
+#include <unordered_set>
+
+namespace kernel {
+namespace {
+/** Like ConnectBlock(), with the coins the block spends taken from its undo data */
+bool ConnectBlockFromUndo(const CBlock& block, const CBlockUndo& undo, const CBlockIndex& index, BlockValidationState& state,
+                          const Consensus::Params& consensus, VersionBitsCache& versionbitscache)
+{
+    if (undo.vtxundo.size() != block.vtx.size() - 1) {
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-undo-data", "undo data does not match the transactions");
+    }
+
+    int lock_time_flags{0};
+    if (DeploymentActiveAt(index, consensus, Consensus::DEPLOYMENT_CSV, versionbitscache)) {
+        lock_time_flags |= LOCKTIME_VERIFY_SEQUENCE;
+    }
+    const unsigned int flags{GetBlockScriptFlags(index, consensus, versionbitscache)};
+
+    std::unordered_set<uint256, SaltedTxidHasher> block_txids;
+    for (const CTransactionRef& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+    }
+
+    CCoinsView dummy;
+    CCoinsViewCache view{&dummy};
+    std::set<COutPoint> spent;
+    CBlockUndo block_undo;
+    block_undo.vtxundo.reserve(block.vtx.size() - 1);
+
+    CAmounts total_supply{index.pprev->GetTotalSupply()};
+    std::vector<int> prevheights;
+    std::vector<CTxOut> conversion_outputs;
+    CAmounts conversion_remainder_sum{0};
+    CAmounts fees{0};
+    int64_t sigops_cost{0};
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx{*block.vtx[i]};
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo{undo.vtxundo[i - 1]};
+            if (tx_undo.vprevout.size() != tx.vin.size()) {
+                return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-undo-data", "undo data does not match the inputs");
+            }
+            // Coins created earlier in the block are in the view already. Coins of
+            // other transactions of the block, or that were spent before, are
+            // missing, as they would be from the UTXO set.
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const COutPoint& prevout{tx.vin[j].prevout};
+                const Coin& coin{tx_undo.vprevout[j]};
+                if (coin.IsSpent() || view.HaveCoin(prevout) || spent.count(prevout) || block_txids.count(prevout.hash)) continue;
+                view.AddCoin(prevout, Coin{coin}, /*possible_overwrite=*/false);
+            }
+
+            CAmounts txfees{0};
+            std::optional<CTxConversionInfo> conversion_info;
+            TxValidationState tx_state;
+            if (!Consensus::CheckTxInputs(tx, tx_state, view, index.nHeight, txfees, conversion_info)) {
+                return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(), tx_state.GetDebugMessage());
+            }
+            fees[CASH] += txfees[CASH];
+            fees[BOND] += txfees[BOND];
+            if (!MoneyRange(fees[CASH]) || !MoneyRange(fees[BOND])) {
+                return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-accumulated-fee-outofrange");
+            }
+
+            if (conversion_info) {
+                CAmount remainder{0};
+                const CAmountType remainder_type{conversion_info->remainderType};
+                if (!Consensus::IsValidConversion(total_supply, conversion_info->inputs, conversion_info->minOutputs, remainder_type, remainder)) {
+                    return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-conversion-out-of-range");
+                }
+                if (remainder > 0) {
+                    if (IsValidDestination(conversion_info->destination)) {
+                        conversion_outputs.push_back(CTxOut(remainder_type, remainder, GetScriptForDestination(conversion_info->destination)));
+                        conversion_remainder_sum[remainder_type] += remainder;
+                    } else {
+                        fees[remainder_type] += remainder;
+                    }
+                }
+                if (IsExpiredConversionInfo(*conversion_info, index.nHeight)) {
+                    return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-expired", "expired conversion transaction");
+                }
+            }
+
+            prevheights.resize(tx.vin.size());
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                prevheights[j] = view.AccessCoin(tx.vin[j].prevout).nHeight;
+            }
+            if (!SequenceLocks(tx, lock_time_flags, prevheights, index)) {
+                return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-nonfinal");
+            }
+        }
+
+        sigops_cost += GetTransactionSigOpCost(tx, view, flags);
+        if (sigops_cost > MAX_BLOCK_SIGOPS_COST) {
+            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-sigops");
+        }
+
+        if (!tx.IsCoinBase()) {
+            std::vector<CTxOut> spent_outputs;
+            spent_outputs.reserve(tx.vin.size());
+            for (const CTxIn& txin : tx.vin) {
+                spent_outputs.push_back(view.AccessCoin(txin.prevout).out);
+            }
+            PrecomputedTransactionData txdata;
+            txdata.Init(tx, std::move(spent_outputs));
+            for (unsigned int j = 0; j < tx.vin.size(); ++j) {
+                const CTxOut& prev{txdata.m_spent_outputs[j]};
+                ScriptError error{SCRIPT_ERR_UNKNOWN_ERROR};
+                if (!VerifyScript(tx.vin[j].scriptSig, prev.scriptPubKey, &tx.vin[j].scriptWitness, flags,
+                                  TransactionSignatureChecker{&tx, j, prev.amountType, prev.nValue, txdata, MissingDataBehavior::ASSERT_FAIL}, &error)) {
+                    return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, strprintf("mandatory-script-verify-flag-failed (%s)", ScriptErrorString(error)));
+                }
+            }
+
+            block_undo.vtxundo.emplace_back();
+            for (const CTxIn& txin : tx.vin) {
+                block_undo.vtxundo.back().vprevout.emplace_back();
+                view.SpendCoin(txin.prevout, &block_undo.vtxundo.back().vprevout.back());
+                spent.insert(txin.prevout);
+            }
+        }
+        AddCoins(view, tx, index.nHeight);
+    }
+
+    const CTransaction& coinbase{*block.vtx[0]};
+    std::string address_with_incorrect_amount;
+    if (!CheckTransactionContainsOutputs(coinbase, conversion_outputs, address_with_incorrect_amount)) {
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-missing-conversion-output");
+    }
+
+    const CAmounts reward{GetBlockSubsidy(index.nHeight, total_supply, consensus)};
+    const CAmounts coinbase_amounts{coinbase.GetValuesOut()};
+    for (const CAmountType type : {CASH, BOND}) {
+        if (coinbase_amounts[type] > fees[type] + reward[type] + conversion_remainder_sum[type]) {
+            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-amount");
+        }
+        total_supply[type] += coinbase_amounts[type] - conversion_remainder_sum[type] - fees[type];
+    }
+    if (total_supply != index.GetTotalSupply()) {
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-total-supply");
+    }
+
+    // The undo data the coins were taken from must be what connecting the block writes
+    if (SerializeHash(block_undo) != SerializeHash(undo)) {
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-undo-data", "undo data does not match the spent coins");
+    }
+    return true;
+}
+} // namespace
+
+BlockVerifier::BlockVerifier(const CChainParams& chainparams, int worker_threads)
+    : m_chainparams{chainparams}
+{
+    if (worker_threads <= 0) worker_threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    m_max_queued = BLOCK_VERIFY_QUEUE_PER_THREAD * worker_threads;
+    for (int i = 0; i < worker_threads; ++i) {
+        m_workers.emplace_back(&util::TraceThread, strprintf("blkverify.%i", i), [this] { ThreadVerify(); });
+    }
+}
+
+BlockVerifier::~BlockVerifier()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (std::thread& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void BlockVerifier::Add(std::vector<std::byte> block, std::vector<std::byte> undo)
+{
+    Job job;
+    CBlockHeader header;
+    try {
+        SpanReader{SER_NETWORK, PROTOCOL_VERSION, MakeUCharSpan(block)} >> header;
+        job.result.hash = header.GetHash();
+    } catch (const std::exception&) {
+        job.result.state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-data", "block can not be deserialized");
+    }
+
+    // Build the chain of headers in order, which the workers check blocks against
+    CBlockIndex* const prev{m_chain.empty() ? nullptr : &m_chain.back()};
+    const bool extends_chain{prev ? header.hashPrevBlock == prev->GetBlockHash() : job.result.hash == m_chainparams.GetConsensus().hashGenesisBlock};
+    if (job.result.state.IsValid() && !extends_chain) {
+        job.result.state.Invalid(BlockValidationResult::BLOCK_MISSING_PREV, "bad-prevblk", "block does not extend the previous block");
+    } else if (job.result.state.IsValid() && prev && prev->bondSupply <= 0) {
+        // The scale factor compounds with the ratio of the previous block's supplies
+        job.result.state.Invalid(BlockValidationResult::BLOCK_INVALID_PREV, "bad-prevblk", "previous block has no bond supply");
+    } else if (job.result.state.IsValid()) {
+        m_chain_hashes.push_back(job.result.hash);
+        CBlockIndex& index{m_chain.emplace_back(header)};
+        index.phashBlock = &m_chain_hashes.back();
+        index.pprev = prev;
+        index.nHeight = prev ? prev->nHeight + 1 : 0;
+        index.BuildSkip();
+        index.BuildScaleFactor(m_chainparams.GetConsensus());
+        index.BuildMedianTimePast();
+        index.BuildSupplyViews();
+        job.index = &index;
+        job.result.height = index.nHeight;
+        job.result.total_supply = index.GetTotalSupply();
+        job.result.scale_factor = index.scaleFactor;
+        job.block = std::move(block);
+        job.undo = std::move(undo);
+    }
+
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_jobs.size() - m_verified < m_max_queued; });
+        m_jobs.push_back(std::move(job));
+    }
+    m_cond.notify_all();
+}
+
+std::vector<BlockVerificationResult> BlockVerifier::Finish()
+{
+    std::vector<BlockVerificationResult> results;
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_verified == m_jobs.size(); });
+
+        // A block is only valid if the blocks before it are
+        bool prev_valid{true};
+        results.reserve(m_jobs.size());
+        for (Job& job : m_jobs) {
+            if (job.index) {
+                if (!prev_valid && job.result.state.IsValid()) {
+                    job.result.state.Invalid(BlockValidationResult::BLOCK_INVALID_PREV, "bad-prevblk", "previous block is invalid");
+                }
+                prev_valid = job.result.state.IsValid();
+            }
+            results.push_back(std::move(job.result));
+        }
+        m_jobs.clear();
+        m_next_job = 0;
+        m_verified = 0;
+    }
+    m_chain.clear();
+    m_chain_hashes.clear();
+    m_versionbitscache.Clear();
+    return results;
+}
+
+void BlockVerifier::ThreadVerify()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_next_job < m_jobs.size() || m_stop; });
+        if (m_stop) return;
+        Job& job{m_jobs[m_next_job++]};
+        {
+            REVERSE_LOCK(lock);
+            if (job.index) Verify(job);
+        }
+        ++m_verified;
+        m_cond.notify_all();
+    }
+}
+
+void BlockVerifier::Verify(Job& job)
+{
+    const Consensus::Params& consensus{m_chainparams.GetConsensus()};
+    BlockValidationState& state{job.result.state};
+    const CBlockIndex& index{*job.index};
+
+    CBlock block;
+    CBlockUndo undo;
+    try {
+        SpanReader{SER_NETWORK, PROTOCOL_VERSION, MakeUCharSpan(job.block)} >> block;
+        if (!index.pprev && !job.undo.empty()) throw std::ios_base::failure("genesis block has no undo data");
+        if (index.pprev) SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(job.undo)} >> undo;
+    } catch (const std::exception&) {
+        state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-data", "block or undo data can not be deserialized");
+    }
+    job.block = {};
+    job.undo = {};
+
+    // The genesis block is only checked by its hash, as its coinbase is not connected
+    if (!state.IsValid() || !index.pprev) return;
+
+    if (!CheckBlock(block, state, consensus) ||
+        !ContextualCheckBlockHeader(block, state, consensus, m_versionbitscache, index.pprev) ||
+        !ContextualCheckBlock(block, state, consensus, m_versionbitscache, index.pprev)) {
+        return;
+    }
+    ConnectBlockFromUndo(block, undo, index, state, consensus, m_versionbitscache);
+}
+} // namespace kernel
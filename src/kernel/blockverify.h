@@ -0,0 +1,106 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_KERNEL_BLOCKVERIFY_H
+#define BITCOIN_KERNEL_BLOCKVERIFY_H
+
+#include <chain.h>
+#include <consensus/amount.h>
+#include <consensus/validation.h>
+#include <sync.h>
+#include <threadsafety.h>
+#include <uint256.h>
+#include <versionbits.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <thread>
+#include <vector>
+
+class CChainParams;
+
+namespace kernel {
+/** Blocks added to a BlockVerifier that may wait to be verified, per worker thread */
+static constexpr size_t BLOCK_VERIFY_QUEUE_PER_THREAD{4};
+
+/** The outcome of verifying one block with a BlockVerifier */
+struct BlockVerificationResult {
+    uint256 hash;
+    //! Height of the block, or -1 if it does not extend the blocks added before it
+    int height{-1};
+    //! Valid if the block and all blocks before it passed every check
+    BlockValidationState state;
+    //! The total supply after the block, as committed to by its header
+    CAmounts total_supply{0};
+    //! The scale factor of the block, compounded from the genesis block
+    CAmountScaleFactor scale_factor{0};
+};
+
+/**
+ * Verifies a chain of blocks from their serialized blocks and undo data, without
+ * a block index or UTXO set, so a chain can be checked independently of a node.
+ *
+ * Blocks are added in chain order starting with the genesis block. Besides the
+ * checks of the headers and transactions, the coins each block spends are taken
+ * from its undo data, so the input, conversion, script and supply checks
+ * ConnectBlock() does can run for many blocks in parallel, and the undo data
+ * is required to match what connecting the block produces. Scripts are checked
+ * without the signature cache, as every signature is only checked once.
+ *
+ * The only ConnectBlock() check left out is BIP30, which needs the UTXO set and
+ * can not be violated once coinbases commit to their height (BIP34).
+ */
+class BlockVerifier
+{
+public:
+    /** Verify blocks on worker_threads threads, or one per core if it is not positive. */
+    BlockVerifier(const CChainParams& chainparams, int worker_threads);
+    ~BlockVerifier();
+
+    /**
+     * Add the next block, serialized as in blk?????.dat, and its undo data, serialized as
+     * in rev?????.dat without the checksum (empty for the genesis block). Waits while
+     * enough blocks are queued to keep the worker threads busy.
+     */
+    void Add(std::vector<std::byte> block, std::vector<std::byte> undo) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Wait until all added blocks are verified and return their results in the order they were added. */
+    std::vector<BlockVerificationResult> Finish() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Job {
+        std::vector<std::byte> block;
+        std::vector<std::byte> undo;
+        //! Entry of the block in the chain built from the headers, if the block extends it
+        CBlockIndex* index{nullptr};
+        BlockVerificationResult result;
+    };
+
+    void ThreadVerify() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Verify(Job& job);
+
+    const CChainParams& m_chainparams;
+    VersionBitsCache m_versionbitscache;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    //! Jobs in the order the blocks were added. References stay valid as jobs are added.
+    std::deque<Job> m_jobs GUARDED_BY(m_mutex);
+    //! Index of the first job no worker has started yet
+    size_t m_next_job GUARDED_BY(m_mutex){0};
+    //! Number of jobs that are verified
+    size_t m_verified GUARDED_BY(m_mutex){0};
+    size_t m_max_queued;
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+    //! Block index entries of the chain, only touched by Add(), and by workers through their job's entry
+    std::deque<CBlockIndex> m_chain;
+    std::deque<uint256> m_chain_hashes;
+
+    std::vector<std::thread> m_workers;
+};
+} // namespace kernel
+
+#endif // BITCOIN_KERNEL_BLOCKVERIFY_H
@@ -14,6 +14,9 @@ class CChainParams;
 
 namespace kernel {
 
+/** Percentage of the coins caches given to the background chainstate once the snapshot chainstate is synced */
+static constexpr int DEFAULT_BACKGROUND_CACHE_PERCENT{95};
+
 /**
  * An options struct for `ChainstateManager`, more ergonomically referred to as
  * `ChainstateManager::Options` due to the using-declaration in
@@ -22,6 +25,9 @@ namespace kernel {
 struct ChainstateManagerOpts {
     const CChainParams& chainparams;
     const std::function<NodeClock::time_point()> adjusted_time_callback{nullptr};
+    //! Percentage of the coins caches given to the background validation chainstate of a
+    //! snapshot, once the snapshot chainstate is synced. Until then it gets 5%.
+    int background_cache_percent{DEFAULT_BACKGROUND_CACHE_PERCENT};
 };
 
 } // namespace kernel
@@ -20,9 +20,12 @@
 #include <util/check.h>
 #include <util/overflow.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <validation.h>
 #include <version.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iosfwd>
 #include <iterator>
@@ -30,9 +33,13 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace kernel {
 
+/** Number of key ranges, one per first byte of the txid, that the coins database is split into for parallel computation */
+static constexpr size_t UTXO_STATS_RANGE_COUNT{256};
+
 CCoinsStats::CCoinsStats(int block_height, const uint256& block_hash)
     : nHeight(block_height),
       hashBlock(block_hash) {}
@@ -68,7 +75,7 @@ CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin) {
 //! It is also possible, though very unlikely, that a change in this
 //! construction could cause a previously invalid (and potentially malicious)
 //! UTXO snapshot to be considered valid.
-static void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     for (auto it = outputs.begin(); it != outputs.end(); ++it) {
         if (it == outputs.begin()) {
@@ -97,6 +104,13 @@ static void ApplyHash(MuHash3072& muhash, const uint256& hash, const std::map<ui
     }
 }
 
+// Only hashes that don't depend on the order of the coins can be combined
+static void CombineHash(MuHash3072& muhash, const MuHash3072& partial)
+{
+    muhash *= partial;
+}
+static void CombineHash(std::nullptr_t, std::nullptr_t) {}
+
 static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     assert(!outputs.empty());
@@ -112,22 +126,37 @@ static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<u
     }
 }
 
-//! Calculate statistics about the unspent transaction output set
-template <typename T>
-static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+static void AddStats(CCoinsStats& stats, const CCoinsStats& other)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
-
-    PrepareHash(hash_obj, stats);
+    stats.nTransactions += other.nTransactions;
+    stats.nTransactionOutputs += other.nTransactionOutputs;
+    stats.nBogoSize += other.nBogoSize;
+    stats.coins_count += other.coins_count;
+    if (stats.total_amount_cash.has_value() && other.total_amount_cash.has_value()) {
+        stats.total_amount_cash = CheckedAdd(*stats.total_amount_cash, *other.total_amount_cash);
+    } else {
+        stats.total_amount_cash.reset();
+    }
+    if (stats.total_amount_bond.has_value() && other.total_amount_bond.has_value()) {
+        stats.total_amount_bond = CheckedAdd(*stats.total_amount_bond, *other.total_amount_bond);
+    } else {
+        stats.total_amount_bond.reset();
+    }
+}
 
+//! Apply the coins from the cursor's position to the end, or only those whose
+//! txid starts with the byte range if given, to the statistics and hash
+template <typename T>
+static bool ApplyCoins(CCoinsViewCursor& cursor, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point, std::optional<uint8_t> range)
+{
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
+    while (cursor.Valid()) {
         interruption_point();
         COutPoint key;
         Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+        if (cursor.GetKey(key) && cursor.GetValue(coin)) {
+            if (range && *key.hash.begin() != *range) break;
             if (!outputs.empty() && key.hash != prevkey) {
                 ApplyStats(stats, prevkey, outputs);
                 ApplyHash(hash_obj, prevkey, outputs);
@@ -139,12 +168,89 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
         } else {
             return error("%s: unable to read value", __func__);
         }
-        pcursor->Next();
+        cursor.Next();
     }
     if (!outputs.empty()) {
         ApplyStats(stats, prevkey, outputs);
         ApplyHash(hash_obj, prevkey, outputs);
     }
+    return true;
+}
+
+//! Calculate statistics about the unspent transaction output set
+template <typename T>
+static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+{
+    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+    assert(pcursor);
+
+    PrepareHash(hash_obj, stats);
+
+    if (!ApplyCoins(*pcursor, stats, hash_obj, interruption_point, std::nullopt)) return false;
+
+    FinalizeHash(hash_obj, stats);
+
+    stats.nDiskSize = view->EstimateSize();
+
+    return true;
+}
+
+/**
+ * Calculate statistics about the unspent transaction output set for a hash
+ * that doesn't depend on the order coins are added in. The coins database is
+ * split into key ranges, one per first byte of the txid, so that all outputs
+ * of a transaction are in one range. Tasks of the shared thread pool take the
+ * next range left, each with its own cursor and partial statistics and hash,
+ * which are combined at the end.
+ */
+template <typename T>
+static bool ComputeUTXOStatsParallel(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+{
+    const size_t num_threads{static_cast<size_t>(std::max(GetNumCores(), 1))};
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    {
+        // The coins database is only written to under cs_main, so the cursors
+        // all read the same snapshot
+        LOCK(::cs_main);
+        for (size_t i = 0; i < num_threads; ++i) {
+            cursors.emplace_back(view->Cursor());
+            assert(cursors.back());
+        }
+    }
+    for (const auto& cursor : cursors) {
+        if (cursor->GetBestBlock() != stats.hashBlock) {
+            return error("%s: coins database changed while starting the computation", __func__);
+        }
+    }
+
+    PrepareHash(hash_obj, stats);
+
+    std::vector<CCoinsStats> partial_stats(num_threads);
+    std::vector<T> partial_hashes(num_threads);
+    std::atomic<size_t> next_range{0};
+    std::atomic<bool> failed{false};
+    util::ParallelFor("utxostats", util::TaskPriority::NORMAL, num_threads, num_threads, [&](size_t thread) {
+        try {
+            for (size_t range = next_range++; range < UTXO_STATS_RANGE_COUNT && !failed; range = next_range++) {
+                uint256 start;
+                *start.begin() = range;
+                cursors[thread]->Seek(COutPoint{start, 0});
+                if (!ApplyCoins(*cursors[thread], partial_stats[thread], partial_hashes[thread], interruption_point, static_cast<uint8_t>(range))) {
+                    failed = true;
+                }
+            }
+        } catch (...) {
+            // Stop the other tasks, and leave the exception to ParallelFor to rethrow
+            failed = true;
+            throw;
+        }
+    });
+    if (failed) return false;
+
+    for (size_t i = 0; i < num_threads; ++i) {
+        AddStats(stats, partial_stats[i]);
+        CombineHash(hash_obj, partial_hashes[i]);
+    }
 
     FinalizeHash(hash_obj, stats);
 
@@ -166,10 +272,10 @@ std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsV
         }
         case(CoinStatsHashType::MUHASH): {
             MuHash3072 muhash;
-            return ComputeUTXOStats(view, stats, muhash, interruption_point);
+            return ComputeUTXOStatsParallel(view, stats, muhash, interruption_point);
         }
         case(CoinStatsHashType::NONE): {
-            return ComputeUTXOStats(view, stats, nullptr, interruption_point);
+            return ComputeUTXOStatsParallel(view, stats, nullptr, interruption_point);
         }
         } // no default case, so the compiler can warn about missing cases
         assert(false);
@@ -11,12 +11,14 @@
 
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <optional>
 
 class CCoinsView;
 class Coin;
 class COutPoint;
 class CScript;
+class HashWriter;
 namespace node {
 class BlockManager;
 } // namespace node
@@ -75,6 +77,10 @@ uint64_t GetBogoSize(const CScript& script_pub_key);
 
 CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin);
 
+//! Add the outputs of one transaction to a HASH_SERIALIZED hash, exactly as
+//! ComputeUTXOStats() does when it reaches them in the coins database.
+void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs);
+
 std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
 } // namespace kernel
 
@@ -4,6 +4,7 @@
 
 #include <kernel/context.h>
 
+#include <crypto/blake3_header.h>
 #include <crypto/sha256.h>
 #include <key.h>
 #include <logging.h>
@@ -19,6 +20,7 @@ Context::Context()
 {
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    LogPrintf("Using the '%s' BLAKE3 implementation\n", Blake3AutoDetect());
     RandomInit();
     ECC_Start();
     ecc_verify_handle.reset(new ECCVerifyHandle());
@@ -35,7 +35,12 @@ using fsbridge::FopenFn;
 
 namespace kernel {
 
+// Only transactions, times and fee deltas are stored: normalized fees and
+// conversion info depend on the chain at load time and are recomputed when
+// the transactions are accepted again.
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+/** Number of transactions loaded from the mempool file that are validated together */
+static const size_t MEMPOOL_LOAD_BATCH_SIZE = 100;
 
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, FopenFn mockable_fopen_function)
 {
@@ -63,6 +68,8 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
         }
         uint64_t num;
         file >> num;
+        std::vector<CTransactionRef> batch;
+        std::vector<int64_t> batch_times;
         while (num) {
             --num;
             CTransactionRef tx;
@@ -77,24 +84,31 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
                 pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
             }
             if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
-                LOCK(cs_main);
-                const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
-                if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+                batch.push_back(std::move(tx));
+                batch_times.push_back(nTime);
+            } else {
+                ++expired;
+            }
+            if (batch.size() < MEMPOOL_LOAD_BATCH_SIZE && num) continue;
+
+            const auto results{WITH_LOCK(cs_main, return AcceptToMemoryPoolBatch(active_chainstate, batch, batch_times, /*bypass_limits=*/false))};
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (results[i].m_result_type == MempoolAcceptResult::ResultType::VALID) {
                     ++count;
                 } else {
                     // mempool may contain the transaction already, e.g. from
                     // wallet(s) having loaded it while we were processing
                     // mempool transactions; consider these as valid, instead of
                     // failed, but mark them as 'already there'
-                    if (pool.exists(GenTxid::Txid(tx->GetHash()))) {
+                    if (pool.exists(GenTxid::Txid(batch[i]->GetHash()))) {
                         ++already_there;
                     } else {
                         ++failed;
                     }
                 }
-            } else {
-                ++expired;
             }
+            batch.clear();
+            batch_times.clear();
             if (ShutdownRequested())
                 return false;
         }
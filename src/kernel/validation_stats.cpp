@@ -0,0 +1,62 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kernel/validation_stats.h>
+
+#include <crypto/common.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace kernel {
+
+std::string ValidationStageName(ValidationStage stage)
+{
+    switch (stage) {
+    case ValidationStage::INPUTS_FETCH: return "inputs_fetch";
+    case ValidationStage::CONVERSION_EVAL: return "conversion_eval";
+    case ValidationStage::SCRIPT_CHECKS: return "script_checks";
+    case ValidationStage::UNDO_WRITE: return "undo_write";
+    case ValidationStage::FLUSH: return "flush";
+    case ValidationStage::REMOVE_FOR_BLOCK: return "remove_for_block";
+    case ValidationStage::UPDATE_NORMALIZED_FEES: return "update_normalized_fees";
+    case ValidationStage::CONNECT_TIP: return "connect_tip";
+    case ValidationStage::COINS_WRITE: return "coins_write";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+size_t LatencyHistogram::BucketIndex(std::chrono::microseconds duration)
+{
+    const uint64_t us = std::max<int64_t>(duration.count(), 0);
+    // The smallest i with us <= 2^i
+    const size_t index = us <= 1 ? 0 : CountBits(us - 1);
+    return std::min(index, NUM_BUCKETS - 1);
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds duration)
+{
+    m_buckets[BucketIndex(duration)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total_us.fetch_add(std::max<int64_t>(duration.count(), 0), std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const
+{
+    Snapshot snapshot;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count = m_count.load(std::memory_order_relaxed);
+    snapshot.total_us = m_total_us.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+LatencyHistogram& GetValidationStageHistogram(ValidationStage stage)
+{
+    static std::array<LatencyHistogram, VALIDATION_STAGE_COUNT> g_histograms;
+    return g_histograms[static_cast<size_t>(stage)];
+}
+
+} // namespace kernel
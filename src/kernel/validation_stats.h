@@ -0,0 +1,79 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_KERNEL_VALIDATION_STATS_H
+#define BITCOIN_KERNEL_VALIDATION_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kernel {
+
+/** Stages of connecting a block whose latencies are recorded. */
+enum class ValidationStage : size_t {
+    INPUTS_FETCH,           //!< Warming the coins cache with the block's inputs
+    CONVERSION_EVAL,        //!< Evaluating the block's conversions (only recorded for blocks with conversions)
+    SCRIPT_CHECKS,          //!< Checking the transaction inputs and scripts, including waiting for the script check queue
+    UNDO_WRITE,             //!< Writing the block undo data
+    FLUSH,                  //!< Flushing the block's coins view into the coins tip
+    REMOVE_FOR_BLOCK,       //!< CTxMemPool::removeForBlock, including UPDATE_NORMALIZED_FEES
+    UPDATE_NORMALIZED_FEES, //!< CTxMemPool::UpdateNormalizedFees
+    CONNECT_TIP,            //!< A whole ActivateBestChain step connecting one block
+    COINS_WRITE,            //!< Writing the coins cache to the database in a full flush, or handing it to the background writer
+};
+
+static constexpr size_t VALIDATION_STAGE_COUNT{static_cast<size_t>(ValidationStage::COINS_WRITE) + 1};
+
+/** Name of a stage as used by the RPC and REST interfaces. */
+std::string ValidationStageName(ValidationStage stage);
+
+/**
+ * Fixed-bucket latency histogram with microsecond resolution.
+ *
+ * Bucket i counts durations of at most 2^i microseconds (and more than the
+ * previous bucket's bound), the last bucket counts everything above. Recording
+ * is a handful of relaxed atomic increments, so it is safe to call from any
+ * thread without a lock; a snapshot taken concurrently with Record() may be
+ * off by the samples in flight.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t NUM_BUCKETS{28};
+
+    struct Snapshot {
+        std::array<uint64_t, NUM_BUCKETS> buckets{};
+        uint64_t count{0};
+        uint64_t total_us{0};
+    };
+
+    void Record(std::chrono::microseconds duration);
+    Snapshot GetSnapshot() const;
+
+    /** Inclusive upper bound of bucket i in microseconds. The last bucket is unbounded. */
+    static constexpr uint64_t BucketUpperBound(size_t i) { return uint64_t{1} << i; }
+    static size_t BucketIndex(std::chrono::microseconds duration);
+
+private:
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_total_us{0};
+};
+
+/** The process-wide histogram of a stage. */
+LatencyHistogram& GetValidationStageHistogram(ValidationStage stage);
+
+/** Record a stage latency. */
+inline void RecordValidationStage(ValidationStage stage, std::chrono::microseconds duration)
+{
+    GetValidationStageHistogram(stage).Record(duration);
+}
+
+} // namespace kernel
+
+#endif // BITCOIN_KERNEL_VALIDATION_STATS_H
@@ -11,8 +11,11 @@
 
 #include <algorithm>
 #include <array>
+#include <condition_variable>
 #include <mutex>
 #include <optional>
+#include <thread>
+#include <vector>
 
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
 constexpr auto MAX_USER_SETABLE_SEVERITY_LEVEL{BCLog::Level::Info};
@@ -45,9 +48,133 @@ static int FileWriteStr(const std::string &str, FILE *fp)
     return fwrite(str.data(), 1, str.size(), fp);
 }
 
+namespace BCLog {
+/** A message queued for the asynchronous writer, formatted by the writer */
+struct AsyncLogRecord {
+    uint64_t sequence;
+    int64_t time_micros;
+    std::chrono::seconds mocktime;
+    LogFlags category;
+    Level level;
+    bool started_new_line;
+    std::string str;
+    //! Only set if the matching prefix is enabled
+    std::string logging_function;
+    std::string source_file;
+    int source_line{0};
+    std::string threadname;
+};
+
+/**
+ * Single-producer single-consumer ring of the messages of one thread. Only
+ * the owning thread pushes and only the writer thread pops, so neither needs
+ * a lock.
+ */
+class AsyncLogRing
+{
+    std::vector<AsyncLogRecord> m_records;
+    const uint64_t m_mask;
+    std::atomic<uint64_t> m_head{0}; //!< Next record to pop, written by the writer
+    std::atomic<uint64_t> m_tail{0}; //!< Next record to push, written by the owner
+
+public:
+    //! Set when the owning thread exits, so the writer can drop the ring once it is drained
+    std::atomic<bool> m_orphaned{false};
+
+    explicit AsyncLogRing(size_t size) : m_records(size), m_mask{size - 1} {}
+
+    bool TryPush(AsyncLogRecord&& record)
+    {
+        const uint64_t tail{m_tail.load(std::memory_order_relaxed)};
+        if (tail - m_head.load(std::memory_order_acquire) == m_records.size()) return false;
+        m_records[tail & m_mask] = std::move(record);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return m_records.size(); }
+
+    void PopAll(std::vector<AsyncLogRecord>& out)
+    {
+        uint64_t head{m_head.load(std::memory_order_relaxed)};
+        const uint64_t tail{m_tail.load(std::memory_order_acquire)};
+        for (; head != tail; ++head) out.push_back(std::move(m_records[head & m_mask]));
+        m_head.store(head, std::memory_order_release);
+    }
+};
+
+class AsyncLogWriter
+{
+public:
+    size_t m_ring_size{DEFAULT_LOG_ASYNC_BUFFER};
+    //! Incremented by every start of the writer, which drops the rings of the previous run
+    uint64_t m_generation{0};
+    std::atomic<uint64_t> m_next_sequence{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<bool> m_stop{false};
+
+    //! Set by callers whose ring fills up, so that the writer does not wait for the next interval
+    std::atomic<bool> m_wake_requested{false};
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+
+    StdMutex m_rings_mutex;
+    std::vector<std::shared_ptr<AsyncLogRing>> m_rings GUARDED_BY(m_rings_mutex);
+
+    AsyncLogRing& ThreadRing();
+
+    void Wake()
+    {
+        if (!m_wake_requested.exchange(true)) {
+            std::lock_guard<std::mutex> lock(m_wake_mutex);
+            m_wake.notify_one();
+        }
+    }
+
+    std::vector<std::shared_ptr<AsyncLogRing>> Rings()
+    {
+        StdLockGuard lock(m_rings_mutex);
+        return m_rings;
+    }
+};
+
+namespace {
+/** The ring of the current thread, orphaned when the thread exits */
+struct ThreadLogRing {
+    const AsyncLogWriter* writer{nullptr};
+    uint64_t generation{0};
+    std::shared_ptr<AsyncLogRing> ring;
+
+    ~ThreadLogRing()
+    {
+        if (ring) ring->m_orphaned = true;
+    }
+};
+thread_local ThreadLogRing g_thread_log_ring;
+} // namespace
+
+AsyncLogRing& AsyncLogWriter::ThreadRing()
+{
+    ThreadLogRing& local{g_thread_log_ring};
+    if (local.writer != this || local.generation != m_generation) {
+        if (local.ring) local.ring->m_orphaned = true;
+        local.ring = std::make_shared<AsyncLogRing>(m_ring_size);
+        local.writer = this;
+        local.generation = m_generation;
+        StdLockGuard lock(m_rings_mutex);
+        m_rings.push_back(local.ring);
+    }
+    return *local.ring;
+}
+} // namespace BCLog
+
 bool BCLog::Logger::StartLogging()
 {
-    StdLockGuard scoped_lock(m_cs);
 
     assert(m_buffering);
     assert(m_fileout == nullptr);
@@ -81,11 +208,103 @@ bool BCLog::Logger::StartLogging()
     }
     if (m_print_to_console) fflush(stdout);
 
+    if (m_log_async) StartAsyncWriter();
+
     return true;
 }
 
+void BCLog::Logger::StartAsyncWriter(size_t buffer_messages)
+{
+    assert(buffer_messages > 0 && (buffer_messages & (buffer_messages - 1)) == 0);
+    if (m_async) return;
+    if (!m_async_writer) m_async_writer = std::make_shared<AsyncLogWriter>();
+    m_async_writer->m_ring_size = buffer_messages;
+    // Rings of an earlier run are empty, have them recreated at the new size
+    ++m_async_writer->m_generation;
+    {
+        StdLockGuard lock(m_async_writer->m_rings_mutex);
+        m_async_writer->m_rings.clear();
+    }
+    m_async_writer->m_stop = false;
+    m_async_thread = std::thread{[this] { RunAsyncWriter(); }};
+    m_async = true;
+}
+
+void BCLog::Logger::StopAsyncWriter()
+{
+    if (!m_async.exchange(false)) return;
+    // Wait for callers that saw m_async set to queue their message
+    while (m_async_callers.load() > 0) std::this_thread::yield();
+    m_async_writer->m_stop = true;
+    {
+        std::lock_guard<std::mutex> lock(m_async_writer->m_wake_mutex);
+        m_async_writer->m_wake.notify_one();
+    }
+    m_async_thread.join();
+}
+
+uint64_t BCLog::Logger::DroppedMessages() const
+{
+    return m_async_writer ? m_async_writer->m_dropped.load() : 0;
+}
+
+/** How often the asynchronous writer writes the queued messages, unless a buffer fills up earlier */
+static constexpr auto ASYNC_LOG_WRITE_INTERVAL{std::chrono::milliseconds{50}};
+
+void BCLog::Logger::RunAsyncWriter()
+{
+    util::ThreadRename("logger");
+    AsyncLogWriter& writer{*m_async_writer};
+    std::vector<AsyncLogRecord> records;
+    std::vector<std::string> lines;
+    uint64_t reported_dropped{writer.m_dropped.load()};
+    while (true) {
+        // Read before draining, so that nothing queued before the stop is missed
+        const bool stop{writer.m_stop};
+        writer.m_wake_requested = false;
+        records.clear();
+        for (const auto& ring : writer.Rings()) {
+            ring->PopAll(records);
+            if (ring->m_orphaned && ring->Size() == 0) {
+                StdLockGuard lock(writer.m_rings_mutex);
+                writer.m_rings.erase(std::find(writer.m_rings.begin(), writer.m_rings.end(), ring));
+            }
+        }
+        const uint64_t dropped{writer.m_dropped.load()};
+
+        if (records.empty() && dropped == reported_dropped) {
+            // Only stop once a drain after the stop request found nothing
+            if (stop) break;
+        } else {
+            // Restore the order in which the messages were logged across
+            // threads, then format them outside of the lock
+            std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) { return a.sequence < b.sequence; });
+            lines.clear();
+            for (const AsyncLogRecord& record : records) {
+                lines.push_back(FormatLogStr(record.str, record.logging_function, record.source_file, record.source_line, record.category, record.level,
+                                             record.threadname, record.started_new_line, record.time_micros, record.mocktime));
+            }
+            if (dropped != reported_dropped) {
+                lines.push_back(FormatLogStr(strprintf("Dropped %u debug messages because the log buffer of their thread was full\n", dropped - reported_dropped),
+                                             "", "", 0, LogFlags::NONE, Level::Warning, "logger", true, GetTimeMicros(), GetMockTime()));
+                reported_dropped = dropped;
+            }
+
+            StdLockGuard scoped_lock(m_cs);
+            for (const std::string& line : lines) WriteLogStr(line);
+            if (m_print_to_console) fflush(stdout);
+        }
+
+        if (!stop) {
+            std::unique_lock<std::mutex> lock(writer.m_wake_mutex);
+            writer.m_wake.wait_for(lock, ASYNC_LOG_WRITE_INTERVAL, [&] { return writer.m_wake_requested || writer.m_stop; });
+        }
+    }
+}
+
 void BCLog::Logger::DisconnectTestLogger()
 {
+    StopAsyncWriter();
     StdLockGuard scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) fclose(m_fileout);
@@ -180,6 +399,7 @@ const CLogCategoryDesc LogCategories[] =
 #endif
     {BCLog::UTIL, "util"},
     {BCLog::BLOCKSTORE, "blockstorage"},
+    {BCLog::TXRECONCILIATION, "txreconciliation"},
     {BCLog::ALL, "1"},
     {BCLog::ALL, "all"},
 };
@@ -280,6 +500,8 @@ std::string LogCategoryToStr(BCLog::LogFlags category)
         return "util";
     case BCLog::LogFlags::BLOCKSTORE:
         return "blockstorage";
+    case BCLog::LogFlags::TXRECONCILIATION:
+        return "txreconciliation";
     case BCLog::LogFlags::ALL:
         return "all";
     }
@@ -335,21 +557,20 @@ std::string BCLog::Logger::LogLevelsString() const
     return Join(std::vector<BCLog::Level>{levels.begin(), levels.end()}, ", ", [this](BCLog::Level level) { return LogLevelToStr(level); });
 }
 
-std::string BCLog::Logger::LogTimestampStr(const std::string& str)
+std::string BCLog::Logger::LogTimestampStr(const std::string& str, bool started_new_line, int64_t time_micros, std::chrono::seconds mocktime) const
 {
     std::string strStamped;
 
     if (!m_log_timestamps)
         return str;
 
-    if (m_started_new_line) {
-        int64_t nTimeMicros = GetTimeMicros();
+    if (started_new_line) {
+        int64_t nTimeMicros = time_micros;
         strStamped = FormatISO8601DateTime(nTimeMicros/1000000);
         if (m_log_time_micros) {
             strStamped.pop_back();
             strStamped += strprintf(".%06dZ", nTimeMicros%1000000);
         }
-        std::chrono::seconds mocktime = GetMockTime();
         if (mocktime > 0s) {
             strStamped += " (mocktime: " + FormatISO8601DateTime(count_seconds(mocktime)) + ")";
         }
@@ -382,12 +603,12 @@ namespace BCLog {
     }
 } // namespace BCLog
 
-void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
+std::string BCLog::Logger::FormatLogStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level,
+                                       const std::string& threadname, bool started_new_line, int64_t time_micros, std::chrono::seconds mocktime) const
 {
-    StdLockGuard scoped_lock(m_cs);
     std::string str_prefixed = LogEscapeMessage(str);
 
-    if ((category != LogFlags::NONE || level != Level::None) && m_started_new_line) {
+    if ((category != LogFlags::NONE || level != Level::None) && started_new_line) {
         std::string s{"["};
 
         if (category != LogFlags::NONE) {
@@ -407,18 +628,63 @@ void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& loggi
         str_prefixed.insert(0, s);
     }
 
-    if (m_log_sourcelocations && m_started_new_line) {
+    if (m_log_sourcelocations && started_new_line) {
         str_prefixed.insert(0, "[" + RemovePrefix(source_file, "./") + ":" + ToString(source_line) + "] [" + logging_function + "] ");
     }
 
-    if (m_log_threadnames && m_started_new_line) {
-        const auto& threadname = util::ThreadGetInternalName();
+    if (m_log_threadnames && started_new_line) {
         str_prefixed.insert(0, "[" + (threadname.empty() ? "unknown" : threadname) + "] ");
     }
 
-    str_prefixed = LogTimestampStr(str_prefixed);
+    return LogTimestampStr(str_prefixed, started_new_line, time_micros, mocktime);
+}
+
+void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
+{
+    const bool ends_line{!str.empty() && str[str.size()-1] == '\n'};
+
+    if (m_async.load(std::memory_order_relaxed)) {
+        ++m_async_callers;
+        if (m_async) {
+            AsyncLogWriter& writer{*m_async_writer};
+            AsyncLogRecord record;
+            record.sequence = writer.m_next_sequence.fetch_add(1, std::memory_order_relaxed);
+            record.time_micros = GetTimeMicros();
+            record.mocktime = GetMockTime();
+            record.category = category;
+            record.level = level;
+            record.started_new_line = m_started_new_line.exchange(ends_line);
+            record.str = str;
+            if (m_log_sourcelocations) {
+                record.logging_function = logging_function;
+                record.source_file = source_file;
+                record.source_line = source_line;
+            }
+            if (m_log_threadnames) record.threadname = util::ThreadGetInternalName();
+            AsyncLogRing& ring{writer.ThreadRing()};
+            if (ring.TryPush(std::move(record))) {
+                if (ring.Size() >= ring.Capacity() / 2) writer.Wake();
+            } else if (category != LogFlags::NONE && level < Level::Warning) {
+                ++writer.m_dropped;
+                writer.Wake();
+            } else {
+                // Never drop unconditional messages, warnings and errors
+                do {
+                    writer.Wake();
+                    std::this_thread::yield();
+                } while (!ring.TryPush(std::move(record)));
+            }
+            --m_async_callers;
+            return;
+        }
+        --m_async_callers;
+    }
+
+    StdLockGuard scoped_lock(m_cs);
+    const std::string str_prefixed{FormatLogStr(str, logging_function, source_file, source_line, category, level, util::ThreadGetInternalName(),
+                                                m_started_new_line, GetTimeMicros(), GetMockTime())};
 
-    m_started_new_line = !str.empty() && str[str.size()-1] == '\n';
+    m_started_new_line = ends_line;
 
     if (m_buffering) {
         // buffer if we haven't started logging yet
@@ -426,6 +692,11 @@ void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& loggi
         return;
     }
 
+    WriteLogStr(str_prefixed);
+}
+
+void BCLog::Logger::WriteLogStr(const std::string& str_prefixed)
+{
     if (m_print_to_console) {
         // print to console
         fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
@@ -12,11 +12,14 @@
 #include <util/string.h>
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -25,6 +28,9 @@ static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
 static const bool DEFAULT_LOGSOURCELOCATIONS = false;
+static const bool DEFAULT_LOGASYNC = false;
+//! Number of messages each thread can queue for the asynchronous log writer
+static constexpr size_t DEFAULT_LOG_ASYNC_BUFFER{1024};
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -66,6 +72,7 @@ namespace BCLog {
 #endif
         UTIL        = (1 << 25),
         BLOCKSTORE  = (1 << 26),
+        TXRECONCILIATION = (1 << 27),
         ALL         = ~(uint32_t)0,
     };
     enum class Level {
@@ -78,6 +85,8 @@ namespace BCLog {
     };
     constexpr auto DEFAULT_LOG_LEVEL{Level::Debug};
 
+    class AsyncLogWriter;
+
     class Logger
     {
     private:
@@ -104,7 +113,26 @@ namespace BCLog {
         /** Log categories bitfield. */
         std::atomic<uint32_t> m_categories{0};
 
-        std::string LogTimestampStr(const std::string& str);
+        std::string LogTimestampStr(const std::string& str, bool started_new_line, int64_t time_micros, std::chrono::seconds mocktime) const;
+
+        /** Add the configured prefixes and timestamp to a message */
+        std::string FormatLogStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level,
+                                 const std::string& threadname, bool started_new_line, int64_t time_micros, std::chrono::seconds mocktime) const;
+        /** Write a formatted message to all outputs */
+        void WriteLogStr(const std::string& str) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
+        /**
+         * Whether messages are queued for the asynchronous writer, and the
+         * number of threads that may be queueing one. StopAsyncWriter() waits
+         * for the latter to drop to zero after clearing the former.
+         */
+        std::atomic<bool> m_async{false};
+        std::atomic<int> m_async_callers{0};
+        //! Created by the first StartAsyncWriter() and kept for the lifetime of the logger
+        std::shared_ptr<AsyncLogWriter> m_async_writer;
+        std::thread m_async_thread;
+
+        void RunAsyncWriter();
 
         /** Slots that connect to the print signal */
         std::list<std::function<void(const std::string&)>> m_print_callbacks GUARDED_BY(m_cs) {};
@@ -117,6 +145,7 @@ namespace BCLog {
         bool m_log_time_micros = DEFAULT_LOGTIMEMICROS;
         bool m_log_threadnames = DEFAULT_LOGTHREADNAMES;
         bool m_log_sourcelocations = DEFAULT_LOGSOURCELOCATIONS;
+        bool m_log_async = DEFAULT_LOGASYNC;
 
         fs::path m_file_path;
         std::atomic<bool> m_reopen_file{false};
@@ -146,8 +175,22 @@ namespace BCLog {
             m_print_callbacks.erase(it);
         }
 
-        /** Start logging (and flush all buffered messages) */
+        /** Start logging (and flush all buffered messages), asynchronously if m_log_async is set */
         bool StartLogging();
+
+        /**
+         * Start a thread that formats and writes the log. Callers then only
+         * queue their message in a lock-free buffer of their thread, which
+         * holds up to buffer_messages messages. If the buffer of a thread is
+         * full, its debug messages are dropped and counted, while unconditional
+         * messages, warnings and errors wait for space. Messages of different
+         * threads may be written slightly out of order.
+         */
+        void StartAsyncWriter(size_t buffer_messages = DEFAULT_LOG_ASYNC_BUFFER);
+        /** Write all queued messages, stop the writer thread and log synchronously again */
+        void StopAsyncWriter();
+        /** Number of debug messages dropped because the buffer of their thread was full */
+        uint64_t DroppedMessages() const;
         /** Only for testing */
         void DisconnectTestLogger();
 
@@ -19,6 +19,7 @@
 #include <node/eviction.h>
 #include <fs.h>
 #include <i2p.h>
+#include <memusage.h>
 #include <net_permissions.h>
 #include <netaddress.h>
 #include <netbase.h>
@@ -496,7 +497,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
             if (m_i2p_sam_session) {
                 connected = m_i2p_sam_session->Connect(addrConnect, conn, proxyConnectionFailed);
             } else {
-                i2p_transient_session = std::make_unique<i2p::sam::Session>(proxy.proxy, &interruptNet);
+                i2p_transient_session = TakeI2PTransientSession(proxy.proxy);
                 connected = i2p_transient_session->Connect(addrConnect, conn, proxyConnectionFailed);
             }
 
@@ -631,7 +632,9 @@ void CNode::CopyStats(CNodeStats& stats)
         LOCK(cs_vSend);
         X(mapSendBytesPerMsgType);
         X(nSendBytes);
+        stats.m_send_queue_size = nSendSize;
     }
+    stats.m_process_queue_size = WITH_LOCK(cs_vProcessMsg, return nProcessQueueSize);
     {
         LOCK(cs_vRecv);
         X(mapRecvBytesPerMsgType);
@@ -811,34 +814,158 @@ void V1TransportSerializer::prepareForTransport(CSerializedNetMsg& msg, std::vec
     CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
 }
 
+int V2TransportDeserializer::readLength(Span<const uint8_t> msg_bytes)
+{
+    unsigned int nRemaining = CHACHA20_POLY1305_AEAD_AAD_LEN - m_pos;
+    unsigned int nCopy = std::min<unsigned int>(nRemaining, msg_bytes.size());
+
+    vRecv.resize(CHACHA20_POLY1305_AEAD_AAD_LEN);
+    memcpy(&vRecv[m_pos], msg_bytes.data(), nCopy);
+    m_pos += nCopy;
+
+    // if length incomplete, exit
+    if (m_pos < CHACHA20_POLY1305_AEAD_AAD_LEN)
+        return nCopy;
+
+    m_aead.GetLength(&m_payload_size, m_sequence.m_aad, m_sequence.m_aad_pos, UCharCast(vRecv.data()));
+
+    // reject messages larger than MAX_SIZE or MAX_PROTOCOL_MESSAGE_LENGTH, leaving room for the message type
+    if (m_payload_size > MAX_SIZE || m_payload_size > MAX_PROTOCOL_MESSAGE_LENGTH + 1 + CMessageHeader::COMMAND_SIZE) {
+        LogPrint(BCLog::NET, "V2 packet error: Size too large (%u bytes), peer=%d\n", m_payload_size, m_node_id);
+        return -1;
+    }
+
+    // switch state to reading payload and MAC
+    in_data = true;
+
+    return nCopy;
+}
+
+int V2TransportDeserializer::readData(Span<const uint8_t> msg_bytes)
+{
+    unsigned int nRemaining = PacketSize() - m_pos;
+    unsigned int nCopy = std::min<unsigned int>(nRemaining, msg_bytes.size());
+
+    if (vRecv.size() < m_pos + nCopy) {
+        // Allocate up to 256 KiB ahead, but never more than the total packet size.
+        vRecv.resize(std::min(PacketSize(), m_pos + nCopy + 256 * 1024));
+    }
+
+    memcpy(&vRecv[m_pos], msg_bytes.data(), nCopy);
+    m_pos += nCopy;
+
+    if (m_pos == PacketSize()) {
+        // The MAC is verified before anything is decrypted, a mismatch means
+        // the stream can no longer be trusted.
+        unsigned char* packet = UCharCast(vRecv.data());
+        if (!m_aead.Crypt(m_sequence.m_payload, m_sequence.m_aad, m_sequence.m_aad_pos, packet, PacketSize(), packet, PacketSize(), /*is_encrypt=*/false)) {
+            LogPrint(BCLog::NET, "V2 packet error: Invalid MAC (%u bytes), peer=%d\n", m_payload_size, m_node_id);
+            return -1;
+        }
+        m_sequence.Next();
+    }
+
+    return nCopy;
+}
+
+CNetMessage V2TransportDeserializer::GetMessage(const std::chrono::microseconds time, bool& reject_message)
+{
+    // Initialize out parameter
+    reject_message = false;
+
+    // We just received a message off the wire, harvest entropy from the time (and the MAC)
+    RandAddEvent(ReadLE32(UCharCast(vRecv.data()) + CHACHA20_POLY1305_AEAD_AAD_LEN + m_payload_size));
+
+    // strip the length and the MAC, leaving the message type and data
+    const uint32_t raw_size{PacketSize()};
+    vRecv.ignore(CHACHA20_POLY1305_AEAD_AAD_LEN);
+    vRecv.resize(m_payload_size);
+
+    CNetMessage msg(std::move(vRecv));
+    msg.m_time = time;
+    msg.m_raw_message_size = raw_size;
+    try {
+        msg.m_recv >> LIMITED_STRING(msg.m_type, CMessageHeader::COMMAND_SIZE);
+    } catch (const std::exception&) {
+        LogPrint(BCLog::NET, "V2 packet error: Unable to deserialize message type, peer=%d\n", m_node_id);
+        reject_message = true;
+    }
+    msg.m_message_size = msg.m_recv.size();
+
+    if (!reject_message && (msg.m_type.empty() || !std::all_of(msg.m_type.begin(), msg.m_type.end(), [](char c) { return c >= ' ' && c <= 0x7E; }))) {
+        LogPrint(BCLog::NET, "V2 packet error: Invalid message type (%s, %u bytes), peer=%d\n",
+                 SanitizeString(msg.m_type), msg.m_message_size, m_node_id);
+        reject_message = true;
+    }
+
+    // Always reset the network deserializer (prepare for the next message)
+    Reset();
+    return msg;
+}
+
+std::vector<unsigned char> CConnman::TakeSendBuffer()
+{
+    LOCK(m_send_buffer_pool_mutex);
+    if (m_send_buffer_pool.empty()) return {};
+    std::vector<unsigned char> buffer{std::move(m_send_buffer_pool.back())};
+    m_send_buffer_pool.pop_back();
+    return buffer;
+}
+
+void CConnman::ReturnSendBuffer(std::vector<unsigned char>&& buffer) const
+{
+    if (buffer.capacity() > MAX_POOLED_SEND_BUFFER_CAPACITY) return;
+    buffer.clear();
+    LOCK(m_send_buffer_pool_mutex);
+    if (m_send_buffer_pool.size() < SEND_BUFFER_POOL_SIZE) m_send_buffer_pool.push_back(std::move(buffer));
+}
+
 size_t CConnman::SocketSendData(CNode& node) const
 {
-    auto it = node.vSendMsg.begin();
     size_t nSentSize = 0;
-
-    while (it != node.vSendMsg.end()) {
-        const auto& data = *it;
-        assert(data.size() > node.nSendOffset);
-        int nBytes = 0;
+    std::array<Span<const unsigned char>, MAX_SEND_MANY_BUFFERS> buffers;
+
+    while (!node.vSendMsg.empty()) {
+        // Send as many queued messages as possible with a single call. Only the
+        // buffers passed to SendMany() are counted, so that a short send is
+        // told apart from one that sent everything it was given.
+        size_t n_buffers = 0;
+        size_t nRequested = 0;
+        for (auto it = node.vSendMsg.begin(); it != node.vSendMsg.end() && n_buffers < buffers.size(); ++it) {
+            assert(it->size() > (n_buffers == 0 ? node.nSendOffset : 0));
+            buffers[n_buffers] = Span{*it}.subspan(n_buffers == 0 ? node.nSendOffset : 0);
+            nRequested += buffers[n_buffers].size();
+            ++n_buffers;
+        }
+        ssize_t nBytes = 0;
         {
             LOCK(node.m_sock_mutex);
             if (!node.m_sock) {
                 break;
             }
-            nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()) + node.nSendOffset, data.size() - node.nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+            nBytes = node.m_sock->SendMany(Span{buffers}.first(n_buffers), MSG_NOSIGNAL | MSG_DONTWAIT);
         }
         if (nBytes > 0) {
             node.m_last_send = GetTime<std::chrono::seconds>();
             node.nSendBytes += nBytes;
-            node.nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (node.nSendOffset == data.size()) {
+            // Drop the messages that were sent in full
+            size_t nRemaining = nBytes;
+            while (nRemaining > 0) {
+                const auto& data = node.vSendMsg.front();
+                if (nRemaining < data.size() - node.nSendOffset) {
+                    node.nSendOffset += nRemaining;
+                    break;
+                }
+                nRemaining -= data.size() - node.nSendOffset;
                 node.nSendOffset = 0;
                 node.nSendSize -= data.size();
                 node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
-                it++;
-            } else {
-                // could not send full message; stop sending more
+                ReturnSendBuffer(std::move(node.vSendMsg.front()));
+                node.vSendMsg.pop_front();
+            }
+            if ((size_t)nBytes < nRequested) {
+                // could not send all messages; stop sending more
                 break;
             }
         } else {
@@ -855,11 +982,10 @@ size_t CConnman::SocketSendData(CNode& node) const
         }
     }
 
-    if (it == node.vSendMsg.end()) {
+    if (node.vSendMsg.empty()) {
         assert(node.nSendOffset == 0);
         assert(node.nSendSize == 0);
     }
-    node.vSendMsg.erase(node.vSendMsg.begin(), it);
     return nSentSize;
 }
 
@@ -1230,7 +1356,7 @@ Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
     return events_per_sock;
 }
 
-void CConnman::SocketHandler()
+void CConnman::SocketHandler(SockWaiter& sock_waiter)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
 
@@ -1246,7 +1372,7 @@ void CConnman::SocketHandler()
         // select(2)). If none are ready, wait for a short while and return
         // empty sets.
         events_per_sock = GenerateWaitSockets(snap.Nodes());
-        if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
+        if (!sock_waiter.WaitMany(timeout, events_per_sock)) {
             interruptNet.sleep_for(timeout);
         }
 
@@ -1371,11 +1497,12 @@ void CConnman::ThreadSocketHandler()
     AssertLockNotHeld(m_total_bytes_sent_mutex);
 
     SetSyscallSandboxPolicy(SyscallSandboxPolicy::NET);
+    const std::unique_ptr<SockWaiter> sock_waiter{MakeSockWaiter()};
     while (!interruptNet)
     {
         DisconnectNodes();
         NotifyNumConnectionsChanged();
-        SocketHandler();
+        SocketHandler(*sock_waiter);
     }
 }
 
@@ -2038,15 +2165,19 @@ void CConnman::ThreadI2PAcceptIncoming()
     static constexpr auto err_wait_cap = 5min;
     auto err_wait = err_wait_begin;
 
-    bool advertising_listen_addr = false;
+    // Several of these threads accept concurrently from the same session. The
+    // address is advertised while any of them is listening.
+    bool listening = false;
     i2p::Connection conn;
 
     while (!interruptNet) {
 
         if (!m_i2p_sam_session->Listen(conn)) {
-            if (advertising_listen_addr && conn.me.IsValid()) {
-                RemoveLocal(conn.me);
-                advertising_listen_addr = false;
+            if (listening) {
+                listening = false;
+                if (--m_i2p_accepts_listening == 0 && conn.me.IsValid()) {
+                    RemoveLocal(conn.me);
+                }
             }
 
             interruptNet.sleep_for(err_wait);
@@ -2057,9 +2188,11 @@ void CConnman::ThreadI2PAcceptIncoming()
             continue;
         }
 
-        if (!advertising_listen_addr) {
-            AddLocal(conn.me, LOCAL_MANUAL);
-            advertising_listen_addr = true;
+        if (!listening) {
+            listening = true;
+            if (m_i2p_accepts_listening++ == 0) {
+                AddLocal(conn.me, LOCAL_MANUAL);
+            }
         }
 
         if (!m_i2p_sam_session->Accept(conn)) {
@@ -2071,6 +2204,50 @@ void CConnman::ThreadI2PAcceptIncoming()
     }
 }
 
+void CConnman::ThreadI2PTransientSessions()
+{
+    static constexpr auto check_interval = 1s;
+    static constexpr auto err_wait_begin = 1s;
+    static constexpr auto err_wait_cap = 5min;
+    auto err_wait = err_wait_begin;
+
+    while (!interruptNet) {
+        Proxy i2p_sam;
+        if (WITH_LOCK(m_i2p_transient_sessions_mutex, return m_i2p_transient_sessions.size()) >= m_max_i2p_transient_sessions ||
+            !GetProxy(NET_I2P, i2p_sam)) {
+            interruptNet.sleep_for(check_interval);
+            continue;
+        }
+
+        auto session{std::make_unique<i2p::sam::Session>(i2p_sam.proxy, &interruptNet)};
+        if (!session->Create()) {
+            interruptNet.sleep_for(err_wait);
+            if (err_wait < err_wait_cap) {
+                err_wait *= 2;
+            }
+            continue;
+        }
+        err_wait = err_wait_begin;
+
+        LOCK(m_i2p_transient_sessions_mutex);
+        m_i2p_transient_sessions.push_back(std::move(session));
+    }
+}
+
+std::unique_ptr<i2p::sam::Session> CConnman::TakeI2PTransientSession(const CService& proxy)
+{
+    {
+        LOCK(m_i2p_transient_sessions_mutex);
+        if (!m_i2p_transient_sessions.empty()) {
+            // If the SAM proxy dropped it meanwhile, it is created again when used
+            auto session{std::move(m_i2p_transient_sessions.front())};
+            m_i2p_transient_sessions.pop_front();
+            return session;
+        }
+    }
+    return std::make_unique<i2p::sam::Session>(proxy, &interruptNet);
+}
+
 bool CConnman::BindListenPort(const CService& addrBind, bilingual_str& strError, NetPermissionFlags permissions)
 {
     int nOne = 1;
@@ -2218,6 +2395,7 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In, AddrMan& addrman_in,
     Options connOptions;
     Init(connOptions);
     SetNetworkActive(network_active);
+    RegisterProfiledLock(&m_nodes_mutex, "m_nodes_mutex");
 }
 
 NodeId CConnman::GetNewNodeId()
@@ -2332,7 +2510,10 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Send and receive from sockets, accept connections
-    threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
+    threadSocketHandler = std::thread(&util::TraceThread, "net", [this, cpus = connOptions.m_thread_cpus] {
+        if (!cpus.empty()) util::SetThreadAffinity(cpus);
+        ThreadSocketHandler();
+    });
 
     if (!gArgs.GetBoolArg("-dnsseed", DEFAULT_DNSSEED))
         LogPrintf("DNS seeding disabled\n");
@@ -2357,15 +2538,25 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Process messages
-    threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this] { ThreadMessageHandler(); });
+    threadMessageHandler = std::thread(&util::TraceThread, "msghand", [this, cpus = connOptions.m_thread_cpus] {
+        if (!cpus.empty()) util::SetThreadAffinity(cpus);
+        ThreadMessageHandler();
+    });
 
     if (m_i2p_sam_session) {
-        threadI2PAcceptIncoming =
-            std::thread(&util::TraceThread, "i2paccept", [this] { ThreadI2PAcceptIncoming(); });
+        for (int n = 0; n < std::max(1, connOptions.m_i2p_accept_streams); ++n) {
+            m_threads_i2p_accept.emplace_back(&util::TraceThread, strprintf("i2paccept.%i", n),
+                                              [this] { ThreadI2PAcceptIncoming(); });
+        }
+    } else if (GetProxy(NET_I2P, i2p_sam) && connOptions.m_i2p_transient_sessions > 0) {
+        // Outbound I2P connections use transient sessions, create some ahead of time
+        m_max_i2p_transient_sessions = connOptions.m_i2p_transient_sessions;
+        threadI2PTransientSessions =
+            std::thread(&util::TraceThread, "i2psessions", [this] { ThreadI2PTransientSessions(); });
     }
 
     // Dump network addresses
-    scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL);
+    scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL, "addrman dump");
 
     return true;
 }
@@ -2411,8 +2602,12 @@ void CConnman::Interrupt()
 
 void CConnman::StopThreads()
 {
-    if (threadI2PAcceptIncoming.joinable()) {
-        threadI2PAcceptIncoming.join();
+    for (std::thread& thread : m_threads_i2p_accept) {
+        thread.join();
+    }
+    m_threads_i2p_accept.clear();
+    if (threadI2PTransientSessions.joinable()) {
+        threadI2PTransientSessions.join();
     }
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
@@ -2455,6 +2650,7 @@ void CConnman::StopNodes()
     }
     m_nodes_disconnected.clear();
     vhListenSocket.clear();
+    WITH_LOCK(m_i2p_transient_sessions_mutex, m_i2p_transient_sessions.clear());
     semOutbound.reset();
     semAddnode.reset();
 }
@@ -2470,6 +2666,7 @@ CConnman::~CConnman()
 {
     Interrupt();
     Stop();
+    UnregisterProfiledLock(&m_nodes_mutex);
 }
 
 std::vector<CAddress> CConnman::GetAddresses(size_t max_addresses, size_t max_pct, std::optional<Network> network) const
@@ -2578,6 +2775,23 @@ void CConnman::GetNodeStats(std::vector<CNodeStats>& vstats) const
     }
 }
 
+size_t CConnman::GetBufferMemoryUsage() const
+{
+    size_t usage{0};
+    {
+        LOCK(m_nodes_mutex);
+        for (CNode* pnode : m_nodes) {
+            usage += WITH_LOCK(pnode->cs_vSend, return pnode->nSendSize);
+            usage += WITH_LOCK(pnode->cs_vProcessMsg, return pnode->nProcessQueueSize);
+        }
+    }
+    LOCK(m_send_buffer_pool_mutex);
+    for (const auto& buffer : m_send_buffer_pool) {
+        usage += memusage::DynamicUsage(buffer);
+    }
+    return usage;
+}
+
 bool CConnman::DisconnectNode(const std::string& strNode)
 {
     LOCK(m_nodes_mutex);
@@ -2791,7 +3005,7 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
     );
 
     // make sure we use the appropriate network transport format
-    std::vector<unsigned char> serializedHeader;
+    std::vector<unsigned char> serializedHeader{TakeSendBuffer()};
     pnode->m_serializer->prepareForTransport(msg, serializedHeader);
     size_t nTotalSize = nMessageSize + serializedHeader.size();
 
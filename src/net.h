@@ -11,6 +11,8 @@
 #include <compat/compat.h>
 #include <node/connection_types.h>
 #include <consensus/amount.h>
+#include <crypto/chacha_poly_aead.h>
+#include <crypto/poly1305.h>
 #include <crypto/siphash.h>
 #include <hash.h>
 #include <i2p.h>
@@ -88,6 +90,10 @@ static constexpr bool DEFAULT_DNSSEED{true};
 static constexpr bool DEFAULT_FIXEDSEEDS{true};
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Default number of "STREAM ACCEPT"s kept outstanding on the I2P SAM session, each on its own thread */
+static constexpr int DEFAULT_I2P_ACCEPT_STREAMS{4};
+/** Default number of transient I2P SAM sessions created ahead of the outbound I2P connections that use them */
+static constexpr int DEFAULT_I2P_TRANSIENT_SESSIONS{2};
 
 typedef int64_t NodeId;
 
@@ -205,6 +211,9 @@ public:
     mapMsgTypeSize mapSendBytesPerMsgType;
     uint64_t nRecvBytes;
     mapMsgTypeSize mapRecvBytesPerMsgType;
+    //! Bytes of messages queued to be sent to the peer, and received from it to be processed
+    size_t m_send_queue_size;
+    size_t m_process_queue_size;
     NetPermissionFlags m_permission_flags;
     std::chrono::microseconds m_last_ping_time;
     std::chrono::microseconds m_min_ping_time;
@@ -321,6 +330,85 @@ public:
     CNetMessage GetMessage(std::chrono::microseconds time, bool& reject_message) override;
 };
 
+/** Packet sequence numbers of one direction of a V2 transport. The lengths of
+ * AAD_PACKAGES_PER_ROUND consecutive packets are encrypted with the same
+ * ChaCha20 keystream block, at increasing positions.
+ */
+struct V2TransportSequence
+{
+    uint64_t m_payload{0};
+    uint64_t m_aad{0};
+    int m_aad_pos{0};
+
+    void Next()
+    {
+        ++m_payload;
+        m_aad_pos += CHACHA20_POLY1305_AEAD_AAD_LEN;
+        if (m_aad_pos + CHACHA20_POLY1305_AEAD_AAD_LEN > CHACHA20_ROUND_OUTPUT) {
+            m_aad_pos = 0;
+            ++m_aad;
+        }
+    }
+};
+
+/** Deserializer for the encrypted V2 transport. Each packet is the 3 byte
+ * encrypted payload length, the encrypted payload (the message type as a
+ * string followed by the message data) and a Poly1305 MAC, see
+ * ChaCha20Poly1305AEAD. The MAC replaces the double-SHA256 checksum of V1.
+ */
+class V2TransportDeserializer final : public TransportDeserializer
+{
+private:
+    const NodeId m_node_id; // Only for logging
+    ChaCha20Poly1305AEAD m_aead;
+    V2TransportSequence m_sequence;
+    bool in_data;                   // parsing length (false) or payload and MAC (true)
+    uint32_t m_payload_size;        // decrypted length of the current packet
+    CDataStream vRecv;              // received packet, including length and MAC
+    unsigned int m_pos;
+
+    int readLength(Span<const uint8_t> msg_bytes);
+    int readData(Span<const uint8_t> msg_bytes);
+
+    unsigned int PacketSize() const { return CHACHA20_POLY1305_AEAD_AAD_LEN + m_payload_size + POLY1305_TAGLEN; }
+
+    void Reset() {
+        vRecv.clear();
+        in_data = false;
+        m_payload_size = 0;
+        m_pos = 0;
+    }
+
+public:
+    V2TransportDeserializer(const NodeId node_id, Span<const uint8_t> key_length, Span<const uint8_t> key_payload, int nTypeIn, int nVersionIn)
+        : m_node_id(node_id),
+          m_aead(key_length.data(), key_length.size(), key_payload.data(), key_payload.size()),
+          vRecv(nTypeIn, nVersionIn)
+    {
+        Reset();
+    }
+
+    bool Complete() const override
+    {
+        return in_data && m_pos == PacketSize();
+    }
+    void SetVersion(int nVersionIn) override
+    {
+        vRecv.SetVersion(nVersionIn);
+    }
+    int Read(Span<const uint8_t>& msg_bytes) override
+    {
+        int ret = in_data ? readData(msg_bytes) : readLength(msg_bytes);
+        if (ret < 0) {
+            Reset();
+        } else {
+            msg_bytes = msg_bytes.subspan(ret);
+        }
+        return ret;
+    }
+    CNetMessage GetMessage(std::chrono::microseconds time, bool& reject_message) override;
+};
+
 /** The TransportSerializer prepares messages for the network transport
  */
 class TransportSerializer {
@@ -350,7 +438,7 @@ class CNode
 
 public:
     const std::unique_ptr<TransportDeserializer> m_deserializer; // Used only by SocketHandler thread
-    const std::unique_ptr<const TransportSerializer> m_serializer;
+    const std::unique_ptr<TransportSerializer> m_serializer; // Used only with cs_vSend held
 
     const NetPermissionFlags m_permission_flags;
 
@@ -693,6 +781,10 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         bool m_i2p_accept_incoming;
+        int m_i2p_accept_streams = DEFAULT_I2P_ACCEPT_STREAMS;
+        int m_i2p_transient_sessions = DEFAULT_I2P_TRANSIENT_SESSIONS;
+        //! If not empty, the CPUs to run the socket and message handler threads on
+        std::vector<unsigned int> m_thread_cpus;
     };
 
     void Init(const Options& connOptions) EXCLUSIVE_LOCKS_REQUIRED(!m_added_nodes_mutex, !m_total_bytes_sent_mutex)
@@ -749,7 +841,7 @@ public:
 
     bool ForNode(NodeId id, std::function<bool(CNode* pnode)> func);
 
-    void PushMessage(CNode* pnode, CSerializedNetMsg&& msg) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
+    void PushMessage(CNode* pnode, CSerializedNetMsg&& msg) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !m_send_buffer_pool_mutex);
 
     using NodeFn = std::function<void(CNode*)>;
     void ForEachNode(const NodeFn& func)
@@ -824,6 +916,8 @@ public:
 
     size_t GetNodeCount(ConnectionDirection) const;
     void GetNodeStats(std::vector<CNodeStats>& vstats) const;
+    /** Memory used by the send and process queues of all peers, and by the pooled send buffers */
+    size_t GetBufferMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_send_buffer_pool_mutex);
     bool DisconnectNode(const std::string& node);
     bool DisconnectNode(const CSubNet& subnet);
     bool DisconnectNode(const CNetAddr& addr);
@@ -892,6 +986,10 @@ private:
     void ThreadOpenConnections(std::vector<std::string> connect) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex);
     void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
     void ThreadI2PAcceptIncoming();
+    /** Keep m_i2p_transient_sessions filled with sessions that are already created with the SAM proxy. */
+    void ThreadI2PTransientSessions() EXCLUSIVE_LOCKS_REQUIRED(!m_i2p_transient_sessions_mutex);
+    /** Take a transient session for an outbound I2P connection, from the pool if it has one. */
+    std::unique_ptr<i2p::sam::Session> TakeI2PTransientSession(const CService& proxy) EXCLUSIVE_LOCKS_REQUIRED(!m_i2p_transient_sessions_mutex);
     void AcceptConnection(const ListenSocket& hListenSocket);
 
     /**
@@ -921,8 +1019,9 @@ private:
 
     /**
      * Check connected and listening sockets for IO readiness and process them accordingly.
+     * @param[in] sock_waiter Waits for the sockets to be ready, keeping them registered between calls.
      */
-    void SocketHandler() EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
+    void SocketHandler(SockWaiter& sock_waiter) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex, !mutexMsgProc);
 
     /**
      * Do the read/write for connected sockets that are ready for IO.
@@ -963,9 +1062,14 @@ private:
 
     NodeId GetNewNodeId();
 
-    size_t SocketSendData(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
+    size_t SocketSendData(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend, !m_send_buffer_pool_mutex);
     void DumpAddresses();
 
+    /** Take an empty buffer for serializing a message from the pool, or a new one if it is empty */
+    std::vector<unsigned char> TakeSendBuffer() EXCLUSIVE_LOCKS_REQUIRED(!m_send_buffer_pool_mutex);
+    /** Give the buffer of a message that was sent in full back to the pool, unless it is full or the buffer is large */
+    void ReturnSendBuffer(std::vector<unsigned char>&& buffer) const EXCLUSIVE_LOCKS_REQUIRED(!m_send_buffer_pool_mutex);
+
     // Network stats
     void RecordBytesRecv(uint64_t bytes);
     void RecordBytesSent(uint64_t bytes) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
@@ -978,6 +1082,19 @@ private:
     // Whether the node should be passed out in ForEach* callbacks
     static bool NodeFullyConnected(const CNode* pnode);
 
+    /** Maximum number of buffers kept in m_send_buffer_pool */
+    static constexpr size_t SEND_BUFFER_POOL_SIZE{256};
+    /** Buffers with a larger capacity are freed instead of being kept in m_send_buffer_pool */
+    static constexpr size_t MAX_POOLED_SEND_BUFFER_CAPACITY{4096};
+
+    /**
+     * Buffers of messages that were sent in full, shared by all peers. Messages
+     * are serialized into them instead of into newly allocated buffers, so
+     * peers with many small messages queued do not each churn the allocator.
+     */
+    mutable Mutex m_send_buffer_pool_mutex;
+    mutable std::vector<std::vector<unsigned char>> m_send_buffer_pool GUARDED_BY(m_send_buffer_pool_mutex);
+
     // Network usage totals
     mutable Mutex m_total_bytes_sent_mutex;
     std::atomic<uint64_t> nTotalBytesRecv{0};
@@ -1103,12 +1220,25 @@ private:
      */
     std::unique_ptr<i2p::sam::Session> m_i2p_sam_session;
 
+    //! Number of the I2P accept threads that currently have a "STREAM ACCEPT" outstanding
+    std::atomic<int> m_i2p_accepts_listening{0};
+
+    /**
+     * Transient I2P SAM sessions whose slow "SESSION CREATE" handshake is done
+     * ahead of time, used for outbound I2P connections when there is no
+     * m_i2p_sam_session. They keep a pointer to `interruptNet`.
+     */
+    Mutex m_i2p_transient_sessions_mutex;
+    std::deque<std::unique_ptr<i2p::sam::Session>> m_i2p_transient_sessions GUARDED_BY(m_i2p_transient_sessions_mutex);
+    size_t m_max_i2p_transient_sessions{0};
+
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadMessageHandler;
-    std::thread threadI2PAcceptIncoming;
+    std::vector<std::thread> m_threads_i2p_accept;
+    std::thread threadI2PTransientSessions;
 
     /** flag for deciding to connect to an extra outbound peer,
      *  in excess of m_max_outbound_full_relay
@@ -16,10 +16,12 @@
 #include <hash.h>
 #include <headerssync.h>
 #include <index/blockfilterindex.h>
+#include <memusage.h>
 #include <merkleblock.h>
 #include <netbase.h>
 #include <netmessagemaker.h>
 #include <node/blockstorage.h>
+#include <node/txreconciliation.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
@@ -44,7 +46,10 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <future>
+#include <map>
 #include <memory>
 #include <optional>
 #include <typeinfo>
@@ -99,6 +104,8 @@ static constexpr int32_t MAX_PEER_TX_REQUEST_IN_FLIGHT = 100;
  *  rate (by our own policy, see INVENTORY_BROADCAST_PER_SECOND) for several minutes, while not receiving
  *  the actual transaction (from any peer) in response to requests for them. */
 static constexpr int32_t MAX_PEER_TX_ANNOUNCEMENTS = 5000;
+/** Maximum number of conversions rejected as invalid to remember, see m_conversion_rejects */
+static constexpr size_t MAX_CONVERSION_REJECTS{10'000};
 /** How long to delay requesting transactions via txids, if we have wtxid-relaying peers */
 static constexpr auto TXID_RELAY_DELAY{2s};
 /** How long to delay requesting transactions from non-preferred peers */
@@ -109,8 +116,21 @@ static constexpr auto OVERLOADED_PEER_TX_DELAY{2s};
 static constexpr auto GETDATA_TX_INTERVAL{60s};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Number of blocks that can be requested at any given time from a single peer. During block
+ *  download this is the window for peers whose download speed isn't known yet, see MaxBlocksInTransit. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** Bounds of the adaptive block download window of a single peer. */
+static const int MIN_BLOCKS_IN_TRANSIT_PER_PEER = 2;
+static const int MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER = 64;
+/** Number of received blocks of a single peer that may wait for their checks. Further messages from
+ *  the peer are not processed until fewer wait, so that its receive buffer fills and reading pauses. */
+static constexpr size_t MAX_RECEIVED_BLOCKS_PER_PEER{MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER};
+/** How much download time the blocks in flight from a single peer should cover. Slow peers get
+ *  fewer blocks, so that a block at the bottom of the download window isn't stuck behind them. */
+static constexpr auto BLOCK_DOWNLOAD_TARGET_QUEUE_TIME{10s};
+/** How many times longer than a faster peer's expected download time a block must have been in flight
+ *  from a slower peer before it is requested from the faster peer instead. */
+static constexpr int BLOCK_REASSIGN_SLOWDOWN_FACTOR = 2;
 /** Time during which a peer must stall block download progress before being disconnected. */
 static constexpr auto BLOCK_STALLING_TIMEOUT{2s};
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
@@ -149,6 +169,10 @@ static constexpr auto INBOUND_INVENTORY_BROADCAST_INTERVAL{5s};
  *  Use a smaller delay as there is less privacy concern for them.
  *  Blocks and peers with NetPermissionFlags::NoBan permission bypass this. */
 static constexpr auto OUTBOUND_INVENTORY_BROADCAST_INTERVAL{2s};
+/** Maximum age of the shared order of mempool transactions that trickled
+ *  inventory is sorted by. It is taken again after this long, if the mempool
+ *  changed in the meantime. */
+static constexpr auto TX_RELAY_ORDER_MAX_AGE{1s};
 /** Maximum rate of inventory items to send per second.
  *  Limits the impact of low-fee transaction floods. */
 static constexpr unsigned int INVENTORY_BROADCAST_PER_SECOND = 7;
@@ -161,6 +185,11 @@ static constexpr unsigned int INVENTORY_MAX_RECENT_RELAY = 3500;
  *  lower bound, and it should be larger to account for higher inv rate to outbound
  *  peers, and random variations in the broadcast mechanism. */
 static_assert(INVENTORY_MAX_RECENT_RELAY >= INVENTORY_BROADCAST_PER_SECOND * UNCONDITIONAL_RELAY_DELAY / std::chrono::seconds{1}, "INVENTORY_RELAY_MAX too low");
+/** Maximum number of txids and wtxids remembered as known to each peer. */
+static constexpr unsigned int INVENTORY_MAX_KNOWN_TX = 50000;
+/** Number of items the per-peer inventory filters are initially sized for. Most
+ *  peers never come close to the maximum, so the filters only grow when needed. */
+static constexpr unsigned int INVENTORY_FILTER_INITIAL_SIZE = 1000;
 /** Average delay between feefilter broadcasts in seconds. */
 static constexpr auto AVG_FEEFILTER_BROADCAST_INTERVAL{10min};
 /** Maximum feefilter broadcast delay after significant change. */
@@ -182,6 +211,9 @@ static constexpr double MAX_ADDR_RATE_PER_SECOND{0.1};
 static constexpr size_t MAX_ADDR_PROCESSING_TOKEN_BUCKET{MAX_ADDR_TO_SEND};
 /** The compactblocks version we support. See BIP 152. */
 static constexpr uint64_t CMPCTBLOCKS_VERSION{2};
+/** Signals, alongside CMPCTBLOCKS_VERSION, that we can predict the conversion
+ *  remainder outputs of a compact block's coinbase, so they may be omitted. */
+static constexpr uint64_t CMPCTBLOCKS_REMAINDERS_VERSION{3};
 
 // Internal stuff
 namespace {
@@ -285,12 +317,13 @@ struct Peer {
         /** A filter of all the txids and wtxids that the peer has announced to
          *  us or we have announced to the peer. We use this to avoid announcing
          *  the same txid/wtxid to a peer that already has the transaction. */
-        CRollingBloomFilter m_tx_inventory_known_filter GUARDED_BY(m_tx_inventory_mutex){50000, 0.000001};
-        /** Set of transaction ids we still have to announce (txid for
+        CRollingBloomFilter m_tx_inventory_known_filter GUARDED_BY(m_tx_inventory_mutex){INVENTORY_MAX_KNOWN_TX, 0.000001, INVENTORY_FILTER_INITIAL_SIZE};
+        /** Transaction ids we still have to announce (txid for
          *  non-wtxid-relay peers, wtxid for wtxid-relay peers). We use the
          *  mempool to sort transactions in dependency order before relay, so
-         *  this does not have to be sorted. */
-        std::set<uint256> m_tx_inventory_to_send GUARDED_BY(m_tx_inventory_mutex);
+         *  this does not have to be sorted. It may contain duplicates, which
+         *  are removed when it is next trickled. */
+        std::vector<uint256> m_tx_inventory_to_send GUARDED_BY(m_tx_inventory_mutex);
         /** Whether the peer has requested us to send our complete mempool. Only
          *  permitted if the peer has NetPermissionFlags::Mempool. See BIP35. */
         bool m_send_mempool GUARDED_BY(m_tx_inventory_mutex){false};
@@ -379,6 +412,16 @@ struct Peer {
     /** Work queue of items requested by this peer **/
     std::deque<CInv> m_getdata_requests GUARDED_BY(m_getdata_requests_mutex);
 
+    /** A block received from this peer, which is processed once its context-free checks are done **/
+    struct ReceivedBlock {
+        std::shared_ptr<const CBlock> block;
+        std::atomic<bool> checked{false};
+    };
+    /** Protects m_received_blocks **/
+    Mutex m_received_blocks_mutex;
+    /** Blocks received from this peer that are not processed yet, in the order they were received **/
+    std::deque<std::shared_ptr<ReceivedBlock>> m_received_blocks GUARDED_BY(m_received_blocks_mutex);
+
     /** Time of the last getheaders message to this peer */
     NodeClock::time_point m_last_getheaders_timestamp{};
 
@@ -434,6 +477,8 @@ struct CNodeState {
     //! When the first entry in vBlocksInFlight started downloading. Don't care when vBlocksInFlight is empty.
     std::chrono::microseconds m_downloading_since{0us};
     int nBlocksInFlight{0};
+    //! Exponentially weighted average time this peer took to deliver each block we requested, or 0 if unknown.
+    std::chrono::microseconds m_block_download_time{0us};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload{false};
     //! Whether this peer wants invs or headers (when possible) for block announcements.
@@ -442,6 +487,8 @@ struct CNodeState {
     bool m_requested_hb_cmpctblocks{false};
     /** Whether this peer will send us cmpctblocks if we request them. */
     bool m_provides_cmpctblocks{false};
+    /** Whether this peer can predict omitted conversion remainder outputs in cmpctblocks. */
+    bool m_predicts_cmpct_remainders{false};
 
     /** State used to enforce CHAIN_SYNC_TIMEOUT and EXTRA_PEER_CHECK_INTERVAL logic.
       *
@@ -487,7 +534,7 @@ struct CNodeState {
     const bool m_is_inbound;
 
     //! A rolling bloom filter of all announced tx CInvs to this peer.
-    CRollingBloomFilter m_recently_announced_invs = CRollingBloomFilter{INVENTORY_MAX_RECENT_RELAY, 0.000001};
+    CRollingBloomFilter m_recently_announced_invs = CRollingBloomFilter{INVENTORY_MAX_RECENT_RELAY, 0.000001, INVENTORY_FILTER_INITIAL_SIZE};
 
     CNodeState(bool is_inbound) : m_is_inbound(is_inbound) {}
 };
@@ -510,6 +557,7 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override;
 
     /** Implement NetEventsInterface */
     void InitializeNode(CNode& node, ServiceFlags our_services) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
@@ -517,7 +565,7 @@ public:
     bool ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex);
     bool SendMessages(CNode* pto) override EXCLUSIVE_LOCKS_REQUIRED(pto->cs_sendProcessing)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_recent_confirmed_transactions_mutex, !m_most_recent_block_mutex, !m_tx_relay_order_mutex);
 
     /** Implement PeerManager */
     void StartScheduledTasks(CScheduler& scheduler) override;
@@ -525,6 +573,7 @@ public:
     std::optional<std::string> FetchBlock(NodeId peer_id, const CBlockIndex& block_index) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) const override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+    PeerManagerMemoryUsage GetMemoryUsage() const override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     bool IgnoresIncomingTxs() override { return m_ignore_incoming_txs; }
     void SendPings() override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void RelayTransaction(const uint256& txid, const uint256& wtxid) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
@@ -591,6 +640,21 @@ private:
 
     void ProcessOrphanTx(std::set<uint256>& orphan_work_set) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans)
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+    /** Find a parent of a transaction that was rejected for its feerate alone and is
+     *  kept in vExtraTxnForCompact, or nullptr if there is none. */
+    CTransactionRef FindReconsiderableParent(const CTransaction& child) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /** Find an orphan that spends a transaction that was rejected for its feerate alone,
+     *  preferring one announced by the given peer, or nullptr if there is none. */
+    CTransactionRef FindOrphanChild(const CTransaction& parent, NodeId nodeid) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /**
+     * Submit a parent that was rejected for its feerate together with a child that pays for it,
+     * so the package feerate is checked instead of the parent's own. Relays the transactions
+     * that are accepted.
+     *
+     * @return True if the package was accepted.
+     */
+    bool ProcessParentChildPackage(Peer& peer, const CTransactionRef& parent, const CTransactionRef& child)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
     /** Process a single headers message from a peer.
      *
      * @param[in]   pfrom     CNode of the peer
@@ -612,7 +676,7 @@ private:
      * announcements for blocks interacting with the 2hr (MAX_FUTURE_BLOCK_TIME) rule). */
     void HandleFewUnconnectingHeaders(CNode& pfrom, Peer& peer, const std::vector<CBlockHeader>& headers);
     /** Return true if the headers connect to each other, false otherwise */
-    bool CheckHeadersAreContinuous(const std::vector<CBlockHeader>& headers) const;
+    bool CheckHeadersAreContinuous(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& hashes) const;
     /** Try to continue a low-work headers sync that has already begun.
      * Assumes the caller has already verified the headers connect, and has
      * checked that each header satisfies the proof-of-work target included in
@@ -667,10 +731,11 @@ private:
 
     void SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlock& block, const BlockTransactionsRequest& req);
 
-    /** Register with TxRequestTracker that an INV has been received from a
+    /** Register with TxRequestTracker that INVs have been received from a
      *  peer. The announcement parameters are decided in PeerManager and then
-     *  passed to TxRequestTracker. */
-    void AddTxAnnouncement(const CNode& node, const GenTxid& gtxid, std::chrono::microseconds current_time)
+     *  passed to TxRequestTracker. All gtxids must be of the same kind (txid
+     *  or wtxid), as that affects the request delay. */
+    void AddTxAnnouncements(const CNode& node, Span<const GenTxid> gtxids, std::chrono::microseconds current_time)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     /** Send a version message to a peer */
@@ -718,6 +783,8 @@ private:
     /** Whether this node is running in -blocksonly mode */
     const bool m_ignore_incoming_txs;
 
+    std::unique_ptr<TxReconciliationTracker> m_txreconciliation;
+
     bool RejectIncomingTxs(const CNode& peer) const;
 
     /** Whether we've completed initial sync yet, for determining when to turn
@@ -773,6 +840,13 @@ private:
     bool AlreadyHaveTx(const GenTxid& gtxid)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, !m_recent_confirmed_transactions_mutex);
 
+    /** Remember a conversion that was rejected as TX_INVALID_CONVERSION, forgetting the oldest one if full. */
+    void AddConversionReject(const uint256& wtxid, const CTxConversionInfo& info) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Forget the rejected conversions that are valid in the conversion validity window of the tip. */
+    void ForgetValidConversionRejects() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Add a rejected transaction's wtxid to the reject filter or cache it belongs to. */
+    void AddRecentReject(const CTransaction& tx, const MempoolAcceptResult& result) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     /**
      * Filter for transactions that were recently rejected by the mempool.
      * These are not rerequested until the chain tip changes, at which point
@@ -808,7 +882,28 @@ private:
      * Memory used: 1.3 MB
      */
     CRollingBloomFilter m_recent_rejects GUARDED_BY(::cs_main){120'000, 0.000'001};
+    /**
+     * Filter for the wtxids of transactions that were rejected only because their feerate
+     * is too low (TX_RECONSIDERABLE). They are not downloaded again when announced, but
+     * unlike m_recent_rejects they do not cause their children to be rejected: such a
+     * child is submitted with its parent as a package, which is common for conversions
+     * that need a child to pay for them when the supply moves. Reset with m_recent_rejects.
+     *
+     * Memory used: 1.3 MB
+     */
+    CRollingBloomFilter m_recent_rejects_reconsiderable GUARDED_BY(::cs_main){120'000, 0.000'001};
     uint256 hashRecentRejectsChainTip GUARDED_BY(cs_main);
+    /**
+     * Conversions that were rejected as TX_INVALID_CONVERSION, by wtxid. Whether they
+     * are valid depends only on the supplies in the conversion validity window, so
+     * instead of being reset with m_recent_rejects they are checked against the window
+     * of every new tip, and only forgotten once a change of the supply makes them valid.
+     * This keeps peers announcing them during volatile periods from having us download
+     * and validate them again and again.
+     */
+    std::map<uint256, CTxConversionInfo> m_conversion_rejects GUARDED_BY(::cs_main);
+    //! The wtxids of m_conversion_rejects, oldest first
+    std::deque<uint256> m_conversion_rejects_order GUARDED_BY(::cs_main);
 
     /*
      * Filter for transactions that have been recently confirmed.
@@ -837,6 +932,14 @@ private:
     std::chrono::microseconds NextInvToInbounds(std::chrono::microseconds now,
                                                 std::chrono::seconds average_interval);
 
+    /** The order trickled transaction inventory is sorted by, shared by all
+     *  peers. Taken again when older than TX_RELAY_ORDER_MAX_AGE. */
+    Mutex m_tx_relay_order_mutex;
+    std::shared_ptr<const TxRelayOrder> m_tx_relay_order GUARDED_BY(m_tx_relay_order_mutex);
+    std::chrono::microseconds m_tx_relay_order_time GUARDED_BY(m_tx_relay_order_mutex){0};
+
+    std::shared_ptr<const TxRelayOrder> GetTxRelayOrder(std::chrono::microseconds now) EXCLUSIVE_LOCKS_REQUIRED(!m_tx_relay_order_mutex);
+
 
     // All of the following cache a recent block, and are protected by m_most_recent_block_mutex
     Mutex m_most_recent_block_mutex;
@@ -871,8 +974,9 @@ private:
     /** Remove this block from our tracked requested blocks. Called if:
      *  - the block has been received from a peer
      *  - the request for the block has timed out
+     *  If from_peer is the peer the block was requested from, its download time is measured.
      */
-    void RemoveBlockRequest(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer = std::nullopt) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /* Mark a block as in flight
      * Returns false, still setting pit, if the block was already in flight from the same peer
@@ -887,6 +991,10 @@ private:
      */
     void FindNextBlocksToDownload(const Peer& peer, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Return the oldest block in flight from staller if the given peer can be expected to deliver it
+     *  much sooner than staller, or nullptr. */
+    const CBlockIndex* FindBlockToReassign(const CNodeState& state, NodeId staller, std::chrono::microseconds current_time) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight GUARDED_BY(cs_main);
 
     /** When our tip was last updated. */
@@ -901,6 +1009,9 @@ private:
     /** Process a new block. Perform any post-processing housekeeping */
     void ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked);
 
+    /** Process the blocks received from a peer whose context-free checks are done, in the order they were received */
+    void ProcessReceivedBlocks(CNode& node, Peer& peer) EXCLUSIVE_LOCKS_REQUIRED(!peer.m_received_blocks_mutex) LOCKS_EXCLUDED(::cs_main);
+
     /** Relay map (txid or wtxid -> CTransactionRef) */
     typedef std::map<uint256, CTransactionRef> MapRelay;
     MapRelay mapRelay GUARDED_BY(cs_main);
@@ -933,10 +1044,23 @@ private:
     /** Offset into vExtraTxnForCompact to insert the next tx */
     size_t vExtraTxnForCompactIt GUARDED_BY(g_cs_orphans) = 0;
 
+    void AddToCompactEvictedConversions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+    /** vExtraTxnForCompact and m_compact_evicted_conversions, to reconstruct compact blocks with */
+    std::vector<std::pair<uint256, CTransactionRef>> GetCompactExtraTransactions() const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Conversions removed from the mempool for no longer being valid in its conversion validity
+     *  window, which miners checking a different window may still include. They are kept for
+     *  compact block reconstruction, oldest first, up to -blockreconstructionconversionbytes of
+     *  memory usage. */
+    std::deque<CTransactionRef> m_compact_evicted_conversions GUARDED_BY(g_cs_orphans);
+    size_t m_compact_evicted_conversions_usage GUARDED_BY(g_cs_orphans){0};
+
     /** Check whether the last unknown block a peer advertised is not yet known. */
     void ProcessBlockAvailability(NodeId nodeid) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Update tracking information about which blocks a peer is assumed to have. */
     void UpdateBlockAvailability(NodeId nodeid, const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Predict the conversion remainder outputs of a block that builds on our tip. */
+    std::optional<std::vector<CTxOut>> PredictRemainderOutputs(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool CanDirectFetch() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /**
@@ -1080,6 +1204,15 @@ static bool IsLimitedPeer(const Peer& peer)
              (peer.m_their_services & NODE_NETWORK_LIMITED));
 }
 
+/** Number of blocks that may be in flight from this peer during block download. Peers that have
+ *  delivered blocks get a window covering BLOCK_DOWNLOAD_TARGET_QUEUE_TIME of their download time. */
+static int MaxBlocksInTransit(const CNodeState& state)
+{
+    if (state.m_block_download_time == 0us) return MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+    const auto window{std::chrono::microseconds{BLOCK_DOWNLOAD_TARGET_QUEUE_TIME} / state.m_block_download_time};
+    return std::clamp<int>(window, MIN_BLOCKS_IN_TRANSIT_PER_PEER, MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER);
+}
+
 /** Whether this peer can serve us witness data */
 static bool CanServeWitnesses(const Peer& peer)
 {
@@ -1098,12 +1231,24 @@ std::chrono::microseconds PeerManagerImpl::NextInvToInbounds(std::chrono::micros
     return m_next_inv_to_inbounds;
 }
 
+std::shared_ptr<const TxRelayOrder> PeerManagerImpl::GetTxRelayOrder(std::chrono::microseconds now)
+{
+    LOCK(m_tx_relay_order_mutex);
+    if (!m_tx_relay_order || m_tx_relay_order_time + TX_RELAY_ORDER_MAX_AGE < now) {
+        if (!m_tx_relay_order || WITH_LOCK(m_mempool.cs, return m_mempool.GetSequence()) != m_tx_relay_order->sequence) {
+            m_tx_relay_order = m_mempool.GetRelayOrder();
+        }
+        m_tx_relay_order_time = now;
+    }
+    return m_tx_relay_order;
+}
+
 bool PeerManagerImpl::IsBlockRequested(const uint256& hash)
 {
     return mapBlocksInFlight.find(hash) != mapBlocksInFlight.end();
 }
 
-void PeerManagerImpl::RemoveBlockRequest(const uint256& hash)
+void PeerManagerImpl::RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer)
 {
     auto it = mapBlocksInFlight.find(hash);
     if (it == mapBlocksInFlight.end()) {
@@ -1116,8 +1261,16 @@ void PeerManagerImpl::RemoveBlockRequest(const uint256& hash)
     assert(state != nullptr);
 
     if (state->vBlocksInFlight.begin() == list_it) {
+        const auto now{GetTime<std::chrono::microseconds>()};
+        if (from_peer == node_id && now > state->m_downloading_since) {
+            // Blocks are served in the order they were requested, so this is how long
+            // the peer took to deliver this one.
+            const auto download_time{now - state->m_downloading_since};
+            state->m_block_download_time = state->m_block_download_time == 0us ? download_time :
+                                           (state->m_block_download_time * 7 + download_time) / 8;
+        }
         // First block on the queue was received, update the start download time for the next one
-        state->m_downloading_since = std::max(state->m_downloading_since, GetTime<std::chrono::microseconds>());
+        state->m_downloading_since = std::max(state->m_downloading_since, now);
     }
     state->vBlocksInFlight.erase(list_it);
 
@@ -1246,6 +1399,16 @@ static bool PeerHasHeader(CNodeState *state, const CBlockIndex *pindex) EXCLUSIV
     return false;
 }
 
+std::optional<std::vector<CTxOut>> PeerManagerImpl::PredictRemainderOutputs(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+    // The remainders depend on the UTXO set and supply at the parent, which we
+    // only have for our tip
+    const CBlockIndex* tip = m_chainman.ActiveChain().Tip();
+    if (!tip || block.hashPrevBlock != tip->GetBlockHash()) return std::nullopt;
+    return GetConversionRemainderOutputs(block, m_chainman.ActiveChainstate().CoinsTip(), tip->nHeight + 1, tip->GetTotalSupply());
+}
+
 void PeerManagerImpl::ProcessBlockAvailability(NodeId nodeid) {
     CNodeState *state = State(nodeid);
     assert(state != nullptr);
@@ -1366,6 +1529,23 @@ void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int co
     }
 }
 
+const CBlockIndex* PeerManagerImpl::FindBlockToReassign(const CNodeState& state, NodeId staller, std::chrono::microseconds current_time)
+{
+    const CNodeState* staller_state = State(staller);
+    if (staller_state == nullptr || staller_state->vBlocksInFlight.empty()) return nullptr;
+    // Only peers that have proven faster than the staller take over its blocks
+    if (state.m_block_download_time == 0us) return nullptr;
+    if (staller_state->m_block_download_time != 0us && staller_state->m_block_download_time <= state.m_block_download_time) return nullptr;
+    if (current_time - staller_state->m_downloading_since < state.m_block_download_time * BLOCK_REASSIGN_SLOWDOWN_FACTOR) return nullptr;
+
+    const QueuedBlock& queued = staller_state->vBlocksInFlight.front();
+    // Compact block downloads are left alone, they are reconstructed with the staller's help
+    if (queued.partialBlock) return nullptr;
+    const CBlockIndex* pindex = queued.pindex;
+    if (state.pindexBestKnownBlock == nullptr || state.pindexBestKnownBlock->GetAncestor(pindex->nHeight) != pindex) return nullptr;
+    return pindex;
+}
+
 } // namespace
 
 void PeerManagerImpl::PushNodeVersion(CNode& pnode, const Peer& peer)
@@ -1393,14 +1573,22 @@ void PeerManagerImpl::PushNodeVersion(CNode& pnode, const Peer& peer)
     }
 }
 
-void PeerManagerImpl::AddTxAnnouncement(const CNode& node, const GenTxid& gtxid, std::chrono::microseconds current_time)
+void PeerManagerImpl::AddTxAnnouncements(const CNode& node, Span<const GenTxid> gtxids, std::chrono::microseconds current_time)
 {
     AssertLockHeld(::cs_main); // For m_txrequest
+    if (gtxids.empty()) return;
     NodeId nodeid = node.GetId();
-    if (!node.HasPermission(NetPermissionFlags::Relay) && m_txrequest.Count(nodeid) >= MAX_PEER_TX_ANNOUNCEMENTS) {
-        // Too many queued announcements from this peer
-        return;
+    if (!node.HasPermission(NetPermissionFlags::Relay)) {
+        const size_t count{m_txrequest.Count(nodeid)};
+        if (count >= MAX_PEER_TX_ANNOUNCEMENTS) {
+            // Too many queued announcements from this peer
+            return;
+        }
+        // Only queue as many as still fit within the limit.
+        gtxids = gtxids.first(std::min(gtxids.size(), size_t{MAX_PEER_TX_ANNOUNCEMENTS} - count));
     }
+    const bool is_wtxid{gtxids.front().IsWtxid()};
+    Assume(std::all_of(gtxids.begin(), gtxids.end(), [&](const GenTxid& gtxid) { return gtxid.IsWtxid() == is_wtxid; }));
     const CNodeState* state = State(nodeid);
 
     // Decide the TxRequestTracker parameters for this announcement:
@@ -1413,11 +1601,11 @@ void PeerManagerImpl::AddTxAnnouncement(const CNode& node, const GenTxid& gtxid,
     auto delay{0us};
     const bool preferred = state->fPreferredDownload;
     if (!preferred) delay += NONPREF_PEER_TX_DELAY;
-    if (!gtxid.IsWtxid() && m_wtxid_relay_peers > 0) delay += TXID_RELAY_DELAY;
+    if (!is_wtxid && m_wtxid_relay_peers > 0) delay += TXID_RELAY_DELAY;
     const bool overloaded = !node.HasPermission(NetPermissionFlags::Relay) &&
         m_txrequest.CountInFlight(nodeid) >= MAX_PEER_TX_REQUEST_IN_FLIGHT;
     if (overloaded) delay += OVERLOADED_PEER_TX_DELAY;
-    m_txrequest.ReceivedInv(nodeid, gtxid, preferred, current_time + delay);
+    m_txrequest.ReceivedInvs(nodeid, gtxids, preferred, current_time + delay);
 }
 
 void PeerManagerImpl::UpdateLastBlockAnnounceTime(NodeId node, int64_t time_in_seconds)
@@ -1462,7 +1650,7 @@ void PeerManagerImpl::ReattemptInitialBroadcast(CScheduler& scheduler)
     // Schedule next run for 10-15 minutes in the future.
     // We add randomness on every cycle to avoid the possibility of P2P fingerprinting.
     const std::chrono::milliseconds delta = 10min + GetRandMillis(5min);
-    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta);
+    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta, "initial broadcast");
 }
 
 void PeerManagerImpl::FinalizeNode(const CNode& node)
@@ -1494,6 +1682,7 @@ void PeerManagerImpl::FinalizeNode(const CNode& node)
     }
     WITH_LOCK(g_cs_orphans, m_orphanage.EraseForPeer(nodeid));
     m_txrequest.DisconnectedPeer(nodeid);
+    if (m_txreconciliation) m_txreconciliation->ForgetPeer(nodeid);
     m_num_preferred_download_peers -= state->fPreferredDownload;
     m_peers_downloading_from -= (state->nBlocksInFlight != 0);
     assert(m_peers_downloading_from >= 0);
@@ -1559,6 +1748,7 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) c
             if (queue.pindex)
                 stats.vHeightInFlight.push_back(queue.pindex->nHeight);
         }
+        stats.m_tx_relay_memory = state->m_recently_announced_invs.DynamicMemoryUsage();
     }
 
     PeerRef peer = GetPeerRef(nodeid);
@@ -1579,6 +1769,9 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) c
     if (auto tx_relay = peer->GetTxRelay(); tx_relay != nullptr) {
         stats.m_relay_txs = WITH_LOCK(tx_relay->m_bloom_filter_mutex, return tx_relay->m_relay_txs);
         stats.m_fee_filter_received = tx_relay->m_fee_filter_received.load();
+        LOCK(tx_relay->m_tx_inventory_mutex);
+        stats.m_tx_relay_memory += tx_relay->m_tx_inventory_known_filter.DynamicMemoryUsage() +
+                                   memusage::DynamicUsage(tx_relay->m_tx_inventory_to_send);
     } else {
         stats.m_relay_txs = false;
         stats.m_fee_filter_received = 0;
@@ -1598,6 +1791,40 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) c
     return true;
 }
 
+PeerManagerMemoryUsage PeerManagerImpl::GetMemoryUsage() const
+{
+    PeerManagerMemoryUsage usage;
+    usage.orphanage = m_orphanage.DynamicMemoryUsage();
+    {
+        LOCK(cs_main);
+        for (const auto& [id, state] : m_node_states) {
+            usage.tx_relay += state.m_recently_announced_invs.DynamicMemoryUsage();
+        }
+    }
+
+    std::vector<PeerRef> peers;
+    {
+        LOCK(m_peer_mutex);
+        for (const auto& [id, peer] : m_peer_map) {
+            peers.push_back(peer);
+        }
+    }
+    for (const PeerRef& peer : peers) {
+        {
+            LOCK(peer->m_headers_sync_mutex);
+            if (peer->m_headers_sync) {
+                usage.headers_sync += memusage::DynamicUsage(peer->m_headers_sync) + peer->m_headers_sync->DynamicMemoryUsage();
+            }
+        }
+        if (auto tx_relay = peer->GetTxRelay(); tx_relay != nullptr) {
+            LOCK(tx_relay->m_tx_inventory_mutex);
+            usage.tx_relay += tx_relay->m_tx_inventory_known_filter.DynamicMemoryUsage() +
+                              memusage::DynamicUsage(tx_relay->m_tx_inventory_to_send);
+        }
+    }
+    return usage;
+}
+
 void PeerManagerImpl::AddToCompactExtraTransactions(const CTransactionRef& tx)
 {
     size_t max_extra_txn = gArgs.GetIntArg("-blockreconstructionextratxn", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN);
@@ -1609,6 +1836,30 @@ void PeerManagerImpl::AddToCompactExtraTransactions(const CTransactionRef& tx)
     vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % max_extra_txn;
 }
 
+void PeerManagerImpl::AddToCompactEvictedConversions(const CTransactionRef& tx)
+{
+    const size_t max_usage = std::max<int64_t>(0, gArgs.GetIntArg("-blockreconstructionconversionbytes", DEFAULT_BLOCK_RECONSTRUCTION_CONVERSION_BYTES));
+    const size_t usage{RecursiveDynamicUsage(tx)};
+    if (usage > max_usage) return;
+    m_compact_evicted_conversions.push_back(tx);
+    m_compact_evicted_conversions_usage += usage;
+    while (m_compact_evicted_conversions_usage > max_usage) {
+        m_compact_evicted_conversions_usage -= RecursiveDynamicUsage(m_compact_evicted_conversions.front());
+        m_compact_evicted_conversions.pop_front();
+    }
+}
+
+std::vector<std::pair<uint256, CTransactionRef>> PeerManagerImpl::GetCompactExtraTransactions() const
+{
+    std::vector<std::pair<uint256, CTransactionRef>> extra_txn;
+    extra_txn.reserve(vExtraTxnForCompact.size() + m_compact_evicted_conversions.size());
+    extra_txn.insert(extra_txn.end(), vExtraTxnForCompact.begin(), vExtraTxnForCompact.end());
+    for (const CTransactionRef& tx : m_compact_evicted_conversions) {
+        extra_txn.emplace_back(tx->GetWitnessHash(), tx);
+    }
+    return extra_txn;
+}
+
 void PeerManagerImpl::Misbehaving(Peer& peer, int howmuch, const std::string& message)
 {
     assert(howmuch > 0);
@@ -1707,6 +1958,7 @@ bool PeerManagerImpl::MaybePunishNodeForTx(NodeId nodeid, const TxValidationStat
     case TxValidationResult::TX_WITNESS_STRIPPED:
     case TxValidationResult::TX_CONFLICT:
     case TxValidationResult::TX_MEMPOOL_POLICY:
+    case TxValidationResult::TX_RECONSIDERABLE:
     case TxValidationResult::TX_NO_MEMPOOL:
         break;
     }
@@ -1780,6 +2032,11 @@ PeerManagerImpl::PeerManagerImpl(CConnman& connman, AddrMan& addrman,
       m_mempool(pool),
       m_ignore_incoming_txs(ignore_incoming_txs)
 {
+    // While Erlay support is incomplete, it must be enabled explicitly via -txreconciliation.
+    // This argument can go away after Erlay support is complete.
+    if (gArgs.GetBoolArg("-txreconciliation", DEFAULT_TXRECONCILIATION_ENABLE)) {
+        m_txreconciliation = std::make_unique<TxReconciliationTracker>(TXRECONCILIATION_VERSION);
+    }
 }
 
 void PeerManagerImpl::StartScheduledTasks(CScheduler& scheduler)
@@ -1789,11 +2046,11 @@ void PeerManagerImpl::StartScheduledTasks(CScheduler& scheduler)
     // combine them in one function and schedule at the quicker (peer-eviction)
     // timer.
     static_assert(EXTRA_PEER_CHECK_INTERVAL < STALE_CHECK_INTERVAL, "peer eviction timer should be less than stale tip check timer");
-    scheduler.scheduleEvery([this] { this->CheckForStaleTipAndEvictPeers(); }, std::chrono::seconds{EXTRA_PEER_CHECK_INTERVAL});
+    scheduler.scheduleEvery([this] { this->CheckForStaleTipAndEvictPeers(); }, std::chrono::seconds{EXTRA_PEER_CHECK_INTERVAL}, "peer eviction");
 
     // schedule next run for 10-15 minutes in the future
     const std::chrono::milliseconds delta = 10min + GetRandMillis(5min);
-    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta);
+    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta, "initial broadcast");
 }
 
 /**
@@ -1838,6 +2095,13 @@ void PeerManagerImpl::BlockDisconnected(const std::shared_ptr<const CBlock> &blo
     m_recent_confirmed_transactions.reset();
 }
 
+void PeerManagerImpl::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    if (reason != MemPoolRemovalReason::CONVERSIONINVALID) return;
+    LOCK(g_cs_orphans);
+    AddToCompactEvictedConversions(tx);
+}
+
 /**
  * Maintain state about the best-seen block and fast-announce a compact block
  * to compatible peers.
@@ -1859,6 +2123,20 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
     const std::shared_future<CSerializedNetMsg> lazy_ser{
         std::async(std::launch::deferred, [&] { return msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock); })};
 
+    // Peers that predict conversion remainders get a compact block with the
+    // remainder outputs stripped from the coinbase, followed by their count.
+    // Only strip them if our own prediction reproduces the coinbase exactly.
+    const std::shared_future<std::optional<CSerializedNetMsg>> lazy_ser_stripped{
+        std::async(std::launch::deferred, [&]() -> std::optional<CSerializedNetMsg> {
+            AssertLockHeld(::cs_main);
+            const std::optional<std::vector<CTxOut>> remainders{PredictRemainderOutputs(*pblock)};
+            const std::vector<CTxOut>& coinbase_vout{pblock->vtx[0]->vout};
+            if (!remainders || remainders->empty() || remainders->size() > coinbase_vout.size()) return std::nullopt;
+            if (!std::equal(remainders->begin(), remainders->end(), coinbase_vout.end() - remainders->size())) return std::nullopt;
+            const CBlockHeaderAndShortTxIDs stripped{*pblock, remainders->size()};
+            return msgMaker.Make(NetMsgType::CMPCTBLOCK, stripped, COMPACTSIZE(stripped.omitted_remainder_outputs));
+        })};
+
     {
         LOCK(m_most_recent_block_mutex);
         m_most_recent_block_hash = hashBlock;
@@ -1866,7 +2144,7 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         m_most_recent_compact_block = pcmpctblock;
     }
 
-    m_connman.ForEachNode([this, pindex, &lazy_ser, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    m_connman.ForEachNode([this, pindex, &lazy_ser, &lazy_ser_stripped, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
 
         if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
@@ -1880,8 +2158,12 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
 
-            const CSerializedNetMsg& ser_cmpctblock{lazy_ser.get()};
-            m_connman.PushMessage(pnode, ser_cmpctblock.Copy());
+            if (state.m_predicts_cmpct_remainders && lazy_ser_stripped.get()) {
+                m_connman.PushMessage(pnode, lazy_ser_stripped.get()->Copy());
+            } else {
+                const CSerializedNetMsg& ser_cmpctblock{lazy_ser.get()};
+                m_connman.PushMessage(pnode, ser_cmpctblock.Copy());
+            }
             state.pindexBestHeaderSent = pindex;
         }
     });
@@ -1976,6 +2258,8 @@ bool PeerManagerImpl::AlreadyHaveTx(const GenTxid& gtxid)
         // txs a second chance.
         hashRecentRejectsChainTip = m_chainman.ActiveChain().Tip()->GetBlockHash();
         m_recent_rejects.reset();
+        m_recent_rejects_reconsiderable.reset();
+        ForgetValidConversionRejects();
     }
 
     const uint256& hash = gtxid.GetHash();
@@ -1987,7 +2271,51 @@ bool PeerManagerImpl::AlreadyHaveTx(const GenTxid& gtxid)
         if (m_recent_confirmed_transactions.contains(hash)) return true;
     }
 
-    return m_recent_rejects.contains(hash) || m_mempool.exists(gtxid);
+    return m_recent_rejects.contains(hash) || m_recent_rejects_reconsiderable.contains(hash) ||
+           m_conversion_rejects.count(hash) || m_mempool.exists(gtxid);
+}
+
+void PeerManagerImpl::AddConversionReject(const uint256& wtxid, const CTxConversionInfo& info)
+{
+    if (!m_conversion_rejects.emplace(wtxid, info).second) return;
+    m_conversion_rejects_order.push_back(wtxid);
+    if (m_conversion_rejects.size() > MAX_CONVERSION_REJECTS) {
+        m_conversion_rejects.erase(m_conversion_rejects_order.front());
+        m_conversion_rejects_order.pop_front();
+    }
+}
+
+void PeerManagerImpl::ForgetValidConversionRejects()
+{
+    if (m_conversion_rejects.empty()) return;
+
+    const int check_last_N_blocks = gArgs.GetIntArg("-mempoolnewconversionschecklastnblocks", DEFAULT_MEMPOOL_NEW_CONVERSIONS_CHECK_LAST_N_BLOCKS);
+    const int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
+    const auto window = m_chainman.ActiveChainstate().GetConversionValidityWindow(check_last_N_blocks, buffer);
+    for (auto it = m_conversion_rejects.begin(); it != m_conversion_rejects.end();) {
+        if (window->IsValid(it->second)) {
+            it = m_conversion_rejects.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_conversion_rejects.size() == m_conversion_rejects_order.size()) return;
+    m_conversion_rejects_order.erase(std::remove_if(m_conversion_rejects_order.begin(), m_conversion_rejects_order.end(),
+                                                    [&](const uint256& wtxid) { return m_conversion_rejects.count(wtxid) == 0; }),
+                                     m_conversion_rejects_order.end());
+    LogPrint(BCLog::MEMPOOL, "%u rejected conversions remain invalid at the new tip\n", m_conversion_rejects.size());
+}
+
+void PeerManagerImpl::AddRecentReject(const CTransaction& tx, const MempoolAcceptResult& result)
+{
+    const TxValidationResult reason{result.m_state.GetResult()};
+    if (reason == TxValidationResult::TX_RECONSIDERABLE) {
+        m_recent_rejects_reconsiderable.insert(tx.GetWitnessHash());
+    } else if (reason == TxValidationResult::TX_INVALID_CONVERSION && result.m_conversion_info) {
+        AddConversionReject(tx.GetWitnessHash(), *result.m_conversion_info);
+    } else {
+        m_recent_rejects.insert(tx.GetWitnessHash());
+    }
 }
 
 bool PeerManagerImpl::AlreadyHaveBlock(const uint256& block_hash)
@@ -2019,7 +2347,7 @@ void PeerManagerImpl::RelayTransaction(const uint256& txid, const uint256& wtxid
 
         const uint256& hash{peer.m_wtxid_relay ? wtxid : txid};
         if (!tx_relay->m_tx_inventory_known_filter.contains(hash)) {
-            tx_relay->m_tx_inventory_to_send.insert(hash);
+            tx_relay->m_tx_inventory_to_send.push_back(hash);
         }
     };
 }
@@ -2145,12 +2473,14 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
         pblock = a_recent_block;
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
-        // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
-        if (!ReadRawBlockFromDisk(block_data, pindex->GetBlockPos(), m_chainparams.MessageStart())) {
+        // as the network format matches the format on disk. Read it straight into the
+        // message, rather than copying it over.
+        CSerializedNetMsg msg;
+        msg.m_type = NetMsgType::BLOCK;
+        if (!ReadRawBlockFromDisk(msg.data, pindex->GetBlockPos(), m_chainparams.MessageStart())) {
             assert(!"cannot load block from disk");
         }
-        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, Span{block_data}));
+        m_connman.PushMessage(&pfrom, std::move(msg));
         // Don't set pblock as we've sent the block
     } else {
         // Send block from disk
@@ -2371,14 +2701,17 @@ void PeerManagerImpl::SendBlockTransactions(CNode& pfrom, Peer& peer, const CBlo
 
 bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, Peer& peer)
 {
+    // Hash the whole message at once, the hashes are needed by both checks
+    const std::vector<uint256> hashes{GetBlockHeaderHashes(headers)};
+
     // Do these headers have proof-of-work matching what's claimed?
-    if (!HasValidProofOfWork(headers, consensusParams)) {
+    if (!HasValidProofOfWork(headers, hashes, consensusParams)) {
         Misbehaving(peer, 100, "header with invalid proof of work");
         return false;
     }
 
     // Are these headers connected to each other?
-    if (!CheckHeadersAreContinuous(headers)) {
+    if (!CheckHeadersAreContinuous(headers, hashes)) {
         Misbehaving(peer, 20, "non-continuous headers sequence");
         return false;
     }
@@ -2439,14 +2772,12 @@ void PeerManagerImpl::HandleFewUnconnectingHeaders(CNode& pfrom, Peer& peer,
     }
 }
 
-bool PeerManagerImpl::CheckHeadersAreContinuous(const std::vector<CBlockHeader>& headers) const
+bool PeerManagerImpl::CheckHeadersAreContinuous(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& hashes) const
 {
-    uint256 hashLastBlock;
-    for (const CBlockHeader& header : headers) {
-        if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+    for (size_t i = 1; i < headers.size(); ++i) {
+        if (headers[i].hashPrevBlock != hashes[i - 1]) {
             return false;
         }
-        hashLastBlock = header.GetHash();
     }
     return true;
 }
@@ -2947,7 +3278,7 @@ void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
                 // See also comments in https://github.com/bitcoin/bitcoin/pull/18044#discussion_r443419034
                 // for concerns around weakening security of unupgraded nodes
                 // if we start doing this too early.
-                m_recent_rejects.insert(porphanTx->GetWitnessHash());
+                AddRecentReject(*porphanTx, result);
                 // If the transaction failed for TX_INPUTS_NOT_STANDARD,
                 // then we know that the witness was irrelevant to the policy
                 // failure, since this check depends only on the txid
@@ -2968,6 +3299,74 @@ void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
     }
 }
 
+CTransactionRef PeerManagerImpl::FindReconsiderableParent(const CTransaction& child)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    for (const auto& [wtxid, tx] : vExtraTxnForCompact) {
+        if (tx == nullptr || !m_recent_rejects_reconsiderable.contains(wtxid)) continue;
+        for (const CTxIn& txin : child.vin) {
+            if (txin.prevout.hash == tx->GetHash()) return tx;
+        }
+    }
+    return nullptr;
+}
+
+CTransactionRef PeerManagerImpl::FindOrphanChild(const CTransaction& parent, NodeId nodeid)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    std::set<uint256> children;
+    m_orphanage.AddChildrenToWorkSet(parent, children);
+    CTransactionRef fallback;
+    for (const uint256& child_txid : children) {
+        const auto [child, from_peer] = m_orphanage.GetTx(child_txid);
+        if (child == nullptr) continue;
+        if (from_peer == nodeid) return child;
+        if (fallback == nullptr) fallback = child;
+    }
+    return fallback;
+}
+
+bool PeerManagerImpl::ProcessParentChildPackage(Peer& peer, const CTransactionRef& parent, const CTransactionRef& child)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    const Package package{parent, child};
+    const PackageMempoolAcceptResult result = ProcessNewPackage(m_chainman.ActiveChainstate(), m_mempool, package, /*test_accept=*/false);
+    LogPrint(BCLog::MEMPOOL, "package of parent %s and child %s from peer=%d: %s\n",
+             parent->GetHash().ToString(), child->GetHash().ToString(), peer.m_id,
+             result.m_state.IsValid() ? "accepted" : result.m_state.ToString());
+
+    for (const CTransactionRef& tx : package) {
+        const auto it = result.m_tx_results.find(tx->GetWitnessHash());
+        if (it == result.m_tx_results.end()) continue;
+        const MempoolAcceptResult& tx_result = it->second;
+        if (tx_result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+            m_txrequest.ForgetTxHash(tx->GetHash());
+            m_txrequest.ForgetTxHash(tx->GetWitnessHash());
+            RelayTransaction(tx->GetHash(), tx->GetWitnessHash());
+            m_orphanage.AddChildrenToWorkSet(*tx, peer.m_orphan_work_set);
+            m_orphanage.EraseTx(tx->GetHash());
+            for (const CTransactionRef& removedTx : tx_result.m_replaced_transactions.value()) {
+                AddToCompactExtraTransactions(removedTx);
+            }
+        } else if (tx_result.m_result_type == MempoolAcceptResult::ResultType::INVALID &&
+                   tx_result.m_state.GetResult() != TxValidationResult::TX_RECONSIDERABLE &&
+                   tx_result.m_state.GetResult() != TxValidationResult::TX_MISSING_INPUTS &&
+                   tx_result.m_state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
+            // The transaction would not be accepted in any package, so treat it as a
+            // transaction rejected on its own.
+            AddRecentReject(*tx, tx_result);
+            m_orphanage.EraseTx(tx->GetHash());
+        }
+    }
+    return result.m_state.IsValid();
+}
+
 bool PeerManagerImpl::PrepareBlockFilterRequest(CNode& node, Peer& peer,
                                                 BlockFilterType filter_type, uint32_t start_height,
                                                 const uint256& stop_hash, uint32_t max_height_diff,
@@ -3148,6 +3547,41 @@ void PeerManagerImpl::ProcessBlock(CNode& node, const std::shared_ptr<const CBlo
     }
 }
 
+void PeerManagerImpl::ProcessReceivedBlocks(CNode& node, Peer& peer)
+{
+    while (true) {
+        std::shared_ptr<const CBlock> pblock;
+        {
+            LOCK(peer.m_received_blocks_mutex);
+            if (peer.m_received_blocks.empty() || !peer.m_received_blocks.front()->checked) return;
+            pblock = std::move(peer.m_received_blocks.front()->block);
+            peer.m_received_blocks.pop_front();
+        }
+
+        bool forceProcessing = false;
+        const uint256 hash(pblock->GetHash());
+        bool min_pow_checked = false;
+        {
+            LOCK(cs_main);
+            // Always process the block if we requested it, since we may
+            // need it even when it's not a candidate for a new best tip.
+            forceProcessing = IsBlockRequested(hash);
+            RemoveBlockRequest(hash, node.GetId());
+            // mapBlockSource is only used for punishing peers and setting
+            // which peers send us compact blocks, so the race between here and
+            // cs_main in ProcessNewBlock is fine.
+            mapBlockSource.emplace(hash, std::make_pair(node.GetId(), true));
+
+            // Check work on this block against our anti-dos thresholds.
+            const CBlockIndex* prev_block = m_chainman.m_blockman.LookupBlockIndex(pblock->hashPrevBlock);
+            if (prev_block && prev_block->nChainWork + CalculateHeadersWork({pblock->GetBlockHeader()}) >= GetAntiDoSWorkThreshold()) {
+                min_pow_checked = true;
+            }
+        }
+        ProcessBlock(node, pblock, forceProcessing, min_pow_checked);
+    }
+}
+
 void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDataStream& vRecv,
                                      const std::chrono::microseconds time_received,
                                      const std::atomic<bool>& interruptMsgProc)
@@ -3253,8 +3687,6 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDADDRV2));
         }
 
-        m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::VERACK));
-
         pfrom.m_has_all_wanted_services = HasAllDesirableServiceFlags(nServices);
         peer->m_their_services = nServices;
         pfrom.SetAddrLocal(addrMe);
@@ -3278,6 +3710,22 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             if (fRelay) pfrom.m_relays_txs = true;
         }
 
+        if (greatest_common_version >= WTXID_RELAY_VERSION && m_txreconciliation) {
+            // Per BIP-330, we announce txreconciliation support if:
+            // - protocol version per the peer's VERSION message supports WTXID_RELAY;
+            // - transaction relay is supported per the peer's VERSION message (see m_relays_txs);
+            // - this is not a block-relay-only connection (see m_relays_txs) and not a feeler;
+            // - this is not an addr fetch connection;
+            // - we are not in -blocksonly mode.
+            if (pfrom.m_relays_txs && !pfrom.IsFeelerConn() && !pfrom.IsAddrFetchConn() && !m_ignore_incoming_txs) {
+                const uint64_t recon_salt = m_txreconciliation->PreRegisterPeer(pfrom.GetId());
+                m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDTXRCNCL,
+                                                             TXRECONCILIATION_VERSION, recon_salt));
+            }
+        }
+
+        m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::VERACK));
+
         // Potentially mark this peer as a preferred download peer.
         {
             LOCK(cs_main);
@@ -3404,6 +3852,9 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             // We send this to non-NODE NETWORK peers as well, because
             // they may wish to request compact blocks from us
             m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, /*high_bandwidth=*/false, /*version=*/CMPCTBLOCKS_VERSION));
+            // Also tell them we can restore omitted conversion remainder outputs.
+            // Peers that don't know this version ignore it.
+            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, /*high_bandwidth=*/false, /*version=*/CMPCTBLOCKS_REMAINDERS_VERSION));
         }
 
         if (auto tx_relay = peer->GetTxRelay()) {
@@ -3420,6 +3871,15 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                        tx_relay->m_next_inv_send_time == 0s));
         }
 
+        if (m_txreconciliation) {
+            if (!peer->m_wtxid_relay || !m_txreconciliation->IsPeerRegistered(pfrom.GetId())) {
+                // We could have optimistically pre-registered/registered the peer. In that case,
+                // we should forget about the reconciliation state here if this wasn't followed
+                // by WTXIDRELAY (since WTXIDRELAY can't be announced later).
+                m_txreconciliation->ForgetPeer(pfrom.GetId());
+            }
+        }
+
         pfrom.fSuccessfullyConnected = true;
         return;
     }
@@ -3435,6 +3895,13 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         uint64_t sendcmpct_version{0};
         vRecv >> sendcmpct_hb >> sendcmpct_version;
 
+        // Remainder prediction is an extension that doesn't affect announcements
+        if (sendcmpct_version == CMPCTBLOCKS_REMAINDERS_VERSION) {
+            LOCK(cs_main);
+            State(pfrom.GetId())->m_predicts_cmpct_remainders = true;
+            return;
+        }
+
         // Only support compact block relay with witnesses
         if (sendcmpct_version != CMPCTBLOCKS_VERSION) return;
 
@@ -3470,6 +3937,61 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    // Received from a peer demonstrating readiness to announce transactions via reconciliations.
+    // This feature negotiation must happen between VERSION and VERACK to avoid relay problems
+    // from switching announcement protocols after the connection is up.
+    if (msg_type == NetMsgType::SENDTXRCNCL) {
+        if (!m_txreconciliation) {
+            LogPrint(BCLog::NET, "sendtxrcncl from peer=%d ignored, as our node does not have txreconciliation enabled\n", pfrom.GetId());
+            return;
+        }
+
+        if (pfrom.fSuccessfullyConnected) {
+            LogPrint(BCLog::NET, "sendtxrcncl received after verack from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+
+        // Peer must not offer us reconciliations if we specified no tx relay support in VERSION.
+        if (RejectIncomingTxs(pfrom)) {
+            LogPrint(BCLog::NET, "sendtxrcncl received from peer=%d to which we indicated no tx relay; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+
+        // Peer must not offer us reconciliations if they specified no tx relay support in VERSION.
+        // This flag might also be false in other cases, but the RejectIncomingTxs check above
+        // eliminates them, so that this flag fully represents what we are looking for.
+        if (!pfrom.m_relays_txs) {
+            LogPrint(BCLog::NET, "sendtxrcncl received from peer=%d which indicated no tx relay to us; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+
+        uint32_t peer_txreconcl_version;
+        uint64_t remote_salt;
+        vRecv >> peer_txreconcl_version >> remote_salt;
+
+        const ReconciliationRegisterResult result = m_txreconciliation->RegisterPeer(pfrom.GetId(), pfrom.IsInboundConn(),
+                                                                                     peer_txreconcl_version, remote_salt);
+        switch (result) {
+        case ReconciliationRegisterResult::NOT_FOUND:
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "Ignore unexpected txreconciliation signal from peer=%d\n", pfrom.GetId());
+            break;
+        case ReconciliationRegisterResult::SUCCESS:
+            break;
+        case ReconciliationRegisterResult::ALREADY_REGISTERED:
+            LogPrint(BCLog::NET, "txreconciliation protocol violation from peer=%d (sendtxrcncl received from already registered peer); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        case ReconciliationRegisterResult::PROTOCOL_VIOLATION:
+            LogPrint(BCLog::NET, "txreconciliation protocol violation from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        return;
+    }
+
     // BIP155 defines feature negotiation of addrv2 and sendaddrv2, which must happen
     // between VERSION and VERACK.
     if (msg_type == NetMsgType::SENDADDRV2) {
@@ -3599,6 +4121,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         const auto current_time{GetTime<std::chrono::microseconds>()};
         uint256* best_block{nullptr};
+        // Transaction announcements are handed to m_txrequest in one batch after the loop.
+        std::vector<GenTxid> tx_announcements;
 
         for (CInv& inv : vInv) {
             if (interruptMsgProc) return;
@@ -3638,13 +4162,15 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
                 AddKnownTx(*peer, inv.hash);
                 if (!fAlreadyHave && !m_chainman.ActiveChainstate().IsInitialBlockDownload()) {
-                    AddTxAnnouncement(pfrom, gtxid, current_time);
+                    tx_announcements.push_back(gtxid);
                 }
             } else {
                 LogPrint(BCLog::NET, "Unknown inv type \"%s\" received from peer=%d\n", inv.ToString(), pfrom.GetId());
             }
         }
 
+        AddTxAnnouncements(pfrom, tx_announcements, current_time);
+
         if (best_block != nullptr) {
             // If we haven't started initial headers-sync with this peer, then
             // consider sending a getheaders now. On initial startup, there's a
@@ -4007,9 +4533,18 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                     break;
                 }
             }
-            if (!fRejectedParents) {
+            // A parent that was rejected for its feerate alone may be accepted together
+            // with this child, as a package.
+            const CTransactionRef reconsiderable_parent{fRejectedParents ? nullptr : FindReconsiderableParent(tx)};
+            if (reconsiderable_parent && ProcessParentChildPackage(*peer, reconsiderable_parent, ptx)) {
+                pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
+
+                // Recursively process any orphan transactions that depended on the package
+                ProcessOrphanTx(peer->m_orphan_work_set);
+            } else if (!fRejectedParents) {
                 const auto current_time{GetTime<std::chrono::microseconds>()};
 
+                std::vector<GenTxid> parent_announcements;
                 for (const uint256& parent_txid : unique_parents) {
                     // Here, we only have the txid (and not wtxid) of the
                     // inputs, so we only request in txid mode, even for
@@ -4018,8 +4553,9 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                     // protocol for getting all unconfirmed parents.
                     const auto gtxid{GenTxid::Txid(parent_txid)};
                     AddKnownTx(*peer, parent_txid);
-                    if (!AlreadyHaveTx(gtxid)) AddTxAnnouncement(pfrom, gtxid, current_time);
+                    if (!AlreadyHaveTx(gtxid)) parent_announcements.push_back(gtxid);
                 }
+                AddTxAnnouncements(pfrom, parent_announcements, current_time);
 
                 if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
                     AddToCompactExtraTransactions(ptx);
@@ -4060,7 +4596,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 // See also comments in https://github.com/bitcoin/bitcoin/pull/18044#discussion_r443419034
                 // for concerns around weakening security of unupgraded nodes
                 // if we start doing this too early.
-                m_recent_rejects.insert(tx.GetWitnessHash());
+                AddRecentReject(tx, result);
                 m_txrequest.ForgetTxHash(tx.GetWitnessHash());
                 // If the transaction failed for TX_INPUTS_NOT_STANDARD,
                 // then we know that the witness was irrelevant to the policy
@@ -4078,6 +4614,15 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                     AddToCompactExtraTransactions(ptx);
                 }
             }
+            if (state.GetResult() == TxValidationResult::TX_RECONSIDERABLE) {
+                // The transaction may have been fetched as the parent of an orphan that
+                // pays for it, so try them as a package.
+                const CTransactionRef child{FindOrphanChild(tx, pfrom.GetId())};
+                if (child && ProcessParentChildPackage(*peer, ptx, child)) {
+                    pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
+                    ProcessOrphanTx(peer->m_orphan_work_set);
+                }
+            }
         }
 
         // If a tx has been detected by m_recent_rejects, we will have reached
@@ -4116,6 +4661,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         CBlockHeaderAndShortTxIDs cmpctblock;
         vRecv >> cmpctblock;
+        // Count of conversion remainder outputs stripped from the coinbase
+        if (!vRecv.empty()) vRecv >> COMPACTSIZE(cmpctblock.omitted_remainder_outputs);
 
         bool received_new_header = false;
 
@@ -4219,7 +4766,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 }
 
                 PartiallyDownloadedBlock& partialBlock = *(*queuedBlockIt)->partialBlock;
-                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = partialBlock.InitData(cmpctblock, GetCompactExtraTransactions());
                 if (status == READ_STATUS_INVALID) {
                     RemoveBlockRequest(pindex->GetBlockHash()); // Reset in-flight state in case Misbehaving does not result in a disconnect
                     Misbehaving(*peer, 100, "invalid compact block");
@@ -4254,13 +4801,16 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 // Optimistically try to reconstruct anyway since we might be
                 // able to without any round trips.
                 PartiallyDownloadedBlock tempBlock(&m_mempool);
-                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                ReadStatus status = tempBlock.InitData(cmpctblock, GetCompactExtraTransactions());
                 if (status != READ_STATUS_OK) {
                     // TODO: don't ignore failures
                     return;
                 }
                 std::vector<CTransactionRef> dummy;
-                status = tempBlock.FillBlock(*pblock, dummy);
+                status = tempBlock.FillBlock(*pblock, dummy, [this](const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+                    AssertLockHeld(::cs_main);
+                    return PredictRemainderOutputs(block);
+                });
                 if (status == READ_STATUS_OK) {
                     fBlockReconstructed = true;
                 }
@@ -4346,7 +4896,10 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             }
 
             PartiallyDownloadedBlock& partialBlock = *it->second.second->partialBlock;
-            ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn);
+            ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn, [this](const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+                AssertLockHeld(::cs_main);
+                return PredictRemainderOutputs(block);
+            });
             if (status == READ_STATUS_INVALID) {
                 RemoveBlockRequest(resp.blockhash); // Reset in-flight state in case Misbehaving does not result in a disconnect
                 Misbehaving(*peer, 100, "invalid compact block/non-matching block transactions");
@@ -4455,27 +5008,24 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom.GetId());
 
-        bool forceProcessing = false;
-        const uint256 hash(pblock->GetHash());
-        bool min_pow_checked = false;
+        // During initial block download, the context-free checks of the block
+        // run on a block check worker thread while further messages are
+        // processed. The block stays requested until it is processed, so it
+        // is not downloaded again in the meantime.
+        auto received = std::make_shared<Peer::ReceivedBlock>();
+        received->block = pblock;
+        if (!m_chainman.ActiveChainstate().IsInitialBlockDownload() ||
+            !QueueBlockCheck(pblock, m_chainparams.GetConsensus(), [this, received] {
+                received->checked = true;
+                m_connman.WakeMessageHandler();
+            })) {
+            received->checked = true;
+        }
         {
-            LOCK(cs_main);
-            // Always process the block if we requested it, since we may
-            // need it even when it's not a candidate for a new best tip.
-            forceProcessing = IsBlockRequested(hash);
-            RemoveBlockRequest(hash);
-            // mapBlockSource is only used for punishing peers and setting
-            // which peers send us compact blocks, so the race between here and
-            // cs_main in ProcessNewBlock is fine.
-            mapBlockSource.emplace(hash, std::make_pair(pfrom.GetId(), true));
-
-            // Check work on this block against our anti-dos thresholds.
-            const CBlockIndex* prev_block = m_chainman.m_blockman.LookupBlockIndex(pblock->hashPrevBlock);
-            if (prev_block && prev_block->nChainWork + CalculateHeadersWork({pblock->GetBlockHeader()}) >= GetAntiDoSWorkThreshold()) {
-                min_pow_checked = true;
-            }
+            LOCK(peer->m_received_blocks_mutex);
+            peer->m_received_blocks.push_back(std::move(received));
         }
-        ProcessBlock(pfrom, pblock, forceProcessing, min_pow_checked);
+        ProcessReceivedBlocks(pfrom, *peer);
         return;
     }
 
@@ -4799,9 +5349,18 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
         }
     }
 
+    ProcessReceivedBlocks(*pfrom, *peer);
+
     if (pfrom->fDisconnect)
         return false;
 
+    // Wait for the checks of the received blocks before taking more
+    // messages. The message handler is woken when a check finishes.
+    {
+        LOCK(peer->m_received_blocks_mutex);
+        if (peer->m_received_blocks.size() >= MAX_RECEIVED_BLOCKS_PER_PEER) return false;
+    }
+
     // this maintains the order of responses
     // and prevents m_getdata_requests to grow unbounded
     {
@@ -5224,27 +5783,6 @@ void PeerManagerImpl::MaybeSendFeefilter(CNode& pto, Peer& peer, std::chrono::mi
     }
 }
 
-namespace {
-class CompareInvMempoolOrder
-{
-    CTxMemPool* mp;
-    bool m_wtxid_relay;
-public:
-    explicit CompareInvMempoolOrder(CTxMemPool *_mempool, bool use_wtxid)
-    {
-        mp = _mempool;
-        m_wtxid_relay = use_wtxid;
-    }
-
-    bool operator()(std::set<uint256>::iterator a, std::set<uint256>::iterator b)
-    {
-        /* As std::make_heap produces a max-heap, we want the entries with the
-         * fewest ancestors/highest fee to sort later. */
-        return mp->CompareDepthAndScore(*b, *a, m_wtxid_relay);
-    }
-};
-} // namespace
-
 bool PeerManagerImpl::RejectIncomingTxs(const CNode& peer) const
 {
     // block-relay-only peers may never send txs to us
@@ -5535,6 +6073,13 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                     if (!tx_relay->m_relay_txs) tx_relay->m_tx_inventory_to_send.clear();
                 }
 
+                if (fSendTrickle) {
+                    // Remove duplicate announcements queued since the last trickle
+                    auto& to_send{tx_relay->m_tx_inventory_to_send};
+                    std::sort(to_send.begin(), to_send.end());
+                    to_send.erase(std::unique(to_send.begin(), to_send.end()), to_send.end());
+                }
+
                 // Respond to BIP35 mempool requests
                 if (fSendTrickle && tx_relay->m_send_mempool) {
                     auto vtxinfo = m_mempool.infoAll();
@@ -5543,10 +6088,14 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
 
                     LOCK(tx_relay->m_bloom_filter_mutex);
 
+                    // The response covers every transaction still to be announced
+                    // that is in the mempool, so they are removed from m_tx_inventory_to_send.
+                    std::vector<uint256> responded;
+                    responded.reserve(vtxinfo.size());
                     for (const auto& txinfo : vtxinfo) {
                         const uint256& hash = peer->m_wtxid_relay ? txinfo.tx->GetWitnessHash() : txinfo.tx->GetHash();
                         CInv inv(peer->m_wtxid_relay ? MSG_WTX : MSG_TX, hash);
-                        tx_relay->m_tx_inventory_to_send.erase(hash);
+                        responded.push_back(hash);
                         // Don't send transactions that peers will not put into their mempool
                         if (txinfo.fee < filterrate.GetFee(txinfo.vsize)) {
                             continue;
@@ -5562,35 +6111,50 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             vInv.clear();
                         }
                     }
+                    std::sort(responded.begin(), responded.end());
+                    auto& to_send{tx_relay->m_tx_inventory_to_send};
+                    to_send.erase(std::remove_if(to_send.begin(), to_send.end(), [&](const uint256& hash) {
+                        return std::binary_search(responded.begin(), responded.end(), hash);
+                    }), to_send.end());
                     tx_relay->m_last_mempool_req = std::chrono::duration_cast<std::chrono::seconds>(current_time);
                 }
 
                 // Determine transactions to relay
                 if (fSendTrickle) {
-                    // Produce a vector with all candidates for sending
-                    std::vector<std::set<uint256>::iterator> vInvTx;
+                    // Topologically and fee-rate sort the inventory we send for privacy and priority reasons,
+                    // by the position of each candidate for sending in the order shared by all peers.
+                    const auto relay_order{GetTxRelayOrder(current_time)};
+                    std::vector<std::pair<uint64_t, uint256>> vInvTx;
                     vInvTx.reserve(tx_relay->m_tx_inventory_to_send.size());
-                    for (std::set<uint256>::iterator it = tx_relay->m_tx_inventory_to_send.begin(); it != tx_relay->m_tx_inventory_to_send.end(); it++) {
-                        vInvTx.push_back(it);
+                    std::vector<uint256> unordered;
+                    for (const uint256& hash : tx_relay->m_tx_inventory_to_send) {
+                        if (const auto it{relay_order->positions.find(hash)}; it != relay_order->positions.end()) {
+                            vInvTx.emplace_back(it->second, hash);
+                        } else {
+                            unordered.push_back(hash);
+                        }
+                    }
+                    if (!unordered.empty()) {
+                        // Transactions that entered the mempool after the order was taken go last, parents first
+                        const auto ancestor_counts{m_mempool.GetAncestorCounts(unordered, peer->m_wtxid_relay)};
+                        for (size_t i = 0; i < unordered.size(); ++i) {
+                            vInvTx.emplace_back(relay_order->positions.size() + ancestor_counts[i], unordered[i]);
+                        }
                     }
+                    tx_relay->m_tx_inventory_to_send.clear();
                     const CFeeRate filterrate{tx_relay->m_fee_filter_received.load()};
-                    // Topologically and fee-rate sort the inventory we send for privacy and priority reasons.
                     // A heap is used so that not all items need sorting if only a few are being sent.
-                    CompareInvMempoolOrder compareInvMempoolOrder(&m_mempool, peer->m_wtxid_relay);
-                    std::make_heap(vInvTx.begin(), vInvTx.end(), compareInvMempoolOrder);
+                    std::make_heap(vInvTx.begin(), vInvTx.end(), std::greater<>{});
                     // No reason to drain out at many times the network's capacity,
                     // especially since we have many peers and some will draw much shorter delays.
                     unsigned int nRelayedTransactions = 0;
                     LOCK(tx_relay->m_bloom_filter_mutex);
                     while (!vInvTx.empty() && nRelayedTransactions < INVENTORY_BROADCAST_MAX) {
                         // Fetch the top element from the heap
-                        std::pop_heap(vInvTx.begin(), vInvTx.end(), compareInvMempoolOrder);
-                        std::set<uint256>::iterator it = vInvTx.back();
+                        std::pop_heap(vInvTx.begin(), vInvTx.end(), std::greater<>{});
+                        uint256 hash = vInvTx.back().second;
                         vInvTx.pop_back();
-                        uint256 hash = *it;
                         CInv inv(peer->m_wtxid_relay ? MSG_WTX : MSG_TX, hash);
-                        // Remove it from the to-be-sent set
-                        tx_relay->m_tx_inventory_to_send.erase(it);
                         // Check if not in the filter already
                         if (tx_relay->m_tx_inventory_known_filter.contains(hash)) {
                             continue;
@@ -5643,6 +6207,10 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             tx_relay->m_tx_inventory_known_filter.insert(txid);
                         }
                     }
+                    // Put back the candidates not sent now
+                    for (const auto& [position, hash] : vInvTx) {
+                        tx_relay->m_tx_inventory_to_send.push_back(hash);
+                    }
                 }
         }
         if (!vInv.empty())
@@ -5712,10 +6280,22 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.ActiveChainstate().IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        const int max_blocks_in_transit{MaxBlocksInTransit(state)};
+        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.ActiveChainstate().IsInitialBlockDownload()) && state.nBlocksInFlight < max_blocks_in_transit) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(*peer, MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller);
+            FindNextBlocksToDownload(*peer, max_blocks_in_transit - state.nBlocksInFlight, vToDownload, staller);
+            if (vToDownload.empty() && staller != -1) {
+                // The download window can't move until staller delivers its oldest block. If we
+                // expect this peer to be much faster, request the block here instead of waiting
+                // for the stalling timeout.
+                if (const CBlockIndex* pindex{FindBlockToReassign(state, staller, current_time)}) {
+                    LogPrint(BCLog::NET, "Reassigning block %s (%d) from slow peer=%d to peer=%d\n", pindex->GetBlockHash().ToString(),
+                        pindex->nHeight, staller, pto->GetId());
+                    vToDownload.push_back(pindex);
+                    staller = -1;
+                }
+            }
             for (const CBlockIndex *pindex : vToDownload) {
                 uint32_t nFetchFlags = GetFetchFlags(*peer);
                 vGetData.push_back(CInv(MSG_BLOCK | nFetchFlags, pindex->GetBlockHash()));
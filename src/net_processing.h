@@ -18,6 +18,8 @@ class ChainstateManager;
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+/** Default for -blockreconstructionconversionbytes, memory usage of conversions no longer valid for the mempool to keep around for block reconstruction */
+static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_CONVERSION_BYTES = 1'000'000;
 static const bool DEFAULT_PEERBLOOMFILTERS = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
@@ -36,6 +38,18 @@ struct CNodeStateStats {
     bool m_addr_relay_enabled{false};
     ServiceFlags their_services;
     int64_t presync_height{-1};
+    /** Memory used by the filters and queues for relaying transactions to the peer */
+    size_t m_tx_relay_memory{0};
+};
+
+/** Memory used by the state PeerManager keeps, see PeerManager::GetMemoryUsage() */
+struct PeerManagerMemoryUsage {
+    //! Orphan transactions
+    size_t orphanage{0};
+    //! Headers presync state of the peers
+    size_t headers_sync{0};
+    //! Filters and queues for relaying transactions to the peers
+    size_t tx_relay{0};
 };
 
 class PeerManager : public CValidationInterface, public NetEventsInterface
@@ -61,6 +75,9 @@ public:
     /** Get statistics from node state */
     virtual bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) const = 0;
 
+    /** Get the memory used by the orphanage and the state of all peers */
+    virtual PeerManagerMemoryUsage GetMemoryUsage() const = 0;
+
     /** Whether this node ignores txs received over p2p. */
     virtual bool IgnoresIncomingTxs() = 0;
 
@@ -1068,10 +1068,8 @@ bool CSubNet::Match(const CNetAddr &addr) const
     return true;
 }
 
-std::string CSubNet::ToString() const
+uint8_t CSubNet::GetPrefixLength() const
 {
-    std::string suffix;
-
     switch (network.m_net) {
     case NET_IPV4:
     case NET_IPV6: {
@@ -1086,9 +1084,28 @@ std::string CSubNet::ToString() const
             cidr += NetmaskBits(netmask[i]);
         }
 
-        suffix = strprintf("/%u", cidr);
+        return cidr;
+    }
+    case NET_ONION:
+    case NET_I2P:
+    case NET_CJDNS:
+    case NET_INTERNAL:
+    case NET_UNROUTABLE:
+    case NET_MAX:
         break;
     }
+    return 0;
+}
+
+std::string CSubNet::ToString() const
+{
+    std::string suffix;
+
+    switch (network.m_net) {
+    case NET_IPV4:
+    case NET_IPV6:
+        suffix = strprintf("/%u", GetPrefixLength());
+        break;
     case NET_ONION:
     case NET_I2P:
     case NET_CJDNS:
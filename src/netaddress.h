@@ -508,6 +508,12 @@ public:
 
     bool Match(const CNetAddr& addr) const;
 
+    /**
+     * Number of leading 1-bits of the netmask of an IPv4 or IPv6 subnet, so that it equals
+     * CSubNet(addr, GetPrefixLength()) for any address it matches. 0 for other networks.
+     */
+    uint8_t GetPrefixLength() const;
+
     std::string ToString() const;
     bool IsValid() const;
 
@@ -4,9 +4,14 @@
 
 #include <netgroup.h>
 
+#include <crypto/common.h>
 #include <hash.h>
 #include <util/asmap.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+
 uint256 NetGroupManager::GetAsmapChecksum() const
 {
     if (!m_asmap.size()) return {};
@@ -83,6 +88,19 @@ uint32_t NetGroupManager::GetMappedAS(const CNetAddr& address) const
     if (m_asmap.size() == 0 || (net_class != NET_IPV4 && net_class != NET_IPV6)) {
         return 0; // Indicates not found, safe because AS0 is reserved per RFC7607.
     }
+    if (!m_asmap_ranges.empty()) {
+        // Look up the same 128 bits as below
+        std::array<uint8_t, ADDR_IPV6_SIZE> ip;
+        if (address.HasLinkedIPv4()) {
+            std::copy(IPV4_IN_IPV6_PREFIX.begin(), IPV4_IN_IPV6_PREFIX.end(), ip.begin());
+            WriteBE32(ip.data() + IPV4_IN_IPV6_PREFIX.size(), address.GetLinkedIPv4());
+        } else {
+            assert(address.IsIPv6());
+            const auto addr_bytes = address.GetAddrBytes();
+            std::copy(addr_bytes.begin(), addr_bytes.end(), ip.begin());
+        }
+        return InterpretCompiled(m_asmap_ranges, ReadBE64(ip.data()), ReadBE64(ip.data() + 8));
+    }
     std::vector<bool> ip_bits(128);
     if (address.HasLinkedIPv4()) {
         // For lookup, treat as if it was just an IPv4 address (IPV4_IN_IPV6_PREFIX + IPv4 bits)
@@ -7,6 +7,7 @@
 
 #include <netaddress.h>
 #include <uint256.h>
+#include <util/asmap.h>
 
 #include <vector>
 
@@ -16,7 +17,8 @@
 class NetGroupManager {
 public:
     explicit NetGroupManager(std::vector<bool> asmap)
-        : m_asmap{std::move(asmap)}
+        : m_asmap{std::move(asmap)},
+          m_asmap_ranges{SanityCheckASMap(m_asmap, 128) ? CompileAsmap(m_asmap) : std::vector<AsmapRange>{}}
     {}
 
     /** Get a checksum identifying the asmap being used. */
@@ -61,6 +63,9 @@ private:
      * This is initialized in the constructor, const, and therefore is
      * thread-safe. */
     const std::vector<bool> m_asmap;
+
+    /** m_asmap compiled into ranges of addresses for fast lookups, or empty if m_asmap is. */
+    const std::vector<AsmapRange> m_asmap_ranges;
 };
 
 #endif // BITCOIN_NETGROUP_H
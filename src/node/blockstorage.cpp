@@ -8,20 +8,26 @@
 #include <chainparams.h>
 #include <clientversion.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <fs.h>
 #include <hash.h>
+#include <memusage.h>
 #include <pow.h>
 #include <reverse_iterator.h>
 #include <shutdown.h>
 #include <signet.h>
 #include <streams.h>
 #include <undo.h>
-#include <util/syscall_sandbox.h>
 #include <util/system.h>
+#include <util/thread.h>
+#include <util/threadpool.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <map>
+#include <thread>
 #include <unordered_map>
 
 namespace node {
@@ -29,6 +35,80 @@ std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fPruneMode = false;
 uint64_t nPruneTarget = 0;
+std::atomic_bool g_mmap_block_files{DEFAULT_MMAP_BLOCKFILES};
+std::atomic_bool g_block_undo_v2{DEFAULT_BLOCK_UNDO_V2};
+
+/** Mappings of the block and undo files read with -mmapblockfiles */
+static FlatFileMappingCache g_block_file_mappings{MAX_MAPPED_BLOCKFILES};
+
+/**
+ * Unlinks the block and undo files of pruned block files, and syncs the blocks
+ * directory, on a thread that is started when the first files are added.
+ */
+class PrunedFileRemover
+{
+public:
+    ~PrunedFileRemover()
+    {
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void Add(const std::set<int>& files) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (files.empty()) return;
+        {
+            LOCK(m_mutex);
+            m_pending.insert(files.begin(), files.end());
+            if (!m_thread.joinable()) {
+                m_thread = std::thread(&util::TraceThread, "prune", [this] { Run(); });
+            }
+        }
+        m_cond.notify_all();
+    }
+
+    void Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_pending.empty() && !m_busy; });
+    }
+
+private:
+    void Run() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (true) {
+            m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_pending.empty() || m_stop; });
+            // Files still pending at shutdown are unlinked before stopping
+            if (m_pending.empty()) return;
+            std::set<int> files;
+            files.swap(m_pending);
+            m_busy = true;
+            {
+                REVERSE_LOCK(lock);
+                UnlinkPrunedFiles(files);
+                DirectoryCommit(gArgs.GetBlocksDirPath());
+            }
+            m_busy = false;
+            m_cond.notify_all();
+        }
+    }
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::set<int> m_pending GUARDED_BY(m_mutex);
+    bool m_busy GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+};
+
+BlockManager::BlockManager() : m_pruned_file_remover{std::make_unique<PrunedFileRemover>()} {}
+
+BlockManager::~BlockManager() = default;
 
 bool CBlockIndexWorkComparator::operator()(const CBlockIndex* pa, const CBlockIndex* pb) const
 {
@@ -57,6 +137,7 @@ bool CBlockIndexHeightOnlyComparator::operator()(const CBlockIndex* pa, const CB
 static FILE* OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false);
 static FlatFileSeq BlockFileSeq();
 static FlatFileSeq UndoFileSeq();
+static std::shared_ptr<const FlatFileMapping> MapRecord(const FlatFileSeq& seq, const FlatFilePos& pos, size_t trailer_size, Span<const unsigned char>& header, Span<const unsigned char>& record);
 
 std::vector<CBlockIndex*> BlockManager::GetAllBlockIndices()
 {
@@ -69,6 +150,14 @@ std::vector<CBlockIndex*> BlockManager::GetAllBlockIndices()
     return rv;
 }
 
+size_t BlockManager::DynamicMemoryUsage()
+{
+    AssertLockHeld(cs_main);
+    size_t usage{memusage::DynamicUsage(m_block_index) + memusage::DynamicUsage(m_dirty_blockindex)};
+    LOCK(cs_LastBlockFile);
+    return usage + memusage::DynamicUsage(m_blockfile_info) + memusage::DynamicUsage(m_dirty_fileinfo);
+}
+
 CBlockIndex* BlockManager::LookupBlockIndex(const uint256& hash)
 {
     AssertLockHeld(cs_main);
@@ -104,9 +193,12 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockInde
         pindexNew->pprev = &(*miPrev).second;
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
         pindexNew->BuildSkip();
+        pindexNew->LinkToParent();
         pindexNew->BuildScaleFactor(consensus_params);
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
+    pindexNew->BuildMedianTimePast();
+    pindexNew->BuildSupplyViews();
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
     if (best_header == nullptr || best_header->nChainWork < pindexNew->nChainWork) {
@@ -148,10 +240,21 @@ void BlockManager::PruneOneBlockFile(const int fileNumber)
         }
     }
 
+    m_blockfile_usage -= m_blockfile_info[fileNumber].nSize + m_blockfile_info[fileNumber].nUndoSize;
     m_blockfile_info[fileNumber].SetNull();
     m_dirty_fileinfo.insert(fileNumber);
 }
 
+void BlockManager::UnlinkPrunedFilesInBackground(const std::set<int>& setFilesToPrune)
+{
+    m_pruned_file_remover->Add(setFilesToPrune);
+}
+
+void BlockManager::WaitForPrunedFilesUnlinked()
+{
+    m_pruned_file_remover->Wait();
+}
+
 void BlockManager::FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nManualPruneHeight, int chain_tip_height)
 {
     assert(fPruneMode && nManualPruneHeight > 0);
@@ -164,7 +267,7 @@ void BlockManager::FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nM
     // last block to prune is the lesser of (user-specified height, MIN_BLOCKS_TO_KEEP from the tip)
     unsigned int nLastBlockWeCanPrune = std::min((unsigned)nManualPruneHeight, chain_tip_height - MIN_BLOCKS_TO_KEEP);
     int count = 0;
-    for (int fileNumber = 0; fileNumber < m_last_blockfile; fileNumber++) {
+    for (int fileNumber = m_first_unpruned_blockfile; fileNumber < m_last_blockfile; fileNumber++) {
         if (m_blockfile_info[fileNumber].nSize == 0 || m_blockfile_info[fileNumber].nHeightLast > nLastBlockWeCanPrune) {
             continue;
         }
@@ -172,6 +275,7 @@ void BlockManager::FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nM
         setFilesToPrune.insert(fileNumber);
         count++;
     }
+    UpdateFirstUnprunedBlockFile();
     LogPrintf("Prune (Manual): prune_height=%d removed %d blk/rev pairs\n", nLastBlockWeCanPrune, count);
 }
 
@@ -204,7 +308,7 @@ void BlockManager::FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPr
             nBuffer += nPruneTarget / 10;
         }
 
-        for (int fileNumber = 0; fileNumber < m_last_blockfile; fileNumber++) {
+        for (int fileNumber = m_first_unpruned_blockfile; fileNumber < m_last_blockfile; fileNumber++) {
             nBytesToPrune = m_blockfile_info[fileNumber].nSize + m_blockfile_info[fileNumber].nUndoSize;
 
             if (m_blockfile_info[fileNumber].nSize == 0) {
@@ -226,6 +330,7 @@ void BlockManager::FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPr
             nCurrentUsage -= nBytesToPrune;
             count++;
         }
+        UpdateFirstUnprunedBlockFile();
     }
 
     LogPrint(BCLog::PRUNE, "target=%dMiB actual=%dMiB diff=%dMiB max_prune_height=%d removed %d blk/rev pairs\n",
@@ -255,6 +360,19 @@ CBlockIndex* BlockManager::InsertBlockIndex(const uint256& hash)
     return pindex;
 }
 
+/** Store the proof of each block in its nChainWork, splitting large indexes across the shared thread pool by height range. */
+static void ComputeBlockProofs(const std::vector<CBlockIndex*>& indices)
+{
+    static constexpr size_t MIN_INDICES_PER_THREAD{10000};
+    const size_t num_chunks{std::clamp<size_t>(indices.size() / MIN_INDICES_PER_THREAD, 1, std::max(GetNumCores(), 1))};
+    const size_t chunk_size{(indices.size() + num_chunks - 1) / num_chunks};
+    util::ParallelFor("blockproofs", util::TaskPriority::HIGH, num_chunks, num_chunks, [&](size_t chunk) {
+        for (size_t i = chunk * chunk_size; i < std::min(indices.size(), (chunk + 1) * chunk_size); ++i) {
+            indices[i]->nChainWork = GetBlockProof(*indices[i]);
+        }
+    });
+}
+
 bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
 {
     if (!m_block_tree_db->LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); })) {
@@ -266,10 +384,15 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
     std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
               CBlockIndexHeightOnlyComparator());
 
+    // The proof of each block is independent of the others, so compute them up
+    // front in parallel. nChainWork holds the proof until it is accumulated below.
+    ComputeBlockProofs(vSortedByHeight);
+
     for (CBlockIndex* pindex : vSortedByHeight) {
         if (ShutdownRequested()) return false;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + pindex->nChainWork;
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
+        pindex->BuildMedianTimePast();
 
         // We can link the chain of blocks for which we've received transactions at some point, or
         // blocks that are assumed-valid on the basis of snapshot load (see
@@ -291,10 +414,20 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
             pindex->nStatus |= BLOCK_FAILED_CHILD;
             m_dirty_blockindex.insert(pindex);
         }
+        // Parents come before their children, so the children of an entry are
+        // linked again after it is reset, also when the block index is reloaded.
+        pindex->pfirstChild = nullptr;
         if (pindex->pprev) {
             pindex->BuildSkip();
+            pindex->LinkToParent();
+        }
+        if (pindex->scaleFactor == 0) {
+            // Entry was written without its scale factor: compound it once and
+            // rewrite the entry so later startups can load it directly.
             pindex->BuildScaleFactor(consensus_params);
+            m_dirty_blockindex.insert(pindex);
         }
+        pindex->BuildSupplyViews();
     }
 
     return true;
@@ -343,6 +476,15 @@ bool BlockManager::LoadBlockIndexDB(const Consensus::Params& consensus_params)
             break;
         }
     }
+    {
+        LOCK(cs_LastBlockFile);
+        m_blockfile_usage = 0;
+        for (const CBlockFileInfo& file : m_blockfile_info) {
+            m_blockfile_usage += file.nSize + file.nUndoSize;
+        }
+        m_first_unpruned_blockfile = 0;
+        UpdateFirstUnprunedBlockFile();
+    }
 
     // Check presence of blk files
     LogPrintf("Checking all blk files are present...\n");
@@ -413,16 +555,17 @@ void CleanupBlockRevFiles()
 {
     std::map<std::string, fs::path> mapBlockFiles;
 
-    // Glob all blk?????.dat and rev?????.dat files from the blocks directory.
-    // Remove the rev files immediately and insert the blk file paths into an
-    // ordered map keyed by block file index.
+    // Glob all blk?????.dat and rev?????.dat files, and their compressed
+    // .cdat versions, from the blocks directory. Remove the rev files
+    // immediately and insert the blk file paths into an ordered map keyed by
+    // block file index.
     LogPrintf("Removing unusable blk?????.dat and rev?????.dat files for -reindex with -prune\n");
     const fs::path& blocksdir = gArgs.GetBlocksDirPath();
     for (fs::directory_iterator it(blocksdir); it != fs::directory_iterator(); it++) {
         const std::string path = fs::PathToString(it->path().filename());
         if (fs::is_regular_file(*it) &&
-            path.length() == 12 &&
-            path.substr(8,4) == ".dat")
+            path.length() >= 12 &&
+            (path.substr(8) == ".dat" || path.substr(8) == ".cdat"))
         {
             if (path.substr(0, 3) == "blk") {
                 mapBlockFiles[path.substr(3, 5)] = it->path();
@@ -453,7 +596,9 @@ CBlockFileInfo* BlockManager::GetBlockFileInfo(size_t n)
     return &m_blockfile_info.at(n);
 }
 
-static bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
+/** Write undo data: a CBlockUndo, or the bare vector of CTxUndo that is its v1 encoding. */
+template <typename Undo>
+static bool UndoWriteToDisk(const Undo& blockundo, FlatFilePos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
 {
     // Open history file to append
     CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
@@ -485,11 +630,34 @@ static bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
 {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return pindex->GetUndoPos())};
+    return UndoReadFromDisk(blockundo, pos, pindex->pprev->GetBlockHash());
+}
 
+bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_block_hash)
+{
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
 
+    // Deserialize from the mapped file, which is followed by its checksum
+    Span<const unsigned char> header, record;
+    if (const auto mapping{g_mmap_block_files ? MapRecord(UndoFileSeq(), pos, sizeof(uint256), header, record) : nullptr}) {
+        SpanReader reader{SER_DISK, CLIENT_VERSION, record};
+        uint256 hashChecksum;
+        CHashVerifier<SpanReader> verifier(&reader);
+        try {
+            verifier << prev_block_hash;
+            verifier >> blockundo;
+            reader >> hashChecksum;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        }
+        if (hashChecksum != verifier.GetHash()) {
+            return error("%s: Checksum mismatch", __func__);
+        }
+        return true;
+    }
+
     // Open history file to read
     CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull()) {
@@ -500,7 +668,7 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
     uint256 hashChecksum;
     CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try {
-        verifier << pindex->pprev->GetBlockHash();
+        verifier << prev_block_hash;
         verifier >> blockundo;
         filein >> hashChecksum;
     } catch (const std::exception& e) {
@@ -518,6 +686,7 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
 void BlockManager::FlushUndoFile(int block_file, bool finalize)
 {
     FlatFilePos undo_pos_old(block_file, m_blockfile_info[block_file].nUndoSize);
+    if (finalize) g_block_file_mappings.Invalidate(UndoFileSeq().FileName(undo_pos_old));
     if (!UndoFileSeq().Flush(undo_pos_old, finalize)) {
         AbortNode("Flushing undo file to disk failed. This is likely the result of an I/O error.");
     }
@@ -527,6 +696,7 @@ void BlockManager::FlushBlockFile(bool fFinalize, bool finalize_undo)
 {
     LOCK(cs_LastBlockFile);
     FlatFilePos block_pos_old(m_last_blockfile, m_blockfile_info[m_last_blockfile].nSize);
+    if (fFinalize) g_block_file_mappings.Invalidate(BlockFileSeq().FileName(block_pos_old));
     if (!BlockFileSeq().Flush(block_pos_old, fFinalize)) {
         AbortNode("Flushing block file to disk failed. This is likely the result of an I/O error.");
     }
@@ -538,20 +708,65 @@ void BlockManager::FlushBlockFile(bool fFinalize, bool finalize_undo)
 uint64_t BlockManager::CalculateCurrentUsage()
 {
     LOCK(cs_LastBlockFile);
+    return m_blockfile_usage;
+}
 
-    uint64_t retval = 0;
-    for (const CBlockFileInfo& file : m_blockfile_info) {
-        retval += file.nSize + file.nUndoSize;
+void BlockManager::UpdateFirstUnprunedBlockFile()
+{
+    AssertLockHeld(cs_LastBlockFile);
+    while (m_first_unpruned_blockfile < m_last_blockfile && m_blockfile_info[m_first_unpruned_blockfile].nSize == 0) {
+        ++m_first_unpruned_blockfile;
+    }
+}
+
+void BlockManager::CompressBlockFiles(int max_height, size_t max_files)
+{
+    if (fImporting || fReindex || max_height < 0) return;
+
+    size_t compressed_files{0};
+    for (int file = 0; compressed_files < max_files; ++file) {
+        const FlatFilePos pos(file, 0);
+        unsigned int block_size, undo_size;
+        {
+            LOCK(cs_LastBlockFile);
+            if (file >= m_last_blockfile) break;
+            const CBlockFileInfo& info{m_blockfile_info[file]};
+            // Leave files of pruned blocks, and of blocks that may still be connected or disconnected
+            if (info.nSize == 0 || info.nHeightLast > static_cast<unsigned int>(max_height)) continue;
+            block_size = info.nSize;
+            undo_size = info.nUndoSize;
+        }
+
+        bool compressed{false};
+        for (const bool undo : {false, true}) {
+            FlatFileSeq seq{undo ? UndoFileSeq() : BlockFileSeq()};
+            const unsigned int size{undo ? undo_size : block_size};
+            uint64_t compressed_size;
+            if (size == 0 || seq.IsCompressed(pos) || !seq.WriteCompressed(pos, size, compressed_size)) continue;
+
+            // The files are only written to while holding cs_main, so the copy is
+            // complete unless the file grew while it was being compressed.
+            LOCK2(::cs_main, cs_LastBlockFile);
+            const CBlockFileInfo& info{m_blockfile_info[file]};
+            const bool unchanged{(undo ? info.nUndoSize : info.nSize) == size};
+            g_block_file_mappings.Invalidate(seq.FileName(pos));
+            if (seq.CommitCompressed(pos, unchanged) && unchanged) {
+                LogPrint(BCLog::BLOCKSTORE, "Compressed %s from %u to %u bytes\n", fs::PathToString(seq.FileName(pos).filename()), size, compressed_size);
+                compressed = true;
+            }
+        }
+        if (compressed) ++compressed_files;
     }
-    return retval;
 }
 
 void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
-        fs::remove(BlockFileSeq().FileName(pos));
-        fs::remove(UndoFileSeq().FileName(pos));
+        g_block_file_mappings.Invalidate(BlockFileSeq().FileName(pos));
+        g_block_file_mappings.Invalidate(UndoFileSeq().FileName(pos));
+        BlockFileSeq().Remove(pos);
+        UndoFileSeq().Remove(pos);
         LogPrint(BCLog::BLOCKSTORE, "Prune: %s deleted blk/rev (%05u)\n", __func__, *it);
     }
 }
@@ -577,6 +792,37 @@ static FILE* OpenUndoFile(const FlatFilePos& pos, bool fReadOnly)
     return UndoFileSeq().Open(pos, fReadOnly);
 }
 
+/**
+ * Map the record at a position of a block or undo file, which is preceded by
+ * the network magic and its size. The record also covers the trailer_size
+ * bytes following it, so it is never read past the data written to the file.
+ *
+ * @return the mapping, which must be held while the record is read, or
+ *         nullptr if the record could not be mapped and should be read
+ *         from the file instead.
+ */
+static std::shared_ptr<const FlatFileMapping> MapRecord(const FlatFileSeq& seq, const FlatFilePos& pos, size_t trailer_size, Span<const unsigned char>& header, Span<const unsigned char>& record)
+{
+    constexpr size_t HEADER_SIZE{CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t)};
+    if (pos.IsNull() || pos.nPos < HEADER_SIZE) return nullptr;
+
+    const fs::path path{seq.FileName(pos)};
+    auto mapping{g_block_file_mappings.Get(path, pos.nPos)};
+    if (!mapping) return nullptr;
+    header = mapping->Data().subspan(pos.nPos - HEADER_SIZE, HEADER_SIZE);
+    const uint64_t record_size{ReadLE32(header.data() + CMessageHeader::MESSAGE_START_SIZE) + uint64_t{trailer_size}};
+    if (record_size > MAX_SIZE) return nullptr;
+
+    // The record may have been written after the file was mapped
+    if (pos.nPos + record_size > mapping->Data().size()) {
+        mapping = g_block_file_mappings.Get(path, pos.nPos + record_size);
+        if (!mapping) return nullptr;
+        header = mapping->Data().subspan(pos.nPos - HEADER_SIZE, HEADER_SIZE);
+    }
+    record = mapping->Data().subspan(pos.nPos, record_size);
+    return mapping;
+}
+
 fs::path GetBlockPosFilename(const FlatFilePos& pos)
 {
     return BlockFileSeq().FileName(pos);
@@ -613,14 +859,20 @@ bool BlockManager::FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigne
         }
         FlushBlockFile(!fKnown, finalize_undo);
         m_last_blockfile = nFile;
+        // Known positions may be in a file number that was pruned before, which
+        // must not be unlinked after it has been written again.
+        if (fKnown) WaitForPrunedFilesUnlinked();
     }
 
+    const unsigned int old_size{m_blockfile_info[nFile].nSize};
     m_blockfile_info[nFile].AddBlock(nHeight, nTime);
     if (fKnown) {
         m_blockfile_info[nFile].nSize = std::max(pos.nPos + nAddSize, m_blockfile_info[nFile].nSize);
     } else {
         m_blockfile_info[nFile].nSize += nAddSize;
     }
+    m_blockfile_usage += m_blockfile_info[nFile].nSize - old_size;
+    m_first_unpruned_blockfile = std::min<int>(m_first_unpruned_blockfile, nFile);
 
     if (!fKnown) {
         bool out_of_space;
@@ -645,6 +897,7 @@ bool BlockManager::FindUndoPos(BlockValidationState& state, int nFile, FlatFileP
 
     pos.nPos = m_blockfile_info[nFile].nUndoSize;
     m_blockfile_info[nFile].nUndoSize += nAddSize;
+    m_blockfile_usage += nAddSize;
     m_dirty_fileinfo.insert(nFile);
 
     bool out_of_space;
@@ -687,11 +940,16 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
     AssertLockHeld(::cs_main);
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull()) {
+        // Without -blockundov2, write the bare vector that is the v1 encoding
+        const bool v2{g_block_undo_v2};
+        const unsigned int undo_size = v2 ? ::GetSerializeSize(blockundo, CLIENT_VERSION) : ::GetSerializeSize(blockundo.vtxundo, CLIENT_VERSION);
         FlatFilePos _pos;
-        if (!FindUndoPos(state, pindex->nFile, _pos, ::GetSerializeSize(blockundo, CLIENT_VERSION) + 40)) {
+        if (!FindUndoPos(state, pindex->nFile, _pos, undo_size + 40)) {
             return error("ConnectBlock(): FindUndoPos failed");
         }
-        if (!UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart())) {
+        const bool written{v2 ? UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart()) :
+                                UndoWriteToDisk(blockundo.vtxundo, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart())};
+        if (!written) {
             return AbortNode(state, "Failed to write undo data");
         }
         // rev files are written in block height order, whereas blk files are written as blocks come in (often out of order)
@@ -712,10 +970,37 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
     return true;
 }
 
+/** Check the proof of work, and signet solution, of a block read from disk */
+static bool CheckBlockFromDisk(const CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+{
+    // Check the header
+    if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams)) {
+        return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
+    }
+
+    // Signet only: check block solution
+    if (consensusParams.signet_blocks && !CheckSignetBlockSolution(block, consensusParams)) {
+        return error("ReadBlockFromDisk: Errors in block solution at %s", pos.ToString());
+    }
+
+    return true;
+}
+
 bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
 {
     block.SetNull();
 
+    Span<const unsigned char> header, record;
+    if (const auto mapping{g_mmap_block_files ? MapRecord(BlockFileSeq(), pos, 0, header, record) : nullptr}) {
+        // Deserialize from the mapped file
+        try {
+            SpanReader{SER_DISK, CLIENT_VERSION, record} >> block;
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+        return CheckBlockFromDisk(block, pos, consensusParams);
+    }
+
     // Open history file to read
     CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull()) {
@@ -729,17 +1014,7 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
-    // Check the header
-    if (!CheckProofOfWork(block.GetHash(), block.nBits, consensusParams)) {
-        return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
-    }
-
-    // Signet only: check block solution
-    if (consensusParams.signet_blocks && !CheckSignetBlockSolution(block, consensusParams)) {
-        return error("ReadBlockFromDisk: Errors in block solution at %s", pos.ToString());
-    }
-
-    return true;
+    return CheckBlockFromDisk(block, pos, consensusParams);
 }
 
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
@@ -758,6 +1033,18 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
 
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
 {
+    Span<const unsigned char> header, record;
+    if (const auto mapping{g_mmap_block_files ? MapRecord(BlockFileSeq(), pos, 0, header, record) : nullptr}) {
+        // Copy the block straight out of the mapped file
+        if (memcmp(header.data(), message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+            return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                         HexStr(header.first(CMessageHeader::MESSAGE_START_SIZE)),
+                         HexStr(message_start));
+        }
+        block.assign(record.begin(), record.end());
+        return true;
+    }
+
     FlatFilePos hpos = pos;
     hpos.nPos -= 8; // Seek back 8 bytes for meta header
     CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
@@ -826,11 +1113,17 @@ struct CImportingNow {
     }
 };
 
-void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFiles, const ArgsManager& args, const fs::path& mempool_path)
+/** Have the OS start reading the file at path in the background, so it is cached once it is loaded. */
+static void PrefetchBlockFile(const fs::path& path)
 {
-    SetSyscallSandboxPolicy(SyscallSandboxPolicy::INITIALIZATION_LOAD_BLOCKS);
-    ScheduleBatchPriority();
+    if (FILE* file{fsbridge::fopen(path, "rb")}) {
+        PrefetchFile(file);
+        fclose(file);
+    }
+}
 
+void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFiles, const ArgsManager& args, const fs::path& mempool_path)
+{
     {
         CImportingNow imp;
 
@@ -842,13 +1135,16 @@ void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFile
             std::multimap<uint256, FlatFilePos> blocks_with_unknown_parent;
             while (true) {
                 FlatFilePos pos(nFile, 0);
-                if (!fs::exists(GetBlockPosFilename(pos))) {
+                if (!fs::exists(GetBlockPosFilename(pos)) && !BlockFileSeq().IsCompressed(pos)) {
                     break; // No block files left to reindex
                 }
                 FILE* file = OpenBlockFile(pos, true);
                 if (!file) {
                     break; // This error is logged in OpenBlockFile
                 }
+                // Read ahead into this and the next block file while this one is processed
+                PrefetchFile(file);
+                PrefetchBlockFile(GetBlockPosFilename(FlatFilePos(nFile + 1, 0)));
                 LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
                 chainman.ActiveChainstate().LoadExternalBlockFile(file, &pos, &blocks_with_unknown_parent);
                 if (ShutdownRequested()) {
@@ -865,9 +1161,12 @@ void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFile
         }
 
         // -loadblock=
-        for (const fs::path& path : vImportFiles) {
+        for (auto it = vImportFiles.begin(); it != vImportFiles.end(); ++it) {
+            const fs::path& path{*it};
             FILE* file = fsbridge::fopen(path, "rb");
             if (file) {
+                PrefetchFile(file);
+                if (std::next(it) != vImportFiles.end()) PrefetchBlockFile(*std::next(it));
                 LogPrintf("Importing blocks file %s...\n", fs::PathToString(path));
                 chainman.ActiveChainstate().LoadExternalBlockFile(file);
                 if (ShutdownRequested()) {
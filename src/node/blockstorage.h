@@ -9,11 +9,15 @@
 #include <chain.h>
 #include <fs.h>
 #include <protocol.h>
+#include <support/allocators/pool.h>
 #include <sync.h>
 #include <txdb.h>
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <set>
 #include <unordered_map>
 #include <vector>
 
@@ -36,6 +40,13 @@ struct Params;
 
 namespace node {
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+static constexpr bool DEFAULT_MMAP_BLOCKFILES{false};
+/** The maximum number of blk?????.dat and rev?????.dat files kept mapped with -mmapblockfiles */
+static constexpr size_t MAX_MAPPED_BLOCKFILES{8};
+static constexpr bool DEFAULT_BLOCK_COMPRESSION{false};
+static constexpr bool DEFAULT_BLOCK_UNDO_V2{true};
+/** How often one more block file is compressed with -blockcompression */
+static constexpr std::chrono::seconds BLOCK_COMPRESSION_INTERVAL{10};
 
 /** The pre-allocation chunk size for blk?????.dat files (since 0.8) */
 static const unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
@@ -51,12 +62,25 @@ extern std::atomic_bool fReindex;
 extern bool fPruneMode;
 /** Number of bytes of block files that we're trying to stay below. */
 extern uint64_t nPruneTarget;
+/** True if blocks and undo data are read from memory mapped block files. */
+extern std::atomic_bool g_mmap_block_files;
+/** True if new undo data is written in the v2 encoding where possible, false to keep writing v1. */
+extern std::atomic_bool g_block_undo_v2;
 
 // Because validation code takes pointers to the map's CBlockIndex objects, if
 // we ever switch to another associative container, we need to either use a
 // container that has stable addressing (true of all std associative
 // containers), or make the key a `std::unique_ptr<CBlockIndex>`
-using BlockMap = std::unordered_map<uint256, CBlockIndex, BlockHasher>;
+//
+// Entries are allocated from a pool rather than one by one, so that entries
+// added one after another, which are mostly the headers of consecutive blocks,
+// are stored next to each other without per-entry allocation overhead.
+using BlockMap = std::unordered_map<uint256,
+                                    CBlockIndex,
+                                    BlockHasher,
+                                    std::equal_to<uint256>,
+                                    PoolAllocator<std::pair<const uint256, CBlockIndex>,
+                                                  sizeof(std::pair<const uint256, CBlockIndex>) + sizeof(void*) * 4>>;
 
 struct CBlockIndexWorkComparator {
     bool operator()(const CBlockIndex* pa, const CBlockIndex* pb) const;
@@ -67,6 +91,8 @@ struct CBlockIndexHeightOnlyComparator {
     bool operator()(const CBlockIndex* pa, const CBlockIndex* pb) const;
 };
 
+class PrunedFileRemover;
+
 struct PruneLockInfo {
     int height_first{std::numeric_limits<int>::max()}; //! Height of earliest block that should be kept and not pruned
 };
@@ -116,9 +142,16 @@ private:
      */
     void FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPruneAfterHeight, int chain_tip_height, int prune_height, bool is_ibd);
 
+    /** Advance m_first_unpruned_blockfile past the block files that have been pruned */
+    void UpdateFirstUnprunedBlockFile() EXCLUSIVE_LOCKS_REQUIRED(cs_LastBlockFile);
+
     RecursiveMutex cs_LastBlockFile;
     std::vector<CBlockFileInfo> m_blockfile_info;
     int m_last_blockfile = 0;
+    /** Combined size of all block and undo files, updated as files grow and are pruned. */
+    uint64_t m_blockfile_usage GUARDED_BY(cs_LastBlockFile){0};
+    /** All block files below this one are pruned, so searching for files to prune starts here. */
+    int m_first_unpruned_blockfile GUARDED_BY(cs_LastBlockFile){0};
     /** Global flag to indicate we should check to see if there are
      *  block/undo files that should be deleted.  Set on startup
      *  or if we allocate more file space when we're in prune mode
@@ -139,11 +172,23 @@ private:
      */
     std::unordered_map<std::string, PruneLockInfo> m_prune_locks GUARDED_BY(::cs_main);
 
+    //! Pool the entries of m_block_index are allocated from
+    BlockMap::allocator_type::ResourceType m_block_index_resource;
+
+    //! Unlinks the files of pruned blocks off the validation thread
+    const std::unique_ptr<PrunedFileRemover> m_pruned_file_remover;
+
 public:
-    BlockMap m_block_index GUARDED_BY(cs_main);
+    BlockManager();
+    ~BlockManager();
+
+    BlockMap m_block_index GUARDED_BY(cs_main){0, BlockHasher{}, BlockMap::key_equal{}, &m_block_index_resource};
 
     std::vector<CBlockIndex*> GetAllBlockIndices() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    /** Memory used by the block index and the block file info */
+    size_t DynamicMemoryUsage() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     /**
      * All pairs A->B, where A (or one of its ancestors) misses transactions, but B has transactions.
      * Pruned nodes may have entries where B is missing data.
@@ -162,6 +207,14 @@ public:
     //! Mark one block file as pruned (modify associated database entries)
     void PruneOneBlockFile(const int fileNumber) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Unlink the files of pruned block files on a background thread. Must only be
+     * called once the block index no longer referring to them has been written.
+     */
+    void UnlinkPrunedFilesInBackground(const std::set<int>& setFilesToPrune);
+    //! Wait until the files passed to UnlinkPrunedFilesInBackground() are unlinked
+    void WaitForPrunedFilesUnlinked();
+
     CBlockIndex* LookupBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     const CBlockIndex* LookupBlockIndex(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -176,6 +229,13 @@ public:
     /** Calculate the amount of disk space the block & undo files currently use */
     uint64_t CalculateCurrentUsage();
 
+    /**
+     * Compress the block and undo files of up to max_files complete block files whose blocks
+     * are all at or below max_height. Blocks and undo data are read from the compressed files
+     * at the same positions, so the block index is left as is.
+     */
+    void CompressBlockFiles(int max_height, size_t max_files) LOCKS_EXCLUDED(::cs_main);
+
     //! Returns last CBlockIndex* that is a checkpoint
     const CBlockIndex* GetLastCheckpoint(const CCheckpointData& data) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
@@ -210,6 +270,8 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
 
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
+/** Read the undo data at pos of the block whose parent is prev_block_hash, without locking cs_main */
+bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& prev_block_hash);
 
 void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFiles, const ArgsManager& args, const fs::path& mempool_path);
 } // namespace node
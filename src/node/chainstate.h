@@ -13,6 +13,9 @@
 #include <tuple>
 
 class CTxMemPool;
+namespace util {
+class ThreadPool;
+} // namespace util
 
 namespace node {
 
@@ -27,6 +30,8 @@ struct ChainstateLoadOptions {
     bool prune{false};
     int64_t check_blocks{DEFAULT_CHECKBLOCKS};
     int64_t check_level{DEFAULT_CHECKLEVEL};
+    //! Workers that read and check blocks for the verification of the loaded chainstate
+    util::ThreadPool* thread_pool{nullptr};
     std::function<bool()> check_interrupt;
     std::function<void()> coins_error_cb;
 };
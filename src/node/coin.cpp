@@ -8,13 +8,22 @@
 #include <txmempool.h>
 #include <validation.h>
 
+#include <vector>
+
 namespace node {
 void FindCoins(const NodeContext& node, std::map<COutPoint, Coin>& coins)
 {
     assert(node.mempool);
     assert(node.chainman);
     LOCK2(cs_main, node.mempool->cs);
-    CCoinsViewCache& chain_view = node.chainman->ActiveChainstate().CoinsTip();
+    Chainstate& active_chainstate = node.chainman->ActiveChainstate();
+    CCoinsViewCache& chain_view = active_chainstate.CoinsTip();
+    // Wallets look up all inputs of a transaction at once, so read the ones
+    // not cached yet together rather than one database lookup at a time.
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(coins.size());
+    for (const auto& coin : coins) outpoints.push_back(coin.first);
+    active_chainstate.PrefetchCoins(outpoints);
     CCoinsViewMemPool mempool_view(&chain_view, *node.mempool);
     for (auto& coin : coins) {
         if (!mempool_view.GetCoin(coin.first, coin.second)) {
@@ -14,6 +14,7 @@
 #include <policy/fees.h>
 #include <scheduler.h>
 #include <txmempool.h>
+#include <util/threadpool.h>
 #include <validation.h>
 
 namespace node {
@@ -28,6 +28,9 @@ class ChainClient;
 class Init;
 class WalletLoader;
 } // namespace interfaces
+namespace util {
+class ThreadPool;
+} // namespace util
 
 namespace node {
 //! NodeContext struct containing references to chain state and connection
@@ -61,6 +64,8 @@ struct NodeContext {
     //! opened by the gui.
     interfaces::WalletLoader* wallet_loader{nullptr};
     std::unique_ptr<CScheduler> scheduler;
+    //! Workers shared by script checks, RPC requests, index syncs and block loading
+    std::unique_ptr<util::ThreadPool> thread_pool;
     std::function<void()> rpc_interruption_point = [] {};
 
     //! Declare default constructor and destructor that are not inline, so code
@@ -9,6 +9,7 @@
 #include <consensus/conversion.h>
 #include <deploymentstatus.h>
 #include <external_signer.h>
+#include <index/blockfilterindex.h>
 #include <init.h>
 #include <interfaces/chain.h>
 #include <interfaces/handler.h>
@@ -52,15 +53,18 @@
 #include <config/bitcoin-config.h>
 #endif
 
+#include <algorithm>
 #include <any>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <variant>
 
 #include <boost/signals2/signal.hpp>
 
 using interfaces::BlockTip;
 using interfaces::Chain;
+using interfaces::ConversionBookEntry;
 using interfaces::FoundBlock;
 using interfaces::Handler;
 using interfaces::MakeHandler;
@@ -562,6 +566,20 @@ public:
         WAIT_LOCK(cs_main, lock);
         return FillBlock(chainman().m_blockman.LookupBlockIndex(hash), block, lock, chainman().ActiveChain());
     }
+    bool hasBlockFilterIndex(BlockFilterType filter_type) override
+    {
+        return GetBlockFilterIndex(filter_type) != nullptr;
+    }
+    std::optional<bool> blockFilterMatchesAny(BlockFilterType filter_type, const uint256& block_hash, const GCSFilter::ElementSet& filter_set) override
+    {
+        const BlockFilterIndex* block_filter_index{GetBlockFilterIndex(filter_type)};
+        if (!block_filter_index) return std::nullopt;
+
+        BlockFilter filter;
+        const CBlockIndex* index{WITH_LOCK(::cs_main, return chainman().m_blockman.LookupBlockIndex(block_hash))};
+        if (index == nullptr || !block_filter_index->LookupFilter(index, filter)) return std::nullopt;
+        return filter.GetFilter().MatchAny(filter_set);
+    }
     bool findFirstBlockWithTimeAndHeight(int64_t min_time, int min_height, const FoundBlock& block) override
     {
         WAIT_LOCK(cs_main, lock);
@@ -659,6 +677,23 @@ public:
     CAmount estimateConvertedAmount(const CAmount& amount, const CAmountType& amountType, const bool& roundedUp) override {
         return GetConvertedAmount(getLastTotalSupply(), amount, amountType, roundedUp);
     }
+    std::vector<ConversionBookEntry> getConversionBook(const CAmountType& inputType, size_t max_entries) override
+    {
+        std::vector<ConversionBookEntry> book;
+        if (!m_node.mempool) return book;
+        LOCK(m_node.mempool->cs);
+        for (const CTxMemPool::txiter& it : m_node.mempool->GetConversionBook(inputType, max_entries)) {
+            book.push_back({it->GetTx().GetHash(), it->GetConversionInput(), it->GetConversionOutput()});
+        }
+        return book;
+    }
+    CAmounts getProjectedSupply() override
+    {
+        const CAmounts tip_supply = WITH_LOCK(::cs_main, return chainman().ActiveChain().Tip()->GetTotalSupply());
+        if (!m_node.mempool) return tip_supply;
+        LOCK(m_node.mempool->cs);
+        return m_node.mempool->GetProjectedSupply(tip_supply);
+    }
     CAmountScaleFactor getLastScaleFactor() override
     {
         const CBlockIndex* tip = WITH_LOCK(::cs_main, return chainman().ActiveChain().Tip());
@@ -672,8 +707,26 @@ public:
     }
     std::optional<CAmountScaleFactor> findScaleFactorAtHeight(const int& height) override
     {
-        std::optional<int> current_height = getHeight();
-        return (current_height && current_height >= height) ? findScaleFactorForHash(getBlockHash(height)) : std::nullopt;
+        LOCK(::cs_main);
+        const CChain& active = chainman().ActiveChain();
+        return (height >= 0 && height <= active.Height()) ? std::optional{active.GetScaleFactor(height)} : std::nullopt;
+    }
+    std::vector<std::optional<CAmountScaleFactor>> findScaleFactors(const std::vector<ScaleFactorQuery>& blocks) override
+    {
+        std::vector<std::optional<CAmountScaleFactor>> result;
+        result.reserve(blocks.size());
+        LOCK(::cs_main);
+        const CChain& active = chainman().ActiveChain();
+        for (const ScaleFactorQuery& block : blocks) {
+            if (const uint256* block_hash = std::get_if<uint256>(&block)) {
+                const CBlockIndex* index = chainman().m_blockman.LookupBlockIndex(*block_hash);
+                result.push_back(index ? std::optional{index->scaleFactor} : std::nullopt);
+            } else {
+                const int height = std::get<int>(block);
+                result.push_back(height >= 0 ? std::optional{active.GetScaleFactor(std::min(height, active.Height()))} : std::nullopt);
+            }
+        }
+        return result;
     }
     bool broadcastTransaction(const CTransactionRef& tx,
         const CAmount& max_tx_fee,
@@ -14,7 +14,7 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
-#include <crypto/blake3.h>
+#include <crypto/blake3_header.h>
 #include <deploymentstatus.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
@@ -26,6 +26,9 @@
 #include <util/moneystr.h>
 #include <util/system.h>
 #include <util/threadnames.h>
+#include <util/threadpool.h>
+#include <util/time.h>
+#include <util/trace.h>
 #include <validation.h>
 #include <validationinterface.h>
 
@@ -37,8 +40,8 @@
 namespace node {
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
-    // Update nExtraNonce
-    static uint256 hashPrevBlock;
+    // Update nExtraNonce, separately for each miner thread
+    static thread_local uint256 hashPrevBlock;
     if (hashPrevBlock != pblock->hashPrevBlock)
     {
         nExtraNonce = 0;
@@ -83,10 +86,43 @@ void RegenerateCommitments(CBlock& block, ChainstateManager& chainman)
     block.hashMerkleRoot = BlockMerkleRoot(block);
 }
 
+CBlock CreateEmptyBlock(ChainstateManager& chainman, const CBlockIndex* pindexPrev, const CScript& scriptPubKeyIn)
+{
+    AssertLockHeld(::cs_main);
+    assert(pindexPrev != nullptr);
+    const Consensus::Params& consensusParams = chainman.GetConsensus();
+    const int nHeight = pindexPrev->nHeight + 1;
+
+    CBlock block;
+    block.nVersion = chainman.m_versionbitscache.ComputeBlockVersion(pindexPrev, consensusParams);
+    block.hashPrevBlock = pindexPrev->GetBlockHash();
+    block.nTime = std::max<int64_t>(pindexPrev->GetMedianTimePast() + 1, TicksSinceEpoch<std::chrono::seconds>(GetAdjustedTime()));
+    block.nBits = GetNextWorkRequired(pindexPrev, &block, consensusParams);
+    block.nNonce = 0;
+
+    // The supply only changes by the block reward
+    const CAmounts reward = GetBlockSubsidy(nHeight, pindexPrev->GetTotalSupply(), consensusParams);
+    block.cashSupply = pindexPrev->cashSupply + reward[CASH];
+    block.bondSupply = pindexPrev->bondSupply + reward[BOND];
+
+    CMutableTransaction coinbaseTx;
+    coinbaseTx.vout.resize(2); // 2 outputs to miner (1 for cash, 1 for bond)
+    coinbaseTx.vout[CASH] = CTxOut(CASH, reward[CASH], scriptPubKeyIn);
+    coinbaseTx.vout[BOND] = CTxOut(BOND, reward[BOND], scriptPubKeyIn);
+    coinbaseTx.vin.resize(1);
+    coinbaseTx.vin[0].prevout.SetNull();
+    coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
+    block.vtx.push_back(MakeTransactionRef(std::move(coinbaseTx)));
+    chainman.GenerateCoinbaseCommitment(block, pindexPrev);
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    return block;
+}
+
 BlockAssembler::Options::Options()
 {
     blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
     nBlockMaxWeight = DEFAULT_BLOCK_MAX_WEIGHT;
+    conversion_time = DEFAULT_BLOCK_CONVERSION_TIME;
 }
 
 BlockAssembler::BlockAssembler(Chainstate& chainstate, const CTxMemPool* mempool, const Options& options)
@@ -95,6 +131,7 @@ BlockAssembler::BlockAssembler(Chainstate& chainstate, const CTxMemPool* mempool
       m_chainstate(chainstate)
 {
     blockMinFeeRate = options.blockMinFeeRate;
+    m_conversion_time = std::max(options.conversion_time, std::chrono::milliseconds{0});
     // Limit weight to between 4K and MAX_BLOCK_WEIGHT-4K for sanity:
     nBlockMaxWeight = std::max<size_t>(4000, std::min<size_t>(MAX_BLOCK_WEIGHT - 4000, options.nBlockMaxWeight));
 }
@@ -111,6 +148,7 @@ static BlockAssembler::Options DefaultOptions()
     } else {
         options.blockMinFeeRate = CFeeRate{DEFAULT_BLOCK_MIN_TX_FEE};
     }
+    options.conversion_time = std::chrono::milliseconds{gArgs.GetIntArg("-blockconversiontime", DEFAULT_BLOCK_CONVERSION_TIME.count())};
     return options;
 }
 
@@ -121,6 +159,7 @@ void BlockAssembler::resetBlock()
 {
     inBlock.clear();
     conversionOutputs.clear();
+    conversionOutputPositions.clear();
 
     // Reserve space for coinbase tx
     nBlockWeight = 4000;
@@ -254,33 +293,45 @@ bool BlockAssembler::TestPackage(uint64_t packageSize, int64_t packageSigOpsCost
 // Perform transaction-level checks before adding to block:
 // - transaction finality (locktime)
 // - conversion validity for current block supply
-bool BlockAssembler::TestPackageTransactions(const CTxMemPool::setEntries& package, std::optional<CTxConversionInfo>& conversionInfo) const
+bool BlockAssembler::TestPackageTransactions(const std::vector<CTxMemPool::txiter>& sortedEntries, std::optional<CTxConversionInfo>& conversionInfo, PackageConversions& packageConversions) const
 {
     // First check that every tx is final
-    for (CTxMemPool::txiter it : package) {
+    for (CTxMemPool::txiter it : sortedEntries) {
         if (!IsFinalTx(it->GetTx(), nHeight, m_lock_time_cutoff)) {
             return false;
         }
     }
 
-    // Next check the validity of each conversion tx in the package.
-    // We track changes to the total supply after each conversion.
-    CBlock* const pblock = &pblocktemplate->block; // pointer for convenience
-    CAmounts totalSupply = {0};
-    totalSupply[CASH] = pblock->cashSupply;
-    totalSupply[BOND] = pblock->bondSupply;
-
-    for (CTxMemPool::txiter it : package) {
-        conversionInfo = it->GetConversionInfo();
-        if (conversionInfo) {
-            if (conversionInfo.value().nDeadline && conversionInfo.value().nDeadline < (uint32_t)nHeight) {
-                return false;
-            }
-            CAmount remainder = 0;
-            if (!Consensus::IsValidConversion(totalSupply, conversionInfo.value().inputs, conversionInfo.value().minOutputs, conversionInfo.value().remainderType, remainder)) {
-                return false;
-            }
+    // Next check the validity of each conversion tx in the package, in the
+    // order they will appear in the block. We track changes to the total
+    // supply after each conversion and keep each remainder, so that the
+    // conversions do not need to be executed again when added to the block.
+    packageConversions.totalSupply = pblocktemplate->block.GetTotalSupply();
+    packageConversions.remainders.assign(sortedEntries.size(), std::nullopt);
+
+    for (size_t i = 0; i < sortedEntries.size(); ++i) {
+        const CTxConversionInfo* info = sortedEntries[i]->GetConversionInfo();
+        if (!info) continue;
+        if (IsExpiredConversionInfo(*info, nHeight)) {
+            // An expired conversion can never become valid again
+            conversionInfo = std::nullopt;
+            return false;
+        }
+        conversionInfo = *info;
+        CAmount remainder = 0;
+        const auto conversion_start{SteadyClock::now()};
+        const bool valid_conversion{Consensus::IsValidConversion(packageConversions.totalSupply, info->inputs, info->minOutputs, info->remainderType, remainder)};
+        TRACE5(conversion, miner_check,
+            sortedEntries[i]->GetTx().GetHash().data(),
+            nHeight,
+            valid_conversion,
+            remainder,
+            Ticks<std::chrono::nanoseconds>(SteadyClock::now() - conversion_start)
+        );
+        if (!valid_conversion) {
+            return false;
         }
+        packageConversions.remainders[i] = remainder;
     }
     return true;
 }
@@ -325,7 +376,7 @@ CTxMemPoolConversionEntry BlockAssembler::GetConversionEntry(const CTxMemPool::t
     return CTxMemPoolConversionEntry(iter, conversionRate, inputType);
 }
 
-void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
+void BlockAssembler::AddToBlock(CTxMemPool::txiter iter, const std::optional<CAmount>& remainder)
 {
     pblocktemplate->block.vtx.emplace_back(iter->GetSharedTx());
     pblocktemplate->vTxFeesCash.push_back(iter->GetFees()[CASH]);
@@ -338,29 +389,21 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     nFees[BOND] += iter->GetFees()[BOND];
     inBlock.insert(iter);
 
-    std::optional<CTxConversionInfo> conversionInfo = iter->GetConversionInfo();
-    if (conversionInfo) {
-        CBlock* const pblock = &pblocktemplate->block; // pointer for convenience
-        CAmounts totalSupply = {0};
-        totalSupply[CASH] = pblock->cashSupply;
-        totalSupply[BOND] = pblock->bondSupply;
-        CAmountType amountType = conversionInfo.value().remainderType;
-        CAmount nAmount;
-        if (Consensus::IsValidConversion(totalSupply, conversionInfo.value().inputs, conversionInfo.value().minOutputs, amountType, nAmount)) {
-            // Update cash and bond supply of block we are building
-            pblock->cashSupply = totalSupply[CASH];
-            pblock->bondSupply = totalSupply[BOND];
-            if (nAmount > 0) {
-                // Include remainder output amount if non-zero
-                if (IsValidDestination(conversionInfo.value().destination)) {
-                    // Send remainder to provided destination
-                    CScript scriptPubKey = GetScriptForDestination(conversionInfo.value().destination);
-                    conversionOutputs.push_back(CTxOut(amountType, nAmount, scriptPubKey));
-                } else {
-                    // No destination provided. Add remainder to miner fees.
-                    nFees[amountType] += nAmount;
-                }
+    if (remainder && remainder.value() > 0) {
+        // Include remainder output amount if non-zero
+        const CAmountType amountType = iter->GetConversionInfo()->remainderType;
+        if (const CScript* scriptPubKey = iter->GetConversionRemainderScript()) {
+            // Send remainder to provided destination, in one output per destination
+            // (consensus only checks the total paid to each)
+            const auto [it, inserted] = conversionOutputPositions.try_emplace({amountType, *scriptPubKey}, conversionOutputs.size());
+            if (inserted) {
+                conversionOutputs.emplace_back(amountType, remainder.value(), *scriptPubKey);
+            } else {
+                conversionOutputs[it->second].nValue += remainder.value();
             }
+        } else {
+            // No destination provided. Add remainder to miner fees.
+            nFees[amountType] += remainder.value();
         }
     }
 
@@ -372,6 +415,24 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     }
 }
 
+void BlockAssembler::AddPackageToBlock(const std::vector<CTxMemPool::txiter>& sortedEntries, const PackageConversions& packageConversions)
+{
+    for (size_t i = 0; i < sortedEntries.size(); ++i) {
+        AddToBlock(sortedEntries[i], packageConversions.remainders[i]);
+    }
+    // Update cash and bond supply of block we are building
+    CBlock* const pblock = &pblocktemplate->block; // pointer for convenience
+    pblock->cashSupply = packageConversions.totalSupply[CASH];
+    pblock->bondSupply = packageConversions.totalSupply[BOND];
+}
+
+/** Marginal amount of the other type received per unit of inputType converted at the given supply */
+static double GetMarginalConversionRate(const CAmounts& totalSupply, CAmountType inputType)
+{
+    if (totalSupply[!inputType] == 0) return std::numeric_limits<double>::infinity();
+    return (double)totalSupply[inputType] / (double)totalSupply[!inputType];
+}
+
 /** Add descendants of given transactions to mapModifiedTx with ancestor
  * state updated assuming given transactions are inBlock. Returns number
  * of updated descendants. */
@@ -439,6 +500,10 @@ void BlockAssembler::SortForBlock(const CTxMemPool::setEntries& package, std::ve
 // Each time through the loop, we compare the best transaction in
 // mapModifiedTxs with the next transaction in the mempool to decide what
 // transaction package to work on next.
+//
+// Packages are bounded by the mempool ancestor/descendant limits, so the
+// per-package work here, including the supply checks for conversions, stays
+// bounded without linearizing whole clusters.
 void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated)
 {
     AssertLockHeld(mempool.cs);
@@ -457,6 +522,10 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
     // NOTE: Entries with more than one conversion in ancestor list are NOT included
     indexed_conversion_transaction_set invalidConversionTxCash;
     indexed_conversion_transaction_set invalidConversionTxBond;
+    // Marginal conversion rate of each type at which the first entry in its
+    // set was last found to be invalid. A set is only retried once the rate
+    // has moved in its favor.
+    double failedConversionRate[2] = {-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
 
     CTxMemPool::indexed_transaction_set::index<ancestor_score>::type::iterator mi = mempool.mapTx.get<ancestor_score>().begin();
     CTxMemPool::txiter iter;
@@ -531,7 +600,7 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
 
         if (packageFees < blockMinFeeRate.GetFee(packageSize)) {
             // Everything else we might consider has a lower fee rate
-            return;
+            break;
         }
 
         if (!TestPackage(packageSize, packageSigOpsCost)) {
@@ -561,9 +630,15 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
         onlyUnconfirmed(ancestors);
         ancestors.insert(iter);
 
+        // Sort the entries in a valid order, which is also the order their
+        // conversions are executed in
+        std::vector<CTxMemPool::txiter> sortedEntries;
+        SortForBlock(ancestors, sortedEntries);
+
         // Test if all tx's are Final, conversions are valid, and conversion deadlines haven't expired
         std::optional<CTxConversionInfo> conversionInfo;
-        if (!TestPackageTransactions(ancestors, conversionInfo)) {
+        PackageConversions packageConversions;
+        if (!TestPackageTransactions(sortedEntries, conversionInfo, packageConversions)) {
             if (fUsingModified) {
                 mapModifiedTx.get<ancestor_score>().erase(modit);
                 failedTx.insert(iter);
@@ -589,10 +664,12 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
             // that failed due an invalid conversion
             if (conversionInfo) {
                 CTxMemPoolConversionEntry conversionEntry = GetConversionEntry(iter, conversionInfo.value());
-                if (conversionEntry.GetConversionType() == CASH) {
-                    invalidConversionTxCash.insert(conversionEntry);
-                } else if (conversionEntry.GetConversionType() == BOND) {
-                    invalidConversionTxBond.insert(conversionEntry);
+                const CAmountType conversionType = conversionEntry.GetConversionType();
+                indexed_conversion_transaction_set& invalidConversionTx = conversionType == CASH ? invalidConversionTxCash : invalidConversionTxBond;
+                invalidConversionTx.insert(conversionEntry);
+                if (invalidConversionTx.get<index_by_conversion_rate>().begin()->iter == iter) {
+                    // The entry is now the first to retry, and is invalid at the current rate
+                    failedConversionRate[conversionType] = GetMarginalConversionRate(pblocktemplate->block.GetTotalSupply(), conversionType);
                 }
             }
 
@@ -602,12 +679,9 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
         // This transaction will make it in; reset the failed counter.
         nConsecutiveFailed = 0;
 
-        // Package can be added. Sort the entries in a valid order.
-        std::vector<CTxMemPool::txiter> sortedEntries;
-        SortForBlock(ancestors, sortedEntries);
-
+        // Package can be added.
+        AddPackageToBlock(sortedEntries, packageConversions);
         for (size_t i = 0; i < sortedEntries.size(); ++i) {
-            AddToBlock(sortedEntries[i]);
             // Erase from the modified set, if present
             mapModifiedTx.erase(sortedEntries[i]);
         }
@@ -619,9 +693,13 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
 
         if (conversionInfo) {
             // Conversion rate changed. Check if any transactions dependent upon
-            // a previously invalid conversion can now be executed.
-            conversionrateiter cashit = invalidConversionTxCash.get<index_by_conversion_rate>().begin();
-            conversionrateiter bondit = invalidConversionTxBond.get<index_by_conversion_rate>().begin();
+            // a previously invalid conversion can now be executed, skipping
+            // conversion types whose rate has not improved since they failed.
+            const CAmounts totalSupply = pblocktemplate->block.GetTotalSupply();
+            conversionrateiter cashit = GetMarginalConversionRate(totalSupply, CASH) > failedConversionRate[CASH] ?
+                invalidConversionTxCash.get<index_by_conversion_rate>().begin() : invalidConversionTxCash.get<index_by_conversion_rate>().end();
+            conversionrateiter bondit = GetMarginalConversionRate(totalSupply, BOND) > failedConversionRate[BOND] ?
+                invalidConversionTxBond.get<index_by_conversion_rate>().begin() : invalidConversionTxBond.get<index_by_conversion_rate>().end();
 
             // Keep track of entries that failed inclusion despite being valid, to avoid duplicate work
             CTxMemPool::setEntries failedValidConversion;
@@ -674,10 +752,15 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
                 onlyUnconfirmed(ancestors);
                 ancestors.insert(iter);
 
+                std::vector<CTxMemPool::txiter> sortedEntries;
+                SortForBlock(ancestors, sortedEntries);
+
                 // Test if conversion in package is valid (will not fail for any other reason)
                 std::optional<CTxConversionInfo> dummyConversionInfo;
-                if (!TestPackageTransactions(ancestors, dummyConversionInfo)) {
+                PackageConversions packageConversions;
+                if (!TestPackageTransactions(sortedEntries, dummyConversionInfo, packageConversions)) {
                     // Conversion is not valid, so assume all other conversions of this type are not either
+                    failedConversionRate[conversionType] = GetMarginalConversionRate(pblocktemplate->block.GetTotalSupply(), conversionType);
                     if (conversionType == CASH) {
                         // Skip to end of iterator
                         cashit = invalidConversionTxCash.get<index_by_conversion_rate>().end();
@@ -706,7 +789,9 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
 
                     if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockWeight >
                             nBlockMaxWeight - 4000) {
-                        // Give up if we're close to full and haven't succeeded in a while
+                        // Give up if we're close to full and haven't succeeded in a while.
+                        // Untested entries remain, so retry both types next time.
+                        failedConversionRate[CASH] = failedConversionRate[BOND] = -std::numeric_limits<double>::infinity();
                         break;
                     }
                     continue;
@@ -715,12 +800,9 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
                 // This transaction will make it in; reset the failed counter.
                 nConsecutiveFailed = 0;
 
-                // Package can be added. Sort the entries in a valid order.
-                std::vector<CTxMemPool::txiter> sortedEntries;
-                SortForBlock(ancestors, sortedEntries);
-
+                // Package can be added.
+                AddPackageToBlock(sortedEntries, packageConversions);
                 for (size_t i = 0; i < sortedEntries.size(); ++i) {
-                    AddToBlock(sortedEntries[i]);
                     // Erase from the modified set, if present
                     mapModifiedTx.erase(sortedEntries[i]);
                     // Add to set of successful transactions to be erased later
@@ -746,6 +828,183 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
             }
         }
     }
+
+    SequenceConversions(mempool, invalidConversionTxCash, invalidConversionTxBond, nPackagesSelected);
+}
+
+std::string ConversionOrderToString(ConversionOrder order)
+{
+    switch (order) {
+    case ConversionOrder::INTERLEAVED: return "interleaved";
+    case ConversionOrder::CASH_FIRST: return "cash-first";
+    case ConversionOrder::BOND_FIRST: return "bond-first";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+BlockAssembler::BlockAssembler(const BlockAssembler& other)
+    : pblocktemplate{std::make_unique<CBlockTemplate>(*other.pblocktemplate)},
+      nBlockMaxWeight{other.nBlockMaxWeight},
+      blockMinFeeRate{other.blockMinFeeRate},
+      m_conversion_time{other.m_conversion_time},
+      nBlockWeight{other.nBlockWeight},
+      nBlockTx{other.nBlockTx},
+      nBlockSigOpsCost{other.nBlockSigOpsCost},
+      nFees{other.nFees[CASH], other.nFees[BOND]},
+      inBlock{other.inBlock},
+      conversionOutputs{other.conversionOutputs},
+      conversionOutputPositions{other.conversionOutputPositions},
+      nHeight{other.nHeight},
+      m_lock_time_cutoff{other.m_lock_time_cutoff},
+      chainparams{other.chainparams},
+      m_mempool{other.m_mempool},
+      m_chainstate{other.m_chainstate} {}
+
+void BlockAssembler::TakeBlock(BlockAssembler& other)
+{
+    std::swap(pblocktemplate, other.pblocktemplate);
+    std::swap(nBlockWeight, other.nBlockWeight);
+    std::swap(nBlockTx, other.nBlockTx);
+    std::swap(nBlockSigOpsCost, other.nBlockSigOpsCost);
+    std::swap(nFees, other.nFees);
+    std::swap(inBlock, other.inBlock);
+    std::swap(conversionOutputs, other.conversionOutputs);
+    std::swap(conversionOutputPositions, other.conversionOutputPositions);
+}
+
+// Executing a conversion moves the supply against later conversions of the same
+// type and in favor of conversions of the other type, so the order of the
+// conversions in a block decides how many of them are valid. The loop in
+// addPackageTxs() only retries the first conversion of each type, in feerate
+// order. This stage then retries every conversion left out, once for each
+// ConversionOrder, each on a copy of the block on a task of the shared thread
+// pool. All orders
+// share the same time budget, so trying several of them does not make block
+// assembly slower. The block whose fees are highest, with bonds converted to
+// cash at the supply before this stage, is kept.
+void BlockAssembler::SequenceConversions(const CTxMemPool& mempool,
+                                         const indexed_conversion_transaction_set& invalidConversionTxCash,
+                                         const indexed_conversion_transaction_set& invalidConversionTxBond,
+                                         int& nPackagesSelected)
+{
+    AssertLockHeld(mempool.cs);
+
+    if (m_conversion_time.count() == 0 || (invalidConversionTxCash.empty() && invalidConversionTxBond.empty())) return;
+    const auto deadline{SteadyClock::now() + m_conversion_time};
+
+    // Look up the in-mempool ancestors of each conversion here, so that the
+    // orders can be tried on other threads while this one holds the mempool
+    // lock. Within a type, conversions are tried in order of their conversion
+    // rate, lowest first, which are the ones with the largest remainders.
+    std::array<std::vector<ConversionCandidate>, 2> candidates;
+    for (const CAmountType conversionType : {CASH, BOND}) {
+        const indexed_conversion_transaction_set& invalidConversionTx = conversionType == CASH ? invalidConversionTxCash : invalidConversionTxBond;
+        for (const CTxMemPoolConversionEntry& entry : invalidConversionTx.get<index_by_conversion_rate>()) {
+            if (inBlock.count(entry.iter)) continue;
+            CTxMemPool::setEntries ancestors;
+            uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+            std::string dummy;
+            mempool.CalculateMemPoolAncestors(*entry.iter, ancestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+
+            onlyUnconfirmed(ancestors);
+            ancestors.insert(entry.iter);
+
+            ConversionCandidate& candidate = candidates[conversionType].emplace_back();
+            candidate.iter = entry.iter;
+            SortForBlock(ancestors, candidate.sortedEntries);
+        }
+    }
+
+    const ConversionRate conversionRate{pblocktemplate->block.GetTotalSupply()};
+    constexpr std::array<ConversionOrder, 3> orders{ConversionOrder::INTERLEAVED, ConversionOrder::CASH_FIRST, ConversionOrder::BOND_FIRST};
+    // The first order is tried on this block, the others on copies of it
+    std::vector<std::unique_ptr<BlockAssembler>> copies;
+    for (size_t i = 1; i < orders.size(); ++i) {
+        copies.emplace_back(new BlockAssembler(*this));
+    }
+    std::array<int, orders.size()> nConversionsAdded{};
+    util::ParallelFor("conversionorders", util::TaskPriority::NORMAL, orders.size(), orders.size(), [&](size_t i) {
+        BlockAssembler& assembler = i == 0 ? *this : *copies[i - 1];
+        nConversionsAdded[i] = assembler.AddConversionsInOrder(orders[i], candidates, deadline);
+    });
+
+    std::vector<ConversionOrderResult> results;
+    size_t best = 0;
+    for (size_t i = 0; i < orders.size(); ++i) {
+        const BlockAssembler& assembler = i == 0 ? *this : *copies[i - 1];
+        ConversionOrderResult& result = results.emplace_back();
+        result.order = ConversionOrderToString(orders[i]);
+        result.nConversions = nConversionsAdded[i];
+        result.fees = {assembler.nFees[CASH], assembler.nFees[BOND]};
+        result.normalizedFees = result.fees[CASH] + conversionRate.Convert(result.fees[BOND], BOND);
+        if (result.normalizedFees > results[best].normalizedFees) best = i;
+        LogPrint(BCLog::BENCH, "%s: %s order added %d conversions, fees %d cash %d bonds\n", __func__,
+                 result.order, result.nConversions, result.fees[CASH], result.fees[BOND]);
+    }
+    if (best != 0) TakeBlock(*copies[best - 1]);
+    results[best].selected = true;
+    nPackagesSelected += results[best].nConversions;
+    pblocktemplate->vConversionOrders = std::move(results);
+}
+
+int BlockAssembler::AddConversionsInOrder(ConversionOrder order, const std::array<std::vector<ConversionCandidate>, 2>& candidates,
+                                          SteadyClock::time_point deadline)
+{
+    // Candidates that were added or can not be added for a reason other than their conversion rate
+    std::array<std::vector<bool>, 2> done{std::vector<bool>(candidates[CASH].size()), std::vector<bool>(candidates[BOND].size())};
+    CAmountType conversionType;
+    if (order == ConversionOrder::INTERLEAVED) {
+        conversionType = candidates[CASH].size() >= candidates[BOND].size() ? CASH : BOND;
+    } else {
+        conversionType = order == ConversionOrder::CASH_FIRST ? CASH : BOND;
+    }
+    // Number of consecutive types that had no conversion to add
+    int nTypesExhausted = 0;
+    int nConversionsAdded = 0;
+
+    while (nTypesExhausted < 2) {
+        bool added = false;
+        for (size_t i = 0; i < candidates[conversionType].size(); ++i) {
+            if (SteadyClock::now() > deadline) return nConversionsAdded;
+            if (done[conversionType][i]) continue;
+            const ConversionCandidate& candidate = candidates[conversionType][i];
+
+            // Leave out ancestors added with earlier conversions
+            std::vector<CTxMemPool::txiter> sortedEntries;
+            uint64_t packageSize = 0;
+            CAmount packageFees = 0;
+            int64_t packageSigOpsCost = 0;
+            for (CTxMemPool::txiter it : candidate.sortedEntries) {
+                if (inBlock.count(it)) continue;
+                sortedEntries.push_back(it);
+                packageSize += it->GetTxSize();
+                packageFees += it->GetModifiedFee();
+                packageSigOpsCost += it->GetSigOpCost();
+            }
+            if (sortedEntries.empty() || sortedEntries.back() != candidate.iter ||
+                packageFees < blockMinFeeRate.GetFee(packageSize) ||
+                !TestPackage(packageSize, packageSigOpsCost)) {
+                done[conversionType][i] = true;
+                continue;
+            }
+
+            // The conversion may become valid once a conversion of the other type is added
+            std::optional<CTxConversionInfo> dummyConversionInfo;
+            PackageConversions packageConversions;
+            if (!TestPackageTransactions(sortedEntries, dummyConversionInfo, packageConversions)) continue;
+
+            AddPackageToBlock(sortedEntries, packageConversions);
+            done[conversionType][i] = true;
+            ++nConversionsAdded;
+            added = true;
+            // Give the other type a turn after each conversion, or after all conversions of this type
+            if (order == ConversionOrder::INTERLEAVED) break;
+        }
+
+        nTypesExhausted = added ? 0 : nTypesExhausted + 1;
+        conversionType = conversionType == CASH ? BOND : CASH;
+    }
+    return nConversionsAdded;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -755,41 +1014,44 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
 
 static std::vector<std::thread> minerThreads;
 static std::atomic<bool> fRequestStopMining(false);
+/** Number of hashes computed by the miner threads since mining was last started */
+static std::atomic<uint64_t> nMiningHashes{0};
+/** Time at which mining was last started, or 0 if not mining */
+static std::atomic<int64_t> nMiningStartTime{0};
 
 //
 // ScanHash scans nonces looking for a hash with at least some zero bits.
 // The nonce is usually preserved between calls, but periodically or if the
-// nonce is 0xffff0000 or above, the block is rebuilt and nNonce starts over at
-// zero.
+// nonce reaches the end of the thread's nonce range, the block is rebuilt and
+// nNonce starts over at the beginning of the range.
 //
 bool static ScanHash(const CBlockHeader *pblock, uint32_t& nNonce, uint256& phash)
 {
-    // Initialize a blake3_hasher in the default hashing mode.
-    blake3_hasher hasher;
-    blake3_hasher_init(&hasher);
-    // Write the first 92 bytes of the block header to a blake3_hasher state.
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *pblock;
-    assert(ss.size() == 96);
-    blake3_hasher_update(&hasher, (unsigned char*)&ss[0], 92);
+    // Cache the hasher state after the first block of the header, which does
+    // not depend on the nonce.
+    unsigned char header[CBlockHeader::SERIALIZED_SIZE];
+    pblock->SerializeToBuffer(header);
+    const CBlake3HeaderHasher hasher(header);
+    const uint32_t nNonceStart = nNonce;
 
     while (true) {
         nNonce++;
 
-        // Write the last 4 bytes of the block header (the nonce) to a copy of
-        // the blake3_hasher state, and compute the result.
-        blake3_hasher hasherCopy = hasher;
-        blake3_hasher_update(&hasherCopy, (unsigned char*)&nNonce, 4);
-        blake3_hasher_finalize(&hasherCopy, (unsigned char*)&phash, BLAKE3_OUT_LEN);
+        // Hash the final block of the header with the nonce
+        hasher.Finalize(nNonce, phash.begin());
 
         // Return the nonce if the hash has at least some zero bits,
         // caller will check if it has enough to reach the target
-        if (((uint16_t*)&phash)[15] == 0)
+        if (((uint16_t*)&phash)[15] == 0) {
+            nMiningHashes += nNonce - nNonceStart;
             return true;
+        }
 
         // If nothing found after trying for a while, return -1
-        if ((nNonce & 0xfff) == 0)
+        if ((nNonce & 0xfff) == 0) {
+            nMiningHashes += nNonce - nNonceStart;
             return false;
+        }
 
         // Check for shutdown or stop request
         if (ShutdownRequested() || fRequestStopMining)
@@ -818,14 +1080,19 @@ static bool ProcessBlockFound(ChainstateManager* chainman, const CBlock* pblock)
     return true;
 }
 
-void static BitcoinMiner(ChainstateManager* chainman, CConnman* connman, CWallet* pwallet)
+void static BitcoinMiner(ChainstateManager* chainman, CConnman* connman, CWallet* pwallet, int nThreadIndex, int nThreads)
 {
     LogPrintf("BitcoinMiner started\n");
     SetThreadPriority(THREAD_PRIORITY_LOWEST);
-    util::ThreadRename("bitcoin-miner");
+    util::ThreadRename(strprintf("bitcoin-miner.%i", nThreadIndex));
 
     unsigned int nExtraNonce = 0;
 
+    // Each thread scans a disjoint nonce range, aligned to the ScanHash batch size
+    const uint32_t nNonceRange = (0xffff0000 / nThreads) & ~uint32_t{0xfff};
+    const uint32_t nNonceBegin = nNonceRange * nThreadIndex;
+    const uint32_t nNonceEnd = nNonceBegin + nNonceRange;
+
     CScript coinbaseScript = CScript();
     std::shared_ptr<CReserveDestination> reserveDest;
     if (pwallet) {
@@ -885,7 +1152,7 @@ void static BitcoinMiner(ChainstateManager* chainman, CConnman* connman, CWallet
             int64_t nStart = GetTime();
             arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
             uint256 hash;
-            uint32_t nNonce = 0;
+            uint32_t nNonce = nNonceBegin;
             while (true) {
                 // Check if something found
                 if (ScanHash(pblock, nNonce, hash))
@@ -917,7 +1184,7 @@ void static BitcoinMiner(ChainstateManager* chainman, CConnman* connman, CWallet
                 // Regtest mode doesn't require peers
                 if (connman->GetNodeCount(ConnectionDirection::Both) == 0 && chainman->GetParams().MiningRequiresPeers())
                     break;
-                if (nNonce >= 0xffff0000)
+                if (nNonce >= nNonceEnd)
                     break;
                 if (mempool->GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60)
                     break;
@@ -949,8 +1216,6 @@ void static BitcoinMiner(ChainstateManager* chainman, CConnman* connman, CWallet
 
 void StartMining(NodeContext& context, int nThreads, CWallet* pwallet)
 {
-    static std::vector<std::thread> minerThreads;
-
     if (nThreads < 0)
         nThreads = GetNumCores();
 
@@ -965,9 +1230,11 @@ void StartMining(NodeContext& context, int nThreads, CWallet* pwallet)
     ChainstateManager& chainman = *context.chainman;
     CConnman& connman = *context.connman;
     fRequestStopMining = false;
+    nMiningHashes = 0;
+    nMiningStartTime = GetTimeMicros();
 
     for (int i = 0; i < nThreads; i++)
-        minerThreads.push_back(std::thread(&BitcoinMiner, &chainman, &connman, pwallet));
+        minerThreads.push_back(std::thread(&BitcoinMiner, &chainman, &connman, pwallet, i, nThreads));
 }
 
 void StopMining() {
@@ -975,6 +1242,16 @@ void StopMining() {
     for (auto& t: minerThreads)
         t.join();
     minerThreads.clear();
+    nMiningStartTime = 0;
+}
+
+double GetMiningHashesPerSec()
+{
+    const int64_t nStart = nMiningStartTime;
+    if (nStart == 0) return 0;
+    const int64_t nElapsed = GetTimeMicros() - nStart;
+    if (nElapsed <= 0) return 0;
+    return nMiningHashes * 1e6 / nElapsed;
 }
 
 } // namespace node
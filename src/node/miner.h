@@ -6,15 +6,23 @@
 #ifndef BITCOIN_NODE_MINER_H
 #define BITCOIN_NODE_MINER_H
 
+#include <hash.h>
 #include <net.h>
 #include <node/context.h>
 #include <primitives/block.h>
 #include <txmempool.h>
+#include <util/time.h>
 #include <wallet/wallet.h>
 
+#include <array>
+#include <chrono>
 #include <memory>
 #include <optional>
 #include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
@@ -33,6 +41,30 @@ static const bool DEFAULT_GENERATE = false;
 static const int DEFAULT_GENERATE_THREADS = 1;
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -blockconversiontime, the time spent sequencing conversions left out of a block by feerate order */
+static constexpr std::chrono::milliseconds DEFAULT_BLOCK_CONVERSION_TIME{50};
+
+/** Order in which conversions left out of a block by feerate order are retried */
+enum class ConversionOrder {
+    INTERLEAVED, //!< Alternate between cash and bond conversions after each conversion
+    CASH_FIRST,  //!< Add all cash conversions that are valid before turning to bond conversions
+    BOND_FIRST,  //!< Add all bond conversions that are valid before turning to cash conversions
+};
+
+std::string ConversionOrderToString(ConversionOrder order);
+
+/** Summary of a candidate block assembled with one ConversionOrder */
+struct ConversionOrderResult {
+    std::string order;
+    //! Number of conversions added in this order
+    int nConversions{0};
+    //! Fees of the block, including the remainders paid to the miner
+    CAmounts fees{0};
+    //! Fees with bonds converted to cash at the supply before the conversions were added
+    CAmount normalizedFees{0};
+    //! Whether this candidate was kept for the block template
+    bool selected{false};
+};
 
 struct CBlockTemplate
 {
@@ -41,6 +73,8 @@ struct CBlockTemplate
     std::vector<CAmount> vTxFeesBond;
     std::vector<int64_t> vTxSigOpsCost;
     std::vector<unsigned char> vchCoinbaseCommitment;
+    //! Candidates the block was chosen from, empty if no conversions were retried
+    std::vector<ConversionOrderResult> vConversionOrders;
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -185,6 +219,21 @@ typedef boost::multi_index_container<
 typedef indexed_conversion_transaction_set::nth_index<0>::type::iterator conversiontxiter;
 typedef indexed_conversion_transaction_set::index<index_by_conversion_rate>::type::iterator conversionrateiter;
 
+/** Result of executing the conversions of a package, in block order, against the block's supply */
+struct PackageConversions {
+    //! Total supply after every conversion in the package
+    CAmounts totalSupply{0};
+    //! Remainder of the conversion at each position of the sorted package (nullopt if not a conversion)
+    std::vector<std::optional<CAmount>> remainders;
+};
+
+/** A conversion left out of a block by feerate order */
+struct ConversionCandidate {
+    CTxMemPool::txiter iter;
+    //! The conversion and its in-mempool ancestors that were not in the block, sorted for the block
+    std::vector<CTxMemPool::txiter> sortedEntries;
+};
+
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler
 {
@@ -195,6 +244,7 @@ private:
     // Configuration parameters for the block size
     unsigned int nBlockMaxWeight;
     CFeeRate blockMinFeeRate;
+    std::chrono::milliseconds m_conversion_time;
 
     // Information on the current status of the block
     uint64_t nBlockWeight;
@@ -202,7 +252,13 @@ private:
     uint64_t nBlockSigOpsCost;
     CAmount nFees[2] = {0};
     CTxMemPool::setEntries inBlock;
+    //! Remainders paid in the coinbase, one output per (amount type, script) in the order they were first added
     std::vector<CTxOut> conversionOutputs;
+    struct ConversionOutputHasher {
+        size_t operator()(const std::pair<CAmountType, CScript>& key) const { return MurmurHash3(key.first, key.second); }
+    };
+    //! Position in conversionOutputs of the output paying each (amount type, script)
+    std::unordered_map<std::pair<CAmountType, CScript>, size_t, ConversionOutputHasher> conversionOutputPositions;
 
     // Chain context for the block
     int nHeight;
@@ -217,6 +273,8 @@ public:
         Options();
         size_t nBlockMaxWeight;
         CFeeRate blockMinFeeRate;
+        //! Time budget for sequencing conversions after feerate order, or zero to only use feerate order
+        std::chrono::milliseconds conversion_time;
     };
 
     explicit BlockAssembler(Chainstate& chainstate, const CTxMemPool* mempool);
@@ -232,14 +290,32 @@ private:
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
     void resetBlock();
-    /** Add a tx to the block */
-    void AddToBlock(CTxMemPool::txiter iter);
+    /** Add a tx to the block, paying out the remainder if it is a conversion */
+    void AddToBlock(CTxMemPool::txiter iter, const std::optional<CAmount>& remainder);
+    /** Add a sorted package to the block and apply the result of its conversions to the block's supply */
+    void AddPackageToBlock(const std::vector<CTxMemPool::txiter>& sortedEntries, const PackageConversions& packageConversions);
 
     // Methods for how to add transactions to a block.
     /** Add transactions based on feerate including unconfirmed ancestors
       * Increments nPackagesSelected / nDescendantsUpdated with corresponding
       * statistics from the package selection (for logging statistics). */
     void addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add conversions that were invalid in feerate order, trying each ConversionOrder
+      * concurrently within the time budget and keeping the block with the highest fees. */
+    void SequenceConversions(const CTxMemPool& mempool,
+                             const indexed_conversion_transaction_set& invalidConversionTxCash,
+                             const indexed_conversion_transaction_set& invalidConversionTxBond,
+                             int& nPackagesSelected) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+    /** Add the candidates in the given order, switching between cash and bond conversions
+      * so each moves the supply in favor of the other, until neither type can be added or
+      * the deadline passes. Only reads the mempool entries, so the caller must hold the
+      * mempool lock for the entries to stay valid. Returns the number of conversions added. */
+    int AddConversionsInOrder(ConversionOrder order, const std::array<std::vector<ConversionCandidate>, 2>& candidates,
+                              SteadyClock::time_point deadline);
+    /** Copy the state of a partially assembled block, to continue it in another way */
+    BlockAssembler(const BlockAssembler& other);
+    /** Continue with the block assembled by other instead */
+    void TakeBlock(BlockAssembler& other);
 
     // helper functions for addPackageTxs()
     /** Remove confirmed (inBlock) entries from given set */
@@ -249,8 +325,11 @@ private:
     /** Perform checks on each transaction in a package:
       * locktime, premature-witness, serialized size (if necessary)
       * These checks should always succeed, and they're here
-      * only as an extra check in case of suboptimal node configuration */
-    bool TestPackageTransactions(const CTxMemPool::setEntries& package, std::optional<CTxConversionInfo>& conversionInfo) const;
+      * only as an extra check in case of suboptimal node configuration.
+      * Also executes the package's conversions in block order against the
+      * block's supply, storing the result in packageConversions. On failure,
+      * conversionInfo is set to the conversion that could not be executed. */
+    bool TestPackageTransactions(const std::vector<CTxMemPool::txiter>& sortedEntries, std::optional<CTxConversionInfo>& conversionInfo, PackageConversions& packageConversions) const;
     /** Create a conversion entry with the estimated conversion rate necessary
       * to execute the transaction.
       */
@@ -259,6 +338,13 @@ private:
     void SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries);
 };
 
+/**
+ * Create a block with only a coinbase, paying the block reward to scriptPubKeyIn, on
+ * top of pindexPrev, which need not be the active tip. The block has no valid
+ * proof-of-work. cs_main must be held.
+ */
+CBlock CreateEmptyBlock(ChainstateManager& chainman, const CBlockIndex* pindexPrev, const CScript& scriptPubKeyIn);
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -266,6 +352,8 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 /** Run the miner threads */
 void StartMining(NodeContext& context, int nThreads, CWallet* pwallet);
 void StopMining();
+/** Average hashes per second of the miner threads since they were started, or 0 if not mining */
+double GetMiningHashesPerSec();
 
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
@@ -12,6 +12,7 @@
 #include <tinyformat.h>
 
 #include <numeric>
+#include <vector>
 
 namespace node {
 PSBTAnalysis AnalyzePSBT(PartiallySignedTransaction psbtx, std::optional<CAmounts> totalSupply)
@@ -26,6 +27,8 @@ PSBTAnalysis AnalyzePSBT(PartiallySignedTransaction psbtx, std::optional<CAmount
     result.inputs.resize(psbtx.tx->vin.size());
 
     const PrecomputedTransactionData txdata = PrecomputePSBTData(psbtx);
+    // Inputs that are not final yet, whose missing data is found by signing them below
+    std::vector<bool> sign_inputs(psbtx.tx->vin.size(), false);
 
     for (unsigned int i = 0; i < psbtx.tx->vin.size(); ++i) {
         PSBTInput& input = psbtx.inputs[i];
@@ -62,32 +65,38 @@ PSBTAnalysis AnalyzePSBT(PartiallySignedTransaction psbtx, std::optional<CAmount
         // Check if it is final
         if (!utxo.IsNull() && !PSBTInputSigned(input)) {
             input_analysis.is_final = false;
-
-            // Figure out what is missing
-            SignatureData outdata;
-            bool complete = SignPSBTInput(DUMMY_SIGNING_PROVIDER, psbtx, i, &txdata, 1, &outdata);
-
-            // Things are missing
-            if (!complete) {
-                input_analysis.missing_pubkeys = outdata.missing_pubkeys;
-                input_analysis.missing_redeem_script = outdata.missing_redeem_script;
-                input_analysis.missing_witness_script = outdata.missing_witness_script;
-                input_analysis.missing_sigs = outdata.missing_sigs;
-
-                // If we are only missing signatures and nothing else, then next is signer
-                if (outdata.missing_pubkeys.empty() && outdata.missing_redeem_script.IsNull() && outdata.missing_witness_script.IsNull() && !outdata.missing_sigs.empty()) {
-                    input_analysis.next = PSBTRole::SIGNER;
-                } else {
-                    input_analysis.next = PSBTRole::UPDATER;
-                }
-            } else {
-                input_analysis.next = PSBTRole::FINALIZER;
-            }
+            sign_inputs[i] = true;
         } else if (!utxo.IsNull()){
             input_analysis.is_final = true;
         }
     }
 
+    ForEachPSBTInput(psbtx, [&](unsigned int i) {
+        if (!sign_inputs[i]) return;
+        PSBTInputAnalysis& input_analysis = result.inputs[i];
+
+        // Figure out what is missing
+        SignatureData outdata;
+        bool complete = SignPSBTInput(DUMMY_SIGNING_PROVIDER, psbtx, i, &txdata, 1, &outdata);
+
+        // Things are missing
+        if (!complete) {
+            input_analysis.missing_pubkeys = outdata.missing_pubkeys;
+            input_analysis.missing_redeem_script = outdata.missing_redeem_script;
+            input_analysis.missing_witness_script = outdata.missing_witness_script;
+            input_analysis.missing_sigs = outdata.missing_sigs;
+
+            // If we are only missing signatures and nothing else, then next is signer
+            if (outdata.missing_pubkeys.empty() && outdata.missing_redeem_script.IsNull() && outdata.missing_witness_script.IsNull() && !outdata.missing_sigs.empty()) {
+                input_analysis.next = PSBTRole::SIGNER;
+            } else {
+                input_analysis.next = PSBTRole::UPDATER;
+            }
+        } else {
+            input_analysis.next = PSBTRole::FINALIZER;
+        }
+    });
+
     // Calculate next role for PSBT by grabbing "minimum" PSBTInput next role
     result.next = PSBTRole::EXTRACTOR;
     for (unsigned int i = 0; i < psbtx.tx->vin.size(); ++i) {
@@ -136,11 +145,17 @@ PSBTAnalysis AnalyzePSBT(PartiallySignedTransaction psbtx, std::optional<CAmount
         CCoinsViewCache view(&view_dummy);
         bool success = true;
 
+        // Dummy sign every input first, then add them to the transaction in order
+        std::vector<char> dummy_signed(psbtx.tx->vin.size());
+        ForEachPSBTInput(psbtx, [&](unsigned int i) {
+            dummy_signed[i] = SignPSBTInput(DUMMY_SIGNING_PROVIDER, psbtx, i, nullptr, 1);
+        });
+
         for (unsigned int i = 0; i < psbtx.tx->vin.size(); ++i) {
             PSBTInput& input = psbtx.inputs[i];
             Coin newcoin;
 
-            if (!SignPSBTInput(DUMMY_SIGNING_PROVIDER, psbtx, i, nullptr, 1) || !psbtx.GetInputUTXO(newcoin.out, i)) {
+            if (!dummy_signed[i] || !psbtx.GetInputUTXO(newcoin.out, i)) {
                 success = false;
                 break;
             } else {
@@ -0,0 +1,76 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/utxo_snapshot.h>
+
+#include <clientversion.h>
+#include <coins.h>
+#include <compressor.h>
+#include <consensus/amount.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <streams.h>
+
+#include <limits>
+#include <optional>
+
+namespace node {
+void SerializeSnapshotCoins(std::vector<unsigned char>& data, const uint256& txid, const std::map<uint32_t, Coin>& outputs)
+{
+    CVectorWriter s{SER_DISK, CLIENT_VERSION, data, data.size()};
+    s << txid << VARINT(uint64_t{outputs.size()});
+    uint64_t next_n{0};
+    for (const auto& [n, coin] : outputs) {
+        if (coin.out.amountType != CASH && coin.out.amountType != BOND) {
+            throw std::ios_base::failure("unsupported amount type");
+        }
+        const uint64_t code{uint64_t{coin.nHeight} * 4 + uint64_t{coin.fCoinBase} * 2 + uint64_t(coin.out.amountType)};
+        s << VARINT(n - next_n) << VARINT(code) << VARINT(CompressAmount(coin.out.nValue));
+        s << Using<TemplateScriptCompression>(coin.out.scriptPubKey);
+        next_n = n + 1;
+    }
+}
+
+void DeserializeSnapshotChunk(const SnapshotChunk& chunk, std::vector<std::pair<COutPoint, Coin>>& coins)
+{
+    SpanReader s{SER_DISK, CLIENT_VERSION, chunk.m_data};
+    uint64_t coins_left{chunk.m_coins_count};
+    std::optional<uint256> prev_txid;
+    while (!s.empty()) {
+        uint256 txid;
+        uint64_t outputs;
+        s >> txid >> VARINT(outputs);
+        // Each transaction's outputs are written once, in coins database order
+        if (prev_txid && !(*prev_txid < txid)) {
+            throw std::ios_base::failure("transactions out of order");
+        }
+        prev_txid = txid;
+        if (outputs == 0 || outputs > coins_left) {
+            throw std::ios_base::failure("bad number of outputs");
+        }
+        coins_left -= outputs;
+        uint64_t next_n{0};
+        for (uint64_t i = 0; i < outputs; ++i) {
+            uint64_t gap, code, amount;
+            s >> VARINT(gap) >> VARINT(code) >> VARINT(amount);
+            const uint64_t n{next_n + gap};
+            if (gap > std::numeric_limits<uint32_t>::max() || n > std::numeric_limits<uint32_t>::max() ||
+                code >> 2 > std::numeric_limits<int32_t>::max()) {
+                throw std::ios_base::failure("value out of range");
+            }
+            auto& [outpoint, coin] = coins.emplace_back();
+            outpoint = COutPoint(txid, static_cast<uint32_t>(n));
+            coin.nHeight = code >> 2;
+            coin.fCoinBase = (code >> 1) & 1;
+            coin.out.amountType = code & 1 ? BOND : CASH;
+            coin.out.nValue = DecompressAmount(amount);
+            s >> Using<TemplateScriptCompression>(coin.out.scriptPubKey);
+            next_n = n + 1;
+        }
+    }
+    if (coins_left != 0) {
+        throw std::ios_base::failure("chunk holds fewer coins than announced");
+    }
+}
+} // namespace node
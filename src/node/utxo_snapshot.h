@@ -6,10 +6,30 @@
 #ifndef BITCOIN_NODE_UTXO_SNAPSHOT_H
 #define BITCOIN_NODE_UTXO_SNAPSHOT_H
 
+#include <span.h>
+#include <tinyformat.h>
 #include <uint256.h>
 #include <serialize.h>
 
+#include <array>
+#include <cstdint>
+#include <ios>
+#include <map>
+#include <utility>
+#include <vector>
+
+class Coin;
+class COutPoint;
+
 namespace node {
+//! Magic bytes at the start of a UTXO snapshot.
+static constexpr std::array<uint8_t, 5> SNAPSHOT_MAGIC_BYTES{'u', 't', 'x', 'o', 0xff};
+
+//! The snapshot format written by dumptxoutset, and the only one loaded:
+//! SnapshotMetadata, the coins in SnapshotChunks, the SnapshotChunkInfo of
+//! every chunk, and the offset of that index as the last 8 bytes.
+static constexpr uint16_t SNAPSHOT_VERSION{2};
+
 //! Metadata describing a serialized version of a UTXO set from which an
 //! assumeutxo Chainstate can be constructed.
 class SnapshotMetadata
@@ -31,8 +51,88 @@ public:
             m_base_blockhash(base_blockhash),
             m_coins_count(coins_count) { }
 
-    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count); }
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << Span{SNAPSHOT_MAGIC_BYTES} << SNAPSHOT_VERSION << m_base_blockhash << m_coins_count;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        std::array<uint8_t, SNAPSHOT_MAGIC_BYTES.size()> magic;
+        s >> Span{magic};
+        if (magic != SNAPSHOT_MAGIC_BYTES) {
+            throw std::ios_base::failure("Invalid UTXO snapshot magic bytes");
+        }
+        uint16_t version;
+        s >> version;
+        if (version != SNAPSHOT_VERSION) {
+            throw std::ios_base::failure(strprintf("Unsupported UTXO snapshot version %d", version));
+        }
+        s >> m_base_blockhash >> m_coins_count;
+    }
+};
+
+//! Close a snapshot chunk once it holds at least this many bytes of coins.
+static constexpr size_t SNAPSHOT_CHUNK_TARGET_SIZE{1 << 20};
+
+//! The coins following the SnapshotMetadata are written in length-prefixed
+//! chunks, in coins database order. A chunk never splits the outputs of one
+//! transaction, so a snapshot can be cut at any chunk boundary and the chunks
+//! can be decoded independently.
+class SnapshotChunk
+{
+public:
+    //! The number of coins encoded in m_data.
+    uint64_t m_coins_count = 0;
+
+    //! Coins encoded by SerializeSnapshotCoins().
+    std::vector<unsigned char> m_data;
+
+    SERIALIZE_METHODS(SnapshotChunk, obj) { READWRITE(COMPACTSIZE(obj.m_coins_count), obj.m_data); }
+};
+
+//! Index entry for one SnapshotChunk, so that readers can seek to any part of
+//! the UTXO set without decoding the chunks before it.
+class SnapshotChunkInfo
+{
+public:
+    //! Offset of the chunk from the start of the snapshot.
+    uint64_t m_offset = 0;
+
+    //! Number of coins in the chunk.
+    uint64_t m_coins_count = 0;
+
+    //! The txid of the first coin in the chunk.
+    uint256 m_first_txid;
+
+    SERIALIZE_METHODS(SnapshotChunkInfo, obj) { READWRITE(obj.m_offset, COMPACTSIZE(obj.m_coins_count), obj.m_first_txid); }
+
+    friend bool operator==(const SnapshotChunkInfo& a, const SnapshotChunkInfo& b)
+    {
+        return a.m_offset == b.m_offset && a.m_coins_count == b.m_coins_count && a.m_first_txid == b.m_first_txid;
+    }
 };
+
+/**
+ * Append the outputs of one transaction to a chunk. They are written as the
+ * txid and the number of outputs, followed for each output by the gap to the
+ * previous output index, a varint packing height, coinbase flag and amount
+ * type, the compressed amount and the script. Besides the templates of
+ * ScriptCompression, scripts have short encodings for P2WPKH, P2WSH and P2TR.
+ */
+void SerializeSnapshotCoins(std::vector<unsigned char>& data, const uint256& txid, const std::map<uint32_t, Coin>& outputs);
+
+/**
+ * Decode the coins of a chunk and append them to coins. The coins of a valid
+ * chunk are in strictly ascending outpoint order. The caller checks the order
+ * across chunks.
+ *
+ * @throws std::ios_base::failure if the chunk is malformed, lists transactions
+ *         out of order or does not hold exactly chunk.m_coins_count coins
+ */
+void DeserializeSnapshotChunk(const SnapshotChunk& chunk, std::vector<std::pair<COutPoint, Coin>>& coins);
 } // namespace node
 
 #endif // BITCOIN_NODE_UTXO_SNAPSHOT_H
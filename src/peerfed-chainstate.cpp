@@ -4,7 +4,8 @@
 //
 // The peerfed-chainstate executable serves to surface the dependencies required
 // by a program wishing to use Bitcoin Core's consensus engine as it is right
-// now.
+// now. Given block files, it replays them into the datadir without networking,
+// which makes it a harness for comparing the validation performance of builds.
 //
 // DEVELOPER NOTE: Since this is a "demo-only", experimental, etc. executable,
 //                 it may diverge from Bitcoin Core's coding style.
@@ -14,121 +15,240 @@
 #include <kernel/checks.h>
 #include <kernel/context.h>
 #include <kernel/validation_cache_sizes.h>
+#include <kernel/validation_stats.h>
 
 #include <chainparams.h>
+#include <chainparamsbase.h>
+#include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <fs.h>
 #include <node/blockstorage.h>
 #include <node/caches.h>
 #include <node/chainstate.h>
+#include <protocol.h>
 #include <scheduler.h>
 #include <script/sigcache.h>
+#include <streams.h>
+#include <txdb.h>
+#include <univalue.h>
 #include <util/system.h>
 #include <util/thread.h>
+#include <util/time.h>
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <functional>
 #include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
-int main(int argc, char* argv[])
-{
-    // SETUP: Argument parsing and handling
-    if (argc != 2) {
-        std::cerr
-            << "Usage: " << argv[0] << " DATADIR" << std::endl
-            << "Display DATADIR information, and process hex-encoded blocks on standard input." << std::endl
-            << std::endl
-            << "IMPORTANT: THIS EXECUTABLE IS EXPERIMENTAL, FOR TESTING ONLY, AND EXPECTED TO" << std::endl
-            << "           BREAK IN FUTURE VERSIONS. DO NOT USE ON YOUR ACTUAL DATADIR." << std::endl;
-        return 1;
-    }
-    std::filesystem::path abs_datadir = std::filesystem::absolute(argv[1]);
-    std::filesystem::create_directories(abs_datadir);
-    gArgs.ForceSetArg("-datadir", abs_datadir.string());
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
 
+static constexpr int DEFAULT_FLUSH_EVERY{0};
 
-    // SETUP: Misc Globals
-    SelectParams(CBaseChainParams::MAIN);
-    const CChainParams& chainparams = Params();
-
-    kernel::Context kernel_context{};
-    // We can't use a goto here, but we can use an assert since none of the
-    // things instantiated so far requires running the epilogue to be torn down
-    // properly
-    assert(!kernel::SanityChecks(kernel_context).has_value());
-
-    // Necessary for CheckInputScripts (eventually called by ProcessNewBlock),
-    // which will try the script cache first and fall back to actually
-    // performing the check with the signature cache.
-    kernel::ValidationCacheSizes validation_cache_sizes{};
-    Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
-    Assert(InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes));
+static void SetupChainstateArgs(ArgsManager& args)
+{
+    SetupHelpOptions(args);
+    SetupChainParamsBaseOptions(args);
+    args.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d)", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    args.AddArg("-dbflushbackground", strprintf("Write periodic flushes of the coins cache to disk on a background thread (default: %u)", DEFAULT_DBFLUSH_BACKGROUND), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    args.AddArg("-flushevery=<n>", strprintf("Write the chainstate to disk, without a background thread, after every <n> connected blocks. 0 to only flush when the coins cache is full or periodically (default: %d)", DEFAULT_FLUSH_EVERY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    args.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+        -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    args.AddArg("-stopatheight=<n>", "Stop replaying once the active chain reaches height <n> (default: 0, replay every block)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+}
 
+/** The cache sizes of node::CalculateCacheSizes(), without indexes */
+static node::CacheSizes CalculateChainstateCacheSizes(const ArgsManager& args)
+{
+    int64_t total_cache = std::clamp(args.GetIntArg("-dbcache", nDefaultDbCache), nMinDbCache, nMaxDbCache) << 20;
+    node::CacheSizes sizes{};
+    sizes.block_tree_db = std::min(total_cache / 8, nMaxBlockDBCache << 20);
+    total_cache -= sizes.block_tree_db;
+    sizes.coins_db = std::min(std::min(total_cache / 2, (total_cache / 4) + (1 << 23)), nMaxCoinsDBCache << 20);
+    total_cache -= sizes.coins_db;
+    sizes.coins = total_cache;
+    return sizes;
+}
 
-    // SETUP: Scheduling and Background Signals
-    CScheduler scheduler{};
-    // Start the lightweight task scheduler thread
-    scheduler.m_service_thread = std::thread(util::TraceThread, "scheduler", [&] { scheduler.serviceQueue(); });
+static int GetScriptCheckThreads(const ArgsManager& args)
+{
+    int script_threads = args.GetIntArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
+    if (script_threads <= 0) script_threads += GetNumCores();
+    // The main thread counts towards the par threads
+    return std::clamp(script_threads - 1, 0, MAX_SCRIPTCHECK_THREADS);
+}
 
-    // Gather some entropy once per minute.
-    scheduler.scheduleEvery(RandAddPeriodic, std::chrono::minutes{1});
+/** Peak resident set size of the process in KiB, or 0 where unknown */
+static int64_t GetPeakRSSKiB()
+{
+#ifndef WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024; // bytes
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
 
-    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+static UniValue ValidationStagesToJSON()
+{
+    using kernel::LatencyHistogram;
+    UniValue stages(UniValue::VOBJ);
+    for (size_t i = 0; i < kernel::VALIDATION_STAGE_COUNT; ++i) {
+        const auto stage{static_cast<kernel::ValidationStage>(i)};
+        const LatencyHistogram::Snapshot snapshot{kernel::GetValidationStageHistogram(stage).GetSnapshot()};
+        UniValue buckets(UniValue::VARR);
+        for (const uint64_t count : snapshot.buckets) {
+            buckets.push_back(count);
+        }
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", snapshot.count);
+        obj.pushKV("total_us", snapshot.total_us);
+        obj.pushKV("buckets", buckets);
+        stages.pushKV(kernel::ValidationStageName(stage), obj);
+    }
+    return stages;
+}
 
+/**
+ * Feed the blocks of the given blk*.dat files, in file order, through
+ * ProcessNewBlock. Blocks whose parent is not known yet, as headers-first sync
+ * stores them, are held back until the parent was processed. Returns a summary
+ * of the replay, or std::nullopt if it failed.
+ */
+static std::optional<UniValue> ReplayBlockFiles(ChainstateManager& chainman, const std::vector<fs::path>& files, const ArgsManager& args)
+{
+    const CChainParams& params = chainman.GetParams();
+    const int64_t flush_every{args.GetIntArg("-flushevery", DEFAULT_FLUSH_EVERY)};
+    const int64_t stop_at_height{args.GetIntArg("-stopatheight", 0)};
+    const int start_height{WITH_LOCK(::cs_main, return chainman.ActiveHeight())};
+    std::multimap<uint256, std::shared_ptr<const CBlock>> unknown_parent;
+    uint64_t blocks_read{0};
+    uint64_t blocks_processed{0};
+    int64_t last_flush_height{start_height};
+    bool done{false};
 
-    // SETUP: Chainstate
-    const ChainstateManager::Options chainman_opts{
-        .chainparams = chainparams,
-        .adjusted_time_callback = NodeClock::now,
-    };
-    ChainstateManager chainman{chainman_opts};
+    const auto process{[&](std::shared_ptr<const CBlock> block) {
+        // Process the block, then every held back descendant it unblocked
+        std::vector<std::shared_ptr<const CBlock>> queue{std::move(block)};
+        while (!queue.empty() && !done) {
+            std::shared_ptr<const CBlock> next{std::move(queue.back())};
+            queue.pop_back();
+            if (!chainman.ProcessNewBlock(next, /*force_processing=*/true, /*min_pow_checked=*/true, /*new_block=*/nullptr)) {
+                std::cerr << "Block " << next->GetHash().ToString() << " was rejected" << std::endl;
+            }
+            ++blocks_processed;
+            const auto range{unknown_parent.equal_range(next->GetHash())};
+            for (auto it = range.first; it != range.second; ++it) {
+                queue.push_back(it->second);
+            }
+            unknown_parent.erase(range.first, range.second);
 
-    node::CacheSizes cache_sizes;
-    cache_sizes.block_tree_db = 2 << 20;
-    cache_sizes.coins_db = 2 << 22;
-    cache_sizes.coins = (450 << 20) - (2 << 20) - (2 << 22);
-    node::ChainstateLoadOptions options;
-    options.check_interrupt = [] { return false; };
-    auto [status, error] = node::LoadChainstate(chainman, cache_sizes, options);
-    if (status != node::ChainstateLoadStatus::SUCCESS) {
-        std::cerr << "Failed to load Chain state from your datadir." << std::endl;
-        goto epilogue;
-    } else {
-        std::tie(status, error) = node::VerifyLoadedChainstate(chainman, options);
-        if (status != node::ChainstateLoadStatus::SUCCESS) {
-            std::cerr << "Failed to verify loaded Chain state from your datadir." << std::endl;
-            goto epilogue;
+            const int height{WITH_LOCK(::cs_main, return chainman.ActiveHeight())};
+            if (flush_every > 0 && height - last_flush_height >= flush_every) {
+                LOCK(::cs_main);
+                for (Chainstate* chainstate : chainman.GetAll()) {
+                    BlockValidationState state;
+                    if (!chainstate->FlushStateToDisk(state, FlushStateMode::ALWAYS)) {
+                        std::cerr << "Failed to flush (" << state.ToString() << ")" << std::endl;
+                    }
+                }
+                last_flush_height = height;
+            }
+            if (stop_at_height > 0 && height >= stop_at_height) done = true;
         }
-    }
+    }};
 
-    for (Chainstate* chainstate : WITH_LOCK(::cs_main, return chainman.GetAll())) {
-        BlockValidationState state;
-        if (!chainstate->ActivateBestChain(state, nullptr)) {
-            std::cerr << "Failed to connect best block (" << state.ToString() << ")" << std::endl;
-            goto epilogue;
+    const auto start{SteadyClock::now()};
+    for (const fs::path& path : files) {
+        FILE* file{fsbridge::fopen(path, "rb")};
+        if (!file) {
+            std::cerr << "Failed to open " << fs::PathToString(path) << std::endl;
+            return std::nullopt;
         }
-    }
-
-    // Main program logic starts here
-    std::cout
-        << "Hello! I'm going to print out some information about your datadir." << std::endl
-        << "\t" << "Path: " << gArgs.GetDataDirNet() << std::endl;
-    {
-        LOCK(chainman.GetMutex());
-        std::cout
-        << "\t" << "Reindexing: " << std::boolalpha << node::fReindex.load() << std::noboolalpha << std::endl
-        << "\t" << "Snapshot Active: " << std::boolalpha << chainman.IsSnapshotActive() << std::noboolalpha << std::endl
-        << "\t" << "Active Height: " << chainman.ActiveHeight() << std::endl
-        << "\t" << "Active IBD: " << std::boolalpha << chainman.ActiveChainstate().IsInitialBlockDownload() << std::noboolalpha << std::endl;
-        CBlockIndex* tip = chainman.ActiveTip();
-        if (tip) {
-            std::cout << "\t" << tip->ToString() << std::endl;
+        // Takes over file and closes it in its destructor
+        CBufferedFile blkdat(file, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8, SER_DISK, CLIENT_VERSION);
+        // Like Chainstate::LoadExternalBlockFile, scan for the network magic so that garbage is skipped
+        uint64_t rewind{blkdat.GetPos()};
+        while (!blkdat.eof() && !done) {
+            blkdat.SetPos(rewind);
+            ++rewind;
+            blkdat.SetLimit();
+            unsigned int size{0};
+            try {
+                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                blkdat.FindByte(params.MessageStart()[0]);
+                rewind = blkdat.GetPos() + 1;
+                blkdat >> buf;
+                if (memcmp(buf, params.MessageStart(), CMessageHeader::MESSAGE_START_SIZE)) continue;
+                blkdat >> size;
+                if (size < 80 || size > MAX_BLOCK_SERIALIZED_SIZE) continue;
+            } catch (const std::exception&) {
+                break;
+            }
+            auto block{std::make_shared<CBlock>()};
+            try {
+                blkdat.SetLimit(blkdat.GetPos() + size);
+                blkdat >> *block;
+                rewind = blkdat.GetPos();
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to read a block from " << fs::PathToString(path) << ": " << e.what() << std::endl;
+                continue;
+            }
+            ++blocks_read;
+            const bool parent_known{WITH_LOCK(::cs_main, return chainman.m_blockman.LookupBlockIndex(block->hashPrevBlock) != nullptr)};
+            if (!parent_known && block->GetHash() != params.GetConsensus().hashGenesisBlock) {
+                unknown_parent.emplace(block->hashPrevBlock, std::move(block));
+                continue;
+            }
+            process(std::move(block));
         }
+        if (done) break;
     }
+    const auto elapsed{SteadyClock::now() - start};
+    GetMainSignals().FlushBackgroundCallbacks();
+
+    const int end_height{WITH_LOCK(::cs_main, return chainman.ActiveHeight())};
+    const double seconds{std::chrono::duration<double>(elapsed).count()};
+    const auto& coins_write{kernel::GetValidationStageHistogram(kernel::ValidationStage::COINS_WRITE)};
+    const kernel::LatencyHistogram::Snapshot flushes{coins_write.GetSnapshot()};
+
+    UniValue summary(UniValue::VOBJ);
+    summary.pushKV("chain", params.NetworkIDString());
+    summary.pushKV("start_height", start_height);
+    summary.pushKV("end_height", end_height);
+    summary.pushKV("blocks_read", blocks_read);
+    summary.pushKV("blocks_processed", blocks_processed);
+    summary.pushKV("blocks_unknown_parent", uint64_t{unknown_parent.size()});
+    summary.pushKV("elapsed_s", seconds);
+    summary.pushKV("blocks_per_s", seconds > 0 ? (end_height - start_height) / seconds : 0.0);
+    summary.pushKV("peak_rss_kib", GetPeakRSSKiB());
+    summary.pushKV("dbcache_mib", args.GetIntArg("-dbcache", nDefaultDbCache));
+    summary.pushKV("script_check_threads", GetScriptCheckThreads(args));
+    summary.pushKV("flush_background", g_coins_flush_background);
+    summary.pushKV("flush_stalls", flushes.count);
+    summary.pushKV("flush_stall_us", flushes.total_us);
+    summary.pushKV("stages", ValidationStagesToJSON());
+    return summary;
+}
 
+static void ProcessStdinBlocks(ChainstateManager& chainman)
+{
     for (std::string line; std::getline(std::cin, line);) {
         if (line.empty()) {
             std::cerr << "Empty line found" << std::endl;
@@ -242,12 +362,145 @@ int main(int argc, char* argv[])
             break;
         }
     }
+}
+
+int main(int argc, char* argv[])
+{
+    // SETUP: Argument parsing and handling
+    SetupChainstateArgs(gArgs);
+    std::string error_message;
+    if (!gArgs.ParseParameters(argc, argv, error_message)) {
+        std::cerr << "Error parsing command line arguments: " << error_message << std::endl;
+        return 1;
+    }
+    const auto command{gArgs.GetCommand()};
+    if (HelpRequested(gArgs) || !command || command->args.empty()) {
+        std::cerr
+            << "Usage: " << argv[0] << " [options] DATADIR [BLOCKFILE...]" << std::endl
+            << "Display DATADIR information, and process hex-encoded blocks on standard input." << std::endl
+            << "If block files (blk*.dat) are given, replay their blocks into DATADIR instead, and print a" << std::endl
+            << "JSON summary with the validation stage histograms on standard output." << std::endl
+            << std::endl
+            << "IMPORTANT: THIS EXECUTABLE IS EXPERIMENTAL, FOR TESTING ONLY, AND EXPECTED TO" << std::endl
+            << "           BREAK IN FUTURE VERSIONS. DO NOT USE ON YOUR ACTUAL DATADIR." << std::endl
+            << std::endl
+            << gArgs.GetHelpMessage();
+        return HelpRequested(gArgs) ? 0 : 1;
+    }
+    std::filesystem::path abs_datadir = std::filesystem::absolute(command->args[0]);
+    std::filesystem::create_directories(abs_datadir);
+    gArgs.ForceSetArg("-datadir", abs_datadir.string());
+    std::vector<fs::path> block_files;
+    for (size_t i = 1; i < command->args.size(); ++i) {
+        block_files.push_back(fs::PathFromString(command->args[i]));
+    }
+    g_coins_flush_background = gArgs.GetBoolArg("-dbflushbackground", DEFAULT_DBFLUSH_BACKGROUND);
+
+
+    // SETUP: Misc Globals
+    try {
+        SelectParams(gArgs.GetChainName());
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    const CChainParams& chainparams = Params();
+
+    kernel::Context kernel_context{};
+    // We can't use a goto here, but we can use an assert since none of the
+    // things instantiated so far requires running the epilogue to be torn down
+    // properly
+    assert(!kernel::SanityChecks(kernel_context).has_value());
+
+    // Necessary for CheckInputScripts (eventually called by ProcessNewBlock),
+    // which will try the script cache first and fall back to actually
+    // performing the check with the signature cache.
+    kernel::ValidationCacheSizes validation_cache_sizes{};
+    Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
+    Assert(InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes));
+
+
+    // SETUP: Scheduling and Background Signals
+    CScheduler scheduler{};
+    // Start the lightweight task scheduler thread
+    scheduler.m_service_threads.emplace_back(util::TraceThread, "scheduler", [&] { scheduler.serviceQueue(); });
+
+    // Gather some entropy once per minute.
+    scheduler.scheduleEvery(RandAddPeriodic, std::chrono::minutes{1});
+
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+
+
+    // SETUP: Chainstate
+    const ChainstateManager::Options chainman_opts{
+        .chainparams = chainparams,
+        .adjusted_time_callback = NodeClock::now,
+    };
+    ChainstateManager chainman{chainman_opts};
+    int exit_status{0};
+
+    const node::CacheSizes cache_sizes{CalculateChainstateCacheSizes(gArgs)};
+    node::ChainstateLoadOptions options;
+    options.check_interrupt = [] { return false; };
+    auto [status, error] = node::LoadChainstate(chainman, cache_sizes, options);
+    if (status != node::ChainstateLoadStatus::SUCCESS) {
+        std::cerr << "Failed to load Chain state from your datadir." << std::endl;
+        exit_status = 1;
+        goto epilogue;
+    } else {
+        std::tie(status, error) = node::VerifyLoadedChainstate(chainman, options);
+        if (status != node::ChainstateLoadStatus::SUCCESS) {
+            std::cerr << "Failed to verify loaded Chain state from your datadir." << std::endl;
+            exit_status = 1;
+            goto epilogue;
+        }
+    }
+
+    StartScriptCheckWorkerThreads(GetScriptCheckThreads(gArgs));
+
+    for (Chainstate* chainstate : WITH_LOCK(::cs_main, return chainman.GetAll())) {
+        BlockValidationState state;
+        if (!chainstate->ActivateBestChain(state, nullptr)) {
+            std::cerr << "Failed to connect best block (" << state.ToString() << ")" << std::endl;
+            exit_status = 1;
+            goto epilogue;
+        }
+    }
+
+    // Main program logic starts here
+    if (!block_files.empty()) {
+        const std::optional<UniValue> summary{ReplayBlockFiles(chainman, block_files, gArgs)};
+        if (summary) {
+            std::cout << summary->write(2) << std::endl;
+        } else {
+            exit_status = 1;
+        }
+        goto epilogue;
+    }
+    // Main program logic starts here
+    std::cout
+        << "Hello! I'm going to print out some information about your datadir." << std::endl
+        << "\t" << "Path: " << gArgs.GetDataDirNet() << std::endl;
+    {
+        LOCK(chainman.GetMutex());
+        std::cout
+        << "\t" << "Reindexing: " << std::boolalpha << node::fReindex.load() << std::noboolalpha << std::endl
+        << "\t" << "Snapshot Active: " << std::boolalpha << chainman.IsSnapshotActive() << std::noboolalpha << std::endl
+        << "\t" << "Active Height: " << chainman.ActiveHeight() << std::endl
+        << "\t" << "Active IBD: " << std::boolalpha << chainman.ActiveChainstate().IsInitialBlockDownload() << std::noboolalpha << std::endl;
+        CBlockIndex* tip = chainman.ActiveTip();
+        if (tip) {
+            std::cout << "\t" << tip->ToString() << std::endl;
+        }
+    }
+
+    ProcessStdinBlocks(chainman);
 
 epilogue:
     // Without this precise shutdown sequence, there will be a lot of nullptr
     // dereferencing and UB.
     scheduler.stop();
-    if (chainman.m_load_block.joinable()) chainman.m_load_block.join();
+    if (chainman.m_load_block.valid()) chainman.m_load_block.wait();
     StopScriptCheckWorkerThreads();
 
     GetMainSignals().FlushBackgroundCallbacks();
@@ -261,4 +514,5 @@ epilogue:
         }
     }
     GetMainSignals().UnregisterBackgroundSignalScheduler();
+    return exit_status;
 }
@@ -53,6 +53,7 @@ static const char DEFAULT_RPCCONNECT[] = "127.0.0.1";
 static const int DEFAULT_HTTP_CLIENT_TIMEOUT=900;
 static constexpr int DEFAULT_WAIT_CLIENT_TIMEOUT = 0;
 static const bool DEFAULT_NAMED=false;
+static constexpr int DEFAULT_BATCH_SIZE{100};
 static const int CONTINUE_EXECUTION=-1;
 static constexpr int8_t UNKNOWN_NETWORK{-1};
 static constexpr std::array NETWORKS{"ipv4", "ipv6", "onion", "i2p", "cjdns"};
@@ -81,6 +82,9 @@ static void SetupCliArgs(ArgsManager& argsman)
                              "RPC generatetoaddress nblocks and maxtries arguments. Example: peerfed-cli -generate 4 1000",
                              DEFAULT_NBLOCKS, DEFAULT_MAX_TRIES),
                    ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-batch", "Read commands from standard input, one per line as the method followed by its arguments separated by spaces, where arguments containing spaces are put in single or double quotes. "
+                   "The commands are sent as JSON-RPC batches over a single connection, and for each command a line with a JSON object holding its result and error is printed in order.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-batchsize=<n>", strprintf("Maximum number of commands sent in one JSON-RPC batch with -batch (default: %d)", DEFAULT_BATCH_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-addrinfo", "Get the number of addresses known to the node, per network and total, after filtering for quality and recency. The total number of addresses known to the node may be higher.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-getinfo", "Get general information from the remote server. Note that unlike server-side RPC calls, the results of -getinfo is the result of multiple non-atomic requests. Some entries in the result may represent results from different states (e.g. wallet balance may be as of a different block from the chain state reported)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-netinfo", "Get network peer connection information from the remote server. An optional integer argument from 0 to 4 can be passed for different peers listings (default: 0). Pass \"help\" for detailed help documentation.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -185,6 +189,8 @@ struct HTTPReply
     int status{0};
     int error{-1};
     std::string body;
+    //! Loop to stop once the reply arrived, for connections kept alive afterwards
+    struct event_base* base{nullptr};
 };
 
 static std::string http_errorstring(int code)
@@ -230,6 +236,7 @@ static void http_request_done(struct evhttp_request *req, void *ctx)
             reply->body = std::string(data, size);
         evbuffer_drain(buf, size);
     }
+    if (reply->base) event_base_loopbreak(reply->base);
 }
 
 static void http_error_cb(enum evhttp_request_error err, void *ctx)
@@ -714,115 +721,135 @@ public:
     }
 };
 
-static UniValue CallRPC(BaseRequestHandler* rh, const std::string& strMethod, const std::vector<std::string>& args, const std::optional<std::string>& rpcwallet = {})
+/**
+ * A connection to the RPC server. Unless it is kept alive, the server closes it
+ * after the first request.
+ */
+class RPCConnection
 {
-    std::string host;
-    // In preference order, we choose the following for the port:
-    //     1. -rpcport
-    //     2. port in -rpcconnect (ie following : in ipv4 or ]: in ipv6)
-    //     3. default port for chain
-    uint16_t port{BaseParams().RPCPort()};
-    SplitHostPort(gArgs.GetArg("-rpcconnect", DEFAULT_RPCCONNECT), port, host);
-    port = static_cast<uint16_t>(gArgs.GetIntArg("-rpcport", port));
-
-    // Obtain event base
-    raii_event_base base = obtain_event_base();
-
-    // Synchronously look up hostname
-    raii_evhttp_connection evcon = obtain_evhttp_connection_base(base.get(), host, port);
-
-    // Set connection timeout
+public:
+    explicit RPCConnection(bool keep_alive) : m_keep_alive{keep_alive}
     {
+        // In preference order, we choose the following for the port:
+        //     1. -rpcport
+        //     2. port in -rpcconnect (ie following : in ipv4 or ]: in ipv6)
+        //     3. default port for chain
+        m_port = BaseParams().RPCPort();
+        SplitHostPort(gArgs.GetArg("-rpcconnect", DEFAULT_RPCCONNECT), m_port, m_host);
+        m_port = static_cast<uint16_t>(gArgs.GetIntArg("-rpcport", m_port));
+
+        // Synchronously look up hostname
+        m_evcon = obtain_evhttp_connection_base(m_base.get(), m_host, m_port);
+
+        // Set connection timeout
         const int timeout = gArgs.GetIntArg("-rpcclienttimeout", DEFAULT_HTTP_CLIENT_TIMEOUT);
         if (timeout > 0) {
-            evhttp_connection_set_timeout(evcon.get(), timeout);
+            evhttp_connection_set_timeout(m_evcon.get(), timeout);
         } else {
             // Indefinite request timeouts are not possible in libevent-http, so we
             // set the timeout to a very long time period instead.
 
             constexpr int YEAR_IN_SECONDS = 31556952; // Average length of year in Gregorian calendar
-            evhttp_connection_set_timeout(evcon.get(), 5 * YEAR_IN_SECONDS);
+            evhttp_connection_set_timeout(m_evcon.get(), 5 * YEAR_IN_SECONDS);
         }
-    }
 
-    HTTPReply response;
-    raii_evhttp_request req = obtain_evhttp_request(http_request_done, (void*)&response);
-    if (req == nullptr) {
-        throw std::runtime_error("create http request failed");
+        // Get credentials
+        if (gArgs.GetArg("-rpcpassword", "") == "") {
+            // Try fall back to cookie-based authentication if no password is provided
+            if (!GetAuthCookie(&m_user_colon_pass)) {
+                m_failed_to_get_auth_cookie = true;
+            }
+        } else {
+            m_user_colon_pass = gArgs.GetArg("-rpcuser", "") + ":" + gArgs.GetArg("-rpcpassword", "");
+        }
     }
 
-    evhttp_request_set_error_cb(req.get(), http_error_cb);
-
-    // Get credentials
-    std::string strRPCUserColonPass;
-    bool failedToGetAuthCookie = false;
-    if (gArgs.GetArg("-rpcpassword", "") == "") {
-        // Try fall back to cookie-based authentication if no password is provided
-        if (!GetAuthCookie(&strRPCUserColonPass)) {
-            failedToGetAuthCookie = true;
+    /** Send a JSON-RPC request or batch to the endpoint of rpcwallet, and return the parsed reply */
+    UniValue Post(const UniValue& request, const std::optional<std::string>& rpcwallet)
+    {
+        HTTPReply response;
+        if (m_keep_alive) response.base = m_base.get();
+        raii_evhttp_request req = obtain_evhttp_request(http_request_done, (void*)&response);
+        if (req == nullptr) {
+            throw std::runtime_error("create http request failed");
         }
-    } else {
-        strRPCUserColonPass = gArgs.GetArg("-rpcuser", "") + ":" + gArgs.GetArg("-rpcpassword", "");
-    }
 
-    struct evkeyvalq* output_headers = evhttp_request_get_output_headers(req.get());
-    assert(output_headers);
-    evhttp_add_header(output_headers, "Host", host.c_str());
-    evhttp_add_header(output_headers, "Connection", "close");
-    evhttp_add_header(output_headers, "Content-Type", "application/json");
-    evhttp_add_header(output_headers, "Authorization", (std::string("Basic ") + EncodeBase64(strRPCUserColonPass)).c_str());
-
-    // Attach request data
-    std::string strRequest = rh->PrepareRequest(strMethod, args).write() + "\n";
-    struct evbuffer* output_buffer = evhttp_request_get_output_buffer(req.get());
-    assert(output_buffer);
-    evbuffer_add(output_buffer, strRequest.data(), strRequest.size());
-
-    // check if we should use a special wallet endpoint
-    std::string endpoint = "/";
-    if (rpcwallet) {
-        char* encodedURI = evhttp_uriencode(rpcwallet->data(), rpcwallet->size(), false);
-        if (encodedURI) {
-            endpoint = "/wallet/" + std::string(encodedURI);
-            free(encodedURI);
-        } else {
-            throw CConnectionFailed("uri-encode failed");
+        evhttp_request_set_error_cb(req.get(), http_error_cb);
+
+        struct evkeyvalq* output_headers = evhttp_request_get_output_headers(req.get());
+        assert(output_headers);
+        evhttp_add_header(output_headers, "Host", m_host.c_str());
+        evhttp_add_header(output_headers, "Connection", m_keep_alive ? "keep-alive" : "close");
+        evhttp_add_header(output_headers, "Content-Type", "application/json");
+        evhttp_add_header(output_headers, "Authorization", (std::string("Basic ") + EncodeBase64(m_user_colon_pass)).c_str());
+
+        // Attach request data
+        std::string strRequest = request.write() + "\n";
+        struct evbuffer* output_buffer = evhttp_request_get_output_buffer(req.get());
+        assert(output_buffer);
+        evbuffer_add(output_buffer, strRequest.data(), strRequest.size());
+
+        // check if we should use a special wallet endpoint
+        std::string endpoint = "/";
+        if (rpcwallet) {
+            char* encodedURI = evhttp_uriencode(rpcwallet->data(), rpcwallet->size(), false);
+            if (encodedURI) {
+                endpoint = "/wallet/" + std::string(encodedURI);
+                free(encodedURI);
+            } else {
+                throw CConnectionFailed("uri-encode failed");
+            }
         }
-    }
-    int r = evhttp_make_request(evcon.get(), req.get(), EVHTTP_REQ_POST, endpoint.c_str());
-    req.release(); // ownership moved to evcon in above call
-    if (r != 0) {
-        throw CConnectionFailed("send http request failed");
+        int r = evhttp_make_request(m_evcon.get(), req.get(), EVHTTP_REQ_POST, endpoint.c_str());
+        req.release(); // ownership moved to evcon in above call
+        if (r != 0) {
+            throw CConnectionFailed("send http request failed");
+        }
+
+        event_base_dispatch(m_base.get());
+
+        if (response.status == 0) {
+            std::string responseErrorMessage;
+            if (response.error != -1) {
+                responseErrorMessage = strprintf(" (error code %d - \"%s\")", response.error, http_errorstring(response.error));
+            }
+            throw CConnectionFailed(strprintf("Could not connect to the server %s:%d%s\n\nMake sure the peerfedd server is running and that you are connecting to the correct RPC port.", m_host, m_port, responseErrorMessage));
+        } else if (response.status == HTTP_UNAUTHORIZED) {
+            if (m_failed_to_get_auth_cookie) {
+                throw std::runtime_error(strprintf(
+                    "Could not locate RPC credentials. No authentication cookie could be found, and RPC password is not set.  See -rpcpassword and -stdinrpcpass.  Configuration file: (%s)",
+                    fs::PathToString(GetConfigFile(gArgs.GetPathArg("-conf", BITCOIN_CONF_FILENAME)))));
+            } else {
+                throw std::runtime_error("Authorization failed: Incorrect rpcuser or rpcpassword");
+            }
+        } else if (response.status == HTTP_SERVICE_UNAVAILABLE) {
+            throw std::runtime_error(strprintf("Server response: %s", response.body));
+        } else if (response.status >= 400 && response.status != HTTP_BAD_REQUEST && response.status != HTTP_NOT_FOUND && response.status != HTTP_INTERNAL_SERVER_ERROR)
+            throw std::runtime_error(strprintf("server returned HTTP error %d", response.status));
+        else if (response.body.empty())
+            throw std::runtime_error("no response from server");
+
+        // Parse reply
+        UniValue valReply(UniValue::VSTR);
+        if (!valReply.read(response.body))
+            throw std::runtime_error("couldn't parse reply from server");
+        return valReply;
     }
 
-    event_base_dispatch(base.get());
+private:
+    const bool m_keep_alive;
+    std::string m_host;
+    uint16_t m_port;
+    raii_event_base m_base{obtain_event_base()};
+    raii_evhttp_connection m_evcon;
+    std::string m_user_colon_pass;
+    bool m_failed_to_get_auth_cookie{false};
+};
 
-    if (response.status == 0) {
-        std::string responseErrorMessage;
-        if (response.error != -1) {
-            responseErrorMessage = strprintf(" (error code %d - \"%s\")", response.error, http_errorstring(response.error));
-        }
-        throw CConnectionFailed(strprintf("Could not connect to the server %s:%d%s\n\nMake sure the peerfedd server is running and that you are connecting to the correct RPC port.", host, port, responseErrorMessage));
-    } else if (response.status == HTTP_UNAUTHORIZED) {
-        if (failedToGetAuthCookie) {
-            throw std::runtime_error(strprintf(
-                "Could not locate RPC credentials. No authentication cookie could be found, and RPC password is not set.  See -rpcpassword and -stdinrpcpass.  Configuration file: (%s)",
-                fs::PathToString(GetConfigFile(gArgs.GetPathArg("-conf", BITCOIN_CONF_FILENAME)))));
-        } else {
-            throw std::runtime_error("Authorization failed: Incorrect rpcuser or rpcpassword");
-        }
-    } else if (response.status == HTTP_SERVICE_UNAVAILABLE) {
-        throw std::runtime_error(strprintf("Server response: %s", response.body));
-    } else if (response.status >= 400 && response.status != HTTP_BAD_REQUEST && response.status != HTTP_NOT_FOUND && response.status != HTTP_INTERNAL_SERVER_ERROR)
-        throw std::runtime_error(strprintf("server returned HTTP error %d", response.status));
-    else if (response.body.empty())
-        throw std::runtime_error("no response from server");
-
-    // Parse reply
-    UniValue valReply(UniValue::VSTR);
-    if (!valReply.read(response.body))
-        throw std::runtime_error("couldn't parse reply from server");
-    const UniValue reply = rh->ProcessReply(valReply);
+static UniValue CallRPC(BaseRequestHandler* rh, const std::string& strMethod, const std::vector<std::string>& args, const std::optional<std::string>& rpcwallet = {})
+{
+    RPCConnection connection{/*keep_alive=*/false};
+    const UniValue reply = rh->ProcessReply(connection.Post(rh->PrepareRequest(strMethod, args), rpcwallet));
     if (reply.empty())
         throw std::runtime_error("expected reply to have result, error and id properties");
 
@@ -867,6 +894,95 @@ static UniValue ConnectAndCallRPC(BaseRequestHandler* rh, const std::string& str
     return response;
 }
 
+/**
+ * Split a line of -batch input into the method and its arguments. Arguments
+ * are separated by spaces or tabs, unless they are in single quotes, which keep
+ * everything literally, or in double quotes, where a backslash escapes the
+ * next character.
+ */
+static std::vector<std::string> SplitBatchCommand(const std::string& line)
+{
+    std::vector<std::string> words;
+    std::string word;
+    bool in_word{false};
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c{line[i]};
+        if (c == ' ' || c == '\t' || c == '\r') {
+            if (in_word) words.push_back(std::move(word));
+            word.clear();
+            in_word = false;
+        } else if (c == '\'' || c == '"') {
+            in_word = true;
+            for (++i; i < line.size() && line[i] != c; ++i) {
+                if (c == '"' && line[i] == '\\' && i + 1 < line.size()) ++i;
+                word += line[i];
+            }
+            if (i == line.size()) {
+                throw std::runtime_error(strprintf("unterminated quote in -batch command: %s", line));
+            }
+        } else {
+            word += c;
+            in_word = true;
+        }
+    }
+    if (in_word) words.push_back(std::move(word));
+    return words;
+}
+
+/**
+ * Send the commands on standard input in JSON-RPC batches of up to -batchsize
+ * over one connection, which the server keeps alive in between, and print a
+ * line with the result and error of each. A batch is sent once it is full,
+ * once standard input ends, or once a terminal has no further input ready.
+ *
+ * @returns 0 if all commands succeeded, or the error code of the first command that failed.
+ */
+static int BatchRPC(const std::optional<std::string>& rpcwallet)
+{
+    const int64_t batch_size{std::max<int64_t>(1, gArgs.GetIntArg("-batchsize", DEFAULT_BATCH_SIZE))};
+    const bool named{gArgs.GetBoolArg("-named", DEFAULT_NAMED)};
+    RPCConnection connection{/*keep_alive=*/true};
+    int nRet = 0;
+    bool done{false};
+    while (!done) {
+        UniValue batch(UniValue::VARR);
+        while (batch.size() < static_cast<size_t>(batch_size)) {
+            std::string line;
+            if (!batch.empty() && !StdinReady()) break;
+            if (!std::getline(std::cin, line)) {
+                done = true;
+                break;
+            }
+            std::vector<std::string> args{SplitBatchCommand(line)};
+            if (args.empty()) continue;
+            const std::string method{args[0]};
+            args.erase(args.begin());
+            const UniValue params{named ? RPCConvertNamedValues(method, args) : RPCConvertValues(method, args)};
+            batch.push_back(JSONRPCRequestObj(method, params, static_cast<int>(batch.size())));
+        }
+        if (batch.empty()) continue;
+
+        const UniValue reply{connection.Post(batch, rpcwallet)};
+        if (!reply.isArray()) {
+            // The whole batch was rejected
+            throw std::runtime_error(strprintf("batch rejected by the server: %s", reply.write()));
+        }
+        const std::vector<UniValue> replies{JSONRPCProcessBatchReply(reply)};
+        for (const UniValue& command_reply : replies) {
+            const UniValue& error{find_value(command_reply, "error")};
+            UniValue line(UniValue::VOBJ);
+            line.pushKV("result", find_value(command_reply, "result"));
+            line.pushKV("error", error);
+            tfm::format(std::cout, "%s\n", line.write());
+            if (!error.isNull() && nRet == 0) {
+                nRet = error["code"].isNum() ? abs(error["code"].getInt<int>()) : EXIT_FAILURE;
+            }
+        }
+        std::cout.flush();
+    }
+    return nRet;
+}
+
 /** Parse UniValue result to update the message to print to std::cout. */
 static void ParseResult(const UniValue& result, std::string& strPrint)
 {
@@ -1120,6 +1236,18 @@ static int CommandLineRPC(int argc, char *argv[])
             gArgs.ForceSetArg("-rpcpassword", rpcPass);
         }
         std::vector<std::string> args = std::vector<std::string>(&argv[1], &argv[argc]);
+        if (gArgs.GetBoolArg("-batch", false)) {
+            if (!args.empty()) {
+                throw std::runtime_error("-batch takes no arguments, the commands are read from standard input");
+            }
+            if (gArgs.GetBoolArg("-stdin", false) || gArgs.GetBoolArg("-stdinwalletpassphrase", false) || gArgs.IsArgSet("-getinfo") ||
+                gArgs.GetBoolArg("-netinfo", false) || gArgs.GetBoolArg("-generate", false) || gArgs.GetBoolArg("-addrinfo", false)) {
+                throw std::runtime_error("-batch can not be combined with -stdin, -stdinwalletpassphrase, -getinfo, -netinfo, -generate or -addrinfo");
+            }
+            std::optional<std::string> wallet_name{};
+            if (gArgs.IsArgSet("-rpcwallet")) wallet_name = gArgs.GetArg("-rpcwallet", "");
+            return BatchRPC(wallet_name);
+        }
         if (gArgs.GetBoolArg("-stdinwalletpassphrase", false)) {
             NO_STDIN_ECHO();
             std::string walletPass;
@@ -33,6 +33,13 @@
 
 static bool fCreateBlank;
 static std::map<std::string,UniValue> registers;
+/** Keys and previous outputs parsed from the privatekeys and prevtxs registers, reused until a register changes */
+struct SigningContext {
+    FillableSigningProvider keystore;
+    CCoinsView viewDummy;
+    CCoinsViewCache view{&viewDummy};
+};
+static std::unique_ptr<SigningContext> g_signing_context;
 static const int CONTINUE_EXECUTION=-1;
 
 const std::function<std::string(const char*)> G_TRANSLATION_FUN = nullptr;
@@ -44,6 +51,8 @@ static void SetupBitcoinTxArgs(ArgsManager &argsman)
     argsman.AddArg("-version", "Print version and exit", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-create", "Create new, empty TX.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-json", "Select JSON output", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-stream", "Read hex-encoded transactions from standard input, one per line, apply the commands to each of them and output the results one per line. "
+        "Register commands are run once, before the first transaction is read.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-txid", "Output only the hex-encoded transaction id of the resultant transaction.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     SetupChainParamsBaseOptions(argsman);
 
@@ -107,6 +116,7 @@ static int AppInitRawTx(int argc, char* argv[])
             strUsage += "\n"
                 "Usage:  peerfed-tx [options] <hex-tx> [commands]  Update hex-encoded bitcoin transaction\n"
                 "or:     peerfed-tx [options] -create [commands]   Create hex-encoded bitcoin transaction\n"
+                "or:     peerfed-tx [options] -stream [commands]   Update hex-encoded bitcoin transactions read from standard input\n"
                 "\n";
             strUsage += gArgs.GetHelpMessage();
         }
@@ -131,6 +141,7 @@ static void RegisterSetJson(const std::string& key, const std::string& rawJson)
     }
 
     registers[key] = val;
+    g_signing_context.reset();
 }
 
 static void RegisterSet(const std::string& strInput)
@@ -572,24 +583,15 @@ static CAmountType AmountTypeFromValue(const UniValue& value)
     throw std::runtime_error("Invalid amount type input");
 }
 
-static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
+/** Parse the keys and previous outputs to sign with from the privatekeys and prevtxs registers */
+static std::unique_ptr<SigningContext> MakeSigningContext()
 {
-    int nHashType = SIGHASH_ALL;
-
-    if (flagStr.size() > 0)
-        if (!findSighashFlags(nHashType, flagStr))
-            throw std::runtime_error("unknown sighash flag/sign option");
-
-    // mergedTx will end up with all the signatures; it
-    // starts as a clone of the raw tx:
-    CMutableTransaction mergedTx{tx};
-    const CMutableTransaction txv{tx};
-    CCoinsView viewDummy;
-    CCoinsViewCache view(&viewDummy);
+    auto context{std::make_unique<SigningContext>()};
+    FillableSigningProvider& tempKeystore = context->keystore;
+    CCoinsViewCache& view = context->view;
 
     if (!registers.count("privatekeys"))
         throw std::runtime_error("privatekeys register variable must be set.");
-    FillableSigningProvider tempKeystore;
     UniValue keysObj = registers["privatekeys"];
 
     for (unsigned int kidx = 0; kidx < keysObj.size(); kidx++) {
@@ -667,7 +669,24 @@ static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
         }
     }
 
-    const FillableSigningProvider& keystore = tempKeystore;
+    return context;
+}
+
+static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
+{
+    int nHashType = SIGHASH_ALL;
+
+    if (flagStr.size() > 0)
+        if (!findSighashFlags(nHashType, flagStr))
+            throw std::runtime_error("unknown sighash flag/sign option");
+
+    if (!g_signing_context) g_signing_context = MakeSigningContext();
+    const FillableSigningProvider& keystore = g_signing_context->keystore;
+    const CCoinsViewCache& view = g_signing_context->view;
+
+    // mergedTx will end up with all the signatures; it
+    // starts as a clone of the raw tx:
+    CMutableTransaction mergedTx{tx};
 
     bool fHashSingle = ((nHashType & ~SIGHASH_ANYONECANPAY) == SIGHASH_SINGLE);
 
@@ -710,6 +729,9 @@ public:
     }
 };
 
+//! Kept running while -stream processes transactions, instead of being restarted for every command that needs it
+static std::unique_ptr<Secp256k1Init> g_ecc;
+
 static void MutateTx(CMutableTransaction& tx, const std::string& command,
                      const std::string& commandVal)
 {
@@ -733,10 +755,10 @@ static void MutateTx(CMutableTransaction& tx, const std::string& command,
     else if (command == "outaddr")
         MutateTxAddOutAddr(tx, commandVal);
     else if (command == "outpubkey") {
-        ecc.reset(new Secp256k1Init());
+        if (!g_ecc) ecc.reset(new Secp256k1Init());
         MutateTxAddOutPubKey(tx, commandVal);
     } else if (command == "outmultisig") {
-        ecc.reset(new Secp256k1Init());
+        if (!g_ecc) ecc.reset(new Secp256k1Init());
         MutateTxAddOutMultiSig(tx, commandVal);
     } else if (command == "outscript")
         MutateTxAddOutScript(tx, commandVal);
@@ -744,7 +766,7 @@ static void MutateTx(CMutableTransaction& tx, const std::string& command,
         MutateTxAddOutData(tx, commandVal);
 
     else if (command == "sign") {
-        ecc.reset(new Secp256k1Init());
+        if (!g_ecc) ecc.reset(new Secp256k1Init());
         MutateTxSign(tx, commandVal);
     }
 
@@ -763,7 +785,8 @@ static void OutputTxJSON(const CTransaction& tx)
     UniValue entry(UniValue::VOBJ);
     TxToUniv(tx, /*block_hash=*/uint256(), entry);
 
-    std::string jsonOutput = entry.write(4);
+    // With -stream every transaction is output on a line of its own
+    std::string jsonOutput = entry.write(gArgs.GetBoolArg("-stream", false) ? 0 : 4);
     tfm::format(std::cout, "%s\n", jsonOutput);
 }
 
@@ -809,6 +832,55 @@ static std::string readStdin()
     return TrimString(ret);
 }
 
+static std::pair<std::string, std::string> ParseCommand(const std::string& arg)
+{
+    size_t eqpos = arg.find('=');
+    if (eqpos == std::string::npos)
+        return {arg, ""};
+    return {arg.substr(0, eqpos), arg.substr(eqpos + 1)};
+}
+
+/**
+ * Apply the commands to every hex-encoded transaction read from standard
+ * input, one per line, and output the results in the same order. The register
+ * commands are run once up front, so that the keys and previous outputs to sign
+ * with are only parsed once for all the transactions.
+ */
+static void StreamRawTx(const std::vector<std::pair<std::string, std::string>>& commands)
+{
+    std::vector<std::pair<std::string, std::string>> tx_commands;
+    for (const auto& [command, value] : commands) {
+        if (command == "load") {
+            RegisterLoad(value);
+        } else if (command == "set") {
+            RegisterSet(value);
+        } else {
+            tx_commands.emplace_back(command, value);
+        }
+    }
+
+    g_ecc = std::make_unique<Secp256k1Init>();
+    std::string line;
+    for (int line_number = 1; std::getline(std::cin, line); ++line_number) {
+        const std::string strHexTx{TrimString(line)};
+        if (strHexTx.empty()) continue;
+        try {
+            CMutableTransaction tx;
+            if (!DecodeHexTx(tx, strHexTx, true))
+                throw std::runtime_error("invalid transaction encoding");
+            for (const auto& [command, value] : tx_commands) {
+                MutateTx(tx, command, value);
+            }
+            OutputTx(CTransaction(tx));
+        } catch (const std::exception& e) {
+            throw std::runtime_error(strprintf("line %d: %s", line_number, e.what()));
+        }
+    }
+    if (std::cin.bad())
+        throw std::runtime_error("error reading stdin");
+    g_ecc.reset();
+}
+
 static int CommandLineRawTx(int argc, char* argv[])
 {
     std::string strPrint;
@@ -821,6 +893,17 @@ static int CommandLineRawTx(int argc, char* argv[])
             argv++;
         }
 
+        if (gArgs.GetBoolArg("-stream", false)) {
+            if (fCreateBlank)
+                throw std::runtime_error("-stream can not be combined with -create");
+            std::vector<std::pair<std::string, std::string>> commands;
+            for (int i = 1; i < argc; i++) {
+                commands.push_back(ParseCommand(argv[i]));
+            }
+            StreamRawTx(commands);
+            return EXIT_SUCCESS;
+        }
+
         CMutableTransaction tx;
         int startArg;
 
@@ -842,16 +925,7 @@ static int CommandLineRawTx(int argc, char* argv[])
             startArg = 1;
 
         for (int i = startArg; i < argc; i++) {
-            std::string arg = argv[i];
-            std::string key, value;
-            size_t eqpos = arg.find('=');
-            if (eqpos == std::string::npos)
-                key = arg;
-            else {
-                key = arg.substr(0, eqpos);
-                value = arg.substr(eqpos + 1);
-            }
-
+            const auto [key, value] = ParseCommand(argv[i]);
             MutateTx(tx, key, value);
         }
 
@@ -43,6 +43,10 @@ std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon)
     assert(false);
 }
 
+/** Version of the fee_estimates.dat format. Older files, which tracked a single
+ *  normalized feerate instead of separate cash and bond feerates, are ignored. */
+static constexpr int CURRENT_FEES_FILE_VERSION{150000};
+
 namespace {
 
 struct EncodedDoubleFormatter
@@ -60,6 +64,26 @@ struct EncodedDoubleFormatter
     }
 };
 
+/**
+ * Index of the lowest bucket whose upper bound is at least feerate. The
+ * buckets are spaced exponentially, so the index is guessed from the
+ * logarithm of the feerate, and only corrected for rounding. Buckets read
+ * from a file with other spacings fall back to a binary search.
+ */
+unsigned int FindBucketIndex(const std::vector<double>& buckets, double feerate)
+{
+    const unsigned int last = buckets.size() - 1;
+    if (feerate <= buckets[0]) return 0;
+    const double guess = std::log(feerate / buckets[0]) / std::log(buckets[1] / buckets[0]);
+    unsigned int index = guess >= 0 && guess < last ? static_cast<unsigned int>(guess) : last;
+    if (index < last && buckets[index] < feerate) ++index;
+    if (index > 0 && buckets[index - 1] >= feerate) --index;
+    if ((buckets[index] >= feerate || index == last) && (index == 0 || buckets[index - 1] < feerate)) {
+        return index;
+    }
+    return std::min<size_t>(std::lower_bound(buckets.begin(), buckets.end(), feerate) - buckets.begin(), last);
+}
+
 } // namespace
 
 /**
@@ -75,20 +99,25 @@ class TxConfirmStats
 private:
     //Define the buckets we will group transactions into
     const std::vector<double>& buckets;              // The upper-bound of the range for the bucket (inclusive)
-    const std::map<double, unsigned int>& bucketMap; // Map of bucket upper-bound to index into all vectors by bucket
 
     // For each bucket X:
     // Count the total # of txs in each bucket
     // Track the historical moving average of this total over blocks
     std::vector<double> txCtAvg;
 
+    // Number of periods of Y blocks tracked
+    unsigned int maxPeriods;
+
+    // The per period and bucket counters are stored flat, one period after
+    // the other, so that they can be decayed in a single pass
+
     // Count the total # of txs confirmed within Y blocks in each bucket
     // Track the historical moving average of these totals over blocks
-    std::vector<std::vector<double>> confAvg; // confAvg[Y][X]
+    std::vector<double> confAvg; // confAvg[Index(Y, X)]
 
     // Track moving avg of txs which have been evicted from the mempool
     // after failing to be confirmed within Y blocks
-    std::vector<std::vector<double>> failAvg; // failAvg[Y][X]
+    std::vector<double> failAvg; // failAvg[Index(Y, X)]
 
     // Sum the total feerate of all tx's in each bucket
     // Track the historical moving average of this total over blocks
@@ -105,12 +134,15 @@ private:
     // Mempool counts of outstanding transactions
     // For each bucket X, track the number of transactions in the mempool
     // that are unconfirmed for each possible confirmation value Y
-    std::vector<std::vector<int> > unconfTxs;  //unconfTxs[Y][X]
+    std::vector<int> unconfTxs;  //unconfTxs[Index(Y, X)]
     // transactions still unconfirmed after GetMaxConfirms for each bucket
     std::vector<int> oldUnconfTxs;
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Position of the counter of bucket X for row Y in the flat counters */
+    size_t Index(unsigned int row, unsigned int bucket) const { return size_t{row} * buckets.size() + bucket; }
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -119,7 +151,7 @@ public:
      * @param maxPeriods max number of periods to track
      * @param decay how much to decay the historical moving average per block
      */
-    TxConfirmStats(const std::vector<double>& defaultBuckets, const std::map<double, unsigned int>& defaultBucketMap,
+    TxConfirmStats(const std::vector<double>& defaultBuckets,
                    unsigned int maxPeriods, double decay, unsigned int scale);
 
     /** Roll the circular buffer for unconfirmed txs*/
@@ -158,7 +190,7 @@ public:
                              EstimationResult *result = nullptr) const;
 
     /** Return the max number of confirms we're tracking */
-    unsigned int GetMaxConfirms() const { return scale * confAvg.size(); }
+    unsigned int GetMaxConfirms() const { return scale * maxPeriods; }
 
     /** Write state of estimation data to a file*/
     void Write(AutoFile& fileout) const;
@@ -172,17 +204,12 @@ public:
 
 
 TxConfirmStats::TxConfirmStats(const std::vector<double>& defaultBuckets,
-                                const std::map<double, unsigned int>& defaultBucketMap,
-                               unsigned int maxPeriods, double _decay, unsigned int _scale)
-    : buckets(defaultBuckets), bucketMap(defaultBucketMap), decay(_decay), scale(_scale)
+                               unsigned int _maxPeriods, double _decay, unsigned int _scale)
+    : buckets(defaultBuckets), maxPeriods(_maxPeriods), decay(_decay), scale(_scale)
 {
     assert(_scale != 0 && "_scale must be non-zero");
-    confAvg.resize(maxPeriods);
-    failAvg.resize(maxPeriods);
-    for (unsigned int i = 0; i < maxPeriods; i++) {
-        confAvg[i].resize(buckets.size());
-        failAvg[i].resize(buckets.size());
-    }
+    confAvg.resize(maxPeriods * buckets.size());
+    failAvg.resize(maxPeriods * buckets.size());
 
     txCtAvg.resize(buckets.size());
     m_feerate_avg.resize(buckets.size());
@@ -192,19 +219,17 @@ TxConfirmStats::TxConfirmStats(const std::vector<double>& defaultBuckets,
 
 void TxConfirmStats::resizeInMemoryCounters(size_t newbuckets) {
     // newbuckets must be passed in because the buckets referred to during Read have not been updated yet.
-    unconfTxs.resize(GetMaxConfirms());
-    for (unsigned int i = 0; i < unconfTxs.size(); i++) {
-        unconfTxs[i].resize(newbuckets);
-    }
+    unconfTxs.resize(GetMaxConfirms() * newbuckets);
     oldUnconfTxs.resize(newbuckets);
 }
 
 // Roll the unconfirmed txs circular buffer
 void TxConfirmStats::ClearCurrent(unsigned int nBlockHeight)
 {
+    const size_t row = Index(nBlockHeight % GetMaxConfirms(), 0);
     for (unsigned int j = 0; j < buckets.size(); j++) {
-        oldUnconfTxs[j] += unconfTxs[nBlockHeight % unconfTxs.size()][j];
-        unconfTxs[nBlockHeight%unconfTxs.size()][j] = 0;
+        oldUnconfTxs[j] += unconfTxs[row + j];
+        unconfTxs[row + j] = 0;
     }
 }
 
@@ -215,9 +240,9 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
     if (blocksToConfirm < 1)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
-    unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
-    for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+    unsigned int bucketindex = FindBucketIndex(buckets, feerate);
+    for (size_t i = periodsToConfirm; i <= maxPeriods; i++) {
+        confAvg[Index(i - 1, bucketindex)]++;
     }
     txCtAvg[bucketindex]++;
     m_feerate_avg[bucketindex] += feerate;
@@ -226,14 +251,12 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
 void TxConfirmStats::UpdateMovingAverages()
 {
     assert(confAvg.size() == failAvg.size());
-    for (unsigned int j = 0; j < buckets.size(); j++) {
-        for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
-        }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
-    }
+    // Plain loops over contiguous arrays, which compilers vectorize
+    const double d = decay;
+    for (double& avg : confAvg) avg *= d;
+    for (double& avg : failAvg) avg *= d;
+    for (double& avg : m_feerate_avg) avg *= d;
+    for (double& avg : txCtAvg) avg *= d;
 }
 
 // returns -1 on error conditions
@@ -260,7 +283,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int bestFarBucket = maxbucketindex;
 
     bool foundAnswer = false;
-    unsigned int bins = unconfTxs.size();
+    unsigned int bins = GetMaxConfirms();
     bool newBucketRange = true;
     bool passing = true;
     EstimatorBucket passBucket;
@@ -273,11 +296,11 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
+        nConf += confAvg[Index(periodTarget - 1, bucket)];
         totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        failNum += failAvg[Index(periodTarget - 1, bucket)];
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
-            extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
+            extraNum += unconfTxs[Index((nBlockHeight - confct) % bins, bucket)];
         extraNum += oldUnconfTxs[bucket];
         // If we have enough transaction data points in this range of buckets,
         // we can test for success
@@ -396,16 +419,25 @@ void TxConfirmStats::Write(AutoFile& fileout) const
     fileout << scale;
     fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
     fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(txCtAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(confAvg);
-    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(failAvg);
+    // The file stores the counters of every period as a separate vector
+    std::vector<std::vector<double>> per_period(maxPeriods);
+    for (unsigned int i = 0; i < maxPeriods; i++) {
+        per_period[i].assign(confAvg.begin() + Index(i, 0), confAvg.begin() + Index(i + 1, 0));
+    }
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(per_period);
+    for (unsigned int i = 0; i < maxPeriods; i++) {
+        per_period[i].assign(failAvg.begin() + Index(i, 0), failAvg.begin() + Index(i + 1, 0));
+    }
+    fileout << Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(per_period);
 }
 
 void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
 {
     // Read data file and do some very basic sanity checking
-    // buckets and bucketMap are not updated yet, so don't access them
+    // buckets are not updated yet, so don't access them
     // If there is a read failure, we'll just discard this entire object anyway
-    size_t maxConfirms, maxPeriods;
+    size_t maxConfirms;
+    std::vector<std::vector<double>> fileConfAvg, fileFailAvg;
 
     // The current version will store the decay with each individual TxConfirmStats and also keep a scale factor
     filein >> Using<EncodedDoubleFormatter>(decay);
@@ -425,29 +457,37 @@ void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
     if (txCtAvg.size() != numBuckets) {
         throw std::runtime_error("Corrupt estimates file. Mismatch in tx count bucket count");
     }
-    filein >> Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(confAvg);
-    maxPeriods = confAvg.size();
+    filein >> Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(fileConfAvg);
+    maxPeriods = fileConfAvg.size();
     maxConfirms = scale * maxPeriods;
 
     if (maxConfirms <= 0 || maxConfirms > 6 * 24 * 7) { // one week
         throw std::runtime_error("Corrupt estimates file.  Must maintain estimates for between 1 and 1008 (one week) confirms");
     }
     for (unsigned int i = 0; i < maxPeriods; i++) {
-        if (confAvg[i].size() != numBuckets) {
+        if (fileConfAvg[i].size() != numBuckets) {
             throw std::runtime_error("Corrupt estimates file. Mismatch in feerate conf average bucket count");
         }
     }
 
-    filein >> Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(failAvg);
-    if (maxPeriods != failAvg.size()) {
+    filein >> Using<VectorFormatter<VectorFormatter<EncodedDoubleFormatter>>>(fileFailAvg);
+    if (maxPeriods != fileFailAvg.size()) {
         throw std::runtime_error("Corrupt estimates file. Mismatch in confirms tracked for failures");
     }
     for (unsigned int i = 0; i < maxPeriods; i++) {
-        if (failAvg[i].size() != numBuckets) {
+        if (fileFailAvg[i].size() != numBuckets) {
             throw std::runtime_error("Corrupt estimates file. Mismatch in one of failure average bucket counts");
         }
     }
 
+    // Flatten the counters, period after period
+    confAvg.clear();
+    failAvg.clear();
+    for (unsigned int i = 0; i < maxPeriods; i++) {
+        confAvg.insert(confAvg.end(), fileConfAvg[i].begin(), fileConfAvg[i].end());
+        failAvg.insert(failAvg.end(), fileFailAvg[i].begin(), fileFailAvg[i].end());
+    }
+
     // Resize the current block variables which aren't stored in the data file
     // to match the number of confirms and buckets
     resizeInMemoryCounters(numBuckets);
@@ -458,9 +498,9 @@ void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
 
 unsigned int TxConfirmStats::NewTx(unsigned int nBlockHeight, double val)
 {
-    unsigned int bucketindex = bucketMap.lower_bound(val)->second;
-    unsigned int blockIndex = nBlockHeight % unconfTxs.size();
-    unconfTxs[blockIndex][bucketindex]++;
+    unsigned int bucketindex = FindBucketIndex(buckets, val);
+    unsigned int blockIndex = nBlockHeight % GetMaxConfirms();
+    unconfTxs[Index(blockIndex, bucketindex)]++;
     return bucketindex;
 }
 
@@ -475,7 +515,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         return;  //This can't happen because we call this with our best seen height, no entries can have higher
     }
 
-    if (blocksAgo >= (int)unconfTxs.size()) {
+    if (blocksAgo >= (int)GetMaxConfirms()) {
         if (oldUnconfTxs[bucketindex] > 0) {
             oldUnconfTxs[bucketindex]--;
         } else {
@@ -484,9 +524,9 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         }
     }
     else {
-        unsigned int blockIndex = entryHeight % unconfTxs.size();
-        if (unconfTxs[blockIndex][bucketindex] > 0) {
-            unconfTxs[blockIndex][bucketindex]--;
+        unsigned int blockIndex = entryHeight % GetMaxConfirms();
+        if (unconfTxs[Index(blockIndex, bucketindex)] > 0) {
+            unconfTxs[Index(blockIndex, bucketindex)]--;
         } else {
             LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy error, mempool tx removed from blockIndex=%u,bucketIndex=%u already\n",
                      blockIndex, bucketindex);
@@ -495,8 +535,8 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
     if (!inBlock && (unsigned int)blocksAgo >= scale) { // Only counts as a failure if not confirmed for entire period
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
-        for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+        for (size_t i = 0; i < periodsAgo && i < maxPeriods; i++) {
+            failAvg[Index(i, bucketindex)]++;
         }
     }
 }
@@ -517,10 +557,12 @@ bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
     AssertLockHeld(m_cs_fee_estimator);
     std::map<uint256, TxStatsInfo>::iterator pos = mapMemPoolTxs.find(hash);
     if (pos != mapMemPoolTxs.end()) {
-        feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
-        shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
-        longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+        const CAmountType feeType = pos->second.feeType;
+        feeStats[feeType]->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+        shortStats[feeType]->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
+        longStats[feeType]->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         mapMemPoolTxs.erase(hash);
+        m_smart_fee_cache.clear();
         return true;
     } else {
         return false;
@@ -531,19 +573,17 @@ CBlockPolicyEstimator::CBlockPolicyEstimator(const fs::path& estimation_filepath
     : m_estimation_filepath{estimation_filepath}, nBestSeenHeight{0}, firstRecordedHeight{0}, historicalFirst{0}, historicalBest{0}, trackedTxs{0}, untrackedTxs{0}
 {
     static_assert(MIN_BUCKET_FEERATE > 0, "Min feerate must be nonzero");
-    size_t bucketIndex = 0;
 
-    for (double bucketBoundary = MIN_BUCKET_FEERATE; bucketBoundary <= MAX_BUCKET_FEERATE; bucketBoundary *= FEE_SPACING, bucketIndex++) {
+    for (double bucketBoundary = MIN_BUCKET_FEERATE; bucketBoundary <= MAX_BUCKET_FEERATE; bucketBoundary *= FEE_SPACING) {
         buckets.push_back(bucketBoundary);
-        bucketMap[bucketBoundary] = bucketIndex;
     }
     buckets.push_back(INF_FEERATE);
-    bucketMap[INF_FEERATE] = bucketIndex;
-    assert(bucketMap.size() == buckets.size());
 
-    feeStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
-    shortStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
-    longStats = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, bucketMap, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
+    for (const CAmountType feeType : {CASH, BOND}) {
+        feeStats[feeType] = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
+        shortStats[feeType] = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
+        longStats[feeType] = std::unique_ptr<TxConfirmStats>(new TxConfirmStats(buckets, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
+    }
 
     // If the fee estimation file is present, read recorded estimations
     AutoFile est_file{fsbridge::fopen(m_estimation_filepath, "rb")};
@@ -580,26 +620,41 @@ void CBlockPolicyEstimator::processTransaction(const CTxMemPoolEntry& entry, boo
         return;
     }
     trackedTxs++;
+    m_smart_fee_cache.clear();
 
-    // Feerates are stored and reported as BTC-per-kb:
-    CFeeRate feeRate(entry.GetNormalizedFee(), entry.GetTxSize());
+    // Transactions that pay their fee only in bonds are tracked in bonds. All
+    // others are tracked at their normalized fee in cash. The feerate is fixed
+    // at entry, so later changes to the conversion rate do not move the
+    // transaction to a different bucket by the time it confirms.
+    const CAmounts& fees = entry.GetFees();
+    const CAmountType feeType = fees[BOND] > 0 && fees[CASH] == 0 ? BOND : CASH;
 
-    mapMemPoolTxs[hash].blockHeight = txHeight;
-    unsigned int bucketIndex = feeStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
-    mapMemPoolTxs[hash].bucketIndex = bucketIndex;
-    unsigned int bucketIndex2 = shortStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
+    // Feerates are stored and reported as BTC-per-kb:
+    CFeeRate feeRate(feeType == BOND ? fees[BOND] : entry.GetNormalizedFee(), entry.GetTxSize());
+
+    TxStatsInfo& info = mapMemPoolTxs[hash];
+    info.blockHeight = txHeight;
+    info.feeType = feeType;
+    info.feePerK = (double)feeRate.GetFeePerK();
+    unsigned int bucketIndex = feeStats[feeType]->NewTx(txHeight, (double)feeRate.GetFeePerK());
+    info.bucketIndex = bucketIndex;
+    unsigned int bucketIndex2 = shortStats[feeType]->NewTx(txHeight, (double)feeRate.GetFeePerK());
     assert(bucketIndex == bucketIndex2);
-    unsigned int bucketIndex3 = longStats->NewTx(txHeight, (double)feeRate.GetFeePerK());
+    unsigned int bucketIndex3 = longStats[feeType]->NewTx(txHeight, (double)feeRate.GetFeePerK());
     assert(bucketIndex == bucketIndex3);
 }
 
 bool CBlockPolicyEstimator::processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry)
 {
     AssertLockHeld(m_cs_fee_estimator);
-    if (!_removeTx(entry->GetTx().GetHash(), true)) {
+    const uint256& hash = entry->GetTx().GetHash();
+    std::map<uint256, TxStatsInfo>::const_iterator pos = mapMemPoolTxs.find(hash);
+    if (pos == mapMemPoolTxs.end()) {
         // This transaction wasn't being tracked for fee estimation
         return false;
     }
+    const TxStatsInfo info = pos->second;
+    _removeTx(hash, true);
 
     // How many blocks did it take for miners to include this transaction?
     // blocksToConfirm is 1-based, so a transaction included in the earliest
@@ -612,12 +667,10 @@ bool CBlockPolicyEstimator::processBlockTx(unsigned int nBlockHeight, const CTxM
         return false;
     }
 
-    // Feerates are stored and reported as BTC-per-kb:
-    CFeeRate feeRate(entry->GetNormalizedFee(), entry->GetTxSize());
-
-    feeStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
-    shortStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
-    longStats->Record(blocksToConfirm, (double)feeRate.GetFeePerK());
+    // Record the feerate the transaction was tracked at when it entered the mempool
+    feeStats[info.feeType]->Record(blocksToConfirm, info.feePerK);
+    shortStats[info.feeType]->Record(blocksToConfirm, info.feePerK);
+    longStats[info.feeType]->Record(blocksToConfirm, info.feePerK);
     return true;
 }
 
@@ -638,16 +691,19 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
     nBestSeenHeight = nBlockHeight;
-
-    // Update unconfirmed circular buffer
-    feeStats->ClearCurrent(nBlockHeight);
-    shortStats->ClearCurrent(nBlockHeight);
-    longStats->ClearCurrent(nBlockHeight);
-
-    // Decay all exponential averages
-    feeStats->UpdateMovingAverages();
-    shortStats->UpdateMovingAverages();
-    longStats->UpdateMovingAverages();
+    m_smart_fee_cache.clear();
+
+    for (const CAmountType feeType : {CASH, BOND}) {
+        // Update unconfirmed circular buffer
+        feeStats[feeType]->ClearCurrent(nBlockHeight);
+        shortStats[feeType]->ClearCurrent(nBlockHeight);
+        longStats[feeType]->ClearCurrent(nBlockHeight);
+
+        // Decay all exponential averages
+        feeStats[feeType]->UpdateMovingAverages();
+        shortStats[feeType]->UpdateMovingAverages();
+        longStats[feeType]->UpdateMovingAverages();
+    }
 
     unsigned int countedTxs = 0;
     // Update averages with data points from current block
@@ -679,22 +735,22 @@ CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
     return estimateRawFee(confTarget, DOUBLE_SUCCESS_PCT, FeeEstimateHorizon::MED_HALFLIFE);
 }
 
-CFeeRate CBlockPolicyEstimator::estimateRawFee(int confTarget, double successThreshold, FeeEstimateHorizon horizon, EstimationResult* result) const
+CFeeRate CBlockPolicyEstimator::estimateRawFee(int confTarget, double successThreshold, FeeEstimateHorizon horizon, EstimationResult* result, CAmountType feeType) const
 {
     TxConfirmStats* stats = nullptr;
     double sufficientTxs = SUFFICIENT_FEETXS;
     switch (horizon) {
     case FeeEstimateHorizon::SHORT_HALFLIFE: {
-        stats = shortStats.get();
+        stats = shortStats[feeType].get();
         sufficientTxs = SUFFICIENT_TXS_SHORT;
         break;
     }
     case FeeEstimateHorizon::MED_HALFLIFE: {
-        stats = feeStats.get();
+        stats = feeStats[feeType].get();
         break;
     }
     case FeeEstimateHorizon::LONG_HALFLIFE: {
-        stats = longStats.get();
+        stats = longStats[feeType].get();
         break;
     }
     } // no default case, so the compiler can warn about missing cases
@@ -720,13 +776,13 @@ unsigned int CBlockPolicyEstimator::HighestTargetTracked(FeeEstimateHorizon hori
     LOCK(m_cs_fee_estimator);
     switch (horizon) {
     case FeeEstimateHorizon::SHORT_HALFLIFE: {
-        return shortStats->GetMaxConfirms();
+        return shortStats[CASH]->GetMaxConfirms();
     }
     case FeeEstimateHorizon::MED_HALFLIFE: {
-        return feeStats->GetMaxConfirms();
+        return feeStats[CASH]->GetMaxConfirms();
     }
     case FeeEstimateHorizon::LONG_HALFLIFE: {
-        return longStats->GetMaxConfirms();
+        return longStats[CASH]->GetMaxConfirms();
     }
     } // no default case, so the compiler can warn about missing cases
     assert(false);
@@ -753,39 +809,39 @@ unsigned int CBlockPolicyEstimator::HistoricalBlockSpan() const
 unsigned int CBlockPolicyEstimator::MaxUsableEstimate() const
 {
     // Block spans are divided by 2 to make sure there are enough potential failing data points for the estimate
-    return std::min(longStats->GetMaxConfirms(), std::max(BlockSpan(), HistoricalBlockSpan()) / 2);
+    return std::min(longStats[CASH]->GetMaxConfirms(), std::max(BlockSpan(), HistoricalBlockSpan()) / 2);
 }
 
 /** Return a fee estimate at the required successThreshold from the shortest
  * time horizon which tracks confirmations up to the desired target.  If
  * checkShorterHorizon is requested, also allow short time horizon estimates
  * for a lower target to reduce the given answer */
-double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result, CAmountType feeType) const
 {
     double estimate = -1;
-    if (confTarget >= 1 && confTarget <= longStats->GetMaxConfirms()) {
+    if (confTarget >= 1 && confTarget <= longStats[feeType]->GetMaxConfirms()) {
         // Find estimate from shortest time horizon possible
-        if (confTarget <= shortStats->GetMaxConfirms()) { // short horizon
-            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result);
+        if (confTarget <= shortStats[feeType]->GetMaxConfirms()) { // short horizon
+            estimate = shortStats[feeType]->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result);
         }
-        else if (confTarget <= feeStats->GetMaxConfirms()) { // medium horizon
-            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+        else if (confTarget <= feeStats[feeType]->GetMaxConfirms()) { // medium horizon
+            estimate = feeStats[feeType]->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
         }
         else { // long horizon
-            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+            estimate = longStats[feeType]->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
         }
         if (checkShorterHorizon) {
             EstimationResult tempResult;
             // If a lower confTarget from a more recent horizon returns a lower answer use it.
-            if (confTarget > feeStats->GetMaxConfirms()) {
-                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult);
+            if (confTarget > feeStats[feeType]->GetMaxConfirms()) {
+                double medMax = feeStats[feeType]->EstimateMedianVal(feeStats[feeType]->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult);
                 if (medMax > 0 && (estimate == -1 || medMax < estimate)) {
                     estimate = medMax;
                     if (result) *result = tempResult;
                 }
             }
-            if (confTarget > shortStats->GetMaxConfirms()) {
-                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult);
+            if (confTarget > shortStats[feeType]->GetMaxConfirms()) {
+                double shortMax = shortStats[feeType]->EstimateMedianVal(shortStats[feeType]->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult);
                 if (shortMax > 0 && (estimate == -1 || shortMax < estimate)) {
                     estimate = shortMax;
                     if (result) *result = tempResult;
@@ -799,15 +855,15 @@ double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, doubl
 /** Ensure that for a conservative estimate, the DOUBLE_SUCCESS_PCT is also met
  * at 2 * target for any longer time horizons.
  */
-double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result, CAmountType feeType) const
 {
     double estimate = -1;
     EstimationResult tempResult;
-    if (doubleTarget <= shortStats->GetMaxConfirms()) {
-        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result);
+    if (doubleTarget <= shortStats[feeType]->GetMaxConfirms()) {
+        estimate = feeStats[feeType]->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result);
     }
-    if (doubleTarget <= feeStats->GetMaxConfirms()) {
-        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult);
+    if (doubleTarget <= feeStats[feeType]->GetMaxConfirms()) {
+        double longEstimate = longStats[feeType]->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult);
         if (longEstimate > estimate) {
             estimate = longEstimate;
             if (result) *result = tempResult;
@@ -822,10 +878,27 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  * shortest time horizon which tracks the required target.  Conservative
  * estimates, however, required the 95% threshold at 2 * target be met for any
  * longer time horizons also.
+ *
+ * Wallets ask for the same estimates over and over, so the results are kept
+ * until the tracked transactions change.
  */
-CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, CAmountType feeType) const
 {
     LOCK(m_cs_fee_estimator);
+    const auto key = std::make_tuple(confTarget, conservative, feeType);
+    auto it = m_smart_fee_cache.find(key);
+    if (it == m_smart_fee_cache.end()) {
+        SmartFeeResult result;
+        result.feerate = _estimateSmartFee(confTarget, &result.calc, conservative, feeType);
+        it = m_smart_fee_cache.emplace(key, result).first;
+    }
+    if (feeCalc) *feeCalc = it->second.calc;
+    return it->second.feerate;
+}
+
+CFeeRate CBlockPolicyEstimator::_estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, CAmountType feeType) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
 
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
@@ -836,7 +909,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     EstimationResult tempResult;
 
     // Return failure if trying to analyze a target we're not tracking
-    if (confTarget <= 0 || (unsigned int)confTarget > longStats->GetMaxConfirms()) {
+    if (confTarget <= 0 || (unsigned int)confTarget > longStats[feeType]->GetMaxConfirms()) {
         return CFeeRate(0);  // error condition
     }
 
@@ -862,13 +935,13 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
      * the purpose of conservative estimates is not to let short term
      * fluctuations lower our estimates by too much.
      */
-    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
+    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult, feeType);
     if (feeCalc) {
         feeCalc->est = tempResult;
         feeCalc->reason = FeeReason::HALF_ESTIMATE;
     }
     median = halfEst;
-    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult);
+    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult, feeType);
     if (actualEst > median) {
         median = actualEst;
         if (feeCalc) {
@@ -876,7 +949,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
             feeCalc->reason = FeeReason::FULL_ESTIMATE;
         }
     }
-    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
+    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult, feeType);
     if (doubleEst > median) {
         median = doubleEst;
         if (feeCalc) {
@@ -886,7 +959,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     }
 
     if (conservative || median == -1) {
-        double consEst =  estimateConservativeFee(2 * confTarget, &tempResult);
+        double consEst =  estimateConservativeFee(2 * confTarget, &tempResult, feeType);
         if (consEst > median) {
             median = consEst;
             if (feeCalc) {
@@ -914,7 +987,7 @@ bool CBlockPolicyEstimator::Write(AutoFile& fileout) const
 {
     try {
         LOCK(m_cs_fee_estimator);
-        fileout << 149900; // version required to read: 0.14.99 or later
+        fileout << CURRENT_FEES_FILE_VERSION; // version required to read
         fileout << CLIENT_VERSION; // version that wrote the file
         fileout << nBestSeenHeight;
         if (BlockSpan() > HistoricalBlockSpan()/2) {
@@ -924,9 +997,11 @@ bool CBlockPolicyEstimator::Write(AutoFile& fileout) const
             fileout << historicalFirst << historicalBest;
         }
         fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(buckets);
-        feeStats->Write(fileout);
-        shortStats->Write(fileout);
-        longStats->Write(fileout);
+        for (const CAmountType feeType : {CASH, BOND}) {
+            feeStats[feeType]->Write(fileout);
+            shortStats[feeType]->Write(fileout);
+            longStats[feeType]->Write(fileout);
+        }
     }
     catch (const std::exception&) {
         LogPrintf("CBlockPolicyEstimator::Write(): unable to write policy estimator data (non-fatal)\n");
@@ -941,7 +1016,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
         LOCK(m_cs_fee_estimator);
         int nVersionRequired, nVersionThatWrote;
         filein >> nVersionRequired >> nVersionThatWrote;
-        if (nVersionRequired > CLIENT_VERSION) {
+        if (nVersionRequired > CURRENT_FEES_FILE_VERSION) {
             throw std::runtime_error(strprintf("up-version (%d) fee estimate file", nVersionRequired));
         }
 
@@ -950,9 +1025,9 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
         unsigned int nFileBestSeenHeight;
         filein >> nFileBestSeenHeight;
 
-        if (nVersionRequired < 149900) {
+        if (nVersionRequired < CURRENT_FEES_FILE_VERSION) {
             LogPrintf("%s: incompatible old fee estimation data (non-fatal). Version: %d\n", __func__, nVersionRequired);
-        } else { // New format introduced in 149900
+        } else { // Separate cash and bond stats introduced in CURRENT_FEES_FILE_VERSION
             unsigned int nFileHistoricalFirst, nFileHistoricalBest;
             filein >> nFileHistoricalFirst >> nFileHistoricalBest;
             if (nFileHistoricalFirst > nFileHistoricalBest || nFileHistoricalBest > nFileBestSeenHeight) {
@@ -965,22 +1040,21 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
                 throw std::runtime_error("Corrupt estimates file. Must have between 2 and 1000 feerate buckets");
             }
 
-            std::unique_ptr<TxConfirmStats> fileFeeStats(new TxConfirmStats(buckets, bucketMap, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
-            std::unique_ptr<TxConfirmStats> fileShortStats(new TxConfirmStats(buckets, bucketMap, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
-            std::unique_ptr<TxConfirmStats> fileLongStats(new TxConfirmStats(buckets, bucketMap, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
-            fileFeeStats->Read(filein, nVersionThatWrote, numBuckets);
-            fileShortStats->Read(filein, nVersionThatWrote, numBuckets);
-            fileLongStats->Read(filein, nVersionThatWrote, numBuckets);
+            std::array<std::unique_ptr<TxConfirmStats>, 2> fileFeeStats, fileShortStats, fileLongStats;
+            for (const CAmountType feeType : {CASH, BOND}) {
+                fileFeeStats[feeType].reset(new TxConfirmStats(buckets, MED_BLOCK_PERIODS, MED_DECAY, MED_SCALE));
+                fileShortStats[feeType].reset(new TxConfirmStats(buckets, SHORT_BLOCK_PERIODS, SHORT_DECAY, SHORT_SCALE));
+                fileLongStats[feeType].reset(new TxConfirmStats(buckets, LONG_BLOCK_PERIODS, LONG_DECAY, LONG_SCALE));
+                fileFeeStats[feeType]->Read(filein, nVersionThatWrote, numBuckets);
+                fileShortStats[feeType]->Read(filein, nVersionThatWrote, numBuckets);
+                fileLongStats[feeType]->Read(filein, nVersionThatWrote, numBuckets);
+            }
 
             // Fee estimates file parsed correctly
-            // Copy buckets from file and refresh our bucketmap
+            // Copy buckets from file
             buckets = fileBuckets;
-            bucketMap.clear();
-            for (unsigned int i = 0; i < buckets.size(); i++) {
-                bucketMap[buckets[i]] = i;
-            }
 
-            // Destroy old TxConfirmStats and point to new ones that already reference buckets and bucketMap
+            // Destroy old TxConfirmStats and point to new ones that already reference buckets
             feeStats = std::move(fileFeeStats);
             shortStats = std::move(fileShortStats);
             longStats = std::move(fileLongStats);
@@ -988,6 +1062,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            m_smart_fee_cache.clear();
         }
     }
     catch (const std::exception& e) {
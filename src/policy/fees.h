@@ -18,6 +18,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
 class AutoFile;
@@ -128,6 +129,10 @@ struct FeeCalculation
  *  We want to be able to estimate feerates that are needed on tx's to be included in
  * a certain number of blocks.  Every time a block is added to the best chain, this class records
  * stats on the transactions included in that block
+ *
+ * Transactions that pay their fee only in bonds are tracked in separate data sets
+ * at their bond feerate, and all other transactions at their normalized cash feerate,
+ * so that estimates in either currency do not drift as the conversion rate moves.
  */
 class CBlockPolicyEstimator
 {
@@ -199,16 +204,16 @@ public:
     bool removeTx(uint256 hash, bool inBlock)
         EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
 
-    /** DEPRECATED. Return a feerate estimate */
+    /** DEPRECATED. Return a cash feerate estimate */
     CFeeRate estimateFee(int confTarget) const
         EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
 
     /** Estimate feerate needed to get be included in a block within confTarget
      *  blocks. If no answer can be given at confTarget, return an estimate at
      *  the closest target where one can be given.  'conservative' estimates are
-     *  valid over longer time horizons also.
+     *  valid over longer time horizons also. The estimate is in units of feeType.
      */
-    CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+    CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, CAmountType feeType = CASH) const
         EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
 
     /** Return a specific fee estimate calculation with a given success
@@ -216,7 +221,7 @@ public:
      * calculation
      */
     CFeeRate estimateRawFee(int confTarget, double successThreshold, FeeEstimateHorizon horizon,
-                            EstimationResult* result = nullptr) const
+                            EstimationResult* result = nullptr, CAmountType feeType = CASH) const
         EXCLUSIVE_LOCKS_REQUIRED(!m_cs_fee_estimator);
 
     /** Write estimation data to a file */
@@ -251,30 +256,41 @@ private:
     {
         unsigned int blockHeight;
         unsigned int bucketIndex;
-        TxStatsInfo() : blockHeight(0), bucketIndex(0) {}
+        CAmountType feeType; //!< Currency data set the transaction is tracked in
+        double feePerK;      //!< Feerate in feeType at the time the transaction entered the mempool
+        TxStatsInfo() : blockHeight(0), bucketIndex(0), feeType(CASH), feePerK(0) {}
     };
 
     // map of txids to information about that transaction
     std::map<uint256, TxStatsInfo> mapMemPoolTxs GUARDED_BY(m_cs_fee_estimator);
 
-    /** Classes to track historical data on transaction confirmations */
-    std::unique_ptr<TxConfirmStats> feeStats PT_GUARDED_BY(m_cs_fee_estimator);
-    std::unique_ptr<TxConfirmStats> shortStats PT_GUARDED_BY(m_cs_fee_estimator);
-    std::unique_ptr<TxConfirmStats> longStats PT_GUARDED_BY(m_cs_fee_estimator);
+    /** Classes to track historical data on transaction confirmations, indexed by fee currency */
+    std::array<std::unique_ptr<TxConfirmStats>, 2> feeStats GUARDED_BY(m_cs_fee_estimator);
+    std::array<std::unique_ptr<TxConfirmStats>, 2> shortStats GUARDED_BY(m_cs_fee_estimator);
+    std::array<std::unique_ptr<TxConfirmStats>, 2> longStats GUARDED_BY(m_cs_fee_estimator);
 
     unsigned int trackedTxs GUARDED_BY(m_cs_fee_estimator);
     unsigned int untrackedTxs GUARDED_BY(m_cs_fee_estimator);
 
     std::vector<double> buckets GUARDED_BY(m_cs_fee_estimator); // The upper-bound of the range for the bucket (inclusive)
-    std::map<double, unsigned int> bucketMap GUARDED_BY(m_cs_fee_estimator); // Map of bucket upper-bound to index into all vectors by bucket
+
+    struct SmartFeeResult
+    {
+        CFeeRate feerate;
+        FeeCalculation calc;
+    };
+    //! Results of estimateSmartFee by target, conservative and fee type, cleared whenever the tracked data changes
+    mutable std::map<std::tuple<int, bool, CAmountType>, SmartFeeResult> m_smart_fee_cache GUARDED_BY(m_cs_fee_estimator);
 
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** estimateSmartFee without the cache */
+    CFeeRate _estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, CAmountType feeType) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
-    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result, CAmountType feeType) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
-    double estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    double estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result, CAmountType feeType) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Number of blocks of data recorded while fee estimates have been running */
     unsigned int BlockSpan() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Number of blocks of recorded fee estimate data represented in saved data file */
@@ -14,6 +14,7 @@
 #include <util/moneystr.h>
 #include <util/rbf.h>
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -82,7 +83,12 @@ std::optional<std::string> GetEntriesForConflicts(const CTransaction& tx,
     for (CTxMemPool::txiter it : iters_conflicting) {
         pool.CalculateDescendants(it, all_conflicts);
     }
-    // Calculate the set of all valid transaction descendants, excluding invalid conversions and their descendants
+    // Calculate the set of all valid transaction descendants, excluding invalid conversions and their descendants.
+    // Usually none of them is an invalid conversion, and they are all valid without walking them again.
+    if (std::none_of(all_conflicts.begin(), all_conflicts.end(), filter_invalid_conversion)) {
+        all_valid_conflicts.insert(all_conflicts.begin(), all_conflicts.end());
+        return std::nullopt;
+    }
     for (CTxMemPool::txiter it : iters_conflicting) {
         pool.CalculateDescendants(it, all_valid_conflicts, filter_invalid_conversion);
     }
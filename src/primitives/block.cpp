@@ -5,27 +5,57 @@
 
 #include <primitives/block.h>
 
-#include <crypto/blake3.h>
+#include <crypto/blake3_header.h>
+#include <crypto/common.h>
 #include <streams.h>
 #include <tinyformat.h>
 #include <version.h>
 
-uint256 CBlockHeader::GetHash() const
+#include <string.h>
+#include <vector>
+
+void CBlockHeader::SerializeToBuffer(unsigned char* out) const
 {
-    // Initialize a blake3_hasher in the default hashing mode.
-    blake3_hasher hasher;
-    blake3_hasher_init(&hasher);
+    // Equivalent to network serialization, without going through a stream
+    WriteLE32(out, static_cast<uint32_t>(nVersion));
+    memcpy(out + 4, hashPrevBlock.begin(), 32);
+    memcpy(out + 36, hashMerkleRoot.begin(), 32);
+    WriteLE32(out + 68, nTime);
+    WriteLE32(out + 72, nBits);
+    WriteLE64(out + 76, static_cast<uint64_t>(cashSupply));
+    WriteLE64(out + 84, static_cast<uint64_t>(bondSupply));
+    WriteLE32(out + 92, nNonce);
+}
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << *this;
-    blake3_hasher_update(&hasher, (unsigned char*)&ss[0], ss.size());
+static_assert(CBlockHeader::SERIALIZED_SIZE == CBlake3HeaderHasher::HEADER_SIZE);
+
+uint256 CBlockHeader::GetHash() const
+{
+    unsigned char header[SERIALIZED_SIZE];
+    SerializeToBuffer(header);
 
-    // Finalize the hash. BLAKE3_OUT_LEN is the default output length, 32 bytes.
     uint256 hash;
-    blake3_hasher_finalize(&hasher, (unsigned char*)&hash, BLAKE3_OUT_LEN);
+    CBlake3HeaderHasher::Hash(header, hash.begin());
     return hash;
 }
 
+std::vector<uint256> GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers)
+{
+    std::vector<unsigned char> serialized(headers.size() * CBlockHeader::SERIALIZED_SIZE);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i].SerializeToBuffer(serialized.data() + i * CBlockHeader::SERIALIZED_SIZE);
+    }
+
+    std::vector<unsigned char> output(headers.size() * CBlake3HeaderHasher::OUTPUT_SIZE);
+    CBlake3HeaderHasher::HashMany(serialized.data(), headers.size(), output.data());
+
+    std::vector<uint256> hashes(headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        memcpy(hashes[i].begin(), output.data() + i * CBlake3HeaderHasher::OUTPUT_SIZE, CBlake3HeaderHasher::OUTPUT_SIZE);
+    }
+    return hashes;
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
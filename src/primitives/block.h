@@ -11,6 +11,8 @@
 #include <uint256.h>
 #include <util/time.h>
 
+#include <optional>
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -21,6 +23,9 @@
 class CBlockHeader
 {
 public:
+    /** Size of a serialized header */
+    static constexpr size_t SERIALIZED_SIZE = 96;
+
     // header
     int32_t nVersion;
     uint256 hashPrevBlock;
@@ -55,6 +60,9 @@ public:
         return (nBits == 0);
     }
 
+    /** Serialize the header into a buffer of SERIALIZED_SIZE bytes */
+    void SerializeToBuffer(unsigned char* out) const;
+
     uint256 GetHash() const;
 
     NodeSeconds Time() const
@@ -68,6 +76,26 @@ public:
     }
 };
 
+/** Compute the hashes of several headers at once, which is faster than hashing them one by one. */
+std::vector<uint256> GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers);
+
+/** Formatter for a block's transactions, which hashes them all at once when reading. */
+struct BlockTransactionsFormatter
+{
+    template <typename Stream>
+    void Ser(Stream& s, const std::vector<CTransactionRef>& vtx)
+    {
+        s << vtx;
+    }
+
+    template <typename Stream>
+    void Unser(Stream& s, std::vector<CTransactionRef>& vtx)
+    {
+        std::vector<CMutableTransaction> txs;
+        s >> txs;
+        vtx = MakeTransactionRefs(std::move(txs));
+    }
+};
 
 class CBlock : public CBlockHeader
 {
@@ -77,6 +105,8 @@ public:
 
     // memory only
     mutable bool fChecked;
+    //! Witness merkle root, if it was computed ahead of ContextualCheckBlock() by a block check worker thread
+    mutable std::optional<uint256> m_witness_merkle_root;
 
     CBlock()
     {
@@ -92,7 +122,7 @@ public:
     SERIALIZE_METHODS(CBlock, obj)
     {
         READWRITEAS(CBlockHeader, obj);
-        READWRITE(obj.vtx);
+        READWRITE(Using<BlockTransactionsFormatter>(obj.vtx));
     }
 
     void SetNull()
@@ -100,6 +130,7 @@ public:
         CBlockHeader::SetNull();
         vtx.clear();
         fChecked = false;
+        m_witness_merkle_root.reset();
     }
 
     CBlockHeader GetBlockHeader() const
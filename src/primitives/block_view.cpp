@@ -0,0 +1,127 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/block_view.h>
+
+#include <consensus/consensus.h>
+#include <hash.h>
+
+#include <ios>
+
+namespace {
+//! Size of the version, and of the marker and flag preceding the inputs in the extended format
+constexpr size_t TX_VERSION_SIZE{4};
+constexpr size_t TX_MARKER_AND_FLAG_SIZE{2};
+constexpr size_t TX_LOCK_TIME_SIZE{4};
+} // namespace
+
+Span<const unsigned char> TransactionView::ReadScript(SpanReader& s)
+{
+    return s.ReadSpan(ReadCompactSize(s));
+}
+
+TransactionView::TransactionView(Span<const unsigned char> data)
+{
+    // Walks the serialization like UnserializeTransaction() does, recording where its parts start
+    SpanReader s{SER_NETWORK, PROTOCOL_VERSION, data};
+    const auto pos{[&] { return data.size() - s.size(); }};
+    const auto skip_inputs{[&] {
+        m_inputs_pos = pos();
+        m_coinbase = false;
+        for (size_t i = 0; i < m_num_inputs; ++i) {
+            COutPoint prevout;
+            s >> prevout;
+            if (i == 0) m_coinbase = m_num_inputs == 1 && prevout.IsNull();
+            ReadScript(s);
+            s.ignore(sizeof(uint32_t));
+        }
+    }};
+    const auto skip_outputs{[&] {
+        m_outputs_pos = pos();
+        for (size_t i = 0; i < m_num_outputs; ++i) {
+            s.ignore(sizeof(CAmountType) + sizeof(CAmount));
+            ReadScript(s);
+        }
+    }};
+
+    s >> m_version;
+    m_num_inputs = ReadCompactSize(s);
+    skip_inputs();
+    m_num_outputs = 0;
+    unsigned char flags{0};
+    if (m_num_inputs == 0) {
+        // A dummy or an empty vin
+        s >> flags;
+        if (flags != 0) {
+            m_num_inputs = ReadCompactSize(s);
+            skip_inputs();
+            m_num_outputs = ReadCompactSize(s);
+        }
+    } else {
+        m_num_outputs = ReadCompactSize(s);
+    }
+    skip_outputs();
+    m_witness_pos = pos();
+    m_has_witness = false;
+    if (flags & 1) {
+        flags ^= 1;
+        for (size_t i = 0; i < m_num_inputs; ++i) {
+            const uint64_t num_items{ReadCompactSize(s)};
+            if (num_items > 0) m_has_witness = true;
+            for (uint64_t j = 0; j < num_items; ++j) {
+                ReadScript(s);
+            }
+        }
+        if (!m_has_witness) {
+            throw std::ios_base::failure("Superfluous witness record");
+        }
+    }
+    if (flags) {
+        throw std::ios_base::failure("Unknown transaction optional data");
+    }
+    s >> m_lock_time;
+    m_data = data.first(pos());
+}
+
+size_t TransactionView::GetStrippedSize() const
+{
+    if (!m_has_witness) return m_data.size();
+    return m_witness_pos - TX_MARKER_AND_FLAG_SIZE + TX_LOCK_TIME_SIZE;
+}
+
+int64_t TransactionView::GetWeight() const
+{
+    return GetStrippedSize() * (WITNESS_SCALE_FACTOR - 1) + GetTotalSize();
+}
+
+uint256 TransactionView::GetHash() const
+{
+    HashWriter hasher{};
+    if (!m_has_witness) {
+        hasher.write(AsBytes(m_data));
+    } else {
+        // The serialization without the marker, flag and witnesses
+        const size_t inputs_start{TX_VERSION_SIZE + TX_MARKER_AND_FLAG_SIZE};
+        hasher.write(AsBytes(m_data.first(TX_VERSION_SIZE)));
+        hasher.write(AsBytes(m_data.subspan(inputs_start, m_witness_pos - inputs_start)));
+        hasher.write(AsBytes(m_data.last(TX_LOCK_TIME_SIZE)));
+    }
+    return hasher.GetHash();
+}
+
+uint256 TransactionView::GetWitnessHash() const
+{
+    if (!m_has_witness) return GetHash();
+    HashWriter hasher{};
+    hasher.write(AsBytes(m_data));
+    return hasher.GetHash();
+}
+
+BlockView::BlockView(Span<const unsigned char> data)
+{
+    SpanReader s{SER_NETWORK, PROTOCOL_VERSION, data};
+    s >> m_header;
+    m_num_txs = ReadCompactSize(s);
+    m_txs = s.ReadSpan(s.size());
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PRIMITIVES_BLOCK_VIEW_H
+#define BITCOIN_PRIMITIVES_BLOCK_VIEW_H
+
+#include <consensus/amount.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <span.h>
+#include <streams.h>
+#include <uint256.h>
+#include <version.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/** A transaction input read from its serialization, see TransactionView */
+struct TxInView {
+    COutPoint prevout;
+    Span<const unsigned char> scriptSig;
+    uint32_t nSequence;
+};
+
+/** A transaction output read from its serialization, see TransactionView */
+struct TxOutView {
+    CAmountType amountType;
+    CAmount nValue;
+    Span<const unsigned char> scriptPubKey;
+
+    /** Same as CScript::IsConversionScript() */
+    bool IsConversionScript() const { return scriptPubKey.size() >= 3 && scriptPubKey[0] == OP_CONVERT; }
+    /** Same as CScript::IsUnspendable() */
+    bool IsUnspendable() const { return (!scriptPubKey.empty() && scriptPubKey[0] == OP_RETURN) || scriptPubKey.size() > MAX_SCRIPT_SIZE; }
+    /** Size of the serialized output */
+    size_t GetSerializeSize() const { return 1 + 8 + GetSizeOfCompactSize(scriptPubKey.size()) + scriptPubKey.size(); }
+};
+
+/**
+ * A read-only view of a serialized transaction, for callers that only read a
+ * few of its fields. Fields are read from the serialization when accessed, and
+ * scripts and witness items are spans into it, so nothing is allocated. The
+ * serialized data must outlive the view.
+ */
+class TransactionView
+{
+    //! The serialized transaction
+    Span<const unsigned char> m_data;
+    int32_t m_version;
+    uint32_t m_lock_time;
+    bool m_coinbase;
+    size_t m_num_inputs;
+    size_t m_num_outputs;
+    //! Offsets of the first input and first output in m_data, after their counts
+    size_t m_inputs_pos;
+    size_t m_outputs_pos;
+    //! Offset of the witnesses in m_data, which is where the outputs end
+    size_t m_witness_pos;
+    bool m_has_witness;
+
+public:
+    /**
+     * Parse the transaction at the start of data, which may continue after it, checking it
+     * the same way as deserializing a CTransaction. Throws std::ios_base::failure if
+     * it is malformed.
+     */
+    explicit TransactionView(Span<const unsigned char> data);
+
+    int32_t GetVersion() const { return m_version; }
+    uint32_t GetLockTime() const { return m_lock_time; }
+    size_t GetInputCount() const { return m_num_inputs; }
+    size_t GetOutputCount() const { return m_num_outputs; }
+    bool IsCoinBase() const { return m_coinbase; }
+    bool HasWitness() const { return m_has_witness; }
+
+    /** The serialized transaction, including witnesses */
+    Span<const unsigned char> GetSerialization() const { return m_data; }
+    size_t GetTotalSize() const { return m_data.size(); }
+    size_t GetStrippedSize() const;
+    /** Same as CTransaction::GetWeight(), without the weight of a conversion's remainder output */
+    int64_t GetWeight() const;
+    uint256 GetHash() const;
+    uint256 GetWitnessHash() const;
+
+    /** Call fn with a TxInView of every input, in order */
+    template <typename Fn>
+    void ForEachInput(Fn&& fn) const
+    {
+        SpanReader s{SER_NETWORK, PROTOCOL_VERSION, m_data.subspan(m_inputs_pos)};
+        for (size_t i = 0; i < m_num_inputs; ++i) {
+            TxInView in;
+            s >> in.prevout;
+            in.scriptSig = ReadScript(s);
+            s >> in.nSequence;
+            fn(in);
+        }
+    }
+
+    /** Call fn with a TxOutView of every output, in order */
+    template <typename Fn>
+    void ForEachOutput(Fn&& fn) const
+    {
+        SpanReader s{SER_NETWORK, PROTOCOL_VERSION, m_data.subspan(m_outputs_pos)};
+        for (size_t i = 0; i < m_num_outputs; ++i) {
+            TxOutView out;
+            s >> out.amountType >> out.nValue;
+            out.scriptPubKey = ReadScript(s);
+            fn(out);
+        }
+    }
+
+    /** Call fn with the index of the input and the item, for every witness stack item in order */
+    template <typename Fn>
+    void ForEachWitnessItem(Fn&& fn) const
+    {
+        if (!m_has_witness) return;
+        SpanReader s{SER_NETWORK, PROTOCOL_VERSION, m_data.subspan(m_witness_pos)};
+        for (size_t i = 0; i < m_num_inputs; ++i) {
+            const uint64_t num_items{ReadCompactSize(s)};
+            for (uint64_t j = 0; j < num_items; ++j) {
+                fn(i, ReadScript(s));
+            }
+        }
+    }
+
+private:
+    /** Read a CompactSize prefixed byte vector as a span into the data s reads */
+    static Span<const unsigned char> ReadScript(SpanReader& s);
+};
+
+/**
+ * A read-only view of a serialized block, whose transactions are parsed into
+ * TransactionViews as they are walked. The serialized data must outlive the view.
+ */
+class BlockView
+{
+    CBlockHeader m_header;
+    size_t m_num_txs;
+    //! The serialized transactions, after their count
+    Span<const unsigned char> m_txs;
+
+public:
+    /** Parse the header and transaction count of a block. Throws std::ios_base::failure if they are malformed. */
+    explicit BlockView(Span<const unsigned char> data);
+
+    const CBlockHeader& GetHeader() const { return m_header; }
+    size_t GetTransactionCount() const { return m_num_txs; }
+
+    /** Call fn with a TransactionView of every transaction, in order. Throws std::ios_base::failure for malformed transactions. */
+    template <typename Fn>
+    void ForEachTransaction(Fn&& fn) const
+    {
+        Span<const unsigned char> txs{m_txs};
+        for (size_t i = 0; i < m_num_txs; ++i) {
+            const TransactionView tx{txs};
+            txs = txs.subspan(tx.GetTotalSize());
+            fn(tx);
+        }
+    }
+};
+
+#endif // BITCOIN_PRIMITIVES_BLOCK_VIEW_H
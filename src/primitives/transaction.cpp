@@ -6,9 +6,12 @@
 #include <primitives/transaction.h>
 
 #include <consensus/amount.h>
+#include <consensus/consensus.h>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <uint256.h>
 #include <util/strencodings.h>
@@ -90,8 +93,72 @@ uint256 CTransaction::ComputeWitnessHash() const
     return SerializeHash(*this, SER_GETHASH, 0);
 }
 
-CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
-CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
+unsigned int CTransaction::ComputeStrippedSize() const
+{
+    return ::GetSerializeSize(*this, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS);
+}
+
+unsigned int CTransaction::ComputeTotalSize() const
+{
+    if (!HasWitness()) {
+        return m_stripped_size;
+    }
+    return ::GetSerializeSize(*this, PROTOCOL_VERSION);
+}
+
+CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()}, m_stripped_size{ComputeStrippedSize()}, m_total_size{ComputeTotalSize()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()}, m_stripped_size{ComputeStrippedSize()}, m_total_size{ComputeTotalSize()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx, const uint256& hash_in, const uint256& witness_hash_in, unsigned int stripped_size_in, unsigned int total_size_in) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{hash_in}, m_witness_hash{witness_hash_in}, m_stripped_size{stripped_size_in}, m_total_size{total_size_in} {}
+
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs)
+{
+    if (txs.empty()) return {};
+
+    // Serialize all transactions, without and (if they have one) with their
+    // witness, into one buffer that is reused by the next call on this thread.
+    // The serialized lengths are the transactions' sizes.
+    static thread_local std::vector<unsigned char> buffer;
+    buffer.clear();
+    std::vector<size_t> ends;
+    ends.reserve(txs.size() * 2);
+    for (const CMutableTransaction& tx : txs) {
+        CVectorWriter{SER_GETHASH, SERIALIZE_TRANSACTION_NO_WITNESS, buffer, buffer.size(), tx};
+        ends.push_back(buffer.size());
+        if (tx.HasWitness()) {
+            CVectorWriter{SER_GETHASH, 0, buffer, buffer.size(), tx};
+            ends.push_back(buffer.size());
+        }
+    }
+
+    std::vector<const unsigned char*> inputs(ends.size());
+    std::vector<size_t> lengths(ends.size());
+    for (size_t i = 0; i < ends.size(); ++i) {
+        const size_t begin{i == 0 ? 0 : ends[i - 1]};
+        inputs[i] = buffer.data() + begin;
+        lengths[i] = ends[i] - begin;
+    }
+    std::vector<uint256> hashes(ends.size());
+    SHA256DMulti(hashes.data()->begin(), inputs.data(), lengths.data(), ends.size());
+
+    std::vector<CTransactionRef> refs;
+    refs.reserve(txs.size());
+    size_t pos{0};
+    for (CMutableTransaction& tx : txs) {
+        const bool has_witness{tx.HasWitness()};
+        const uint256& hash{hashes[pos]};
+        const uint256& witness_hash{has_witness ? hashes[pos + 1] : hash};
+        const unsigned int stripped_size(lengths[pos]);
+        const unsigned int total_size(lengths[has_witness ? pos + 1 : pos]);
+        refs.push_back(std::make_shared<const CTransaction>(std::move(tx), hash, witness_hash, stripped_size, total_size));
+        pos += has_witness ? 2 : 1;
+    }
+
+    // Don't keep more than a block's worth of memory on every thread that ever saw a large batch
+    if (buffer.capacity() > MAX_BLOCK_SERIALIZED_SIZE) {
+        std::vector<unsigned char>().swap(buffer);
+    }
+    return refs;
+}
 
 CAmounts CTransaction::GetValuesOut() const
 {
@@ -106,11 +173,6 @@ CAmounts CTransaction::GetValuesOut() const
     return nValuesOut;
 }
 
-unsigned int CTransaction::GetTotalSize() const
-{
-    return ::GetSerializeSize(*this, PROTOCOL_VERSION);
-}
-
 bool CTransaction::IsConversion() const
 {
     return CTransaction::GetConversionOutput().has_value() && !CTransaction::IsCoinBase();
@@ -7,6 +7,7 @@
 #define BITCOIN_PRIMITIVES_TRANSACTION_H
 
 #include <consensus/amount.h>
+#include <consensus/consensus.h>
 #include <prevector.h>
 #include <script/script.h>
 #include <serialize.h>
@@ -158,9 +159,12 @@ public:
 class CTxOut
 {
 public:
-    CAmountType amountType;
+    // amountType is laid out last, so it takes no padding of its own, and whatever follows an
+    // output in a struct can use the rest of its tail padding (see Coin). The serialization
+    // order does not follow the layout.
     CAmount nValue;
     CScript scriptPubKey;
+    CAmountType amountType;
 
     CTxOut()
     {
@@ -311,14 +315,21 @@ private:
     /** Memory only. */
     const uint256 hash;
     const uint256 m_witness_hash;
+    const unsigned int m_stripped_size;
+    const unsigned int m_total_size;
 
     uint256 ComputeHash() const;
     uint256 ComputeWitnessHash() const;
+    unsigned int ComputeStrippedSize() const;
+    unsigned int ComputeTotalSize() const;
 
 public:
     /** Convert a CMutableTransaction into a CTransaction. */
     explicit CTransaction(const CMutableTransaction& tx);
     explicit CTransaction(CMutableTransaction&& tx);
+    /** Convert a CMutableTransaction whose hashes and sizes were already
+     *  computed, see MakeTransactionRefs. */
+    CTransaction(CMutableTransaction&& tx, const uint256& hash_in, const uint256& witness_hash_in, unsigned int stripped_size_in, unsigned int total_size_in);
 
     template <typename Stream>
     inline void Serialize(Stream& s) const {
@@ -326,7 +337,11 @@ public:
     }
 
     /** This deserializing constructor is provided instead of an Unserialize method.
-     *  Unserialize is not possible, since it would require overwriting const fields. */
+     *  Unserialize is not possible, since it would require overwriting const fields.
+     *  The inputs, outputs, scripts and witnesses are allocated separately rather than
+     *  from an arena of the block being read: a CTransactionRef may outlive its block
+     *  (in the mempool, orphanage, compact block relay or validation interface queue),
+     *  so the block can't free their memory in one piece. */
     template <typename Stream>
     CTransaction(deserialize_type, Stream& s) : CTransaction(CMutableTransaction(deserialize, s)) {}
 
@@ -345,7 +360,20 @@ public:
      * "Total Size" defined in BIP141 and BIP144.
      * @return Total transaction size in bytes
      */
-    unsigned int GetTotalSize() const;
+    unsigned int GetTotalSize() const { return m_total_size; }
+
+    /**
+     * Get the transaction size in bytes without witness data.
+     * "Base Size" defined in BIP141.
+     */
+    unsigned int GetStrippedSize() const { return m_stripped_size; }
+
+    /**
+     * Get the BIP141 weight of the serialized transaction. This excludes
+     * the remainder output a conversion adds to the coinbase transaction; use
+     * GetTransactionWeight() (see "consensus/validation.h") to include it.
+     */
+    int64_t GetWeight() const { return int64_t{m_stripped_size} * (WITNESS_SCALE_FACTOR - 1) + m_total_size; }
 
     bool IsCoinBase() const
     {
@@ -426,6 +454,10 @@ struct CMutableTransaction
 typedef std::shared_ptr<const CTransaction> CTransactionRef;
 template <typename Tx> static inline CTransactionRef MakeTransactionRef(Tx&& txIn) { return std::make_shared<const CTransaction>(std::forward<Tx>(txIn)); }
 
+/** Convert several transactions at once, hashing them in parallel lanes,
+ *  which is faster than one MakeTransactionRef per transaction. */
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs);
+
 /** A generic txid reference (txid or wtxid). */
 class GenTxid
 {
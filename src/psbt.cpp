@@ -6,7 +6,16 @@
 
 #include <util/check.h>
 #include <util/strencodings.h>
+#include <util/threadpool.h>
 
+#include <atomic>
+
+namespace {
+//! PSBTs with fewer inputs than this are processed on the calling thread only
+constexpr size_t MIN_PARALLEL_PSBT_INPUTS{32};
+//! Maximum number of threads processing the inputs of a PSBT
+constexpr size_t MAX_PSBT_INPUT_THREADS{8};
+} // namespace
 
 PartiallySignedTransaction::PartiallySignedTransaction(const CMutableTransaction& tx) : tx(tx)
 {
@@ -399,17 +408,29 @@ bool SignPSBTInput(const SigningProvider& provider, PartiallySignedTransaction&
     return sig_complete;
 }
 
+void ForEachPSBTInput(const PartiallySignedTransaction& psbt, const std::function<void(unsigned int)>& fn)
+{
+    const size_t num_inputs{psbt.tx->vin.size()};
+    if (num_inputs < MIN_PARALLEL_PSBT_INPUTS) {
+        for (unsigned int i = 0; i < num_inputs; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    util::ParallelFor("psbt", util::TaskPriority::NORMAL, num_inputs, MAX_PSBT_INPUT_THREADS, [&](size_t i) { fn(i); });
+}
+
 bool FinalizePSBT(PartiallySignedTransaction& psbtx)
 {
     // Finalize input signatures -- in case we have partial signatures that add up to a complete
     //   signature, but have not combined them yet (e.g. because the combiner that created this
     //   PartiallySignedTransaction did not understand them), this will combine them into a final
     //   script.
-    bool complete = true;
+    std::atomic<bool> complete{true};
     const PrecomputedTransactionData txdata = PrecomputePSBTData(psbtx);
-    for (unsigned int i = 0; i < psbtx.tx->vin.size(); ++i) {
-        complete &= SignPSBTInput(DUMMY_SIGNING_PROVIDER, psbtx, i, &txdata, SIGHASH_ALL, nullptr, true);
-    }
+    ForEachPSBTInput(psbtx, [&](unsigned int i) {
+        if (!SignPSBTInput(DUMMY_SIGNING_PROVIDER, psbtx, i, &txdata, SIGHASH_ALL, nullptr, true)) complete = false;
+    });
 
     return complete;
 }
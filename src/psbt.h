@@ -15,6 +15,7 @@
 #include <span.h>
 #include <streams.h>
 
+#include <functional>
 #include <optional>
 
 // Magic bytes
@@ -1228,6 +1229,14 @@ bool PSBTInputSigned(const PSBTInput& input);
  **/
 bool SignPSBTInput(const SigningProvider& provider, PartiallySignedTransaction& psbt, int index, const PrecomputedTransactionData* txdata, int sighash = SIGHASH_ALL, SignatureData* out_sigdata = nullptr, bool finalize = true);
 
+/**
+ * Call fn with the index of every input of a PSBT, on tasks of the shared thread pool if it
+ * has many inputs. fn may only modify the input it is called with, and must not depend on the
+ * order of the calls. The first exception thrown by fn stops further calls, and is rethrown
+ * once the running calls have returned.
+ */
+void ForEachPSBTInput(const PartiallySignedTransaction& psbt, const std::function<void(unsigned int)>& fn);
+
 /** Counts the unsigned inputs of a PSBT. */
 size_t CountPSBTUnsignedInputs(const PartiallySignedTransaction& psbt);
 
@@ -27,9 +27,6 @@
 #include <QThread>
 #include <QTimer>
 
-static int64_t nLastHeaderTipUpdateNotification = 0;
-static int64_t nLastBlockTipUpdateNotification = 0;
-
 ClientModel::ClientModel(interfaces::Node& node, OptionsModel *_optionsModel, QObject *parent) :
     QObject(parent),
     m_node(node),
@@ -245,14 +242,44 @@ void ClientModel::TipChanged(SynchronizationState sync_state, interfaces::BlockT
     }
 
     // Throttle GUI notifications about (a) blocks during initial sync, and (b) both blocks and headers during reindex.
+    // Notifications within MODEL_UPDATE_DELAY of the last one are coalesced,
+    // and only the latest is emitted once the delay has passed.
     const bool throttle = (sync_state != SynchronizationState::POST_INIT && synctype == SyncType::BLOCK_SYNC) || sync_state == SynchronizationState::INIT_REINDEX;
     const int64_t now = throttle ? GetTimeMillis() : 0;
-    int64_t& nLastUpdateNotification = synctype != SyncType::BLOCK_SYNC ? nLastHeaderTipUpdateNotification : nLastBlockTipUpdateNotification;
-    if (throttle && now < nLastUpdateNotification + count_milliseconds(MODEL_UPDATE_DELAY)) {
+    const size_t index = synctype != SyncType::BLOCK_SYNC ? 0 : 1;
+    const int64_t next_notification = m_last_tip_notification[index] + count_milliseconds(MODEL_UPDATE_DELAY);
+    if (throttle && now < next_notification) {
+        bool schedule;
+        {
+            LOCK(m_pending_tips_mutex);
+            schedule = !m_pending_tips[index];
+            m_pending_tips[index] = PendingTip{tip.block_height, tip.block_time, verification_progress, synctype, sync_state};
+        }
+        if (schedule) {
+            // Called from a node thread, so start the timer on the GUI thread
+            const int delay = next_notification - now;
+            QMetaObject::invokeMethod(this, [this, index, delay] {
+                QTimer::singleShot(delay, this, [this, index] { EmitPendingTip(index); });
+            });
+        }
         return;
     }
+    // Anything held back is older than this notification
+    WITH_LOCK(m_pending_tips_mutex, m_pending_tips[index].reset());
     Q_EMIT numBlocksChanged(tip.block_height, QDateTime::fromSecsSinceEpoch(tip.block_time), verification_progress, synctype, sync_state);
-    nLastUpdateNotification = now;
+    m_last_tip_notification[index] = now;
+}
+
+void ClientModel::EmitPendingTip(size_t index)
+{
+    std::optional<PendingTip> pending;
+    {
+        LOCK(m_pending_tips_mutex);
+        std::swap(pending, m_pending_tips[index]);
+    }
+    if (!pending) return;
+    Q_EMIT numBlocksChanged(pending->height, QDateTime::fromSecsSinceEpoch(pending->time), pending->verification_progress, pending->synctype, pending->sync_state);
+    m_last_tip_notification[index] = GetTimeMillis();
 }
 
 void ClientModel::subscribeToCoreSignals()
@@ -10,8 +10,10 @@
 
 #include <consensus/amount.h>
 
+#include <array>
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <sync.h>
 #include <uint256.h>
 
@@ -117,7 +119,23 @@ private:
     //! A thread to interact with m_node asynchronously
     QThread* const m_thread;
 
-    void TipChanged(SynchronizationState sync_state, interfaces::BlockTip tip, double verification_progress, SyncType synctype) EXCLUSIVE_LOCKS_REQUIRED(!m_cached_tip_mutex);
+    //! A tip notification that was held back by throttling
+    struct PendingTip {
+        int height;
+        int64_t time;
+        double verification_progress;
+        SyncType synctype;
+        SynchronizationState sync_state;
+    };
+    //! Time of the last notification, and the latest notification held back
+    //! since, for headers (0) and blocks (1)
+    std::array<std::atomic<int64_t>, 2> m_last_tip_notification{};
+    Mutex m_pending_tips_mutex;
+    std::array<std::optional<PendingTip>, 2> m_pending_tips GUARDED_BY(m_pending_tips_mutex);
+
+    /** Emit the held back notification, if it was not superseded */
+    void EmitPendingTip(size_t index) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_tips_mutex);
+    void TipChanged(SynchronizationState sync_state, interfaces::BlockTip tip, double verification_progress, SyncType synctype) EXCLUSIVE_LOCKS_REQUIRED(!m_cached_tip_mutex, !m_pending_tips_mutex);
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
 
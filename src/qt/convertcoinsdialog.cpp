@@ -13,6 +13,7 @@
 #include <qt/bitcoinunits.h>
 #include <qt/clientmodel.h>
 #include <qt/coincontroldialog.h>
+#include <qt/guiconstants.h>
 #include <qt/guiutil.h>
 #include <qt/optionsmodel.h>
 #include <qt/platformstyle.h>
@@ -34,6 +35,7 @@
 #include <memory>
 
 #include <QFontMetrics>
+#include <QPointer>
 #include <QScrollBar>
 #include <QSettings>
 #include <QTextDocument>
@@ -119,6 +121,10 @@ ConvertCoinsDialog::ConvertCoinsDialog(const PlatformStyle *_platformStyle, QWid
         connect(ui->groupType, qOverload<int>(&QButtonGroup::buttonClicked), this, &ConvertCoinsDialog::updateConversionType);
     #endif
 
+    m_estimate_timer.setSingleShot(true);
+    m_estimate_timer.setInterval(CONVERSION_ESTIMATE_DELAY);
+    connect(&m_estimate_timer, &QTimer::timeout, this, [this] { recalculate(); });
+
     connect(ui->reqAmountIn, &BitcoinAmountField::valueChanged, this, &ConvertCoinsDialog::onInputChanged);
     connect(ui->reqAmountOut, &BitcoinAmountField::valueChanged, this, &ConvertCoinsDialog::onOutputChanged);
     connect(ui->clearButton, &QPushButton::clicked, this, &ConvertCoinsDialog::clear);
@@ -326,7 +332,7 @@ void ConvertCoinsDialog::onInputChanged()
     } else {
         // Input changed by user
         inputIsExact = true;
-        recalculate();
+        m_estimate_timer.start();
     }
 }
 
@@ -338,39 +344,80 @@ void ConvertCoinsDialog::onOutputChanged()
     } else {
         // Output changed by user
         inputIsExact = false;
-        recalculate();
+        m_estimate_timer.start();
     }
 }
 
-void ConvertCoinsDialog::recalculate()
+static CAmount EstimateConversion(interfaces::Wallet& wallet, bool input_is_exact, CAmount amount, CAmountType input_type, CAmountType output_type)
 {
-    if (model && inputIsExact && ui->reqAmountIn->value() != 0) {
-        calculatingOutput = true;
-        CAmount inputAmount = ui->reqAmountIn->value();
-        if (model && model->getOptionsModel()->getShowScaledAmount(getInputType())) {
-            inputAmount = DescaleAmount(inputAmount, clientModel->getBestScaleFactor());
+    return input_is_exact ? wallet.estimateConversionOutputAmount(amount, input_type) :
+                            wallet.estimateConversionInputAmount(amount, output_type);
+}
+
+void ConvertCoinsDialog::recalculate(bool synchronous)
+{
+    m_estimate_timer.stop();
+    const uint64_t request{++m_estimate_request};
+
+    const bool input_is_exact{inputIsExact};
+    CAmount amount = input_is_exact ? ui->reqAmountIn->value() : ui->reqAmountOut->value();
+    if (!model || !clientModel || amount == 0) {
+        m_applied_estimate = request;
+        return;
+    }
+
+    const CAmountType input_type{getInputType()};
+    const CAmountType output_type{getOutputType()};
+    if (model->getOptionsModel()->getShowScaledAmount(input_is_exact ? input_type : output_type)) {
+        amount = DescaleAmount(amount, clientModel->getBestScaleFactor());
+    }
+
+    if (synchronous) {
+        applyEstimate(request, EstimateConversion(model->wallet(), input_is_exact, amount, input_type, output_type));
+        return;
+    }
+
+    // The estimate may wait on node locks (e.g. while a block is connected),
+    // so it is queried on the wallet model's worker thread. The result is
+    // routed back through the wallet model, which outlives the worker, and
+    // dropped if the dialog is gone or the amounts were edited meanwhile.
+    QPointer<ConvertCoinsDialog> dialog(this);
+    WalletModel* const wallet_model{model};
+    QTimer::singleShot(0, wallet_model->worker(), [dialog, wallet_model, request, input_is_exact, input_type, output_type, amount] {
+        const CAmount estimate{EstimateConversion(wallet_model->wallet(), input_is_exact, amount, input_type, output_type)};
+        QTimer::singleShot(0, wallet_model, [dialog, request, estimate] {
+            if (dialog) dialog->applyEstimate(request, estimate);
+        });
+    });
+}
+
+void ConvertCoinsDialog::applyEstimate(uint64_t request, CAmount estimate)
+{
+    if (!model || !clientModel || request != m_estimate_request || m_estimate_timer.isActive()) return;
+    m_applied_estimate = request;
+
+    if (inputIsExact && ui->reqAmountIn->value() != 0) {
+        if (model->getOptionsModel()->getShowScaledAmount(getOutputType())) {
+            estimate = ScaleAmount(estimate, clientModel->getBestScaleFactor());
         }
-        CAmount outputAmount = model->wallet().estimateConversionOutputAmount(inputAmount, getInputType());
-        if (model && model->getOptionsModel()->getShowScaledAmount(getOutputType())) {
-            outputAmount = ScaleAmount(outputAmount, clientModel->getBestScaleFactor());
+        calculatingOutput = true;
+        ui->reqAmountOut->setValue(estimate);
+    } else if (!inputIsExact && ui->reqAmountOut->value() != 0) {
+        if (model->getOptionsModel()->getShowScaledAmount(getOutputType())) {
+            estimate = ScaleAmount(estimate, clientModel->getBestScaleFactor());
         }
-        ui->reqAmountOut->setValue(outputAmount);
-    } else if (model && !inputIsExact && ui->reqAmountOut->value() != 0) {
         calculatingInput = true;
-        CAmount outputAmount = ui->reqAmountOut->value();
-        if (model && model->getOptionsModel()->getShowScaledAmount(getOutputType())) {
-            outputAmount = DescaleAmount(outputAmount, clientModel->getBestScaleFactor());
-        }
-        CAmount inputAmount = model->wallet().estimateConversionInputAmount(outputAmount, getOutputType());
-        if (model && model->getOptionsModel()->getShowScaledAmount(getOutputType())) {
-            inputAmount = ScaleAmount(inputAmount, clientModel->getBestScaleFactor());
-        }
-        ui->reqAmountIn->setValue(inputAmount);
+        ui->reqAmountIn->setValue(estimate);
     }
 }
 
 bool ConvertCoinsDialog::PrepareConversionText(QString& question_string, QString& informative_text, QString& detailed_text)
 {
+    // Don't convert with an amount whose estimate is still outstanding
+    if (m_estimate_timer.isActive() || m_applied_estimate != m_estimate_request) {
+        recalculate(/*synchronous=*/true);
+    }
+
     WalletModel::UnlockContext ctx(model->requestUnlock());
     if(!ctx.isValid())
     {
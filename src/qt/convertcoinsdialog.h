@@ -69,6 +69,11 @@ private:
     bool inputIsExact = true; // if false, output is exact
     bool calculatingInput = false;
     bool calculatingOutput = false;
+    // Delays the conversion estimate until the user stops typing
+    QTimer m_estimate_timer;
+    // Identifies the latest estimate so that stale results are dropped
+    uint64_t m_estimate_request{0};
+    uint64_t m_applied_estimate{0};
 
     CAmountType getInputType();
     CAmountType getOutputType();
@@ -112,7 +117,8 @@ private Q_SLOTS:
     CAmountType getFeeType();
     void onInputChanged();
     void onOutputChanged();
-    void recalculate();
+    void recalculate(bool synchronous = false);
+    void applyEstimate(uint64_t request, CAmount estimate);
     void updateFeeMinimizedLabel();
     void updateFeeSectionControls();
     void updateNumberOfBlocks(int count, const QDateTime& blockDate, double nVerificationProgress, SyncType synctype, SynchronizationState sync_state);
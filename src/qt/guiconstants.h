@@ -16,6 +16,9 @@ static constexpr auto MODEL_UPDATE_DELAY{250ms};
 /* A delay between shutdown pollings */
 static constexpr auto SHUTDOWN_POLLING_DELAY{200ms};
 
+/* A delay between the last edit of a conversion amount and its estimate */
+static constexpr auto CONVERSION_ESTIMATE_DELAY{300ms};
+
 /* AskPassphraseDialog -- Maximum passphrase length */
 static const int MAX_PASSPHRASE_SIZE = 1024;
 
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <vector>
 
 #include <QColor>
 #include <QDateTime>
@@ -42,6 +43,9 @@ static int column_alignments[] = {
         Qt::AlignRight|Qt::AlignVCenter /* bondAmount */
     };
 
+// Number of wallet transactions decomposed into records at a time
+static const int TX_RECORD_PAGE_SIZE = 1000;
+
 // Comparison operator for sort/binary search of model tx list
 struct TxLessThan
 {
@@ -109,22 +113,60 @@ public:
     void NotifyTransactionChanged(const uint256 &hash, ChangeType status);
     void DispatchNotifications();
 
-    /* Query entire wallet anew from core.
+    /* Wallet transactions not decomposed into records yet, oldest first.
+     * They are loaded a page at a time, most recent first, as the view
+     * asks for more rows.
+     */
+    std::vector<uint256> m_unloaded_txids;
+
+    /* Query the wallet's transaction index anew from core and load the most
+     * recent page.
      */
     void refreshWallet(interfaces::Wallet& wallet)
     {
         assert(!m_loaded);
-        {
-            for (const auto& wtx : wallet.getWalletTxs()) {
-                if (TransactionRecord::showTransaction()) {
-                    cachedWallet.append(TransactionRecord::decomposeTransaction(wtx));
-                }
-            }
-        }
+        m_unloaded_txids = wallet.getWalletTxHashes();
+        loadMore(wallet);
         m_loaded = true;
         DispatchNotifications();
     }
 
+    bool canLoadMore() const
+    {
+        return !m_unloaded_txids.empty();
+    }
+
+    /* Decompose the next page of wallet transactions into the model.
+     */
+    void loadMore(interfaces::Wallet& wallet)
+    {
+        for (int i = 0; i < TX_RECORD_PAGE_SIZE && !m_unloaded_txids.empty(); ++i) {
+            const uint256 hash{m_unloaded_txids.back()};
+            m_unloaded_txids.pop_back();
+
+            // Skip transactions already added by a notification
+            QList<TransactionRecord>::iterator lower = std::lower_bound(
+                cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
+            if (lower != cachedWallet.end() && lower->hash == hash) continue;
+            if (!TransactionRecord::showTransaction()) continue;
+
+            const interfaces::WalletTx wtx = wallet.getWalletTx(hash);
+            if (!wtx.tx) continue;
+            const QList<TransactionRecord> toInsert = TransactionRecord::decomposeTransaction(wtx);
+            if (toInsert.isEmpty()) continue;
+
+            const int lowerIndex = (lower - cachedWallet.begin());
+            parent->beginInsertRows(QModelIndex(), lowerIndex, lowerIndex+toInsert.size()-1);
+            int insert_idx = lowerIndex;
+            for (const TransactionRecord &rec : toInsert)
+            {
+                cachedWallet.insert(insert_idx, rec);
+                insert_idx += 1;
+            }
+            parent->endInsertRows();
+        }
+    }
+
     /* Update our model of the wallet incrementally, to synchronize our model of the wallet
        with that of the core.
 
@@ -307,6 +349,22 @@ int TransactionTableModel::rowCount(const QModelIndex &parent) const
     return priv->size();
 }
 
+bool TransactionTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return priv->canLoadMore();
+}
+
+void TransactionTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    priv->loadMore(walletModel->wallet());
+}
+
 int TransactionTableModel::columnCount(const QModelIndex &parent) const
 {
     if (parent.isValid()) {
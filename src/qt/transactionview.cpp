@@ -373,6 +373,11 @@ void TransactionView::exportClicked()
     if (filename.isNull())
         return;
 
+    // Export the whole history, not only the pages loaded so far
+    while (transactionProxyModel->canFetchMore(QModelIndex())) {
+        transactionProxyModel->fetchMore(QModelIndex());
+    }
+
     CSVModelWriter writer(filename);
 
     // name, column, role
@@ -25,6 +25,7 @@
 #include <node/interface_ui.h>
 #include <psbt.h>
 #include <util/system.h> // for GetBoolArg
+#include <util/threadnames.h>
 #include <util/translation.h>
 #include <wallet/coincontrol.h>
 #include <wallet/wallet.h> // for CRecipient
@@ -35,6 +36,7 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QSet>
+#include <QThread>
 #include <QTimer>
 
 using interfaces::WalletConversionTxDetails;
@@ -52,19 +54,33 @@ WalletModel::WalletModel(std::unique_ptr<interfaces::Wallet> wallet, ClientModel
     transactionTableModel(nullptr),
     recentRequestsTableModel(nullptr),
     cachedEncryptionStatus(Unencrypted),
-    timer(new QTimer(this))
+    timer(new QTimer(this)),
+    m_worker_thread(new QThread(this)),
+    m_worker(new QObject)
 {
     fHaveWatchOnly = m_wallet->haveWatchOnly();
     addressTableModel = new AddressTableModel(this);
     transactionTableModel = new TransactionTableModel(platformStyle, this);
     recentRequestsTableModel = new RecentRequestsTableModel(this);
 
+    // Interface calls that may wait on wallet or node locks run on this
+    // thread so that they don't block the main event loop
+    m_worker->moveToThread(m_worker_thread);
+    m_worker_thread->start();
+    QTimer::singleShot(0, m_worker, []() {
+        util::ThreadRename("qt-walletmodl");
+    });
+
     subscribeToCoreSignals();
 }
 
 WalletModel::~WalletModel()
 {
     unsubscribeFromCoreSignals();
+
+    m_worker_thread->quit();
+    m_worker_thread->wait();
+    delete m_worker;
 }
 
 void WalletModel::startPollBalance()
@@ -98,30 +114,45 @@ void WalletModel::updateStatus()
 
 void WalletModel::pollBalanceChanged()
 {
+    // Polls arriving while a balance query is in flight are coalesced into
+    // the next one.
+    if (m_balance_poll_pending) return;
+
     // Avoid recomputing wallet balances unless a TransactionChanged or
     // BlockTip notification was received.
     if (!fForceCheckBalanceChanged && m_cached_last_update_tip == getLastBlockProcessed()) return;
 
-    // Try to get balances and return early if locks can't be acquired. This
-    // avoids the GUI from getting stuck on periodical polls if the core is
-    // holding the locks for a longer time - for example, during a wallet
-    // rescan.
-    interfaces::WalletBalances new_balances;
-    uint256 block_hash;
-    if (!m_wallet->tryGetBalances(new_balances, block_hash)) {
-        return;
-    }
-
-    if (fForceCheckBalanceChanged || block_hash != m_cached_last_update_tip) {
-        fForceCheckBalanceChanged = false;
+    const bool force{fForceCheckBalanceChanged};
+    fForceCheckBalanceChanged = false;
+    m_balance_poll_pending = true;
+
+    QTimer::singleShot(0, m_worker, [this, force] {
+        // Try to get balances and return early if locks can't be acquired. This
+        // avoids the worker from getting stuck on periodical polls if the core is
+        // holding the locks for a longer time - for example, during a wallet
+        // rescan.
+        interfaces::WalletBalances new_balances;
+        uint256 block_hash;
+        const bool got_balances{m_wallet->tryGetBalances(new_balances, block_hash)};
+
+        QTimer::singleShot(0, this, [this, force, got_balances, new_balances, block_hash] {
+            m_balance_poll_pending = false;
+            if (!got_balances) {
+                // Retry on the next poll
+                if (force) fForceCheckBalanceChanged = true;
+                return;
+            }
 
-        // Balance and number of transactions might have changed
-        m_cached_last_update_tip = block_hash;
+            if (force || block_hash != m_cached_last_update_tip) {
+                // Balance and number of transactions might have changed
+                m_cached_last_update_tip = block_hash;
 
-        checkBalanceChanged(new_balances);
-        if(transactionTableModel)
-            transactionTableModel->updateConfirmations();
-    }
+                checkBalanceChanged(new_balances);
+                if(transactionTableModel)
+                    transactionTableModel->updateConfirmations();
+            }
+        });
+    });
 }
 
 void WalletModel::checkBalanceChanged(const interfaces::WalletBalances& new_balances)
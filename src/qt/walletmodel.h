@@ -48,6 +48,7 @@ class CCoinControl;
 } // namespace wallet
 
 QT_BEGIN_NAMESPACE
+class QThread;
 class QTimer;
 QT_END_NAMESPACE
 
@@ -179,6 +180,8 @@ public:
     interfaces::Node& node() const { return m_node; }
     interfaces::Wallet& wallet() const { return *m_wallet; }
     ClientModel& clientModel() const { return *m_client_model; }
+    //! Object living on the worker thread, used to run wallet interface calls off the GUI thread
+    QObject* worker() const { return m_worker; }
     void setClientModel(ClientModel* client_model);
 
     QString getWalletName() const;
@@ -231,6 +234,11 @@ private:
 
     // Block hash denoting when the last balance update was done.
     uint256 m_cached_last_update_tip{};
+    // Whether a balance query is running on the worker thread.
+    bool m_balance_poll_pending{false};
+
+    QThread* const m_worker_thread;
+    QObject* const m_worker;
 
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
@@ -12,6 +12,7 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/txindex.h>
+#include <kernel/validation_stats.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <primitives/block.h>
@@ -25,6 +26,7 @@
 #include <sync.h>
 #include <txmempool.h>
 #include <util/check.h>
+#include <util/string.h>
 #include <util/system.h>
 #include <validation.h>
 #include <version.h>
@@ -37,9 +39,15 @@
 using node::GetTransaction;
 using node::NodeContext;
 using node::ReadBlockFromDisk;
+using node::ReadRawBlockFromDisk;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+static constexpr unsigned int MAX_REST_BLOCKRANGE_RESULTS = 100;
+//! Blocks are added to a block range response until it reaches this size
+static constexpr size_t MAX_REST_BLOCKRANGE_SIZE = 32 * 1024 * 1024;
+static constexpr unsigned int MAX_REST_SUPPLY_RESULTS = 100000;
+static constexpr unsigned int DEFAULT_REST_SCALE_FACTOR_INTERVAL = 2016;
 
 static const struct {
     RESTResponseFormat rf;
@@ -288,7 +296,11 @@ static bool rest_block(const std::any& context,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
+    // Binary and hex blocks serialized with witness data are served as
+    // stored on disk, without decoding them
+    const bool serve_raw{(rf == RESTResponseFormat::BINARY || rf == RESTResponseFormat::HEX) && RPCSerializationFlags() == 0};
     CBlock block;
+    std::vector<uint8_t> block_data;
     const CBlockIndex* pblockindex = nullptr;
     const CBlockIndex* tip = nullptr;
     ChainstateManager* maybe_chainman = GetChainman(context, req);
@@ -305,24 +317,30 @@ static bool rest_block(const std::any& context,
         if (chainman.m_blockman.IsBlockPruned(pblockindex))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, chainman.GetParams().GetConsensus()))
+        if (serve_raw) {
+            if (!ReadRawBlockFromDisk(block_data, pblockindex->GetBlockPos(), chainman.GetParams().MessageStart())) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
+        } else if (!ReadBlockFromDisk(block, pblockindex, chainman.GetParams().GetConsensus())) {
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
     }
 
     switch (rf) {
     case RESTResponseFormat::BINARY: {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string binaryBlock = ssBlock.str();
+        if (!serve_raw) {
+            CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), block_data, 0} << block;
+        }
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, MakeByteSpan(block_data));
         return true;
     }
 
     case RESTResponseFormat::HEX: {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock) + "\n";
+        if (!serve_raw) {
+            CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), block_data, 0} << block;
+        }
+        std::string strHex = HexStr(block_data) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
@@ -598,19 +616,44 @@ static bool rest_mempool(const std::any& context, HTTPRequest* req, const std::s
     std::string param;
     const RESTResponseFormat rf = ParseDataFormat(param, str_uri_part);
     if (param != "contents" && param != "info") {
-        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool/<info|contents>.json");
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/mempool/<info.json|contents.<bin|hex|json>>");
     }
 
     const CTxMemPool* mempool = GetMemPool(context, req);
     if (!mempool) return false;
 
     switch (rf) {
+    case RESTResponseFormat::BINARY:
+    case RESTResponseFormat::HEX: {
+        if (param != "contents") {
+            return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+        }
+        // The serialized transactions, parents before their children
+        std::vector<CTransactionRef> txs;
+        for (const TxMempoolInfo& info : mempool->infoAll()) {
+            txs.push_back(info.tx);
+        }
+        CDataStream ssTxs(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+        ssTxs << txs;
+
+        if (rf == RESTResponseFormat::BINARY) {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, ssTxs.str());
+        } else {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(ssTxs) + "\n");
+        }
+        return true;
+    }
     case RESTResponseFormat::JSON: {
         std::string str_json;
         if (param == "contents") {
             str_json = MempoolToJSON(*mempool, true).write() + "\n";
         } else {
-            str_json = MempoolInfoToJSON(*mempool).write() + "\n";
+            ChainstateManager* maybe_chainman = GetChainman(context, req);
+            if (!maybe_chainman) return false;
+            const CAmounts tip_supply = WITH_LOCK(cs_main, return maybe_chainman->ActiveChain().Tip()->GetTotalSupply());
+            str_json = MempoolInfoToJSON(*mempool, tip_supply).write() + "\n";
         }
 
         req->WriteHeader("Content-Type", "application/json");
@@ -926,6 +969,233 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
     }
 }
 
+/** Parse /<HEIGHT>.<ext>?count=<COUNT> and return the active chain entries from that height up, or
+ * std::nullopt after writing an error reply */
+static std::optional<std::vector<const CBlockIndex*>> ParseHeightRange(const std::any& context, HTTPRequest* req, const std::string& height_str, unsigned int max_count)
+{
+    int32_t height = -1;
+    if (!ParseInt32(height_str, &height) || height < 0) {
+        RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(height_str));
+        return std::nullopt;
+    }
+    const std::string raw_count{req->GetQueryParameter("count").value_or("5")};
+    const auto count{ToIntegral<unsigned int>(raw_count)};
+    if (!count || *count < 1 || *count > max_count) {
+        RESTERR(req, HTTP_BAD_REQUEST, strprintf("Count is invalid or out of acceptable range (1-%u): %s", max_count, SanitizeString(raw_count)));
+        return std::nullopt;
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return std::nullopt;
+    LOCK(cs_main);
+    const CChain& active_chain = maybe_chainman->ActiveChain();
+    if (height > active_chain.Height()) {
+        RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        return std::nullopt;
+    }
+    std::vector<const CBlockIndex*> range;
+    const int end = static_cast<int>(std::min<int64_t>(int64_t{height} + *count - 1, active_chain.Height()));
+    range.reserve(end - height + 1);
+    for (int i = height; i <= end; ++i) {
+        range.push_back(active_chain[i]);
+    }
+    return range;
+}
+
+static bool rest_blockrange(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string height_str;
+    const RESTResponseFormat rf = ParseDataFormat(height_str, str_uri_part);
+    if (rf != RESTResponseFormat::BINARY && rf != RESTResponseFormat::HEX) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: bin, hex)");
+    }
+
+    const auto range{ParseHeightRange(context, req, height_str, MAX_REST_BLOCKRANGE_RESULTS)};
+    if (!range) return false;
+    ChainstateManager& chainman = *Assert(GetChainman(context, req));
+
+    std::vector<FlatFilePos> positions;
+    {
+        LOCK(cs_main);
+        for (const CBlockIndex* pindex : *range) {
+            if (chainman.m_blockman.IsBlockPruned(pindex)) {
+                if (positions.empty()) return RESTERR(req, HTTP_NOT_FOUND, pindex->GetBlockHash().GetHex() + " not available (pruned data)");
+                break;
+            }
+            positions.push_back(pindex->GetBlockPos());
+        }
+    }
+
+    // The blocks are read without holding cs_main. A block that can no longer be read (e.g.
+    // pruned in the meantime) ends the range, as does reaching the size limit.
+    const bool serve_raw{RPCSerializationFlags() == 0};
+    std::vector<uint8_t> blocks_data;
+    for (const FlatFilePos& pos : positions) {
+        if (blocks_data.size() >= MAX_REST_BLOCKRANGE_SIZE) break;
+        std::vector<uint8_t> block_data;
+        CBlock block;
+        if (serve_raw) {
+            if (!ReadRawBlockFromDisk(block_data, pos, chainman.GetParams().MessageStart())) break;
+        } else {
+            if (!ReadBlockFromDisk(block, pos, chainman.GetParams().GetConsensus())) break;
+            CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), block_data, 0} << block;
+        }
+        blocks_data.insert(blocks_data.end(), block_data.begin(), block_data.end());
+    }
+    if (blocks_data.empty()) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Block not found");
+    }
+
+    if (rf == RESTResponseFormat::BINARY) {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, MakeByteSpan(blocks_data));
+    } else {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(blocks_data) + "\n");
+    }
+    return true;
+}
+
+static bool rest_supply(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string height_str;
+    const RESTResponseFormat rf = ParseDataFormat(height_str, str_uri_part);
+
+    const auto range{ParseHeightRange(context, req, height_str, MAX_REST_SUPPLY_RESULTS)};
+    if (!range) return false;
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY:
+    case RESTResponseFormat::HEX: {
+        // The unscaled supplies and the scale factor of each block
+        CDataStream ss_supply(SER_NETWORK, PROTOCOL_VERSION);
+        for (const CBlockIndex* pindex : *range) {
+            ss_supply << pindex->cashSupply << pindex->bondSupply << pindex->scaleFactor;
+        }
+        if (rf == RESTResponseFormat::BINARY) {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, ss_supply.str());
+        } else {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(ss_supply) + "\n");
+        }
+        return true;
+    }
+    case RESTResponseFormat::JSON: {
+        UniValue supplies(UniValue::VARR);
+        for (const CBlockIndex* pindex : *range) {
+            const CAmounts scaledSupply{pindex->GetScaledTotalSupply()};
+            UniValue supply(UniValue::VOBJ);
+            supply.pushKV("height", pindex->nHeight);
+            supply.pushKV("cashSupply", ValueFromAmount(scaledSupply[CASH]));
+            supply.pushKV("bondSupply", ValueFromAmount(scaledSupply[BOND]));
+            supply.pushKV("unscaledCashSupply", ValueFromAmount(pindex->cashSupply));
+            supply.pushKV("unscaledBondSupply", ValueFromAmount(pindex->bondSupply));
+            supply.pushKV("scaleFactor", ValueFromScaleFactor(pindex->scaleFactor));
+            supplies.push_back(supply);
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, supplies.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_headersupply(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string height_str;
+    const RESTResponseFormat rf = ParseDataFormat(height_str, str_uri_part);
+
+    const std::string raw_interval{req->GetQueryParameter("interval").value_or(ToString(DEFAULT_REST_SCALE_FACTOR_INTERVAL))};
+    const auto interval{ToIntegral<unsigned int>(raw_interval)};
+    if (!interval || *interval < 1) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid interval: " + SanitizeString(raw_interval));
+    }
+    const auto range{ParseHeightRange(context, req, height_str, MAX_REST_HEADERS_RESULTS)};
+    if (!range) return false;
+
+    // Clients extend the scale factor of the first header with GetNextScaleFactor(),
+    // and check it against the one of every header at a multiple of the interval.
+    const auto is_checkpoint{[&](const CBlockIndex* pindex) {
+        return pindex == range->front() || pindex->nHeight % *interval == 0;
+    }};
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY:
+    case RESTResponseFormat::HEX: {
+        CDataStream ss_headers(SER_NETWORK, PROTOCOL_VERSION);
+        for (const CBlockIndex* pindex : *range) {
+            ss_headers << pindex->GetBlockHeader();
+            if (is_checkpoint(pindex)) ss_headers << pindex->scaleFactor;
+        }
+        if (rf == RESTResponseFormat::BINARY) {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, ss_headers.str());
+        } else {
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, HexStr(ss_headers) + "\n");
+        }
+        return true;
+    }
+    case RESTResponseFormat::JSON: {
+        UniValue headers(UniValue::VARR);
+        for (const CBlockIndex* pindex : *range) {
+            CDataStream ss_header(SER_NETWORK, PROTOCOL_VERSION);
+            ss_header << pindex->GetBlockHeader();
+            UniValue header(UniValue::VOBJ);
+            header.pushKV("height", pindex->nHeight);
+            header.pushKV("hash", pindex->GetBlockHash().GetHex());
+            header.pushKV("header", HexStr(ss_header));
+            if (is_checkpoint(pindex)) header.pushKV("scaleFactor", ValueFromScaleFactor(pindex->scaleFactor));
+            headers.push_back(header);
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, headers.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_metrics(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!str_uri_part.empty()) {
+        return RESTERR(req, HTTP_NOT_FOUND, "not found, use /rest/metrics");
+    }
+
+    // Prometheus text exposition of the validation stage histograms, with
+    // cumulative buckets and durations in seconds
+    using kernel::LatencyHistogram;
+    const std::string name{"peerfed_validation_stage_duration_seconds"};
+    std::string body;
+    body += "# HELP " + name + " Duration of the stages of connecting blocks to the active chain.\n";
+    body += "# TYPE " + name + " histogram\n";
+    for (size_t i = 0; i < kernel::VALIDATION_STAGE_COUNT; ++i) {
+        const auto stage_id{static_cast<kernel::ValidationStage>(i)};
+        const std::string stage{kernel::ValidationStageName(stage_id)};
+        const LatencyHistogram::Snapshot snapshot{kernel::GetValidationStageHistogram(stage_id).GetSnapshot()};
+        uint64_t cumulative{0};
+        for (size_t b = 0; b + 1 < LatencyHistogram::NUM_BUCKETS; ++b) {
+            cumulative += snapshot.buckets[b];
+            body += strprintf("%s_bucket{stage=\"%s\",le=\"%.6f\"} %u\n", name, stage, LatencyHistogram::BucketUpperBound(b) * 1e-6, cumulative);
+        }
+        body += strprintf("%s_bucket{stage=\"%s\",le=\"+Inf\"} %u\n", name, stage, snapshot.count);
+        body += strprintf("%s_sum{stage=\"%s\"} %.6f\n", name, stage, snapshot.total_us * 1e-6);
+        body += strprintf("%s_count{stage=\"%s\"} %u\n", name, stage, snapshot.count);
+    }
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, body);
+    return true;
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
@@ -940,6 +1210,10 @@ static const struct {
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/blockrange/", rest_blockrange},
+      {"/rest/supply/", rest_supply},
+      {"/rest/headersupply/", rest_headersupply},
+      {"/rest/metrics", rest_metrics},
 };
 
 void StartREST(const std::any& context)
@@ -12,6 +12,7 @@
 #include <consensus/amount.h>
 #include <consensus/conversion.h>
 #include <consensus/params.h>
+#include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <deploymentinfo.h>
@@ -20,13 +21,17 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/conversionindex.h>
+#include <key_io.h>
 #include <kernel/coinstats.h>
+#include <kernel/validation_stats.h>
 #include <logging/timer.h>
 #include <net.h>
 #include <net_processing.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
+#include <primitives/block_view.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
@@ -40,8 +45,10 @@
 #include <undo.h>
 #include <univalue.h>
 #include <util/check.h>
+#include <util/hasher.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -50,9 +57,13 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <unordered_set>
 
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
@@ -60,7 +71,12 @@ using kernel::CoinStatsHashType;
 using node::BlockManager;
 using node::NodeContext;
 using node::ReadBlockFromDisk;
+using node::ReadRawBlockFromDisk;
+using node::SerializeSnapshotCoins;
+using node::SnapshotChunk;
+using node::SnapshotChunkInfo;
 using node::SnapshotMetadata;
+using node::SNAPSHOT_CHUNK_TARGET_SIZE;
 using node::UndoReadFromDisk;
 
 struct CUpdatedBlock
@@ -152,8 +168,9 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     result.pushKV("time", (int64_t)blockindex->nTime);
     result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
     result.pushKV("nonce", (uint64_t)blockindex->nNonce);
-    result.pushKV("cashSupply", ValueFromAmount(ScaleAmount(blockindex->cashSupply, blockindex->scaleFactor)));
-    result.pushKV("bondSupply", ValueFromAmount(ScaleAmount(blockindex->bondSupply, blockindex->scaleFactor)));
+    const CAmounts scaledSupply{blockindex->GetScaledTotalSupply()};
+    result.pushKV("cashSupply", ValueFromAmount(scaledSupply[CASH]));
+    result.pushKV("bondSupply", ValueFromAmount(scaledSupply[BOND]));
     result.pushKV("unscaledCashSupply", ValueFromAmount(blockindex->cashSupply));
     result.pushKV("unscaledBondSupply", ValueFromAmount(blockindex->bondSupply));
     result.pushKV("scaleFactor", ValueFromScaleFactor(blockindex->scaleFactor));
@@ -173,8 +190,8 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
 {
     UniValue result = blockheaderToJSON(tip, blockindex);
 
-    result.pushKV("strippedsize", (int)::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
-    result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
+    result.pushKV("strippedsize", (int)::GetBlockStrippedSize(block));
+    result.pushKV("size", (int)::GetBlockTotalSize(block));
     result.pushKV("weight", (int)::GetBlockWeight(block));
     UniValue txs(UniValue::VARR);
 
@@ -601,19 +618,22 @@ static CBlock GetBlockChecked(BlockManager& blockman, const CBlockIndex* pblocki
     return block;
 }
 
-static CBlockUndo GetUndoChecked(BlockManager& blockman, const CBlockIndex* pblockindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+static std::vector<uint8_t> GetRawBlockChecked(BlockManager& blockman, const CBlockIndex* pblockindex) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
 {
     AssertLockHeld(::cs_main);
-    CBlockUndo blockUndo;
+    std::vector<uint8_t> data;
     if (blockman.IsBlockPruned(pblockindex)) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Undo data not available (pruned data)");
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
     }
 
-    if (!UndoReadFromDisk(blockUndo, pblockindex)) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Can't read undo data from disk");
+    if (!ReadRawBlockFromDisk(data, pblockindex->GetBlockPos(), Params().MessageStart())) {
+        // Block not found on disk. This could be because we have the block
+        // header in our index but not yet have the block or did not accept the
+        // block.
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
     }
 
-    return blockUndo;
+    return data;
 }
 
 const RPCResult getblock_vin{
@@ -741,6 +761,11 @@ static RPCHelpMan getblock()
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
         }
 
+        if (verbosity <= 0 && RPCSerializationFlags() == 0) {
+            // The block is serialized as on disk, so it doesn't need to be decoded
+            return HexStr(GetRawBlockChecked(chainman.m_blockman, pblockindex));
+        }
+
         block = GetBlockChecked(chainman.m_blockman, pblockindex);
     }
 
@@ -1022,6 +1047,340 @@ static RPCHelpMan gettxoutsetinfo()
     };
 }
 
+static RPCHelpMan getconversionstats()
+{
+    return RPCHelpMan{"getconversionstats",
+                "\nReturns conversion statistics over a range of blocks of the active chain.\n"
+                "Requires coinstatsindex, and answers any range without reading blocks.\n",
+                {
+                    {"start_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The height of the first block in the range"},
+                    {"end_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"the current best block"}, "The height of the last block in the range"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "start_height", "The height of the first block in the range"},
+                        {RPCResult::Type::NUM, "end_height", "The height of the last block in the range"},
+                        {RPCResult::Type::NUM, "conversions", "The number of conversions"},
+                        {RPCResult::Type::OBJ, "cash_to_bond", "Conversions from cash to bonds",
+                        {
+                            {RPCResult::Type::STR_AMOUNT, "amount_in", "Unscaled cash converted"},
+                            {RPCResult::Type::STR_AMOUNT, "amount_out", "Unscaled bonds received"},
+                        }},
+                        {RPCResult::Type::OBJ, "bond_to_cash", "Conversions from bonds to cash",
+                        {
+                            {RPCResult::Type::STR_AMOUNT, "amount_in", "Unscaled bonds converted"},
+                            {RPCResult::Type::STR_AMOUNT, "amount_out", "Unscaled cash received"},
+                        }},
+                        {RPCResult::Type::OBJ, "remainders", "Unscaled conversion remainders",
+                        {
+                            {RPCResult::Type::STR_AMOUNT, "cash_to_destination", "Cash remainders paid to the remainder destination"},
+                            {RPCResult::Type::STR_AMOUNT, "bond_to_destination", "Bond remainders paid to the remainder destination"},
+                            {RPCResult::Type::STR_AMOUNT, "cash_to_miner", "Cash remainders without a destination, paid to the miner"},
+                            {RPCResult::Type::STR_AMOUNT, "bond_to_miner", "Bond remainders without a destination, paid to the miner"},
+                        }},
+                        {RPCResult::Type::OBJ, "interest_accrued", "Growth of the scaled value of the total supply",
+                        {
+                            {RPCResult::Type::STR_AMOUNT, "cash", "Scaled value accrued by the cash supply"},
+                            {RPCResult::Type::STR_AMOUNT, "bond", "Scaled value accrued by the bond supply"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getconversionstats", "1000") +
+                    HelpExampleCli("getconversionstats", "1000 2000") +
+                    HelpExampleRpc("getconversionstats", "1000, 2000")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_coin_stats_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Querying conversion stats requires coinstatsindex");
+    }
+
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const CBlockIndex* start_index;
+    const CBlockIndex* end_index;
+    {
+        LOCK(::cs_main);
+        const CChain& active_chain = chainman.ActiveChain();
+        const int start_height{request.params[0].getInt<int>()};
+        const int end_height{request.params[1].isNull() ? active_chain.Height() : request.params[1].getInt<int>()};
+        if (start_height < 0 || end_height > active_chain.Height()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+        }
+        if (start_height > end_height) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "start_height must not be greater than end_height");
+        }
+        start_index = active_chain[start_height];
+        end_index = active_chain[end_height];
+    }
+
+    if (!g_coin_stats_index->BlockUntilSyncedToCurrentChain()) {
+        const IndexSummary summary{g_coin_stats_index->GetSummary()};
+        if (end_index->nHeight > summary.best_block_height) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("Unable to get data because coinstatsindex is still syncing. Current height: %d", summary.best_block_height));
+        }
+    }
+
+    // The index stores prefix sums, so any range is the difference of two entries
+    std::optional<ConversionStats> stats{g_coin_stats_index->LookUpConversionStats(*end_index)};
+    std::optional<ConversionStats> prev_stats{start_index->pprev ? g_coin_stats_index->LookUpConversionStats(*start_index->pprev) : ConversionStats{}};
+    if (!stats || !prev_stats) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Conversion stats are unavailable for this range; rebuild coinstatsindex to record them");
+    }
+    *stats -= *prev_stats;
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("start_height", start_index->nHeight);
+    ret.pushKV("end_height", end_index->nHeight);
+    ret.pushKV("conversions", stats->conversion_count);
+
+    UniValue cash_to_bond(UniValue::VOBJ);
+    cash_to_bond.pushKV("amount_in", ValueFromAmount(stats->amount_in[CASH]));
+    cash_to_bond.pushKV("amount_out", ValueFromAmount(stats->amount_out[BOND]));
+    ret.pushKV("cash_to_bond", cash_to_bond);
+
+    UniValue bond_to_cash(UniValue::VOBJ);
+    bond_to_cash.pushKV("amount_in", ValueFromAmount(stats->amount_in[BOND]));
+    bond_to_cash.pushKV("amount_out", ValueFromAmount(stats->amount_out[CASH]));
+    ret.pushKV("bond_to_cash", bond_to_cash);
+
+    UniValue remainders(UniValue::VOBJ);
+    remainders.pushKV("cash_to_destination", ValueFromAmount(stats->remainder_to_destination[CASH]));
+    remainders.pushKV("bond_to_destination", ValueFromAmount(stats->remainder_to_destination[BOND]));
+    remainders.pushKV("cash_to_miner", ValueFromAmount(stats->remainder_to_miner[CASH]));
+    remainders.pushKV("bond_to_miner", ValueFromAmount(stats->remainder_to_miner[BOND]));
+    ret.pushKV("remainders", remainders);
+
+    UniValue interest(UniValue::VOBJ);
+    interest.pushKV("cash", ValueFromAmount(stats->interest_accrued[CASH]));
+    interest.pushKV("bond", ValueFromAmount(stats->interest_accrued[BOND]));
+    ret.pushKV("interest_accrued", interest);
+    return ret;
+},
+    };
+}
+
+static const std::vector<RPCResult> ConversionEntryDoc()
+{
+    return {
+        {RPCResult::Type::STR_HEX, "txid", "The conversion transaction id"},
+        {RPCResult::Type::STR_HEX, "blockhash", "The hash of the block containing the conversion"},
+        {RPCResult::Type::NUM, "height", "The height of the block containing the conversion"},
+        {RPCResult::Type::BOOL, "in_active_chain", "Whether the block is in the active chain"},
+        {RPCResult::Type::STR, "remainder_type", "The currency of the remainder (cash or bond)"},
+        {RPCResult::Type::STR_AMOUNT, "remainder", "The unscaled remainder of the conversion"},
+        {RPCResult::Type::STR, "address", /*optional=*/true, "The address the remainder was paid to, if it was not paid to the miner"},
+        {RPCResult::Type::NUM, "coinbase_vout", /*optional=*/true, "The coinbase output paying the remainder, if it was not paid to the miner"},
+    };
+}
+
+static UniValue ConversionEntryToJSON(ChainstateManager& chainman, const uint256& txid, const ConversionIndexEntry& entry)
+{
+    bool in_active_chain;
+    {
+        LOCK(::cs_main);
+        const CBlockIndex* pindex = chainman.m_blockman.LookupBlockIndex(entry.block_hash);
+        in_active_chain = pindex && chainman.ActiveChain().Contains(pindex);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("txid", txid.GetHex());
+    ret.pushKV("blockhash", entry.block_hash.GetHex());
+    ret.pushKV("height", entry.height);
+    ret.pushKV("in_active_chain", in_active_chain);
+    ret.pushKV("remainder_type", ValueFromAmountType(entry.remainder_type));
+    ret.pushKV("remainder", ValueFromAmount(entry.remainder));
+    CTxDestination destination;
+    if (!entry.remainder_script.empty() && ExtractDestination(entry.remainder_script, destination)) {
+        ret.pushKV("address", EncodeDestination(destination));
+    }
+    if (entry.coinbase_vout >= 0) {
+        ret.pushKV("coinbase_vout", entry.coinbase_vout);
+    }
+    return ret;
+}
+
+static void EnsureConversionIndexSynced()
+{
+    if (!g_conversion_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Querying conversions requires -conversionindex");
+    }
+    if (!g_conversion_index->BlockUntilSyncedToCurrentChain()) {
+        const IndexSummary summary{g_conversion_index->GetSummary()};
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("conversionindex is still syncing. Current height: %d", summary.best_block_height));
+    }
+}
+
+static RPCHelpMan getconversion()
+{
+    return RPCHelpMan{"getconversion",
+                "\nReturns the block and remainder of a confirmed conversion.\n"
+                "Requires -conversionindex.\n",
+                {
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The conversion transaction id"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "", ConversionEntryDoc()},
+                RPCExamples{
+                    HelpExampleCli("getconversion", "\"mytxid\"") +
+                    HelpExampleRpc("getconversion", "\"mytxid\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const uint256 txid{ParseHashV(request.params[0], "txid")};
+    EnsureConversionIndexSynced();
+
+    ConversionIndexEntry entry;
+    if (!g_conversion_index->FindConversion(txid, entry)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No confirmed conversion with this txid");
+    }
+    return ConversionEntryToJSON(EnsureAnyChainman(request.context), txid, entry);
+},
+    };
+}
+
+static RPCHelpMan listconversions()
+{
+    return RPCHelpMan{"listconversions",
+                "\nLists the confirmed conversions whose remainder was paid to an address, in order of height.\n"
+                "Requires -conversionindex.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The remainder destination"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "", ConversionEntryDoc()},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("listconversions", "\"" + EXAMPLE_ADDRESS[0] + "\"") +
+                    HelpExampleRpc("listconversions", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const CTxDestination destination{DecodeDestination(request.params[0].get_str())};
+    if (!IsValidDestination(destination)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+    EnsureConversionIndexSynced();
+
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    UniValue ret(UniValue::VARR);
+    for (const auto& [txid, entry] : g_conversion_index->FindConversionsByDestination(GetScriptForDestination(destination))) {
+        ret.push_back(ConversionEntryToJSON(chainman, txid, entry));
+    }
+    return ret;
+},
+    };
+}
+
+static UniValue DBInfoToJSON(const CDBWrapper& db)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("cache_size", (uint64_t)db.CacheSize());
+    ret.pushKV("block_cache_percent", db.Tuning().block_cache_percent);
+    ret.pushKV("bloom_bits", db.Tuning().bloom_bits);
+    ret.pushKV("write_buffer_size", (uint64_t)db.Tuning().write_buffer_size);
+    ret.pushKV("memory_usage", (uint64_t)db.DynamicMemoryUsage());
+    ret.pushKV("stats", db.GetProperty("leveldb.stats").value_or(""));
+    return ret;
+}
+
+static RPCHelpMan getdbinfo()
+{
+    const std::vector<RPCResult> db_info{
+        {RPCResult::Type::NUM, "cache_size", "The cache size of the database in bytes"},
+        {RPCResult::Type::NUM, "block_cache_percent", "The percentage of the cache size used for the block cache"},
+        {RPCResult::Type::NUM, "bloom_bits", "The bits per key of the bloom filter, 0 if there is none"},
+        {RPCResult::Type::NUM, "write_buffer_size", "The size of a write buffer in bytes"},
+        {RPCResult::Type::NUM, "memory_usage", "The approximate memory usage of the database in bytes, as reported by LevelDB"},
+        {RPCResult::Type::STR, "stats", "The compaction statistics of the database, as reported by LevelDB"},
+    };
+    return RPCHelpMan{"getdbinfo",
+                "\nReturns the LevelDB settings and statistics of the chainstate and block index databases.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "chainstate", "The coins database of the active chainstate", db_info},
+                        {RPCResult::Type::OBJ, "blockindex", "The block index database", db_info},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getdbinfo", "")
+            + HelpExampleRpc("getdbinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    LOCK(cs_main);
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("chainstate", DBInfoToJSON(chainman.ActiveChainstate().CoinsDB().GetDB()));
+    ret.pushKV("blockindex", DBInfoToJSON(*chainman.m_blockman.m_block_tree_db));
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getvalidationstats()
+{
+    return RPCHelpMan{"getvalidationstats",
+                "\nReturns latency histograms of the stages of connecting blocks to the active chain since startup.\n"
+                "Bucket i counts the durations of at most bucket_bounds_us[i] microseconds that exceed the previous bound.\n"
+                "The last bucket counts the durations above the last bound.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::ARR, "bucket_bounds_us", "The inclusive upper bounds of the buckets in microseconds",
+                        {
+                            {RPCResult::Type::NUM, "", "Upper bound"},
+                        }},
+                        {RPCResult::Type::OBJ_DYN, "stages", "",
+                        {
+                            {RPCResult::Type::OBJ, "stage", "The histogram of a stage (inputs_fetch, conversion_eval, script_checks, undo_write, flush, remove_for_block, update_normalized_fees, connect_tip, coins_write)",
+                            {
+                                {RPCResult::Type::NUM, "count", "The number of recorded durations"},
+                                {RPCResult::Type::NUM, "total_us", "The sum of the recorded durations in microseconds"},
+                                {RPCResult::Type::ARR, "buckets", "The number of durations in each bucket",
+                                {
+                                    {RPCResult::Type::NUM, "", "Count"},
+                                }},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getvalidationstats", "")
+            + HelpExampleRpc("getvalidationstats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    using kernel::LatencyHistogram;
+    UniValue bounds(UniValue::VARR);
+    for (size_t i = 0; i + 1 < LatencyHistogram::NUM_BUCKETS; ++i) {
+        bounds.push_back(LatencyHistogram::BucketUpperBound(i));
+    }
+    UniValue stages(UniValue::VOBJ);
+    for (size_t i = 0; i < kernel::VALIDATION_STAGE_COUNT; ++i) {
+        const auto stage{static_cast<kernel::ValidationStage>(i)};
+        const LatencyHistogram::Snapshot snapshot{kernel::GetValidationStageHistogram(stage).GetSnapshot()};
+        UniValue buckets(UniValue::VARR);
+        for (const uint64_t count : snapshot.buckets) {
+            buckets.push_back(count);
+        }
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", snapshot.count);
+        obj.pushKV("total_us", snapshot.total_us);
+        obj.pushKV("buckets", buckets);
+        stages.pushKV(kernel::ValidationStageName(stage), obj);
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("bucket_bounds_us", bounds);
+    ret.pushKV("stages", stages);
+    return ret;
+},
+    };
+}
+
 static RPCHelpMan gettxout()
 {
     return RPCHelpMan{"gettxout",
@@ -1106,6 +1465,118 @@ static RPCHelpMan gettxout()
     };
 }
 
+static RPCHelpMan gettxouts()
+{
+    return RPCHelpMan{"gettxouts",
+        "\nReturns details about many transaction outputs at once, looked up under one lock and\n"
+        "with the uncached outputs read from the database in parallel.\n",
+        {
+            {"outputs", RPCArg::Type::ARR, RPCArg::Optional::NO, "The transaction outputs to look up.",
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                            {"vout", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number"},
+                        },
+                    },
+                },
+            },
+            {"include_mempool", RPCArg::Type::BOOL, RPCArg::Default{true}, "Whether to include the mempool. Note that an unspent output that is spent in the mempool won't appear."},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at the tip of the chain"},
+                {RPCResult::Type::ARR, "txouts", "The outputs in the order they were requested",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                        {RPCResult::Type::NUM, "vout", "The output number"},
+                        {RPCResult::Type::BOOL, "unspent", "Whether the output was found unspent. The fields below are only present if it was"},
+                        {RPCResult::Type::NUM, "confirmations", /*optional=*/true, "The number of confirmations"},
+                        {RPCResult::Type::STR, "amountType", /*optional=*/true, "The type of output amount ('cash' or 'bond')"},
+                        {RPCResult::Type::STR_AMOUNT, "value", /*optional=*/true, "The output value in " + CURRENCY_UNIT + ", scaled by the scale factor of bestblock"},
+                        {RPCResult::Type::STR_AMOUNT, "unscaledValue", /*optional=*/true, "The unscaled output value in " + CURRENCY_UNIT},
+                        {RPCResult::Type::STR_HEX, "scriptPubKey", /*optional=*/true, "The raw public key script bytes, hex-encoded"},
+                        {RPCResult::Type::BOOL, "coinbase", /*optional=*/true, "Coinbase or not"},
+                    }},
+                }},
+            }},
+        RPCExamples{
+            HelpExampleCli("gettxouts", "\"[{\\\"txid\\\":\\\"mytxid\\\",\\\"vout\\\":0}]\"")
+            + HelpExampleRpc("gettxouts", "[{\"txid\":\"mytxid\",\"vout\":0}]")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const UniValue& output_params = request.params[0].get_array();
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(output_params.size());
+    for (size_t idx = 0; idx < output_params.size(); ++idx) {
+        const UniValue& o = output_params[idx].get_obj();
+        RPCTypeCheckObj(o,
+                        {
+                            {"txid", UniValueType(UniValue::VSTR)},
+                            {"vout", UniValueType(UniValue::VNUM)},
+                        }, /*fAllowNull=*/false, /*fStrict=*/true);
+        const int vout{find_value(o, "vout").getInt<int>()};
+        if (vout < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, vout cannot be negative");
+        }
+        outpoints.emplace_back(ParseHashO(o, "txid"), vout);
+    }
+    const bool include_mempool{request.params[1].isNull() || request.params[1].get_bool()};
+
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    const CTxMemPool* mempool = include_mempool ? &EnsureMemPool(node) : nullptr;
+
+    LOCK(cs_main);
+    Chainstate& active_chainstate = chainman.ActiveChainstate();
+    CCoinsViewCache& coins_view = active_chainstate.CoinsTip();
+    active_chainstate.PrefetchCoins(outpoints);
+    const CBlockIndex* pindex = active_chainstate.m_blockman.LookupBlockIndex(coins_view.GetBestBlock());
+
+    UniValue txouts(UniValue::VARR);
+    const auto add_txout{[&](const COutPoint& out, const CCoinsView& view) {
+        UniValue o(UniValue::VOBJ);
+        o.pushKV("txid", out.hash.GetHex());
+        o.pushKV("vout", (uint64_t)out.n);
+        Coin coin;
+        if (!view.GetCoin(out, coin) || (mempool && mempool->isSpent(out))) {
+            o.pushKV("unspent", false);
+            txouts.push_back(o);
+            return;
+        }
+        o.pushKV("unspent", true);
+        if (coin.nHeight == MEMPOOL_HEIGHT) {
+            o.pushKV("confirmations", 0);
+        } else {
+            o.pushKV("confirmations", (int64_t)(pindex->nHeight - coin.nHeight + 1));
+        }
+        o.pushKV("amountType", ValueFromAmountType(coin.out.amountType));
+        o.pushKV("value", ValueFromAmount(ScaleAmount(coin.out.nValue, pindex->scaleFactor)));
+        o.pushKV("unscaledValue", ValueFromAmount(coin.out.nValue));
+        o.pushKV("scriptPubKey", HexStr(coin.out.scriptPubKey));
+        o.pushKV("coinbase", (bool)coin.fCoinBase);
+        txouts.push_back(o);
+    }};
+    if (mempool) {
+        LOCK(mempool->cs);
+        CCoinsViewMemPool view(&coins_view, *mempool);
+        for (const COutPoint& out : outpoints) add_txout(out, view);
+    } else {
+        for (const COutPoint& out : outpoints) add_txout(out, coins_view);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("bestblock", pindex->GetBlockHash().GetHex());
+    ret.pushKV("txouts", txouts);
+    return ret;
+},
+    };
+}
+
 static RPCHelpMan verifychain()
 {
     return RPCHelpMan{"verifychain",
@@ -1126,11 +1597,12 @@ static RPCHelpMan verifychain()
     const int check_level{request.params[0].isNull() ? DEFAULT_CHECKLEVEL : request.params[0].getInt<int>()};
     const int check_depth{request.params[1].isNull() ? DEFAULT_CHECKBLOCKS : request.params[1].getInt<int>()};
 
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
     LOCK(cs_main);
 
     Chainstate& active_chainstate = chainman.ActiveChainstate();
-    return CVerifyDB().VerifyDB(
+    return CVerifyDB(node.thread_pool.get()).VerifyDB(
         active_chainstate, chainman.GetParams().GetConsensus(), active_chainstate.CoinsTip(), check_level, check_depth);
 },
     };
@@ -1744,93 +2216,57 @@ static inline bool SetHasKeys(const std::set<T>& set, const Tk& key, const Args&
 // outpoint (needed for the utxo index) + nHeight + fCoinBase
 static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
 
-static RPCHelpMan getblockstats()
-{
-    return RPCHelpMan{"getblockstats",
-                "\nCompute per block statistics for a given window. All amounts are in satoshis.\n"
-                "It won't work for some heights with pruning.\n",
-                {
-                    {"hash_or_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The block hash or height of the target block", "", {"", "string or numeric"}},
-                    {"stats", RPCArg::Type::ARR, RPCArg::DefaultHint{"all values"}, "Values to plot (see result below)",
-                        {
-                            {"height", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
-                            {"time", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
-                        },
-                        "stats"},
-                },
-                RPCResult{
-            RPCResult::Type::OBJ, "", "",
-            {
-                {RPCResult::Type::NUM, "avgfee", /*optional=*/true, "Average fee in the block"},
-                {RPCResult::Type::NUM, "avgfeerate", /*optional=*/true, "Average feerate (in satoshis per virtual byte)"},
-                {RPCResult::Type::NUM, "avgtxsize", /*optional=*/true, "Average transaction size"},
-                {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "The block hash (to check for potential reorgs)"},
-                {RPCResult::Type::ARR_FIXED, "feerate_percentiles", /*optional=*/true, "Feerates at the 10th, 25th, 50th, 75th, and 90th percentile weight unit (in satoshis per virtual byte)",
-                {
-                    {RPCResult::Type::NUM, "10th_percentile_feerate", "The 10th percentile feerate"},
-                    {RPCResult::Type::NUM, "25th_percentile_feerate", "The 25th percentile feerate"},
-                    {RPCResult::Type::NUM, "50th_percentile_feerate", "The 50th percentile feerate"},
-                    {RPCResult::Type::NUM, "75th_percentile_feerate", "The 75th percentile feerate"},
-                    {RPCResult::Type::NUM, "90th_percentile_feerate", "The 90th percentile feerate"},
-                }},
-                {RPCResult::Type::NUM, "height", /*optional=*/true, "The height of the block"},
-                {RPCResult::Type::NUM, "ins", /*optional=*/true, "The number of inputs (excluding coinbase)"},
-                {RPCResult::Type::NUM, "maxfee", /*optional=*/true, "Maximum fee in the block"},
-                {RPCResult::Type::NUM, "maxfeerate", /*optional=*/true, "Maximum feerate (in satoshis per virtual byte)"},
-                {RPCResult::Type::NUM, "maxtxsize", /*optional=*/true, "Maximum transaction size"},
-                {RPCResult::Type::NUM, "medianfee", /*optional=*/true, "Truncated median fee in the block"},
-                {RPCResult::Type::NUM, "mediantime", /*optional=*/true, "The block median time past"},
-                {RPCResult::Type::NUM, "mediantxsize", /*optional=*/true, "Truncated median transaction size"},
-                {RPCResult::Type::NUM, "minfee", /*optional=*/true, "Minimum fee in the block"},
-                {RPCResult::Type::NUM, "minfeerate", /*optional=*/true, "Minimum feerate (in satoshis per virtual byte)"},
-                {RPCResult::Type::NUM, "mintxsize", /*optional=*/true, "Minimum transaction size"},
-                {RPCResult::Type::NUM, "outs", /*optional=*/true, "The number of outputs"},
-                {RPCResult::Type::NUM, "subsidy", /*optional=*/true, "The block subsidy"},
-                {RPCResult::Type::NUM, "swtotal_size", /*optional=*/true, "Total size of all segwit transactions"},
-                {RPCResult::Type::NUM, "swtotal_weight", /*optional=*/true, "Total weight of all segwit transactions"},
-                {RPCResult::Type::NUM, "swtxs", /*optional=*/true, "The number of segwit transactions"},
-                {RPCResult::Type::NUM, "swtxs", /*optional=*/true, "The number of conversion transactions"},
-                {RPCResult::Type::NUM, "time", /*optional=*/true, "The block time"},
-                {RPCResult::Type::NUM, "total_out_unscaled_cash", /*optional=*/true, "Unscaled total cash amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])"},
-                {RPCResult::Type::NUM, "total_out_unscaled_bond", /*optional=*/true, "Unscaled total bond amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])"},
-                {RPCResult::Type::NUM, "total_out_normalized", /*optional=*/true, "Normalized unscaled total amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])"},
-                {RPCResult::Type::NUM, "total_size", /*optional=*/true, "Total size of all non-coinbase transactions"},
-                {RPCResult::Type::NUM, "total_weight", /*optional=*/true, "Total weight of all non-coinbase transactions"},
-                {RPCResult::Type::NUM, "totalfee", /*optional=*/true, "The fee total"},
-                {RPCResult::Type::NUM, "txs", /*optional=*/true, "The number of transactions (including coinbase)"},
-                {RPCResult::Type::NUM, "utxo_increase", /*optional=*/true, "The increase/decrease in the number of unspent outputs"},
-                {RPCResult::Type::NUM, "utxo_size_inc", /*optional=*/true, "The increase/decrease in size for the utxo index (not discounting op_return and similar)"},
-            }},
-                RPCExamples{
-                    HelpExampleCli("getblockstats", R"('"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09"' '["minfeerate","avgfeerate"]')") +
-                    HelpExampleCli("getblockstats", R"(1000 '["minfeerate","avgfeerate"]')") +
-                    HelpExampleRpc("getblockstats", R"("00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09", ["minfeerate","avgfeerate"])") +
-                    HelpExampleRpc("getblockstats", R"(1000, ["minfeerate","avgfeerate"])")
-                },
-        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
-{
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
-    const CBlockIndex& pindex{*CHECK_NONFATAL(ParseHashOrHeight(request.params[0], chainman))};
+/** Maximum number of blocks whose statistics are kept in g_block_stats_cache */
+static constexpr size_t MAX_BLOCK_STATS_CACHE_SIZE{2000};
 
-    std::set<std::string> stats;
-    if (!request.params[1].isNull()) {
-        const UniValue stats_univalue = request.params[1].get_array();
-        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
-            const std::string stat = stats_univalue[i].get_str();
-            stats.insert(stat);
-        }
+/**
+ * All statistics of the blocks computed most recently, by block hash. They only
+ * depend on the block and its ancestors, so they remain valid across reorgs.
+ * Blocks are evicted in the order they were added.
+ */
+static GlobalMutex g_block_stats_cache_mutex;
+static std::unordered_map<uint256, UniValue, BlockHasher> g_block_stats_cache GUARDED_BY(g_block_stats_cache_mutex);
+static std::deque<uint256> g_block_stats_cache_order GUARDED_BY(g_block_stats_cache_mutex);
+
+/** Where getblockstats reads a block from, checked under cs_main for pruning */
+static FlatFilePos GetBlockStatsPos(BlockManager& blockman, const CBlockIndex& pindex) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+{
+    if (blockman.IsBlockPruned(&pindex)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
     }
+    return pindex.GetBlockPos();
+}
 
-    const CBlock& block = GetBlockChecked(chainman.m_blockman, &pindex);
-    const CBlockUndo& blockUndo = GetUndoChecked(chainman.m_blockman, &pindex);
+/**
+ * Compute the selected statistics of a block, or all of them if none is
+ * selected. The block and its undo data are read without holding cs_main.
+ */
+static UniValue ComputeBlockStats(const CBlockIndex& pindex, const FlatFilePos& block_pos, const Consensus::Params& consensus, const std::set<std::string>& stats)
+{
+    // Only a few fields of each transaction are needed, so read them from the serialized block
+    std::vector<uint8_t> block_data;
+    if (!ReadRawBlockFromDisk(block_data, block_pos, Params().MessageStart())) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+    const BlockView block{block_data};
+    CAmounts total_supply = {0};
+    total_supply[CASH] = block.GetHeader().cashSupply;
+    total_supply[BOND] = block.GetHeader().bondSupply;
+    const size_t num_txs{block.GetTransactionCount()};
+    // The genesis block has no undo data, nor inputs that would need it
+    CBlockUndo blockUndo;
+    if (pindex.pprev && !UndoReadFromDisk(blockUndo, &pindex)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Can't read undo data from disk");
+    }
 
     const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
     const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
     const bool do_medianfee = do_all || stats.count("medianfee") != 0;
     const bool do_feerate_percentiles = do_all || stats.count("feerate_percentiles") != 0;
     const bool loop_inputs = do_all || do_medianfee || do_feerate_percentiles ||
-        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee", "minfeerate", "maxfeerate");
+        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee", "minfeerate", "maxfeerate", "totalfee_cash", "totalfee_bond") ||
+        SetHasKeys(stats, "conversions_cash_to_bond", "conversions_cash_to_bond_in", "conversions_cash_to_bond_out", "conversions_bond_to_cash",
+                   "conversions_bond_to_cash_in", "conversions_bond_to_cash_out", "remainder_cash", "remainder_bond");
     const bool loop_outputs = do_all || loop_inputs || stats.count("total_out");
     const bool do_calculate_size = do_mediantxsize ||
         SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize", "maxtxsize", "swtotal_size");
@@ -1843,6 +2279,7 @@ static RPCHelpMan getblockstats()
     CAmount minfeerate = MAX_MONEY;
     CAmounts total_out = {0};
     CAmount totalfee = 0;
+    CAmounts totalfees = {0};
     int64_t inputs = 0;
     int64_t maxtxsize = 0;
     int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
@@ -1857,39 +2294,44 @@ static RPCHelpMan getblockstats()
     std::vector<CAmount> fee_array;
     std::vector<std::pair<CAmount, int64_t>> feerate_array;
     std::vector<int64_t> txsize_array;
-
-    for (size_t i = 0; i < block.vtx.size(); ++i) {
-        const auto& tx = block.vtx.at(i);
-        outputs += tx->vout.size();
-
-        std::optional<CTxOut> conversion_out;
+    // Conversions are replayed on the supply before the block to recover their remainders, as ConnectBlock does
+    CAmounts supply{pindex.pprev ? pindex.pprev->GetTotalSupply() : CAmounts{0}};
+    CAmounts conversion_count = {0};
+    CAmounts conversion_in = {0};
+    CAmounts conversion_out_amount = {0};
+    CAmounts remainders = {0};
+
+    size_t i{0};
+    block.ForEachTransaction([&](const TransactionView& tx) {
+        const size_t tx_index{i++};
+        outputs += tx.GetOutputCount();
+
+        std::optional<TxOutView> conversion_out;
         CAmounts tx_total_out = {0};
         if (loop_outputs) {
-            for (const CTxOut& out : tx->vout) {
-                utxo_size_inc += GetSerializeSize(out, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-                if (out.scriptPubKey.IsConversionScript()) {
+            tx.ForEachOutput([&](const TxOutView& out) {
+                utxo_size_inc += out.GetSerializeSize() + PER_UTXO_OVERHEAD;
+                if (out.IsConversionScript()) {
                     // Do not count the conversion output amount because it is a fee for the miner
                     conversion_out = out;
                     conversiontxs += 1;
                 } else {
                     tx_total_out[out.amountType] += out.nValue;
                 }
-            }
+            });
         }
 
-        if (tx->IsCoinBase()) {
-            continue;
+        if (tx.IsCoinBase()) {
+            return;
         }
 
-        // TODO: Count conversion remainders
-
-        inputs += tx->vin.size(); // Don't count coinbase's fake input
+        inputs += tx.GetInputCount(); // Don't count coinbase's fake input
         total_out[CASH] += tx_total_out[CASH]; // Don't count coinbase reward
         total_out[BOND] += tx_total_out[BOND]; // Don't count coinbase reward
 
         int64_t tx_size = 0;
         if (do_calculate_size) {
-            tx_size = tx->GetTotalSize();
+            tx_size = tx.GetTotalSize();
             if (do_mediantxsize) {
                 txsize_array.push_back(tx_size);
             }
@@ -1900,11 +2342,21 @@ static RPCHelpMan getblockstats()
 
         int64_t weight = 0;
         if (do_calculate_weight) {
-            weight = GetTransactionWeight(*tx);
+            weight = tx.GetWeight();
+            // Only transactions starting with a conversion output pay for a remainder output
+            tx.ForEachOutput([&, first = true](const TxOutView& out) mutable {
+                if (first && out.IsConversionScript()) {
+                    CTxConversionInfo conversion_info;
+                    if (ExtractConversionInfo(CScript(out.scriptPubKey.begin(), out.scriptPubKey.end()), conversion_info)) {
+                        weight += GetRemainderOutputWeight(conversion_info);
+                    }
+                }
+                first = false;
+            });
             total_weight += weight;
         }
 
-        if (do_calculate_sw && tx->HasWitness()) {
+        if (do_calculate_sw && tx.HasWitness()) {
             ++swtxs;
             swtotal_size += tx_size;
             swtotal_weight += weight;
@@ -1912,7 +2364,7 @@ static RPCHelpMan getblockstats()
 
         if (loop_inputs) {
             CAmounts tx_total_in = {0};
-            const auto& txundo = blockUndo.vtxundo.at(i - 1);
+            const auto& txundo = blockUndo.vtxundo.at(tx_index - 1);
             for (const Coin& coin: txundo.vprevout) {
                 const CTxOut& prevoutput = coin.out;
 
@@ -1923,13 +2375,29 @@ static RPCHelpMan getblockstats()
             CAmounts txfees = {0};
             if (conversion_out.has_value()) {
                 txfees[conversion_out.value().amountType] = conversion_out.value().nValue;
+
+                CTxConversionInfo conversion_info;
+                if (ExtractConversionInfo(CScript(conversion_out->scriptPubKey.begin(), conversion_out->scriptPubKey.end()), conversion_info)) {
+                    CAmounts tx_all_out{tx_total_out};
+                    tx_all_out[conversion_out->amountType] += conversion_out->nValue;
+                    CAmount remainder;
+                    CHECK_NONFATAL(Consensus::IsValidConversion(supply, tx_total_in, tx_all_out, conversion_info.remainderType, remainder));
+                    remainders[conversion_info.remainderType] += remainder;
+                    // The currency the conversion created less of than it spent is the one converted from
+                    tx_all_out[conversion_info.remainderType] += remainder;
+                    const CAmountType from{tx_all_out[CASH] < tx_total_in[CASH] ? CASH : BOND};
+                    const CAmountType to{from == CASH ? BOND : CASH};
+                    ++conversion_count[from];
+                    conversion_in[from] += tx_total_in[from] - tx_all_out[from];
+                    conversion_out_amount[to] += tx_all_out[to] - tx_total_in[to];
+                }
             } else {
                 txfees[CASH] = tx_total_in[CASH] - tx_total_out[CASH];
                 txfees[BOND] = tx_total_in[BOND] - tx_total_out[BOND];
             }
 
             // Normalize the transaction fee
-            CAmount txfee = txfees[CASH] + GetConvertedAmount(block.GetTotalSupply(), txfees[BOND], BOND);
+            CAmount txfee = txfees[CASH] + GetConvertedAmount(total_supply, txfees[BOND], BOND);
             CHECK_NONFATAL(MoneyRange(txfee));
             if (do_medianfee) {
                 fee_array.push_back(txfee);
@@ -1937,6 +2405,8 @@ static RPCHelpMan getblockstats()
             maxfee = std::max(maxfee, txfee);
             minfee = std::min(minfee, txfee);
             totalfee += txfee;
+            totalfees[CASH] += txfees[CASH];
+            totalfees[BOND] += txfees[BOND];
 
             // New feerate uses satoshis per virtual byte instead of per serialized byte
             CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
@@ -1946,7 +2416,7 @@ static RPCHelpMan getblockstats()
             maxfeerate = std::max(maxfeerate, feerate);
             minfeerate = std::min(minfeerate, feerate);
         }
-    }
+    });
 
     CAmount feerate_percentiles[NUM_GETBLOCKSTATS_PERCENTILES] = { 0 };
     CalculatePercentilesByWeight(feerate_percentiles, feerate_array, total_weight);
@@ -1957,13 +2427,20 @@ static RPCHelpMan getblockstats()
     }
 
     UniValue ret_all(UniValue::VOBJ);
-    ret_all.pushKV("avgfee", (block.vtx.size() > 1) ? totalfee / (block.vtx.size() - 1) : 0);
+    ret_all.pushKV("avgfee", (num_txs > 1) ? totalfee / (num_txs - 1) : 0);
     ret_all.pushKV("avgfeerate", total_weight ? (totalfee * WITNESS_SCALE_FACTOR) / total_weight : 0); // Unit: sat/vbyte
-    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1) ? total_size / (block.vtx.size() - 1) : 0);
+    ret_all.pushKV("avgtxsize", (num_txs > 1) ? total_size / (num_txs - 1) : 0);
     ret_all.pushKV("blockhash", pindex.GetBlockHash().GetHex());
+    ret_all.pushKV("conversions_bond_to_cash", conversion_count[BOND]);
+    ret_all.pushKV("conversions_bond_to_cash_in", conversion_in[BOND]);
+    ret_all.pushKV("conversions_bond_to_cash_out", conversion_out_amount[CASH]);
+    ret_all.pushKV("conversions_cash_to_bond", conversion_count[CASH]);
+    ret_all.pushKV("conversions_cash_to_bond_in", conversion_in[CASH]);
+    ret_all.pushKV("conversions_cash_to_bond_out", conversion_out_amount[BOND]);
     ret_all.pushKV("feerate_percentiles", feerates_res);
     ret_all.pushKV("height", (int64_t)pindex.nHeight);
     ret_all.pushKV("ins", inputs);
+    ret_all.pushKV("interest_rate", pindex.GetInterestRate());
     ret_all.pushKV("maxfee", maxfee);
     ret_all.pushKV("maxfeerate", maxfeerate);
     ret_all.pushKV("maxtxsize", maxtxsize);
@@ -1974,7 +2451,10 @@ static RPCHelpMan getblockstats()
     ret_all.pushKV("minfeerate", (minfeerate == MAX_MONEY) ? 0 : minfeerate);
     ret_all.pushKV("mintxsize", mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize);
     ret_all.pushKV("outs", outputs);
-    ret_all.pushKV("subsidy", GetBlockSubsidy(pindex.nHeight, chainman.GetParams().GetConsensus()));
+    ret_all.pushKV("remainder_bond", remainders[BOND]);
+    ret_all.pushKV("remainder_cash", remainders[CASH]);
+    ret_all.pushKV("scale_factor", pindex.scaleFactor);
+    ret_all.pushKV("subsidy", GetBlockSubsidy(pindex.nHeight, consensus));
     ret_all.pushKV("swtotal_size", swtotal_size);
     ret_all.pushKV("swtotal_weight", swtotal_weight);
     ret_all.pushKV("swtxs", swtxs);
@@ -1982,15 +2462,59 @@ static RPCHelpMan getblockstats()
     ret_all.pushKV("time", pindex.GetBlockTime());
     ret_all.pushKV("total_out_unscaled_cash", total_out[CASH]);
     ret_all.pushKV("total_out_unscaled_bond", total_out[BOND]);
-    ret_all.pushKV("total_out_normalized", total_out[CASH] + GetConvertedAmount(block.GetTotalSupply(), total_out[BOND], BOND));
+    ret_all.pushKV("total_out_normalized", total_out[CASH] + GetConvertedAmount(total_supply, total_out[BOND], BOND));
     ret_all.pushKV("total_size", total_size);
     ret_all.pushKV("total_weight", total_weight);
     ret_all.pushKV("totalfee", totalfee);
-    ret_all.pushKV("txs", (int64_t)block.vtx.size());
+    ret_all.pushKV("totalfee_bond", totalfees[BOND]);
+    ret_all.pushKV("totalfee_cash", totalfees[CASH]);
+    ret_all.pushKV("txs", (int64_t)num_txs);
     ret_all.pushKV("utxo_increase", outputs - inputs);
     ret_all.pushKV("utxo_size_inc", utxo_size_inc);
 
-    if (do_all) {
+    return ret_all;
+}
+
+/** The statistics of a block, from g_block_stats_cache if it has them. Computing all of them adds them to it. */
+static UniValue GetBlockStats(const CBlockIndex& pindex, const FlatFilePos& block_pos, const Consensus::Params& consensus, const std::set<std::string>& stats)
+{
+    const uint256 hash{pindex.GetBlockHash()};
+    {
+        LOCK(g_block_stats_cache_mutex);
+        const auto it{g_block_stats_cache.find(hash)};
+        if (it != g_block_stats_cache.end()) return it->second;
+    }
+    UniValue result{ComputeBlockStats(pindex, block_pos, consensus, stats)};
+    if (stats.empty()) {
+        LOCK(g_block_stats_cache_mutex);
+        if (g_block_stats_cache.emplace(hash, result).second) {
+            g_block_stats_cache_order.push_back(hash);
+            if (g_block_stats_cache_order.size() > MAX_BLOCK_STATS_CACHE_SIZE) {
+                g_block_stats_cache.erase(g_block_stats_cache_order.front());
+                g_block_stats_cache_order.pop_front();
+            }
+        }
+    }
+    return result;
+}
+
+static std::set<std::string> ParseBlockStats(const UniValue& param)
+{
+    std::set<std::string> stats;
+    if (!param.isNull()) {
+        const UniValue stats_univalue = param.get_array();
+        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
+            const std::string stat = stats_univalue[i].get_str();
+            stats.insert(stat);
+        }
+    }
+    return stats;
+}
+
+/** Select the requested statistics from those of a block, or return all of them if none is selected */
+static UniValue SelectBlockStats(const UniValue& ret_all, const std::set<std::string>& stats)
+{
+    if (stats.empty()) {
         return ret_all;
     }
 
@@ -2003,20 +2527,209 @@ static RPCHelpMan getblockstats()
         ret.pushKV(stat, value);
     }
     return ret;
+}
+
+static std::vector<RPCResult> BlockStatsDoc()
+{
+    return {
+        {RPCResult::Type::NUM, "avgfee", /*optional=*/true, "Average fee in the block"},
+        {RPCResult::Type::NUM, "avgfeerate", /*optional=*/true, "Average feerate (in satoshis per virtual byte)"},
+        {RPCResult::Type::NUM, "avgtxsize", /*optional=*/true, "Average transaction size"},
+        {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "The block hash (to check for potential reorgs)"},
+        {RPCResult::Type::ARR_FIXED, "feerate_percentiles", /*optional=*/true, "Feerates at the 10th, 25th, 50th, 75th, and 90th percentile weight unit (in satoshis per virtual byte)",
+        {
+            {RPCResult::Type::NUM, "10th_percentile_feerate", "The 10th percentile feerate"},
+            {RPCResult::Type::NUM, "25th_percentile_feerate", "The 25th percentile feerate"},
+            {RPCResult::Type::NUM, "50th_percentile_feerate", "The 50th percentile feerate"},
+            {RPCResult::Type::NUM, "75th_percentile_feerate", "The 75th percentile feerate"},
+            {RPCResult::Type::NUM, "90th_percentile_feerate", "The 90th percentile feerate"},
+        }},
+        {RPCResult::Type::NUM, "conversions_bond_to_cash", /*optional=*/true, "The number of conversions from bonds to cash"},
+        {RPCResult::Type::NUM, "conversions_bond_to_cash_in", /*optional=*/true, "Unscaled bonds converted to cash"},
+        {RPCResult::Type::NUM, "conversions_bond_to_cash_out", /*optional=*/true, "Unscaled cash received for bonds"},
+        {RPCResult::Type::NUM, "conversions_cash_to_bond", /*optional=*/true, "The number of conversions from cash to bonds"},
+        {RPCResult::Type::NUM, "conversions_cash_to_bond_in", /*optional=*/true, "Unscaled cash converted to bonds"},
+        {RPCResult::Type::NUM, "conversions_cash_to_bond_out", /*optional=*/true, "Unscaled bonds received for cash"},
+        {RPCResult::Type::NUM, "height", /*optional=*/true, "The height of the block"},
+        {RPCResult::Type::NUM, "interest_rate", /*optional=*/true, "The interest rate after the block, in basis points"},
+        {RPCResult::Type::NUM, "ins", /*optional=*/true, "The number of inputs (excluding coinbase)"},
+        {RPCResult::Type::NUM, "maxfee", /*optional=*/true, "Maximum fee in the block"},
+        {RPCResult::Type::NUM, "maxfeerate", /*optional=*/true, "Maximum feerate (in satoshis per virtual byte)"},
+        {RPCResult::Type::NUM, "maxtxsize", /*optional=*/true, "Maximum transaction size"},
+        {RPCResult::Type::NUM, "medianfee", /*optional=*/true, "Truncated median fee in the block"},
+        {RPCResult::Type::NUM, "mediantime", /*optional=*/true, "The block median time past"},
+        {RPCResult::Type::NUM, "mediantxsize", /*optional=*/true, "Truncated median transaction size"},
+        {RPCResult::Type::NUM, "minfee", /*optional=*/true, "Minimum fee in the block"},
+        {RPCResult::Type::NUM, "minfeerate", /*optional=*/true, "Minimum feerate (in satoshis per virtual byte)"},
+        {RPCResult::Type::NUM, "mintxsize", /*optional=*/true, "Minimum transaction size"},
+        {RPCResult::Type::NUM, "outs", /*optional=*/true, "The number of outputs"},
+        {RPCResult::Type::NUM, "remainder_bond", /*optional=*/true, "Unscaled total of the bond conversion remainders"},
+        {RPCResult::Type::NUM, "remainder_cash", /*optional=*/true, "Unscaled total of the cash conversion remainders"},
+        {RPCResult::Type::NUM, "scale_factor", /*optional=*/true, "The scale factor of the block, where 10000000000 is 1"},
+        {RPCResult::Type::NUM, "subsidy", /*optional=*/true, "The block subsidy"},
+        {RPCResult::Type::NUM, "swtotal_size", /*optional=*/true, "Total size of all segwit transactions"},
+        {RPCResult::Type::NUM, "swtotal_weight", /*optional=*/true, "Total weight of all segwit transactions"},
+        {RPCResult::Type::NUM, "swtxs", /*optional=*/true, "The number of segwit transactions"},
+        {RPCResult::Type::NUM, "conversiontxs", /*optional=*/true, "The number of conversion transactions"},
+        {RPCResult::Type::NUM, "time", /*optional=*/true, "The block time"},
+        {RPCResult::Type::NUM, "total_out_unscaled_cash", /*optional=*/true, "Unscaled total cash amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])"},
+        {RPCResult::Type::NUM, "total_out_unscaled_bond", /*optional=*/true, "Unscaled total bond amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])"},
+        {RPCResult::Type::NUM, "total_out_normalized", /*optional=*/true, "Normalized unscaled total amount in all outputs (excluding coinbase and thus reward [ie subsidy + totalfee])"},
+        {RPCResult::Type::NUM, "total_size", /*optional=*/true, "Total size of all non-coinbase transactions"},
+        {RPCResult::Type::NUM, "total_weight", /*optional=*/true, "Total weight of all non-coinbase transactions"},
+        {RPCResult::Type::NUM, "totalfee", /*optional=*/true, "The fee total"},
+        {RPCResult::Type::NUM, "totalfee_bond", /*optional=*/true, "The unscaled total of the fees paid in bonds, before normalization"},
+        {RPCResult::Type::NUM, "totalfee_cash", /*optional=*/true, "The unscaled total of the fees paid in cash"},
+        {RPCResult::Type::NUM, "txs", /*optional=*/true, "The number of transactions (including coinbase)"},
+        {RPCResult::Type::NUM, "utxo_increase", /*optional=*/true, "The increase/decrease in the number of unspent outputs"},
+        {RPCResult::Type::NUM, "utxo_size_inc", /*optional=*/true, "The increase/decrease in size for the utxo index (not discounting op_return and similar)"},
+    };
+}
+
+static RPCHelpMan getblockstats()
+{
+    return RPCHelpMan{"getblockstats",
+                "\nCompute per block statistics for a given window. All amounts are in satoshis.\n"
+                "It won't work for some heights with pruning.\n",
+                {
+                    {"hash_or_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The block hash or height of the target block", "", {"", "string or numeric"}},
+                    {"stats", RPCArg::Type::ARR, RPCArg::DefaultHint{"all values"}, "Values to plot (see result below)",
+                        {
+                            {"height", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
+                            {"time", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
+                        },
+                        "stats"},
+                },
+                RPCResult{RPCResult::Type::OBJ, "", "", BlockStatsDoc()},
+                RPCExamples{
+                    HelpExampleCli("getblockstats", R"('"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09"' '["minfeerate","avgfeerate"]')") +
+                    HelpExampleCli("getblockstats", R"(1000 '["minfeerate","avgfeerate"]')") +
+                    HelpExampleRpc("getblockstats", R"("00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09", ["minfeerate","avgfeerate"])") +
+                    HelpExampleRpc("getblockstats", R"(1000, ["minfeerate","avgfeerate"])")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const std::set<std::string> stats{ParseBlockStats(request.params[1])};
+    const CBlockIndex* pindex;
+    FlatFilePos block_pos;
+    {
+        LOCK(cs_main);
+        pindex = CHECK_NONFATAL(ParseHashOrHeight(request.params[0], chainman));
+        block_pos = GetBlockStatsPos(chainman.m_blockman, *pindex);
+    }
+    return SelectBlockStats(GetBlockStats(*pindex, block_pos, chainman.GetParams().GetConsensus(), stats), stats);
+},
+    };
+}
+
+static RPCHelpMan getblockstatsrange()
+{
+    return RPCHelpMan{"getblockstatsrange",
+                "\nCompute per block statistics for a range of blocks of the active chain, reading and computing the blocks in parallel.\n"
+                "The statistics of recently computed blocks are cached, so repeated queries are cheap. All amounts are in satoshis.\n"
+                "It won't work for some heights with pruning.\n",
+                {
+                    {"start_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The height of the first block in the range"},
+                    {"end_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The height of the last block in the range"},
+                    {"stats", RPCArg::Type::ARR, RPCArg::DefaultHint{"all values"}, "Values to plot (see result of getblockstats)",
+                        {
+                            {"height", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
+                            {"time", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
+                        },
+                        "stats"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "The statistics of each block, in order of height",
+                    {
+                        {RPCResult::Type::OBJ, "", "", {{RPCResult::Type::ELISION, "", "The same output as getblockstats"}}},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getblockstatsrange", R"(1000 2000 '["minfeerate","avgfeerate"]')") +
+                    HelpExampleRpc("getblockstatsrange", R"(1000, 2000, ["minfeerate","avgfeerate"])")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const std::set<std::string> stats{ParseBlockStats(request.params[2])};
+    std::vector<std::pair<const CBlockIndex*, FlatFilePos>> blocks;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = chainman.ActiveChain();
+        const int start_height{request.params[0].getInt<int>()};
+        const int end_height{request.params[1].getInt<int>()};
+        if (start_height < 0 || end_height > active_chain.Height()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+        }
+        if (start_height > end_height) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "start_height must not be greater than end_height");
+        }
+        blocks.reserve(end_height - start_height + 1);
+        for (int height = start_height; height <= end_height; ++height) {
+            const CBlockIndex* pindex{active_chain[height]};
+            blocks.emplace_back(pindex, GetBlockStatsPos(chainman.m_blockman, *pindex));
+        }
+    }
+
+    // All statistics are computed, so that they are cached for any later selection
+    const Consensus::Params& consensus{chainman.GetParams().GetConsensus()};
+    std::vector<UniValue> results(blocks.size());
+    std::optional<util::TaskPool> pool;
+    if (util::ThreadPool* thread_pool{EnsureAnyNodeContext(request.context).thread_pool.get()}) {
+        pool.emplace(*thread_pool, "getblockstatsrange", util::TaskPriority::NORMAL);
+    }
+    util::ParallelFor(pool ? &*pool : nullptr, blocks.size(), pool ? pool->GetThreadPool().GetThreadCount() : 1, [&](size_t i) {
+        results[i] = SelectBlockStats(GetBlockStats(*blocks[i].first, blocks[i].second, consensus, {}), stats);
+    });
+
+    UniValue ret(UniValue::VARR);
+    for (UniValue& result : results) {
+        ret.push_back(std::move(result));
+    }
+    return ret;
 },
     };
 }
 
 namespace {
-//! Search for a given set of pubkey scripts
-bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>& should_abort, int64_t& count, CCoinsViewCursor* cursor, const std::set<CScript>& needles, std::map<COutPoint, Coin>& out_results, std::function<void()>& interruption_point)
+/** Number of key ranges scantxoutset splits the txout set into, one per first byte of the txid */
+constexpr size_t SCAN_RANGE_COUNT{256};
+
+/** Hex-encoded bitmap of the ranges a scan has completed, to resume it from */
+std::string EncodeScanCursor(const std::vector<bool>& done)
+{
+    std::vector<unsigned char> bits(SCAN_RANGE_COUNT / 8);
+    for (size_t range = 0; range < SCAN_RANGE_COUNT; ++range) {
+        if (done[range]) bits[range / 8] |= 1 << (range % 8);
+    }
+    return HexStr(bits);
+}
+
+std::vector<bool> DecodeScanCursor(const std::string& cursor)
 {
-    scan_progress = 0;
-    count = 0;
-    while (cursor->Valid()) {
+    if (cursor.size() != SCAN_RANGE_COUNT / 4 || !IsHex(cursor)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor, expected one returned by an aborted scan");
+    }
+    const std::vector<unsigned char> bits{ParseHex(cursor)};
+    std::vector<bool> done(SCAN_RANGE_COUNT);
+    for (size_t range = 0; range < SCAN_RANGE_COUNT; ++range) {
+        done[range] = bits[range / 8] & (1 << (range % 8));
+    }
+    return done;
+}
+
+//! Search the coins whose txid starts with the byte range for a given set of pubkey scripts
+bool FindScriptPubKey(const std::atomic<bool>& should_abort, int64_t& count, CCoinsViewCursor& cursor, uint8_t range, const std::unordered_set<CScript, SaltedSipHasher>& needles, std::map<COutPoint, Coin>& out_results, const std::function<void()>& interruption_point)
+{
+    uint256 start;
+    *start.begin() = range;
+    cursor.Seek(COutPoint{start, 0});
+    while (cursor.Valid()) {
         COutPoint key;
         Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) return false;
+        if (!cursor.GetKey(key)) return false;
+        if (*key.hash.begin() != range) break;
+        if (!cursor.GetValue(coin)) return false;
         if (++count % 8192 == 0) {
             interruption_point();
             if (should_abort) {
@@ -2024,17 +2737,11 @@ bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>&
                 return false;
             }
         }
-        if (count % 256 == 0) {
-            // update progress reference every 256 item
-            uint32_t high = 0x100 * *key.hash.begin() + *(key.hash.begin() + 1);
-            scan_progress = (int)(high * 100.0 / 65536.0 + 0.5);
-        }
         if (needles.count(coin.out.scriptPubKey)) {
             out_results.emplace(key, coin);
         }
-        cursor->Next();
+        cursor.Next();
     }
-    scan_progress = 100;
     return true;
 }
 } // namespace
@@ -2102,10 +2809,13 @@ static RPCHelpMan scantxoutset()
                 }},
             },
                         "[scanobjects,...]"},
+            {"cursor", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED_NAMED_ARG, "For \"start\", the cursor returned by an aborted scan. Only the parts of the\n"
+                "txout set that scan did not complete are scanned, and only their outputs are returned."},
         },
         {
             RPCResult{"when action=='start'; only returns after scan completes", RPCResult::Type::OBJ, "", "", {
                 {RPCResult::Type::BOOL, "success", "Whether the scan was completed"},
+                {RPCResult::Type::STR_HEX, "cursor", /*optional=*/true, "If the scan was aborted, the cursor to resume it from"},
                 {RPCResult::Type::NUM, "txouts", "The number of unspent transaction outputs scanned"},
                 {RPCResult::Type::NUM, "height", "The current block height (index)"},
                 {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at the tip of the chain"},
@@ -2119,11 +2829,14 @@ static RPCHelpMan scantxoutset()
                         {RPCResult::Type::STR, "desc", "A specialized descriptor for the matched scriptPubKey"},
                         {RPCResult::Type::STR, "amountType", "The type of output amount ('cash' or 'bond')"},
                         {RPCResult::Type::STR_AMOUNT, "amount", "The unscaled total amount in " + CURRENCY_UNIT + " of the unspent output"},
+                        {RPCResult::Type::STR_AMOUNT, "scaled_amount", "The amount in " + CURRENCY_UNIT + " of the unspent output, scaled by the scale factor of bestblock"},
                         {RPCResult::Type::NUM, "height", "Height of the unspent transaction output"},
                     }},
                 }},
                 {RPCResult::Type::STR_AMOUNT, "total_cash_amount", "The unscaled total amount of all found unspent cash outputs in " + CURRENCY_UNIT},
                 {RPCResult::Type::STR_AMOUNT, "total_bond_amount", "The unscaled total amount of all found unspent bond outputs in " + CURRENCY_UNIT},
+                {RPCResult::Type::STR_AMOUNT, "total_scaled_cash_amount", "The total amount of all found unspent cash outputs in " + CURRENCY_UNIT + ", scaled by the scale factor of bestblock"},
+                {RPCResult::Type::STR_AMOUNT, "total_scaled_bond_amount", "The total amount of all found unspent bond outputs in " + CURRENCY_UNIT + ", scaled by the scale factor of bestblock"},
             }},
             RPCResult{"when action=='abort'", RPCResult::Type::BOOL, "success", "True if scan will be aborted (not necessarily before this RPC returns), or false if there is no scan to abort"},
             RPCResult{"when action=='status' and a scan is currently in progress", RPCResult::Type::OBJ, "", "",
@@ -2142,7 +2855,7 @@ static RPCHelpMan scantxoutset()
         },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
-    RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VARR});
+    RPCTypeCheck(request.params, {UniValue::VSTR, UniValue::VARR, UniValue::VSTR});
 
     UniValue result(UniValue::VOBJ);
     if (request.params[0].get_str() == "status") {
@@ -2172,7 +2885,7 @@ static RPCHelpMan scantxoutset()
             throw JSONRPCError(RPC_MISC_ERROR, "scanobjects argument is required for the start action");
         }
 
-        std::set<CScript> needles;
+        std::unordered_set<CScript, SaltedSipHasher> needles;
         std::map<CScript, std::string> descriptors;
         CAmounts total_in = {0};
 
@@ -2186,27 +2899,78 @@ static RPCHelpMan scantxoutset()
                 descriptors.emplace(std::move(script), std::move(inferred));
             }
         }
+        std::vector<bool> done(SCAN_RANGE_COUNT);
+        if (!request.params[2].isNull()) {
+            done = DecodeScanCursor(request.params[2].get_str());
+        }
 
-        // Scan the unspent transaction output set for inputs
+        // Scan the unspent transaction output set for inputs, with each thread
+        // taking the next key range left. The cursors are all created under
+        // cs_main, so every thread reads the same snapshot of the database.
         UniValue unspents(UniValue::VARR);
         std::vector<CTxOut> input_txos;
         std::map<COutPoint, Coin> coins;
         g_should_abort_scan = false;
-        int64_t count = 0;
-        std::unique_ptr<CCoinsViewCursor> pcursor;
-        const CBlockIndex* tip;
+        std::vector<size_t> ranges;
+        for (size_t range = 0; range < SCAN_RANGE_COUNT; ++range) {
+            if (!done[range]) ranges.push_back(range);
+        }
         NodeContext& node = EnsureAnyNodeContext(request.context);
+        // Each task of the node's thread pool scanning ranges uses a cursor of its own
+        std::optional<util::TaskPool> pool;
+        if (node.thread_pool) pool.emplace(*node.thread_pool, "scantxoutset", util::TaskPriority::NORMAL);
+        const size_t max_threads{pool ? static_cast<size_t>(pool->GetThreadPool().GetThreadCount()) + 1 : 1};
+        const size_t num_threads{std::clamp<size_t>(GetNumCores(), 1, std::max<size_t>(std::min(ranges.size(), max_threads), 1))};
+        std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+        const CBlockIndex* tip;
         {
             ChainstateManager& chainman = EnsureChainman(node);
             LOCK(cs_main);
             Chainstate& active_chainstate = chainman.ActiveChainstate();
             active_chainstate.ForceFlushStateToDisk();
-            pcursor = CHECK_NONFATAL(active_chainstate.CoinsDB().Cursor());
+            for (size_t i = 0; i < num_threads; ++i) {
+                cursors.push_back(CHECK_NONFATAL(active_chainstate.CoinsDB().Cursor()));
+            }
             tip = CHECK_NONFATAL(active_chainstate.m_chain.Tip());
         }
-        bool res = FindScriptPubKey(g_scan_progress, g_should_abort_scan, count, pcursor.get(), needles, coins, node.rpc_interruption_point);
-        result.pushKV("success", res);
-        result.pushKV("txouts", count);
+
+        Mutex results_mutex;
+        std::atomic<size_t> next_range{0};
+        std::atomic<size_t> done_count{SCAN_RANGE_COUNT - ranges.size()};
+        std::atomic<int64_t> count{0};
+        std::atomic<bool> failed{false};
+        g_scan_progress = (int)(done_count * 100.0 / SCAN_RANGE_COUNT + 0.5);
+        const auto scan{[&](CCoinsViewCursor& cursor) {
+            try {
+                for (size_t i = next_range++; i < ranges.size() && !failed; i = next_range++) {
+                    std::map<COutPoint, Coin> range_coins;
+                    int64_t range_count{0};
+                    const bool complete{FindScriptPubKey(g_should_abort_scan, range_count, cursor, ranges[i], needles, range_coins, node.rpc_interruption_point)};
+                    count += range_count;
+                    if (!complete) {
+                        failed = true;
+                        return;
+                    }
+                    // Outputs of a range are only kept once it is complete, so
+                    // that resuming from the cursor doesn't return them twice
+                    LOCK(results_mutex);
+                    coins.merge(range_coins);
+                    done[ranges[i]] = true;
+                    g_scan_progress = (int)(++done_count * 100.0 / SCAN_RANGE_COUNT + 0.5);
+                }
+            } catch (...) {
+                // Stop the other scans, and leave the exception to ParallelFor to rethrow
+                failed = true;
+                throw;
+            }
+        }};
+        util::ParallelFor(pool ? &*pool : nullptr, num_threads, num_threads, [&](size_t i) { scan(*cursors[i]); });
+
+        result.pushKV("success", !failed);
+        if (failed) {
+            result.pushKV("cursor", EncodeScanCursor(done));
+        }
+        result.pushKV("txouts", count.load());
         result.pushKV("height", tip->nHeight);
         result.pushKV("bestblock", tip->GetBlockHash().GetHex());
 
@@ -2224,6 +2988,7 @@ static RPCHelpMan scantxoutset()
             unspent.pushKV("desc", descriptors[txo.scriptPubKey]);
             unspent.pushKV("amountType", ValueFromAmountType(txo.amountType));
             unspent.pushKV("amount", ValueFromAmount(txo.nValue));
+            unspent.pushKV("scaled_amount", ValueFromAmount(ScaleAmount(txo.nValue, tip->scaleFactor)));
             unspent.pushKV("height", (int32_t)coin.nHeight);
 
             unspents.push_back(unspent);
@@ -2231,6 +2996,8 @@ static RPCHelpMan scantxoutset()
         result.pushKV("unspents", unspents);
         result.pushKV("total_cash_amount", ValueFromAmount(total_in[CASH]));
         result.pushKV("total_bond_amount", ValueFromAmount(total_in[BOND]));
+        result.pushKV("total_scaled_cash_amount", ValueFromAmount(ScaleAmount(total_in[CASH], tip->scaleFactor)));
+        result.pushKV("total_scaled_bond_amount", ValueFromAmount(ScaleAmount(total_in[BOND], tip->scaleFactor)));
     } else {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid command");
     }
@@ -2427,17 +3194,45 @@ UniValue CreateUTXOSnapshot(
     COutPoint key;
     Coin coin;
     unsigned int iter{0};
+    SnapshotChunk chunk;
+    std::vector<SnapshotChunkInfo> chunk_index;
+    uint256 chunk_first_txid;
+    uint64_t offset{GetSerializeSize(metadata)};
+    uint256 txid;
+    std::map<uint32_t, Coin> outputs;
+
+    const auto write_chunk{[&] {
+        chunk_index.push_back({offset, chunk.m_coins_count, chunk_first_txid});
+        afile << chunk;
+        offset += GetSerializeSize(chunk);
+        chunk.m_coins_count = 0;
+        chunk.m_data.clear();
+    }};
+    const auto add_outputs{[&] {
+        if (chunk.m_coins_count == 0) chunk_first_txid = txid;
+        SerializeSnapshotCoins(chunk.m_data, txid, outputs);
+        chunk.m_coins_count += outputs.size();
+        outputs.clear();
+        // Only close a chunk between transactions, see SnapshotChunk.
+        if (chunk.m_data.size() >= SNAPSHOT_CHUNK_TARGET_SIZE) write_chunk();
+    }};
 
     while (pcursor->Valid()) {
         if (iter % 5000 == 0) node.rpc_interruption_point();
         ++iter;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            afile << key;
-            afile << coin;
+            if (!outputs.empty() && key.hash != txid) add_outputs();
+            txid = key.hash;
+            outputs[key.n] = std::move(coin);
         }
 
         pcursor->Next();
     }
+    if (!outputs.empty()) add_outputs();
+    if (chunk.m_coins_count > 0) write_chunk();
+
+    afile << chunk_index;
+    afile << offset;
 
     afile.fclose();
 
@@ -2459,6 +3254,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &getblockchaininfo},
         {"blockchain", &getchaintxstats},
         {"blockchain", &getblockstats},
+        {"blockchain", &getblockstatsrange},
         {"blockchain", &getbestblockhash},
         {"blockchain", &getblockcount},
         {"blockchain", &getblock},
@@ -2466,10 +3262,16 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &getblockhash},
         {"blockchain", &getblockheader},
         {"blockchain", &getchaintips},
+        {"blockchain", &getdbinfo},
+        {"blockchain", &getvalidationstats},
         {"blockchain", &getdifficulty},
         {"blockchain", &getdeploymentinfo},
         {"blockchain", &gettxout},
+        {"blockchain", &gettxouts},
         {"blockchain", &gettxoutsetinfo},
+        {"blockchain", &getconversionstats},
+        {"blockchain", &getconversion},
+        {"blockchain", &listconversions},
         {"blockchain", &pruneblockchain},
         {"blockchain", &verifychain},
         {"blockchain", &preciousblock},
@@ -33,6 +33,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "generatetoaddress", 2, "maxtries" },
     { "generatetodescriptor", 0, "num_blocks" },
     { "generatetodescriptor", 2, "maxtries" },
+    { "generateemptyblocks", 0, "nblocks" },
     { "generateblock", 1, "transactions" },
     { "getnetworkhashps", 0, "nblocks" },
     { "getnetworkhashps", 1, "height" },
@@ -75,6 +76,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listtransactions", 3, "include_watchonly" },
     { "walletpassphrase", 1, "timeout" },
     { "getblocktemplate", 0, "template_request" },
+    { "submittemplateblock", 2, "version" },
+    { "submittemplateblock", 3, "time" },
+    { "submittemplateblock", 4, "nonce" },
     { "listsinceblock", 1, "target_confirmations" },
     { "listsinceblock", 2, "include_watchonly" },
     { "listsinceblock", 3, "include_removed" },
@@ -87,6 +91,13 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "sendmany", 8, "fee_rate"},
     { "sendmany", 9, "is_scaled_fee_rate" },
     { "sendmany", 10, "verbose" },
+    { "createconversions", 0, "conversions" },
+    { "createconversions", 1, "is_scaled_amount" },
+    { "createconversions", 2, "conf_target" },
+    { "createconversions", 4, "fee_rate" },
+    { "createconversions", 5, "is_scaled_fee_rate" },
+    { "createconversions", 6, "deadline" },
+    { "createconversions", 7, "add_to_wallet" },
     { "deriveaddresses", 1, "range" },
     { "scantxoutset", 1, "scanobjects" },
     { "addmultisigaddress", 0, "nrequired" },
@@ -139,9 +150,13 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "converttopsbt", 2, "iswitness"},
     { "gettxout", 1, "n" },
     { "gettxout", 2, "include_mempool" },
+    { "gettxouts", 0, "outputs" },
+    { "gettxouts", 1, "include_mempool" },
     { "gettxoutproof", 0, "txids" },
     { "gettxoutsetinfo", 1, "hash_or_height" },
     { "gettxoutsetinfo", 2, "use_index"},
+    { "getconversionstats", 0, "start_height" },
+    { "getconversionstats", 1, "end_height" },
     { "lockunspent", 0, "unlock" },
     { "lockunspent", 1, "transactions" },
     { "lockunspent", 2, "persistent" },
@@ -168,6 +183,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "getblockstatsrange", 0, "start_height" },
+    { "getblockstatsrange", 1, "end_height" },
+    { "getblockstatsrange", 2, "stats" },
+    { "getlockstats", 0, "reset" },
     { "pruneblockchain", 0, "height" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
@@ -182,6 +201,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setnetworkactive", 0, "state" },
     { "setwalletflag", 1, "value" },
     { "getmempoolancestors", 1, "verbose" },
+    { "getconversionbook", 1, "count" },
+    { "estimateconversions", 0, "conversions" },
     { "getmempooldescendants", 1, "verbose" },
     { "gettxspendingprevout", 0, "outputs" },
     { "bumpfee", 1, "options" },
@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <consensus/conversion.h>
 #include <core_io.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
@@ -14,6 +15,7 @@
 #include <txmempool.h>
 #include <univalue.h>
 #include <util/fees.h>
+#include <validation.h>
 
 #include <algorithm>
 #include <array>
@@ -42,11 +44,13 @@ static RPCHelpMan estimatesmartfee()
             "target, but is not as responsive to short term drops in the\n"
             "prevailing fee market. Must be one of (case insensitive):\n"
              "\"" + FeeModes("\"\n\"") + "\""},
+            {"fee_type", RPCArg::Type::STR, RPCArg::Default{"cash"}, "The type of amount the fee is paid in ('cash' or 'bond').\n"
+            "Each is estimated from the transactions that paid their fees in it."},
         },
         RPCResult{
             RPCResult::Type::OBJ, "", "",
             {
-                {RPCResult::Type::NUM, "feerate", /*optional=*/true, "estimate fee rate in " + CURRENCY_UNIT + "/kvB (only present if no errors were encountered)"},
+                {RPCResult::Type::NUM, "feerate", /*optional=*/true, "estimate fee rate in " + CURRENCY_UNIT + "/kvB of fee_type (only present if no errors were encountered)"},
                 {RPCResult::Type::ARR, "errors", /*optional=*/true, "Errors encountered during processing (if there are any)",
                     {
                         {RPCResult::Type::STR, "", "error"},
@@ -59,11 +63,12 @@ static RPCHelpMan estimatesmartfee()
         }},
         RPCExamples{
             HelpExampleCli("estimatesmartfee", "6") +
+            HelpExampleCli("estimatesmartfee", "6 economical bond") +
             HelpExampleRpc("estimatesmartfee", "6")
         },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
         {
-            RPCTypeCheck(request.params, {UniValue::VNUM, UniValue::VSTR});
+            RPCTypeCheck(request.params, {UniValue::VNUM, UniValue::VSTR, UniValue::VSTR});
             RPCTypeCheckArgument(request.params[0], UniValue::VNUM);
 
             CBlockPolicyEstimator& fee_estimator = EnsureAnyFeeEstimator(request.context);
@@ -80,14 +85,21 @@ static RPCHelpMan estimatesmartfee()
                 }
                 if (fee_mode == FeeEstimateMode::ECONOMICAL) conservative = false;
             }
+            const CAmountType fee_type{request.params[2].isNull() ? CASH : AmountTypeFromValue(request.params[2])};
 
             UniValue result(UniValue::VOBJ);
             UniValue errors(UniValue::VARR);
             FeeCalculation feeCalc;
-            CFeeRate feeRate{fee_estimator.estimateSmartFee(conf_target, &feeCalc, conservative)};
+            CFeeRate feeRate{fee_estimator.estimateSmartFee(conf_target, &feeCalc, conservative, fee_type)};
             if (feeRate != CFeeRate(0)) {
                 CFeeRate min_mempool_feerate{mempool.GetMinFee()};
                 CFeeRate min_relay_feerate{mempool.m_min_relay_feerate};
+                if (fee_type == BOND) {
+                    // The mempool minimums are normalized to cash
+                    const CAmounts total_supply{WITH_LOCK(cs_main, return EnsureChainman(node).ActiveChain().Tip()->GetTotalSupply())};
+                    min_mempool_feerate = CFeeRate(GetConvertedAmount(total_supply, min_mempool_feerate.GetFeePerK(), CASH, /*roundedUp=*/true));
+                    min_relay_feerate = CFeeRate(GetConvertedAmount(total_supply, min_relay_feerate.GetFeePerK(), CASH, /*roundedUp=*/true));
+                }
                 feeRate = std::max({feeRate, min_mempool_feerate, min_relay_feerate});
                 result.pushKV("feerate", ValueFromAmount(feeRate.GetFeePerK()));
             } else {
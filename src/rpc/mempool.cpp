@@ -8,8 +8,10 @@
 #include <kernel/mempool_persist.h>
 
 #include <chainparams.h>
+#include <consensus/conversion.h>
 #include <core_io.h>
 #include <fs.h>
+#include <index/txospenderindex.h>
 #include <node/mempool_persist_args.h>
 #include <policy/rbf.h>
 #include <policy/settings.h>
@@ -20,7 +22,10 @@
 #include <txmempool.h>
 #include <univalue.h>
 #include <util/moneystr.h>
+#include <util/overflow.h>
+#include <util/system.h>
 #include <util/time.h>
+#include <validation.h>
 
 using kernel::DumpMempool;
 
@@ -260,33 +265,97 @@ static std::vector<RPCResult> MempoolEntryDescription()
     };
 }
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+/**
+ * Fields of a mempool entry reported by the RPCs. They are copied under the
+ * mempool lock, and the JSON is built from the copy after releasing it, so
+ * that polling the verbose RPCs does not hold up transaction acceptance.
+ */
+struct MempoolEntrySnapshot {
+    uint256 txid;
+    uint256 wtxid;
+    size_t vsize;
+    size_t weight;
+    std::chrono::seconds time;
+    unsigned int height;
+    uint64_t descendant_count;
+    uint64_t descendant_size;
+    uint64_t ancestor_count;
+    uint64_t ancestor_size;
+    CAmount base_fee;
+    CAmount modified_fee;
+    CAmount ancestor_fees;
+    CAmount descendant_fees;
+    std::vector<uint256> depends;
+    std::vector<uint256> spent_by;
+    bool bip125_replaceable;
+    bool unbroadcast;
+};
+
+static MempoolEntrySnapshot SnapshotEntry(const CTxMemPool& pool, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
 {
     AssertLockHeld(pool.cs);
 
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("weight", (int)e.GetTxWeight());
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("wtxid", pool.vTxHashes[e.vTxHashesIdx].first.ToString());
+    const CTransaction& tx = e.GetTx();
+    MempoolEntrySnapshot snapshot;
+    snapshot.txid = tx.GetHash();
+    snapshot.wtxid = pool.vTxHashes[e.vTxHashesIdx].first;
+    snapshot.vsize = e.GetTxSize();
+    snapshot.weight = e.GetTxWeight();
+    snapshot.time = e.GetTime();
+    snapshot.height = e.GetHeight();
+    snapshot.descendant_count = e.GetCountWithDescendants();
+    snapshot.descendant_size = e.GetSizeWithDescendants();
+    snapshot.ancestor_count = e.GetCountWithAncestors();
+    snapshot.ancestor_size = e.GetSizeWithAncestors();
+    snapshot.base_fee = e.GetNormalizedFee();
+    snapshot.modified_fee = e.GetModifiedFee();
+    snapshot.ancestor_fees = e.GetModFeesWithAncestors();
+    snapshot.descendant_fees = e.GetModFeesWithDescendants();
+
+    for (const CTxIn& txin : tx.vin) {
+        if (pool.exists(GenTxid::Txid(txin.prevout.hash))) {
+            snapshot.depends.push_back(txin.prevout.hash);
+        }
+    }
+
+    const CTxMemPool::txiter& it = pool.mapTx.find(tx.GetHash());
+    const CTxMemPoolEntry::Children& children = it->GetMemPoolChildrenConst();
+    for (const CTxMemPoolEntry& child : children) {
+        snapshot.spent_by.push_back(child.GetTx().GetHash());
+    }
+
+    // Add opt-in RBF status
+    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
+    if (rbfState == RBFTransactionState::UNKNOWN) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
+    }
+    snapshot.bip125_replaceable = rbfState == RBFTransactionState::REPLACEABLE_BIP125;
+    snapshot.unbroadcast = pool.IsUnbroadcastTx(tx.GetHash());
+    return snapshot;
+}
+
+static void entryToJSON(UniValue& info, const MempoolEntrySnapshot& e)
+{
+    info.pushKV("vsize", (int)e.vsize);
+    info.pushKV("weight", (int)e.weight);
+    info.pushKV("time", count_seconds(e.time));
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.descendant_count);
+    info.pushKV("descendantsize", e.descendant_size);
+    info.pushKV("ancestorcount", e.ancestor_count);
+    info.pushKV("ancestorsize", e.ancestor_size);
+    info.pushKV("wtxid", e.wtxid.ToString());
 
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetNormalizedFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.base_fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.ancestor_fees));
+    fees.pushKV("descendant", ValueFromAmount(e.descendant_fees));
     info.pushKV("fees", fees);
 
-    const CTransaction& tx = e.GetTx();
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
-    {
-        if (pool.exists(GenTxid::Txid(txin.prevout.hash)))
-            setDepends.insert(txin.prevout.hash.ToString());
+    for (const uint256& dep : e.depends) {
+        setDepends.insert(dep.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -298,25 +367,29 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("depends", depends);
 
     UniValue spent(UniValue::VARR);
-    const CTxMemPool::txiter& it = pool.mapTx.find(tx.GetHash());
-    const CTxMemPoolEntry::Children& children = it->GetMemPoolChildrenConst();
-    for (const CTxMemPoolEntry& child : children) {
-        spent.push_back(child.GetTx().GetHash().ToString());
+    for (const uint256& child : e.spent_by) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", spent);
 
-    // Add opt-in RBF status
-    bool rbfStatus = false;
-    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
-    if (rbfState == RBFTransactionState::UNKNOWN) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
-    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
-        rbfStatus = true;
-    }
+    info.pushKV("bip125-replaceable", e.bip125_replaceable);
+    info.pushKV("unbroadcast", e.unbroadcast);
+}
 
-    info.pushKV("bip125-replaceable", rbfStatus);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
+/** Return entry snapshots as a JSON object keyed by txid */
+static UniValue EntriesToJSON(const std::vector<MempoolEntrySnapshot>& snapshots)
+{
+    UniValue o(UniValue::VOBJ);
+    for (const MempoolEntrySnapshot& e : snapshots) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(info, e);
+        // Mempool has unique entries so there is no advantage in using
+        // UniValue::pushKV, which checks if the key already exists in O(N).
+        // UniValue::__pushKV is used instead which currently is O(1).
+        o.__pushKV(e.txid.ToString(), info);
+    }
+    return o;
 }
 
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
@@ -325,18 +398,15 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
-        UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.mapTx) {
-            const uint256& hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
-            // Mempool has unique entries so there is no advantage in using
-            // UniValue::pushKV, which checks if the key already exists in O(N).
-            // UniValue::__pushKV is used instead which currently is O(1).
-            o.__pushKV(hash.ToString(), info);
+        std::vector<MempoolEntrySnapshot> snapshots;
+        {
+            LOCK(pool.cs);
+            snapshots.reserve(pool.mapTx.size());
+            for (const CTxMemPoolEntry& e : pool.mapTx) {
+                snapshots.push_back(SnapshotEntry(pool, e));
+            }
         }
-        return o;
+        return EntriesToJSON(snapshots);
     } else {
         uint64_t mempool_sequence;
         std::vector<uint256> vtxid;
@@ -441,35 +511,32 @@ static RPCHelpMan getmempoolancestors()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
+    std::vector<MempoolEntrySnapshot> snapshots;
+    {
+        LOCK(mempool.cs);
 
-    CTxMemPool::txiter it = mempool.mapTx.find(hash);
-    if (it == mempool.mapTx.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
 
-    CTxMemPool::setEntries setAncestors;
-    uint64_t noLimit = std::numeric_limits<uint64_t>::max();
-    std::string dummy;
-    mempool.CalculateMemPoolAncestors(*it, setAncestors, noLimit, noLimit, noLimit, noLimit, dummy, false);
+        CTxMemPool::setEntries setAncestors;
+        uint64_t noLimit = std::numeric_limits<uint64_t>::max();
+        std::string dummy;
+        mempool.CalculateMemPoolAncestors(*it, setAncestors, noLimit, noLimit, noLimit, noLimit, dummy, false);
 
-    if (!fVerbose) {
-        UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter ancestorIt : setAncestors) {
-            o.push_back(ancestorIt->GetTx().GetHash().ToString());
+        if (!fVerbose) {
+            UniValue o(UniValue::VARR);
+            for (CTxMemPool::txiter ancestorIt : setAncestors) {
+                o.push_back(ancestorIt->GetTx().GetHash().ToString());
+            }
+            return o;
         }
-        return o;
-    } else {
-        UniValue o(UniValue::VOBJ);
         for (CTxMemPool::txiter ancestorIt : setAncestors) {
-            const CTxMemPoolEntry &e = *ancestorIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
-            o.pushKV(_hash.ToString(), info);
+            snapshots.push_back(SnapshotEntry(mempool, *ancestorIt));
         }
-        return o;
     }
+    return EntriesToJSON(snapshots);
 },
     };
 }
@@ -505,36 +572,33 @@ static RPCHelpMan getmempooldescendants()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
+    std::vector<MempoolEntrySnapshot> snapshots;
+    {
+        LOCK(mempool.cs);
 
-    CTxMemPool::txiter it = mempool.mapTx.find(hash);
-    if (it == mempool.mapTx.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
 
-    CTxMemPool::setEntries setDescendants;
-    mempool.CalculateDescendants(it, setDescendants);
-    // CTxMemPool::CalculateDescendants will include the given tx
-    setDescendants.erase(it);
+        CTxMemPool::setEntries setDescendants;
+        mempool.CalculateDescendants(it, setDescendants);
+        // CTxMemPool::CalculateDescendants will include the given tx
+        setDescendants.erase(it);
 
-    if (!fVerbose) {
-        UniValue o(UniValue::VARR);
-        for (CTxMemPool::txiter descendantIt : setDescendants) {
-            o.push_back(descendantIt->GetTx().GetHash().ToString());
-        }
+        if (!fVerbose) {
+            UniValue o(UniValue::VARR);
+            for (CTxMemPool::txiter descendantIt : setDescendants) {
+                o.push_back(descendantIt->GetTx().GetHash().ToString());
+            }
 
-        return o;
-    } else {
-        UniValue o(UniValue::VOBJ);
+            return o;
+        }
         for (CTxMemPool::txiter descendantIt : setDescendants) {
-            const CTxMemPoolEntry &e = *descendantIt;
-            const uint256& _hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(mempool, info, e);
-            o.pushKV(_hash.ToString(), info);
+            snapshots.push_back(SnapshotEntry(mempool, *descendantIt));
         }
-        return o;
     }
+    return EntriesToJSON(snapshots);
 },
     };
 }
@@ -557,25 +621,174 @@ static RPCHelpMan getmempoolentry()
     uint256 hash = ParseHashV(request.params[0], "parameter 1");
 
     const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-    LOCK(mempool.cs);
+    const MempoolEntrySnapshot snapshot{[&] {
+        LOCK(mempool.cs);
 
-    CTxMemPool::txiter it = mempool.mapTx.find(hash);
-    if (it == mempool.mapTx.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
-    }
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in mempool");
+        }
+        return SnapshotEntry(mempool, *it);
+    }()};
 
-    const CTxMemPoolEntry &e = *it;
     UniValue info(UniValue::VOBJ);
-    entryToJSON(mempool, info, e);
+    entryToJSON(info, snapshot);
     return info;
 },
     };
 }
 
+static RPCHelpMan getconversionbook()
+{
+    return RPCHelpMan{"getconversionbook",
+        "\nReturns the conversions in the mempool that sell the given type, sorted by the rate they require (lowest first).\n"
+        "The rate is the minimum amount of the other type a conversion requires per unit sold.\n",
+        {
+            {"type", RPCArg::Type::STR, RPCArg::Optional::NO, "The type sold by the conversions (\"cash\" or \"bond\")"},
+            {"count", RPCArg::Type::NUM, RPCArg::Default{100}, "The maximum number of conversions to return"},
+        },
+        RPCResult{
+            RPCResult::Type::ARR, "", "",
+            {
+                {RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::STR_HEX, "txid", "The conversion transaction id"},
+                    {RPCResult::Type::STR_AMOUNT, "input", "The unscaled amount sold"},
+                    {RPCResult::Type::STR_AMOUNT, "output", "The minimum unscaled amount of the other type required in return"},
+                    {RPCResult::Type::NUM, "rate", "The rate required by the conversion (output / input)"},
+                    {RPCResult::Type::STR_AMOUNT, "depthinput", "The unscaled amount sold by this and all preceding conversions"},
+                    {RPCResult::Type::STR_AMOUNT, "depthoutput", "The minimum unscaled amount required by this and all preceding conversions"},
+                }},
+            }},
+        RPCExamples{
+            HelpExampleCli("getconversionbook", "\"cash\"")
+            + HelpExampleCli("getconversionbook", "\"bond\" 10")
+            + HelpExampleRpc("getconversionbook", "\"cash\", 10")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const CAmountType inputType = AmountTypeFromValue(request.params[0]);
+    const int count = request.params[1].isNull() ? 100 : request.params[1].getInt<int>();
+    if (count < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+    }
+
+    const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
+    LOCK(mempool.cs);
+
+    UniValue book(UniValue::VARR);
+    CAmount depthInput = 0;
+    CAmount depthOutput = 0;
+    for (const CTxMemPool::txiter& it : mempool.GetConversionBook(inputType, count)) {
+        depthInput = SaturatingAdd(depthInput, it->GetConversionInput());
+        depthOutput = SaturatingAdd(depthOutput, it->GetConversionOutput());
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("txid", it->GetTx().GetHash().GetHex());
+        entry.pushKV("input", ValueFromAmount(it->GetConversionInput()));
+        entry.pushKV("output", ValueFromAmount(it->GetConversionOutput()));
+        entry.pushKV("rate", (double)it->GetConversionOutput() / (double)it->GetConversionInput());
+        entry.pushKV("depthinput", ValueFromAmount(depthInput));
+        entry.pushKV("depthoutput", ValueFromAmount(depthOutput));
+        book.push_back(entry);
+    }
+    return book;
+},
+    };
+}
+
+static RPCHelpMan estimateconversions()
+{
+    return RPCHelpMan{"estimateconversions",
+        "\nEstimates the output of converting each of the given unscaled input amounts. Each conversion is priced\n"
+        "independently at the tip supply, at the supply projected after the pending conversions in the mempool,\n"
+        "and at the least favorable supply of the blocks that new conversions are checked against (see\n"
+        "-mempoolnewconversionschecklastnblocks).\n",
+        {
+            {"conversions", RPCArg::Type::ARR, RPCArg::Optional::NO, "The conversions to price",
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"amount", RPCArg::Type::AMOUNT, RPCArg::Optional::NO, "The unscaled input amount"},
+                            {"type", RPCArg::Type::STR, RPCArg::Optional::NO, "The input type (\"cash\" or \"bond\")"},
+                        },
+                    },
+                },
+            },
+        },
+        RPCResult{
+            RPCResult::Type::ARR, "", "",
+            {
+                {RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::STR_AMOUNT, "tip", "The unscaled output at the tip supply"},
+                    {RPCResult::Type::STR_AMOUNT, "mempool", "The unscaled output at the projected supply after the pending conversions"},
+                    {RPCResult::Type::STR_AMOUNT, "worst", "The lowest unscaled output at the supply of the blocks checked"},
+                }},
+            }},
+        RPCExamples{
+            HelpExampleCli("estimateconversions", "\"[{\\\"amount\\\":1,\\\"type\\\":\\\"bond\\\"}]\"")
+            + HelpExampleRpc("estimateconversions", "\"[{\\\"amount\\\":1,\\\"type\\\":\\\"bond\\\"}]\"")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    RPCTypeCheckArgument(request.params[0], UniValue::VARR);
+    const UniValue& conversion_params = request.params[0];
+
+    std::vector<std::pair<CAmount, CAmountType>> conversions;
+    conversions.reserve(conversion_params.size());
+    for (unsigned int idx = 0; idx < conversion_params.size(); idx++) {
+        const UniValue& o = conversion_params[idx].get_obj();
+        RPCTypeCheckObj(o,
+                        {
+                            {"amount", UniValueType()},
+                            {"type", UniValueType(UniValue::VSTR)},
+                        }, /*fAllowNull=*/false, /*fStrict=*/true);
+        conversions.emplace_back(AmountFromValue(find_value(o, "amount")), AmountTypeFromValue(find_value(o, "type")));
+    }
+
+    // Collect every supply in one acquisition of each lock, then price outside of them
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
+    const int check_last_N_blocks = gArgs.GetIntArg("-mempoolnewconversionschecklastnblocks", DEFAULT_MEMPOOL_NEW_CONVERSIONS_CHECK_LAST_N_BLOCKS);
+    std::vector<CAmounts> window_supplies;
+    CAmounts projected_supply;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* tip = chainman.ActiveChain().Tip();
+        for (const CBlockIndex* pindex = tip; pindex && (int)window_supplies.size() < std::max(check_last_N_blocks, 1); pindex = pindex->pprev) {
+            window_supplies.push_back(pindex->GetTotalSupply());
+        }
+    }
+    if (window_supplies.empty()) {
+        throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "No active chain");
+    }
+    {
+        LOCK(mempool.cs);
+        projected_supply = mempool.GetProjectedSupply(window_supplies.front());
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const auto& [amount, type] : conversions) {
+        CAmount worst = CalculateOutputAmount(window_supplies.front(), amount, type);
+        for (const CAmounts& supply : window_supplies) {
+            worst = std::min(worst, CalculateOutputAmount(supply, amount, type));
+        }
+        UniValue quote(UniValue::VOBJ);
+        quote.pushKV("tip", ValueFromAmount(CalculateOutputAmount(window_supplies.front(), amount, type)));
+        quote.pushKV("mempool", ValueFromAmount(CalculateOutputAmount(projected_supply, amount, type)));
+        quote.pushKV("worst", ValueFromAmount(worst));
+        result.push_back(quote);
+    }
+    return result;
+},
+    };
+}
+
 static RPCHelpMan gettxspendingprevout()
 {
     return RPCHelpMan{"gettxspendingprevout",
-        "Scans the mempool to find transactions spending any of the given outputs",
+        "Scans the mempool to find transactions spending any of the given outputs.\n"
+        "Outputs spent by confirmed transactions are looked up in the spent output index, if it is enabled with -txospenderindex.",
         {
             {"outputs", RPCArg::Type::ARR, RPCArg::Optional::NO, "The transaction outputs that we want to check, and within each, the txid (string) vout (numeric).",
                 {
@@ -595,7 +808,9 @@ static RPCHelpMan gettxspendingprevout()
                 {
                     {RPCResult::Type::STR_HEX, "txid", "the transaction id of the checked output"},
                     {RPCResult::Type::NUM, "vout", "the vout value of the checked output"},
-                    {RPCResult::Type::STR_HEX, "spendingtxid", /*optional=*/true, "the transaction id of the mempool transaction spending this output (omitted if unspent)"},
+                    {RPCResult::Type::STR_HEX, "spendingtxid", /*optional=*/true, "the transaction id of the mempool transaction spending this output, or of the confirmed one if -txospenderindex is enabled (omitted if unspent)"},
+                    {RPCResult::Type::STR_HEX, "blockhash", /*optional=*/true, "the hash of the block of the confirmed transaction spending this output"},
+                    {RPCResult::Type::NUM, "height", /*optional=*/true, "the height of the block of the confirmed transaction spending this output"},
                 }},
             }
         },
@@ -633,18 +848,35 @@ static RPCHelpMan gettxspendingprevout()
             }
 
             const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
-            LOCK(mempool.cs);
+            std::vector<std::optional<uint256>> mempool_spenders;
+            mempool_spenders.reserve(prevouts.size());
+            {
+                LOCK(mempool.cs);
+                for (const COutPoint& prevout : prevouts) {
+                    const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
+                    mempool_spenders.push_back(spendingTx ? std::make_optional(spendingTx->GetHash()) : std::nullopt);
+                }
+            }
+
+            // Confirmed spends are read from disk, without holding the mempool lock
+            if (g_txospenderindex) g_txospenderindex->BlockUntilSyncedToCurrentChain();
 
             UniValue result{UniValue::VARR};
 
-            for (const COutPoint& prevout : prevouts) {
+            for (size_t i = 0; i < prevouts.size(); ++i) {
+                const COutPoint& prevout{prevouts[i]};
                 UniValue o(UniValue::VOBJ);
                 o.pushKV("txid", prevout.hash.ToString());
                 o.pushKV("vout", (uint64_t)prevout.n);
 
-                const CTransaction* spendingTx = mempool.GetConflictTx(prevout);
-                if (spendingTx != nullptr) {
-                    o.pushKV("spendingtxid", spendingTx->GetHash().ToString());
+                if (mempool_spenders[i]) {
+                    o.pushKV("spendingtxid", mempool_spenders[i]->ToString());
+                } else if (g_txospenderindex) {
+                    if (const auto spender{g_txospenderindex->FindSpender(prevout)}) {
+                        o.pushKV("spendingtxid", spender->tx->GetHash().ToString());
+                        o.pushKV("blockhash", spender->block_hash.ToString());
+                        o.pushKV("height", spender->height);
+                    }
                 }
 
                 result.push_back(o);
@@ -655,7 +887,7 @@ static RPCHelpMan gettxspendingprevout()
     };
 }
 
-UniValue MempoolInfoToJSON(const CTxMemPool& pool)
+UniValue MempoolInfoToJSON(const CTxMemPool& pool, const CAmounts& tip_supply)
 {
     // Make sure this call is atomic in the pool.
     LOCK(pool.cs);
@@ -671,6 +903,9 @@ UniValue MempoolInfoToJSON(const CTxMemPool& pool)
     ret.pushKV("incrementalrelayfee", ValueFromAmount(pool.m_incremental_relay_feerate.GetFeePerK()));
     ret.pushKV("unbroadcastcount", uint64_t{pool.GetUnbroadcastTxs().size()});
     ret.pushKV("fullrbf", pool.m_full_rbf);
+    const CAmounts projected_supply = pool.GetProjectedSupply(tip_supply);
+    ret.pushKV("projectedcashsupply", ValueFromAmount(projected_supply[CASH]));
+    ret.pushKV("projectedbondsupply", ValueFromAmount(projected_supply[BOND]));
     return ret;
 }
 
@@ -693,6 +928,8 @@ static RPCHelpMan getmempoolinfo()
                 {RPCResult::Type::NUM, "incrementalrelayfee", "minimum fee rate increment for mempool limiting or replacement in " + CURRENCY_UNIT + "/kvB"},
                 {RPCResult::Type::NUM, "unbroadcastcount", "Current number of transactions that haven't passed initial broadcast yet"},
                 {RPCResult::Type::BOOL, "fullrbf", "True if the mempool accepts RBF without replaceability signaling inspection"},
+                {RPCResult::Type::STR_AMOUNT, "projectedcashsupply", "Unscaled supply of cash after the pending conversions that clear in order of required rate"},
+                {RPCResult::Type::STR_AMOUNT, "projectedbondsupply", "Unscaled supply of bonds after the pending conversions that clear in order of required rate"},
             }},
         RPCExamples{
             HelpExampleCli("getmempoolinfo", "")
@@ -700,7 +937,9 @@ static RPCHelpMan getmempoolinfo()
         },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
-    return MempoolInfoToJSON(EnsureAnyMemPool(request.context));
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const CAmounts tip_supply = WITH_LOCK(cs_main, return chainman.ActiveChain().Tip()->GetTotalSupply());
+    return MempoolInfoToJSON(EnsureAnyMemPool(request.context), tip_supply);
 },
     };
 }
@@ -894,6 +1133,8 @@ void RegisterMempoolRPCCommands(CRPCTable& t)
         {"blockchain", &getmempoolancestors},
         {"blockchain", &getmempooldescendants},
         {"blockchain", &getmempoolentry},
+        {"blockchain", &getconversionbook},
+        {"blockchain", &estimateconversions},
         {"blockchain", &gettxspendingprevout},
         {"blockchain", &getmempoolinfo},
         {"blockchain", &getrawmempool},
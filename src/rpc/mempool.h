@@ -5,11 +5,13 @@
 #ifndef BITCOIN_RPC_MEMPOOL_H
 #define BITCOIN_RPC_MEMPOOL_H
 
+#include <consensus/amount.h>
+
 class CTxMemPool;
 class UniValue;
 
-/** Mempool information to JSON */
-UniValue MempoolInfoToJSON(const CTxMemPool& pool);
+/** Mempool information to JSON, projecting the pending conversions from tip_supply */
+UniValue MempoolInfoToJSON(const CTxMemPool& pool, const CAmounts& tip_supply);
 
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
@@ -13,6 +13,7 @@
 #include <core_io.h>
 #include <deploymentinfo.h>
 #include <deploymentstatus.h>
+#include <hash.h>
 #include <key_io.h>
 #include <net.h>
 #include <node/context.h>
@@ -38,13 +39,20 @@
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <algorithm>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <set>
 #include <stdint.h>
 
 using node::DEFAULT_GENERATE;
 using node::DEFAULT_GENERATE_THREADS;
+using node::GetMiningHashesPerSec;
 using node::BlockAssembler;
 using node::CBlockTemplate;
+using node::CreateEmptyBlock;
+using node::ConversionOrderResult;
 using node::NodeContext;
 using node::RegenerateCommitments;
 using node::UpdateTime;
@@ -164,6 +172,51 @@ static UniValue generateBlocks(ChainstateManager& chainman, const CTxMemPool& me
     return blockHashes;
 }
 
+/** Number of blocks generateemptyblocks stores before connecting them, so the chain is
+ *  activated and its state flushed once per batch rather than once per block */
+static constexpr int EMPTY_BLOCKS_BATCH_SIZE{1000};
+
+static UniValue generateEmptyBlocks(ChainstateManager& chainman, const CScript& coinbase_script, int nGenerate)
+{
+    UniValue blockHashes(UniValue::VARR);
+    while (nGenerate > 0 && !ShutdownRequested()) {
+        const CBlockIndex* pindexLast;
+        {
+            LOCK(cs_main);
+            // Build each block on the one stored before it, computing the supply from its
+            // block index entry, without assembling it from the mempool or connecting it
+            pindexLast = chainman.ActiveTip();
+            for (int i = 0; i < EMPTY_BLOCKS_BATCH_SIZE && nGenerate > 0 && !ShutdownRequested(); ++i) {
+                auto block = std::make_shared<CBlock>(CreateEmptyBlock(chainman, pindexLast, coinbase_script));
+                while (!CheckProofOfWork(block->GetHash(), block->nBits, chainman.GetConsensus())) {
+                    if (block->nNonce == std::numeric_limits<uint32_t>::max()) {
+                        throw JSONRPCError(RPC_INTERNAL_ERROR, "Couldn't find a nonce for the block");
+                    }
+                    ++block->nNonce;
+                }
+
+                BlockValidationState state;
+                CBlockIndex* pindex = nullptr;
+                if (!chainman.ActiveChainstate().AcceptBlock(block, state, &pindex, /*fRequested=*/true, /*dbp=*/nullptr, /*fNewBlock=*/nullptr, /*min_pow_checked=*/true)) {
+                    throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("AcceptBlock, block not accepted: %s", state.ToString()));
+                }
+                blockHashes.push_back(pindex->GetBlockHash().GetHex());
+                pindexLast = pindex;
+                --nGenerate;
+            }
+        }
+
+        BlockValidationState state;
+        if (!chainman.ActiveChainstate().ActivateBestChain(state)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, strprintf("ActivateBestChain failed: %s", state.ToString()));
+        }
+        if (WITH_LOCK(cs_main, return chainman.ActiveTip()) != pindexLast) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Generated blocks were not connected");
+        }
+    }
+    return blockHashes;
+}
+
 static bool getScriptFromDescriptor(const std::string& descriptor, CScript& script, std::string& error)
 {
     FlatSigningProvider key_provider;
@@ -284,6 +337,44 @@ static RPCHelpMan generatetoaddress()
     };
 }
 
+static RPCHelpMan generateemptyblocks()
+{
+    return RPCHelpMan{"generateemptyblocks",
+        "Mine blocks with only a coinbase to a specified address and return the block hashes (-regtest only).\n"
+        "Much faster than generatetoaddress for building long chains, as the blocks are not assembled\n"
+        "from the mempool and are connected in batches.\n",
+        {
+            {"nblocks", RPCArg::Type::NUM, RPCArg::Optional::NO, "How many blocks are generated."},
+            {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address to send the newly generated bitcoin to."},
+        },
+        RPCResult{
+            RPCResult::Type::ARR, "", "hashes of blocks generated",
+            {
+                {RPCResult::Type::STR_HEX, "", "blockhash"},
+            }},
+        RPCExamples{
+            "\nGenerate 10000 blocks to myaddress\n"
+            + HelpExampleCli("generateemptyblocks", "10000 \"myaddress\"")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!Params().IsMockableChain()) {
+        throw std::runtime_error("generateemptyblocks is for regression testing (-regtest mode) only");
+    }
+    const int num_blocks{request.params[0].getInt<int>()};
+
+    CTxDestination destination = DecodeDestination(request.params[1].get_str());
+    if (!IsValidDestination(destination)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Error: Invalid address");
+    }
+
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+
+    return generateEmptyBlocks(chainman, GetScriptForDestination(destination), num_blocks);
+},
+    };
+}
+
 static RPCHelpMan generateblock()
 {
     return RPCHelpMan{"generateblock",
@@ -406,6 +497,7 @@ static RPCHelpMan getmininginfo()
                         {RPCResult::Type::NUM, "difficulty", "The current difficulty"},
                         {RPCResult::Type::BOOL, "generate", "If the generation is on or off (see getgenerate or setgenerate calls)"},
                         {RPCResult::Type::NUM, "genproclimit", "The processor limit for generation. -1 if no generation. (see getgenerate or setgenerate calls)"},
+                        {RPCResult::Type::NUM, "hashespersec", "The hashes per second of the built-in miner since it was started (0 if not mining)"},
                         {RPCResult::Type::NUM, "networkhashps", "The network hashes per second"},
                         {RPCResult::Type::NUM, "pooledtx", "The size of the mempool"},
                         {RPCResult::Type::STR, "chain", "current network name (main, test, signet, regtest)"},
@@ -431,6 +523,7 @@ static RPCHelpMan getmininginfo()
     obj.pushKV("difficulty",       (double)GetDifficulty(active_chain.Tip()));
     obj.pushKV("generate",         args.GetBoolArg("-gen", DEFAULT_GENERATE));
     obj.pushKV("genproclimit",         args.GetIntArg("-genproclimit", DEFAULT_GENERATE_THREADS));
+    obj.pushKV("hashespersec",     GetMiningHashesPerSec());
     obj.pushKV("networkhashps",    getnetworkhashps().HandleRequest(request));
     obj.pushKV("pooledtx",         (uint64_t)mempool.size());
     obj.pushKV("chain", chainman.GetParams().NetworkIDString());
@@ -507,6 +600,21 @@ static std::string gbt_vb_name(const Consensus::DeploymentPos pos) {
     return s;
 }
 
+//! How often a long poll with a template diff checks the mempool for updates,
+//! matching how often a template is rebuilt for mempool changes
+static constexpr std::chrono::seconds TEMPLATE_DIFF_POLL_INTERVAL{5};
+//! Number of recent templates a diff can be requested against, or a block submitted for
+static constexpr size_t MAX_SERVED_TEMPLATES{10};
+
+/** A template served by getblocktemplate */
+struct ServedTemplate {
+    uint256 id;
+    //! The block of the template. Its transactions are shared with the template.
+    CBlock block;
+};
+//! Recent templates, newest last
+static std::deque<ServedTemplate> g_served_templates GUARDED_BY(cs_main);
+
 static RPCHelpMan getblocktemplate()
 {
     return RPCHelpMan{"getblocktemplate",
@@ -530,6 +638,8 @@ static RPCHelpMan getblocktemplate()
                     {"segwit", RPCArg::Type::STR, RPCArg::Optional::NO, "(literal) indicates client side segwit support"},
                     {"str", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "other client side supported softfork deployment"},
                 }},
+                {"templatediff", RPCArg::Type::STR_HEX, /* treat as named arg */ RPCArg::Optional::OMITTED_NAMED_ARG, "The templateid of a recent template the client has. Transactions of that template are then only listed by txid, "
+                    "and the transactions it had that were removed are listed. A long poll with it checks the mempool for updates every " + ToString(TEMPLATE_DIFF_POLL_INTERVAL.count()) + " seconds."},
             },
                         "\"template_request\""},
         },
@@ -557,19 +667,25 @@ static RPCHelpMan getblocktemplate()
                 {
                     {RPCResult::Type::OBJ, "", "",
                     {
-                        {RPCResult::Type::STR_HEX, "data", "transaction data encoded in hexadecimal (byte-for-byte)"},
+                        {RPCResult::Type::STR_HEX, "data", /*optional=*/true, "transaction data encoded in hexadecimal (byte-for-byte). This and the fields below are omitted for transactions of the 'difffrom' template"},
                         {RPCResult::Type::STR_HEX, "txid", "transaction id encoded in little-endian hexadecimal"},
-                        {RPCResult::Type::STR_HEX, "hash", "hash encoded in little-endian hexadecimal (including witness data)"},
-                        {RPCResult::Type::ARR, "depends", "array of numbers",
+                        {RPCResult::Type::STR_HEX, "hash", /*optional=*/true, "hash encoded in little-endian hexadecimal (including witness data)"},
+                        {RPCResult::Type::ARR, "depends", /*optional=*/true, "array of numbers",
                         {
                             {RPCResult::Type::NUM, "", "transactions before this one (by 1-based index in 'transactions' list) that must be present in the final block if this one is"},
                         }},
-                        {RPCResult::Type::NUM, "feecash", "difference in unscaled cash value between transaction inputs and outputs (in satoshis); for coinbase transactions, this is a negative Number of the total collected block fees (ie, not including the block subsidy); if key is not present, fee is unknown and clients MUST NOT assume there isn't one"},
-                        {RPCResult::Type::NUM, "feebond", "difference in unscaled bond value between transaction inputs and outputs (in satoshis); for coinbase transactions, this is a negative Number of the total collected block fees (ie, not including the block subsidy); if key is not present, fee is unknown and clients MUST NOT assume there isn't one"},
-                        {RPCResult::Type::NUM, "sigops", "total SigOps cost, as counted for purposes of block limits; if key is not present, sigop cost is unknown and clients MUST NOT assume it is zero"},
-                        {RPCResult::Type::NUM, "weight", "total transaction weight, as counted for purposes of block limits"},
+                        {RPCResult::Type::NUM, "feecash", /*optional=*/true, "difference in unscaled cash value between transaction inputs and outputs (in satoshis); for coinbase transactions, this is a negative Number of the total collected block fees (ie, not including the block subsidy); if key is not present, fee is unknown and clients MUST NOT assume there isn't one"},
+                        {RPCResult::Type::NUM, "feebond", /*optional=*/true, "difference in unscaled bond value between transaction inputs and outputs (in satoshis); for coinbase transactions, this is a negative Number of the total collected block fees (ie, not including the block subsidy); if key is not present, fee is unknown and clients MUST NOT assume there isn't one"},
+                        {RPCResult::Type::NUM, "sigops", /*optional=*/true, "total SigOps cost, as counted for purposes of block limits; if key is not present, sigop cost is unknown and clients MUST NOT assume it is zero"},
+                        {RPCResult::Type::NUM, "weight", /*optional=*/true, "total transaction weight, as counted for purposes of block limits"},
                     }},
                 }},
+                {RPCResult::Type::STR_HEX, "templateid", "An id of the transactions of this template, to request a diff against it with 'templatediff'"},
+                {RPCResult::Type::STR_HEX, "difffrom", /*optional=*/true, "Only if the 'templatediff' template was known: the templateid the transactions are listed against"},
+                {RPCResult::Type::ARR, "removed", /*optional=*/true, "Only if the 'templatediff' template was known: the transactions of that template which are not in this one",
+                {
+                    {RPCResult::Type::STR_HEX, "", "The transaction id"},
+                }},
                 {RPCResult::Type::OBJ_DYN, "coinbaseaux", "data that should be included in the coinbase's scriptSig content",
                 {
                     {RPCResult::Type::STR_HEX, "key", "values must be in the coinbase (keys may be ignored)"},
@@ -594,6 +710,18 @@ static RPCHelpMan getblocktemplate()
                 {RPCResult::Type::NUM, "height", "The height of the next block"},
                 {RPCResult::Type::STR_HEX, "signet_challenge", /*optional=*/true, "Only on signet"},
                 {RPCResult::Type::STR_HEX, "default_witness_commitment", /*optional=*/true, "a valid witness commitment for the unmodified block template"},
+                {RPCResult::Type::ARR, "conversionorders", /*optional=*/true, "Only if conversions left out in feerate order were retried: the candidate templates built with each order of those conversions",
+                {
+                    {RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR, "order", "The order the conversions were retried in"},
+                        {RPCResult::Type::NUM, "conversions", "The number of conversions added"},
+                        {RPCResult::Type::NUM, "feecash", "The unscaled cash fees of the candidate, including conversion remainders paid to the miner (in satoshis)"},
+                        {RPCResult::Type::NUM, "feebond", "The unscaled bond fees of the candidate, including conversion remainders paid to the miner (in satoshis)"},
+                        {RPCResult::Type::NUM, "normalizedfee", "The fees with bonds converted to cash (in satoshis), which the candidates are compared by"},
+                        {RPCResult::Type::BOOL, "selected", "Whether this candidate is the returned template"},
+                    }},
+                }},
             }},
         },
         RPCExamples{
@@ -608,6 +736,7 @@ static RPCHelpMan getblocktemplate()
 
     std::string strMode = "template";
     UniValue lpval = NullUniValue;
+    std::optional<uint256> diff_from;
     std::set<std::string> setClientRules;
     Chainstate& active_chainstate = chainman.ActiveChainstate();
     CChain& active_chain = active_chainstate.m_chain;
@@ -624,6 +753,10 @@ static RPCHelpMan getblocktemplate()
         else
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid mode");
         lpval = find_value(oparam, "longpollid");
+        const UniValue& diffval = find_value(oparam, "templatediff");
+        if (!diffval.isNull()) {
+            diff_from = ParseHashV(diffval, "templatediff");
+        }
 
         if (strMode == "proposal")
         {
@@ -682,7 +815,8 @@ static RPCHelpMan getblocktemplate()
 
     if (!lpval.isNull())
     {
-        // Wait to respond until either the best block changes, OR a minute has passed and there are more transactions
+        // Wait to respond until either the best block changes, OR a minute has passed and there are more transactions.
+        // Clients receiving diffs are sent updates sooner, as they are cheap to send.
         uint256 hashWatchedChain;
         std::chrono::steady_clock::time_point checktxtime;
         unsigned int nTransactionsUpdatedLastLP;
@@ -705,7 +839,9 @@ static RPCHelpMan getblocktemplate()
         // Release lock while waiting
         LEAVE_CRITICAL_SECTION(cs_main);
         {
-            checktxtime = std::chrono::steady_clock::now() + std::chrono::minutes(1);
+            const std::chrono::seconds first_check{diff_from ? TEMPLATE_DIFF_POLL_INTERVAL : std::chrono::minutes(1)};
+            const std::chrono::seconds next_check{diff_from ? TEMPLATE_DIFF_POLL_INTERVAL : std::chrono::seconds(10)};
+            checktxtime = std::chrono::steady_clock::now() + first_check;
 
             WAIT_LOCK(g_best_block_mutex, lock);
             while (g_best_block == hashWatchedChain && IsRPCRunning())
@@ -716,7 +852,7 @@ static RPCHelpMan getblocktemplate()
                     // without holding the mempool lock to avoid deadlocks
                     if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
                         break;
-                    checktxtime += std::chrono::seconds(10);
+                    checktxtime += next_check;
                 }
             }
         }
@@ -743,11 +879,17 @@ static RPCHelpMan getblocktemplate()
     static CBlockIndex* pindexPrev;
     static int64_t nStart;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
+    // Encoding the transactions dominates calls that reuse the template, so they are
+    // encoded once per template (and segwit status), rather than on every poll.
+    static UniValue transactions;
+    static bool transactions_pre_segwit;
+    static uint256 template_id;
     if (pindexPrev != active_chain.Tip() ||
         (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
     {
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
         pindexPrev = nullptr;
+        transactions.clear();
 
         // Store the pindexBest used before CreateNewBlock, to avoid races
         nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
@@ -762,6 +904,17 @@ static RPCHelpMan getblocktemplate()
 
         // Need to update only after we know CreateNewBlock succeeded
         pindexPrev = pindexPrevNew;
+
+        std::vector<uint256> txids;
+        txids.reserve(pblocktemplate->block.vtx.size() - 1);
+        for (size_t i = 1; i < pblocktemplate->block.vtx.size(); ++i) {
+            txids.push_back(pblocktemplate->block.vtx[i]->GetHash());
+        }
+        template_id = (HashWriter{} << pindexPrev->GetBlockHash() << txids).GetHash();
+        if (g_served_templates.empty() || g_served_templates.back().id != template_id) {
+            g_served_templates.push_back({template_id, pblocktemplate->block});
+            if (g_served_templates.size() > MAX_SERVED_TEMPLATES) g_served_templates.pop_front();
+        }
     }
     CHECK_NONFATAL(pindexPrev);
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
@@ -775,43 +928,47 @@ static RPCHelpMan getblocktemplate()
 
     UniValue aCaps(UniValue::VARR); aCaps.push_back("proposal");
 
-    UniValue transactions(UniValue::VARR);
-    std::map<uint256, int64_t> setTxIndex;
-    int i = 0;
-    for (const auto& it : pblock->vtx) {
-        const CTransaction& tx = *it;
-        uint256 txHash = tx.GetHash();
-        setTxIndex[txHash] = i++;
+    if (transactions.isNull() || transactions_pre_segwit != fPreSegWit) {
+        UniValue encoded(UniValue::VARR);
+        std::map<uint256, int64_t> setTxIndex;
+        int i = 0;
+        for (const auto& it : pblock->vtx) {
+            const CTransaction& tx = *it;
+            uint256 txHash = tx.GetHash();
+            setTxIndex[txHash] = i++;
 
-        if (tx.IsCoinBase())
-            continue;
+            if (tx.IsCoinBase())
+                continue;
 
-        UniValue entry(UniValue::VOBJ);
+            UniValue entry(UniValue::VOBJ);
 
-        entry.pushKV("data", EncodeHexTx(tx));
-        entry.pushKV("txid", txHash.GetHex());
-        entry.pushKV("hash", tx.GetWitnessHash().GetHex());
+            entry.pushKV("data", EncodeHexTx(tx));
+            entry.pushKV("txid", txHash.GetHex());
+            entry.pushKV("hash", tx.GetWitnessHash().GetHex());
 
-        UniValue deps(UniValue::VARR);
-        for (const CTxIn &in : tx.vin)
-        {
-            if (setTxIndex.count(in.prevout.hash))
-                deps.push_back(setTxIndex[in.prevout.hash]);
-        }
-        entry.pushKV("depends", deps);
-
-        int index_in_template = i - 1;
-        entry.pushKV("feecash", pblocktemplate->vTxFeesCash[index_in_template]);
-        entry.pushKV("feebond", pblocktemplate->vTxFeesBond[index_in_template]);
-        int64_t nTxSigOps = pblocktemplate->vTxSigOpsCost[index_in_template];
-        if (fPreSegWit) {
-            CHECK_NONFATAL(nTxSigOps % WITNESS_SCALE_FACTOR == 0);
-            nTxSigOps /= WITNESS_SCALE_FACTOR;
-        }
-        entry.pushKV("sigops", nTxSigOps);
-        entry.pushKV("weight", GetTransactionWeight(tx));
+            UniValue deps(UniValue::VARR);
+            for (const CTxIn &in : tx.vin)
+            {
+                if (setTxIndex.count(in.prevout.hash))
+                    deps.push_back(setTxIndex[in.prevout.hash]);
+            }
+            entry.pushKV("depends", deps);
+
+            int index_in_template = i - 1;
+            entry.pushKV("feecash", pblocktemplate->vTxFeesCash[index_in_template]);
+            entry.pushKV("feebond", pblocktemplate->vTxFeesBond[index_in_template]);
+            int64_t nTxSigOps = pblocktemplate->vTxSigOpsCost[index_in_template];
+            if (fPreSegWit) {
+                CHECK_NONFATAL(nTxSigOps % WITNESS_SCALE_FACTOR == 0);
+                nTxSigOps /= WITNESS_SCALE_FACTOR;
+            }
+            entry.pushKV("sigops", nTxSigOps);
+            entry.pushKV("weight", GetTransactionWeight(tx));
 
-        transactions.push_back(entry);
+            encoded.push_back(entry);
+        }
+        transactions = std::move(encoded);
+        transactions_pre_segwit = fPreSegWit;
     }
 
     UniValue aux(UniValue::VOBJ);
@@ -881,7 +1038,36 @@ static RPCHelpMan getblocktemplate()
     result.pushKV("vbrequired", int(0));
 
     result.pushKV("previousblockhash", pblock->hashPrevBlock.GetHex());
-    result.pushKV("transactions", transactions);
+    const auto base = diff_from ? std::find_if(g_served_templates.begin(), g_served_templates.end(), [&](const ServedTemplate& served) { return served.id == *diff_from; }) : g_served_templates.end();
+    if (base == g_served_templates.end()) {
+        result.pushKV("transactions", transactions);
+    } else {
+        // List the transactions the client has by txid only. The order, and
+        // the indexes in 'depends', are those of the full template.
+        std::set<uint256> base_txids;
+        for (size_t i = 1; i < base->block.vtx.size(); ++i) {
+            base_txids.insert(base->block.vtx[i]->GetHash());
+        }
+        UniValue diff_transactions(UniValue::VARR);
+        for (size_t i = 1; i < pblock->vtx.size(); ++i) {
+            const uint256& txid = pblock->vtx[i]->GetHash();
+            if (base_txids.erase(txid) > 0) {
+                UniValue entry(UniValue::VOBJ);
+                entry.pushKV("txid", txid.GetHex());
+                diff_transactions.push_back(entry);
+            } else {
+                diff_transactions.push_back(transactions[i - 1]);
+            }
+        }
+        UniValue removed(UniValue::VARR);
+        for (const uint256& txid : base_txids) {
+            removed.push_back(txid.GetHex());
+        }
+        result.pushKV("transactions", diff_transactions);
+        result.pushKV("difffrom", diff_from->GetHex());
+        result.pushKV("removed", removed);
+    }
+    result.pushKV("templateid", template_id.GetHex());
     result.pushKV("coinbaseaux", aux);
     result.pushKV("coinbasecashvalue", (int64_t)pblock->vtx[0]->vout[CASH].nValue);
     result.pushKV("coinbasebondvalue", (int64_t)pblock->vtx[0]->vout[BOND].nValue);
@@ -917,6 +1103,21 @@ static RPCHelpMan getblocktemplate()
         result.pushKV("default_witness_commitment", HexStr(pblocktemplate->vchCoinbaseCommitment));
     }
 
+    if (!pblocktemplate->vConversionOrders.empty()) {
+        UniValue conversion_orders(UniValue::VARR);
+        for (const ConversionOrderResult& candidate : pblocktemplate->vConversionOrders) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("order", candidate.order);
+            entry.pushKV("conversions", candidate.nConversions);
+            entry.pushKV("feecash", candidate.fees[CASH]);
+            entry.pushKV("feebond", candidate.fees[BOND]);
+            entry.pushKV("normalizedfee", candidate.normalizedFees);
+            entry.pushKV("selected", candidate.selected);
+            conversion_orders.push_back(entry);
+        }
+        result.pushKV("conversionorders", conversion_orders);
+    }
+
     return result;
 },
     };
@@ -940,6 +1141,46 @@ protected:
     }
 };
 
+/** Process a block submitted by a miner, returning the result according to BIP22 */
+static UniValue SubmitBlock(ChainstateManager& chainman, const std::shared_ptr<CBlock>& blockptr)
+{
+    CBlock& block = *blockptr;
+    uint256 hash = block.GetHash();
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = chainman.m_blockman.LookupBlockIndex(hash);
+        if (pindex) {
+            if (pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
+                return "duplicate";
+            }
+            if (pindex->nStatus & BLOCK_FAILED_MASK) {
+                return "duplicate-invalid";
+            }
+        }
+    }
+
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = chainman.m_blockman.LookupBlockIndex(block.hashPrevBlock);
+        if (pindex) {
+            chainman.UpdateUncommittedBlockStructures(block, pindex);
+        }
+    }
+
+    bool new_block;
+    auto sc = std::make_shared<submitblock_StateCatcher>(block.GetHash());
+    RegisterSharedValidationInterface(sc);
+    bool accepted = chainman.ProcessNewBlock(blockptr, /*force_processing=*/true, /*min_pow_checked=*/true, /*new_block=*/&new_block);
+    UnregisterSharedValidationInterface(sc);
+    if (!new_block && accepted) {
+        return "duplicate";
+    }
+    if (!sc->found) {
+        return "inconclusive";
+    }
+    return BIP22ValidationResult(sc->state);
+}
+
 static RPCHelpMan submitblock()
 {
     // We allow 2 arguments for compliance with BIP22. Argument 2 is ignored.
@@ -970,41 +1211,66 @@ static RPCHelpMan submitblock()
         throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block does not start with a coinbase");
     }
 
-    ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    uint256 hash = block.GetHash();
-    {
-        LOCK(cs_main);
-        const CBlockIndex* pindex = chainman.m_blockman.LookupBlockIndex(hash);
-        if (pindex) {
-            if (pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
-                return "duplicate";
-            }
-            if (pindex->nStatus & BLOCK_FAILED_MASK) {
-                return "duplicate-invalid";
-            }
-        }
+    return SubmitBlock(EnsureAnyChainman(request.context), blockptr);
+},
+    };
+}
+
+static RPCHelpMan submittemplateblock()
+{
+    return RPCHelpMan{"submittemplateblock",
+        "\nAttempts to submit a new block built from a recent template of getblocktemplate to the network.\n"
+        "Only the header fields and the coinbase the miner chose are sent, the transactions are taken from the template.\n",
+        {
+            {"templateid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the templateid of the template"},
+            {"coinbase", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the hex-encoded coinbase transaction of the block"},
+            {"version", RPCArg::Type::NUM, RPCArg::Optional::NO, "the block version"},
+            {"time", RPCArg::Type::NUM, RPCArg::Optional::NO, "the block time"},
+            {"nonce", RPCArg::Type::NUM, RPCArg::Optional::NO, "the block nonce"},
+        },
+        {
+            RPCResult{"If the block was accepted", RPCResult::Type::NONE, "", ""},
+            RPCResult{"Otherwise", RPCResult::Type::STR, "", "According to BIP22"},
+        },
+        RPCExamples{
+                    HelpExampleCli("submittemplateblock", "\"templateid\" \"coinbase\" 536870912 1700000000 12345")
+            + HelpExampleRpc("submittemplateblock", "\"templateid\", \"coinbase\", 536870912, 1700000000, 12345")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const uint256 template_id{ParseHashV(request.params[0], "templateid")};
+    CMutableTransaction coinbase;
+    if (!DecodeHexTx(coinbase, request.params[1].get_str())) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Coinbase decode failed");
+    }
+    if (!CTransaction(coinbase).IsCoinBase()) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Transaction is not a coinbase");
     }
 
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    std::shared_ptr<CBlock> blockptr;
     {
         LOCK(cs_main);
-        const CBlockIndex* pindex = chainman.m_blockman.LookupBlockIndex(block.hashPrevBlock);
-        if (pindex) {
-            chainman.UpdateUncommittedBlockStructures(block, pindex);
+        const auto served = std::find_if(g_served_templates.begin(), g_served_templates.end(), [&](const ServedTemplate& served) { return served.id == template_id; });
+        if (served == g_served_templates.end()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown template");
+        }
+        blockptr = std::make_shared<CBlock>(served->block);
+        CBlock& block = *blockptr;
+        block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+        block.nVersion = request.params[2].getInt<int32_t>();
+        block.nTime = request.params[3].getInt<uint32_t>();
+        block.nNonce = request.params[4].getInt<uint32_t>();
+        // The time can change the work required on testnet, as in UpdateTime
+        const CBlockIndex* pindexPrev = chainman.m_blockman.LookupBlockIndex(block.hashPrevBlock);
+        const Consensus::Params& consensusParams = chainman.GetParams().GetConsensus();
+        if (pindexPrev && consensusParams.fPowAllowMinDifficultyBlocks) {
+            block.nBits = GetNextWorkRequired(pindexPrev, &block, consensusParams);
         }
+        block.hashMerkleRoot = BlockMerkleRoot(block);
     }
 
-    bool new_block;
-    auto sc = std::make_shared<submitblock_StateCatcher>(block.GetHash());
-    RegisterSharedValidationInterface(sc);
-    bool accepted = chainman.ProcessNewBlock(blockptr, /*force_processing=*/true, /*min_pow_checked=*/true, /*new_block=*/&new_block);
-    UnregisterSharedValidationInterface(sc);
-    if (!new_block && accepted) {
-        return "duplicate";
-    }
-    if (!sc->found) {
-        return "inconclusive";
-    }
-    return BIP22ValidationResult(sc->state);
+    return SubmitBlock(chainman, blockptr);
 },
     };
 }
@@ -1056,11 +1322,13 @@ void RegisterMiningRPCCommands(CRPCTable& t)
         {"mining", &prioritisetransaction},
         {"mining", &getblocktemplate},
         {"mining", &submitblock},
+        {"mining", &submittemplateblock},
         {"mining", &submitheader},
 
         {"hidden", &generatetoaddress},
         {"hidden", &generatetodescriptor},
         {"hidden", &generateblock},
+        {"hidden", &generateemptyblocks},
         {"hidden", &generate},
     };
     for (const auto& c : commands) {
@@ -160,6 +160,12 @@ static RPCHelpMan getpeerinfo()
                                                       "Only known message types can appear as keys in the object and all bytes received\n"
                                                       "of unknown message types are listed under '"+NET_MESSAGE_TYPE_OTHER+"'."}
                     }},
+                    {RPCResult::Type::OBJ, "memory", "Memory used for this peer, in bytes",
+                    {
+                        {RPCResult::Type::NUM, "send_queue", "Messages queued to be sent to the peer"},
+                        {RPCResult::Type::NUM, "process_queue", "Messages received from the peer and queued to be processed"},
+                        {RPCResult::Type::NUM, "tx_relay", /*optional=*/true, "Filters and queues for announcing transactions to the peer"},
+                    }},
                     {RPCResult::Type::STR, "connection_type", "Type of connection: \n" + Join(CONNECTION_TYPE_DOC, ",\n") + ".\n"
                                                               "Please note this output is unlikely to be stable in upcoming releases as we iterate to\n"
                                                               "best capture connection behaviors."},
@@ -260,6 +266,13 @@ static RPCHelpMan getpeerinfo()
                 recvPerMsgType.pushKV(i.first, i.second);
         }
         obj.pushKV("bytesrecv_per_msg", recvPerMsgType);
+        UniValue memory(UniValue::VOBJ);
+        memory.pushKV("send_queue", stats.m_send_queue_size);
+        memory.pushKV("process_queue", stats.m_process_queue_size);
+        if (fStateStats) {
+            memory.pushKV("tx_relay", statestats.m_tx_relay_memory);
+        }
+        obj.pushKV("memory", memory);
         obj.pushKV("connection_type", ConnectionTypeAsString(stats.m_conn_type));
 
         ret.push_back(obj);
@@ -3,26 +3,41 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <addrman.h>
 #include <chainparams.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/conversionindex.h>
 #include <index/txindex.h>
+#include <index/txospenderindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/echo.h>
 #include <interfaces/init.h>
 #include <interfaces/ipc.h>
+#include <interfaces/wallet.h>
+#include <net.h>
+#include <net_processing.h>
 #include <node/context.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <scheduler.h>
+#include <script/sigcache.h>
+#include <sync.h>
+#include <txmempool.h>
 #include <univalue.h>
 #include <util/check.h>
 #include <util/syscall_sandbox.h>
+#include <util/threadpool.h>
 #include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
 
+#include <algorithm>
+#include <map>
 #include <stdint.h>
+#include <vector>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
 #endif
@@ -210,6 +225,300 @@ static RPCHelpMan getmemoryinfo()
     };
 }
 
+static UniValue CacheStatsToJSON(const CuckooCache::stats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    obj.pushKV("evictions", stats.evictions);
+    return obj;
+}
+
+static RPCHelpMan getcacheinfo()
+{
+    const std::vector<RPCResult> cache_stats{
+        {RPCResult::Type::NUM, "hits", "Number of lookups that found an entry"},
+        {RPCResult::Type::NUM, "misses", "Number of lookups that found no entry"},
+        {RPCResult::Type::NUM, "evictions", "Number of entries dropped by inserts that found no free slot. Older entries are otherwise overwritten without being counted."},
+    };
+    return RPCHelpMan{"getcacheinfo",
+                "Returns statistics about the signature and script execution caches since startup.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "signatures", "Cache of valid signatures", cache_stats},
+                        {RPCResult::Type::OBJ, "scripts", "Cache of transactions whose scripts were all valid", cache_stats},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getcacheinfo", "")
+            + HelpExampleRpc("getcacheinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("signatures", CacheStatsToJSON(GetSignatureCacheStats()));
+    obj.pushKV("scripts", CacheStatsToJSON(GetScriptExecutionCacheStats()));
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getmemoryusage()
+{
+    return RPCHelpMan{"getmemoryusage",
+                "Returns the number of bytes of dynamic memory used by the main data structures of the node and by each loaded wallet.\n"
+                "The numbers are estimates of the heap usage of each structure, and don't add up to the memory usage of the process.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "coins_cache", "The UTXO cache of every chainstate"},
+                        {RPCResult::Type::NUM, "mempool", "The transaction memory pool"},
+                        {RPCResult::Type::NUM, "orphanage", "Orphan transactions"},
+                        {RPCResult::Type::NUM, "block_index", "The block index and the block file information"},
+                        {RPCResult::Type::NUM, "headers_sync", "The state of the headers presyncs with peers"},
+                        {RPCResult::Type::NUM, "addrman", "The address manager"},
+                        {RPCResult::Type::NUM, "peer_buffers", "The send and receive buffers of the peers"},
+                        {RPCResult::Type::NUM, "tx_relay", "The transaction relay state of the peers"},
+                        {RPCResult::Type::NUM, "signature_cache", "The signature cache"},
+                        {RPCResult::Type::NUM, "script_cache", "The script execution cache"},
+                        {RPCResult::Type::ARR, "wallets", "The loaded wallets",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The wallet name"},
+                                {RPCResult::Type::NUM, "usage", "The transactions, spends, coins and address book of the wallet"},
+                            }},
+                        }},
+                        {RPCResult::Type::NUM, "total", "The sum of the above"},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getmemoryusage", "")
+            + HelpExampleRpc("getmemoryusage", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const NodeContext& node = EnsureAnyNodeContext(request.context);
+    size_t total{0};
+    UniValue obj(UniValue::VOBJ);
+    const auto push{[&](const std::string& key, size_t usage) {
+        total += usage;
+        obj.pushKV(key, uint64_t{usage});
+    }};
+
+    size_t coins_cache{0};
+    size_t block_index{0};
+    if (node.chainman) {
+        LOCK(cs_main);
+        for (Chainstate* chainstate : node.chainman->GetAll()) {
+            coins_cache += chainstate->CoinsTip().DynamicMemoryUsage();
+        }
+        block_index = node.chainman->m_blockman.DynamicMemoryUsage();
+    }
+    const PeerManagerMemoryUsage peer_usage{node.peerman ? node.peerman->GetMemoryUsage() : PeerManagerMemoryUsage{}};
+    push("coins_cache", coins_cache);
+    push("mempool", node.mempool ? node.mempool->DynamicMemoryUsage() : 0);
+    push("orphanage", peer_usage.orphanage);
+    push("block_index", block_index);
+    push("headers_sync", peer_usage.headers_sync);
+    push("addrman", node.addrman ? node.addrman->DynamicMemoryUsage() : 0);
+    push("peer_buffers", node.connman ? node.connman->GetBufferMemoryUsage() : 0);
+    push("tx_relay", peer_usage.tx_relay);
+    push("signature_cache", GetSignatureCacheMemoryUsage());
+    push("script_cache", GetScriptExecutionCacheMemoryUsage());
+
+    UniValue wallets(UniValue::VARR);
+    if (node.wallet_loader) {
+        for (const auto& wallet : node.wallet_loader->getWallets()) {
+            const size_t usage{wallet->getMemoryUsage()};
+            total += usage;
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("name", wallet->getWalletName());
+            entry.pushKV("usage", uint64_t{usage});
+            wallets.push_back(entry);
+        }
+    }
+    obj.pushKV("wallets", wallets);
+    obj.pushKV("total", uint64_t{total});
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getlockstats()
+{
+    return RPCHelpMan{"getlockstats",
+                "Returns the contention of cs_main, the mempool, wallet and node list locks per acquisition site, "
+                "recorded since startup or the last reset when the node runs with -lockstats.\n",
+                {
+                    {"reset", RPCArg::Type::BOOL, RPCArg::Default{false}, "Clear the statistics after returning them."},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::BOOL, "enabled", "Whether lock profiling is enabled"},
+                        {RPCResult::Type::NUM, "sample_interval", "One in this many acquisitions has its hold time measured"},
+                        {RPCResult::Type::ARR, "sites", "The acquisition sites, longest total wait first",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "lock", "The lock (cs_main, mempool.cs, cs_wallet or m_nodes_mutex)"},
+                                {RPCResult::Type::STR, "file", "The source file of the acquisition"},
+                                {RPCResult::Type::NUM, "line", "The source line of the acquisition"},
+                                {RPCResult::Type::NUM, "acquisitions", "The number of acquisitions"},
+                                {RPCResult::Type::NUM, "contentions", "The number of acquisitions that had to wait for the lock"},
+                                {RPCResult::Type::NUM, "wait_us", "The total time spent waiting for the lock in microseconds"},
+                                {RPCResult::Type::NUM, "max_wait_us", "The longest wait in microseconds"},
+                                {RPCResult::Type::NUM, "hold_samples", "The number of acquisitions whose hold time was measured"},
+                                {RPCResult::Type::NUM, "hold_us", "The total measured hold time in microseconds"},
+                                {RPCResult::Type::NUM, "max_hold_us", "The longest measured hold in microseconds"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "true")
+            + HelpExampleRpc("getlockstats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const auto to_us{[](std::chrono::nanoseconds ns) { return Ticks<std::chrono::microseconds>(ns); }};
+    UniValue sites(UniValue::VARR);
+    for (const LockProfileStats& stats : GetLockProfileStats()) {
+        UniValue site(UniValue::VOBJ);
+        site.pushKV("lock", stats.lock_name);
+        site.pushKV("file", stats.file);
+        site.pushKV("line", stats.line);
+        site.pushKV("acquisitions", stats.acquisitions);
+        site.pushKV("contentions", stats.contentions);
+        site.pushKV("wait_us", to_us(stats.wait_time));
+        site.pushKV("max_wait_us", to_us(stats.max_wait_time));
+        site.pushKV("hold_samples", stats.hold_samples);
+        site.pushKV("hold_us", to_us(stats.hold_time));
+        site.pushKV("max_hold_us", to_us(stats.max_hold_time));
+        sites.push_back(site);
+    }
+    if (!request.params[0].isNull() && request.params[0].get_bool()) ResetLockProfileStats();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("enabled", LockProfilingEnabled());
+    obj.pushKV("sample_interval", (uint64_t)g_lock_profile_interval.load(std::memory_order_relaxed));
+    obj.pushKV("sites", sites);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getschedulerinfo()
+{
+    return RPCHelpMan{"getschedulerinfo",
+                "Returns the number of queued background tasks and the runtime of the named periodic tasks since startup.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "queued", "The number of tasks waiting to run"},
+                        {RPCResult::Type::ARR, "tasks", "The named tasks that ran, longest total runtime first",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The name of the task"},
+                                {RPCResult::Type::NUM, "runs", "The number of times the task ran"},
+                                {RPCResult::Type::NUM, "time_us", "The total runtime in microseconds"},
+                                {RPCResult::Type::NUM, "max_time_us", "The longest run in microseconds"},
+                                {RPCResult::Type::NUM, "delay_us", "The total time runs started after their scheduled time in microseconds"},
+                                {RPCResult::Type::NUM, "max_delay_us", "The longest delay of a run in microseconds"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getschedulerinfo", "")
+            + HelpExampleRpc("getschedulerinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    CScheduler& scheduler{*CHECK_NONFATAL(EnsureAnyNodeContext(request.context).scheduler)};
+    std::chrono::steady_clock::time_point first, last;
+    const size_t queued{scheduler.getQueueInfo(first, last)};
+    const std::map<std::string, CScheduler::TaskStats> task_stats{scheduler.GetTaskStats()};
+    std::vector<std::pair<std::string, CScheduler::TaskStats>> sorted(task_stats.begin(), task_stats.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.total_time > b.second.total_time; });
+
+    const auto to_us{[](std::chrono::nanoseconds ns) { return Ticks<std::chrono::microseconds>(ns); }};
+    UniValue tasks(UniValue::VARR);
+    for (const auto& [name, stats] : sorted) {
+        UniValue task(UniValue::VOBJ);
+        task.pushKV("name", name);
+        task.pushKV("runs", stats.runs);
+        task.pushKV("time_us", to_us(stats.total_time));
+        task.pushKV("max_time_us", to_us(stats.max_time));
+        task.pushKV("delay_us", to_us(stats.total_delay));
+        task.pushKV("max_delay_us", to_us(stats.max_delay));
+        tasks.push_back(task);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("queued", (uint64_t)queued);
+    obj.pushKV("tasks", tasks);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getthreadpoolinfo()
+{
+    return RPCHelpMan{"getthreadpoolinfo",
+                "Returns the size of the thread pool and the utilisation of the workers by each of the pools of tasks using it.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "threads", "The number of worker threads"},
+                        {RPCResult::Type::ARR, "pools", "The pools of tasks, in the order they were created",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The name of the pool"},
+                                {RPCResult::Type::STR, "priority", "The priority of its tasks (high, normal or low)"},
+                                {RPCResult::Type::NUM, "tasks_run", "The number of tasks that ran"},
+                                {RPCResult::Type::NUM, "tasks_stolen", "The number of tasks that ran on another worker than the one they were queued for"},
+                                {RPCResult::Type::NUM, "queued", "The number of tasks waiting for a worker"},
+                                {RPCResult::Type::NUM, "running", "The number of tasks running"},
+                                {RPCResult::Type::NUM, "busy_us", "The total time workers spent running its tasks in microseconds"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getthreadpoolinfo", "")
+            + HelpExampleRpc("getthreadpoolinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const util::ThreadPool& thread_pool{*CHECK_NONFATAL(EnsureAnyNodeContext(request.context).thread_pool)};
+    UniValue pools(UniValue::VARR);
+    for (const util::TaskPoolStats& stats : thread_pool.GetStats()) {
+        UniValue pool(UniValue::VOBJ);
+        pool.pushKV("name", stats.name);
+        pool.pushKV("priority", util::TaskPriorityToString(stats.priority));
+        pool.pushKV("tasks_run", stats.tasks_run);
+        pool.pushKV("tasks_stolen", stats.tasks_stolen);
+        pool.pushKV("queued", (uint64_t)stats.queued);
+        pool.pushKV("running", (uint64_t)stats.running);
+        pool.pushKV("busy_us", Ticks<std::chrono::microseconds>(stats.busy_time));
+        pools.push_back(pool);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("threads", thread_pool.GetThreadCount());
+    obj.pushKV("pools", pools);
+    return obj;
+},
+    };
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (unsigned int i = 0; i < cats.size(); ++i) {
@@ -410,6 +719,14 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_conversion_index) {
+        result.pushKVs(SummaryToJSON(g_conversion_index->GetSummary(), index_name));
+    }
+
+    if (g_txospenderindex) {
+        result.pushKVs(SummaryToJSON(g_txospenderindex->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
@@ -423,6 +740,11 @@ void RegisterNodeRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"control", &getmemoryinfo},
+        {"control", &getcacheinfo},
+        {"control", &getmemoryusage},
+        {"control", &getlockstats},
+        {"control", &getschedulerinfo},
+        {"control", &getthreadpoolinfo},
         {"control", &logging},
         {"util", &getindexinfo},
         {"hidden", &setmocktime},
@@ -40,6 +40,7 @@
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <map>
 #include <numeric>
 #include <stdint.h>
 
@@ -50,6 +51,7 @@ using node::FindCoins;
 using node::GetTransaction;
 using node::NodeContext;
 using node::PSBTAnalysis;
+using node::ReadBlockFromDisk;
 
 static void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry, Chainstate& active_chainstate)
 {
@@ -186,9 +188,12 @@ static RPCHelpMan getrawtransaction()
                 "\nHint: Use gettransaction for wallet transactions.\n"
 
                 "\nIf verbose is 'true', returns an Object with information about 'txid'.\n"
-                "If verbose is 'false' or omitted, returns a string that is serialized, hex-encoded data for 'txid'.",
+                "If verbose is 'false' or omitted, returns a string that is serialized, hex-encoded data for 'txid'.\n"
+                "\nIf 'txid' is an array of transaction ids, returns an array with the result for each of them,\n"
+                "which is null for transactions that are not found. With -txindex, the transactions are read\n"
+                "together, in the order they are stored on disk.",
                 {
-                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id, or an array of transaction ids", "", {"", "string or array"}},
                     {"verbose", RPCArg::Type::BOOL, RPCArg::Default{false}, "If false, return a string, otherwise return a json object"},
                     {"blockhash", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED_NAMED_ARG, "The block in which to look for the transaction"},
                 },
@@ -209,6 +214,12 @@ static RPCHelpMan getrawtransaction()
                          },
                          DecodeTxDoc(/*txid_field_doc=*/"The transaction id (same as provided)")),
                     },
+                    RPCResult{"if txid is an array",
+                        RPCResult::Type::ARR, "", "",
+                        {
+                            {RPCResult::Type::ELISION, "", "The result for each transaction id, as above, or null if it is not found"},
+                        },
+                    },
                 },
                 RPCExamples{
                     HelpExampleCli("getrawtransaction", "\"mytxid\"")
@@ -216,6 +227,7 @@ static RPCHelpMan getrawtransaction()
             + HelpExampleRpc("getrawtransaction", "\"mytxid\", true")
             + HelpExampleCli("getrawtransaction", "\"mytxid\" false \"myblockhash\"")
             + HelpExampleCli("getrawtransaction", "\"mytxid\" true \"myblockhash\"")
+            + HelpExampleRpc("getrawtransaction", "[\"mytxid\", \"myothertxid\"], true")
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
@@ -223,12 +235,22 @@ static RPCHelpMan getrawtransaction()
     ChainstateManager& chainman = EnsureChainman(node);
 
     bool in_active_chain = true;
-    uint256 hash = ParseHashV(request.params[0], "parameter 1");
+    const bool batch{request.params[0].isArray()};
+    std::vector<uint256> hashes;
+    if (batch) {
+        for (const UniValue& txid : request.params[0].getValues()) {
+            hashes.push_back(ParseHashV(txid, "txid"));
+        }
+    } else {
+        hashes.push_back(ParseHashV(request.params[0], "parameter 1"));
+    }
     const CBlockIndex* blockindex = nullptr;
 
-    if (hash == chainman.GetParams().GenesisBlock().hashMerkleRoot) {
-        // Special exception for the genesis block coinbase transaction
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "The genesis block coinbase is not considered an ordinary transaction and cannot be retrieved");
+    for (const uint256& hash : hashes) {
+        if (hash == chainman.GetParams().GenesisBlock().hashMerkleRoot) {
+            // Special exception for the genesis block coinbase transaction
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "The genesis block coinbase is not considered an ordinary transaction and cannot be retrieved");
+        }
     }
 
     // Accept either a bool (true) or a num (>=1) to indicate verbose output.
@@ -253,6 +275,54 @@ static RPCHelpMan getrawtransaction()
         f_txindex_ready = g_txindex->BlockUntilSyncedToCurrentChain();
     }
 
+    if (batch) {
+        std::vector<std::pair<uint256, CTransactionRef>> txs(hashes.size());
+        if (blockindex) {
+            CBlock block;
+            if (!ReadBlockFromDisk(block, blockindex, chainman.GetConsensus())) {
+                throw JSONRPCError(RPC_MISC_ERROR, "Block not available");
+            }
+            std::map<uint256, CTransactionRef> block_txs;
+            for (const auto& tx : block.vtx) block_txs.emplace(tx->GetHash(), tx);
+            for (size_t i = 0; i < hashes.size(); ++i) {
+                auto it{block_txs.find(hashes[i])};
+                if (it != block_txs.end()) txs[i] = {blockindex->GetBlockHash(), it->second};
+            }
+        } else {
+            std::vector<uint256> confirmed_hashes;
+            std::vector<size_t> confirmed_indexes;
+            for (size_t i = 0; i < hashes.size(); ++i) {
+                if (node.mempool) txs[i].second = node.mempool->get(hashes[i]);
+                if (!txs[i].second) {
+                    confirmed_hashes.push_back(hashes[i]);
+                    confirmed_indexes.push_back(i);
+                }
+            }
+            if (g_txindex && !confirmed_hashes.empty()) {
+                auto found{g_txindex->FindTxs(confirmed_hashes)};
+                for (size_t i = 0; i < found.size(); ++i) {
+                    txs[confirmed_indexes[i]] = std::move(found[i]);
+                }
+            }
+        }
+
+        UniValue results(UniValue::VARR);
+        for (const auto& [hash_block, tx] : txs) {
+            if (!tx) {
+                results.push_back(NullUniValue);
+            } else if (!fVerbose) {
+                results.push_back(EncodeHexTx(*tx, RPCSerializationFlags()));
+            } else {
+                UniValue result(UniValue::VOBJ);
+                if (blockindex) result.pushKV("in_active_chain", in_active_chain);
+                TxToJSON(*tx, hash_block, result, chainman.ActiveChainstate());
+                results.push_back(result);
+            }
+        }
+        return results;
+    }
+
+    const uint256& hash{hashes[0]};
     uint256 hash_block;
     const CTransactionRef tx = GetTransaction(blockindex, node.mempool.get(), hash, chainman.GetConsensus(), hash_block);
     if (!tx) {
@@ -15,6 +15,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 /**
@@ -35,21 +36,21 @@ UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params,
     return request;
 }
 
-UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id)
+UniValue JSONRPCReplyObj(UniValue result, UniValue error, UniValue id)
 {
     UniValue reply(UniValue::VOBJ);
     if (!error.isNull())
         reply.pushKV("result", NullUniValue);
     else
-        reply.pushKV("result", result);
-    reply.pushKV("error", error);
-    reply.pushKV("id", id);
+        reply.pushKV("result", std::move(result));
+    reply.pushKV("error", std::move(error));
+    reply.pushKV("id", std::move(id));
     return reply;
 }
 
-std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id)
+std::string JSONRPCReply(UniValue result, UniValue error, UniValue id)
 {
-    UniValue reply = JSONRPCReplyObj(result, error, id);
+    UniValue reply = JSONRPCReplyObj(std::move(result), std::move(error), std::move(id));
     return reply.write() + "\n";
 }
 
@@ -5,21 +5,30 @@
 
 #include <rpc/server.h>
 
+#include <httpserver.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <unordered_map>
+#include <vector>
+
+/** Minimum number of consecutive read-only calls in a batch request that are run on several threads */
+static constexpr size_t MIN_PARALLEL_BATCH_CALLS{16};
 
 static GlobalMutex g_rpc_warmup_mutex;
 static std::atomic<bool> g_rpc_running{false};
@@ -221,6 +230,27 @@ static RPCHelpMan getrpcinfo()
                             }},
                         }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
+                        {RPCResult::Type::ARR, "work_queues", "The HTTP work queues serving RPC calls",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                 {RPCResult::Type::STR, "name", "default, or priority for the queue serving getblocktemplate, submitblock and submitheader"},
+                                 {RPCResult::Type::NUM, "threads", "The number of worker threads"},
+                                 {RPCResult::Type::NUM, "depth", "The number of requests waiting for a worker"},
+                                 {RPCResult::Type::NUM, "max_depth", "The number of waiting requests at which new connections are no longer accepted"},
+                                 {RPCResult::Type::NUM, "last_wait", "The time the most recently started request waited, in microseconds"},
+                            }},
+                        }},
+                        {RPCResult::Type::OBJ, "connections", "The HTTP connections of the RPC server",
+                        {
+                            {RPCResult::Type::NUM, "open", "The number of open connections"},
+                            {RPCResult::Type::NUM, "accepted", "The number of connections requests arrived on"},
+                            {RPCResult::Type::NUM, "requests", "The number of requests received"},
+                            {RPCResult::Type::NUM, "reused", "The number of requests received over a connection kept alive after an earlier request"},
+                            {RPCResult::Type::NUM, "request_limit_closes", "The number of connections closed for reaching -rpcmaxrequestsperconnection"},
+                            {RPCResult::Type::BOOL, "accepting", "Whether new connections are accepted, rather than held back because a work queue is full"},
+                            {RPCResult::Type::NUM, "accept_pauses", "The number of times new connections were held back"},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -244,6 +274,29 @@ static RPCHelpMan getrpcinfo()
     UniValue log_path(UniValue::VSTR, path);
     result.pushKV("logpath", log_path);
 
+    UniValue work_queues(UniValue::VARR);
+    for (const HTTPWorkQueueInfo& info : GetHTTPWorkQueueInfo()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("name", info.name);
+        entry.pushKV("threads", info.threads);
+        entry.pushKV("depth", uint64_t{info.depth});
+        entry.pushKV("max_depth", uint64_t{info.max_depth});
+        entry.pushKV("last_wait", int64_t{info.last_wait.count()});
+        work_queues.push_back(entry);
+    }
+    result.pushKV("work_queues", work_queues);
+
+    const HTTPConnectionInfo connection_info{GetHTTPConnectionInfo()};
+    UniValue connections(UniValue::VOBJ);
+    connections.pushKV("open", uint64_t{connection_info.open});
+    connections.pushKV("accepted", connection_info.accepted);
+    connections.pushKV("requests", connection_info.requests);
+    connections.pushKV("reused", connection_info.reused);
+    connections.pushKV("request_limit_closes", connection_info.request_limit_closes);
+    connections.pushKV("accepting", connection_info.accepting);
+    connections.pushKV("accept_pauses", connection_info.accept_pauses);
+    result.pushKV("connections", connections);
+
     return result;
 }
     };
@@ -361,7 +414,7 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
         jreq.parse(req);
 
         UniValue result = tableRPC.execute(jreq);
-        rpc_result = JSONRPCReplyObj(result, NullUniValue, jreq.id);
+        rpc_result = JSONRPCReplyObj(std::move(result), NullUniValue, jreq.id);
     }
     catch (const UniValue& objError)
     {
@@ -376,12 +429,47 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
+/** Whether a batch item is a read-only call that can run concurrently with others */
+static bool IsParallelBatchCall(const UniValue& req)
+{
+    // Calls that only read the chain, block files or indexes
+    static const std::set<std::string> PARALLEL_BATCH_METHODS{
+        "getbestblockhash", "getblock", "getblockcount", "getblockhash", "getblockheader", "getrawtransaction", "gettxout",
+    };
+    if (!req.isObject()) return false;
+    const UniValue& method = find_value(req, "method");
+    return method.isStr() && PARALLEL_BATCH_METHODS.count(method.get_str());
+}
+
 std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    // Runs of read-only calls are spread over up to -rpcthreads tasks of the shared thread
+    // pool, whatever the size of the batch. Other calls run one at a time, in order, after
+    // the calls before them have completed.
+    const size_t num_threads{(size_t)std::max<int64_t>(gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1)};
+    std::vector<UniValue> results(vReq.size());
+    size_t reqIdx = 0;
+    while (reqIdx < vReq.size()) {
+        size_t end = reqIdx;
+        while (end < vReq.size() && IsParallelBatchCall(vReq[end])) ++end;
+        if (num_threads == 1 || end - reqIdx < MIN_PARALLEL_BATCH_CALLS) {
+            for (end = std::max(end, reqIdx + 1); reqIdx < end; ++reqIdx) {
+                results[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+            }
+            continue;
+        }
+
+        const size_t first{reqIdx};
+        util::ParallelFor("rpcbatch", util::TaskPriority::NORMAL, end - first, num_threads, [&](size_t i) {
+            results[first + i] = JSONRPCExecOne(jreq, vReq[first + i]);
+        });
+        reqIdx = end;
+    }
 
+    UniValue ret(UniValue::VARR);
+    for (UniValue& result : results) {
+        ret.push_back(std::move(result));
+    }
     return ret.write() + "\n";
 }
 
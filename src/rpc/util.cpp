@@ -1094,12 +1094,12 @@ std::vector<CScript> EvalDescriptorStringOrObject(const UniValue& scanobject, Fl
         range.first = 0;
         range.second = 0;
     }
+    std::vector<std::vector<CScript>> range_scripts;
+    if (!ExpandRange(*desc, range.first, range.second, provider, range_scripts, provider)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Cannot derive script without private keys: '%s'", desc_str));
+    }
     std::vector<CScript> ret;
-    for (int i = range.first; i <= range.second; ++i) {
-        std::vector<CScript> scripts;
-        if (!desc->Expand(i, provider, scripts, provider)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("Cannot derive script without private keys: '%s'", desc_str));
-        }
+    for (std::vector<CScript>& scripts : range_scripts) {
         std::move(scripts.begin(), scripts.end(), std::back_inserter(ret));
     }
     return ret;
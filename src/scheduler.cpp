@@ -8,16 +8,156 @@
 #include <util/syscall_sandbox.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <iterator>
+#include <tuple>
 #include <utility>
 
-CScheduler::CScheduler() = default;
+static int64_t TimeToTick(std::chrono::steady_clock::time_point t)
+{
+    return Ticks<std::chrono::milliseconds>(t.time_since_epoch());
+}
+
+static bool TaskBefore(const TimerWheel::Task& a, const TimerWheel::Task& b)
+{
+    return std::tie(a.time, a.sequence) < std::tie(b.time, b.sequence);
+}
+
+TimerWheel::TimerWheel(std::chrono::steady_clock::time_point now) : m_tick{TimeToTick(now)} {}
+
+void TimerWheel::Place(Task task)
+{
+    const int64_t tick{std::max(TimeToTick(task.time), m_tick)};
+    // Use the finest level whose slots cover the tick within the range of the
+    // current slot of the level above, so that the slots before m_tick stay empty.
+    for (int level = 0; level < LEVELS; ++level) {
+        if ((tick >> (SLOT_BITS * (level + 1))) == (m_tick >> (SLOT_BITS * (level + 1)))) {
+            m_wheels[level][(tick >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(std::move(task));
+            return;
+        }
+    }
+    const auto time{task.time};
+    m_overflow.emplace(time, std::move(task));
+}
+
+void TimerWheel::Insert(Task task)
+{
+    task.sequence = m_next_sequence++;
+    Place(std::move(task));
+    ++m_size;
+}
+
+void TimerWheel::Advance(std::chrono::steady_clock::time_point now)
+{
+    const int64_t tick{std::max(TimeToTick(now), m_tick)};
+
+    // Take every task out of the slots the wheel moves through. They are either
+    // due or share a slot of their level with the new tick, in which case they
+    // are placed again on a finer level.
+    std::vector<Task> taken;
+    for (int level = 0; level < LEVELS; ++level) {
+        const int shift{SLOT_BITS * level};
+        size_t first{size_t(m_tick >> shift) & (SLOTS - 1)};
+        size_t last{size_t(tick >> shift) & (SLOTS - 1)};
+        if ((tick >> (shift + SLOT_BITS)) != (m_tick >> (shift + SLOT_BITS))) {
+            // The wheel went around: all of this level is due
+            first = 0;
+            last = SLOTS - 1;
+        }
+        for (size_t slot = first; slot <= last; ++slot) {
+            std::vector<Task>& tasks{m_wheels[level][slot]};
+            std::move(tasks.begin(), tasks.end(), std::back_inserter(taken));
+            tasks.clear();
+        }
+    }
+    const int64_t top{tick >> (SLOT_BITS * LEVELS)};
+    while (!m_overflow.empty() && (TimeToTick(m_overflow.begin()->first) >> (SLOT_BITS * LEVELS)) <= top) {
+        taken.push_back(std::move(m_overflow.begin()->second));
+        m_overflow.erase(m_overflow.begin());
+    }
+
+    m_tick = tick;
+    const size_t ready{m_ready.size()};
+    for (Task& task : taken) {
+        if (task.time <= now) {
+            m_ready.push_back(std::move(task));
+        } else {
+            Place(std::move(task));
+        }
+    }
+    std::sort(m_ready.begin() + ready, m_ready.end(), TaskBefore);
+    std::inplace_merge(m_ready.begin(), m_ready.begin() + ready, m_ready.end(), TaskBefore);
+}
+
+TimerWheel::Task TimerWheel::PopReady()
+{
+    assert(!m_ready.empty());
+    Task task{std::move(m_ready.front())};
+    m_ready.pop_front();
+    --m_size;
+    return task;
+}
+
+std::chrono::steady_clock::time_point TimerWheel::NextTime() const
+{
+    assert(!Empty());
+    if (!m_ready.empty()) return m_ready.front().time;
+    auto next{std::chrono::steady_clock::time_point::max()};
+    for (int level = 0; level < LEVELS; ++level) {
+        // Slots are in time order from the current one, so the earliest task
+        // of the level is in its first non-empty slot.
+        for (size_t slot = size_t(m_tick >> (SLOT_BITS * level)) & (SLOTS - 1); slot < SLOTS; ++slot) {
+            const std::vector<Task>& tasks{m_wheels[level][slot]};
+            if (tasks.empty()) continue;
+            for (const Task& task : tasks) next = std::min(next, task.time);
+            break;
+        }
+    }
+    if (!m_overflow.empty()) next = std::min(next, m_overflow.begin()->first);
+    return next;
+}
+
+std::chrono::steady_clock::time_point TimerWheel::LastTime() const
+{
+    assert(!Empty());
+    auto last{std::chrono::steady_clock::time_point::min()};
+    for (const Task& task : m_ready) last = std::max(last, task.time);
+    for (const auto& level : m_wheels) {
+        for (const std::vector<Task>& tasks : level) {
+            for (const Task& task : tasks) last = std::max(last, task.time);
+        }
+    }
+    if (!m_overflow.empty()) last = std::max(last, m_overflow.rbegin()->first);
+    return last;
+}
+
+void TimerWheel::Shift(std::chrono::steady_clock::duration delta)
+{
+    std::vector<Task> tasks;
+    std::move(m_ready.begin(), m_ready.end(), std::back_inserter(tasks));
+    m_ready.clear();
+    for (auto& level : m_wheels) {
+        for (std::vector<Task>& slot : level) {
+            std::move(slot.begin(), slot.end(), std::back_inserter(tasks));
+            slot.clear();
+        }
+    }
+    for (auto& [time, task] : m_overflow) tasks.push_back(std::move(task));
+    m_overflow.clear();
+    for (Task& task : tasks) {
+        task.time -= delta;
+        Place(std::move(task));
+    }
+}
+
+CScheduler::CScheduler() : taskQueue{std::chrono::steady_clock::now()} {}
 
 CScheduler::~CScheduler()
 {
     assert(nThreadsServicingQueue == 0);
-    if (stopWhenEmpty) assert(taskQueue.empty());
+    if (stopWhenEmpty) assert(taskQueue.Empty());
 }
 
 
@@ -32,7 +172,7 @@ void CScheduler::serviceQueue()
     // is called.
     while (!shouldStop()) {
         try {
-            while (!shouldStop() && taskQueue.empty()) {
+            while (!shouldStop() && taskQueue.Empty()) {
                 // Wait until there is something to do.
                 newTaskScheduled.wait(lock);
             }
@@ -40,8 +180,8 @@ void CScheduler::serviceQueue()
             // Wait until either there is a new task, or until
             // the time of the first item on the queue:
 
-            while (!shouldStop() && !taskQueue.empty()) {
-                std::chrono::steady_clock::time_point timeToWaitFor = taskQueue.begin()->first;
+            while (!shouldStop() && !taskQueue.Empty()) {
+                std::chrono::steady_clock::time_point timeToWaitFor = taskQueue.NextTime();
                 if (newTaskScheduled.wait_until(lock, timeToWaitFor) == std::cv_status::timeout) {
                     break; // Exit loop after timeout, it means we reached the time of the event
                 }
@@ -49,17 +189,32 @@ void CScheduler::serviceQueue()
 
             // If there are multiple threads, the queue can empty while we're waiting (another
             // thread may service the task we were waiting on).
-            if (shouldStop() || taskQueue.empty())
+            if (shouldStop() || taskQueue.Empty())
                 continue;
 
-            Function f = taskQueue.begin()->second;
-            taskQueue.erase(taskQueue.begin());
+            taskQueue.Advance(std::chrono::steady_clock::now());
+            if (!taskQueue.HasReady()) continue;
+            TimerWheel::Task task{taskQueue.PopReady()};
+            // Let another thread pick up the next ready task while this one runs
+            if (taskQueue.HasReady()) newTaskScheduled.notify_one();
 
+            std::chrono::steady_clock::time_point start, end;
             {
                 // Unlock before calling f, so it can reschedule itself or another task
                 // without deadlocking:
                 REVERSE_LOCK(lock);
-                f();
+                start = std::chrono::steady_clock::now();
+                task.f();
+                end = std::chrono::steady_clock::now();
+            }
+            if (!task.name.empty()) {
+                TaskStats& stats{m_task_stats[task.name]};
+                ++stats.runs;
+                stats.total_time += end - start;
+                stats.max_time = std::max<std::chrono::nanoseconds>(stats.max_time, end - start);
+                const std::chrono::nanoseconds delay{std::max(start - task.time, std::chrono::steady_clock::duration::zero())};
+                stats.total_delay += delay;
+                stats.max_delay = std::max(stats.max_delay, delay);
             }
         } catch (...) {
             --nThreadsServicingQueue;
@@ -70,11 +225,11 @@ void CScheduler::serviceQueue()
     newTaskScheduled.notify_one();
 }
 
-void CScheduler::schedule(CScheduler::Function f, std::chrono::steady_clock::time_point t)
+void CScheduler::schedule(CScheduler::Function f, std::chrono::steady_clock::time_point t, std::string name)
 {
     {
         LOCK(newTaskMutex);
-        taskQueue.insert(std::make_pair(t, f));
+        taskQueue.Insert({t, std::move(f), std::move(name)});
     }
     newTaskScheduled.notify_one();
 }
@@ -83,43 +238,31 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds)
 {
     assert(delta_seconds > 0s && delta_seconds <= 1h);
 
-    {
-        LOCK(newTaskMutex);
-
-        // use temp_queue to maintain updated schedule
-        std::multimap<std::chrono::steady_clock::time_point, Function> temp_queue;
-
-        for (const auto& element : taskQueue) {
-            temp_queue.emplace_hint(temp_queue.cend(), element.first - delta_seconds, element.second);
-        }
-
-        // point taskQueue to temp_queue
-        taskQueue = std::move(temp_queue);
-    }
+    WITH_LOCK(newTaskMutex, taskQueue.Shift(delta_seconds));
 
     // notify that the taskQueue needs to be processed
     newTaskScheduled.notify_one();
 }
 
-static void Repeat(CScheduler& s, CScheduler::Function f, std::chrono::milliseconds delta)
+static void Repeat(CScheduler& s, CScheduler::Function f, std::chrono::milliseconds delta, const std::string& name)
 {
     f();
-    s.scheduleFromNow([=, &s] { Repeat(s, f, delta); }, delta);
+    s.scheduleFromNow([=, &s] { Repeat(s, f, delta, name); }, delta, name);
 }
 
-void CScheduler::scheduleEvery(CScheduler::Function f, std::chrono::milliseconds delta)
+void CScheduler::scheduleEvery(CScheduler::Function f, std::chrono::milliseconds delta, std::string name)
 {
-    scheduleFromNow([this, f, delta] { Repeat(*this, f, delta); }, delta);
+    scheduleFromNow([this, f, delta, name] { Repeat(*this, f, delta, name); }, delta, name);
 }
 
 size_t CScheduler::getQueueInfo(std::chrono::steady_clock::time_point& first,
                                 std::chrono::steady_clock::time_point& last) const
 {
     LOCK(newTaskMutex);
-    size_t result = taskQueue.size();
-    if (!taskQueue.empty()) {
-        first = taskQueue.begin()->first;
-        last = taskQueue.rbegin()->first;
+    size_t result = taskQueue.Size();
+    if (!taskQueue.Empty()) {
+        first = taskQueue.NextTime();
+        last = taskQueue.LastTime();
     }
     return result;
 }
@@ -130,6 +273,12 @@ bool CScheduler::AreThreadsServicingQueue() const
     return nThreadsServicingQueue;
 }
 
+std::map<std::string, CScheduler::TaskStats> CScheduler::GetTaskStats() const
+{
+    LOCK(newTaskMutex);
+    return m_task_stats;
+}
+
 
 void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue()
 {
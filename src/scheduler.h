@@ -12,28 +12,92 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <map>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+/**
+ * Hierarchical timer wheel holding the tasks of a CScheduler. Not thread safe.
+ *
+ * Tasks are hashed into LEVELS wheels of SLOTS slots by the millisecond tick
+ * they are due at: level 0 slots span one tick, level 1 slots span SLOTS ticks
+ * and so on. Inserting a task is constant time no matter how many tasks are
+ * queued, and advancing the wheel only touches the slots that came due,
+ * cascading their tasks that are not due yet down to finer levels. Tasks that
+ * are further out than the top level spans are kept in an ordered overflow
+ * map. Due tasks are handed out earliest first, tasks due at the same time in
+ * the order they were inserted.
+ */
+class TimerWheel
+{
+public:
+    using Function = std::function<void()>;
+
+    struct Task {
+        std::chrono::steady_clock::time_point time;
+        Function f;
+        //! Name the runtime statistics of the task are recorded under, if not empty
+        std::string name;
+        uint64_t sequence{0};
+    };
+
+    explicit TimerWheel(std::chrono::steady_clock::time_point now);
+
+    void Insert(Task task);
+    /** Move every task due at or before now to the ready queue */
+    void Advance(std::chrono::steady_clock::time_point now);
+    bool HasReady() const { return !m_ready.empty(); }
+    /** Take the earliest ready task. Must only be called if HasReady() */
+    Task PopReady();
+    /** Earliest and latest time of any task, ready ones included. Must only be called if not Empty() */
+    std::chrono::steady_clock::time_point NextTime() const;
+    std::chrono::steady_clock::time_point LastTime() const;
+    /** Move every task, ready ones included, the given duration earlier */
+    void Shift(std::chrono::steady_clock::duration delta);
+
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+
+private:
+    static constexpr int SLOT_BITS{6};
+    static constexpr size_t SLOTS{size_t{1} << SLOT_BITS};
+    static constexpr int LEVELS{4};
+
+    //! Tick of the last Advance(). Slots before it on every level are empty.
+    int64_t m_tick;
+    uint64_t m_next_sequence{0};
+    size_t m_size{0};
+    std::vector<Task> m_wheels[LEVELS][SLOTS];
+    std::multimap<std::chrono::steady_clock::time_point, Task> m_overflow;
+    std::deque<Task> m_ready;
+
+    void Place(Task task);
+};
 
 /**
  * Simple class for background tasks that should be run
  * periodically or once "after a while"
  *
+ * Tasks are serviced by every thread running serviceQueue, so a long task only
+ * delays the others if all threads are busy. Tasks scheduled under a name have
+ * their runtime and start delay recorded, see GetTaskStats().
+ *
  * Usage:
  *
  * CScheduler* s = new CScheduler();
  * s->scheduleFromNow(doSomething, std::chrono::milliseconds{11}); // Assuming a: void doSomething() { }
  * s->scheduleFromNow([=] { this->func(argument); }, std::chrono::milliseconds{3});
- * std::thread* t = new std::thread([&] { s->serviceQueue(); });
+ * s->m_service_threads.emplace_back([&] { s->serviceQueue(); });
  *
  * ... then at program shutdown, make sure to call stop() to clean up the thread(s) running serviceQueue:
  * s->stop();
- * t->join();
- * delete t;
- * delete s; // Must be done after thread is interrupted/joined.
+ * delete s; // Must be done after threads are interrupted/joined.
  */
 class CScheduler
 {
@@ -41,17 +105,31 @@ public:
     CScheduler();
     ~CScheduler();
 
-    std::thread m_service_thread;
+    //! Threads running serviceQueue, joined by stop() and StopWhenDrained()
+    std::vector<std::thread> m_service_threads;
 
     typedef std::function<void()> Function;
 
-    /** Call func at/after time t */
-    void schedule(Function f, std::chrono::steady_clock::time_point t) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+    /** Runtime statistics of the runs of the tasks scheduled under one name */
+    struct TaskStats {
+        uint64_t runs{0};
+        std::chrono::nanoseconds total_time{0};
+        std::chrono::nanoseconds max_time{0};
+        //! How long after their scheduled time the runs started
+        std::chrono::nanoseconds total_delay{0};
+        std::chrono::nanoseconds max_delay{0};
+    };
+
+    /**
+     * Call func at/after time t. If a name is given, the runtime of f is
+     * recorded in the statistics returned by GetTaskStats().
+     */
+    void schedule(Function f, std::chrono::steady_clock::time_point t, std::string name = {}) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
     /** Call f once after the delta has passed */
-    void scheduleFromNow(Function f, std::chrono::milliseconds delta) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex)
+    void scheduleFromNow(Function f, std::chrono::milliseconds delta, std::string name = {}) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex)
     {
-        schedule(std::move(f), std::chrono::steady_clock::now() + delta);
+        schedule(std::move(f), std::chrono::steady_clock::now() + delta, std::move(name));
     }
 
     /**
@@ -60,7 +138,7 @@ public:
      * The timing is not exact: Every time f is finished, it is rescheduled to run again after delta. If you need more
      * accurate scheduling, don't use this method.
      */
-    void scheduleEvery(Function f, std::chrono::milliseconds delta) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+    void scheduleEvery(Function f, std::chrono::milliseconds delta, std::string name = {}) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
     /**
      * Mock the scheduler to fast forward in time.
@@ -79,14 +157,14 @@ public:
     {
         WITH_LOCK(newTaskMutex, stopRequested = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
     /** Tell any threads running serviceQueue to stop when there is no work left to be done */
     void StopWhenDrained() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex)
     {
         WITH_LOCK(newTaskMutex, stopWhenEmpty = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
 
     /**
@@ -100,14 +178,25 @@ public:
     /** Returns true if there are threads actively running in serviceQueue() */
     bool AreThreadsServicingQueue() const EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
+    /** Returns the runtime statistics of the named tasks that ran so far, by name */
+    std::map<std::string, TaskStats> GetTaskStats() const EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+
 private:
     mutable Mutex newTaskMutex;
     std::condition_variable newTaskScheduled;
-    std::multimap<std::chrono::steady_clock::time_point, Function> taskQueue GUARDED_BY(newTaskMutex);
+    TimerWheel taskQueue GUARDED_BY(newTaskMutex);
+    std::map<std::string, TaskStats> m_task_stats GUARDED_BY(newTaskMutex);
     int nThreadsServicingQueue GUARDED_BY(newTaskMutex){0};
     bool stopRequested GUARDED_BY(newTaskMutex){false};
     bool stopWhenEmpty GUARDED_BY(newTaskMutex){false};
-    bool shouldStop() const EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex) { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
+    bool shouldStop() const EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex) { return stopRequested || (stopWhenEmpty && taskQueue.Empty()); }
+
+    void JoinServiceThreads()
+    {
+        for (std::thread& thread : m_service_threads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
 };
 
 /**
@@ -11,12 +11,18 @@
 #include <script/standard.h>
 
 #include <span.h>
+#include <sync.h>
 #include <util/bip32.h>
 #include <util/spanparsing.h>
 #include <util/system.h>
 #include <util/strencodings.h>
+#include <util/threadpool.h>
 #include <util/vector.h>
 
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
@@ -303,6 +309,71 @@ enum class DeriveType {
     HARDENED,
 };
 
+//! Number of derived extended public keys kept by the process-wide derivation cache
+constexpr size_t DERIVED_XPUB_CACHE_SIZE{16384};
+
+/**
+ * Process-wide cache of extended public keys derived from a parent xpub along an unhardened
+ * path, keyed by the parent and the path and evicting the least recently used entry. It is
+ * shared by all descriptors, so expanding the same xpub again, whether by another descriptor,
+ * RPC or wallet, does not redo the derivations. Hardened derivations are never cached, as
+ * they need the private key, which the caller may not have.
+ */
+class DerivedExtPubKeyCache
+{
+    using Entry = std::pair<std::vector<unsigned char>, CExtPubKey>;
+
+    Mutex m_mutex;
+    //! Entries, the most recently used first
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::map<std::vector<unsigned char>, std::list<Entry>::iterator> m_index GUARDED_BY(m_mutex);
+
+public:
+    /** Derive the xpub at path from parent. Returns false if a derivation step fails. */
+    bool Derive(const CExtPubKey& parent, Span<const uint32_t> path, CExtPubKey& out) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (path.empty()) {
+            out = parent;
+            return true;
+        }
+        std::vector<unsigned char> key(BIP32_EXTKEY_SIZE);
+        parent.Encode(key.data());
+        for (uint32_t step : path) {
+            key.push_back(step >> 24);
+            key.push_back(step >> 16);
+            key.push_back(step >> 8);
+            key.push_back(step);
+        }
+        {
+            LOCK(m_mutex);
+            auto it = m_index.find(key);
+            if (it != m_index.end()) {
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                out = it->second->second;
+                return true;
+            }
+        }
+
+        CExtPubKey derived = parent;
+        for (uint32_t step : path) {
+            if (!derived.Derive(derived, step)) return false;
+        }
+        out = derived;
+
+        LOCK(m_mutex);
+        if (m_index.count(key)) return true;
+        m_entries.emplace_front(key, derived);
+        m_index.emplace(std::move(key), m_entries.begin());
+        if (m_entries.size() > DERIVED_XPUB_CACHE_SIZE) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+        return true;
+    }
+};
+
+DerivedExtPubKeyCache g_derived_xpub_cache;
+
 /** An object representing a parsed extended public key in a descriptor. */
 class BIP32PubkeyProvider final : public PubkeyProvider
 {
@@ -387,11 +458,12 @@ public:
                 last_hardened_extkey = lh_xprv.Neuter();
             }
         } else {
-            for (auto entry : m_path) {
-                if (!parent_extkey.Derive(parent_extkey, entry)) return false;
-            }
+            if (!g_derived_xpub_cache.Derive(m_root_extkey, m_path, parent_extkey)) return false;
             final_extkey = parent_extkey;
-            if (m_derive == DeriveType::UNHARDENED) der = parent_extkey.Derive(final_extkey, pos);
+            if (m_derive == DeriveType::UNHARDENED) {
+                const uint32_t child{(uint32_t)pos};
+                der = g_derived_xpub_cache.Derive(parent_extkey, Span<const uint32_t>{&child, 1}, final_extkey);
+            }
             assert(m_derive != DeriveType::HARDENED);
         }
         if (!der) return false;
@@ -1749,6 +1821,25 @@ std::unique_ptr<Descriptor> InferDescriptor(const CScript& script, const Signing
     return InferScript(script, ParseScriptContext::TOP, provider);
 }
 
+bool ExpandRange(const Descriptor& desc, int begin, int end, const SigningProvider& provider, std::vector<std::vector<CScript>>& output_scripts, FlatSigningProvider& out)
+{
+    const size_t count{end < begin ? 0 : static_cast<size_t>(end - begin) + 1};
+    output_scripts.assign(count, {});
+    std::vector<FlatSigningProvider> outs(count);
+    std::atomic<bool> failed{false};
+    const size_t num_threads{count < MIN_PARALLEL_EXPAND_RANGE ? 1 : MAX_EXPAND_RANGE_THREADS};
+    util::ParallelFor("expandrange", util::TaskPriority::NORMAL, count, num_threads, [&](size_t i) {
+        if (failed) return;
+        if (!desc.Expand(begin + static_cast<int>(i), provider, output_scripts[i], outs[i])) failed = true;
+    });
+    if (failed) return false;
+
+    for (FlatSigningProvider& pos_out : outs) {
+        out.Merge(std::move(pos_out));
+    }
+    return true;
+}
+
 void DescriptorCache::CacheParentExtPubKey(uint32_t key_exp_pos, const CExtPubKey& xpub)
 {
     m_parent_xpubs[key_exp_pos] = xpub;
@@ -182,4 +182,18 @@ std::string GetDescriptorChecksum(const std::string& descriptor);
  */
 std::unique_ptr<Descriptor> InferDescriptor(const CScript& script, const SigningProvider& provider);
 
+/** Ranges with fewer positions than this are expanded by ExpandRange() on the calling thread only */
+static constexpr size_t MIN_PARALLEL_EXPAND_RANGE{64};
+/** Maximum number of threads expanding a range in ExpandRange() */
+static constexpr size_t MAX_EXPAND_RANGE_THREADS{8};
+
+/** Expand a descriptor at the positions begin .. end, on tasks of the shared thread pool for
+ * large ranges.
+ *
+ * output_scripts gets the scripts of each position in order, and the information needed to
+ * solve them is added to out. Returns false if any position can not be expanded with the
+ * information in provider, in which case nothing is added to out.
+ */
+bool ExpandRange(const Descriptor& desc, int begin, int end, const SigningProvider& provider, std::vector<std::vector<CScript>>& output_scripts, FlatSigningProvider& out);
+
 #endif // BITCOIN_SCRIPT_DESCRIPTOR_H
@@ -1660,6 +1660,9 @@ bool GenericTransactionSignatureChecker<T>::VerifyECDSASignature(const std::vect
 template <class T>
 bool GenericTransactionSignatureChecker<T>::VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const
 {
+    // Signatures are verified one at a time. Their verification could be deferred and batched, as a
+    // non-empty signature that fails makes the whole script fail (BIP 340/342), but the libsecp256k1
+    // subtree provides no batch verification to do it with.
     return pubkey.VerifySchnorr(sighash, sig);
 }
 
@@ -1804,9 +1807,13 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(const CScriptNum& nSeq
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
 
-static bool ExecuteWitnessScript(const Span<const valtype>& stack_span, const CScript& exec_script, unsigned int flags, SigVersion sigversion, const BaseSignatureChecker& checker, ScriptExecutionData& execdata, ScriptError* serror)
+static bool ExecuteWitnessScript(const Span<const CScriptWitnessItem>& stack_span, const CScript& exec_script, unsigned int flags, SigVersion sigversion, const BaseSignatureChecker& checker, ScriptExecutionData& execdata, ScriptError* serror)
 {
-    std::vector<valtype> stack{stack_span.begin(), stack_span.end()};
+    std::vector<valtype> stack;
+    stack.reserve(stack_span.size());
+    for (const CScriptWitnessItem& item : stack_span) {
+        stack.emplace_back(item.begin(), item.end());
+    }
 
     if (sigversion == SigVersion::TAPSCRIPT) {
         // OP_SUCCESSx processing overrides everything, including stack element size limits
@@ -1870,12 +1877,12 @@ uint256 ComputeTaprootMerkleRoot(Span<const unsigned char> control, const uint25
     return k;
 }
 
-static bool VerifyTaprootCommitment(const std::vector<unsigned char>& control, const std::vector<unsigned char>& program, const uint256& tapleaf_hash)
+static bool VerifyTaprootCommitment(Span<const unsigned char> control, const std::vector<unsigned char>& program, const uint256& tapleaf_hash)
 {
     assert(control.size() >= TAPROOT_CONTROL_BASE_SIZE);
     assert(program.size() >= uint256::size());
     //! The internal pubkey (x-only, so no Y coordinate parity).
-    const XOnlyPubKey p{Span{control}.subspan(1, TAPROOT_CONTROL_BASE_SIZE - 1)};
+    const XOnlyPubKey p{control.subspan(1, TAPROOT_CONTROL_BASE_SIZE - 1)};
     //! The output pubkey (taken from the scriptPubKey).
     const XOnlyPubKey q{program};
     // Compute the Merkle root from the leaf and the provided path.
@@ -1896,8 +1903,8 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
             if (stack.size() == 0) {
                 return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_WITNESS_EMPTY);
             }
-            const valtype& script_bytes = SpanPopBack(stack);
-            exec_script = CScript(script_bytes.begin(), script_bytes.end());
+            const CScriptWitnessItem& script_bytes = SpanPopBack(stack);
+            exec_script = CScript(script_bytes.data(), script_bytes.data() + script_bytes.size());
             uint256 hash_exec_script;
             CSHA256().Write(exec_script.data(), exec_script.size()).Finalize(hash_exec_script.begin());
             if (memcmp(hash_exec_script.begin(), program.data(), 32)) {
@@ -1910,7 +1917,22 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
                 return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH); // 2 items in witness
             }
             exec_script << OP_DUP << OP_HASH160 << program << OP_EQUALVERIFY << OP_CHECKSIG;
-            return ExecuteWitnessScript(stack, exec_script, flags, SigVersion::WITNESS_V0, checker, execdata, serror);
+            // Verify the implied script directly, exactly as ExecuteWitnessScript would
+            for (const CScriptWitnessItem& elem : stack) {
+                if (elem.size() > MAX_SCRIPT_ELEMENT_SIZE) return set_error(serror, SCRIPT_ERR_PUSH_SIZE);
+            }
+            const uint160 pubkey_hash{Hash160(stack[1])};
+            if (memcmp(pubkey_hash.begin(), program.data(), WITNESS_V0_KEYHASH_SIZE)) {
+                return set_error(serror, SCRIPT_ERR_EQUALVERIFY);
+            }
+            const valtype sig{stack[0].begin(), stack[0].end()};
+            const valtype pubkey{stack[1].begin(), stack[1].end()};
+            bool success = true;
+            if (!EvalChecksigPreTapscript(sig, pubkey, exec_script.begin(), exec_script.end(), flags, checker, SigVersion::WITNESS_V0, serror, success)) {
+                return false; // serror is set
+            }
+            if (!success) return set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+            return set_success(serror);
         } else {
             return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_WRONG_LENGTH);
         }
@@ -1920,7 +1942,7 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
         if (stack.size() == 0) return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_WITNESS_EMPTY);
         if (stack.size() >= 2 && !stack.back().empty() && stack.back()[0] == ANNEX_TAG) {
             // Drop annex (this is non-standard; see IsWitnessStandard)
-            const valtype& annex = SpanPopBack(stack);
+            const CScriptWitnessItem& annex = SpanPopBack(stack);
             execdata.m_annex_hash = (HashWriter{} << annex).GetSHA256();
             execdata.m_annex_present = true;
         } else {
@@ -1935,9 +1957,9 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
             return set_success(serror);
         } else {
             // Script path spending (stack size is >1 after removing optional annex)
-            const valtype& control = SpanPopBack(stack);
-            const valtype& script_bytes = SpanPopBack(stack);
-            exec_script = CScript(script_bytes.begin(), script_bytes.end());
+            const CScriptWitnessItem& control = SpanPopBack(stack);
+            const CScriptWitnessItem& script_bytes = SpanPopBack(stack);
+            exec_script = CScript(script_bytes.data(), script_bytes.data() + script_bytes.size());
             if (control.size() < TAPROOT_CONTROL_BASE_SIZE || control.size() > TAPROOT_CONTROL_MAX_SIZE || ((control.size() - TAPROOT_CONTROL_BASE_SIZE) % TAPROOT_CONTROL_NODE_SIZE) != 0) {
                 return set_error(serror, SCRIPT_ERR_TAPROOT_WRONG_CONTROL_SIZE);
             }
@@ -1967,6 +1989,52 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
     // There is intentionally no return statement here, to be able to use "control reaches end of non-void function" warnings to detect gaps in the logic above.
 }
 
+/** Whether script is OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG. */
+static bool IsPayToPubKeyHash(const CScript& script)
+{
+    return script.size() == 25 && script[0] == OP_DUP && script[1] == OP_HASH160 && script[2] == 20 &&
+           script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG;
+}
+
+/**
+ * Evaluate a scriptPubKey (or P2SH redeemScript) on the stack its scriptSig
+ * left. The P2PKH, P2SH and witness program templates are evaluated directly,
+ * with the same resulting stack and error as EvalScript, which runs any other
+ * script.
+ */
+static bool EvalScriptPubKey(std::vector<valtype>& stack, const CScript& script, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    static const valtype vchFalse(0);
+    static const valtype vchTrue(1, 1);
+
+    if (stack.size() == 2 && IsPayToPubKeyHash(script)) {
+        const uint160 pubkey_hash{Hash160(stack[1])};
+        if (memcmp(pubkey_hash.begin(), script.data() + 3, 20)) {
+            return set_error(serror, SCRIPT_ERR_EQUALVERIFY);
+        }
+        bool success = true;
+        if (!EvalChecksigPreTapscript(stack[0], stack[1], script.begin(), script.end(), flags, checker, SigVersion::BASE, serror, success)) {
+            return false; // serror is set
+        }
+        stack.assign(1, success ? vchTrue : vchFalse);
+        return set_success(serror);
+    }
+    // EvalScript would briefly hold one more element than this
+    if (!stack.empty() && stack.size() < MAX_STACK_SIZE && script.IsPayToScriptHash()) {
+        const uint160 script_hash{Hash160(stack.back())};
+        stack.back() = memcmp(script_hash.begin(), script.data() + 2, 20) ? vchFalse : vchTrue;
+        return set_success(serror);
+    }
+    int witness_version;
+    valtype witness_program;
+    if (stack.empty() && script.IsWitnessProgram(witness_version, witness_program)) {
+        stack.push_back(CScriptNum(witness_version).getvch());
+        stack.push_back(std::move(witness_program));
+        return set_success(serror);
+    }
+    return EvalScript(stack, script, flags, checker, SigVersion::BASE, serror);
+}
+
 bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness* witness, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
 {
     static const CScriptWitness emptyWitness;
@@ -1989,7 +2057,7 @@ bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const C
         return false;
     if (flags & SCRIPT_VERIFY_P2SH)
         stackCopy = stack;
-    if (!EvalScript(stack, scriptPubKey, flags, checker, SigVersion::BASE, serror))
+    if (!EvalScriptPubKey(stack, scriptPubKey, flags, checker, serror))
         // serror is set
         return false;
     if (stack.empty())
@@ -2035,7 +2103,7 @@ bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const C
         CScript pubKey2(pubKeySerialized.begin(), pubKeySerialized.end());
         popstack(stack);
 
-        if (!EvalScript(stack, pubKey2, flags, checker, SigVersion::BASE, serror))
+        if (!EvalScriptPubKey(stack, pubKey2, flags, checker, serror))
             // serror is set
             return false;
         if (stack.empty())
@@ -2095,7 +2163,8 @@ size_t static WitnessSigOps(int witversion, const std::vector<unsigned char>& wi
             return 1;
 
         if (witprogram.size() == WITNESS_V0_SCRIPTHASH_SIZE && witness.stack.size() > 0) {
-            CScript subscript(witness.stack.back().begin(), witness.stack.back().end());
+            const CScriptWitnessItem& script_bytes = witness.stack.back();
+            CScript subscript(script_bytes.data(), script_bytes.data() + script_bytes.size());
             return subscript.GetSigOpCount(true);
         }
     }
@@ -13,6 +13,7 @@
 
 #include <assert.h>
 #include <climits>
+#include <initializer_list>
 #include <limits>
 #include <stdexcept>
 #include <stdint.h>
@@ -564,11 +565,33 @@ public:
     }
 };
 
+/**
+ * Witness stack items of up to this many bytes are stored inline. This covers
+ * ECDSA signatures with their hash type, Schnorr signatures, public keys and
+ * single-level Taproot control blocks, so a typical witness needs one
+ * allocation for its stack rather than one per item.
+ */
+static constexpr unsigned int WITNESS_ITEM_INLINE_SIZE{73};
+
+typedef prevector<WITNESS_ITEM_INLINE_SIZE, unsigned char> CScriptWitnessItemBase;
+
+/** A witness stack item, read as a span of bytes. */
+class CScriptWitnessItem : public CScriptWitnessItemBase
+{
+public:
+    using CScriptWitnessItemBase::CScriptWitnessItemBase;
+    CScriptWitnessItem() = default;
+    CScriptWitnessItem(const std::vector<unsigned char>& item) : CScriptWitnessItemBase(item.begin(), item.end()) {}
+    CScriptWitnessItem(std::initializer_list<unsigned char> item) : CScriptWitnessItemBase(item.begin(), item.end()) {}
+
+    SERIALIZE_METHODS(CScriptWitnessItem, obj) { READWRITEAS(CScriptWitnessItemBase, obj); }
+};
+
 struct CScriptWitness
 {
     // Note that this encodes the data elements being pushed, rather than
     // encoding them as a CScript that pushes them.
-    std::vector<std::vector<unsigned char> > stack;
+    std::vector<CScriptWitnessItem> stack;
 
     // Some compilers complain without a default constructor
     CScriptWitness() { }
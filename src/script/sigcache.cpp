@@ -13,9 +13,7 @@
 #include <cuckoocache.h>
 
 #include <algorithm>
-#include <mutex>
 #include <optional>
-#include <shared_mutex>
 #include <vector>
 
 namespace {
@@ -30,9 +28,9 @@ private:
      //! Entries are SHA256(nonce || 'E' or 'S' || 31 zero bytes || signature hash || public key || signature):
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    //! Sharded, so that parallel script checks rarely wait for each other
+    typedef CuckooCache::sharded_cache<uint256, SignatureCacheHasher> map_type;
     map_type setValid;
-    std::shared_mutex cs_sigcache;
 
 public:
     CSignatureCache()
@@ -67,19 +65,26 @@ public:
     bool
     Get(const uint256& entry, const bool erase)
     {
-        std::shared_lock<std::shared_mutex> lock(cs_sigcache);
         return setValid.contains(entry, erase);
     }
 
     void Set(const uint256& entry)
     {
-        std::unique_lock<std::shared_mutex> lock(cs_sigcache);
         setValid.insert(entry);
     }
     std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t n)
     {
         return setValid.setup_bytes(n);
     }
+    CuckooCache::stats GetStats() const
+    {
+        return setValid.get_stats();
+    }
+
+    size_t DynamicMemoryUsage()
+    {
+        return setValid.DynamicMemoryUsage();
+    }
 };
 
 /* In previous versions of this code, signatureCache was a local static variable
@@ -104,6 +109,16 @@ bool InitSignatureCache(size_t max_size_bytes)
     return true;
 }
 
+CuckooCache::stats GetSignatureCacheStats()
+{
+    return signatureCache.GetStats();
+}
+
+size_t GetSignatureCacheMemoryUsage()
+{
+    return signatureCache.DynamicMemoryUsage();
+}
+
 bool CachingTransactionSignatureChecker::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
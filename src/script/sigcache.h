@@ -6,6 +6,7 @@
 #ifndef BITCOIN_SCRIPT_SIGCACHE_H
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
+#include <cuckoocache.h>
 #include <script/interpreter.h>
 #include <span.h>
 #include <util/hasher.h>
@@ -34,4 +35,9 @@ public:
 
 [[nodiscard]] bool InitSignatureCache(size_t max_size_bytes);
 
+/** Hits, misses and evictions of the signature cache */
+CuckooCache::stats GetSignatureCacheStats();
+/** Memory used by the signature cache */
+size_t GetSignatureCacheMemoryUsage();
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
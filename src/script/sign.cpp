@@ -12,12 +12,88 @@
 #include <script/keyorigin.h>
 #include <script/signingprovider.h>
 #include <script/standard.h>
+#include <sync.h>
 #include <uint256.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <util/vector.h>
 
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <thread>
+
 typedef std::vector<unsigned char> valtype;
 
+namespace {
+//! Transactions with fewer inputs than this are signed on the calling thread only
+constexpr size_t MIN_PARALLEL_SIGN_INPUTS{16};
+//! Maximum number of threads signing the inputs of a transaction
+constexpr unsigned int MAX_SIGN_THREADS{8};
+
+/**
+ * Forwards to another provider, remembering the private keys it returned, so
+ * that inputs spending from the same key don't look it up (and possibly
+ * decrypt it) again. Safe to use from several threads if the wrapped provider is.
+ */
+class KeyCachingSigningProvider final : public SigningProvider
+{
+private:
+    const SigningProvider& m_provider;
+    mutable Mutex m_mutex;
+    mutable std::map<CKeyID, CKey> m_keys GUARDED_BY(m_mutex);
+
+public:
+    explicit KeyCachingSigningProvider(const SigningProvider& provider) : m_provider{provider} {}
+
+    bool GetCScript(const CScriptID& scriptid, CScript& script) const override { return m_provider.GetCScript(scriptid, script); }
+    bool HaveCScript(const CScriptID& scriptid) const override { return m_provider.HaveCScript(scriptid); }
+    bool GetPubKey(const CKeyID& address, CPubKey& pubkey) const override { return m_provider.GetPubKey(address, pubkey); }
+    bool HaveKey(const CKeyID& address) const override { return m_provider.HaveKey(address); }
+    bool GetKeyOrigin(const CKeyID& keyid, KeyOriginInfo& info) const override { return m_provider.GetKeyOrigin(keyid, info); }
+    bool GetTaprootSpendData(const XOnlyPubKey& output_key, TaprootSpendData& spenddata) const override { return m_provider.GetTaprootSpendData(output_key, spenddata); }
+    bool GetTaprootBuilder(const XOnlyPubKey& output_key, TaprootBuilder& builder) const override { return m_provider.GetTaprootBuilder(output_key, builder); }
+
+    bool GetKey(const CKeyID& address, CKey& key) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            const auto it{m_keys.find(address)};
+            if (it != m_keys.end()) {
+                key = it->second;
+                return true;
+            }
+        }
+        if (!m_provider.GetKey(address, key)) return false;
+        LOCK(m_mutex);
+        m_keys.emplace(address, key);
+        return true;
+    }
+};
+
+/**
+ * Call func(i) for every i below count, on the workers of a thread pool shared
+ * by all signing if count is large. The pool is started on first use, as
+ * signing has no access to the node's.
+ */
+void ForEachInputIndex(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count < MIN_PARALLEL_SIGN_INPUTS) {
+        for (size_t i = 0; i < count; ++i) func(i);
+        return;
+    }
+    static const unsigned int num_threads{std::clamp(std::thread::hardware_concurrency(), 2U, MAX_SIGN_THREADS)};
+    static util::ThreadPool thread_pool{[] {
+        util::ThreadPool::Options options;
+        options.name = "sign";
+        options.threads = num_threads - 1;
+        return options;
+    }()};
+    static const util::TaskPool pool{thread_pool, "sign", util::TaskPriority::HIGH};
+    util::ParallelFor(&pool, count, num_threads, func);
+}
+} // namespace
+
 MutableTransactionSignatureCreator::MutableTransactionSignatureCreator(const CMutableTransaction& tx, unsigned int input_idx, const CAmountType& amountType, const CAmount& amount, int hash_type)
     : m_txto{tx}, nIn{input_idx}, nHashType{hash_type}, amountType{amountType}, amount{amount}, checker{&m_txto, nIn, amountType, amount, MissingDataBehavior::FAIL},
       m_txdata(nullptr)
@@ -409,7 +485,7 @@ bool ProduceSignature(const SigningProvider& provider, const BaseSignatureCreato
         witnessscript << OP_DUP << OP_HASH160 << ToByteVector(result[0]) << OP_EQUALVERIFY << OP_CHECKSIG;
         TxoutType subType;
         solved = solved && SignStep(provider, creator, witnessscript, result, subType, SigVersion::WITNESS_V0, sigdata);
-        sigdata.scriptWitness.stack = result;
+        sigdata.scriptWitness.stack.assign(result.begin(), result.end());
         sigdata.witness = true;
         result.clear();
     }
@@ -420,13 +496,13 @@ bool ProduceSignature(const SigningProvider& provider, const BaseSignatureCreato
         TxoutType subType;
         solved = solved && SignStep(provider, creator, witnessscript, result, subType, SigVersion::WITNESS_V0, sigdata) && subType != TxoutType::SCRIPTHASH && subType != TxoutType::WITNESS_V0_SCRIPTHASH && subType != TxoutType::WITNESS_V0_KEYHASH;
         result.push_back(std::vector<unsigned char>(witnessscript.begin(), witnessscript.end()));
-        sigdata.scriptWitness.stack = result;
+        sigdata.scriptWitness.stack.assign(result.begin(), result.end());
         sigdata.witness = true;
         result.clear();
     } else if (whichType == TxoutType::WITNESS_V1_TAPROOT && !P2SH) {
         sigdata.witness = true;
         if (solved) {
-            sigdata.scriptWitness.stack = std::move(result);
+            sigdata.scriptWitness.stack.assign(result.begin(), result.end());
         }
         result.clear();
     } else if (solved && whichType == TxoutType::WITNESS_UNKNOWN) {
@@ -471,7 +547,10 @@ struct Stacks
 
     Stacks() = delete;
     Stacks(const Stacks&) = delete;
-    explicit Stacks(const SignatureData& data) : witness(data.scriptWitness.stack) {
+    explicit Stacks(const SignatureData& data) {
+        for (const CScriptWitnessItem& item : data.scriptWitness.stack) {
+            witness.emplace_back(item.begin(), item.end());
+        }
         EvalScript(script, data.scriptSig, SCRIPT_VERIFY_STRICTENC, BaseSignatureChecker(), SigVersion::BASE);
     }
 };
@@ -678,25 +757,43 @@ bool SignTransaction(CMutableTransaction& mtx, const SigningProvider* keystore,
         txdata.Init(txConst, std::move(spent_outputs), true);
     }
 
-    // Sign what we can:
+    // Sign what we can. The inputs are signed independently of each other, on
+    // several threads for large transactions, and only then updated.
+    const KeyCachingSigningProvider provider{*keystore};
+    std::vector<std::optional<SignatureData>> sigdatas(mtx.vin.size());
+    ForEachInputIndex(mtx.vin.size(), [&](size_t i) {
+        auto coin = coins.find(mtx.vin[i].prevout);
+        if (coin == coins.end() || coin->second.IsSpent()) return;
+        SignatureData& sigdata = sigdatas[i].emplace(DataFromTransaction(mtx, i, coin->second.out));
+        // Only sign SIGHASH_SINGLE if there's a corresponding output:
+        if (!fHashSingle || (i < mtx.vout.size())) {
+            ProduceSignature(provider, MutableTransactionSignatureCreator(mtx, i, coin->second.out.amountType, coin->second.out.nValue, &txdata, nHashType), coin->second.out.scriptPubKey, sigdata);
+        }
+    });
+    for (unsigned int i = 0; i < mtx.vin.size(); ++i) {
+        if (sigdatas[i]) UpdateInput(mtx.vin[i], *sigdatas[i]);
+    }
+
+    // Verify the signed inputs
+    std::vector<std::optional<ScriptError>> script_errors(mtx.vin.size());
+    ForEachInputIndex(mtx.vin.size(), [&](size_t i) {
+        if (!sigdatas[i]) return;
+        const CTxOut& prevout = coins.at(mtx.vin[i].prevout).out;
+        ScriptError serror = SCRIPT_ERR_OK;
+        if (!VerifyScript(mtx.vin[i].scriptSig, prevout.scriptPubKey, &mtx.vin[i].scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&txConst, i, prevout.amountType, prevout.nValue, txdata, MissingDataBehavior::FAIL), &serror)) {
+            script_errors[i] = serror;
+        }
+    });
+
     for (unsigned int i = 0; i < mtx.vin.size(); ++i) {
         CTxIn& txin = mtx.vin[i];
-        auto coin = coins.find(txin.prevout);
-        if (coin == coins.end() || coin->second.IsSpent()) {
+        if (!sigdatas[i]) {
             input_errors[i] = _("Input not found or already spent");
             continue;
         }
-        const CScript& prevPubKey = coin->second.out.scriptPubKey;
-        const CAmount& amount = coin->second.out.nValue;
-        const CAmountType& amountType = coin->second.out.amountType;
-
-        SignatureData sigdata = DataFromTransaction(mtx, i, coin->second.out);
-        // Only sign SIGHASH_SINGLE if there's a corresponding output:
-        if (!fHashSingle || (i < mtx.vout.size())) {
-            ProduceSignature(*keystore, MutableTransactionSignatureCreator(mtx, i, amountType, amount, &txdata, nHashType), prevPubKey, sigdata);
-        }
-
-        UpdateInput(txin, sigdata);
+        const CTxOut& prevout = coins.at(txin.prevout).out;
+        const CAmount& amount = prevout.nValue;
+        const CAmountType& amountType = prevout.amountType;
 
         // amount must be specified for valid segwit signature
         if (amount == MAX_MONEY && !txin.scriptWitness.IsNull()) {
@@ -710,8 +807,8 @@ bool SignTransaction(CMutableTransaction& mtx, const SigningProvider* keystore,
             continue;
         }
 
-        ScriptError serror = SCRIPT_ERR_OK;
-        if (!VerifyScript(txin.scriptSig, prevPubKey, &txin.scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&txConst, i, amountType, amount, txdata, MissingDataBehavior::FAIL), &serror)) {
+        if (script_errors[i]) {
+            const ScriptError serror{*script_errors[i]};
             if (serror == SCRIPT_ERR_INVALID_STACK_OPERATION) {
                 // Unable to sign input and verification failed (possible attempt to partially sign).
                 input_errors[i] = Untranslated("Unable to sign input, invalid stack size (possibly missing key)");
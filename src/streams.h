@@ -23,6 +23,57 @@
 #include <utility>
 #include <vector>
 
+namespace util {
+/**
+ * XOR data with a key that repeats over it, starting at key_offset into the key.
+ *
+ * Keys whose size divides 8, like the 8 byte database obfuscation key, are
+ * applied 64 bits at a time, in blocks of four words that compilers turn into
+ * vector instructions, instead of one byte at a time.
+ */
+inline void Xor(Span<std::byte> write, Span<const std::byte> key, size_t key_offset = 0)
+{
+    if (key.size() == 0) {
+        return;
+    }
+    key_offset %= key.size();
+
+    size_t i{0};
+    if (8 % key.size() == 0) {
+        std::byte pattern[8];
+        for (size_t j = 0; j < sizeof(pattern); ++j) {
+            pattern[j] = key[(key_offset + j) % key.size()];
+        }
+        uint64_t key_word;
+        memcpy(&key_word, pattern, sizeof(key_word));
+        for (; i + 32 <= write.size(); i += 32) {
+            uint64_t words[4];
+            memcpy(words, write.data() + i, sizeof(words));
+            for (uint64_t& word : words) word ^= key_word;
+            memcpy(write.data() + i, words, sizeof(words));
+        }
+        for (; i + 8 <= write.size(); i += 8) {
+            uint64_t word;
+            memcpy(&word, write.data() + i, sizeof(word));
+            word ^= key_word;
+            memcpy(write.data() + i, &word, sizeof(word));
+        }
+        // i is a multiple of 8, and so of the key size, so the key continues at key_offset
+    }
+
+    for (size_t j = key_offset; i != write.size(); i++) {
+        write[i] ^= key[j++];
+
+        // This potentially acts on very many bytes of data, so it's
+        // important that we calculate `j`, i.e. the `key` index in this
+        // way instead of doing a %, which would effectively be a division
+        // for each byte Xor'd -- much slower than need be.
+        if (j == key.size())
+            j = 0;
+    }
+}
+} // namespace util
+
 template<typename Stream>
 class OverrideStream
 {
@@ -175,6 +226,25 @@ public:
         memcpy(dst.data(), m_data.data(), dst.size());
         m_data = m_data.subspan(dst.size());
     }
+
+    void ignore(size_t num_ignore)
+    {
+        if (num_ignore > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(num_ignore);
+    }
+
+    /** Skip the next num bytes and return them, without copying */
+    Span<const unsigned char> ReadSpan(size_t num)
+    {
+        if (num > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ReadSpan(): end of data");
+        }
+        const Span<const unsigned char> ret{m_data.first(num)};
+        m_data = m_data.subspan(num);
+        return ret;
+    }
 };
 
 /** Double ended buffer combining vector and stream-like interfaces.
@@ -347,20 +417,7 @@ public:
      */
     void Xor(const std::vector<unsigned char>& key)
     {
-        if (key.size() == 0) {
-            return;
-        }
-
-        for (size_type i = 0, j = 0; i != size(); i++) {
-            vch[i] ^= std::byte{key[j++]};
-
-            // This potentially acts on very many bytes of data, so it's
-            // important that we calculate `j`, i.e. the `key` index in this
-            // way instead of doing a %, which would effectively be a division
-            // for each byte Xor'd -- much slower than need be.
-            if (j == key.size())
-                j = 0;
-        }
+        util::Xor(MakeWritableByteSpan(*this), MakeByteSpan(key));
     }
 };
 
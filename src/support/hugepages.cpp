@@ -0,0 +1,68 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <support/hugepages.h>
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <climits>
+#endif
+
+#ifdef __linux__
+/** Interleave the pages of a range across the NUMA nodes the process may use, if there are several. */
+static void InterleaveNumaNodes(void* p, std::size_t bytes)
+{
+#if defined(SYS_get_mempolicy) && defined(SYS_mbind)
+    std::array<unsigned long, 16> nodemask{};
+    const unsigned long maxnode{nodemask.size() * sizeof(unsigned long) * CHAR_BIT};
+    if (syscall(SYS_get_mempolicy, nullptr, nodemask.data(), maxnode, nullptr, MPOL_F_MEMS_ALLOWED) != 0) return;
+    int num_nodes{0};
+    for (const unsigned long word : nodemask) num_nodes += __builtin_popcountl(word);
+    if (num_nodes < 2) return;
+    // Best effort: the default policy remains in place if this fails.
+    syscall(SYS_mbind, p, bytes, MPOL_INTERLEAVE, nodemask.data(), maxnode, 0);
+#endif
+}
+#endif
+
+void* AllocateHugePages(std::size_t bytes)
+{
+    assert(bytes % HUGE_PAGE_SIZE == 0);
+#ifdef __linux__
+    // Map an extra huge page, so that the range can be trimmed to start on a huge page boundary.
+    void* mapped = mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) throw std::bad_alloc();
+    const uintptr_t begin{reinterpret_cast<uintptr_t>(mapped)};
+    const uintptr_t aligned{(begin + HUGE_PAGE_SIZE - 1) & ~uintptr_t{HUGE_PAGE_SIZE - 1}};
+    if (aligned > begin) munmap(mapped, aligned - begin);
+    if (aligned - begin < HUGE_PAGE_SIZE) munmap(reinterpret_cast<void*>(aligned + bytes), HUGE_PAGE_SIZE - (aligned - begin));
+    void* p{reinterpret_cast<void*>(aligned)};
+#ifdef MADV_HUGEPAGE
+    // Best effort: transparent huge pages may be disabled.
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    InterleaveNumaNodes(p, bytes);
+    return p;
+#else
+    return ::operator new(bytes, std::align_val_t{HUGE_PAGE_SIZE});
+#endif
+}
+
+void FreeHugePages(void* p, std::size_t bytes) noexcept
+{
+#ifdef __linux__
+    munmap(p, bytes);
+#else
+    ::operator delete(p, std::align_val_t{HUGE_PAGE_SIZE});
+#endif
+}
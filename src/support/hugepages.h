@@ -0,0 +1,28 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_HUGEPAGES_H
+#define BITCOIN_SUPPORT_HUGEPAGES_H
+
+#include <cstddef>
+
+/** Size and alignment of the memory ranges that AllocateHugePages() returns huge pages for. */
+static constexpr std::size_t HUGE_PAGE_SIZE{2 << 20};
+
+/**
+ * Allocate memory for a large, long-lived data structure. On Linux the memory is
+ * aligned to HUGE_PAGE_SIZE and backed by transparent huge pages where they are
+ * enabled, which reduces TLB misses when it is accessed randomly. It is also
+ * interleaved across the NUMA nodes the process may use. Elsewhere the memory
+ * comes from operator new.
+ *
+ * @param[in] bytes  Size of the allocation, a multiple of HUGE_PAGE_SIZE.
+ * @throws std::bad_alloc if the memory can't be allocated.
+ */
+void* AllocateHugePages(std::size_t bytes);
+
+/** Free memory that AllocateHugePages() returned for the same number of bytes. */
+void FreeHugePages(void* p, std::size_t bytes) noexcept;
+
+#endif // BITCOIN_SUPPORT_HUGEPAGES_H
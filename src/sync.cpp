@@ -13,11 +13,15 @@
 #include <util/strencodings.h>
 #include <util/threadnames.h>
 
+#include <algorithm>
+#include <array>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <system_error>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -324,3 +328,200 @@ bool LockStackEmpty()
 bool g_debug_lockorder_abort = true;
 
 #endif /* DEBUG_LOCKORDER */
+
+std::atomic<uint32_t> g_lock_profile_interval{0};
+
+namespace {
+/** Upper bound on the number of profiled locks, e.g. cs_main, the mempool and one cs_wallet per loaded wallet. */
+constexpr size_t MAX_PROFILED_LOCKS{64};
+/** Size of the acquisition site table, twice the number of sites a node is expected to use. */
+constexpr size_t MAX_LOCK_PROFILE_SITES{2048};
+
+struct ProfiledLock {
+    std::atomic<const void*> cs{nullptr};
+    std::atomic<const char*> name{nullptr};
+};
+
+std::array<ProfiledLock, MAX_PROFILED_LOCKS> g_profiled_locks;
+//! Number of leading g_profiled_locks entries that were ever used
+std::atomic<size_t> g_profiled_locks_used{0};
+std::mutex g_profiled_locks_mutex;
+
+/** A held profiled lock, kept per thread to attribute the release to the acquisition site. */
+struct HeldProfiledLock {
+    const void* cs;
+    LockProfileSite* site;
+    //! Acquisition time if the hold is sampled
+    std::optional<std::chrono::steady_clock::time_point> acquired;
+};
+
+thread_local std::vector<HeldProfiledLock> g_held_profiled_locks;
+
+void UpdateMax(std::atomic<uint64_t>& max, uint64_t value)
+{
+    uint64_t current{max.load(std::memory_order_relaxed)};
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+} // namespace
+
+struct LockProfileSite {
+    enum State : int { EMPTY, INITIALIZING, READY };
+    std::atomic<int> state{EMPTY};
+    const void* cs{nullptr};
+    const char* lock_name{nullptr};
+    const char* file{nullptr};
+    int line{0};
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contentions{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+    std::atomic<uint64_t> hold_samples{0};
+    std::atomic<uint64_t> hold_ns{0};
+    std::atomic<uint64_t> max_hold_ns{0};
+};
+
+static std::array<LockProfileSite, MAX_LOCK_PROFILE_SITES> g_lock_profile_sites;
+
+void SetLockProfiling(uint32_t sample_interval)
+{
+    g_lock_profile_interval.store(sample_interval, std::memory_order_relaxed);
+}
+
+void RegisterProfiledLock(const void* cs, const char* name)
+{
+    std::lock_guard<std::mutex> lock(g_profiled_locks_mutex);
+    for (size_t i = 0; i < MAX_PROFILED_LOCKS; ++i) {
+        ProfiledLock& profiled{g_profiled_locks[i]};
+        if (profiled.cs.load(std::memory_order_relaxed) == nullptr) {
+            profiled.name.store(name, std::memory_order_relaxed);
+            profiled.cs.store(cs, std::memory_order_release);
+            if (g_profiled_locks_used.load(std::memory_order_relaxed) <= i) g_profiled_locks_used.store(i + 1, std::memory_order_release);
+            return;
+        }
+    }
+    LogPrintf("Not profiling lock %s: more than %u profiled locks\n", name, MAX_PROFILED_LOCKS);
+}
+
+void UnregisterProfiledLock(const void* cs)
+{
+    std::lock_guard<std::mutex> lock(g_profiled_locks_mutex);
+    for (ProfiledLock& profiled : g_profiled_locks) {
+        if (profiled.cs.load(std::memory_order_relaxed) == cs) {
+            profiled.cs.store(nullptr, std::memory_order_release);
+        }
+    }
+}
+
+LockProfileSite* GetLockProfileSite(const void* cs, const char* file, int line)
+{
+    const char* lock_name{nullptr};
+    const size_t used{g_profiled_locks_used.load(std::memory_order_acquire)};
+    for (size_t i = 0; i < used; ++i) {
+        const ProfiledLock& profiled{g_profiled_locks[i]};
+        if (profiled.cs.load(std::memory_order_acquire) == cs) {
+            lock_name = profiled.name.load(std::memory_order_relaxed);
+            break;
+        }
+    }
+    if (lock_name == nullptr) return nullptr;
+
+    // Open addressing on the (lock, file, line) triple. The file pointers of
+    // __FILE__ are stable, so they identify a site without comparing strings.
+    uint64_t hash{(uint64_t)(uintptr_t)cs * 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uintptr_t)file * 0xC2B2AE3D27D4EB4FULL ^ (uint64_t)line};
+    hash ^= hash >> 29;
+    for (size_t probe = 0; probe < MAX_LOCK_PROFILE_SITES; ++probe) {
+        LockProfileSite& site{g_lock_profile_sites[(hash + probe) % MAX_LOCK_PROFILE_SITES]};
+        int state{site.state.load(std::memory_order_acquire)};
+        if (state == LockProfileSite::EMPTY) {
+            if (site.state.compare_exchange_strong(state, LockProfileSite::INITIALIZING, std::memory_order_acquire)) {
+                site.cs = cs;
+                site.lock_name = lock_name;
+                site.file = file;
+                site.line = line;
+                site.state.store(LockProfileSite::READY, std::memory_order_release);
+                return &site;
+            }
+        }
+        while (state == LockProfileSite::INITIALIZING) {
+            std::this_thread::yield();
+            state = site.state.load(std::memory_order_acquire);
+        }
+        if (site.cs == cs && site.file == file && site.line == line) return &site;
+    }
+    // The table is full, leave this site out.
+    return nullptr;
+}
+
+void LockProfileAcquired(LockProfileSite* site, const void* cs, std::chrono::nanoseconds wait_time, bool contended)
+{
+    const uint64_t acquisition{site->acquisitions.fetch_add(1, std::memory_order_relaxed)};
+    if (contended) {
+        const uint64_t wait_ns = std::max<int64_t>(wait_time.count(), 0);
+        site->contentions.fetch_add(1, std::memory_order_relaxed);
+        site->wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+        UpdateMax(site->max_wait_ns, wait_ns);
+    }
+    const uint32_t interval{g_lock_profile_interval.load(std::memory_order_relaxed)};
+    HeldProfiledLock held{cs, site, std::nullopt};
+    if (interval != 0 && acquisition % interval == 0) held.acquired = std::chrono::steady_clock::now();
+    g_held_profiled_locks.push_back(held);
+}
+
+void LockProfileReleased(const void* cs)
+{
+    auto& held_locks{g_held_profiled_locks};
+    // Locks are mostly released in reverse order, so search from the most recent.
+    for (auto it = held_locks.rbegin(); it != held_locks.rend(); ++it) {
+        if (it->cs != cs) continue;
+        if (it->acquired) {
+            const uint64_t hold_ns = std::max<int64_t>((std::chrono::steady_clock::now() - *it->acquired).count(), 0);
+            it->site->hold_samples.fetch_add(1, std::memory_order_relaxed);
+            it->site->hold_ns.fetch_add(hold_ns, std::memory_order_relaxed);
+            UpdateMax(it->site->max_hold_ns, hold_ns);
+        }
+        held_locks.erase(std::next(it).base());
+        return;
+    }
+}
+
+std::vector<LockProfileStats> GetLockProfileStats()
+{
+    // Several locks of the same name (e.g. the cs_wallet of each wallet) and
+    // copies of a site in different translation units are merged.
+    std::map<std::tuple<std::string, std::string, int>, LockProfileStats> merged;
+    for (const LockProfileSite& site : g_lock_profile_sites) {
+        if (site.state.load(std::memory_order_acquire) != LockProfileSite::READY) continue;
+        LockProfileStats& stats{merged[{site.lock_name, site.file, site.line}]};
+        stats.lock_name = site.lock_name;
+        stats.file = site.file;
+        stats.line = site.line;
+        stats.acquisitions += site.acquisitions.load(std::memory_order_relaxed);
+        stats.contentions += site.contentions.load(std::memory_order_relaxed);
+        stats.wait_time += std::chrono::nanoseconds{site.wait_ns.load(std::memory_order_relaxed)};
+        stats.max_wait_time = std::max(stats.max_wait_time, std::chrono::nanoseconds{site.max_wait_ns.load(std::memory_order_relaxed)});
+        stats.hold_samples += site.hold_samples.load(std::memory_order_relaxed);
+        stats.hold_time += std::chrono::nanoseconds{site.hold_ns.load(std::memory_order_relaxed)};
+        stats.max_hold_time = std::max(stats.max_hold_time, std::chrono::nanoseconds{site.max_hold_ns.load(std::memory_order_relaxed)});
+    }
+    std::vector<LockProfileStats> result;
+    result.reserve(merged.size());
+    for (auto& [_, stats] : merged) {
+        if (stats.acquisitions > 0) result.push_back(std::move(stats));
+    }
+    std::sort(result.begin(), result.end(), [](const LockProfileStats& a, const LockProfileStats& b) { return a.wait_time > b.wait_time; });
+    return result;
+}
+
+void ResetLockProfileStats()
+{
+    for (LockProfileSite& site : g_lock_profile_sites) {
+        site.acquisitions.store(0, std::memory_order_relaxed);
+        site.contentions.store(0, std::memory_order_relaxed);
+        site.wait_ns.store(0, std::memory_order_relaxed);
+        site.max_wait_ns.store(0, std::memory_order_relaxed);
+        site.hold_samples.store(0, std::memory_order_relaxed);
+        site.hold_ns.store(0, std::memory_order_relaxed);
+        site.max_hold_ns.store(0, std::memory_order_relaxed);
+    }
+}
@@ -14,10 +14,14 @@
 #include <threadsafety.h>
 #include <util/macros.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 ////////////////////////////////////////////////
 //                                            //
@@ -84,6 +88,62 @@ inline void DeleteLock(void* cs) {}
 inline bool LockStackEmpty() { return true; }
 #endif
 
+/**
+ * Runtime lock contention profiling (-lockstats).
+ *
+ * Only locks registered with RegisterProfiledLock() are profiled. Each
+ * acquisition through LOCK(), WAIT_LOCK(), TRY_LOCK() or
+ * ENTER_CRITICAL_SECTION() is aggregated per acquisition site (file and
+ * line): the number of acquisitions, of contended acquisitions and their wait
+ * time, and the hold time of one in every sample_interval acquisitions. An
+ * uncontended acquisition that is not sampled costs a few relaxed atomic
+ * operations and no clock reads; with profiling disabled, one relaxed load.
+ */
+struct LockProfileSite;
+
+struct LockProfileStats {
+    std::string lock_name;
+    std::string file;
+    int line{0};
+    uint64_t acquisitions{0};
+    uint64_t contentions{0};
+    std::chrono::nanoseconds wait_time{0};
+    std::chrono::nanoseconds max_wait_time{0};
+    uint64_t hold_samples{0};
+    std::chrono::nanoseconds hold_time{0};
+    std::chrono::nanoseconds max_hold_time{0};
+};
+
+//! Sampling interval of hold times, 0 when lock profiling is disabled.
+extern std::atomic<uint32_t> g_lock_profile_interval;
+
+inline bool LockProfilingEnabled() { return g_lock_profile_interval.load(std::memory_order_relaxed) != 0; }
+/** Enable lock profiling, timing the hold of one in sample_interval acquisitions. 0 disables it. */
+void SetLockProfiling(uint32_t sample_interval);
+/** Profile a lock under the given name, which must outlive the lock (usually a string literal). */
+void RegisterProfiledLock(const void* cs, const char* name);
+void UnregisterProfiledLock(const void* cs);
+/** The site to record an acquisition of cs at, or nullptr if cs isn't profiled. */
+LockProfileSite* GetLockProfileSite(const void* cs, const char* file, int line);
+void LockProfileAcquired(LockProfileSite* site, const void* cs, std::chrono::nanoseconds wait_time, bool contended);
+void LockProfileReleased(const void* cs);
+/** Statistics per lock name and acquisition site, sorted by total wait time, longest first. */
+std::vector<LockProfileStats> GetLockProfileStats();
+void ResetLockProfileStats();
+
+/** Lock cs, recording the acquisition at site. */
+template <typename MutexType>
+void LockProfiled(MutexType& cs, LockProfileSite* site) EXCLUSIVE_LOCK_FUNCTION(cs) NO_THREAD_SAFETY_ANALYSIS
+{
+    if (cs.try_lock()) {
+        LockProfileAcquired(site, &cs, std::chrono::nanoseconds{0}, /*contended=*/false);
+        return;
+    }
+    const auto wait_start{std::chrono::steady_clock::now()};
+    cs.lock();
+    LockProfileAcquired(site, &cs, std::chrono::steady_clock::now() - wait_start, /*contended=*/true);
+}
+
 /**
  * Template mixin that adds -Wthread-safety locking annotations and lock order
  * checking to a subset of the mutex API.
@@ -155,6 +215,18 @@ private:
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex());
+        if (LockProfilingEnabled()) {
+            if (LockProfileSite* site = GetLockProfileSite(Base::mutex(), pszFile, nLine)) {
+                if (Base::try_lock()) {
+                    LockProfileAcquired(site, Base::mutex(), std::chrono::nanoseconds{0}, /*contended=*/false);
+                    return;
+                }
+                const auto wait_start{std::chrono::steady_clock::now()};
+                Base::lock();
+                LockProfileAcquired(site, Base::mutex(), std::chrono::steady_clock::now() - wait_start, /*contended=*/true);
+                return;
+            }
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (Base::try_lock()) return;
         LOG_TIME_MICROS_WITH_CATEGORY(strprintf("lock contention %s, %s:%d", pszName, pszFile, nLine), BCLog::LOCK);
@@ -168,6 +240,10 @@ private:
         Base::try_lock();
         if (!Base::owns_lock()) {
             LeaveCritical();
+        } else if (LockProfilingEnabled()) {
+            if (LockProfileSite* site = GetLockProfileSite(Base::mutex(), pszFile, nLine)) {
+                LockProfileAcquired(site, Base::mutex(), std::chrono::nanoseconds{0}, /*contended=*/false);
+            }
         }
         return Base::owns_lock();
     }
@@ -194,8 +270,10 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
             LeaveCritical();
+            if (LockProfilingEnabled()) LockProfileReleased(Base::mutex());
+        }
     }
 
     operator bool()
@@ -215,6 +293,7 @@ public:
     public:
         explicit reverse_lock(UniqueLock& _lock, const char* _guardname, const char* _file, int _line) : lock(_lock), file(_file), line(_line) {
             CheckLastCritical((void*)lock.mutex(), lockname, _guardname, _file, _line);
+            if (LockProfilingEnabled()) LockProfileReleased(lock.mutex());
             lock.unlock();
             LeaveCritical();
             lock.swap(templock);
@@ -222,8 +301,7 @@ public:
 
         ~reverse_lock() {
             templock.swap(lock);
-            EnterCritical(lockname.c_str(), file.c_str(), line, lock.mutex());
-            lock.lock();
+            lock.Enter(lockname.c_str(), file.c_str(), line);
         }
 
      private:
@@ -265,16 +343,21 @@ inline RecursiveMutex* MaybeCheckNotHeld(RecursiveMutex* cs) LOCKS_EXCLUDED(cs)
 #define TRY_LOCK(cs, name) DebugLock<decltype(cs)> name(MaybeCheckNotHeld(cs), #cs, __FILE__, __LINE__, true)
 #define WAIT_LOCK(cs, name) DebugLock<decltype(cs)> name(MaybeCheckNotHeld(cs), #cs, __FILE__, __LINE__)
 
-#define ENTER_CRITICAL_SECTION(cs)                            \
-    {                                                         \
-        EnterCritical(#cs, __FILE__, __LINE__, &cs); \
-        (cs).lock();                                          \
+#define ENTER_CRITICAL_SECTION(cs)                                                            \
+    {                                                                                         \
+        EnterCritical(#cs, __FILE__, __LINE__, &cs);                                          \
+        if (LockProfileSite* site{LockProfilingEnabled() ? GetLockProfileSite(&cs, __FILE__, __LINE__) : nullptr}) { \
+            LockProfiled(cs, site);                                                           \
+        } else {                                                                              \
+            (cs).lock();                                                                      \
+        }                                                                                     \
     }
 
 #define LEAVE_CRITICAL_SECTION(cs)                                          \
     {                                                                       \
         std::string lockname;                                               \
         CheckLastCritical((void*)(&cs), lockname, #cs, __FILE__, __LINE__); \
+        if (LockProfilingEnabled()) LockProfileReleased(&cs);               \
         (cs).unlock();                                                      \
         LeaveCritical();                                                    \
     }
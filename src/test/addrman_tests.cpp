@@ -666,6 +666,37 @@ BOOST_AUTO_TEST_CASE(addrman_serialization)
     BOOST_CHECK(addr_pos7.position != addr_pos8.position);
 }
 
+BOOST_AUTO_TEST_CASE(addrman_serialization_positions)
+{
+    // Bucket positions are stored in peers.dat and restored without rehashing,
+    // RevalidateBuckets() must then leave every entry where it is.
+    const auto ratio = GetCheckRatio(m_node);
+    auto addrman = std::make_unique<AddrMan>(EMPTY_NETGROUPMAN, DETERMINISTIC, ratio);
+    auto addrman_dup = std::make_unique<AddrMan>(EMPTY_NETGROUPMAN, DETERMINISTIC, ratio);
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+
+    std::vector<CAddress> addrs;
+    for (unsigned int i = 1; i < 64; ++i) {
+        addrs.emplace_back(ResolveService("250." + ToString(i) + ".1.1"), NODE_NONE);
+    }
+    BOOST_REQUIRE(addrman->Add(addrs, ResolveIP("252.2.2.2")));
+    for (size_t i = 0; i < addrs.size(); i += 4) {
+        addrman->Good(addrs[i]);
+    }
+
+    stream << *addrman;
+    stream >> *addrman_dup;
+    BOOST_CHECK_EQUAL(addrman_dup->size(), addrman->size());
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const CAddress& addr : addrs) {
+            BOOST_CHECK(addrman->FindAddressEntry(addr).value() == addrman_dup->FindAddressEntry(addr).value());
+        }
+        addrman_dup->RevalidateBuckets();
+        BOOST_CHECK_EQUAL(addrman_dup->size(), addrman->size());
+    }
+}
+
 BOOST_AUTO_TEST_CASE(remove_invalid)
 {
     // Confirm that invalid addresses are ignored in unserialization.
@@ -6,6 +6,7 @@
 #include <policy/feerate.h>
 
 #include <limits>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -20,6 +21,36 @@ BOOST_AUTO_TEST_CASE(MoneyRangeTest)
     BOOST_CHECK_EQUAL(MoneyRange(MAX_MONEY + CAmount(1)), false);
 }
 
+BOOST_AUTO_TEST_CASE(ScaleAmountTest)
+{
+    const CAmountScaleFactor factor = BASE_FACTOR + BASE_FACTOR / 2;
+    BOOST_CHECK_EQUAL(ScaleAmount(100, BASE_FACTOR), 100);
+    BOOST_CHECK_EQUAL(ScaleAmount(100, factor), 150);
+    BOOST_CHECK_EQUAL(ScaleAmount(101, factor), 151);
+    BOOST_CHECK_EQUAL(ScaleAmount(-101, factor), -151);
+    BOOST_CHECK_EQUAL(ScaleAmount(std::numeric_limits<CAmount>::max(), 2 * BASE_FACTOR), std::numeric_limits<CAmount>::max());
+    BOOST_CHECK_EQUAL(ScaleAmount(std::numeric_limits<CAmount>::min(), 2 * BASE_FACTOR), std::numeric_limits<CAmount>::min());
+
+    BOOST_CHECK_EQUAL(DescaleAmount(150, factor), 100);
+    BOOST_CHECK_EQUAL(DescaleAmount(151, factor), 101);
+    BOOST_CHECK_EQUAL(DescaleAmount(152, factor), 102);
+    BOOST_CHECK_EQUAL(DescaleAmount(-151, factor), -100);
+    BOOST_CHECK_EQUAL(DescaleAmount(MAX_MONEY, BASE_FACTOR), MAX_MONEY);
+    BOOST_CHECK_EQUAL(DescaleAmount(std::numeric_limits<CAmount>::max(), BASE_FACTOR / 2), std::numeric_limits<CAmount>::max());
+    for (CAmount amount = 0; amount < 1000; ++amount) {
+        BOOST_CHECK_GE(ScaleAmount(DescaleAmount(amount, factor), factor), amount);
+    }
+
+    std::vector<CAmount> amounts{0, 1, 100, 101, -101, MAX_MONEY, std::numeric_limits<CAmount>::max(), std::numeric_limits<CAmount>::min()};
+    for (const CAmountScaleFactor scale : {BASE_FACTOR, factor, 2 * BASE_FACTOR}) {
+        std::vector<CAmount> scaled{amounts};
+        ScaleAmounts(scaled, scale);
+        for (size_t i = 0; i < amounts.size(); ++i) {
+            BOOST_CHECK_EQUAL(scaled[i], ScaleAmount(amounts[i], scale));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(GetFeeTest)
 {
     CFeeRate feeRate, altFeeRate;
@@ -40,4 +40,51 @@ BOOST_AUTO_TEST_CASE(file)
     }
 }
 
+BOOST_AUTO_TEST_CASE(subnets)
+{
+    SetMockTime(1000s);
+    const auto addr = [](const std::string& str) {
+        CNetAddr addr;
+        BOOST_REQUIRE(LookupHost(str, addr, /*fAllowLookup=*/false));
+        return addr;
+    };
+    const auto subnet = [](const std::string& str) {
+        CSubNet subnet;
+        BOOST_REQUIRE(LookupSubNet(str, subnet));
+        return subnet;
+    };
+
+    BanMan banman{m_args.GetDataDirBase() / "banlist_subnets", /*client_interface=*/nullptr, /*default_ban_time=*/0};
+    banman.Ban(subnet("10.0.0.0/8"), /*ban_time_offset=*/100);
+    banman.Ban(subnet("192.168.1.0/24"), /*ban_time_offset=*/200);
+    banman.Ban(addr("1.2.3.4"), /*ban_time_offset=*/100);
+    banman.Ban(subnet("2001:db8::/32"), /*ban_time_offset=*/100);
+
+    BOOST_CHECK(banman.IsBanned(addr("10.1.2.3")));
+    BOOST_CHECK(banman.IsBanned(addr("192.168.1.255")));
+    BOOST_CHECK(!banman.IsBanned(addr("192.168.2.1")));
+    BOOST_CHECK(banman.IsBanned(addr("1.2.3.4")));
+    BOOST_CHECK(!banman.IsBanned(addr("1.2.3.5")));
+    BOOST_CHECK(banman.IsBanned(addr("2001:db8:1::1")));
+    BOOST_CHECK(!banman.IsBanned(addr("2001:db9::1")));
+    // An IPv4 ban does not cover IPv6 addresses with the same leading bits
+    BOOST_CHECK(!banman.IsBanned(addr("a00::1")));
+
+    BOOST_CHECK(banman.Unban(subnet("10.0.0.0/8")));
+    BOOST_CHECK(!banman.IsBanned(addr("10.1.2.3")));
+    BOOST_CHECK(banman.IsBanned(addr("1.2.3.4")));
+
+    // Expired bans no longer match and are swept out
+    SetMockTime(1150s);
+    BOOST_CHECK(!banman.IsBanned(addr("1.2.3.4")));
+    BOOST_CHECK(banman.IsBanned(addr("192.168.1.1")));
+    banmap_t banned;
+    banman.GetBanned(banned);
+    BOOST_CHECK_EQUAL(banned.size(), 1U);
+    BOOST_CHECK(banned.count(subnet("192.168.1.0/24")));
+
+    banman.ClearBanned();
+    BOOST_CHECK(!banman.IsBanned(addr("192.168.1.1")));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,170 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/block.h>
+#include <primitives/block_view.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <ios>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(block_view_tests, BasicTestingSetup)
+
+static std::vector<unsigned char> RandomBytes(size_t max_size)
+{
+    return g_insecure_rand_ctx.randbytes(InsecureRandRange(max_size + 1));
+}
+
+static CTransactionRef RandomTransaction(bool coinbase, bool witness)
+{
+    CMutableTransaction tx;
+    tx.nVersion = InsecureRand32();
+    tx.nLockTime = InsecureRand32();
+    tx.vin.resize(coinbase ? 1 : 1 + InsecureRandRange(4));
+    for (CTxIn& in : tx.vin) {
+        if (!coinbase) in.prevout = COutPoint{InsecureRand256(), InsecureRand32()};
+        const std::vector<unsigned char> script_sig{RandomBytes(100)};
+        in.scriptSig = CScript(script_sig.begin(), script_sig.end());
+        in.nSequence = InsecureRand32();
+        if (witness) {
+            for (uint64_t i = InsecureRandRange(3); i > 0; --i) {
+                in.scriptWitness.stack.push_back(RandomBytes(80));
+            }
+        }
+    }
+    if (witness) tx.vin[0].scriptWitness.stack.push_back(RandomBytes(80));
+    tx.vout.resize(InsecureRandRange(4));
+    for (CTxOut& out : tx.vout) {
+        out.amountType = InsecureRandBool() ? CASH : BOND;
+        out.nValue = InsecureRandRange(MAX_MONEY);
+        const std::vector<unsigned char> script{RandomBytes(40)};
+        out.scriptPubKey = CScript(script.begin(), script.end());
+    }
+    return MakeTransactionRef(tx);
+}
+
+static void CheckView(const TransactionView& view, const CTransaction& tx)
+{
+    BOOST_CHECK_EQUAL(view.GetVersion(), tx.nVersion);
+    BOOST_CHECK_EQUAL(view.GetLockTime(), tx.nLockTime);
+    BOOST_CHECK_EQUAL(view.IsCoinBase(), tx.IsCoinBase());
+    BOOST_CHECK_EQUAL(view.HasWitness(), tx.HasWitness());
+    BOOST_CHECK_EQUAL(view.GetHash(), tx.GetHash());
+    BOOST_CHECK_EQUAL(view.GetWitnessHash(), tx.GetWitnessHash());
+    BOOST_CHECK_EQUAL(view.GetTotalSize(), tx.GetTotalSize());
+    BOOST_CHECK_EQUAL(view.GetStrippedSize(), tx.GetStrippedSize());
+    BOOST_CHECK_EQUAL(view.GetWeight(), tx.GetWeight());
+
+    BOOST_REQUIRE_EQUAL(view.GetInputCount(), tx.vin.size());
+    size_t i{0};
+    view.ForEachInput([&](const TxInView& in) {
+        BOOST_CHECK(in.prevout == tx.vin[i].prevout);
+        BOOST_CHECK(CScript(in.scriptSig.begin(), in.scriptSig.end()) == tx.vin[i].scriptSig);
+        BOOST_CHECK_EQUAL(in.nSequence, tx.vin[i].nSequence);
+        ++i;
+    });
+    BOOST_CHECK_EQUAL(i, tx.vin.size());
+
+    BOOST_REQUIRE_EQUAL(view.GetOutputCount(), tx.vout.size());
+    i = 0;
+    view.ForEachOutput([&](const TxOutView& out) {
+        BOOST_CHECK_EQUAL(out.amountType, tx.vout[i].amountType);
+        BOOST_CHECK_EQUAL(out.nValue, tx.vout[i].nValue);
+        BOOST_CHECK(CScript(out.scriptPubKey.begin(), out.scriptPubKey.end()) == tx.vout[i].scriptPubKey);
+        BOOST_CHECK_EQUAL(out.GetSerializeSize(), GetSerializeSize(tx.vout[i], PROTOCOL_VERSION));
+        ++i;
+    });
+    BOOST_CHECK_EQUAL(i, tx.vout.size());
+
+    std::vector<std::vector<CScriptWitnessItem>> stacks(tx.vin.size());
+    view.ForEachWitnessItem([&](size_t input, Span<const unsigned char> item) {
+        stacks.at(input).emplace_back(item.begin(), item.end());
+    });
+    for (size_t input = 0; input < tx.vin.size(); ++input) {
+        BOOST_CHECK(stacks[input] == tx.vin[input].scriptWitness.stack);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transaction_view)
+{
+    for (int i = 0; i < 100; ++i) {
+        const CTransactionRef tx{RandomTransaction(/*coinbase=*/i % 10 == 0, /*witness=*/i % 2 == 0)};
+        CDataStream stream{SER_NETWORK, PROTOCOL_VERSION};
+        stream << tx;
+        // Trailing data is not part of the transaction
+        stream << InsecureRand32();
+        const TransactionView view{MakeUCharSpan(stream)};
+        BOOST_CHECK_EQUAL(view.GetTotalSize(), stream.size() - 4);
+        CheckView(view, *tx);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transaction_view_malformed)
+{
+    const CTransactionRef tx{RandomTransaction(/*coinbase=*/false, /*witness=*/true)};
+    CDataStream stream{SER_NETWORK, PROTOCOL_VERSION};
+    stream << tx;
+    const auto tx_data{MakeUCharSpan(stream)};
+    const std::vector<unsigned char> data{tx_data.begin(), tx_data.end()};
+
+    // Every truncation fails, like deserializing a CTransaction does
+    for (size_t size = 0; size < data.size(); ++size) {
+        BOOST_CHECK_THROW(TransactionView{Span{data}.first(size)}, std::ios_base::failure);
+    }
+
+    // Unknown flags, and a witness flag without any witness data
+    std::vector<unsigned char> unknown_flags{data};
+    unknown_flags[5] = 0x03;
+    BOOST_CHECK_EXCEPTION(TransactionView{unknown_flags}, std::ios_base::failure, HasReason{"Unknown transaction optional data"});
+
+    CMutableTransaction no_witness{*tx};
+    for (CTxIn& in : no_witness.vin) in.scriptWitness.SetNull();
+    CDataStream superfluous{SER_NETWORK, PROTOCOL_VERSION};
+    superfluous << no_witness;
+    const auto no_witness_data{MakeUCharSpan(superfluous)};
+    std::vector<unsigned char> superfluous_data{no_witness_data.begin(), no_witness_data.end()};
+    // Turn the serialization into the extended format with an empty stack for every input
+    superfluous_data.insert(superfluous_data.begin() + 4, {0x00, 0x01});
+    superfluous_data.insert(superfluous_data.end() - 4, no_witness.vin.size(), 0x00);
+    BOOST_CHECK_EXCEPTION(TransactionView{superfluous_data}, std::ios_base::failure, HasReason{"Superfluous witness record"});
+}
+
+BOOST_AUTO_TEST_CASE(block_view)
+{
+    CBlock block;
+    block.nVersion = InsecureRand32();
+    block.hashPrevBlock = InsecureRand256();
+    block.hashMerkleRoot = InsecureRand256();
+    block.nTime = InsecureRand32();
+    block.nBits = InsecureRand32();
+    block.cashSupply = InsecureRandRange(MAX_MONEY);
+    block.bondSupply = InsecureRandRange(MAX_MONEY);
+    block.nNonce = InsecureRand32();
+    block.vtx.push_back(RandomTransaction(/*coinbase=*/true, /*witness=*/true));
+    for (int i = 0; i < 20; ++i) {
+        block.vtx.push_back(RandomTransaction(/*coinbase=*/false, /*witness=*/InsecureRandBool()));
+    }
+
+    CDataStream stream{SER_NETWORK, PROTOCOL_VERSION};
+    stream << block;
+    const BlockView view{MakeUCharSpan(stream)};
+    BOOST_CHECK_EQUAL(view.GetHeader().GetHash(), block.GetHash());
+    BOOST_CHECK_EQUAL(view.GetHeader().cashSupply, block.cashSupply);
+    BOOST_CHECK_EQUAL(view.GetHeader().bondSupply, block.bondSupply);
+    BOOST_REQUIRE_EQUAL(view.GetTransactionCount(), block.vtx.size());
+
+    size_t i{0};
+    view.ForEachTransaction([&](const TransactionView& tx) {
+        CheckView(tx, *block.vtx.at(i++));
+    });
+    BOOST_CHECK_EQUAL(i, block.vtx.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
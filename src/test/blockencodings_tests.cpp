@@ -300,6 +300,75 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(OmittedRemainderOutputsRoundTripTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig.resize(10);
+    coinbase.vout.resize(4);
+    coinbase.vout[0].nValue = 42;
+    coinbase.vout[1] = CTxOut(BOND, 42, CScript());
+    // Conversion remainder outputs
+    coinbase.vout[2] = CTxOut(CASH, 7, CScript() << OP_TRUE);
+    coinbase.vout[3] = CTxOut(BOND, 8, CScript() << OP_TRUE);
+    const std::vector<CTxOut> remainders{coinbase.vout[2], coinbase.vout[3]};
+
+    CBlock block;
+    block.vtx.resize(1);
+    block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    block.nVersion = 42;
+    block.hashPrevBlock = InsecureRand256();
+    block.nBits = 0x207fffff;
+
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    assert(!mutated);
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, Params().GetConsensus())) ++block.nNonce;
+
+    CBlockHeaderAndShortTxIDs shortIDs{block, remainders.size()};
+    BOOST_CHECK_EQUAL(shortIDs.omitted_remainder_outputs, remainders.size());
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << shortIDs << COMPACTSIZE(shortIDs.omitted_remainder_outputs);
+
+    CBlockHeaderAndShortTxIDs shortIDs2;
+    stream >> shortIDs2;
+    BOOST_CHECK_EQUAL(shortIDs2.omitted_remainder_outputs, 0U);
+    BOOST_CHECK(!stream.empty());
+    stream >> COMPACTSIZE(shortIDs2.omitted_remainder_outputs);
+    BOOST_CHECK_EQUAL(shortIDs2.omitted_remainder_outputs, remainders.size());
+
+    // Without a prediction, or with a wrong one, fall back to the full block
+    {
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+        CBlock block2;
+        BOOST_CHECK(partialBlock.FillBlock(block2, {}) == READ_STATUS_FAILED);
+    }
+    {
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+        CBlock block2;
+        BOOST_CHECK(partialBlock.FillBlock(block2, {}, [&](const CBlock&) {
+            return std::optional<std::vector<CTxOut>>{{remainders[1], remainders[0]}};
+        }) == READ_STATUS_FAILED);
+    }
+
+    // The predicted remainders restore the original coinbase
+    {
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+        CBlock block2;
+        BOOST_CHECK(partialBlock.FillBlock(block2, {}, [&](const CBlock&) {
+            return std::optional<std::vector<CTxOut>>{remainders};
+        }) == READ_STATUS_OK);
+        BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+        BOOST_CHECK_EQUAL(block.hashMerkleRoot.ToString(), BlockMerkleRoot(block2, &mutated).ToString());
+        BOOST_CHECK(!mutated);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
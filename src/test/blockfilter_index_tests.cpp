@@ -273,6 +273,60 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+static void SyncFilterIndex(BlockFilterIndex& filter_index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_headers_file, BuildChainTestingSetup)
+{
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    const fs::path headers_path{gArgs.GetDataDirNet() / "indexes" / "blockfilter" / "basic" / "headers.dat"};
+    std::vector<uint256> expected_hashes;
+    uint256 expected_header;
+    {
+        BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, false, true);
+        BOOST_REQUIRE(filter_index.Start());
+        SyncFilterIndex(filter_index);
+        BOOST_CHECK(filter_index.LookupFilterHashRange(0, tip, expected_hashes));
+        BOOST_CHECK(filter_index.LookupFilterHeader(tip, expected_header));
+        filter_index.Stop();
+    }
+    BOOST_CHECK_GE(fs::file_size(headers_path), (tip->nHeight + 1U) * 3 * sizeof(uint256));
+
+    // A truncated headers file is rebuilt from the database on restart
+    fs::resize_file(headers_path, 100);
+    {
+        BlockFilterIndex filter_index(interfaces::MakeChain(m_node), BlockFilterType::BASIC, 1 << 20, false, false);
+        BOOST_REQUIRE(filter_index.Start());
+        SyncFilterIndex(filter_index);
+        BOOST_CHECK_GE(fs::file_size(headers_path), (tip->nHeight + 1U) * 3 * sizeof(uint256));
+
+        std::vector<uint256> hashes;
+        uint256 header;
+        BOOST_CHECK(filter_index.LookupFilterHashRange(0, tip, hashes));
+        BOOST_CHECK(filter_index.LookupFilterHeader(tip, header));
+        BOOST_CHECK(hashes == expected_hashes);
+        BOOST_CHECK_EQUAL(header, expected_header);
+
+        {
+            uint256 last_header;
+            LOCK(cs_main);
+            for (const CBlockIndex* block_index = m_node.chainman->ActiveChain().Genesis();
+                 block_index != nullptr;
+                 block_index = m_node.chainman->ActiveChain().Next(block_index)) {
+                CheckFilterLookups(filter_index, block_index, last_header);
+            }
+        }
+        filter_index.Stop();
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
@@ -125,6 +125,34 @@ BOOST_AUTO_TEST_CASE(blockfilter_basic_test)
     BOOST_CHECK(default_ctor_block_filter_1.GetEncodedFilter() == default_ctor_block_filter_2.GetEncodedFilter());
 }
 
+BOOST_AUTO_TEST_CASE(blockfilter_batch_construction)
+{
+    std::vector<CBlock> blocks(10);
+    std::vector<CBlockUndo> block_undos(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        CMutableTransaction tx;
+        tx.vout.emplace_back(CASH, 100, CScript() << OP_0 << std::vector<unsigned char>(20, i));
+        blocks[i].nNonce = i;
+        blocks[i].vtx.push_back(MakeTransactionRef(tx));
+        block_undos[i].vtxundo.emplace_back();
+        block_undos[i].vtxundo.back().vprevout.emplace_back(CTxOut(CASH, 100, CScript() << OP_1 << std::vector<unsigned char>(32, i)), 0, false);
+    }
+
+    // Filters built by any number of threads match the filters built one at a time
+    for (const int n_threads : {1, 3, 16}) {
+        const std::vector<BlockFilter> filters{ConstructBlockFilters(BlockFilterType::BASIC, blocks, block_undos, n_threads)};
+        BOOST_REQUIRE_EQUAL(filters.size(), blocks.size());
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            const BlockFilter expected(BlockFilterType::BASIC, blocks[i], block_undos[i]);
+            BOOST_CHECK_EQUAL(filters[i].GetBlockHash(), blocks[i].GetHash());
+            BOOST_CHECK(filters[i].GetEncodedFilter() == expected.GetEncodedFilter());
+        }
+    }
+
+    BOOST_CHECK(ConstructBlockFilters(BlockFilterType::BASIC, {}, {}, 4).empty());
+    BOOST_CHECK_THROW(ConstructBlockFilters(BlockFilterType::INVALID, blocks, block_undos, 4), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(blockfilters_json_test)
 {
     UniValue json;
@@ -0,0 +1,45 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <flatfile.h>
+#include <node/blockstorage.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+using node::BlockManager;
+using node::GetBlockPosFilename;
+
+BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(blockmanager_unlink_pruned_files_in_background)
+{
+    BlockManager& blockman{m_node.chainman->m_blockman};
+    const FlatFilePos pos{0, 0};
+    const fs::path block_file{GetBlockPosFilename(pos)};
+    const fs::path undo_file{block_file.parent_path() / "rev00000.dat"};
+    BOOST_CHECK(fs::exists(block_file));
+    BOOST_CHECK(fs::exists(undo_file));
+
+    // All blocks of the test chain are stored in the first block file
+    const CBlockFileInfo& info{*blockman.GetBlockFileInfo(0)};
+    BOOST_CHECK_GT(info.nUndoSize, 0U);
+    BOOST_CHECK_EQUAL(blockman.CalculateCurrentUsage(), uint64_t{info.nSize} + info.nUndoSize);
+
+    WITH_LOCK(::cs_main, blockman.PruneOneBlockFile(0));
+    BOOST_CHECK_EQUAL(blockman.CalculateCurrentUsage(), 0U);
+    BOOST_CHECK(fs::exists(block_file));
+
+    blockman.UnlinkPrunedFilesInBackground({0});
+    blockman.WaitForPrunedFilesUnlinked();
+    BOOST_CHECK(!fs::exists(block_file));
+    BOOST_CHECK(!fs::exists(undo_file));
+
+    // Waiting without pending files returns immediately
+    blockman.WaitForPrunedFilesUnlinked();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <index/blockreader.h>
+#include <index/coinstatsindex.h>
+#include <index/txindex.h>
+#include <interfaces/chain.h>
+#include <kernel/coinstats.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+BOOST_FIXTURE_TEST_SUITE(blockreader_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockreader_shares_reads)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    const CBlockIndex* genesis{WITH_LOCK(cs_main, return chainstate.m_chain.Genesis())};
+    BOOST_REQUIRE(genesis);
+
+    IndexBlockReader reader_a{chainstate};
+    IndexBlockReader reader_b{chainstate};
+
+    // Readers of the same chainstate get the same deserialized block
+    const std::shared_ptr<const CBlock> block_a{reader_a.Read(*genesis)};
+    const std::shared_ptr<const CBlock> block_b{reader_b.Read(*genesis)};
+    BOOST_REQUIRE(block_a);
+    BOOST_CHECK_EQUAL(block_a->GetHash(), genesis->GetBlockHash());
+    BOOST_CHECK_EQUAL(block_a.get(), block_b.get());
+}
+
+BOOST_AUTO_TEST_CASE(blockreader_read_failure)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+
+    // A block that isn't stored at its position on disk can't be read
+    const uint256 hash{InsecureRand256()};
+    CBlockIndex missing;
+    missing.phashBlock = &hash;
+    missing.nStatus = BLOCK_HAVE_DATA;
+
+    IndexBlockReader reader{chainstate};
+    BOOST_CHECK(!reader.Read(missing));
+}
+
+BOOST_FIXTURE_TEST_CASE(blockreader_concurrent_index_sync, TestChain100Setup)
+{
+    // Indexes syncing at the same time share the blocks they read
+    TxIndex txindex{interfaces::MakeChain(m_node), 1 << 20, true};
+    CoinStatsIndex coin_stats_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(txindex.Start());
+    BOOST_REQUIRE(coin_stats_index.Start());
+
+    const auto timeout = GetTime<std::chrono::seconds>() + 120s;
+    while (!txindex.BlockUntilSyncedToCurrentChain() || !coin_stats_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(timeout > GetTime<std::chrono::milliseconds>());
+        UninterruptibleSleep(100ms);
+    }
+
+    uint256 block_hash;
+    CTransactionRef tx;
+    BOOST_CHECK(txindex.FindTx(m_coinbase_txns.back()->GetHash(), block_hash, tx));
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_CHECK(coin_stats_index.LookUpStats(*tip));
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    txindex.Stop();
+    coin_stats_index.Stop();
+
+    // Let scheduler events finish running to avoid accessing any memory related to the indexes after they are destructed
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <kernel/blockverify.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+using kernel::BlockVerificationResult;
+using kernel::BlockVerifier;
+using node::ReadBlockFromDisk;
+using node::UndoReadFromDisk;
+
+struct BlockVerifierSetup : public TestChain100Setup {
+    //! Serialized blocks and undo data of the active chain, as the block verifier takes them
+    std::vector<std::pair<std::vector<std::byte>, std::vector<std::byte>>> ReadChain()
+    {
+        std::vector<std::pair<std::vector<std::byte>, std::vector<std::byte>>> chain;
+        LOCK(::cs_main);
+        for (const CBlockIndex* pindex{m_node.chainman->ActiveChain().Genesis()}; pindex; pindex = m_node.chainman->ActiveChain().Next(pindex)) {
+            CBlock block;
+            BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+            CDataStream block_stream{SER_NETWORK, PROTOCOL_VERSION};
+            block_stream << block;
+            CDataStream undo_stream{SER_DISK, CLIENT_VERSION};
+            if (pindex->pprev) {
+                CBlockUndo undo;
+                BOOST_REQUIRE(UndoReadFromDisk(undo, pindex));
+                undo_stream << undo;
+            }
+            chain.emplace_back(std::vector<std::byte>{block_stream.begin(), block_stream.end()},
+                               std::vector<std::byte>{undo_stream.begin(), undo_stream.end()});
+        }
+        return chain;
+    }
+
+    std::vector<BlockVerificationResult> Verify(const std::vector<std::pair<std::vector<std::byte>, std::vector<std::byte>>>& chain, int worker_threads)
+    {
+        BlockVerifier verifier{Params(), worker_threads};
+        for (const auto& [block, undo] : chain) {
+            verifier.Add(block, undo);
+        }
+        return verifier.Finish();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(blockverify_tests, BlockVerifierSetup)
+
+BOOST_AUTO_TEST_CASE(blockverifier_chain)
+{
+    // Spend a coinbase so that there is undo data to check
+    const CScript script_pub_key{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/1, coinbaseKey,
+                                                                  script_pub_key, /*output_amount=*/CAmount(49 * COIN), /*submit=*/false)};
+    CreateAndProcessBlock({spend}, script_pub_key);
+    const auto chain{ReadChain()};
+    BOOST_REQUIRE_EQUAL(chain.size(), 102U);
+
+    for (const int worker_threads : {1, 3}) {
+        const auto results{Verify(chain, worker_threads)};
+        BOOST_REQUIRE_EQUAL(results.size(), chain.size());
+        LOCK(::cs_main);
+        for (size_t i = 0; i < results.size(); ++i) {
+            const CBlockIndex& index{*m_node.chainman->ActiveChain()[i]};
+            BOOST_CHECK_MESSAGE(results[i].state.IsValid(), results[i].state.ToString());
+            BOOST_CHECK_EQUAL(results[i].hash, index.GetBlockHash());
+            BOOST_CHECK_EQUAL(results[i].height, index.nHeight);
+            BOOST_CHECK(results[i].total_supply == index.GetTotalSupply());
+            BOOST_CHECK_EQUAL(results[i].scale_factor, index.scaleFactor);
+        }
+    }
+
+    // Undo data that does not match the spent coin invalidates the block and its descendants
+    auto bad_undo{chain};
+    {
+        CBlockUndo undo;
+        SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(bad_undo[101].second)} >> undo;
+        BOOST_REQUIRE_EQUAL(undo.vtxundo.size(), 1U);
+        undo.vtxundo[0].vprevout[0].fCoinBase = false;
+        CDataStream undo_stream{SER_DISK, CLIENT_VERSION};
+        undo_stream << undo;
+        bad_undo[101].second.assign(undo_stream.begin(), undo_stream.end());
+    }
+    auto results{Verify(bad_undo, 2)};
+    BOOST_CHECK(results[100].state.IsValid());
+    BOOST_CHECK_EQUAL(results[101].state.GetRejectReason(), "bad-undo-data");
+
+    // A block failing its checks invalidates its descendants
+    auto bad_block{chain};
+    bad_block[50].first.back() ^= std::byte{1};
+    results = Verify(bad_block, 2);
+    BOOST_CHECK(results[49].state.IsValid());
+    BOOST_CHECK(!results[50].state.IsValid());
+    for (size_t i = 51; i < results.size(); ++i) {
+        BOOST_CHECK_EQUAL(results[i].state.GetRejectReason(), "bad-prevblk");
+    }
+
+    // Blocks that do not extend the chain are not verified
+    auto gap{chain};
+    gap.erase(gap.begin() + 10);
+    results = Verify(gap, 2);
+    BOOST_CHECK(results[9].state.IsValid());
+    BOOST_CHECK_EQUAL(results[10].height, -1);
+    BOOST_CHECK_EQUAL(results[10].state.GetRejectReason(), "bad-prevblk");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -518,4 +518,38 @@ BOOST_AUTO_TEST_CASE(rolling_bloom)
     g_mock_deterministic_tests = false;
 }
 
+BOOST_AUTO_TEST_CASE(rolling_bloom_growing)
+{
+    // last-10000-entry, starting out sized for 100 entries
+    CRollingBloomFilter full(10000, 0.000001);
+    CRollingBloomFilter rb(10000, 0.000001, 100);
+    const size_t initial_usage{rb.DynamicMemoryUsage()};
+    BOOST_CHECK_LT(initial_usage * 50, full.DynamicMemoryUsage());
+
+    // The last 10000 entries are remembered while the filter grows, and after
+    std::vector<std::vector<unsigned char>> data;
+    for (int i = 0; i < 25000; i++) {
+        data.push_back(RandomData());
+        rb.insert(data.back());
+        if (i % 100 == 0) {
+            for (int j = std::max(0, i - 9999); j <= i; j++) {
+                BOOST_CHECK(rb.contains(data[j]));
+            }
+        }
+    }
+    // Once grown and its smaller filters are dropped, its size matches a filter that started at full size
+    BOOST_CHECK_LT(rb.DynamicMemoryUsage(), full.DynamicMemoryUsage() + 1024);
+
+    // The filter does not fill up as it grows
+    unsigned int hits{0};
+    for (int i = 0; i < 10000; i++) {
+        if (rb.contains(RandomData())) ++hits;
+    }
+    BOOST_CHECK_LE(hits, 2U);
+
+    rb.reset();
+    BOOST_CHECK(!rb.contains(data.back()));
+    BOOST_CHECK_EQUAL(rb.DynamicMemoryUsage(), initial_usage);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
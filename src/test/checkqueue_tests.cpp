@@ -185,6 +185,11 @@ static void Correct_Queue_range(std::vector<size_t> range)
         if (FakeCheckCheckCompletion::n_calls != i) {
             BOOST_REQUIRE_EQUAL(FakeCheckCheckCompletion::n_calls, i);
         }
+        const auto stats{small_queue->GetLastStats()};
+        if (stats.checks != i || stats.stolen > i) {
+            BOOST_REQUIRE_EQUAL(stats.checks, i);
+            BOOST_REQUIRE_LE(stats.stolen, i);
+        }
     }
     small_queue->StopWorkerThreads();
 }
@@ -270,6 +270,12 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
 
     CCoinsViewDB db_base{"test", /*nCacheSize=*/1 << 23, /*fMemory=*/true, /*fWipe=*/false};
     SimulationTest(&db_base, true);
+
+    CCoinsViewDB flush_db{"test", /*nCacheSize=*/1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+    CCoinsViewBackgroundFlush flush_base{&flush_db};
+    flush_base.SetBackground(true);
+    SimulationTest(&flush_base, true);
+    BOOST_CHECK(flush_base.WaitForWrite());
 }
 
 // Store of all necessary tx and undo data for next test
@@ -547,6 +553,83 @@ BOOST_AUTO_TEST_CASE(ccoins_serialization)
     }
 }
 
+static bool UndoEqual(const CBlockUndo& a, const CBlockUndo& b)
+{
+    if (a.vtxundo.size() != b.vtxundo.size()) return false;
+    for (size_t i = 0; i < a.vtxundo.size(); ++i) {
+        const std::vector<Coin>& coins_a = a.vtxundo[i].vprevout;
+        const std::vector<Coin>& coins_b = b.vtxundo[i].vprevout;
+        if (coins_a.size() != coins_b.size()) return false;
+        for (size_t j = 0; j < coins_a.size(); ++j) {
+            if (coins_a[j].out != coins_b[j].out || coins_a[j].nHeight != coins_b[j].nHeight ||
+                coins_a[j].fCoinBase != coins_b[j].fCoinBase) return false;
+        }
+    }
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE(coin_layout)
+{
+    // The height and coinbase flag of a coin are stored in the tail padding of
+    // its output, so a coin is no larger than the output
+    if constexpr (sizeof(void*) == 8) {
+        BOOST_CHECK_EQUAL(sizeof(CScript), 32U);
+        BOOST_CHECK_EQUAL(sizeof(CTxOut), 48U);
+        BOOST_CHECK_EQUAL(sizeof(Coin), 48U);
+        BOOST_CHECK_EQUAL(sizeof(CCoinsCacheEntry), 56U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(undo_serialization)
+{
+    const std::vector<CScript> scripts{
+        GetScriptForDestination(PKHash(uint160(g_insecure_rand_ctx.randbytes(20)))),
+        GetScriptForDestination(WitnessV0KeyHash(uint160(g_insecure_rand_ctx.randbytes(20)))),
+        GetScriptForDestination(WitnessV0ScriptHash(InsecureRand256())),
+        GetScriptForDestination(WitnessV1Taproot(XOnlyPubKey(InsecureRand256()))),
+        CScript() << OP_RETURN << g_insecure_rand_ctx.randbytes(40),
+        CScript(),
+    };
+    CBlockUndo undo;
+    for (int i = 0; i < 300; ++i) {
+        CTxUndo& txundo = undo.vtxundo.emplace_back();
+        for (int j = 0; j < 3; ++j) {
+            CTxOut out(InsecureRandBool() ? BOND : CASH, InsecureRandRange(MAX_MONEY), scripts[InsecureRandRange(scripts.size())]);
+            txundo.vprevout.emplace_back(std::move(out), InsecureRandRange(1 << 30), InsecureRandBool());
+        }
+    }
+
+    // Undo data is written in the v2 encoding, which is smaller, and both encodings can be read
+    CDataStream v2(SER_DISK, CLIENT_VERSION);
+    v2 << undo;
+    CDataStream v1(SER_DISK, CLIENT_VERSION);
+    v1 << undo.vtxundo;
+    BOOST_CHECK_EQUAL(uint8_t(v2[0]), BLOCK_UNDO_V2_MARKER);
+    BOOST_CHECK_LT(v2.size(), v1.size());
+    for (CDataStream* stream : {&v1, &v2}) {
+        CBlockUndo read;
+        *stream >> read;
+        BOOST_CHECK(stream->empty());
+        BOOST_CHECK(UndoEqual(read, undo));
+    }
+
+    // Amount types the v2 encoding can not represent fall back to the v1 encoding
+    undo.vtxundo[7].vprevout[1].out.amountType = UNKNOWN;
+    CDataStream fallback(SER_DISK, CLIENT_VERSION);
+    fallback << undo;
+    CDataStream expected(SER_DISK, CLIENT_VERSION);
+    expected << undo.vtxundo;
+    BOOST_CHECK(fallback.str() == expected.str());
+    CBlockUndo read;
+    fallback >> read;
+    BOOST_CHECK(UndoEqual(read, undo));
+
+    // v1 transaction counts must be canonical CompactSizes, as ReadCompactSize requires
+    CDataStream non_canonical(SER_DISK, CLIENT_VERSION);
+    non_canonical << uint8_t{253} << uint16_t{0};
+    BOOST_CHECK_EXCEPTION(non_canonical >> read, std::ios_base::failure, HasReason("non-canonical ReadCompactSize()"));
+}
+
 const static COutPoint OUTPOINT;
 const static CAmount SPENT = -1;
 const static CAmount ABSENT = -2;
@@ -608,7 +691,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -877,4 +961,102 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch)
+{
+    CCoinsView base;
+    CCoinsViewCache cache(&base);
+    const COutPoint outpoint{InsecureRand256(), 0};
+
+    // Spent coins are not cached
+    cache.AddPrefetchedCoin(outpoint, Coin{});
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint));
+
+    Coin coin;
+    coin.out.nValue = 1;
+    cache.AddPrefetchedCoin(outpoint, Coin{coin});
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK_EQUAL(cache.AccessCoin(outpoint).out.nValue, 1);
+
+    // A cached entry, including a spend not yet flushed, is never replaced
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    coin.out.nValue = 2;
+    cache.AddPrefetchedCoin(outpoint, Coin{coin});
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_background_flush)
+{
+    CCoinsViewDB db{"test", /*nCacheSize=*/1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+    CCoinsViewBackgroundFlush flush_view{&db};
+    CCoinsViewCache cache{&flush_view};
+
+    Coin coin;
+    coin.out.nValue = 1;
+    std::vector<COutPoint> outpoints;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        outpoints.emplace_back(InsecureRand256(), i);
+        cache.AddCoin(outpoints.back(), Coin{coin}, /*possible_overwrite=*/false);
+    }
+    const uint256 block1{InsecureRand256()};
+    cache.SetBestBlock(block1);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(db.GetBestBlock(), block1);
+
+    // Flushed coins are visible through the view before and after they are on disk
+    flush_view.SetBackground(true);
+    BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+    const COutPoint added{InsecureRand256(), 0};
+    cache.AddCoin(added, Coin{coin}, /*possible_overwrite=*/false);
+    const uint256 block2{InsecureRand256()};
+    cache.SetBestBlock(block2);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK_EQUAL(flush_view.GetBestBlock(), block2);
+    BOOST_CHECK(!cache.HaveCoin(outpoints[0]));
+    BOOST_CHECK(cache.HaveCoin(outpoints[1]));
+    BOOST_CHECK(cache.HaveCoin(added));
+
+    BOOST_CHECK(flush_view.WaitForWrite());
+    BOOST_CHECK_EQUAL(db.GetBestBlock(), block2);
+    BOOST_CHECK(!db.HaveCoin(outpoints[0]));
+    BOOST_CHECK(db.HaveCoin(added));
+    BOOST_CHECK(!flush_view.WriteFailed());
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_db_large_flush)
+{
+    CCoinsViewDB db{"test", /*nCacheSize=*/1 << 23, /*fMemory=*/true, /*fWipe=*/false};
+    CCoinsViewCache cache{&db};
+
+    // Enough coins to be serialized on several threads and committed in several batches
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.out.scriptPubKey.assign(uint32_t{22}, 1);
+    std::vector<COutPoint> outpoints;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        outpoints.emplace_back(InsecureRand256(), i);
+        coin.nHeight = i;
+        cache.AddCoin(outpoints.back(), Coin{coin}, /*possible_overwrite=*/false);
+    }
+    const uint256 block1{InsecureRand256()};
+    cache.SetBestBlock(block1);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(db.GetBestBlock(), block1);
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+
+    for (uint32_t i = 0; i < outpoints.size(); i += 2) {
+        BOOST_CHECK(cache.SpendCoin(outpoints[i]));
+    }
+    const uint256 block2{InsecureRand256()};
+    cache.SetBestBlock(block2);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(db.GetBestBlock(), block2);
+
+    for (uint32_t i = 0; i < outpoints.size(); ++i) {
+        Coin read;
+        BOOST_CHECK_EQUAL(db.GetCoin(outpoints[i], read), i % 2 == 1);
+        if (i % 2 == 1) BOOST_CHECK_EQUAL(read.nHeight, i);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -76,12 +76,47 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_initial_sync, TestChain100Setup)
 
     BOOST_CHECK(block_index != new_block_index);
 
+    // Conversion stats are recorded from genesis, and no conversions were mined
+    const std::optional<ConversionStats> conversion_stats{coin_stats_index.LookUpConversionStats(*new_block_index)};
+    BOOST_REQUIRE(conversion_stats);
+    BOOST_CHECK_EQUAL(conversion_stats->conversion_count, 0U);
+    BOOST_CHECK(coin_stats_index.LookUpConversionStats(*genesis_block_index));
+
     // Shutdown sequence (c.f. Shutdown() in init.cpp)
     coin_stats_index.Stop();
 
     // Rest of shutdown sequence and destructors happen in ~TestingSetup()
 }
 
+BOOST_AUTO_TEST_CASE(conversion_stats_accounting)
+{
+    ConversionStats stats;
+
+    // 10 cash converted to 7 bonds, with a 1 bond remainder to the destination
+    stats.AddConversion({10, 0}, {0, 6}, BOND, 1, /*has_destination=*/true);
+    // 5 bonds converted to 4 cash, with a 2 cash remainder to the miner
+    stats.AddConversion({0, 5}, {2, 0}, CASH, 2, /*has_destination=*/false);
+    BOOST_CHECK_EQUAL(stats.conversion_count, 2U);
+    BOOST_CHECK_EQUAL(stats.amount_in[CASH], 10);
+    BOOST_CHECK_EQUAL(stats.amount_out[BOND], 7);
+    BOOST_CHECK_EQUAL(stats.amount_in[BOND], 5);
+    BOOST_CHECK_EQUAL(stats.amount_out[CASH], 4);
+    BOOST_CHECK_EQUAL(stats.remainder_to_destination[BOND], 1);
+    BOOST_CHECK_EQUAL(stats.remainder_to_miner[CASH], 2);
+
+    // Prefix sums subtract to the stats of the range in between
+    ConversionStats range{stats};
+    ConversionStats first;
+    first.AddConversion({10, 0}, {0, 6}, BOND, 1, /*has_destination=*/true);
+    range -= first;
+    BOOST_CHECK_EQUAL(range.conversion_count, 1U);
+    BOOST_CHECK_EQUAL(range.amount_in[CASH], 0);
+    BOOST_CHECK_EQUAL(range.amount_in[BOND], 5);
+    BOOST_CHECK_EQUAL(range.amount_out[BOND], 0);
+    BOOST_CHECK_EQUAL(range.remainder_to_destination[BOND], 0);
+    BOOST_CHECK_EQUAL(range.remainder_to_miner[CASH], 2);
+}
+
 // Test shutdown between BlockConnected and ChainStateFlushed notifications,
 // make sure index is not corrupted and is able to reload.
 BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
@@ -0,0 +1,175 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/merkle.h>
+#include <index/conversionindex.h>
+#include <interfaces/chain.h>
+#include <key.h>
+#include <node/miner.h>
+#include <pow.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+using node::BlockAssembler;
+
+BOOST_AUTO_TEST_SUITE(conversionindex_tests)
+
+//! Position of the bond output of the test chain's coinbase transactions, which follows the cash output
+static constexpr uint32_t COINBASE_BOND_VOUT{1};
+
+static void IndexWaitSynced(BaseIndex& index)
+{
+    // Allow the ConversionIndex to catch up with the block index that is
+    // syncing in a background thread.
+    const auto timeout = GetTime<std::chrono::seconds>() + 120s;
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(timeout > GetTime<std::chrono::milliseconds>());
+        UninterruptibleSleep(100ms);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(conversionindex_initial_sync, TestChain100Setup)
+{
+    ConversionIndex conversion_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(conversion_index.Start());
+    IndexWaitSynced(conversion_index);
+
+    // Convert the bonds of a coinbase to cash, with the remainder paid to a
+    // destination. The regtest supply starts out as bonds only.
+    const CScript remainder_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CTransactionRef& input_tx{m_coinbase_txns[0]};
+    BOOST_REQUIRE_EQUAL(input_tx->vout[COINBASE_BOND_VOUT].amountType, BOND);
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint{input_tx->GetHash(), COINBASE_BOND_VOUT});
+    mtx.vout.emplace_back(BOND, 10 * CENT, GetConversionScript(CASH, remainder_script, 0));
+    mtx.vout.emplace_back(CASH, CENT, remainder_script);
+
+    FillableSigningProvider keystore;
+    keystore.AddKey(coinbaseKey);
+    std::map<COutPoint, Coin> input_coins;
+    input_coins.emplace(mtx.vin[0].prevout, Coin{input_tx->vout[COINBASE_BOND_VOUT], 1, /*fCoinBaseIn=*/true});
+    std::map<int, bilingual_str> input_errors;
+    BOOST_REQUIRE(SignTransaction(mtx, &keystore, input_coins, SIGHASH_ALL, input_errors));
+    const CTransactionRef conversion_tx{MakeTransactionRef(mtx)};
+
+    ConversionIndexEntry entry;
+    BOOST_CHECK(!conversion_index.FindConversion(conversion_tx->GetHash(), entry));
+
+    {
+        LOCK(cs_main);
+        const MempoolAcceptResult result{m_node.chainman->ProcessTransaction(conversion_tx)};
+        BOOST_REQUIRE_MESSAGE(result.m_result_type == MempoolAcceptResult::ResultType::VALID, result.m_state.ToString());
+    }
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    // Mine the conversion from the mempool, so the miner pays its remainder
+    CBlock block{BlockAssembler{m_node.chainman->ActiveChainstate(), m_node.mempool.get()}.CreateNewBlock(coinbase_script)->block};
+    BOOST_REQUIRE_EQUAL(block.vtx.size(), 2U);
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, m_node.chainman->GetConsensus())) ++block.nNonce;
+    BOOST_REQUIRE(m_node.chainman->ProcessNewBlock(std::make_shared<const CBlock>(block), true, true, nullptr));
+    BOOST_REQUIRE(conversion_index.BlockUntilSyncedToCurrentChain());
+
+    // The conversion is found by hash, along with the coinbase output paying its remainder
+    BOOST_REQUIRE(conversion_index.FindConversion(conversion_tx->GetHash(), entry));
+    BOOST_CHECK_EQUAL(entry.block_hash, block.GetHash());
+    BOOST_CHECK_EQUAL(entry.height, 101);
+    BOOST_CHECK_EQUAL(entry.remainder_type, CASH);
+    BOOST_CHECK_GT(entry.remainder, 0);
+    BOOST_CHECK(entry.remainder_script == remainder_script);
+    BOOST_REQUIRE_GE(entry.coinbase_vout, 0);
+    const CTxOut& remainder_out{block.vtx[0]->vout.at(entry.coinbase_vout)};
+    BOOST_CHECK_EQUAL(remainder_out.amountType, CASH);
+    BOOST_CHECK_EQUAL(remainder_out.nValue, entry.remainder);
+    BOOST_CHECK(remainder_out.scriptPubKey == remainder_script);
+
+    // The conversion is found by the script its remainder was paid to
+    const auto conversions{conversion_index.FindConversionsByDestination(remainder_script)};
+    BOOST_REQUIRE_EQUAL(conversions.size(), 1U);
+    BOOST_CHECK_EQUAL(conversions[0].first, conversion_tx->GetHash());
+    BOOST_CHECK_EQUAL(conversions[0].second.remainder, entry.remainder);
+    BOOST_CHECK(conversion_index.FindConversionsByDestination(coinbase_script).empty());
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    conversion_index.Stop();
+
+    // Let scheduler events finish running to avoid accessing any memory related to the index after it is destructed
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_FIXTURE_TEST_CASE(conversion_remainders_merged, TestChain100Setup)
+{
+    ConversionIndex conversion_index{interfaces::MakeChain(m_node), 1 << 20, true};
+    BOOST_REQUIRE(conversion_index.Start());
+    IndexWaitSynced(conversion_index);
+
+    // Two conversions paying their remainders to the same destination
+    const CScript remainder_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    FillableSigningProvider keystore;
+    keystore.AddKey(coinbaseKey);
+    std::vector<CTransactionRef> conversions;
+    for (size_t i = 0; i < 2; ++i) {
+        const CTransactionRef& input_tx{m_coinbase_txns[i]};
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(COutPoint{input_tx->GetHash(), COINBASE_BOND_VOUT});
+        mtx.vout.emplace_back(BOND, 10 * CENT, GetConversionScript(CASH, remainder_script, 0));
+        mtx.vout.emplace_back(CASH, CENT, remainder_script);
+        std::map<COutPoint, Coin> input_coins;
+        input_coins.emplace(mtx.vin[0].prevout, Coin{input_tx->vout[COINBASE_BOND_VOUT], 1, /*fCoinBaseIn=*/true});
+        std::map<int, bilingual_str> input_errors;
+        BOOST_REQUIRE(SignTransaction(mtx, &keystore, input_coins, SIGHASH_ALL, input_errors));
+        conversions.push_back(MakeTransactionRef(mtx));
+        LOCK(cs_main);
+        const MempoolAcceptResult result{m_node.chainman->ProcessTransaction(conversions.back())};
+        BOOST_REQUIRE_MESSAGE(result.m_result_type == MempoolAcceptResult::ResultType::VALID, result.m_state.ToString());
+    }
+
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    CBlock block{BlockAssembler{m_node.chainman->ActiveChainstate(), m_node.mempool.get()}.CreateNewBlock(coinbase_script)->block};
+    BOOST_REQUIRE_EQUAL(block.vtx.size(), 3U);
+
+    // The coinbase pays both remainders in one output after the miner's, as predicted for compact blocks
+    const std::vector<CTxOut>& coinbase_vout{block.vtx[0]->vout};
+    BOOST_REQUIRE_EQUAL(coinbase_vout.size(), 3U);
+    BOOST_CHECK_EQUAL(coinbase_vout[2].amountType, CASH);
+    BOOST_CHECK(coinbase_vout[2].scriptPubKey == remainder_script);
+    {
+        LOCK(cs_main);
+        const CBlockIndex* tip{m_node.chainman->ActiveChain().Tip()};
+        const auto predicted{GetConversionRemainderOutputs(block, m_node.chainman->ActiveChainstate().CoinsTip(), tip->nHeight + 1, tip->GetTotalSupply())};
+        BOOST_REQUIRE(predicted);
+        BOOST_REQUIRE_EQUAL(predicted->size(), 1U);
+        BOOST_CHECK(predicted->at(0) == coinbase_vout[2]);
+    }
+
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, m_node.chainman->GetConsensus())) ++block.nNonce;
+    BOOST_REQUIRE(m_node.chainman->ProcessNewBlock(std::make_shared<const CBlock>(block), true, true, nullptr));
+    BOOST_CHECK_EQUAL(m_node.chainman->ActiveChain().Tip()->GetBlockHash(), block.GetHash());
+    BOOST_REQUIRE(conversion_index.BlockUntilSyncedToCurrentChain());
+
+    // Both conversions are indexed with the merged output, which pays the sum of their remainders
+    CAmount remainders{0};
+    for (const CTransactionRef& tx : conversions) {
+        ConversionIndexEntry entry;
+        BOOST_REQUIRE(conversion_index.FindConversion(tx->GetHash(), entry));
+        BOOST_CHECK_GT(entry.remainder, 0);
+        BOOST_CHECK_EQUAL(entry.coinbase_vout, 2);
+        remainders += entry.remainder;
+    }
+    BOOST_CHECK_EQUAL(coinbase_vout[2].nValue, remainders);
+
+    conversion_index.Stop();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <crypto/aes.h>
+#include <crypto/blake3.h>
+#include <crypto/blake3_header.h>
 #include <crypto/chacha20.h>
 #include <crypto/chacha_poly_aead.h>
 #include <crypto/hkdf_sha256_32.h>
@@ -20,6 +22,7 @@
 #include <test/util/setup_common.h>
 #include <util/strencodings.h>
 
+#include <algorithm>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -500,6 +503,35 @@ BOOST_AUTO_TEST_CASE(chacha20_testvector)
                  "fab78c9");
 }
 
+BOOST_AUTO_TEST_CASE(chacha20_multiblock)
+{
+    // Long inputs are processed 8 blocks at a time where the CPU supports it,
+    // which must match crypting them one block at a time, also across a carry
+    // of the block counter into its upper half.
+    const std::vector<unsigned char> key{ParseHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f")};
+    for (uint64_t seek : {uint64_t{0}, uint64_t{0xfffffffc}}) {
+        for (size_t len : {511, 512, 513, 1024 + 63, 4096}) {
+            std::vector<unsigned char> m(len), out(len), out_blockwise(len), stream(len), stream_blockwise(len);
+            for (size_t i = 0; i < len; ++i) m[i] = i * 13;
+            ChaCha20 ctx(key.data(), key.size()), ctx_blockwise(key.data(), key.size());
+            ctx.SetIV(0x4a000000UL);
+            ctx.Seek(seek);
+            ctx_blockwise.SetIV(0x4a000000UL);
+            ctx_blockwise.Seek(seek);
+            ctx.Crypt(m.data(), out.data(), len);
+            ctx.Keystream(stream.data(), len);
+            for (size_t pos = 0; pos < len; pos += 64) {
+                ctx_blockwise.Crypt(m.data() + pos, out_blockwise.data() + pos, std::min<size_t>(64, len - pos));
+            }
+            for (size_t pos = 0; pos < len; pos += 64) {
+                ctx_blockwise.Keystream(stream_blockwise.data() + pos, std::min<size_t>(64, len - pos));
+            }
+            BOOST_CHECK(out == out_blockwise);
+            BOOST_CHECK(stream == stream_blockwise);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(poly1305_testvector)
 {
     // RFC 7539, section 2.5.2.
@@ -753,6 +785,29 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256d_multi)
+{
+    // Messages around the one and two block padding boundaries, and longer
+    std::vector<std::vector<unsigned char>> messages;
+    for (size_t len : {0, 1, 32, 55, 56, 63, 64, 65, 119, 120, 128, 200, 1000}) {
+        for (int i = 0; i < 3; ++i) messages.push_back(g_insecure_rand_ctx.randbytes(len));
+    }
+    for (size_t count = 0; count <= messages.size(); ++count) {
+        std::vector<const unsigned char*> inputs;
+        std::vector<size_t> lengths;
+        for (size_t i = 0; i < count; ++i) {
+            inputs.push_back(messages[i].data());
+            lengths.push_back(messages[i].size());
+        }
+        std::vector<unsigned char> out1(32 * count), out2(32 * count);
+        for (size_t i = 0; i < count; ++i) {
+            CHash256().Write(messages[i]).Finalize({out1.data() + 32 * i, 32});
+        }
+        SHA256DMulti(out2.data(), inputs.data(), lengths.data(), count);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 static void TestSHA3_256(const std::string& input, const std::string& output)
 {
     const auto in_bytes = ParseHex(input);
@@ -947,4 +1002,81 @@ BOOST_AUTO_TEST_CASE(muhash_tests)
     BOOST_CHECK_EQUAL(HexStr(out4), "3a31e6903aff0de9f62f9a9f7f8b861de76ce2cda09822b90014319ae5dc2271");
 }
 
+BOOST_AUTO_TEST_CASE(muhash_inverse_tests)
+{
+    // Compare the safegcd inverse with exponentiation, which is only used without __int128
+    const auto check_inverse{[](const unsigned char (&data)[Num3072::BYTE_SIZE]) {
+        Num3072 x{data};
+        Num3072 inv{x.GetInverse()};
+        Num3072 inv_exp{x.GetInverseByExponentiation()};
+        unsigned char inv_bytes[Num3072::BYTE_SIZE], inv_exp_bytes[Num3072::BYTE_SIZE];
+        inv.ToBytes(inv_bytes);
+        inv_exp.ToBytes(inv_exp_bytes);
+        BOOST_CHECK_EQUAL(HexStr(inv_bytes), HexStr(inv_exp_bytes));
+
+        // Both are zero for zero, and the inverse for anything else
+        unsigned char expected[Num3072::BYTE_SIZE] = {0};
+        if (std::any_of(std::begin(data), std::end(data), [](unsigned char c) { return c != 0; })) {
+            x.Multiply(inv);
+            expected[0] = 1;
+        }
+        x.ToBytes(inv_bytes);
+        BOOST_CHECK_EQUAL(HexStr(inv_bytes), HexStr(expected));
+    }};
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    // 0, 1 and 2
+    for (unsigned char v = 0; v <= 2; ++v) {
+        std::fill(std::begin(data), std::end(data), 0);
+        data[0] = v;
+        check_inverse(data);
+    }
+    // The modulus 2^3072 - 1103717, minus 1 and 2
+    for (unsigned char v : {0x9a, 0x99}) {
+        std::fill(std::begin(data), std::end(data), 0xff);
+        data[0] = v;
+        data[1] = 0x28;
+        data[2] = 0xef;
+        check_inverse(data);
+    }
+    // Powers of two, including those around the 62-bit limbs of safegcd and the 64-bit limbs of Num3072
+    for (int bit : {61, 62, 63, 64, 124, 128, 3007, 3068, 3071}) {
+        std::fill(std::begin(data), std::end(data), 0);
+        data[bit / 8] = 1 << (bit % 8);
+        check_inverse(data);
+    }
+    // Random values, half of them below 2^3064
+    for (int i = 0; i < 64; ++i) {
+        const std::vector<unsigned char> rand{g_insecure_rand_ctx.randbytes(sizeof(data))};
+        std::copy(rand.begin(), rand.end(), data);
+        if (i & 1) data[Num3072::BYTE_SIZE - 1] = 0;
+        check_inverse(data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blake3_header_tests)
+{
+    for (int i = 0; i < 100; ++i) {
+        std::vector<unsigned char> header = g_insecure_rand_ctx.randbytes(CBlake3HeaderHasher::HEADER_SIZE);
+        const uint32_t nonce = InsecureRand32();
+
+        const CBlake3HeaderHasher hasher(header.data());
+        unsigned char midstate_hash[CBlake3HeaderHasher::OUTPUT_SIZE];
+        hasher.Finalize(nonce, midstate_hash);
+
+        WriteLE32(header.data() + CBlake3HeaderHasher::NONCE_OFFSET, nonce);
+        unsigned char hash[CBlake3HeaderHasher::OUTPUT_SIZE];
+        CBlake3HeaderHasher::Hash(header.data(), hash);
+
+        blake3_hasher reference;
+        blake3_hasher_init(&reference);
+        blake3_hasher_update(&reference, header.data(), header.size());
+        unsigned char reference_hash[BLAKE3_OUT_LEN];
+        blake3_hasher_finalize(&reference, reference_hash, BLAKE3_OUT_LEN);
+
+        BOOST_CHECK_EQUAL(HexStr(midstate_hash), HexStr(reference_hash));
+        BOOST_CHECK_EQUAL(HexStr(hash), HexStr(reference_hash));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -117,6 +117,47 @@ BOOST_AUTO_TEST_CASE(cuckoocache_hit_rate_ok)
     }
 }
 
+/** Check that sharding doesn't lower the hit rate */
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_hit_rate_ok)
+{
+    double HitRateThresh = 0.98;
+    size_t megabytes = 4;
+    for (double load = 0.1; load < 2; load *= 2) {
+        double hits = test_cache<CuckooCache::sharded_cache<uint256, SignatureCacheHasher>>(megabytes, load);
+        BOOST_CHECK(normalize_hit_rate(hits, load) > HitRateThresh);
+    }
+}
+
+/** Check that a sharded cache counts its hits, misses and evictions */
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_stats)
+{
+    SeedInsecureRand(SeedRand::ZEROS);
+    CuckooCache::sharded_cache<uint256, SignatureCacheHasher> cc{};
+    const auto setup_results{cc.setup_bytes(1 << 20)};
+    BOOST_REQUIRE(setup_results);
+    const uint32_t num_elems{setup_results->first};
+
+    std::vector<uint256> hashes;
+    for (uint32_t i = 0; i < num_elems / 2; ++i) {
+        hashes.push_back(InsecureRand256());
+        cc.insert(hashes.back());
+    }
+    BOOST_CHECK_EQUAL(cc.get_stats().evictions, 0U);
+    for (const uint256& h : hashes) {
+        BOOST_CHECK(cc.contains(h, false));
+        BOOST_CHECK(!cc.contains(InsecureRand256(), false));
+    }
+    BOOST_CHECK_EQUAL(cc.get_stats().hits, hashes.size());
+    BOOST_CHECK_EQUAL(cc.get_stats().misses, hashes.size());
+
+    // Inserting many more elements than fit eventually runs out of free slots. Most old elements are
+    // garbage collected instead of evicted, so it takes a while.
+    for (uint32_t i = 0; i < 8 * num_elems; ++i) {
+        cc.insert(InsecureRand256());
+    }
+    BOOST_CHECK(cc.get_stats().evictions > 0);
+}
+
 
 /** This helper checks that erased elements are preferentially inserted onto and
  * that the hit rate of "fresher" keys is reasonable*/
@@ -41,6 +41,34 @@ BOOST_AUTO_TEST_CASE(dbwrapper)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_tuning)
+{
+    // The write buffers get what the block cache leaves, unless a size is given
+    CDBWrapper default_dbw(m_args.GetDataDirBase() / "dbwrapper_tuning_default", (1 << 20), true, false);
+    BOOST_CHECK_EQUAL(default_dbw.CacheSize(), 1U << 20);
+    BOOST_CHECK_EQUAL(default_dbw.Tuning().block_cache_percent, 50);
+    BOOST_CHECK_EQUAL(default_dbw.Tuning().bloom_bits, 10);
+    BOOST_CHECK_EQUAL(default_dbw.Tuning().write_buffer_size, 1U << 18);
+
+    DBTuning tuning;
+    tuning.block_cache_percent = 100;
+    tuning.bloom_bits = 0;
+    tuning.write_buffer_size = 1 << 16;
+    CDBWrapper dbw(m_args.GetDataDirBase() / "dbwrapper_tuning", (1 << 20), true, false, false, tuning);
+    BOOST_CHECK_EQUAL(dbw.Tuning().write_buffer_size, 1U << 16);
+
+    // Reads work without a bloom filter
+    uint8_t key{'k'};
+    uint256 in = InsecureRand256();
+    uint256 res;
+    BOOST_CHECK(dbw.Write(key, in));
+    BOOST_CHECK(dbw.Read(key, res));
+    BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+    BOOST_CHECK(!dbw.Exists(uint8_t{'x'}));
+    BOOST_CHECK(dbw.GetProperty("leveldb.stats").has_value());
+    BOOST_CHECK(!dbw.GetProperty("leveldb.unknown").has_value());
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_basic_data)
 {
     // Perform tests both obfuscated and non-obfuscated.
@@ -533,4 +533,33 @@ BOOST_AUTO_TEST_CASE(descriptor_test)
     Check("sh(wsh(thresh(1,pkh(L4gM1FBdyHNpkzsFh9ipnofLhpZRp2mwobpeULy1a6dBTvw8Ywtd),a:and_n(multi(1,xprvA1RpRA33e1JQ7ifknakTFpgNXPmW2YvmhqLQYMmrj4xJXXWYpDPS3xz7iAxn8L39njGVyuoseXzU6rcxFLJ8HFsTjSyQbLYnMpCqE2VbFWc,xprv9uPDJpEQgRQfDcW7BkF7eTya6RPxXeJCqCJGHuCJ4GiRVLzkTXBAJMu2qaMWPrS7AANYqdq6vcBcBUdJCVVFceUvJFjaPdGZ2y9WACViL4L/0),n:older(2)))))", "sh(wsh(thresh(1,pkh(03cdabb7f2dce7bfbd8a0b9570c6fd1e712e5d64045e9d6b517b3d5072251dc204),a:and_n(multi(1,xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4koxb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL,xpub68NZiKmJWnxxS6aaHmn81bvJeTESw724CRDs6HbuccFQN9Ku14VQrADWgqbhhTHBaohPX4CjNLf9fq9MYo6oDaPPLPxSb7gwQN3ih19Zm4Y/0),n:older(2)))))", "sh(wsh(thresh(1,pkh(03cdabb7f2dce7bfbd8a0b9570c6fd1e712e5d64045e9d6b517b3d5072251dc204),a:and_n(multi(1,xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4koxb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL,xpub68NZiKmJWnxxS6aaHmn81bvJeTESw724CRDs6HbuccFQN9Ku14VQrADWgqbhhTHBaohPX4CjNLf9fq9MYo6oDaPPLPxSb7gwQN3ih19Zm4Y/0),n:older(2)))))", UNSOLVABLE | MIXED_PUBKEYS, {{"a914767e9119ff3b3ac0cb6dcfe21de1842ccf85f1c487"}}, OutputType::P2SH_SEGWIT, {{},{0}});
 }
 
+BOOST_AUTO_TEST_CASE(descriptor_expand_range)
+{
+    FlatSigningProvider keys;
+    std::string error;
+    auto desc = Parse("wsh(multi(1,xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4koxb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL/1/*,xpub68NZiKmJWnxxS6aaHmn81bvJeTESw724CRDs6HbuccFQN9Ku14VQrADWgqbhhTHBaohPX4CjNLf9fq9MYo6oDaPPLPxSb7gwQN3ih19Zm4Y/*))", keys, error);
+    BOOST_REQUIRE(desc);
+
+    // A range expanded on several threads matches expanding it one position at a time
+    const int begin{5}, end{5 + 2 * MIN_PARALLEL_EXPAND_RANGE};
+    std::vector<std::vector<CScript>> range_scripts;
+    FlatSigningProvider range_out;
+    BOOST_REQUIRE(ExpandRange(*desc, begin, end, keys, range_scripts, range_out));
+    BOOST_REQUIRE_EQUAL(range_scripts.size(), size_t(end - begin + 1));
+    FlatSigningProvider out;
+    for (int i = begin; i <= end; ++i) {
+        std::vector<CScript> scripts;
+        BOOST_REQUIRE(desc->Expand(i, keys, scripts, out));
+        BOOST_CHECK(scripts == range_scripts[i - begin]);
+    }
+    BOOST_CHECK(out.pubkeys == range_out.pubkeys);
+    BOOST_CHECK(out.scripts == range_out.scripts);
+    BOOST_CHECK(out.origins == range_out.origins);
+
+    // Hardened derivation steps still need the private key
+    auto hardened = Parse("wpkh(xpub6ERApfZwUNrhLCkDtcHTcxd75RbzS1ed54G1LkBUHQVHQKqhMkhgbmJbZRkrgZw4koxb5JaHWkY4ALHY2grBGRjaDMzQLcgJvLJuZZvRcEL/*')", keys, error);
+    BOOST_REQUIRE(hardened);
+    BOOST_CHECK(!ExpandRange(*hardened, 0, 2 * MIN_PARALLEL_EXPAND_RANGE, keys, range_scripts, range_out));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -123,4 +123,118 @@ BOOST_AUTO_TEST_CASE(flatfile_flush)
     BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(0, 1))), 1U);
 }
 
+BOOST_AUTO_TEST_CASE(flatfile_compress)
+{
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+    const FlatFilePos pos(0, 0);
+
+    // Enough data for several compressed chunks, followed by pre-allocated space
+    std::vector<unsigned char> data(FLATFILE_COMPRESSED_CHUNK_SIZE * 2 + 1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = i % 64 < 32 ? InsecureRandBits(8) : data[i / 2];
+    }
+    {
+        CAutoFile file(seq.Open(pos), SER_DISK, CLIENT_VERSION);
+        file.write(MakeByteSpan(data));
+    }
+    bool out_of_space;
+    seq.Allocate(FlatFilePos(0, data.size()), 1, out_of_space);
+
+    // Discarded copies leave the file as is
+    uint64_t compressed_size;
+    BOOST_CHECK(!seq.WriteCompressed(pos, fs::file_size(seq.FileName(pos)) + 1, compressed_size));
+    BOOST_REQUIRE(seq.WriteCompressed(pos, data.size(), compressed_size));
+    BOOST_CHECK(seq.CommitCompressed(pos, false));
+    BOOST_CHECK(!seq.IsCompressed(pos));
+
+    BOOST_REQUIRE(seq.WriteCompressed(pos, data.size(), compressed_size));
+    BOOST_CHECK_LT(compressed_size, data.size());
+    BOOST_REQUIRE(seq.CommitCompressed(pos, true));
+    BOOST_CHECK(seq.IsCompressed(pos));
+    BOOST_CHECK(!fs::exists(seq.FileName(pos)));
+    BOOST_CHECK_EQUAL(fs::file_size(seq.CompressedFileName(pos)), compressed_size);
+    BOOST_CHECK(seq.Flush(pos, true));
+
+#ifdef HAVE_FOPENCOOKIE
+    // Positions within the file are read in place, across chunk boundaries
+    for (const size_t offset : {size_t{0}, size_t{FLATFILE_COMPRESSED_CHUNK_SIZE - 10}, data.size() - 10}) {
+        CAutoFile file(seq.Open(FlatFilePos(0, offset), true), SER_DISK, CLIENT_VERSION);
+        std::vector<unsigned char> read(std::min<size_t>(1000, data.size() - offset));
+        file.read(MakeWritableByteSpan(read));
+        BOOST_CHECK(std::equal(read.begin(), read.end(), data.begin() + offset));
+    }
+    {
+        CAutoFile file(seq.Open(FlatFilePos(0, data.size()), true), SER_DISK, CLIENT_VERSION);
+        uint8_t byte;
+        BOOST_CHECK_THROW(file >> byte, std::ios_base::failure);
+    }
+    BOOST_CHECK(seq.IsCompressed(pos));
+#endif
+
+    // Writing to the file decompresses it again
+    const std::vector<unsigned char> more{1, 2, 3};
+    {
+        CAutoFile file(seq.Open(FlatFilePos(0, data.size())), SER_DISK, CLIENT_VERSION);
+        file.write(MakeByteSpan(more));
+    }
+    BOOST_CHECK(!seq.IsCompressed(pos));
+    BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(pos)), data.size() + more.size());
+    {
+        CAutoFile file(seq.Open(pos, true), SER_DISK, CLIENT_VERSION);
+        std::vector<unsigned char> read(data.size());
+        file.read(MakeWritableByteSpan(read));
+        BOOST_CHECK(read == data);
+    }
+
+    BOOST_REQUIRE(seq.WriteCompressed(pos, data.size() + more.size(), compressed_size));
+    BOOST_REQUIRE(seq.CommitCompressed(pos, true));
+    seq.Remove(pos);
+    BOOST_CHECK(!seq.IsCompressed(pos));
+    BOOST_CHECK(!fs::exists(seq.FileName(pos)));
+}
+
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(flatfile_mapping)
+{
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+    const fs::path path{seq.FileName(FlatFilePos(0, 0))};
+
+    // Empty and missing files can't be mapped
+    BOOST_CHECK(FlatFileMapping(path).IsNull());
+    fclose(seq.Open(FlatFilePos(0, 0)));
+    BOOST_CHECK(FlatFileMapping(path).IsNull());
+
+    const std::vector<unsigned char> data1{1, 2, 3, 4};
+    const std::vector<unsigned char> data2{5, 6};
+    {
+        CAutoFile file(seq.Open(FlatFilePos(0, 0)), SER_DISK, CLIENT_VERSION);
+        file.write(MakeByteSpan(data1));
+    }
+
+    FlatFileMappingCache cache{1};
+    const auto mapping1{cache.Get(path, data1.size())};
+    BOOST_REQUIRE(mapping1);
+    BOOST_CHECK(std::equal(data1.begin(), data1.end(), mapping1->Data().begin(), mapping1->Data().end()));
+    BOOST_CHECK_EQUAL(cache.Get(path, data1.size()), mapping1);
+    BOOST_CHECK(!cache.Get(path, data1.size() + data2.size()));
+
+    // The file is mapped again once it has grown
+    {
+        CAutoFile file(seq.Open(FlatFilePos(0, data1.size())), SER_DISK, CLIENT_VERSION);
+        file.write(MakeByteSpan(data2));
+    }
+    const auto mapping2{cache.Get(path, data1.size() + data2.size())};
+    BOOST_REQUIRE(mapping2);
+    BOOST_CHECK(mapping2 != mapping1);
+    BOOST_CHECK_EQUAL(mapping2->Data()[data1.size()], data2[0]);
+
+    // Mappings stay readable after being invalidated
+    cache.Invalidate(path);
+    BOOST_CHECK(cache.Get(path, 1) != mapping2);
+    BOOST_CHECK_EQUAL(mapping1->Data()[0], data1[0]);
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
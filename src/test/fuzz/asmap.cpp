@@ -2,11 +2,15 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <crypto/common.h>
 #include <netaddress.h>
 #include <netgroup.h>
 #include <test/fuzz/fuzz.h>
 #include <util/asmap.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstdint>
 #include <vector>
 
@@ -59,4 +63,18 @@ FUZZ_TARGET(asmap)
     }
     NetGroupManager netgroupman{asmap};
     (void)netgroupman.GetMappedAS(net_addr);
+
+    // The compiled asmap must map the input bits like the interpreter
+    std::array<uint8_t, ADDR_IPV6_SIZE> ip;
+    if (ipv6) {
+        std::copy(addr_data, addr_data + ADDR_IPV6_SIZE, ip.begin());
+    } else {
+        std::copy(IPV4_IN_IPV6_PREFIX.begin(), IPV4_IN_IPV6_PREFIX.end(), ip.begin());
+        std::copy(addr_data, addr_data + ADDR_IPV4_SIZE, ip.begin() + IPV4_IN_IPV6_PREFIX.size());
+    }
+    std::vector<bool> ip_bits(128);
+    for (size_t i = 0; i < ip_bits.size(); ++i) {
+        ip_bits[i] = (ip[i / 8] >> (7 - i % 8)) & 1;
+    }
+    assert(Interpret(asmap, ip_bits) == InterpretCompiled(CompileAsmap(asmap), ReadBE64(ip.data()), ReadBE64(ip.data() + 8)));
 }
@@ -0,0 +1,74 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/amount.h>
+#include <consensus/conversion.h>
+#include <consensus/invariant.h>
+#include <consensus/tx_verify.h>
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+using namespace boost::multiprecision;
+
+namespace {
+/** Reference implementation of Consensus::IsValidConversion using arbitrary precision arithmetic. */
+bool ReferenceIsValidConversion(CAmounts& totalSupply, const CAmounts inputs, const CAmounts minOutputs, const CAmountType remainderType, CAmount& remainder)
+{
+    int128_t invariant_sq_in = pow((int128_t)totalSupply[CASH], 2) + pow((int128_t)totalSupply[BOND], 2);
+    int128_t invariant_sq_min_out = pow((int128_t)(totalSupply[CASH] + minOutputs[CASH] - inputs[CASH]), 2) + pow((int128_t)(totalSupply[BOND] + minOutputs[BOND] - inputs[BOND]), 2);
+    if (invariant_sq_min_out > invariant_sq_in) {
+        return false;
+    }
+    remainder = (sqrt(invariant_sq_in - pow((int128_t)(totalSupply[!remainderType] + minOutputs[!remainderType] - inputs[!remainderType]), 2)) - (int128_t)(totalSupply[remainderType] + minOutputs[remainderType] - inputs[remainderType])).convert_to<CAmount>();
+    totalSupply[CASH] += (minOutputs[CASH] - inputs[CASH]);
+    totalSupply[BOND] += (minOutputs[BOND] - inputs[BOND]);
+    totalSupply[remainderType] += remainder;
+    return true;
+}
+} // namespace
+
+FUZZ_TARGET(conversion)
+{
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+
+    const uint64_t n = fuzzed_data_provider.ConsumeIntegral<uint64_t>();
+    const CAmountSquare n_sq = static_cast<CAmountSquare>(n) * n;
+    assert(ISqrt(n_sq) == n);
+    if (n > 0) assert(ISqrt(n_sq - 1) == n - 1);
+
+    const CAmounts totalSupply{fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(0, MAX_MONEY), fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(0, MAX_MONEY)};
+    const CAmountType inputType = fuzzed_data_provider.ConsumeBool() ? CASH : BOND;
+    CAmounts inputs{0}, minOutputs{0};
+    inputs[inputType] = fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(0, MAX_MONEY);
+    minOutputs[!inputType] = fuzzed_data_provider.ConsumeBool() ?
+        CalculateOutputAmount(totalSupply, inputs[inputType], inputType) - fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(-1, COIN) :
+        fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(0, MAX_MONEY);
+    minOutputs[inputType] = fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(0, inputs[inputType]);
+    const CAmountType remainderType = fuzzed_data_provider.ConsumeBool() ? CASH : BOND;
+
+    CAmounts supply = totalSupply, reference_supply = totalSupply;
+    CAmount remainder{0}, reference_remainder{0};
+    const bool valid = Consensus::IsValidConversion(supply, inputs, minOutputs, remainderType, remainder);
+    const bool reference_valid = ReferenceIsValidConversion(reference_supply, inputs, minOutputs, remainderType, reference_remainder);
+    assert(valid == reference_valid);
+    assert(remainder == reference_remainder);
+    assert(supply == reference_supply);
+
+    // The precomputed conversion rate matches GetConvertedAmount() exactly
+    const ConversionRate conversion_rate{totalSupply};
+    const CAmount amount = fuzzed_data_provider.ConsumeIntegral<CAmount>();
+    const CAmountType amountType = fuzzed_data_provider.ConsumeBool() ? CASH : BOND;
+    const CAmount converted = GetConvertedAmount(totalSupply, amount, amountType);
+    assert(conversion_rate.Convert(amount, amountType) == converted);
+    if (totalSupply[CASH] > 0 && totalSupply[BOND] > 0 && converted < std::numeric_limits<CAmount>::max()) {
+        assert(conversion_rate.Convert(amount, amountType, /*roundedUp=*/true) == converted + 1);
+    }
+}
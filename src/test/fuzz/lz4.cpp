@@ -0,0 +1,27 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <util/compression.h>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+FUZZ_TARGET(lz4)
+{
+    FuzzedDataProvider fuzzed_data_provider{buffer.data(), buffer.size()};
+
+    // Arbitrary input is either rejected or decompressed to exactly the given size
+    std::vector<std::byte> out(fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 1 << 16));
+    const std::vector<std::byte> compressed{fuzzed_data_provider.ConsumeBytes<std::byte>(fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, 1 << 16))};
+    (void)LZ4Decompress(compressed, out);
+
+    // Any data round-trips
+    const std::vector<std::byte> data{fuzzed_data_provider.ConsumeRemainingBytes<std::byte>()};
+    std::vector<std::byte> decompressed(data.size());
+    assert(LZ4Decompress(LZ4Compress(data), decompressed));
+    assert(decompressed == data);
+}
@@ -74,6 +74,7 @@ const std::vector<std::string> RPC_COMMANDS_NOT_SAFE_FOR_FUZZING{
     "dumptxoutset",   // avoid writing to disk
     "dumpwallet", // avoid writing to disk
     "echoipc",              // avoid assertion failure (Assertion `"EnsureAnyNodeContext(request.context).init" && check' failed.)
+    "generateemptyblocks",  // avoid prohibitively slow execution (when `nblocks` is large)
     "generatetoaddress",    // avoid prohibitively slow execution (when `num_blocks` is large)
     "generatetodescriptor", // avoid prohibitively slow execution (when `nblocks` is large)
     "gettxoutproof",        // avoid prohibitively slow execution
@@ -102,6 +103,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "echo",
     "echojson",
     "estimaterawfee",
+    "estimateconversions",
     "estimatesmartfee",
     "finalizepsbt",
     "generate",
@@ -116,15 +118,23 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getblockheader",
     "getblockfrompeer", // when no peers are connected, no p2p message is sent
     "getblockstats",
+    "getblockstatsrange",
     "getblocktemplate",
+    "getcacheinfo",
     "getchaintips",
     "getchaintxstats",
     "getconnectioncount",
+    "getconversion",
+    "getconversionbook",
+    "getconversionstats",
+    "getdbinfo",
     "getdeploymentinfo",
     "getdescriptorinfo",
     "getdifficulty",
     "getindexinfo",
+    "getlockstats",
     "getmemoryinfo",
+    "getmemoryusage",
     "getmempoolancestors",
     "getmempooldescendants",
     "getmempoolentry",
@@ -139,12 +149,17 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getrawmempool",
     "getrawtransaction",
     "getrpcinfo",
+    "getschedulerinfo",
+    "getthreadpoolinfo",
     "gettxout",
+    "gettxouts",
     "gettxoutsetinfo",
+    "getvalidationstats",
     "help",
     "invalidateblock",
     "joinpsbts",
     "listbanned",
+    "listconversions",
     "logging",
     "mockscheduler",
     "ping",
@@ -159,6 +174,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "signrawtransactionwithkey",
     "submitblock",
     "submitheader",
+    "submittemplateblock",
     "submitpackage",
     "syncwithvalidationinterfacequeue",
     "testmempoolaccept",
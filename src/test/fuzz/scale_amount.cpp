@@ -0,0 +1,54 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/amount.h>
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+using namespace boost::multiprecision;
+
+namespace {
+/** Reference implementation of ScaleAmount using arbitrary precision arithmetic. */
+CAmount ReferenceScaleAmount(const CAmount& nValue, const CAmountScaleFactor& scaleFactor)
+{
+    return ((int256_t)nValue * (int256_t)scaleFactor / ((int256_t)BASE_FACTOR)).convert_to<CAmount>();
+}
+
+/** Reference implementation of DescaleAmount using arbitrary precision arithmetic. */
+CAmount ReferenceDescaleAmount(const CAmount& scaledValue, const CAmountScaleFactor& scaleFactor)
+{
+    CAmount baseAmount = ((int256_t)scaledValue * (int256_t)BASE_FACTOR / ((int256_t)scaleFactor)).convert_to<CAmount>();
+    while (ReferenceScaleAmount(baseAmount, scaleFactor) < scaledValue) {
+        baseAmount++;
+    }
+    return baseAmount;
+}
+} // namespace
+
+FUZZ_TARGET(scale_amount)
+{
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+    const CAmount amount = fuzzed_data_provider.ConsumeBool() ?
+        fuzzed_data_provider.ConsumeIntegralInRange<CAmount>(-MAX_MONEY, MAX_MONEY) :
+        fuzzed_data_provider.ConsumeIntegral<CAmount>();
+    const CAmountScaleFactor scale_factor = fuzzed_data_provider.ConsumeBool() ?
+        fuzzed_data_provider.ConsumeIntegralInRange<CAmountScaleFactor>(BASE_FACTOR, 2 * BASE_FACTOR) :
+        fuzzed_data_provider.ConsumeIntegralInRange<CAmountScaleFactor>(1, std::numeric_limits<CAmountScaleFactor>::max());
+
+    assert(ScaleAmount(amount, scale_factor) == ReferenceScaleAmount(amount, scale_factor));
+
+    // The reference implementation is only well-defined if some amount scales to at least the target.
+    if (ReferenceScaleAmount(std::numeric_limits<CAmount>::max(), scale_factor) >= amount) {
+        const CAmount descaled = DescaleAmount(amount, scale_factor);
+        assert(descaled == ReferenceDescaleAmount(amount, scale_factor));
+        assert(ScaleAmount(descaled, scale_factor) >= amount);
+    }
+}
@@ -206,7 +206,7 @@ FUZZ_TARGET_INIT(tx_pool_standard, initialize_tx_pool)
                 in.prevout = outpoint;
                 in.nSequence = sequence;
                 in.scriptSig = script_sig;
-                in.scriptWitness.stack = script_wit_stack;
+                in.scriptWitness.stack.assign(script_wit_stack.begin(), script_wit_stack.end());
 
                 tx_mut.vin.push_back(in);
             }
@@ -68,6 +68,15 @@ ssize_t FuzzedSock::Send(const void* data, size_t len, int flags) const
     return r;
 }
 
+ssize_t FuzzedSock::SendMany(Span<const Span<const unsigned char>> buffers, int flags) const
+{
+    size_t len{0};
+    for (const auto& buffer : buffers.first(std::min(buffers.size(), MAX_SEND_MANY_BUFFERS))) {
+        len += buffer.size();
+    }
+    return Send(nullptr, len, flags);
+}
+
 ssize_t FuzzedSock::Recv(void* buf, size_t len, int flags) const
 {
     // Have a permanent error at recv_errnos[0] because when the fuzzed data is exhausted
@@ -331,7 +340,7 @@ CMutableTransaction ConsumeTransaction(FuzzedDataProvider& fuzzed_data_provider,
         const auto script_sig = p2wsh_op_true ? CScript{} : ConsumeScript(fuzzed_data_provider);
         CScriptWitness script_wit;
         if (p2wsh_op_true) {
-            script_wit.stack = std::vector<std::vector<uint8_t>>{WITNESS_STACK_ELEM_OP_TRUE};
+            script_wit.stack = {WITNESS_STACK_ELEM_OP_TRUE};
         } else {
             script_wit = ConsumeScriptWitness(fuzzed_data_provider);
         }
@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <consensus/amount.h>
 #include <consensus/params.h>
 #include <headerssync.h>
 #include <pow.h>
@@ -47,6 +48,8 @@ void HeadersGeneratorSetup::GenerateHeaders(std::vector<CBlockHeader>& headers,
         next_header.hashMerkleRoot = merkle_root;
         next_header.nTime = prev_time+1;
         next_header.nBits = nBits;
+        next_header.cashSupply = headers.size() * COIN;
+        next_header.bondSupply = headers.size() * COIN / 2;
 
         FindProofOfWork(next_header);
         prev_hash = next_header.GetHash();
@@ -118,6 +121,8 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(!result.request_more);
     // All headers should be ready for acceptance:
     BOOST_CHECK(result.pow_validated_headers.size() == first_chain.size());
+    // ...and reconstructed exactly, including the supply fields:
+    BOOST_CHECK(result.pow_validated_headers.back().GetHash() == first_chain.back().GetHash());
     // Nothing left for the sync logic to do:
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::FINAL);
 
@@ -6,11 +6,13 @@
 #include <logging.h>
 #include <logging/timer.h>
 #include <test/util/setup_common.h>
+#include <util/strencodings.h>
 #include <util/string.h>
 
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -138,6 +140,68 @@ BOOST_FIXTURE_TEST_CASE(logging_LogPrintMacros, LogSetup)
     BOOST_CHECK_EQUAL_COLLECTIONS(log_lines.begin(), log_lines.end(), expected.begin(), expected.end());
 }
 
+BOOST_FIXTURE_TEST_CASE(logging_Async, LogSetup)
+{
+    LogInstance().StartAsyncWriter();
+    LogPrintf("foo12: %s\n", "bar12");
+    std::thread thread{[] {
+        for (int i = 0; i < 100; ++i) LogPrintf("thread: %d\n", i);
+    }};
+    LogPrintLevel(BCLog::NET, BCLog::Level::Warning, "foo13: %s\n", "bar13");
+    thread.join();
+    LogPrintfCategory(BCLog::VALIDATION, "foo14: %s\n", "bar14");
+    LogInstance().StopAsyncWriter();
+
+    // Messages of one thread are written in order
+    std::ifstream file{tmp_log_path};
+    std::vector<std::string> log_lines;
+    std::vector<std::string> thread_lines;
+    for (std::string log; std::getline(file, log);) {
+        (log.rfind("thread: ", 0) == 0 ? thread_lines : log_lines).push_back(log);
+    }
+    std::vector<std::string> expected = {
+        "foo12: bar12",
+        "[net:warning] foo13: bar13",
+        "[validation] foo14: bar14",
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(log_lines.begin(), log_lines.end(), expected.begin(), expected.end());
+    std::vector<std::string> expected_thread;
+    for (int i = 0; i < 100; ++i) expected_thread.push_back(strprintf("thread: %d", i));
+    BOOST_CHECK_EQUAL_COLLECTIONS(thread_lines.begin(), thread_lines.end(), expected_thread.begin(), expected_thread.end());
+
+    // Logging is synchronous again
+    LogPrintf("foo15: %s\n", "bar15");
+    file.clear();
+    std::getline(file, log_lines.emplace_back());
+    BOOST_CHECK_EQUAL(log_lines.back(), "foo15: bar15");
+}
+
+BOOST_FIXTURE_TEST_CASE(logging_AsyncDrop, LogSetup)
+{
+    // A tiny buffer makes the writer fall behind
+    LogInstance().StartAsyncWriter(/*buffer_messages=*/2);
+    const uint64_t dropped_before{LogInstance().DroppedMessages()};
+    for (int i = 0; i < 1000; ++i) LogPrint(BCLog::NET, "foo16: %d\n", i);
+    LogInstance().StopAsyncWriter();
+    const uint64_t dropped{LogInstance().DroppedMessages() - dropped_before};
+
+    // Every message is either written or counted, and the drops are reported
+    std::ifstream file{tmp_log_path};
+    uint64_t written{0};
+    uint64_t reported{0};
+    const std::string drop_prefix{"[warning] Dropped "};
+    for (std::string log; std::getline(file, log);) {
+        if (log.rfind("[net] foo16: ", 0) == 0) ++written;
+        if (log.rfind(drop_prefix, 0) == 0) {
+            const auto count{ToIntegral<uint64_t>(log.substr(drop_prefix.size(), log.find(' ', drop_prefix.size()) - drop_prefix.size()))};
+            BOOST_REQUIRE(count);
+            reported += *count;
+        }
+    }
+    BOOST_CHECK_EQUAL(written + dropped, 1000U);
+    BOOST_CHECK_EQUAL(reported, dropped);
+}
+
 BOOST_FIXTURE_TEST_CASE(logging_LogPrintMacros_CategoryName, LogSetup)
 {
     LogInstance().EnableCategory(BCLog::LogFlags::ALL);
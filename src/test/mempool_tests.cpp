@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <consensus/conversion.h>
 #include <policy/policy.h>
 #include <txmempool.h>
 #include <interfaces/chain.h>
@@ -11,6 +12,7 @@
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
+#include <limits>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -396,11 +398,6 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
     CheckSort<ancestor_score>(pool, sortedOrder);
 
     // TODO: Test for expired transactions
-    const auto dummy_filter_expired = [](CTxMemPool::txiter it)
-        EXCLUSIVE_LOCKS_REQUIRED(pool.cs, ::cs_main) {
-        // Transaction is not a conversion or conversion has not expired
-        return false;
-    };
     const auto dummy_filter_invalid = [](CTxMemPool::txiter it)
         EXCLUSIVE_LOCKS_REQUIRED(pool.cs, ::cs_main) {
         // Transaction is not a conversion or conversion has not expired
@@ -410,7 +407,7 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
     /* after tx6 is mined, tx7 should move up in the sort */
     std::vector<CTransactionRef> vtx;
     vtx.push_back(MakeTransactionRef(tx6));
-    pool.removeForBlock(vtx, 1, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+    pool.removeForBlock(vtx, 1, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
 
     sortedOrder.erase(sortedOrder.begin()+1);
     // Ties are broken by hash
@@ -566,11 +563,6 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     pool.addUnchecked(entry.Fee(9000LL).FromTx(tx7));
 
     // TODO: Test for expired transactions
-    const auto dummy_filter_expired = [](CTxMemPool::txiter it)
-        EXCLUSIVE_LOCKS_REQUIRED(pool.cs, ::cs_main) {
-        // Transaction is not a conversion or conversion has not expired
-        return false;
-    };
     const auto dummy_filter_invalid = [](CTxMemPool::txiter it)
         EXCLUSIVE_LOCKS_REQUIRED(pool.cs, ::cs_main) {
         // Transaction is not a conversion or conversion has not expired
@@ -582,7 +574,7 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     SetMockTime(42 + CTxMemPool::ROLLING_FEE_HALFLIFE);
     BOOST_CHECK_EQUAL(pool.GetMinFee(1).GetFeePerK(), maxFeeRateRemoved.GetFeePerK() + 1000);
     // ... we should keep the same min fee until we get a block
-    pool.removeForBlock(vtx, 1, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+    pool.removeForBlock(vtx, 1, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
     SetMockTime(42 + 2*CTxMemPool::ROLLING_FEE_HALFLIFE);
     BOOST_CHECK_EQUAL(pool.GetMinFee(1).GetFeePerK(), llround((maxFeeRateRemoved.GetFeePerK() + 1000)/2.0));
     // ... then feerate should drop 1/2 each halflife
@@ -825,4 +817,348 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTestsDiamond)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolEntryLinksTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Parents and children are kept sorted by txid as they are added and removed
+    const CTransactionRef parent = make_tx(/*output_values=*/std::vector<CAmount>(8, COIN));
+    pool.addUnchecked(entry.FromTx(parent));
+    std::vector<CTransactionRef> children;
+    for (uint32_t i = 0; i < 8; ++i) {
+        children.push_back(make_tx(/*output_values=*/{COIN / 2}, /*inputs=*/{parent}, /*input_indices=*/{i}));
+        pool.addUnchecked(entry.FromTx(children.back()));
+    }
+    const CTransactionRef grandchild = make_tx(/*output_values=*/{COIN / 2}, /*inputs=*/{children[0], children[1]}, /*input_indices=*/{0, 0});
+    pool.addUnchecked(entry.FromTx(grandchild));
+
+    const auto is_sorted = [](const std::vector<CTxMemPoolEntry::CTxMemPoolEntryRef>& refs) {
+        return std::is_sorted(refs.begin(), refs.end(), CompareIteratorByHash{});
+    };
+    const auto parent_it = pool.GetIter(parent->GetHash()).value();
+    BOOST_CHECK_EQUAL(parent_it->GetMemPoolChildrenConst().size(), 8U);
+    BOOST_CHECK(is_sorted(parent_it->GetMemPoolChildrenConst()));
+    const auto grandchild_it = pool.GetIter(grandchild->GetHash()).value();
+    BOOST_CHECK_EQUAL(grandchild_it->GetMemPoolParentsConst().size(), 2U);
+    BOOST_CHECK(is_sorted(grandchild_it->GetMemPoolParentsConst()));
+
+    pool.removeRecursive(*children[1], REMOVAL_REASON_DUMMY);
+    BOOST_CHECK_EQUAL(pool.size(), 8U);
+    BOOST_CHECK_EQUAL(parent_it->GetMemPoolChildrenConst().size(), 7U);
+    BOOST_CHECK(is_sorted(parent_it->GetMemPoolChildrenConst()));
+    for (const CTxMemPoolEntry& child : parent_it->GetMemPoolChildrenConst()) {
+        BOOST_CHECK(child.GetTx().GetHash() != children[1]->GetHash());
+        BOOST_CHECK_EQUAL(child.GetMemPoolParentsConst().size(), 1U);
+        BOOST_CHECK(child.GetConversionInfo() == nullptr);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MempoolRelayOrderTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(::cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Two unrelated parents with different fees, and a child of the cheaper one with the highest fee
+    const CTransactionRef cheap = make_tx(/*output_values=*/{COIN});
+    pool.addUnchecked(entry.Fee(1000).FromTx(cheap));
+    const CTransactionRef expensive = make_tx(/*output_values=*/{2 * COIN});
+    pool.addUnchecked(entry.Fee(2000).FromTx(expensive));
+    CMutableTransaction witness_child{*make_tx(/*output_values=*/{COIN / 2}, /*inputs=*/{cheap})};
+    witness_child.vin[0].scriptWitness.stack.push_back({1});
+    pool.addUnchecked(entry.Fee(10000).FromTx(witness_child));
+    const CTransaction child{witness_child};
+
+    const auto order{pool.GetRelayOrder()};
+    BOOST_CHECK_EQUAL(order->sequence, pool.GetSequence());
+    const auto position = [&](const uint256& hash) { return order->positions.at(hash); };
+    BOOST_CHECK_LT(position(expensive->GetHash()), position(cheap->GetHash()));
+    BOOST_CHECK_LT(position(cheap->GetHash()), position(child.GetHash()));
+    BOOST_CHECK_EQUAL(position(child.GetWitnessHash()), position(child.GetHash()));
+    // The positions agree with CompareDepthAndScore
+    for (const uint256& a : {cheap->GetWitnessHash(), expensive->GetWitnessHash(), child.GetWitnessHash()}) {
+        for (const uint256& b : {cheap->GetWitnessHash(), expensive->GetWitnessHash(), child.GetWitnessHash()}) {
+            if (a != b) BOOST_CHECK_EQUAL(pool.CompareDepthAndScore(a, b, /*wtxid=*/true), position(a) < position(b));
+        }
+    }
+
+    // Transactions added after the order was taken are not in it
+    const CTransactionRef grandchild = make_tx(/*output_values=*/{COIN / 4}, /*inputs=*/{MakeTransactionRef(child)});
+    pool.addUnchecked(entry.Fee(1000).FromTx(grandchild));
+    BOOST_CHECK_EQUAL(order->positions.count(grandchild->GetHash()), 0U);
+    BOOST_CHECK(pool.GetRelayOrder()->positions.count(grandchild->GetHash()));
+
+    const std::vector<uint64_t> expected_counts{1, 2, 3, 0};
+    BOOST_CHECK(pool.GetAncestorCounts({cheap->GetHash(), child.GetHash(), grandchild->GetHash(), uint256::ONE}, /*wtxid=*/false) == expected_counts);
+    BOOST_CHECK(pool.GetAncestorCounts({cheap->GetWitnessHash(), child.GetWitnessHash(), grandchild->GetWitnessHash(), uint256::ONE}, /*wtxid=*/true) == expected_counts);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolNormalizedFeesTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // [tx_grandparent] <- [tx_parent (bond fee)] <- [tx_child]    [tx_unrelated]
+    CTransactionRef tx_grandparent = make_tx(/*output_values=*/{10 * COIN});
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(tx_grandparent));
+    CTransactionRef tx_parent = make_tx(/*output_values=*/{10 * COIN}, /*inputs=*/{tx_grandparent});
+    pool.addUnchecked(entry.Fee(0).BondFee(2000LL).FromTx(tx_parent));
+    CTransactionRef tx_child = make_tx(/*output_values=*/{10 * COIN}, /*inputs=*/{tx_parent});
+    pool.addUnchecked(entry.Fee(3000LL).BondFee(0).FromTx(tx_child));
+    CTransactionRef tx_unrelated = make_tx(/*output_values=*/{10 * COIN});
+    pool.addUnchecked(entry.Fee(4000LL).FromTx(tx_unrelated));
+
+    const auto dummy_filter = [](CTxMemPool::txiter it) EXCLUSIVE_LOCKS_REQUIRED(pool.cs, ::cs_main) { return false; };
+    const auto entry_for = [&](const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(pool.cs) -> const CTxMemPoolEntry& {
+        return *pool.mapTx.find(tx->GetHash());
+    };
+
+    // One bond converts to half a unit of cash
+    pool.removeForBlock({}, 1, CAmounts{2000 * COIN, 1000 * COIN}, dummy_filter);
+    BOOST_CHECK_EQUAL(entry_for(tx_parent).GetModifiedFee(), 1000);
+    BOOST_CHECK_EQUAL(entry_for(tx_parent).GetModFeesWithAncestors(), 2000);
+    BOOST_CHECK_EQUAL(entry_for(tx_parent).GetModFeesWithDescendants(), 4000);
+    BOOST_CHECK_EQUAL(entry_for(tx_grandparent).GetModFeesWithDescendants(), 5000);
+    BOOST_CHECK_EQUAL(entry_for(tx_child).GetModFeesWithAncestors(), 5000);
+    BOOST_CHECK_EQUAL(entry_for(tx_unrelated).GetModifiedFee(), 4000);
+
+    // One bond converts to one unit of cash
+    pool.removeForBlock({}, 2, CAmounts{1000 * COIN, 1000 * COIN}, dummy_filter);
+    BOOST_CHECK_EQUAL(entry_for(tx_parent).GetModifiedFee(), 2000);
+    BOOST_CHECK_EQUAL(entry_for(tx_parent).GetModFeesWithAncestors(), 3000);
+    BOOST_CHECK_EQUAL(entry_for(tx_parent).GetModFeesWithDescendants(), 5000);
+    BOOST_CHECK_EQUAL(entry_for(tx_grandparent).GetModFeesWithDescendants(), 6000);
+    BOOST_CHECK_EQUAL(entry_for(tx_child).GetModFeesWithAncestors(), 6000);
+    BOOST_CHECK_EQUAL(entry_for(tx_unrelated).GetModifiedFee(), 4000);
+
+    // Once the bond fee payer is mined, its relatives no longer depend on the conversion rate
+    pool.removeForBlock({tx_grandparent, tx_parent}, 3, CAmounts{2000 * COIN, 1000 * COIN}, dummy_filter);
+    BOOST_CHECK_EQUAL(entry_for(tx_child).GetModFeesWithAncestors(), 3000);
+    BOOST_CHECK_EQUAL(pool.size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolConversionBookTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const auto conversion = [](CAmount cash_in, CAmount bond_in, CAmount cash_out, CAmount bond_out) {
+        CTxConversionInfo info;
+        info.remainderType = CASH;
+        info.destination = CNoDestination();
+        info.nDeadline = 0;
+        info.inputs = CAmounts{cash_in, bond_in};
+        info.minOutputs = CAmounts{cash_out, bond_out};
+        return info;
+    };
+
+    // Cash sellers requiring rates of 2, 1/2 and 1, a bond seller, and a plain transfer
+    CTransactionRef tx_cash_high = make_tx(/*output_values=*/{1 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(10 * COIN, 0, 0, 20 * COIN)).FromTx(tx_cash_high));
+    CTransactionRef tx_cash_low = make_tx(/*output_values=*/{2 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(12 * COIN, 0, 2 * COIN, 5 * COIN)).FromTx(tx_cash_low));
+    CTransactionRef tx_cash_mid = make_tx(/*output_values=*/{3 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(5 * COIN, 1 * COIN, 0, 6 * COIN)).FromTx(tx_cash_mid));
+    CTransactionRef tx_bond = make_tx(/*output_values=*/{4 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(0, 10 * COIN, 3 * COIN, 0)).FromTx(tx_bond));
+    CTransactionRef tx_transfer = make_tx(/*output_values=*/{5 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(std::nullopt).FromTx(tx_transfer));
+
+    const auto book_txids = [&](CAmountType type) EXCLUSIVE_LOCKS_REQUIRED(pool.cs) {
+        std::vector<uint256> txids;
+        for (const CTxMemPool::txiter& it : pool.GetConversionBook(type, std::numeric_limits<size_t>::max())) {
+            txids.push_back(it->GetTx().GetHash());
+        }
+        return txids;
+    };
+
+    const auto cash_book = pool.GetConversionBook(CASH, 10);
+    BOOST_REQUIRE_EQUAL(cash_book.size(), 3U);
+    BOOST_CHECK(cash_book[0]->GetTx().GetHash() == tx_cash_low->GetHash());
+    BOOST_CHECK_EQUAL(cash_book[0]->GetConversionInput(), 10 * COIN);
+    BOOST_CHECK_EQUAL(cash_book[0]->GetConversionOutput(), 5 * COIN);
+    BOOST_CHECK(cash_book[1]->GetTx().GetHash() == tx_cash_mid->GetHash());
+    BOOST_CHECK(cash_book[2]->GetTx().GetHash() == tx_cash_high->GetHash());
+    BOOST_CHECK_EQUAL(pool.GetConversionBook(CASH, 1).size(), 1U);
+    BOOST_CHECK(book_txids(BOND) == std::vector<uint256>{tx_bond->GetHash()});
+
+    pool.removeRecursive(*tx_cash_mid, MemPoolRemovalReason::REPLACED);
+    BOOST_CHECK((book_txids(CASH) == std::vector<uint256>{tx_cash_low->GetHash(), tx_cash_high->GetHash()}));
+    pool.removeRecursive(*tx_bond, MemPoolRemovalReason::REPLACED);
+    BOOST_CHECK(book_txids(BOND).empty());
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolConversionDeadlineTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const auto conversion = [](uint32_t deadline) {
+        CTxConversionInfo info;
+        info.remainderType = CASH;
+        info.destination = CNoDestination();
+        info.nDeadline = deadline;
+        info.inputs = CAmounts{10 * COIN, 0};
+        info.minOutputs = CAmounts{0, 5 * COIN};
+        return info;
+    };
+
+    // Conversions with deadlines 5, 3 and none, a child of the second, and a plain transfer
+    CTransactionRef tx_late = make_tx(/*output_values=*/{1 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(5)).FromTx(tx_late));
+    CTransactionRef tx_early = make_tx(/*output_values=*/{2 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(3)).FromTx(tx_early));
+    CTransactionRef tx_none = make_tx(/*output_values=*/{3 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(conversion(0)).FromTx(tx_none));
+    CTransactionRef tx_child = make_tx(/*output_values=*/{1 * COIN}, /*inputs=*/{tx_early});
+    pool.addUnchecked(entry.ConversionInfo(std::nullopt).FromTx(tx_child));
+    CTransactionRef tx_transfer = make_tx(/*output_values=*/{4 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(std::nullopt).FromTx(tx_transfer));
+
+    // Only conversions that have not expired are checked for validity
+    std::vector<uint256> checked;
+    const auto filter_invalid = [&](CTxMemPool::txiter it) EXCLUSIVE_LOCKS_REQUIRED(pool.cs, ::cs_main) {
+        checked.push_back(it->GetTx().GetHash());
+        return false;
+    };
+    const CAmounts supply{1000 * COIN, 1000 * COIN};
+
+    pool.removeForBlock({}, 3, supply, filter_invalid);
+    BOOST_CHECK_EQUAL(pool.size(), 5U);
+    BOOST_CHECK((checked == std::vector<uint256>{tx_early->GetHash(), tx_late->GetHash(), tx_none->GetHash()}));
+
+    // The deadline of 3 expires at height 4, taking its child with it
+    checked.clear();
+    pool.removeForBlock({}, 4, supply, filter_invalid);
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_early->GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_child->GetHash())));
+    BOOST_CHECK((checked == std::vector<uint256>{tx_late->GetHash(), tx_none->GetHash()}));
+
+    // Conversions without a deadline never expire
+    checked.clear();
+    pool.removeForBlock({}, 1000, supply, filter_invalid);
+    BOOST_CHECK_EQUAL(pool.size(), 2U);
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_none->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_transfer->GetHash())));
+    BOOST_CHECK(checked == std::vector<uint256>{tx_none->GetHash()});
+}
+
+BOOST_AUTO_TEST_CASE(MempoolInvalidConversionTrimTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    CTxConversionInfo info;
+    info.remainderType = CASH;
+    info.destination = CNoDestination();
+    info.inputs = CAmounts{10 * COIN, 0};
+    info.minOutputs = CAmounts{0, 5 * COIN};
+
+    // A conversion that is no longer valid pays the highest fee
+    CTransactionRef tx_invalid = make_tx(/*output_values=*/{1 * COIN});
+    pool.addUnchecked(entry.Fee(10000).ConversionInfo(info).FromTx(tx_invalid));
+    CTransactionRef tx_valid = make_tx(/*output_values=*/{2 * COIN});
+    pool.addUnchecked(entry.Fee(1000).ConversionInfo(info).FromTx(tx_valid));
+    CTransactionRef tx_transfer = make_tx(/*output_values=*/{3 * COIN});
+    pool.addUnchecked(entry.Fee(100).ConversionInfo(std::nullopt).FromTx(tx_transfer));
+
+    std::vector<uint256> checked;
+    const auto is_invalid = [&](CTxMemPool::txiter it) {
+        checked.push_back(it->GetTx().GetHash());
+        return it->GetTx().GetHash() == tx_invalid->GetHash();
+    };
+
+    // Only conversions are checked, and only once per tip
+    pool.UpdateInvalidConversions(uint256::ONE, is_invalid);
+    BOOST_CHECK_EQUAL(checked.size(), 2U);
+    checked.clear();
+    pool.UpdateInvalidConversions(uint256::ONE, is_invalid);
+    BOOST_CHECK(checked.empty());
+    CTransactionRef tx_new = make_tx(/*output_values=*/{4 * COIN});
+    pool.addUnchecked(entry.Fee(1000).ConversionInfo(info).FromTx(tx_new));
+    pool.UpdateInvalidConversions(uint256::ONE, is_invalid);
+    BOOST_CHECK(checked == std::vector<uint256>{tx_new->GetHash()});
+    checked.clear();
+    pool.UpdateInvalidConversions(uint256::ZERO, is_invalid);
+    BOOST_CHECK_EQUAL(checked.size(), 3U);
+
+    // The invalid conversion is evicted before the transactions paying lower fees
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_invalid->GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_transfer->GetHash())));
+
+    // Then the lowest descendant score as usual
+    pool.TrimToSize(pool.DynamicMemoryUsage() - 1);
+    BOOST_CHECK_EQUAL(pool.size(), 2U);
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_transfer->GetHash())));
+}
+
+BOOST_AUTO_TEST_CASE(MempoolProjectedSupplyTest)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const auto sell = [](CAmountType type, CAmount input, CAmount output) {
+        CTxConversionInfo info;
+        info.remainderType = type;
+        info.destination = CNoDestination();
+        info.nDeadline = 0;
+        info.inputs = CAmounts{0};
+        info.minOutputs = CAmounts{0};
+        info.inputs[type] = input;
+        info.minOutputs[!type] = output;
+        return info;
+    };
+
+    const CAmounts supply{1000 * COIN, 1000 * COIN};
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == supply);
+
+    // A cash seller that clears, one that never does, and a bond seller that clears after the first executes
+    CTransactionRef tx_cash = make_tx(/*output_values=*/{1 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(sell(CASH, 10 * COIN, 9 * COIN)).FromTx(tx_cash));
+    CTransactionRef tx_cash_greedy = make_tx(/*output_values=*/{2 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(sell(CASH, 10 * COIN, 20 * COIN)).FromTx(tx_cash_greedy));
+    CTransactionRef tx_bond = make_tx(/*output_values=*/{3 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(sell(BOND, 5 * COIN, 5 * COIN)).FromTx(tx_bond));
+
+    CAmounts expected = supply;
+    const CAmount bond_out = CalculateOutputAmount(expected, 10 * COIN, CASH);
+    expected[CASH] -= 10 * COIN;
+    expected[BOND] += bond_out;
+    BOOST_REQUIRE_GE(CalculateOutputAmount(expected, 5 * COIN, BOND), 5 * COIN);
+    const CAmount cash_out = CalculateOutputAmount(expected, 5 * COIN, BOND);
+    expected[BOND] -= 5 * COIN;
+    expected[CASH] += cash_out;
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == expected);
+
+    // The cached projection follows the books as conversions are added and removed
+    CTransactionRef tx_cash_greedier = make_tx(/*output_values=*/{4 * COIN});
+    pool.addUnchecked(entry.ConversionInfo(sell(CASH, 10 * COIN, 30 * COIN)).FromTx(tx_cash_greedier));
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == expected);
+    pool.removeRecursive(*tx_cash_greedy, REMOVAL_REASON_DUMMY);
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == expected);
+    pool.removeRecursive(*tx_bond, REMOVAL_REASON_DUMMY);
+    expected = supply;
+    expected[CASH] -= 10 * COIN;
+    expected[BOND] += bond_out;
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == expected);
+    pool.addUnchecked(entry.ConversionInfo(sell(BOND, 5 * COIN, 5 * COIN)).FromTx(tx_bond));
+    expected[BOND] -= 5 * COIN;
+    expected[CASH] += cash_out;
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == expected);
+    const CAmounts other_supply{2000 * COIN, 1000 * COIN};
+    BOOST_CHECK(pool.GetProjectedSupply(other_supply) != expected);
+    BOOST_CHECK(pool.GetProjectedSupply(supply) == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -86,6 +86,17 @@ static CBlockIndex CreateBlockIndex(int nHeight, CBlockIndex* active_chain_tip)
     return index;
 }
 
+// Shift the time of the last nMedianTimeSpan blocks, and with it the median time past of the tip.
+static void ShiftMedianTimePast(CBlockIndex* tip, int64_t offset)
+{
+    for (int i = 0; i < CBlockIndex::nMedianTimeSpan; ++i) {
+        Assert(tip->GetAncestor(tip->nHeight - i))->nTime += offset;
+    }
+    for (int i = 0; i < CBlockIndex::nMedianTimeSpan; ++i) {
+        tip->GetAncestor(tip->nHeight - i)->BuildMedianTimePast();
+    }
+}
+
 // Test suite for ancestor feerate transaction selection.
 // Implemented as an additional function, rather than a separate test case,
 // to allow reusing the blockchain created in CreateNewBlock_validity.
@@ -407,17 +418,13 @@ void MinerTestingSetup::TestBasicMining(const CChainParams& chainparams, const C
     BOOST_CHECK(!TestSequenceLocks(CTransaction{tx})); // Sequence locks fail
 
     const int SEQUENCE_LOCK_TIME = 512; // Sequence locks pass 512 seconds later
-    for (int i = 0; i < CBlockIndex::nMedianTimeSpan; ++i)
-        m_node.chainman->ActiveChain().Tip()->GetAncestor(m_node.chainman->ActiveChain().Tip()->nHeight - i)->nTime += SEQUENCE_LOCK_TIME; // Trick the MedianTimePast
+    ShiftMedianTimePast(m_node.chainman->ActiveChain().Tip(), SEQUENCE_LOCK_TIME); // Trick the MedianTimePast
     {
         CBlockIndex* active_chain_tip = m_node.chainman->ActiveChain().Tip();
         BOOST_CHECK(SequenceLocks(CTransaction(tx), flags, prevheights, CreateBlockIndex(active_chain_tip->nHeight + 1, active_chain_tip)));
     }
 
-    for (int i = 0; i < CBlockIndex::nMedianTimeSpan; ++i) {
-        CBlockIndex* ancestor{Assert(m_node.chainman->ActiveChain().Tip()->GetAncestor(m_node.chainman->ActiveChain().Tip()->nHeight - i))};
-        ancestor->nTime -= SEQUENCE_LOCK_TIME; // undo tricked MTP
-    }
+    ShiftMedianTimePast(m_node.chainman->ActiveChain().Tip(), -SEQUENCE_LOCK_TIME); // undo tricked MTP
 
     // absolute height locked
     tx.vin[0].prevout.hash = txFirst[2]->GetHash();
@@ -463,10 +470,7 @@ void MinerTestingSetup::TestBasicMining(const CChainParams& chainparams, const C
     // For now these will still generate a valid template until BIP68 soft fork
     BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3U);
     // However if we advance height by 1 and time by SEQUENCE_LOCK_TIME, all of them should be mined
-    for (int i = 0; i < CBlockIndex::nMedianTimeSpan; ++i) {
-        CBlockIndex* ancestor{Assert(m_node.chainman->ActiveChain().Tip()->GetAncestor(m_node.chainman->ActiveChain().Tip()->nHeight - i))};
-        ancestor->nTime += SEQUENCE_LOCK_TIME; // Trick the MedianTimePast
-    }
+    ShiftMedianTimePast(m_node.chainman->ActiveChain().Tip(), SEQUENCE_LOCK_TIME); // Trick the MedianTimePast
     m_node.chainman->ActiveChain().Tip()->nHeight++;
     SetMockTime(m_node.chainman->ActiveChain().Tip()->GetMedianTimePast() + 1);
 
@@ -603,6 +603,68 @@ BOOST_AUTO_TEST_CASE(cnetaddr_unserialize_v2)
     BOOST_REQUIRE(s.empty());
 }
 
+/** Encrypt a message into a V2 packet, as read by V2TransportDeserializer */
+static std::vector<unsigned char> MakeV2Packet(ChaCha20Poly1305AEAD& aead, V2TransportSequence& sequence, const CSerializedNetMsg& msg)
+{
+    std::vector<unsigned char> packet(CHACHA20_POLY1305_AEAD_AAD_LEN);
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, packet, CHACHA20_POLY1305_AEAD_AAD_LEN, msg.m_type};
+    packet.insert(packet.end(), msg.data.begin(), msg.data.end());
+    const size_t payload_size{packet.size() - CHACHA20_POLY1305_AEAD_AAD_LEN};
+    packet[0] = payload_size & 0xff;
+    packet[1] = (payload_size >> 8) & 0xff;
+    packet[2] = (payload_size >> 16) & 0xff;
+    packet.resize(packet.size() + POLY1305_TAGLEN);
+    BOOST_REQUIRE(aead.Crypt(sequence.m_payload, sequence.m_aad, sequence.m_aad_pos, packet.data(), packet.size(),
+                             packet.data(), packet.size() - POLY1305_TAGLEN, /*is_encrypt=*/true));
+    sequence.Next();
+    return packet;
+}
+
+BOOST_AUTO_TEST_CASE(v2_transport_roundtrip)
+{
+    const std::vector<uint8_t> key_length(32, 0x11), key_payload(32, 0x22);
+    ChaCha20Poly1305AEAD aead{key_length.data(), key_length.size(), key_payload.data(), key_payload.size()};
+    V2TransportSequence sequence;
+    V2TransportDeserializer deserializer{/*node_id=*/0, key_length, key_payload, SER_NETWORK, INIT_PROTO_VERSION};
+
+    // Cross several length keystream blocks, with empty and large payloads.
+    for (unsigned int i = 0; i < 3 * AAD_PACKAGES_PER_ROUND; ++i) {
+        CSerializedNetMsg msg;
+        msg.m_type = i % 2 ? NetMsgType::INV : NetMsgType::TX;
+        msg.data.assign(i % 7 == 0 ? 0 : i * 1000, uint8_t(i));
+        const std::vector<unsigned char> data{msg.data};
+        const std::vector<unsigned char> packet{MakeV2Packet(aead, sequence, msg)};
+
+        // Feed the packet in two pieces, splitting the length field for some.
+        Span<const uint8_t> bytes{packet};
+        Span<const uint8_t> first{bytes.first(std::min<size_t>(i % 5, bytes.size()))};
+        Span<const uint8_t> rest{bytes.subspan(first.size())};
+        while (!first.empty()) BOOST_REQUIRE(deserializer.Read(first) > 0);
+        while (!rest.empty()) BOOST_REQUIRE(deserializer.Read(rest) > 0);
+        BOOST_REQUIRE(deserializer.Complete());
+
+        bool reject_message{true};
+        CNetMessage received{deserializer.GetMessage(std::chrono::microseconds{0}, reject_message)};
+        BOOST_CHECK(!reject_message);
+        BOOST_CHECK_EQUAL(received.m_type, msg.m_type);
+        BOOST_CHECK_EQUAL(received.m_message_size, data.size());
+        BOOST_CHECK_EQUAL(received.m_raw_message_size, packet.size());
+        BOOST_CHECK(MakeUCharSpan(received.m_recv) == Span{data});
+    }
+
+    // A modified packet fails authentication.
+    CSerializedNetMsg msg;
+    msg.m_type = NetMsgType::PING;
+    msg.data.assign(8, 0);
+    std::vector<unsigned char> packet{MakeV2Packet(aead, sequence, msg)};
+    packet[CHACHA20_POLY1305_AEAD_AAD_LEN] ^= 1;
+    Span<const uint8_t> bytes{packet};
+    int ret{0};
+    while (!bytes.empty() && (ret = deserializer.Read(bytes)) >= 0) {}
+    BOOST_CHECK_EQUAL(ret, -1);
+    BOOST_CHECK(!deserializer.Complete());
+}
+
 // prior to PR #14728, this test triggers an undefined behavior
 BOOST_AUTO_TEST_CASE(ipv4_peer_with_ipv6_addrMe_test)
 {
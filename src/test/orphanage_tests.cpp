@@ -25,6 +25,12 @@ public:
         return m_orphans.size();
     }
 
+    size_t CountPeerOrphans(NodeId peer) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
+    {
+        const auto it = m_peer_orphans.find(peer);
+        return it == m_peer_orphans.end() ? 0 : it->second.orphans.size();
+    }
+
     CTransactionRef RandomOrphan() EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
     {
         std::map<uint256, OrphanTx>::iterator it;
@@ -134,4 +140,50 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     BOOST_CHECK(orphanage.CountOrphans() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(peer_orphan_quotas)
+{
+    TxOrphanageTest orphanage;
+    LOCK(g_cs_orphans);
+
+    // Orphans of equal size: 30 from peer 0 and 5 from peer 1
+    const auto add_orphans{[&](NodeId peer, int count) {
+        for (int i = 0; i < count; i++) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout.n = 0;
+            tx.vin[0].prevout.hash = InsecureRand256();
+            tx.vin[0].scriptSig << OP_1;
+            tx.vout.resize(1);
+            tx.vout[0].nValue = 1*CENT;
+            tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+            BOOST_CHECK(orphanage.AddTx(MakeTransactionRef(tx), peer));
+        }
+    }};
+    add_orphans(0, 30);
+    add_orphans(1, 5);
+    const size_t orphan_size{orphanage.RandomOrphan()->GetTotalSize()};
+
+    // Count quota
+    orphanage.LimitOrphans(/*max_orphans=*/100, /*max_peer_orphans=*/25, /*max_peer_bytes=*/100 * orphan_size);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(0), 25U);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(1), 5U);
+
+    // Byte quota
+    orphanage.LimitOrphans(/*max_orphans=*/100, /*max_peer_orphans=*/25, /*max_peer_bytes=*/20 * orphan_size);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(0), 20U);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(1), 5U);
+
+    // The overall limit evicts from the peer using the most memory first
+    orphanage.LimitOrphans(/*max_orphans=*/20);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(0), 15U);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(1), 5U);
+    orphanage.LimitOrphans(/*max_orphans=*/6);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(0), 3U);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(1), 3U);
+
+    orphanage.EraseForPeer(0);
+    BOOST_CHECK_EQUAL(orphanage.CountPeerOrphans(0), 0U);
+    BOOST_CHECK_EQUAL(orphanage.CountOrphans(), 3U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
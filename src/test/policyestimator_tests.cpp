@@ -52,11 +52,6 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     int blocknum = 0;
 
     // TODO: Test for expired transactions
-    const auto dummy_filter_expired = [](CTxMemPool::txiter it)
-        EXCLUSIVE_LOCKS_REQUIRED(mpool.cs, ::cs_main) {
-        // Transaction is not a conversion or conversion has not expired
-        return false;
-    };
     const auto dummy_filter_invalid = [](CTxMemPool::txiter it)
         EXCLUSIVE_LOCKS_REQUIRED(mpool.cs, ::cs_main) {
         // Transaction is not a conversion or conversion has not expired
@@ -87,7 +82,7 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
                 txHashes[9-h].pop_back();
             }
         }
-        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
         block.clear();
         // Check after just a few txs that combining buckets works as expected
         if (blocknum == 3) {
@@ -126,7 +121,7 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     // Mine 50 more blocks with no transactions happening, estimates shouldn't change
     // We haven't decayed the moving average enough so we still have enough data points in every bucket
     while (blocknum < 250)
-        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
 
     BOOST_CHECK(feeEst.estimateFee(1) == CFeeRate(0));
     for (int i = 2; i < 10;i++) {
@@ -146,7 +141,7 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
                 txHashes[j].push_back(hash);
             }
         }
-        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
     }
 
     for (int i = 1; i < 10;i++) {
@@ -163,7 +158,7 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
             txHashes[j].pop_back();
         }
     }
-    mpool.removeForBlock(block, 266, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+    mpool.removeForBlock(block, 266, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
     block.clear();
     BOOST_CHECK(feeEst.estimateFee(1) == CFeeRate(0));
     for (int i = 2; i < 10;i++) {
@@ -184,7 +179,7 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
 
             }
         }
-        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_expired, dummy_filter_invalid);
+        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter_invalid);
         block.clear();
     }
     BOOST_CHECK(feeEst.estimateFee(1) == CFeeRate(0));
@@ -193,4 +188,44 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     }
 }
 
+BOOST_AUTO_TEST_CASE(BlockPolicyEstimatesByFeeType)
+{
+    CBlockPolicyEstimator& feeEst = *Assert(m_node.fee_estimator);
+    CTxMemPool& mpool = *Assert(m_node.mempool);
+    LOCK2(cs_main, mpool.cs);
+    TestMemPoolEntryHelper entry;
+    const CAmount cashFee{2000};
+    const CAmount bondFee{30000};
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 0;
+    const size_t vsize{entry.FromTx(tx).GetTxSize()};
+
+    const auto dummy_filter = [](CTxMemPool::txiter it) EXCLUSIVE_LOCKS_REQUIRED(mpool.cs, ::cs_main) { return false; };
+
+    // Every block confirms 4 cash-fee and 4 bond-fee transactions that entered
+    // the mempool at the previous height
+    std::vector<CTransactionRef> block;
+    int blocknum = 0;
+    while (blocknum < 50) {
+        for (int k = 0; k < 8; k++) {
+            tx.vin[0].prevout.n = 10000 * blocknum + k;
+            const bool paysBonds{k % 2 == 1};
+            mpool.addUnchecked(entry.Fee(paysBonds ? 0 : cashFee).BondFee(paysBonds ? bondFee : 0).Time(GetTime()).Height(blocknum).FromTx(tx));
+            block.push_back(mpool.get(tx.GetHash()));
+        }
+        mpool.removeForBlock(block, ++blocknum, m_node.chain->getLastTotalSupply(), dummy_filter);
+        block.clear();
+    }
+
+    // Each currency is estimated from the transactions that paid in it
+    const CFeeRate cashRate{cashFee, static_cast<uint32_t>(vsize)};
+    const CFeeRate bondRate{bondFee, static_cast<uint32_t>(vsize)};
+    BOOST_CHECK_EQUAL(feeEst.estimateSmartFee(2, nullptr, false, CASH).GetFeePerK(), cashRate.GetFeePerK());
+    BOOST_CHECK_EQUAL(feeEst.estimateSmartFee(2, nullptr, false, BOND).GetFeePerK(), bondRate.GetFeePerK());
+    BOOST_CHECK_EQUAL(feeEst.estimateSmartFee(2, nullptr, false).GetFeePerK(), cashRate.GetFeePerK());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <memusage.h>
+#include <support/allocators/pool.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(pool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(basic_allocating)
+{
+    auto resource = PoolResource<8, 8>();
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // freelist is empty, so allocations are carved out of the chunk
+    void* block = resource.Allocate(8, 8);
+    void* next = resource.Allocate(8, 8);
+    BOOST_CHECK_EQUAL(static_cast<std::byte*>(next) - static_cast<std::byte*>(block), 8);
+
+    // a deallocated block is reused by the next allocation of the same size
+    resource.Deallocate(block, 8, 8);
+    BOOST_CHECK_EQUAL(resource.Allocate(8, 8), block);
+
+    // zero sized allocations use the smallest block size
+    void* zero = resource.Allocate(0, 1);
+    resource.Deallocate(zero, 0, 1);
+    BOOST_CHECK_EQUAL(resource.Allocate(1, 1), zero);
+
+    // too large or overaligned allocations are forwarded to operator new
+    void* large = resource.Allocate(16, 8);
+    void* aligned = resource.Allocate(8, 16);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(aligned) % 16, 0U);
+    resource.Deallocate(large, 16, 8);
+    resource.Deallocate(aligned, 8, 16);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(allocate_new_chunks)
+{
+    auto resource = PoolResource<8, 8>(64);
+    BOOST_CHECK_EQUAL(resource.ChunkSizeBytes(), 64U);
+
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < 8; ++i) {
+        blocks.push_back(resource.Allocate(8, 8));
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+    blocks.push_back(resource.Allocate(8, 8));
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+
+    // chunks are kept until the resource is destroyed
+    for (void* block : blocks) {
+        resource.Deallocate(block, 8, 8);
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(huge_pages)
+{
+    auto resource = PoolResource<8, 8>(64, /*huge_pages=*/true);
+    BOOST_CHECK(resource.UsesHugePages());
+    BOOST_CHECK_EQUAL(resource.ChunkSizeBytes(), HUGE_PAGE_SIZE);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // chunks and large allocations are aligned to the huge page size
+    void* block = resource.Allocate(8, 8);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(block) % HUGE_PAGE_SIZE, 0U);
+    void* large = resource.Allocate(HUGE_PAGE_SIZE + 1, 8);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(large) % HUGE_PAGE_SIZE, 0U);
+    static_cast<std::byte*>(large)[HUGE_PAGE_SIZE] = std::byte{1};
+    resource.Deallocate(large, HUGE_PAGE_SIZE + 1, 8);
+    resource.Deallocate(block, 8, 8);
+
+    // a coins cache can be backed by huge pages, and keeps them when it is reallocated
+    CCoinsView base;
+    CCoinsViewCache cache(&base, /*huge_pages=*/true);
+    BOOST_CHECK(cache.UsesHugePages());
+    cache.ReallocateCache();
+    BOOST_CHECK(cache.UsesHugePages());
+    BOOST_CHECK(!CCoinsViewCache(&base).UsesHugePages());
+}
+
+BOOST_AUTO_TEST_CASE(memusage_test)
+{
+    auto std_map = std::unordered_map<int64_t, int64_t>{};
+
+    using Map = std::unordered_map<int64_t,
+                                   int64_t,
+                                   std::hash<int64_t>,
+                                   std::equal_to<int64_t>,
+                                   PoolAllocator<std::pair<const int64_t, int64_t>,
+                                                 sizeof(std::pair<const int64_t, int64_t>) + sizeof(void*) * 4>>;
+    auto resource = Map::allocator_type::ResourceType(1024);
+    auto resource_map = Map{0, std::hash<int64_t>{}, std::equal_to<int64_t>{}, &resource};
+
+    // The pool's usage grows in whole chunks and never undercounts the nodes
+    for (int64_t i = 0; i < 1000; ++i) {
+        std_map[i];
+        resource_map[i];
+        BOOST_CHECK_GE(memusage::DynamicUsage(resource_map), resource.NumAllocatedChunks() * resource.ChunkSizeBytes());
+    }
+    BOOST_CHECK_GT(resource.NumAllocatedChunks(), 1U);
+    // Nodes are packed into chunks without a malloc overhead per node
+    BOOST_CHECK_LE(memusage::DynamicUsage(resource_map), memusage::DynamicUsage(std_map));
+}
+
+BOOST_AUTO_TEST_CASE(coins_cache_memory_released_on_flush)
+{
+    CCoinsView base;
+    CCoinsViewCache cache(&base);
+    const size_t empty_usage = cache.DynamicMemoryUsage();
+
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.out.scriptPubKey.assign(uint32_t{56}, 1);
+    for (uint32_t i = 0; i < 10000; ++i) {
+        cache.AddCoin(COutPoint{InsecureRand256(), i}, Coin{coin}, /*possible_overwrite=*/false);
+    }
+    BOOST_CHECK_GT(cache.DynamicMemoryUsage(), empty_usage);
+
+    // The base view can't be written to, but the cache is emptied regardless
+    BOOST_CHECK(!cache.Flush());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), empty_usage);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -183,8 +183,20 @@ BOOST_FIXTURE_TEST_CASE(rbf_helper_functions, TestChain100Setup)
                                        /*all_valid_conflicts=*/ all_valid_conflicts,
                                        /*filter_invalid_conversion=*/ filter_invalid_conversion) == std::nullopt);
     BOOST_CHECK(all_conflicts == all_entries);
+    BOOST_CHECK(all_valid_conflicts == all_entries);
     auto conflicts_size = all_conflicts.size();
     all_conflicts.clear();
+    all_valid_conflicts.clear();
+
+    // An invalid conversion is excluded from the valid conflicts with its descendants
+    std::function<bool(CTxMemPool::txiter)> filter_entry1 = [&](CTxMemPool::txiter it) {
+        return it == entry1;
+    };
+    BOOST_CHECK(GetEntriesForConflicts(*conflicts_with_parents.get(), pool, all_parents, all_conflicts, all_valid_conflicts, filter_entry1) == std::nullopt);
+    BOOST_CHECK(all_conflicts == all_entries);
+    BOOST_CHECK((all_valid_conflicts == CTxMemPool::setEntries{entry3, entry4, entry5, entry6, entry7, entry8}));
+    all_conflicts.clear();
+    all_valid_conflicts.clear();
 
     add_descendants(tx2, 23, pool);
     BOOST_CHECK(GetEntriesForConflicts(*conflicts_with_parents.get(), pool, all_parents, all_conflicts, all_valid_conflicts, filter_invalid_conversion) == std::nullopt);
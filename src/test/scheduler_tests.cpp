@@ -4,12 +4,15 @@
 
 #include <random.h>
 #include <scheduler.h>
+#include <util/string.h>
 #include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
 
 #include <functional>
+#include <map>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -210,4 +213,70 @@ BOOST_AUTO_TEST_CASE(mockforward)
     BOOST_CHECK(delta > 2*60 && delta < 3*60);
 }
 
+BOOST_AUTO_TEST_CASE(timer_wheel)
+{
+    // Compare the wheel with an ordered map over delays from sub-tick to
+    // beyond the range of the wheel levels.
+    FastRandomContext rng{/*fDeterministic=*/true};
+    auto now{std::chrono::steady_clock::now()};
+    TimerWheel wheel{now};
+    std::multimap<std::chrono::steady_clock::time_point, std::string> expected;
+    const auto random_delay{[&]() -> std::chrono::nanoseconds {
+        switch (rng.randrange(4)) {
+        case 0: return std::chrono::microseconds{(int64_t)rng.randrange(5000) - 1000};
+        case 1: return std::chrono::milliseconds{rng.randrange(100000)};
+        case 2: return std::chrono::seconds{rng.randrange(100000)};
+        default: return std::chrono::hours{rng.randrange(2000)};
+        }
+    }};
+    for (int i = 0; i < 10000; ++i) {
+        if (rng.randbool()) {
+            const auto time{now + random_delay()};
+            wheel.Insert({time, [] {}, ToString(i)});
+            expected.emplace(time, ToString(i));
+        } else {
+            now += rng.randbool() ? random_delay() / 16 : std::chrono::nanoseconds{rng.randrange(3000000)};
+            wheel.Advance(now);
+            while (wheel.HasReady()) {
+                TimerWheel::Task task{wheel.PopReady()};
+                BOOST_REQUIRE(!expected.empty());
+                BOOST_CHECK(task.time <= now);
+                BOOST_CHECK(task.time == expected.begin()->first);
+                BOOST_CHECK_EQUAL(task.name, expected.begin()->second);
+                expected.erase(expected.begin());
+            }
+            BOOST_CHECK(expected.empty() || expected.begin()->first > now);
+        }
+        BOOST_REQUIRE_EQUAL(wheel.Size(), expected.size());
+        if (!expected.empty()) {
+            BOOST_CHECK(wheel.NextTime() == expected.begin()->first);
+            BOOST_CHECK(wheel.LastTime() == expected.rbegin()->first);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(task_stats)
+{
+    CScheduler scheduler;
+    std::thread scheduler_thread([&] { scheduler.serviceQueue(); });
+
+    scheduler.scheduleFromNow([] { UninterruptibleSleep(std::chrono::milliseconds{10}); }, std::chrono::milliseconds{0}, "slow");
+    scheduler.scheduleFromNow([] {}, std::chrono::milliseconds{0}, "fast");
+    scheduler.scheduleFromNow([] {}, std::chrono::milliseconds{0});
+    scheduler.scheduleFromNow([&scheduler] { scheduler.stop(); }, std::chrono::milliseconds{1});
+    scheduler_thread.join();
+
+    // Only named tasks are recorded
+    const std::map<std::string, CScheduler::TaskStats> stats{scheduler.GetTaskStats()};
+    BOOST_REQUIRE_EQUAL(stats.size(), 2U);
+    const CScheduler::TaskStats& slow{stats.at("slow")};
+    BOOST_CHECK_EQUAL(slow.runs, 1U);
+    BOOST_CHECK(slow.total_time >= std::chrono::milliseconds{10});
+    BOOST_CHECK(slow.max_time == slow.total_time);
+    // The fast task was queued behind the slow one on the only thread
+    const CScheduler::TaskStats& fast{stats.at("fast")};
+    BOOST_CHECK_EQUAL(fast.runs, 1U);
+    BOOST_CHECK(fast.max_delay >= std::chrono::milliseconds{10});
+}
+
 BOOST_AUTO_TEST_SUITE_END()
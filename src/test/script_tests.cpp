@@ -8,6 +8,7 @@
 #include <core_io.h>
 #include <fs.h>
 #include <key.h>
+#include <memusage.h>
 #include <rpc/util.h>
 #include <script/script.h>
 #include <script/script_error.h>
@@ -1302,6 +1303,32 @@ BOOST_AUTO_TEST_CASE(script_standard_push)
     }
 }
 
+BOOST_AUTO_TEST_CASE(script_witness_item)
+{
+    std::vector<std::vector<unsigned char>> items;
+    for (const unsigned int size : {0u, 1u, 33u, 64u, 72u, WITNESS_ITEM_INLINE_SIZE, WITNESS_ITEM_INLINE_SIZE + 1, MAX_SCRIPT_ELEMENT_SIZE}) {
+        items.push_back(g_insecure_rand_ctx.randbytes(size));
+    }
+    CScriptWitness witness;
+    witness.stack.assign(items.begin(), items.end());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const CScriptWitnessItem& item{witness.stack[i]};
+        BOOST_CHECK(std::equal(item.begin(), item.end(), items[i].begin(), items[i].end()));
+        // Items up to the inline size need no allocation of their own
+        BOOST_CHECK_EQUAL(memusage::DynamicUsage(item) == 0, item.size() <= WITNESS_ITEM_INLINE_SIZE);
+    }
+
+    // The stack serializes exactly as a vector of byte vectors
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << witness.stack;
+    CDataStream expected(SER_NETWORK, PROTOCOL_VERSION);
+    expected << items;
+    BOOST_CHECK_EQUAL(HexStr(stream), HexStr(expected));
+    std::vector<CScriptWitnessItem> stack;
+    stream >> stack;
+    BOOST_CHECK(stack == witness.stack);
+}
+
 BOOST_AUTO_TEST_CASE(script_IsPushOnly_on_invalid_scripts)
 {
     // IsPushOnly returns false when given a script containing only pushes that
@@ -1472,6 +1499,83 @@ BOOST_AUTO_TEST_CASE(script_HasValidOps)
     BOOST_CHECK(!script.HasValidOps());
 }
 
+enum class StandardSpend { P2PKH, P2WPKH, P2SH_P2WPKH };
+
+/** Verify a spend of a standard template, or of an equivalent script the template
+ *  fast paths do not match (OP_NOP prefixed P2PKH, P2WSH of the P2PKH script),
+ *  with the signature or public key optionally mutated. */
+static std::pair<bool, ScriptError> VerifyStandardSpend(StandardSpend spend, bool use_template, const CKey& key, const CKey& other_key, int mutation, unsigned int flags)
+{
+    const CPubKey pubkey{key.GetPubKey()};
+    const CScript pkh_script{CScript() << OP_DUP << OP_HASH160 << ToByteVector(pubkey.GetID()) << OP_EQUALVERIFY << OP_CHECKSIG};
+    CScript script_code{pkh_script};
+    CScript program;
+    CScript script_pubkey;
+    if (spend == StandardSpend::P2PKH) {
+        if (!use_template) script_code = CScript() << OP_NOP << OP_DUP << OP_HASH160 << ToByteVector(pubkey.GetID()) << OP_EQUALVERIFY << OP_CHECKSIG;
+        script_pubkey = script_code;
+    } else {
+        program = use_template ? CScript() << OP_0 << ToByteVector(pubkey.GetID()) : GetScriptForDestination(WitnessV0ScriptHash(pkh_script));
+        script_pubkey = spend == StandardSpend::P2SH_P2WPKH ? GetScriptForDestination(ScriptHash(program)) : program;
+    }
+    const SigVersion sigversion{spend == StandardSpend::P2PKH ? SigVersion::BASE : SigVersion::WITNESS_V0};
+
+    const CMutableTransaction tx_credit{BuildCreditingTransaction(script_pubkey, 1)};
+    CMutableTransaction tx_spend{BuildSpendingTransaction(CScript(), CScriptWitness(), CTransaction(tx_credit))};
+    std::vector<unsigned char> sig;
+    BOOST_REQUIRE(key.Sign(SignatureHash(script_code, tx_spend, 0, SIGHASH_ALL, tx_credit.vout[0].amountType, tx_credit.vout[0].nValue, sigversion), sig));
+    sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+    std::vector<unsigned char> pubkey_data{ToByteVector(pubkey)};
+    switch (mutation) {
+    case 1: sig[sig.size() / 2] ^= 1; break;
+    case 2: sig.clear(); break;
+    case 3: pubkey_data = ToByteVector(other_key.GetPubKey()); break;
+    case 4: pubkey_data.resize(MAX_SCRIPT_ELEMENT_SIZE + 1); break;
+    }
+
+    if (spend == StandardSpend::P2PKH) {
+        tx_spend.vin[0].scriptSig = CScript() << sig << pubkey_data;
+    } else {
+        tx_spend.vin[0].scriptWitness.stack = {sig, pubkey_data};
+        if (!use_template) tx_spend.vin[0].scriptWitness.stack.emplace_back(pkh_script.begin(), pkh_script.end());
+        if (spend == StandardSpend::P2SH_P2WPKH) tx_spend.vin[0].scriptSig = CScript() << ToByteVector(program);
+    }
+
+    ScriptError err;
+    const bool ret{VerifyScript(tx_spend.vin[0].scriptSig, script_pubkey, &tx_spend.vin[0].scriptWitness, flags, MutableTransactionSignatureChecker(&tx_spend, 0, tx_credit.vout[0].amountType, tx_credit.vout[0].nValue, MissingDataBehavior::ASSERT_FAIL), &err)};
+    return {ret, err};
+}
+
+BOOST_AUTO_TEST_CASE(script_standard_template_fast_paths)
+{
+    // Standard templates are verified without the interpreter loop. The result
+    // and error must match those of the general path for an equivalent script.
+    const unsigned int base_flags{SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS};
+    const std::vector<unsigned int> all_flags{
+        base_flags,
+        base_flags | SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_NULLFAIL,
+        base_flags | SCRIPT_VERIFY_DERSIG | SCRIPT_VERIFY_LOW_S | SCRIPT_VERIFY_WITNESS_PUBKEYTYPE,
+    };
+    for (const bool compressed : {true, false}) {
+        CKey key, other_key;
+        key.MakeNewKey(compressed);
+        other_key.MakeNewKey(compressed);
+        for (const StandardSpend spend : {StandardSpend::P2PKH, StandardSpend::P2WPKH, StandardSpend::P2SH_P2WPKH}) {
+            for (int mutation = 0; mutation <= 4; ++mutation) {
+                for (const unsigned int flags : all_flags) {
+                    const auto fast{VerifyStandardSpend(spend, /*use_template=*/true, key, other_key, mutation, flags)};
+                    const auto general{VerifyStandardSpend(spend, /*use_template=*/false, key, other_key, mutation, flags)};
+                    BOOST_CHECK_EQUAL(fast.first, general.first);
+                    BOOST_CHECK_MESSAGE(fast.second == general.second, ScriptErrorString(fast.second) + " != " + ScriptErrorString(general.second));
+                    if (mutation == 0 && (compressed || !(flags & SCRIPT_VERIFY_WITNESS_PUBKEYTYPE) || spend == StandardSpend::P2PKH)) {
+                        BOOST_CHECK(fast.first);
+                    }
+                }
+            }
+        }
+    }
+}
+
 static CMutableTransaction TxFromHex(const std::string& str)
 {
     CMutableTransaction tx;
@@ -1821,4 +1925,39 @@ BOOST_AUTO_TEST_CASE(bip341_keypath_test_vectors)
 
 }
 
+BOOST_AUTO_TEST_CASE(sign_transaction_many_inputs)
+{
+    // Enough inputs to be signed on several threads, spending from a few keys
+    std::vector<CKey> keys(3);
+    FillableSigningProvider keystore;
+    for (CKey& key : keys) {
+        key.MakeNewKey(true);
+        BOOST_CHECK(keystore.AddKey(key));
+    }
+    CMutableTransaction mtx;
+    std::map<COutPoint, Coin> coins;
+    for (int i = 0; i < 40; ++i) {
+        const COutPoint prevout{InsecureRand256(), 0};
+        mtx.vin.emplace_back(prevout);
+        const CKey& key{keys[i % keys.size()]};
+        const CScript script{i % 2 ? GetScriptForDestination(WitnessV0KeyHash(key.GetPubKey())) : GetScriptForDestination(PKHash(key.GetPubKey()))};
+        coins.emplace(prevout, Coin{CTxOut{CASH, 1000 + i, script}, 1, false});
+    }
+    // An input whose coin is unknown
+    mtx.vin.emplace_back(COutPoint{InsecureRand256(), 0});
+    mtx.vout.emplace_back(CASH, 1000, CScript{} << OP_TRUE);
+
+    std::map<int, bilingual_str> input_errors;
+    BOOST_CHECK(!SignTransaction(mtx, &keystore, coins, SIGHASH_ALL, input_errors));
+    BOOST_CHECK_EQUAL(input_errors.size(), 1U);
+    BOOST_CHECK(input_errors.count(40));
+
+    const CTransaction tx{mtx};
+    for (unsigned int i = 0; i < 40; ++i) {
+        const CTxOut& prevout{coins.at(tx.vin[i].prevout).out};
+        BOOST_CHECK(VerifyScript(tx.vin[i].scriptSig, prevout.scriptPubKey, &tx.vin[i].scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS,
+                                 MutableTransactionSignatureChecker(&mtx, i, prevout.amountType, prevout.nValue, MissingDataBehavior::FAIL)));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,7 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chain.h>
+#include <clientversion.h>
+#include <crypto/blake3.h>
 #include <hash.h>
+#include <primitives/block.h>
 #include <serialize.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
@@ -242,4 +246,70 @@ BOOST_AUTO_TEST_CASE(class_methods)
     BOOST_CHECK(methodtest3 == methodtest4);
 }
 
+BOOST_AUTO_TEST_CASE(block_header_buffer)
+{
+    for (int i = 0; i < 100; ++i) {
+        CBlockHeader header;
+        header.nVersion = InsecureRand32();
+        header.hashPrevBlock = InsecureRand256();
+        header.hashMerkleRoot = InsecureRand256();
+        header.nTime = InsecureRand32();
+        header.nBits = InsecureRand32();
+        header.cashSupply = g_insecure_rand_ctx.rand64();
+        header.bondSupply = g_insecure_rand_ctx.rand64();
+        header.nNonce = InsecureRand32();
+
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << header;
+        BOOST_REQUIRE_EQUAL(ss.size(), CBlockHeader::SERIALIZED_SIZE);
+        unsigned char buffer[CBlockHeader::SERIALIZED_SIZE];
+        header.SerializeToBuffer(buffer);
+        BOOST_CHECK_EQUAL(HexStr(buffer), HexStr(ss));
+
+        uint256 hash;
+        blake3_hasher hasher;
+        blake3_hasher_init(&hasher);
+        blake3_hasher_update(&hasher, UCharCast(ss.data()), ss.size());
+        blake3_hasher_finalize(&hasher, hash.begin(), BLAKE3_OUT_LEN);
+        BOOST_CHECK_EQUAL(header.GetHash(), hash);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(disk_block_index_scale_factor)
+{
+    LOCK(cs_main);
+    CBlockIndex index;
+    index.nHeight = 42;
+    index.nStatus = BLOCK_VALID_TREE;
+    index.nTx = 7;
+    index.cashSupply = 3 * COIN;
+    index.bondSupply = 5 * COIN;
+    index.scaleFactor = BASE_FACTOR + 12345;
+
+    // The scale factor round-trips, and the on-disk flag does not leak into nStatus
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << CDiskBlockIndex{&index};
+    CDiskBlockIndex loaded;
+    ss >> loaded;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK_EQUAL(loaded.nHeight, 42);
+    BOOST_CHECK_EQUAL(loaded.nStatus, (uint32_t)BLOCK_VALID_TREE);
+    BOOST_CHECK_EQUAL(loaded.nTx, 7U);
+    BOOST_CHECK_EQUAL(loaded.bondSupply, 5 * COIN);
+    BOOST_CHECK_EQUAL(loaded.scaleFactor, BASE_FACTOR + 12345);
+
+    // Entries written without a scale factor load it as zero
+    int version{CLIENT_VERSION};
+    uint32_t status{BLOCK_VALID_TREE};
+    CDataStream legacy(SER_DISK, CLIENT_VERSION);
+    legacy << VARINT_MODE(version, VarIntMode::NONNEGATIVE_SIGNED) << VARINT_MODE(index.nHeight, VarIntMode::NONNEGATIVE_SIGNED) << VARINT(status) << VARINT(index.nTx);
+    legacy << index.nVersion << uint256() << index.hashMerkleRoot << index.nTime << index.nBits << index.nNonce << index.cashSupply << index.bondSupply;
+    CDiskBlockIndex legacy_loaded;
+    legacy >> legacy_loaded;
+    BOOST_CHECK(legacy.empty());
+    BOOST_CHECK_EQUAL(legacy_loaded.nStatus, (uint32_t)BLOCK_VALID_TREE);
+    BOOST_CHECK_EQUAL(legacy_loaded.bondSupply, 5 * COIN);
+    BOOST_CHECK_EQUAL(legacy_loaded.scaleFactor, 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
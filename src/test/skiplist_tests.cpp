@@ -119,6 +119,14 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_test)
             vBlocksMain[i].nTimeMax = std::max(vBlocksMain[i].nTime, vBlocksMain[i-1].nTimeMax);
         }
     }
+    // Check that the cached median time past matches the computed one.
+    for (unsigned int i=0; i<vBlocksMain.size(); ++i) {
+        const int64_t medianTimePast = vBlocksMain[i].GetMedianTimePast();
+        vBlocksMain[i].BuildMedianTimePast();
+        BOOST_CHECK_EQUAL(vBlocksMain[i].nTimeMedian, medianTimePast);
+        BOOST_CHECK_EQUAL(vBlocksMain[i].GetMedianTimePast(), medianTimePast);
+    }
+
     // Check that we set nTimeMax up correctly.
     unsigned int curTimeMax = 0;
     for (unsigned int i=0; i<vBlocksMain.size(); ++i) {
@@ -187,4 +195,67 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_edge_test)
     BOOST_CHECK(ret2->nTimeMax >= 200 && ret2->nHeight == 4);
 }
 
+BOOST_AUTO_TEST_CASE(scalefactor_table_test)
+{
+    // Build a main chain and a branch splitting off at height 49, each with distinct scale factors.
+    std::vector<CBlockIndex> vBlocksMain(100);
+    for (unsigned int i = 0; i < vBlocksMain.size(); i++) {
+        vBlocksMain[i].nHeight = i;
+        vBlocksMain[i].pprev = i ? &vBlocksMain[i - 1] : nullptr;
+        vBlocksMain[i].scaleFactor = BASE_FACTOR + i;
+    }
+    std::vector<CBlockIndex> vBlocksSide(80);
+    for (unsigned int i = 0; i < vBlocksSide.size(); i++) {
+        vBlocksSide[i].nHeight = i + 50;
+        vBlocksSide[i].pprev = i ? &vBlocksSide[i - 1] : &vBlocksMain[49];
+        vBlocksSide[i].scaleFactor = 2 * BASE_FACTOR + i + 50;
+    }
+
+    CChain chain;
+    BOOST_CHECK_EQUAL(chain.GetScaleFactor(0), BASE_FACTOR);
+    chain.SetTip(vBlocksMain.back());
+    for (int height = 0; height <= chain.Height(); height++) {
+        BOOST_CHECK_EQUAL(chain.GetScaleFactor(height), chain[height]->scaleFactor);
+    }
+    BOOST_CHECK_EQUAL(chain.GetScaleFactor(-1), BASE_FACTOR);
+    BOOST_CHECK_EQUAL(chain.GetScaleFactor(100), BASE_FACTOR);
+
+    // Reorganize onto the longer branch, then disconnect back below the fork point.
+    chain.SetTip(vBlocksSide.back());
+    for (int height = 0; height <= chain.Height(); height++) {
+        BOOST_CHECK_EQUAL(chain.GetScaleFactor(height), chain[height]->scaleFactor);
+    }
+    BOOST_CHECK_EQUAL(chain.GetScaleFactor(100), 2 * BASE_FACTOR + 100);
+    chain.SetTip(vBlocksMain[20]);
+    BOOST_CHECK_EQUAL(chain.GetScaleFactor(20), BASE_FACTOR + 20);
+    BOOST_CHECK_EQUAL(chain.GetScaleFactor(21), BASE_FACTOR);
+}
+
+BOOST_AUTO_TEST_CASE(supply_views_test)
+{
+    CBlockIndex index;
+    index.cashSupply = 3 * COIN;
+    index.bondSupply = 7 * COIN;
+    index.scaleFactor = BASE_FACTOR * 3 / 2;
+    // Computed on demand until built
+    BOOST_CHECK_EQUAL(index.nInterestRate, -1);
+    const int64_t rate{index.GetInterestRate()};
+    const CAmounts scaled{index.GetScaledTotalSupply()};
+    BOOST_CHECK_EQUAL(rate, 4286);
+    BOOST_CHECK_EQUAL(scaled[CASH], ScaleAmount(index.cashSupply, index.scaleFactor));
+    BOOST_CHECK_EQUAL(scaled[BOND], ScaleAmount(index.bondSupply, index.scaleFactor));
+
+    index.BuildSupplyViews();
+    BOOST_CHECK_EQUAL(index.nInterestRate, rate);
+    BOOST_CHECK_EQUAL(index.GetInterestRate(), rate);
+    BOOST_CHECK(index.GetScaledTotalSupply() == scaled);
+
+    // No interest without bonds, whether computed on demand or built
+    CBlockIndex no_bonds;
+    no_bonds.cashSupply = COIN;
+    BOOST_CHECK_EQUAL(no_bonds.GetInterestRate(), 0);
+    no_bonds.BuildSupplyViews();
+    BOOST_CHECK_EQUAL(no_bonds.GetInterestRate(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
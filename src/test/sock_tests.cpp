@@ -113,6 +113,26 @@ BOOST_AUTO_TEST_CASE(send_and_receive)
     BOOST_CHECK(SocketIsClosed(s[1]));
 }
 
+BOOST_AUTO_TEST_CASE(send_many)
+{
+    int s[2];
+    CreateSocketPair(s);
+
+    Sock sender(s[0]);
+    Sock receiver(s[1]);
+
+    // The buffers are received in order, as a single stream
+    const std::vector<unsigned char> header{'a', 'b'};
+    const std::vector<unsigned char> payload{'c', 'd', 'e'};
+    const std::vector<Span<const unsigned char>> buffers{header, payload, Span{payload}.first(1)};
+    BOOST_CHECK_EQUAL(sender.SendMany({}, 0), 0);
+    BOOST_REQUIRE_EQUAL(sender.SendMany(buffers, 0), 6);
+
+    char buf[6];
+    BOOST_REQUIRE_EQUAL(receiver.Recv(buf, sizeof(buf), MSG_WAITALL), 6);
+    BOOST_CHECK_EQUAL(std::string(buf, sizeof(buf)), "abcdec");
+}
+
 BOOST_AUTO_TEST_CASE(wait)
 {
     int s[2];
@@ -128,6 +148,43 @@ BOOST_AUTO_TEST_CASE(wait)
     waiter.join();
 }
 
+BOOST_AUTO_TEST_CASE(sock_waiter)
+{
+    const std::unique_ptr<SockWaiter> waiter{MakeSockWaiter()};
+    Sock::EventsPerSock events_per_sock;
+    BOOST_CHECK(!waiter->WaitMany(0ms, events_per_sock));
+
+    for (int round = 0; round < 2; ++round) {
+        // Sockets closed since the previous round may have their descriptors reused
+        int s[2];
+        CreateSocketPair(s);
+        const auto sock0{std::make_shared<const Sock>(s[0])};
+        const auto sock1{std::make_shared<const Sock>(s[1])};
+
+        events_per_sock.clear();
+        events_per_sock.emplace(sock0, Sock::Events{Sock::RECV});
+        events_per_sock.emplace(sock1, Sock::Events{Sock::RECV});
+        BOOST_REQUIRE(waiter->WaitMany(0ms, events_per_sock));
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock0).occurred, 0);
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock1).occurred, 0);
+
+        BOOST_REQUIRE_EQUAL(sock1->Send("a", 1, 0), 1);
+        BOOST_REQUIRE(waiter->WaitMany(1min, events_per_sock));
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock0).occurred, Sock::RECV);
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock1).occurred, 0);
+
+        // Changes to the requested events are picked up
+        events_per_sock.at(sock0).requested = Sock::SEND;
+        BOOST_REQUIRE(waiter->WaitMany(1min, events_per_sock));
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock0).occurred, Sock::SEND);
+
+        // Sockets that are no longer waited on are not reported
+        events_per_sock.erase(sock0);
+        BOOST_REQUIRE(waiter->WaitMany(0ms, events_per_sock));
+        BOOST_CHECK_EQUAL(events_per_sock.at(sock1).occurred, 0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
 {
     constexpr auto timeout = 1min; // High enough so that it is never hit.
@@ -195,6 +195,27 @@ BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
     }
 }
 
+BOOST_AUTO_TEST_CASE(xor_word_at_a_time)
+{
+    // Compare against XORing one byte at a time, across key sizes that take the
+    // word path and ones that do not, and sizes around the word and block boundaries
+    for (const size_t key_size : {1, 2, 3, 4, 5, 8, 13}) {
+        std::vector<std::byte> key(key_size);
+        for (std::byte& b : key) b = std::byte(InsecureRandBits(8));
+        for (size_t size = 0; size < 80; ++size) {
+            const size_t key_offset{InsecureRandRange(2 * key_size)};
+            std::vector<std::byte> data(size);
+            for (std::byte& b : data) b = std::byte(InsecureRandBits(8));
+            std::vector<std::byte> expected{data};
+            for (size_t i = 0; i < size; ++i) {
+                expected[i] ^= key[(key_offset + i) % key_size];
+            }
+            util::Xor(data, key, key_offset);
+            BOOST_CHECK(data == expected);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(streams_buffered_file)
 {
     fs::path streams_test_filename = m_args.GetDataDirBase() / "streams_test_tmp";
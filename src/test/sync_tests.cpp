@@ -4,11 +4,16 @@
 
 #include <sync.h>
 #include <test/util/setup_common.h>
+#include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 template <typename MutexType>
@@ -140,4 +145,61 @@ BOOST_AUTO_TEST_CASE(inconsistent_lock_order_detected)
 #endif // DEBUG_LOCKORDER
 }
 
+BOOST_AUTO_TEST_CASE(lock_profiling)
+{
+    RecursiveMutex profiled;
+    Mutex unprofiled;
+    RegisterProfiledLock(&profiled, "profiled");
+    SetLockProfiling(1);
+
+    std::atomic<bool> held{false};
+    std::thread holder{[&] {
+        LOCK(profiled);
+        held = true;
+        UninterruptibleSleep(std::chrono::milliseconds{20});
+    }};
+    while (!held) std::this_thread::yield();
+    { LOCK(profiled); }
+    holder.join();
+    {
+        LOCK(profiled);
+        LOCK(profiled);
+    }
+    {
+        TRY_LOCK(profiled, lock);
+        BOOST_CHECK(lock.owns_lock());
+    }
+    { LOCK(unprofiled); }
+
+    // Other tests' locks may be registered as well
+    auto stats{GetLockProfileStats()};
+    stats.erase(std::remove_if(stats.begin(), stats.end(), [](const LockProfileStats& site) { return site.lock_name != "profiled"; }), stats.end());
+    BOOST_REQUIRE_EQUAL(stats.size(), 5U);
+    // Sorted by wait time, the contended acquisition first
+    BOOST_CHECK_EQUAL(stats[0].lock_name, "profiled");
+    BOOST_CHECK_EQUAL(stats[0].acquisitions, 1U);
+    BOOST_CHECK_EQUAL(stats[0].contentions, 1U);
+    BOOST_CHECK(stats[0].wait_time > std::chrono::nanoseconds{0});
+    BOOST_CHECK(stats[0].wait_time == stats[0].max_wait_time);
+    uint64_t acquisitions{0};
+    for (const LockProfileStats& site : stats) {
+        acquisitions += site.acquisitions;
+        BOOST_CHECK_EQUAL(site.hold_samples, site.acquisitions);
+    }
+    // The holder thread's hold covers the contended wait
+    BOOST_CHECK_EQUAL(acquisitions, 5U);
+    BOOST_CHECK(std::any_of(stats.begin(), stats.end(), [](const LockProfileStats& site) { return site.max_hold_time >= std::chrono::milliseconds{20}; }));
+
+    const auto profiled_sites{[] {
+        const auto stats{GetLockProfileStats()};
+        return std::count_if(stats.begin(), stats.end(), [](const LockProfileStats& site) { return site.lock_name == "profiled"; });
+    }};
+    ResetLockProfileStats();
+    BOOST_CHECK_EQUAL(profiled_sites(), 0);
+    UnregisterProfiledLock(&profiled);
+    { LOCK(profiled); }
+    BOOST_CHECK_EQUAL(profiled_sites(), 0);
+    SetLockProfiling(0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
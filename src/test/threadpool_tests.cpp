@@ -0,0 +1,240 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/thread.h>
+#include <util/threadpool.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using util::TaskPool;
+using util::TaskPoolStats;
+using util::TaskPriority;
+using util::ThreadPool;
+
+static ThreadPool::Options PoolOptions(int threads)
+{
+    ThreadPool::Options options;
+    options.name = "testpool";
+    options.threads = threads;
+    return options;
+}
+
+static TaskPoolStats GetStats(const ThreadPool& pool, const std::string& name)
+{
+    for (const TaskPoolStats& stats : pool.GetStats()) {
+        if (stats.name == name) return stats;
+    }
+    BOOST_FAIL("Unknown task pool " + name);
+    return {};
+}
+
+BOOST_FIXTURE_TEST_SUITE(threadpool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(threadpool_runs_tasks)
+{
+    ThreadPool pool{PoolOptions(4)};
+    BOOST_CHECK_EQUAL(pool.GetThreadCount(), 4);
+    BOOST_CHECK(!pool.IsWorkerThread());
+
+    const TaskPool tasks{pool, "tasks", TaskPriority::NORMAL};
+    std::atomic<int> counter{0};
+    std::atomic<int> on_worker{0};
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(tasks.Submit([&] {
+            ++counter;
+            if (pool.IsWorkerThread()) ++on_worker;
+            // Tasks queued from a worker go to its own queue
+            tasks.Post([&] { ++counter; });
+        }));
+    }
+    for (auto& future : futures) future.wait();
+    pool.Stop();
+    BOOST_CHECK_EQUAL(counter, 200);
+    BOOST_CHECK_EQUAL(on_worker, 100);
+
+    const TaskPoolStats stats{GetStats(pool, "tasks")};
+    BOOST_CHECK(stats.priority == TaskPriority::NORMAL);
+    BOOST_CHECK_EQUAL(stats.tasks_run, 200U);
+    BOOST_CHECK_LE(stats.tasks_stolen, stats.tasks_run);
+    BOOST_CHECK_EQUAL(stats.queued, 0U);
+    BOOST_CHECK_EQUAL(stats.running, 0U);
+
+    // Once stopped, tasks are run by the caller
+    bool ran{false};
+    tasks.Submit([&] { ran = true; }).wait();
+    BOOST_CHECK(ran);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_priorities)
+{
+    ThreadPool pool{PoolOptions(1)};
+    const TaskPool high{pool, "high", TaskPriority::HIGH};
+    const TaskPool normal{pool, "normal", TaskPriority::NORMAL};
+    const TaskPool low{pool, "low", TaskPriority::LOW};
+
+    // Keep the only worker busy until all tasks are queued
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::future<void> blocker{normal.Submit([released] { released.wait(); })};
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    const auto record{[&](std::string name) {
+        return [&, name] {
+            std::lock_guard<std::mutex> lock{mutex};
+            order.push_back(name);
+        };
+    }};
+    low.Post(record("low1"));
+    normal.Post(record("normal1"));
+    high.Post(record("high1"));
+    low.Post(record("low2"));
+    high.Post(record("high2"));
+    release.set_value();
+    blocker.wait();
+    pool.Stop();
+
+    const std::vector<std::string> expected{"high1", "high2", "normal1", "low1", "low2"};
+    BOOST_CHECK(order == expected);
+    BOOST_CHECK_EQUAL(GetStats(pool, "high").tasks_run, 2U);
+    BOOST_CHECK_EQUAL(GetStats(pool, "low").tasks_run, 2U);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_low_priority_limit)
+{
+    // Low priority tasks may occupy at most half of the workers
+    ThreadPool pool{PoolOptions(4)};
+    const TaskPool low{pool, "low", TaskPriority::LOW};
+    const TaskPool high{pool, "high", TaskPriority::HIGH};
+
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::atomic<int> started{0};
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 3; ++i) {
+        futures.push_back(low.Submit([&started, released] {
+            ++started;
+            released.wait();
+        }));
+    }
+    while (started < 2) std::this_thread::yield();
+
+    // The other workers still run the other tasks
+    for (int i = 0; i < 10; ++i) {
+        high.Submit([] {}).wait();
+    }
+    BOOST_CHECK_EQUAL(started, 2);
+    BOOST_CHECK_EQUAL(GetStats(pool, "low").queued, 1U);
+    BOOST_CHECK_EQUAL(GetStats(pool, "low").running, 2U);
+
+    release.set_value();
+    for (auto& future : futures) future.wait();
+    BOOST_CHECK_EQUAL(started, 3);
+    BOOST_CHECK_EQUAL(GetStats(pool, "high").tasks_run, 10U);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_stop_runs_queued_tasks)
+{
+    ThreadPool pool{PoolOptions(2)};
+    const TaskPool tasks{pool, "tasks", TaskPriority::LOW};
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 50; ++i) {
+        tasks.Post([&] {
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+            ++counter;
+        });
+    }
+    pool.Stop();
+    BOOST_CHECK_EQUAL(counter, 50);
+    BOOST_CHECK_EQUAL(GetStats(pool, "tasks").tasks_run, 50U);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_parallel_for)
+{
+    ThreadPool pool{PoolOptions(3)};
+    const TaskPool tasks{pool, "tasks", TaskPriority::HIGH};
+
+    // Every index is visited once, with and without a pool
+    for (const TaskPool* task_pool : {&tasks, static_cast<const TaskPool*>(nullptr)}) {
+        std::vector<int> visits(1000, 0);
+        util::ParallelFor(task_pool, visits.size(), 4, [&](size_t i) { ++visits[i]; });
+        for (const int count : visits) BOOST_CHECK_EQUAL(count, 1);
+    }
+
+    // The first exception stops further calls and is rethrown on the caller
+    std::atomic<size_t> calls{0};
+    BOOST_CHECK_EXCEPTION(util::ParallelFor(&tasks, 1000, 4, [&](size_t i) {
+        ++calls;
+        if (i == 10) throw std::runtime_error("failed");
+    }), std::runtime_error, HasReason("failed"));
+    BOOST_CHECK_LT(calls, 1000U);
+
+    // Calls from workers complete while all other workers are busy
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::vector<std::future<void>> blockers;
+    for (int i = 0; i < 2; ++i) {
+        blockers.push_back(tasks.Submit([released] { released.wait(); }));
+    }
+    std::atomic<int> sum{0};
+    tasks.Submit([&] { util::ParallelFor(&tasks, 100, 3, [&](size_t i) { sum += i; }); }).wait();
+    BOOST_CHECK_EQUAL(sum, 4950);
+    release.set_value();
+    for (auto& future : blockers) future.wait();
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_shared_pool)
+{
+    // Without a shared pool, all calls are made on the calling thread
+    const std::thread::id caller{std::this_thread::get_id()};
+    std::atomic<int> elsewhere{0};
+    util::ParallelFor("tasks", TaskPriority::NORMAL, 100, 4, [&](size_t) {
+        if (std::this_thread::get_id() != caller) ++elsewhere;
+    });
+    BOOST_CHECK_EQUAL(elsewhere, 0);
+
+    ThreadPool pool{PoolOptions(2)};
+    util::SetSharedThreadPool(&pool);
+    std::vector<int> visits(1000, 0);
+    util::ParallelFor("tasks", TaskPriority::NORMAL, visits.size(), 8, [&](size_t i) { ++visits[i]; });
+    for (const int count : visits) BOOST_CHECK_EQUAL(count, 1);
+    BOOST_CHECK_THROW(util::ParallelFor("tasks", TaskPriority::NORMAL, 10, 8, [](size_t) { throw std::runtime_error("failed"); }), std::runtime_error);
+    // A failed call doesn't keep the pool from being cleared
+    util::SetSharedThreadPool(nullptr);
+    pool.Stop();
+    BOOST_CHECK_GT(GetStats(pool, "tasks").tasks_run, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_parse_cpu_set)
+{
+    using Cpus = std::vector<unsigned int>;
+    BOOST_CHECK(util::ParseCpuSet("3") == Cpus({3}));
+    BOOST_CHECK(util::ParseCpuSet("4-6, 0,5") == Cpus({0, 4, 5, 6}));
+    BOOST_CHECK(util::ParseCpuSet(" 2 - 3 ") == Cpus({2, 3}));
+    for (const std::string invalid : {"", ",", "a", "-1", "3-1", "1-2-3", "1-", "4096", "node", "nodex"}) {
+        BOOST_CHECK_MESSAGE(!util::ParseCpuSet(invalid), invalid);
+    }
+
+    // Workers pinned to a set of CPUs still run the tasks
+    ThreadPool::Options options{PoolOptions(2)};
+    options.cpus = {0};
+    ThreadPool pool{options};
+    const TaskPool tasks{pool, "tasks", TaskPriority::NORMAL};
+    bool ran{false};
+    tasks.Submit([&] { ran = true; }).wait();
+    BOOST_CHECK(ran);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,7 @@
 #include <consensus/tx_check.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <hash.h>
 #include <key.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
@@ -964,4 +965,111 @@ BOOST_AUTO_TEST_CASE(test_IsStandard)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_CheckTransactionContainsOutputs)
+{
+    const CScript script_a = CScript() << OP_1;
+    const CScript script_b = CScript() << OP_2;
+
+    CMutableTransaction mtx;
+    mtx.vout.emplace_back(CASH, 3 * CENT, script_a);
+    mtx.vout.emplace_back(BOND, 5 * CENT, script_a);
+    mtx.vout.emplace_back(CASH, 7 * CENT, script_b);
+    mtx.vout.emplace_back(CASH, 1 * CENT, script_b);
+    const CTransaction tx{mtx};
+
+    std::string address;
+    BOOST_CHECK(CheckTransactionContainsOutputs(tx, {}, address));
+    // Amounts paid to the same pair are summed, and unexpected outputs are ignored
+    BOOST_CHECK(CheckTransactionContainsOutputs(tx, {CTxOut(CASH, 5 * CENT, script_b), CTxOut(CASH, 3 * CENT, script_b)}, address));
+    BOOST_CHECK(CheckTransactionContainsOutputs(tx, {CTxOut(BOND, 5 * CENT, script_a)}, address));
+    BOOST_CHECK(address.empty());
+
+    // The amount type is part of the key
+    BOOST_CHECK(!CheckTransactionContainsOutputs(tx, {CTxOut(BOND, 3 * CENT, script_a)}, address));
+    BOOST_CHECK_EQUAL(address, HexStr(script_a));
+    BOOST_CHECK(!CheckTransactionContainsOutputs(tx, {CTxOut(CASH, 7 * CENT, script_b)}, address));
+    BOOST_CHECK_EQUAL(address, HexStr(script_b));
+    BOOST_CHECK(!CheckTransactionContainsOutputs(tx, {CTxOut(CASH, 1 * CENT, CScript() << OP_3)}, address));
+}
+
+BOOST_AUTO_TEST_CASE(test_CheckTransactionContainsOutputs_collisions)
+{
+    // Scripts that all hash to the first slot of the table built for 40 outputs (128 slots), so
+    // that they do not fit within the probe limit
+    std::vector<CTxOut> outputs;
+    for (int64_t i = 0; outputs.size() < 40; ++i) {
+        const CScript script = CScript() << i;
+        if ((MurmurHash3(CASH, script) & 127) == 0) outputs.emplace_back(CASH, (i % 7 + 1) * CENT, script);
+    }
+
+    CMutableTransaction mtx;
+    mtx.vout.emplace_back(BOND, 1 * CENT, outputs[0].scriptPubKey);
+    mtx.vout.insert(mtx.vout.end(), outputs.rbegin(), outputs.rend());
+    std::string address;
+    BOOST_CHECK(CheckTransactionContainsOutputs(CTransaction{mtx}, outputs, address));
+    BOOST_CHECK(address.empty());
+
+    mtx.vout.back().nValue += 1;
+    BOOST_CHECK(!CheckTransactionContainsOutputs(CTransaction{mtx}, outputs, address));
+    BOOST_CHECK_EQUAL(address, HexStr(outputs.front().scriptPubKey));
+}
+
+BOOST_AUTO_TEST_CASE(make_transaction_refs)
+{
+    // Transactions of many sizes, with and without witnesses
+    std::vector<CMutableTransaction> txs;
+    for (int i = 0; i < 50; ++i) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = i;
+        for (int j = 0, n = InsecureRandRange(4) + 1; j < n; ++j) {
+            mtx.vin.emplace_back(InsecureRand256(), InsecureRand32(), CScript() << g_insecure_rand_ctx.randbytes(InsecureRandRange(200)));
+            if (i % 3 == 0) mtx.vin.back().scriptWitness.stack.push_back(g_insecure_rand_ctx.randbytes(InsecureRandRange(300)));
+        }
+        for (int j = 0, n = InsecureRandRange(4) + 1; j < n; ++j) {
+            mtx.vout.emplace_back(j % 2 ? BOND : CASH, InsecureRandRange(COIN), CScript() << g_insecure_rand_ctx.randbytes(InsecureRandRange(100)));
+        }
+        txs.push_back(mtx);
+    }
+    std::vector<CTransactionRef> expected;
+    for (const CMutableTransaction& mtx : txs) expected.push_back(MakeTransactionRef(mtx));
+
+    const std::vector<CTransactionRef> refs{MakeTransactionRefs(std::move(txs))};
+    BOOST_REQUIRE_EQUAL(refs.size(), expected.size());
+    for (size_t i = 0; i < refs.size(); ++i) {
+        BOOST_CHECK_EQUAL(refs[i]->GetHash(), expected[i]->GetHash());
+        BOOST_CHECK_EQUAL(refs[i]->GetWitnessHash(), expected[i]->GetWitnessHash());
+        BOOST_CHECK_EQUAL(refs[i]->GetWeight(), expected[i]->GetWeight());
+        BOOST_CHECK_EQUAL(refs[i]->HasWitness(), expected[i]->HasWitness());
+        BOOST_CHECK(*refs[i] == *expected[i]);
+    }
+    BOOST_CHECK(MakeTransactionRefs({}).empty());
+
+    // The recorded sizes match serialization, and so do the block sizes
+    // built from them
+    for (size_t i = 0; i < refs.size(); ++i) {
+        BOOST_CHECK_EQUAL(refs[i]->GetStrippedSize(), ::GetSerializeSize(*expected[i], PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
+        BOOST_CHECK_EQUAL(refs[i]->GetTotalSize(), ::GetSerializeSize(*expected[i], PROTOCOL_VERSION));
+        BOOST_CHECK_EQUAL(refs[i]->GetStrippedSize(), expected[i]->GetStrippedSize());
+        BOOST_CHECK_EQUAL(refs[i]->GetTotalSize(), expected[i]->GetTotalSize());
+    }
+
+    // Blocks are read through MakeTransactionRefs
+    CBlock block;
+    block.vtx = expected;
+    const int64_t stripped_size(::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
+    const int64_t total_size(::GetSerializeSize(block, PROTOCOL_VERSION));
+    BOOST_CHECK_EQUAL(GetBlockStrippedSize(block), stripped_size);
+    BOOST_CHECK_EQUAL(GetBlockTotalSize(block), total_size);
+    BOOST_CHECK_EQUAL(GetBlockWeight(block), stripped_size * (WITNESS_SCALE_FACTOR - 1) + total_size);
+    CDataStream stream{SER_NETWORK, PROTOCOL_VERSION};
+    stream << block;
+    CBlock read;
+    stream >> read;
+    BOOST_REQUIRE_EQUAL(read.vtx.size(), expected.size());
+    for (size_t i = 0; i < read.vtx.size(); ++i) {
+        BOOST_CHECK_EQUAL(read.vtx[i]->GetWitnessHash(), expected[i]->GetWitnessHash());
+        BOOST_CHECK_EQUAL(read.vtx[i]->GetWeight(), expected[i]->GetWeight());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
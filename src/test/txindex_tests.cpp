@@ -69,6 +69,24 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
         }
     }
 
+    // Check that transactions are looked up together, in the order requested.
+    std::vector<uint256> tx_hashes;
+    for (auto it = m_coinbase_txns.rbegin(); it != m_coinbase_txns.rend(); ++it) {
+        tx_hashes.push_back((*it)->GetHash());
+    }
+    tx_hashes.push_back(InsecureRand256());
+    tx_hashes.push_back(genesis_block.vtx[0]->GetHash());
+    const auto results{txindex.FindTxs(tx_hashes)};
+    BOOST_REQUIRE_EQUAL(results.size(), tx_hashes.size());
+    for (size_t i = 0; i < m_coinbase_txns.size(); ++i) {
+        BOOST_REQUIRE(results[i].second);
+        BOOST_CHECK_EQUAL(results[i].second->GetHash(), tx_hashes[i]);
+        BOOST_CHECK(txindex.FindTx(tx_hashes[i], block_hash, tx_disk));
+        BOOST_CHECK_EQUAL(results[i].first, block_hash);
+    }
+    BOOST_CHECK(!results[m_coinbase_txns.size()].second);
+    BOOST_CHECK(!results[m_coinbase_txns.size() + 1].second);
+
     // shutdown sequence (c.f. Shutdown() in init.cpp)
     txindex.Stop();
 
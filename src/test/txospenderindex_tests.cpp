@@ -0,0 +1,75 @@
+// Copyright (c) 2023 Josh Doman
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <consensus/validation.h>
+#include <index/txospenderindex.h>
+#include <interfaces/chain.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txospenderindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(txospenderindex_initial_sync, TestChain100Setup)
+{
+    TxoSpenderIndex txospenderindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    const CScript script_pub_key{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+
+    // Spend a coinbase before the index is started, and another one after
+    std::vector<CMutableTransaction> spends;
+    for (int i = 0; i < 2; ++i) {
+        spends.push_back(CreateValidMempoolTransaction(m_coinbase_txns[i], /*input_vout=*/0, /*input_height=*/i + 1, coinbaseKey,
+                                                       script_pub_key, /*output_amount=*/CAmount(49 * COIN), /*submit=*/false));
+    }
+    const CBlock block1{CreateAndProcessBlock({spends[0]}, script_pub_key)};
+
+    BOOST_REQUIRE(txospenderindex.Start());
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txospenderindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    const CBlock block2{CreateAndProcessBlock({spends[1]}, script_pub_key)};
+    BOOST_CHECK(txospenderindex.BlockUntilSyncedToCurrentChain());
+
+    for (int i = 0; i < 2; ++i) {
+        const auto spender{txospenderindex.FindSpender(spends[i].vin[0].prevout)};
+        BOOST_REQUIRE(spender);
+        BOOST_CHECK_EQUAL(spender->tx->GetHash(), spends[i].GetHash());
+        BOOST_CHECK_EQUAL(spender->block_hash, (i == 0 ? block1 : block2).GetHash());
+        BOOST_CHECK_EQUAL(spender->height, 101 + i);
+    }
+
+    // Unspent outputs, including the outputs of the spends, have no spender
+    BOOST_CHECK(!txospenderindex.FindSpender(COutPoint{m_coinbase_txns[2]->GetHash(), 0}));
+    BOOST_CHECK(!txospenderindex.FindSpender(COutPoint{spends[0].GetHash(), 0}));
+    BOOST_CHECK(!txospenderindex.FindSpender(COutPoint{spends[0].vin[0].prevout.hash, 1}));
+
+    // The outputs spent by a disconnected block are unspent again
+    {
+        BlockValidationState state;
+        CBlockIndex* tip{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip())};
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    CreateAndProcessBlock({}, script_pub_key);
+    BOOST_CHECK(txospenderindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(txospenderindex.FindSpender(spends[0].vin[0].prevout));
+    BOOST_CHECK(!txospenderindex.FindSpender(spends[1].vin[0].prevout));
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    txospenderindex.Stop();
+
+    // Let scheduler events finish running to avoid accessing any memory related to the index after it is destructed
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -702,6 +702,15 @@ BOOST_FIXTURE_TEST_CASE(package_cpfp_tests, TestChain100Setup)
     CTransactionRef tx_child_cheap = MakeTransactionRef(mtx_child_cheap);
     package_still_too_low.push_back(tx_child_cheap);
 
+    // The cheap parent on its own is rejected for its feerate alone, so it may be reconsidered
+    // in a package.
+    {
+        const auto result_parent_cheap = m_node.chainman->ProcessTransaction(tx_parent_cheap, /*test_accept=*/true);
+        BOOST_CHECK(result_parent_cheap.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+        BOOST_CHECK(result_parent_cheap.m_state.GetResult() == TxValidationResult::TX_RECONSIDERABLE);
+        BOOST_CHECK_EQUAL(result_parent_cheap.m_state.GetRejectReason(), "min relay fee not met");
+    }
+
     // Cheap package should fail with package-fee-too-low.
     {
         BOOST_CHECK_EQUAL(m_node.mempool->size(), expected_pool_size);
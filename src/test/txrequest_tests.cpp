@@ -735,4 +735,41 @@ BOOST_AUTO_TEST_CASE(TxRequestTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ReceivedInvsTest)
+{
+    TxRequestTracker bulk(/*deterministic=*/true);
+    TxRequestTracker single(/*deterministic=*/true);
+    const GenTxid gtxid1{GenTxid::Wtxid(InsecureRand256())};
+    const GenTxid gtxid2{GenTxid::Wtxid(InsecureRand256())};
+    const GenTxid gtxid3{GenTxid::Txid(InsecureRand256())};
+
+    // A batch, including a duplicate and an empty one, is equivalent to announcing its entries one at a time.
+    const std::vector<std::pair<NodeId, std::vector<GenTxid>>> invs{
+        {0, {gtxid1, gtxid2, gtxid1}},
+        {1, {}},
+        {1, {gtxid2, gtxid3}},
+        {0, {gtxid3, gtxid2}},
+    };
+    for (const auto& [peer, gtxids] : invs) {
+        bulk.ReceivedInvs(peer, gtxids, /*preferred=*/true, MIN_TIME);
+        for (const GenTxid& gtxid : gtxids) single.ReceivedInv(peer, gtxid, /*preferred=*/true, MIN_TIME);
+        bulk.SanityCheck();
+    }
+    BOOST_CHECK_EQUAL(bulk.Size(), 5U);
+    BOOST_CHECK_EQUAL(bulk.Size(), single.Size());
+    for (NodeId peer : {0, 1, 2}) {
+        BOOST_CHECK_EQUAL(bulk.Count(peer), single.Count(peer));
+        BOOST_CHECK(bulk.GetRequestable(peer, NO_TIME) == single.GetRequestable(peer, NO_TIME));
+    }
+
+    // Interned txhashes are released again once their announcements are gone.
+    bulk.ForgetTxHash(gtxid1.GetHash());
+    bulk.DisconnectedPeer(0);
+    bulk.SanityCheck();
+    BOOST_CHECK_EQUAL(bulk.Size(), 2U);
+    bulk.DisconnectedPeer(1);
+    bulk.SanityCheck();
+    BOOST_CHECK_EQUAL(bulk.Size(), 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,13 +3,18 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <consensus/validation.h>
+#include <key.h>
 #include <key_io.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
+#include <script/interpreter.h>
 #include <script/script.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
+#include <txmempool.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
@@ -49,4 +54,197 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "coinbase");
     BOOST_CHECK(result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
+
+/**
+ * Ensure that a batch of transactions is accepted as if each was submitted in order.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_accept_batch, TestChain100Setup)
+{
+    CKey parent_key;
+    parent_key.MakeNewKey(true);
+    const CScript parent_script{GetScriptForDestination(PKHash(parent_key.GetPubKey()))};
+    const CScript child_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+
+    // Two independent parents, a child of the first one, a transaction with an invalid signature
+    // and a copy of the second parent
+    const CTransactionRef tx_parent1{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, parent_script, CAmount(49 * COIN), /*submit=*/false))};
+    const CTransactionRef tx_parent2{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[1], 0, 0, coinbaseKey, parent_script, CAmount(49 * COIN), /*submit=*/false))};
+    const CTransactionRef tx_child{MakeTransactionRef(CreateValidMempoolTransaction(tx_parent1, 0, 101, parent_key, child_script, CAmount(48 * COIN), /*submit=*/false))};
+    const CTransactionRef tx_bad_sig{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[2], 0, 0, parent_key, parent_script, CAmount(49 * COIN), /*submit=*/false))};
+    const std::vector<CTransactionRef> txns{tx_parent1, tx_parent2, tx_child, tx_bad_sig, tx_parent2};
+
+    LOCK(cs_main);
+    unsigned int initialPoolSize = m_node.mempool->size();
+    const auto results{AcceptToMemoryPoolBatch(m_node.chainman->ActiveChainstate(), txns, std::vector<int64_t>(txns.size(), GetTime()), /*bypass_limits=*/false)};
+    BOOST_REQUIRE_EQUAL(results.size(), txns.size());
+    for (size_t i = 0; i < 3; ++i) {
+        BOOST_CHECK_MESSAGE(results[i].m_result_type == MempoolAcceptResult::ResultType::VALID, results[i].m_state.ToString());
+        BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(txns[i]->GetHash())));
+    }
+    BOOST_CHECK(results[3].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK(results[3].m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
+    BOOST_CHECK(!m_node.mempool->exists(GenTxid::Txid(tx_bad_sig->GetHash())));
+    BOOST_CHECK(results[4].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(results[4].m_state.GetRejectReason(), "txn-already-in-mempool");
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 3);
+}
+
+/**
+ * Ensure that a round of independent transactions, whose scripts are checked together on the
+ * script check queue, gets the same results as when their scripts are checked one by one.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_accept_batch_script_check_queue, TestChain100Setup)
+{
+    BOOST_REQUIRE(g_parallel_script_checks);
+    CKey other_key;
+    other_key.MakeNewKey(true);
+    const CScript script{GetScriptForDestination(PKHash(other_key.GetPubKey()))};
+
+    // Independent transactions, so that they all end up in the same round, one of them with an
+    // invalid signature so that the queued checks of the round fail
+    std::vector<CTransactionRef> txns;
+    for (size_t i = 0; i < 4; ++i) {
+        const CKey& key{i == 2 ? other_key : coinbaseKey};
+        txns.push_back(MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[i], 0, 0, key, script, CAmount(49 * COIN), /*submit=*/false)));
+    }
+    const auto check_results{[&](const std::vector<MempoolAcceptResult>& results) {
+        BOOST_REQUIRE_EQUAL(results.size(), txns.size());
+        for (size_t i = 0; i < txns.size(); ++i) {
+            if (i == 2) {
+                BOOST_CHECK(results[i].m_result_type == MempoolAcceptResult::ResultType::INVALID);
+                BOOST_CHECK(results[i].m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
+                BOOST_CHECK(!m_node.mempool->exists(GenTxid::Txid(txns[i]->GetHash())));
+            } else {
+                BOOST_CHECK_MESSAGE(results[i].m_result_type == MempoolAcceptResult::ResultType::VALID, results[i].m_state.ToString());
+                BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(txns[i]->GetHash())));
+            }
+        }
+    }};
+
+    LOCK(cs_main);
+    const unsigned int initial_pool_size = m_node.mempool->size();
+    check_results(AcceptToMemoryPoolBatch(m_node.chainman->ActiveChainstate(), txns, std::vector<int64_t>(txns.size(), GetTime()), /*bypass_limits=*/false));
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initial_pool_size + 3);
+
+    // The same round again, with the scripts checked one by one
+    for (const CTransactionRef& tx : txns) {
+        WITH_LOCK(m_node.mempool->cs, m_node.mempool->removeRecursive(*tx, MemPoolRemovalReason::CONFLICT));
+    }
+    BOOST_REQUIRE_EQUAL(m_node.mempool->size(), initial_pool_size);
+    g_parallel_script_checks = false;
+    check_results(AcceptToMemoryPoolBatch(m_node.chainman->ActiveChainstate(), txns, std::vector<int64_t>(txns.size(), GetTime()), /*bypass_limits=*/false));
+    g_parallel_script_checks = true;
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initial_pool_size + 3);
+}
+
+/**
+ * Ensure that the scripts of a transaction with many inputs, which are checked on the script check
+ * queue, are rejected with the same reason as when they are checked serially.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_accept_many_inputs, TestChain100Setup)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript script{GetScriptForDestination(PKHash(key.GetPubKey()))};
+
+    const auto sign = [](CMutableTransaction& mtx, const CKey& signing_key, const CTransaction& input_tx) {
+        FillableSigningProvider keystore;
+        keystore.AddKey(signing_key);
+        std::map<COutPoint, Coin> input_coins;
+        for (const CTxIn& txin : mtx.vin) {
+            input_coins.emplace(txin.prevout, Coin{input_tx.vout[txin.prevout.n], 1, false});
+        }
+        std::map<int, bilingual_str> input_errors;
+        BOOST_REQUIRE(SignTransaction(mtx, &keystore, input_coins, SIGHASH_ALL, input_errors));
+    };
+
+    // Split a coinbase output into 20 outputs and spend them all in one transaction
+    CMutableTransaction fan_out;
+    fan_out.vin.emplace_back(COutPoint{m_coinbase_txns[0]->GetHash(), 0});
+    for (int i = 0; i < 20; ++i) fan_out.vout.emplace_back(2 * COIN, script);
+    sign(fan_out, coinbaseKey, *m_coinbase_txns[0]);
+    const CTransaction fan_out_tx{fan_out};
+
+    CMutableTransaction consolidation;
+    for (uint32_t i = 0; i < fan_out_tx.vout.size(); ++i) consolidation.vin.emplace_back(COutPoint{fan_out_tx.GetHash(), i});
+    consolidation.vout.emplace_back(39 * COIN, script);
+    sign(consolidation, key, fan_out_tx);
+    CMutableTransaction bad_sig{consolidation};
+    bad_sig.vin[10].scriptSig = bad_sig.vin[11].scriptSig;
+
+    LOCK(cs_main);
+    BOOST_CHECK(m_node.chainman->ProcessTransaction(MakeTransactionRef(fan_out_tx)).m_result_type == MempoolAcceptResult::ResultType::VALID);
+
+    const MempoolAcceptResult bad_result{m_node.chainman->ProcessTransaction(MakeTransactionRef(bad_sig))};
+    BOOST_CHECK(bad_result.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK(bad_result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
+    BOOST_CHECK_EQUAL(bad_result.m_state.GetRejectReason(), "mandatory-script-verify-flag-failed (Signature must be zero for failed CHECK(MULTI)SIG operation)");
+
+    const MempoolAcceptResult result{m_node.chainman->ProcessTransaction(MakeTransactionRef(consolidation))};
+    BOOST_CHECK_MESSAGE(result.m_result_type == MempoolAcceptResult::ResultType::VALID, result.m_state.ToString());
+    BOOST_CHECK(m_node.mempool->exists(GenTxid::Txid(consolidation.GetHash())));
+}
+
+/**
+ * Ensure that mempool entries keep the signature hashing data they were validated with.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_precomputed_txdata, TestChain100Setup)
+{
+    const CScript script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction mtx{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, CAmount(49 * COIN))};
+    {
+        LOCK2(cs_main, m_node.mempool->cs);
+        const auto txdata{m_node.mempool->GetPrecomputedTxData(CTransaction{mtx}.GetWitnessHash())};
+        BOOST_REQUIRE(txdata);
+        BOOST_CHECK(txdata->m_spent_outputs_ready);
+        BOOST_REQUIRE_EQUAL(txdata->m_spent_outputs.size(), 1U);
+        BOOST_CHECK(txdata->m_spent_outputs[0] == m_coinbase_txns[0]->vout[0]);
+        BOOST_CHECK(!m_node.mempool->GetPrecomputedTxData(m_coinbase_txns[1]->GetWitnessHash()));
+    }
+
+    // A block connecting the transaction reuses it, and the mempool lets go of it
+    const CBlock block{CreateAndProcessBlock({mtx}, script)};
+    LOCK2(cs_main, m_node.mempool->cs);
+    BOOST_CHECK_EQUAL(m_node.chainman->ActiveChain().Tip()->GetBlockHash(), block.GetHash());
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 0U);
+    BOOST_CHECK(!m_node.mempool->GetPrecomputedTxData(block.vtx[1]->GetWitnessHash()));
+}
+
+/**
+ * Ensure that the mempool checks, which mostly only check the entries that changed since
+ * the last check, pass while a chain of transactions is added, prioritised and mined.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_incremental_check, TestChain100Setup)
+{
+    CTxMemPool& pool{*m_node.mempool};
+    const auto check_pool{[&] {
+        LOCK(cs_main);
+        Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+        pool.check(chainstate.CoinsTip(), chainstate.m_chain.Height() + 1);
+    }};
+
+    // Every submission is followed by a check, of the entries it added or changed
+    const CScript script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    std::vector<CMutableTransaction> chain;
+    chain.push_back(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, CAmount(49 * COIN)));
+    for (int i = 1; i < 10; ++i) {
+        chain.push_back(CreateValidMempoolTransaction(MakeTransactionRef(chain.back()), 0, 0, coinbaseKey, script, CAmount((49 - i) * COIN)));
+    }
+    BOOST_CHECK_EQUAL(pool.size(), chain.size());
+
+    // Prioritising the middle of the chain changes its ancestors and descendants
+    pool.PrioritiseTransaction(chain[5].GetHash(), COIN);
+    check_pool();
+
+    // Run through a full check and back to checking changed entries
+    for (int i = 0; i < CTxMemPool::FULL_CHECK_INTERVAL; ++i) {
+        check_pool();
+    }
+
+    // Mining the start of the chain updates the ancestor state of the rest
+    CreateAndProcessBlock({chain[0], chain[1]}, script);
+    BOOST_CHECK_EQUAL(pool.size(), chain.size() - 2);
+    check_pool();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -43,6 +43,7 @@
 #include <util/string.h>
 #include <util/thread.h>
 #include <util/threadnames.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/translation.h>
 #include <util/url.h>
@@ -183,7 +184,7 @@ ChainTestingSetup::ChainTestingSetup(const std::string& chainName, const std::ve
     // We have to run a scheduler thread to prevent ActivateBestChain
     // from blocking due to queue overrun.
     m_node.scheduler = std::make_unique<CScheduler>();
-    m_node.scheduler->m_service_thread = std::thread(util::TraceThread, "scheduler", [&] { m_node.scheduler->serviceQueue(); });
+    m_node.scheduler->m_service_threads.emplace_back(util::TraceThread, "scheduler", [&] { m_node.scheduler->serviceQueue(); });
     GetMainSignals().RegisterBackgroundSignalScheduler(*m_node.scheduler);
 
     m_node.fee_estimator = std::make_unique<CBlockPolicyEstimator>(FeeestPath(*m_node.args));
@@ -198,9 +199,13 @@ ChainTestingSetup::ChainTestingSetup(const std::string& chainName, const std::ve
     m_node.chainman = std::make_unique<ChainstateManager>(chainman_opts);
     m_node.chainman->m_blockman.m_block_tree_db = std::make_unique<CBlockTreeDB>(m_cache_sizes.block_tree_db, true);
 
-    // Start script-checking threads. Set g_parallel_script_checks to true so they are used.
+    // Start the thread pool and the script-checking workers on it. Set g_parallel_script_checks to true so they are used.
     constexpr int script_check_threads = 2;
-    StartScriptCheckWorkerThreads(script_check_threads);
+    util::ThreadPool::Options thread_pool_options;
+    thread_pool_options.threads = script_check_threads;
+    m_node.thread_pool = std::make_unique<util::ThreadPool>(std::move(thread_pool_options));
+    util::SetSharedThreadPool(m_node.thread_pool.get());
+    StartScriptCheckWorkers(*m_node.thread_pool, script_check_threads);
     g_parallel_script_checks = true;
 }
 
@@ -208,6 +213,8 @@ ChainTestingSetup::~ChainTestingSetup()
 {
     if (m_node.scheduler) m_node.scheduler->stop();
     StopScriptCheckWorkerThreads();
+    util::SetSharedThreadPool(nullptr);
+    m_node.thread_pool->Stop();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
     m_node.connman.reset();
@@ -236,6 +243,7 @@ TestingSetup::TestingSetup(const std::string& chainName, const std::vector<const
     options.prune = node::fPruneMode;
     options.check_blocks = m_args.GetIntArg("-checkblocks", DEFAULT_CHECKBLOCKS);
     options.check_level = m_args.GetIntArg("-checklevel", DEFAULT_CHECKLEVEL);
+    options.thread_pool = m_node.thread_pool.get();
     auto [status, error] = LoadChainstate(*Assert(m_node.chainman), m_cache_sizes, options);
     assert(status == node::ChainstateLoadStatus::SUCCESS);
 
@@ -434,8 +442,9 @@ CTxMemPoolEntry TestMemPoolEntryHelper::FromTx(const CTransactionRef& tx) const
 {
     CAmounts nFees = {0};
     nFees[CASH] = nFee; // All fees are in cash by default
+    nFees[BOND] = nBondFee; // Normalized by the mempool at the next block
     return CTxMemPoolEntry(tx, nFees, nFee, nTime, nHeight,
-                           spendsCoinbase, sigOpCost, lp);
+                           spendsCoinbase, sigOpCost, lp, conversionInfo);
 }
 
 /**
@@ -24,6 +24,7 @@
 #include <util/time.h>
 #include <util/vector.h>
 #include <util/bitdeque.h>
+#include <util/compression.h>
 
 #include <array>
 #include <fstream>
@@ -181,6 +182,25 @@ BOOST_AUTO_TEST_CASE(parse_hex)
     // Stop parsing at invalid value
     result = ParseHex("1234 invalid 1234");
     BOOST_CHECK(result.size() == 2 && result[0] == 0x12 && result[1] == 0x34);
+
+    // Upper case digits are supported across whole blocks of input
+    result = ParseHex("04678AFDB0FE5548271967F1A67130B7105CD6A828E03909A67962E0EA1F61DEB649F6BC3F4CEF38C4F35504E51EC112DE5C384DF7BA0B8D578A4C702B6BF11D5F");
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(), expected.end());
+
+    // A space or invalid character at any position of a long input is
+    // handled as in short inputs
+    const std::string hex{HexStr(expected)};
+    for (size_t pos = 0; pos < hex.size(); pos += 2) {
+        std::string spaced{hex};
+        spaced.insert(pos, " ");
+        result = ParseHex(spaced);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(), expected.end());
+
+        std::string invalid{hex};
+        invalid[pos + 1] = 'g';
+        result = ParseHex(invalid);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(), expected.begin() + pos / 2);
+    }
 }
 
 BOOST_AUTO_TEST_CASE(util_HexStr)
@@ -2782,4 +2802,38 @@ BOOST_AUTO_TEST_CASE(util_WriteBinaryFile)
     BOOST_CHECK(valid);
     BOOST_CHECK_EQUAL(actual_text, expected_text);
 }
+BOOST_AUTO_TEST_CASE(util_LZ4)
+{
+    // A literal, a match overlapping the bytes it produces, and trailing literals
+    const std::vector<unsigned char> block{0x11, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+    std::vector<std::byte> out(11);
+    BOOST_CHECK(LZ4Decompress(MakeByteSpan(block), out));
+    BOOST_CHECK_EQUAL(std::string(reinterpret_cast<const char*>(out.data()), out.size()), "aaaaaabcdef");
+
+    // The output must have exactly the original size
+    out.resize(10);
+    BOOST_CHECK(!LZ4Decompress(MakeByteSpan(block), out));
+    out.resize(12);
+    BOOST_CHECK(!LZ4Decompress(MakeByteSpan(block), out));
+
+    // Offsets before the start of the output are rejected
+    const std::vector<unsigned char> bad_offset{0x11, 'a', 0x02, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+    out.resize(11);
+    BOOST_CHECK(!LZ4Decompress(MakeByteSpan(bad_offset), out));
+
+    for (const size_t size : {0, 1, 12, 13, 1000, 100000}) {
+        std::vector<std::byte> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = i % 64 < 32 ? std::byte(InsecureRandBits(8)) : data[i / 2];
+        }
+        const std::vector<std::byte> compressed{LZ4Compress(data)};
+        std::vector<std::byte> decompressed(size);
+        BOOST_CHECK(LZ4Decompress(compressed, decompressed));
+        BOOST_CHECK(decompressed == data);
+    }
+
+    // Repetitive data compresses well
+    const std::vector<std::byte> zeros(100000);
+    BOOST_CHECK_LT(LZ4Compress(zeros).size(), 1000U);
+}
 BOOST_AUTO_TEST_SUITE_END()
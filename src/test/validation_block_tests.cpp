@@ -357,4 +357,24 @@ BOOST_AUTO_TEST_CASE(witness_commitment_index)
 
     BOOST_CHECK_EQUAL(GetWitnessCommitmentIndex(pblock), 2);
 }
+
+BOOST_AUTO_TEST_CASE(unreachable_total_supply_header)
+{
+    const uint256 tip_hash{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash())};
+
+    // The template's supply is reachable
+    auto pblock = Block(tip_hash);
+    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
+    while (!CheckProofOfWork(pblock->GetHash(), pblock->nBits, Params().GetConsensus())) ++pblock->nNonce;
+    BlockValidationState state;
+    BOOST_CHECK(m_node.chainman->ProcessNewBlockHeaders({pblock->GetBlockHeader()}, true, state));
+
+    // Growing the supply by more than the subsidy is rejected from the header alone
+    pblock = Block(tip_hash);
+    pblock->bondSupply += GetBlockSubsidy(1, Params().GetConsensus()) + 1;
+    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
+    while (!CheckProofOfWork(pblock->GetHash(), pblock->nBits, Params().GetConsensus())) ++pblock->nNonce;
+    BOOST_CHECK(!m_node.chainman->ProcessNewBlockHeaders({pblock->GetBlockHeader()}, true, state));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "bad-total-supply");
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -75,6 +75,18 @@ BOOST_AUTO_TEST_CASE(validation_chainstate_resize_caches)
 
 //! Test UpdateTip behavior for both active and background chainstates.
 //!
+//! VerifyDB reads and checks the blocks in batches ahead of disconnecting and
+//! reconnecting them, so check more blocks than fit in one at every level.
+BOOST_FIXTURE_TEST_CASE(chainstate_verifydb, TestChain100Setup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    LOCK(::cs_main);
+    for (const int check_level : {0, 1, 2, 3, 4}) {
+        BOOST_CHECK(CVerifyDB().VerifyDB(chainstate, Params().GetConsensus(), chainstate.CoinsTip(), check_level, /*nCheckDepth=*/0));
+    }
+    BOOST_CHECK_EQUAL(chainstate.m_chain.Height(), 100);
+}
+
 //! When run on the background chainstate, UpdateTip should do a subset
 //! of what it does for the active chainstate.
 BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup)
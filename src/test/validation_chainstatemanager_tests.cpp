@@ -7,9 +7,11 @@
 #include <node/utxo_snapshot.h>
 #include <random.h>
 #include <rpc/blockchain.h>
+#include <streams.h>
 #include <sync.h>
 #include <test/util/chainstate.h>
 #include <test/util/setup_common.h>
+#include <test/util/validation.h>
 #include <uint256.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -20,10 +22,67 @@
 
 #include <boost/test/unit_test.hpp>
 
+using node::DeserializeSnapshotChunk;
+using node::SerializeSnapshotCoins;
+using node::SnapshotChunk;
+using node::SnapshotChunkInfo;
 using node::SnapshotMetadata;
 
 BOOST_FIXTURE_TEST_SUITE(validation_chainstatemanager_tests, ChainTestingSetup)
 
+//! Write a snapshot of the active chainstate that lists its first coin twice,
+//! a forged copy ahead of the real one, and try to activate it.
+static bool ActivateSnapshotWithDuplicateCoin(node::NodeContext& node, const fs::path& root)
+{
+    const fs::path snapshot_path{root / "test_snapshot_duplicate.dat"};
+    {
+        AutoFile outfile{fsbridge::fopen(snapshot_path, "wb")};
+        CreateUTXOSnapshot(node, node.chainman->ActiveChainstate(), outfile, snapshot_path, snapshot_path);
+    }
+
+    SnapshotMetadata metadata;
+    std::vector<SnapshotChunk> chunks;
+    {
+        AutoFile infile{fsbridge::fopen(snapshot_path, "rb")};
+        infile >> metadata;
+        for (uint64_t coins{0}; coins < metadata.m_coins_count; coins += chunks.back().m_coins_count) {
+            infile >> chunks.emplace_back();
+        }
+    }
+
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    DeserializeSnapshotChunk(chunks.at(0), coins);
+    const auto& [outpoint, coin] = coins.at(0);
+    Coin forged{coin};
+    forged.out.nValue = 0;
+    forged.out.scriptPubKey = CScript() << OP_TRUE;
+    std::vector<unsigned char> data;
+    SerializeSnapshotCoins(data, outpoint.hash, {{outpoint.n, forged}});
+    data.insert(data.end(), chunks[0].m_data.begin(), chunks[0].m_data.end());
+    chunks[0].m_data = std::move(data);
+    ++chunks[0].m_coins_count;
+    ++metadata.m_coins_count;
+
+    {
+        AutoFile outfile{fsbridge::fopen(snapshot_path, "wb")};
+        outfile << metadata;
+        std::vector<SnapshotChunkInfo> chunk_index;
+        uint64_t offset{GetSerializeSize(metadata)};
+        for (const SnapshotChunk& chunk : chunks) {
+            uint256 first_txid;
+            SpanReader{SER_DISK, CLIENT_VERSION, chunk.m_data} >> first_txid;
+            chunk_index.push_back({offset, chunk.m_coins_count, first_txid});
+            outfile << chunk;
+            offset += GetSerializeSize(chunk);
+        }
+        outfile << chunk_index << offset;
+    }
+
+    AutoFile infile{fsbridge::fopen(snapshot_path, "rb")};
+    infile >> metadata;
+    return node.chainman->ActivateSnapshot(infile, metadata, /*in_memory=*/true);
+}
+
 //! Basic tests for ChainstateManager.
 //!
 //! First create a legacy (IBD) chainstate, then create a snapshot chainstate.
@@ -130,6 +189,7 @@ BOOST_AUTO_TEST_CASE(chainstatemanager_rebalance_caches)
 
     BOOST_CHECK_EQUAL(c1.m_coinstip_cache_size_bytes, max_cache);
     BOOST_CHECK_EQUAL(c1.m_coinsdb_cache_size_bytes, max_cache);
+    BOOST_CHECK(!WITH_LOCK(::cs_main, return manager.IsBackgroundChainstate(&c1)));
 
     // Create a snapshot-based chainstate.
     //
@@ -152,6 +212,82 @@ BOOST_AUTO_TEST_CASE(chainstatemanager_rebalance_caches)
     BOOST_CHECK_CLOSE(c1.m_coinsdb_cache_size_bytes, max_cache * 0.05, 1);
     BOOST_CHECK_CLOSE(c2.m_coinstip_cache_size_bytes, max_cache * 0.95, 1);
     BOOST_CHECK_CLOSE(c2.m_coinsdb_cache_size_bytes, max_cache * 0.95, 1);
+
+    // The IBD chainstate now validates up to the snapshot in the background
+    BOOST_CHECK(WITH_LOCK(::cs_main, return manager.IsBackgroundChainstate(&c1)));
+    BOOST_CHECK(!WITH_LOCK(::cs_main, return manager.IsBackgroundChainstate(&c2)));
+}
+
+BOOST_AUTO_TEST_CASE(chainstatemanager_memory_budget)
+{
+    ChainstateManager& manager = *m_node.chainman;
+    CTxMemPool& mempool = *m_node.mempool;
+
+    const size_t max_cache{10000};
+    manager.m_total_coinsdb_cache = max_cache;
+    manager.m_total_coinstip_cache = max_cache;
+
+    Chainstate& c1 = WITH_LOCK(cs_main, return manager.InitializeChainstate(&mempool));
+    c1.InitCoinsDB(
+        /*cache_size_bytes=*/max_cache, /*in_memory=*/true, /*should_wipe=*/false);
+
+    LOCK(::cs_main);
+    c1.InitCoinsCache(max_cache);
+    BOOST_REQUIRE(c1.LoadGenesisBlock());
+    c1.CoinsTip().SetBestBlock(InsecureRand256());
+    BOOST_REQUIRE(c1.IsInitialBlockDownload());
+
+    // Without a budget, the caches keep their sizes
+    manager.MaybeResizeToMemoryBudget();
+    BOOST_CHECK_EQUAL(c1.m_coinstip_cache_size_bytes, max_cache);
+
+    // During initial block download, the coins cache gets what the coins db cache and the mempool leave
+    manager.m_memory_budget = mempool.m_max_size_bytes + 10 * max_cache;
+    manager.MaybeResizeToMemoryBudget();
+    BOOST_CHECK_EQUAL(c1.m_coinstip_cache_size_bytes, 9 * max_cache);
+    BOOST_CHECK_EQUAL(c1.m_coinsdb_cache_size_bytes, max_cache);
+
+    // It only grows in steps of 10%
+    manager.m_memory_budget += max_cache / 2;
+    manager.MaybeResizeToMemoryBudget();
+    BOOST_CHECK_EQUAL(c1.m_coinstip_cache_size_bytes, 9 * max_cache);
+    manager.m_memory_budget += max_cache;
+    manager.MaybeResizeToMemoryBudget();
+    BOOST_CHECK_EQUAL(c1.m_coinstip_cache_size_bytes, 21 * max_cache / 2);
+
+    // At the tip, it shrinks back to its share of -dbcache
+    static_cast<TestChainState&>(c1).JumpOutOfIbd();
+    manager.MaybeResizeToMemoryBudget();
+    BOOST_CHECK_EQUAL(c1.m_coinstip_cache_size_bytes, max_cache);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_chunk_order)
+{
+    Coin coin;
+    coin.out.nValue = COIN;
+    coin.out.scriptPubKey = CScript() << OP_TRUE;
+    uint256 txid1{InsecureRand256()};
+    uint256 txid2{InsecureRand256()};
+    if (txid2 < txid1) std::swap(txid1, txid2);
+
+    SnapshotChunk chunk;
+    SerializeSnapshotCoins(chunk.m_data, txid1, {{0, coin}, {2, coin}});
+    SerializeSnapshotCoins(chunk.m_data, txid2, {{1, coin}});
+    chunk.m_coins_count = 3;
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    DeserializeSnapshotChunk(chunk, coins);
+    BOOST_REQUIRE_EQUAL(coins.size(), 3U);
+    BOOST_CHECK(coins[1].first == COutPoint(txid1, 2));
+    BOOST_CHECK(coins[2].first == COutPoint(txid2, 1));
+
+    // The outputs of a transaction are written once, and transactions in ascending order
+    for (const uint256& txid : {txid1, txid2}) {
+        SnapshotChunk bad{chunk};
+        SerializeSnapshotCoins(bad.m_data, txid, {{3, coin}});
+        ++bad.m_coins_count;
+        coins.clear();
+        BOOST_CHECK_EXCEPTION(DeserializeSnapshotChunk(bad, coins), std::ios_base::failure, HasReason{"transactions out of order"});
+    }
 }
 
 //! Test basic snapshot activation.
@@ -194,14 +330,10 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, TestChain100Setup)
     // Should not load malleated snapshots
     BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
         m_node, m_path_root, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
-            // A UTXO is missing but count is correct
-            metadata.m_coins_count -= 1;
-
-            COutPoint outpoint;
-            Coin coin;
-
-            auto_infile >> outpoint;
-            auto_infile >> coin;
+            // UTXOs are missing but count is correct
+            SnapshotChunk chunk;
+            auto_infile >> chunk;
+            metadata.m_coins_count -= chunk.m_coins_count;
     }));
     BOOST_REQUIRE(!CreateAndActivateUTXOSnapshot(
         m_node, m_path_root, [](AutoFile& auto_infile, SnapshotMetadata& metadata) {
@@ -223,6 +355,8 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot, TestChain100Setup)
             // Wrong hash
             metadata.m_base_blockhash = uint256::ONE;
     }));
+    // A coin listed twice, even though the copy that is hashed is the real one
+    BOOST_REQUIRE(!ActivateSnapshotWithDuplicateCoin(m_node, m_path_root));
 
     BOOST_REQUIRE(CreateAndActivateUTXOSnapshot(m_node, m_path_root));
 
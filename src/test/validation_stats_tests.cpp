@@ -0,0 +1,48 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kernel/validation_stats.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+using kernel::LatencyHistogram;
+
+BOOST_FIXTURE_TEST_SUITE(validation_stats_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(latency_histogram_buckets)
+{
+    using std::chrono::microseconds;
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{-5}), 0U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{0}), 0U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{1}), 0U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{2}), 1U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{3}), 2U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{4}), 2U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{1000}), 10U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{1024}), 10U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{1025}), 11U);
+    BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(std::chrono::hours{24}), LatencyHistogram::NUM_BUCKETS - 1);
+    // Every duration lands in the first bucket whose bound it doesn't exceed
+    for (size_t i = 0; i + 1 < LatencyHistogram::NUM_BUCKETS; ++i) {
+        const uint64_t bound{LatencyHistogram::BucketUpperBound(i)};
+        BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{bound}), i);
+        BOOST_CHECK_EQUAL(LatencyHistogram::BucketIndex(microseconds{bound + 1}), i + 1);
+    }
+
+    LatencyHistogram histogram;
+    histogram.Record(microseconds{3});
+    histogram.Record(microseconds{4});
+    histogram.Record(microseconds{500});
+    const LatencyHistogram::Snapshot snapshot{histogram.GetSnapshot()};
+    BOOST_CHECK_EQUAL(snapshot.count, 3U);
+    BOOST_CHECK_EQUAL(snapshot.total_us, 507U);
+    BOOST_CHECK_EQUAL(snapshot.buckets[2], 2U);
+    BOOST_CHECK_EQUAL(snapshot.buckets[9], 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,11 +4,17 @@
 
 #include <chainparams.h>
 #include <consensus/amount.h>
+#include <consensus/merkle.h>
+#include <consensus/tx_verify.h>
 #include <net.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
 #include <signet.h>
 #include <uint256.h>
 #include <validation.h>
 
+#include <future>
+
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -121,6 +127,76 @@ BOOST_AUTO_TEST_CASE(signet_parse_tests)
     BOOST_CHECK(!CheckSignetBlockSolution(block, signet_params->GetConsensus()));
 }
 
+BOOST_AUTO_TEST_CASE(conversion_validity_window)
+{
+    // Build a short chain with drifting supplies
+    std::vector<CBlockIndex> blocks(10);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].nHeight = i;
+        blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        blocks[i].cashSupply = (1000 + InsecureRandRange(100)) * COIN;
+        blocks[i].bondSupply = (400 + InsecureRandRange(100)) * COIN;
+    }
+    const CBlockIndex* tip = &blocks.back();
+    const int check_last_N_blocks = 5;
+    const int percent_buffer = 50;
+
+    LOCK(cs_main);
+    const ConversionValidityWindow window{tip, check_last_N_blocks, percent_buffer};
+    for (int i = 0; i < 1000; ++i) {
+        CTxConversionInfo info;
+        const CAmountType input_type = InsecureRandBool() ? CASH : BOND;
+        info.inputs = {0};
+        info.minOutputs = {0};
+        info.inputs[input_type] = 1 + InsecureRandRange(10 * COIN);
+        info.minOutputs[!input_type] = info.inputs[input_type] * (50 + InsecureRandRange(200)) / 100;
+        info.remainderType = InsecureRandBool() ? CASH : BOND;
+
+        // Reference: run the full consensus check against each buffered supply in the window
+        bool expected = false;
+        const CBlockIndex* pindex = tip;
+        for (int j = 0; j < check_last_N_blocks && pindex != nullptr && !expected; ++j, pindex = pindex->pprev) {
+            for (const CAmountType buffered_type : {CASH, BOND}) {
+                CAmounts supply = pindex->GetTotalSupply();
+                supply[buffered_type] += supply[buffered_type] * percent_buffer / 10000;
+                CAmount remainder;
+                if (Consensus::IsValidConversion(supply, info.inputs, info.minOutputs, info.remainderType, remainder)) expected = true;
+            }
+        }
+        BOOST_CHECK_EQUAL(window.IsValid(info), expected);
+        BOOST_CHECK_EQUAL(CheckValidConversionAtTip(tip, info, check_last_N_blocks, percent_buffer), expected);
+    }
+    BOOST_CHECK(!ConversionValidityWindow(nullptr, check_last_N_blocks, percent_buffer).IsValid(CTxConversionInfo{}));
+}
+
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(mmap_block_files)
+{
+    const CBlockIndex* genesis{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Genesis())};
+    const auto& consensus{m_node.chainman->GetConsensus()};
+    const auto& message_start{m_node.chainman->GetParams().MessageStart()};
+    const FlatFilePos pos{WITH_LOCK(cs_main, return genesis->GetBlockPos())};
+
+    CBlock block;
+    std::vector<uint8_t> raw_block;
+    BOOST_REQUIRE(node::ReadBlockFromDisk(block, genesis, consensus));
+    BOOST_REQUIRE(node::ReadRawBlockFromDisk(raw_block, pos, message_start));
+
+    // Blocks read from the mapped block files are the same as those read from the files
+    node::g_mmap_block_files = true;
+    CBlock mapped_block;
+    std::vector<uint8_t> mapped_raw_block;
+    BOOST_CHECK(node::ReadBlockFromDisk(mapped_block, genesis, consensus));
+    BOOST_CHECK(node::ReadRawBlockFromDisk(mapped_raw_block, pos, message_start));
+    CMessageHeader::MessageStartChars bad_message_start{};
+    BOOST_CHECK(!node::ReadRawBlockFromDisk(mapped_raw_block, pos, bad_message_start));
+    node::g_mmap_block_files = node::DEFAULT_MMAP_BLOCKFILES;
+
+    BOOST_CHECK_EQUAL(mapped_block.GetHash(), block.GetHash());
+    BOOST_CHECK(mapped_raw_block == raw_block);
+}
+#endif
+
 //! Test retrieval of valid assumeutxo values.
 BOOST_AUTO_TEST_CASE(test_assumeutxo)
 {
@@ -144,4 +220,30 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo)
     BOOST_CHECK_EQUAL(out210.nChainTx, 200U);
 }
 
+BOOST_AUTO_TEST_CASE(block_check_queue)
+{
+    const CChainParams& params{m_node.chainman->GetParams()};
+    auto block{std::make_shared<CBlock>(params.GenesisBlock())};
+
+    // Without worker threads nothing is queued
+    BOOST_CHECK(!QueueBlockCheck(block, params.GetConsensus(), [] {}));
+
+    StartBlockCheckWorkerThreads(2);
+    std::promise<void> checked;
+    BOOST_REQUIRE(QueueBlockCheck(block, params.GetConsensus(), [&checked] { checked.set_value(); }));
+    checked.get_future().wait();
+    BOOST_CHECK(block->fChecked);
+    BOOST_CHECK(block->m_witness_merkle_root == BlockWitnessMerkleRoot(*block));
+
+    // A block that fails the checks is left for ProcessNewBlock() to check and report
+    auto bad_block{std::make_shared<CBlock>(params.GenesisBlock())};
+    bad_block->hashMerkleRoot = uint256::ONE;
+    std::promise<void> bad_checked;
+    BOOST_REQUIRE(QueueBlockCheck(bad_block, params.GetConsensus(), [&bad_checked] { bad_checked.set_value(); }));
+    bad_checked.get_future().wait();
+    BOOST_CHECK(!bad_block->fChecked);
+    BOOST_CHECK(!bad_block->m_witness_merkle_root);
+    StopBlockCheckWorkerThreads();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,8 +8,14 @@
 #include <scheduler.h>
 #include <test/util/setup_common.h>
 #include <util/check.h>
+#include <util/string.h>
 #include <validationinterface.h>
 
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
 
 struct TestSubscriberNoop final : public CValidationInterface {
@@ -91,4 +97,69 @@ BOOST_AUTO_TEST_CASE(unregister_all_during_call)
     BOOST_CHECK(destroyed);
 }
 
+class TestSequenceInterface final : public CValidationInterface
+{
+public:
+    TestSequenceInterface(std::string name, std::function<void(const std::string&)> log, std::function<void()> on_call = nullptr)
+        : m_name(std::move(name)), m_log(std::move(log)), m_on_call(std::move(on_call))
+    {
+    }
+    void TransactionAddedToMempool(const CTransactionRef&, uint64_t mempool_sequence) override
+    {
+        if (m_on_call) m_on_call();
+        m_log(m_name + ":" + ToString(mempool_sequence));
+    }
+    std::string m_name;
+    std::function<void(const std::string&)> m_log;
+    std::function<void()> m_on_call;
+};
+
+// A slow subscriber doesn't hold up the others, which still receive the
+// events in order. Barriers wait for every subscriber.
+BOOST_AUTO_TEST_CASE(subscribers_run_concurrently)
+{
+    // Service the queue with a second thread
+    m_node.scheduler->m_service_threads.emplace_back([&] { m_node.scheduler->serviceQueue(); });
+
+    Mutex log_mutex;
+    std::vector<std::string> log;
+    auto append = [&](const std::string& entry) { WITH_LOCK(log_mutex, log.push_back(entry)); };
+
+    std::promise<void> release_slow;
+    std::shared_future<void> slow_released{release_slow.get_future()};
+    std::promise<void> fast_done;
+    auto slow = std::make_shared<TestSequenceInterface>("slow", append, [&] { slow_released.wait(); });
+    auto fast = std::make_shared<TestSequenceInterface>("fast", [&](const std::string& entry) {
+        append(entry);
+        if (entry == "fast:3") fast_done.set_value();
+    });
+    RegisterSharedValidationInterface(slow);
+    RegisterSharedValidationInterface(fast);
+
+    const CTransactionRef tx{MakeTransactionRef(CMutableTransaction{})};
+    GetMainSignals().TransactionAddedToMempool(tx, 1);
+    GetMainSignals().TransactionAddedToMempool(tx, 2);
+    CallFunctionInValidationInterfaceQueue([&] { append("barrier"); });
+    GetMainSignals().TransactionAddedToMempool(tx, 3);
+
+    // The fast subscriber stops at the barrier until the slow one reaches it
+    BOOST_CHECK(fast_done.get_future().wait_for(std::chrono::milliseconds{200}) == std::future_status::timeout);
+    BOOST_CHECK_EQUAL(WITH_LOCK(log_mutex, return log.size()), 2U);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(*slow), 4U);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 4U);
+
+    release_slow.set_value();
+    SyncWithValidationInterfaceQueue();
+    UnregisterSharedValidationInterface(slow);
+    UnregisterSharedValidationInterface(fast);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(*fast), 0U);
+
+    LOCK(log_mutex);
+    BOOST_REQUIRE_EQUAL(log.size(), 7U);
+    BOOST_CHECK(std::vector<std::string>(log.begin(), log.begin() + 2) == (std::vector<std::string>{"fast:1", "fast:2"}));
+    BOOST_CHECK(std::vector<std::string>(log.begin() + 2, log.begin() + 4) == (std::vector<std::string>{"slow:1", "slow:2"}));
+    BOOST_CHECK_EQUAL(log[4], "barrier");
+    BOOST_CHECK((log[5] == "slow:3" && log[6] == "fast:3") || (log[5] == "fast:3" && log[6] == "slow:3"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
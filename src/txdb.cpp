@@ -6,16 +6,24 @@
 #include <txdb.h>
 
 #include <chain.h>
+#include <logging.h>
+#include <logging/timer.h>
 #include <pow.h>
 #include <random.h>
 #include <shutdown.h>
 #include <uint256.h>
 #include <util/system.h>
+#include <util/thread.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <util/vector.h>
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
 static constexpr uint8_t DB_COIN{'C'};
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
 static constexpr uint8_t DB_BLOCK_INDEX{'b'};
@@ -26,6 +34,13 @@ static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
 
+//! Flushes that change fewer coins than this are serialized on a single thread
+static constexpr size_t MIN_PARALLEL_BATCH_WRITE_COINS{50000};
+//! Maximum number of threads that serialize a flush
+static constexpr size_t MAX_BATCH_WRITE_THREADS{8};
+//! Number of coins a thread claims at a time while serializing a flush
+static constexpr size_t BATCH_WRITE_CHUNK_COINS{256};
+
 // Keys used in previous version that might still be found in the DB:
 static constexpr uint8_t DB_COINS{'c'};
 static constexpr uint8_t DB_TXINDEX_BLOCK{'T'};
@@ -49,6 +64,39 @@ std::optional<bilingual_str> CheckLegacyTxindex(CBlockTreeDB& block_tree_db)
     return std::nullopt;
 }
 
+bool ReadDBTuning(const ArgsManager& args, const std::string& db_name, DBTuning& tuning, bilingual_str& error)
+{
+    const int64_t block_cache_percent{args.GetIntArg("-" + db_name + "dbblockcachepct", tuning.block_cache_percent)};
+    if (block_cache_percent < 0 || block_cache_percent > 100) {
+        error = strprintf(_("Invalid -%sdbblockcachepct value: %d (must be between 0 and 100)"), db_name, block_cache_percent);
+        return false;
+    }
+    const int64_t bloom_bits{args.GetIntArg("-" + db_name + "dbbloombits", tuning.bloom_bits)};
+    if (bloom_bits < 0 || bloom_bits > MAX_DB_BLOOM_BITS) {
+        error = strprintf(_("Invalid -%sdbbloombits value: %d (must be between 0 and %d)"), db_name, bloom_bits, MAX_DB_BLOOM_BITS);
+        return false;
+    }
+    const int64_t write_buffer_mib{args.GetIntArg("-" + db_name + "dbwritebuffer", 0)};
+    if (write_buffer_mib < 0 || write_buffer_mib > MAX_DB_WRITE_BUFFER) {
+        error = strprintf(_("Invalid -%sdbwritebuffer value: %d (must be between 0 and %d)"), db_name, write_buffer_mib, MAX_DB_WRITE_BUFFER);
+        return false;
+    }
+    tuning.block_cache_percent = block_cache_percent;
+    tuning.bloom_bits = bloom_bits;
+    tuning.write_buffer_size = static_cast<size_t>(write_buffer_mib) << 20;
+    return true;
+}
+
+DBTuning GetDBTuning(const std::string& db_name)
+{
+    DBTuning tuning;
+    bilingual_str error;
+    if (!ReadDBTuning(gArgs, db_name, tuning, error)) {
+        LogPrintf("%s, using the default tuning\n", error.original);
+    }
+    return tuning;
+}
+
 bool CCoinsViewDB::NeedsUpgrade()
 {
     std::unique_ptr<CDBIterator> cursor{m_db->NewIterator()};
@@ -71,7 +119,7 @@ struct CoinEntry {
 } // namespace
 
 CCoinsViewDB::CCoinsViewDB(fs::path ldb_path, size_t nCacheSize, bool fMemory, bool fWipe) :
-    m_db(std::make_unique<CDBWrapper>(ldb_path, nCacheSize, fMemory, fWipe, true)),
+    m_db(std::make_unique<CDBWrapper>(ldb_path, nCacheSize, fMemory, fWipe, true, GetDBTuning("chainstate"))),
     m_ldb_path(ldb_path),
     m_is_memory(fMemory) { }
 
@@ -84,7 +132,7 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size)
         // filesystem lock.
         m_db.reset();
         m_db = std::make_unique<CDBWrapper>(
-            m_ldb_path, new_cache_size, m_is_memory, /*fWipe=*/false, /*obfuscate=*/true);
+            m_ldb_path, new_cache_size, m_is_memory, /*fWipe=*/false, /*obfuscate=*/true, GetDBTuning("chainstate"));
     }
 }
 
@@ -112,9 +160,6 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
-    CDBBatch batch(*m_db);
-    size_t count = 0;
-    size_t changed = 0;
     size_t batch_size = (size_t)gArgs.GetIntArg("-dbbatchsize", nDefaultDbBatchSize);
     int crash_simulate = gArgs.GetIntArg("-dbcrashratio", 0);
     assert(!hashBlock.IsNull());
@@ -129,29 +174,73 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
         }
     }
 
-    // In the first batch, mark the database as being in the middle of a
-    // transition from old_tip to hashBlock.
-    // A vector is used for future extensibility, as we may want to support
-    // interrupting after partial writes from multiple independent reorgs.
-    batch.Erase(DB_BEST_BLOCK);
-    batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
-
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
-        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
-            CoinEntry entry(&it->first);
-            if (it->second.coin.IsSpent())
-                batch.Erase(entry);
-            else
-                batch.Write(entry, it->second.coin);
-            changed++;
+    // mapCoins is left intact, so that CCoinsViewBackgroundFlush can answer lookups from
+    // it while it is being written. Erasing entries wouldn't release memory anyway, as the
+    // PoolAllocator keeps freed nodes until the map is destroyed.
+    std::vector<CCoinsMap::const_iterator> dirty;
+    for (CCoinsMap::const_iterator it = mapCoins.cbegin(); it != mapCoins.cend(); ++it) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) dirty.push_back(it);
+    }
+    const size_t count{mapCoins.size()};
+    const size_t changed{dirty.size()};
+
+    // Serializing coins is CPU bound, so large flushes are serialized on tasks of the shared
+    // thread pool. In each round, every task fills its own batch with its share of -dbbatchsize, and
+    // the batches are committed in order. A round thus holds about as much serialized data
+    // as a single batch, and the batches are freed once committed.
+    const size_t num_threads{changed < MIN_PARALLEL_BATCH_WRITE_COINS ? 1 : std::clamp<size_t>(GetNumCores(), 1, MAX_BATCH_WRITE_THREADS)};
+    const size_t thread_batch_size{batch_size / num_threads};
+    std::atomic<size_t> next{0};
+    const auto fill{[&](CDBBatch& batch) {
+        while (batch.SizeEstimate() <= thread_batch_size) {
+            const size_t begin{next.fetch_add(BATCH_WRITE_CHUNK_COINS)};
+            if (begin >= changed) return;
+            for (size_t i = begin; i < std::min(changed, begin + BATCH_WRITE_CHUNK_COINS); ++i) {
+                CoinEntry entry(&dirty[i]->first);
+                if (dirty[i]->second.coin.IsSpent())
+                    batch.Erase(entry);
+                else
+                    batch.Write(entry, dirty[i]->second.coin);
+            }
+        }
+    }};
+
+    bool ret = true;
+    bool first = true;
+    bool last = false;
+    while (!last) {
+        std::vector<CDBBatch> batches;
+        batches.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) batches.emplace_back(*m_db);
+
+        if (first) {
+            // In the first batch, mark the database as being in the middle of a
+            // transition from old_tip to hashBlock.
+            // A vector is used for future extensibility, as we may want to support
+            // interrupting after partial writes from multiple independent reorgs.
+            batches.front().Erase(DB_BEST_BLOCK);
+            batches.front().Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
+            first = false;
         }
-        count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
-        if (batch.SizeEstimate() > batch_size) {
+
+        util::ParallelFor("batchwrite", util::TaskPriority::HIGH, num_threads, num_threads, [&](size_t i) { fill(batches[i]); });
+
+        last = next >= changed;
+        if (last) {
+            // In the last batch, mark the database as consistent with hashBlock again.
+            batches.back().Erase(DB_HEAD_BLOCKS);
+            batches.back().Write(DB_BEST_BLOCK, hashBlock);
+        }
+
+        for (CDBBatch& batch : batches) {
+            if (last && &batch == &batches.back()) {
+                LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+                ret = m_db->WriteBatch(batch);
+                break;
+            }
+            if (batch.SizeEstimate() == 0) continue;
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
             m_db->WriteBatch(batch);
-            batch.Clear();
             if (crash_simulate) {
                 static FastRandomContext rng;
                 if (rng.randrange(crash_simulate) == 0) {
@@ -162,22 +251,135 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
         }
     }
 
-    // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
-
-    LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
-    bool ret = m_db->WriteBatch(batch);
     LogPrint(BCLog::COINDB, "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
     return ret;
 }
 
+CCoinsViewBackgroundFlush::~CCoinsViewBackgroundFlush()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cv.notify_all();
+    // The thread completes a write that is in flight before it exits
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool CCoinsViewBackgroundFlush::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    {
+        LOCK(m_mutex);
+        const auto it{m_pending.find(outpoint)};
+        if (it != m_pending.end()) {
+            if (it->second.coin.IsSpent()) return false;
+            coin = it->second.coin;
+            return true;
+        }
+    }
+    return m_db.GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewBackgroundFlush::HaveCoin(const COutPoint& outpoint) const
+{
+    {
+        LOCK(m_mutex);
+        const auto it{m_pending.find(outpoint)};
+        if (it != m_pending.end()) return !it->second.coin.IsSpent();
+    }
+    return m_db.HaveCoin(outpoint);
+}
+
+uint256 CCoinsViewBackgroundFlush::GetBestBlock() const
+{
+    {
+        LOCK(m_mutex);
+        if (!m_pending_block.IsNull()) return m_pending_block;
+    }
+    return m_db.GetBestBlock();
+}
+
+bool CCoinsViewBackgroundFlush::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_writing; });
+        if (m_failed) return false;
+        if (m_background) {
+            // Only the dirty coins need to be written, and the caller discards the rest
+            for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it = mapCoins.erase(it)) {
+                if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) continue;
+                m_pending.emplace(std::piecewise_construct, std::forward_as_tuple(it->first),
+                                  std::forward_as_tuple(std::move(it->second.coin), CCoinsCacheEntry::DIRTY));
+            }
+            m_pending_block = hashBlock;
+            m_writing = true;
+            if (!m_thread.joinable()) {
+                m_thread = std::thread(&util::TraceThread, "coinsflush", [this] { ThreadWrite(); });
+            }
+            m_cv.notify_all();
+            return true;
+        }
+    }
+    return m_db.BatchWrite(mapCoins, hashBlock);
+}
+
+void CCoinsViewBackgroundFlush::SetBackground(bool background)
+{
+    LOCK(m_mutex);
+    m_background = background;
+}
+
+bool CCoinsViewBackgroundFlush::WaitForWrite()
+{
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_writing; });
+    return !m_failed;
+}
+
+bool CCoinsViewBackgroundFlush::WriteFailed() const
+{
+    return WITH_LOCK(m_mutex, return m_failed);
+}
+
+void CCoinsViewBackgroundFlush::ThreadWrite()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_writing || m_stop; });
+        if (!m_writing) return;
+
+        const uint256 block{m_pending_block};
+        bool written{false};
+        {
+            REVERSE_LOCK(lock);
+            LOG_TIME_MILLIS_WITH_CATEGORY(strprintf("write %u coins to disk in the background", m_pending.size()), BCLog::BENCH);
+            try {
+                written = m_db.BatchWrite(m_pending, block);
+            } catch (const std::runtime_error& e) {
+                LogPrintf("Error writing to coin database: %s\n", e.what());
+            }
+        }
+        if (written) {
+            m_pending.~CCoinsMap();
+            m_pending_resource.~CCoinsMapMemoryResource();
+            ::new (&m_pending_resource) CCoinsMapMemoryResource{};
+            ::new (&m_pending) CCoinsMap{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &m_pending_resource};
+            m_pending_block.SetNull();
+        } else {
+            // Keep answering lookups from the coins that weren't written. The next flush
+            // fails, which shuts the node down.
+            LogPrintf("Failed to write %u coins to the coin database in the background\n", m_pending.size());
+            m_failed = true;
+        }
+        m_writing = false;
+        m_cv.notify_all();
+    }
+}
+
 size_t CCoinsViewDB::EstimateSize() const
 {
     return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.GetDataDirNet() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.GetDataDirNet() / "blocks" / "index", nCacheSize, fMemory, fWipe, /*obfuscate=*/false, GetDBTuning("blockindex")) {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -214,6 +416,7 @@ public:
 
     bool Valid() const override;
     void Next() override;
+    void Seek(const COutPoint& start) override;
 
 private:
     std::unique_ptr<CDBIterator> pcursor;
@@ -272,6 +475,17 @@ void CCoinsViewDBCursor::Next()
     }
 }
 
+void CCoinsViewDBCursor::Seek(const COutPoint& start)
+{
+    pcursor->Seek(CoinEntry(&start));
+    CoinEntry entry(&keyTmp.second);
+    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
+        keyTmp.first = 0;
+    } else {
+        keyTmp.first = entry.key;
+    }
+}
+
 bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
@@ -323,6 +537,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nNonce         = diskindex.nNonce;
                 pindexNew->cashSupply     = diskindex.cashSupply;
                 pindexNew->bondSupply     = diskindex.bondSupply;
+                pindexNew->scaleFactor    = diskindex.scaleFactor;
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
 
@@ -10,12 +10,15 @@
 #include <dbwrapper.h>
 #include <sync.h>
 
+#include <condition_variable>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+class ArgsManager;
 class CBlockFileInfo;
 class CBlockIndex;
 class uint256;
@@ -43,6 +46,24 @@ static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
+//! max. bits per key of the bloom filter of a database
+static const int64_t MAX_DB_BLOOM_BITS = 64;
+//! max. write buffer size of a database (MiB)
+static const int64_t MAX_DB_WRITE_BUFFER = 1024;
+
+/**
+ * Read the LevelDB tuning of a database from its -<db_name>dbblockcachepct,
+ * -<db_name>dbbloombits and -<db_name>dbwritebuffer options. Returns false and sets error,
+ * leaving tuning unchanged, if any of them is out of range.
+ */
+bool ReadDBTuning(const ArgsManager& args, const std::string& db_name, DBTuning& tuning, bilingual_str& error);
+
+/**
+ * Read the LevelDB tuning of a database from gArgs. The options are checked at startup, so the
+ * defaults are used if they are out of range.
+ */
+DBTuning GetDBTuning(const std::string& db_name);
+
 // Actually declared in validation.cpp; can't include because of circular dependency.
 extern RecursiveMutex cs_main;
 
@@ -72,6 +93,62 @@ public:
 
     //! Dynamically alter the underlying leveldb cache size.
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    //! The underlying database, e.g. to report its statistics.
+    const CDBWrapper& GetDB() const { return *m_db; }
+};
+
+/**
+ * CCoinsView on top of the coin database that can write flushed coins on a background
+ * thread, so that the caller of BatchWrite() doesn't wait for leveldb. Until the write
+ * has completed, lookups of the coins being written are answered from memory. Only one
+ * write is in flight at a time: BatchWrite() waits for the previous one to complete.
+ */
+class CCoinsViewBackgroundFlush final : public CCoinsViewBacked
+{
+private:
+    CCoinsViewDB& m_db;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cv;
+
+    //! Whether BatchWrite() hands the coins to the background thread
+    bool m_background GUARDED_BY(m_mutex){false};
+    //! Whether the background thread is writing m_pending
+    bool m_writing GUARDED_BY(m_mutex){false};
+    //! Whether a background write has failed, in which case m_pending is kept
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+    //! The dirty coins being written and the block they are consistent with. Lookups
+    //! read them under m_mutex. The map is only modified while m_writing is false, so
+    //! the background thread reads it without the lock.
+    CCoinsMapMemoryResource m_pending_resource{};
+    CCoinsMap m_pending{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &m_pending_resource};
+    uint256 m_pending_block GUARDED_BY(m_mutex);
+
+    std::thread m_thread;
+
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+public:
+    explicit CCoinsViewBackgroundFlush(CCoinsViewDB* db) : CCoinsViewBacked(db), m_db(*db) {}
+    ~CCoinsViewBackgroundFlush();
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool HaveCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    uint256 GetBestBlock() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Set whether subsequent calls to BatchWrite() return before the coins are written.
+    void SetBackground(bool background) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Wait for the background write, if any, to complete. Returns false if a background
+    //! write has failed.
+    bool WaitForWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Whether a background write has failed
+    bool WriteFailed() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
 };
 
 /** Access to the block database (blocks/index/) */
@@ -5,23 +5,30 @@
 
 #include <txmempool.h>
 
+#include <kernel/validation_stats.h>
+
 #include <chain.h>
 #include <coins.h>
 #include <consensus/consensus.h>
 #include <consensus/conversion.h>
+#include <consensus/invariant.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
 #include <reverse_iterator.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
 #include <util/check.h>
 #include <util/moneystr.h>
 #include <util/overflow.h>
 #include <util/system.h>
 #include <util/time.h>
+#include <util/trace.h>
 #include <validationinterface.h>
 
+#include <algorithm>
 #include <cmath>
 #include <optional>
 
@@ -48,7 +55,8 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& tx, CAmounts fees, CAmou
     : tx{tx},
       nFees{fees},
       nNormalizedFee{normalized_fee},
-      nTxWeight(GetTransactionWeight(*tx)),
+      // Reuse the parsed conversion info when the caller provides it
+      nTxWeight(conversion_info ? GetTransactionWeight(*tx, conversion_info) : GetTransactionWeight(*tx)),
       nUsageSize{RecursiveDynamicUsage(tx)},
       nTime{time},
       entryHeight{entry_height},
@@ -57,44 +65,64 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& tx, CAmounts fees, CAmou
       m_all_modified_fees{nFees},
       m_modified_fee{nNormalizedFee},
       lockPoints{lp},
-      conversionInfo{conversion_info},
       nSizeWithDescendants{GetTxSize()},
       nModAllFeesWithDescendants{nFees},
       nModFeesWithDescendants{nNormalizedFee},
       nSizeWithAncestors{GetTxSize()},
       nModAllFeesWithAncestors{nFees},
       nModFeesWithAncestors{nNormalizedFee},
-      nSigOpCostWithAncestors{sigOpCost} {}
+      nSigOpCostWithAncestors{sigOpCost}
+{
+    if (conversion_info) {
+        Conversion conversion{*conversion_info};
+        // A conversion sells the type whose inputs exceed its minimum outputs for the other type
+        const CAmounts& inputs = conversion.info.inputs;
+        const CAmounts& minOutputs = conversion.info.minOutputs;
+        for (const CAmountType type : {CASH, BOND}) {
+            if (inputs[type] > minOutputs[type] && inputs[!type] < minOutputs[!type]) {
+                conversion.type = type;
+                conversion.input = inputs[type] - minOutputs[type];
+                conversion.output = minOutputs[!type] - inputs[!type];
+            }
+        }
+        if (IsValidDestination(conversion.info.destination)) {
+            conversion.remainder_script = GetScriptForDestination(conversion.info.destination);
+        }
+        m_conversion = std::make_shared<const Conversion>(std::move(conversion));
+        nUsageSize += memusage::DynamicUsage(m_conversion) + memusage::DynamicUsage(m_conversion->remainder_script);
+    }
+}
 
-void CTxMemPoolEntry::UpdateModifiedFee(CAmount fee_diff, CAmounts totalSupply)
+void CTxMemPoolEntry::UpdateModifiedFee(CAmount fee_diff, const ConversionRate& conversion_rate)
 {
     nModAllFeesWithDescendants[CASH] = SaturatingAdd(nModAllFeesWithDescendants[CASH], fee_diff);
     nModAllFeesWithAncestors[CASH] = SaturatingAdd(nModAllFeesWithAncestors[CASH], fee_diff);
     m_all_modified_fees[CASH] = SaturatingAdd(m_all_modified_fees[CASH], fee_diff);
 
     // Recalculate the normalized modified fees
-    UpdateNormalizedFee(totalSupply);
+    UpdateNormalizedFee(conversion_rate);
 }
 
-void CTxMemPoolEntry::UpdateNormalizedFee(CAmounts totalSupply)
+void CTxMemPoolEntry::UpdateNormalizedFee(const ConversionRate& conversion_rate)
 {
+    const CAmounts& totalSupply = conversion_rate.GetTotalSupply();
     if (totalSupply[CASH] == 0 && totalSupply[BOND] == 0)
         // Skip if total supply is invalid
         return;
-    CAmount normalizedBondFee = nFees[BOND] > 0 ? GetConvertedAmount(totalSupply, nFees[BOND], BOND) : 0;
+    CAmount normalizedBondFee = nFees[BOND] > 0 ? conversion_rate.Convert(nFees[BOND], BOND) : 0;
     nNormalizedFee = nFees[CASH] + normalizedBondFee;
 
     m_modified_fee = m_all_modified_fees[CASH];
     if (m_all_modified_fees[BOND] > 0) {
-        m_modified_fee = SaturatingAdd(m_modified_fee, m_all_modified_fees[BOND] == nFees[BOND] ? normalizedBondFee : GetConvertedAmount(totalSupply, m_all_modified_fees[BOND], BOND));
+        m_modified_fee = SaturatingAdd(m_modified_fee, m_all_modified_fees[BOND] == nFees[BOND] ? normalizedBondFee : conversion_rate.Convert(m_all_modified_fees[BOND], BOND));
     }
     nModFeesWithDescendants = nModAllFeesWithDescendants[CASH];
     if (nModAllFeesWithDescendants[BOND] > 0) {
-        nModFeesWithDescendants = SaturatingAdd(nModFeesWithDescendants, nModAllFeesWithDescendants[BOND] == nFees[BOND] ? normalizedBondFee : GetConvertedAmount(totalSupply, nModAllFeesWithDescendants[BOND], BOND));
+        nModFeesWithDescendants = SaturatingAdd(nModFeesWithDescendants, nModAllFeesWithDescendants[BOND] == nFees[BOND] ? normalizedBondFee : conversion_rate.Convert(nModAllFeesWithDescendants[BOND], BOND));
     }
     nModFeesWithAncestors = nModAllFeesWithAncestors[CASH];
     if (nModAllFeesWithAncestors[BOND] > 0) {
-        nModFeesWithAncestors = SaturatingAdd(nModFeesWithAncestors, nModAllFeesWithAncestors[BOND] == nFees[BOND] ? normalizedBondFee : GetConvertedAmount(totalSupply, nModAllFeesWithAncestors[BOND], BOND));
+        nModFeesWithAncestors = SaturatingAdd(nModFeesWithAncestors, nModAllFeesWithAncestors[BOND] == nFees[BOND] ? normalizedBondFee : conversion_rate.Convert(nModAllFeesWithAncestors[BOND], BOND));
     }
 }
 
@@ -103,6 +131,21 @@ void CTxMemPoolEntry::UpdateLockPoints(const LockPoints& lp)
     lockPoints = lp;
 }
 
+static size_t PrecomputedTxDataUsage(const std::shared_ptr<PrecomputedTransactionData>& txdata)
+{
+    if (!txdata) return 0;
+    size_t usage{memusage::DynamicUsage(txdata) + memusage::DynamicUsage(txdata->m_spent_outputs)};
+    for (const CTxOut& out : txdata->m_spent_outputs) usage += RecursiveDynamicUsage(out);
+    return usage;
+}
+
+void CTxMemPoolEntry::SetPrecomputedTxData(std::shared_ptr<PrecomputedTransactionData> txdata)
+{
+    nUsageSize -= PrecomputedTxDataUsage(m_precomputed_txdata);
+    m_precomputed_txdata = std::move(txdata);
+    nUsageSize += PrecomputedTxDataUsage(m_precomputed_txdata);
+}
+
 size_t CTxMemPoolEntry::GetTxSize() const
 {
     return GetVirtualTransactionSize(nTxWeight, sigOpCost, ::nBytesPerSigOp);
@@ -111,8 +154,8 @@ size_t CTxMemPoolEntry::GetTxSize() const
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendants,
                                       const std::set<uint256>& setExclude, std::set<uint256>& descendants_to_remove)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    CTxMemPoolEntry::EntryRefs stageEntries, descendants;
+    stageEntries.insert(updateIt->GetMemPoolChildrenConst().begin(), updateIt->GetMemPoolChildrenConst().end());
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
@@ -138,7 +181,7 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
     int64_t modifySize = 0;
     CAmounts modifyFees = {0};
     int64_t modifyCount = 0;
-    CAmounts totalSupply = m_total_supply;
+    const ConversionRate& conversion_rate = m_conversion_rate;
     for (const CTxMemPoolEntry& descendant : descendants) {
         if (!setExclude.count(descendant.GetTx().GetHash())) {
             modifySize += descendant.GetTxSize();
@@ -147,9 +190,10 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
             modifyCount++;
             cachedDescendants[updateIt].insert(mapTx.iterator_to(descendant));
             // Update ancestor state for each descendant
-            mapTx.modify(mapTx.iterator_to(descendant), [=](CTxMemPoolEntry& e) {
-              e.UpdateAncestorState(updateIt->GetTxSize(), updateIt->GetModifiedFees(), 1, updateIt->GetSigOpCost(), totalSupply);
+            mapTx.modify(mapTx.iterator_to(descendant), [=, &conversion_rate](CTxMemPoolEntry& e) {
+              e.UpdateAncestorState(updateIt->GetTxSize(), updateIt->GetModifiedFees(), 1, updateIt->GetSigOpCost(), conversion_rate);
             });
+            MarkForCheck(mapTx.iterator_to(descendant));
             // Don't directly remove the transaction here -- doing so would
             // invalidate iterators in cachedDescendants. Mark it for removal
             // by inserting into descendants_to_remove.
@@ -158,7 +202,8 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap& cachedDescendan
             }
         }
     }
-    mapTx.modify(updateIt, [=](CTxMemPoolEntry& e) { e.UpdateDescendantState(modifySize, modifyFees, modifyCount, totalSupply); });
+    mapTx.modify(updateIt, [=, &conversion_rate](CTxMemPoolEntry& e) { e.UpdateDescendantState(modifySize, modifyFees, modifyCount, conversion_rate); });
+    MarkForCheck(updateIt);
 }
 
 void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashesToUpdate)
@@ -219,7 +264,7 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256>& vHashes
 bool CTxMemPool::CalculateAncestorsAndCheckLimits(size_t entry_size,
                                                   size_t entry_count,
                                                   setEntries& setAncestors,
-                                                  CTxMemPoolEntry::Parents& staged_ancestors,
+                                                  CTxMemPoolEntry::EntryRefs& staged_ancestors,
                                                   uint64_t limitAncestorCount,
                                                   uint64_t limitAncestorSize,
                                                   uint64_t limitDescendantCount,
@@ -272,7 +317,7 @@ bool CTxMemPool::CheckPackageLimits(const Package& package,
                                     uint64_t limitDescendantSize,
                                     std::string &errString) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    CTxMemPoolEntry::EntryRefs staged_ancestors;
     size_t total_size = 0;
     for (const auto& tx : package) {
         total_size += GetVirtualTransactionSize(*tx);
@@ -309,7 +354,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry,
                                            std::string &errString,
                                            bool fSearchForParents /* = true */) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    CTxMemPoolEntry::EntryRefs staged_ancestors;
     const CTransaction &tx = entry.GetTx();
 
     if (fSearchForParents) {
@@ -330,7 +375,7 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry,
         // If we're not searching for parents, we require this to already be an
         // entry in the mempool and use the entry's cached parents.
         txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        staged_ancestors.insert(it->GetMemPoolParentsConst().begin(), it->GetMemPoolParentsConst().end());
     }
 
     return CalculateAncestorsAndCheckLimits(entry.GetTxSize(), /*entry_count=*/1,
@@ -351,9 +396,10 @@ void CTxMemPool::UpdateAncestorsOf(bool add, txiter it, setEntries &setAncestors
     CAmounts updateFees = {0};
     updateFees[CASH] = updateCount * it->GetModifiedFees()[CASH];
     updateFees[BOND] = updateCount * it->GetModifiedFees()[BOND];
-    CAmounts totalSupply = m_total_supply;
+    const ConversionRate& conversion_rate = m_conversion_rate;
     for (txiter ancestorIt : setAncestors) {
-        mapTx.modify(ancestorIt, [=](CTxMemPoolEntry& e) { e.UpdateDescendantState(updateSize, updateFees, updateCount, totalSupply); });
+        mapTx.modify(ancestorIt, [=, &conversion_rate](CTxMemPoolEntry& e) { e.UpdateDescendantState(updateSize, updateFees, updateCount, conversion_rate); });
+        MarkForCheck(ancestorIt);
     }
 }
 
@@ -363,14 +409,15 @@ void CTxMemPool::UpdateEntryForAncestors(txiter it, const setEntries &setAncesto
     int64_t updateSize = 0;
     CAmounts updateFees = {0};
     int64_t updateSigOpsCost = 0;
-    CAmounts totalSupply = m_total_supply;
+    const ConversionRate& conversion_rate = m_conversion_rate;
     for (txiter ancestorIt : setAncestors) {
         updateSize += ancestorIt->GetTxSize();
         updateFees[CASH] += ancestorIt->GetModifiedFees()[CASH];
         updateFees[BOND] += ancestorIt->GetModifiedFees()[BOND];
         updateSigOpsCost += ancestorIt->GetSigOpCost();
     }
-    mapTx.modify(it, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(updateSize, updateFees, updateCount, updateSigOpsCost, totalSupply); });
+    mapTx.modify(it, [=, &conversion_rate](CTxMemPoolEntry& e){ e.UpdateAncestorState(updateSize, updateFees, updateCount, updateSigOpsCost, conversion_rate); });
+    MarkForCheck(it);
 }
 
 void CTxMemPool::UpdateChildrenForRemoval(txiter it)
@@ -383,17 +430,51 @@ void CTxMemPool::UpdateChildrenForRemoval(txiter it)
 
 void CTxMemPool::UpdateNormalizedFees(CAmounts totalSupply)
 {
-    // Update the local total supply reference
-    m_total_supply = totalSupply;
-    // Get all entries in mempool
-    std::vector<txiter> view;
-    for (auto mi = mapTx.get<ancestor_score>().begin(); mi != mapTx.get<ancestor_score>().end(); ++mi) {
-        view.push_back(mapTx.project<0>(mi));
+    const auto time_start{SteadyClock::now()};
+
+    // Compute the conversion rate once for all entries
+    m_conversion_rate = ConversionRate{totalSupply};
+    const ConversionRate& conversion_rate = m_conversion_rate;
+
+    // Only entries with bond fees in their own, descendant or ancestor fees are affected
+    // by the conversion rate: the bond fee payers, their descendants and their ancestors.
+    setEntries descendants;
+    for (txiter it : m_bond_fee_entries) {
+        CalculateDescendants(it, descendants);
+    }
+    std::vector<txiter> ancestors;
+    {
+        WITH_FRESH_EPOCH(m_epoch);
+        std::vector<txiter> stage(m_bond_fee_entries.begin(), m_bond_fee_entries.end());
+        while (!stage.empty()) {
+            const txiter it = stage.back();
+            stage.pop_back();
+            for (const CTxMemPoolEntry& parent : it->GetMemPoolParentsConst()) {
+                const txiter parent_it = mapTx.iterator_to(parent);
+                if (visited(parent_it)) continue;
+                stage.push_back(parent_it);
+                if (!descendants.count(parent_it)) ancestors.push_back(parent_it);
+            }
+        }
     }
 
-    for (txiter iter : view) {
-        mapTx.modify(iter, [&totalSupply](CTxMemPoolEntry& e) { e.UpdateNormalizedFee(totalSupply); });
+    for (txiter iter : descendants) {
+        mapTx.modify(iter, [&conversion_rate](CTxMemPoolEntry& e) { e.UpdateNormalizedFee(conversion_rate); });
+        MarkForCheck(iter);
     }
+    for (txiter iter : ancestors) {
+        mapTx.modify(iter, [&conversion_rate](CTxMemPoolEntry& e) { e.UpdateNormalizedFee(conversion_rate); });
+        MarkForCheck(iter);
+    }
+
+    const auto duration{std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - time_start)};
+    kernel::RecordValidationStage(kernel::ValidationStage::UPDATE_NORMALIZED_FEES, duration);
+    TRACE4(mempool, update_normalized_fees,
+        mapTx.size(),
+        m_bond_fee_entries.size(),
+        descendants.size() + ancestors.size(),
+        Ticks<std::chrono::microseconds>(duration)
+    );
 }
 
 void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants)
@@ -417,9 +498,10 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
             modifyFees[CASH] = -removeIt->GetModifiedFees()[CASH];
             modifyFees[BOND] = -removeIt->GetModifiedFees()[BOND];
             int modifySigOps = -removeIt->GetSigOpCost();
-            CAmounts totalSupply = m_total_supply;
+            const ConversionRate& conversion_rate = m_conversion_rate;
             for (txiter dit : setDescendants) {
-                mapTx.modify(dit, [=](CTxMemPoolEntry& e){ e.UpdateAncestorState(modifySize, modifyFees, -1, modifySigOps, totalSupply); });
+                mapTx.modify(dit, [=, &conversion_rate](CTxMemPoolEntry& e){ e.UpdateAncestorState(modifySize, modifyFees, -1, modifySigOps, conversion_rate); });
+                MarkForCheck(dit);
             }
         }
     }
@@ -459,24 +541,24 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
     }
 }
 
-void CTxMemPoolEntry::UpdateDescendantState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, CAmounts totalSupply)
+void CTxMemPoolEntry::UpdateDescendantState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, const ConversionRate& conversion_rate)
 {
     nSizeWithDescendants += modifySize;
     assert(int64_t(nSizeWithDescendants) > 0);
     nModAllFeesWithDescendants[CASH] = SaturatingAdd(nModAllFeesWithDescendants[CASH], modifyFee[CASH]);
     nModAllFeesWithDescendants[BOND] = SaturatingAdd(nModAllFeesWithDescendants[BOND], modifyFee[BOND]);
-    UpdateNormalizedFee(totalSupply);
+    UpdateNormalizedFee(conversion_rate);
     nCountWithDescendants += modifyCount;
     assert(int64_t(nCountWithDescendants) > 0);
 }
 
-void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, int64_t modifySigOps, CAmounts totalSupply)
+void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, int64_t modifySigOps, const ConversionRate& conversion_rate)
 {
     nSizeWithAncestors += modifySize;
     assert(int64_t(nSizeWithAncestors) > 0);
     nModAllFeesWithAncestors[CASH] = SaturatingAdd(nModAllFeesWithAncestors[CASH], modifyFee[CASH]);
     nModAllFeesWithAncestors[BOND] = SaturatingAdd(nModAllFeesWithAncestors[BOND], modifyFee[BOND]);
-    UpdateNormalizedFee(totalSupply);
+    UpdateNormalizedFee(conversion_rate);
     nCountWithAncestors += modifyCount;
     assert(int64_t(nCountWithAncestors) > 0);
     nSigOpCostWithAncestors += modifySigOps;
@@ -498,6 +580,12 @@ CTxMemPool::CTxMemPool(const Options& opts)
       m_limits{opts.limits}
 {
     _clear(); //lock free clear
+    RegisterProfiledLock(&cs, "mempool.cs");
+}
+
+CTxMemPool::~CTxMemPool()
+{
+    UnregisterProfiledLock(&cs);
 }
 
 bool CTxMemPool::isSpent(const COutPoint& outpoint) const
@@ -522,6 +610,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // Used by AcceptToMemoryPool(), which DOES do
     // all the appropriate checks.
     indexed_transaction_set::iterator newit = mapTx.insert(entry).first;
+    MarkForCheck(newit);
 
     // Update transaction for any feeDelta created by PrioritiseTransaction
     CAmount delta{0};
@@ -529,8 +618,8 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // The following call to UpdateModifiedFee assumes no previous fee modifications
     Assume(entry.GetNormalizedFee() == entry.GetModifiedFee());
     if (delta) {
-        CAmounts totalSupply = m_total_supply;
-        mapTx.modify(newit, [&delta, &totalSupply](CTxMemPoolEntry& e) { e.UpdateModifiedFee(delta, totalSupply); });
+        const ConversionRate& conversion_rate = m_conversion_rate;
+        mapTx.modify(newit, [&delta, &conversion_rate](CTxMemPoolEntry& e) { e.UpdateModifiedFee(delta, conversion_rate); });
     }
 
     // Update cachedInnerUsage to include contained transaction's usage.
@@ -568,6 +657,18 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
 
     vTxHashes.emplace_back(tx.GetWitnessHash(), newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
+
+    if (entry.GetFees()[BOND] > 0) {
+        m_bond_fee_entries.insert(newit);
+    }
+    if (entry.GetConversionType() != UNKNOWN) {
+        m_conversion_books[entry.GetConversionType()].insert(newit);
+        UpdateProjectedSupplyForConversion(newit);
+    }
+    if (entry.GetConversionInfo()) {
+        m_conversion_deadlines.insert(newit);
+        m_unchecked_conversions.insert(newit);
+    }
 }
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
@@ -604,6 +705,17 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     m_total_fees[BOND] -= it->GetFees()[BOND];
     cachedInnerUsage -= it->DynamicMemoryUsage();
     cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    m_bond_fee_entries.erase(it);
+    if (it->GetConversionType() != UNKNOWN) {
+        UpdateProjectedSupplyForConversion(it);
+        m_conversion_books[it->GetConversionType()].erase(it);
+    }
+    if (it->GetConversionInfo()) {
+        m_conversion_deadlines.erase(it);
+        m_invalid_conversions.erase(it);
+        m_unchecked_conversions.erase(it);
+    }
+    m_check_pending.erase(hash);
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
@@ -676,22 +788,35 @@ void CTxMemPool::removeRecursive(const CTransaction &origTx, MemPoolRemovalReaso
         RemoveStaged(setAllRemoves, false, reason);
 }
 
-void CTxMemPool::removeForReorg(CChain& chain, std::function<bool(txiter)> check_final_valid_and_mature)
+void CTxMemPool::removeForReorg(CChain& chain, std::function<std::optional<MemPoolRemovalReason>(txiter)> check_final_valid_and_mature)
 {
     // Remove transactions spending a coinbase which are now immature or are no-longer-final transactions
     // Also removes conversion transactions that have an expired conversion deadline or are not valid at start of next block
     AssertLockHeld(cs);
     AssertLockHeld(::cs_main);
 
-    setEntries txToRemove;
+    std::map<MemPoolRemovalReason, setEntries> txToRemove;
     for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
-        if (check_final_valid_and_mature(it)) txToRemove.insert(it);
+        if (const auto reason{check_final_valid_and_mature(it)}) txToRemove[*reason].insert(it);
     }
+    // A descendant of entries removed for different reasons is only removed for the first
     setEntries setAllRemoves;
-    for (txiter it : txToRemove) {
-        CalculateDescendants(it, setAllRemoves);
+    std::vector<std::pair<MemPoolRemovalReason, setEntries>> stages;
+    for (const auto& [reason, entries] : txToRemove) {
+        setEntries stage;
+        for (txiter it : entries) {
+            if (setAllRemoves.count(it)) continue;
+            setEntries descendants;
+            CalculateDescendants(it, descendants);
+            for (txiter descendant : descendants) {
+                if (setAllRemoves.insert(descendant).second) stage.insert(descendant);
+            }
+        }
+        stages.emplace_back(reason, std::move(stage));
+    }
+    for (auto& [reason, stage] : stages) {
+        RemoveStaged(stage, false, reason);
     }
-    RemoveStaged(setAllRemoves, false, MemPoolRemovalReason::REORG);
     for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
         assert(TestLockPointValidity(chain, it->GetLockPoints()));
     }
@@ -717,7 +842,7 @@ void CTxMemPool::removeConflicts(const CTransaction &tx)
 /**
  * Called when a block is connected. Removes from mempool and updates the miner fee estimator.
  */
-void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight, CAmounts totalSupply, std::function<bool(txiter)> check_expired, std::function<bool(txiter)> check_invalid_conversion)
+void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight, CAmounts totalSupply, std::function<bool(txiter)> check_invalid_conversion)
 {
     AssertLockHeld(cs);
     AssertLockHeld(::cs_main);
@@ -746,12 +871,17 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
 
-    // Remove all expired and invalid conversion transactions and their descendants
+    // Remove all expired and invalid conversion transactions and their descendants.
+    // Expired conversions are at the front of the deadline index, so only the
+    // conversions that remain need to be checked for validity.
     setEntries expiredTxsToRemove;
     setEntries invalidConversionTxsToRemove;
-    for (indexed_transaction_set::const_iterator it = mapTx.begin(); it != mapTx.end(); it++) {
-        if (check_expired(it)) expiredTxsToRemove.insert(it);
-        else if (check_invalid_conversion(it)) invalidConversionTxsToRemove.insert(it);
+    deadlineIndex::const_iterator deadlineit = m_conversion_deadlines.begin();
+    for (; deadlineit != m_conversion_deadlines.end() && IsExpiredConversionInfo(*(*deadlineit)->GetConversionInfo(), nBlockHeight); ++deadlineit) {
+        expiredTxsToRemove.insert(*deadlineit);
+    }
+    for (; deadlineit != m_conversion_deadlines.end(); ++deadlineit) {
+        if (check_invalid_conversion(*deadlineit)) invalidConversionTxsToRemove.insert(*deadlineit);
     }
     setEntries setAllExpiredRemoves;
     for (txiter it : expiredTxsToRemove) {
@@ -766,11 +896,23 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
 
     // Update the normalized tx fees with the new conversion rate
     UpdateNormalizedFees(totalSupply);
+    // Project from the new supply now rather than on the first query
+    GetProjectedSupply(totalSupply);
 }
 
 void CTxMemPool::_clear()
 {
     vTxHashes.clear();
+    m_bond_fee_entries.clear();
+    for (conversionBook& book : m_conversion_books) {
+        book.clear();
+    }
+    m_conversion_deadlines.clear();
+    m_invalid_conversions.clear();
+    m_unchecked_conversions.clear();
+    m_projected_supply.reset();
+    m_projection_stop = {};
+    m_check_pending.clear();
     mapTx.clear();
     mapNextTx.clear();
     totalTxSize = 0;
@@ -788,6 +930,93 @@ void CTxMemPool::clear()
     _clear();
 }
 
+void CTxMemPool::MarkForCheck(txiter it)
+{
+    if (m_check_ratio == 0) return;
+    m_check_pending.insert(it->GetTx().GetHash());
+}
+
+void CTxMemPool::CheckEntry(txiter it, CCoinsViewCache& coins, int64_t spendheight) const
+{
+    const CTransaction& tx = it->GetTx();
+    CTxMemPoolEntry::EntryRefs setParentCheck;
+    for (const CTxIn &txin : tx.vin) {
+        // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
+        indexed_transaction_set::const_iterator it2 = mapTx.find(txin.prevout.hash);
+        if (it2 != mapTx.end()) {
+            const CTransaction& tx2 = it2->GetTx();
+            assert(tx2.vout.size() > txin.prevout.n && !tx2.vout[txin.prevout.n].IsNull());
+            setParentCheck.insert(*it2);
+        }
+        assert(coins.HaveCoin(txin.prevout));
+        // Check whether its inputs are marked in mapNextTx.
+        auto it3 = mapNextTx.find(txin.prevout);
+        assert(it3 != mapNextTx.end());
+        assert(it3->first == &txin.prevout);
+        assert(it3->second == &tx);
+    }
+    auto comp = [](const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) -> bool {
+        return a.GetTx().GetHash() == b.GetTx().GetHash();
+    };
+    assert(setParentCheck.size() == it->GetMemPoolParentsConst().size());
+    assert(std::equal(setParentCheck.begin(), setParentCheck.end(), it->GetMemPoolParentsConst().begin(), comp));
+    // Verify ancestor state is correct.
+    setEntries setAncestors;
+    uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+    std::string dummy;
+    CalculateMemPoolAncestors(*it, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy);
+    uint64_t nCountCheck = setAncestors.size() + 1;
+    uint64_t nSizeCheck = it->GetTxSize();
+    CAmounts nFeesCheck = it->GetModifiedFees();
+    int64_t nSigOpCheck = it->GetSigOpCost();
+
+    for (txiter ancestorIt : setAncestors) {
+        nSizeCheck += ancestorIt->GetTxSize();
+        nFeesCheck[CASH] += ancestorIt->GetModifiedFees()[CASH];
+        nFeesCheck[BOND] += ancestorIt->GetModifiedFees()[BOND];
+        nSigOpCheck += ancestorIt->GetSigOpCost();
+    }
+
+    assert(it->GetCountWithAncestors() == nCountCheck);
+    assert(it->GetSizeWithAncestors() == nSizeCheck);
+    assert(it->GetSigOpCostWithAncestors() == nSigOpCheck);
+    assert(it->GetModAllFeesWithAncestors()[CASH] == nFeesCheck[CASH]);
+    assert(it->GetModAllFeesWithAncestors()[BOND] == nFeesCheck[BOND]);
+    // Entries paying bond fees must be tracked for normalized fee updates.
+    assert(m_bond_fee_entries.count(it) == (it->GetFees()[BOND] > 0 ? 1 : 0));
+    // Conversions must be in the order book for the type they sell.
+    if (it->GetConversionType() != UNKNOWN) {
+        assert(m_conversion_books[it->GetConversionType()].count(it));
+    }
+    // Conversions must be in the deadline index.
+    assert(m_conversion_deadlines.count(it) == (it->GetConversionInfo() ? 1 : 0));
+    // Only conversions may be marked invalid or pending a validity check.
+    if (!it->GetConversionInfo()) assert(!m_invalid_conversions.count(it) && !m_unchecked_conversions.count(it));
+
+    // Check children against mapNextTx
+    CTxMemPoolEntry::EntryRefs setChildrenCheck;
+    auto iter = mapNextTx.lower_bound(COutPoint(it->GetTx().GetHash(), 0));
+    uint64_t child_sizes = 0;
+    for (; iter != mapNextTx.end() && iter->first->hash == it->GetTx().GetHash(); ++iter) {
+        txiter childit = mapTx.find(iter->second->GetHash());
+        assert(childit != mapTx.end()); // mapNextTx points to in-mempool transactions
+        if (setChildrenCheck.insert(*childit).second) {
+            child_sizes += childit->GetTxSize();
+        }
+    }
+    assert(setChildrenCheck.size() == it->GetMemPoolChildrenConst().size());
+    assert(std::equal(setChildrenCheck.begin(), setChildrenCheck.end(), it->GetMemPoolChildrenConst().begin(), comp));
+    // Also check to make sure size is greater than sum with immediate children.
+    // just a sanity check, not definitive that this calc is correct...
+    assert(it->GetSizeWithDescendants() >= child_sizes + it->GetTxSize());
+
+    TxValidationState dummy_state; // Not used. CheckTxInputs() should always pass
+    CAmounts txfees = {0};
+    std::optional<CTxConversionInfo> conversionInfo;
+    assert(!tx.IsCoinBase());
+    assert(Consensus::CheckTxInputs(tx, dummy_state, coins, spendheight, txfees, conversionInfo));
+}
+
 void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendheight) const
 {
     if (m_check_ratio == 0) return;
@@ -796,12 +1025,33 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
 
     AssertLockHeld(::cs_main);
     LOCK(cs);
+
+    // Check the whole pool periodically, and when most of it changed anyway
+    if (++m_checks_since_full < FULL_CHECK_INTERVAL && m_check_pending.size() <= mapTx.size() / 2) {
+        LogPrint(BCLog::MEMPOOL, "Checking %u changed mempool transactions\n", (unsigned int)m_check_pending.size());
+        // Coins spent by checked entries are looked up in the mempool, then in the chain
+        CCoinsViewMemPool mempool_view(const_cast<CCoinsViewCache*>(&active_coins_tip), *this);
+        CCoinsViewCache coins(&mempool_view);
+        for (const uint256& txid : m_check_pending) {
+            // Removed entries are dropped from m_check_pending, and their relatives marked instead
+            const txiter it{mapTx.find(txid)};
+            assert(it != mapTx.end());
+            CheckEntry(it, coins, spendheight);
+        }
+        m_check_pending.clear();
+        return;
+    }
+    m_checks_since_full = 0;
+    m_check_pending.clear();
     LogPrint(BCLog::MEMPOOL, "Checking mempool with %u transactions and %u inputs\n", (unsigned int)mapTx.size(), (unsigned int)mapNextTx.size());
 
     uint64_t checkTotal = 0;
     CAmounts check_total_fees = {0};
     uint64_t innerUsage = 0;
     uint64_t prev_ancestor_count{0};
+    size_t bond_fee_entries_count{0};
+    size_t conversion_book_count{0};
+    size_t conversion_deadline_count{0};
 
     CCoinsViewCache mempoolDuplicate(const_cast<CCoinsViewCache*>(&active_coins_tip));
 
@@ -812,81 +1062,22 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
         innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
-        CTxMemPoolEntry::Parents setParentCheck;
-        for (const CTxIn &txin : tx.vin) {
-            // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
-            indexed_transaction_set::const_iterator it2 = mapTx.find(txin.prevout.hash);
-            if (it2 != mapTx.end()) {
-                const CTransaction& tx2 = it2->GetTx();
-                assert(tx2.vout.size() > txin.prevout.n && !tx2.vout[txin.prevout.n].IsNull());
-                setParentCheck.insert(*it2);
-            }
-            // We are iterating through the mempool entries sorted in order by ancestor count.
-            // All parents must have been checked before their children and their coins added to
-            // the mempoolDuplicate coins cache.
-            assert(mempoolDuplicate.HaveCoin(txin.prevout));
-            // Check whether its inputs are marked in mapNextTx.
-            auto it3 = mapNextTx.find(txin.prevout);
-            assert(it3 != mapNextTx.end());
-            assert(it3->first == &txin.prevout);
-            assert(it3->second == &tx);
-        }
-        auto comp = [](const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) -> bool {
-            return a.GetTx().GetHash() == b.GetTx().GetHash();
-        };
-        assert(setParentCheck.size() == it->GetMemPoolParentsConst().size());
-        assert(std::equal(setParentCheck.begin(), setParentCheck.end(), it->GetMemPoolParentsConst().begin(), comp));
-        // Verify ancestor state is correct.
-        setEntries setAncestors;
-        uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
-        std::string dummy;
-        CalculateMemPoolAncestors(*it, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy);
-        uint64_t nCountCheck = setAncestors.size() + 1;
-        uint64_t nSizeCheck = it->GetTxSize();
-        CAmounts nFeesCheck = it->GetModifiedFees();
-        int64_t nSigOpCheck = it->GetSigOpCost();
-
-        for (txiter ancestorIt : setAncestors) {
-            nSizeCheck += ancestorIt->GetTxSize();
-            nFeesCheck[CASH] += ancestorIt->GetModifiedFees()[CASH];
-            nFeesCheck[BOND] += ancestorIt->GetModifiedFees()[BOND];
-            nSigOpCheck += ancestorIt->GetSigOpCost();
-        }
-
-        assert(it->GetCountWithAncestors() == nCountCheck);
-        assert(it->GetSizeWithAncestors() == nSizeCheck);
-        assert(it->GetSigOpCostWithAncestors() == nSigOpCheck);
-        assert(it->GetModAllFeesWithAncestors()[CASH] == nFeesCheck[CASH]);
-        assert(it->GetModAllFeesWithAncestors()[BOND] == nFeesCheck[BOND]);
+        // We are iterating through the mempool entries sorted in order by ancestor count.
+        // All parents must have been checked before their children and their coins added to
+        // the mempoolDuplicate coins cache.
+        CheckEntry(it, mempoolDuplicate, spendheight);
         // Sanity check: we are walking in ascending ancestor count order.
         assert(prev_ancestor_count <= it->GetCountWithAncestors());
         prev_ancestor_count = it->GetCountWithAncestors();
-
-        // Check children against mapNextTx
-        CTxMemPoolEntry::Children setChildrenCheck;
-        auto iter = mapNextTx.lower_bound(COutPoint(it->GetTx().GetHash(), 0));
-        uint64_t child_sizes = 0;
-        for (; iter != mapNextTx.end() && iter->first->hash == it->GetTx().GetHash(); ++iter) {
-            txiter childit = mapTx.find(iter->second->GetHash());
-            assert(childit != mapTx.end()); // mapNextTx points to in-mempool transactions
-            if (setChildrenCheck.insert(*childit).second) {
-                child_sizes += childit->GetTxSize();
-            }
-        }
-        assert(setChildrenCheck.size() == it->GetMemPoolChildrenConst().size());
-        assert(std::equal(setChildrenCheck.begin(), setChildrenCheck.end(), it->GetMemPoolChildrenConst().begin(), comp));
-        // Also check to make sure size is greater than sum with immediate children.
-        // just a sanity check, not definitive that this calc is correct...
-        assert(it->GetSizeWithDescendants() >= child_sizes + it->GetTxSize());
-
-        TxValidationState dummy_state; // Not used. CheckTxInputs() should always pass
-        CAmounts txfees = {0};
-        std::optional<CTxConversionInfo> conversionInfo;
-        assert(!tx.IsCoinBase());
-        assert(Consensus::CheckTxInputs(tx, dummy_state, mempoolDuplicate, spendheight, txfees, conversionInfo));
+        if (it->GetFees()[BOND] > 0) ++bond_fee_entries_count;
+        if (it->GetConversionType() != UNKNOWN) ++conversion_book_count;
+        if (it->GetConversionInfo()) ++conversion_deadline_count;
         for (const auto& input: tx.vin) mempoolDuplicate.SpendCoin(input.prevout);
         AddCoins(mempoolDuplicate, tx, std::numeric_limits<int>::max());
     }
+    assert(m_bond_fee_entries.size() == bond_fee_entries_count);
+    assert(m_conversion_books[CASH].size() + m_conversion_books[BOND].size() == conversion_book_count);
+    assert(m_conversion_deadlines.size() == conversion_deadline_count);
     for (auto it = mapNextTx.cbegin(); it != mapNextTx.cend(); it++) {
         uint256 hash = it->second->GetHash();
         indexed_transaction_set::const_iterator it2 = mapTx.find(hash);
@@ -963,6 +1154,33 @@ static TxMempoolInfo GetInfo(CTxMemPool::indexed_transaction_set::const_iterator
     return TxMempoolInfo{it->GetSharedTx(), it->GetTime(), it->GetNormalizedFee(), it->GetTxSize(), it->GetModifiedFee() - it->GetNormalizedFee()};
 }
 
+std::shared_ptr<const TxRelayOrder> CTxMemPool::GetRelayOrder() const
+{
+    LOCK(cs);
+    auto order{std::make_shared<TxRelayOrder>()};
+    order->sequence = GetSequence();
+    order->positions.reserve(mapTx.size() * 2);
+    uint64_t position{0};
+    for (const auto& it : GetSortedDepthAndScore()) {
+        order->positions.emplace(it->GetTx().GetHash(), position);
+        order->positions.emplace(it->GetTx().GetWitnessHash(), position);
+        ++position;
+    }
+    return order;
+}
+
+std::vector<uint64_t> CTxMemPool::GetAncestorCounts(const std::vector<uint256>& hashes, bool wtxid) const
+{
+    LOCK(cs);
+    std::vector<uint64_t> counts;
+    counts.reserve(hashes.size());
+    for (const uint256& hash : hashes) {
+        const auto it{wtxid ? get_iter_from_wtxid(hash) : mapTx.find(hash)};
+        counts.push_back(it == mapTx.end() ? 0 : it->GetCountWithAncestors());
+    }
+    return counts;
+}
+
 std::vector<TxMempoolInfo> CTxMemPool::infoAll() const
 {
     LOCK(cs);
@@ -986,6 +1204,14 @@ CTransactionRef CTxMemPool::get(const uint256& hash) const
     return i->GetSharedTx();
 }
 
+std::shared_ptr<PrecomputedTransactionData> CTxMemPool::GetPrecomputedTxData(const uint256& wtxid) const
+{
+    AssertLockHeld(cs);
+    const auto it{mapTx.get<index_by_wtxid>().find(wtxid)};
+    if (it == mapTx.get<index_by_wtxid>().end()) return nullptr;
+    return it->GetPrecomputedTxData();
+}
+
 TxMempoolInfo CTxMemPool::info(const GenTxid& gtxid) const
 {
     LOCK(cs);
@@ -1002,24 +1228,27 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
         CAmount &delta = mapDeltas[hash];
         delta = SaturatingAdd(delta, nFeeDelta);
         CAmounts nFeeDeltas = {nFeeDelta, 0};
-        CAmounts totalSupply = m_total_supply;
+        const ConversionRate& conversion_rate = m_conversion_rate;
         txiter it = mapTx.find(hash);
         if (it != mapTx.end()) {
-            mapTx.modify(it, [&nFeeDelta, &totalSupply](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta, totalSupply); });
+            mapTx.modify(it, [&nFeeDelta, &conversion_rate](CTxMemPoolEntry& e) { e.UpdateModifiedFee(nFeeDelta, conversion_rate); });
+            MarkForCheck(it);
             // Now update all ancestors' modified fees with descendants
             setEntries setAncestors;
             uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
             std::string dummy;
             CalculateMemPoolAncestors(*it, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
             for (txiter ancestorIt : setAncestors) {
-                mapTx.modify(ancestorIt, [&nFeeDeltas, &totalSupply](CTxMemPoolEntry& e){ e.UpdateDescendantState(0, nFeeDeltas, 0, totalSupply);});
+                mapTx.modify(ancestorIt, [&nFeeDeltas, &conversion_rate](CTxMemPoolEntry& e){ e.UpdateDescendantState(0, nFeeDeltas, 0, conversion_rate);});
+                MarkForCheck(ancestorIt);
             }
             // Now update all descendants' modified fees with ancestors
             setEntries setDescendants;
             CalculateDescendants(it, setDescendants);
             setDescendants.erase(it);
             for (txiter descendantIt : setDescendants) {
-                mapTx.modify(descendantIt, [&nFeeDeltas, &totalSupply](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDeltas, 0, 0, totalSupply); });
+                mapTx.modify(descendantIt, [&nFeeDeltas, &conversion_rate](CTxMemPoolEntry& e){ e.UpdateAncestorState(0, nFeeDeltas, 0, 0, conversion_rate); });
+                MarkForCheck(descendantIt);
             }
             ++nTransactionsUpdated;
         }
@@ -1106,10 +1335,78 @@ void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
     }
 }
 
+bool CTxMemPool::CompareIteratorByConversionRate::operator()(const txiter& a, const txiter& b) const
+{
+    // Compare output_a / input_a < output_b / input_b without rounding
+    const CWideAmount lhs = CWideAmount{a->GetConversionOutput()} * b->GetConversionInput();
+    const CWideAmount rhs = CWideAmount{b->GetConversionOutput()} * a->GetConversionInput();
+    if (lhs != rhs) return lhs < rhs;
+    return a->GetTx().GetHash() < b->GetTx().GetHash();
+}
+
+bool CTxMemPool::CompareIteratorByDeadline::operator()(const txiter& a, const txiter& b) const
+{
+    // A zero deadline never expires, so sort it after every other deadline
+    const uint32_t deadline_a = a->GetConversionInfo()->nDeadline ? a->GetConversionInfo()->nDeadline : std::numeric_limits<uint32_t>::max();
+    const uint32_t deadline_b = b->GetConversionInfo()->nDeadline ? b->GetConversionInfo()->nDeadline : std::numeric_limits<uint32_t>::max();
+    if (deadline_a != deadline_b) return deadline_a < deadline_b;
+    return a->GetTx().GetHash() < b->GetTx().GetHash();
+}
+
+std::vector<CTxMemPool::txiter> CTxMemPool::GetConversionBook(CAmountType inputType, size_t max_entries) const
+{
+    AssertLockHeld(cs);
+    const conversionBook& book = m_conversion_books.at(inputType);
+    std::vector<txiter> ret;
+    ret.reserve(std::min(book.size(), max_entries));
+    for (auto it = book.begin(); it != book.end() && ret.size() < max_entries; ++it) {
+        ret.push_back(*it);
+    }
+    return ret;
+}
+
+CAmounts CTxMemPool::GetProjectedSupply(CAmounts totalSupply) const
+{
+    AssertLockHeld(cs);
+    if (m_projected_supply && m_projected_supply_base == totalSupply) return *m_projected_supply;
+    m_projected_supply_base = totalSupply;
+    std::array<conversionBook::const_iterator, 2> next{m_conversion_books[CASH].begin(), m_conversion_books[BOND].begin()};
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (const CAmountType type : {CASH, BOND}) {
+            for (; next[type] != m_conversion_books[type].end(); ++next[type]) {
+                const CTxMemPoolEntry& entry = **next[type];
+                const CAmount output = CalculateOutputAmount(totalSupply, entry.GetConversionInput(), type);
+                if (output < entry.GetConversionOutput()) break;
+                totalSupply[type] -= entry.GetConversionInput();
+                totalSupply[!type] += output;
+                progress = true;
+            }
+        }
+    }
+    for (const CAmountType type : {CASH, BOND}) {
+        m_projection_stop[type] = next[type] == m_conversion_books[type].end() ? std::nullopt : std::optional{*next[type]};
+    }
+    m_projected_supply = totalSupply;
+    return totalSupply;
+}
+
+void CTxMemPool::UpdateProjectedSupplyForConversion(txiter it)
+{
+    AssertLockHeld(cs);
+    if (!m_projected_supply) return;
+    const conversionBook& book = m_conversion_books[it->GetConversionType()];
+    const std::optional<txiter>& stop = m_projection_stop[it->GetConversionType()];
+    // The projection never reached conversions sorted after the one its book stopped at
+    if (stop && book.key_comp()(*stop, it)) return;
+    m_projected_supply.reset();
+}
+
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + memusage::DynamicUsage(m_bond_fee_entries) + memusage::DynamicUsage(m_conversion_books[CASH]) + memusage::DynamicUsage(m_conversion_books[BOND]) + memusage::DynamicUsage(m_conversion_deadlines) + memusage::DynamicUsage(m_invalid_conversions) + memusage::DynamicUsage(m_unchecked_conversions) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1155,26 +1452,37 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, bool validFeeEstimat
     return addUnchecked(entry, setAncestors, validFeeEstimate);
 }
 
+/** Add or remove an entry in a vector of entries kept sorted by txid. */
+static void UpdateSortedEntryRefs(std::vector<CTxMemPoolEntry::CTxMemPoolEntryRef>& refs, const CTxMemPoolEntry& entry, bool add)
+{
+    const CompareIteratorByHash comp;
+    const auto it = std::lower_bound(refs.begin(), refs.end(), std::cref(entry), comp);
+    const bool found{it != refs.end() && !comp(std::cref(entry), *it)};
+    if (add && !found) {
+        refs.insert(it, entry);
+    } else if (!add && found) {
+        refs.erase(it);
+    }
+}
+
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
-    }
+    CTxMemPoolEntry::Children& children = entry->GetMemPoolChildren();
+    cachedInnerUsage -= memusage::DynamicUsage(children);
+    UpdateSortedEntryRefs(children, *child, add);
+    cachedInnerUsage += memusage::DynamicUsage(children);
+    MarkForCheck(entry);
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
-    }
+    CTxMemPoolEntry::Parents& parents = entry->GetMemPoolParents();
+    cachedInnerUsage -= memusage::DynamicUsage(parents);
+    UpdateSortedEntryRefs(parents, *parent, add);
+    cachedInnerUsage += memusage::DynamicUsage(parents);
+    MarkForCheck(entry);
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
@@ -1209,13 +1517,31 @@ void CTxMemPool::trackPackageRemoved(const CFeeRate& rate) {
     }
 }
 
-void CTxMemPool::TrimToSize(size_t sizelimit, std::function<bool(txiter)> check_invalid_conversion, std::vector<COutPoint>* pvNoSpendsRemaining) {
+void CTxMemPool::UpdateInvalidConversions(const uint256& tip_hash, const std::function<bool(txiter)>& is_invalid_conversion)
+{
+    AssertLockHeld(cs);
+    if (tip_hash != m_conversions_checked_tip) {
+        // Validity depends on the tip, so check every conversion again
+        m_conversions_checked_tip = tip_hash;
+        m_invalid_conversions.clear();
+        for (txiter it : m_conversion_deadlines) {
+            if (is_invalid_conversion(it)) m_invalid_conversions.insert(it);
+        }
+    } else {
+        for (txiter it : m_unchecked_conversions) {
+            if (is_invalid_conversion(it)) m_invalid_conversions.insert(it);
+        }
+    }
+    m_unchecked_conversions.clear();
+}
+
+void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining) {
     AssertLockHeld(cs);
 
     unsigned nTxnRemoved = 0;
 
     // Abstract out the removeEntry logic to avoid duplication, returns number of txs removed
-    std::function<unsigned(txiter)> removeEntry = [this, pvNoSpendsRemaining](txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs) {
+    std::function<unsigned(txiter, MemPoolRemovalReason)> removeEntry = [this, pvNoSpendsRemaining](txiter it, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs) {
         AssertLockHeld(cs);
 
         setEntries stage;
@@ -1227,7 +1553,7 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::function<bool(txiter)> check_
             for (txiter iter : stage)
                 txn.push_back(iter->GetTx());
         }
-        RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
+        RemoveStaged(stage, false, reason);
         if (pvNoSpendsRemaining) {
             for (const CTransaction& tx : txn) {
                 for (const CTxIn& txin : tx.vin) {
@@ -1239,18 +1565,32 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::function<bool(txiter)> check_
         return stage.size();
     };
 
-    // Start by removing invalid conversion txs
-    for (auto mi = mapTx.get<descendant_score>().begin(); mi != mapTx.get<descendant_score>().end(); ++mi) {
-        if (DynamicMemoryUsage() <= sizelimit) {
-            if (nTxnRemoved > 0) {
-                LogPrint(BCLog::MEMPOOL, "Removed %u txn, all invalid conversions\n", nTxnRemoved);
-            }
-            return;
+    // Start by removing invalid conversion txs, in order of lowest descendant score.
+    // They are looked up by txid, as removing one also removes its descendants.
+    // They are reported as removed for no longer being valid, like in removeForBlock.
+    if (DynamicMemoryUsage() > sizelimit && !m_invalid_conversions.empty()) {
+        std::vector<txiter> invalid_conversions(m_invalid_conversions.begin(), m_invalid_conversions.end());
+        std::sort(invalid_conversions.begin(), invalid_conversions.end(), [](txiter a, txiter b) {
+            const CompareTxMemPoolEntryByDescendantScore compare;
+            return compare(*a, *b) && !compare(*b, *a);
+        });
+        std::vector<uint256> txids;
+        txids.reserve(invalid_conversions.size());
+        for (txiter it : invalid_conversions) {
+            txids.push_back(it->GetTx().GetHash());
         }
-        txiter it = mapTx.project<0>(mi);
-        if (check_invalid_conversion && check_invalid_conversion(it)) {
-            nTxnRemoved += removeEntry(it);
+        for (const uint256& txid : txids) {
+            if (DynamicMemoryUsage() <= sizelimit) break;
+            const txiter it = mapTx.find(txid);
+            if (it == mapTx.end()) continue;
+            nTxnRemoved += removeEntry(it, MemPoolRemovalReason::CONVERSIONINVALID);
+        }
+    }
+    if (DynamicMemoryUsage() <= sizelimit) {
+        if (nTxnRemoved > 0) {
+            LogPrint(BCLog::MEMPOOL, "Removed %u txn, all invalid conversions\n", nTxnRemoved);
         }
+        return;
     }
 
     // After all invalid conversion txs have been removed, start removing valid txs in order of lowest fee rate
@@ -1266,7 +1606,7 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::function<bool(txiter)> check_
         removed += m_incremental_relay_feerate;
         trackPackageRemoved(removed);
         maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-        nTxnRemoved += removeEntry(mapTx.project<0>(it));
+        nTxnRemoved += removeEntry(mapTx.project<0>(it), MemPoolRemovalReason::SIZELIMIT);
     }
 
     if (maxFeeRateRemoved > CFeeRate(0)) {
@@ -1323,5 +1663,5 @@ void CTxMemPool::SetLoadTried(bool load_tried)
 CAmount CTxMemPool::GetTotalNormalizedFee() const
 {
     AssertLockHeld(cs);
-    return m_total_fees[CASH] + GetConvertedAmount(m_total_supply, m_total_fees[BOND], BOND);
+    return m_total_fees[CASH] + m_conversion_rate.Convert(m_total_fees[BOND], BOND);
 }
@@ -6,11 +6,15 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <array>
 #include <atomic>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -19,6 +23,7 @@
 
 #include <coins.h>
 #include <consensus/amount.h>
+#include <consensus/conversion.h>
 #include <indirectmap.h>
 #include <policy/feerate.h>
 #include <policy/packages.h>
@@ -36,6 +41,7 @@
 class CBlockIndex;
 class CChain;
 class Chainstate;
+struct PrecomputedTransactionData;
 extern RecursiveMutex cs_main;
 
 /** Fake height value used in Coin to signify they are only in the memory pool (since 0.8) */
@@ -89,26 +95,41 @@ class CTxMemPoolEntry
 {
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
-    // two aliases, should the types ever diverge
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
+    //! Entries collected while walking the transaction graph
+    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> EntryRefs;
+    // In-mempool parents and children, sorted by txid. Most entries link to a
+    // handful of others, for which a vector is far smaller than a std::set.
+    // Two aliases, should the types ever diverge.
+    typedef std::vector<CTxMemPoolEntryRef> Parents;
+    typedef std::vector<CTxMemPoolEntryRef> Children;
 
 private:
+    //! Conversion data, allocated only for conversion transactions
+    struct Conversion {
+        CTxConversionInfo info;          //!< Cached to avoid expensive parent-transaction lookups
+        CAmountType type{UNKNOWN};       //!< Type the conversion sells, or UNKNOWN
+        CAmount input{0};                //!< Net amount of type the conversion sells
+        CAmount output{0};               //!< Minimum net amount of the other type it requires in return
+        CScript remainder_script;        //!< Script the remainder is paid to, empty if it goes to the miner
+    };
+
     const CTransactionRef tx;
     mutable Parents m_parents;
     mutable Children m_children;
     const CAmounts nFees;             //!< Cached to avoid expensive parent-transaction lookups
     CAmount nNormalizedFee;         //!< Cached to avoid expensive parent-transaction lookups
     const size_t nTxWeight;         //!< ... and avoid recomputing tx weight (also used for GetTxSize())
-    const size_t nUsageSize;        //!< ... and total memory usage
+    size_t nUsageSize;              //!< ... and total memory usage
     const int64_t nTime;            //!< Local time when entering the mempool
+    const int64_t sigOpCost;        //!< Total sigop cost
     const unsigned int entryHeight; //!< Chain height when entering the mempool
     const bool spendsCoinbase;      //!< keep track of transactions that spend a coinbase
-    const int64_t sigOpCost;        //!< Total sigop cost
     CAmounts m_all_modified_fees;       //!< Used for determining the priority of the transaction for mining in a block
     CAmount m_modified_fee;         //!< Used for determining the priority of the transaction for mining in a block (normalized using current conversion rate)
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
-    const std::optional<CTxConversionInfo> conversionInfo; //!< Cached to avoid expensive parent-transaction lookups
+    std::shared_ptr<const Conversion> m_conversion;
+    //! Signature hashing data computed when the transaction was validated, for ConnectBlock to reuse
+    std::shared_ptr<PrecomputedTransactionData> m_precomputed_txdata;
 
     // Information about descendants of this transaction that are in the
     // mempool; if we remove this transaction we must remove all of these
@@ -125,6 +146,10 @@ private:
     CAmount nModFeesWithAncestors;
     int64_t nSigOpCostWithAncestors;
 
+    //! Id of the conversion validity window the conversion was last checked against, and the result
+    mutable uint64_t m_conversion_window_id{0};
+    mutable bool m_conversion_valid{false};
+
 public:
     CTxMemPoolEntry(const CTransactionRef& tx, CAmounts fees, CAmount normalized_fee,
                     int64_t time, unsigned int entry_height,
@@ -146,15 +171,19 @@ public:
     const LockPoints& GetLockPoints() const { return lockPoints; }
 
     // Adjusts the descendant state.
-    void UpdateDescendantState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, CAmounts totalSupply);
+    void UpdateDescendantState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, const ConversionRate& conversion_rate);
     // Adjusts the ancestor state
-    void UpdateAncestorState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, int64_t modifySigOps, CAmounts totalSupply);
+    void UpdateAncestorState(int64_t modifySize, CAmounts modifyFee, int64_t modifyCount, int64_t modifySigOps, const ConversionRate& conversion_rate);
     // Updates the modified fees with descendants/ancestors.
-    void UpdateModifiedFee(CAmount fee_diff, CAmounts total_supply);
-    // Updates the normalized fee with the conversion rate implied by the total supply.
-    void UpdateNormalizedFee(CAmounts total_supply);
+    void UpdateModifiedFee(CAmount fee_diff, const ConversionRate& conversion_rate);
+    // Updates the normalized fee with the conversion rate of the latest total supply.
+    void UpdateNormalizedFee(const ConversionRate& conversion_rate);
     // Update the LockPoints after a reorg
     void UpdateLockPoints(const LockPoints& lp);
+    // Keep the precomputed data the transaction was validated with. Must be
+    // called before the entry is added to the mempool.
+    void SetPrecomputedTxData(std::shared_ptr<PrecomputedTransactionData> txdata);
+    const std::shared_ptr<PrecomputedTransactionData>& GetPrecomputedTxData() const { return m_precomputed_txdata; }
 
     uint64_t GetCountWithDescendants() const { return nCountWithDescendants; }
     uint64_t GetSizeWithDescendants() const { return nSizeWithDescendants; }
@@ -162,7 +191,25 @@ public:
 
     bool GetSpendsCoinbase() const { return spendsCoinbase; }
 
-    const std::optional<CTxConversionInfo>& GetConversionInfo() const { return conversionInfo; }
+    //! The parsed conversion, or nullptr if the transaction is not a conversion
+    const CTxConversionInfo* GetConversionInfo() const { return m_conversion ? &m_conversion->info : nullptr; }
+    CAmountType GetConversionType() const { return m_conversion ? m_conversion->type : UNKNOWN; }
+    CAmount GetConversionInput() const { return m_conversion ? m_conversion->input : 0; }
+    CAmount GetConversionOutput() const { return m_conversion ? m_conversion->output : 0; }
+    //! Script the remainder of the conversion is paid to, or nullptr if it goes to the miner
+    const CScript* GetConversionRemainderScript() const { return m_conversion && !m_conversion->remainder_script.empty() ? &m_conversion->remainder_script : nullptr; }
+
+    //! Validity of the conversion in the window with the given id, if that was the last window it was checked against
+    std::optional<bool> GetCachedConversionValidity(uint64_t window_id) const
+    {
+        if (m_conversion_window_id != window_id) return std::nullopt;
+        return m_conversion_valid;
+    }
+    void SetCachedConversionValidity(uint64_t window_id, bool valid) const
+    {
+        m_conversion_window_id = window_id;
+        m_conversion_valid = valid;
+    }
 
     uint64_t GetCountWithAncestors() const { return nCountWithAncestors; }
     uint64_t GetSizeWithAncestors() const { return nSizeWithAncestors; }
@@ -355,6 +402,20 @@ struct TxMempoolInfo
     int64_t nFeeDelta;
 };
 
+/**
+ * The order transactions are announced to peers in: by their number of
+ * in-mempool ancestors, and then by their score (see CTxMemPool::CompareDepthAndScore).
+ * It is taken once and shared by all peers, so that they can sort the
+ * transactions they announce without looking each of them up in the mempool.
+ */
+struct TxRelayOrder
+{
+    /** Mempool sequence number when the order was taken */
+    uint64_t sequence;
+    /** Position of each transaction in the order, by txid and by wtxid */
+    std::unordered_map<uint256, uint64_t, SaltedTxidHasher> positions;
+};
+
 /** Reason why a transaction was removed from the mempool,
  * this is passed to the notification signal.
  */
@@ -453,7 +514,7 @@ protected:
     CAmounts m_total_fees GUARDED_BY(cs){{0}};  //!< sum of all mempool tx's fees (NOT modified fee)
     uint64_t cachedInnerUsage GUARDED_BY(cs);   //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
 
-    CAmounts m_total_supply GUARDED_BY(cs);   //!< reference to latest total supply of cash and bonds (set each new block and reorg by UpdateNormalizedFees)
+    ConversionRate m_conversion_rate GUARDED_BY(cs);   //!< conversion rate of the latest total supply of cash and bonds (set each new block and reorg by UpdateNormalizedFees)
 
     mutable int64_t lastRollingFeeUpdate GUARDED_BY(cs);
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs);
@@ -474,6 +535,8 @@ protected:
 public:
 
     static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12; // public only for testing
+    //! check() only checks the entries changed since the last check, except every this many checks
+    static constexpr int FULL_CHECK_INTERVAL{100};
 
     typedef boost::multi_index_container<
         CTxMemPoolEntry,
@@ -542,6 +605,18 @@ public:
 
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
+    /** Sort conversions by the rate they require (minimum output per unit of input), lowest first */
+    struct CompareIteratorByConversionRate {
+        bool operator()(const txiter& a, const txiter& b) const;
+    };
+    typedef std::set<txiter, CompareIteratorByConversionRate> conversionBook;
+
+    /** Sort conversions by deadline, earliest first, with conversions without a deadline last */
+    struct CompareIteratorByDeadline {
+        bool operator()(const txiter& a, const txiter& b) const;
+    };
+    typedef std::set<txiter, CompareIteratorByDeadline> deadlineIndex;
+
     uint64_t CalculateDescendantMaximum(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 private:
     typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
@@ -557,6 +632,46 @@ private:
      */
     std::set<uint256> m_unbroadcast_txids GUARDED_BY(cs);
 
+    /**
+     * Entries that pay bond fees. Only these and their in-mempool relatives have
+     * normalized fees that depend on the conversion rate.
+     */
+    setEntries m_bond_fee_entries GUARDED_BY(cs);
+
+    /** Conversions indexed by the type they sell, sorted by the rate they require */
+    std::array<conversionBook, 2> m_conversion_books GUARDED_BY(cs);
+
+    /**
+     * All conversions sorted by deadline, so that expired conversions can be
+     * found without scanning mapTx when a block is connected.
+     */
+    deadlineIndex m_conversion_deadlines GUARDED_BY(cs);
+
+    /**
+     * Result of the last GetProjectedSupply(), valid for the supply it started
+     * from until a conversion it reached is added or removed. The conversion each
+     * book stopped at is kept, as conversions sorted after it leave the result as is.
+     */
+    mutable std::optional<CAmounts> m_projected_supply GUARDED_BY(cs);
+    mutable CAmounts m_projected_supply_base GUARDED_BY(cs){{0}};
+    mutable std::array<std::optional<txiter>, 2> m_projection_stop GUARDED_BY(cs);
+
+    /** Conversions found not to be valid in the next block, which TrimToSize() evicts first */
+    setEntries m_invalid_conversions GUARDED_BY(cs);
+
+    /** Conversions added since the last UpdateInvalidConversions() call */
+    setEntries m_unchecked_conversions GUARDED_BY(cs);
+
+    /** Tip the conversions were last checked against by UpdateInvalidConversions() */
+    uint256 m_conversions_checked_tip GUARDED_BY(cs);
+
+    /**
+     * Txids of the entries added or changed since the last check(), which it
+     * checks instead of the whole pool. Only tracked when checks are enabled.
+     */
+    mutable std::unordered_set<uint256, SaltedTxidHasher> m_check_pending GUARDED_BY(cs);
+    /** Number of check() runs since it last checked the whole pool */
+    mutable int m_checks_since_full GUARDED_BY(cs){0};
 
     /**
      * Helper function to calculate all in-mempool ancestors of staged_ancestors and apply ancestor
@@ -569,7 +684,7 @@ private:
     bool CalculateAncestorsAndCheckLimits(size_t entry_size,
                                           size_t entry_count,
                                           setEntries& setAncestors,
-                                          CTxMemPoolEntry::Parents &staged_ancestors,
+                                          CTxMemPoolEntry::EntryRefs& staged_ancestors,
                                           uint64_t limitAncestorCount,
                                           uint64_t limitAncestorSize,
                                           uint64_t limitDescendantCount,
@@ -602,12 +717,17 @@ public:
      * in the pool.
      */
     explicit CTxMemPool(const Options& opts);
+    ~CTxMemPool();
 
     /**
      * If sanity-checking is turned on, check makes sure the pool is
      * consistent (does not contain two transactions that spend the same inputs,
      * all inputs are in the mapNextTx array). If sanity-checking is turned off,
      * check does nothing.
+     *
+     * Most runs only check the entries added or changed since the previous run.
+     * Every FULL_CHECK_INTERVAL runs, or when most of the pool changed, the whole
+     * pool and its totals are checked.
      */
     void check(const CCoinsViewCache& active_coins_tip, int64_t spendheight) const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
@@ -625,17 +745,25 @@ public:
     /** After reorg, filter the entries that would no longer be valid in the next block, and update
      * the entries' cached LockPoints if needed.  The mempool does not have any knowledge of
      * consensus rules. It just appplies the callable function and removes the ones for which it
-     * returns true.
+     * returns a reason, with their descendants, for that reason.
      * @param[in]   filter_final_valid_and_mature     Predicate that checks the relevant validation rules
      *                                                and updates an entry's LockPoints.
      * */
-    void removeForReorg(CChain& chain, std::function<bool(txiter)> filter_final_valid_and_mature) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
+    void removeForReorg(CChain& chain, std::function<std::optional<MemPoolRemovalReason>(txiter)> filter_final_valid_and_mature) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
     void removeConflicts(const CTransaction& tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
-    void removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight, CAmounts totalSupply, std::function<bool(txiter)> filtered_expired, std::function<bool(txiter)> filtered_invalid_conversion) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
+    /** Remove the transactions in a connected block, their conflicts, and conversions (with their
+     * descendants) whose deadline expired at nBlockHeight or for which filtered_invalid_conversion
+     * returns true. Only conversions are passed to filtered_invalid_conversion.
+     */
+    void removeForBlock(const std::vector<CTransactionRef>& vtx, unsigned int nBlockHeight, CAmounts totalSupply, std::function<bool(txiter)> filtered_invalid_conversion) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
 
     void clear();
     void _clear() EXCLUSIVE_LOCKS_REQUIRED(cs); //lock free
     bool CompareDepthAndScore(const uint256& hasha, const uint256& hashb, bool wtxid=false);
+    /** Take the order transactions are currently announced to peers in */
+    std::shared_ptr<const TxRelayOrder> GetRelayOrder() const;
+    /** Number of in-mempool ancestors, including itself, of each of the transactions, or 0 for those not in the mempool */
+    std::vector<uint64_t> GetAncestorCounts(const std::vector<uint256>& hashes, bool wtxid) const;
     void queryHashes(std::vector<uint256>& vtxid) const;
     bool isSpent(const COutPoint& outpoint) const;
     unsigned int GetTransactionsUpdated() const;
@@ -738,10 +866,19 @@ public:
     }
 
     /** Remove transactions from the mempool until its dynamic size is <= sizelimit.
+      *  Conversions marked invalid by UpdateInvalidConversions() are removed first.
       *  pvNoSpendsRemaining, if set, will be populated with the list of outpoints
       *  which are not in mempool which no longer have any spends in this mempool.
       */
-    void TrimToSize(size_t sizelimit, std::function<bool(txiter)> check_invalid_conversion = nullptr, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /**
+     * Mark the conversions for which is_invalid_conversion returns true, so that
+     * TrimToSize() evicts them first. Each conversion is checked once per tip:
+     * all of them when tip_hash changed since the last call, otherwise only those
+     * added since.
+     */
+    void UpdateInvalidConversions(const uint256& tip_hash, const std::function<bool(txiter)>& is_invalid_conversion) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /** Expire all transaction (and their dependencies) in the mempool older than time. Return the number of removed transactions. */
     int Expire(std::chrono::seconds time) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -796,6 +933,8 @@ public:
     }
 
     CTransactionRef get(const uint256& hash) const;
+    /** Returns the precomputed data the transaction with this wtxid was validated with, if it is in the mempool */
+    std::shared_ptr<PrecomputedTransactionData> GetPrecomputedTxData(const uint256& wtxid) const EXCLUSIVE_LOCKS_REQUIRED(cs);
     txiter get_iter_from_wtxid(const uint256& wtxid) const EXCLUSIVE_LOCKS_REQUIRED(cs)
     {
         AssertLockHeld(cs);
@@ -804,6 +943,21 @@ public:
     TxMempoolInfo info(const GenTxid& gtxid) const;
     std::vector<TxMempoolInfo> infoAll() const;
 
+    /**
+     * Return the conversions selling inputType, sorted by the rate they require
+     * (lowest first), stopping after max_entries.
+     */
+    std::vector<txiter> GetConversionBook(CAmountType inputType, size_t max_entries) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /**
+     * Project the total supply after executing the pending conversions. Each
+     * book is executed in order of required rate until a conversion no longer
+     * clears, alternating between the books until neither makes progress.
+     * The result is cached and only recomputed after a change to the books
+     * the projection depends on, or for a different totalSupply.
+     */
+    CAmounts GetProjectedSupply(CAmounts totalSupply) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     size_t DynamicMemoryUsage() const;
 
     /** Adds a transaction to the unbroadcast set */
@@ -884,6 +1038,12 @@ private:
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Update normalized fee for current conversion rate. */
     void UpdateNormalizedFees(CAmounts totalSupply) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Drop the cached projected supply if it depends on the position of conversion it in its book. */
+    void UpdateProjectedSupplyForConversion(txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Have the next check() check entry it, which was added or changed. */
+    void MarkForCheck(txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Check an entry's links, ancestor state, indexes and inputs, whose coins must be in coins. */
+    void CheckEntry(txiter it, CCoinsViewCache& coins, int64_t spendheight) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /** Before calling removeUnchecked for a given transaction,
      *  UpdateForRemoveFromMempool must be called on the entire (dependent) set
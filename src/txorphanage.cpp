@@ -5,9 +5,12 @@
 #include <txorphanage.h>
 
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <logging.h>
+#include <memusage.h>
 #include <policy/policy.h>
 
+#include <algorithm>
 #include <cassert>
 
 /** Expiration time for orphan transactions in seconds */
@@ -39,9 +42,11 @@ bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
         return false;
     }
 
-    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, m_orphan_list.size()});
+    PeerOrphans& peer_orphans = m_peer_orphans[peer];
+    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, peer_orphans.orphans.size()});
     assert(ret.second);
-    m_orphan_list.push_back(ret.first);
+    peer_orphans.orphans.push_back(ret.first);
+    peer_orphans.total_size += tx->GetTotalSize();
     // Allow for lookups in the orphan pool by wtxid, as well as txid
     m_wtxid_to_orphan_it.emplace(tx->GetWitnessHash(), ret.first);
     for (const CTxIn& txin : tx->vin) {
@@ -69,16 +74,21 @@ int TxOrphanage::EraseTx(const uint256& txid)
             m_outpoint_to_orphan_it.erase(itPrev);
     }
 
+    const auto peer_it = m_peer_orphans.find(it->second.fromPeer);
+    assert(peer_it != m_peer_orphans.end());
+    std::vector<OrphanMap::iterator>& peer_list = peer_it->second.orphans;
     size_t old_pos = it->second.list_pos;
-    assert(m_orphan_list[old_pos] == it);
-    if (old_pos + 1 != m_orphan_list.size()) {
-        // Unless we're deleting the last entry in m_orphan_list, move the last
-        // entry to the position we're deleting.
-        auto it_last = m_orphan_list.back();
-        m_orphan_list[old_pos] = it_last;
+    assert(peer_list[old_pos] == it);
+    if (old_pos + 1 != peer_list.size()) {
+        // Unless we're deleting the last entry in the peer's list, move the
+        // last entry to the position we're deleting.
+        auto it_last = peer_list.back();
+        peer_list[old_pos] = it_last;
         it_last->second.list_pos = old_pos;
     }
-    m_orphan_list.pop_back();
+    peer_list.pop_back();
+    peer_it->second.total_size -= it->second.tx->GetTotalSize();
+    if (peer_list.empty()) m_peer_orphans.erase(peer_it);
     m_wtxid_to_orphan_it.erase(it->second.tx->GetWitnessHash());
 
     m_orphans.erase(it);
@@ -90,19 +100,25 @@ void TxOrphanage::EraseForPeer(NodeId peer)
     AssertLockHeld(g_cs_orphans);
 
     int nErased = 0;
-    std::map<uint256, OrphanTx>::iterator iter = m_orphans.begin();
-    while (iter != m_orphans.end())
-    {
-        std::map<uint256, OrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
-        if (maybeErase->second.fromPeer == peer)
-        {
-            nErased += EraseTx(maybeErase->second.tx->GetHash());
-        }
+    const auto peer_it = m_peer_orphans.find(peer);
+    if (peer_it == m_peer_orphans.end()) return;
+    // EraseTx() reorders the peer's list and drops it once empty, so iterate over a copy
+    const std::vector<OrphanMap::iterator> orphans{peer_it->second.orphans};
+    for (const OrphanMap::iterator& it : orphans) {
+        nErased += EraseTx(it->first);
     }
     if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
 }
 
-void TxOrphanage::LimitOrphans(unsigned int max_orphans)
+void TxOrphanage::EvictPeerOrphan(PeerOrphans& peer_orphans, FastRandomContext& rng)
+{
+    AssertLockHeld(g_cs_orphans);
+    assert(!peer_orphans.orphans.empty());
+    // This may erase peer_orphans itself, once it runs out of orphans
+    EraseTx(peer_orphans.orphans[rng.randrange(peer_orphans.orphans.size())]->first);
+}
+
+void TxOrphanage::LimitOrphans(unsigned int max_orphans, unsigned int max_peer_orphans, size_t max_peer_bytes)
 {
     AssertLockHeld(g_cs_orphans);
 
@@ -128,11 +144,23 @@ void TxOrphanage::LimitOrphans(unsigned int max_orphans)
         if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
     }
     FastRandomContext rng;
+    for (auto peer_it = m_peer_orphans.begin(); peer_it != m_peer_orphans.end();) {
+        // Evict random orphans of a peer over its quota. Advance the iterator
+        // first, since this erases the peer's entry if it runs out of orphans.
+        const NodeId peer{(peer_it++)->first};
+        for (auto it = m_peer_orphans.find(peer); it != m_peer_orphans.end() &&
+             (it->second.orphans.size() > max_peer_orphans || it->second.total_size > max_peer_bytes);
+             it = m_peer_orphans.find(peer)) {
+            EvictPeerOrphan(it->second, rng);
+            ++nEvicted;
+        }
+    }
     while (m_orphans.size() > max_orphans)
     {
-        // Evict a random orphan:
-        size_t randompos = rng.randrange(m_orphan_list.size());
-        EraseTx(m_orphan_list[randompos]->first);
+        // Evict a random orphan of the peer using the most memory:
+        const auto largest = std::max_element(m_peer_orphans.begin(), m_peer_orphans.end(),
+            [](const auto& a, const auto& b) { return a.second.total_size < b.second.total_size; });
+        EvictPeerOrphan(largest->second, rng);
         ++nEvicted;
     }
     if (nEvicted > 0) LogPrint(BCLog::MEMPOOL, "orphanage overflow, removed %u tx\n", nEvicted);
@@ -200,3 +228,21 @@ void TxOrphanage::EraseForBlock(const CBlock& block)
         LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
     }
 }
+
+size_t TxOrphanage::DynamicMemoryUsage() const
+{
+    LOCK(g_cs_orphans);
+    size_t usage{memusage::DynamicUsage(m_orphans) + memusage::DynamicUsage(m_wtxid_to_orphan_it)};
+    for (const auto& [txid, orphan] : m_orphans) {
+        usage += RecursiveDynamicUsage(orphan.tx);
+    }
+    usage += memusage::DynamicUsage(m_outpoint_to_orphan_it);
+    for (const auto& [outpoint, orphans] : m_outpoint_to_orphan_it) {
+        usage += memusage::DynamicUsage(orphans);
+    }
+    usage += memusage::DynamicUsage(m_peer_orphans);
+    for (const auto& [peer, peer_orphans] : m_peer_orphans) {
+        usage += memusage::DynamicUsage(peer_orphans.orphans);
+    }
+    return usage;
+}
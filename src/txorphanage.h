@@ -8,11 +8,17 @@
 #include <net.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <random.h>
 #include <sync.h>
 
 /** Guards orphan transactions and extra txs for compact blocks */
 extern RecursiveMutex g_cs_orphans;
 
+/** Default for the maximum number of orphans kept from a single peer */
+static constexpr unsigned int DEFAULT_MAX_PEER_ORPHAN_TRANSACTIONS{25};
+/** Default for the maximum total size in bytes of the orphans kept from a single peer */
+static constexpr size_t DEFAULT_MAX_PEER_ORPHAN_BYTES{1'000'000};
+
 /** A class to track orphan transactions (failed on TX_MISSING_INPUTS)
  * Since we cannot distinguish orphans from bad transactions with
  * non-existent inputs, we heavily limit the number of orphans
@@ -40,8 +46,13 @@ public:
     /** Erase all orphans included in or invalidated by a new block */
     void EraseForBlock(const CBlock& block) LOCKS_EXCLUDED(::g_cs_orphans);
 
-    /** Limit the orphanage to the given maximum */
-    void LimitOrphans(unsigned int max_orphans) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+    /** Limit the orphans of each peer to max_peer_orphans and max_peer_bytes,
+     *  then the orphanage to max_orphans. Evictions for the overall limit are
+     *  taken from the peer whose orphans use the most memory, so a single peer
+     *  cannot push out the orphans of everyone else. */
+    void LimitOrphans(unsigned int max_orphans,
+                      unsigned int max_peer_orphans = DEFAULT_MAX_PEER_ORPHAN_TRANSACTIONS,
+                      size_t max_peer_bytes = DEFAULT_MAX_PEER_ORPHAN_BYTES) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
     /** Add any orphans that list a particular tx as a parent into a peer's work set
      * (ie orphans that may have found their final missing parent, and so should be reconsidered for the mempool) */
@@ -54,11 +65,15 @@ public:
         return m_orphans.size();
     }
 
+    /** Return the memory used by the orphans and the indexes into them */
+    size_t DynamicMemoryUsage() const LOCKS_EXCLUDED(::g_cs_orphans);
+
 protected:
     struct OrphanTx {
         CTransactionRef tx;
         NodeId fromPeer;
         int64_t nTimeExpire;
+        /** Position in the orphans of fromPeer in m_peer_orphans */
         size_t list_pos;
     };
 
@@ -81,8 +96,18 @@ protected:
      *  to remove orphan transactions from the m_orphans */
     std::map<COutPoint, std::set<OrphanMap::iterator, IteratorComparator>> m_outpoint_to_orphan_it GUARDED_BY(g_cs_orphans);
 
-    /** Orphan transactions in vector for quick random eviction */
-    std::vector<OrphanMap::iterator> m_orphan_list GUARDED_BY(g_cs_orphans);
+    struct PeerOrphans {
+        /** Orphans announced by the peer, in a vector for quick random eviction */
+        std::vector<OrphanMap::iterator> orphans;
+        /** Total serialized size of the orphans */
+        size_t total_size{0};
+    };
+
+    /** Orphans and their memory use by announcing peer */
+    std::map<NodeId, PeerOrphans> m_peer_orphans GUARDED_BY(g_cs_orphans);
+
+    /** Erase a random orphan of a peer */
+    void EvictPeerOrphan(PeerOrphans& peer_orphans, FastRandomContext& rng) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
     /** Index from wtxid into the m_orphans to lookup orphan
      *  transactions using their witness ids. */
@@ -9,6 +9,7 @@
 #include <primitives/transaction.h>
 #include <random.h>
 #include <uint256.h>
+#include <util/hasher.h>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -55,8 +56,9 @@ using SequenceNumber = uint64_t;
 
 /** An announcement. This is the data we track for each txid or wtxid that is announced to us by each peer. */
 struct Announcement {
-    /** Txid or wtxid that was announced. */
-    const uint256 m_txhash;
+    /** Txid or wtxid that was announced. This refers to the single copy of the txhash kept by
+     *  TxRequestTracker::Impl for all announcements of it. */
+    const uint256& m_txhash;
     /** For CANDIDATE_{DELAYED,BEST,READY} the reqtime; for REQUESTED the expiry. */
     std::chrono::microseconds m_time;
     /** What peer the request was from. */
@@ -98,12 +100,14 @@ struct Announcement {
     }
 
     /** Construct a new announcement from scratch, initially in CANDIDATE_DELAYED state. */
-    Announcement(const GenTxid& gtxid, NodeId peer, bool preferred, std::chrono::microseconds reqtime,
+    Announcement(const uint256& txhash, bool is_wtxid, NodeId peer, bool preferred, std::chrono::microseconds reqtime,
         SequenceNumber sequence) :
-        m_txhash(gtxid.GetHash()), m_time(reqtime), m_peer(peer), m_sequence(sequence), m_preferred(preferred),
-        m_is_wtxid(gtxid.IsWtxid()), m_state(static_cast<uint8_t>(State::CANDIDATE_DELAYED)) {}
+        m_txhash(txhash), m_time(reqtime), m_peer(peer), m_sequence(sequence), m_preferred(preferred),
+        m_is_wtxid(is_wtxid), m_state(static_cast<uint8_t>(State::CANDIDATE_DELAYED)) {}
 };
 
+static_assert(sizeof(Announcement) == 32, "Announcement should stay compact");
+
 //! Type alias for priorities.
 using Priority = uint64_t;
 
@@ -320,6 +324,10 @@ class TxRequestTracker::Impl {
     //! Map with this tracker's per-peer statistics.
     std::unordered_map<NodeId, PeerInfo> m_peerinfo;
 
+    //! Every txhash that has announcements in m_index, with the number of them. Announcements refer to the key
+    //! stored here instead of holding a copy, and a txhash missing from this map was not announced by any peer.
+    std::unordered_map<uint256, size_t, SaltedTxidHasher> m_txhashes;
+
 public:
     void SanityCheck() const
     {
@@ -327,6 +335,16 @@ public:
         // on m_index. It also verifies the invariant that no PeerInfo announcements with m_total==0 exist.
         assert(m_peerinfo == RecomputePeerInfo(m_index));
 
+        // Every announcement must refer to the interned copy of its txhash, and the reference counts must match.
+        std::map<uint256, size_t> txhashes;
+        for (const Announcement& ann : m_index) {
+            auto it = m_txhashes.find(ann.m_txhash);
+            assert(it != m_txhashes.end() && &it->first == &ann.m_txhash);
+            ++txhashes[ann.m_txhash];
+        }
+        assert(txhashes.size() == m_txhashes.size());
+        for (const auto& [txhash, count] : txhashes) assert(m_txhashes.at(txhash) == count);
+
         // Calculate per-txhash statistics from m_index, and validate invariants.
         for (auto& item : ComputeTxHashInfo(m_index, m_computer)) {
             TxHashInfo& info = item.second;
@@ -371,7 +389,7 @@ public:
     }
 
 private:
-    //! Wrapper around Index::...::erase that keeps m_peerinfo up to date.
+    //! Wrapper around Index::...::erase that keeps m_peerinfo and m_txhashes up to date.
     template<typename Tag>
     Iter<Tag> Erase(Iter<Tag> it)
     {
@@ -379,7 +397,11 @@ private:
         peerit->second.m_completed -= it->GetState() == State::COMPLETED;
         peerit->second.m_requested -= it->GetState() == State::REQUESTED;
         if (--peerit->second.m_total == 0) m_peerinfo.erase(peerit);
-        return m_index.get<Tag>().erase(it);
+        // Only drop the interned txhash once the announcement referring to it is gone.
+        auto hashit = m_txhashes.find(it->m_txhash);
+        auto ret = m_index.get<Tag>().erase(it);
+        if (--hashit->second == 0) m_txhashes.erase(hashit);
+        return ret;
     }
 
     //! Wrapper around Index::...::modify that keeps m_peerinfo up to date.
@@ -573,23 +595,35 @@ public:
         }
     }
 
-    void ReceivedInv(NodeId peer, const GenTxid& gtxid, bool preferred,
+    void ReceivedInvs(NodeId peer, Span<const GenTxid> gtxids, bool preferred,
         std::chrono::microseconds reqtime)
     {
-        // Bail out if we already have a CANDIDATE_BEST announcement for this (txhash, peer) combination. The case
-        // where there is a non-CANDIDATE_BEST announcement already will be caught by the uniqueness property of the
-        // ByPeer index when we try to emplace the new object below.
-        if (m_index.get<ByPeer>().count(ByPeerView{peer, true, gtxid.GetHash()})) return;
-
-        // Try creating the announcement with CANDIDATE_DELAYED state (which will fail due to the uniqueness
-        // of the ByPeer index if a non-CANDIDATE_BEST announcement already exists with the same txhash and peer).
-        // Bail out in that case.
-        auto ret = m_index.get<ByPeer>().emplace(gtxid, peer, preferred, reqtime, m_current_sequence);
-        if (!ret.second) return;
-
-        // Update accounting metadata.
-        ++m_peerinfo[peer].m_total;
-        ++m_current_sequence;
+        if (gtxids.empty()) return;
+        PeerInfo& info = m_peerinfo[peer];
+        for (const GenTxid& gtxid : gtxids) {
+            // Look up (or intern) the txhash. If nobody announced it yet, this peer cannot have either, and the
+            // announcement is created without further checks.
+            auto [hashit, inserted] = m_txhashes.try_emplace(gtxid.GetHash(), 0);
+            const uint256& txhash = hashit->first;
+
+            // Skip if we already have a CANDIDATE_BEST announcement for this (txhash, peer) combination. The case
+            // where there is a non-CANDIDATE_BEST announcement already will be caught by the uniqueness property
+            // of the ByPeer index when we try to emplace the new object below.
+            if (!inserted && m_index.get<ByPeer>().count(ByPeerView{peer, true, txhash})) continue;
+
+            // Try creating the announcement with CANDIDATE_DELAYED state (which can only fail for a txhash that was
+            // interned already, so there is nothing to undo in that case).
+            auto ret = m_index.get<ByPeer>().emplace(txhash, gtxid.IsWtxid(), peer, preferred, reqtime,
+                                                     m_current_sequence);
+            if (!ret.second) continue;
+
+            // Update accounting metadata.
+            ++hashit->second;
+            ++info.m_total;
+            ++m_current_sequence;
+        }
+        // Don't leave an empty PeerInfo behind if every announcement was a duplicate.
+        if (info.m_total == 0) m_peerinfo.erase(peer);
     }
 
     //! Find the GenTxids to request now from peer.
@@ -730,7 +764,13 @@ void TxRequestTracker::PostGetRequestableSanityCheck(std::chrono::microseconds n
 void TxRequestTracker::ReceivedInv(NodeId peer, const GenTxid& gtxid, bool preferred,
     std::chrono::microseconds reqtime)
 {
-    m_impl->ReceivedInv(peer, gtxid, preferred, reqtime);
+    m_impl->ReceivedInvs(peer, Span{&gtxid, 1}, preferred, reqtime);
+}
+
+void TxRequestTracker::ReceivedInvs(NodeId peer, Span<const GenTxid> gtxids, bool preferred,
+    std::chrono::microseconds reqtime)
+{
+    m_impl->ReceivedInvs(peer, gtxids, preferred, reqtime);
 }
 
 void TxRequestTracker::RequestedTx(NodeId peer, const uint256& txhash, std::chrono::microseconds expiry)
@@ -7,6 +7,7 @@
 
 #include <primitives/transaction.h>
 #include <net.h> // For NodeId
+#include <span.h>
 #include <uint256.h>
 
 #include <chrono>
@@ -131,6 +132,14 @@ public:
     void ReceivedInv(NodeId peer, const GenTxid& gtxid, bool preferred,
         std::chrono::microseconds reqtime);
 
+    /** Adds new CANDIDATE announcements for all entries of an inv message at once.
+     *
+     * Equivalent to calling ReceivedInv for every gtxid in order, with the same preferred and reqtime values, but
+     * shares the per-peer bookkeeping across the batch.
+     */
+    void ReceivedInvs(NodeId peer, Span<const GenTxid> gtxids, bool preferred,
+        std::chrono::microseconds reqtime);
+
     /** Deletes all announcements for a given peer.
      *
      * It should be called when a peer goes offline.
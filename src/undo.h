@@ -8,11 +8,15 @@
 
 #include <coins.h>
 #include <compressor.h>
+#include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <version.h>
 
+#include <ios>
+#include <limits>
+
 /** Formatter for undo information for a CTxIn
  *
  *  Contains the prevout's CTxOut being spent, and its metadata as well
@@ -49,6 +53,36 @@ struct TxInUndoFormatter
     }
 };
 
+/** Formatter for undo information for a CTxIn in the v2 undo encoding
+ *
+ *  The height, the coinbase flag and the amount type, which must be CASH or
+ *  BOND, are folded into one VARINT as in UTXO snapshots. It is followed by
+ *  the compressed amount and the script, encoded with TemplateScriptCompression.
+ */
+struct TxInUndoV2Formatter
+{
+    template<typename Stream>
+    void Ser(Stream &s, const Coin& txout) {
+        ::Serialize(s, VARINT(uint64_t{txout.nHeight} * 4 + uint64_t{txout.fCoinBase} * 2 + uint64_t(txout.out.amountType == BOND)));
+        ::Serialize(s, Using<AmountCompression>(txout.out.nValue));
+        ::Serialize(s, Using<TemplateScriptCompression>(txout.out.scriptPubKey));
+    }
+
+    template<typename Stream>
+    void Unser(Stream &s, Coin& txout) {
+        uint64_t nCode = 0;
+        ::Unserialize(s, VARINT(nCode));
+        if (nCode >> 2 > std::numeric_limits<int32_t>::max()) {
+            throw std::ios_base::failure("undo height out of range");
+        }
+        txout.nHeight = nCode >> 2;
+        txout.fCoinBase = (nCode >> 1) & 1;
+        txout.out.amountType = nCode & 1 ? BOND : CASH;
+        ::Unserialize(s, Using<AmountCompression>(txout.out.nValue));
+        ::Unserialize(s, Using<TemplateScriptCompression>(txout.out.scriptPubKey));
+    }
+};
+
 /** Undo information for a CTransaction */
 class CTxUndo
 {
@@ -59,13 +93,76 @@ public:
     SERIALIZE_METHODS(CTxUndo, obj) { READWRITE(Using<VectorFormatter<TxInUndoFormatter>>(obj.vprevout)); }
 };
 
-/** Undo information for a CBlock */
+/** Formatter for a CTxUndo in the v2 undo encoding */
+struct TxUndoV2Formatter
+{
+    FORMATTER_METHODS(CTxUndo, obj) { READWRITE(Using<VectorFormatter<TxInUndoV2Formatter>>(obj.vprevout)); }
+};
+
+/**
+ * First byte of block undo data in the v2 encoding. The v1 encoding starts with
+ * the number of transactions as a CompactSize, which only starts with this byte
+ * for sizes far beyond MAX_SIZE.
+ */
+static constexpr uint8_t BLOCK_UNDO_V2_MARKER{0xff};
+
+/** Undo information for a CBlock
+ *
+ *  It is written in the v2 encoding, unless a spent coin has an amount type
+ *  that encoding can not represent, and read in either encoding.
+ */
 class CBlockUndo
 {
 public:
     std::vector<CTxUndo> vtxundo; // for all but the coinbase
 
-    SERIALIZE_METHODS(CBlockUndo, obj) { READWRITE(obj.vtxundo); }
+    /** Whether every spent coin can be written in the v2 encoding */
+    bool IsV2Encodable() const
+    {
+        for (const CTxUndo& txundo : vtxundo) {
+            for (const Coin& coin : txundo.vprevout) {
+                if (coin.out.amountType != CASH && coin.out.amountType != BOND) return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        if (!IsV2Encodable()) {
+            s << vtxundo;
+            return;
+        }
+        s << BLOCK_UNDO_V2_MARKER << Using<VectorFormatter<TxUndoV2Formatter>>(vtxundo);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        uint8_t first;
+        s >> first;
+        if (first == BLOCK_UNDO_V2_MARKER) {
+            s >> Using<VectorFormatter<TxUndoV2Formatter>>(vtxundo);
+            return;
+        }
+        // The rest of the CompactSize starting the v1 encoding
+        uint64_t count{first};
+        if (first == 253) {
+            count = ser_readdata16(s);
+            if (count < 253) throw std::ios_base::failure("non-canonical ReadCompactSize()");
+        } else if (first == 254) {
+            count = ser_readdata32(s);
+            if (count < 0x10000u) throw std::ios_base::failure("non-canonical ReadCompactSize()");
+        }
+        if (count > MAX_SIZE) {
+            throw std::ios_base::failure("ReadCompactSize(): size too large");
+        }
+        vtxundo.clear();
+        for (uint64_t i = 0; i < count; ++i) {
+            s >> vtxundo.emplace_back();
+        }
+    }
 };
 
 #endif // BITCOIN_UNDO_H
@@ -14,6 +14,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <iterator>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -194,6 +196,92 @@ bool SanityCheckASMap(const std::vector<bool>& asmap, int bits)
     return false; // Reached EOF without RETURN instruction
 }
 
+std::vector<AsmapRange> CompileAsmap(const std::vector<bool>& asmap)
+{
+    // The state of the interpreter on one branch of the code: the input bits consumed so far,
+    // with the bits not consumed yet left zero, and the ASN returned on a mismatch.
+    struct Branch {
+        std::vector<bool>::const_iterator pos;
+        int bits;
+        uint64_t hi;
+        uint64_t lo;
+        uint32_t default_asn;
+
+        void SetBit()
+        {
+            if (bits < 64) {
+                hi |= uint64_t{1} << (63 - bits);
+            } else {
+                lo |= uint64_t{1} << (127 - bits);
+            }
+        }
+    };
+
+    // Every branch ends in a RETURN, or a mismatch, covering a prefix of the inputs. The
+    // prefixes are disjoint and cover all inputs, so each one's range ends where the next begins.
+    std::vector<AsmapRange> ranges;
+    const std::vector<bool>::const_iterator endpos = asmap.end();
+    std::vector<Branch> branches{{asmap.begin(), 0, 0, 0, 0}};
+    while (!branches.empty()) {
+        Branch branch{branches.back()};
+        branches.pop_back();
+        while (true) {
+            const Instruction opcode{DecodeType(branch.pos, endpos)};
+            if (opcode == Instruction::RETURN) {
+                ranges.push_back({branch.hi, branch.lo, DecodeASN(branch.pos, endpos)});
+                break;
+            } else if (opcode == Instruction::JUMP) {
+                const uint32_t jump{DecodeJump(branch.pos, endpos)};
+                assert(branch.bits < 128);
+                Branch taken{branch};
+                taken.pos += jump;
+                taken.SetBit();
+                ++taken.bits;
+                branches.push_back(taken);
+                ++branch.bits;
+            } else if (opcode == Instruction::MATCH) {
+                const uint32_t match{DecodeMatch(branch.pos, endpos)};
+                const uint32_t matchlen = CountBits(match) - 1;
+                for (uint32_t bit = 0; bit < matchlen; bit++) {
+                    assert(branch.bits < 128);
+                    const bool expected = (match >> (matchlen - 1 - bit)) & 1;
+                    Branch mismatch{branch};
+                    if (!expected) mismatch.SetBit();
+                    ranges.push_back({mismatch.hi, mismatch.lo, branch.default_asn});
+                    if (expected) branch.SetBit();
+                    ++branch.bits;
+                }
+            } else {
+                assert(opcode == Instruction::DEFAULT);
+                branch.default_asn = DecodeASN(branch.pos, endpos);
+            }
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const AsmapRange& a, const AsmapRange& b) {
+        return std::tie(a.start_hi, a.start_lo) < std::tie(b.start_hi, b.start_lo);
+    });
+    // Merge neighbouring ranges of the same ASN
+    std::vector<AsmapRange> merged;
+    for (const AsmapRange& range : ranges) {
+        if (merged.empty() || merged.back().asn != range.asn) merged.push_back(range);
+    }
+    merged.shrink_to_fit();
+    assert(!merged.empty() && merged.front().start_hi == 0 && merged.front().start_lo == 0);
+    return merged;
+}
+
+uint32_t InterpretCompiled(const std::vector<AsmapRange>& ranges, uint64_t ip_hi, uint64_t ip_lo)
+{
+    // Find the last range starting at or before the input
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), std::make_pair(ip_hi, ip_lo),
+                               [](const std::pair<uint64_t, uint64_t>& ip, const AsmapRange& range) {
+                                   return ip < std::make_pair(range.start_hi, range.start_lo);
+                               });
+    assert(it != ranges.begin());
+    return std::prev(it)->asn;
+}
+
 std::vector<bool> DecodeAsmap(fs::path path)
 {
     std::vector<bool> bits;
@@ -14,6 +14,23 @@ uint32_t Interpret(const std::vector<bool> &asmap, const std::vector<bool> &ip);
 
 bool SanityCheckASMap(const std::vector<bool>& asmap, int bits);
 
+/** The 128-bit inputs from start up to the start of the next range, which an asmap maps to asn. */
+struct AsmapRange {
+    uint64_t start_hi;
+    uint64_t start_lo;
+    uint32_t asn;
+};
+
+/**
+ * Compile an asmap that passes SanityCheckASMap(asmap, 128) into the sorted ranges of 128-bit
+ * inputs it maps to the same ASN, by following every branch of the asmap code once. Looking up
+ * an input in them is then a binary search rather than interpreting the code bit by bit.
+ */
+std::vector<AsmapRange> CompileAsmap(const std::vector<bool>& asmap);
+
+/** Look up a 128-bit input, given as its most and least significant halves, in a compiled asmap. */
+uint32_t InterpretCompiled(const std::vector<AsmapRange>& ranges, uint64_t ip_hi, uint64_t ip_lo);
+
 /** Read asmap from provided binary file */
 std::vector<bool> DecodeAsmap(fs::path path);
 
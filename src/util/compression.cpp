@@ -0,0 +1,136 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/compression.h>
+
+#include <crypto/common.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+//! Matches are at least this long
+constexpr size_t MIN_MATCH{4};
+//! The last match must start at least this many bytes before the end of the input
+constexpr size_t MATCH_SAFE_DISTANCE{12};
+//! The last bytes of the input are always literals
+constexpr size_t LAST_LITERALS{5};
+//! Matches refer back at most this far
+constexpr size_t MAX_OFFSET{65535};
+constexpr int HASH_BITS{14};
+
+uint32_t HashSequence(const std::byte* p)
+{
+    return (ReadLE32(reinterpret_cast<const unsigned char*>(p)) * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/** Append a length that did not fit into its 4 bit token field. */
+void WriteLengthTail(std::vector<std::byte>& out, size_t length)
+{
+    for (; length >= 255; length -= 255) out.push_back(std::byte{255});
+    out.push_back(std::byte(length));
+}
+
+void WriteSequence(std::vector<std::byte>& out, const std::byte* literals, size_t literal_len, size_t offset, size_t match_len)
+{
+    const size_t match_code{match_len >= MIN_MATCH ? match_len - MIN_MATCH : 0};
+    out.push_back(std::byte((std::min<size_t>(literal_len, 15) << 4) | std::min<size_t>(match_code, 15)));
+    if (literal_len >= 15) WriteLengthTail(out, literal_len - 15);
+    out.insert(out.end(), literals, literals + literal_len);
+    if (match_len == 0) return; // The last sequence has no match
+    out.push_back(std::byte(offset & 0xff));
+    out.push_back(std::byte(offset >> 8));
+    if (match_code >= 15) WriteLengthTail(out, match_code - 15);
+}
+} // namespace
+
+std::vector<std::byte> LZ4Compress(Span<const std::byte> data)
+{
+    std::vector<std::byte> out;
+    out.reserve(data.size() / 2 + 16);
+    const std::byte* const begin{data.data()};
+    const std::byte* const end{begin + data.size()};
+    const std::byte* anchor{begin};
+
+    if (data.size() > MATCH_SAFE_DISTANCE) {
+        // Positions of the last occurrence of each hashed 4 byte sequence
+        std::array<uint32_t, 1 << HASH_BITS> table{};
+        const std::byte* const match_limit{end - MATCH_SAFE_DISTANCE};
+        const std::byte* p{begin + 1};
+        table[HashSequence(begin)] = 0;
+        while (p < match_limit) {
+            const uint32_t hash{HashSequence(p)};
+            const std::byte* candidate{begin + table[hash]};
+            table[hash] = p - begin;
+            if (candidate >= p || size_t(p - candidate) > MAX_OFFSET || std::memcmp(candidate, p, MIN_MATCH) != 0) {
+                ++p;
+                continue;
+            }
+            // Extend the match backwards over pending literals, then forwards
+            while (p > anchor && candidate > begin && p[-1] == candidate[-1]) {
+                --p;
+                --candidate;
+            }
+            const std::byte* match_end{p + MIN_MATCH};
+            const std::byte* const extend_limit{end - LAST_LITERALS};
+            while (match_end < extend_limit && *match_end == candidate[match_end - p]) ++match_end;
+
+            WriteSequence(out, anchor, p - anchor, p - candidate, match_end - p);
+            anchor = p = match_end;
+            if (p < match_limit) table[HashSequence(p - 2)] = p - 2 - begin;
+        }
+    }
+    WriteSequence(out, anchor, end - anchor, 0, 0);
+    return out;
+}
+
+bool LZ4Decompress(Span<const std::byte> compressed, Span<std::byte> out)
+{
+    const std::byte* in{compressed.data()};
+    const std::byte* const in_end{in + compressed.size()};
+    std::byte* const out_begin{out.data()};
+    std::byte* dst{out_begin};
+    std::byte* const out_end{out_begin + out.size()};
+
+    // Read a length whose token field was saturated, failing on overflow of the input
+    const auto read_length = [&](size_t& length) {
+        uint8_t b;
+        do {
+            if (in == in_end) return false;
+            b = uint8_t(*in++);
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (in < in_end) {
+        const uint8_t token{uint8_t(*in++)};
+        size_t literal_len{size_t{token} >> 4};
+        if (literal_len == 15 && !read_length(literal_len)) return false;
+        if (literal_len > size_t(in_end - in) || literal_len > size_t(out_end - dst)) return false;
+        if (literal_len > 0) std::memcpy(dst, in, literal_len);
+        in += literal_len;
+        dst += literal_len;
+        if (in == in_end) break; // The last sequence has no match
+
+        if (in_end - in < 2) return false;
+        const size_t offset{size_t(uint8_t(in[0])) | size_t(uint8_t(in[1])) << 8};
+        in += 2;
+        size_t match_len{token & 15U};
+        if (match_len == 15 && !read_length(match_len)) return false;
+        match_len += MIN_MATCH;
+        if (offset == 0 || offset > size_t(dst - out_begin) || match_len > size_t(out_end - dst)) return false;
+        // A match may overlap the bytes it produces, which are then copied one at a time
+        const std::byte* src{dst - offset};
+        if (offset >= match_len) {
+            std::memcpy(dst, src, match_len);
+            dst += match_len;
+        } else {
+            for (size_t i = 0; i < match_len; ++i) *dst++ = *src++;
+        }
+    }
+    return dst == out_end;
+}
@@ -0,0 +1,29 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_COMPRESSION_H
+#define BITCOIN_UTIL_COMPRESSION_H
+
+#include <span.h>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Compress data into the LZ4 block format (without the LZ4 frame around it).
+ * The result decompresses with any LZ4 block decoder, given the size of the
+ * original data.
+ */
+std::vector<std::byte> LZ4Compress(Span<const std::byte> data);
+
+/**
+ * Decompress an LZ4 block into out, which must have exactly the size of the
+ * original data. Malformed input is detected and never read or written out
+ * of bounds.
+ *
+ * @return true if compressed decompressed to exactly out.size() bytes.
+ */
+bool LZ4Decompress(Span<const std::byte> compressed, Span<std::byte> out);
+
+#endif // BITCOIN_UTIL_COMPRESSION_H
@@ -11,6 +11,8 @@
 #include <util/system.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -24,6 +26,12 @@
 #include <poll.h>
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -56,6 +64,27 @@ ssize_t Sock::Send(const void* data, size_t len, int flags) const
     return send(m_socket, static_cast<const char*>(data), len, flags);
 }
 
+ssize_t Sock::SendMany(Span<const Span<const unsigned char>> buffers, int flags) const
+{
+    if (buffers.empty()) {
+        return 0;
+    }
+#ifdef WIN32
+    return Send(buffers[0].data(), buffers[0].size(), flags);
+#else
+    std::array<iovec, MAX_SEND_MANY_BUFFERS> iov;
+    const size_t n_buffers{std::min(buffers.size(), iov.size())};
+    for (size_t i = 0; i < n_buffers; ++i) {
+        iov[i].iov_base = const_cast<unsigned char*>(buffers[i].data());
+        iov[i].iov_len = buffers[i].size();
+    }
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = n_buffers;
+    return sendmsg(m_socket, &msg, flags);
+#endif
+}
+
 ssize_t Sock::Recv(void* buf, size_t len, int flags) const
 {
     return recv(m_socket, static_cast<char*>(buf), len, flags);
@@ -223,6 +252,125 @@ bool Sock::WaitMany(std::chrono::milliseconds timeout, EventsPerSock& events_per
 #endif /* USE_POLL */
 }
 
+namespace {
+/** Waits on the sockets with `Sock::WaitMany()`, passing all of them on each wait */
+class WaitManySockWaiter final : public SockWaiter
+{
+public:
+    bool WaitMany(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock) override
+    {
+        return !events_per_sock.empty() && events_per_sock.begin()->first->WaitMany(timeout, events_per_sock);
+    }
+};
+
+#ifdef __linux__
+/** Waits on the sockets with a persistent epoll(7) interest list */
+class EpollSockWaiter final : public SockWaiter
+{
+private:
+    struct Registration {
+        //! Expires once the socket is closed, which removes it from the interest list
+        std::weak_ptr<const Sock> sock;
+        Sock::Event requested;
+    };
+
+    const int m_epoll_fd;
+    std::unordered_map<SOCKET, Registration> m_registrations;
+    std::vector<epoll_event> m_ready;
+
+    static uint32_t ToEpollEvents(Sock::Event requested)
+    {
+        uint32_t events{0};
+        if (requested & Sock::RECV) events |= EPOLLIN;
+        if (requested & Sock::SEND) events |= EPOLLOUT;
+        return events;
+    }
+
+    /** Register the requested events of a socket, or update them if they changed */
+    bool Update(const std::shared_ptr<const Sock>& sock, Sock::Event requested)
+    {
+        const SOCKET s{sock->Get()};
+        epoll_event ev{};
+        ev.events = ToEpollEvents(requested);
+        ev.data.fd = s;
+
+        auto it = m_registrations.find(s);
+        if (it != m_registrations.end() && it->second.sock.lock() == sock) {
+            if (it->second.requested == requested) return true;
+            if (epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, s, &ev) != 0) return false;
+            it->second.requested = requested;
+            return true;
+        }
+        // A new socket, possibly reusing the descriptor of a closed one
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, s, &ev) != 0 &&
+            (errno != EEXIST || epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, s, &ev) != 0)) {
+            return false;
+        }
+        m_registrations.insert_or_assign(s, Registration{sock, requested});
+        return true;
+    }
+
+public:
+    explicit EpollSockWaiter(int epoll_fd) : m_epoll_fd{epoll_fd} {}
+    ~EpollSockWaiter() override { close(m_epoll_fd); }
+
+    bool WaitMany(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock) override
+    {
+        if (events_per_sock.empty()) return false;
+
+        std::unordered_map<SOCKET, Sock::Events*> events_per_socket;
+        for (auto& [sock, events] : events_per_sock) {
+            events.occurred = 0;
+            events_per_socket.emplace(sock->Get(), &events);
+            if (!Update(sock, events.requested)) {
+                // Forget the registrations, the interest list is updated again on the next wait
+                LogPrint(BCLog::NET, "epoll_ctl failed: %s\n", NetworkErrorString(errno));
+                for (const auto& [s, registration] : m_registrations) {
+                    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, s, nullptr);
+                }
+                m_registrations.clear();
+                return events_per_sock.begin()->first->WaitMany(timeout, events_per_sock);
+            }
+        }
+        for (auto it = m_registrations.begin(); it != m_registrations.end();) {
+            if (events_per_socket.count(it->first)) {
+                ++it;
+                continue;
+            }
+            if (!it->second.sock.expired()) epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+            it = m_registrations.erase(it);
+        }
+
+        m_ready.resize(events_per_sock.size());
+        const int n_ready{epoll_wait(m_epoll_fd, m_ready.data(), m_ready.size(), count_milliseconds(timeout))};
+        if (n_ready == SOCKET_ERROR) {
+            return false;
+        }
+        for (int i = 0; i < n_ready; ++i) {
+            const auto it = events_per_socket.find(m_ready[i].data.fd);
+            if (it == events_per_socket.end()) continue;
+            if (m_ready[i].events & EPOLLIN) it->second->occurred |= Sock::RECV;
+            if (m_ready[i].events & EPOLLOUT) it->second->occurred |= Sock::SEND;
+            if (m_ready[i].events & (EPOLLERR | EPOLLHUP)) it->second->occurred |= Sock::ERR;
+        }
+        return true;
+    }
+};
+#endif // __linux__
+} // namespace
+
+std::unique_ptr<SockWaiter> MakeSockWaiter()
+{
+#ifdef __linux__
+    const int epoll_fd{epoll_create1(EPOLL_CLOEXEC)};
+    if (epoll_fd != -1) {
+        return std::make_unique<EpollSockWaiter>(epoll_fd);
+    }
+    LogPrintf("Unable to create epoll instance, falling back to poll: %s\n", NetworkErrorString(errno));
+#endif
+    return std::make_unique<WaitManySockWaiter>();
+}
+
 void Sock::SendComplete(const std::string& data,
                         std::chrono::milliseconds timeout,
                         CThreadInterrupt& interrupt) const
@@ -6,6 +6,7 @@
 #define BITCOIN_UTIL_SOCK_H
 
 #include <compat/compat.h>
+#include <span.h>
 #include <threadinterrupt.h>
 #include <util/time.h>
 
@@ -20,6 +21,13 @@
  */
 static constexpr auto MAX_WAIT_FOR_IO = 1s;
 
+/** Maximum number of buffers sent by a single `Sock::SendMany()` call. Windows sends only the first. */
+#ifdef WIN32
+static constexpr size_t MAX_SEND_MANY_BUFFERS{1};
+#else
+static constexpr size_t MAX_SEND_MANY_BUFFERS{64};
+#endif
+
 /**
  * RAII helper class that manages a socket. Mimics `std::unique_ptr`, but instead of a pointer it
  * contains a socket and closes it automatically when it goes out of scope.
@@ -74,6 +82,14 @@ public:
      */
     [[nodiscard]] virtual ssize_t Send(const void* data, size_t len, int flags) const;
 
+    /**
+     * sendmsg(2) wrapper, sending the given buffers in order with a single call. At most
+     * MAX_SEND_MANY_BUFFERS buffers are sent. Like `Send()`, it may send fewer bytes than given,
+     * and returns the number of bytes sent. Code that uses this wrapper can be unit tested if
+     * this method is overridden by a mock Sock implementation.
+     */
+    [[nodiscard]] virtual ssize_t SendMany(Span<const Span<const unsigned char>> buffers, int flags) const;
+
     /**
      * recv(2) wrapper. Equivalent to `recv(this->Get(), buf, len, flags);`. Code that uses this
      * wrapper can be unit tested if this method is overridden by a mock Sock implementation.
@@ -267,6 +283,27 @@ private:
     void Close();
 };
 
+/**
+ * Waits for events on mostly the same sockets over and over again, like the socket handler of
+ * CConnman. On Linux the sockets stay registered with epoll(7) between waits, so that only the
+ * changes to the requested events are passed to the kernel and the cost of a wait scales with
+ * the number of ready sockets, rather than all sockets. Elsewhere this is `Sock::WaitMany()`.
+ */
+class SockWaiter
+{
+public:
+    virtual ~SockWaiter() = default;
+
+    /**
+     * Same as `Sock::WaitMany()`. Sockets registered by a previous call that are not in
+     * `events_per_sock` are no longer waited on. Registrations don't keep sockets open.
+     */
+    [[nodiscard]] virtual bool WaitMany(std::chrono::milliseconds timeout, Sock::EventsPerSock& events_per_sock) = 0;
+};
+
+/** Create the most efficient `SockWaiter` supported by the system. */
+std::unique_ptr<SockWaiter> MakeSockWaiter();
+
 /** Return readable error string for a network error code */
 std::string NetworkErrorString(int err);
 
@@ -15,6 +15,10 @@
 #include <string>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static const std::string CHARS_ALPHA_NUM = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
 
 static const std::string SAFE_CHARS[] =
@@ -77,11 +81,45 @@ bool IsHexNumber(std::string_view str)
     return str.size() > 0;
 }
 
+#if defined(__SSE2__)
+namespace {
+/** Decode 32 hex characters into 16 bytes. Returns false, writing nothing, if any character is not a hex digit. */
+bool DecodeHex32(const char* in, uint8_t* out)
+{
+    __m128i bytes[2];
+    for (int i = 0; i < 2; ++i) {
+        const __m128i c = _mm_loadu_si128((const __m128i*)(in + 16 * i));
+        // Characters of 0x80 and above compare as negative and match neither range
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+        const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+        const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+        if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xffff) return false;
+        const __m128i values = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+                                            _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+        // Each 16-bit lane holds the high nibble in its low byte and the low nibble in its high byte
+        bytes[i] = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00ff)), 4), _mm_srli_epi16(values, 8));
+    }
+    _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(bytes[0], bytes[1]));
+    return true;
+}
+} // namespace
+#endif
+
 template <typename Byte>
 std::vector<Byte> ParseHex(std::string_view str)
 {
     std::vector<Byte> vch;
+    vch.reserve(str.size() / 2);
     auto it = str.begin();
+#if defined(__SSE2__)
+    // Decode runs of plain hex 16 bytes at a time. Anything else, such as
+    // whitespace, is left to the loop below.
+    uint8_t block[16];
+    while (str.end() - it >= 32 && DecodeHex32(&*it, block)) {
+        vch.insert(vch.end(), (const Byte*)block, (const Byte*)block + sizeof(block));
+        it += 32;
+    }
+#endif
     while (it != str.end() && it + 1 != str.end()) {
         if (IsSpace(*it)) {
             ++it;
@@ -480,8 +518,23 @@ std::string HexStr(const Span<const uint8_t> s)
     static_assert(sizeof(byte_to_hex) == 512);
 
     char* it = rv.data();
-    for (uint8_t v : s) {
-        std::memcpy(it, byte_to_hex[v].data(), 2);
+    size_t pos = 0;
+#if defined(__SSE2__)
+    // Encode 16 bytes at a time: split them into nibbles, interleave the high
+    // and low nibbles, and map 0-9 to '0'-'9' and 10-15 to 'a'-'f'.
+    for (; pos + 16 <= s.size(); pos += 16) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)(s.data() + pos));
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f));
+        const __m128i lo = _mm_and_si128(bytes, _mm_set1_epi8(0x0f));
+        for (const __m128i nibbles : {_mm_unpacklo_epi8(hi, lo), _mm_unpackhi_epi8(hi, lo)}) {
+            const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+            _mm_storeu_si128((__m128i*)it, _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters));
+            it += 16;
+        }
+    }
+#endif
+    for (; pos < s.size(); ++pos) {
+        std::memcpy(it, byte_to_hex[s[pos]].data(), 2);
         it += 2;
     }
 
@@ -549,16 +549,18 @@ public:
 
     void AllowAddressSpaceAccess()
     {
-        allowed_syscalls.insert(__NR_brk);        // change data segment size
-        allowed_syscalls.insert(__NR_madvise);    // give advice about use of memory
-        allowed_syscalls.insert(__NR_membarrier); // issue memory barriers on a set of threads
-        allowed_syscalls.insert(__NR_mincore);    // check if virtual memory is in RAM
-        allowed_syscalls.insert(__NR_mlock);      // lock memory
-        allowed_syscalls.insert(__NR_mmap);       // map files or devices into memory
-        allowed_syscalls.insert(__NR_mprotect);   // set protection on a region of memory
-        allowed_syscalls.insert(__NR_mremap);     // remap a file in memory
-        allowed_syscalls.insert(__NR_munlock);    // unlock memory
-        allowed_syscalls.insert(__NR_munmap);     // unmap files or devices into memory
+        allowed_syscalls.insert(__NR_brk);           // change data segment size
+        allowed_syscalls.insert(__NR_get_mempolicy); // retrieve NUMA memory policy
+        allowed_syscalls.insert(__NR_madvise);       // give advice about use of memory
+        allowed_syscalls.insert(__NR_mbind);         // set memory policy for a memory range
+        allowed_syscalls.insert(__NR_membarrier);    // issue memory barriers on a set of threads
+        allowed_syscalls.insert(__NR_mincore);       // check if virtual memory is in RAM
+        allowed_syscalls.insert(__NR_mlock);         // lock memory
+        allowed_syscalls.insert(__NR_mmap);          // map files or devices into memory
+        allowed_syscalls.insert(__NR_mprotect);      // set protection on a region of memory
+        allowed_syscalls.insert(__NR_mremap);        // remap a file in memory
+        allowed_syscalls.insert(__NR_munlock);       // unlock memory
+        allowed_syscalls.insert(__NR_munmap);        // unmap files or devices into memory
     }
 
     void AllowEpoll()
@@ -580,6 +582,7 @@ public:
         allowed_syscalls.insert(__NR_chdir);           // change working directory
         allowed_syscalls.insert(__NR_chmod);           // change permissions of a file
         allowed_syscalls.insert(__NR_copy_file_range); // copy a range of data from one file to another
+        allowed_syscalls.insert(__NR_fadvise64);       // predeclare an access pattern for file data
         allowed_syscalls.insert(__NR_fallocate);       // manipulate file space
         allowed_syscalls.insert(__NR_fchmod);          // change permissions of a file
         allowed_syscalls.insert(__NR_fchown);          // change ownership of a file
@@ -855,9 +858,6 @@ void SetSyscallSandboxPolicy(SyscallSandboxPolicy syscall_policy)
         seccomp_policy_builder.AllowFileSystem();
         seccomp_policy_builder.AllowNetwork();
         break;
-    case SyscallSandboxPolicy::INITIALIZATION_LOAD_BLOCKS: // Thread: loadblk
-        seccomp_policy_builder.AllowFileSystem();
-        break;
     case SyscallSandboxPolicy::INITIALIZATION_MAP_PORT: // Thread: mapport
         seccomp_policy_builder.AllowFileSystem();
         seccomp_policy_builder.AllowNetwork();
@@ -877,10 +877,6 @@ void SetSyscallSandboxPolicy(SyscallSandboxPolicy syscall_policy)
         seccomp_policy_builder.AllowFileSystem();
         seccomp_policy_builder.AllowNetwork();
         break;
-    case SyscallSandboxPolicy::NET_HTTP_SERVER_WORKER: // Thread: httpworker.<N>
-        seccomp_policy_builder.AllowFileSystem();
-        seccomp_policy_builder.AllowNetwork();
-        break;
     case SyscallSandboxPolicy::NET_OPEN_CONNECTION: // Thread: opencon
         seccomp_policy_builder.AllowFileSystem();
         seccomp_policy_builder.AllowNetwork();
@@ -888,6 +884,11 @@ void SetSyscallSandboxPolicy(SyscallSandboxPolicy syscall_policy)
     case SyscallSandboxPolicy::SCHEDULER: // Thread: scheduler
         seccomp_policy_builder.AllowFileSystem();
         break;
+    case SyscallSandboxPolicy::THREAD_POOL: // Thread: pool.<N>
+        // Runs the tasks of script checks, HTTP requests, index syncs and block loading
+        seccomp_policy_builder.AllowFileSystem();
+        seccomp_policy_builder.AllowNetwork();
+        break;
     case SyscallSandboxPolicy::TOR_CONTROL: // Thread: torcontrol
         seccomp_policy_builder.AllowFileSystem();
         seccomp_policy_builder.AllowNetwork();
@@ -9,7 +9,6 @@ enum class SyscallSandboxPolicy {
     // 1. Initialization
     INITIALIZATION,
     INITIALIZATION_DNS_SEED,
-    INITIALIZATION_LOAD_BLOCKS,
     INITIALIZATION_MAP_PORT,
 
     // 2. Steady state (non-initialization, non-shutdown)
@@ -17,9 +16,9 @@ enum class SyscallSandboxPolicy {
     NET,
     NET_ADD_CONNECTION,
     NET_HTTP_SERVER,
-    NET_HTTP_SERVER_WORKER,
     NET_OPEN_CONNECTION,
     SCHEDULER,
+    THREAD_POOL,
     TOR_CONTROL,
     TX_INDEX,
     VALIDATION_SCRIPT_CHECK,
@@ -1303,6 +1303,18 @@ void AllocateFileRange(FILE *file, unsigned int offset, unsigned int length) {
 #endif
 }
 
+void PrefetchFile(FILE *file) {
+#if defined(HAVE_POSIX_FADVISE)
+    // Both calls are advisory, so failures are ignored
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_WILLNEED);
+#elif defined(MAC_OSX)
+    fcntl(fileno(file), F_RDAHEAD, 1);
+#else
+    (void)file;
+#endif
+}
+
 #ifdef WIN32
 fs::path GetSpecialFolderPath(int nFolder, bool fCreate)
 {
@@ -68,6 +68,8 @@ void DirectoryCommit(const fs::path &dirname);
 bool TruncateFile(FILE *file, unsigned int length);
 int RaiseFileDescriptorLimit(int nMinFD);
 void AllocateFileRange(FILE *file, unsigned int offset, unsigned int length);
+/** Advise the OS that file is about to be read sequentially, so it can start reading it into the page cache. */
+void PrefetchFile(FILE *file);
 
 /**
  * Rename src to dest.
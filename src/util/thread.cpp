@@ -5,14 +5,47 @@
 #include <util/thread.h>
 
 #include <logging.h>
+#include <tinyformat.h>
+#include <util/strencodings.h>
+#include <util/string.h>
 #include <util/system.h>
 #include <util/threadnames.h>
 
+#include <algorithm>
 #include <exception>
+#include <fstream>
 #include <functional>
 #include <string>
 #include <utility>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+//! Highest CPU number accepted in a CPU set
+constexpr uint32_t MAX_CPU{1023};
+
+//! Parse a comma separated list of CPU numbers and ranges of them, like "0-3,8", into cpus
+bool ParseCpuList(const std::string& list, std::vector<unsigned int>& cpus)
+{
+    for (const std::string& entry : SplitString(TrimString(list), ',')) {
+        const std::vector<std::string> range{SplitString(entry, '-')};
+        uint32_t first, last;
+        if (range.size() > 2 ||
+            !ParseUInt32(TrimString(range.front()), &first) || !ParseUInt32(TrimString(range.back()), &last) ||
+            first > last || last > MAX_CPU) {
+            return false;
+        }
+        for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return true;
+}
+} // namespace
+
 void util::TraceThread(std::string_view thread_name, std::function<void()> thread_func)
 {
     util::ThreadRename(std::string{thread_name});
@@ -28,3 +61,43 @@ void util::TraceThread(std::string_view thread_name, std::function<void()> threa
         throw;
     }
 }
+
+std::optional<std::vector<unsigned int>> util::ParseCpuSet(const std::string& cpu_set)
+{
+    std::vector<unsigned int> cpus;
+    for (const std::string& entry : SplitString(cpu_set, ',')) {
+        const std::string item{TrimString(entry)};
+        if (item.rfind("node", 0) == 0) {
+            // The CPUs of a NUMA node are listed in the same format
+            uint32_t node;
+            if (!ParseUInt32(item.substr(4), &node)) return std::nullopt;
+            std::ifstream file{strprintf("/sys/devices/system/node/node%u/cpulist", node)};
+            std::string list;
+            if (!std::getline(file, list) || !ParseCpuList(list, cpus)) return std::nullopt;
+        } else if (!ParseCpuList(item, cpus)) {
+            return std::nullopt;
+        }
+    }
+    if (cpus.empty()) return std::nullopt;
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool util::SetThreadAffinity(const std::vector<unsigned int>& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const unsigned int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    if (const int err{pthread_setaffinity_np(pthread_self(), sizeof(set), &set)}; err != 0) {
+        LogPrintf("Failed to pin thread %s to CPUs %s (error %d)\n", util::ThreadGetInternalName(), Join(cpus, ",", [](unsigned int cpu) { return ToString(cpu); }), err);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
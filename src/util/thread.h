@@ -6,7 +6,9 @@
 #define BITCOIN_UTIL_THREAD_H
 
 #include <functional>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace util {
 /**
@@ -14,6 +16,16 @@ namespace util {
  */
 void TraceThread(std::string_view thread_name, std::function<void()> thread_func);
 
+/**
+ * Parse a set of CPUs, as a comma separated list of CPU numbers, ranges of
+ * them like "0-7", and NUMA nodes like "node1", which stand for the CPUs of
+ * the node. Returns the sorted CPUs, or nullopt if the set is invalid or empty.
+ */
+std::optional<std::vector<unsigned int>> ParseCpuSet(const std::string& cpu_set);
+
+/** Restrict the calling thread to run on the given CPUs. Only supported on Linux. */
+bool SetThreadAffinity(const std::vector<unsigned int>& cpus);
+
 } // namespace util
 
 #endif // BITCOIN_UTIL_THREAD_H
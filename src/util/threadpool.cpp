@@ -0,0 +1,336 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/threadpool.h>
+
+#include <logging.h>
+#include <tinyformat.h>
+#include <util/system.h>
+#include <util/thread.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <utility>
+
+namespace util {
+
+namespace {
+//! The pool the current thread is a worker of, and its index
+thread_local const ThreadPool* t_pool{nullptr};
+thread_local size_t t_worker_index{0};
+
+//! The shared thread pool, and the number of ParallelFor() calls running on it
+Mutex g_shared_pool_mutex;
+std::condition_variable g_shared_pool_cv;
+ThreadPool* g_shared_pool GUARDED_BY(g_shared_pool_mutex){nullptr};
+size_t g_shared_pool_users GUARDED_BY(g_shared_pool_mutex){0};
+} // namespace
+
+std::string TaskPriorityToString(TaskPriority priority)
+{
+    switch (priority) {
+    case TaskPriority::HIGH: return "high";
+    case TaskPriority::NORMAL: return "normal";
+    case TaskPriority::LOW: return "low";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+ThreadPool::ThreadPool(Options options)
+    : m_options{std::move(options)},
+      m_max_low_priority{std::max<size_t>(1, m_options.threads / 2)}
+{
+    assert(m_options.threads > 0);
+    for (int n = 0; n < m_options.threads; ++n) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (int n = 0; n < m_options.threads; ++n) {
+        m_threads.emplace_back([this, n] { WorkerLoop(n); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    Stop();
+}
+
+void ThreadPool::Stop()
+{
+    {
+        LOCK(m_mutex);
+        if (m_stop) return;
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+bool ThreadPool::IsWorkerThread() const
+{
+    return t_pool == this;
+}
+
+std::vector<TaskPoolStats> ThreadPool::GetStats() const
+{
+    LOCK(m_mutex);
+    std::vector<TaskPoolStats> stats;
+    for (const auto& pool : m_pools) {
+        stats.push_back({pool->name, pool->priority, pool->tasks_run, pool->tasks_stolen,
+                         pool->queued, pool->running, std::chrono::microseconds{pool->busy_us.load()}});
+    }
+    return stats;
+}
+
+std::shared_ptr<ThreadPool::PoolState> ThreadPool::AddPool(std::string name, TaskPriority priority)
+{
+    LOCK(m_mutex);
+    for (const auto& state : m_pools) {
+        if (state->name == name && state->priority == priority) return state;
+    }
+    auto state{std::make_shared<PoolState>()};
+    state->name = std::move(name);
+    state->priority = priority;
+    m_pools.push_back(state);
+    return state;
+}
+
+void ThreadPool::Post(Task task)
+{
+    const size_t priority{static_cast<size_t>(task.pool->priority)};
+    bool stopped;
+    {
+        LOCK(m_mutex);
+        stopped = m_stop;
+        if (!stopped) {
+            ++m_queued[priority];
+            ++task.pool->queued;
+        }
+    }
+    if (stopped) {
+        // No worker would run it
+        Run(task);
+        return;
+    }
+    const size_t index{IsWorkerThread() ? t_worker_index : m_next_worker++ % m_workers.size()};
+    {
+        Worker& worker{*m_workers[index]};
+        LOCK(worker.m_mutex);
+        worker.m_tasks[priority].push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+std::optional<ThreadPool::Task> ThreadPool::TakeTask(size_t index)
+{
+    for (size_t priority = 0; priority < NUM_PRIORITIES; ++priority) {
+        if (m_queued[priority] == 0) continue;
+        const bool low_priority{priority == static_cast<size_t>(TaskPriority::LOW)};
+        if (low_priority) {
+            // Reserve a slot for running it, so that long running tasks leave workers for the others
+            size_t running{m_running_low_priority};
+            do {
+                if (running >= m_max_low_priority && !WITH_LOCK(m_mutex, return m_stop)) return std::nullopt;
+            } while (!m_running_low_priority.compare_exchange_weak(running, running + 1));
+        }
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            Worker& worker{*m_workers[(index + i) % m_workers.size()]};
+            LOCK(worker.m_mutex);
+            auto& tasks{worker.m_tasks[priority]};
+            if (tasks.empty()) continue;
+            Task task{std::move(tasks.front())};
+            tasks.pop_front();
+            --m_queued[priority];
+            --task.pool->queued;
+            if (i > 0) ++task.pool->tasks_stolen;
+            return task;
+        }
+        if (low_priority) --m_running_low_priority;
+    }
+    return std::nullopt;
+}
+
+bool ThreadPool::HasRunnableTask() const
+{
+    return m_queued[static_cast<size_t>(TaskPriority::HIGH)] > 0 ||
+           m_queued[static_cast<size_t>(TaskPriority::NORMAL)] > 0 ||
+           (m_queued[static_cast<size_t>(TaskPriority::LOW)] > 0 && (m_running_low_priority < m_max_low_priority || m_stop));
+}
+
+void ThreadPool::Run(Task& task)
+{
+    ++task.pool->running;
+    const auto start{std::chrono::steady_clock::now()};
+    try {
+        task.func();
+    } catch (const std::exception& e) {
+        PrintExceptionContinue(&e, util::ThreadGetInternalName());
+        throw;
+    } catch (...) {
+        PrintExceptionContinue(nullptr, util::ThreadGetInternalName());
+        throw;
+    }
+    task.pool->busy_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    --task.pool->running;
+    ++task.pool->tasks_run;
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+    util::ThreadRename(strprintf("%s.%i", m_options.name, index));
+    if (m_options.syscall_sandbox_policy) SetSyscallSandboxPolicy(*m_options.syscall_sandbox_policy);
+    if (!m_options.cpus.empty()) {
+        SetThreadAffinity({m_options.cpus[index % m_options.cpus.size()]});
+    } else if (m_options.pin_threads) {
+        if (const unsigned int num_cpus{std::thread::hardware_concurrency()}; num_cpus > 0) {
+            SetThreadAffinity({static_cast<unsigned int>(index % num_cpus)});
+        }
+    }
+    t_pool = this;
+    t_worker_index = index;
+
+    while (true) {
+        std::optional<Task> task{TakeTask(index)};
+        if (!task) {
+            WAIT_LOCK(m_mutex, lock);
+            while (!HasRunnableTask() && !m_stop) {
+                m_cv.wait(lock);
+            }
+            if (m_stop && std::all_of(m_queued.begin(), m_queued.end(), [](const auto& queued) { return queued == 0; })) {
+                return;
+            }
+            continue;
+        }
+        Run(*task);
+        if (task->pool->priority == TaskPriority::LOW) {
+            // A worker may be waiting for a slot to run another one
+            {
+                LOCK(m_mutex);
+                --m_running_low_priority;
+            }
+            m_cv.notify_one();
+        }
+    }
+}
+
+TaskPool::TaskPool(ThreadPool& pool, std::string name, TaskPriority priority)
+    : m_pool{pool}, m_state{pool.AddPool(std::move(name), priority)}
+{
+}
+
+void TaskPool::Post(std::function<void()> func) const
+{
+    m_pool.Post({std::move(func), m_state});
+}
+
+std::future<void> TaskPool::Submit(std::function<void()> func) const
+{
+    auto promise{std::make_shared<std::promise<void>>()};
+    std::future<void> future{promise->get_future()};
+    Post([func = std::move(func), promise] {
+        func();
+        promise->set_value();
+    });
+    return future;
+}
+
+void ParallelFor(const TaskPool* pool, size_t count, size_t max_threads, const std::function<void(size_t)>& func)
+{
+    struct State {
+        std::atomic<size_t> next{0};
+        Mutex mutex;
+        std::condition_variable cv;
+        //! Number of tasks making calls, and whether the caller returned, after which tasks must not make any
+        size_t running GUARDED_BY(mutex){0};
+        bool finished GUARDED_BY(mutex){false};
+        std::exception_ptr error GUARDED_BY(mutex);
+    };
+    const auto state{std::make_shared<State>()};
+    const auto run{[&state = *state, count, &func] {
+        for (size_t i = state.next++; i < count; i = state.next++) {
+            try {
+                func(i);
+            } catch (...) {
+                LOCK(state.mutex);
+                if (!state.error) state.error = std::current_exception();
+                state.next = count;
+            }
+        }
+    }};
+
+    if (pool) {
+        for (size_t i = 1; i < std::min(count, max_threads); ++i) {
+            pool->Post([state, run] {
+                {
+                    LOCK(state->mutex);
+                    if (state->finished) return;
+                    ++state->running;
+                }
+                run();
+                {
+                    LOCK(state->mutex);
+                    --state->running;
+                }
+                state->cv.notify_all();
+            });
+        }
+    }
+    run();
+
+    std::exception_ptr error;
+    {
+        WAIT_LOCK(state->mutex, lock);
+        while (state->running > 0) {
+            state->cv.wait(lock);
+        }
+        state->finished = true;
+        error = state->error;
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void SetSharedThreadPool(ThreadPool* pool)
+{
+    WAIT_LOCK(g_shared_pool_mutex, lock);
+    while (g_shared_pool_users > 0) {
+        g_shared_pool_cv.wait(lock);
+    }
+    g_shared_pool = pool;
+}
+
+void ParallelFor(const std::string& name, TaskPriority priority, size_t count, size_t max_threads, const std::function<void(size_t)>& func)
+{
+    ThreadPool* thread_pool;
+    {
+        LOCK(g_shared_pool_mutex);
+        thread_pool = g_shared_pool;
+        if (thread_pool) ++g_shared_pool_users;
+    }
+    if (!thread_pool) {
+        ParallelFor(nullptr, count, 1, func);
+        return;
+    }
+    // The pool may only be cleared once this call returned
+    const auto release{[] {
+        {
+            LOCK(g_shared_pool_mutex);
+            --g_shared_pool_users;
+        }
+        g_shared_pool_cv.notify_all();
+    }};
+    try {
+        const TaskPool pool{*thread_pool, name, priority};
+        ParallelFor(&pool, count, std::min<size_t>(max_threads, thread_pool->GetThreadCount() + 1), func);
+    } catch (...) {
+        release();
+        throw;
+    }
+    release();
+}
+
+} // namespace util
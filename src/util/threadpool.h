@@ -0,0 +1,201 @@
+// Copyright (c) 2023 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADPOOL_H
+#define BITCOIN_UTIL_THREADPOOL_H
+
+#include <sync.h>
+#include <util/syscall_sandbox.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/** Priority of the tasks of a TaskPool. Workers run the queued tasks of higher priorities first. */
+enum class TaskPriority {
+    //! Short tasks that something is waiting on, like the verifications of a block
+    HIGH,
+    //! Short tasks, like RPC calls
+    NORMAL,
+    //! Long running background tasks, like syncing an index. They may occupy at most half of the workers.
+    LOW,
+};
+
+std::string TaskPriorityToString(TaskPriority priority);
+
+/** Utilisation statistics of a TaskPool */
+struct TaskPoolStats {
+    std::string name;
+    TaskPriority priority;
+    //! Number of tasks that were run, and how many of them were stolen from the queue of another worker
+    uint64_t tasks_run;
+    uint64_t tasks_stolen;
+    //! Number of tasks waiting for a worker, and being run
+    size_t queued;
+    size_t running;
+    //! Total time workers spent running the tasks
+    std::chrono::microseconds busy_time;
+};
+
+class TaskPool;
+
+/**
+ * A fixed set of worker threads, shared by the tasks of several TaskPools.
+ *
+ * Each worker has a queue of tasks for every priority. Tasks submitted from a
+ * worker go to its own queue, and the others are spread over the workers in
+ * turn. A worker runs the oldest task of the highest priority it finds,
+ * looking at its own queue first and stealing from the queues of the other
+ * workers when its own is empty, so that workers don't contend on a single lock.
+ */
+class ThreadPool
+{
+public:
+    struct Options {
+        //! Prefix of the names of the worker threads
+        std::string name{"pool"};
+        int threads{1};
+        //! Pin worker N to CPU N modulo the number of CPUs. Only supported on Linux.
+        bool pin_threads{false};
+        //! If not empty, pin worker N to the Nth of these CPUs, modulo their number, instead
+        std::vector<unsigned int> cpus;
+        //! Policy the worker threads restrict themselves to
+        std::optional<SyscallSandboxPolicy> syscall_sandbox_policy;
+    };
+
+    explicit ThreadPool(Options options);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    /** Run the queued tasks, and stop and join the workers. Tasks submitted afterwards are run by the caller. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    int GetThreadCount() const { return m_workers.size(); }
+    /** Whether the calling thread is one of the workers */
+    bool IsWorkerThread() const;
+    /** Statistics of the TaskPools using the workers, in the order they were created */
+    std::vector<TaskPoolStats> GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    friend class TaskPool;
+
+    /** Statistics shared by a TaskPool and its copies */
+    struct PoolState {
+        std::string name;
+        TaskPriority priority;
+        std::atomic<uint64_t> tasks_run{0};
+        std::atomic<uint64_t> tasks_stolen{0};
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> running{0};
+        std::atomic<int64_t> busy_us{0};
+    };
+
+    struct Task {
+        std::function<void()> func;
+        std::shared_ptr<PoolState> pool;
+    };
+
+    static constexpr size_t NUM_PRIORITIES{3};
+
+    struct Worker {
+        Mutex m_mutex;
+        std::array<std::deque<Task>, NUM_PRIORITIES> m_tasks GUARDED_BY(m_mutex);
+    };
+
+    std::shared_ptr<PoolState> AddPool(std::string name, TaskPriority priority) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Post(Task task) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Take the task the worker should run next, if there is one */
+    std::optional<Task> TakeTask(size_t index);
+    /** Whether a waiting worker has a task it may run */
+    bool HasRunnableTask() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Run(Task& task);
+    void WorkerLoop(size_t index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    const Options m_options;
+    //! Maximum number of workers running LOW priority tasks
+    const size_t m_max_low_priority;
+
+    mutable Mutex m_mutex;
+    //! Workers block on this when out of work
+    std::condition_variable m_cv;
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::shared_ptr<PoolState>> m_pools GUARDED_BY(m_mutex);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    //! Worker the next task submitted from outside of the workers is queued for
+    std::atomic<size_t> m_next_worker{0};
+    /**
+     * Number of tasks of each priority that no worker has taken yet. It is
+     * increased with m_mutex held, before the task is queued, so that idle
+     * workers don't miss it.
+     */
+    std::array<std::atomic<size_t>, NUM_PRIORITIES> m_queued{};
+    std::atomic<size_t> m_running_low_priority{0};
+};
+
+/**
+ * A named set of tasks that are run on the workers of a ThreadPool at the same
+ * priority, and whose utilisation is reported separately. Copies, and
+ * TaskPools created again with the same name and priority, share the
+ * statistics. The ThreadPool must outlive it.
+ */
+class TaskPool
+{
+public:
+    TaskPool(ThreadPool& pool, std::string name, TaskPriority priority);
+
+    /** Queue func to be run by a worker */
+    void Post(std::function<void()> func) const;
+    /** Queue func to be run by a worker, returning a future that is ready once it ran */
+    std::future<void> Submit(std::function<void()> func) const;
+
+    ThreadPool& GetThreadPool() const { return m_pool; }
+
+private:
+    ThreadPool& m_pool;
+    std::shared_ptr<ThreadPool::PoolState> m_state;
+};
+
+/**
+ * Call func(i) for every i in [0, count), on the calling thread and on up to
+ * max_threads - 1 tasks of pool, and return once all calls returned. Tasks
+ * that only start once all calls were made return right away, so the caller
+ * doesn't wait for busy workers and may be a worker itself. If a call throws,
+ * no further calls are started and the first exception is rethrown. Without a
+ * pool, all calls are made on the calling thread.
+ */
+void ParallelFor(const TaskPool* pool, size_t count, size_t max_threads, const std::function<void(size_t)>& func);
+
+/**
+ * Set the thread pool that code without access to the node's, like the coins
+ * database and the wallet, runs its parallel work on. nullptr clears it. Waits
+ * for the ParallelFor() calls running on the previous pool to return.
+ */
+void SetSharedThreadPool(ThreadPool* pool);
+
+/**
+ * ParallelFor() on tasks of the given name and priority of the shared thread
+ * pool, or on the calling thread only if none is set. max_threads is capped at
+ * the number of workers of the pool plus the caller.
+ */
+void ParallelFor(const std::string& name, TaskPriority priority, size_t count, size_t max_threads, const std::function<void(size_t)>& func);
+
+} // namespace util
+
+#endif // BITCOIN_UTIL_THREADPOOL_H
@@ -7,6 +7,7 @@
 
 #include <kernel/coinstats.h>
 #include <kernel/mempool_persist.h>
+#include <kernel/validation_stats.h>
 
 #include <arith_uint256.h>
 #include <chain.h>
@@ -15,6 +16,7 @@
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/conversion.h>
+#include <consensus/invariant.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_check.h>
 #include <consensus/tx_verify.h>
@@ -51,6 +53,8 @@
 #include <util/rbf.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/thread.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
@@ -61,14 +65,16 @@
 #include <boost/multiprecision/cpp_int.hpp>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <map>
 #include <numeric>
 #include <optional>
 #include <string>
+#include <thread>
+#include <unordered_set>
 
-using kernel::CCoinsStats;
-using kernel::CoinStatsHashType;
-using kernel::ComputeUTXOStats;
+using kernel::ApplyHash;
 using kernel::LoadMempool;
 
 using fsbridge::FopenFn;
@@ -76,13 +82,15 @@ using node::BlockManager;
 using node::BlockMap;
 using node::CBlockIndexHeightOnlyComparator;
 using node::CBlockIndexWorkComparator;
+using node::DeserializeSnapshotChunk;
 using node::fImporting;
 using node::fPruneMode;
 using node::fReindex;
 using node::ReadBlockFromDisk;
+using node::SnapshotChunk;
+using node::SnapshotChunkInfo;
 using node::SnapshotMetadata;
 using node::UndoReadFromDisk;
-using node::UnlinkPrunedFiles;
 
 using namespace boost::multiprecision;
 
@@ -128,7 +136,15 @@ GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 bool g_parallel_script_checks{false};
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+/** Checks the scripts of blocks connected by the background chainstate of a snapshot, if it has workers */
+static CCheckQueue<CScriptCheck> background_scriptcheckqueue(128);
+static bool g_parallel_background_script_checks{false};
+/** Transactions with at least this many inputs have their scripts checked on the script check queue in AcceptToMemoryPool. */
+static constexpr size_t MEMPOOL_SCRIPT_CHECK_QUEUE_MIN_INPUTS{16};
 bool fCheckBlockIndex = false;
+bool g_coins_cache_huge_pages{DEFAULT_DBCACHE_HUGE_PAGES};
+bool g_coins_flush_background{DEFAULT_DBFLUSH_BACKGROUND};
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
 
@@ -158,8 +174,9 @@ const CBlockIndex* Chainstate::FindForkInGlobalIndex(const CBlockLocator& locato
 bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
-                       std::vector<CScriptCheck>* pvChecks = nullptr)
-                       EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                       std::vector<CScriptCheck>* pvChecks = nullptr);
+
+static void CacheScriptExecution(const CTransaction& tx, unsigned int flags);
 
 bool CheckFinalTxAtTip(const CBlockIndex& active_chain_tip, const CTransaction& tx)
 {
@@ -196,30 +213,64 @@ bool CheckExpiredConversionAtTip(const CBlockIndex& active_chain_tip, const CTxC
     return IsExpiredConversionInfo(info, nBlockHeight);
 }
 
-bool CheckValidConversionAtTip(CBlockIndex* tip, const CTxConversionInfo& info, const int& check_last_N_blocks, const int& percent_buffer)
+//! Number of conversion validity windows built, for their ids
+static std::atomic<uint64_t> g_conversion_window_count{0};
+
+ConversionValidityWindow::ConversionValidityWindow(const CBlockIndex* tip, int check_last_N_blocks, int percent_buffer)
+    : m_id{++g_conversion_window_count}, m_tip{tip}, m_check_last_N_blocks{check_last_N_blocks}, m_percent_buffer{percent_buffer}
 {
-    AssertLockHeld(cs_main);
-    CBlockIndex* pindex = tip;
-    CAmount dummy;
+    const CBlockIndex* pindex = tip;
     for (int i = 0; i < check_last_N_blocks && pindex != nullptr; i++) {
-        // Check validity by increasing cash supply by allowable buffer
+        // Increase cash supply by allowable buffer
         CAmounts totalSupply1 = pindex->GetTotalSupply();
         totalSupply1[CASH] += totalSupply1[CASH] * percent_buffer / 10000; // percent_buffer represented in bips (1% = 100)
-        if (Consensus::IsValidConversion(totalSupply1, info.inputs, info.minOutputs, info.remainderType, dummy)) {
-            return true;
-        }
-        // Check validity by increasing bond supply by allowable buffer
+        m_supplies.push_back({totalSupply1, GetInvariantSquare(totalSupply1)});
+        // Increase bond supply by allowable buffer
         CAmounts totalSupply2 = pindex->GetTotalSupply();
         totalSupply2[BOND] += totalSupply2[BOND] * percent_buffer / 10000; // percent_buffer represented in bips (1% = 100)
-        if (Consensus::IsValidConversion(totalSupply2, info.inputs, info.minOutputs, info.remainderType, dummy)) {
-            return true;
-        }
+        m_supplies.push_back({totalSupply2, GetInvariantSquare(totalSupply2)});
         // Check the previous block
         pindex = pindex->pprev;
     }
+}
+
+bool ConversionValidityWindow::IsValid(const CTxMemPoolEntry& entry) const
+{
+    const CTxConversionInfo* info = entry.GetConversionInfo();
+    if (!info) return true;
+    if (const std::optional<bool> valid = entry.GetCachedConversionValidity(m_id)) return *valid;
+    const bool valid = IsValid(*info);
+    entry.SetCachedConversionValidity(m_id, valid);
+    return valid;
+}
+
+bool ConversionValidityWindow::IsValid(const CTxConversionInfo& info) const
+{
+    // Equivalent to Consensus::IsValidConversion succeeding against any buffered supply
+    for (const BufferedSupply& buffered : m_supplies) {
+        if (GetInvariantSquare(buffered.totalSupply, info.inputs, info.minOutputs) <= buffered.invariant_sq) {
+            return true;
+        }
+    }
     return false;
 }
 
+FeeConversionWindow::FeeConversionWindow(const CBlockIndex* tip, int check_last_N_blocks)
+    : m_tip{tip}, m_check_last_N_blocks{check_last_N_blocks}, m_tip_rate{tip->GetTotalSupply()}
+{
+    const CBlockIndex* pindex = tip;
+    for (int i = 0; i < check_last_N_blocks && pindex != nullptr; i++) {
+        m_rates.emplace_back(pindex->GetTotalSupply());
+        pindex = pindex->pprev;
+    }
+}
+
+bool CheckValidConversionAtTip(const CBlockIndex* tip, const CTxConversionInfo& info, const int& check_last_N_blocks, const int& percent_buffer)
+{
+    AssertLockHeld(cs_main);
+    return ConversionValidityWindow{tip, check_last_N_blocks, percent_buffer}.IsValid(info);
+}
+
 bool CheckSequenceLocksAtTip(CBlockIndex* tip,
                         const CCoinsView& coins_view,
                         const CTransaction& tx,
@@ -298,7 +349,7 @@ bool CheckSequenceLocksAtTip(CBlockIndex* tip,
 // Returns the script flags which should be checked for a given block
 static unsigned int GetBlockScriptFlags(const CBlockIndex& block_index, const ChainstateManager& chainman);
 
-static void LimitMempoolSize(CTxMemPool& pool, CChain& chain, CCoinsViewCache& coins_cache)
+static void LimitMempoolSize(CTxMemPool& pool, Chainstate& active_chainstate)
     EXCLUSIVE_LOCKS_REQUIRED(::cs_main, pool.cs)
 {
     AssertLockHeld(::cs_main);
@@ -308,23 +359,19 @@ static void LimitMempoolSize(CTxMemPool& pool, CChain& chain, CCoinsViewCache& c
         LogPrint(BCLog::MEMPOOL, "Expired %i transactions from the memory pool\n", expired);
     }
 
-    CBlockIndex* tip = chain.Tip();
+    if (pool.DynamicMemoryUsage() <= pool.m_max_size_bytes) return;
+
+    // Conversion considered invalid if not valid in the next block within set buffer
     int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
-    std::function<bool(CTxMemPool::txiter)> is_invalid_conversion = [tip, buffer](CTxMemPool::txiter it)
-        EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
-        AssertLockHeld(::cs_main);
-        // Conversion considered invalid if not valid in the next block within set buffer
-        int checkLastNBlocks = 1;
-        if (it->GetConversionInfo() && !CheckValidConversionAtTip(tip, it->GetConversionInfo().value(), checkLastNBlocks, buffer)) {
-            return true;
-        }
-        return false;
-    };
+    const auto conversion_window = active_chainstate.GetConversionValidityWindow(/*check_last_N_blocks=*/1, buffer);
+    pool.UpdateInvalidConversions(active_chainstate.m_chain.Tip()->GetBlockHash(), [&conversion_window](CTxMemPool::txiter it) {
+        return !conversion_window->IsValid(*it);
+    });
 
     std::vector<COutPoint> vNoSpendsRemaining;
-    pool.TrimToSize(pool.m_max_size_bytes, is_invalid_conversion, &vNoSpendsRemaining);
+    pool.TrimToSize(pool.m_max_size_bytes, &vNoSpendsRemaining);
     for (const COutPoint& removed : vNoSpendsRemaining)
-        coins_cache.Uncache(removed);
+        active_chainstate.CoinsTip().Uncache(removed);
 }
 
 static bool IsCurrentForFeeEstimation(Chainstate& active_chainstate) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
@@ -355,22 +402,34 @@ void Chainstate::MaybeUpdateMempoolForReorg(
     // Iterate disconnectpool in reverse, so that we add transactions
     // back to the mempool starting with the earliest transaction that had
     // been previously seen in a block.
+    std::vector<CTransactionRef> resurrected;
     auto it = disconnectpool.queuedTx.get<insertion_order>().rbegin();
     while (it != disconnectpool.queuedTx.get<insertion_order>().rend()) {
-        // ignore validation errors in resurrected transactions
-        if (!fAddToMempool || (*it)->IsCoinBase() ||
-            AcceptToMemoryPool(*this, *it, GetTime(),
-                /*bypass_limits=*/true, /*test_accept=*/false).m_result_type !=
-                    MempoolAcceptResult::ResultType::VALID) {
-            // If the transaction doesn't make it in to the mempool, remove any
-            // transactions that depend on it (which would now be orphans).
+        if (!fAddToMempool || (*it)->IsCoinBase()) {
+            // Remove any transactions that depend on it (which would now be orphans).
             m_mempool->removeRecursive(**it, MemPoolRemovalReason::REORG);
-        } else if (m_mempool->exists(GenTxid::Txid((*it)->GetHash()))) {
-            vHashUpdate.push_back((*it)->GetHash());
+        } else {
+            resurrected.push_back(*it);
         }
         ++it;
     }
     disconnectpool.queuedTx.clear();
+    if (!resurrected.empty()) {
+        // Submit them as a batch, so that independent transactions share the mempool lock and
+        // have their scripts checked in parallel.
+        const auto results{AcceptToMemoryPoolBatch(*this, resurrected, std::vector<int64_t>(resurrected.size(), GetTime()),
+                                                   /*bypass_limits=*/true)};
+        for (size_t i = 0; i < resurrected.size(); ++i) {
+            // ignore validation errors in resurrected transactions
+            if (results[i].m_result_type != MempoolAcceptResult::ResultType::VALID) {
+                // If the transaction doesn't make it in to the mempool, remove any
+                // transactions that depend on it (which would now be orphans).
+                m_mempool->removeRecursive(*resurrected[i], MemPoolRemovalReason::REORG);
+            } else if (m_mempool->exists(GenTxid::Txid(resurrected[i]->GetHash()))) {
+                vHashUpdate.push_back(resurrected[i]->GetHash());
+            }
+        }
+    }
     // AcceptToMemoryPool/addUnchecked all assume that new mempool entries have
     // no in-mempool children, which is generally not true when adding
     // previously-confirmed transactions back to the mempool.
@@ -382,24 +441,26 @@ void Chainstate::MaybeUpdateMempoolForReorg(
     // Checks whether the transaction is still final and if it spends a coinbase output, mature.
     // If conversion, also checks whether transaction has expired or is invalid at start of next block.
     // Also updates valid entries' cached LockPoints if needed.
-    // If false, the tx is still valid and its lockpoints are updated.
-    // If true, the tx would be invalid in the next block; remove this entry and all of its descendants.
+    // If nullopt, the tx is still valid and its lockpoints are updated.
+    // Otherwise, the tx would be invalid in the next block; remove this entry and all of its descendants
+    // for the returned reason.
 
     int checkLastNBlocks = gArgs.GetIntArg("-mempoolexistingconversionschecklastnblocks", DEFAULT_MEMPOOL_EXISTING_CONVERSIONS_CHECK_LAST_N_BLOCKS);
     int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
-    const auto filter_final_valid_and_mature = [this, checkLastNBlocks, buffer](CTxMemPool::txiter it)
-        EXCLUSIVE_LOCKS_REQUIRED(m_mempool->cs, ::cs_main) {
+    const auto conversion_window = GetConversionValidityWindow(checkLastNBlocks, buffer);
+    const auto filter_final_valid_and_mature = [this, &conversion_window](CTxMemPool::txiter it)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mempool->cs, ::cs_main) -> std::optional<MemPoolRemovalReason> {
         AssertLockHeld(m_mempool->cs);
         AssertLockHeld(::cs_main);
         const CTransaction& tx = it->GetTx();
 
         // The transaction must be final.
-        if (!CheckFinalTxAtTip(*Assert(m_chain.Tip()), tx)) return true;
+        if (!CheckFinalTxAtTip(*Assert(m_chain.Tip()), tx)) return MemPoolRemovalReason::REORG;
         if (it->GetConversionInfo()) {
             // The transaction must not be expired
-            if (CheckExpiredConversionAtTip(*Assert(m_chain.Tip()), it->GetConversionInfo().value())) return true;
+            if (CheckExpiredConversionAtTip(*Assert(m_chain.Tip()), *it->GetConversionInfo())) return MemPoolRemovalReason::TXEXPIRED;
             // The conversion must be valid at start of next block
-            if (!CheckValidConversionAtTip(m_chain.Tip(), it->GetConversionInfo().value(), checkLastNBlocks, buffer)) return true;
+            if (!conversion_window->IsValid(*it)) return MemPoolRemovalReason::CONVERSIONINVALID;
         }
         LockPoints lp = it->GetLockPoints();
         const bool validLP{TestLockPointValidity(m_chain, lp)};
@@ -410,7 +471,7 @@ void Chainstate::MaybeUpdateMempoolForReorg(
         // the chain), it will update lp to contain LockPoints relevant to the new chain.
         if (!CheckSequenceLocksAtTip(m_chain.Tip(), view_mempool, tx, &lp, validLP)) {
             // If CheckSequenceLocksAtTip fails, remove the tx and don't depend on the LockPoints.
-            return true;
+            return MemPoolRemovalReason::REORG;
         } else if (!validLP) {
             // If CheckSequenceLocksAtTip succeeded, it also updated the LockPoints.
             // Now update the mempool entry lockpoints as well.
@@ -427,18 +488,18 @@ void Chainstate::MaybeUpdateMempoolForReorg(
                 assert(!coin.IsSpent());
                 const auto mempool_spend_height{m_chain.Tip()->nHeight + 1};
                 if (coin.IsCoinBase() && mempool_spend_height - coin.nHeight < COINBASE_MATURITY) {
-                    return true;
+                    return MemPoolRemovalReason::REORG;
                 }
             }
         }
         // Transaction is still valid and cached LockPoints are updated.
-        return false;
+        return std::nullopt;
     };
 
     // We also need to remove any now-immature transactions
     m_mempool->removeForReorg(m_chain, filter_final_valid_and_mature);
     // Re-limit mempool size, in case we added any transactions
-    LimitMempoolSize(*m_mempool, m_chain, this->CoinsTip());
+    LimitMempoolSize(*m_mempool, *this);
 }
 
 /**
@@ -448,7 +509,8 @@ void Chainstate::MaybeUpdateMempoolForReorg(
 * */
 static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, TxValidationState& state,
                 const CCoinsViewCache& view, const CTxMemPool& pool,
-                unsigned int flags, PrecomputedTransactionData& txdata, CCoinsViewCache& coins_tip)
+                unsigned int flags, PrecomputedTransactionData& txdata, CCoinsViewCache& coins_tip,
+                std::vector<CScriptCheck>* pvChecks = nullptr)
                 EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
 {
     AssertLockHeld(cs_main);
@@ -480,7 +542,13 @@ static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, TxValidationS
     }
 
     // Call CheckInputScripts() to cache signature and script validity against current tip consensus rules.
-    return CheckInputScripts(tx, state, view, flags, /* cacheSigStore= */ true, /* cacheFullScriptStore= */ true, txdata);
+    return CheckInputScripts(tx, state, view, flags, /* cacheSigStore= */ true, /* cacheFullScriptStore= */ true, txdata, pvChecks);
+}
+
+/** Whether the scripts of a transaction are checked on the script check queue when it is accepted to the mempool. */
+static bool UseScriptCheckQueue(const CTransaction& tx)
+{
+    return g_parallel_script_checks && tx.vin.size() >= MEMPOOL_SCRIPT_CHECK_QUEUE_MIN_INPUTS;
 }
 
 namespace {
@@ -523,6 +591,10 @@ public:
          * policies such as mempool min fee and min relay fee.
          */
         const bool m_package_feerates;
+        /** When true, the mempool will not be trimmed when individual transactions of a batch are
+         * submitted in Finalize(). Instead, limits are enforced once the whole batch is submitted.
+         */
+        const bool m_batch_submission;
 
         /** Parameters for single transaction mempool validation. */
         static ATMPArgs SingleAccept(const CChainParams& chainparams, int64_t accept_time,
@@ -536,6 +608,7 @@ public:
                             /* m_allow_replacement */ true,
                             /* m_package_submission */ false,
                             /* m_package_feerates */ false,
+                            /* m_batch_submission */ false,
             };
         }
 
@@ -550,6 +623,7 @@ public:
                             /* m_allow_replacement */ false,
                             /* m_package_submission */ false, // not submitting to mempool
                             /* m_package_feerates */ false,
+                            /* m_batch_submission */ false,
             };
         }
 
@@ -564,6 +638,7 @@ public:
                             /* m_allow_replacement */ false,
                             /* m_package_submission */ true,
                             /* m_package_feerates */ true,
+                            /* m_batch_submission */ false,
             };
         }
 
@@ -577,6 +652,22 @@ public:
                             /* m_allow_replacement */ true,
                             /* m_package_submission */ false,
                             /* m_package_feerates */ false, // only 1 transaction
+                            /* m_batch_submission */ false,
+            };
+        }
+
+        /** Parameters for a transaction accepted as part of a batch of independent transactions. */
+        static ATMPArgs BatchAccept(const CChainParams& chainparams, int64_t accept_time, bool bypass_limits,
+                                    std::vector<COutPoint>& coins_to_uncache) {
+            return ATMPArgs{/* m_chainparams */ chainparams,
+                            /* m_accept_time */ accept_time,
+                            /* m_bypass_limits */ bypass_limits,
+                            /* m_coins_to_uncache */ coins_to_uncache,
+                            /* m_test_accept */ false,
+                            /* m_allow_replacement */ true,
+                            /* m_package_submission */ false,
+                            /* m_package_feerates */ false,
+                            /* m_batch_submission */ true,
             };
         }
 
@@ -590,7 +681,8 @@ public:
                  bool test_accept,
                  bool allow_replacement,
                  bool package_submission,
-                 bool package_feerates)
+                 bool package_feerates,
+                 bool batch_submission)
             : m_chainparams{chainparams},
               m_accept_time{accept_time},
               m_bypass_limits{bypass_limits},
@@ -598,7 +690,8 @@ public:
               m_test_accept{test_accept},
               m_allow_replacement{allow_replacement},
               m_package_submission{package_submission},
-              m_package_feerates{package_feerates}
+              m_package_feerates{package_feerates},
+              m_batch_submission{batch_submission}
         {
         }
     };
@@ -619,6 +712,20 @@ public:
      */
     PackageMempoolAcceptResult AcceptPackage(const Package& package, ATMPArgs& args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Accept a round of a batch of transactions, starting at txns[start]. The round takes the
+     * transactions that neither spend nor conflict with each other, up to the first one that does
+     * or that replaces mempool transactions, runs their script checks together and, unless
+     * bypass_limits is set, trims the mempool once they are all submitted. A replacement starting a round is accepted on its own.
+     * Results are stored in the results of the transactions the round processed.
+     *
+     * @returns the position of the first transaction not processed by this round.
+     */
+    size_t AcceptBatchRound(const std::vector<CTransactionRef>& txns, size_t start,
+                            const std::vector<int64_t>& accept_times, bool bypass_limits,
+                            std::vector<std::vector<COutPoint>>& coins_to_uncache,
+                            std::vector<std::optional<MempoolAcceptResult>>& results) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -668,9 +775,10 @@ private:
         /** Txid. */
         const uint256& m_hash;
         TxValidationState m_state;
-        /** A temporary cache containing serialized transaction data for signature verification.
-         * Reused across PolicyScriptChecks and ConsensusScriptChecks. */
-        PrecomputedTransactionData m_precomputed_txdata;
+        /** A cache containing serialized transaction data for signature verification.
+         * Reused across PolicyScriptChecks and ConsensusScriptChecks, and kept by the
+         * mempool entry for ConnectBlock. */
+        std::shared_ptr<PrecomputedTransactionData> m_precomputed_txdata{std::make_shared<PrecomputedTransactionData>()};
     };
 
     // Run the policy checks on a given transaction, excluding any script checks.
@@ -679,6 +787,15 @@ private:
     // only tests that are fast should be done here (to avoid CPU DoS).
     bool PreChecks(ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // The result for a transaction that failed PreChecks, with what an invalid conversion converts.
+    static MempoolAcceptResult FailedPreChecks(const Workspace& ws)
+    {
+        if (ws.m_state.GetResult() == TxValidationResult::TX_INVALID_CONVERSION) {
+            return MempoolAcceptResult::Failure(ws.m_state, ws.m_conversion_info);
+        }
+        return MempoolAcceptResult::Failure(ws.m_state);
+    }
+
     // Run checks for mempool replace-by-fee.
     bool ReplacementChecks(Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
@@ -697,6 +814,11 @@ private:
     // utxo set or in the mempool.
     bool ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Run the script checks of several transactions together on the script check queue, using our
+    // policy flags. Returns false if any of them fails, without telling which one: the caller
+    // should then call PolicyScriptChecks() on each transaction to fill in its state.
+    bool QueuedPolicyScriptChecks(const std::vector<Workspace*>& workspaces) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Try to add the transaction to the mempool, removing any conflicts first.
     // Returns true if the transaction is in the mempool after any size
     // limiting is performed, false otherwise.
@@ -717,11 +839,11 @@ private:
         AssertLockHeld(m_pool.cs);
         CAmount mempoolRejectFee = m_pool.GetMinFee().GetFee(package_size);
         if (mempoolRejectFee > 0 && package_fee < mempoolRejectFee) {
-            return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool min fee not met", strprintf("%d < %d", package_fee, mempoolRejectFee));
+            return state.Invalid(TxValidationResult::TX_RECONSIDERABLE, "mempool min fee not met", strprintf("%d < %d", package_fee, mempoolRejectFee));
         }
 
         if (package_fee < m_pool.m_min_relay_feerate.GetFee(package_size)) {
-            return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "min relay fee not met",
+            return state.Invalid(TxValidationResult::TX_RECONSIDERABLE, "min relay fee not met",
                                  strprintf("%d < %d", package_fee, m_pool.m_min_relay_feerate.GetFee(package_size)));
         }
         return true;
@@ -782,7 +904,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     // A transaction with 1 segwit input and 1 P2WPHK output has non-witness size of 82 bytes.
     // Transactions smaller than this are not relayed to mitigate CVE-2017-12842 by not relaying
     // 64-byte transactions.
-    if (::GetSerializeSize(tx, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) < MIN_STANDARD_TX_NONWITNESS_SIZE)
+    if (tx.GetStrippedSize() < MIN_STANDARD_TX_NONWITNESS_SIZE)
         return state.Invalid(TxValidationResult::TX_NOT_STANDARD, "tx-size-small");
 
     // Only accept nLockTime-using transactions that can be mined in the next
@@ -883,15 +1005,19 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     }
 
     if (ws.m_conversion_info) {
+        int checkLastNBlocks = gArgs.GetIntArg("-mempoolnewconversionschecklastnblocks", DEFAULT_MEMPOOL_NEW_CONVERSIONS_CHECK_LAST_N_BLOCKS);
+        int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
+
         // Do not accept conversion transactions with a deadline that will have expired by the next block
         if (CheckExpiredConversionAtTip(*Assert(m_active_chainstate.m_chain.Tip()), ws.m_conversion_info.value())) {
+            TRACE5(conversion, mempool_check, ws.m_hash.data(), false, checkLastNBlocks, buffer, "tx-expired");
             return state.Invalid(TxValidationResult::TX_EXPIRED_CONVERSION, "tx-expired");
         }
 
         // Check that conversion is valid at the start of the next block
-        int checkLastNBlocks = gArgs.GetIntArg("-mempoolnewconversionschecklastnblocks", DEFAULT_MEMPOOL_NEW_CONVERSIONS_CHECK_LAST_N_BLOCKS);
-        int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
-        if (!CheckValidConversionAtTip(m_active_chainstate.m_chain.Tip(), ws.m_conversion_info.value(), checkLastNBlocks, buffer)) {
+        const bool valid_in_window{m_active_chainstate.GetConversionValidityWindow(checkLastNBlocks, buffer)->IsValid(ws.m_conversion_info.value())};
+        TRACE5(conversion, mempool_check, ws.m_hash.data(), valid_in_window, checkLastNBlocks, buffer, valid_in_window ? "" : "invalid-conversion");
+        if (!valid_in_window) {
             return state.Invalid(TxValidationResult::TX_INVALID_CONVERSION, "invalid-conversion");
         }
     }
@@ -907,20 +1033,17 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
 
     int64_t nSigOpsCost = GetTransactionSigOpCost(tx, m_view, STANDARD_SCRIPT_VERIFY_FLAGS);
 
-    CAmounts totalSupply = m_active_chainstate.m_chain.Tip()->GetTotalSupply();
-    ws.m_normalized_base_fees = ws.m_base_fees[CASH] + GetConvertedAmount(totalSupply, ws.m_base_fees[BOND], BOND);
+    const int checkLastNBlocks = gArgs.GetIntArg("-mempoolminfeechecklastnblocks", DEFAULT_MEMPOOL_MIN_FEE_CHECK_LAST_N_BLOCKS);
+    const auto fee_window = m_active_chainstate.GetFeeConversionWindow(checkLastNBlocks);
+    ws.m_normalized_base_fees = ws.m_base_fees[CASH] + fee_window->GetTipRate().Convert(ws.m_base_fees[BOND], BOND);
     // ws.m_modified_fees includes any fee deltas from PrioritiseTransaction
     ws.m_modified_fees = ws.m_normalized_base_fees;
     m_pool.ApplyDelta(hash, ws.m_modified_fees);
 
     // Keep track of max m_modified_fees over last N blocks
-    int checkLastNBlocks = gArgs.GetIntArg("-mempoolminfeechecklastnblocks", DEFAULT_MEMPOOL_MIN_FEE_CHECK_LAST_N_BLOCKS);
-    CBlockIndex* pindex = m_active_chainstate.m_chain.Tip();
-    for (int i = 0; i < checkLastNBlocks && pindex; i++) {
-        CAmounts totalSupply = pindex->GetTotalSupply();
-        CAmount normalized_fees = ws.m_base_fees[CASH] + GetConvertedAmount(totalSupply, ws.m_base_fees[BOND], BOND);
+    for (const ConversionRate& conversion_rate : fee_window->GetRates()) {
+        CAmount normalized_fees = ws.m_base_fees[CASH] + conversion_rate.Convert(ws.m_base_fees[BOND], BOND);
         ws.m_max_modified_fees = std::max(ws.m_max_modified_fees, normalized_fees);
-        pindex = pindex->pprev;
     }
     // Include any fee deltas from PrioritiseTransaction
     m_pool.ApplyDelta(hash, ws.m_max_modified_fees);
@@ -1033,14 +1156,12 @@ bool MemPoolAccept::ReplacementChecks(Workspace& ws)
 
     int checkLastNBlocks = gArgs.GetIntArg("-mempoolnewconversionschecklastnblocks", DEFAULT_MEMPOOL_NEW_CONVERSIONS_CHECK_LAST_N_BLOCKS);
     int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
-    std::function<bool(CTxMemPool::txiter)> filter_invalid_conversion = [this, checkLastNBlocks, buffer](CTxMemPool::txiter it)
+    const auto conversion_window = m_active_chainstate.GetConversionValidityWindow(checkLastNBlocks, buffer);
+    std::function<bool(CTxMemPool::txiter)> filter_invalid_conversion = [conversion_window](CTxMemPool::txiter it)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
         // Conversion must be valid according to the same rules used to evaluate a new transaction
-        if (it->GetConversionInfo() && !CheckValidConversionAtTip(m_active_chainstate.m_chain.Tip(), it->GetConversionInfo().value(), checkLastNBlocks, buffer)) {
-            return true;
-        }
-        return false;
+        return !conversion_window->IsValid(*it);
     };
 
     CFeeRate newFeeRate(ws.m_modified_fees, ws.m_vsize);
@@ -1110,15 +1231,19 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws)
 
     constexpr unsigned int scriptVerifyFlags = STANDARD_SCRIPT_VERIFY_FLAGS;
 
+    // Check the scripts of large transactions on the script check queue. If that fails, check them
+    // again below to find out why.
+    if (UseScriptCheckQueue(tx) && QueuedPolicyScriptChecks({&ws})) return true;
+
     // Check input scripts and signatures.
     // This is done last to help prevent CPU exhaustion denial-of-service attacks.
-    if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false, ws.m_precomputed_txdata)) {
+    if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false, *ws.m_precomputed_txdata)) {
         // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
         // need to turn both off, and compare against just turning off CLEANSTACK
         // to see if the failure is specifically due to witness validation.
         TxValidationState state_dummy; // Want reported failures to be from first CheckInputScripts
-        if (!tx.HasWitness() && CheckInputScripts(tx, state_dummy, m_view, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, ws.m_precomputed_txdata) &&
-                !CheckInputScripts(tx, state_dummy, m_view, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, ws.m_precomputed_txdata)) {
+        if (!tx.HasWitness() && CheckInputScripts(tx, state_dummy, m_view, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, *ws.m_precomputed_txdata) &&
+                !CheckInputScripts(tx, state_dummy, m_view, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, *ws.m_precomputed_txdata)) {
             // Only the witness is missing, so the transaction itself may be fine.
             state.Invalid(TxValidationResult::TX_WITNESS_STRIPPED,
                     state.GetRejectReason(), state.GetDebugMessage());
@@ -1153,8 +1278,22 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
     // invalid blocks (using TestBlockValidity), however allowing such
     // transactions into the mempool can be exploited as a DoS attack.
     unsigned int currentBlockScriptVerifyFlags{GetBlockScriptFlags(*m_active_chainstate.m_chain.Tip(), m_active_chainstate.m_chainman)};
+    if (UseScriptCheckQueue(tx)) {
+        std::vector<CScriptCheck> checks;
+        TxValidationState state_dummy;
+        if (CheckInputsFromMempoolAndCache(tx, state_dummy, m_view, m_pool, currentBlockScriptVerifyFlags,
+                                           *ws.m_precomputed_txdata, m_active_chainstate.CoinsTip(), &checks)) {
+            CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+            control.Add(checks);
+            if (control.Wait()) {
+                CacheScriptExecution(tx, currentBlockScriptVerifyFlags);
+                return true;
+            }
+        }
+        // Check the scripts again below to find out why they failed
+    }
     if (!CheckInputsFromMempoolAndCache(tx, state, m_view, m_pool, currentBlockScriptVerifyFlags,
-                                        ws.m_precomputed_txdata, m_active_chainstate.CoinsTip())) {
+                                        *ws.m_precomputed_txdata, m_active_chainstate.CoinsTip())) {
         LogPrintf("BUG! PLEASE REPORT THIS! CheckInputScripts failed against latest-block but not STANDARD flags %s, %s\n", hash.ToString(), state.ToString());
         return Assume(false);
     }
@@ -1162,6 +1301,23 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws)
     return true;
 }
 
+bool MemPoolAccept::QueuedPolicyScriptChecks(const std::vector<Workspace*>& workspaces)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    for (Workspace* ws : workspaces) {
+        std::vector<CScriptCheck> checks;
+        TxValidationState state_dummy;
+        if (!CheckInputScripts(*ws->m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, true, false, *ws->m_precomputed_txdata, &checks)) {
+            return false;
+        }
+        control.Add(checks);
+    }
+    return control.Wait();
+}
+
 bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws)
 {
     AssertLockHeld(cs_main);
@@ -1194,14 +1350,15 @@ bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws)
     bool validForFeeEstimation = !bypass_limits && !args.m_package_submission && IsCurrentForFeeEstimation(m_active_chainstate) && m_pool.HasNoInputsOf(tx);
 
     // Store transaction in memory
+    entry->SetPrecomputedTxData(ws.m_precomputed_txdata);
     m_pool.addUnchecked(*entry, ws.m_ancestors, validForFeeEstimation);
 
     // trim mempool and check if tx was trimmed
     // If we are validating a package, don't trim here because we could evict a previous transaction
     // in the package. LimitMempoolSize() should be called at the very end to make sure the mempool
     // is still within limits and package submission happens atomically.
-    if (!args.m_package_submission && !bypass_limits) {
-        LimitMempoolSize(m_pool, m_active_chainstate.m_chain, m_active_chainstate.CoinsTip());
+    if (!args.m_package_submission && !args.m_batch_submission && !bypass_limits) {
+        LimitMempoolSize(m_pool, m_active_chainstate);
         if (!m_pool.exists(GenTxid::Txid(hash)))
             return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool full");
     }
@@ -1266,7 +1423,7 @@ bool MemPoolAccept::SubmitPackage(const ATMPArgs& args, std::vector<Workspace>&
 
     // It may or may not be the case that all the transactions made it into the mempool. Regardless,
     // make sure we haven't exceeded max mempool size.
-    LimitMempoolSize(m_pool, m_active_chainstate.m_chain, m_active_chainstate.CoinsTip());
+    LimitMempoolSize(m_pool, m_active_chainstate);
 
     // Find the wtxids of the transactions that made it into the mempool. Allow partial submission,
     // but don't report success unless they all made it into the mempool.
@@ -1291,7 +1448,7 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
 
     Workspace ws(ptx);
 
-    if (!PreChecks(args, ws)) return MempoolAcceptResult::Failure(ws.m_state);
+    if (!PreChecks(args, ws)) return FailedPreChecks(ws);
 
     if (m_rbf && !ReplacementChecks(ws)) return MempoolAcceptResult::Failure(ws.m_state);
 
@@ -1313,6 +1470,115 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
     return MempoolAcceptResult::Success(std::move(ws.m_replaced_transactions), ws.m_vsize, ws.m_normalized_base_fees);
 }
 
+size_t MemPoolAccept::AcceptBatchRound(const std::vector<CTransactionRef>& txns, size_t start,
+                                       const std::vector<int64_t>& accept_times, bool bypass_limits,
+                                       std::vector<std::vector<COutPoint>>& coins_to_uncache,
+                                       std::vector<std::optional<MempoolAcceptResult>>& results)
+{
+    AssertLockHeld(cs_main);
+    LOCK(m_pool.cs); // mempool "read lock" (held through GetMainSignals().TransactionAddedToMempool())
+
+    // The workspaces must not move, as the script checks point into them.
+    std::list<std::pair<size_t, Workspace>> pending;
+    std::set<uint256> pending_txids;
+    std::set<COutPoint> pending_spent;
+    const size_t limit_descendants{m_limit_descendants};
+    const size_t limit_descendant_size{m_limit_descendant_size};
+
+    size_t next{start};
+    for (; next < txns.size(); ++next) {
+        const CTransactionRef& ptx{txns[next]};
+        // A transaction depending on or conflicting with a pending one is left to the next round,
+        // which sees the pending ones in the mempool.
+        if (std::any_of(ptx->vin.cbegin(), ptx->vin.cend(), [&](const CTxIn& txin) {
+                return pending_txids.count(txin.prevout.hash) || pending_spent.count(txin.prevout);
+            })) {
+            break;
+        }
+
+        auto args = ATMPArgs::BatchAccept(m_active_chainstate.m_params, accept_times[next], bypass_limits, coins_to_uncache[next]);
+        Workspace& ws{pending.emplace_back(std::piecewise_construct, std::forward_as_tuple(next), std::forward_as_tuple(ptx)).second};
+        if (!PreChecks(args, ws)) {
+            results[next].emplace(FailedPreChecks(ws));
+            pending.pop_back();
+            continue;
+        }
+        if (m_rbf) {
+            // Replacements remove mempool transactions, so they are accepted on their own
+            pending.pop_back();
+            m_rbf = false;
+            m_limit_descendants = limit_descendants;
+            m_limit_descendant_size = limit_descendant_size;
+            if (pending.empty()) {
+                auto single_args = ATMPArgs::SingleAccept(m_active_chainstate.m_params, accept_times[next],
+                                                          bypass_limits, coins_to_uncache[next],
+                                                          /*test_accept=*/false);
+                results[next].emplace(MemPoolAccept(m_pool, m_active_chainstate).AcceptSingleTransaction(ptx, single_args));
+                ++next;
+            }
+            break;
+        }
+        pending_txids.insert(ws.m_hash);
+        for (const CTxIn& txin : ptx->vin) pending_spent.insert(txin.prevout);
+    }
+    if (pending.empty()) return next;
+
+    // Verify the scripts of the whole round on the script check queue. If any of them fails, the
+    // transactions are checked one by one, to find which ones are invalid and why.
+    bool scripts_checked{false};
+    if (g_parallel_script_checks && pending.size() > 1) {
+        std::vector<Workspace*> round;
+        for (auto& [i, ws] : pending) round.push_back(&ws);
+        scripts_checked = QueuedPolicyScriptChecks(round);
+    }
+
+    std::vector<std::pair<size_t, Workspace*>> submitted;
+    for (auto& [i, ws] : pending) {
+        auto args = ATMPArgs::BatchAccept(m_active_chainstate.m_params, accept_times[i], bypass_limits, coins_to_uncache[i]);
+        if ((!scripts_checked && !PolicyScriptChecks(args, ws)) || !ConsensusScriptChecks(args, ws)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            continue;
+        }
+
+        // Re-calculate mempool ancestors to call addUnchecked(). Transactions of this round may
+        // share ancestors, whose descendants have grown since PreChecks.
+        std::string err_string, dummy_err_string;
+        if (!m_pool.CalculateMemPoolAncestors(*ws.m_entry, ws.m_ancestors, m_limit_ancestors, m_limit_ancestor_size,
+                                              m_limit_descendants, m_limit_descendant_size, err_string)) {
+            ws.m_ancestors.clear();
+            // Contracting/payment channels CPFP carve-out, as in PreChecks
+            if (ws.m_vsize > EXTRA_DESCENDANT_TX_SIZE_LIMIT ||
+                    !m_pool.CalculateMemPoolAncestors(*ws.m_entry, ws.m_ancestors, 2, m_limit_ancestor_size, m_limit_descendants + 1,
+                                                      m_limit_descendant_size + EXTRA_DESCENDANT_TX_SIZE_LIMIT, dummy_err_string)) {
+                ws.m_state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "too-long-mempool-chain", err_string);
+                results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+                continue;
+            }
+        }
+        if (!Finalize(args, ws)) {
+            results[i].emplace(MempoolAcceptResult::Failure(ws.m_state));
+            // Since LimitMempoolSize() won't be called, this should never fail.
+            Assume(false);
+            continue;
+        }
+        submitted.emplace_back(i, &ws);
+    }
+    if (submitted.empty()) return next;
+
+    if (!bypass_limits) LimitMempoolSize(m_pool, m_active_chainstate);
+
+    for (auto& [i, ws] : submitted) {
+        if (m_pool.exists(GenTxid::Wtxid(ws->m_ptx->GetWitnessHash()))) {
+            results[i].emplace(MempoolAcceptResult::Success(std::move(ws->m_replaced_transactions), ws->m_vsize, ws->m_normalized_base_fees));
+            GetMainSignals().TransactionAddedToMempool(ws->m_ptx, m_pool.GetAndIncrementSequence());
+        } else {
+            ws->m_state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool full");
+            results[i].emplace(MempoolAcceptResult::Failure(ws->m_state));
+        }
+    }
+    return next;
+}
+
 PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::vector<CTransactionRef>& txns, ATMPArgs& args)
 {
     AssertLockHeld(cs_main);
@@ -1334,7 +1600,7 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         if (!PreChecks(args, ws)) {
             package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
             // Exit early to avoid doing pointless work. Update the failed tx result; the rest are unfinished.
-            results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
+            results.emplace(ws.m_ptx->GetWitnessHash(), FailedPreChecks(ws));
             return PackageMempoolAcceptResult(package_state, std::move(results));
         }
         // Make the coins created by this transaction available for subsequent transactions in the
@@ -1372,8 +1638,17 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         return PackageMempoolAcceptResult(package_state, package_feerate, std::move(results));
     }
 
+    // Check the scripts of all the package transactions together on the script check queue. If that
+    // fails, check them one by one to find which transaction is invalid and why.
+    bool scripts_checked{false};
+    if (g_parallel_script_checks && txns.size() > 1) {
+        std::vector<Workspace*> package;
+        for (Workspace& ws : workspaces) package.push_back(&ws);
+        scripts_checked = QueuedPolicyScriptChecks(package);
+    }
+
     for (Workspace& ws : workspaces) {
-        if (!PolicyScriptChecks(args, ws)) {
+        if (!scripts_checked && !PolicyScriptChecks(args, ws)) {
             // Exit early to avoid doing pointless work. Update the failed tx result; the rest are unfinished.
             package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
             results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
@@ -1497,7 +1772,7 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package& package,
                 // in package validation, because its fees should only be "used" once.
                 assert(m_pool.exists(GenTxid::Wtxid(wtxid)));
                 results.emplace(wtxid, single_res);
-            } else if (single_res.m_state.GetResult() != TxValidationResult::TX_MEMPOOL_POLICY &&
+            } else if (single_res.m_state.GetResult() != TxValidationResult::TX_RECONSIDERABLE &&
                        single_res.m_state.GetResult() != TxValidationResult::TX_MISSING_INPUTS) {
                 // Package validation policy only differs from individual policy in its evaluation
                 // of feerate. For example, if a transaction fails here due to violation of a
@@ -1559,6 +1834,38 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
     return result;
 }
 
+std::vector<MempoolAcceptResult> AcceptToMemoryPoolBatch(Chainstate& active_chainstate, const std::vector<CTransactionRef>& txns,
+                                                         const std::vector<int64_t>& accept_times, bool bypass_limits)
+{
+    AssertLockHeld(::cs_main);
+    assert(txns.size() == accept_times.size());
+    assert(active_chainstate.GetMempool() != nullptr);
+    CTxMemPool& pool{*active_chainstate.GetMempool()};
+
+    std::vector<std::vector<COutPoint>> coins_to_uncache(txns.size());
+    std::vector<std::optional<MempoolAcceptResult>> results(txns.size());
+    // Each round sees the transactions of the previous ones in the mempool
+    for (size_t next = 0; next < txns.size();) {
+        next = MemPoolAccept(pool, active_chainstate).AcceptBatchRound(txns, next, accept_times, bypass_limits, coins_to_uncache, results);
+    }
+
+    std::vector<MempoolAcceptResult> batch_results;
+    batch_results.reserve(txns.size());
+    for (size_t i = 0; i < txns.size(); ++i) {
+        if (results[i]->m_result_type != MempoolAcceptResult::ResultType::VALID) {
+            // Remove coins that were not present in the coins cache before, as in AcceptToMemoryPool()
+            for (const COutPoint& outpoint : coins_to_uncache[i]) {
+                active_chainstate.CoinsTip().Uncache(outpoint);
+            }
+        }
+        batch_results.push_back(std::move(*results[i]));
+    }
+    // After we've (potentially) uncached entries, ensure our coins cache is still within its size limits
+    BlockValidationState state_dummy;
+    active_chainstate.FlushStateToDisk(state_dummy, FlushStateMode::PERIODIC);
+    return batch_results;
+}
+
 PackageMempoolAcceptResult ProcessNewPackage(Chainstate& active_chainstate, CTxMemPool& pool,
                                                    const Package& package, bool test_accept)
 {
@@ -1620,12 +1927,13 @@ CoinsViews::CoinsViews(
     bool in_memory,
     bool should_wipe) : m_dbview(
                             gArgs.GetDataDirNet() / ldb_name, cache_size_bytes, in_memory, should_wipe),
-                        m_catcherview(&m_dbview) {}
+                        m_flushview(&m_dbview),
+                        m_catcherview(&m_flushview) {}
 
 void CoinsViews::InitCache()
 {
     AssertLockHeld(::cs_main);
-    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview, g_coins_cache_huge_pages);
 }
 
 Chainstate::Chainstate(
@@ -1783,7 +2091,7 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.amountType, m_tx_out.nValue, cacheStore, *txdata), &error);
 }
 
-static CuckooCache::cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
+static CuckooCache::sharded_cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
 
 bool InitScriptExecutionCache(size_t max_size_bytes)
@@ -1805,6 +2113,25 @@ bool InitScriptExecutionCache(size_t max_size_bytes)
     return true;
 }
 
+CuckooCache::stats GetScriptExecutionCacheStats()
+{
+    return g_scriptExecutionCache.get_stats();
+}
+
+size_t GetScriptExecutionCacheMemoryUsage()
+{
+    return g_scriptExecutionCache.DynamicMemoryUsage();
+}
+
+/** Key of the execution of the scripts of a transaction with the given flags in the script execution cache. */
+static uint256 GetScriptExecutionCacheEntry(const CTransaction& tx, unsigned int flags)
+{
+    uint256 hashCacheEntry;
+    CSHA256 hasher = g_scriptExecutionCacheHasher;
+    hasher.Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+    return hashCacheEntry;
+}
+
 /**
  * Check whether all of this transaction's input scripts succeed.
  *
@@ -1840,10 +2167,7 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     // correct (ie that the transaction hash which is in tx's prevouts
     // properly commits to the scriptPubKey in the inputs view of that
     // transaction).
-    uint256 hashCacheEntry;
-    CSHA256 hasher = g_scriptExecutionCacheHasher;
-    hasher.Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
-    AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
+    const uint256 hashCacheEntry{GetScriptExecutionCacheEntry(tx, flags)};
     if (g_scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
         return true;
     }
@@ -1912,6 +2236,15 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     return true;
 }
 
+/**
+ * Cache the execution of the scripts of a transaction with the given flags, after the checks that
+ * CheckInputScripts() pushed onto pvChecks have all succeeded.
+ */
+static void CacheScriptExecution(const CTransaction& tx, unsigned int flags)
+{
+    g_scriptExecutionCache.insert(GetScriptExecutionCacheEntry(tx, flags));
+}
+
 bool AbortNode(BlockValidationState& state, const std::string& strMessage, const bilingual_str& userMessage)
 {
     AbortNode(strMessage, userMessage);
@@ -1955,16 +2288,20 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When FAILED is returned, view is left in an indeterminate state. */
-DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CBlockUndo* block_undo)
 {
     AssertLockHeld(::cs_main);
     bool fClean = true;
 
-    CBlockUndo blockUndo;
-    if (!UndoReadFromDisk(blockUndo, pindex)) {
-        error("DisconnectBlock(): failure reading undo data");
-        return DISCONNECT_FAILED;
+    CBlockUndo read_undo;
+    if (!block_undo) {
+        if (!UndoReadFromDisk(read_undo, pindex)) {
+            error("DisconnectBlock(): failure reading undo data");
+            return DISCONNECT_FAILED;
+        }
+        block_undo = &read_undo;
     }
+    CBlockUndo& blockUndo{*block_undo};
 
     if (blockUndo.vtxundo.size() + 1 != block.vtx.size()) {
         error("DisconnectBlock(): block and undo data inconsistent");
@@ -2017,16 +2354,158 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
-
 void StartScriptCheckWorkerThreads(int threads_num)
 {
     scriptcheckqueue.StartWorkerThreads(threads_num);
 }
 
+void StartScriptCheckWorkers(util::ThreadPool& thread_pool, int workers_num)
+{
+    scriptcheckqueue.StartWorkers(util::TaskPool{thread_pool, "scriptcheck", util::TaskPriority::HIGH}, workers_num);
+}
+
+void StartBackgroundScriptCheckWorkers(util::ThreadPool& thread_pool, int workers_num)
+{
+    if (workers_num <= 0) return;
+    background_scriptcheckqueue.StartWorkers(util::TaskPool{thread_pool, "scriptcheck.background", util::TaskPriority::LOW}, workers_num);
+    g_parallel_background_script_checks = true;
+}
+
 void StopScriptCheckWorkerThreads()
 {
     scriptcheckqueue.StopWorkerThreads();
+    background_scriptcheckqueue.StopWorkerThreads();
+    g_parallel_background_script_checks = false;
+}
+
+namespace {
+/** How many received blocks may wait for a block check worker, per worker. */
+static constexpr size_t BLOCK_CHECK_QUEUE_PER_THREAD{8};
+
+/**
+ * Runs the context-free checks of received blocks on the workers of a thread
+ * pool. The results are cached in the block (CBlock::fChecked and the witness
+ * merkle root), so ProcessNewBlock() skips that work on the thread that
+ * accepts it.
+ */
+class BlockCheckQueue
+{
+public:
+    ~BlockCheckQueue() { StopWorkers(); }
+
+    //! Run up to workers_num workers as tasks of pool.
+    void StartWorkers(util::TaskPool pool, int workers_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        assert(!m_pool);
+        m_pool.emplace(std::move(pool));
+        m_stop = false;
+        m_max_workers = workers_num;
+        m_max_queued = workers_num * BLOCK_CHECK_QUEUE_PER_THREAD;
+    }
+
+    //! Run the workers on a pool of new threads, one for each.
+    void StartWorkerThreads(int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        assert(!m_own_thread_pool);
+        util::ThreadPool::Options options;
+        options.name = "blkcheck";
+        options.threads = threads_num;
+        m_own_thread_pool = std::make_unique<util::ThreadPool>(std::move(options));
+        StartWorkers(util::TaskPool{*m_own_thread_pool, "blockcheck", util::TaskPriority::HIGH}, threads_num);
+    }
+
+    //! Drop the queued blocks, and wait for the workers to end.
+    void StopWorkers() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_stop = true;
+            m_queue.clear();
+            m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_running_workers == 0; });
+            m_pool.reset();
+        }
+        m_own_thread_pool.reset();
+    }
+
+    bool Add(std::shared_ptr<const CBlock> block, const Consensus::Params& params, std::function<void()> on_checked) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            if (!m_pool || m_stop || m_queue.size() >= m_max_queued) return false;
+            m_queue.push_back({std::move(block), &params, std::move(on_checked)});
+            if (m_running_workers >= m_max_workers) return true;
+            ++m_running_workers;
+        }
+        m_pool->Post([this] { Loop(); });
+        return true;
+    }
+
+private:
+    struct Job {
+        std::shared_ptr<const CBlock> block;
+        const Consensus::Params* params;
+        std::function<void()> on_checked;
+    };
+
+    //! Check the queued blocks, ending once there are none left
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            Job job;
+            {
+                LOCK(m_mutex);
+                if (m_queue.empty()) {
+                    --m_running_workers;
+                    m_cond.notify_all();
+                    return;
+                }
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            // A block that fails is checked again, and reported, by ProcessNewBlock().
+            BlockValidationState state;
+            if (CheckBlock(*job.block, state, *job.params)) {
+                job.block->m_witness_merkle_root = BlockWitnessMerkleRoot(*job.block);
+            }
+            job.on_checked();
+        }
+    }
+
+    Mutex m_mutex;
+    //! Signalled when a worker ends
+    std::condition_variable m_cond;
+    std::deque<Job> m_queue GUARDED_BY(m_mutex);
+    size_t m_max_queued GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    //! Pool the workers run on, and the thread pool created for them by StartWorkerThreads().
+    std::optional<util::TaskPool> m_pool GUARDED_BY(m_mutex);
+    std::unique_ptr<util::ThreadPool> m_own_thread_pool;
+    int m_max_workers GUARDED_BY(m_mutex){0};
+    int m_running_workers GUARDED_BY(m_mutex){0};
+};
+} // namespace
+
+static BlockCheckQueue blockcheckqueue;
+
+void StartBlockCheckWorkerThreads(int threads_num)
+{
+    blockcheckqueue.StartWorkerThreads(threads_num);
+}
+
+void StartBlockCheckWorkers(util::ThreadPool& thread_pool, int workers_num)
+{
+    blockcheckqueue.StartWorkers(util::TaskPool{thread_pool, "blockcheck", util::TaskPriority::HIGH}, workers_num);
+}
+
+void StopBlockCheckWorkerThreads()
+{
+    blockcheckqueue.StopWorkers();
+}
+
+bool QueueBlockCheck(std::shared_ptr<const CBlock> block, const Consensus::Params& params, std::function<void()> on_checked)
+{
+    return blockcheckqueue.Add(std::move(block), params, std::move(on_checked));
 }
 
 /**
@@ -2059,8 +2538,11 @@ static std::array<ThresholdConditionCache, VERSIONBITS_NUM_BITS> warningcache GU
 
 static unsigned int GetBlockScriptFlags(const CBlockIndex& block_index, const ChainstateManager& chainman)
 {
-    const Consensus::Params& consensusparams = chainman.GetConsensus();
+    return GetBlockScriptFlags(block_index, chainman.GetConsensus(), chainman.m_versionbitscache);
+}
 
+unsigned int GetBlockScriptFlags(const CBlockIndex& block_index, const Consensus::Params& consensusparams, VersionBitsCache& versionbitscache)
+{
     // BIP16 didn't become active until Apr 1 2012 (on mainnet, and
     // retroactively applied to testnet)
     // However, only one historical block violated the P2SH rules (on both
@@ -2076,28 +2558,90 @@ static unsigned int GetBlockScriptFlags(const CBlockIndex& block_index, const Ch
     }
 
     // Enforce the DERSIG (BIP66) rule
-    if (DeploymentActiveAt(block_index, chainman, Consensus::DEPLOYMENT_DERSIG)) {
+    if (DeploymentActiveAt(block_index, consensusparams, Consensus::DEPLOYMENT_DERSIG, versionbitscache)) {
         flags |= SCRIPT_VERIFY_DERSIG;
     }
 
     // Enforce CHECKLOCKTIMEVERIFY (BIP65)
-    if (DeploymentActiveAt(block_index, chainman, Consensus::DEPLOYMENT_CLTV)) {
+    if (DeploymentActiveAt(block_index, consensusparams, Consensus::DEPLOYMENT_CLTV, versionbitscache)) {
         flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
     }
 
     // Enforce CHECKSEQUENCEVERIFY (BIP112)
-    if (DeploymentActiveAt(block_index, chainman, Consensus::DEPLOYMENT_CSV)) {
+    if (DeploymentActiveAt(block_index, consensusparams, Consensus::DEPLOYMENT_CSV, versionbitscache)) {
         flags |= SCRIPT_VERIFY_CHECKSEQUENCEVERIFY;
     }
 
     // Enforce BIP147 NULLDUMMY (activated simultaneously with segwit)
-    if (DeploymentActiveAt(block_index, chainman, Consensus::DEPLOYMENT_SEGWIT)) {
+    if (DeploymentActiveAt(block_index, consensusparams, Consensus::DEPLOYMENT_SEGWIT, versionbitscache)) {
         flags |= SCRIPT_VERIFY_NULLDUMMY;
     }
 
     return flags;
 }
 
+/** Minimum number of uncached prevouts per thread when prefetching a block's inputs */
+static constexpr size_t MIN_PREFETCH_PREVOUTS_PER_THREAD{256};
+
+/**
+ * Read coins missing from the cache from the coins database on tasks of the
+ * shared thread pool, each taking a contiguous range, then add them to the
+ * cache serially. Read errors are left for the serial lookups that follow to
+ * report.
+ */
+static void PrefetchCoins(const std::vector<COutPoint>& prevouts, CCoinsViewCache& cache, const CCoinsView& db)
+{
+    // A single thread would do the same reads as the serial lookups
+    const size_t num_chunks{std::min<size_t>(prevouts.size() / MIN_PREFETCH_PREVOUTS_PER_THREAD, std::max(GetNumCores(), 1))};
+    if (num_chunks < 2) return;
+
+    std::vector<Coin> coins(prevouts.size());
+    const size_t chunk_size{(prevouts.size() + num_chunks - 1) / num_chunks};
+    util::ParallelFor("prefetch", util::TaskPriority::HIGH, num_chunks, num_chunks, [&](size_t chunk) {
+        for (size_t i = chunk * chunk_size; i < std::min(prevouts.size(), (chunk + 1) * chunk_size); ++i) {
+            try {
+                if (!db.GetCoin(prevouts[i], coins[i])) coins[i].Clear();
+            } catch (const std::runtime_error&) {
+                coins[i].Clear();
+            }
+        }
+    });
+
+    for (size_t i = 0; i < prevouts.size(); ++i) {
+        cache.AddPrefetchedCoin(prevouts[i], std::move(coins[i]));
+    }
+}
+
+/**
+ * Load the coins spent by a block into the coins cache before connecting it.
+ * Prevouts missing from the cache and not created within the block are
+ * prefetched.
+ */
+static void PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, const CCoinsView& db)
+{
+    std::unordered_set<uint256, SaltedTxidHasher> block_txids;
+    for (const CTransactionRef& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+    }
+    std::vector<COutPoint> prevouts;
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        for (const CTxIn& txin : block.vtx[i]->vin) {
+            if (block_txids.count(txin.prevout.hash) || cache.HaveCoinInCache(txin.prevout)) continue;
+            prevouts.push_back(txin.prevout);
+        }
+    }
+    PrefetchCoins(prevouts, cache, db);
+}
+
+void Chainstate::PrefetchCoins(const std::vector<COutPoint>& outpoints)
+{
+    AssertLockHeld(::cs_main);
+    std::vector<COutPoint> uncached;
+    for (const COutPoint& outpoint : outpoints) {
+        if (!CoinsTip().HaveCoinInCache(outpoint)) uncached.push_back(outpoint);
+    }
+    ::PrefetchCoins(uncached, CoinsTip(), m_coins_views->m_flushview);
+}
 
 static int64_t nTimeCheck = 0;
 static int64_t nTimeForks = 0;
@@ -2291,6 +2835,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
 
+    // Warm the coins cache so the serial input and conversion checks below
+    // don't each wait on a database read
+    PrefetchBlockInputs(block, CoinsTip(), m_coins_views->m_flushview);
+    const int64_t nTimeInputs = GetTimeMicros();
+
     CBlockUndo blockundo;
 
     // Precomputed transaction data pointers must not be invalidated
@@ -2298,15 +2847,35 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
     // for as long as `control`.
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && g_parallel_script_checks ? &scriptcheckqueue : nullptr);
+    CCheckQueue<CScriptCheck>* check_queue{nullptr};
+    if (fScriptChecks && g_parallel_script_checks) {
+        // Background validation keeps off the workers checking the active chainstate
+        const bool background{g_parallel_background_script_checks && m_chainman.IsBackgroundChainstate(this)};
+        check_queue = background ? &background_scriptcheckqueue : &scriptcheckqueue;
+    }
+    CCheckQueueControl<CScriptCheck> control(check_queue);
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
 
+    // Transactions validated into the mempool already computed their data
+    // from the same spent outputs, so reuse it. These references keep it
+    // alive for as long as `control` too.
+    std::vector<std::shared_ptr<PrecomputedTransactionData>> mempool_txsdata(block.vtx.size());
+    if (fScriptChecks && m_mempool) {
+        LOCK(m_mempool->cs);
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            auto txdata{m_mempool->GetPrecomputedTxData(block.vtx[i]->GetWitnessHash())};
+            if (txdata && txdata->m_spent_outputs_ready) mempool_txsdata[i] = std::move(txdata);
+        }
+    }
+
     // Get the total supply at the end of the previous block
     CAmounts totalSupply = pindex->pprev->GetTotalSupply();
 
     std::vector<int> prevheights;
     std::vector<CTxOut> conversionOutputs;
     CAmounts conversionRemainderSum = {0};
+    CAmounts conversionRemainderFees = {0};
+    std::optional<std::chrono::nanoseconds> conversion_time;
     CAmounts nFees = {0};
     int nInputs = 0;
     int64_t nSigOpsCost = 0;
@@ -2339,8 +2908,19 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 CAmounts inputs = conversion_info.value().inputs;
                 CAmounts minOutputs = conversion_info.value().minOutputs;
                 CAmountType remainderType = conversion_info.value().remainderType;
-                CAmount remainder;
-                if (Consensus::IsValidConversion(totalSupply, inputs, minOutputs, remainderType, remainder)) {
+                CAmount remainder{0};
+                const auto conversion_start{SteadyClock::now()};
+                const bool valid_conversion{Consensus::IsValidConversion(totalSupply, inputs, minOutputs, remainderType, remainder)};
+                const auto conversion_duration{SteadyClock::now() - conversion_start};
+                conversion_time = conversion_time.value_or(0ns) + conversion_duration;
+                TRACE5(conversion, connect_block_check,
+                    tx.GetHash().data(),
+                    pindex->nHeight,
+                    valid_conversion,
+                    remainder,
+                    Ticks<std::chrono::nanoseconds>(conversion_duration)
+                );
+                if (valid_conversion) {
                     if (remainder > 0) {
                         // Include remainder output amount if non-zero
                         if (IsValidDestination(conversion_info.value().destination)) {
@@ -2351,6 +2931,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
                         } else {
                             // No destination provided. Add remainder to miner fees.
                             nFees[remainderType] += remainder;
+                            conversionRemainderFees[remainderType] += remainder;
                         }
                     }
                 } else {
@@ -2391,7 +2972,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             TxValidationState tx_state;
-            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], g_parallel_script_checks ? &vChecks : nullptr)) {
+            if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, mempool_txsdata[i] ? *mempool_txsdata[i] : txsdata[i], g_parallel_script_checks ? &vChecks : nullptr)) {
                 // Any transaction validation failure in ConnectBlock is a block consensus failure
                 state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
                               tx_state.GetRejectReason(), tx_state.GetDebugMessage());
@@ -2409,6 +2990,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
     LogPrint(BCLog::BENCH, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(), MILLI * (nTime3 - nTime2), MILLI * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
+    LogPrint(BCLog::BENCH, "        - Coins cache: %.2fMiB%s\n", CoinsTip().DynamicMemoryUsage() * (1.0 / (1 << 20)), CoinsTip().UsesHugePages() ? " on huge pages" : "");
 
     // Verify that the coinbase transaction contains all prescribed conversion outputs
     const CTransaction &coinbaseTx = *(block.vtx[0]);
@@ -2418,6 +3000,15 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cb-missing-conversion-output");
     }
 
+    TRACE6(conversion, block_remainders,
+        pindex->nHeight,
+        conversionOutputs.size(),
+        conversionRemainderSum[CASH],
+        conversionRemainderSum[BOND],
+        conversionRemainderFees[CASH],
+        conversionRemainderFees[BOND]
+    );
+
     // Calculate allowable block reward
     CAmounts reward = GetBlockSubsidy(pindex->nHeight, totalSupply, m_params.GetConsensus());
     // Check that coinbase amount does not exceed block reward plus fees plus conversion remainder sum
@@ -2448,15 +3039,27 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
+    if (check_queue) {
+        const auto check_stats{check_queue->GetLastStats()};
+        LogPrint(BCLog::BENCH, "      - Script checks: %u queued, %u stolen by idle workers\n", check_stats.checks, check_stats.stolen);
+    }
 
     if (fJustCheck)
         return true;
 
+    // Block template checks are left out of the stage histograms
+    kernel::RecordValidationStage(kernel::ValidationStage::INPUTS_FETCH, std::chrono::microseconds{nTimeInputs - nTime2});
+    if (conversion_time) {
+        kernel::RecordValidationStage(kernel::ValidationStage::CONVERSION_EVAL, std::chrono::duration_cast<std::chrono::microseconds>(*conversion_time));
+    }
+    kernel::RecordValidationStage(kernel::ValidationStage::SCRIPT_CHECKS, std::chrono::microseconds{nTime4 - nTimeInputs});
+
     if (!m_blockman.WriteUndoDataForBlock(blockundo, state, pindex, m_params)) {
         return false;
     }
 
     int64_t nTime5 = GetTimeMicros(); nTimeUndo += nTime5 - nTime4;
+    kernel::RecordValidationStage(kernel::ValidationStage::UNDO_WRITE, std::chrono::microseconds{nTime5 - nTime4});
     LogPrint(BCLog::BENCH, "    - Write undo data: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime5 - nTime4), nTimeUndo * MICRO, nTimeUndo * MILLI / nBlocksTotal);
 
     if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
@@ -2534,6 +3137,10 @@ bool Chainstate::FlushStateToDisk(
         bool fFlushForPrune = false;
         bool fDoFullFlush = false;
 
+        if (m_coins_views->m_flushview.WriteFailed()) {
+            return AbortNode(state, "Failed to write to coin database");
+        }
+
         CoinsCacheSizeState cache_state = GetCoinsCacheSizeState();
         LOCK(m_blockman.cs_LastBlockFile);
         if (fPruneMode && (m_blockman.m_check_for_pruning || nManualPruneHeight > 0) && !fReindex) {
@@ -2582,14 +3189,17 @@ bool Chainstate::FlushStateToDisk(
         if (nLastFlush.count() == 0) {
             nLastFlush = nNow;
         }
+        // The background chainstate of a snapshot only writes its coins when it has to, so that
+        // its flushes don't compete for the disk with those of the active chainstate.
+        const bool is_background_chainstate{m_chainman.IsBackgroundChainstate(this)};
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
-        bool fCacheLarge = mode == FlushStateMode::PERIODIC && cache_state >= CoinsCacheSizeState::LARGE;
+        bool fCacheLarge = mode == FlushStateMode::PERIODIC && cache_state >= CoinsCacheSizeState::LARGE && !is_background_chainstate;
         // The cache is over the limit, we have to write now.
         bool fCacheCritical = mode == FlushStateMode::IF_NEEDED && cache_state >= CoinsCacheSizeState::CRITICAL;
         // It's been a while since we wrote the block index to disk. Do this frequently, so we don't need to redownload after a crash.
         bool fPeriodicWrite = mode == FlushStateMode::PERIODIC && nNow > nLastWrite + DATABASE_WRITE_INTERVAL;
         // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
-        bool fPeriodicFlush = mode == FlushStateMode::PERIODIC && nNow > nLastFlush + DATABASE_FLUSH_INTERVAL;
+        bool fPeriodicFlush = mode == FlushStateMode::PERIODIC && nNow > nLastFlush + DATABASE_FLUSH_INTERVAL && !is_background_chainstate;
         // Combine all conditions that result in a full cache flush.
         fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
         // Write blocks and block index to disk.
@@ -2613,11 +3223,10 @@ bool Chainstate::FlushStateToDisk(
                     return AbortNode(state, "Failed to write to block index database");
                 }
             }
-            // Finally remove any pruned files
+            // Finally remove any pruned files. The block index written above no
+            // longer refers to them, so they are unlinked in the background.
             if (fFlushForPrune) {
-                LOG_TIME_MILLIS_WITH_CATEGORY("unlink pruned files", BCLog::BENCH);
-
-                UnlinkPrunedFiles(setFilesToPrune);
+                m_blockman.UnlinkPrunedFilesInBackground(setFilesToPrune);
             }
             nLastWrite = nNow;
         }
@@ -2634,10 +3243,17 @@ bool Chainstate::FlushStateToDisk(
             if (!CheckDiskSpace(gArgs.GetDataDirNet(), 48 * 2 * 2 * CoinsTip().GetCacheSize())) {
                 return AbortNode(state, "Disk space is too low!", _("Disk space is too low!"));
             }
-            // Flush the chainstate (which may refer to block index entries).
+            // Flush the chainstate (which may refer to block index entries). Flushes that
+            // callers rely on being on disk, or that precede pruning, are written before
+            // returning; others may be written on a background thread.
+            const bool background{g_coins_flush_background && mode != FlushStateMode::ALWAYS && !fFlushForPrune};
+            m_coins_views->m_flushview.SetBackground(background);
+            const auto write_start{SteadyClock::now()};
             if (!CoinsTip().Flush())
                 return AbortNode(state, "Failed to write to coin database");
-            nLastFlush = nNow;
+            kernel::RecordValidationStage(kernel::ValidationStage::COINS_WRITE, std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - write_start));
+            // Only the flushes of the active chainstate postpone its next periodic flush
+            if (!is_background_chainstate) nLastFlush = nNow;
             full_flush_completed = true;
             TRACE5(utxocache, flush,
                    (int64_t)(GetTimeMicros() - nNow.count()), // in microseconds (µs)
@@ -2924,6 +3540,7 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
         assert(flushed);
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
+    kernel::RecordValidationStage(kernel::ValidationStage::FLUSH, std::chrono::microseconds{nTime4 - nTime3});
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FlushStateMode::IF_NEEDED)) {
@@ -2933,35 +3550,27 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     LogPrint(BCLog::BENCH, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO, nTimeChainState * MILLI / nBlocksTotal);
     // Remove conflicting transactions from the mempool and remove expired conversion transactions and all descendants
     if (m_mempool) {
-        // Predicates to use for filtering transactions in removeForBlock.
-        // Checks whether the conversion transaction deadline has expired.
-        // If false, the tx is still valid.
-        // If true, the tx would be invalid in the next block; remove this entry and all of its descendants.
-        const auto filter_expired = [this](CTxMemPool::txiter it)
-            EXCLUSIVE_LOCKS_REQUIRED(m_mempool->cs, ::cs_main) {
-            AssertLockHeld(m_mempool->cs);
-            AssertLockHeld(::cs_main);
-            // The transaction must not have expired
-            if (it->GetConversionInfo() && CheckExpiredConversionAtTip(*Assert(m_chain.Tip()), it->GetConversionInfo().value())) return true;
-            // Transaction is not a conversion or conversion has not expired
-            return false;
-        };
+        // Predicate to use for filtering conversions in removeForBlock, which
+        // removes expired conversions itself.
         // Checks whether the conversion transaction is valid at start of next block
         // If false, the tx is still valid.
         // If true, the tx would be invalid in the next block; remove this entry and all of its descendants.
 
         int checkLastNBlocks = gArgs.GetIntArg("-mempoolexistingconversionschecklastnblocks", DEFAULT_MEMPOOL_EXISTING_CONVERSIONS_CHECK_LAST_N_BLOCKS);
         int buffer = gArgs.GetIntArg("-mempoolconversionbuffer", DEFAULT_MEMPOOL_CONVERSION_BUFFER);
-        const auto filter_invalid_conversion = [this, checkLastNBlocks, buffer](CTxMemPool::txiter it)
+        const auto conversion_window = GetConversionValidityWindow(checkLastNBlocks, buffer);
+        const auto filter_invalid_conversion = [this, &conversion_window](CTxMemPool::txiter it)
             EXCLUSIVE_LOCKS_REQUIRED(m_mempool->cs, ::cs_main) {
             AssertLockHeld(m_mempool->cs);
             AssertLockHeld(::cs_main);
             // The conversion must be valid at start of next block
-            if (it->GetConversionInfo() && !CheckValidConversionAtTip(m_chain.Tip(), it->GetConversionInfo().value(), checkLastNBlocks, buffer)) return true;
+            if (!conversion_window->IsValid(*it)) return true;
             // Transaction is not a conversion or conversion is valid at start of next block
             return false;
         };
-        m_mempool->removeForBlock(blockConnecting.vtx, pindexNew->nHeight, pindexNew->GetTotalSupply(), filter_expired, filter_invalid_conversion);
+        const auto remove_start{SteadyClock::now()};
+        m_mempool->removeForBlock(blockConnecting.vtx, pindexNew->nHeight, pindexNew->GetTotalSupply(), filter_invalid_conversion);
+        kernel::RecordValidationStage(kernel::ValidationStage::REMOVE_FOR_BLOCK, std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - remove_start));
         disconnectpool.removeForBlock(blockConnecting.vtx);
     }
     // Update m_chain & related variables.
@@ -2969,6 +3578,7 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     UpdateTip(pindexNew);
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
+    kernel::RecordValidationStage(kernel::ValidationStage::CONNECT_TIP, std::chrono::microseconds{nTime6 - nTime1});
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
     LogPrint(BCLog::BENCH, "- Connect block: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime1) * MILLI, nTimeTotal * MICRO, nTimeTotal * MILLI / nBlocksTotal);
 
@@ -3457,21 +4067,26 @@ bool Chainstate::InvalidateBlock(BlockValidationState& state, CBlockIndex* pinde
 void Chainstate::ResetBlockFailureFlags(CBlockIndex *pindex) {
     AssertLockHeld(cs_main);
 
-    int nHeight = pindex->nHeight;
-
-    // Remove the invalidity flag from this block and all its descendants.
-    for (auto& [_, block_index] : m_blockman.m_block_index) {
-        if (!block_index.IsValid() && block_index.GetAncestor(nHeight) == pindex) {
-            block_index.nStatus &= ~BLOCK_FAILED_MASK;
-            m_blockman.m_dirty_blockindex.insert(&block_index);
-            if (block_index.IsValid(BLOCK_VALID_TRANSACTIONS) && block_index.HaveTxsDownloaded() && setBlockIndexCandidates.value_comp()(m_chain.Tip(), &block_index)) {
-                setBlockIndexCandidates.insert(&block_index);
+    // Remove the invalidity flag from this block and all its descendants, walking
+    // only the subtree below it rather than the whole block index.
+    std::vector<CBlockIndex*> stack{pindex};
+    while (!stack.empty()) {
+        CBlockIndex* block_index{stack.back()};
+        stack.pop_back();
+        for (CBlockIndex* child = block_index->pfirstChild; child; child = child->pnextSibling) {
+            stack.push_back(child);
+        }
+        if (!block_index->IsValid()) {
+            block_index->nStatus &= ~BLOCK_FAILED_MASK;
+            m_blockman.m_dirty_blockindex.insert(block_index);
+            if (block_index->IsValid(BLOCK_VALID_TRANSACTIONS) && block_index->HaveTxsDownloaded() && setBlockIndexCandidates.value_comp()(m_chain.Tip(), block_index)) {
+                setBlockIndexCandidates.insert(block_index);
             }
-            if (&block_index == m_chainman.m_best_invalid) {
+            if (block_index == m_chainman.m_best_invalid) {
                 // Reset invalid block marker if it was pointing to one of those.
                 m_chainman.m_best_invalid = nullptr;
             }
-            m_chainman.m_failed_blocks.erase(&block_index);
+            m_chainman.m_failed_blocks.erase(block_index);
         }
     }
 
@@ -3578,7 +4193,7 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
     // checks that use witness data may be performed here.
 
     // Size limits
-    if (block.vtx.empty() || block.vtx.size() * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT || ::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS) * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT)
+    if (block.vtx.empty() || block.vtx.size() * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT || GetBlockStrippedSize(block) * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT)
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-length", "size limits failed");
 
     // First transaction must be coinbase, the rest must not be
@@ -3655,8 +4270,16 @@ std::vector<unsigned char> ChainstateManager::GenerateCoinbaseCommitment(CBlock&
 
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
 {
-    return std::all_of(headers.cbegin(), headers.cend(),
-            [&](const auto& header) { return CheckProofOfWork(header.GetHash(), header.nBits, consensusParams);});
+    return HasValidProofOfWork(headers, GetBlockHeaderHashes(headers), consensusParams);
+}
+
+bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& hashes, const Consensus::Params& consensusParams)
+{
+    assert(headers.size() == hashes.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (!CheckProofOfWork(hashes[i], headers[i].nBits, consensusParams)) return false;
+    }
+    return true;
 }
 
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers)
@@ -3678,6 +4301,32 @@ arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers)
  *  in ConnectBlock().
  *  Note that -reindex-chainstate skips the validation that happens here!
  */
+/** Header checks against the previous block that depend neither on the block index nor on the clock */
+static bool ContextualCheckBlockHeaderVersionAndSupply(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, VersionBitsCache& versionbitscache, const CBlockIndex* pindexPrev)
+{
+    const int nHeight = pindexPrev->nHeight + 1;
+
+    // Reject blocks with outdated version
+    if ((block.nVersion < 2 && DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_HEIGHTINCB, versionbitscache)) ||
+        (block.nVersion < 3 && DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_DERSIG, versionbitscache)) ||
+        (block.nVersion < 4 && DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_CLTV, versionbitscache))) {
+            return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, strprintf("bad-version(0x%08x)", block.nVersion),
+                                 strprintf("rejected nVersion=0x%08x block", block.nVersion));
+    }
+
+    // Conversions never increase the sum-of-squares invariant K of the total
+    // supply and the block reward adds at most the subsidy to it, so reject a
+    // total supply that no set of transactions could reach before fetching any
+    // inputs. ConnectBlock still checks the supply exactly.
+    const CAmounts supply{std::max<CAmount>(block.cashSupply, 0), std::max<CAmount>(block.bondSupply, 0)};
+    const uint64_t max_invariant{ISqrt(GetInvariantSquare(pindexPrev->GetTotalSupply())) + GetBlockSubsidy(nHeight, consensusParams)};
+    if (ISqrt(GetInvariantSquare(supply)) > max_invariant) {
+        return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "bad-total-supply", "total supply grows faster than the block reward");
+    }
+
+    return true;
+}
+
 static bool ContextualCheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, BlockManager& blockman, const ChainstateManager& chainman, const CBlockIndex* pindexPrev, NodeClock::time_point now) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
 {
     AssertLockHeld(::cs_main);
@@ -3710,15 +4359,18 @@ static bool ContextualCheckBlockHeader(const CBlockHeader& block, BlockValidatio
         return state.Invalid(BlockValidationResult::BLOCK_TIME_FUTURE, "time-too-new", "block timestamp too far in the future");
     }
 
-    // Reject blocks with outdated version
-    if ((block.nVersion < 2 && DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_HEIGHTINCB)) ||
-        (block.nVersion < 3 && DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_DERSIG)) ||
-        (block.nVersion < 4 && DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_CLTV))) {
-            return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, strprintf("bad-version(0x%08x)", block.nVersion),
-                                 strprintf("rejected nVersion=0x%08x block", block.nVersion));
-    }
+    return ContextualCheckBlockHeaderVersionAndSupply(block, state, consensusParams, chainman.m_versionbitscache, pindexPrev);
+}
 
-    return true;
+bool ContextualCheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, VersionBitsCache& versionbitscache, const CBlockIndex* pindexPrev)
+{
+    assert(pindexPrev != nullptr);
+    // The same checks as above, except for the checkpoints and the current time
+    if (block.nBits != GetNextWorkRequired(pindexPrev, &block, consensusParams))
+        return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "bad-diffbits", "incorrect proof of work");
+    if (block.GetBlockTime() <= pindexPrev->GetMedianTimePast())
+        return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER, "time-too-old", "block's timestamp is too early");
+    return ContextualCheckBlockHeaderVersionAndSupply(block, state, consensusParams, versionbitscache, pindexPrev);
 }
 
 /** NOTE: This function is not currently invoked by ConnectBlock(), so we
@@ -3728,12 +4380,17 @@ static bool ContextualCheckBlockHeader(const CBlockHeader& block, BlockValidatio
  *  Note that -reindex-chainstate skips the validation that happens here!
  */
 static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& state, const ChainstateManager& chainman, const CBlockIndex* pindexPrev)
+{
+    return ContextualCheckBlock(block, state, chainman.GetConsensus(), chainman.m_versionbitscache, pindexPrev);
+}
+
+bool ContextualCheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, VersionBitsCache& versionbitscache, const CBlockIndex* pindexPrev)
 {
     const int nHeight = pindexPrev == nullptr ? 0 : pindexPrev->nHeight + 1;
 
     // Enforce BIP113 (Median Time Past).
     bool enforce_locktime_median_time_past{false};
-    if (DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_CSV)) {
+    if (DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_CSV, versionbitscache)) {
         assert(pindexPrev != nullptr);
         enforce_locktime_median_time_past = true;
     }
@@ -3757,7 +4414,7 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     }
 
     // Enforce rule that the coinbase starts with serialized block height
-    if (DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_HEIGHTINCB))
+    if (DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_HEIGHTINCB, versionbitscache))
     {
         CScript expect = CScript() << nHeight;
         if (block.vtx[0]->vin[0].scriptSig.size() < expect.size() ||
@@ -3775,11 +4432,11 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     //   {0xaa, 0x21, 0xa9, 0xed}, and the following 32 bytes are SHA256^2(witness root, witness reserved value). In case there are
     //   multiple, the last one is used.
     bool fHaveWitness = false;
-    if (DeploymentActiveAfter(pindexPrev, chainman, Consensus::DEPLOYMENT_SEGWIT)) {
+    if (DeploymentActiveAfter(pindexPrev, consensusParams, Consensus::DEPLOYMENT_SEGWIT, versionbitscache)) {
         int commitpos = GetWitnessCommitmentIndex(block);
         if (commitpos != NO_WITNESS_COMMITMENT) {
             bool malleated = false;
-            uint256 hashWitness = BlockWitnessMerkleRoot(block, &malleated);
+            uint256 hashWitness = block.m_witness_merkle_root ? *block.m_witness_merkle_root : BlockWitnessMerkleRoot(block, &malleated);
             // The malleation check is ignored; as the transaction tree itself
             // already does not permit it, it is impossible to trigger in the
             // witness tree.
@@ -4134,6 +4791,58 @@ bool TestBlockValidity(BlockValidationState& state,
     return true;
 }
 
+util::Result<std::vector<BlockConversion>> ReplayBlockConversions(const CBlock& block, const CBlockUndo& blockundo, CAmounts totalSupply)
+{
+    std::vector<BlockConversion> conversions;
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        const CTransaction& tx{*block.vtx[i]};
+        std::optional<CTxConversionInfo> info{GetConversionInfo(tx)};
+        if (!info) continue;
+
+        BlockConversion conversion{i, std::move(*info), {0}, 0};
+        for (const Coin& coin : blockundo.vtxundo.at(i - 1).vprevout) {
+            conversion.inputs[coin.out.amountType] += coin.out.nValue;
+        }
+        if (!Consensus::IsValidConversion(totalSupply, conversion.inputs, tx.GetValuesOut(), conversion.info.remainderType, conversion.remainder)) {
+            return util::Error{Untranslated(strprintf("invalid conversion %s", tx.GetHash().ToString()))};
+        }
+        conversions.push_back(std::move(conversion));
+    }
+    return conversions;
+}
+
+std::optional<std::vector<CTxOut>> GetConversionRemainderOutputs(const CBlock& block, CCoinsView& inputs, int nHeight, CAmounts totalSupply)
+{
+    CCoinsViewCache view(&inputs);
+    std::vector<CTxOut> conversionOutputs;
+    std::map<std::pair<CAmountType, CScript>, size_t> conversionOutputPositions;
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        CAmounts txfees = {0};
+        std::optional<CTxConversionInfo> conversion_info;
+        TxValidationState tx_state;
+        if (!Consensus::CheckTxInputs(tx, tx_state, view, nHeight, txfees, conversion_info)) return std::nullopt;
+
+        if (conversion_info) {
+            CAmount remainder;
+            if (!Consensus::IsValidConversion(totalSupply, conversion_info->inputs, conversion_info->minOutputs, conversion_info->remainderType, remainder)) {
+                return std::nullopt;
+            }
+            // Remainders without a destination are added to the miner fees
+            if (remainder > 0 && IsValidDestination(conversion_info->destination)) {
+                const auto [it, inserted] = conversionOutputPositions.try_emplace({conversion_info->remainderType, GetScriptForDestination(conversion_info->destination)}, conversionOutputs.size());
+                if (inserted) {
+                    conversionOutputs.emplace_back(conversion_info->remainderType, remainder, it->first.second);
+                } else {
+                    conversionOutputs[it->second].nValue += remainder;
+                }
+            }
+        }
+        AddCoins(view, tx, nHeight);
+    }
+    return conversionOutputs;
+}
+
 /* This function is called from the RPC code for pruneblockchain */
 void PruneBlockFilesManual(Chainstate& active_chainstate, int nManualPruneHeight)
 {
@@ -4179,7 +4888,51 @@ bool Chainstate::LoadChainTip()
     return true;
 }
 
-CVerifyDB::CVerifyDB()
+namespace {
+/** Number of blocks that VerifyDB reads and checks together, ahead of disconnecting or connecting them */
+constexpr size_t VERIFYDB_READ_AHEAD_BLOCKS{32};
+/** Maximum number of threads reading and checking blocks in VerifyDB */
+constexpr size_t MAX_VERIFYDB_READ_AHEAD_THREADS{8};
+
+/** A block read and checked ahead of VerifyDB */
+struct VerifyBlock {
+    CBlockIndex* index;
+    //! Positions of the block and undo data, looked up with cs_main held
+    FlatFilePos block_pos;
+    FlatFilePos undo_pos;
+    //! Whether the block data was read, and passed CheckBlock if that was required
+    bool read{false};
+    bool checked{false};
+    CBlock block{};
+    BlockValidationState state{};
+    //! Whether the undo data was read, if that was required and there is any
+    bool undo_read{false};
+    CBlockUndo undo{};
+};
+
+/**
+ * Read the blocks, on tasks of pool if there is one, checking them from check
+ * level 1 and reading their undo data from check level 2. The tasks don't take
+ * cs_main, which the caller holds.
+ */
+void FetchVerifyBlocks(const util::TaskPool* pool, std::vector<VerifyBlock>& blocks, const Consensus::Params& consensus_params, int check_level)
+{
+    util::ParallelFor(pool, blocks.size(), MAX_VERIFYDB_READ_AHEAD_THREADS, [&](size_t i) {
+        VerifyBlock& verify_block = blocks[i];
+        verify_block.read = ReadBlockFromDisk(verify_block.block, verify_block.block_pos, consensus_params) &&
+                            verify_block.block.GetHash() == verify_block.index->GetBlockHash();
+        if (!verify_block.read) return;
+        if (check_level >= 1) {
+            verify_block.checked = CheckBlock(verify_block.block, verify_block.state, consensus_params);
+        }
+        if (check_level >= 2 && !verify_block.undo_pos.IsNull()) {
+            verify_block.undo_read = UndoReadFromDisk(verify_block.undo, verify_block.undo_pos, verify_block.index->pprev->GetBlockHash());
+        }
+    });
+}
+} // namespace
+
+CVerifyDB::CVerifyDB(util::ThreadPool* thread_pool) : m_thread_pool{thread_pool}
 {
     uiInterface.ShowProgress(_("Verifying blocks…").translated, 0, false);
 }
@@ -4216,6 +4969,16 @@ bool CVerifyDB::VerifyDB(
     LogPrintf("[0%%]..."); /* Continued */
 
     const bool is_snapshot_cs{!chainstate.m_from_snapshot_blockhash};
+    const auto has_data{[&](const CBlockIndex* index) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        return !(fPruneMode || is_snapshot_cs) || (index->nStatus & BLOCK_HAVE_DATA);
+    }};
+
+    // Blocks are read and checked in batches on several threads, ahead of the
+    // disconnection and reconnection of the blocks, which stay in order.
+    std::optional<util::TaskPool> pool;
+    if (m_thread_pool) pool.emplace(*m_thread_pool, "verifydb", util::TaskPriority::NORMAL);
+    std::vector<VerifyBlock> blocks;
+    size_t next_block{0};
 
     for (pindex = chainstate.m_chain.Tip(); pindex && pindex->pprev; pindex = pindex->pprev) {
         const int percentageDone = std::max(1, std::min(99, (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * (nCheckLevel >= 4 ? 50 : 100))));
@@ -4228,37 +4991,44 @@ bool CVerifyDB::VerifyDB(
         if (pindex->nHeight <= chainstate.m_chain.Height() - nCheckDepth) {
             break;
         }
-        if ((fPruneMode || is_snapshot_cs) && !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+        if (!has_data(pindex)) {
             // If pruning or running under an assumeutxo snapshot, only go
             // back as far as we have data.
             LogPrintf("VerifyDB(): block verification stopping at height %d (pruning, no data)\n", pindex->nHeight);
             break;
         }
-        CBlock block;
+        if (next_block == blocks.size()) {
+            // Read and check the next blocks the loop gets to
+            blocks.clear();
+            next_block = 0;
+            for (CBlockIndex* index = pindex; index && index->pprev && blocks.size() < VERIFYDB_READ_AHEAD_BLOCKS; index = index->pprev) {
+                if (index->nHeight <= chainstate.m_chain.Height() - nCheckDepth || !has_data(index)) break;
+                blocks.push_back({index, index->GetBlockPos(), index->GetUndoPos()});
+            }
+            FetchVerifyBlocks(pool ? &*pool : nullptr, blocks, consensus_params, nCheckLevel);
+        }
+        VerifyBlock& verify_block{blocks[next_block++]};
+        assert(verify_block.index == pindex);
+        const CBlock& block{verify_block.block};
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+        if (!verify_block.read) {
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         }
         // check level 1: verify block validity
-        if (nCheckLevel >= 1 && !CheckBlock(block, state, consensus_params)) {
+        if (nCheckLevel >= 1 && !verify_block.checked) {
             return error("%s: *** found bad block at %d, hash=%s (%s)\n", __func__,
-                         pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
+                         pindex->nHeight, pindex->GetBlockHash().ToString(), verify_block.state.ToString());
         }
         // check level 2: verify undo validity
-        if (nCheckLevel >= 2 && pindex) {
-            CBlockUndo undo;
-            if (!pindex->GetUndoPos().IsNull()) {
-                if (!UndoReadFromDisk(undo, pindex)) {
-                    return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
-                }
-            }
+        if (nCheckLevel >= 2 && !verify_block.undo_pos.IsNull() && !verify_block.undo_read) {
+            return error("VerifyDB(): *** found bad undo data at %d, hash=%s\n", pindex->nHeight, pindex->GetBlockHash().ToString());
         }
         // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
         size_t curr_coins_usage = coins.DynamicMemoryUsage() + chainstate.CoinsTip().DynamicMemoryUsage();
 
         if (nCheckLevel >= 3 && curr_coins_usage <= chainstate.m_coinstip_cache_size_bytes) {
             assert(coins.GetBestBlock() == pindex->GetBlockHash());
-            DisconnectResult res = chainstate.DisconnectBlock(block, pindex, coins);
+            DisconnectResult res = chainstate.DisconnectBlock(block, pindex, coins, verify_block.undo_read ? &verify_block.undo : nullptr);
             if (res == DISCONNECT_FAILED) {
                 return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             }
@@ -4280,6 +5050,8 @@ bool CVerifyDB::VerifyDB(
 
     // check level 4: try reconnecting blocks
     if (nCheckLevel >= 4) {
+        blocks.clear();
+        next_block = 0;
         while (pindex != chainstate.m_chain.Tip()) {
             const int percentageDone = std::max(1, std::min(99, 100 - (int)(((double)(chainstate.m_chain.Height() - pindex->nHeight)) / (double)nCheckDepth * 50)));
             if (reportDone < percentageDone / 10) {
@@ -4289,10 +5061,20 @@ bool CVerifyDB::VerifyDB(
             }
             uiInterface.ShowProgress(_("Verifying blocks…").translated, percentageDone, false);
             pindex = chainstate.m_chain.Next(pindex);
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params))
+            if (next_block == blocks.size()) {
+                blocks.clear();
+                next_block = 0;
+                for (CBlockIndex* index = pindex; index && blocks.size() < VERIFYDB_READ_AHEAD_BLOCKS; index = chainstate.m_chain.Next(index)) {
+                    blocks.push_back({index, index->GetBlockPos(), index->GetUndoPos()});
+                }
+                // ConnectBlock checks the blocks itself
+                FetchVerifyBlocks(pool ? &*pool : nullptr, blocks, consensus_params, /*check_level=*/0);
+            }
+            VerifyBlock& verify_block{blocks[next_block++]};
+            assert(verify_block.index == pindex);
+            if (!verify_block.read)
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-            if (!chainstate.ConnectBlock(block, state, pindex, coins)) {
+            if (!chainstate.ConnectBlock(verify_block.block, state, pindex, coins)) {
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s (%s)", pindex->nHeight, pindex->GetBlockHash().ToString(), state.ToString());
             }
             if (ShutdownRequested()) return true;
@@ -4537,6 +5319,137 @@ bool Chainstate::LoadGenesisBlock()
     return true;
 }
 
+namespace {
+/** How many blocks the external block file reader may prepare ahead of processing. */
+static constexpr size_t EXTERNAL_BLOCK_READ_AHEAD{16};
+
+/**
+ * Locates and deserializes the blocks of an external block file on a separate
+ * thread, so that Chainstate::LoadExternalBlockFile() can validate and store
+ * one block while the following ones are read from disk and parsed.
+ */
+class ExternalBlockReader
+{
+public:
+    struct Entry {
+        std::shared_ptr<CBlock> block;
+        uint256 hash;
+        unsigned int pos;
+    };
+
+    /** Takes over file and closes it when the reader thread finishes. */
+    ExternalBlockReader(FILE* file, const CChainParams& params) : m_params{params}
+    {
+        m_thread = std::thread(&util::TraceThread, "loadblk.read", [this, file] { Run(file); });
+    }
+
+    ~ExternalBlockReader()
+    {
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        m_thread.join();
+    }
+
+    /** Returns the next block in file order, or std::nullopt once the file is exhausted. */
+    std::optional<Entry> Next() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::optional<Entry> entry;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_queue.empty() || m_done; });
+            if (m_queue.empty()) return std::nullopt;
+            entry = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_cond.notify_all();
+        return entry;
+    }
+
+    /** The system error that ended reading early, if any. Only meaningful once Next() returned std::nullopt. */
+    std::optional<std::string> Error() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        return m_error;
+    }
+
+private:
+    void Run(FILE* file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        try {
+            // This takes over file and calls fclose() on it in the CBufferedFile destructor
+            CBufferedFile blkdat(file, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
+            uint64_t nRewind = blkdat.GetPos();
+            while (!blkdat.eof()) {
+                if (ShutdownRequested()) break;
+
+                blkdat.SetPos(nRewind);
+                nRewind++; // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try {
+                    // locate a header
+                    unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                    blkdat.FindByte(m_params.MessageStart()[0]);
+                    nRewind = blkdat.GetPos() + 1;
+                    blkdat >> buf;
+                    if (memcmp(buf, m_params.MessageStart(), CMessageHeader::MESSAGE_START_SIZE)) {
+                        continue;
+                    }
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                        continue;
+                } catch (const std::exception&) {
+                    // no valid block header found; don't complain
+                    break;
+                }
+                try {
+                    // read block
+                    Entry entry;
+                    entry.pos = blkdat.GetPos();
+                    blkdat.SetLimit(entry.pos + nSize);
+                    entry.block = std::make_shared<CBlock>();
+                    blkdat >> *entry.block;
+                    nRewind = blkdat.GetPos();
+                    entry.hash = entry.block->GetHash();
+
+                    WAIT_LOCK(m_mutex, lock);
+                    m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_queue.size() < EXTERNAL_BLOCK_READ_AHEAD || m_stop; });
+                    if (m_stop) break;
+                    m_queue.push_back(std::move(entry));
+                } catch (const std::exception& e) {
+                    LogPrintf("LoadExternalBlockFile: Deserialize or I/O error - %s\n", e.what());
+                    continue;
+                }
+                m_cond.notify_all();
+            }
+        } catch (const std::runtime_error& e) {
+            LOCK(m_mutex);
+            m_error = e.what();
+        }
+        {
+            LOCK(m_mutex);
+            m_done = true;
+        }
+        m_cond.notify_all();
+    }
+
+    const CChainParams& m_params;
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Entry> m_queue GUARDED_BY(m_mutex);
+    //! Set by the reader thread once it will not add further entries
+    bool m_done GUARDED_BY(m_mutex){false};
+    //! Set by the consumer to make the reader thread finish early
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::optional<std::string> m_error GUARDED_BY(m_mutex);
+    std::thread m_thread;
+};
+} // namespace
+
 void Chainstate::LoadExternalBlockFile(
     FILE* fileIn,
     FlatFilePos* dbp,
@@ -4551,45 +5464,16 @@ void Chainstate::LoadExternalBlockFile(
 
     int nLoaded = 0;
     try {
-        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
-        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
+        ExternalBlockReader reader{fileIn, m_params};
+        while (auto entry{reader.Next()}) {
             if (ShutdownRequested()) return;
 
-            blkdat.SetPos(nRewind);
-            nRewind++; // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
             try {
-                // locate a header
-                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
-                blkdat.FindByte(m_params.MessageStart()[0]);
-                nRewind = blkdat.GetPos() + 1;
-                blkdat >> buf;
-                if (memcmp(buf, m_params.MessageStart(), CMessageHeader::MESSAGE_START_SIZE)) {
-                    continue;
-                }
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
-                    continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                break;
-            }
-            try {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
                 if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
-
-                uint256 hash = block.GetHash();
+                    dbp->nPos = entry->pos;
+                const std::shared_ptr<CBlock>& pblock = entry->block;
+                const CBlock& block = *pblock;
+                const uint256& hash = entry->hash;
                 {
                     LOCK(cs_main);
                     // detect out of order blocks, and store them for later
@@ -4658,6 +5542,9 @@ void Chainstate::LoadExternalBlockFile(
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
+        if (auto error{reader.Error()}) {
+            throw std::runtime_error(*error);
+        }
     } catch (const std::runtime_error& e) {
         AbortNode(std::string("System error: ") + e.what());
     }
@@ -4886,6 +5773,29 @@ void Chainstate::CheckBlockIndex()
     assert(nNodes == forward.size());
 }
 
+std::shared_ptr<const ConversionValidityWindow> Chainstate::GetConversionValidityWindow(int check_last_N_blocks, int percent_buffer)
+{
+    AssertLockHeld(::cs_main);
+    const CBlockIndex* tip = m_chain.Tip();
+    for (const auto& window : m_conversion_windows) {
+        if (window->Matches(tip, check_last_N_blocks, percent_buffer)) return window;
+    }
+    // Windows built for a previous tip are no longer needed
+    m_conversion_windows.erase(std::remove_if(m_conversion_windows.begin(), m_conversion_windows.end(),
+        [tip](const auto& window) { return window->GetTip() != tip; }), m_conversion_windows.end());
+    return m_conversion_windows.emplace_back(std::make_shared<const ConversionValidityWindow>(tip, check_last_N_blocks, percent_buffer));
+}
+
+std::shared_ptr<const FeeConversionWindow> Chainstate::GetFeeConversionWindow(int check_last_N_blocks)
+{
+    AssertLockHeld(::cs_main);
+    const CBlockIndex* tip = m_chain.Tip();
+    if (!m_fee_conversion_window || !m_fee_conversion_window->Matches(tip, check_last_N_blocks)) {
+        m_fee_conversion_window = std::make_shared<const FeeConversionWindow>(tip, check_last_N_blocks);
+    }
+    return m_fee_conversion_window;
+}
+
 std::string Chainstate::ToString()
 {
     AssertLockHeld(::cs_main);
@@ -4906,6 +5816,8 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // The database is reopened, so a background write must not be in flight
+    if (!m_coins_views->m_flushview.WaitForWrite()) return false;
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
@@ -5116,7 +6028,7 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     CBlockIndex* snapshot_start_block = WITH_LOCK(::cs_main, return m_blockman.LookupBlockIndex(base_blockhash));
 
     if (!snapshot_start_block) {
-        // Needed for ComputeUTXOStats and ExpectedAssumeutxo to determine the
+        // Needed for ExpectedAssumeutxo and the supply check to determine the
         // height and to avoid a crash when base_blockhash.IsNull()
         LogPrintf("[snapshot] Did not find snapshot start blockheader %s\n",
                   base_blockhash.ToString());
@@ -5134,65 +6046,157 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     const AssumeutxoData& au_data = *maybe_au_data;
 
-    COutPoint outpoint;
-    Coin coin;
     const uint64_t coins_count = metadata.m_coins_count;
     uint64_t coins_left = metadata.m_coins_count;
 
     LogPrintf("[snapshot] loading coins from snapshot %s\n", base_blockhash.ToString());
     int64_t coins_processed{0};
 
+    // Chunks are read in batches of one per thread and decoded and checked in
+    // parallel. The coins of a batch are then added to the HASH_SERIALIZED
+    // hash on one thread while this one inserts them into the cache.
+    //
+    // The snapshot writer takes coins in coins database order, so hashing them
+    // in file order gives the same result as ComputeUTXOStats() on the loaded
+    // chainstate without reading every coin back. Coins must therefore be in
+    // strictly ascending outpoint order: a snapshot listing an outpoint twice
+    // would otherwise hash one copy and load the other.
+    const size_t num_threads{static_cast<size_t>(std::max(GetNumCores(), 1))};
+    HashWriter hasher{};
+    hasher << base_blockhash;
+    uint256 hash_txid;
+    std::map<uint32_t, Coin> hash_outputs;
+    std::optional<CAmount> total_amount_cash{0};
+    std::optional<CAmount> total_amount_bond{0};
+    // The last coin of the chunks decoded so far
+    std::optional<COutPoint> last_outpoint;
+    // The chunk index we expect at the end of the snapshot
+    std::vector<SnapshotChunkInfo> chunk_index;
+    uint64_t offset{GetSerializeSize(metadata)};
+
     while (coins_left > 0) {
+        std::vector<SnapshotChunk> chunks;
         try {
-            coins_file >> outpoint;
-            coins_file >> coin;
+            while (chunks.size() < num_threads && coins_left > 0) {
+                coins_file >> chunks.emplace_back();
+                chunk_index.push_back({offset, chunks.back().m_coins_count, uint256{}});
+                offset += GetSerializeSize(chunks.back());
+                if (chunks.back().m_coins_count > coins_left) {
+                    LogPrintf("[snapshot] bad snapshot - coins left over after deserializing %d coins\n",
+                        coins_count);
+                    return false;
+                }
+                coins_left -= chunks.back().m_coins_count;
+            }
         } catch (const std::ios_base::failure&) {
             LogPrintf("[snapshot] bad snapshot format or truncated snapshot after deserializing %d coins\n",
                       coins_count - coins_left);
             return false;
         }
-        if (coin.nHeight > base_height ||
-            outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() // Avoid integer wrap-around in coinstats.cpp:ApplyHash
-        ) {
-            LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
-                      coins_count - coins_left);
-            return false;
+
+        std::vector<std::vector<std::pair<COutPoint, Coin>>> decoded(chunks.size());
+        std::vector<CAmounts> chunk_amounts(chunks.size(), CAmounts{0});
+        std::vector<uint8_t> chunk_ok(chunks.size(), false);
+        const auto decode{[&](size_t i) {
+            try {
+                DeserializeSnapshotChunk(chunks[i], decoded[i]);
+            } catch (const std::ios_base::failure&) {
+                return;
+            }
+            const COutPoint* prev_outpoint{nullptr};
+            for (const auto& [outpoint, coin] : decoded[i]) {
+                if (prev_outpoint && !(*prev_outpoint < outpoint)) return;
+                prev_outpoint = &outpoint;
+                if (coin.nHeight > base_height ||
+                    outpoint.n >= std::numeric_limits<decltype(outpoint.n)>::max() || // Avoid integer wrap-around in coinstats.cpp:ApplyHash
+                    !MoneyRange(coin.out.nValue)
+                ) {
+                    return;
+                }
+                CAmount& amount{chunk_amounts[i][coin.out.amountType]};
+                const auto sum{CheckedAdd(amount, coin.out.nValue)};
+                if (!sum) return;
+                amount = *sum;
+            }
+            chunk_ok[i] = true;
+        }};
+        util::ParallelFor("snapshot", util::TaskPriority::NORMAL, chunks.size(), chunks.size(), decode);
+
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            if (!chunk_ok[i]) {
+                LogPrintf("[snapshot] bad snapshot data after deserializing %d coins\n",
+                          coins_processed);
+                return false;
+            }
+            if (!decoded[i].empty()) {
+                if (last_outpoint && !(*last_outpoint < decoded[i].front().first)) {
+                    LogPrintf("[snapshot] bad snapshot - coins out of order after deserializing %d coins\n",
+                              coins_processed);
+                    return false;
+                }
+                last_outpoint = decoded[i].back().first;
+                chunk_index[chunk_index.size() - chunks.size() + i].m_first_txid = decoded[i].front().first.hash;
+            }
+            if (total_amount_cash) total_amount_cash = CheckedAdd(*total_amount_cash, chunk_amounts[i][CASH]);
+            if (total_amount_bond) total_amount_bond = CheckedAdd(*total_amount_bond, chunk_amounts[i][BOND]);
         }
+        chunks.clear();
 
-        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint), std::move(coin));
+        std::thread hash_thread{[&] {
+            for (const auto& coins : decoded) {
+                for (const auto& [outpoint, coin] : coins) {
+                    if (!hash_outputs.empty() && outpoint.hash != hash_txid) {
+                        ApplyHash(hasher, hash_txid, hash_outputs);
+                        hash_outputs.clear();
+                    }
+                    hash_txid = outpoint.hash;
+                    hash_outputs[outpoint.n] = coin;
+                }
+            }
+        }};
 
-        --coins_left;
-        ++coins_processed;
+        const bool inserted{[&] {
+            for (const auto& coins : decoded) {
+                for (const auto& [outpoint, coin] : coins) {
+                    coins_cache.EmplaceCoinInternalDANGER(COutPoint{outpoint}, Coin{coin});
 
-        if (coins_processed % 1000000 == 0) {
-            LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
-                coins_processed,
-                static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
-                coins_cache.DynamicMemoryUsage() / (1000 * 1000));
-        }
+                    ++coins_processed;
 
-        // Batch write and flush (if we need to) every so often.
-        //
-        // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
-        // means <5MB of memory imprecision.
-        if (coins_processed % 120000 == 0) {
-            if (ShutdownRequested()) {
-                return false;
-            }
+                    if (coins_processed % 1000000 == 0) {
+                        LogPrintf("[snapshot] %d coins loaded (%.2f%%, %.2f MB)\n",
+                            coins_processed,
+                            static_cast<float>(coins_processed) * 100 / static_cast<float>(coins_count),
+                            coins_cache.DynamicMemoryUsage() / (1000 * 1000));
+                    }
 
-            const auto snapshot_cache_state = WITH_LOCK(::cs_main,
-                return snapshot_chainstate.GetCoinsCacheSizeState());
+                    // Batch write and flush (if we need to) every so often.
+                    //
+                    // If our average Coin size is roughly 41 bytes, checking every 120,000 coins
+                    // means <5MB of memory imprecision.
+                    if (coins_processed % 120000 == 0) {
+                        if (ShutdownRequested()) {
+                            return false;
+                        }
 
-            if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
-                // This is a hack - we don't know what the actual best block is, but that
-                // doesn't matter for the purposes of flushing the cache here. We'll set this
-                // to its correct value (`base_blockhash`) below after the coins are loaded.
-                coins_cache.SetBestBlock(GetRandHash());
+                        const auto snapshot_cache_state = WITH_LOCK(::cs_main,
+                            return snapshot_chainstate.GetCoinsCacheSizeState());
 
-                // No need to acquire cs_main since this chainstate isn't being used yet.
-                FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
+                        if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
+                            // This is a hack - we don't know what the actual best block is, but that
+                            // doesn't matter for the purposes of flushing the cache here. We'll set this
+                            // to its correct value (`base_blockhash`) below after the coins are loaded.
+                            coins_cache.SetBestBlock(GetRandHash());
+
+                            // No need to acquire cs_main since this chainstate isn't being used yet.
+                            FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
+                        }
+                    }
+                }
             }
-        }
+            return true;
+        }()};
+        hash_thread.join();
+        if (!inserted) return false;
     }
 
     // Important that we set this. This and the coins_cache accesses above are
@@ -5202,11 +6206,28 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     // method.
     coins_cache.SetBestBlock(base_blockhash);
 
+    // The coins are followed by the index of their chunks and the offset of
+    // that index, which must describe the chunks we just read.
+    bool index_ok{false};
+    try {
+        std::vector<SnapshotChunkInfo> file_chunk_index;
+        uint64_t file_index_offset;
+        coins_file >> file_chunk_index >> file_index_offset;
+        index_ok = file_chunk_index == chunk_index && file_index_offset == offset;
+    } catch (const std::ios_base::failure&) {
+    }
+    if (!index_ok) {
+        LogPrintf("[snapshot] bad snapshot - chunk index missing or not matching after deserializing %d coins\n",
+            coins_count);
+        return false;
+    }
+
     bool out_of_coins{false};
     try {
-        coins_file >> outpoint;
+        uint8_t extra;
+        coins_file >> extra;
     } catch (const std::ios_base::failure&) {
-        // We expect an exception since we should be out of coins.
+        // We expect an exception since we should be at the end of the snapshot.
         out_of_coins = true;
     }
     if (!out_of_coins) {
@@ -5220,30 +6241,32 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
         coins_cache.DynamicMemoryUsage() / (1000 * 1000),
         base_blockhash.ToString());
 
-    // No need to acquire cs_main since this chainstate isn't being used yet.
-    FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true);
-
-    assert(coins_cache.GetBestBlock() == base_blockhash);
-
-    auto breakpoint_fnc = [] { /* TODO insert breakpoint here? */ };
-
-    // As above, okay to immediately release cs_main here since no other context knows
-    // about the snapshot_chainstate.
-    CCoinsViewDB* snapshot_coinsdb = WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+    if (!hash_outputs.empty()) ApplyHash(hasher, hash_txid, hash_outputs);
+    const uint256 hash_serialized{hasher.GetHash()};
 
-    const std::optional<CCoinsStats> maybe_stats = ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED, snapshot_coinsdb, m_blockman, breakpoint_fnc);
-    if (!maybe_stats.has_value()) {
-        LogPrintf("[snapshot] failed to generate coins stats\n");
+    // Assert that the deserialized chainstate contents match the expected assumeutxo value.
+    if (AssumeutxoHash{hash_serialized} != au_data.hash_serialized) {
+        LogPrintf("[snapshot] bad snapshot content hash: expected %s, got %s\n",
+            au_data.hash_serialized.ToString(), hash_serialized.ToString());
         return false;
     }
 
-    // Assert that the deserialized chainstate contents match the expected assumeutxo value.
-    if (AssumeutxoHash{maybe_stats->hashSerialized} != au_data.hash_serialized) {
-        LogPrintf("[snapshot] bad snapshot content hash: expected %s, got %s\n",
-            au_data.hash_serialized.ToString(), maybe_stats->hashSerialized.ToString());
+    // Outputs that can never be spent are not part of the UTXO set, so the
+    // coins may add up to less than the total supply in the base block, but
+    // never to more.
+    if (!total_amount_cash || !total_amount_bond ||
+        *total_amount_cash > snapshot_start_block->cashSupply ||
+        *total_amount_bond > snapshot_start_block->bondSupply) {
+        LogPrintf("[snapshot] bad snapshot - coins exceed the total supply (%d cash, %d bond) of the base block\n",
+            snapshot_start_block->cashSupply, snapshot_start_block->bondSupply);
         return false;
     }
 
+    // No need to acquire cs_main since this chainstate isn't being used yet.
+    FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true);
+
+    assert(coins_cache.GetBestBlock() == base_blockhash);
+
     snapshot_chainstate.m_chain.SetTip(*snapshot_start_block);
 
     // The remainder of this function requires modifying data protected by cs_main.
@@ -5335,14 +6358,44 @@ void ChainstateManager::MaybeRebalanceCaches()
             m_snapshot_chainstate->ResizeCoinsCaches(
                 m_total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
         } else {
-            m_snapshot_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.05, m_total_coinsdb_cache * 0.05);
-            m_ibd_chainstate->ResizeCoinsCaches(
-                m_total_coinstip_cache * 0.95, m_total_coinsdb_cache * 0.95);
+            // The background chainstate gets its configured budget, and the tip the rest
+            const double background_share{std::clamp(m_options.background_cache_percent, 1, 99) / 100.0};
+            if (background_share > 0.5) {
+                m_snapshot_chainstate->ResizeCoinsCaches(
+                    m_total_coinstip_cache * (1 - background_share), m_total_coinsdb_cache * (1 - background_share));
+                m_ibd_chainstate->ResizeCoinsCaches(
+                    m_total_coinstip_cache * background_share, m_total_coinsdb_cache * background_share);
+            } else {
+                m_ibd_chainstate->ResizeCoinsCaches(
+                    m_total_coinstip_cache * background_share, m_total_coinsdb_cache * background_share);
+                m_snapshot_chainstate->ResizeCoinsCaches(
+                    m_total_coinstip_cache * (1 - background_share), m_total_coinsdb_cache * (1 - background_share));
+            }
         }
     }
 }
 
+void ChainstateManager::MaybeResizeToMemoryBudget()
+{
+    AssertLockHeld(::cs_main);
+    // Two chainstates share the caches as MaybeRebalanceCaches() decides
+    if (m_memory_budget <= 0 || (m_ibd_chainstate && m_snapshot_chainstate)) return;
+    Chainstate& chainstate{ActiveChainstate()};
+    int64_t coinstip_size{m_total_coinstip_cache};
+    if (chainstate.IsInitialBlockDownload()) {
+        // Keep the mempool limit out of the budget, as its unused part is
+        // lent to the coins cache anyway (see GetCoinsCacheSizeState()).
+        const CTxMemPool* mempool{chainstate.GetMempool()};
+        const int64_t mempool_size{mempool ? mempool->m_max_size_bytes : 0};
+        coinstip_size = std::max(coinstip_size, m_memory_budget - m_total_coinsdb_cache - mempool_size);
+    }
+    const int64_t current_size = chainstate.m_coinstip_cache_size_bytes;
+    // Shrinking flushes the cache, so it is only done once at the end of initial
+    // block download, and growing is done in steps of at least 10%.
+    if (coinstip_size > current_size && coinstip_size < current_size + current_size / 10) return;
+    chainstate.ResizeCoinsCaches(coinstip_size, chainstate.m_coinsdb_cache_size_bytes);
+}
+
 ChainstateManager::~ChainstateManager()
 {
     LOCK(::cs_main);
@@ -16,6 +16,9 @@
 #include <chainparams.h>
 #include <kernel/chainstatemanager_opts.h>
 #include <consensus/amount.h>
+#include <consensus/conversion.h>
+#include <cuckoocache.h>
+#include <consensus/invariant.h>
 #include <deploymentstatus.h>
 #include <fs.h>
 #include <node/blockstorage.h>
@@ -23,16 +26,21 @@
 #include <policy/packages.h>
 #include <policy/policy.h>
 #include <script/script_error.h>
+#include <script/standard.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h> // For CTxMemPool::cs
 #include <uint256.h>
 #include <util/check.h>
 #include <util/hasher.h>
+#include <util/result.h>
 #include <util/translation.h>
 #include <versionbits.h>
 
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <optional>
@@ -43,6 +51,7 @@
 #include <utility>
 #include <vector>
 
+class CBlockUndo;
 class Chainstate;
 class CBlockTreeDB;
 class CTxMemPool;
@@ -58,15 +67,26 @@ class SnapshotMetadata;
 namespace Consensus {
 struct Params;
 } // namespace Consensus
+namespace util {
+class ThreadPool;
+} // namespace util
 
 /** Maximum number of dedicated script-checking threads allowed */
 static const int MAX_SCRIPTCHECK_THREADS = 15;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** -parbackground default (number of script-checking workers of the background chainstate, 0 = as many as -par) */
+static constexpr int DEFAULT_BACKGROUND_SCRIPTCHECK_THREADS{0};
 static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
+static constexpr bool DEFAULT_DBCACHE_HUGE_PAGES{false};
+static constexpr bool DEFAULT_DBFLUSH_BACKGROUND{false};
+/** How often the coins cache is resized to the -maxmemory budget */
+static constexpr std::chrono::minutes MEMORY_BUDGET_INTERVAL{1};
 static const bool DEFAULT_TXINDEX = false;
 static constexpr bool DEFAULT_COINSTATSINDEX{false};
+static constexpr bool DEFAULT_CONVERSIONINDEX{false};
+static constexpr bool DEFAULT_TXOSPENDERINDEX{false};
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 /** Default for -stopatheight */
 static const int DEFAULT_STOPATHEIGHT = 0;
@@ -109,6 +129,10 @@ extern uint256 g_best_block;
  */
 extern bool g_parallel_script_checks;
 extern bool fCheckBlockIndex;
+/** Whether the coins caches of chainstates are allocated from huge pages. */
+extern bool g_coins_cache_huge_pages;
+/** Whether periodic flushes of the coins cache are written to the coin database on a background thread. */
+extern bool g_coins_flush_background;
 extern bool fCheckpointsEnabled;
 /** If the tip is older than this (in seconds), the node is considered to be in initial block download. */
 extern int64_t nMaxTipAge;
@@ -124,8 +148,30 @@ extern const std::vector<std::string> CHECKLEVEL_DOC;
 
 /** Run instances of script checking worker threads */
 void StartScriptCheckWorkerThreads(int threads_num);
+/** Run up to workers_num script checking workers on the threads of thread_pool */
+void StartScriptCheckWorkers(util::ThreadPool& thread_pool, int workers_num);
+/**
+ * Run up to workers_num script checking workers for the background validation
+ * chainstate of a snapshot on the threads of thread_pool. They run at low
+ * priority, so that they leave workers to the checks of the active chainstate.
+ */
+void StartBackgroundScriptCheckWorkers(util::ThreadPool& thread_pool, int workers_num);
 /** Stop all of the script checking worker threads */
 void StopScriptCheckWorkerThreads();
+/** Run instances of the worker threads that check received blocks ahead of ProcessNewBlock() */
+void StartBlockCheckWorkerThreads(int threads_num);
+/** Run up to workers_num block checking workers on the threads of thread_pool */
+void StartBlockCheckWorkers(util::ThreadPool& thread_pool, int workers_num);
+/** Stop all of the block checking worker threads, dropping queued blocks */
+void StopBlockCheckWorkerThreads();
+/**
+ * Queue the context-free checks of a received block (CheckBlock() and its witness
+ * merkle root) for a block checking worker thread. No other thread may use the
+ * block until on_checked is called on the worker thread; ProcessNewBlock() then
+ * finds the results cached in the block. Returns false without queuing if there
+ * are no worker threads or they are busy enough already.
+ */
+bool QueueBlockCheck(std::shared_ptr<const CBlock> block, const Consensus::Params& params, std::function<void()> on_checked);
 
 CAmounts GetBlockSubsidy(int nHeight, const CAmounts startingSupply, const Consensus::Params& consensusParams);
 
@@ -168,8 +214,12 @@ struct MempoolAcceptResult {
     /** The wtxid of the transaction in the mempool which has the same txid but different witness. */
     const std::optional<uint256> m_other_wtxid;
 
-    static MempoolAcceptResult Failure(TxValidationState state) {
-        return MempoolAcceptResult(state);
+    // The following field is only present for conversions rejected as TX_INVALID_CONVERSION
+    /** What the conversion spends and converts to, to tell when the supply would make it valid. */
+    const std::optional<CTxConversionInfo> m_conversion_info;
+
+    static MempoolAcceptResult Failure(TxValidationState state, std::optional<CTxConversionInfo> conversion_info = std::nullopt) {
+        return MempoolAcceptResult(state, std::move(conversion_info));
     }
 
     static MempoolAcceptResult Success(std::list<CTransactionRef>&& replaced_txns, int64_t vsize, CAmount fees) {
@@ -187,8 +237,8 @@ struct MempoolAcceptResult {
 // Private constructors. Use static methods MempoolAcceptResult::Success, etc. to construct.
 private:
     /** Constructor for failure case */
-    explicit MempoolAcceptResult(TxValidationState state)
-        : m_result_type(ResultType::INVALID), m_state(state) {
+    explicit MempoolAcceptResult(TxValidationState state, std::optional<CTxConversionInfo> conversion_info)
+        : m_result_type(ResultType::INVALID), m_state(state), m_conversion_info(std::move(conversion_info)) {
             Assume(!state.IsValid()); // Can be invalid or error
         }
 
@@ -254,6 +304,25 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
                                        int64_t accept_time, bool bypass_limits, bool test_accept)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Try to add a batch of transactions to the mempool, as if each was submitted with
+ * AcceptToMemoryPool() in order. Independent transactions are validated together under one
+ * mempool lock: their script checks run in parallel on the script check queue and, unless limits
+ * are bypassed, the mempool is trimmed once they are all submitted. This is used when loading the
+ * mempool from disk and when resubmitting the transactions of disconnected blocks; transactions
+ * received from peers are still submitted one by one with AcceptToMemoryPool().
+ *
+ * @param[in]  active_chainstate  Reference to the active chainstate.
+ * @param[in]  txns               The transactions to submit for mempool acceptance, parents first.
+ * @param[in]  accept_times       The timestamp for adding each transaction to the mempool.
+ * @param[in]  bypass_limits      When true, don't enforce mempool fee and capacity limits.
+ *
+ * @returns a MempoolAcceptResult for each transaction, in the same order.
+ */
+std::vector<MempoolAcceptResult> AcceptToMemoryPoolBatch(Chainstate& active_chainstate, const std::vector<CTransactionRef>& txns,
+                                                         const std::vector<int64_t>& accept_times, bool bypass_limits)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /**
 * Validate (and maybe submit) a package to the mempool. See doc/policy/packages.md for full details
 * on package validation rules.
@@ -278,13 +347,87 @@ bool CheckFinalTxAtTip(const CBlockIndex& active_chain_tip, const CTransaction&
  */
 bool CheckExpiredConversionAtTip(const CBlockIndex& active_chain_tip, const CTxConversionInfo& info) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+/**
+ * Buffered total supplies at the end of the last N blocks up to a tip, together with
+ * their sum-of-squares invariants. Built once per tip so that checking a conversion
+ * only compares its invariant out against each cached invariant in.
+ */
+class ConversionValidityWindow
+{
+private:
+    struct BufferedSupply {
+        CAmounts totalSupply;
+        CAmountSquare invariant_sq;
+    };
+
+    //! Unique among all windows, so that results cached against it are never mistaken for another's
+    const uint64_t m_id;
+    const CBlockIndex* m_tip;
+    int m_check_last_N_blocks;
+    int m_percent_buffer;
+    //! Cash-buffered then bond-buffered supply for each block, starting at the tip
+    std::vector<BufferedSupply> m_supplies;
+
+public:
+    /**
+     * @param[in]   percent_buffer  Allowable buffer (in bips) applied first to the
+     *                              cash supply, then to the bond supply.
+     */
+    ConversionValidityWindow(const CBlockIndex* tip, int check_last_N_blocks, int percent_buffer);
+
+    uint64_t GetId() const { return m_id; }
+    const CBlockIndex* GetTip() const { return m_tip; }
+
+    bool Matches(const CBlockIndex* tip, int check_last_N_blocks, int percent_buffer) const
+    {
+        return m_tip == tip && m_check_last_N_blocks == check_last_N_blocks && m_percent_buffer == percent_buffer;
+    }
+
+    /** Check if conversion was valid within the buffer at the end of one of the blocks in the window */
+    bool IsValid(const CTxConversionInfo& info) const;
+
+    /**
+     * Check if the mempool entry is not a conversion, or a conversion valid in the
+     * window. The result is cached on the entry, so checking it again against the
+     * same window, like for repeated replacements of it, is free.
+     */
+    bool IsValid(const CTxMemPoolEntry& entry) const;
+};
+
+/**
+ * Conversion rates of the total supplies at the end of the last N blocks up to a tip,
+ * built once per tip for normalizing the bond fees of transactions entering the mempool.
+ */
+class FeeConversionWindow
+{
+private:
+    const CBlockIndex* m_tip;
+    int m_check_last_N_blocks;
+    ConversionRate m_tip_rate;
+    //! Conversion rate for each block, starting at the tip
+    std::vector<ConversionRate> m_rates;
+
+public:
+    FeeConversionWindow(const CBlockIndex* tip, int check_last_N_blocks);
+
+    const CBlockIndex* GetTip() const { return m_tip; }
+
+    bool Matches(const CBlockIndex* tip, int check_last_N_blocks) const
+    {
+        return m_tip == tip && m_check_last_N_blocks == check_last_N_blocks;
+    }
+
+    const ConversionRate& GetTipRate() const { return m_tip_rate; }
+    const std::vector<ConversionRate>& GetRates() const { return m_rates; }
+};
+
 /**
  * Check if conversion was valid within some range at the end of one of the last N blocks
  * @param[in]   percent_buffer  Allowable buffer (in bips) when checking the validity of
  *                              the transaction. First, checks validity by increasing the
  *                              cash supply, then checks by increasing the bond supply.
  */
-bool CheckValidConversionAtTip(const CBlockIndex& active_chain_tip, const CTxConversionInfo& info, const int& check_last_N_blocks, const int& percent_buffer) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+bool CheckValidConversionAtTip(const CBlockIndex* tip, const CTxConversionInfo& info, const int& check_last_N_blocks, const int& percent_buffer) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 /**
  * Check if transaction will be BIP68 final in the next block to be created on top of tip.
  * @param[in]   tip             Chain tip to check tx sequence locks against. For example,
@@ -347,11 +490,28 @@ public:
 /** Initializes the script-execution cache */
 [[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes);
 
+/** Hits, misses and evictions of the script-execution cache */
+CuckooCache::stats GetScriptExecutionCacheStats();
+/** Memory used by the script-execution cache */
+size_t GetScriptExecutionCacheMemoryUsage();
+
 /** Functions for validating blocks and updating the block tree */
 
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
 
+/**
+ * Checks of a block header against its ancestors, leaving out the checkpoints
+ * and the clock, which only apply to blocks that are about to be accepted.
+ */
+bool ContextualCheckBlockHeader(const CBlockHeader& block, BlockValidationState& state, const Consensus::Params& consensusParams, VersionBitsCache& versionbitscache, const CBlockIndex* pindexPrev);
+
+/** Checks of a block's transactions against the block's ancestors, which do not need its inputs */
+bool ContextualCheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, VersionBitsCache& versionbitscache, const CBlockIndex* pindexPrev);
+
+/** Script verification flags the inputs of a block's transactions are checked with */
+unsigned int GetBlockScriptFlags(const CBlockIndex& block_index, const Consensus::Params& consensusparams, VersionBitsCache& versionbitscache);
+
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(BlockValidationState& state,
                        const CChainParams& chainparams,
@@ -362,8 +522,45 @@ bool TestBlockValidity(BlockValidationState& state,
                        bool fCheckPOW = true,
                        bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Predict the conversion remainder outputs paid by a block's coinbase, as the
+ * miner lays them out, by executing the block's conversions on top of the UTXO
+ * set and total supply at the block's parent. Remainders paid to the same
+ * amount type and script are merged into the output of the first of them.
+ *
+ * @param[in] block        The block. Its coinbase is ignored.
+ * @param[in] inputs       A view of the UTXO set at the block's parent.
+ * @param[in] nHeight      The height of the block.
+ * @param[in] totalSupply  The total supply at the end of the block's parent.
+ * @returns The remainder outputs, or std::nullopt if an input is missing or a conversion is invalid.
+ */
+std::optional<std::vector<CTxOut>> GetConversionRemainderOutputs(const CBlock& block, CCoinsView& inputs, int nHeight, CAmounts totalSupply);
+
+/** A conversion of a connected block, with the amounts it spent and the remainder it was paid */
+struct BlockConversion {
+    //! Position of the conversion transaction in the block
+    size_t tx_index;
+    CTxConversionInfo info;
+    CAmounts inputs;
+    CAmount remainder;
+};
+
+/**
+ * Replay the conversions of a connected block on the total supply of its
+ * parent, as ConnectBlock does, to recover their remainders. The spent amounts
+ * are taken from the block's undo data.
+ *
+ * @param[in] block        The block.
+ * @param[in] blockundo    The undo data of the block.
+ * @param[in] totalSupply  The total supply at the end of the block's parent.
+ * @returns The conversions in block order, or an error naming the first invalid one.
+ */
+util::Result<std::vector<BlockConversion>> ReplayBlockConversions(const CBlock& block, const CBlockUndo& blockundo, CAmounts totalSupply);
+
 /** Check with the proof of work on each blockheader matches the value in nBits */
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
+/** Same as above, with the hashes of the headers already computed */
+bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const std::vector<uint256>& hashes, const Consensus::Params& consensusParams);
 
 /** Return the sum of the work on a given set of headers */
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers);
@@ -371,7 +568,8 @@ arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers);
 /** RAII wrapper for VerifyDB: Verify consistency of the block and coin databases */
 class CVerifyDB {
 public:
-    CVerifyDB();
+    /** Blocks are read and checked ahead on the workers of thread_pool, if given */
+    explicit CVerifyDB(util::ThreadPool* thread_pool = nullptr);
     ~CVerifyDB();
     bool VerifyDB(
         Chainstate& chainstate,
@@ -379,6 +577,9 @@ public:
         CCoinsView& coinsview,
         int nCheckLevel,
         int nCheckDepth) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+private:
+    util::ThreadPool* const m_thread_pool;
 };
 
 enum DisconnectResult
@@ -414,6 +615,10 @@ public:
     //! All unspent coins reside in this store.
     CCoinsViewDB m_dbview GUARDED_BY(cs_main);
 
+    //! This view writes flushed coins to `m_dbview`, on a background thread if requested,
+    //! and answers lookups of the coins it is writing until they are on disk.
+    CCoinsViewBackgroundFlush m_flushview GUARDED_BY(cs_main);
+
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
@@ -492,6 +697,12 @@ protected:
     //! Manages the UTXO set, which is a reflection of the contents of `m_chain`.
     std::unique_ptr<CoinsViews> m_coins_views;
 
+    //! Conversion validity windows built for the current tip.
+    std::vector<std::shared_ptr<const ConversionValidityWindow>> m_conversion_windows GUARDED_BY(::cs_main);
+
+    //! Fee conversion window built for the current tip.
+    std::shared_ptr<const FeeConversionWindow> m_fee_conversion_window GUARDED_BY(::cs_main);
+
 public:
     //! Reference to a BlockManager instance which itself is shared across all
     //! Chainstate instances.
@@ -574,6 +785,12 @@ public:
         return m_coins_views->m_dbview;
     }
 
+    /**
+     * Load the given coins into CoinsTip() ahead of looking them up one by one,
+     * reading those missing from the cache in parallel when there are enough.
+     */
+    void PrefetchCoins(const std::vector<COutPoint>& outpoints) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     //! @returns A pointer to the mempool.
     CTxMemPool* GetMempool()
     {
@@ -681,7 +898,8 @@ public:
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockValidationState& state, CBlockIndex** ppindex, bool fRequested, const FlatFilePos* dbp, bool* fNewBlock, bool min_pow_checked) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
-    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+    //! block_undo is the undo data of the block if it was read already, which is moved from
+    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CBlockUndo* block_undo = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
                       CCoinsViewCache& view, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -748,6 +966,12 @@ public:
 
     std::string ToString() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    //! @returns The conversion validity window for the current tip, building it on first use.
+    std::shared_ptr<const ConversionValidityWindow> GetConversionValidityWindow(int check_last_N_blocks, int percent_buffer) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
+    //! @returns The fee conversion window for the current tip, building it on first use.
+    std::shared_ptr<const FeeConversionWindow> GetFeeConversionWindow(int check_last_N_blocks) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
 private:
     bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
     bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
@@ -914,7 +1138,8 @@ public:
     RecursiveMutex& GetMutex() const LOCK_RETURNED(::cs_main) { return ::cs_main; }
 
     const Options m_options;
-    std::thread m_load_block;
+    //! The task importing blocks at startup, see node::ThreadImport()
+    std::future<void> m_load_block;
     //! A single BlockManager instance is shared across each constructed
     //! chainstate to avoid duplicating block metadata.
     node::BlockManager m_blockman;
@@ -950,6 +1175,10 @@ public:
     //! The total number of bytes available for us to use across all leveldb
     //! coins databases. This will be split somehow across chainstates.
     int64_t m_total_coinsdb_cache{0};
+    //
+    //! The number of bytes the coins caches and the mempool may use together
+    //! (see -maxmemory), or 0 if the coins caches keep their sizes.
+    int64_t m_memory_budget{0};
 
     //! Instantiate a new chainstate and assign it based upon whether it is
     //! from a snapshot.
@@ -1008,6 +1237,12 @@ public:
     //! Is there a snapshot in use and has it been fully validated?
     bool IsSnapshotValidated() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main) { return m_snapshot_validated; }
 
+    //! Is the chainstate the one validating the chain up to a snapshot in the background?
+    bool IsBackgroundChainstate(const Chainstate* chainstate) const EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
+        return chainstate && m_snapshot_chainstate && chainstate == m_ibd_chainstate.get() && !m_snapshot_validated;
+    }
+
     /**
      * Process an incoming block. This only returns after the best known valid
      * block is made active. Note that it does not, however, guarantee that the
@@ -1063,6 +1298,11 @@ public:
     //! ResizeCoinsCaches() as needed.
     void MaybeRebalanceCaches() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    //! With a memory budget and a single chainstate, grow the coins cache into
+    //! the part of the budget the mempool may not use while in initial block
+    //! download, and shrink it back to m_total_coinstip_cache at the tip.
+    void MaybeResizeToMemoryBudget() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     /** Update uncommitted block structures (currently: only the witness reserved value). This is safe for submitted blocks. */
     void UpdateUncommittedBlockStructures(CBlock& block, const CBlockIndex* pindexPrev) const;
 
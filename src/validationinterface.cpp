@@ -13,13 +13,31 @@
 #include <primitives/transaction.h>
 #include <scheduler.h>
 
+#include <algorithm>
+#include <deque>
 #include <future>
+#include <limits>
+#include <list>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 /**
  * MainSignalsImpl manages a list of shared_ptr<CValidationInterface> callbacks.
  *
+ * Events are appended to a log shared by all subscribers, and each subscriber
+ * processes the log in order from its own position, one event at a time, on
+ * the scheduler. Subscribers therefore see events in the order they were
+ * generated, while different subscribers run concurrently if the scheduler
+ * is serviced by several threads, so a slow subscriber doesn't delay the
+ * others. Events are dropped from the log once every subscriber processed
+ * them. A subscriber registering while events are pending starts at the
+ * oldest event not yet processed by every subscriber.
+ *
+ * Functions passed to CallFunctionInValidationInterfaceQueue are barriers in
+ * the log: every subscriber stops at them, and they are called once all
+ * earlier events have been processed, before any later one.
+ *
  * A std::unordered_map is used to track what callbacks are currently
  * registered, and a std::list is used to store the callbacks that are
  * currently registered as well as any callbacks that are just unregistered
@@ -28,29 +46,158 @@
 class MainSignalsImpl
 {
 private:
+    /** A logged event, calling either each subscriber or a barrier function */
+    struct Event {
+        std::function<void(CValidationInterface&)> callback;
+        std::function<void()> barrier;
+    };
+
+    struct Subscriber {
+        std::shared_ptr<CValidationInterface> callbacks;
+        //! Position in the log of the next event to process
+        uint64_t next;
+        //! Cleared when unregistered. Remaining events are then skipped.
+        bool registered{true};
+        //! Whether ProcessQueue is scheduled or running for this subscriber
+        bool scheduled{false};
+    };
+
+    CScheduler& m_scheduler;
+
     Mutex m_mutex;
-    //! List entries consist of a callback pointer and reference count. The
-    //! count is equal to the number of current executions of that entry, plus 1
-    //! if it's registered. It cannot be 0 because that would imply it is
-    //! unregistered and also not being executed (so shouldn't exist).
-    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; };
-    std::list<ListEntry> m_list GUARDED_BY(m_mutex);
-    std::unordered_map<CValidationInterface*, std::list<ListEntry>::iterator> m_map GUARDED_BY(m_mutex);
+    std::deque<std::shared_ptr<const Event>> m_events GUARDED_BY(m_mutex);
+    //! Position of the front of m_events in the log
+    uint64_t m_events_begin GUARDED_BY(m_mutex){0};
+    bool m_barrier_running GUARDED_BY(m_mutex){false};
+    std::list<std::shared_ptr<Subscriber>> m_list GUARDED_BY(m_mutex);
+    std::unordered_map<CValidationInterface*, std::shared_ptr<Subscriber>> m_map GUARDED_BY(m_mutex);
 
-public:
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
-    SingleThreadedSchedulerClient m_schedulerClient;
+    uint64_t EventsEnd() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_events_begin + m_events.size(); }
 
-    explicit MainSignalsImpl(CScheduler& scheduler LIFETIMEBOUND) : m_schedulerClient(scheduler) {}
+    bool AtBarrier(uint64_t pos) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        return pos < EventsEnd() && m_events[pos - m_events_begin]->barrier;
+    }
+
+    void Schedule(const std::shared_ptr<Subscriber>& sub) EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        if (sub->scheduled || sub->next == EventsEnd()) return;
+        sub->scheduled = true;
+        m_scheduler.schedule([this, sub] { ProcessQueue(sub); }, std::chrono::steady_clock::now());
+    }
+
+    //! Drop the events every subscriber has processed. Without subscribers,
+    //! events are dropped up to the first barrier, which still has to run.
+    void Trim() EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        uint64_t processed{std::numeric_limits<uint64_t>::max()};
+        for (const auto& sub : m_list) processed = std::min(processed, sub->next);
+        while (m_events_begin < processed && !m_events.empty()) {
+            if (m_list.empty() && m_events.front()->barrier) break;
+            m_events.pop_front();
+            ++m_events_begin;
+        }
+    }
+
+    //! Whether the barrier at the front of the log can run, which is when
+    //! every subscriber has stopped at it
+    bool BarrierReady() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        if (!AtBarrier(m_events_begin)) return false;
+        return std::all_of(m_list.begin(), m_list.end(), [&](const auto& sub) { return sub->next == m_events_begin; });
+    }
+
+    void MaybeRunBarrier() EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        if (m_barrier_running || !BarrierReady()) return;
+        m_barrier_running = true;
+        m_scheduler.schedule([this] { RunBarrier(); }, std::chrono::steady_clock::now());
+    }
+
+    //! Move every subscriber past the barrier that has run and resume them
+    void BarrierDone() EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        m_barrier_running = false;
+        m_events.pop_front();
+        ++m_events_begin;
+        for (const auto& sub : m_list) {
+            sub->next = std::max(sub->next, m_events_begin);
+        }
+        Trim();
+        MaybeRunBarrier();
+        for (const auto& sub : m_list) Schedule(sub);
+    }
+
+    void RunBarrier() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        const auto barrier{WITH_LOCK(m_mutex, return m_events.front())};
+        barrier->barrier();
+        LOCK(m_mutex);
+        BarrierDone();
+    }
+
+    //! Forget an unregistered subscriber that isn't running
+    void Remove(const std::shared_ptr<Subscriber>& sub) EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        m_list.remove(sub);
+        Trim();
+        MaybeRunBarrier();
+    }
+
+    void ProcessQueue(const std::shared_ptr<Subscriber>& sub) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::shared_ptr<const Event> event;
+        std::shared_ptr<CValidationInterface> callbacks;
+        {
+            LOCK(m_mutex);
+            if (!sub->registered) {
+                sub->scheduled = false;
+                Remove(sub);
+                return;
+            }
+            if (sub->next == EventsEnd() || AtBarrier(sub->next)) {
+                sub->scheduled = false;
+                MaybeRunBarrier();
+                return;
+            }
+            event = m_events[sub->next - m_events_begin];
+            callbacks = sub->callbacks;
+        }
+
+        // RAII the advancing of the subscriber to ensure it happens even if
+        // the callback throws.
+        struct RAIIAdvance {
+            MainSignalsImpl& impl;
+            const std::shared_ptr<Subscriber>& sub;
+            ~RAIIAdvance()
+            {
+                LOCK(impl.m_mutex);
+                ++sub->next;
+                impl.Trim();
+                sub->scheduled = false;
+                if (sub->registered) {
+                    impl.Schedule(sub);
+                } else {
+                    impl.Remove(sub);
+                }
+            }
+        } raii_advance{*this, sub};
+
+        event->callback(*callbacks);
+    }
+
+public:
+    explicit MainSignalsImpl(CScheduler& scheduler LIFETIMEBOUND) : m_scheduler(scheduler) {}
 
     void Register(std::shared_ptr<CValidationInterface> callbacks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
         LOCK(m_mutex);
-        auto inserted = m_map.emplace(callbacks.get(), m_list.end());
-        if (inserted.second) inserted.first->second = m_list.emplace(m_list.end());
+        auto inserted = m_map.emplace(callbacks.get(), nullptr);
+        if (inserted.second) {
+            inserted.first->second = m_list.emplace_back(std::make_shared<Subscriber>(Subscriber{.next = m_events_begin}));
+        }
         inserted.first->second->callbacks = std::move(callbacks);
+        Schedule(inserted.first->second);
     }
 
     void Unregister(CValidationInterface* callbacks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
@@ -58,7 +205,8 @@ public:
         LOCK(m_mutex);
         auto it = m_map.find(callbacks);
         if (it != m_map.end()) {
-            if (!--it->second->count) m_list.erase(it->second);
+            it->second->registered = false;
+            if (!it->second->scheduled) Remove(it->second);
             m_map.erase(it);
         }
     }
@@ -71,23 +219,90 @@ public:
     {
         LOCK(m_mutex);
         for (const auto& entry : m_map) {
-            if (!--entry.second->count) m_list.erase(entry.second);
+            entry.second->registered = false;
+            if (!entry.second->scheduled) Remove(entry.second);
         }
         m_map.clear();
     }
 
+    //! Call f on each registered subscriber immediately, on the calling thread
     template<typename F> void Iterate(F&& f) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
+        const auto subs{WITH_LOCK(m_mutex, return std::vector<std::shared_ptr<Subscriber>>(m_list.begin(), m_list.end()))};
+        for (const auto& sub : subs) {
+            const auto callbacks{WITH_LOCK(m_mutex, return sub->registered ? sub->callbacks : nullptr)};
+            if (callbacks) f(*callbacks);
+        }
+    }
+
+    //! Append an event calling f on each subscriber in the background
+    void Enqueue(std::function<void(CValidationInterface&)> f) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        m_events.push_back(std::make_shared<const Event>(Event{.callback = std::move(f)}));
+        Trim();
+        for (const auto& sub : m_list) Schedule(sub);
+    }
+
+    //! Append a barrier calling func once every earlier event is processed
+    void EnqueueBarrier(std::function<void()> func) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        m_events.push_back(std::make_shared<const Event>(Event{.barrier = std::move(func)}));
+        MaybeRunBarrier();
+        for (const auto& sub : m_list) Schedule(sub);
+    }
+
+    //! Process all remaining events on the calling thread. Must be called
+    //! after the scheduler has no remaining processing threads.
+    void EmptyQueue() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        assert(!m_scheduler.AreThreadsServicingQueue());
         WAIT_LOCK(m_mutex, lock);
-        for (auto it = m_list.begin(); it != m_list.end();) {
-            ++it->count;
+        while (true) {
+            for (auto it = m_list.begin(); it != m_list.end();) {
+                it = (*it)->registered ? std::next(it) : m_list.erase(it);
+            }
+            Trim();
+            if (BarrierReady()) {
+                const auto barrier{m_events.front()};
+                {
+                    REVERSE_LOCK(lock);
+                    barrier->barrier();
+                }
+                BarrierDone();
+                continue;
+            }
+            const auto it{std::find_if(m_list.begin(), m_list.end(), [&](const auto& sub) {
+                return sub->next < EventsEnd() && !AtBarrier(sub->next);
+            })};
+            if (it == m_list.end()) break;
+            const auto sub{*it};
+            const auto event{m_events[sub->next - m_events_begin]};
             {
                 REVERSE_LOCK(lock);
-                f(*it->callbacks);
+                event->callback(*sub->callbacks);
             }
-            it = --it->count ? std::next(it) : m_list.erase(it);
+            ++sub->next;
         }
     }
+
+    //! Number of events the slowest subscriber has yet to process
+    size_t CallbacksPending() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        uint64_t processed{EventsEnd()};
+        for (const auto& sub : m_list) processed = std::min(processed, sub->next);
+        return EventsEnd() - processed;
+    }
+
+    //! Number of events a subscriber has yet to process
+    size_t CallbacksPending(const CValidationInterface& callbacks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        auto it = m_map.find(const_cast<CValidationInterface*>(&callbacks));
+        return it == m_map.end() ? 0 : EventsEnd() - it->second->next;
+    }
 };
 
 static CMainSignals g_signals;
@@ -106,14 +321,20 @@ void CMainSignals::UnregisterBackgroundSignalScheduler()
 void CMainSignals::FlushBackgroundCallbacks()
 {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        m_internals->EmptyQueue();
     }
 }
 
 size_t CMainSignals::CallbacksPending()
 {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    return m_internals->CallbacksPending();
+}
+
+size_t CMainSignals::CallbacksPending(const CValidationInterface& callbacks)
+{
+    if (!m_internals) return 0;
+    return m_internals->CallbacksPending(callbacks);
 }
 
 CMainSignals& GetMainSignals()
@@ -157,7 +378,7 @@ void UnregisterAllValidationInterfaces()
 
 void CallFunctionInValidationInterfaceQueue(std::function<void()> func)
 {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->EnqueueBarrier(std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue()
@@ -175,14 +396,14 @@ void SyncWithValidationInterfaceQueue()
 // evaluating arguments when logging is not enabled.
 //
 // NOTE: The lambda captures all local variables by value.
-#define ENQUEUE_AND_LOG_EVENT(event, fmt, name, ...)           \
-    do {                                                       \
-        auto local_name = (name);                              \
-        LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);  \
-        m_internals->m_schedulerClient.AddToProcessQueue([=] { \
-            LOG_EVENT(fmt, local_name, __VA_ARGS__);           \
-            event();                                           \
-        });                                                    \
+#define ENQUEUE_AND_LOG_EVENT(event, fmt, name, ...)                         \
+    do {                                                                     \
+        auto local_name = (name);                                            \
+        LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);                \
+        m_internals->Enqueue([=](CValidationInterface& callbacks) {          \
+            LOG_EVENT(fmt, local_name, __VA_ARGS__);                         \
+            event(callbacks);                                                \
+        });                                                                  \
     } while (0)
 
 #define LOG_EVENT(fmt, ...) \
@@ -193,8 +414,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    auto event = [pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload); });
+    auto event = [pindexNew, pindexFork, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: new block hash=%s fork block hash=%s (in IBD=%s)", __func__,
                           pindexNew->GetBlockHash().ToString(),
@@ -203,8 +424,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) {
-    auto event = [tx, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionAddedToMempool(tx, mempool_sequence); });
+    auto event = [tx, mempool_sequence](CValidationInterface& callbacks) {
+        callbacks.TransactionAddedToMempool(tx, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s wtxid=%s", __func__,
                           tx->GetHash().ToString(),
@@ -212,8 +433,8 @@ void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t
 }
 
 void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) {
-    auto event = [tx, reason, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence); });
+    auto event = [tx, reason, mempool_sequence](CValidationInterface& callbacks) {
+        callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s wtxid=%s", __func__,
                           tx->GetHash().ToString(),
@@ -221,8 +442,8 @@ void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemP
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockConnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockConnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -231,8 +452,8 @@ void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, c
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
 {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockDisconnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -240,8 +461,8 @@ void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    auto event = [locator, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.ChainStateFlushed(locator); });
+    auto event = [locator](CValidationInterface& callbacks) {
+        callbacks.ChainStateFlushed(locator);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           locator.IsNull() ? "null" : locator.vHave.front().ToString());
@@ -40,7 +40,8 @@ void UnregisterSharedValidationInterface(std::shared_ptr<CValidationInterface> c
 
 /**
  * Pushes a function to callback onto the notification queue, guaranteeing any
- * callbacks generated prior to now are finished when the function is called.
+ * callbacks generated prior to now are finished when the function is called,
+ * and that no callbacks generated later start before it returns.
  *
  * Be very careful blocking on func to be called if any locks are held -
  * validation interface clients may not be able to make progress as they often
@@ -190,14 +191,21 @@ private:
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
 
 public:
-    /** Register a CScheduler to give callbacks which should run in the background (may only be called once) */
+    /**
+     * Register a CScheduler to give callbacks which should run in the background (may only be called once).
+     * Each subscriber receives callbacks in order, while different subscribers are called concurrently
+     * when the scheduler is serviced by several threads.
+     */
     void RegisterBackgroundSignalScheduler(CScheduler& scheduler);
     /** Unregister a CScheduler to give callbacks which should run in the background - these callbacks will now be dropped! */
     void UnregisterBackgroundSignalScheduler();
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** Number of callbacks the slowest subscriber has yet to process */
     size_t CallbacksPending();
+    /** Number of callbacks a subscriber has yet to process, or 0 if it is not registered */
+    size_t CallbacksPending(const CValidationInterface& callbacks);
 
 
     void UpdatedBlockTip(const CBlockIndex *, const CBlockIndex *, bool fInitialDownload);
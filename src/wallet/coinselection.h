@@ -66,6 +66,12 @@ public:
     /** The fee required to spend this output at the consolidation feerate. */
     CAmount long_term_fee{0};
 
+    /** Number of in-mempool ancestors of the transaction containing this output, including itself. 0 if it is confirmed. */
+    size_t ancestors{0};
+
+    /** Number of in-mempool descendants of the transaction containing this output, including itself. 0 if it is confirmed. */
+    size_t descendants{0};
+
     COutput(const COutPoint& outpoint, const CTxOut& txout, int depth, int input_bytes, bool spendable, bool solvable, bool safe, int64_t time, bool from_me, const std::optional<CFeeRate> feerate = std::nullopt)
         : outpoint{outpoint},
           txout{txout},
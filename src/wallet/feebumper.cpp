@@ -143,6 +143,56 @@ static CFeeRate EstimateFeeRate(const CWallet& wallet, const CWalletTx& wtx, con
     return std::max(normalizedfeerate, min_feerate);
 }
 
+/**
+ * Bump the fee of a conversion by moving value from its change output to its
+ * conversion output, leaving everything else as it is. Keeping the inputs, the
+ * conversion script and the other outputs means the transaction doesn't have
+ * to be built again through coin selection, and the conversion keeps its
+ * original deadline and converted amount. Returns false if the conversion has
+ * no change output that can cover the increase, in which case the transaction
+ * has to be re-created.
+ */
+static bool BumpConversionFromChange(const CWallet& wallet, const CWalletTx& wtx, const CCoinControl& coin_control, CAmountType fee_type,
+                                     CAmounts& new_fees, CMutableTransaction& mtx) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet)
+{
+    CMutableTransaction bumped{*wtx.tx};
+    std::optional<size_t> conversion_pos;
+    std::optional<size_t> change_pos;
+    for (size_t i = 0; i < bumped.vout.size(); ++i) {
+        const CTxOut& output = bumped.vout[i];
+        if (output.scriptPubKey.IsConversionScript()) {
+            conversion_pos = i;
+        } else if (output.amountType == fee_type && OutputIsChange(wallet, output)) {
+            change_pos = i;
+        }
+    }
+    if (!conversion_pos || !change_pos) return false;
+
+    // The dummy signer expects empty witnesses for external inputs
+    for (auto& txin : bumped.vin) {
+        txin.scriptSig.clear();
+        txin.scriptWitness.SetNull();
+    }
+    const int64_t vsize{CalculateMaximumSignedTxSize(CTransaction(bumped), &wallet, &coin_control).vsize};
+    if (vsize < 0) return false;
+
+    const CAmount normalized_fee{GetMinimumFeeRate(wallet, coin_control, /*feeCalc=*/nullptr).GetFee(vsize)};
+    if (normalized_fee > wallet.GetDefaultMaxTxFee()) return false;
+    const CAmount new_fee{fee_type == CASH ? normalized_fee : wallet.chain().estimateConvertedAmount(normalized_fee, CASH, /*roundedUp=*/true)};
+    const CAmount fee_increase{new_fee - bumped.vout[*conversion_pos].nValue};
+    if (fee_increase <= 0) return false;
+
+    CTxOut& change{bumped.vout[*change_pos]};
+    change.nValue -= fee_increase;
+    if (change.nValue <= 0 || IsDust(change, wallet.chain().relayDustFee())) return false;
+    bumped.vout[*conversion_pos].nValue = new_fee;
+
+    new_fees[fee_type] = new_fee;
+    new_fees[!fee_type] = 0;
+    mtx = std::move(bumped);
+    return true;
+}
+
 namespace feebumper {
 
 bool TransactionCanBeBumped(const CWallet& wallet, const uint256& txid)
@@ -290,6 +340,12 @@ Result CreateRateBumpTransaction(CWallet& wallet, const uint256& txid, const CCo
         new_coin_control.m_feerate = EstimateFeeRate(wallet, wtx, old_fees, new_coin_control);
     }
 
+    // Conversions whose change can pay the higher fee are bumped in place
+    if (isConversion && new_coin_control.m_fee_type == conversionFeeType &&
+        BumpConversionFromChange(wallet, wtx, new_coin_control, conversionFeeType, new_fees, mtx)) {
+        return Result::OK;
+    }
+
     // Fill in required inputs we are double-spending(all of them)
     // N.B.: bip125 doesn't require all the inputs in the replaced transaction to be
     // used in the replacement transaction, but it's very important for wallets to make
@@ -88,9 +88,10 @@ void WalletInit::AddWalletOptions(ArgsManager& argsman) const
 #endif
 
 #ifdef USE_SQLITE
+    argsman.AddArg("-sqlitewal", strprintf("Use SQLite's write-ahead log for wallet databases, which makes each write transaction cheaper to commit (default: %u)", DatabaseOptions().use_wal), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-unsafesqlitesync", "Set SQLite synchronous=OFF to disable waiting for the database to sync to disk. This is unsafe and can cause data loss and corruption. This option is only used by tests to improve their performance (default: false)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::WALLET_DEBUG_TEST);
 #else
-    argsman.AddHiddenArgs({"-unsafesqlitesync"});
+    argsman.AddHiddenArgs({"-sqlitewal", "-unsafesqlitesync"});
 #endif
 
     argsman.AddArg("-walletrejectlongchains", strprintf("Wallet will not create transactions that violate mempool chain limits (default: %u)", DEFAULT_WALLET_REJECT_LONG_CHAINS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::WALLET_DEBUG_TEST);
@@ -156,6 +156,11 @@ public:
     void abortRescan() override { m_wallet->AbortRescan(); }
     bool backupWallet(const std::string& filename) override { return m_wallet->BackupWallet(filename); }
     std::string getWalletName() override { return m_wallet->GetName(); }
+    size_t getMemoryUsage() override
+    {
+        LOCK(m_wallet->cs_wallet);
+        return m_wallet->DynamicMemoryUsage();
+    }
     util::Result<CTxDestination> getNewDestination(const OutputType type, const std::string& label) override
     {
         LOCK(m_wallet->cs_wallet);
@@ -293,6 +298,24 @@ public:
 
         return txr.tx;
     }
+    util::Result<std::vector<CTransactionRef>> createConversionTransactions(const std::vector<WalletConversionTxDetails>& txs_details,
+        const CCoinControl& coin_control,
+        bool sign,
+        std::vector<CAmount>& fees,
+        std::vector<CAmountType>& feeTypes) override
+    {
+        auto res = CreateConversionTransactions(*m_wallet, txs_details, coin_control, sign);
+        if (!res) return util::Error{util::ErrorString(res)};
+        std::vector<CTransactionRef> txs;
+        fees.clear();
+        feeTypes.clear();
+        for (const auto& txr : *res) {
+            txs.push_back(txr.tx);
+            fees.push_back(txr.fee);
+            feeTypes.push_back(txr.feeType);
+        }
+        return txs;
+    }
     void commitTransaction(CTransactionRef tx,
         WalletValueMap value_map,
         WalletOrderForm order_form) override
@@ -355,6 +378,16 @@ public:
         }
         return result;
     }
+    std::vector<uint256> getWalletTxHashes() override
+    {
+        LOCK(m_wallet->cs_wallet);
+        std::vector<uint256> result;
+        result.reserve(m_wallet->wtxOrdered.size());
+        for (const auto& [_, wtx] : m_wallet->wtxOrdered) {
+            result.push_back(wtx->GetHash());
+        }
+        return result;
+    }
     bool tryGetTxStatus(const uint256& txid,
         interfaces::WalletTxStatus& tx_status,
         int& num_blocks,
@@ -376,12 +376,13 @@ bool CachedTxIsTrusted(const CWallet& wallet, const CWalletTx& wtx)
     return CachedTxIsTrusted(wallet, wtx, trusted_parents);
 }
 
-Balance GetBalance(const CWallet& wallet, bool amountType, const int min_depth, bool avoid_reuse)
+Balance GetBalance(const CWallet& wallet, CAmountType amountType, const int min_depth, bool avoid_reuse)
 {
     Balance ret;
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
     {
         LOCK(wallet.cs_wallet);
+        if (auto cached{wallet.GetCachedBalance(amountType, min_depth, avoid_reuse)}) return *cached;
         std::set<uint256> trusted_parents;
         for (const auto& entry : wallet.mapWallet)
         {
@@ -401,6 +402,7 @@ Balance GetBalance(const CWallet& wallet, bool amountType, const int min_depth,
             ret.m_mine_immature += CachedTxGetImmatureCredit(wallet, wtx, amountType, ISMINE_SPENDABLE);
             ret.m_watchonly_immature += CachedTxGetImmatureCredit(wallet, wtx, amountType, ISMINE_WATCH_ONLY);
         }
+        wallet.SetCachedBalance(amountType, min_depth, avoid_reuse, ret);
     }
     return ret;
 }
@@ -434,6 +434,127 @@ RPCHelpMan sendmany()
     };
 }
 
+RPCHelpMan createconversions()
+{
+    return RPCHelpMan{"createconversions",
+                "\nCreate a batch of conversion transactions in one pass. The conversions share one fee estimate\n"
+                "and one scan of the wallet's coins, and no two conversions spend the same coin.\n"
+                "Each conversion pays its fee in its input type. If any conversion cannot be created, none are." +
+        HELP_REQUIRING_PASSPHRASE,
+                {
+                    {"conversions", RPCArg::Type::ARR, RPCArg::Optional::NO, "The conversions to create",
+                        {
+                            {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                                {
+                                    {"input_type", RPCArg::Type::STR, RPCArg::Optional::NO, "The type of amount to convert from ('cash' or 'bond')."},
+                                    {"max_input", RPCArg::Type::AMOUNT, RPCArg::Optional::NO, "The maximum amount to convert, in " + CURRENCY_UNIT + "."},
+                                    {"min_output", RPCArg::Type::AMOUNT, RPCArg::Optional::NO, "The minimum amount to receive of the other type, in " + CURRENCY_UNIT + "."},
+                                    {"remainder_type", RPCArg::Type::STR, RPCArg::DefaultHint{"the output type"}, "The type of amount in which the wallet receives any remainder."},
+                                },
+                            },
+                        },
+                    },
+                    {"is_scaled_amount", RPCArg::Type::BOOL, RPCArg::Default{true}, "True if the amounts are scaled (false if they are unscaled cash or bonds)."},
+                    {"conf_target", RPCArg::Type::NUM, RPCArg::DefaultHint{"wallet -txconfirmtarget"}, "Confirmation target in blocks"},
+                    {"estimate_mode", RPCArg::Type::STR, RPCArg::Default{"unset"}, "The fee estimate mode, must be one of (case insensitive):\n"
+                     "\"" + FeeModes("\"\n\"") + "\""},
+                    {"fee_rate", RPCArg::Type::AMOUNT, RPCArg::DefaultHint{"not set, fall back to wallet fee estimation"}, "Specify a fee rate in " + CURRENCY_ATOM + "/vB."},
+                    {"is_scaled_fee_rate", RPCArg::Type::BOOL, RPCArg::Default{false}, "True if fee rate is a scaled amount."},
+                    {"deadline", RPCArg::Type::NUM, RPCArg::DefaultHint{"wallet -conversiondeadline"}, "Number of blocks after which the conversions expire (0 for no deadline)."},
+                    {"add_to_wallet", RPCArg::Type::BOOL, RPCArg::Default{true}, "When false, returns the serialized transactions without adding them to the wallet or broadcasting them."},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                            {RPCResult::Type::STR_HEX, "hex", /*optional=*/true, "If add_to_wallet is false, the hex-encoded raw transaction with signature(s)"},
+                            {RPCResult::Type::STR_AMOUNT, "fee", "The fee paid (unscaled)"},
+                            {RPCResult::Type::STR, "fee_type", "The type of amount the fee is paid in"},
+                        }},
+                    }
+                },
+                RPCExamples{
+            "\nConvert 0.1 cash to at least 0.09 bonds and 0.2 bonds to at least 0.18 cash:\n"
+            + HelpExampleCli("createconversions", "\"[{\\\"input_type\\\":\\\"cash\\\",\\\"max_input\\\":0.1,\\\"min_output\\\":0.09},{\\\"input_type\\\":\\\"bond\\\",\\\"max_input\\\":0.2,\\\"min_output\\\":0.18}]\"") +
+            "\nAs a JSON-RPC call\n"
+            + HelpExampleRpc("createconversions", "[{\"input_type\":\"cash\",\"max_input\":0.1,\"min_output\":0.09},{\"input_type\":\"bond\",\"max_input\":0.2,\"min_output\":0.18}]")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::shared_ptr<CWallet> const pwallet = GetWalletForJSONRPCRequest(request);
+    if (!pwallet) return UniValue::VNULL;
+
+    // Make sure the results are valid at least up to the most recent block
+    // the user could have gotten from another RPC command prior to now
+    pwallet->BlockUntilSyncedToCurrentChain();
+
+    if (pwallet->IsWalletFlagSet(WALLET_FLAG_DISABLE_PRIVATE_KEYS)) {
+        throw JSONRPCError(RPC_WALLET_ERROR, "Error: Private keys are disabled for this wallet");
+    }
+
+    LOCK(pwallet->cs_wallet);
+    EnsureWalletIsUnlocked(*pwallet);
+
+    bool scaledAmounts = true;
+    if (!request.params[1].isNull()) {
+        scaledAmounts = request.params[1].get_bool();
+    }
+    // Descale amounts using latest scale factor, unless amounts are unscaled
+    const CAmountScaleFactor scaleFactor = scaledAmounts ? pwallet->chain().getLastScaleFactor() : BASE_FACTOR;
+
+    std::vector<WalletConversionTxDetails> txs_details;
+    for (const UniValue& conversion : request.params[0].get_array().getValues()) {
+        RPCTypeCheckObj(conversion,
+            {
+                {"input_type", UniValueType(UniValue::VSTR)},
+                {"max_input", UniValueType()}, // will be checked by AmountFromValue()
+                {"min_output", UniValueType()}, // will be checked by AmountFromValue()
+                {"remainder_type", UniValueType(UniValue::VSTR)},
+            },
+            /*fAllowNull=*/true, /*fStrict=*/true);
+        const CAmountType inputType = AmountTypeFromValue(find_value(conversion, "input_type"));
+        const CAmountType outputType = inputType == CASH ? BOND : CASH;
+        const CAmountType remainderType = conversion.exists("remainder_type") ? AmountTypeFromValue(find_value(conversion, "remainder_type")) : outputType;
+        const CAmount maxInput = DescaleAmount(AmountFromValue(find_value(conversion, "max_input")), scaleFactor);
+        const CAmount minOutput = DescaleAmount(AmountFromValue(find_value(conversion, "min_output")), scaleFactor);
+        txs_details.push_back({maxInput, minOutput, inputType, outputType, remainderType, /*fSubtractFeeFromInput=*/false});
+    }
+    if (txs_details.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, conversions are empty");
+    }
+
+    CCoinControl coin_control;
+    SetFeeEstimateMode(*pwallet, coin_control, /*conf_target=*/request.params[2], /*estimate_mode=*/request.params[3], /*fee_rate=*/request.params[4], /*is_scaled_fee_rate=*/request.params[5], /*override_min_fee=*/false);
+    if (!request.params[6].isNull()) {
+        coin_control.m_conversion_deadline = request.params[6].getInt<unsigned int>();
+    }
+    const bool add_to_wallet{request.params[7].isNull() ? true : request.params[7].get_bool()};
+
+    auto res = CreateConversionTransactions(*pwallet, txs_details, coin_control, /*sign=*/true);
+    if (!res) {
+        throw JSONRPCError(RPC_WALLET_INSUFFICIENT_FUNDS, util::ErrorString(res).original);
+    }
+
+    UniValue result(UniValue::VARR);
+    for (const auto& txr : *res) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("txid", txr.tx->GetHash().GetHex());
+        if (add_to_wallet) {
+            pwallet->CommitTransaction(txr.tx, {}, {} /* orderForm */);
+        } else {
+            entry.pushKV("hex", EncodeHexTx(*txr.tx));
+        }
+        entry.pushKV("fee", ValueFromAmount(txr.fee));
+        entry.pushKV("fee_type", ValueFromAmountType(txr.feeType));
+        result.push_back(entry);
+    }
+    return result;
+},
+    };
+}
+
 RPCHelpMan settxfee()
 {
     return RPCHelpMan{"settxfee",
@@ -325,6 +325,7 @@ static void MaybePushAddress(UniValue & entry, const CTxDestination &dest)
  *
  * @param  wallet         The wallet.
  * @param  wtx            The wallet transaction.
+ * @param  scaleFactor    The scale factor of the transaction, from CWallet::GetBestScaleFactor.
  * @param  nMinDepth      The minimum confirmation depth.
  * @param  fLong          Whether to include the JSON version of the transaction.
  * @param  ret            The vector into which the result is stored.
@@ -332,7 +333,7 @@ static void MaybePushAddress(UniValue & entry, const CTxDestination &dest)
  * @param  filter_label   Optional label string to filter incoming transactions.
  */
 template <class Vec>
-static void ListTransactions(const CWallet& wallet, const CWalletTx& wtx, int nMinDepth, bool fLong,
+static void ListTransactions(const CWallet& wallet, const CWalletTx& wtx, const CAmountScaleFactor& scaleFactor, int nMinDepth, bool fLong,
                              Vec& ret, const isminefilter& filter_ismine, const std::string* filter_label,
                              bool include_change = false)
     EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet)
@@ -346,8 +347,6 @@ static void ListTransactions(const CWallet& wallet, const CWalletTx& wtx, int nM
 
     bool involvesWatchonly = CachedTxIsFromMe(wallet, wtx, ISMINE_WATCH_ONLY);
 
-    const CAmountScaleFactor scaleFactor = wallet.GetBestScaleFactor(wtx);
-
     // Converted
     for (const COutputEntry& c : listConverted)
     {
@@ -585,12 +584,21 @@ RPCHelpMan listtransactions()
 
         const CWallet::TxItems & txOrdered = pwallet->wtxOrdered;
 
-        // iterate backwards until we have nCount items to return:
-        for (CWallet::TxItems::const_reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it)
-        {
-            CWalletTx *const pwtx = (*it).second;
-            ListTransactions(*pwallet, *pwtx, 0, true, ret, filter, filter_label);
-            if ((int)ret.size() >= (nCount+nFrom)) break;
+        // iterate backwards until we have nCount items to return, looking up
+        // the scale factors of a batch of transactions at a time:
+        CWallet::TxItems::const_reverse_iterator it = txOrdered.rbegin();
+        while (it != txOrdered.rend() && (int)ret.size() < (nCount+nFrom)) {
+            // Each transaction gives at least one item, unless filtered out
+            const size_t batch_size = std::max<size_t>(nCount + nFrom - ret.size(), 100);
+            std::vector<const CWalletTx*> batch;
+            for (; it != txOrdered.rend() && batch.size() < batch_size; ++it) {
+                batch.push_back((*it).second);
+            }
+            const std::vector<CAmountScaleFactor> scaleFactors = pwallet->GetBestScaleFactors(batch);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                ListTransactions(*pwallet, *batch[i], scaleFactors[i], 0, true, ret, filter, filter_label);
+                if ((int)ret.size() >= (nCount+nFrom)) break;
+            }
         }
     }
 
@@ -714,13 +722,18 @@ RPCHelpMan listsinceblock()
 
     UniValue transactions(UniValue::VARR);
 
+    std::vector<const CWalletTx*> wtxs;
     for (const std::pair<const uint256, CWalletTx>& pairWtx : wallet.mapWallet) {
         const CWalletTx& tx = pairWtx.second;
 
         if (depth == -1 || abs(wallet.GetTxDepthInMainChain(tx)) < depth) {
-            ListTransactions(wallet, tx, 0, true, transactions, filter, nullptr /* filter_label */, /*include_change=*/include_change);
+            wtxs.push_back(&tx);
         }
     }
+    const std::vector<CAmountScaleFactor> scaleFactors = wallet.GetBestScaleFactors(wtxs);
+    for (size_t i = 0; i < wtxs.size(); ++i) {
+        ListTransactions(wallet, *wtxs[i], scaleFactors[i], 0, true, transactions, filter, nullptr /* filter_label */, /*include_change=*/include_change);
+    }
 
     // when a reorg'd block is requested, we also list any relevant transactions
     // in the blocks of the chain that was detached
@@ -730,14 +743,19 @@ RPCHelpMan listsinceblock()
         if (!wallet.chain().findBlock(blockId, FoundBlock().data(block)) || block.IsNull()) {
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
         }
+        std::vector<const CWalletTx*> block_wtxs;
         for (const CTransactionRef& tx : block.vtx) {
             auto it = wallet.mapWallet.find(tx->GetHash());
             if (it != wallet.mapWallet.end()) {
-                // We want all transactions regardless of confirmation count to appear here,
-                // even negative confirmation ones, hence the big negative.
-                ListTransactions(wallet, it->second, -100000000, true, removed, filter, nullptr /* filter_label */, /*include_change=*/include_change);
+                block_wtxs.push_back(&it->second);
             }
         }
+        const std::vector<CAmountScaleFactor> block_scale_factors = wallet.GetBestScaleFactors(block_wtxs);
+        for (size_t i = 0; i < block_wtxs.size(); ++i) {
+            // We want all transactions regardless of confirmation count to appear here,
+            // even negative confirmation ones, hence the big negative.
+            ListTransactions(wallet, *block_wtxs[i], block_scale_factors[i], -100000000, true, removed, filter, nullptr /* filter_label */, /*include_change=*/include_change);
+        }
         blockId = block.hashPrevBlock;
         --*altheight;
     }
@@ -892,7 +910,7 @@ RPCHelpMan gettransaction()
     WalletTxToJSON(*pwallet, wtx, entry);
 
     UniValue details(UniValue::VARR);
-    ListTransactions(*pwallet, wtx, 0, false, details, filter, nullptr /* filter_label */);
+    ListTransactions(*pwallet, wtx, scaleFactor, 0, false, details, filter, nullptr /* filter_label */);
     entry.pushKV("details", details);
 
     std::string strHex = EncodeHexTx(*wtx.tx, pwallet->chain().rpcSerializationFlags());
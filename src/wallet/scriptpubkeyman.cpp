@@ -11,16 +11,52 @@
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/translation.h>
 #include <wallet/scriptpubkeyman.h>
 
+#include <algorithm>
 #include <optional>
 
 namespace wallet {
 //! Value for the first BIP 32 hardened derivation. Can be used as a bit mask and as a value. See BIP 32 for more details.
 const uint32_t BIP32_HARDENED_KEY_LIMIT = 0x80000000;
 
+namespace {
+//! Number of descriptor range indexes derived together before they are added to the wallet
+constexpr int32_t TOPUP_DERIVE_BATCH_SIZE{1000};
+//! Batches of fewer indexes than this are derived on the calling thread only
+constexpr size_t MIN_PARALLEL_DERIVE_SIZE{64};
+//! Maximum number of threads deriving a batch
+constexpr unsigned int MAX_DERIVE_THREADS{8};
+
+/** The scripts, keys and new cache items derived for one descriptor range index */
+struct DerivedRangeIndex {
+    std::vector<CScript> scripts;
+    FlatSigningProvider keys;
+    DescriptorCache cache;
+    bool ok{false};
+};
+
+/**
+ * Expand a descriptor at the range indexes start .. start + derived.size() - 1,
+ * on tasks of the shared thread pool for large batches. Each index is expanded from the cache
+ * if possible and, if a provider is given, derived using it otherwise. Neither
+ * is modified.
+ */
+void DeriveRange(const Descriptor& descriptor, const DescriptorCache& cache, const SigningProvider* provider, int32_t start, std::vector<DerivedRangeIndex>& derived)
+{
+    const size_t num_threads{derived.size() < MIN_PARALLEL_DERIVE_SIZE ? 1 : MAX_DERIVE_THREADS};
+    util::ParallelFor("derive", util::TaskPriority::NORMAL, derived.size(), num_threads, [&](size_t i) {
+        DerivedRangeIndex& index = derived[i];
+        const int pos{start + static_cast<int>(i)};
+        index.ok = descriptor.ExpandFromCache(pos, cache, index.scripts, index.keys) ||
+                   (provider && descriptor.Expand(pos, *provider, index.scripts, index.keys, &index.cache));
+    });
+}
+} // namespace
+
 util::Result<CTxDestination> LegacyScriptPubKeyMan::GetNewDestination(const OutputType type)
 {
     if (LEGACY_OUTPUT_TYPES.count(type) == 0) {
@@ -1753,7 +1789,12 @@ std::optional<MigrationData> LegacyScriptPubKeyMan::MigrateToDescriptor()
     }
 
     // keyids is now all non-HD keys. Each key will have its own combo descriptor
+    WalletLogPrintf("Migrating %u non-HD keys and %u scripts to descriptors\n", keyids.size(), spks.size());
+    size_t keys_done{0};
     for (const CKeyID& keyid : keyids) {
+        if (++keys_done % 10000 == 0) {
+            WalletLogPrintf("Migrated %u of %u non-HD keys\n", keys_done, keyids.size());
+        }
         CKey key;
         if (!GetKey(keyid, key)) {
             assert(false);
@@ -2138,37 +2179,55 @@ bool DescriptorScriptPubKeyMan::TopUp(unsigned int size)
     provider.keys = GetKeys();
 
     WalletBatch batch(m_storage.GetDatabase());
+    // Write the whole top-up in one database transaction rather than committing
+    // every cache item on its own. If the caller already has a transaction open,
+    // the writes become part of it instead.
+    const bool began_txn{new_range_end > m_max_cached_index + 1 && batch.TxnBegin()};
     uint256 id = GetID();
-    for (int32_t i = m_max_cached_index + 1; i < new_range_end; ++i) {
-        FlatSigningProvider out_keys;
-        std::vector<CScript> scripts_temp;
-        DescriptorCache temp_cache;
-        // Maybe we have a cached xpub and we can expand from the cache first
-        if (!m_wallet_descriptor.descriptor->ExpandFromCache(i, m_wallet_descriptor.cache, scripts_temp, out_keys)) {
-            if (!m_wallet_descriptor.descriptor->Expand(i, provider, scripts_temp, out_keys, &temp_cache)) return false;
-        }
-        // Add all of the scriptPubKeys to the scriptPubKey set
-        for (const CScript& script : scripts_temp) {
-            m_map_script_pub_keys[script] = i;
-        }
-        for (const auto& pk_pair : out_keys.pubkeys) {
-            const CPubKey& pubkey = pk_pair.second;
-            if (m_map_pubkeys.count(pubkey) != 0) {
-                // We don't need to give an error here.
-                // It doesn't matter which of many valid indexes the pubkey has, we just need an index where we can derive it and it's private key
-                continue;
+    const int32_t first_index{m_max_cached_index + 1};
+    std::vector<DerivedRangeIndex> derived;
+    for (int32_t start = first_index; start < new_range_end; start = m_max_cached_index + 1) {
+        // The first index is derived on its own. The xpubs it adds to the cache
+        // let the indexes after it be expanded from the cache, which is much
+        // cheaper than deriving each of them from the root again.
+        const int32_t count{start == first_index ? 1 : std::min(TOPUP_DERIVE_BATCH_SIZE, new_range_end - start)};
+        derived.clear();
+        derived.resize(count);
+        DeriveRange(*m_wallet_descriptor.descriptor, m_wallet_descriptor.cache, &provider, start, derived);
+
+        for (int32_t i = start; i < start + count; ++i) {
+            const DerivedRangeIndex& index = derived[i - start];
+            if (!index.ok) {
+                // Keep the items cached so far, as they are already in memory
+                if (began_txn) batch.TxnCommit();
+                return false;
             }
-            m_map_pubkeys[pubkey] = i;
-        }
-        // Merge and write the cache
-        DescriptorCache new_items = m_wallet_descriptor.cache.MergeAndDiff(temp_cache);
-        if (!batch.WriteDescriptorCacheItems(id, new_items)) {
-            throw std::runtime_error(std::string(__func__) + ": writing cache items failed");
+            // Add all of the scriptPubKeys to the scriptPubKey set
+            for (const CScript& script : index.scripts) {
+                m_map_script_pub_keys[script] = i;
+            }
+            for (const auto& pk_pair : index.keys.pubkeys) {
+                const CPubKey& pubkey = pk_pair.second;
+                if (m_map_pubkeys.count(pubkey) != 0) {
+                    // We don't need to give an error here.
+                    // It doesn't matter which of many valid indexes the pubkey has, we just need an index where we can derive it and it's private key
+                    continue;
+                }
+                m_map_pubkeys[pubkey] = i;
+            }
+            // Merge and write the cache
+            DescriptorCache new_items = m_wallet_descriptor.cache.MergeAndDiff(index.cache);
+            if (!batch.WriteDescriptorCacheItems(id, new_items)) {
+                throw std::runtime_error(std::string(__func__) + ": writing cache items failed");
+            }
+            m_max_cached_index++;
         }
-        m_max_cached_index++;
     }
     m_wallet_descriptor.range_end = new_range_end;
     batch.WriteDescriptor(GetID(), m_wallet_descriptor);
+    if (began_txn && !batch.TxnCommit()) {
+        throw std::runtime_error(std::string(__func__) + ": committing cache items failed");
+    }
 
     // By this point, the cache size should be the size of the entire range
     assert(m_wallet_descriptor.range_end - 1 == m_max_cached_index);
@@ -2465,6 +2524,9 @@ TransactionError DescriptorScriptPubKeyMan::FillPSBT(PartiallySignedTransaction&
     if (n_signed) {
         *n_signed = 0;
     }
+    // The keys for each input are looked up here, as that needs the wallet lock held by the
+    // caller, and the inputs are then signed with them on several threads.
+    std::vector<std::unique_ptr<FlatSigningProvider>> input_keys(psbtx.tx->vin.size());
     for (unsigned int i = 0; i < psbtx.tx->vin.size(); ++i) {
         const CTxIn& txin = psbtx.tx->vin[i];
         PSBTInput& input = psbtx.inputs.at(i);
@@ -2491,9 +2553,6 @@ TransactionError DescriptorScriptPubKeyMan::FillPSBT(PartiallySignedTransaction&
             // There's no UTXO so we can just skip this now
             continue;
         }
-        SignatureData sigdata;
-        input.FillSignatureData(sigdata);
-
         std::unique_ptr<FlatSigningProvider> keys = std::make_unique<FlatSigningProvider>();
         std::unique_ptr<FlatSigningProvider> script_keys = GetSigningProvider(script, sign);
         if (script_keys) {
@@ -2536,9 +2595,17 @@ TransactionError DescriptorScriptPubKeyMan::FillPSBT(PartiallySignedTransaction&
             }
         }
 
-        SignPSBTInput(HidingSigningProvider(keys.get(), !sign, !bip32derivs), psbtx, i, &txdata, sighash_type, nullptr, finalize);
+        input_keys[i] = std::move(keys);
+    }
+
+    ForEachPSBTInput(psbtx, [&](unsigned int i) {
+        if (!input_keys[i]) return;
+        SignPSBTInput(HidingSigningProvider(input_keys[i].get(), !sign, !bip32derivs), psbtx, i, &txdata, sighash_type, nullptr, finalize);
+    });
 
-        bool signed_one = PSBTInputSigned(input);
+    for (unsigned int i = 0; i < psbtx.tx->vin.size(); ++i) {
+        if (!input_keys[i]) continue;
+        bool signed_one = PSBTInputSigned(psbtx.inputs.at(i));
         if (n_signed && (signed_one || !sign)) {
             // If sign is false, we assume that we _could_ sign if we get here. This
             // will never have false negatives; it is hard to tell under what i
@@ -2590,29 +2657,35 @@ void DescriptorScriptPubKeyMan::SetCache(const DescriptorCache& cache)
 {
     LOCK(cs_desc_man);
     m_wallet_descriptor.cache = cache;
-    for (int32_t i = m_wallet_descriptor.range_start; i < m_wallet_descriptor.range_end; ++i) {
-        FlatSigningProvider out_keys;
-        std::vector<CScript> scripts_temp;
-        if (!m_wallet_descriptor.descriptor->ExpandFromCache(i, m_wallet_descriptor.cache, scripts_temp, out_keys)) {
-            throw std::runtime_error("Error: Unable to expand wallet descriptor from cache");
-        }
-        // Add all of the scriptPubKeys to the scriptPubKey set
-        for (const CScript& script : scripts_temp) {
-            if (m_map_script_pub_keys.count(script) != 0) {
-                throw std::runtime_error(strprintf("Error: Already loaded script at index %d as being at index %d", i, m_map_script_pub_keys[script]));
+    std::vector<DerivedRangeIndex> derived;
+    for (int32_t start = m_wallet_descriptor.range_start; start < m_wallet_descriptor.range_end; start += TOPUP_DERIVE_BATCH_SIZE) {
+        derived.clear();
+        derived.resize(std::min(TOPUP_DERIVE_BATCH_SIZE, m_wallet_descriptor.range_end - start));
+        DeriveRange(*m_wallet_descriptor.descriptor, m_wallet_descriptor.cache, /*provider=*/nullptr, start, derived);
+
+        for (int32_t i = start; i < start + (int32_t)derived.size(); ++i) {
+            const DerivedRangeIndex& index = derived[i - start];
+            if (!index.ok) {
+                throw std::runtime_error("Error: Unable to expand wallet descriptor from cache");
             }
-            m_map_script_pub_keys[script] = i;
-        }
-        for (const auto& pk_pair : out_keys.pubkeys) {
-            const CPubKey& pubkey = pk_pair.second;
-            if (m_map_pubkeys.count(pubkey) != 0) {
-                // We don't need to give an error here.
-                // It doesn't matter which of many valid indexes the pubkey has, we just need an index where we can derive it and it's private key
-                continue;
+            // Add all of the scriptPubKeys to the scriptPubKey set
+            for (const CScript& script : index.scripts) {
+                if (m_map_script_pub_keys.count(script) != 0) {
+                    throw std::runtime_error(strprintf("Error: Already loaded script at index %d as being at index %d", i, m_map_script_pub_keys[script]));
+                }
+                m_map_script_pub_keys[script] = i;
+            }
+            for (const auto& pk_pair : index.keys.pubkeys) {
+                const CPubKey& pubkey = pk_pair.second;
+                if (m_map_pubkeys.count(pubkey) != 0) {
+                    // We don't need to give an error here.
+                    // It doesn't matter which of many valid indexes the pubkey has, we just need an index where we can derive it and it's private key
+                    continue;
+                }
+                m_map_pubkeys[pubkey] = i;
             }
-            m_map_pubkeys[pubkey] = i;
+            m_max_cached_index++;
         }
-        m_max_cached_index++;
     }
 }
 
@@ -2655,17 +2728,28 @@ const WalletDescriptor DescriptorScriptPubKeyMan::GetWalletDescriptor() const
 }
 
 const std::unordered_set<CScript, SaltedSipHasher> DescriptorScriptPubKeyMan::GetScriptPubKeys() const
+{
+    return GetScriptPubKeys(0);
+}
+
+const std::unordered_set<CScript, SaltedSipHasher> DescriptorScriptPubKeyMan::GetScriptPubKeys(int32_t minimum_index) const
 {
     LOCK(cs_desc_man);
     std::unordered_set<CScript, SaltedSipHasher> script_pub_keys;
     script_pub_keys.reserve(m_map_script_pub_keys.size());
 
-    for (auto const& script_pub_key: m_map_script_pub_keys) {
-        script_pub_keys.insert(script_pub_key.first);
+    for (auto const& [script_pub_key, index] : m_map_script_pub_keys) {
+        if (index >= minimum_index) script_pub_keys.insert(script_pub_key);
     }
     return script_pub_keys;
 }
 
+int32_t DescriptorScriptPubKeyMan::GetEndRange() const
+{
+    LOCK(cs_desc_man);
+    return m_max_cached_index + 1;
+}
+
 bool DescriptorScriptPubKeyMan::GetDescriptorString(std::string& out, const bool priv) const
 {
     LOCK(cs_desc_man);
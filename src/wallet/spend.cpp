@@ -159,7 +159,8 @@ CoinsResult AvailableCoins(const CWallet& wallet,
                            const CAmount& nMaximumAmount,
                            const CAmount& nMinimumSumAmount,
                            const uint64_t nMaximumCount,
-                           bool only_spendable)
+                           bool only_spendable,
+                           std::optional<CAmountType> amount_type)
 {
     AssertLockHeld(wallet.cs_wallet);
 
@@ -172,24 +173,27 @@ CoinsResult AvailableCoins(const CWallet& wallet,
     const bool only_safe = {coinControl ? !coinControl->m_include_unsafe_inputs : true};
 
     std::set<uint256> trusted_parents;
-    for (const auto& entry : wallet.mapWallet)
-    {
-        const uint256& wtxid = entry.first;
-        const CWalletTx& wtx = entry.second;
-
+    // Checks on the transaction that are shared by all of its outputs. Sets the depth,
+    // safety and origin of the transaction, and returns whether its outputs are eligible.
+    int nDepth{0};
+    bool safeTx{false};
+    bool tx_from_me{false};
+    size_t tx_ancestors{0};
+    size_t tx_descendants{0};
+    const auto check_tx = [&](const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
         if (wallet.IsTxImmatureCoinBase(wtx))
-            continue;
+            return false;
 
-        int nDepth = wallet.GetTxDepthInMainChain(wtx);
+        nDepth = wallet.GetTxDepthInMainChain(wtx);
         if (nDepth < 0)
-            continue;
+            return false;
 
         // We should not consider coins which aren't at least in our mempool
         // It's possible for these to be conflicted via ancestors which we may never be able to detect
         if (nDepth == 0 && !wtx.InMempool())
-            continue;
+            return false;
 
-        bool safeTx = CachedTxIsTrusted(wallet, wtx, trusted_parents);
+        safeTx = CachedTxIsTrusted(wallet, wtx, trusted_parents);
 
         // We should not consider coins from transactions that are replacing
         // other transactions.
@@ -223,18 +227,39 @@ CoinsResult AvailableCoins(const CWallet& wallet,
         }
 
         if (only_safe && !safeTx) {
-            continue;
+            return false;
         }
 
         if (nDepth < min_depth || nDepth > max_depth) {
-            continue;
+            return false;
         }
 
-        bool tx_from_me = CachedTxIsFromMe(wallet, wtx, ISMINE_ALL);
+        tx_from_me = CachedTxIsFromMe(wallet, wtx, ISMINE_ALL);
 
-        for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
-            const CTxOut& output = wtx.tx->vout[i];
-            const COutPoint outpoint(wtxid, i);
+        // Look up the mempool ancestry once here rather than for every output
+        // in every coin selection attempt. Confirmed transactions have none.
+        tx_ancestors = tx_descendants = 0;
+        if (nDepth == 0) {
+            wallet.chain().getTransactionAncestry(wtx.GetHash(), tx_ancestors, tx_descendants);
+        }
+        return true;
+    };
+
+    for (const CAmountType txo_type : {CASH, BOND}) {
+        if (amount_type && *amount_type != txo_type) continue;
+
+        // The outputs of a transaction are adjacent in the set, so the
+        // transaction is only looked up and checked once for all of them
+        const CWalletTx* wtx{nullptr};
+        bool tx_eligible{false};
+        for (const COutPoint& outpoint : wallet.GetUnspentTXOs(txo_type)) {
+            if (!wtx || wtx->GetHash() != outpoint.hash) {
+                wtx = wallet.GetWalletTx(outpoint.hash);
+                tx_eligible = check_tx(*Assert(wtx));
+            }
+            if (!tx_eligible) continue;
+
+            const CTxOut& output = wtx->tx->vout[outpoint.n];
 
             if (output.nValue < nMinimumAmount || output.nValue > nMaximumAmount)
                 continue;
@@ -287,7 +312,9 @@ CoinsResult AvailableCoins(const CWallet& wallet,
                 script = output.scriptPubKey;
             }
 
-            COutput coin(outpoint, output, nDepth, input_bytes, spendable, solvable, safeTx, wtx.GetTxTime(), tx_from_me, feerate);
+            COutput coin(outpoint, output, nDepth, input_bytes, spendable, solvable, safeTx, wtx->GetTxTime(), tx_from_me, feerate);
+            coin.ancestors = tx_ancestors;
+            coin.descendants = tx_descendants;
 
             // When parsing a scriptPubKey, Solver returns the parsed pubkeys or hashes (depending on the script)
             // We don't need those here, so we are leaving them in return_values_unused
@@ -328,7 +355,9 @@ CAmount GetAvailableBalance(const CWallet& wallet, CAmountType amountType, const
             /*nMinimumAmount=*/ 1,
             /*nMaximumAmount=*/ MAX_MONEY,
             /*nMinimumSumAmount=*/ MAX_MONEY,
-            /*nMaximumCount=*/ 0
+            /*nMaximumCount=*/ 0,
+            /*only_spendable=*/ true,
+            /*amount_type=*/ amountType
     ).total_amount[amountType];
 }
 
@@ -406,12 +435,9 @@ std::vector<OutputGroup> GroupOutputs(const CWallet& wallet, const std::vector<C
             // Skip outputs we cannot spend
             if (!output.spendable) continue;
 
-            size_t ancestors, descendants;
-            wallet.chain().getTransactionAncestry(output.outpoint.hash, ancestors, descendants);
-
             // Make an OutputGroup containing just this output
             OutputGroup group{coin_sel_params};
-            group.Insert(output, ancestors, descendants, positive_only);
+            group.Insert(output, output.ancestors, output.descendants, positive_only);
 
             // Check the OutputGroup's eligibility. Only add the eligible ones.
             if (positive_only && group.GetSelectionAmount() <= 0) continue;
@@ -431,8 +457,6 @@ std::vector<OutputGroup> GroupOutputs(const CWallet& wallet, const std::vector<C
         // Skip outputs we cannot spend
         if (!output.spendable) continue;
 
-        size_t ancestors, descendants;
-        wallet.chain().getTransactionAncestry(output.outpoint.hash, ancestors, descendants);
         CScript spk = output.txout.scriptPubKey;
 
         std::vector<OutputGroup>& groups = spk_to_groups_map[spk];
@@ -455,7 +479,7 @@ std::vector<OutputGroup> GroupOutputs(const CWallet& wallet, const std::vector<C
         }
 
         // Add the output to group
-        group->Insert(output, ancestors, descendants, positive_only);
+        group->Insert(output, output.ancestors, output.descendants, positive_only);
     }
 
     // Now we go through the entire map and pull out the OutputGroups
@@ -946,9 +970,9 @@ static util::Result<CreatedTransactionResult> CreateTransactionInternal(
                                               1,            /*nMinimumAmount*/
                                               MAX_MONEY,    /*nMaximumAmount*/
                                               MAX_MONEY,    /*nMinimumSumAmount*/
-                                              0);           /*nMaximumCount*/
-    // Filter for selected amount type
-    available_coins.Filter(nFeeTypeRet);
+                                              0,            /*nMaximumCount*/
+                                              /*only_spendable=*/true,
+                                              /*amount_type=*/nFeeTypeRet);
 
     // Choose coins to use
     std::optional<SelectionResult> result = SelectCoins(wallet, available_coins, /*nTargetValue=*/selection_target, coin_control, coin_selection_params);
@@ -1132,12 +1156,21 @@ util::Result<CreatedTransactionResult> CreateTransaction(
     return res;
 }
 
+/** State shared by the conversions built in one CreateConversionTransactions() call */
+struct ConversionBatchState {
+    //! Normalized minimum fee rate and its calculation, estimated once for the batch
+    std::optional<std::pair<CFeeRate, FeeCalculation>> min_feerate;
+    //! Available coins of each input type, less the coins already selected in the batch
+    std::array<std::optional<CoinsResult>, 2> available_coins;
+};
+
 static util::Result<CreatedTransactionResult> CreateConversionTransactionInternal(
         CWallet& wallet,
         const WalletConversionTxDetails& tx_details,
         int change_pos,
         const CCoinControl& coin_control,
-        bool sign) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet)
+        bool sign,
+        ConversionBatchState* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet)
 {
     AssertLockHeld(wallet.cs_wallet);
 
@@ -1195,7 +1228,13 @@ static util::Result<CreatedTransactionResult> CreateConversionTransactionInterna
 
     // Get the fee rate to use effective values in coin selection
     FeeCalculation feeCalc;
-    coin_selection_params.m_effective_feerate = GetMinimumFeeRate(wallet, coin_control, &feeCalc);
+    if (batch && batch->min_feerate) {
+        coin_selection_params.m_effective_feerate = batch->min_feerate->first;
+        feeCalc = batch->min_feerate->second;
+    } else {
+        coin_selection_params.m_effective_feerate = GetMinimumFeeRate(wallet, coin_control, &feeCalc);
+        if (batch) batch->min_feerate = std::make_pair(coin_selection_params.m_effective_feerate, feeCalc);
+    }
     // Do not, ever, assume that it's fine to change the fee rate if the user has explicitly
     // provided one
     if (coin_control.m_feerate) {
@@ -1314,22 +1353,34 @@ static util::Result<CreatedTransactionResult> CreateConversionTransactionInterna
         selection_target = tx_details.maxInput + not_input_fees;
     }
 
-    // Get available coins
-    auto available_coins = AvailableCoins(wallet,
-                                              &coin_control,
-                                              coin_selection_params.m_effective_feerate,
-                                              1,            /*nMinimumAmount*/
-                                              MAX_MONEY,    /*nMaximumAmount*/
-                                              MAX_MONEY,    /*nMinimumSumAmount*/
-                                              0);           /*nMaximumCount*/
-    // Filter for selected amount type
-    available_coins.Filter(tx_details.inputType);
+    // Get available coins, reusing the coins left in the batch if they have already been fetched
+    std::optional<CoinsResult> unbatched_coins;
+    std::optional<CoinsResult>& available_coins = batch ? batch->available_coins[tx_details.inputType] : unbatched_coins;
+    if (!available_coins) {
+        available_coins = AvailableCoins(wallet,
+                                         &coin_control,
+                                         coin_selection_params.m_effective_feerate,
+                                         1,            /*nMinimumAmount*/
+                                         MAX_MONEY,    /*nMaximumAmount*/
+                                         MAX_MONEY,    /*nMinimumSumAmount*/
+                                         0,            /*nMaximumCount*/
+                                         /*only_spendable=*/true,
+                                         /*amount_type=*/tx_details.inputType);
+    }
 
     // Choose coins to use
-    std::optional<SelectionResult> result = SelectCoins(wallet, available_coins, /*nTargetValue=*/selection_target, coin_control, coin_selection_params);
+    std::optional<SelectionResult> result = SelectCoins(wallet, *available_coins, /*nTargetValue=*/selection_target, coin_control, coin_selection_params);
     if (!result) {
         return util::Error{_("Insufficient funds")};
     }
+    if (batch) {
+        // Later conversions in the batch must not select the same coins
+        std::set<COutPoint> selected_outpoints;
+        for (const auto& coin : result->GetInputSet()) {
+            selected_outpoints.insert(coin.outpoint);
+        }
+        available_coins->Erase(selected_outpoints);
+    }
     TRACE5(coin_selection, selected_coins, wallet.GetName().c_str(), GetAlgorithmName(result->GetAlgo()).c_str(), result->GetTarget(), result->GetWaste(), result->GetSelectedValue());
 
     const CAmount change_amount = result->GetChange(coin_selection_params.min_viable_change, coin_selection_params.m_change_fee);
@@ -1475,23 +1526,32 @@ static util::Result<CreatedTransactionResult> CreateConversionTransactionInterna
     return CreatedTransactionResult(tx, nFeeRet, nFeeTypeRet, nChangePosInOut, feeCalc);
 }
 
-util::Result<CreatedTransactionResult> CreateConversionTransaction(
-        CWallet& wallet,
-        const WalletConversionTxDetails& tx_details,
-        int change_pos,
-        const CCoinControl& coin_control,
-        bool sign)
+static std::optional<bilingual_str> CheckConversionTxDetails(const WalletConversionTxDetails& tx_details)
 {
     if (tx_details.maxInput <= 0) {
-        return util::Error{_("Transaction must have a positive input amount")};
+        return _("Transaction must have a positive input amount");
     }
 
     if (tx_details.minOutput < 0) {
-        return util::Error{_("Transaction minimum output amount must not be negative")};
+        return _("Transaction minimum output amount must not be negative");
     }
 
     if (tx_details.inputType == tx_details.outputType) {
-        return util::Error{_("Transaction input and outputs must be different types")};
+        return _("Transaction input and outputs must be different types");
+    }
+
+    return std::nullopt;
+}
+
+util::Result<CreatedTransactionResult> CreateConversionTransaction(
+        CWallet& wallet,
+        const WalletConversionTxDetails& tx_details,
+        int change_pos,
+        const CCoinControl& coin_control,
+        bool sign)
+{
+    if (const auto error = CheckConversionTxDetails(tx_details)) {
+        return util::Error{*error};
     }
 
     LOCK(wallet.cs_wallet);
@@ -1521,6 +1581,41 @@ util::Result<CreatedTransactionResult> CreateConversionTransaction(
     return res;
 }
 
+util::Result<std::vector<CreatedTransactionResult>> CreateConversionTransactions(
+        CWallet& wallet,
+        const std::vector<WalletConversionTxDetails>& txs_details,
+        const CCoinControl& coin_control,
+        bool sign)
+{
+    for (const auto& tx_details : txs_details) {
+        if (const auto error = CheckConversionTxDetails(tx_details)) {
+            return util::Error{*error};
+        }
+    }
+
+    LOCK(wallet.cs_wallet);
+
+    // Build every conversion from one fee estimate and one scan of the wallet's coins
+    constexpr int RANDOM_CHANGE_POSITION = -1;
+    ConversionBatchState batch;
+    std::vector<CreatedTransactionResult> results;
+    results.reserve(txs_details.size());
+    for (size_t i = 0; i < txs_details.size(); ++i) {
+        const auto& tx_details = txs_details[i];
+        // Each conversion pays its fee in its input type
+        CCoinControl tx_coin_control = coin_control;
+        tx_coin_control.m_fee_type = tx_details.inputType;
+        auto res = CreateConversionTransactionInternal(wallet, tx_details, RANDOM_CHANGE_POSITION, tx_coin_control, sign, &batch);
+        TRACE4(coin_selection, normal_create_conversion_tx_internal, wallet.GetName().c_str(), bool(res),
+               res ? res->fee : 0, res ? res->change_pos : 0);
+        if (!res) {
+            return util::Error{Untranslated(strprintf("Conversion %u: ", i)) + util::ErrorString(res)};
+        }
+        results.push_back(std::move(*res));
+    }
+    return results;
+}
+
 bool FundTransaction(CWallet& wallet, CMutableTransaction& tx, CAmount& nFeeRet, int& nChangePosInOut, bilingual_str& error, bool lockUnspents, const std::set<int>& setSubtractFeeFromOutputs, CCoinControl coinControl)
 {
     std::vector<CRecipient> vecSend;
@@ -61,7 +61,7 @@ struct CoinsResult {
 
 /**
  * Populate the CoinsResult struct with vectors of available COutputs, organized by OutputType.
- * (Filtered by CAmountType)
+ * (Filtered by CAmountType if amount_type is set)
  */
 CoinsResult AvailableCoins(const CWallet& wallet,
                            const CCoinControl* coinControl = nullptr,
@@ -70,7 +70,8 @@ CoinsResult AvailableCoins(const CWallet& wallet,
                            const CAmount& nMaximumAmount = MAX_MONEY,
                            const CAmount& nMinimumSumAmount = MAX_MONEY,
                            const uint64_t nMaximumCount = 0,
-                           bool only_spendable = true) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet);
+                           bool only_spendable = true,
+                           std::optional<CAmountType> amount_type = std::nullopt) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet);
 
 /**
  * Wrapper function for AvailableCoins which skips the `feerate` parameter. Use this function
@@ -172,6 +173,14 @@ util::Result<CreatedTransactionResult> CreateTransaction(CWallet& wallet, const
  */
 util::Result<CreatedTransactionResult> CreateConversionTransaction(CWallet& wallet, const WalletConversionTxDetails& tx_details, int change_pos, const CCoinControl& coin_control, bool sign = true);
 
+/**
+ * Create a batch of conversion transactions in one pass. The conversions share
+ * a single fee estimate and draw their coins from a single scan of the wallet,
+ * so no two conversions in the batch spend the same coin. Each conversion pays
+ * its fee in its input type. Fails if any conversion cannot be created.
+ */
+util::Result<std::vector<CreatedTransactionResult>> CreateConversionTransactions(CWallet& wallet, const std::vector<WalletConversionTxDetails>& txs_details, const CCoinControl& coin_control, bool sign = true);
+
 /**
  * Insert additional inputs into the transaction by
  * calling CreateTransaction();
@@ -84,7 +84,7 @@ static void SetPragma(sqlite3* db, const std::string& key, const std::string& va
 }
 
 SQLiteDatabase::SQLiteDatabase(const fs::path& dir_path, const fs::path& file_path, const DatabaseOptions& options, bool mock)
-    : WalletDatabase(), m_mock(mock), m_dir_path(fs::PathToString(dir_path)), m_file_path(fs::PathToString(file_path)), m_use_unsafe_sync(options.use_unsafe_sync)
+    : WalletDatabase(), m_mock(mock), m_dir_path(fs::PathToString(dir_path)), m_file_path(fs::PathToString(file_path)), m_use_unsafe_sync(options.use_unsafe_sync), m_use_wal(options.use_wal)
 {
     {
         LOCK(g_sqlite_mutex);
@@ -120,6 +120,15 @@ SQLiteDatabase::SQLiteDatabase(const fs::path& dir_path, const fs::path& file_pa
 
 void SQLiteBatch::SetupSQLStatements()
 {
+    if (const auto cached{m_database.TakeCachedStatements()}) {
+        m_read_stmt = cached->read;
+        m_insert_stmt = cached->insert;
+        m_overwrite_stmt = cached->overwrite;
+        m_delete_stmt = cached->erase;
+        m_cursor_stmt = cached->cursor;
+        return;
+    }
+
     const std::vector<std::pair<sqlite3_stmt**, const char*>> statements{
         {&m_read_stmt, "SELECT value FROM main WHERE key = ?"},
         {&m_insert_stmt, "INSERT INTO main VALUES(?, ?)"},
@@ -144,6 +153,35 @@ SQLiteDatabase::~SQLiteDatabase()
     Cleanup();
 }
 
+std::optional<SQLiteStatements> SQLiteDatabase::TakeCachedStatements()
+{
+    LOCK(m_statements_mutex);
+    if (m_cached_statements.empty()) return std::nullopt;
+    SQLiteStatements statements{m_cached_statements.back()};
+    m_cached_statements.pop_back();
+    return statements;
+}
+
+void SQLiteDatabase::CacheStatements(const SQLiteStatements& statements)
+{
+    LOCK(m_statements_mutex);
+    m_cached_statements.push_back(statements);
+}
+
+void SQLiteDatabase::FinalizeCachedStatements()
+{
+    LOCK(m_statements_mutex);
+    for (const SQLiteStatements& statements : m_cached_statements) {
+        for (sqlite3_stmt* stmt : {statements.read, statements.insert, statements.overwrite, statements.erase, statements.cursor}) {
+            int res = sqlite3_finalize(stmt);
+            if (res != SQLITE_OK) {
+                LogPrintf("SQLiteDatabase: Could not finalize cached statement: %s\n", sqlite3_errstr(res));
+            }
+        }
+    }
+    m_cached_statements.clear();
+}
+
 void SQLiteDatabase::Cleanup() noexcept
 {
     Close();
@@ -261,6 +299,13 @@ void SQLiteDatabase::Open()
         SetPragma(m_db, "synchronous", "OFF", "Failed to set synchronous mode to OFF");
     }
 
+    // The journal mode is stored in the database file, so set it either way to
+    // switch back from a write-ahead log when it is no longer wanted. Because the
+    // database is locked exclusively, the log does not need shared memory.
+    if (!m_mock) {
+        SetPragma(m_db, "journal_mode", m_use_wal ? "WAL" : "DELETE", "Failed to set the journal mode");
+    }
+
     // Make the table for our key-value pairs
     // First check that the main table exists
     sqlite3_stmt* check_main_stmt{nullptr};
@@ -335,6 +380,7 @@ bool SQLiteDatabase::Backup(const std::string& dest) const
 
 void SQLiteDatabase::Close()
 {
+    FinalizeCachedStatements();
     int res = sqlite3_close(m_db);
     if (res != SQLITE_OK) {
         throw std::runtime_error(strprintf("SQLiteDatabase: Failed to close database: %s\n", sqlite3_errstr(res)));
@@ -359,8 +405,8 @@ SQLiteBatch::SQLiteBatch(SQLiteDatabase& database)
 
 void SQLiteBatch::Close()
 {
-    // If m_db is in a transaction (i.e. not in autocommit mode), then abort the transaction in progress
-    if (m_database.m_db && sqlite3_get_autocommit(m_database.m_db) == 0) {
+    // If this batch began a transaction that is still in progress, then abort it
+    if (m_txn) {
         if (TxnAbort()) {
             LogPrintf("SQLiteBatch: Batch closed unexpectedly without the transaction being explicitly committed or aborted\n");
         } else {
@@ -368,6 +414,19 @@ void SQLiteBatch::Close()
         }
     }
 
+    // Hand the statements over to the database for the next batch, unless it is
+    // being closed too
+    if (m_database.m_db && m_read_stmt && m_insert_stmt && m_overwrite_stmt && m_delete_stmt && m_cursor_stmt) {
+        for (sqlite3_stmt* stmt : {m_read_stmt, m_insert_stmt, m_overwrite_stmt, m_delete_stmt, m_cursor_stmt}) {
+            sqlite3_clear_bindings(stmt);
+            sqlite3_reset(stmt);
+        }
+        m_database.CacheStatements({m_read_stmt, m_insert_stmt, m_overwrite_stmt, m_delete_stmt, m_cursor_stmt});
+        m_read_stmt = m_insert_stmt = m_overwrite_stmt = m_delete_stmt = m_cursor_stmt = nullptr;
+        m_cursor_init = false;
+        return;
+    }
+
     // Free all of the prepared statements
     const std::vector<std::pair<sqlite3_stmt**, const char*>> statements{
         {&m_read_stmt, "read"},
@@ -519,25 +578,30 @@ bool SQLiteBatch::TxnBegin()
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to begin the transaction\n");
     }
-    return res == SQLITE_OK;
+    m_txn = res == SQLITE_OK;
+    return m_txn;
 }
 
 bool SQLiteBatch::TxnCommit()
 {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
+    if (!m_database.m_db || !m_txn || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
     int res = sqlite3_exec(m_database.m_db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr);
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to commit the transaction\n");
+    } else {
+        m_txn = false;
     }
     return res == SQLITE_OK;
 }
 
 bool SQLiteBatch::TxnAbort()
 {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
+    if (!m_database.m_db || !m_txn || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
     int res = sqlite3_exec(m_database.m_db, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr);
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to abort the transaction\n");
+    } else {
+        m_txn = false;
     }
     return res == SQLITE_OK;
 }
@@ -5,15 +5,28 @@
 #ifndef BITCOIN_WALLET_SQLITE_H
 #define BITCOIN_WALLET_SQLITE_H
 
+#include <sync.h>
 #include <wallet/db.h>
 
 #include <sqlite3.h>
 
+#include <optional>
+#include <vector>
+
 struct bilingual_str;
 
 namespace wallet {
 class SQLiteDatabase;
 
+/** The prepared statements a SQLiteBatch uses to access the main table */
+struct SQLiteStatements {
+    sqlite3_stmt* read{nullptr};
+    sqlite3_stmt* insert{nullptr};
+    sqlite3_stmt* overwrite{nullptr};
+    sqlite3_stmt* erase{nullptr};
+    sqlite3_stmt* cursor{nullptr};
+};
+
 /** RAII class that provides access to a WalletDatabase */
 class SQLiteBatch : public DatabaseBatch
 {
@@ -21,6 +34,9 @@ private:
     SQLiteDatabase& m_database;
 
     bool m_cursor_init = false;
+    //! Whether this batch began the open transaction. Writes of other batches
+    //! are part of it, but only this one commits or aborts it.
+    bool m_txn{false};
 
     sqlite3_stmt* m_read_stmt{nullptr};
     sqlite3_stmt* m_insert_stmt{nullptr};
@@ -63,8 +79,17 @@ private:
 
     const std::string m_file_path;
 
+    Mutex m_statements_mutex;
+    /** Statements of closed batches, reset and ready to be used by the next batch.
+     * Preparing them again for every batch is a large part of the cost of a
+     * short-lived batch. */
+    std::vector<SQLiteStatements> m_cached_statements GUARDED_BY(m_statements_mutex);
+
     void Cleanup() noexcept;
 
+    /** Finalize all cached statements. Must be done before the database handle can be closed. */
+    void FinalizeCachedStatements() EXCLUSIVE_LOCKS_REQUIRED(!m_statements_mutex);
+
 public:
     SQLiteDatabase() = delete;
 
@@ -112,8 +137,14 @@ public:
     /** Make a SQLiteBatch connected to this database */
     std::unique_ptr<DatabaseBatch> MakeBatch(bool flush_on_close = true) override;
 
+    /** Take the statements of a previously closed batch, if there are any */
+    std::optional<SQLiteStatements> TakeCachedStatements() EXCLUSIVE_LOCKS_REQUIRED(!m_statements_mutex);
+    /** Keep the reset statements of a closing batch for later batches */
+    void CacheStatements(const SQLiteStatements& statements) EXCLUSIVE_LOCKS_REQUIRED(!m_statements_mutex);
+
     sqlite3* m_db{nullptr};
     bool m_use_unsafe_sync;
+    bool m_use_wal;
 };
 
 std::unique_ptr<SQLiteDatabase> MakeSQLiteDatabase(const fs::path& path, const DatabaseOptions& options, DatabaseStatus& status, bilingual_str& error);
@@ -103,5 +103,32 @@ BOOST_FIXTURE_TEST_CASE(BasicOutputTypesTest, AvailableCoinsTestingSetup)
     BOOST_CHECK_EQUAL(available_coins.coins[OutputType::LEGACY].size(), 2U);
 }
 
+BOOST_FIXTURE_TEST_CASE(UnspentTXOsTest, AvailableCoinsTestingSetup)
+{
+    LOCK(wallet->cs_wallet);
+
+    // The mature coinbase output is indexed along with the immature ones
+    const std::vector<COutput> coinbase_coins{AvailableCoins(*wallet).All()};
+    BOOST_CHECK_EQUAL(coinbase_coins.size(), 1U);
+    BOOST_CHECK(wallet->GetUnspentTXOs(CASH).count(coinbase_coins[0].outpoint));
+    BOOST_CHECK(wallet->GetUnspentTXOs(BOND).empty());
+
+    // Spending it replaces it with the outputs of the spending transaction
+    const size_t unspent_before{wallet->GetUnspentTXOs(CASH).size()};
+    const auto dest{wallet->GetNewDestination(OutputType::BECH32, "")};
+    BOOST_ASSERT(dest);
+    const CWalletTx& wtx{AddTx(CRecipient{{GetScriptForDestination(*dest)}, CASH, 1 * COIN, /*fSubtractFeeFromAmount=*/true})};
+    const std::set<COutPoint>& unspent{wallet->GetUnspentTXOs(CASH)};
+    BOOST_CHECK_EQUAL(unspent.size(), unspent_before + 1);
+    BOOST_CHECK(!unspent.count(coinbase_coins[0].outpoint));
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        BOOST_CHECK(unspent.count(COutPoint(wtx.GetHash(), i)));
+    }
+    for (const COutput& coin : AvailableCoins(*wallet).All()) {
+        BOOST_CHECK(unspent.count(coin.outpoint));
+    }
+    BOOST_CHECK(AvailableCoins(*wallet, /*coinControl=*/nullptr, /*feerate=*/std::nullopt, 1, MAX_MONEY, MAX_MONEY, 0, /*only_spendable=*/true, /*amount_type=*/BOND).All().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace wallet
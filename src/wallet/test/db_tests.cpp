@@ -2,11 +2,16 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 
 #include <fs.h>
 #include <test/util/setup_common.h>
 #include <wallet/bdb.h>
+#include <wallet/walletdb.h>
 
 #include <fstream>
 #include <memory>
@@ -78,5 +83,37 @@ BOOST_AUTO_TEST_CASE(getwalletenv_g_dbenvs_free_instance)
     BOOST_CHECK(env_2_a == env_2_b);
 }
 
+#ifdef USE_SQLITE
+BOOST_AUTO_TEST_CASE(sqlite_nested_batch_txn)
+{
+    DatabaseOptions options;
+    options.require_format = DatabaseFormat::SQLITE;
+    std::unique_ptr<WalletDatabase> database = CreateMockWalletDatabase(options);
+
+    std::unique_ptr<DatabaseBatch> outer = database->MakeBatch();
+    BOOST_REQUIRE(outer->TxnBegin());
+    {
+        // Another batch writes into the open transaction, and can't end it
+        std::unique_ptr<DatabaseBatch> inner = database->MakeBatch();
+        BOOST_CHECK(!inner->TxnBegin());
+        BOOST_CHECK(inner->Write(std::string{"key"}, std::string{"value"}));
+        BOOST_CHECK(!inner->TxnCommit());
+        BOOST_CHECK(!inner->TxnAbort());
+    }
+    // Closing the inner batch left the transaction open
+    BOOST_CHECK(outer->Exists(std::string{"key"}));
+    BOOST_CHECK(outer->TxnAbort());
+    BOOST_CHECK(!outer->Exists(std::string{"key"}));
+
+    BOOST_REQUIRE(outer->TxnBegin());
+    BOOST_CHECK(database->MakeBatch()->Write(std::string{"key"}, std::string{"value"}));
+    BOOST_CHECK(outer->TxnCommit());
+    std::string value;
+    BOOST_CHECK(database->MakeBatch()->Read(std::string{"key"}, value));
+    BOOST_CHECK_EQUAL(value, "value");
+}
+#endif
+
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace wallet
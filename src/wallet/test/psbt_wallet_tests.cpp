@@ -11,6 +11,10 @@
 #include <test/util/setup_common.h>
 #include <wallet/test/wallet_test_fixture.h>
 
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
 namespace wallet {
 BOOST_FIXTURE_TEST_SUITE(psbt_wallet_tests, WalletTestingSetup)
 
@@ -70,6 +74,23 @@ BOOST_AUTO_TEST_CASE(psbt_updater_test)
     BOOST_CHECK(m_wallet.FillPSBT(psbtx, complete, SIGHASH_ALL, true, true) != TransactionError::OK);
 }
 
+BOOST_AUTO_TEST_CASE(psbt_for_each_input)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1000);
+    PartiallySignedTransaction psbtx(mtx);
+
+    std::vector<std::atomic<int>> calls(mtx.vin.size());
+    ForEachPSBTInput(psbtx, [&](unsigned int i) { ++calls[i]; });
+    for (const std::atomic<int>& count : calls) {
+        BOOST_CHECK_EQUAL(count.load(), 1);
+    }
+
+    BOOST_CHECK_THROW(ForEachPSBTInput(psbtx, [&](unsigned int i) {
+        if (i == 500) throw std::runtime_error("input failed");
+    }), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(parse_hd_keypath)
 {
     std::vector<uint32_t> keypath;
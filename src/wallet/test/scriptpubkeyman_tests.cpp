@@ -3,6 +3,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <key.h>
+#include <key_io.h>
+#include <script/descriptor.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
 #include <wallet/scriptpubkeyman.h>
@@ -39,5 +41,39 @@ BOOST_AUTO_TEST_CASE(CanProvide)
     BOOST_CHECK(keyman.CanProvide(p2sh_script, data));
 }
 
+// Test that a top-up large enough to be derived on several threads adds the
+// same scripts as expanding the descriptor index by index.
+BOOST_AUTO_TEST_CASE(DescriptorTopUpMatchesExpand)
+{
+    CWallet wallet(m_node.chain.get(), "", m_args, CreateDummyWalletDatabase());
+    LOCK(wallet.cs_wallet);
+    wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+
+    CExtKey master_key;
+    const std::vector<std::byte> seed(32, std::byte{1});
+    master_key.SetSeed(seed);
+    FlatSigningProvider keys;
+    std::string error;
+    std::unique_ptr<Descriptor> parsed_desc{Parse("wpkh(" + EncodeExtKey(master_key) + "/84h/1h/0h/0/*)", keys, error, /*require_checksum=*/false)};
+    BOOST_REQUIRE(parsed_desc);
+    const std::shared_ptr<Descriptor> desc{std::move(parsed_desc)};
+    WalletDescriptor w_desc(desc, /*creation_time=*/0, /*range_start=*/0, /*range_end=*/1, /*next_index=*/0);
+    auto spk_man{dynamic_cast<DescriptorScriptPubKeyMan*>(wallet.AddWalletDescriptor(w_desc, keys, /*label=*/"", /*internal=*/false))};
+    BOOST_REQUIRE(spk_man);
+    BOOST_CHECK(spk_man->TopUp(2500));
+
+    const int32_t range_end{WITH_LOCK(spk_man->cs_desc_man, return spk_man->GetWalletDescriptor().range_end)};
+    BOOST_CHECK_EQUAL(range_end, 2500);
+    const auto spks{spk_man->GetScriptPubKeys()};
+    BOOST_CHECK_EQUAL(spks.size(), 2500U);
+    for (int32_t i = 0; i < range_end; ++i) {
+        std::vector<CScript> scripts;
+        FlatSigningProvider out_keys;
+        BOOST_REQUIRE(desc->Expand(i, keys, scripts, out_keys));
+        BOOST_REQUIRE_EQUAL(scripts.size(), 1U);
+        BOOST_CHECK(spks.count(scripts[0]));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace wallet
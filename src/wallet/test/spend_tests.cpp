@@ -61,6 +61,37 @@ BOOST_FIXTURE_TEST_CASE(SubtractFee, TestChain100Setup)
     BOOST_CHECK_EQUAL(fee, check_tx(fee + 123));
 }
 
+BOOST_FIXTURE_TEST_CASE(CreateConversionTransactionsTest, TestChain100Setup)
+{
+    for (int i = 0; i < 3; ++i) {
+        CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+    }
+    auto wallet = CreateSyncedWallet(*m_node.chain, WITH_LOCK(Assert(m_node.chainman)->GetMutex(), return m_node.chainman->ActiveChain()), m_args, coinbaseKey);
+
+    CCoinControl coin_control;
+    coin_control.m_feerate.emplace(10000);
+    coin_control.fOverrideFeeRate = true;
+
+    const WalletConversionTxDetails conversion{COIN, COIN / 2, CASH, BOND, BOND, /*fSubtractFeeFromInput=*/false};
+    auto res = CreateConversionTransactions(*wallet, {conversion, conversion, conversion}, coin_control);
+    BOOST_REQUIRE(res);
+    BOOST_CHECK_EQUAL(res->size(), 3U);
+
+    // Every conversion pays its fee in its input type, and no coin is spent twice
+    std::set<COutPoint> spent;
+    for (const auto& txr : *res) {
+        BOOST_CHECK_EQUAL(txr.feeType, CASH);
+        BOOST_CHECK_GT(txr.fee, 0);
+        for (const auto& txin : txr.tx->vin) {
+            BOOST_CHECK(spent.insert(txin.prevout).second);
+        }
+    }
+
+    // The batch fails as a whole if any conversion is invalid
+    const WalletConversionTxDetails invalid{COIN, COIN / 2, CASH, CASH, BOND, /*fSubtractFeeFromInput=*/false};
+    BOOST_CHECK(!CreateConversionTransactions(*wallet, {conversion, invalid}, coin_control));
+}
+
 static void TestFillInputToWeight(int64_t additional_weight, std::vector<int64_t> expected_stack_sizes)
 {
     static const int64_t EMPTY_INPUT_WEIGHT = GetTransactionInputWeight(CTxIn());
@@ -250,15 +250,26 @@ public:
 
     template<typename Stream>
     void Unserialize(Stream& s)
+    {
+        CTransactionRef serialized_tx;
+        s >> serialized_tx;
+        UnserializeAfterTx(std::move(serialized_tx), s);
+    }
+
+    /** Unserialize the fields that follow the transaction, for a stream whose
+     * transaction has already been read. */
+    template<typename Stream>
+    void UnserializeAfterTx(CTransactionRef serialized_tx, Stream& s)
     {
         Init();
+        tx = std::move(serialized_tx);
 
         std::vector<uint256> dummy_vector1; //!< Used to be vMerkleBranch
         std::vector<CMerkleTx> dummy_vector2; //!< Used to be vtxPrev
         bool dummy_bool; //! Used to be fSpent
         uint256 serialized_block_hash;
         int serializedIndex;
-        s >> tx >> serialized_block_hash >> dummy_vector1 >> serializedIndex >> dummy_vector2 >> mapValue >> vOrderForm >> fTimeReceivedIsTxTime >> nTimeReceived >> fFromMe >> dummy_bool;
+        s >> serialized_block_hash >> dummy_vector1 >> serializedIndex >> dummy_vector2 >> mapValue >> vOrderForm >> fTimeReceivedIsTxTime >> nTimeReceived >> fFromMe >> dummy_bool;
 
         m_state = TxStateInterpretSerialized({serialized_block_hash, serializedIndex});
 
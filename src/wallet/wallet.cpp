@@ -5,16 +5,19 @@
 
 #include <wallet/wallet.h>
 
+#include <blockfilter.h>
 #include <chain.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <external_signer.h>
 #include <fs.h>
 #include <interfaces/chain.h>
 #include <interfaces/wallet.h>
 #include <key.h>
 #include <key_io.h>
+#include <memusage.h>
 #include <outputtype.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
@@ -33,6 +36,7 @@
 #include <util/moneystr.h>
 #include <util/rbf.h>
 #include <util/string.h>
+#include <util/threadpool.h>
 #include <util/translation.h>
 #include <wallet/coincontrol.h>
 #include <wallet/context.h>
@@ -43,7 +47,9 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
 #include <optional>
+#include <thread>
 
 using interfaces::FoundBlock;
 
@@ -579,15 +585,12 @@ std::set<uint256> CWallet::GetConflicts(const uint256& txid) const
         return result;
     const CWalletTx& wtx = it->second;
 
-    std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range;
-
     for (const CTxIn& txin : wtx.tx->vin)
     {
-        if (mapTxSpends.count(txin.prevout) <= 1)
+        const auto spends = mapTxSpends.find(txin.prevout);
+        if (spends == mapTxSpends.end() || spends->second.size() <= 1)
             continue;  // No conflict if zero or one spends
-        range = mapTxSpends.equal_range(txin.prevout);
-        for (TxSpends::const_iterator _it = range.first; _it != range.second; ++_it)
-            result.insert(_it->second);
+        result.insert(spends->second.begin(), spends->second.end());
     }
     return result;
 }
@@ -615,7 +618,7 @@ void CWallet::Close()
     GetDatabase().Close();
 }
 
-void CWallet::SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator> range)
+void CWallet::SyncMetaData(const TxSpenders& spenders)
 {
     // We want all the wallet transactions in range to have the same metadata as
     // the oldest (smallest nOrderPos).
@@ -623,8 +626,8 @@ void CWallet::SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator> ran
 
     int nMinOrderPos = std::numeric_limits<int>::max();
     const CWalletTx* copyFrom = nullptr;
-    for (TxSpends::iterator it = range.first; it != range.second; ++it) {
-        const CWalletTx* wtx = &mapWallet.at(it->second);
+    for (const uint256& hash : spenders) {
+        const CWalletTx* wtx = &mapWallet.at(hash);
         if (wtx->nOrderPos < nMinOrderPos) {
             nMinOrderPos = wtx->nOrderPos;
             copyFrom = wtx;
@@ -636,9 +639,8 @@ void CWallet::SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator> ran
     }
 
     // Now copy data from copyFrom to rest:
-    for (TxSpends::iterator it = range.first; it != range.second; ++it)
+    for (const uint256& hash : spenders)
     {
-        const uint256& hash = it->second;
         CWalletTx* copyTo = &mapWallet.at(hash);
         if (copyFrom == copyTo) continue;
         assert(copyFrom && "Oldest wallet transaction in range assumed to have been found.");
@@ -660,11 +662,10 @@ void CWallet::SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator> ran
  */
 bool CWallet::IsSpent(const COutPoint& outpoint) const
 {
-    std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range;
-    range = mapTxSpends.equal_range(outpoint);
+    const auto spends = mapTxSpends.find(outpoint);
+    if (spends == mapTxSpends.end()) return false;
 
-    for (TxSpends::const_iterator it = range.first; it != range.second; ++it) {
-        const uint256& wtxid = it->second;
+    for (const uint256& wtxid : spends->second) {
         const auto mit = mapWallet.find(wtxid);
         if (mit != mapWallet.end()) {
             int depth = GetTxDepthInMainChain(mit->second);
@@ -675,9 +676,67 @@ bool CWallet::IsSpent(const COutPoint& outpoint) const
     return false;
 }
 
+const std::set<COutPoint>& CWallet::GetUnspentTXOs(CAmountType amount_type) const
+{
+    AssertLockHeld(cs_wallet);
+    assert(amount_type == CASH || amount_type == BOND);
+    if (m_unspent_txos_stale) RebuildUnspentTXOs();
+    return m_unspent_txos[amount_type];
+}
+
+std::optional<Balance> CWallet::GetCachedBalance(CAmountType amount_type, int min_depth, bool avoid_reuse) const
+{
+    AssertLockHeld(cs_wallet);
+    const auto it{m_cached_balances.find({amount_type, min_depth, avoid_reuse})};
+    if (it == m_cached_balances.end()) return std::nullopt;
+    return it->second;
+}
+
+void CWallet::SetCachedBalance(CAmountType amount_type, int min_depth, bool avoid_reuse, const Balance& balance) const
+{
+    AssertLockHeld(cs_wallet);
+    m_cached_balances[{amount_type, min_depth, avoid_reuse}] = balance;
+}
+
+void CWallet::RebuildUnspentTXOs() const
+{
+    AssertLockHeld(cs_wallet);
+    for (auto& txos : m_unspent_txos) txos.clear();
+    for (const auto& [txid, wtx] : mapWallet) {
+        for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+            const CTxOut& txout = wtx.tx->vout[i];
+            if (txout.amountType != CASH && txout.amountType != BOND) continue;
+            const COutPoint outpoint(txid, i);
+            if (IsMine(txout) != ISMINE_NO && !IsSpent(outpoint)) {
+                m_unspent_txos[txout.amountType].insert(outpoint);
+            }
+        }
+    }
+    m_unspent_txos_stale = false;
+}
+
+void CWallet::RefreshUnspentTXO(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_wallet);
+    // A stale index is rebuilt entirely on its next use
+    if (m_unspent_txos_stale) return;
+    const auto it = mapWallet.find(outpoint.hash);
+    if (it == mapWallet.end() || outpoint.n >= it->second.tx->vout.size()) return;
+    const CTxOut& txout = it->second.tx->vout[outpoint.n];
+    if (txout.amountType != CASH && txout.amountType != BOND) return;
+    if (IsMine(txout) != ISMINE_NO && !IsSpent(outpoint)) {
+        m_unspent_txos[txout.amountType].insert(outpoint);
+    } else {
+        m_unspent_txos[txout.amountType].erase(outpoint);
+    }
+}
+
 void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid, WalletBatch* batch)
 {
-    mapTxSpends.insert(std::make_pair(outpoint, wtxid));
+    TxSpenders& spenders = mapTxSpends[outpoint];
+    if (std::find(spenders.begin(), spenders.end(), wtxid) == spenders.end()) {
+        spenders.push_back(wtxid);
+    }
 
     if (batch) {
         UnlockCoin(outpoint, batch);
@@ -686,9 +745,9 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid, Walle
         UnlockCoin(outpoint, &temp_batch);
     }
 
-    std::pair<TxSpends::iterator, TxSpends::iterator> range;
-    range = mapTxSpends.equal_range(outpoint);
-    SyncMetaData(range);
+    SyncMetaData(spenders);
+
+    RefreshUnspentTXO(outpoint);
 }
 
 
@@ -878,6 +937,7 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        MarkBalancesDirty();
     }
 }
 
@@ -899,6 +959,7 @@ bool CWallet::MarkReplaced(const uint256& originalHash, const uint256& newHash)
 
     // Refresh mempool status without waiting for transactionRemovedFromMempool or transactionAddedToMempool
     RefreshMempoolStatus(wtx, chain());
+    MarkBalancesDirty();
 
     WalletBatch batch(GetDatabase());
 
@@ -994,6 +1055,9 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
         wtx.nTimeSmart = ComputeTimeSmart(wtx, rescanning_old_block);
         AddToSpends(wtx, &batch);
+        for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+            RefreshUnspentTXO(COutPoint(hash, i));
+        }
     }
 
     if (!fInsertedNew)
@@ -1016,6 +1080,8 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
         }
     }
 
+    AddConversionDeadline(wtx);
+
     //// debug print
     WalletLogPrintf("AddToWallet %s  %s%s\n", hash.ToString(), (fInsertedNew ? "new" : ""), (fUpdated ? "update" : ""));
 
@@ -1026,6 +1092,7 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    MarkBalancesDirty();
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1093,6 +1160,7 @@ bool CWallet::LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
     }
     AddToSpends(wtx);
+    AddConversionDeadline(wtx);
     for (const CTxIn& txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
@@ -1113,13 +1181,13 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const SyncTxS
 
         if (auto* conf = std::get_if<TxStateConfirmed>(&state)) {
             for (const CTxIn& txin : tx.vin) {
-                std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range = mapTxSpends.equal_range(txin.prevout);
-                while (range.first != range.second) {
-                    if (range.first->second != tx.GetHash()) {
-                        WalletLogPrintf("Transaction %s (in block %s) conflicts with wallet transaction %s (both spend %s:%i)\n", tx.GetHash().ToString(), conf->confirmed_block_hash.ToString(), range.first->second.ToString(), range.first->first.hash.ToString(), range.first->first.n);
-                        MarkConflicted(conf->confirmed_block_hash, conf->confirmed_block_height, range.first->second);
+                const auto spends = mapTxSpends.find(txin.prevout);
+                if (spends == mapTxSpends.end()) continue;
+                for (const uint256& spender : spends->second) {
+                    if (spender != tx.GetHash()) {
+                        WalletLogPrintf("Transaction %s (in block %s) conflicts with wallet transaction %s (both spend %s:%i)\n", tx.GetHash().ToString(), conf->confirmed_block_hash.ToString(), spender.ToString(), txin.prevout.hash.ToString(), txin.prevout.n);
+                        MarkConflicted(conf->confirmed_block_hash, conf->confirmed_block_height, spender);
                     }
-                    range.first++;
                 }
             }
         }
@@ -1180,10 +1248,12 @@ bool CWallet::TransactionCanBeAbandoned(const uint256& hashTx) const
 
 void CWallet::MarkInputsDirty(const CTransactionRef& tx)
 {
+    MarkBalancesDirty();
     for (const CTxIn& txin : tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            RefreshUnspentTXO(txin.prevout);
         }
     }
 }
@@ -1227,10 +1297,11 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
             NotifyTransactionChanged(wtx.GetHash(), CT_UPDATED);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them abandoned too
             for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
-                std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range = mapTxSpends.equal_range(COutPoint(now, i));
-                for (TxSpends::const_iterator iter = range.first; iter != range.second; ++iter) {
-                    if (!done.count(iter->second)) {
-                        todo.insert(iter->second);
+                const auto spends = mapTxSpends.find(COutPoint(now, i));
+                if (spends == mapTxSpends.end()) continue;
+                for (const uint256& spender : spends->second) {
+                    if (!done.count(spender)) {
+                        todo.insert(spender);
                     }
                 }
             }
@@ -1280,10 +1351,11 @@ void CWallet::MarkConflicted(const uint256& hashBlock, int conflicting_height, c
             batch.WriteTx(wtx);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them conflicted too
             for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
-                std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range = mapTxSpends.equal_range(COutPoint(now, i));
-                for (TxSpends::const_iterator iter = range.first; iter != range.second; ++iter) {
-                    if (!done.count(iter->second)) {
-                        todo.insert(iter->second);
+                const auto spends = mapTxSpends.find(COutPoint(now, i));
+                if (spends == mapTxSpends.end()) continue;
+                for (const uint256& spender : spends->second) {
+                    if (!done.count(spender)) {
+                        todo.insert(spender);
                     }
                 }
             }
@@ -1312,6 +1384,7 @@ void CWallet::transactionAddedToMempool(const CTransactionRef& tx, uint64_t memp
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         RefreshMempoolStatus(it->second, chain());
+        MarkBalancesDirty();
     }
 }
 
@@ -1320,6 +1393,7 @@ void CWallet::transactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRe
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         RefreshMempoolStatus(it->second, chain());
+        MarkBalancesDirty();
     }
     // Handle transactions that were removed from the mempool because they
     // conflict with transactions in a newly connected block.
@@ -1364,22 +1438,40 @@ void CWallet::blockConnected(const interfaces::BlockInfo& block)
 
     m_last_block_processed_height = block.height;
     m_last_block_processed = block.hash;
+    MarkBalancesDirty();
     for (size_t index = 0; index < block.data->vtx.size(); index++) {
         SyncTransaction(block.data->vtx[index], TxStateConfirmed{block.hash, block.height, static_cast<int>(index)});
         transactionRemovedFromMempool(block.data->vtx[index], MemPoolRemovalReason::BLOCK, 0 /* mempool_sequence */);
     }
 
-    // Mark all conversion transactions beyond their deadline as expired
-    for (auto& [txid, wtx] : mapWallet) {
+    ExpireConversions(block.height);
+}
+
+void CWallet::AddConversionDeadline(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+
+    // Only conversion transactions have an expiration deadline
+    if (!wtx.IsConversion() || wtx.isConfirmed() || wtx.isConflicted() || wtx.isExpired()) return;
+    const int deadline{wtx.GetConversionDeadline()};
+    if (deadline > 0) m_conversion_deadlines.emplace(deadline, wtx.GetHash());
+}
+
+void CWallet::ExpireConversions(int height)
+{
+    AssertLockHeld(cs_wallet);
+
+    // Take the entries out first, as marking a transaction updates the set
+    const auto end{m_conversion_deadlines.lower_bound({height + 1, uint256::ZERO})};
+    const std::vector<std::pair<int, uint256>> expiring{m_conversion_deadlines.begin(), end};
+    m_conversion_deadlines.erase(m_conversion_deadlines.begin(), end);
+    for (const auto& [deadline, txid] : expiring) {
+        const auto it{mapWallet.find(txid)};
+        if (it == mapWallet.end()) continue;
+        const CWalletTx& wtx{it->second};
         // Do not mark as expired transactions that are already confirmed, conflicted, or expired
         if (wtx.isConfirmed() || wtx.isConflicted() || wtx.isExpired()) continue;
-        // Only conversion transactions have an expiration deadline
-        if (wtx.IsConversion()) {
-            CTxConversionInfo conversionInfo = GetConversionInfo(*wtx.tx).value();
-            if (conversionInfo.nDeadline && conversionInfo.nDeadline <= (uint32_t)block.height) {
-                SyncTransaction(wtx.tx, TxStateExpired{});
-            }
-        }
+        SyncTransaction(wtx.tx, TxStateExpired{});
     }
 }
 
@@ -1394,6 +1486,7 @@ void CWallet::blockDisconnected(const interfaces::BlockInfo& block)
     // future with a stickier abandoned state or even removing abandontransaction call.
     m_last_block_processed_height = block.height - 1;
     m_last_block_processed = *Assert(block.prev_hash);
+    MarkBalancesDirty();
     for (const CTransactionRef& ptx : Assert(block.data)->vtx) {
         SyncTransaction(ptx, TxStateInactive{});
     }
@@ -1693,6 +1786,8 @@ bool CWallet::ImportScripts(const std::set<CScript> scripts, int64_t timestamp)
         return false;
     }
     LOCK(spk_man->cs_KeyStore);
+    m_unspent_txos_stale = true;
+    MarkBalancesDirty();
     return spk_man->ImportScripts(scripts, timestamp);
 }
 
@@ -1703,6 +1798,8 @@ bool CWallet::ImportPrivKeys(const std::map<CKeyID, CKey>& privkey_map, const in
         return false;
     }
     LOCK(spk_man->cs_KeyStore);
+    m_unspent_txos_stale = true;
+    MarkBalancesDirty();
     return spk_man->ImportPrivKeys(privkey_map, timestamp);
 }
 
@@ -1713,6 +1810,8 @@ bool CWallet::ImportPubKeys(const std::vector<CKeyID>& ordered_pubkeys, const st
         return false;
     }
     LOCK(spk_man->cs_KeyStore);
+    m_unspent_txos_stale = true;
+    MarkBalancesDirty();
     return spk_man->ImportPubKeys(ordered_pubkeys, pubkey_map, key_origins, add_keypool, internal, timestamp);
 }
 
@@ -1723,6 +1822,8 @@ bool CWallet::ImportScriptPubKeys(const std::string& label, const std::set<CScri
         return false;
     }
     LOCK(spk_man->cs_KeyStore);
+    m_unspent_txos_stale = true;
+    MarkBalancesDirty();
     if (!spk_man->ImportScriptPubKeys(script_pub_keys, have_solving_data, timestamp)) {
         return false;
     }
@@ -1769,6 +1870,96 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+namespace {
+/** Number of blocks whose filters are matched and whose data is read together, ahead of the wallet, during a rescan */
+constexpr size_t RESCAN_READ_AHEAD_BLOCKS{32};
+/** Maximum number of threads matching filters and reading blocks during a rescan */
+constexpr size_t MAX_RESCAN_READ_AHEAD_THREADS{4};
+
+/**
+ * Matches the scriptPubKeys of a descriptor wallet against BIP 157 block
+ * filters, so that a rescan only has to read the blocks that may involve the
+ * wallet. Outputs of any transaction, coinbases included, and spent outputs are
+ * part of the basic filter.
+ */
+class FastWalletRescanFilter
+{
+public:
+    explicit FastWalletRescanFilter(const CWallet& wallet) : m_wallet(wallet)
+    {
+        // fast rescanning via block filters is only supported by descriptor wallets
+        assert(!m_wallet.IsLegacy());
+
+        for (auto spkm : m_wallet.GetAllScriptPubKeyMans()) {
+            auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan*>(spkm)};
+            assert(desc_spkm != nullptr);
+            AddScriptPubKeys(desc_spkm);
+            // remember the end of ranged descriptors, to add the scripts of later top-ups
+            if (desc_spkm->IsHDEnabled()) {
+                m_last_range_ends.emplace(desc_spkm->GetID(), desc_spkm->GetEndRange());
+            }
+        }
+    }
+
+    /** Add the scripts generated by top-ups since the last call. Returns whether any were added. */
+    bool UpdateIfNeeded()
+    {
+        bool updated{false};
+        for (auto& [desc_spkm_id, last_range_end] : m_last_range_ends) {
+            auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan*>(m_wallet.GetScriptPubKeyMan(desc_spkm_id))};
+            assert(desc_spkm != nullptr);
+            const int32_t current_range_end{desc_spkm->GetEndRange()};
+            if (current_range_end > last_range_end) {
+                AddScriptPubKeys(desc_spkm, last_range_end);
+                last_range_end = current_range_end;
+                updated = true;
+            }
+        }
+        return updated;
+    }
+
+    std::optional<bool> MatchesBlock(const uint256& block_hash) const
+    {
+        return m_wallet.chain().blockFilterMatchesAny(BlockFilterType::BASIC, block_hash, m_filter_set);
+    }
+
+private:
+    const CWallet& m_wallet;
+    std::map<uint256, int32_t> m_last_range_ends;
+    GCSFilter::ElementSet m_filter_set;
+
+    void AddScriptPubKeys(const DescriptorScriptPubKeyMan* desc_spkm, int32_t last_range_end = 0)
+    {
+        for (const auto& script_pub_key : desc_spkm->GetScriptPubKeys(last_range_end)) {
+            m_filter_set.emplace(script_pub_key.begin(), script_pub_key.end());
+        }
+    }
+};
+
+/** A block fetched ahead of the wallet during a rescan */
+struct RescanBlock {
+    uint256 hash;
+    //! Whether the block filter matches the wallet, if there is a filter
+    std::optional<bool> filter_matches{};
+    //! Whether the block data was read; block is null if that failed
+    bool read{false};
+    CBlock block{};
+};
+
+/** Match the filters of the blocks, and read those that may involve the wallet, on tasks of the shared thread pool */
+void FetchRescanBlocks(interfaces::Chain& chain, const FastWalletRescanFilter* filter, std::vector<RescanBlock>& blocks)
+{
+    util::ParallelFor("rescan", util::TaskPriority::NORMAL, blocks.size(), MAX_RESCAN_READ_AHEAD_THREADS, [&](size_t i) {
+        RescanBlock& rescan_block = blocks[i];
+        if (filter) rescan_block.filter_matches = filter->MatchesBlock(rescan_block.hash);
+        if (rescan_block.filter_matches.value_or(true)) {
+            chain.findBlock(rescan_block.hash, FoundBlock().data(rescan_block.block));
+            rescan_block.read = true;
+        }
+    });
+}
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1802,7 +1993,11 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     uint256 block_hash = start_block;
     ScanResult result;
 
-    WalletLogPrintf("Rescan started from block %s...\n", start_block.ToString());
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (!IsLegacy() && chain().hasBlockFilterIndex(BlockFilterType::BASIC)) fast_rescan_filter = std::make_unique<FastWalletRescanFilter>(*this);
+
+    WalletLogPrintf("Rescan started from block %s... (%s)\n", start_block.ToString(),
+                    fast_rescan_filter ? "fast variant using block filters" : "slow variant inspecting all blocks");
 
     fAbortRescan = false;
     ShowProgress(strprintf("%s " + _("Rescanning…").translated, GetDisplayName()), 0); // show rescan progress in GUI as dialog or on splashscreen, if rescan required on startup (e.g. due to corruption)
@@ -1813,6 +2008,11 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     double progress_end = chain().guessVerificationProgress(end_hash);
     double progress_current = progress_begin;
     int block_height = start_height;
+    int blocks_skipped{0};
+    // Blocks fetched ahead, and the position of block_hash among them
+    std::vector<RescanBlock> read_ahead;
+    size_t read_ahead_pos{0};
+    bool filter_updated{false};
     while (!fAbortRescan && !chain().shutdownRequested()) {
         if (progress_end - progress_begin > 0.0) {
             m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
@@ -1829,9 +2029,37 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", block_height, progress_current);
         }
 
-        // Read block data
-        CBlock block;
-        chain().findBlock(block_hash, FoundBlock().data(block));
+        // Scripts generated while scanning the previous blocks are added to the filter
+        if (fast_rescan_filter && fast_rescan_filter->UpdateIfNeeded()) filter_updated = true;
+
+        if (read_ahead_pos >= read_ahead.size() || read_ahead[read_ahead_pos].hash != block_hash) {
+            // Fetch the next blocks of the active chain together. The blocks are
+            // scanned in order below, and a reorg leads to fetching again.
+            read_ahead.clear();
+            read_ahead_pos = 0;
+            read_ahead.push_back({block_hash});
+            for (int height = block_height; read_ahead.size() < RESCAN_READ_AHEAD_BLOCKS && !(max_height && height >= *max_height); ++height) {
+                bool next_block = false;
+                uint256 next_block_hash;
+                chain().findBlock(read_ahead.back().hash, FoundBlock().nextBlock(FoundBlock().inActiveChain(next_block).hash(next_block_hash)));
+                if (!next_block) break;
+                read_ahead.push_back({next_block_hash});
+            }
+            FetchRescanBlocks(chain(), fast_rescan_filter.get(), read_ahead);
+            filter_updated = false;
+        }
+        RescanBlock& rescan_block = read_ahead[read_ahead_pos++];
+
+        // Blocks whose filter didn't match before scripts were added are matched again
+        if (filter_updated && rescan_block.filter_matches == false) {
+            rescan_block.filter_matches = fast_rescan_filter->MatchesBlock(block_hash);
+        }
+        const bool fetch_block{rescan_block.filter_matches.value_or(true)};
+        if (fetch_block && !rescan_block.read) {
+            chain().findBlock(block_hash, FoundBlock().data(rescan_block.block));
+            rescan_block.read = true;
+        }
+        const CBlock& block = rescan_block.block;
 
         // Find next block separately from reading data above, because reading
         // is slow and there might be a reorg while it is read.
@@ -1840,7 +2068,12 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
         uint256 next_block_hash;
         chain().findBlock(block_hash, FoundBlock().inActiveChain(block_still_active).nextBlock(FoundBlock().inActiveChain(next_block).hash(next_block_hash)));
 
-        if (!block.IsNull()) {
+        if (!fetch_block) {
+            // The block filter matches none of our scripts
+            result.last_scanned_block = block_hash;
+            result.last_scanned_height = block_height;
+            ++blocks_skipped;
+        } else if (!block.IsNull()) {
             LOCK(cs_wallet);
             if (!block_still_active) {
                 // Abort scan if current block is no longer active, to prevent
@@ -1852,6 +2085,7 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
                 SyncTransaction(block.vtx[posInBlock], TxStateConfirmed{block_hash, block_height, static_cast<int>(posInBlock)}, fUpdate, /*rescanning_old_block=*/true);
             }
+            rescan_block.block.SetNull();
             // scan succeeded, record block as most recent successfully scanned
             result.last_scanned_block = block_hash;
             result.last_scanned_height = block_height;
@@ -1908,6 +2142,9 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     } else {
         WalletLogPrintf("Rescan completed in %15dms\n", Ticks<std::chrono::milliseconds>(reserver.now() - start_time));
     }
+    if (fast_rescan_filter) {
+        WalletLogPrintf("Rescan skipped %d blocks not matching the block filters\n", blocks_skipped);
+    }
     return result;
 }
 
@@ -1939,7 +2176,10 @@ bool CWallet::SubmitTxMemoryPoolAndRelay(CWalletTx& wtx, std::string& err_string
     // If transaction was previously in the mempool, it should be updated when
     // TransactionRemovedFromMempool fires.
     bool ret = chain().broadcastTransaction(wtx.tx, GetDefaultMaxTxFee(), relay, err_string);
-    if (ret) wtx.m_state = TxStateInMempool{};
+    if (ret) {
+        wtx.m_state = TxStateInMempool{};
+        MarkBalancesDirty();
+    }
     return ret;
 }
 
@@ -2310,9 +2550,19 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     for (const uint256& hash : vHashOut) {
         const auto& it = mapWallet.find(hash);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
+        m_conversion_deadlines.erase({it->second.GetConversionDeadline(), hash});
         for (const auto& txin : it->second.tx->vin)
             mapTxSpends.erase(txin.prevout);
+        const CTransactionRef tx = it->second.tx;
         mapWallet.erase(it);
+        for (unsigned int i = 0; i < tx->vout.size(); ++i) {
+            if (tx->vout[i].amountType == CASH || tx->vout[i].amountType == BOND) {
+                m_unspent_txos[tx->vout[i].amountType].erase(COutPoint(hash, i));
+            }
+        }
+        for (const auto& txin : tx->vin) {
+            RefreshUnspentTXO(txin.prevout);
+        }
         NotifyTransactionChanged(hash, CT_DELETED);
     }
 
@@ -2411,6 +2661,23 @@ size_t CWallet::KeypoolCountExternalKeys() const
     return count;
 }
 
+size_t CWallet::DynamicMemoryUsage() const
+{
+    AssertLockHeld(cs_wallet);
+    size_t usage{memusage::DynamicUsage(mapWallet)};
+    for (const auto& [txid, wtx] : mapWallet) {
+        usage += RecursiveDynamicUsage(wtx.tx);
+    }
+    usage += memusage::DynamicUsage(mapTxSpends) + memusage::DynamicUsage(wtxOrdered);
+    for (const auto& [outpoint, spenders] : mapTxSpends) {
+        usage += memusage::DynamicUsage(spenders);
+    }
+    for (const auto& txos : m_unspent_txos) {
+        usage += memusage::DynamicUsage(txos);
+    }
+    return usage + memusage::DynamicUsage(m_address_book);
+}
+
 unsigned int CWallet::GetKeyPoolSize() const
 {
     AssertLockHeld(cs_wallet);
@@ -2482,6 +2749,7 @@ void CWallet::MarkDestinationsDirty(const std::set<CTxDestination>& destinations
             CTxDestination dst;
             if (ExtractDestination(wtx.tx->vout[i].scriptPubKey, dst) && destinations.count(dst)) {
                 wtx.MarkDirty();
+                MarkBalancesDirty();
                 break;
             }
         }
@@ -3327,26 +3595,36 @@ CAmountScaleFactor CWallet::GetBestScaleFactor(const CWalletTx& wtx) const
 {
     AssertLockHeld(cs_wallet);
 
-    std::optional<CAmountScaleFactor> scale_factor;
-    if (wtx.state<TxStateConfirmed>()) {
-        // Use scale factor at height of first confirmation
-        scale_factor = chain().findScaleFactorForHash(wtx.state<TxStateConfirmed>()->confirmed_block_hash);
-    } else if (wtx.state<TxStateExpired>()) {
-        // Use scale factor at height when it expired
-        scale_factor = chain().findScaleFactorAtHeight(wtx.GetConversionDeadline());
-    } else {
-        std::optional<int> chainHeight = chain().getHeight();
-        int conversionDeadline = wtx.GetConversionDeadline();
-        if (chainHeight && conversionDeadline > 0 && chainHeight.value() > conversionDeadline) {
-            // Use scale factor at height when it expired (We check because a
-            // replaced conversion will marked conflicted state and not expired)
-            scale_factor = chain().findScaleFactorAtHeight(conversionDeadline);
+    return GetBestScaleFactors({&wtx}).front();
+}
+
+std::vector<CAmountScaleFactor> CWallet::GetBestScaleFactors(const std::vector<const CWalletTx*>& wtxs) const
+{
+    AssertLockHeld(cs_wallet);
+
+    std::vector<interfaces::Chain::ScaleFactorQuery> blocks;
+    blocks.reserve(wtxs.size());
+    for (const CWalletTx* wtx : wtxs) {
+        if (auto* conf = wtx->state<TxStateConfirmed>()) {
+            // Use scale factor at height of first confirmation
+            blocks.emplace_back(conf->confirmed_block_hash);
+        } else if (int conversionDeadline = wtx->GetConversionDeadline(); conversionDeadline > 0) {
+            // Use scale factor at height when it expired, or the latest scale
+            // factor while it has not. We check the deadline rather than the
+            // expired state because a replaced conversion will be marked
+            // conflicted and not expired.
+            blocks.emplace_back(conversionDeadline);
         } else {
             // Use latest scale factor (transaction is neither confirmed nor expired)
-            scale_factor = chain().getLastScaleFactor();
+            blocks.emplace_back(std::numeric_limits<int>::max());
         }
     }
-    return scale_factor.value_or(BASE_FACTOR);
+    std::vector<CAmountScaleFactor> result;
+    result.reserve(wtxs.size());
+    for (const std::optional<CAmountScaleFactor>& scale_factor : chain().findScaleFactors(blocks)) {
+        result.push_back(scale_factor.value_or(BASE_FACTOR));
+    }
+    return result;
 }
 
 bool CWallet::IsExpired(const CWalletTx& wtx) const
@@ -3357,10 +3635,9 @@ bool CWallet::IsExpired(const CWalletTx& wtx) const
     if (!wtx.state<TxStateConfirmed>() && !wtx.state<TxStateExpired>()) {
         // Check in case tx is in a conflicted state (tx that is replaced before
         // it expires will be marked conflicted and not expired even after deadline
-        // passes)
-        std::optional<int> chainHeight = chain().getHeight();
+        // passes). The last processed block avoids a chain lookup per transaction.
         int conversionDeadline = wtx.GetConversionDeadline();
-        if (chainHeight && conversionDeadline > 0 && chainHeight.value() >= conversionDeadline) {
+        if (m_last_block_processed_height >= 0 && conversionDeadline > 0 && m_last_block_processed_height >= conversionDeadline) {
             is_expired = true;
         }
     }
@@ -3375,10 +3652,9 @@ int CWallet::ExpiresIn(const CWalletTx& wtx) const
         // Skip calculation if transaction is confirmed or we know it has expired
         return -1;
 
-    std::optional<int> chainHeight = chain().getHeight();
     int conversionDeadline = wtx.GetConversionDeadline();
-    if (chainHeight && conversionDeadline > 0 && chainHeight.value() <= conversionDeadline) {
-        return conversionDeadline - chainHeight.value();
+    if (m_last_block_processed_height >= 0 && conversionDeadline > 0 && m_last_block_processed_height <= conversionDeadline) {
+        return conversionDeadline - m_last_block_processed_height;
     } else {
         return -1;
     }
@@ -3761,6 +4037,8 @@ ScriptPubKeyMan* CWallet::AddWalletDescriptor(WalletDescriptor& desc, const Flat
     }
 
     // Top up key pool, the manager will generate new scriptPubKeys internally
+    m_unspent_txos_stale = true;
+    MarkBalancesDirty();
     if (!spk_man->TopUp()) {
         WalletLogPrintf("Could not top up scriptPubKeys\n");
         return nullptr;
@@ -3845,6 +4123,7 @@ bool CWallet::MigrateToSQLite(bilingual_str& error)
     m_database = std::move(new_db);
 
     // Write existing records into the new DB
+    WalletLogPrintf("Copying %u records into the SQLite database\n", records.size());
     batch = m_database->MakeBatch();
     bool began = batch->TxnBegin();
     assert(began); // This is a critical error, the new db could not be written to. The original db exists as a backup, but we should not continue execution.
@@ -4194,8 +4473,19 @@ util::Result<MigrationResult> MigrateLegacyToDescriptor(std::shared_ptr<CWallet>
         // First change to using SQLite
         if (!local_wallet->MigrateToSQLite(error)) return util::Error{error};
 
-        // Do the migration, and cleanup if it fails
+        // Do the migration, and cleanup if it fails. All of its writes to the
+        // wallet's database are made in a single transaction, rather than
+        // committing every record of every new descriptor on its own.
+        std::unique_ptr<DatabaseBatch> batch = local_wallet->GetDatabase().MakeBatch();
+        const bool began = batch->TxnBegin();
         success = DoMigration(*local_wallet, context, error, res);
+        if (began) {
+            if (success && !batch->TxnCommit()) {
+                error = _("Error: Unable to write the migrated wallet to the database");
+                success = false;
+            }
+            if (!success) batch->TxnAbort();
+        }
     }
 
     if (success) {
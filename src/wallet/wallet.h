@@ -12,6 +12,7 @@
 #include <interfaces/handler.h>
 #include <outputtype.h>
 #include <policy/feerate.h>
+#include <prevector.h>
 #include <psbt.h>
 #include <tinyformat.h>
 #include <util/hasher.h>
@@ -29,6 +30,7 @@
 #include <wallet/walletutil.h>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <map>
 #include <memory>
@@ -37,6 +39,7 @@
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <unordered_map>
 #include <vector>
@@ -233,6 +236,15 @@ struct CRecipient
     bool fSubtractFeeFromAmount;
 };
 
+struct Balance {
+    CAmount m_mine_trusted{0};           //!< Trusted, at depth=GetBalance.min_depth or more
+    CAmount m_mine_untrusted_pending{0}; //!< Untrusted, but in mempool (pending)
+    CAmount m_mine_immature{0};          //!< Immature coinbases in the main chain
+    CAmount m_watchonly_trusted{0};
+    CAmount m_watchonly_untrusted_pending{0};
+    CAmount m_watchonly_immature{0};
+};
+
 class WalletRescanReserver; //forward declarations for ScanForWalletTransactions/RescanFromTime
 /**
  * A CWallet maintains a set of transactions and balances, and provides the ability to create new transactions.
@@ -266,12 +278,38 @@ private:
      * Used to keep track of spent outpoints, and
      * detect and report conflicts (double-spends or
      * mutated transactions where the mutant gets mined).
+     * Most outpoints have a single spender, which is stored inline.
      */
-    typedef std::unordered_multimap<COutPoint, uint256, SaltedOutpointHasher> TxSpends;
+    typedef prevector<1, uint256> TxSpenders;
+    typedef std::unordered_map<COutPoint, TxSpenders, SaltedOutpointHasher> TxSpends;
     TxSpends mapTxSpends GUARDED_BY(cs_wallet);
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid, WalletBatch* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const CWalletTx& wtx, WalletBatch* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Outputs of wallet transactions that are ours and not spent by another
+     * wallet transaction, by amount type. Coin selection starts from these
+     * instead of scanning every output of mapWallet. The sets may still hold
+     * outputs that became spent or stopped being ours without the entry being
+     * refreshed, so users must check both, but they never miss an output that
+     * is ours and unspent.
+     *
+     * The sets are rebuilt from mapWallet on first use after loading and after
+     * scripts were imported, as outputs already in the wallet may have become ours.
+     */
+    mutable std::array<std::set<COutPoint>, 2> m_unspent_txos GUARDED_BY(cs_wallet);
+    mutable bool m_unspent_txos_stale GUARDED_BY(cs_wallet){true};
+    void RebuildUnspentTXOs() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /**
+     * Results of GetBalance by amount type, min_depth and avoid_reuse. They
+     * depend on the state, mempool presence and depth of the wallet
+     * transactions, so any change to those must call MarkBalancesDirty.
+     */
+    mutable std::map<std::tuple<CAmountType, int, bool>, Balance> m_cached_balances GUARDED_BY(cs_wallet);
+    /** Add an output to, or remove it from, m_unspent_txos */
+    void RefreshUnspentTXO(const COutPoint& outpoint) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Add a transaction to the wallet, or update it.  confirm.block_* should
      * be set when the transaction was known to be included in a block.  When
@@ -293,10 +331,10 @@ private:
     /** Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, int conflicting_height, const uint256& hashTx);
 
-    /** Mark a transaction's inputs dirty, thus forcing the outputs to be recomputed */
+    /** Mark a transaction's inputs dirty, thus forcing the outputs to be recomputed, and refresh them in m_unspent_txos */
     void MarkInputsDirty(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
-    void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void SyncMetaData(const TxSpenders& spenders) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     void SyncTransaction(const CTransactionRef& tx, const SyncTxState& state, bool update_tx = true, bool rescanning_old_block = false) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
@@ -383,12 +421,14 @@ public:
           m_name(name),
           m_database(std::move(database))
     {
+        RegisterProfiledLock(&cs_wallet, "cs_wallet");
     }
 
     ~CWallet()
     {
         // Should not have slots connected at this point.
         assert(NotifyUnload.empty());
+        UnregisterProfiledLock(&cs_wallet);
     }
 
     bool IsCrypted() const;
@@ -405,6 +445,11 @@ public:
     typedef std::multimap<int64_t, CWalletTx*> TxItems;
     TxItems wtxOrdered;
 
+    /** Conversions that may still expire, ordered by deadline. Entries of
+     * conversions that were confirmed or conflicted in the meantime are only
+     * removed once their deadline is reached. */
+    std::set<std::pair<int, uint256>> m_conversion_deadlines GUARDED_BY(cs_wallet);
+
     int64_t nOrderPosNext GUARDED_BY(cs_wallet) = 0;
     uint64_t nAccountingEntryNumber = 0;
 
@@ -454,11 +499,17 @@ public:
      * Otherwise, returns the latest scale factor.
      */
     CAmountScaleFactor GetBestScaleFactor(const CWalletTx& wtx) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** GetBestScaleFactor of several transactions, looked up with a single chain call */
+    std::vector<CAmountScaleFactor> GetBestScaleFactors(const std::vector<const CWalletTx*>& wtxs) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     /**
      * @return true if state is Expired or block number exceeds conversion deadline (if present)
      */
     bool IsExpired(const CWalletTx& wtx) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Add the transaction to m_conversion_deadlines if it is a conversion that may still expire */
+    void AddConversionDeadline(const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Mark the conversions whose deadline is at or below the height as expired */
+    void ExpireConversions(int height) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     /**
      * @return number of blocks until conversion deadline passes (-1 if deadline not present or already passed)
@@ -470,6 +521,15 @@ public:
 
     bool IsSpent(const COutPoint& outpoint) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /** Outputs of the given amount type that may be ours and unspent, see m_unspent_txos */
+    const std::set<COutPoint>& GetUnspentTXOs(CAmountType amount_type) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /** Cached GetBalance result, if any */
+    std::optional<Balance> GetCachedBalance(CAmountType amount_type, int min_depth, bool avoid_reuse) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void SetCachedBalance(CAmountType amount_type, int min_depth, bool avoid_reuse, const Balance& balance) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Forget the cached GetBalance results */
+    void MarkBalancesDirty() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) { AssertLockHeld(cs_wallet); m_cached_balances.clear(); }
+
     // Whether this or any known scriptPubKey with the same single key has been spent.
     bool IsSpentKey(const CScript& scriptPubKey) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void SetSpentKeyState(WalletBatch& batch, const uint256& hash, unsigned int n, bool used, std::set<CTxDestination>& tx_destinations) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
@@ -669,6 +729,9 @@ public:
     CAmount GetDefaultMaxTxFee() const;
 
     size_t KeypoolCountExternalKeys() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /** Approximate memory used by the transactions, the indexes into them and the address book */
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     bool TopUpKeyPool(unsigned int kpSize = 0);
 
     std::optional<int64_t> GetOldestKeyPoolTime() const;
@@ -915,6 +978,7 @@ public:
         AssertLockHeld(cs_wallet);
         m_last_block_processed_height = block_height;
         m_last_block_processed = block_hash;
+        MarkBalancesDirty();
     };
 
     //! Connect the signals from ScriptPubKeyMans to the signals in CWallet
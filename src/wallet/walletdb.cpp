@@ -12,6 +12,7 @@
 #include <sync.h>
 #include <util/bip32.h>
 #include <util/system.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/translation.h>
 #ifdef USE_BDB
@@ -22,6 +23,7 @@
 #endif
 #include <wallet/wallet.h>
 
+#include <algorithm>
 #include <atomic>
 #include <optional>
 #include <string>
@@ -315,10 +317,85 @@ public:
     std::map<uint160, CHDChain> m_hd_chains;
     bool tx_corrupt{false};
     bool descriptor_unknown{false};
+    //! Whether tx records are collected in m_tx_records rather than loaded as they are read
+    bool m_defer_tx_records{false};
+    //! Hashes and values of tx records that still have to be loaded
+    std::vector<std::pair<uint256, CDataStream>> m_tx_records;
 
     CWalletScanState() = default;
 };
 
+//! Number of tx records collected before they are decoded and loaded together
+static constexpr size_t TX_RECORD_BATCH_SIZE{10000};
+//! Maximum number of threads decoding the transactions of tx records
+static constexpr unsigned int MAX_TX_DECODE_THREADS{8};
+
+/** Load a wallet transaction, given the transaction already read from its tx record and the rest of the record's value */
+static bool LoadTxRecord(CWallet* pwallet, const uint256& hash, CTransactionRef tx, CDataStream& ssValue,
+                         CWalletScanState& wss, std::string& strErr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    // LoadToWallet call below creates a new CWalletTx that fill_wtx
+    // callback fills with transaction metadata.
+    auto fill_wtx = [&](CWalletTx& wtx, bool new_tx) {
+        if(!new_tx) {
+            // There's some corruption here since the tx we just tried to load was already in the wallet.
+            // We don't consider this type of corruption critical, and can fix it by removing tx data and
+            // rescanning.
+            wss.tx_corrupt = true;
+            return false;
+        }
+        wtx.UnserializeAfterTx(std::move(tx), ssValue);
+        if (wtx.GetHash() != hash)
+            return false;
+
+        // Undo serialize changes in 31600
+        if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
+        {
+            if (!ssValue.empty())
+            {
+                uint8_t fTmp;
+                uint8_t fUnused;
+                std::string unused_string;
+                ssValue >> fTmp >> fUnused >> unused_string;
+                strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
+                                   wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
+                wtx.fTimeReceivedIsTxTime = fTmp;
+            }
+            else
+            {
+                strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
+                wtx.fTimeReceivedIsTxTime = 0;
+            }
+            wss.vWalletUpgrade.push_back(hash);
+        }
+
+        if (wtx.nOrderPos == -1)
+            wss.fAnyUnordered = true;
+
+        return true;
+    };
+    return pwallet->LoadToWallet(hash, fill_wtx);
+}
+
+/**
+ * Read the transactions at the start of the values of tx records, on tasks of
+ * the shared thread pool. Decoding and hashing the transactions is most of the cost of loading
+ * them. Returns the transactions in the order of the records, with nullptr and
+ * an error message for those that could not be read.
+ */
+static std::vector<std::pair<CTransactionRef, std::string>> DecodeTxRecords(std::vector<std::pair<uint256, CDataStream>>& tx_records)
+{
+    std::vector<std::pair<CTransactionRef, std::string>> decoded(tx_records.size());
+    util::ParallelFor("wallettxs", util::TaskPriority::NORMAL, tx_records.size(), MAX_TX_DECODE_THREADS, [&](size_t i) {
+        try {
+            tx_records[i].second >> decoded[i].first;
+        } catch (const std::exception& e) {
+            decoded[i] = {nullptr, e.what()};
+        }
+    });
+    return decoded;
+}
+
 static bool
 ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
              CWalletScanState &wss, std::string& strType, std::string& strErr, const KeyFilterFn& filter_fn = nullptr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
@@ -345,47 +422,13 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
         } else if (strType == DBKeys::TX) {
             uint256 hash;
             ssKey >> hash;
-            // LoadToWallet call below creates a new CWalletTx that fill_wtx
-            // callback fills with transaction metadata.
-            auto fill_wtx = [&](CWalletTx& wtx, bool new_tx) {
-                if(!new_tx) {
-                    // There's some corruption here since the tx we just tried to load was already in the wallet.
-                    // We don't consider this type of corruption critical, and can fix it by removing tx data and
-                    // rescanning.
-                    wss.tx_corrupt = true;
-                    return false;
-                }
-                ssValue >> wtx;
-                if (wtx.GetHash() != hash)
-                    return false;
-
-                // Undo serialize changes in 31600
-                if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
-                {
-                    if (!ssValue.empty())
-                    {
-                        uint8_t fTmp;
-                        uint8_t fUnused;
-                        std::string unused_string;
-                        ssValue >> fTmp >> fUnused >> unused_string;
-                        strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
-                                           wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
-                        wtx.fTimeReceivedIsTxTime = fTmp;
-                    }
-                    else
-                    {
-                        strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                        wtx.fTimeReceivedIsTxTime = 0;
-                    }
-                    wss.vWalletUpgrade.push_back(hash);
-                }
-
-                if (wtx.nOrderPos == -1)
-                    wss.fAnyUnordered = true;
-
+            if (wss.m_defer_tx_records) {
+                wss.m_tx_records.emplace_back(hash, std::move(ssValue));
                 return true;
-            };
-            if (!pwallet->LoadToWallet(hash, fill_wtx)) {
+            }
+            CTransactionRef tx;
+            ssValue >> tx;
+            if (!LoadTxRecord(pwallet, hash, std::move(tx), ssValue, wss, strErr)) {
                 return false;
             }
         } else if (strType == DBKeys::WATCHS) {
@@ -775,6 +818,39 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
 
     LOCK(pwallet->cs_wallet);
 
+    // Tx records are collected while reading, so that their transactions can be
+    // decoded on several threads before they are loaded in the order they were read
+    wss.m_defer_tx_records = true;
+    const auto load_tx_records = [&]() EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
+        auto decoded{DecodeTxRecords(wss.m_tx_records)};
+        for (size_t i = 0; i < wss.m_tx_records.size(); ++i) {
+            auto& [hash, ssValue] = wss.m_tx_records[i];
+            auto& [tx, strErr] = decoded[i];
+            bool loaded{false};
+            if (tx) {
+                try {
+                    loaded = LoadTxRecord(pwallet, hash, std::move(tx), ssValue, wss, strErr);
+                } catch (const std::exception& e) {
+                    if (strErr.empty()) strErr = e.what();
+                }
+            }
+            if (!loaded) {
+                if (wss.tx_corrupt) {
+                    pwallet->WalletLogPrintf("Error: Corrupt transaction found. This can be fixed by removing transactions from wallet and rescanning.\n");
+                    wss.tx_corrupt = false;
+                    result = DBErrors::CORRUPT;
+                } else {
+                    // Rescan if there is a bad transaction record
+                    fNoncriticalErrors = true;
+                    rescan_required = true;
+                }
+            }
+            if (!strErr.empty())
+                pwallet->WalletLogPrintf("%s\n", strErr);
+        }
+        wss.m_tx_records.clear();
+    };
+
     // Last client version to open this wallet
     int last_client = CLIENT_VERSION;
     bool has_last_client = m_batch->Read(DBKeys::VERSION, last_client);
@@ -862,7 +938,9 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
             }
             if (!strErr.empty())
                 pwallet->WalletLogPrintf("%s\n", strErr);
+            if (wss.m_tx_records.size() >= TX_RECORD_BATCH_SIZE) load_tx_records();
         }
+        load_tx_records();
     } catch (...) {
         result = DBErrors::CORRUPT;
     }
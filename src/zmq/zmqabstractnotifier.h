@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 
+class CBlock;
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
@@ -46,7 +47,7 @@ public:
     // Notifies of ConnectTip result, i.e., new active tip only
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     // Notifies of every block connection
-    virtual bool NotifyBlockConnect(const CBlockIndex *pindex);
+    virtual bool NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block);
     // Notifies of every block disconnection
     virtual bool NotifyBlockDisconnect(const CBlockIndex *pindex);
     // Notifies of every mempool acceptance
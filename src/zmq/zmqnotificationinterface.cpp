@@ -37,6 +37,8 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubrawconversion"] = CZMQAbstractNotifier::Create<CZMQPublishRawConversionNotifier>;
+    factories["pubsupply"] = CZMQAbstractNotifier::Create<CZMQPublishSupplyNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -168,8 +170,8 @@ void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBloc
     }
 
     // Next we notify BlockConnect listeners for *all* blocks
-    TryForEachAndRemoveFailed(notifiers, [pindexConnected](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyBlockConnect(pindexConnected);
+    TryForEachAndRemoveFailed(notifiers, [pindexConnected, &pblock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockConnect(pindexConnected, pblock);
     });
 }
 
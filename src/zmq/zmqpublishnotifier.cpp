@@ -8,13 +8,18 @@
 #include <chainparams.h>
 #include <netbase.h>
 #include <node/blockstorage.h>
+#include <primitives/block.h>
 #include <rpc/server.h>
+#include <script/standard.h>
 #include <streams.h>
+#include <undo.h>
 #include <util/system.h>
+#include <validation.h>
 #include <zmq/zmqutil.h>
 
 #include <zmq.h>
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstddef>
 #include <map>
@@ -23,6 +28,7 @@
 #include <utility>
 
 using node::ReadBlockFromDisk;
+using node::UndoReadFromDisk;
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier*> mapPublishNotifiers;
 
@@ -31,6 +37,68 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_RAWCONVERSION = "rawconversion";
+static const char *MSG_SUPPLY    = "supply";
+
+// Internal function to send one part of a multipart message
+static int zmq_send_part(void *sock, const void* data, size_t size, int flags)
+{
+    zmq_msg_t msg;
+
+    int rc = zmq_msg_init_size(&msg, size);
+    if (rc != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        return -1;
+    }
+
+    void *buf = zmq_msg_data(&msg);
+    memcpy(buf, data, size);
+
+    rc = zmq_msg_send(&msg, sock, flags);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return -1;
+    }
+
+    zmq_msg_close(&msg);
+    return 0;
+}
+
+static void zmq_free_payload(void* /*data*/, void* hint)
+{
+    delete static_cast<ZMQPayload*>(hint);
+}
+
+// Internal function to send one part of a multipart message without copying
+// it. The message holds a reference to the payload, which ZMQ drops once the
+// part has been sent.
+static int zmq_send_payload(void *sock, const ZMQPayload& payload, int flags)
+{
+    zmq_msg_t msg;
+
+    auto* ref = new ZMQPayload(payload);
+    int rc = zmq_msg_init_data(&msg, const_cast<unsigned char*>(payload->data()), payload->size(), zmq_free_payload, ref);
+    if (rc != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        delete ref;
+        return -1;
+    }
+
+    rc = zmq_msg_send(&msg, sock, flags);
+    if (rc == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return -1;
+    }
+
+    zmq_msg_close(&msg);
+    return 0;
+}
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -40,41 +108,34 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
 
     while (1)
     {
-        zmq_msg_t msg;
+        const void* next = va_arg(args, const void*);
 
-        int rc = zmq_msg_init_size(&msg, size);
-        if (rc != 0)
+        if (zmq_send_part(sock, data, size, next ? ZMQ_SNDMORE : 0) == -1)
         {
-            zmqError("Unable to initialize ZMQ msg");
             va_end(args);
             return -1;
         }
 
-        void *buf = zmq_msg_data(&msg);
-        memcpy(buf, data, size);
-
-        data = va_arg(args, const void*);
-
-        rc = zmq_msg_send(&msg, sock, data ? ZMQ_SNDMORE : 0);
-        if (rc == -1)
-        {
-            zmqError("Unable to send ZMQ msg");
-            zmq_msg_close(&msg);
-            va_end(args);
-            return -1;
-        }
-
-        zmq_msg_close(&msg);
-
-        if (!data)
+        if (!next)
             break;
 
+        data = next;
         size = va_arg(args, size_t);
     }
     va_end(args);
     return 0;
 }
 
+/** Serialize an object for sending as a message payload */
+template <typename T>
+static std::shared_ptr<std::vector<unsigned char>> SerializePayload(const T& obj, size_t size_hint)
+{
+    auto payload = std::make_shared<std::vector<unsigned char>>();
+    payload->reserve(size_hint);
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), *payload, 0} << obj;
+    return payload;
+}
+
 static bool IsZMQAddressIPV6(const std::string &zmq_address)
 {
     const std::string tcp_prefix = "tcp://";
@@ -204,6 +265,25 @@ bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void
     return true;
 }
 
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, ZMQPayload payload)
+{
+    assert(psocket);
+
+    /* send three parts, command & data & a LE 4byte sequence number */
+    unsigned char msgseq[sizeof(uint32_t)];
+    WriteLE32(msgseq, nSequence);
+    if (zmq_send_part(psocket, command, strlen(command), ZMQ_SNDMORE) == -1 ||
+        zmq_send_payload(psocket, payload, ZMQ_SNDMORE) == -1 ||
+        zmq_send_part(psocket, msgseq, sizeof(msgseq), 0) == -1) {
+        return false;
+    }
+
+    /* increment memory only sequence number after sending */
+    nSequence++;
+
+    return true;
+}
+
 bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     uint256 hash = pindex->GetBlockHash();
@@ -230,30 +310,36 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     LogPrint(BCLog::ZMQ, "Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
+    // The new tip is normally the last block connected, otherwise read it from disk
+    std::shared_ptr<const CBlock> block = std::move(m_connected_block);
+    if (!block || block->GetHash() != pindex->GetBlockHash()) {
+        const Consensus::Params& consensusParams = Params().GetConsensus();
+        auto disk_block = std::make_shared<CBlock>();
         LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
+        if(!ReadBlockFromDisk(*disk_block, pindex, consensusParams))
         {
             zmqError("Can't read block from disk");
             return false;
         }
-
-        ss << block;
+        block = std::move(disk_block);
     }
 
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    size_t size_hint = ::GetSerializeSize(block->GetBlockHeader(), PROTOCOL_VERSION) + GetSizeOfCompactSize(block->vtx.size());
+    for (const CTransactionRef& tx : block->vtx) size_hint += tx->GetTotalSize();
+    return SendZmqMessage(MSG_RAWBLOCK, SerializePayload(*block, size_hint));
+}
+
+bool CZMQPublishRawBlockNotifier::NotifyBlockConnect(const CBlockIndex * /*pindex*/, const std::shared_ptr<const CBlock>& block)
+{
+    m_connected_block = block;
+    return true;
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "Publish rawtx %s to %s\n", hash.GetHex(), this->address);
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendZmqMessage(MSG_RAWTX, SerializePayload(transaction, transaction.GetTotalSize()));
 }
 
 // Helper function to send a 'sequence' topic message with the following structure:
@@ -269,7 +355,7 @@ static bool SendSequenceMsg(CZMQAbstractPublishNotifier& notifier, uint256 hash,
     return notifier.SendZmqMessage(MSG_SEQUENCE, data, sequence ? sizeof(data) : sizeof(hash) + sizeof(label));
 }
 
-bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*block*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "Publish sequence block connect %s to %s\n", hash.GetHex(), this->address);
@@ -296,3 +382,55 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogPrint(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+bool CZMQPublishRawConversionNotifier::NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block)
+{
+    // The genesis block contains no conversions
+    if (!pindex->pprev) return true;
+
+    const bool has_conversions = std::any_of(block->vtx.begin() + 1, block->vtx.end(), [](const CTransactionRef& tx) {
+        return GetConversionInfo(*tx).has_value();
+    });
+    if (!has_conversions) return true;
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        zmqError("Can't read block undo data from disk");
+        return false;
+    }
+
+    const auto conversions = ReplayBlockConversions(*block, block_undo, pindex->pprev->GetTotalSupply());
+    if (!conversions) {
+        zmqError("Can't replay conversion of connected block");
+        return false;
+    }
+    for (const BlockConversion& conversion : *conversions) {
+        const CTransaction& tx = *block->vtx[conversion.tx_index];
+        LogPrint(BCLog::ZMQ, "Publish rawconversion %s to %s\n", tx.GetHash().GetHex(), this->address);
+        // <serialized transaction> | <1-byte remainder type> | <8-byte LE remainder>
+        auto payload = SerializePayload(tx, tx.GetTotalSize() + sizeof(CAmountType) + sizeof(CAmount));
+        CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, *payload, payload->size()} << conversion.info.remainderType << conversion.remainder;
+        if (!SendZmqMessage(MSG_RAWCONVERSION, std::move(payload))) return false;
+    }
+    return true;
+}
+
+bool CZMQPublishSupplyNotifier::NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*block*/)
+{
+    uint256 hash = pindex->GetBlockHash();
+    LogPrint(BCLog::ZMQ, "Publish supply %s to %s\n", hash.GetHex(), this->address);
+
+    // <32-byte hash> | <4-byte LE height> | <8-byte LE cash supply> | <8-byte LE bond supply>
+    //   | <8-byte LE scale factor> | <8-byte LE interest rate>
+    unsigned char data[sizeof(hash) + sizeof(uint32_t) + 4 * sizeof(uint64_t)];
+    for (unsigned int i = 0; i < sizeof(hash); ++i) {
+        data[sizeof(hash) - 1 - i] = hash.begin()[i];
+    }
+    unsigned char* p = data + sizeof(hash);
+    WriteLE32(p, pindex->nHeight);
+    WriteLE64(p + 4, pindex->cashSupply);
+    WriteLE64(p + 12, pindex->bondSupply);
+    WriteLE64(p + 20, pindex->scaleFactor);
+    WriteLE64(p + 28, pindex->GetInterestRate());
+    return SendZmqMessage(MSG_SUPPLY, data, sizeof(data));
+}
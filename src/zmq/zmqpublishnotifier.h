@@ -7,8 +7,15 @@
 
 #include <zmq/zmqabstractnotifier.h>
 
+#include <memory>
+#include <vector>
+
+class CBlock;
 class CBlockIndex;
 
+/** Serialized message data shared with ZMQ until it has been sent */
+using ZMQPayload = std::shared_ptr<const std::vector<unsigned char>>;
+
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
@@ -24,6 +31,10 @@ public:
     */
     bool SendZmqMessage(const char *command, const void* data, size_t size);
 
+    /* send zmq multipart message without copying the data, which ZMQ
+       holds a reference to until it has been sent */
+    bool SendZmqMessage(const char *command, ZMQPayload payload);
+
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
 };
@@ -42,8 +53,13 @@ public:
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
+private:
+    //! Last connected block, published instead of reading the new tip from disk
+    std::shared_ptr<const CBlock> m_connected_block;
+
 public:
     bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -55,10 +71,22 @@ public:
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlockConnect(const CBlockIndex *pindex) override;
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
     bool NotifyBlockDisconnect(const CBlockIndex *pindex) override;
     bool NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence) override;
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+class CZMQPublishRawConversionNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
+};
+
+class CZMQPublishSupplyNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the -blockcompression option.
+
+Block and undo files whose blocks are all buried are compressed, and blocks
+are read from them as before, including when reindexing.
+"""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class BlockCompressionTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        # -fastprune keeps the block files small, so that several are written
+        self.extra_args = [["-blockcompression", "-fastprune"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_platform_not_linux()
+
+    def run_test(self):
+        node = self.nodes[0]
+        blocks_dir = os.path.join(node.datadir, self.chain, "blocks")
+
+        self.log.info("Mine enough blocks to bury the first block file")
+        self.generate(node, 1000)
+        old_blocks = [node.getblock(node.getblockhash(height), 0) for height in (1, 100, 200)]
+
+        self.log.info("Run the compression task until the first block and undo files are compressed")
+        def compressed():
+            node.mockscheduler(10)
+            return os.path.isfile(os.path.join(blocks_dir, "blk00000.cdat")) and os.path.isfile(os.path.join(blocks_dir, "rev00000.cdat"))
+        self.wait_until(compressed)
+        assert not os.path.isfile(os.path.join(blocks_dir, "blk00000.dat"))
+        assert not os.path.isfile(os.path.join(blocks_dir, "rev00000.dat"))
+        # The file blocks are still written to is left as is
+        last_file = max(name for name in os.listdir(blocks_dir) if name.startswith("blk"))
+        assert last_file.endswith(".dat")
+
+        self.log.info("Blocks are read from the compressed files")
+        assert_equal([node.getblock(node.getblockhash(height), 0) for height in (1, 100, 200)], old_blocks)
+
+        self.log.info("Undo data is read from the compressed files")
+        tip = node.getbestblockhash()
+        node.invalidateblock(node.getblockhash(5))
+        assert_equal(node.getblockcount(), 4)
+        node.reconsiderblock(node.getblockhash(5))
+        assert_equal(node.getbestblockhash(), tip)
+
+        self.log.info("Reindexing reads the compressed files")
+        self.restart_node(0, extra_args=self.extra_args[0] + ["-reindex"])
+        self.wait_until(lambda: node.getblockcount() == 1000)
+        assert_equal(node.getbestblockhash(), tip)
+        assert_equal([node.getblock(node.getblockhash(height), 0) for height in (1, 100, 200)], old_blocks)
+
+
+if __name__ == '__main__':
+    BlockCompressionTest().main()
@@ -5,6 +5,7 @@
 """Test peerfed-cli"""
 
 from decimal import Decimal
+import json
 import re
 
 from test_framework.blocktools import COINBASE_MATURITY
@@ -94,6 +95,16 @@ class TestBitcoinCli(BitcoinTestFramework):
         assert_equal(['foo', 'bar'], self.nodes[0].cli(f'-rpcuser={user}', '-stdin', '-stdinrpcpass', input=f'{password}\nfoo\nbar').echo())
         assert_raises_process_error(1, 'Incorrect rpcuser or rpcpassword', self.nodes[0].cli(f'-rpcuser={user}', '-stdin', '-stdinrpcpass', input='foo').echo)
 
+        self.log.info("Test -batch")
+        batch = self.nodes[0].cli('-batch', '-batchsize=2', input='getblockcount\n\necho foo "bar baz" \'qux\'\ngetblockhash 0\n').send_cli()
+        assert_equal([json.loads(line) for line in batch.splitlines()], [
+            {'result': BLOCKS, 'error': None},
+            {'result': ['foo', 'bar baz', 'qux'], 'error': None},
+            {'result': self.nodes[0].getblockhash(0), 'error': None},
+        ])
+        assert_raises_process_error(1, "-batch can not be combined", self.nodes[0].cli('-batch', '-getinfo').send_cli)
+        assert_raises_process_error(1, "-batch takes no arguments", self.nodes[0].cli('-batch').echo)
+
         self.log.info("Test connecting to a non-existing server")
         assert_raises_process_error(1, "Could not connect to the server", self.nodes[0].cli('-rpcport=1').echo)
 
@@ -5,14 +5,16 @@
 """Test the RPC HTTP basics."""
 
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.util import assert_equal, str_to_b64str
+from test_framework.util import assert_equal, assert_greater_than_or_equal, str_to_b64str
 
 import http.client
+import socket
 import urllib.parse
 
 class HTTPBasicsTest (BitcoinTestFramework):
     def set_test_params(self):
         self.num_nodes = 3
+        self.extra_args = [[], ['-rpcmaxrequestsperconnection=2'], []]
         self.supports_cli = False
 
     def setup_network(self):
@@ -68,7 +70,21 @@ class HTTPBasicsTest (BitcoinTestFramework):
         assert b'"error":null' in out1
         assert conn.sock is None  #now the connection must be closed after the response
 
-        #node1 (2nd node) is running with disabled keep-alive option
+        #pipelined requests are answered in order over the same connection
+        request = (f'POST / HTTP/1.1\r\nHost: {url.hostname}\r\nAuthorization: {headers["Authorization"]}\r\n'
+                   'Content-Length: {}\r\n\r\n{}')
+        bodies = [f'{{"method": "getblockhash", "params": [0], "id": {i}}}' for i in range(3)]
+        with socket.create_connection((url.hostname, url.port)) as sock:
+            sock.sendall(''.join(request.format(len(body), body) for body in bodies).encode())
+            out1 = b''
+            while out1.count(b'"error":null') < len(bodies):
+                data = sock.recv(4096)
+                assert data  #the connection must stay open until all requests are answered
+                out1 += data
+        assert_equal(out1.count(b'HTTP/1.1 200 OK'), len(bodies))
+        assert out1.index(b'"id":0') < out1.index(b'"id":1') < out1.index(b'"id":2')
+
+        #node1 (2nd node) closes kept-alive connections after two requests
         urlNode1 = urllib.parse.urlparse(self.nodes[1].url)
         authpair = f'{urlNode1.username}:{urlNode1.password}'
         headers = {"Authorization": f"Basic {str_to_b64str(authpair)}"}
@@ -78,6 +94,12 @@ class HTTPBasicsTest (BitcoinTestFramework):
         conn.request('POST', '/', '{"method": "getbestblockhash"}', headers)
         out1 = conn.getresponse().read()
         assert b'"error":null' in out1
+        assert conn.sock is not None
+        conn.request('POST', '/', '{"method": "getbestblockhash"}', headers)
+        out1 = conn.getresponse().read()
+        assert b'"error":null' in out1
+        assert conn.sock is None  #the request limit of the connection was reached
+        assert_greater_than_or_equal(self.nodes[1].getrpcinfo()['connections']['request_limit_closes'], 1)
 
         #node2 (third node) is running with standard keep-alive parameters which means keep-alive is on
         urlNode2 = urllib.parse.urlparse(self.nodes[2].url)
@@ -17,6 +17,8 @@ import urllib.parse
 from test_framework.messages import (
     BLOCK_HEADER_SIZE,
     COIN,
+    CTransaction,
+    deser_vector,
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -62,14 +64,14 @@ class RESTTest (BitcoinTestFramework):
             self,
             uri: str,
             http_method: str = 'GET',
-            req_type: ReqType = ReqType.JSON,
+            req_type: typing.Optional[ReqType] = ReqType.JSON,
             body: str = '',
             status: int = 200,
             ret_type: RetType = RetType.JSON,
             query_params: typing.Dict[str, typing.Any] = None,
             ) -> typing.Union[http.client.HTTPResponse, bytes, str, None]:
         rest_uri = '/rest' + uri
-        if req_type in ReqType:
+        if req_type is not None:
             rest_uri += f'.{req_type.name.lower()}'
         if query_params:
             rest_uri += f'?{urllib.parse.urlencode(query_params)}'
@@ -313,6 +315,59 @@ class RESTTest (BitcoinTestFramework):
                 self.test_rest_request(f"/headers/{bb_hash}", ret_type=RetType.BYTES, status=400, query_params={"count": num}),
             )
 
+        self.log.info("Test the /blockrange, /supply and /headersupply URIs")
+        start_height = block_json_obj['height']
+        blocks_bytes = b''
+        for height in range(start_height, start_height + 5):
+            blocks_bytes += self.test_rest_request(f"/block/{self.nodes[0].getblockhash(height)}", req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        assert_equal(self.test_rest_request(f"/blockrange/{start_height}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 5}), blocks_bytes)
+        resp_hex = self.test_rest_request(f"/blockrange/{start_height}", req_type=ReqType.HEX, ret_type=RetType.OBJ, query_params={"count": 5})
+        assert_equal(resp_hex.read().decode('utf-8').rstrip(), blocks_bytes.hex())
+        # The range stops at the tip
+        assert_equal(self.test_rest_request(f"/blockrange/{start_height}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 100}), blocks_bytes)
+        self.test_rest_request(f"/blockrange/{start_height}", ret_type=RetType.OBJ, status=404)
+        self.test_rest_request("/blockrange/1000000", req_type=ReqType.BIN, ret_type=RetType.OBJ, status=404)
+        self.test_rest_request(f"/blockrange/{start_height}", req_type=ReqType.BIN, ret_type=RetType.OBJ, status=400, query_params={"count": 101})
+
+        json_obj = self.test_rest_request(f"/supply/{start_height}", query_params={"count": 5})
+        assert_equal(len(json_obj), 5)
+        supply_bytes = b''
+        for entry in json_obj:
+            header = self.nodes[0].getblockheader(self.nodes[0].getblockhash(entry['height']))
+            for key in ['cashSupply', 'bondSupply', 'unscaledCashSupply', 'unscaledBondSupply', 'scaleFactor']:
+                assert_equal(entry[key], header[key])
+            supply_bytes += pack("<qqQ", int(header['unscaledCashSupply'] * COIN), int(header['unscaledBondSupply'] * COIN), int(header['scaleFactor'] * 10**10))
+        assert_equal(self.test_rest_request(f"/supply/{start_height}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 5}), supply_bytes)
+        resp_hex = self.test_rest_request(f"/supply/{start_height}", req_type=ReqType.HEX, ret_type=RetType.OBJ, query_params={"count": 5})
+        assert_equal(resp_hex.read().decode('utf-8').rstrip(), supply_bytes.hex())
+        resp = self.test_rest_request(f"/supply/{INVALID_PARAM}", ret_type=RetType.OBJ, status=400)
+        assert_equal(resp.read().decode('utf-8').rstrip(), f"Invalid height: {INVALID_PARAM}")
+        resp = self.test_rest_request(f"/supply/{start_height}", ret_type=RetType.OBJ, status=400, query_params={"count": 0})
+        assert_equal(resp.read().decode('utf-8').rstrip(), "Count is invalid or out of acceptable range (1-100000): 0")
+
+        json_obj = self.test_rest_request(f"/headersupply/{start_height}", query_params={"count": 5, "interval": 2})
+        assert_equal(len(json_obj), 5)
+        headers_bytes = b''
+        for entry in json_obj:
+            blockhash = self.nodes[0].getblockhash(entry['height'])
+            assert_equal(entry['hash'], blockhash)
+            assert_equal(entry['header'], self.nodes[0].getblockheader(blockhash, False))
+            headers_bytes += bytes.fromhex(entry['header'])
+            # The scale factor of the first header and of the headers at even heights
+            if entry['height'] == start_height or entry['height'] % 2 == 0:
+                scale_factor = self.nodes[0].getblockheader(blockhash)['scaleFactor']
+                assert_equal(entry['scaleFactor'], scale_factor)
+                headers_bytes += pack("<Q", int(scale_factor * 10**10))
+            else:
+                assert 'scaleFactor' not in entry
+        assert_equal(self.test_rest_request(f"/headersupply/{start_height}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 5, "interval": 2}), headers_bytes)
+        resp_hex = self.test_rest_request(f"/headersupply/{start_height}", req_type=ReqType.HEX, ret_type=RetType.OBJ, query_params={"count": 5, "interval": 2})
+        assert_equal(resp_hex.read().decode('utf-8').rstrip(), headers_bytes.hex())
+        resp = self.test_rest_request(f"/headersupply/{start_height}", ret_type=RetType.OBJ, status=400, query_params={"interval": 0})
+        assert_equal(resp.read().decode('utf-8').rstrip(), "Invalid interval: 0")
+        resp = self.test_rest_request(f"/headersupply/{start_height}", ret_type=RetType.OBJ, status=400, query_params={"count": 2001})
+        assert_equal(resp.read().decode('utf-8').rstrip(), "Count is invalid or out of acceptable range (1-2000): 2001")
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 chained txs and mine them on node 1
@@ -344,6 +399,14 @@ class RESTTest (BitcoinTestFramework):
             assert_equal(json_obj[tx]['spentby'], txs[i + 1:i + 2])
             assert_equal(json_obj[tx]['depends'], txs[i - 1:i])
 
+        # The binary and hex formats return the transactions, parents first
+        bin_response = self.test_rest_request("/mempool/contents", req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        mempool_txs = deser_vector(BytesIO(bin_response), CTransaction)
+        assert_equal([tx.rehash() for tx in mempool_txs], txs)
+        hex_response = self.test_rest_request("/mempool/contents", req_type=ReqType.HEX, ret_type=RetType.BYTES)
+        assert_equal(hex_response.decode('ascii').strip(), bin_response.hex())
+        self.test_rest_request("/mempool/info", req_type=ReqType.BIN, status=404, ret_type=RetType.OBJ)
+
         # Now mine the transactions
         newblockhash = self.generate(self.nodes[1], 1)
 
@@ -378,6 +441,16 @@ class RESTTest (BitcoinTestFramework):
         blockchain_info = self.nodes[0].getblockchaininfo()
         assert_equal(blockchain_info, json_obj)
 
+        self.log.info("Test the /metrics URI")
+        metrics = self.test_rest_request("/metrics", req_type=None, ret_type=RetType.BYTES).decode('utf-8')
+        validation_stats = self.nodes[0].getvalidationstats()
+        assert "# TYPE peerfed_validation_stage_duration_seconds histogram" in metrics
+        for stage, histogram in validation_stats['stages'].items():
+            assert f'peerfed_validation_stage_duration_seconds_count{{stage="{stage}"}} {histogram["count"]}\n' in metrics
+            assert f'peerfed_validation_stage_duration_seconds_bucket{{stage="{stage}",le="+Inf"}} {histogram["count"]}\n' in metrics
+            assert f'peerfed_validation_stage_duration_seconds_bucket{{stage="{stage}",le="0.000001"}} {histogram["buckets"][0]}\n' in metrics
+        self.test_rest_request("/metrics/extra", req_type=None, ret_type=RetType.OBJ, status=404)
+
         # Test compatibility of deprecated and newer endpoints
         self.log.info("Test compatibility of deprecated and newer endpoints")
         assert_equal(self.test_rest_request(f"/headers/{bb_hash}", query_params={"count": 1}), self.test_rest_request(f"/headers/1/{bb_hash}"))
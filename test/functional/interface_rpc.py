@@ -9,7 +9,6 @@ from test_framework.authproxy import JSONRPCException
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal, assert_greater_than_or_equal
 from threading import Thread
-import subprocess
 
 
 def expect_http_status(expected_http_status, expected_rpc_code,
@@ -22,13 +21,9 @@ def expect_http_status(expected_http_status, expected_rpc_code,
         assert_equal(exc.http_status, expected_http_status)
 
 
-def test_work_queue_getblock(node, got_exceeded_error):
-    while not got_exceeded_error:
-        try:
-            node.cli('getrpcinfo').send_cli()
-        except subprocess.CalledProcessError as e:
-            assert_equal(e.output, 'error: Server response: Work queue depth exceeded\n')
-            got_exceeded_error.append(True)
+def test_work_queue_getrpcinfo(node, results):
+    for _ in range(10):
+        results.append(node.cli('getrpcinfo').send_cli())
 
 
 class RPCInterfaceTest(BitcoinTestFramework):
@@ -48,6 +43,21 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_greater_than_or_equal(command['duration'], 0)
         assert_equal(info['logpath'], os.path.join(self.nodes[0].datadir, self.chain, 'debug.log'))
 
+        # Mining calls are served from their own queue
+        assert_equal([queue['name'] for queue in info['work_queues']], ['default', 'priority'])
+        assert_equal(info['work_queues'][1]['threads'], 1)
+        for queue in info['work_queues']:
+            assert_equal(queue['depth'], 0)
+            assert_greater_than_or_equal(queue['last_wait'], 0)
+
+        # The test framework keeps its connection alive between calls
+        connections = info['connections']
+        assert_greater_than_or_equal(connections['open'], 1)
+        assert_equal(connections['requests'], connections['accepted'] + connections['reused'])
+        assert_greater_than_or_equal(self.nodes[0].getrpcinfo()['connections']['reused'], 1)
+        assert_equal(connections['accepting'], True)
+        assert_equal(connections['accept_pauses'], 0)
+
     def test_batch_request(self):
         self.log.info("Testing basic JSON-RPC batch request...")
 
@@ -74,29 +84,46 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_equal(result_by_id[3]['error'], None)
         assert result_by_id[3]['result'] is not None
 
+        self.log.info("Testing JSON-RPC batch request with read-only calls run in parallel...")
+        genesis_hash = self.nodes[0].getblockhash(0)
+        # Runs of read-only calls, split by a call that is run on its own
+        requests = [{"method": "getblockhash", "id": i, "params": [i % 2]} for i in range(40)]
+        requests.insert(20, {"method": "uptime", "id": "uptime"})
+        results = self.nodes[0].batch(requests)
+        assert_equal([res['id'] for res in results], [req['id'] for req in requests])
+        for res in results:
+            if res['id'] == "uptime":
+                assert_equal(res['error'], None)
+            elif res['id'] % 2 == 0:
+                assert_equal(res['result'], genesis_hash)
+            else:
+                assert_equal(res['error']['code'], -8)
+
     def test_http_status_codes(self):
         self.log.info("Testing HTTP status codes for JSON-RPC requests...")
 
         expect_http_status(404, -32601, self.nodes[0].invalidmethod)
         expect_http_status(500, -8, self.nodes[0].getblockhash, 42)
 
-    def test_work_queue_exceeded(self):
-        self.log.info("Testing work queue exceeded...")
+    def test_work_queue_backpressure(self):
+        self.log.info("Testing that a full work queue holds back connections instead of rejecting requests...")
         self.restart_node(0, ['-rpcworkqueue=1', '-rpcthreads=1'])
-        got_exceeded_error = []
+        results = []
         threads = []
         for _ in range(3):
-            t = Thread(target=test_work_queue_getblock, args=(self.nodes[0], got_exceeded_error))
+            t = Thread(target=test_work_queue_getrpcinfo, args=(self.nodes[0], results))
             t.start()
             threads.append(t)
         for t in threads:
             t.join()
+        assert_equal(len(results), 30)
+        assert_equal(self.nodes[0].getrpcinfo()['connections']['accepting'], True)
 
     def run_test(self):
         self.test_getrpcinfo()
         self.test_batch_request()
         self.test_http_status_codes()
-        self.test_work_queue_exceeded()
+        self.test_work_queue_backpressure()
 
 
 if __name__ == '__main__':
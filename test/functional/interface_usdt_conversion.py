@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+""" Tests the conversion:block_remainders and mempool:update_normalized_fees
+    tracepoint API interface.
+    See https://github.com/bitcoin/bitcoin/blob/master/doc/tracing.md#context-conversion
+"""
+
+import ctypes
+
+# Test will be skipped if we don't have bcc installed
+try:
+    from bcc import BPF, USDT # type: ignore[import]
+except ImportError:
+    pass
+
+from test_framework.address import ADDRESS_BCRT1_UNSPENDABLE
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+conversion_program = """
+#include <uapi/linux/ptrace.h>
+
+typedef signed long long i64;
+
+struct block_remainders
+{
+    int         height;
+    u64         outputs;
+    i64         cash;
+    i64         bond;
+    i64         fee_cash;
+    i64         fee_bond;
+};
+
+struct normalized_fees
+{
+    u64         entries;
+    u64         bond_fee_entries;
+    u64         updated;
+    i64         duration;
+};
+
+BPF_PERF_OUTPUT(block_remainders);
+int trace_block_remainders(struct pt_regs *ctx) {
+    struct block_remainders remainders = {};
+    bpf_usdt_readarg(1, ctx, &remainders.height);
+    bpf_usdt_readarg(2, ctx, &remainders.outputs);
+    bpf_usdt_readarg(3, ctx, &remainders.cash);
+    bpf_usdt_readarg(4, ctx, &remainders.bond);
+    bpf_usdt_readarg(5, ctx, &remainders.fee_cash);
+    bpf_usdt_readarg(6, ctx, &remainders.fee_bond);
+    block_remainders.perf_submit(ctx, &remainders, sizeof(remainders));
+    return 0;
+}
+
+BPF_PERF_OUTPUT(update_normalized_fees);
+int trace_update_normalized_fees(struct pt_regs *ctx) {
+    struct normalized_fees fees = {};
+    bpf_usdt_readarg(1, ctx, &fees.entries);
+    bpf_usdt_readarg(2, ctx, &fees.bond_fee_entries);
+    bpf_usdt_readarg(3, ctx, &fees.updated);
+    bpf_usdt_readarg(4, ctx, &fees.duration);
+    update_normalized_fees.perf_submit(ctx, &fees, sizeof(fees));
+    return 0;
+}
+"""
+
+
+class BlockRemainders(ctypes.Structure):
+    _fields_ = [
+        ("height", ctypes.c_int),
+        ("outputs", ctypes.c_uint64),
+        ("cash", ctypes.c_int64),
+        ("bond", ctypes.c_int64),
+        ("fee_cash", ctypes.c_int64),
+        ("fee_bond", ctypes.c_int64),
+    ]
+
+
+class NormalizedFees(ctypes.Structure):
+    _fields_ = [
+        ("entries", ctypes.c_uint64),
+        ("bond_fee_entries", ctypes.c_uint64),
+        ("updated", ctypes.c_uint64),
+        ("duration", ctypes.c_int64),
+    ]
+
+
+class ConversionTracepointTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_platform_not_linux()
+        self.skip_if_no_peerfedd_tracepoints()
+        self.skip_if_no_python_bcc()
+        self.skip_if_no_bpf_permissions()
+
+    def run_test(self):
+        # Mines blocks without conversions and checks that each connected
+        # block reports no remainders and one normalized fee update of the
+        # empty mempool.
+        BLOCKS_EXPECTED = 2
+        start_height = self.nodes[0].getblockcount()
+        remainders = []
+        fee_updates = []
+
+        self.log.info("hook into the conversion:block_remainders and mempool:update_normalized_fees tracepoints")
+        ctx = USDT(pid=self.nodes[0].process.pid)
+        ctx.enable_probe(probe="conversion:block_remainders",
+                         fn_name="trace_block_remainders")
+        ctx.enable_probe(probe="mempool:update_normalized_fees",
+                         fn_name="trace_update_normalized_fees")
+        bpf = BPF(text=conversion_program, usdt_contexts=[ctx], debug=0)
+
+        # The handle_* functions are ctypes callbacks called from C, an
+        # AssertError in them doesn't propagate back to Python. We record the
+        # events and check them afterwards.
+        def handle_block_remainders(_, data, __):
+            event = ctypes.cast(data, ctypes.POINTER(BlockRemainders)).contents
+            self.log.info(f"handle_block_remainders(): height={event.height} outputs={event.outputs}")
+            remainders.append((event.height, event.outputs, event.cash, event.bond, event.fee_cash, event.fee_bond))
+
+        def handle_update_normalized_fees(_, data, __):
+            event = ctypes.cast(data, ctypes.POINTER(NormalizedFees)).contents
+            self.log.info(f"handle_update_normalized_fees(): entries={event.entries} updated={event.updated}")
+            fee_updates.append((event.entries, event.bond_fee_entries, event.updated))
+
+        bpf["block_remainders"].open_perf_buffer(handle_block_remainders)
+        bpf["update_normalized_fees"].open_perf_buffer(handle_update_normalized_fees)
+
+        self.log.info(f"mine {BLOCKS_EXPECTED} blocks")
+        self.generatetoaddress(self.nodes[0], BLOCKS_EXPECTED, ADDRESS_BCRT1_UNSPENDABLE)
+
+        bpf.perf_buffer_poll(timeout=200)
+        bpf.cleanup()
+
+        self.log.info("check that every connected block was traced")
+        # Block template validity checks connect the same heights again.
+        assert_equal({r[0] for r in remainders}, set(range(start_height + 1, start_height + BLOCKS_EXPECTED + 1)))
+        assert all(r[1:] == (0, 0, 0, 0, 0) for r in remainders)
+        assert_equal(fee_updates, [(0, 0, 0)] * BLOCKS_EXPECTED)
+
+
+if __name__ == '__main__':
+    ConversionTracepointTest().main()
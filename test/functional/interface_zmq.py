@@ -16,6 +16,7 @@ from test_framework.blocktools import (
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.messages import (
+    COIN,
     CTransaction,
     hash256,
 )
@@ -75,6 +76,13 @@ class ZMQSubscriber:
             assert label == "D" or label == "C"
         return (hash, label, mempool_sequence)
 
+    def receive_supply(self):
+        body = self._receive_from_publisher_and_check()
+        assert_equal(len(body), 32+4+8*4)
+        hash = body[:32].hex()
+        height, cash, bond, scale_factor, interest_rate = struct.unpack("<IqqQq", body[32:])
+        return (hash, height, cash, bond, scale_factor, interest_rate)
+
 
 class ZMQTestSetupBlock:
     """Helper class for setting up a ZMQ test via the "sync up" procedure.
@@ -120,6 +128,7 @@ class ZMQTest (BitcoinTestFramework):
             self.test_mempool_sync()
             self.test_reorg()
             self.test_multiple_interfaces()
+            self.test_supply()
             self.test_ipv6()
         finally:
             # Destroy the ZMQ context.
@@ -560,6 +569,27 @@ class ZMQTest (BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1].receive().hex())
 
+    def test_supply(self):
+        self.log.info("Testing supply publisher")
+        [supply] = self.setup_zmq_test([("supply", "tcp://127.0.0.1:28333")])
+
+        num_blocks = 3
+        genhashes = self.generatetoaddress(self.nodes[0], num_blocks, ADDRESS_BCRT1_UNSPENDABLE)
+        for block_hash in genhashes:
+            header = self.nodes[0].getblockheader(block_hash)
+            hash, height, cash, bond, scale_factor, interest_rate = supply.receive_supply()
+            assert_equal(hash, block_hash)
+            assert_equal(height, header["height"])
+            assert_equal(cash, int(header["unscaledCashSupply"] * COIN))
+            assert_equal(bond, int(header["unscaledBondSupply"] * COIN))
+            assert_equal(scale_factor, int(header["scaleFactor"] * 10**10))
+            # The interest rate in basis points is the cash to bond supply ratio
+            assert_equal(interest_rate, (cash * 10000 * 10 // bond + 5) // 10)
+
+        assert_equal(self.nodes[0].getzmqnotifications(), [
+            {"type": "pubsupply", "address": "tcp://127.0.0.1:28333", "hwm": 1000},
+        ])
+
     def test_ipv6(self):
         if not test_ipv6_local():
             self.log.info("Skipping IPv6 test, because IPv6 is not supported.")
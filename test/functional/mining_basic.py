@@ -6,12 +6,16 @@
 
 - getmininginfo
 - getblocktemplate proposal mode
-- submitblock"""
+- submitblock
+- submittemplateblock"""
 
 import copy
+import time
 from decimal import Decimal
 
 from test_framework.blocktools import (
+    add_witness_commitment,
+    create_block,
     create_coinbase,
     get_witness_script,
     NORMAL_GBT_REQUEST_PARAMS,
@@ -108,6 +112,40 @@ class MiningTest(BitcoinTestFramework):
         script = get_witness_script(witness_root, 0)
         assert_equal(witness_commitment, script.hex())
 
+        self.log.info("getblocktemplate: Test template diffs")
+        base_id = tmpl['templateid']
+        new_txid = self.wallet.send_self_transfer(from_node=node)['txid']
+        # Templates are rebuilt for mempool changes at most every 5 seconds
+        node.setmocktime(int(time.time()) + 10)
+        diff = node.getblocktemplate({**NORMAL_GBT_REQUEST_PARAMS, 'templatediff': base_id})
+        node.setmocktime(0)
+        assert diff['templateid'] != base_id
+        assert_equal(diff['difffrom'], base_id)
+        assert_equal(diff['removed'], [])
+        assert_equal(len(diff['transactions']), 2)
+        full = node.getblocktemplate(NORMAL_GBT_REQUEST_PARAMS)
+        assert_equal(full['templateid'], diff['templateid'])
+        for entry, full_entry in zip(diff['transactions'], full['transactions']):
+            if entry['txid'] == new_txid:
+                assert_equal(entry, full_entry)
+            else:
+                assert_equal(entry, {'txid': full_entry['txid']})
+        assert 'difffrom' not in full
+        unknown = node.getblocktemplate({**NORMAL_GBT_REQUEST_PARAMS, 'templatediff': '00' * 32})
+        assert_equal(unknown['transactions'], full['transactions'])
+        assert 'removed' not in unknown
+
+        self.log.info("submittemplateblock: Test block built from a template")
+        block = create_block(tmpl=full, txlist=[tx['data'] for tx in full['transactions']])
+        add_witness_commitment(block)
+        block.solve()
+        coinbase_hex = block.vtx[0].serialize().hex()
+        assert_raises_rpc_error(-8, "Unknown template", node.submittemplateblock, '00' * 32, coinbase_hex, block.nVersion, block.nTime, block.nNonce)
+        assert_raises_rpc_error(-22, "Transaction is not a coinbase", node.submittemplateblock, full['templateid'], full['transactions'][0]['data'], block.nVersion, block.nTime, block.nNonce)
+        assert_equal(node.submittemplateblock(full['templateid'], coinbase_hex, block.nVersion, block.nTime, block.nNonce), None)
+        assert_equal(node.getbestblockhash(), block.hash)
+        assert_equal(node.submittemplateblock(full['templateid'], coinbase_hex, block.nVersion, block.nTime, block.nNonce), 'duplicate')
+
         # Mine a block to leave initial block download and clear the mempool
         self.generatetoaddress(node, 1, node.get_deterministic_priv_key().address)
         tmpl = node.getblocktemplate(NORMAL_GBT_REQUEST_PARAMS)
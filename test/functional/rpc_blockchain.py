@@ -82,6 +82,7 @@ class BlockchainTest(BitcoinTestFramework):
         self._test_getblockchaininfo()
         self._test_getchaintxstats()
         self._test_gettxoutsetinfo()
+        self._test_gettxouts()
         self._test_getblockheader()
         self._test_getdifficulty()
         self._test_getnetworkhashps()
@@ -89,6 +90,7 @@ class BlockchainTest(BitcoinTestFramework):
         self._test_waitforblockheight()
         self._test_getblock()
         self._test_getdeploymentinfo()
+        self._test_getvalidationstats()
         assert self.nodes[0].verifychain(4, 0)
 
     def mine_chain(self):
@@ -255,6 +257,52 @@ class BlockchainTest(BitcoinTestFramework):
         # calling with an explicit hash works
         self.check_signalling_deploymentinfo_result(self.nodes[0].getdeploymentinfo(gbci207["bestblockhash"]), gbci207["blocks"], gbci207["bestblockhash"], "started")
 
+    def _test_getvalidationstats(self):
+        self.log.info("Test getvalidationstats")
+        node = self.nodes[0]
+        stats_before = node.getvalidationstats()
+        bounds = stats_before['bucket_bounds_us']
+        assert_equal(bounds, [2**i for i in range(len(bounds))])
+        assert_equal(sorted(stats_before['stages'].keys()), sorted([
+            'inputs_fetch', 'conversion_eval', 'script_checks', 'undo_write', 'flush',
+            'remove_for_block', 'update_normalized_fees', 'connect_tip', 'coins_write']))
+        for stage in stats_before['stages'].values():
+            assert_equal(len(stage['buckets']), len(bounds) + 1)
+            assert_equal(sum(stage['buckets']), stage['count'])
+
+        self.generate(self.wallet, 2)
+        stats = node.getvalidationstats()
+        # Each connected block is recorded once per stage, block template
+        # checks are not. There were no conversions.
+        for name in ['inputs_fetch', 'script_checks', 'undo_write', 'flush', 'remove_for_block', 'update_normalized_fees', 'connect_tip']:
+            assert_equal(stats['stages'][name]['count'], stats_before['stages'][name]['count'] + 2)
+            assert_equal(sum(stats['stages'][name]['buckets']), stats['stages'][name]['count'])
+            assert stats['stages'][name]['total_us'] >= stats_before['stages'][name]['total_us']
+        assert_equal(stats['stages']['conversion_eval'], stats_before['stages']['conversion_eval'])
+
+    def _test_gettxouts(self):
+        self.log.info("Test gettxouts")
+        node = self.nodes[0]
+        coinbase_txid = node.getblock(node.getbestblockhash())['tx'][0]
+        outputs = [{'txid': coinbase_txid, 'vout': 0}, {'txid': coinbase_txid, 'vout': 99}]
+        res = node.gettxouts(outputs)
+        assert_equal(res['bestblock'], node.getbestblockhash())
+        assert_equal(len(res['txouts']), 2)
+        txout = node.gettxout(coinbase_txid, 0)
+        found = res['txouts'][0]
+        assert_equal(found['txid'], coinbase_txid)
+        assert_equal(found['vout'], 0)
+        assert_equal(found['unspent'], True)
+        assert_equal(found['confirmations'], txout['confirmations'])
+        assert_equal(found['amountType'], txout['amountType'])
+        assert_equal(found['unscaledValue'], txout['value'])
+        assert_equal(found['scriptPubKey'], txout['scriptPubKey']['hex'])
+        assert_equal(found['coinbase'], True)
+        assert_equal(res['txouts'][1], {'txid': coinbase_txid, 'vout': 99, 'unspent': False})
+        assert_equal(node.gettxouts(outputs, False), res)
+
+        assert_raises_rpc_error(-8, "Invalid parameter, vout cannot be negative", node.gettxouts, [{'txid': coinbase_txid, 'vout': -1}])
+
     def _test_getchaintxstats(self):
         self.log.info("Test getchaintxstats")
 
@@ -6,10 +6,10 @@
 """
 
 from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.messages import deser_compact_size
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal, assert_raises_rpc_error
 
-import hashlib
 from pathlib import Path
 
 
@@ -40,10 +40,24 @@ class DumptxoutsetTest(BitcoinTestFramework):
             '09abf0e7b510f61ca6cf33bab104e9ee99b3528b371d27a2d4b39abb800fba7e')
 
         with open(str(expected_path), 'rb') as f:
-            digest = hashlib.sha256(f.read()).hexdigest()
-            # UTXO snapshot hash should be deterministic based on mocked time.
-            assert_equal(
-                digest, 'b1bacb602eacf5fbc9a7c2ef6eeb0d229c04e98bdf0c2ea5929012cd0eae3830')
+            # Metadata: magic bytes, format version, base block hash and coins count
+            assert_equal(f.read(5), b'utxo\xff')
+            assert_equal(int.from_bytes(f.read(2), 'little'), 2)
+            assert_equal(f.read(32)[::-1].hex(), out['base_hash'])
+            assert_equal(int.from_bytes(f.read(8), 'little'), 100)
+            # A snapshot this small fits in a single chunk of coins
+            chunk_offset = f.tell()
+            assert_equal(deser_compact_size(f), 100)
+            chunk_size = deser_compact_size(f)
+            assert_equal(len(f.read(chunk_size)), chunk_size)
+            # Chunk index, followed by its offset
+            index_offset = f.tell()
+            assert_equal(deser_compact_size(f), 1)
+            assert_equal(int.from_bytes(f.read(8), 'little'), chunk_offset)
+            assert_equal(deser_compact_size(f), 100)
+            f.read(32)
+            assert_equal(int.from_bytes(f.read(8), 'little'), index_offset)
+            assert_equal(f.read(), b'')
 
         assert_equal(
             out['txoutset_hash'], '1f7e3befd45dc13ae198dfbb22869a9c5c4196f8e9ef9735831af1288033f890')
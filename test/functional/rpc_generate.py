@@ -20,11 +20,31 @@ class RPCGenerateTest(BitcoinTestFramework):
         self.test_generatetoaddress()
         self.test_generate()
         self.test_generateblock()
+        self.test_generateemptyblocks()
 
     def test_generatetoaddress(self):
         self.generatetoaddress(self.nodes[0], 1, 'mneYUmWYsuk7kySiURxCi3AGxrAqZxLgPZ')
         assert_raises_rpc_error(-5, "Invalid address", self.generatetoaddress, self.nodes[0], 1, '3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy')
 
+    def test_generateemptyblocks(self):
+        node = self.nodes[0]
+        address = 'mneYUmWYsuk7kySiURxCi3AGxrAqZxLgPZ'
+
+        self.log.info('Generate blocks with only a coinbase, in more than one batch')
+        height = node.getblockcount()
+        hashes = node.generateemptyblocks(1500, address)
+        assert_equal(len(hashes), 1500)
+        assert_equal(node.getblockcount(), height + 1500)
+        assert_equal(node.getbestblockhash(), hashes[-1])
+        block = node.getblock(hashes[-1], 2)
+        assert_equal(len(block['tx']), 1)
+        assert_equal(block['tx'][0]['vout'][0]['scriptPubKey']['address'], address)
+
+        self.log.info('Generate blocks the usual way on top of them')
+        self.generatetoaddress(node, 1, address)
+
+        assert_raises_rpc_error(-5, "Invalid address", node.generateemptyblocks, 1, '3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy')
+
     def test_generateblock(self):
         node = self.nodes[0]
         miniwallet = MiniWallet(node)
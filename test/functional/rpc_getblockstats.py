@@ -116,6 +116,23 @@ class GetblockstatsTest(BitcoinTestFramework):
             stats_by_hash = self.nodes[0].getblockstats(hash_or_height=blockhash)
             assert_equal(stats_by_hash, self.expected_stats[i])
 
+        self.log.info('Test getblockstatsrange')
+        stats_range = self.nodes[0].getblockstatsrange(self.start_height, self.start_height + self.max_stat_pos)
+        assert_equal(stats_range, stats)
+        for block_stats in stats_range:
+            assert_equal(block_stats['conversions_cash_to_bond'] + block_stats['conversions_bond_to_cash'], block_stats['conversiontxs'])
+            for stat in ['remainder_cash', 'remainder_bond', 'totalfee_cash', 'totalfee_bond', 'scale_factor', 'interest_rate']:
+                assert stat in block_stats
+        # The genesis block has no undo data, and selections are taken from the cached statistics
+        stats_range = self.nodes[0].getblockstatsrange(0, self.start_height, ['height', 'txs'])
+        assert_equal(len(stats_range), self.start_height + 1)
+        assert_equal(stats_range[0], {'height': 0, 'txs': 1})
+        assert_equal(stats_range[-1], {'height': self.start_height, 'txs': stats[0]['txs']})
+        tip = self.start_height + self.max_stat_pos
+        assert_raises_rpc_error(-8, 'Block height out of range', self.nodes[0].getblockstatsrange, 0, tip + 1)
+        assert_raises_rpc_error(-8, 'start_height must not be greater than end_height', self.nodes[0].getblockstatsrange, 2, 1)
+        assert_raises_rpc_error(-8, "Invalid selected statistic 'asdfghjkl'", self.nodes[0].getblockstatsrange, 0, tip, ['minfee', 'asdfghjkl'])
+
         # Make sure each stat can be queried on its own
         for stat in expected_keys:
             for i in range(self.max_stat_pos+1):
@@ -54,6 +54,38 @@ class RpcMiscTest(BitcoinTestFramework):
 
         assert_raises_rpc_error(-8, "unknown mode foobar", node.getmemoryinfo, mode="foobar")
 
+        self.log.info("test getcacheinfo")
+        cacheinfo = node.getcacheinfo()
+        for cache in ['signatures', 'scripts']:
+            for counter in ['hits', 'misses', 'evictions']:
+                assert_greater_than_or_equal(cacheinfo[cache][counter], 0)
+
+        self.log.info("test getmemoryusage")
+        usage = node.getmemoryusage()
+        # The caches are allocated at startup
+        assert_greater_than(usage['signature_cache'], 0)
+        assert_greater_than(usage['script_cache'], 0)
+        assert_greater_than(usage['block_index'], 0)
+        assert_equal(usage['total'], sum(usage[key] for key in usage if key not in ['wallets', 'total']) + sum(wallet['usage'] for wallet in usage['wallets']))
+
+        self.log.info("test getschedulerinfo")
+        # The periodic entropy, banlist and address dumps and peer checks are queued
+        assert_greater_than_or_equal(node.getschedulerinfo()['queued'], 4)
+        node.mockscheduler(60)
+        self.wait_until(lambda: 'entropy' in {task['name'] for task in node.getschedulerinfo()['tasks']})
+        entropy = next(task for task in node.getschedulerinfo()['tasks'] if task['name'] == 'entropy')
+        assert_greater_than_or_equal(entropy['runs'], 1)
+        assert_greater_than_or_equal(entropy['time_us'], entropy['max_time_us'])
+
+        self.log.info("test getthreadpoolinfo")
+        threadpoolinfo = node.getthreadpoolinfo()
+        assert_greater_than_or_equal(threadpoolinfo['threads'], 4)
+        pools = {pool['name']: pool for pool in threadpoolinfo['pools']}
+        assert_equal(pools['httpworker']['priority'], 'normal')
+        # This call is running on a worker
+        assert_greater_than_or_equal(pools['httpworker']['running'], 1)
+        self.wait_until(lambda: {pool['name']: pool for pool in node.getthreadpoolinfo()['pools']}['loadblk']['tasks_run'] == 1)
+
         self.log.info("test logging rpc and help")
 
         # Test toggling a logging category on/off/on with the logging RPC.
@@ -100,6 +132,49 @@ class RpcMiscTest(BitcoinTestFramework):
         # Specifying an unknown index name returns an empty result
         assert_equal(node.getindexinfo("foo"), {})
 
+        self.log.info("test getdbinfo")
+        dbinfo = node.getdbinfo()
+        for db in ['chainstate', 'blockindex']:
+            assert_equal(dbinfo[db]['block_cache_percent'], 50)
+            assert_equal(dbinfo[db]['bloom_bits'], 10)
+            assert_greater_than(dbinfo[db]['cache_size'], 0)
+            assert_greater_than(dbinfo[db]['write_buffer_size'], 0)
+            assert_greater_than(dbinfo[db]['memory_usage'], 0)
+            assert 'Compactions' in dbinfo[db]['stats']
+
+        self.restart_node(0, ["-chainstatedbblockcachepct=80", "-chainstatedbbloombits=0", "-blockindexdbwritebuffer=2"])
+        dbinfo = node.getdbinfo()
+        assert_equal(dbinfo['chainstate']['block_cache_percent'], 80)
+        assert_equal(dbinfo['chainstate']['bloom_bits'], 0)
+        assert_equal(dbinfo['blockindex']['write_buffer_size'], 2 << 20)
+
+        self.stop_node(0)
+        for arg, error in [("-chainstatedbblockcachepct=101", "Invalid -chainstatedbblockcachepct value: 101 (must be between 0 and 100)"),
+                           ("-blockindexdbbloombits=-1", "Invalid -blockindexdbbloombits value: -1 (must be between 0 and 64)"),
+                           ("-chainstatedbwritebuffer=1025", "Invalid -chainstatedbwritebuffer value: 1025 (must be between 0 and 1024)")]:
+            node.assert_start_raises_init_error([arg], f"Error: {error}")
+        self.start_node(0)
+
+        self.log.info("test getlockstats")
+        assert_equal(node.getlockstats(), {'enabled': False, 'sample_interval': 0, 'sites': []})
+        self.restart_node(0, ["-lockstats=1"])
+        node.getblockchaininfo()
+        lockstats = node.getlockstats()
+        assert_equal(lockstats['enabled'], True)
+        assert_equal(lockstats['sample_interval'], 1)
+        assert_equal({site['lock'] for site in lockstats['sites']} - {'cs_main', 'mempool.cs', 'cs_wallet', 'm_nodes_mutex'}, set())
+        cs_main_sites = [site for site in lockstats['sites'] if site['lock'] == 'cs_main']
+        assert any(site['file'].endswith('blockchain.cpp') for site in cs_main_sites)
+        for site in lockstats['sites']:
+            assert_greater_than(site['acquisitions'], 0)
+            assert_greater_than_or_equal(site['acquisitions'], site['contentions'])
+            assert_greater_than_or_equal(site['wait_us'], site['max_wait_us'])
+            assert_greater_than_or_equal(site['hold_us'], site['max_hold_us'])
+        node.getlockstats(reset=True)
+        assert_equal([site for site in node.getlockstats()['sites'] if site['lock'] == 'cs_main' and site['file'].endswith('blockchain.cpp')], [])
+        self.stop_node(0)
+        node.assert_start_raises_init_error(["-lockstats=-1"], "Error: Invalid -lockstats value: -1")
+
 
 if __name__ == '__main__':
     RpcMiscTest().main()
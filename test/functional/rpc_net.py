@@ -104,6 +104,12 @@ class NetTest(BitcoinTestFramework):
         assert_equal(peer_info[1][0]['connection_type'], 'manual')
         assert_equal(peer_info[1][1]['connection_type'], 'inbound')
 
+        # check the per-peer `memory` report
+        for info in peer_info:
+            for peer in info:
+                assert_equal(sorted(peer['memory'].keys()), ['process_queue', 'send_queue', 'tx_relay'])
+                assert_greater_than(peer['memory']['tx_relay'], 0)
+
         # Check dynamically generated networks list in getpeerinfo help output.
         assert "(ipv4, ipv6, onion, i2p, cjdns, not_publicly_routable)" in self.nodes[0].help("getpeerinfo")
 
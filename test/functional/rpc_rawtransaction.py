@@ -166,6 +166,20 @@ class RawTransactionsTest(BitcoinTestFramework):
             self.nodes[n].reconsiderblock(block1)
             assert_equal(self.nodes[n].getbestblockhash(), block2)
 
+        self.log.info("Test getrawtransaction with an array of txids")
+        mempool_tx = self.wallet.send_self_transfer(from_node=self.nodes[0])
+        self.sync_all()
+        txids = [tx, txId, mempool_tx['txid'], "00" * 32]
+        assert_equal(self.nodes[0].getrawtransaction(txids), [self.nodes[0].getrawtransaction(tx), self.nodes[0].getrawtransaction(txId), mempool_tx['hex'], None])
+        verbose = self.nodes[0].getrawtransaction(txids, True)
+        assert_equal([tx_info['txid'] for tx_info in verbose[:3]], txids[:3])
+        assert_equal(verbose[0]['blockhash'], block1)
+        assert 'blockhash' not in verbose[2]
+        assert_equal(verbose[3], None)
+        assert_equal(self.nodes[2].getrawtransaction(txids, False, block1), [self.nodes[0].getrawtransaction(tx), None, None, None])
+        assert_equal(self.nodes[2].getrawtransaction([txId]), [None])
+        self.generate(self.nodes[0], 1)
+
         self.log.info("Test getrawtransaction on genesis block coinbase returns an error")
         block = self.nodes[0].getblock(self.nodes[0].getblockhash(0))
         assert_raises_rpc_error(-5, "The genesis block coinbase is not considered an ordinary transaction", self.nodes[0].getrawtransaction, block['merkleroot'])
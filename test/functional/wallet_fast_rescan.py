@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that a descriptor wallet rescan using block filters finds the same
+transactions as a rescan inspecting every block, including those paying to
+scripts that only get generated by top-ups during the rescan."""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+KEYPOOL_SIZE = 10
+NUM_PAYMENTS = 8
+
+
+class WalletFastRescanTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [[f'-keypool={KEYPOOL_SIZE}', '-blockfilterindex=1'], [f'-keypool={KEYPOOL_SIZE}']]
+        self.setup_clean_chain = True
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+        self.skip_if_no_sqlite()
+
+    def import_and_list_txids(self, node, descriptors):
+        node.createwallet(wallet_name='rescan', disable_private_keys=True, blank=True, descriptors=True)
+        w = node.get_wallet_rpc('rescan')
+        result = w.importdescriptors([{'desc': d['desc'], 'timestamp': 0, 'active': d['active'], 'internal': d['internal'], 'range': d['range']} for d in descriptors])
+        assert all(r['success'] for r in result)
+        return sorted(tx['txid'] for tx in w.listtransactions(count=1000))
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.createwallet(wallet_name='funder', descriptors=True)
+        funder = node.get_wallet_rpc('funder')
+        self.generatetoaddress(node, 110, funder.getnewaddress())
+
+        node.createwallet(wallet_name='topup_test', descriptors=True)
+        w = node.get_wallet_rpc('topup_test')
+        descriptors = [d for d in w.listdescriptors()['descriptors'] if d['active']]
+        receive_desc = next(d['desc'] for d in descriptors if not d['internal'] and d['desc'].startswith('wpkh('))
+
+        self.log.info("Pay to addresses further and further down the descriptor range")
+        sent_txids = []
+        for i in range(NUM_PAYMENTS):
+            address = node.deriveaddresses(receive_desc, [i * 3, i * 3])[0]
+            sent_txids.append(funder.sendtoaddress(address, 'cash', 1))
+            self.generatetoaddress(node, 1 + i, funder.getnewaddress())
+        self.sync_all()
+        sent_txids.sort()
+
+        self.log.info("Rescan using block filters")
+        with node.assert_debug_log(['fast variant using block filters']):
+            assert_equal(self.import_and_list_txids(node, descriptors), sent_txids)
+
+        self.log.info("Rescan inspecting every block")
+        with self.nodes[1].assert_debug_log(['slow variant inspecting all blocks']):
+            assert_equal(self.import_and_list_txids(self.nodes[1], descriptors), sent_txids)
+
+
+if __name__ == '__main__':
+    WalletFastRescanTest().main()